@@ -47,6 +47,7 @@ EXTENSIONS = (
     ['XR_KHR_D3D12_enable', 'XR_USE_GRAPHICS_API_D3D12'],
     ['XR_KHR_loader_init', 'XR_USE_PLATFORM_ANDROID'],
     ['XR_KHR_loader_init_android', 'OXR_HAVE_KHR_loader_init', 'XR_USE_PLATFORM_ANDROID'],
+    ['XR_KHR_locate_spaces'],
     ['XR_KHR_opengl_enable', 'XR_USE_GRAPHICS_API_OPENGL'],
     ['XR_KHR_opengl_es_enable', 'XR_USE_GRAPHICS_API_OPENGL_ES'],
     ['XR_KHR_swapchain_usage_input_attachment_bit'],
@@ -70,7 +71,13 @@ EXTENSIONS = (
     ['XR_FB_composition_layer_settings', 'XRT_FEATURE_OPENXR_LAYER_FB_SETTINGS'],
     ['XR_FB_composition_layer_depth_test', 'XRT_FEATURE_OPENXR_LAYER_FB_DEPTH_TEST'],
     ['XR_FB_display_refresh_rate', 'XRT_FEATURE_OPENXR_DISPLAY_REFRESH_RATE'],
+    ['XR_FB_foveation', 'XRT_FEATURE_OPENXR_FOVEATION_FB'],
+    ['XR_FB_foveation_configuration', 'XRT_FEATURE_OPENXR_FOVEATION_FB'],
+    ['XR_FB_foveation_vulkan', 'XR_USE_GRAPHICS_API_VULKAN', 'XRT_FEATURE_OPENXR_FOVEATION_FB'],
     ['XR_FB_passthrough', 'XRT_FEATURE_OPENXR_LAYER_PASSTHROUGH'],
+    ['XR_FB_space_warp', 'XRT_FEATURE_OPENXR_LAYER_FB_SPACE_WARP'],
+    ['XR_FB_swapchain_update_state', 'XRT_FEATURE_OPENXR_FOVEATION_FB'],
+    ['XR_META_recommended_layer_resolution', 'XRT_FEATURE_OPENXR_META_RECOMMENDED_LAYER_RESOLUTION'],
     ['XR_ML_ml2_controller_interaction', 'XRT_FEATURE_OPENXR_INTERACTION_ML2'],
     ['XR_MND_headless', 'XRT_FEATURE_OPENXR_HEADLESS'],
     ['XR_MND_swapchain_usage_input_attachment_bit'],
@@ -87,6 +87,7 @@ def get_device_cmds():
         None,
         Cmd("vkCreatePipelineCache"),
         Cmd("vkDestroyPipelineCache"),
+        Cmd("vkGetPipelineCacheData"),
         None,
         Cmd("vkResetDescriptorPool"),
         Cmd("vkCreateDescriptorPool"),
@@ -197,6 +198,7 @@ def get_instance_cmds():
         Cmd("vkGetPhysicalDeviceProperties2"),
         Cmd("vkGetPhysicalDeviceFeatures2"),
         Cmd("vkGetPhysicalDeviceMemoryProperties"),
+        Cmd("vkGetPhysicalDeviceMemoryProperties2"),
         Cmd("vkGetPhysicalDeviceQueueFamilyProperties"),
         Cmd("vkGetPhysicalDeviceSurfaceCapabilitiesKHR"),
         Cmd("vkGetPhysicalDeviceSurfaceFormatsKHR"),
@@ -287,7 +289,9 @@ DEVICE_EXTENSIONS_TO_CHECK = [
     "VK_EXT_display_control",
     "VK_EXT_external_memory_dma_buf",
     "VK_EXT_global_priority",
+    "VK_EXT_image_compression_control",
     "VK_EXT_image_drm_format_modifier",
+    "VK_EXT_memory_budget",
     "VK_EXT_robustness2",
     "VK_GOOGLE_display_timing",
 ]
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+# Copyright 2024, Collabora, Ltd.
+# SPDX-License-Identifier: BSL-1.0
+"""
+Make INT8 QDQ variants of the Mercury hand tracking models.
+
+Calibrates on the camera images of EuRoC style datasets (like the ones
+recorded with the euroc recorder in Monado) and writes the models next to
+the float ones with an "_int8" suffix. Use them by setting
+MERCURY_MODEL_VARIANT=int8.
+
+The QDQ format keeps the inputs and outputs of the models as floats, so the
+pre and post-processing in hg_model.cpp stays the same.
+"""
+
+import argparse
+import glob
+import os
+import random
+
+import cv2
+import numpy as np
+import onnxruntime as ort
+from onnxruntime.quantization import (CalibrationDataReader, CalibrationMethod,
+                                      QuantFormat, QuantType, quantize_static)
+from onnxruntime.quantization.shape_inference import quant_pre_process
+
+DETECTION_MODEL = "grayscale_detection_160x160"
+KEYPOINT_MODEL = "grayscale_keypoint_jan18"
+DETECTION_SIZE = 160
+KEYPOINT_SIZE = 128
+MIN_DETECTION_CONFIDENCE = 0.3
+
+
+def normalize(img):
+    """Same as normalizeGrayscaleImage in hg_model.cpp."""
+    out = img.astype(np.float32) / 255.0
+    std = out.std()
+    if std == 0:
+        return None
+    out *= 0.25 / std
+    out += 0.5 - out.mean()
+    return out
+
+
+def blackbar(img, size):
+    """Scale down to fit and pad, like blackbar in hg_model.cpp without rotation."""
+    h, w = img.shape
+    scale = min(size / w, size / h)
+    go = np.array([[scale, 0, (size - w * scale) / 2],
+                   [0, scale, (size - h * scale) / 2]], dtype=np.float32)
+    return cv2.warpAffine(img, go, (size, size)), go
+
+
+def find_images(datasets, cameras):
+    images = []
+    for dataset in datasets:
+        for cam in cameras:
+            pattern = os.path.join(dataset, "mav0", cam, "data", "*.png")
+            images += sorted(glob.glob(pattern))
+    return images
+
+
+class DetectionReader(CalibrationDataReader):
+    def __init__(self, images):
+        self.images = iter(images)
+
+    def get_next(self):
+        for path in self.images:
+            img = cv2.imread(path, cv2.IMREAD_GRAYSCALE)
+            if img is None:
+                continue
+            data = normalize(blackbar(img, DETECTION_SIZE)[0])
+            if data is None:
+                continue
+            return {"inputImg": data.reshape(1, 1, DETECTION_SIZE, DETECTION_SIZE)}
+        return None
+
+
+class KeypointReader(CalibrationDataReader):
+    """
+    Crops around the hands the float detection model finds. This is close to
+    what the tracker feeds the model right after detection, the stereographic
+    projection is not reproduced.
+    """
+
+    def __init__(self, images, detection_path):
+        self.images = iter(images)
+        self.session = ort.InferenceSession(detection_path, providers=["CPUExecutionProvider"])
+        self.pending = []
+
+    def crops(self, img):
+        binned, go = blackbar(img, DETECTION_SIZE)
+        data = normalize(binned)
+        if data is None:
+            return []
+
+        names = ["hand_exists", "cx", "cy", "size"]
+        hand_exists, cx, cy, size = self.session.run(
+            names, {"inputImg": data.reshape(1, 1, DETECTION_SIZE, DETECTION_SIZE)})
+
+        back = cv2.invertAffineTransform(go)
+        out = []
+        for hand_idx in range(2):
+            if hand_exists.flat[hand_idx] < MIN_DETECTION_CONFIDENCE:
+                continue
+
+            # Same mapping as hand_detection_interpret.
+            pt = np.array([(cx.flat[hand_idx] + 1) / 2 * DETECTION_SIZE,
+                           (cy.flat[hand_idx] + 1) / 2 * DETECTION_SIZE, 1.0])
+            center = back @ pt
+            half = size.flat[hand_idx] * DETECTION_SIZE * 2.0 * np.hypot(back[0, 0], back[0, 1]) / 2
+
+            src = np.array([center - [half, half], center + [half, -half], center + [-half, half]],
+                           dtype=np.float32)
+            dst = np.array([[0, 0], [KEYPOINT_SIZE, 0], [0, KEYPOINT_SIZE]], dtype=np.float32)
+            crop = cv2.warpAffine(img, cv2.getAffineTransform(src, dst), (KEYPOINT_SIZE, KEYPOINT_SIZE))
+
+            # The model sees right hands mirrored.
+            if hand_idx == 1:
+                crop = cv2.flip(crop, 1)
+
+            crop = normalize(crop)
+            if crop is not None:
+                out.append(crop)
+        return out
+
+    def get_next(self):
+        while not self.pending:
+            path = next(self.images, None)
+            if path is None:
+                return None
+            img = cv2.imread(path, cv2.IMREAD_GRAYSCALE)
+            if img is not None:
+                self.pending = self.crops(img)
+
+        crop = self.pending.pop()
+        return {
+            "inputImg": crop.reshape(1, 1, KEYPOINT_SIZE, KEYPOINT_SIZE),
+            "lastKeypoints": np.zeros((1, 42), dtype=np.float32),
+            "useLastKeypoints": np.zeros((1,), dtype=np.float32),
+        }
+
+
+def quantize(models_folder, name, reader, method):
+    src = os.path.join(models_folder, name + ".onnx")
+    pre = os.path.join(models_folder, name + "_preprocessed.onnx")
+    dst = os.path.join(models_folder, name + "_int8.onnx")
+
+    print(f"Quantizing {src} -> {dst}")
+    quant_pre_process(src, pre)
+    quantize_static(pre, dst, reader,
+                    quant_format=QuantFormat.QDQ,
+                    activation_type=QuantType.QUInt8,
+                    weight_type=QuantType.QInt8,
+                    per_channel=True,
+                    calibrate_method=method)
+    os.remove(pre)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Make INT8 variants of the Mercury models")
+    parser.add_argument("datasets", nargs="+", help="EuRoC style dataset folders to calibrate with")
+    parser.add_argument("--models-folder",
+                        default=os.path.expanduser("~/.local/share/monado/hand-tracking-models"),
+                        help="Folder with the float models, the int8 ones are written here too")
+    parser.add_argument("--cameras", nargs="+", default=["cam0", "cam1"], help="Camera folders to use")
+    parser.add_argument("--max-images", type=int, default=500, help="Images to calibrate each model with")
+    parser.add_argument("--method", choices=["minmax", "entropy", "percentile"], default="percentile",
+                        help="Calibration method")
+    args = parser.parse_args()
+
+    images = find_images(args.datasets, args.cameras)
+    if not images:
+        parser.error("No images found, expected <dataset>/mav0/<camera>/data/*.png")
+
+    random.seed(0)
+    random.shuffle(images)
+    images = images[:args.max_images]
+
+    method = {
+        "minmax": CalibrationMethod.MinMax,
+        "entropy": CalibrationMethod.Entropy,
+        "percentile": CalibrationMethod.Percentile,
+    }[args.method]
+
+    quantize(args.models_folder, DETECTION_MODEL, DetectionReader(images), method)
+
+    detection_path = os.path.join(args.models_folder, DETECTION_MODEL + ".onnx")
+    quantize(args.models_folder, KEYPOINT_MODEL, KeypointReader(images, detection_path), method)
+
+
+if __name__ == "__main__":
+    main()
@@ -24,6 +24,12 @@ PB_BIND(monado_metrics_SystemGpuInfo, monado_metrics_SystemGpuInfo, AUTO)
 PB_BIND(monado_metrics_SystemPresentInfo, monado_metrics_SystemPresentInfo, AUTO)
 
 
+PB_BIND(monado_metrics_SystemGpuPhase, monado_metrics_SystemGpuPhase, AUTO)
+
+
+PB_BIND(monado_metrics_DeviceIoStats, monado_metrics_DeviceIoStats, AUTO)
+
+
 PB_BIND(monado_metrics_Record, monado_metrics_Record, AUTO)
 
 
@@ -73,6 +73,29 @@ typedef struct _monado_metrics_SystemPresentInfo {
     uint64_t earliest_present_time_ns;
 } monado_metrics_SystemPresentInfo;
 
+typedef struct _monado_metrics_SystemGpuPhase {
+    int64_t frame_id;
+    uint32_t phase;
+    uint32_t view_index;
+    uint64_t gpu_start_ns;
+    uint64_t gpu_end_ns;
+    uint64_t when_ns;
+} monado_metrics_SystemGpuPhase;
+
+typedef struct _monado_metrics_DeviceIoStats {
+    char name[32];
+    uint64_t when_ns;
+    uint64_t period_ns;
+    uint32_t packet_count;
+    uint32_t missed_count;
+    uint32_t duplicate_count;
+    uint64_t interval_mean_ns;
+    uint64_t interval_max_ns;
+    uint64_t process_mean_ns;
+    uint64_t process_max_ns;
+    uint32_t backlog_max;
+} monado_metrics_DeviceIoStats;
+
 typedef struct _monado_metrics_Record {
     pb_size_t which_record;
     union {
@@ -82,6 +105,8 @@ typedef struct _monado_metrics_Record {
         monado_metrics_SystemFrame system_frame;
         monado_metrics_SystemGpuInfo system_gpu_info;
         monado_metrics_SystemPresentInfo system_present_info;
+        monado_metrics_SystemGpuPhase system_gpu_phase;
+        monado_metrics_DeviceIoStats device_io_stats;
     } record;
 } monado_metrics_Record;
 
@@ -97,6 +122,8 @@ extern "C" {
 #define monado_metrics_SystemFrame_init_default  {0, 0, 0, 0, 0, 0}
 #define monado_metrics_SystemGpuInfo_init_default {0, 0, 0, 0}
 #define monado_metrics_SystemPresentInfo_init_default {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+#define monado_metrics_SystemGpuPhase_init_default {0, 0, 0, 0, 0, 0}
+#define monado_metrics_DeviceIoStats_init_default {"", 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
 #define monado_metrics_Record_init_default       {0, {monado_metrics_Version_init_default}}
 #define monado_metrics_Version_init_zero         {0, 0}
 #define monado_metrics_SessionFrame_init_zero    {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
@@ -104,6 +131,8 @@ extern "C" {
 #define monado_metrics_SystemFrame_init_zero     {0, 0, 0, 0, 0, 0}
 #define monado_metrics_SystemGpuInfo_init_zero   {0, 0, 0, 0}
 #define monado_metrics_SystemPresentInfo_init_zero {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+#define monado_metrics_SystemGpuPhase_init_zero  {0, 0, 0, 0, 0, 0}
+#define monado_metrics_DeviceIoStats_init_zero   {"", 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
 #define monado_metrics_Record_init_zero          {0, {monado_metrics_Version_init_zero}}
 
 /* Field tags (for use in manual encoding/decoding) */
@@ -152,12 +181,31 @@ extern "C" {
 #define monado_metrics_SystemPresentInfo_present_margin_ns_tag 13
 #define monado_metrics_SystemPresentInfo_actual_present_time_ns_tag 14
 #define monado_metrics_SystemPresentInfo_earliest_present_time_ns_tag 15
+#define monado_metrics_SystemGpuPhase_frame_id_tag 1
+#define monado_metrics_SystemGpuPhase_phase_tag  2
+#define monado_metrics_SystemGpuPhase_view_index_tag 3
+#define monado_metrics_SystemGpuPhase_gpu_start_ns_tag 4
+#define monado_metrics_SystemGpuPhase_gpu_end_ns_tag 5
+#define monado_metrics_SystemGpuPhase_when_ns_tag 6
+#define monado_metrics_DeviceIoStats_name_tag    1
+#define monado_metrics_DeviceIoStats_when_ns_tag 2
+#define monado_metrics_DeviceIoStats_period_ns_tag 3
+#define monado_metrics_DeviceIoStats_packet_count_tag 4
+#define monado_metrics_DeviceIoStats_missed_count_tag 5
+#define monado_metrics_DeviceIoStats_duplicate_count_tag 6
+#define monado_metrics_DeviceIoStats_interval_mean_ns_tag 7
+#define monado_metrics_DeviceIoStats_interval_max_ns_tag 8
+#define monado_metrics_DeviceIoStats_process_mean_ns_tag 9
+#define monado_metrics_DeviceIoStats_process_max_ns_tag 10
+#define monado_metrics_DeviceIoStats_backlog_max_tag 11
 #define monado_metrics_Record_version_tag        1
 #define monado_metrics_Record_session_frame_tag  2
 #define monado_metrics_Record_used_tag           3
 #define monado_metrics_Record_system_frame_tag   4
 #define monado_metrics_Record_system_gpu_info_tag 5
 #define monado_metrics_Record_system_present_info_tag 6
+#define monado_metrics_Record_system_gpu_phase_tag 7
+#define monado_metrics_Record_device_io_stats_tag 8
 
 /* Struct field encoding specification for nanopb */
 #define monado_metrics_Version_FIELDLIST(X, a) \
@@ -229,13 +277,40 @@ X(a, STATIC,   SINGULAR, UINT64,   earliest_present_time_ns,  15)
 #define monado_metrics_SystemPresentInfo_CALLBACK NULL
 #define monado_metrics_SystemPresentInfo_DEFAULT NULL
 
+#define monado_metrics_SystemGpuPhase_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, INT64,    frame_id,          1) \
+X(a, STATIC,   SINGULAR, UINT32,   phase,             2) \
+X(a, STATIC,   SINGULAR, UINT32,   view_index,        3) \
+X(a, STATIC,   SINGULAR, UINT64,   gpu_start_ns,      4) \
+X(a, STATIC,   SINGULAR, UINT64,   gpu_end_ns,        5) \
+X(a, STATIC,   SINGULAR, UINT64,   when_ns,           6)
+#define monado_metrics_SystemGpuPhase_CALLBACK NULL
+#define monado_metrics_SystemGpuPhase_DEFAULT NULL
+
+#define monado_metrics_DeviceIoStats_FIELDLIST(X, a) \
+X(a, STATIC,   SINGULAR, STRING,   name,              1) \
+X(a, STATIC,   SINGULAR, UINT64,   when_ns,           2) \
+X(a, STATIC,   SINGULAR, UINT64,   period_ns,         3) \
+X(a, STATIC,   SINGULAR, UINT32,   packet_count,      4) \
+X(a, STATIC,   SINGULAR, UINT32,   missed_count,      5) \
+X(a, STATIC,   SINGULAR, UINT32,   duplicate_count,   6) \
+X(a, STATIC,   SINGULAR, UINT64,   interval_mean_ns,   7) \
+X(a, STATIC,   SINGULAR, UINT64,   interval_max_ns,   8) \
+X(a, STATIC,   SINGULAR, UINT64,   process_mean_ns,   9) \
+X(a, STATIC,   SINGULAR, UINT64,   process_max_ns,   10) \
+X(a, STATIC,   SINGULAR, UINT32,   backlog_max,      11)
+#define monado_metrics_DeviceIoStats_CALLBACK NULL
+#define monado_metrics_DeviceIoStats_DEFAULT NULL
+
 #define monado_metrics_Record_FIELDLIST(X, a) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (record,version,record.version),   1) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (record,session_frame,record.session_frame),   2) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (record,used,record.used),   3) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (record,system_frame,record.system_frame),   4) \
 X(a, STATIC,   ONEOF,    MESSAGE,  (record,system_gpu_info,record.system_gpu_info),   5) \
-X(a, STATIC,   ONEOF,    MESSAGE,  (record,system_present_info,record.system_present_info),   6)
+X(a, STATIC,   ONEOF,    MESSAGE,  (record,system_present_info,record.system_present_info),   6) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (record,system_gpu_phase,record.system_gpu_phase),   7) \
+X(a, STATIC,   ONEOF,    MESSAGE,  (record,device_io_stats,record.device_io_stats),   8)
 #define monado_metrics_Record_CALLBACK NULL
 #define monado_metrics_Record_DEFAULT NULL
 #define monado_metrics_Record_record_version_MSGTYPE monado_metrics_Version
@@ -244,6 +319,8 @@ X(a, STATIC,   ONEOF,    MESSAGE,  (record,system_present_info,record.system_pre
 #define monado_metrics_Record_record_system_frame_MSGTYPE monado_metrics_SystemFrame
 #define monado_metrics_Record_record_system_gpu_info_MSGTYPE monado_metrics_SystemGpuInfo
 #define monado_metrics_Record_record_system_present_info_MSGTYPE monado_metrics_SystemPresentInfo
+#define monado_metrics_Record_record_system_gpu_phase_MSGTYPE monado_metrics_SystemGpuPhase
+#define monado_metrics_Record_record_device_io_stats_MSGTYPE monado_metrics_DeviceIoStats
 
 extern const pb_msgdesc_t monado_metrics_Version_msg;
 extern const pb_msgdesc_t monado_metrics_SessionFrame_msg;
@@ -251,6 +328,8 @@ extern const pb_msgdesc_t monado_metrics_Used_msg;
 extern const pb_msgdesc_t monado_metrics_SystemFrame_msg;
 extern const pb_msgdesc_t monado_metrics_SystemGpuInfo_msg;
 extern const pb_msgdesc_t monado_metrics_SystemPresentInfo_msg;
+extern const pb_msgdesc_t monado_metrics_SystemGpuPhase_msg;
+extern const pb_msgdesc_t monado_metrics_DeviceIoStats_msg;
 extern const pb_msgdesc_t monado_metrics_Record_msg;
 
 /* Defines for backwards compatibility with code written before nanopb-0.4.0 */
@@ -260,13 +339,17 @@ extern const pb_msgdesc_t monado_metrics_Record_msg;
 #define monado_metrics_SystemFrame_fields &monado_metrics_SystemFrame_msg
 #define monado_metrics_SystemGpuInfo_fields &monado_metrics_SystemGpuInfo_msg
 #define monado_metrics_SystemPresentInfo_fields &monado_metrics_SystemPresentInfo_msg
+#define monado_metrics_SystemGpuPhase_fields &monado_metrics_SystemGpuPhase_msg
+#define monado_metrics_DeviceIoStats_fields &monado_metrics_DeviceIoStats_msg
 #define monado_metrics_Record_fields &monado_metrics_Record_msg
 
 /* Maximum encoded size of messages (where known) */
+#define monado_metrics_DeviceIoStats_size         123
 #define monado_metrics_Record_size               168
 #define monado_metrics_SessionFrame_size         145
 #define monado_metrics_SystemFrame_size          66
 #define monado_metrics_SystemGpuInfo_size        44
+#define monado_metrics_SystemGpuPhase_size       56
 #define monado_metrics_SystemPresentInfo_size    165
 #define monado_metrics_Used_size                 44
 #define monado_metrics_Version_size              12
@@ -585,6 +585,9 @@ typedef enum XrStructureType {
     XR_TYPE_SYSTEM_PLANE_DETECTION_PROPERTIES_EXT = 1000429007,
     XR_TYPE_EVENT_DATA_USER_PRESENCE_CHANGED_EXT = 1000470000,
     XR_TYPE_SYSTEM_USER_PRESENCE_PROPERTIES_EXT = 1000470001,
+    XR_TYPE_SPACES_LOCATE_INFO_KHR = 1000471000,
+    XR_TYPE_SPACE_LOCATIONS_KHR = 1000471001,
+    XR_TYPE_SPACE_VELOCITIES_KHR = 1000471002,
     XR_TYPE_GRAPHICS_BINDING_VULKAN2_KHR = XR_TYPE_GRAPHICS_BINDING_VULKAN_KHR,
     XR_TYPE_SWAPCHAIN_IMAGE_VULKAN2_KHR = XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR,
     XR_TYPE_GRAPHICS_REQUIREMENTS_VULKAN2_KHR = XR_TYPE_GRAPHICS_REQUIREMENTS_VULKAN_KHR,
@@ -6924,6 +6927,56 @@ typedef struct XrSystemUserPresencePropertiesEXT {
 
 
 
+#define XR_KHR_locate_spaces 1
+#define XR_KHR_locate_spaces_SPEC_VERSION 1
+#define XR_KHR_LOCATE_SPACES_EXTENSION_NAME "XR_KHR_locate_spaces"
+typedef struct XrSpacesLocateInfoKHR {
+    XrStructureType             type;
+    const void* XR_MAY_ALIAS    next;
+    XrSpace                     baseSpace;
+    XrTime                      time;
+    uint32_t                    spaceCount;
+    const XrSpace*              spaces;
+} XrSpacesLocateInfoKHR;
+
+typedef struct XrSpaceLocationDataKHR {
+    XrSpaceLocationFlags    locationFlags;
+    XrPosef                 pose;
+} XrSpaceLocationDataKHR;
+
+typedef struct XrSpaceLocationsKHR {
+    XrStructureType            type;
+    void* XR_MAY_ALIAS         next;
+    uint32_t                   locationCount;
+    XrSpaceLocationDataKHR*    locations;
+} XrSpaceLocationsKHR;
+
+typedef struct XrSpaceVelocityDataKHR {
+    XrSpaceVelocityFlags    velocityFlags;
+    XrVector3f              linearVelocity;
+    XrVector3f              angularVelocity;
+} XrSpaceVelocityDataKHR;
+
+// XrSpaceVelocitiesKHR extends XrSpaceLocationsKHR
+typedef struct XrSpaceVelocitiesKHR {
+    XrStructureType            type;
+    void* XR_MAY_ALIAS         next;
+    uint32_t                   velocityCount;
+    XrSpaceVelocityDataKHR*    velocities;
+} XrSpaceVelocitiesKHR;
+
+typedef XrResult (XRAPI_PTR *PFN_xrLocateSpacesKHR)(XrSession session, const XrSpacesLocateInfoKHR* locateInfo, XrSpaceLocationsKHR* spaceLocations);
+
+#ifndef XR_NO_PROTOTYPES
+#ifdef XR_EXTENSION_PROTOTYPES
+XRAPI_ATTR XrResult XRAPI_CALL xrLocateSpacesKHR(
+    XrSession                                   session,
+    const XrSpacesLocateInfoKHR*                locateInfo,
+    XrSpaceLocationsKHR*                        spaceLocations);
+#endif /* XR_EXTENSION_PROTOTYPES */
+#endif /* !XR_NO_PROTOTYPES */
+
+
 #define XR_ML_user_calibration 1
 #define XR_ML_user_calibration_SPEC_VERSION 1
 #define XR_ML_USER_CALIBRATION_EXTENSION_NAME "XR_ML_user_calibration"
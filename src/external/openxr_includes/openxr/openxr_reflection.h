@@ -480,6 +480,9 @@ XR_ENUM_STR(XrResult);
     _(XR_TYPE_SYSTEM_PLANE_DETECTION_PROPERTIES_EXT, 1000429007) \
     _(XR_TYPE_EVENT_DATA_USER_PRESENCE_CHANGED_EXT, 1000470000) \
     _(XR_TYPE_SYSTEM_USER_PRESENCE_PROPERTIES_EXT, 1000470001) \
+    _(XR_TYPE_SPACES_LOCATE_INFO_KHR, 1000471000) \
+    _(XR_TYPE_SPACE_LOCATIONS_KHR, 1000471001) \
+    _(XR_TYPE_SPACE_VELOCITIES_KHR, 1000471002) \
     _(XR_STRUCTURE_TYPE_MAX_ENUM, 0x7FFFFFFF)
 
 #define XR_LIST_ENUM_XrFormFactor(_) \
@@ -4552,6 +4555,40 @@ XR_ENUM_STR(XrResult);
     _(next) \
     _(supportsUserPresence) \
 
+/// Calls your macro with the name of each member of XrSpacesLocateInfoKHR, in order.
+#define XR_LIST_STRUCT_XrSpacesLocateInfoKHR(_) \
+    _(type) \
+    _(next) \
+    _(baseSpace) \
+    _(time) \
+    _(spaceCount) \
+    _(spaces) \
+
+/// Calls your macro with the name of each member of XrSpaceLocationDataKHR, in order.
+#define XR_LIST_STRUCT_XrSpaceLocationDataKHR(_) \
+    _(locationFlags) \
+    _(pose) \
+
+/// Calls your macro with the name of each member of XrSpaceLocationsKHR, in order.
+#define XR_LIST_STRUCT_XrSpaceLocationsKHR(_) \
+    _(type) \
+    _(next) \
+    _(locationCount) \
+    _(locations) \
+
+/// Calls your macro with the name of each member of XrSpaceVelocityDataKHR, in order.
+#define XR_LIST_STRUCT_XrSpaceVelocityDataKHR(_) \
+    _(velocityFlags) \
+    _(linearVelocity) \
+    _(angularVelocity) \
+
+/// Calls your macro with the name of each member of XrSpaceVelocitiesKHR, in order.
+#define XR_LIST_STRUCT_XrSpaceVelocitiesKHR(_) \
+    _(type) \
+    _(next) \
+    _(velocityCount) \
+    _(velocities) \
+
 /// Calls your macro with the name of each member of XrEventDataHeadsetFitChangedML, in order.
 #define XR_LIST_STRUCT_XrEventDataHeadsetFitChangedML(_) \
     _(type) \
@@ -4896,6 +4933,9 @@ XR_ENUM_STR(XrResult);
     _(XrPlaneDetectorPolygonBufferEXT, XR_TYPE_PLANE_DETECTOR_POLYGON_BUFFER_EXT) \
     _(XrEventDataUserPresenceChangedEXT, XR_TYPE_EVENT_DATA_USER_PRESENCE_CHANGED_EXT) \
     _(XrSystemUserPresencePropertiesEXT, XR_TYPE_SYSTEM_USER_PRESENCE_PROPERTIES_EXT) \
+    _(XrSpacesLocateInfoKHR, XR_TYPE_SPACES_LOCATE_INFO_KHR) \
+    _(XrSpaceLocationsKHR, XR_TYPE_SPACE_LOCATIONS_KHR) \
+    _(XrSpaceVelocitiesKHR, XR_TYPE_SPACE_VELOCITIES_KHR) \
     _(XrEventDataHeadsetFitChangedML, XR_TYPE_EVENT_DATA_HEADSET_FIT_CHANGED_ML) \
     _(XrEventDataEyeCalibrationChangedML, XR_TYPE_EVENT_DATA_EYE_CALIBRATION_CHANGED_ML) \
     _(XrUserCalibrationEnableEventsInfoML, XR_TYPE_USER_CALIBRATION_ENABLE_EVENTS_INFO_ML) \
@@ -5214,6 +5254,7 @@ XR_ENUM_STR(XrResult);
     _(XR_EXT_plane_detection, 430) \
     _(XR_OPPO_controller_interaction, 454) \
     _(XR_EXT_user_presence, 471) \
+    _(XR_KHR_locate_spaces, 472) \
     _(XR_ML_user_calibration, 473) \
     _(XR_YVR_controller_interaction, 498) \
 
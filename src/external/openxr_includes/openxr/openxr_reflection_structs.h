@@ -344,6 +344,9 @@ This file contains expansion macros (X Macros) for OpenXR structures.
     _avail(XrPlaneDetectorPolygonBufferEXT, XR_TYPE_PLANE_DETECTOR_POLYGON_BUFFER_EXT) \
     _avail(XrEventDataUserPresenceChangedEXT, XR_TYPE_EVENT_DATA_USER_PRESENCE_CHANGED_EXT) \
     _avail(XrSystemUserPresencePropertiesEXT, XR_TYPE_SYSTEM_USER_PRESENCE_PROPERTIES_EXT) \
+    _avail(XrSpacesLocateInfoKHR, XR_TYPE_SPACES_LOCATE_INFO_KHR) \
+    _avail(XrSpaceLocationsKHR, XR_TYPE_SPACE_LOCATIONS_KHR) \
+    _avail(XrSpaceVelocitiesKHR, XR_TYPE_SPACE_VELOCITIES_KHR) \
     _avail(XrEventDataHeadsetFitChangedML, XR_TYPE_EVENT_DATA_HEADSET_FIT_CHANGED_ML) \
     _avail(XrEventDataEyeCalibrationChangedML, XR_TYPE_EVENT_DATA_EYE_CALIBRATION_CHANGED_ML) \
     _avail(XrUserCalibrationEnableEventsInfoML, XR_TYPE_USER_CALIBRATION_ENABLE_EVENTS_INFO_ML) \
@@ -14,18 +14,69 @@
 #include "util/u_debug.h"
 #include "util/u_handles.h"
 
+#include "os/os_threading.h"
+
 #include "xrt/xrt_vulkan_includes.h"
 
 #ifdef XRT_GRAPHICS_BUFFER_HANDLE_IS_AHARDWAREBUFFER
 #include <android/hardware_buffer.h>
 
 DEBUG_GET_ONCE_LOG_OPTION(ahardwarebuffer_log, "AHARDWAREBUFFER_LOG", U_LOGGING_WARN)
+DEBUG_GET_ONCE_NUM_OPTION(ahardwarebuffer_pool_size, "AHARDWAREBUFFER_POOL_SIZE", 8)
 #define AHB_TRACE(...) U_LOG_IFL_T(debug_get_log_option_ahardwarebuffer_log(), __VA_ARGS__)
 #define AHB_DEBUG(...) U_LOG_IFL_D(debug_get_log_option_ahardwarebuffer_log(), __VA_ARGS__)
 #define AHB_INFO(...) U_LOG_IFL_I(debug_get_log_option_ahardwarebuffer_log(), __VA_ARGS__)
 #define AHB_WARN(...) U_LOG_IFL_W(debug_get_log_option_ahardwarebuffer_log(), __VA_ARGS__)
 #define AHB_ERROR(...) U_LOG_IFL_E(debug_get_log_option_ahardwarebuffer_log(), __VA_ARGS__)
 
+/*!
+ * Most free buffers that can be kept for reuse, the default of
+ * AHARDWAREBUFFER_POOL_SIZE covers a stereo swapchain and its depth swapchain.
+ * Swapchains are often recreated with the same description, for instance when
+ * an app pauses and resumes.
+ */
+#define AHB_POOL_SIZE (16)
+
+struct ahb_pool_entry
+{
+	AHardwareBuffer_Desc desc;
+	AHardwareBuffer *buffer;
+};
+
+/*!
+ * Allocator that keeps released buffers around and hands them out again to
+ * swapchains with the same description.
+ *
+ * @implements xrt_image_native_allocator
+ */
+struct android_ahardwarebuffer_allocator
+{
+	struct xrt_image_native_allocator base;
+
+	//! Protects the pool, swapchains may be created from any thread.
+	struct os_mutex pool_mutex;
+
+	//! Oldest buffer first.
+	struct ahb_pool_entry pool[AHB_POOL_SIZE];
+	uint32_t pool_count;
+
+	//! How many buffers are kept at most, zero disables the pool.
+	uint32_t pool_max;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline struct android_ahardwarebuffer_allocator *
+android_ahardwarebuffer_allocator(struct xrt_image_native_allocator *xina)
+{
+	return (struct android_ahardwarebuffer_allocator *)xina;
+}
+
 static inline enum AHardwareBuffer_Format
 vk_format_to_ahardwarebuffer(uint64_t format)
 {
@@ -48,8 +99,13 @@ vk_format_to_ahardwarebuffer(uint64_t format)
 	}
 }
 
-xrt_result_t
-ahardwarebuffer_image_allocate(const struct xrt_swapchain_create_info *xsci, xrt_graphics_buffer_handle_t *out_image)
+/*!
+ * Fills in the description of the buffers for a swapchain. No CPU usage bits
+ * are ever set, that leaves the gralloc implementation free to pick a
+ * compressed (UBWC, AFBC) layout, which lowers the memory bandwidth needed.
+ */
+static xrt_result_t
+desc_from_create_info(const struct xrt_swapchain_create_info *xsci, AHardwareBuffer_Desc *out_desc)
 {
 	AHardwareBuffer_Desc desc;
 	U_ZERO(&desc);
@@ -62,21 +118,18 @@ ahardwarebuffer_image_allocate(const struct xrt_swapchain_create_info *xsci, xrt
 	desc.width = xsci->width;
 	desc.format = ahb_format;
 	desc.layers = xsci->array_size;
+	// Monado always samples layers
+	desc.usage |= AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE;
 	if (xsci->face_count == 6) {
 		desc.usage |= AHARDWAREBUFFER_USAGE_GPU_CUBE_MAP;
 		desc.layers *= 6;
 	}
+	if (xsci->mip_count > 1) {
+		desc.usage |= AHARDWAREBUFFER_USAGE_GPU_MIPMAP_COMPLETE;
+	}
 	if (0 != (xsci->bits & (XRT_SWAPCHAIN_USAGE_COLOR | XRT_SWAPCHAIN_USAGE_DEPTH_STENCIL))) {
 		desc.usage |= AHARDWAREBUFFER_USAGE_GPU_FRAMEBUFFER;
 	}
-
-	// The compositor always needs to sample the buffer, add the flag.
-	desc.usage |= AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE;
-
-	// Here if the above changes.
-	if (0 != (xsci->bits & XRT_SWAPCHAIN_USAGE_SAMPLED)) {
-		desc.usage |= AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE;
-	}
 	if (0 != (xsci->create & XRT_SWAPCHAIN_CREATE_PROTECTED_CONTENT)) {
 		desc.usage |= AHARDWAREBUFFER_USAGE_PROTECTED_CONTENT;
 	}
@@ -88,6 +141,100 @@ ahardwarebuffer_image_allocate(const struct xrt_swapchain_create_info *xsci, xrt
 	}
 #endif
 
+	*out_desc = desc;
+
+	return XRT_SUCCESS;
+}
+
+static bool
+desc_equal(const AHardwareBuffer_Desc *a, const AHardwareBuffer_Desc *b)
+{
+	return a->width == b->width && a->height == b->height && a->layers == b->layers && a->format == b->format &&
+	       a->usage == b->usage;
+}
+
+
+/*
+ *
+ * Pool functions.
+ *
+ */
+
+/*!
+ * Takes the most recently returned buffer matching @p desc out of the pool.
+ */
+static AHardwareBuffer *
+pool_take(struct android_ahardwarebuffer_allocator *aaa, const AHardwareBuffer_Desc *desc)
+{
+	AHardwareBuffer *buffer = NULL;
+
+	os_mutex_lock(&aaa->pool_mutex);
+	for (uint32_t i = aaa->pool_count; i-- > 0;) {
+		if (!desc_equal(&aaa->pool[i].desc, desc)) {
+			continue;
+		}
+
+		buffer = aaa->pool[i].buffer;
+		for (uint32_t k = i + 1; k < aaa->pool_count; k++) {
+			aaa->pool[k - 1] = aaa->pool[k];
+		}
+		aaa->pool_count--;
+		break;
+	}
+	os_mutex_unlock(&aaa->pool_mutex);
+
+	return buffer;
+}
+
+/*!
+ * Puts the buffer into the pool and takes over the reference, when full the
+ * oldest buffer is released to make room.
+ */
+static void
+pool_put(struct android_ahardwarebuffer_allocator *aaa, AHardwareBuffer *buffer)
+{
+	if (aaa->pool_max == 0) {
+		u_graphics_buffer_unref(&buffer);
+		return;
+	}
+
+	AHardwareBuffer *evicted = NULL;
+	AHardwareBuffer_Desc desc;
+	AHardwareBuffer_describe(buffer, &desc);
+
+	os_mutex_lock(&aaa->pool_mutex);
+	if (aaa->pool_count >= aaa->pool_max) {
+		evicted = aaa->pool[0].buffer;
+		for (uint32_t k = 1; k < aaa->pool_count; k++) {
+			aaa->pool[k - 1] = aaa->pool[k];
+		}
+		aaa->pool_count--;
+	}
+	aaa->pool[aaa->pool_count].desc = desc;
+	aaa->pool[aaa->pool_count].buffer = buffer;
+	aaa->pool_count++;
+	os_mutex_unlock(&aaa->pool_mutex);
+
+	// Does null checking.
+	u_graphics_buffer_unref(&evicted);
+}
+
+
+/*
+ *
+ * Allocator functions.
+ *
+ */
+
+xrt_result_t
+ahardwarebuffer_image_allocate(const struct xrt_swapchain_create_info *xsci, xrt_graphics_buffer_handle_t *out_image)
+{
+	AHardwareBuffer_Desc desc;
+	xrt_result_t xret = desc_from_create_info(xsci, &desc);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
 	int ret = AHardwareBuffer_allocate(&desc, out_image);
 	if (ret != 0) {
 		AHB_ERROR("Failed allocating image.");
@@ -103,40 +250,24 @@ ahardwarebuffer_images_allocate(struct xrt_image_native_allocator *xina,
                                 size_t image_count,
                                 struct xrt_image_native *out_images)
 {
-	AHardwareBuffer_Desc desc;
-	U_ZERO(&desc);
-	enum AHardwareBuffer_Format ahb_format = vk_format_to_ahardwarebuffer(xsci->format);
-	if (ahb_format == 0) {
-		AHB_ERROR("Could not convert %04" PRIx64 " to AHardwareBuffer_Format!", (uint64_t)xsci->format);
-		return XRT_ERROR_ALLOCATION;
-	}
-	desc.height = xsci->height;
-	desc.width = xsci->width;
-	desc.format = ahb_format;
-	desc.layers = xsci->array_size;
-	// Monado always samples layers
-	desc.usage |= AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE;
-	if (xsci->face_count == 6) {
-		desc.usage |= AHARDWAREBUFFER_USAGE_GPU_CUBE_MAP;
-		desc.layers *= 6;
-	}
-	if (0 != (xsci->bits & (XRT_SWAPCHAIN_USAGE_COLOR | XRT_SWAPCHAIN_USAGE_DEPTH_STENCIL))) {
-		desc.usage |= AHARDWAREBUFFER_USAGE_GPU_FRAMEBUFFER;
-	}
-	if (0 != (xsci->create & XRT_SWAPCHAIN_CREATE_PROTECTED_CONTENT)) {
-		desc.usage |= AHARDWAREBUFFER_USAGE_PROTECTED_CONTENT;
-	}
+	struct android_ahardwarebuffer_allocator *aaa = android_ahardwarebuffer_allocator(xina);
 
-#if __ANDROID_API__ >= 29
-	if (0 == AHardwareBuffer_isSupported(&desc)) {
-		AHB_ERROR("Computed AHardwareBuffer_Desc is not supported.");
-		return XRT_ERROR_ALLOCATION;
+	AHardwareBuffer_Desc desc;
+	xrt_result_t xret = desc_from_create_info(xsci, &desc);
+	if (xret != XRT_SUCCESS) {
+		return xret;
 	}
-#endif
 
 	memset(out_images, 0, sizeof(*out_images) * image_count);
 	bool failed = false;
+	uint32_t reused = 0;
 	for (size_t i = 0; i < image_count; ++i) {
+		out_images[i].handle = pool_take(aaa, &desc);
+		if (out_images[i].handle != NULL) {
+			reused++;
+			continue;
+		}
+
 		int ret = AHardwareBuffer_allocate(&desc, &(out_images[i].handle));
 		if (ret != 0) {
 			AHB_ERROR("Failed allocating image %d.", (int)i);
@@ -150,6 +281,9 @@ ahardwarebuffer_images_allocate(struct xrt_image_native_allocator *xina,
 		}
 		return XRT_ERROR_ALLOCATION;
 	}
+
+	AHB_DEBUG("Reused %u of %u images from the pool.", reused, (uint32_t)image_count);
+
 	return XRT_SUCCESS;
 }
 
@@ -158,27 +292,61 @@ ahardwarebuffer_images_free(struct xrt_image_native_allocator *xina,
                             size_t image_count,
                             struct xrt_image_native *images)
 {
+	struct android_ahardwarebuffer_allocator *aaa = android_ahardwarebuffer_allocator(xina);
+
 	for (size_t i = 0; i < image_count; ++i) {
-		u_graphics_buffer_unref(&(images[i].handle));
+		if (images[i].handle == NULL) {
+			continue;
+		}
+
+		pool_put(aaa, images[i].handle);
+		images[i].handle = NULL;
 	}
+
 	return XRT_SUCCESS;
 }
+
 static void
 ahardwarebuffer_destroy(struct xrt_image_native_allocator *xina)
 {
-	if (xina != NULL) {
-		free(xina);
+	if (xina == NULL) {
+		return;
 	}
+
+	struct android_ahardwarebuffer_allocator *aaa = android_ahardwarebuffer_allocator(xina);
+
+	for (uint32_t i = 0; i < aaa->pool_count; i++) {
+		u_graphics_buffer_unref(&aaa->pool[i].buffer);
+	}
+	aaa->pool_count = 0;
+
+	os_mutex_destroy(&aaa->pool_mutex);
+	free(aaa);
 }
 
 struct xrt_image_native_allocator *
 android_ahardwarebuffer_allocator_create()
 {
-	struct xrt_image_native_allocator *xina = U_TYPED_CALLOC(struct xrt_image_native_allocator);
-	xina->images_allocate = ahardwarebuffer_images_allocate;
-	xina->images_free = ahardwarebuffer_images_free;
-	xina->destroy = ahardwarebuffer_destroy;
-	return xina;
+	struct android_ahardwarebuffer_allocator *aaa = U_TYPED_CALLOC(struct android_ahardwarebuffer_allocator);
+	if (os_mutex_init(&aaa->pool_mutex) != 0) {
+		AHB_ERROR("Failed to init pool mutex!");
+		free(aaa);
+		return NULL;
+	}
+
+	long pool_max = debug_get_num_option_ahardwarebuffer_pool_size();
+	if (pool_max < 0) {
+		pool_max = 0;
+	} else if (pool_max > AHB_POOL_SIZE) {
+		pool_max = AHB_POOL_SIZE;
+	}
+	aaa->pool_max = (uint32_t)pool_max;
+
+	aaa->base.images_allocate = ahardwarebuffer_images_allocate;
+	aaa->base.images_free = ahardwarebuffer_images_free;
+	aaa->base.destroy = ahardwarebuffer_destroy;
+
+	return &aaa->base;
 }
 
 #endif // XRT_GRAPHICS_BUFFER_HANDLE_IS_AHARDWAREBUFFER
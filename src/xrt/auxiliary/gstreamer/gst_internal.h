@@ -12,6 +12,7 @@
 #include "xrt/xrt_frame.h"
 
 typedef struct _GstElement GstElement;
+typedef struct _GstAllocator GstAllocator;
 
 
 #ifdef __cplusplus
@@ -71,6 +72,15 @@ struct gstreamer_sink
 
 	//! Cached appsrc element.
 	GstElement *appsrc;
+
+	//! Wraps DMA-BUF fds into memories, only set for DMA-BUF sinks.
+	GstAllocator *dmabuf_allocator;
+
+	//! Size of the video, used for the video meta of DMA-BUF buffers.
+	uint32_t width, height;
+
+	//! The GstVideoFormat of DMA-BUF buffers.
+	int video_format;
 };
 
 
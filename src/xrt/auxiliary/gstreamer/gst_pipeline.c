@@ -16,6 +16,9 @@
 
 #include "gst/gst.h"
 
+#include <stdio.h>
+
+
 /*
  *
  * Internal pipeline functions.
@@ -52,12 +55,165 @@ destroy(struct xrt_frame_node *node)
 }
 
 
+/*
+ *
+ * Encoder functions.
+ *
+ */
+
+static const char *
+encoder_element_name(enum gstreamer_encoder encoder)
+{
+	switch (encoder) {
+	case GSTREAMER_ENCODER_SOFTWARE_H264: return "x264enc";
+	case GSTREAMER_ENCODER_VAAPI_H264: return "vaapih264enc";
+	case GSTREAMER_ENCODER_NVENC_H264: return "nvh264enc";
+	case GSTREAMER_ENCODER_V4L2_H264: return "v4l2h264enc";
+	default: return NULL;
+	}
+}
+
+/*!
+ * The elements between the appsrc and the encoder, they get the frames into
+ * a format, and memory, that the encoder takes.
+ */
+static const char *
+encoder_upload(const struct gstreamer_encoder_params *params)
+{
+	switch (params->encoder) {
+	case GSTREAMER_ENCODER_SOFTWARE_H264: return "videoconvert ! queue";
+	case GSTREAMER_ENCODER_VAAPI_H264:
+		// vaapipostproc imports the DMA-BUF and converts on the GPU.
+		if (params->dmabuf) {
+			return "vaapipostproc ! video/x-raw(memory:VASurface),format=NV12 ! queue";
+		}
+		return "videoconvert ! video/x-raw,format=NV12 ! queue";
+	case GSTREAMER_ENCODER_NVENC_H264: return "videoconvert ! video/x-raw,format=NV12 ! queue";
+	case GSTREAMER_ENCODER_V4L2_H264:
+		// The encoder reads the DMA-BUF directly, it must take the format.
+		if (params->dmabuf) {
+			return "queue";
+		}
+		return "videoconvert ! video/x-raw,format=NV12 ! queue";
+	default: return NULL;
+	}
+}
+
+static int
+encoder_element(const struct gstreamer_encoder_params *params, char *str, size_t size)
+{
+	bool low = params->latency == GSTREAMER_ENCODER_LATENCY_LOW;
+	uint32_t kbps = params->bitrate_kbps;
+
+	switch (params->encoder) {
+	case GSTREAMER_ENCODER_SOFTWARE_H264: {
+		const char *speed_preset = params->speed_preset;
+		if (speed_preset == NULL) {
+			speed_preset = low ? "ultrafast" : "medium";
+		}
+		return snprintf(str, size, "x264enc bitrate=%u speed-preset=\"%s\"%s", kbps, speed_preset,
+		                low ? " tune=zerolatency key-int-max=30" : "");
+	}
+	case GSTREAMER_ENCODER_VAAPI_H264:
+		return snprintf(str, size, "vaapih264enc rate-control=cbr bitrate=%u %s", kbps,
+		                low ? "max-bframes=0 keyframe-period=30" : "tune=high-compression");
+	case GSTREAMER_ENCODER_NVENC_H264:
+		return snprintf(str, size, "nvh264enc rc-mode=cbr bitrate=%u %s", kbps,
+		                low ? "preset=low-latency-hq zerolatency=true bframes=0 gop-size=30" : "preset=hq");
+	case GSTREAMER_ENCODER_V4L2_H264:
+		// The V4L2 controls take bits per second, bitrate mode 1 is CBR.
+		return snprintf(str, size,
+		                "v4l2h264enc%s extra-controls=\"controls,video_bitrate=%u,video_bitrate_mode=1,"
+		                "h264_i_frame_period=%u\"",
+		                params->dmabuf ? " output-io-mode=dmabuf-import" : "", kbps * 1000, low ? 30 : 120);
+	default: return -1;
+	}
+}
+
+
 /*
  *
  * Exported functions.
  *
  */
 
+bool
+gstreamer_encoder_is_available(enum gstreamer_encoder encoder)
+{
+	const char *name = encoder_element_name(encoder);
+	if (name == NULL) {
+		return false;
+	}
+
+	gst_init(NULL, NULL);
+
+	GstElementFactory *factory = gst_element_factory_find(name);
+	if (factory == NULL) {
+		return false;
+	}
+
+	gst_object_unref(factory);
+
+	return true;
+}
+
+bool
+gstreamer_encoder_supports_dmabuf(enum gstreamer_encoder encoder)
+{
+	switch (encoder) {
+	case GSTREAMER_ENCODER_VAAPI_H264:
+	case GSTREAMER_ENCODER_V4L2_H264: return true;
+	default: return false;
+	}
+}
+
+bool
+gstreamer_pipeline_create_encoder(struct xrt_frame_context *xfctx,
+                                  const struct gstreamer_encoder_params *params,
+                                  struct gstreamer_pipeline **out_gp)
+{
+	if (params->dmabuf && !gstreamer_encoder_supports_dmabuf(params->encoder)) {
+		U_LOG_E("Encoder '%s' can not import DMA-BUFs!", encoder_element_name(params->encoder));
+		return false;
+	}
+
+	if (!gstreamer_encoder_is_available(params->encoder)) {
+		U_LOG_E("Encoder '%s' is not installed!", encoder_element_name(params->encoder));
+		return false;
+	}
+
+	char encoder_string[256];
+	int ret = encoder_element(params, encoder_string, sizeof(encoder_string));
+	if (ret < 0 || (size_t)ret >= sizeof(encoder_string)) {
+		U_LOG_E("Failed to make encoder string!");
+		return false;
+	}
+
+	char pipeline_string[2048];
+	ret = snprintf(pipeline_string,         //
+	               sizeof(pipeline_string), //
+	               "appsrc name=\"%s\" ! "
+	               "queue ! "
+	               "%s ! "
+	               "%s ! "
+	               "video/x-h264,profile=main ! "
+	               "h264parse ! "
+	               "queue ! "
+	               "mp4mux ! "
+	               "filesink location=\"%s\"",
+	               params->appsrc_name, encoder_upload(params), encoder_string, params->filename);
+	if (ret < 0 || (size_t)ret >= sizeof(pipeline_string)) {
+		U_LOG_E("Failed to make pipeline string!");
+		return false;
+	}
+
+	U_LOG_D("Pipeline: %s", pipeline_string);
+
+	gstreamer_pipeline_create_from_string(xfctx, pipeline_string, out_gp);
+
+	return true;
+}
+
 void
 gstreamer_pipeline_play(struct gstreamer_pipeline *gp)
 {
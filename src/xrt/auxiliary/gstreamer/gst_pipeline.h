@@ -18,6 +18,87 @@ extern "C" {
 
 struct gstreamer_pipeline;
 
+/*!
+ * H264 encoders that @ref gstreamer_pipeline_create_encoder can record with.
+ */
+enum gstreamer_encoder
+{
+	//! Software x264enc.
+	GSTREAMER_ENCODER_SOFTWARE_H264,
+
+	//! vaapih264enc from gstreamer-vaapi, Intel and AMD GPUs.
+	GSTREAMER_ENCODER_VAAPI_H264,
+
+	//! nvh264enc from the nvcodec plugin, NVIDIA GPUs.
+	GSTREAMER_ENCODER_NVENC_H264,
+
+	//! v4l2h264enc, V4L2 memory-to-memory encoders found on most SoCs.
+	GSTREAMER_ENCODER_V4L2_H264,
+};
+
+/*!
+ * Tuning of the encoder, trades compression for how long frames are held.
+ */
+enum gstreamer_encoder_latency
+{
+	//! Best compression for a given bitrate, may use B-frames.
+	GSTREAMER_ENCODER_LATENCY_QUALITY,
+
+	//! No B-frames and short GOPs, frames leave the encoder right away.
+	GSTREAMER_ENCODER_LATENCY_LOW,
+};
+
+/*!
+ * Parameters for @ref gstreamer_pipeline_create_encoder.
+ */
+struct gstreamer_encoder_params
+{
+	enum gstreamer_encoder encoder;
+
+	enum gstreamer_encoder_latency latency;
+
+	//! Target bitrate in kbit/s, the encoders run in constant bitrate mode.
+	uint32_t bitrate_kbps;
+
+	//! x264 speed preset like "fast", NULL picks one from the latency.
+	const char *speed_preset;
+
+	/*!
+	 * The appsrc gives `memory:DMABuf` buffers, imported straight into the
+	 * encoder. Only valid if @ref gstreamer_encoder_supports_dmabuf.
+	 */
+	bool dmabuf;
+
+	//! Name of the appsrc to give to the @ref gstreamer_sink.
+	const char *appsrc_name;
+
+	//! The mp4 file to write.
+	const char *filename;
+};
+
+/*!
+ * Is the GStreamer element for the encoder installed.
+ */
+bool
+gstreamer_encoder_is_available(enum gstreamer_encoder encoder);
+
+/*!
+ * Can the encoder import DMA-BUF memory without copying it to the CPU.
+ */
+bool
+gstreamer_encoder_supports_dmabuf(enum gstreamer_encoder encoder);
+
+/*!
+ * Create a pipeline that encodes what is pushed into the appsrc and writes it
+ * to a mp4 file.
+ *
+ * @return False if the encoder is not available or the parameters are bad.
+ */
+bool
+gstreamer_pipeline_create_encoder(struct xrt_frame_context *xfctx,
+                                  const struct gstreamer_encoder_params *params,
+                                  struct gstreamer_pipeline **out_gp);
+
 void
 gstreamer_pipeline_create_from_string(struct xrt_frame_context *xfctx,
                                       const char *pipeline_string,
@@ -21,6 +21,7 @@
 #include "gst/video/gstvideometa.h"
 #include "gst/app/gstappsink.h"
 #include "gst/app/gstappsrc.h"
+#include "gst/allocators/gstdmabuf.h"
 
 #include <assert.h>
 
@@ -31,6 +32,15 @@
  *
  */
 
+/*!
+ * Release information for a buffer pushed with @ref gstreamer_sink_push_dmabuf.
+ */
+struct dmabuf_release
+{
+	gstreamer_sink_dmabuf_release_func_t func;
+	void *user_data;
+};
+
 static void
 wrapped_buffer_destroy(gpointer data)
 {
@@ -41,6 +51,17 @@ wrapped_buffer_destroy(gpointer data)
 	xrt_frame_reference(&xf, NULL);
 }
 
+static void
+dmabuf_memory_finalized(gpointer data, GstMiniObject *obj)
+{
+	struct dmabuf_release *release = (struct dmabuf_release *)data;
+
+	U_LOG_T("Called");
+
+	release->func(release->user_data);
+	free(release);
+}
+
 static GstVideoFormat
 gst_fmt_from_xf_format(enum xrt_format format_in)
 {
@@ -54,6 +75,19 @@ gst_fmt_from_xf_format(enum xrt_format format_in)
 	}
 }
 
+static const char *
+format_str_from_xf_format(enum xrt_format format_in)
+{
+	switch (format_in) {
+	case XRT_FORMAT_R8G8B8: return "RGB";
+	case XRT_FORMAT_R8G8B8A8: return "RGBA";
+	case XRT_FORMAT_R8G8B8X8: return "RGBx";
+	case XRT_FORMAT_YUYV422: return "YUY2";
+	case XRT_FORMAT_L8: return "GRAY8";
+	default: assert(false); return NULL;
+	}
+}
+
 static void
 complain_if_wrong_image_size(struct xrt_frame *xf)
 {
@@ -68,6 +102,22 @@ complain_if_wrong_image_size(struct xrt_frame *xf)
 	}
 }
 
+static void
+set_timestamps(struct gstreamer_sink *gs, GstBuffer *buffer, uint64_t xtimestamp_ns)
+{
+	// Use the first frame as offset.
+	if (gs->offset_ns == 0) {
+		gs->offset_ns = xtimestamp_ns;
+	}
+
+	// Need to be offset or gstreamer becomes sad.
+	GST_BUFFER_PTS(buffer) = xtimestamp_ns - gs->offset_ns;
+
+	// Duration is measured from last time stamp.
+	GST_BUFFER_DURATION(buffer) = xtimestamp_ns - gs->timestamp_ns;
+	gs->timestamp_ns = xtimestamp_ns;
+}
+
 static void
 push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 {
@@ -108,19 +158,7 @@ push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 	                               xf->height, 1, offsets, strides);
 
 	//! Get the timestampe from the frame.
-	uint64_t xtimestamp_ns = xf->timestamp;
-
-	// Use the first frame as offset.
-	if (gs->offset_ns == 0) {
-		gs->offset_ns = xtimestamp_ns;
-	}
-
-	// Need to be offset or gstreamer becomes sad.
-	GST_BUFFER_PTS(buffer) = xtimestamp_ns - gs->offset_ns;
-
-	// Duration is measured from last time stamp.
-	GST_BUFFER_DURATION(buffer) = xtimestamp_ns - gs->timestamp_ns;
-	gs->timestamp_ns = xtimestamp_ns;
+	set_timestamps(gs, buffer, xf->timestamp);
 
 	// All done, send it to the gstreamer pipeline.
 	ret = gst_app_src_push_buffer((GstAppSrc *)gs->appsrc, buffer);
@@ -129,6 +167,44 @@ push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 	}
 }
 
+static void
+release_dmabuf_frame(void *user_data)
+{
+	struct xrt_frame *xf = (struct xrt_frame *)user_data;
+
+	xrt_frame_reference(&xf, NULL);
+}
+
+static void
+push_frame_dmabuf(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	struct gstreamer_sink *gs = (struct gstreamer_sink *)xfs;
+
+	if (!xf->has_buffer_handle) {
+		U_LOG_E("DMA-BUF sink can only be given frames with buffer handles!");
+		return;
+	}
+
+#ifdef XRT_GRAPHICS_BUFFER_HANDLE_IS_FD
+	// Keeps the producer from reusing the buffer while it's being encoded.
+	struct xrt_frame *taken = NULL;
+	xrt_frame_reference(&taken, xf);
+
+	gstreamer_sink_push_dmabuf(       //
+	    gs,                           // gs
+	    (int)xf->buffer_handle,       // fd
+	    xf->buffer_offset + xf->size, // size
+	    xf->buffer_offset,            // offset
+	    xf->stride,                   // stride
+	    xf->timestamp,                // timestamp_ns
+	    release_dmabuf_frame,         // release_func
+	    taken);                       // user_data
+#else
+	(void)gs;
+	U_LOG_E("Buffer handles are not DMA-BUF fds on this platform!");
+#endif
+}
+
 static void
 enough_data(GstElement *appsrc, gpointer udata)
 {
@@ -162,10 +238,66 @@ destroy(struct xrt_frame_node *node)
 	 * be called, it's now safe to destroy and free ourselves.
 	 */
 
+	if (gs->dmabuf_allocator != NULL) {
+		gst_object_unref(gs->dmabuf_allocator);
+		gs->dmabuf_allocator = NULL;
+	}
+
 	free(gs);
 }
 
 
+static struct gstreamer_sink *
+create_sink(struct gstreamer_pipeline *gp,
+            uint32_t width,
+            uint32_t height,
+            const char *format_str,
+            const char *appsrc_name,
+            bool dmabuf)
+{
+	struct gstreamer_sink *gs = U_TYPED_CALLOC(struct gstreamer_sink);
+	gs->base.push_frame = dmabuf ? push_frame_dmabuf : push_frame;
+	gs->node.break_apart = break_apart;
+	gs->node.destroy = destroy;
+	gs->gp = gp;
+	gs->appsrc = gst_bin_get_by_name(GST_BIN(gp->pipeline), appsrc_name);
+	gs->width = width;
+	gs->height = height;
+	gs->video_format = gst_video_format_from_string(format_str);
+
+
+	GstCaps *caps = gst_caps_new_simple(      //
+	    "video/x-raw",                        //
+	    "format", G_TYPE_STRING, format_str,  //
+	    "width", G_TYPE_INT, width,           //
+	    "height", G_TYPE_INT, height,         //
+	    "framerate", GST_TYPE_FRACTION, 0, 1, //
+	    NULL);
+
+	if (dmabuf) {
+		gst_caps_set_features(caps, 0, gst_caps_features_new(GST_CAPS_FEATURE_MEMORY_DMABUF, NULL));
+		gs->dmabuf_allocator = gst_dmabuf_allocator_new();
+	}
+
+	g_object_set(G_OBJECT(gs->appsrc),                      //
+	             "caps", caps,                              //
+	             "stream-type", GST_APP_STREAM_TYPE_STREAM, //
+	             "format", GST_FORMAT_TIME,                 //
+	             "is-live", TRUE,                           //
+	             NULL);
+
+	g_signal_connect(G_OBJECT(gs->appsrc), "enough-data", G_CALLBACK(enough_data), gs);
+
+	/*
+	 * Add ourselves to the context so we are destroyed.
+	 * This is done once we know everything is completed.
+	 */
+	xrt_frame_context_add(gp->xfctx, &gs->node);
+
+	return gs;
+}
+
+
 /*
  *
  * Exported functions.
@@ -193,47 +325,85 @@ gstreamer_sink_create_with_pipeline(struct gstreamer_pipeline *gp,
                                     struct gstreamer_sink **out_gs,
                                     struct xrt_frame_sink **out_xfs)
 {
-	const char *format_str = NULL;
-	switch (format) {
-	case XRT_FORMAT_R8G8B8: format_str = "RGB"; break;
-	case XRT_FORMAT_R8G8B8A8: format_str = "RGBA"; break;
-	case XRT_FORMAT_R8G8B8X8: format_str = "RGBx"; break;
-	case XRT_FORMAT_YUYV422: format_str = "YUY2"; break;
-	case XRT_FORMAT_L8: format_str = "GRAY8"; break;
-	default: assert(false); break;
-	}
-
-	struct gstreamer_sink *gs = U_TYPED_CALLOC(struct gstreamer_sink);
-	gs->base.push_frame = push_frame;
-	gs->node.break_apart = break_apart;
-	gs->node.destroy = destroy;
-	gs->gp = gp;
-	gs->appsrc = gst_bin_get_by_name(GST_BIN(gp->pipeline), appsrc_name);
+	const char *format_str = format_str_from_xf_format(format);
 
+	struct gstreamer_sink *gs = create_sink(gp, width, height, format_str, appsrc_name, false);
 
-	GstCaps *caps = gst_caps_new_simple(      //
-	    "video/x-raw",                        //
-	    "format", G_TYPE_STRING, format_str,  //
-	    "width", G_TYPE_INT, width,           //
-	    "height", G_TYPE_INT, height,         //
-	    "framerate", GST_TYPE_FRACTION, 0, 1, //
-	    NULL);
+	*out_gs = gs;
+	*out_xfs = &gs->base;
+}
 
-	g_object_set(G_OBJECT(gs->appsrc),                      //
-	             "caps", caps,                              //
-	             "stream-type", GST_APP_STREAM_TYPE_STREAM, //
-	             "format", GST_FORMAT_TIME,                 //
-	             "is-live", TRUE,                           //
-	             NULL);
+void
+gstreamer_sink_create_dmabuf_with_pipeline(struct gstreamer_pipeline *gp,
+                                           uint32_t width,
+                                           uint32_t height,
+                                           const char *format_str,
+                                           const char *appsrc_name,
+                                           struct gstreamer_sink **out_gs)
+{
+	*out_gs = create_sink(gp, width, height, format_str, appsrc_name, true);
+}
 
-	g_signal_connect(G_OBJECT(gs->appsrc), "enough-data", G_CALLBACK(enough_data), gs);
+void
+gstreamer_sink_create_dmabuf_frames_with_pipeline(struct gstreamer_pipeline *gp,
+                                                  uint32_t width,
+                                                  uint32_t height,
+                                                  enum xrt_format format,
+                                                  const char *appsrc_name,
+                                                  struct gstreamer_sink **out_gs,
+                                                  struct xrt_frame_sink **out_xfs)
+{
+	const char *format_str = format_str_from_xf_format(format);
 
-	/*
-	 * Add ourselves to the context so we are destroyed.
-	 * This is done once we know everything is completed.
-	 */
-	xrt_frame_context_add(gp->xfctx, &gs->node);
+	struct gstreamer_sink *gs = create_sink(gp, width, height, format_str, appsrc_name, true);
 
 	*out_gs = gs;
 	*out_xfs = &gs->base;
 }
+
+bool
+gstreamer_sink_push_dmabuf(struct gstreamer_sink *gs,
+                           int fd,
+                           size_t size,
+                           size_t offset,
+                           uint32_t stride,
+                           uint64_t timestamp_ns,
+                           gstreamer_sink_dmabuf_release_func_t release_func,
+                           void *user_data)
+{
+	SINK_TRACE_MARKER();
+
+	assert(gs->dmabuf_allocator != NULL);
+
+	// The caller owns the fd, it's kept open until the release.
+	GstMemory *memory = gst_dmabuf_allocator_alloc_with_flags( //
+	    gs->dmabuf_allocator,                                  // allocator
+	    fd,                                                    // fd
+	    size,                                                  // size
+	    GST_FD_MEMORY_FLAG_DONT_CLOSE);                        // flags
+
+	// Copies of the buffer share the memory, so it outlives the buffer.
+	struct dmabuf_release *release = U_TYPED_CALLOC(struct dmabuf_release);
+	release->func = release_func;
+	release->user_data = user_data;
+	gst_mini_object_weak_ref(GST_MINI_OBJECT(memory), dmabuf_memory_finalized, release);
+
+	GstBuffer *buffer = gst_buffer_new();
+	gst_buffer_append_memory(buffer, memory);
+
+	gsize offsets[4] = {offset, 0, 0, 0};
+	gint strides[4] = {(gint)stride, 0, 0, 0};
+	gst_buffer_add_video_meta_full(buffer, GST_VIDEO_FRAME_FLAG_NONE, (GstVideoFormat)gs->video_format, gs->width,
+	                               gs->height, 1, offsets, strides);
+
+	set_timestamps(gs, buffer, timestamp_ns);
+
+	// Takes ownership of the buffer, even on failure.
+	GstFlowReturn ret = gst_app_src_push_buffer((GstAppSrc *)gs->appsrc, buffer);
+	if (ret != GST_FLOW_OK) {
+		U_LOG_E("Got GST error '%i'", ret);
+		return false;
+	}
+
+	return true;
+}
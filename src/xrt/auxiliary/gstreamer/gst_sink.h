@@ -18,6 +18,12 @@ extern "C" {
 struct gstreamer_sink;
 struct gstreamer_pipeline;
 
+/*!
+ * Called when GStreamer no longer uses a buffer pushed with
+ * @ref gstreamer_sink_push_dmabuf, from any thread.
+ */
+typedef void (*gstreamer_sink_dmabuf_release_func_t)(void *user_data);
+
 
 void
 gstreamer_sink_send_eos(struct gstreamer_sink *gs);
@@ -34,6 +40,52 @@ gstreamer_sink_create_with_pipeline(struct gstreamer_pipeline *gp,
                                     struct gstreamer_sink **out_gs,
                                     struct xrt_frame_sink **out_xfs);
 
+/*!
+ * Create a sink that is fed DMA-BUF fds with @ref gstreamer_sink_push_dmabuf
+ * instead of @ref xrt_frame, the caps have the `memory:DMABuf` feature so
+ * hardware encoders can import the memory without any copies. The format is
+ * given as a GStreamer video format string like "RGBA" or "BGRA".
+ */
+void
+gstreamer_sink_create_dmabuf_with_pipeline(struct gstreamer_pipeline *gp,
+                                           uint32_t width,
+                                           uint32_t height,
+                                           const char *format_str,
+                                           const char *appsrc_name,
+                                           struct gstreamer_sink **out_gs);
+
+/*!
+ * Same as @ref gstreamer_sink_create_dmabuf_with_pipeline but fed with
+ * @ref xrt_frame that have a buffer handle, like the exported DMA-BUFs from
+ * the V4L2 driver. Each frame is referenced until GStreamer is done with the
+ * memory, frames without a buffer handle are not pushed.
+ */
+void
+gstreamer_sink_create_dmabuf_frames_with_pipeline(struct gstreamer_pipeline *gp,
+                                                  uint32_t width,
+                                                  uint32_t height,
+                                                  enum xrt_format format,
+                                                  const char *appsrc_name,
+                                                  struct gstreamer_sink **out_gs,
+                                                  struct xrt_frame_sink **out_xfs);
+
+/*!
+ * Push one linear image held by a DMA-BUF into the pipeline. The fd stays
+ * owned by the caller and must stay valid until @p release_func is called.
+ *
+ * @return False if GStreamer did not accept the buffer, @p release_func has
+ *         still been called in that case.
+ */
+bool
+gstreamer_sink_push_dmabuf(struct gstreamer_sink *gs,
+                           int fd,
+                           size_t size,
+                           size_t offset,
+                           uint32_t stride,
+                           uint64_t timestamp_ns,
+                           gstreamer_sink_dmabuf_release_func_t release_func,
+                           void *user_data);
+
 
 #ifdef __cplusplus
 }
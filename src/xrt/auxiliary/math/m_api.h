@@ -746,6 +746,37 @@ math_pose_transform(const struct xrt_pose *transform, const struct xrt_pose *pos
 void
 math_pose_transform_point(const struct xrt_pose *transform, const struct xrt_vec3 *point, struct xrt_vec3 *out_point);
 
+/*!
+ * Apply a rigid-body transformation to an array of points, gives the same
+ * result as calling @ref math_pose_transform_point on each of them.
+ *
+ * The input points and outputs may be the same pointer.
+ *
+ * @relates xrt_pose
+ * @see xrt_vec3
+ * @ingroup aux_math
+ */
+void
+math_pose_transform_points(const struct xrt_pose *transform,
+                           const struct xrt_vec3 *points,
+                           uint32_t count,
+                           struct xrt_vec3 *out_points);
+
+/*!
+ * Apply a rigid-body transformation to an array of poses, gives the same
+ * result as calling @ref math_pose_transform on each of them.
+ *
+ * The input poses and outputs may be the same pointer.
+ *
+ * @relates xrt_pose
+ * @ingroup aux_math
+ */
+void
+math_pose_transform_many(const struct xrt_pose *transform,
+                         const struct xrt_pose *poses,
+                         uint32_t count,
+                         struct xrt_pose *out_poses);
+
 
 /*
  *
@@ -937,3 +937,64 @@ math_pose_transform_point(const struct xrt_pose *transform, const struct xrt_vec
 
 	map_vec3(*out_point) = transform_point(*transform, *point);
 }
+
+/*
+ * The batch variants below convert the transform's rotation to a matrix once,
+ * this is cheaper per point than rotating with the quaternion and lets Eigen
+ * vectorise the whole array as a single matrix product.
+ */
+
+extern "C" void
+math_pose_transform_points(const struct xrt_pose *transform,
+                           const struct xrt_vec3 *points,
+                           uint32_t count,
+                           struct xrt_vec3 *out_points)
+{
+	assert(transform != NULL);
+	assert(points != NULL || count == 0);
+	assert(out_points != NULL || count == 0);
+
+	if (count == 0) {
+		return;
+	}
+
+	static_assert(sizeof(struct xrt_vec3) == sizeof(float) * 3, "xrt_vec3 must be tightly packed");
+
+	Eigen::Matrix3f rotation = orientation(*transform).toRotationMatrix();
+	Eigen::Map<const Eigen::Matrix3Xf> in(&points[0].x, 3, count);
+	Eigen::Map<Eigen::Matrix3Xf> out(&out_points[0].x, 3, count);
+
+	// The product is evaluated into a temporary, so in and out may alias.
+	out = (rotation * in).colwise() + position(*transform);
+}
+
+extern "C" void
+math_pose_transform_many(const struct xrt_pose *transform,
+                         const struct xrt_pose *poses,
+                         uint32_t count,
+                         struct xrt_pose *out_poses)
+{
+	assert(transform != NULL);
+	assert(poses != NULL || count == 0);
+	assert(out_poses != NULL || count == 0);
+
+	if (count == 0) {
+		return;
+	}
+
+	static_assert(sizeof(struct xrt_pose) == sizeof(float) * 7, "xrt_pose must be tightly packed");
+	using PositionMap = Eigen::Map<Eigen::Matrix3Xf, 0, Eigen::OuterStride<7>>;
+	using ConstPositionMap = Eigen::Map<const Eigen::Matrix3Xf, 0, Eigen::OuterStride<7>>;
+
+	Eigen::Matrix3f rotation = orientation(*transform).toRotationMatrix();
+	ConstPositionMap in(&poses[0].position.x, 3, count);
+	PositionMap out(&out_poses[0].position.x, 3, count);
+
+	// The product is evaluated into a temporary, so in and out may alias.
+	out = (rotation * in).colwise() + position(*transform);
+
+	Eigen::Quaternionf q = orientation(*transform);
+	for (uint32_t i = 0; i < count; i++) {
+		orientation(out_poses[i]) = q * orientation(poses[i]);
+	}
+}
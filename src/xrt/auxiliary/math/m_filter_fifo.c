@@ -13,6 +13,81 @@
 #include <assert.h>
 
 
+/*
+ *
+ * Shared helpers.
+ *
+ */
+
+/*
+ * Both fifos store samples in a power of two ring indexed by the total number
+ * of samples pushed, the fifo is filled with zero samples at timepoint zero on
+ * allocation so that count starts at num. Next to the samples a running sum of
+ * all samples pushed is kept, making the sum over a window two lookups. The
+ * ring is larger than num so the running sum before the oldest sample is kept.
+ */
+
+static size_t
+ring_size_for(size_t num)
+{
+	size_t size = 1;
+	while (size < num + 1) {
+		size <<= 1;
+	}
+	return size;
+}
+
+/*!
+ * Returns the first index, between @p first and @p end, where the timestamp
+ * is not less than @p timestamp_ns, or @p end if there are none.
+ */
+static uint64_t
+ring_lower_bound(const uint64_t *timestamps_ns, size_t mask, uint64_t first, uint64_t end, uint64_t timestamp_ns)
+{
+	while (first < end) {
+		uint64_t mid = first + (end - first) / 2;
+		if (timestamps_ns[mid & mask] < timestamp_ns) {
+			first = mid + 1;
+		} else {
+			end = mid;
+		}
+	}
+
+	return first;
+}
+
+/*!
+ * Finds the indices of the samples between the two timepoints, inclusive,
+ * the samples are the ones in [out_low, out_high).
+ */
+static void
+ring_find_window(const uint64_t *timestamps_ns,
+                 size_t mask,
+                 uint64_t first,
+                 uint64_t end,
+                 uint64_t start_ns,
+                 uint64_t stop_ns,
+                 uint64_t *out_low,
+                 uint64_t *out_high)
+{
+	// Error, skip averaging.
+	if (start_ns > stop_ns) {
+		*out_low = end;
+		*out_high = end;
+		return;
+	}
+
+	uint64_t low = ring_lower_bound(timestamps_ns, mask, first, end, start_ns);
+	uint64_t high = end;
+	if (stop_ns < UINT64_MAX) {
+		high = ring_lower_bound(timestamps_ns, mask, low, end, stop_ns + 1);
+	}
+
+	*out_low = low;
+	*out_high = high;
+}
+
+
 /*
  *
  * Filter fifo vec3_f32.
@@ -21,10 +96,20 @@
 
 struct m_ff_vec3_f32
 {
+	//! Number of samples tracked.
 	size_t num;
-	size_t latest;
+
+	//! Size of the ring minus one, the size is a power of two.
+	size_t mask;
+
+	//! Total number of samples pushed, including the ones filled at alloc.
+	uint64_t count;
+
 	struct xrt_vec3 *samples;
 	uint64_t *timestamps_ns;
+
+	//! Sum of all samples pushed up to and including the one at the index.
+	struct xrt_vec3_f64 *sums;
 };
 
 
@@ -37,10 +122,14 @@ struct m_ff_vec3_f32
 static void
 vec3_f32_init(struct m_ff_vec3_f32 *ff, size_t num)
 {
-	ff->samples = U_TYPED_ARRAY_CALLOC(struct xrt_vec3, num);
-	ff->timestamps_ns = U_TYPED_ARRAY_CALLOC(uint64_t, num);
+	size_t size = ring_size_for(num);
+
+	ff->samples = U_TYPED_ARRAY_CALLOC(struct xrt_vec3, size);
+	ff->timestamps_ns = U_TYPED_ARRAY_CALLOC(uint64_t, size);
+	ff->sums = U_TYPED_ARRAY_CALLOC(struct xrt_vec3_f64, size);
 	ff->num = num;
-	ff->latest = 0;
+	ff->mask = size - 1;
+	ff->count = num;
 }
 
 static void
@@ -56,8 +145,14 @@ vec3_f32_destroy(struct m_ff_vec3_f32 *ff)
 		ff->timestamps_ns = NULL;
 	}
 
+	if (ff->sums != NULL) {
+		free(ff->sums);
+		ff->sums = NULL;
+	}
+
 	ff->num = 0;
-	ff->latest = 0;
+	ff->mask = 0;
+	ff->count = 0;
 }
 
 
@@ -97,14 +192,34 @@ m_ff_vec3_f32_get_num(struct m_ff_vec3_f32 *ff)
 void
 m_ff_vec3_f32_push(struct m_ff_vec3_f32 *ff, const struct xrt_vec3 *sample, uint64_t timestamp_ns)
 {
-	assert(ff->timestamps_ns[ff->latest] <= timestamp_ns);
+	m_ff_vec3_f32_push_many(ff, sample, &timestamp_ns, 1);
+}
 
-	// We write samples backwards in the queue.
-	size_t i = ff->latest == 0 ? ff->num - 1 : --ff->latest;
-	ff->latest = i;
+void
+m_ff_vec3_f32_push_many(struct m_ff_vec3_f32 *ff,
+                        const struct xrt_vec3 *samples,
+                        const uint64_t *timestamps_ns,
+                        size_t sample_count)
+{
+	size_t mask = ff->mask;
+	uint64_t c = ff->count;
+	struct xrt_vec3_f64 sum = ff->sums[(c - 1) & mask];
 
-	ff->samples[i] = *sample;
-	ff->timestamps_ns[i] = timestamp_ns;
+	for (size_t k = 0; k < sample_count; k++, c++) {
+		size_t i = c & mask;
+
+		assert(ff->timestamps_ns[(c - 1) & mask] <= timestamps_ns[k]);
+
+		sum.x += samples[k].x;
+		sum.y += samples[k].y;
+		sum.z += samples[k].z;
+
+		ff->samples[i] = samples[k];
+		ff->timestamps_ns[i] = timestamps_ns[k];
+		ff->sums[i] = sum;
+	}
+
+	ff->count = c;
 }
 
 bool
@@ -114,7 +229,7 @@ m_ff_vec3_f32_get(struct m_ff_vec3_f32 *ff, size_t num, struct xrt_vec3 *out_sam
 		return false;
 	}
 
-	size_t pos = (ff->latest + num) % ff->num;
+	size_t pos = (ff->count - 1 - num) & ff->mask;
 	*out_sample = ff->samples[pos];
 	*out_timestamp_ns = ff->timestamps_ns[pos];
 
@@ -124,50 +239,25 @@ m_ff_vec3_f32_get(struct m_ff_vec3_f32 *ff, size_t num, struct xrt_vec3 *out_sam
 size_t
 m_ff_vec3_f32_filter(struct m_ff_vec3_f32 *ff, uint64_t start_ns, uint64_t stop_ns, struct xrt_vec3 *out_average)
 {
-	size_t num_sampled = 0;
-	size_t count = 0;
-	// Use double precision internally.
-	double x = 0;
-	double y = 0;
-	double z = 0;
-
-	// Error, skip averaging.
-	if (start_ns > stop_ns) {
-		count = ff->num;
-	}
-
-	while (count < ff->num) {
-		size_t pos = (ff->latest + count) % ff->num;
+	uint64_t low = 0;
+	uint64_t high = 0;
+	ring_find_window(ff->timestamps_ns, ff->mask, ff->count - ff->num, ff->count, start_ns, stop_ns, &low, &high);
 
-		// We have not yet reached where to start.
-		if (ff->timestamps_ns[pos] > stop_ns) {
-			count++;
-			continue;
-		}
-
-		// If the sample is before the start we have reach the end.
-		if (ff->timestamps_ns[pos] < start_ns) {
-			count++;
-			break;
-		}
-
-		x += ff->samples[pos].x;
-		y += ff->samples[pos].y;
-		z += ff->samples[pos].z;
-		num_sampled++;
-		count++;
-	}
+	size_t num_sampled = (size_t)(high - low);
 
 	// Avoid division by zero.
-	if (num_sampled > 0) {
-		x /= num_sampled;
-		y /= num_sampled;
-		z /= num_sampled;
+	if (num_sampled == 0) {
+		U_ZERO(out_average);
+		return 0;
 	}
 
-	out_average->x = (float)x;
-	out_average->y = (float)y;
-	out_average->z = (float)z;
+	// Use double precision internally.
+	const struct xrt_vec3_f64 *a = &ff->sums[(low - 1) & ff->mask];
+	const struct xrt_vec3_f64 *b = &ff->sums[(high - 1) & ff->mask];
+
+	out_average->x = (float)((b->x - a->x) / num_sampled);
+	out_average->y = (float)((b->y - a->y) / num_sampled);
+	out_average->z = (float)((b->z - a->z) / num_sampled);
 
 	return num_sampled;
 }
@@ -181,10 +271,20 @@ m_ff_vec3_f32_filter(struct m_ff_vec3_f32 *ff, uint64_t start_ns, uint64_t stop_
 
 struct m_ff_f64
 {
+	//! Number of samples tracked.
 	size_t num;
-	size_t latest;
+
+	//! Size of the ring minus one, the size is a power of two.
+	size_t mask;
+
+	//! Total number of samples pushed, including the ones filled at alloc.
+	uint64_t count;
+
 	double *samples;
 	uint64_t *timestamps_ns;
+
+	//! Sum of all samples pushed up to and including the one at the index.
+	double *sums;
 };
 
 
@@ -197,10 +297,14 @@ struct m_ff_f64
 static void
 ff_f64_init(struct m_ff_f64 *ff, size_t num)
 {
-	ff->samples = U_TYPED_ARRAY_CALLOC(double, num);
-	ff->timestamps_ns = U_TYPED_ARRAY_CALLOC(uint64_t, num);
+	size_t size = ring_size_for(num);
+
+	ff->samples = U_TYPED_ARRAY_CALLOC(double, size);
+	ff->timestamps_ns = U_TYPED_ARRAY_CALLOC(uint64_t, size);
+	ff->sums = U_TYPED_ARRAY_CALLOC(double, size);
 	ff->num = num;
-	ff->latest = 0;
+	ff->mask = size - 1;
+	ff->count = num;
 }
 
 static void
@@ -216,8 +320,14 @@ ff_f64_destroy(struct m_ff_f64 *ff)
 		ff->timestamps_ns = NULL;
 	}
 
+	if (ff->sums != NULL) {
+		free(ff->sums);
+		ff->sums = NULL;
+	}
+
 	ff->num = 0;
-	ff->latest = 0;
+	ff->mask = 0;
+	ff->count = 0;
 }
 
 
@@ -257,14 +367,29 @@ m_ff_f64_get_num(struct m_ff_f64 *ff)
 void
 m_ff_f64_push(struct m_ff_f64 *ff, const double *sample, uint64_t timestamp_ns)
 {
-	assert(ff->timestamps_ns[ff->latest] <= timestamp_ns);
+	m_ff_f64_push_many(ff, sample, &timestamp_ns, 1);
+}
 
-	// We write samples backwards in the queue.
-	size_t i = ff->latest == 0 ? ff->num - 1 : --ff->latest;
-	ff->latest = i;
+void
+m_ff_f64_push_many(struct m_ff_f64 *ff, const double *samples, const uint64_t *timestamps_ns, size_t sample_count)
+{
+	size_t mask = ff->mask;
+	uint64_t c = ff->count;
+	double sum = ff->sums[(c - 1) & mask];
+
+	for (size_t k = 0; k < sample_count; k++, c++) {
+		size_t i = c & mask;
+
+		assert(ff->timestamps_ns[(c - 1) & mask] <= timestamps_ns[k]);
+
+		sum += samples[k];
+
+		ff->samples[i] = samples[k];
+		ff->timestamps_ns[i] = timestamps_ns[k];
+		ff->sums[i] = sum;
+	}
 
-	ff->samples[i] = *sample;
-	ff->timestamps_ns[i] = timestamp_ns;
+	ff->count = c;
 }
 
 bool
@@ -274,7 +399,7 @@ m_ff_f64_get(struct m_ff_f64 *ff, size_t num, double *out_sample, uint64_t *out_
 		return false;
 	}
 
-	size_t pos = (ff->latest + num) % ff->num;
+	size_t pos = (ff->count - 1 - num) & ff->mask;
 	*out_sample = ff->samples[pos];
 	*out_timestamp_ns = ff->timestamps_ns[pos];
 
@@ -284,41 +409,19 @@ m_ff_f64_get(struct m_ff_f64 *ff, size_t num, double *out_sample, uint64_t *out_
 size_t
 m_ff_f64_filter(struct m_ff_f64 *ff, uint64_t start_ns, uint64_t stop_ns, double *out_average)
 {
-	size_t num_sampled = 0;
-	size_t count = 0;
-	double val = 0;
+	uint64_t low = 0;
+	uint64_t high = 0;
+	ring_find_window(ff->timestamps_ns, ff->mask, ff->count - ff->num, ff->count, start_ns, stop_ns, &low, &high);
 
-	// Error, skip averaging.
-	if (start_ns > stop_ns) {
-		count = ff->num;
-	}
-
-	while (count < ff->num) {
-		size_t pos = (ff->latest + count) % ff->num;
-
-		// We have not yet reached where to start.
-		if (ff->timestamps_ns[pos] > stop_ns) {
-			count++;
-			continue;
-		}
-
-		// If the sample is before the start we have reach the end.
-		if (ff->timestamps_ns[pos] < start_ns) {
-			count++;
-			break;
-		}
-
-		val += ff->samples[pos];
-		num_sampled++;
-		count++;
-	}
+	size_t num_sampled = (size_t)(high - low);
 
 	// Avoid division by zero.
-	if (num_sampled > 0) {
-		val /= num_sampled;
+	if (num_sampled == 0) {
+		*out_average = 0;
+		return 0;
 	}
 
-	*out_average = val;
+	*out_average = (ff->sums[(high - 1) & ff->mask] - ff->sums[(low - 1) & ff->mask]) / num_sampled;
 
 	return num_sampled;
 }
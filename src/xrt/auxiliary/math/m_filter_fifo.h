@@ -45,6 +45,16 @@ m_ff_vec3_f32_get_num(struct m_ff_vec3_f32 *ff);
 void
 m_ff_vec3_f32_push(struct m_ff_vec3_f32 *ff, const struct xrt_vec3 *sample, uint64_t timestamp_ns);
 
+/*!
+ * Pushes @p sample_count samples in one go, same as calling
+ * @ref m_ff_vec3_f32_push for each, the samples must be in time order.
+ */
+void
+m_ff_vec3_f32_push_many(struct m_ff_vec3_f32 *ff,
+                        const struct xrt_vec3 *samples,
+                        const uint64_t *timestamps_ns,
+                        size_t sample_count);
+
 /*!
  * Return the sample at the index, zero means the last sample push, one second
  * last and so on.
@@ -93,6 +103,13 @@ m_ff_f64_get_num(struct m_ff_f64 *ff);
 void
 m_ff_f64_push(struct m_ff_f64 *ff, const double *sample, uint64_t timestamp_ns);
 
+/*!
+ * Pushes @p sample_count samples in one go, same as calling
+ * @ref m_ff_f64_push for each, the samples must be in time order.
+ */
+void
+m_ff_f64_push_many(struct m_ff_f64 *ff, const double *samples, const uint64_t *timestamps_ns, size_t sample_count);
+
 /*!
  * Return the sample at the index, 0 means the last sample push, 1 second-to-last, etc.
  */
@@ -160,6 +177,17 @@ public:
 		m_ff_vec3_f32_push(mFifoPtr, &sample, timestamp_ns);
 	}
 
+	/*!
+	 * @copydoc m_ff_vec3_f32_push_many
+	 *
+	 * Wrapper for @ref m_ff_vec3_f32_push_many.
+	 */
+	inline void
+	push_many(const xrt_vec3 *samples, const uint64_t *timestamps_ns, size_t sample_count)
+	{
+		m_ff_vec3_f32_push_many(mFifoPtr, samples, timestamps_ns, sample_count);
+	}
+
 	/*!
 	 * @copydoc m_ff_vec3_f32_get
 	 *
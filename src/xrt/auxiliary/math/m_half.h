@@ -0,0 +1,122 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  IEEE 754 half precision float conversion helpers.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_math
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+static inline bool
+m_half_round_up(uint32_t rem, uint32_t halfway, uint32_t value)
+{
+	// Round to nearest, ties to even.
+	return rem > halfway || (rem == halfway && (value & 1) != 0);
+}
+
+/*!
+ * Convert a float to a half float, rounding to nearest even. Values too large
+ * become infinity and NaNs stay NaNs.
+ *
+ * @ingroup aux_math
+ */
+static inline uint16_t
+m_float_to_half(float f)
+{
+	uint32_t x;
+	memcpy(&x, &f, sizeof(x));
+
+	uint32_t sign = (x >> 16) & 0x8000;
+	uint32_t exp = (x >> 23) & 0xff;
+	uint32_t mant = x & 0x7fffff;
+
+	// Infinity and NaN, keep NaNs as NaNs.
+	if (exp == 0xff) {
+		return (uint16_t)(sign | 0x7c00 | (mant != 0 ? 0x200 : 0));
+	}
+
+	int32_t e = (int32_t)exp - 127 + 15;
+
+	// Too large, becomes infinity.
+	if (e >= 0x1f) {
+		return (uint16_t)(sign | 0x7c00);
+	}
+
+	// Subnormal, or too small and becomes zero.
+	if (e <= 0) {
+		if (e < -10) {
+			return (uint16_t)sign;
+		}
+
+		mant |= 0x800000;
+		uint32_t shift = (uint32_t)(14 - e);
+		uint32_t half = mant >> shift;
+		uint32_t rem = mant & ((1u << shift) - 1);
+
+		if (m_half_round_up(rem, 1u << (shift - 1), half)) {
+			half++;
+		}
+
+		return (uint16_t)(sign | half);
+	}
+
+	// Rounding up may carry into the exponent, which is the right result.
+	uint32_t half = ((uint32_t)e << 10) | (mant >> 13);
+	if (m_half_round_up(mant & 0x1fff, 0x1000, half)) {
+		half++;
+	}
+
+	return (uint16_t)(sign | half);
+}
+
+/*!
+ * Convert a half float to a float, this is always exact.
+ *
+ * @ingroup aux_math
+ */
+static inline float
+m_half_to_float(uint16_t h)
+{
+	uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+	uint32_t exp = (h >> 10) & 0x1f;
+	uint32_t mant = h & 0x3ff;
+	uint32_t x;
+
+	if (exp == 0x1f) {
+		x = sign | 0x7f800000 | (mant << 13);
+	} else if (exp != 0) {
+		x = sign | ((exp + 112) << 23) | (mant << 13);
+	} else if (mant == 0) {
+		x = sign;
+	} else {
+		// Subnormal, normalize it.
+		uint32_t e = 113;
+		while ((mant & 0x400) == 0) {
+			mant <<= 1;
+			e--;
+		}
+
+		x = sign | (e << 23) | ((mant & 0x3ff) << 13);
+	}
+
+	float f;
+	memcpy(&f, &x, sizeof(f));
+
+	return f;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
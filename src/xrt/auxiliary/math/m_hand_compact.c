@@ -0,0 +1,179 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Compact encoding of hand joint sets, for sending them over IPC.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_math
+ */
+
+#include "util/u_misc.h"
+
+#include "math/m_api.h"
+#include "math/m_mathinclude.h"
+#include "math/m_half.h"
+#include "math/m_hand_compact.h"
+
+
+//! Largest value of the three smallest components of a unit quaternion.
+#define QUAT_COMPONENT_MAX (0.70710678f)
+
+//! Flags that a compact set can't carry.
+#define VELOCITY_BITS (XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT)
+
+
+/*
+ *
+ * Quaternion helpers.
+ *
+ */
+
+static inline uint16_t
+quantize_component(float v)
+{
+	float n = (v / QUAT_COMPONENT_MAX + 1.0f) * 0.5f;
+	n = CLAMP(n, 0.0f, 1.0f);
+
+	return (uint16_t)(n * 65535.0f + 0.5f);
+}
+
+static inline float
+dequantize_component(uint16_t q)
+{
+	return ((float)q / 65535.0f * 2.0f - 1.0f) * QUAT_COMPONENT_MAX;
+}
+
+static uint32_t
+encode_quat(const struct xrt_quat *quat, uint16_t out_comps[3])
+{
+	struct xrt_quat q = *quat;
+	math_quat_normalize(&q);
+
+	float c[4] = {q.x, q.y, q.z, q.w};
+
+	uint32_t largest = 0;
+	for (uint32_t i = 1; i < 4; i++) {
+		if (fabsf(c[i]) > fabsf(c[largest])) {
+			largest = i;
+		}
+	}
+
+	// q and -q are the same rotation, make the dropped one positive.
+	float sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+
+	for (uint32_t i = 0, k = 0; i < 4; i++) {
+		if (i != largest) {
+			out_comps[k++] = quantize_component(c[i] * sign);
+		}
+	}
+
+	return largest;
+}
+
+static void
+decode_quat(const uint16_t comps[3], uint32_t largest, struct xrt_quat *out_quat)
+{
+	float c[4];
+	float sum = 0.0f;
+
+	for (uint32_t i = 0, k = 0; i < 4; i++) {
+		if (i == largest) {
+			continue;
+		}
+
+		c[i] = dequantize_component(comps[k++]);
+		sum += c[i] * c[i];
+	}
+
+	c[largest] = sqrtf(MAX(1.0f - sum, 0.0f));
+
+	out_quat->x = c[0];
+	out_quat->y = c[1];
+	out_quat->z = c[2];
+	out_quat->w = c[3];
+
+	math_quat_normalize(out_quat);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+bool
+m_hand_joint_set_compact_encode(const struct xrt_hand_joint_set *set, struct m_hand_joint_set_compact *out_compact)
+{
+	const struct xrt_hand_joint_value *values = set->values.hand_joint_set_default;
+
+	U_ZERO(out_compact);
+	out_compact->hand_pose = set->hand_pose;
+	out_compact->is_active = set->is_active;
+
+	// Joint values are not looked at when not active.
+	if (!set->is_active) {
+		return true;
+	}
+
+	uint32_t flags = values[0].relation.relation_flags;
+	for (uint32_t i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		uint32_t joint_flags = values[i].relation.relation_flags;
+		if (joint_flags != flags || (joint_flags & VELOCITY_BITS) != 0) {
+			return false;
+		}
+	}
+
+	const struct xrt_pose *wrist = &values[XRT_HAND_JOINT_WRIST].relation.pose;
+
+	out_compact->wrist = *wrist;
+	out_compact->joint_flags = flags;
+
+	for (uint32_t i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		const struct xrt_pose *pose = &values[i].relation.pose;
+		struct m_hand_joint_compact *joint = &out_compact->joints[i];
+
+		joint->position[0] = m_float_to_half(pose->position.x - wrist->position.x);
+		joint->position[1] = m_float_to_half(pose->position.y - wrist->position.y);
+		joint->position[2] = m_float_to_half(pose->position.z - wrist->position.z);
+		joint->radius = m_float_to_half(values[i].radius);
+
+		uint64_t largest = encode_quat(&pose->orientation, joint->orientation);
+		out_compact->largest |= largest << (i * 2);
+	}
+
+	return true;
+}
+
+void
+m_hand_joint_set_compact_decode(const struct m_hand_joint_set_compact *compact, struct xrt_hand_joint_set *out_set)
+{
+	struct xrt_hand_joint_value *values = out_set->values.hand_joint_set_default;
+
+	U_ZERO(out_set);
+	out_set->hand_pose = compact->hand_pose;
+	out_set->is_active = compact->is_active;
+
+	if (!compact->is_active) {
+		return;
+	}
+
+	const struct xrt_pose *wrist = &compact->wrist;
+
+	for (uint32_t i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		const struct m_hand_joint_compact *joint = &compact->joints[i];
+		struct xrt_space_relation *rel = &values[i].relation;
+
+		rel->relation_flags = (enum xrt_space_relation_flags)compact->joint_flags;
+		rel->pose.position.x = wrist->position.x + m_half_to_float(joint->position[0]);
+		rel->pose.position.y = wrist->position.y + m_half_to_float(joint->position[1]);
+		rel->pose.position.z = wrist->position.z + m_half_to_float(joint->position[2]);
+		values[i].radius = m_half_to_float(joint->radius);
+
+		uint32_t largest = (uint32_t)(compact->largest >> (i * 2)) & 0x3;
+		decode_quat(joint->orientation, largest, &rel->pose.orientation);
+	}
+
+	// The wrist is sent in full.
+	values[XRT_HAND_JOINT_WRIST].relation.pose = *wrist;
+}
@@ -0,0 +1,89 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Compact encoding of hand joint sets, for sending them over IPC.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_math
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * A single joint of a @ref m_hand_joint_set_compact, all values are half
+ * floats except for the orientation.
+ *
+ * @ingroup aux_math
+ */
+struct m_hand_joint_compact
+{
+	//! Position relative to the wrist in the same space, in meters.
+	uint16_t position[3];
+
+	/*!
+	 * The three smallest components of the orientation, in order and with
+	 * the largest component dropped, quantized from [-1/sqrt(2), 1/sqrt(2)].
+	 * Which one is dropped is in @ref m_hand_joint_set_compact::largest.
+	 */
+	uint16_t orientation[3];
+
+	//! Radius of the joint, in meters.
+	uint16_t radius;
+};
+
+/*!
+ * A @ref xrt_hand_joint_set in around a third of the size. The wrist pose and
+ * hand pose are kept in full precision, all joints share the same flags and
+ * have no velocities.
+ *
+ * @ingroup aux_math
+ */
+struct m_hand_joint_set_compact
+{
+	//! Full precision pose of the wrist joint, the others are relative to it.
+	struct xrt_pose wrist;
+
+	//! Same as @ref xrt_hand_joint_set::hand_pose.
+	struct xrt_space_relation hand_pose;
+
+	//! Two bits per joint, the index of the dropped orientation component.
+	uint64_t largest;
+
+	//! The @ref xrt_space_relation_flags of all joints.
+	uint32_t joint_flags;
+
+	//! Same as @ref xrt_hand_joint_set::is_active.
+	bool is_active;
+
+	struct m_hand_joint_compact joints[XRT_HAND_JOINT_COUNT];
+};
+
+/*!
+ * Encode @p set, returns false if it can't be represented: the joints have
+ * different flags or valid velocities. The caller then needs to send the full
+ * set instead.
+ *
+ * @ingroup aux_math
+ */
+bool
+m_hand_joint_set_compact_encode(const struct xrt_hand_joint_set *set, struct m_hand_joint_set_compact *out_compact);
+
+/*!
+ * Decode into a full @ref xrt_hand_joint_set, velocities are zeroed.
+ *
+ * @ingroup aux_math
+ */
+void
+m_hand_joint_set_compact_decode(const struct m_hand_joint_set_compact *compact, struct xrt_hand_joint_set *out_set);
+
+
+#ifdef __cplusplus
+}
+#endif
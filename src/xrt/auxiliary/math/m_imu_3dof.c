@@ -15,6 +15,7 @@
 #include "math/m_api.h"
 #include "math/m_filter_fifo.h"
 #include "math/m_imu_3dof.h"
+#include "math/m_predict.h"
 #include "math/m_vec3.h"
 #include "math/m_mathinclude.h"
 
@@ -25,6 +26,9 @@
 #define DUR_300MS_IN_NS (300 * 1000 * 1000)
 #define DUR_20MS_IN_NS (20 * 1000 * 1000)
 
+//! Number of samples pushed to the filter fifos at a time.
+#define M_IMU_3DOF_BATCH_CHUNK (32)
+
 
 void
 m_imu_3dof_init(struct m_imu_3dof *f, int flags)
@@ -100,27 +104,15 @@ m_imu_3dof_add_vars(struct m_imu_3dof *f, void *root, const char *prefix)
 	u_var_add_bool(root, &f->gyro_bias.manually_fire, tmp);
 }
 
+/*!
+ * Tracks if the device has been level, done for each sample so a single
+ * sample of movement in a batch resets the level timepoint.
+ */
 static void
-gravity_correction(struct m_imu_3dof *f,
-                   uint64_t timestamp_ns,
-                   const struct xrt_vec3 *accel,
-                   const struct xrt_vec3 *gyro,
-                   double dt,
-                   float gyro_length)
+gravity_level_check(struct m_imu_3dof *f, uint64_t timestamp_ns, const struct xrt_vec3 *accel, float gyro_length)
 {
-	uint64_t dur_ns = 0;
-	if (f->flags & M_IMU_3DOF_USE_GRAVITY_DUR_20MS) {
-		dur_ns = DUR_20MS_IN_NS;
-	} else if (f->flags & M_IMU_3DOF_USE_GRAVITY_DUR_300MS) {
-		dur_ns = DUR_300MS_IN_NS;
-	} else {
-		return;
-	}
-
 	const float gravity_tolerance = .9f;
 	const float gyro_tolerance = .1f;
-	const float min_tilt_error = 0.05f;
-	const float max_tilt_error = 0.01f;
 
 	/*
 	 * If the device is within tolerance levels, count this
@@ -136,6 +128,23 @@ gravity_correction(struct m_imu_3dof *f,
 	}
 	f->grav.is_accel = is_accel;
 	f->grav.is_rotating = is_rotating;
+}
+
+static void
+gravity_correction(struct m_imu_3dof *f, uint64_t timestamp_ns, double dt, float gyro_length)
+{
+	uint64_t dur_ns = 0;
+	if (f->flags & M_IMU_3DOF_USE_GRAVITY_DUR_20MS) {
+		dur_ns = DUR_20MS_IN_NS;
+	} else if (f->flags & M_IMU_3DOF_USE_GRAVITY_DUR_300MS) {
+		dur_ns = DUR_300MS_IN_NS;
+	} else {
+		return;
+	}
+
+	const float gravity_tolerance = .9f;
+	const float min_tilt_error = 0.05f;
+	const float max_tilt_error = 0.01f;
 
 	/*
 	 * Device has been level for long enough, grab mean from the
@@ -226,71 +235,127 @@ gyro_biasing(struct m_imu_3dof *f, uint64_t timestamp_ns)
 	f->gyro_bias.value = gyro_mean;
 }
 
+/*!
+ * Integrate the gyro sample into the orientation, does not renormalize.
+ */
+static void
+integrate_gyro(struct m_imu_3dof *f, const struct xrt_vec3 *gyro_biased, float gyro_biased_length, double dt)
+{
+	if (gyro_biased_length <= 0.0001f) {
+		return;
+	}
+
+#if 0
+	math_quat_integrate_velocity(&f->rot, gyro_biased, dt, &f->rot);
+#else
+	struct xrt_vec3 rot_axis = {
+	    gyro_biased->x / gyro_biased_length,
+	    gyro_biased->y / gyro_biased_length,
+	    gyro_biased->z / gyro_biased_length,
+	};
+
+	float rot_angle = gyro_biased_length * (float)dt;
+
+	struct xrt_quat delta_orient;
+	math_quat_from_angle_vector(rot_angle, &rot_axis, &delta_orient);
+
+	math_quat_rotate(&f->rot, &delta_orient, &f->rot);
+#endif
+}
+
 void
 m_imu_3dof_update(struct m_imu_3dof *f,
                   uint64_t timestamp_ns,
                   const struct xrt_vec3 *accel,
                   const struct xrt_vec3 *gyro)
 {
-	//! Skip the first sample.
-	if (f->state == M_IMU_3DOF_STATE_START) {
-		f->state = M_IMU_3DOF_STATE_RUNNING;
-		f->last.timestamp_ns = timestamp_ns;
-		return;
-	}
+	m_imu_3dof_update_batch(f, &timestamp_ns, accel, gyro, 1);
+}
 
-	// This code assumes all timestamps makes some forward progress.
-	assert(timestamp_ns >= f->last.timestamp_ns);
+void
+m_imu_3dof_update_batch(struct m_imu_3dof *f,
+                        const uint64_t *timestamps_ns,
+                        const struct xrt_vec3 *accels,
+                        const struct xrt_vec3 *gyros,
+                        uint32_t count)
+{
+	struct xrt_vec3 world_accels[M_IMU_3DOF_BATCH_CHUNK];
+	uint64_t chunk_timestamps_ns[M_IMU_3DOF_BATCH_CHUNK];
+	struct xrt_vec3 chunk_gyros[M_IMU_3DOF_BATCH_CHUNK];
+	uint32_t chunk_count = 0;
+
+	uint64_t first_timestamp_ns = f->last.timestamp_ns;
+	struct xrt_vec3 gyro_biased = XRT_VEC3_ZERO;
+	float gyro_biased_length = 0.0f;
+	bool updated = false;
+
+	for (uint32_t i = 0; i < count; i++) {
+		uint64_t timestamp_ns = timestamps_ns[i];
+		const struct xrt_vec3 *accel = &accels[i];
+		const struct xrt_vec3 *gyro = &gyros[i];
+
+		//! Skip the first sample.
+		if (f->state == M_IMU_3DOF_STATE_START) {
+			f->state = M_IMU_3DOF_STATE_RUNNING;
+			f->last.timestamp_ns = timestamp_ns;
+			first_timestamp_ns = timestamp_ns;
+			continue;
+		}
 
-	f->last.gyro = *gyro;
-	f->last.accel = *accel;
+		// This code assumes all timestamps makes some forward progress.
+		assert(timestamp_ns >= f->last.timestamp_ns);
 
-	struct xrt_vec3 world_accel = {0};
-	math_quat_rotate_vec3(&f->rot, accel, &world_accel);
+		uint64_t diff = timestamp_ns - f->last.timestamp_ns;
+		double dt = (double)diff / DUR_1S_IN_NS;
 
-	uint64_t diff = timestamp_ns - f->last.timestamp_ns;
-	double dt = (double)diff / DUR_1S_IN_NS;
+		f->last.delta_ms = dt * 1000.0f;
+		f->last.timestamp_ns = timestamp_ns;
 
-	f->last.delta_ms = dt * 1000.0f;
-	f->last.timestamp_ns = timestamp_ns;
+		// Rotated with the orientation before this sample is integrated.
+		math_quat_rotate_vec3(&f->rot, accel, &world_accels[chunk_count]);
+		chunk_timestamps_ns[chunk_count] = timestamp_ns;
+		chunk_gyros[chunk_count] = *gyro;
 
-	m_ff_vec3_f32_push(f->word_accel_ff, &world_accel, timestamp_ns);
-	m_ff_vec3_f32_push(f->gyro_ff, gyro, timestamp_ns);
+		if (++chunk_count == M_IMU_3DOF_BATCH_CHUNK) {
+			m_ff_vec3_f32_push_many(f->word_accel_ff, world_accels, chunk_timestamps_ns, chunk_count);
+			m_ff_vec3_f32_push_many(f->gyro_ff, chunk_gyros, chunk_timestamps_ns, chunk_count);
+			chunk_count = 0;
+		}
 
-	struct xrt_vec3 gyro_biased = m_vec3_sub(*gyro, f->gyro_bias.value);
-	float gyro_biased_length = m_vec3_len(gyro_biased);
-	float gyro_length = m_vec3_len(*gyro);
-	float accel_length = m_vec3_len(*accel);
+		gyro_biased = m_vec3_sub(*gyro, f->gyro_bias.value);
+		gyro_biased_length = m_vec3_len(gyro_biased);
 
-	f->last.accel_length = accel_length;
-	f->last.gyro_length = gyro_length;
-	f->last.gyro_biased_length = gyro_biased_length;
+		integrate_gyro(f, &gyro_biased, gyro_biased_length, dt);
+		gravity_level_check(f, timestamp_ns, accel, gyro_biased_length);
 
+		updated = true;
+	}
 
-	if (gyro_biased_length > 0.0001f) {
-#if 0
-		math_quat_integrate_velocity(&f->rot, gyro, dt, &f->rot);
-#else
-		struct xrt_vec3 rot_axis = {
-		    gyro_biased.x / gyro_biased_length,
-		    gyro_biased.y / gyro_biased_length,
-		    gyro_biased.z / gyro_biased_length,
-		};
+	if (!updated) {
+		return;
+	}
 
-		float rot_angle = gyro_biased_length * (float)dt;
+	m_ff_vec3_f32_push_many(f->word_accel_ff, world_accels, chunk_timestamps_ns, chunk_count);
+	m_ff_vec3_f32_push_many(f->gyro_ff, chunk_gyros, chunk_timestamps_ns, chunk_count);
 
-		struct xrt_quat delta_orient;
-		math_quat_from_angle_vector(rot_angle, &rot_axis, &delta_orient);
+	const struct xrt_vec3 *last_accel = &accels[count - 1];
+	const struct xrt_vec3 *last_gyro = &gyros[count - 1];
 
-		math_quat_rotate(&f->rot, &delta_orient, &f->rot);
-#endif
-	}
+	f->last.gyro = *last_gyro;
+	f->last.accel = *last_accel;
+	f->last.accel_length = m_vec3_len(*last_accel);
+	f->last.gyro_length = m_vec3_len(*last_gyro);
+	f->last.gyro_biased_length = gyro_biased_length;
 
-	// Gravity correction.
-	gravity_correction(f, timestamp_ns, accel, &gyro_biased, dt, gyro_biased_length);
+	/*
+	 * Gravity correction, done once for the whole batch. The correction
+	 * scales with time so use the time covered by all of the samples.
+	 */
+	double batch_dt = (double)(f->last.timestamp_ns - first_timestamp_ns) / DUR_1S_IN_NS;
+	gravity_correction(f, f->last.timestamp_ns, batch_dt, gyro_biased_length);
 
 	// Gyro bias calculations.
-	gyro_biasing(f, timestamp_ns);
+	gyro_biasing(f, f->last.timestamp_ns);
 
 	/*
 	 * Mitigate drift due to floating point
@@ -298,3 +363,35 @@ m_imu_3dof_update(struct m_imu_3dof *f,
 	 */
 	math_quat_normalize(&f->rot);
 }
+
+void
+m_imu_3dof_predict(const struct m_imu_3dof *f, int64_t delta_ns, struct xrt_space_relation *out_relation)
+{
+	struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+	rel.relation_flags = (enum xrt_space_relation_flags)(XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
+	                                                     XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT |
+	                                                     XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+	rel.pose.orientation = f->rot;
+
+	// The gyro is in the body frame, but relations carry world angular velocity.
+	struct xrt_vec3 gyro_biased = m_vec3_sub(f->last.gyro, f->gyro_bias.value);
+	math_quat_rotate_vec3(&f->rot, &gyro_biased, &rel.angular_velocity);
+
+	if (delta_ns > M_IMU_3DOF_MAX_PREDICTION_NS) {
+		delta_ns = M_IMU_3DOF_MAX_PREDICTION_NS;
+	}
+
+	if (delta_ns <= 0 || f->state != M_IMU_3DOF_STATE_RUNNING) {
+		out_relation->pose.orientation = rel.pose.orientation;
+		out_relation->angular_velocity = rel.angular_velocity;
+		out_relation->relation_flags = rel.relation_flags;
+		return;
+	}
+
+	struct xrt_space_relation predicted;
+	m_predict_relation(&rel, (double)delta_ns / DUR_1S_IN_NS, &predicted);
+
+	out_relation->pose.orientation = predicted.pose.orientation;
+	out_relation->angular_velocity = predicted.angular_velocity;
+	out_relation->relation_flags = rel.relation_flags;
+}
@@ -22,6 +22,9 @@ extern "C" {
 #define M_IMU_3DOF_USE_GRAVITY_DUR_300MS (1 << 0)
 #define M_IMU_3DOF_USE_GRAVITY_DUR_20MS (1 << 1)
 
+//! Longest prediction @ref m_imu_3dof_predict will do, past this the gyro says little.
+#define M_IMU_3DOF_MAX_PREDICTION_NS (100 * 1000 * 1000)
+
 
 struct m_ff_vec3_f32;
 
@@ -90,6 +93,32 @@ m_imu_3dof_update(struct m_imu_3dof *f,
                   const struct xrt_vec3 *accel,
                   const struct xrt_vec3 *gyro);
 
+/*!
+ * Integrates @p count samples in one go, the orientation is renormalized and
+ * gravity correction is done once for the whole batch rather than for every
+ * sample. Meant for devices that deliver several samples in each packet.
+ */
+void
+m_imu_3dof_update_batch(struct m_imu_3dof *f,
+                        const uint64_t *timestamps_ns,
+                        const struct xrt_vec3 *accels,
+                        const struct xrt_vec3 *gyros,
+                        uint32_t count);
+
+/*!
+ * Predicts the orientation @p delta_ns past the newest integrated sample from
+ * its bias corrected gyro reading. The angular velocity of the returned
+ * relation is in the world frame, so it can be handed on to
+ * @ref m_predict_relation or a relation history. Negative deltas give the
+ * current orientation and long ones are clamped to
+ * @ref M_IMU_3DOF_MAX_PREDICTION_NS.
+ *
+ * Only the orientation, angular velocity and flags are written, the position
+ * is left to the caller.
+ */
+void
+m_imu_3dof_predict(const struct m_imu_3dof *f, int64_t delta_ns, struct xrt_space_relation *out_relation);
+
 
 #ifdef __cplusplus
 }
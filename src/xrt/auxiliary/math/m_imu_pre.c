@@ -57,6 +57,59 @@ m_imu_pre_filter_set_switch_x_and_y(struct m_imu_pre_filter *imu)
 	imu->transform.v[8] = 1;
 }
 
+/*!
+ * The filter for one part folded into `v = matrix * ticks + offset`, stored
+ * row major.
+ */
+struct part_affine
+{
+	float m[9];
+	float offset[3];
+};
+
+static void
+part_to_affine(const struct m_imu_pre_filter_part *part,
+               const struct xrt_matrix_3x3 *transform,
+               struct part_affine *out)
+{
+	const float scale[3] = {
+	    part->ticks_to_float * part->gain.x,
+	    part->ticks_to_float * part->gain.y,
+	    part->ticks_to_float * part->gain.z,
+	};
+	const float bias[3] = {
+	    part->bias.x * part->gain.x,
+	    part->bias.y * part->gain.y,
+	    part->bias.z * part->gain.z,
+	};
+
+	for (int row = 0; row < 3; row++) {
+		const float *t = &transform->v[row * 3];
+
+		out->m[row * 3 + 0] = t[0] * scale[0];
+		out->m[row * 3 + 1] = t[1] * scale[1];
+		out->m[row * 3 + 2] = t[2] * scale[2];
+		out->offset[row] = -(t[0] * bias[0] + t[1] * bias[1] + t[2] * bias[2]);
+	}
+}
+
+static void
+part_apply_array(const struct part_affine *affine, const struct xrt_vec3_i32 *in, uint32_t count, struct xrt_vec3 *out)
+{
+	const float *m = affine->m;
+	const float *o = affine->offset;
+
+	for (uint32_t i = 0; i < count; i++) {
+		float x = (float)in[i].x;
+		float y = (float)in[i].y;
+		float z = (float)in[i].z;
+
+		out[i].x = m[0] * x + m[1] * y + m[2] * z + o[0];
+		out[i].y = m[3] * x + m[4] * y + m[5] * z + o[1];
+		out[i].z = m[6] * x + m[7] * y + m[8] * z + o[2];
+	}
+}
+
 void
 m_imu_pre_filter_data(struct m_imu_pre_filter *imu,
                       const struct xrt_vec3_i32 *accel,
@@ -64,35 +117,23 @@ m_imu_pre_filter_data(struct m_imu_pre_filter *imu,
                       struct xrt_vec3 *out_accel,
                       struct xrt_vec3 *out_gyro)
 {
-	struct m_imu_pre_filter_part fa;
-	struct m_imu_pre_filter_part fg;
-	struct xrt_vec3 a;
-	struct xrt_vec3 g;
-	struct xrt_matrix_3x3 m;
-
-	fa = imu->accel;
-	fg = imu->gyro;
-	m = imu->transform;
-
-	a.x = accel->x * fa.ticks_to_float;
-	a.y = accel->y * fa.ticks_to_float;
-	a.z = accel->z * fa.ticks_to_float;
-
-	g.x = gyro->x * fg.ticks_to_float;
-	g.y = gyro->y * fg.ticks_to_float;
-	g.z = gyro->z * fg.ticks_to_float;
-
-	a.x = (a.x - fa.bias.x) * fa.gain.x;
-	a.y = (a.y - fa.bias.y) * fa.gain.y;
-	a.z = (a.z - fa.bias.z) * fa.gain.z;
+	m_imu_pre_filter_data_array(imu, accel, gyro, 1, out_accel, out_gyro);
+}
 
-	g.x = (g.x - fg.bias.x) * fg.gain.x;
-	g.y = (g.y - fg.bias.y) * fg.gain.y;
-	g.z = (g.z - fg.bias.z) * fg.gain.z;
+void
+m_imu_pre_filter_data_array(struct m_imu_pre_filter *imu,
+                            const struct xrt_vec3_i32 *accels,
+                            const struct xrt_vec3_i32 *gyros,
+                            uint32_t count,
+                            struct xrt_vec3 *out_accels,
+                            struct xrt_vec3 *out_gyros)
+{
+	struct part_affine fa;
+	struct part_affine fg;
 
-	math_matrix_3x3_transform_vec3(&m, &a, &a);
-	math_matrix_3x3_transform_vec3(&m, &g, &g);
+	part_to_affine(&imu->accel, &imu->transform, &fa);
+	part_to_affine(&imu->gyro, &imu->transform, &fg);
 
-	*out_accel = a;
-	*out_gyro = g;
+	part_apply_array(&fa, accels, count, out_accels);
+	part_apply_array(&fg, gyros, count, out_gyros);
 }
@@ -82,6 +82,21 @@ m_imu_pre_filter_data(struct m_imu_pre_filter *imu,
                       struct xrt_vec3 *out_accel,
                       struct xrt_vec3 *out_gyro);
 
+/*!
+ * Pre-filters @p count samples in one go, same as calling
+ * @ref m_imu_pre_filter_data on each sample. Meant for devices that send
+ * several samples in each packet, the filter is folded into a single affine
+ * transform once per call and the loop is kept simple enough for the compiler
+ * to vectorise.
+ */
+void
+m_imu_pre_filter_data_array(struct m_imu_pre_filter *imu,
+                            const struct xrt_vec3_i32 *accels,
+                            const struct xrt_vec3_i32 *gyros,
+                            uint32_t count,
+                            struct xrt_vec3 *out_accels,
+                            struct xrt_vec3 *out_gyros);
+
 
 #ifdef __cplusplus
 }
@@ -12,6 +12,8 @@
 #include "m_predict.h"
 #include "util/u_trace_marker.h"
 
+#include <math.h>
+
 
 static void
 do_orientation(const struct xrt_space_relation *rel,
@@ -113,3 +115,47 @@ m_predict_relation(const struct xrt_space_relation *rel, double delta_s, struct
 
 	out_rel->relation_flags = flags;
 }
+
+void
+m_predict_relation_with_angular_acceleration(const struct xrt_space_relation *rel,
+                                             const struct xrt_vec3 *angular_acceleration,
+                                             float damping,
+                                             double delta_s,
+                                             struct xrt_space_relation *out_rel)
+{
+	bool valid_angular_velocity = (rel->relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT) != 0;
+	if (delta_s <= 0 || !valid_angular_velocity) {
+		m_predict_relation(rel, delta_s, out_rel);
+		return;
+	}
+
+	/*
+	 * With the acceleration decaying as a * e^(-k * t) the velocity at the
+	 * end is w + a * (1 - e^(-k * t)) / k, and the average velocity over the
+	 * prediction is w + a * (k * t - 1 + e^(-k * t)) / (k^2 * t). Fall back
+	 * to the undamped formulas when k * t is small to avoid cancellation.
+	 */
+	double k = damping > 0.0f ? (double)damping : 0.0;
+	double kt = k * delta_s;
+	double avg_scale = 0;
+	double end_scale = 0;
+	if (kt < 1e-4) {
+		avg_scale = delta_s / 2;
+		end_scale = delta_s;
+	} else {
+		double decay = exp(-kt);
+		avg_scale = (kt - 1 + decay) / (k * k * delta_s);
+		end_scale = (1 - decay) / k;
+	}
+
+	// Predict using the average angular velocity over the prediction.
+	struct xrt_space_relation tmp = *rel;
+	struct xrt_vec3 avg_accel = m_vec3_mul_scalar(*angular_acceleration, (float)avg_scale);
+	tmp.angular_velocity = m_vec3_add(rel->angular_velocity, avg_accel);
+
+	m_predict_relation(&tmp, delta_s, out_rel);
+
+	// The velocity at the end of the prediction is different from the average.
+	out_rel->angular_velocity = m_vec3_add(
+	    out_rel->angular_velocity, m_vec3_mul_scalar(*angular_acceleration, (float)(end_scale - avg_scale)));
+}
@@ -29,6 +29,24 @@ extern "C" {
 void
 m_predict_relation(const struct xrt_space_relation *rel, double delta_s, struct xrt_space_relation *out_rel);
 
+/*!
+ * Same as @ref m_predict_relation but also integrates @p angular_acceleration,
+ * which decays exponentially at the rate @p damping (per second) so that long
+ * predictions do not run away. A @p damping of zero means constant angular
+ * acceleration. Backwards predictions ignore the angular acceleration.
+ *
+ * Assumes that both the angular velocity and acceleration are relative to the
+ * space the relation is in, not relative to relation::pose.
+ *
+ * @ingroup aux_math
+ */
+void
+m_predict_relation_with_angular_acceleration(const struct xrt_space_relation *rel,
+                                             const struct xrt_vec3 *angular_acceleration,
+                                             float damping,
+                                             double delta_s,
+                                             struct xrt_space_relation *out_rel);
+
 
 #ifdef __cplusplus
 }
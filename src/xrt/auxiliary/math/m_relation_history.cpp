@@ -16,14 +16,17 @@
 #include "math/m_predict.h"
 #include "math/m_vec3.h"
 #include "os/os_time.h"
+#include "util/u_debug.h"
 #include "util/u_logging.h"
+#include "util/u_time.h"
 #include "util/u_trace_marker.h"
+#include "util/u_var.h"
 #include "xrt/xrt_defines.h"
 #include "os/os_threading.h"
-#include "util/u_template_historybuf.hpp"
 
 #include <memory>
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <stdio.h>
 #include <stdlib.h>
@@ -31,9 +34,12 @@
 #include <assert.h>
 #include <mutex>
 
-using namespace xrt::auxiliary::util;
 namespace os = xrt::auxiliary::os;
 
+DEBUG_GET_ONCE_BOOL_OPTION(predict_angular_acceleration, "M_RELATION_HISTORY_PREDICT_ANGULAR_ACCELERATION", false)
+DEBUG_GET_ONCE_FLOAT_OPTION(predict_damping, "M_RELATION_HISTORY_PREDICT_DAMPING", 10.0f)
+DEBUG_GET_ONCE_FLOAT_OPTION(predict_window_ms, "M_RELATION_HISTORY_PREDICT_WINDOW_MS", 20.0f)
+
 struct relation_history_entry
 {
 	struct xrt_space_relation relation;
@@ -42,17 +48,328 @@ struct relation_history_entry
 
 static constexpr size_t BufLen = 4096;
 
+/*!
+ * The history is a ring of entries protected by a sequence lock, readers never
+ * take any lock so they never block the writer, which is usually a driver
+ * thread pushing samples at a high rate. Readers instead retry if a write
+ * happened while they were reading.
+ */
 struct m_relation_history
 {
-	HistoryBuffer<struct relation_history_entry, BufLen> impl;
-	mutable os::Mutex mutex;
+	//! Ring of entries, indexed by the logical index modulo @ref BufLen.
+	struct relation_history_entry entries[BufLen];
+
+	//! Logical index of the oldest entry.
+	std::atomic<uint64_t> first{0};
+
+	//! Logical index one past the newest entry.
+	std::atomic<uint64_t> end{0};
+
+	//! Odd while the history is being written to.
+	std::atomic<uint32_t> seq{0};
+
+	//! Only serializes writers against each other, never taken by readers.
+	os::Mutex write_mutex;
+
+	//! Read without any locking, also poked at directly from the debug UI.
+	struct m_relation_history_prediction prediction;
+};
+
+/*!
+ * The entries needed to produce a relation, copied out of the history so the
+ * math can be done after making sure they weren't written to while copied.
+ */
+struct relation_history_lookup
+{
+	enum m_relation_history_result result;
+
+	//! Entry to predict from or to use as is, or predecessor when interpolating.
+	struct relation_history_entry a;
+
+	//! Successor when interpolating, older entry when predicting with angular acceleration.
+	struct relation_history_entry b;
+
+	//! Set when predicting and @p b holds an older entry.
+	bool has_older;
 };
 
 
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline const relation_history_entry &
+entry_at(const struct m_relation_history *rh, uint64_t index)
+{
+	return rh->entries[index % BufLen];
+}
+
+//! Must be called with the write mutex held.
+static inline void
+write_begin(struct m_relation_history *rh)
+{
+	uint32_t seq = rh->seq.load(std::memory_order_relaxed);
+	rh->seq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+//! Must be called with the write mutex held.
+static inline void
+write_end(struct m_relation_history *rh)
+{
+	uint32_t seq = rh->seq.load(std::memory_order_relaxed);
+	rh->seq.store(seq + 1, std::memory_order_release);
+}
+
+/*!
+ * Calls @p read until it has run without a write happening at the same time,
+ * anything @p read copies out is only valid once this returns.
+ */
+template <typename Func>
+static inline void
+read_consistent(const struct m_relation_history *rh, Func read)
+{
+	while (true) {
+		uint32_t seq = rh->seq.load(std::memory_order_acquire);
+		if ((seq & 1) != 0) {
+			continue; // Writer is in the middle of a push, very short.
+		}
+
+		read();
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (rh->seq.load(std::memory_order_relaxed) == seq) {
+			return;
+		}
+	}
+}
+
+/*!
+ * Copies the newest entry that is at least @p window_ns older than the newest
+ * entry into @p out_lookup::b, or the oldest entry if none are that old.
+ *
+ * Must be called from @ref read_consistent.
+ */
+static void
+lookup_read_older(const struct m_relation_history *rh,
+                  uint64_t first,
+                  uint64_t end,
+                  uint64_t window_ns,
+                  struct relation_history_lookup *out_lookup)
+{
+	uint64_t latest_ns = entry_at(rh, end - 1).timestamp;
+	if (end - first < 2 || latest_ns <= window_ns) {
+		return;
+	}
+
+	// Find the first element *greater than* the timestamp, the one before it is the one we want.
+	uint64_t timestamp_ns = latest_ns - window_ns;
+	uint64_t low = first;
+	uint64_t high = end - 1;
+	while (low < high) {
+		uint64_t mid = low + (high - low) / 2;
+		if (entry_at(rh, mid).timestamp <= timestamp_ns) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	out_lookup->b = entry_at(rh, low > first ? low - 1 : first);
+	out_lookup->has_older = true;
+}
+
+/*!
+ * Finds the entries for the timestamp in the range from @p first to @p end,
+ * the search starts at @p search_from which must be known to not be past the
+ * entry, returns the index of the first entry not older than the timestamp.
+ *
+ * Must be called from @ref read_consistent. Only touches the entries within
+ * the ring so a concurrent write can't make it read out of bounds, the result
+ * is thrown away in that case anyways.
+ */
+static uint64_t
+lookup_read(const struct m_relation_history *rh,
+            uint64_t first,
+            uint64_t end,
+            uint64_t search_from,
+            uint64_t at_timestamp_ns,
+            uint64_t older_window_ns,
+            struct relation_history_lookup *out_lookup)
+{
+	out_lookup->has_older = false;
+
+	if (first >= end || at_timestamp_ns == 0) {
+		out_lookup->result = M_RELATION_HISTORY_RESULT_INVALID;
+		return search_from;
+	}
+
+	// Find the first element *not less than* our value.
+	uint64_t low = search_from;
+	uint64_t high = end;
+	while (low < high) {
+		uint64_t mid = low + (high - low) / 2;
+		if (entry_at(rh, mid).timestamp < at_timestamp_ns) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	if (low == end) {
+		// The desired timestamp is after what our buffer contains.
+		out_lookup->result = M_RELATION_HISTORY_RESULT_PREDICTED;
+		out_lookup->a = entry_at(rh, end - 1);
+
+		if (older_window_ns > 0) {
+			lookup_read_older(rh, first, end, older_window_ns, out_lookup);
+		}
+	} else if (at_timestamp_ns == entry_at(rh, low).timestamp) {
+		out_lookup->result = M_RELATION_HISTORY_RESULT_EXACT;
+		out_lookup->a = entry_at(rh, low);
+	} else if (low == first) {
+		// The desired timestamp is before what our buffer contains.
+		out_lookup->result = M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED;
+		out_lookup->a = entry_at(rh, first);
+	} else {
+		// We precede low and follow low - 1, which exists as low isn't first.
+		out_lookup->result = M_RELATION_HISTORY_RESULT_INTERPOLATED;
+		out_lookup->a = entry_at(rh, low - 1);
+		out_lookup->b = entry_at(rh, low);
+	}
+
+	return low;
+}
+
+/*!
+ * Estimates the angular acceleration from the angular velocity of the two
+ * entries, returns false if it can't be done.
+ */
+static bool
+estimate_angular_acceleration(const struct relation_history_entry &newer,
+                              const struct relation_history_entry &older,
+                              struct xrt_vec3 *out_angular_acceleration)
+{
+	enum xrt_space_relation_flags flags =
+	    (enum xrt_space_relation_flags)(newer.relation.relation_flags & older.relation.relation_flags);
+	if ((flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT) == 0 || newer.timestamp <= older.timestamp) {
+		return false;
+	}
+
+	double dt = time_ns_to_s((int64_t)(newer.timestamp - older.timestamp));
+	*out_angular_acceleration = (newer.relation.angular_velocity - older.relation.angular_velocity) / (float)dt;
+
+	return true;
+}
+
+static void
+lookup_to_relation(const struct relation_history_lookup *lookup,
+                   const struct m_relation_history_prediction *prediction,
+                   uint64_t at_timestamp_ns,
+                   struct xrt_space_relation *out_relation)
+{
+	switch (lookup->result) {
+	case M_RELATION_HISTORY_RESULT_INVALID: *out_relation = {}; return;
+	case M_RELATION_HISTORY_RESULT_EXACT:
+		// Flags copied directly along with everything else.
+		U_LOG_T("Exact match in the buffer!");
+		*out_relation = lookup->a.relation;
+		return;
+	case M_RELATION_HISTORY_RESULT_PREDICTED:
+	case M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED: {
+		// Output flags match the buffer entry we predict from.
+		int64_t diff_prediction_ns = static_cast<int64_t>(at_timestamp_ns) - lookup->a.timestamp;
+		double delta_s = time_ns_to_s(diff_prediction_ns);
+
+		U_LOG_T("Extrapolating %f s from the %s of the buffer!", delta_s,
+		        lookup->result == M_RELATION_HISTORY_RESULT_PREDICTED ? "back" : "front");
+
+		struct xrt_vec3 angular_acceleration;
+		if (lookup->has_older && estimate_angular_acceleration(lookup->a, lookup->b, &angular_acceleration)) {
+			m_predict_relation_with_angular_acceleration( //
+			    &lookup->a.relation,                      //
+			    &angular_acceleration,                    //
+			    prediction->damping,                      //
+			    delta_s,                                  //
+			    out_relation);                            //
+		} else {
+			m_predict_relation(&lookup->a.relation, delta_s, out_relation);
+		}
+		return;
+	}
+	case M_RELATION_HISTORY_RESULT_INTERPOLATED: break;
+	}
+
+	U_LOG_T("Interpolating within buffer!");
+
+	const auto &predecessor = lookup->a;
+	const auto &successor = lookup->b;
+
+	// Do the thing.
+	int64_t diff_before = static_cast<int64_t>(at_timestamp_ns) - predecessor.timestamp;
+	int64_t diff_after = static_cast<int64_t>(successor.timestamp) - at_timestamp_ns;
+
+	float amount_to_lerp = (float)diff_before / (float)(diff_before + diff_after);
+
+	// Copy intersection of relation flags
+	xrt_space_relation result{};
+	result.relation_flags =
+	    (enum xrt_space_relation_flags)(predecessor.relation.relation_flags & successor.relation.relation_flags);
+	// First-order implementation - lerp between the before and after
+	if (0 != (result.relation_flags & XRT_SPACE_RELATION_POSITION_VALID_BIT)) {
+		result.pose.position =
+		    m_vec3_lerp(predecessor.relation.pose.position, successor.relation.pose.position, amount_to_lerp);
+	}
+	if (0 != (result.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT)) {
+
+		math_quat_slerp(&predecessor.relation.pose.orientation, &successor.relation.pose.orientation,
+		                amount_to_lerp, &result.pose.orientation);
+	}
+
+	//! @todo Does interpolating the velocities make any sense?
+	if (0 != (result.relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT)) {
+		result.angular_velocity = m_vec3_lerp(predecessor.relation.angular_velocity,
+		                                      successor.relation.angular_velocity, amount_to_lerp);
+	}
+	if (0 != (result.relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT)) {
+		result.linear_velocity = m_vec3_lerp(predecessor.relation.linear_velocity,
+		                                     successor.relation.linear_velocity, amount_to_lerp);
+	}
+	*out_relation = result;
+}
+
+/*!
+ * How far back to look for the entry to estimate the angular acceleration
+ * from, zero if the prediction does not use it.
+ */
+static uint64_t
+get_older_window_ns(const struct m_relation_history_prediction *prediction)
+{
+	if (!prediction->angular_acceleration || prediction->window_ms <= 0.0f) {
+		return 0;
+	}
+
+	return (uint64_t)(prediction->window_ms * (float)U_TIME_1MS_IN_NS);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
 void
 m_relation_history_create(struct m_relation_history **rh_ptr)
 {
 	auto ret = std::make_unique<m_relation_history>();
+
+	ret->prediction.angular_acceleration = debug_get_bool_option_predict_angular_acceleration();
+	ret->prediction.damping = debug_get_float_option_predict_damping();
+	ret->prediction.window_ms = debug_get_float_option_predict_window_ms();
+
 	*rh_ptr = ret.release();
 }
 
@@ -60,24 +377,78 @@ bool
 m_relation_history_push(struct m_relation_history *rh, struct xrt_space_relation const *in_relation, uint64_t timestamp)
 {
 	XRT_TRACE_MARKER();
-	struct relation_history_entry rhe;
+
+	std::unique_lock<os::Mutex> lock(rh->write_mutex);
+
+	// Only written to with the write mutex held, so no need for the sequence lock.
+	uint64_t first = rh->first.load(std::memory_order_relaxed);
+	uint64_t end = rh->end.load(std::memory_order_relaxed);
+
+	// Everything explodes if the timestamps in relation_history aren't monotonically increasing. If we get a
+	// timestamp that's before the most recent timestamp in the buffer, don't put it in the history.
+	if (first < end && timestamp <= entry_at(rh, end - 1).timestamp) {
+		return false;
+	}
+
+	write_begin(rh);
+
+	// Drop the oldest entry if full, its slot is the one being written.
+	if (end - first >= BufLen) {
+		rh->first.store(first + 1, std::memory_order_relaxed);
+	}
+
+	struct relation_history_entry &rhe = rh->entries[end % BufLen];
 	rhe.relation = *in_relation;
 	rhe.timestamp = timestamp;
-	bool ret = false;
-	std::unique_lock<os::Mutex> lock(rh->mutex);
-	try {
-		// if we aren't empty, we can compare against the latest timestamp.
-		if (rh->impl.empty() || rhe.timestamp > rh->impl.back().timestamp) {
-			// Everything explodes if the timestamps in relation_history aren't monotonically increasing. If
-			// we get a timestamp that's before the most recent timestamp in the buffer, don't put it
-			// in the history.
-			rh->impl.push_back(rhe);
-			ret = true;
+
+	rh->end.store(end + 1, std::memory_order_relaxed);
+
+	write_end(rh);
+
+	return true;
+}
+
+uint32_t
+m_relation_history_push_many(struct m_relation_history *rh,
+                             struct xrt_space_relation const *in_relations,
+                             const uint64_t *timestamps,
+                             uint32_t count)
+{
+	XRT_TRACE_MARKER();
+
+	std::unique_lock<os::Mutex> lock(rh->write_mutex);
+
+	// Only written to with the write mutex held, so no need for the sequence lock.
+	uint64_t first = rh->first.load(std::memory_order_relaxed);
+	uint64_t end = rh->end.load(std::memory_order_relaxed);
+	uint32_t pushed = 0;
+
+	write_begin(rh);
+
+	for (uint32_t i = 0; i < count; i++) {
+		// Same as push, keep the timestamps monotonically increasing.
+		if (first < end && timestamps[i] <= entry_at(rh, end - 1).timestamp) {
+			continue;
 		}
-	} catch (std::exception const &e) {
-		U_LOG_E("Caught exception: %s", e.what());
+
+		if (end - first >= BufLen) {
+			first++;
+		}
+
+		struct relation_history_entry &rhe = rh->entries[end % BufLen];
+		rhe.relation = in_relations[i];
+		rhe.timestamp = timestamps[i];
+
+		end++;
+		pushed++;
 	}
-	return ret;
+
+	rh->first.store(first, std::memory_order_relaxed);
+	rh->end.store(end, std::memory_order_relaxed);
+
+	write_end(rh);
+
+	return pushed;
 }
 
 enum m_relation_history_result
@@ -86,97 +457,66 @@ m_relation_history_get(const struct m_relation_history *rh,
                        struct xrt_space_relation *out_relation)
 {
 	XRT_TRACE_MARKER();
-	std::unique_lock<os::Mutex> lock(rh->mutex);
-	try {
-		if (rh->impl.empty() || at_timestamp_ns == 0) {
-			// Do nothing. You push nothing to the buffer you get nothing from the buffer.
-			*out_relation = {};
-			return M_RELATION_HISTORY_RESULT_INVALID;
-		}
-		const auto b = rh->impl.begin();
-		const auto e = rh->impl.end();
-
-		// Find the first element *not less than* our value. the lambda we pass is the comparison
-		// function, to compare against timestamps.
-		const auto it =
-		    std::lower_bound(b, e, at_timestamp_ns, [](const relation_history_entry &rhe, uint64_t timestamp) {
-			    return rhe.timestamp < timestamp;
-		    });
-
-		if (it == e) {
-			// lower bound is at the end:
-			// The desired timestamp is after what our buffer contains.
-			// (pose-prediction)
-			// Output flags match the most recent buffer entry.
-			int64_t diff_prediction_ns = static_cast<int64_t>(at_timestamp_ns) - rh->impl.back().timestamp;
-			double delta_s = time_ns_to_s(diff_prediction_ns);
-
-			U_LOG_T("Extrapolating %f s past the back of the buffer!", delta_s);
-
-			m_predict_relation(&rh->impl.back().relation, delta_s, out_relation);
-			return M_RELATION_HISTORY_RESULT_PREDICTED;
-		}
-		if (at_timestamp_ns == it->timestamp) {
-			// exact match:
-			// Flags copied directly along with everything else.
-			U_LOG_T("Exact match in the buffer!");
-			*out_relation = it->relation;
-			return M_RELATION_HISTORY_RESULT_EXACT;
-		}
-		if (it == b) {
-			// lower bound is at the beginning (and it's not an exact match):
-			// The desired timestamp is before what our buffer contains.
-			// (an edge case where somebody asks for a really old pose and we do our best)
-			// Output flags are the same as the input flags for the history entry we use
-			int64_t diff_prediction_ns = static_cast<int64_t>(at_timestamp_ns) - rh->impl.front().timestamp;
-			double delta_s = time_ns_to_s(diff_prediction_ns);
-			U_LOG_T("Extrapolating %f s before the front of the buffer!", delta_s);
-			m_predict_relation(&rh->impl.front().relation, delta_s, out_relation);
-			return M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED;
-		}
-		U_LOG_T("Interpolating within buffer!");
-
-		// We precede *it and follow *(it - 1) (which we know exists because we already handled
-		// the it = begin() case)
-		const auto &predecessor = *(it - 1);
-		const auto &successor = *it;
-
-		// Do the thing.
-		int64_t diff_before = static_cast<int64_t>(at_timestamp_ns) - predecessor.timestamp;
-		int64_t diff_after = static_cast<int64_t>(successor.timestamp) - at_timestamp_ns;
-
-		float amount_to_lerp = (float)diff_before / (float)(diff_before + diff_after);
-
-		// Copy intersection of relation flags
-		xrt_space_relation result{};
-		result.relation_flags = (enum xrt_space_relation_flags)(predecessor.relation.relation_flags &
-		                                                        successor.relation.relation_flags);
-		// First-order implementation - lerp between the before and after
-		if (0 != (result.relation_flags & XRT_SPACE_RELATION_POSITION_VALID_BIT)) {
-			result.pose.position = m_vec3_lerp(predecessor.relation.pose.position,
-			                                   successor.relation.pose.position, amount_to_lerp);
-		}
-		if (0 != (result.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT)) {
 
-			math_quat_slerp(&predecessor.relation.pose.orientation, &successor.relation.pose.orientation,
-			                amount_to_lerp, &result.pose.orientation);
-		}
+	struct relation_history_lookup lookup = {};
+	struct m_relation_history_prediction prediction = rh->prediction;
+	uint64_t older_window_ns = get_older_window_ns(&prediction);
 
-		//! @todo Does interpolating the velocities make any sense?
-		if (0 != (result.relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT)) {
-			result.angular_velocity = m_vec3_lerp(predecessor.relation.angular_velocity,
-			                                      successor.relation.angular_velocity, amount_to_lerp);
-		}
-		if (0 != (result.relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT)) {
-			result.linear_velocity = m_vec3_lerp(predecessor.relation.linear_velocity,
-			                                     successor.relation.linear_velocity, amount_to_lerp);
-		}
-		*out_relation = result;
-		return M_RELATION_HISTORY_RESULT_INTERPOLATED;
+	read_consistent(rh, [&]() {
+		uint64_t first = rh->first.load(std::memory_order_relaxed);
+		uint64_t end = rh->end.load(std::memory_order_relaxed);
 
-	} catch (std::exception const &e) {
-		U_LOG_E("Caught exception: %s", e.what());
-		return M_RELATION_HISTORY_RESULT_INVALID;
+		lookup_read(rh, first, end, first, at_timestamp_ns, older_window_ns, &lookup);
+	});
+
+	// You push nothing to the buffer you get nothing from the buffer.
+	lookup_to_relation(&lookup, &prediction, at_timestamp_ns, out_relation);
+
+	return lookup.result;
+}
+
+void
+m_relation_history_get_many(const struct m_relation_history *rh,
+                            const uint64_t *at_timestamps_ns,
+                            uint32_t count,
+                            struct xrt_space_relation *out_relations,
+                            enum m_relation_history_result *out_results)
+{
+	XRT_TRACE_MARKER();
+
+	// Copied entries are kept on the stack, so do the lookups in chunks.
+	constexpr uint32_t ChunkSize = 16;
+	struct relation_history_lookup lookups[ChunkSize];
+	struct m_relation_history_prediction prediction = rh->prediction;
+	uint64_t older_window_ns = get_older_window_ns(&prediction);
+
+	for (uint32_t offset = 0; offset < count; offset += ChunkSize) {
+		const uint64_t *timestamps = &at_timestamps_ns[offset];
+		uint32_t chunk_count = std::min(count - offset, ChunkSize);
+
+		read_consistent(rh, [&]() {
+			uint64_t first = rh->first.load(std::memory_order_relaxed);
+			uint64_t end = rh->end.load(std::memory_order_relaxed);
+			uint64_t search_from = first;
+
+			for (uint32_t i = 0; i < chunk_count; i++) {
+				// When the timestamps are increasing the search continues where the last one ended.
+				if (i > 0 && timestamps[i] < timestamps[i - 1]) {
+					search_from = first;
+				}
+
+				uint64_t ts = timestamps[i];
+				search_from = lookup_read(rh, first, end, search_from, ts, older_window_ns, &lookups[i]);
+			}
+		});
+
+		for (uint32_t i = 0; i < chunk_count; i++) {
+			lookup_to_relation(&lookups[i], &prediction, timestamps[i], &out_relations[offset + i]);
+
+			if (out_results != NULL) {
+				out_results[offset + i] = lookups[i].result;
+			}
+		}
 	}
 }
 
@@ -232,27 +572,68 @@ m_relation_history_get_latest(const struct m_relation_history *rh,
                               uint64_t *out_time_ns,
                               struct xrt_space_relation *out_relation)
 {
-	std::unique_lock<os::Mutex> lock(rh->mutex);
-	if (rh->impl.empty()) {
+	struct relation_history_entry rhe = {};
+	bool empty = true;
+
+	read_consistent(rh, [&]() {
+		uint64_t first = rh->first.load(std::memory_order_relaxed);
+		uint64_t end = rh->end.load(std::memory_order_relaxed);
+
+		empty = first >= end;
+		if (!empty) {
+			rhe = entry_at(rh, end - 1);
+		}
+	});
+
+	if (empty) {
 		return false;
 	}
-	*out_relation = rh->impl.back().relation;
-	*out_time_ns = rh->impl.back().timestamp;
+
+	*out_relation = rhe.relation;
+	*out_time_ns = rhe.timestamp;
 	return true;
 }
 
 uint32_t
 m_relation_history_get_size(const struct m_relation_history *rh)
 {
-	std::unique_lock<os::Mutex> lock(rh->mutex);
-	return (uint32_t)rh->impl.size();
+	uint64_t size = 0;
+
+	read_consistent(rh, [&]() {
+		uint64_t first = rh->first.load(std::memory_order_relaxed);
+		uint64_t end = rh->end.load(std::memory_order_relaxed);
+		size = end - first;
+	});
+
+	return (uint32_t)size;
 }
 
 void
 m_relation_history_clear(struct m_relation_history *rh)
 {
-	std::unique_lock<os::Mutex> lock(rh->mutex);
-	rh->impl.clear();
+	std::unique_lock<os::Mutex> lock(rh->write_mutex);
+
+	write_begin(rh);
+	rh->first.store(rh->end.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	write_end(rh);
+}
+
+void
+m_relation_history_set_prediction(struct m_relation_history *rh, const struct m_relation_history_prediction *pred)
+{
+	rh->prediction = *pred;
+}
+
+void
+m_relation_history_add_vars(struct m_relation_history *rh, void *root, const char *prefix)
+{
+	char tmp[512];
+	snprintf(tmp, sizeof(tmp), "%sprediction.angular_acceleration", prefix);
+	u_var_add_bool(root, &rh->prediction.angular_acceleration, tmp);
+	snprintf(tmp, sizeof(tmp), "%sprediction.damping", prefix);
+	u_var_add_f32(root, &rh->prediction.damping, tmp);
+	snprintf(tmp, sizeof(tmp), "%sprediction.window_ms", prefix);
+	u_var_add_f32(root, &rh->prediction.window_ms, tmp);
 }
 
 void
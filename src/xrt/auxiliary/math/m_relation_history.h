@@ -20,9 +20,9 @@ extern "C" {
 /**
  * @brief Opaque type for storing the history of a space relation in a ring buffer
  *
- * @note Unlike the bare C++ data structure @ref HistoryBuffer this wraps, **this is a thread safe interface**,
- * and is safe for concurrent access from multiple threads.
- * (It is using a simple mutex, not a reader/writer lock, but that is fine until proven to be a bottleneck.)
+ * @note **This is a thread safe interface**, and is safe for concurrent access from multiple threads.
+ * Readers never take a lock and never block the thread pushing new relations, they instead retry if it pushed
+ * while they were reading. Pushing from multiple threads is safe but those are serialized with a mutex.
  *
  * @ingroup aux_util
  */
@@ -42,6 +42,26 @@ enum m_relation_history_result
 	M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED, //!< The desired timestamp was older than the oldest entry
 };
 
+/*!
+ * Controls how a relation history predicts past its newest entry.
+ *
+ * @relates m_relation_history
+ */
+struct m_relation_history_prediction
+{
+	/*!
+	 * Also use the angular acceleration, estimated from the angular velocity
+	 * of the entries in the history, when predicting. Off by default.
+	 */
+	bool angular_acceleration;
+
+	//! How fast the estimated angular acceleration decays, per second.
+	float damping;
+
+	//! How far back to look when estimating the angular acceleration.
+	float window_ms;
+};
+
 /*!
  * Creates an opaque relation_history object.
  *
@@ -64,6 +84,26 @@ m_relation_history_push(struct m_relation_history *rh,
                         struct xrt_space_relation const *in_relation,
                         uint64_t timestamp);
 
+/*!
+ * Same as @ref m_relation_history_push but for several poses at once, takes
+ * the write lock once and readers see all of them appear at the same time.
+ * Poses whose timestamp isn't after the one before it are skipped.
+ *
+ * @param rh self
+ * @param in_relations Array of @p count relations.
+ * @param timestamps Array of @p count timestamps, increasing.
+ * @param count Number of poses.
+ *
+ * @return The number of poses that were pushed.
+ *
+ * @public @memberof m_relation_history
+ */
+uint32_t
+m_relation_history_push_many(struct m_relation_history *rh,
+                             struct xrt_space_relation const *in_relations,
+                             const uint64_t *timestamps,
+                             uint32_t count);
+
 /*!
  * Interpolates or extrapolates to the desired timestamp.
  *
@@ -77,6 +117,26 @@ m_relation_history_get(const struct m_relation_history *rh,
                        uint64_t at_timestamp_ns,
                        struct xrt_space_relation *out_relation);
 
+/*!
+ * Same as @ref m_relation_history_get but for several timestamps at once, the
+ * history is searched once for all of them if the timestamps are increasing.
+ * Timestamps may be in any order, just slightly slower if they are not.
+ *
+ * @param rh self
+ * @param at_timestamps_ns Timestamps to get relations at.
+ * @param count Number of timestamps.
+ * @param[out] out_relations Array of @p count relations.
+ * @param[out] out_results Optional array of @p count results, may be NULL.
+ *
+ * @public @memberof m_relation_history
+ */
+void
+m_relation_history_get_many(const struct m_relation_history *rh,
+                            const uint64_t *at_timestamps_ns,
+                            uint32_t count,
+                            struct xrt_space_relation *out_relations,
+                            enum m_relation_history_result *out_results);
+
 /*!
  * Estimates the movement (velocity and angular velocity) of a new relation based on
  * the latest relation found in the buffer (as returned by m_relation_history_get_latest).
@@ -117,6 +177,24 @@ m_relation_history_get_latest(const struct m_relation_history *rh,
 uint32_t
 m_relation_history_get_size(const struct m_relation_history *rh);
 
+/*!
+ * Sets how the history predicts past its newest entry, the defaults come from
+ * the `M_RELATION_HISTORY_PREDICT_*` environment variables.
+ *
+ * @public @memberof m_relation_history
+ */
+void
+m_relation_history_set_prediction(struct m_relation_history *rh, const struct m_relation_history_prediction *pred);
+
+/*!
+ * Adds the prediction settings of the history to the given u_var root, so it
+ * can be tuned per device.
+ *
+ * @public @memberof m_relation_history
+ */
+void
+m_relation_history_add_vars(struct m_relation_history *rh, void *root, const char *prefix);
+
 /*!
  * Clears the history from all of the items.
  *
@@ -183,6 +261,15 @@ public:
 		return m_relation_history_push(mPtr, &relation, ts);
 	}
 
+	/*!
+	 * @copydoc m_relation_history_push_many
+	 */
+	uint32_t
+	push_many(xrt_space_relation const *relations, const uint64_t *timestamps, uint32_t count) noexcept
+	{
+		return m_relation_history_push_many(mPtr, relations, timestamps, count);
+	}
+
 	/*!
 	 * @copydoc m_relation_history_get
 	 */
@@ -192,6 +279,18 @@ public:
 		return m_relation_history_get(mPtr, at_time_ns, out_relation);
 	}
 
+	/*!
+	 * @copydoc m_relation_history_get_many
+	 */
+	void
+	get_many(const uint64_t *at_times_ns,
+	         uint32_t count,
+	         xrt_space_relation *out_relations,
+	         Result *out_results = nullptr) const noexcept
+	{
+		m_relation_history_get_many(mPtr, at_times_ns, count, out_relations, out_results);
+	}
+
 	/*!
 	 * @copydoc m_relation_history_get_latest
 	 */
@@ -210,6 +309,15 @@ public:
 		return m_relation_history_get_size(mPtr);
 	}
 
+	/*!
+	 * @copydoc m_relation_history_set_prediction
+	 */
+	void
+	set_prediction(m_relation_history_prediction const &pred) noexcept
+	{
+		m_relation_history_set_prediction(mPtr, &pred);
+	}
+
 	/*!
 	 * @copydoc m_relation_history_clear
 	 */
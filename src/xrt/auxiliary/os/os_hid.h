@@ -140,6 +140,43 @@ os_hid_destroy(struct os_hid_device *hid_dev)
  */
 int
 os_hid_open_hidraw(const char *path, struct os_hid_device **out_hid);
+
+/*!
+ * Called from the hid reactor thread with each input report of a registered
+ * device, @p timestamp_ns is when the reactor woke up to read it. A negative
+ * @p size is an error from reading the device, @p data is then NULL and the
+ * device will not be polled anymore, it still needs to be unregistered.
+ *
+ * @see os_hid_reactor_register
+ */
+typedef void (*os_hid_report_func_t)(void *ptr, const uint8_t *data, int size, int64_t timestamp_ns);
+
+/*!
+ * Hand the reading of input reports on a hidraw device over to the shared hid
+ * reactor, a single epoll thread that reads all pending reports of every
+ * registered device each time it wakes up and hands them to @p func. This
+ * saves drivers from having a blocking read thread per device.
+ *
+ * Once registered, the device must not be read with @ref os_hid_read, all
+ * other functions can still be used from any thread.
+ *
+ * @return 0 on success, -ENOTSUP if the device isn't a hidraw device, in which
+ * case the driver has to read it itself, or another negative errno value.
+ *
+ * @public @memberof os_hid_device
+ */
+int
+os_hid_reactor_register(struct os_hid_device *hid_dev, os_hid_report_func_t func, void *ptr);
+
+/*!
+ * Stop dispatching reports from the given device. Once this returns the
+ * callback is not running and will not be called again. Must not be called
+ * from the callback itself. Destroying a device also unregisters it.
+ *
+ * @public @memberof os_hid_device
+ */
+void
+os_hid_reactor_unregister(struct os_hid_device *hid_dev);
 #endif
 
 #ifdef __cplusplus
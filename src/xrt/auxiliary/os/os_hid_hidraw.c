@@ -12,6 +12,8 @@
 
 #ifdef XRT_OS_LINUX
 
+#include "os/os_threading.h"
+#include "os/os_time.h"
 #include "util/u_misc.h"
 #include <poll.h>
 #include <errno.h>
@@ -21,6 +23,8 @@
 #include <time.h>
 #include <stdint.h>
 
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/ioctl.h>
 
 #include <linux/hidraw.h>
@@ -36,6 +40,13 @@ struct hid_hidraw
 	struct os_hid_device base;
 
 	int fd;
+
+	//! Is this device registered with the hid reactor, protected by its state lock.
+	bool reactor_registered;
+	//! Slot in the hid reactor, valid when registered.
+	uint32_t reactor_slot;
+	//! File status flags to restore when unregistering.
+	int reactor_saved_flags;
 };
 
 static int
@@ -126,11 +137,358 @@ os_hidraw_set_feature(struct os_hid_device *ohdev, const uint8_t *data, size_t l
 	return ioctl(hrdev->fd, HIDIOCSFEATURE(length), data);
 }
 
+
+
+/*
+ *
+ * Reactor.
+ *
+ */
+
+//! How many devices the reactor can have registered at once.
+#define HID_REACTOR_MAX_DEVICES 32
+
+//! How many epoll events to take in one wakeup.
+#define HID_REACTOR_MAX_EVENTS 16
+
+/*!
+ * How many reports to read from one device per wakeup, the rest are read on
+ * the next one so that a chatty device can't starve the others.
+ */
+#define HID_REACTOR_MAX_READS_PER_WAKEUP 8
+
+//! Largest report that hidraw will give us.
+#define HID_REACTOR_MAX_REPORT_SIZE 4096
+
+//! Epoll data of the eventfd used to wake up the reactor thread.
+#define HID_REACTOR_WAKE_DATA UINT64_MAX
+
+struct hid_reactor_slot
+{
+	struct hid_hidraw *hrdev;
+	os_hid_report_func_t func;
+	void *ptr;
+
+	//! Bumped on every unregister, so stale epoll events can be told apart.
+	uint32_t generation;
+
+	//! Is the fd still in the epoll set, errors remove it.
+	bool polled;
+};
+
+/*!
+ * Process wide reactor, the thread is started by the first registered device
+ * and stopped when the last is unregistered.
+ */
+static struct
+{
+	//! Serialises (un)registering, starting and stopping the thread, taken before dispatch.
+	pthread_mutex_t state;
+
+	//! Protects the slots and is held by the thread while calling callbacks.
+	pthread_mutex_t dispatch;
+
+	struct os_thread_helper oth;
+
+	int epoll_fd;
+	int wake_fd;
+
+	uint32_t device_count;
+	struct hid_reactor_slot slots[HID_REACTOR_MAX_DEVICES];
+} g_reactor = {
+    .state = PTHREAD_MUTEX_INITIALIZER,
+    .dispatch = PTHREAD_MUTEX_INITIALIZER,
+    .epoll_fd = -1,
+    .wake_fd = -1,
+};
+
+static inline uint64_t
+hid_reactor_make_data(uint32_t slot, uint32_t generation)
+{
+	return ((uint64_t)generation << 32) | slot;
+}
+
+static void
+hid_reactor_remove_from_epoll_locked(struct hid_reactor_slot *slot)
+{
+	if (!slot->polled) {
+		return;
+	}
+
+	epoll_ctl(g_reactor.epoll_fd, EPOLL_CTL_DEL, slot->hrdev->fd, NULL);
+	slot->polled = false;
+}
+
+static void
+hid_reactor_dispatch_locked(const struct epoll_event *event, uint8_t *buffer, int64_t timestamp_ns)
+{
+	uint32_t index = (uint32_t)(event->data.u64 & UINT32_MAX);
+	uint32_t generation = (uint32_t)(event->data.u64 >> 32);
+
+	if (index >= HID_REACTOR_MAX_DEVICES) {
+		return;
+	}
+
+	struct hid_reactor_slot *slot = &g_reactor.slots[index];
+	if (slot->hrdev == NULL || slot->generation != generation || !slot->polled) {
+		// Unregistered after epoll_wait returned.
+		return;
+	}
+
+	// Read everything that is pending, the fd is non-blocking.
+	for (int i = 0; i < HID_REACTOR_MAX_READS_PER_WAKEUP; i++) {
+		ssize_t ret = read(slot->hrdev->fd, buffer, HID_REACTOR_MAX_REPORT_SIZE);
+		if (ret > 0) {
+			slot->func(slot->ptr, buffer, (int)ret, timestamp_ns);
+			continue;
+		}
+
+		if (ret < 0 && (errno == EAGAIN || errno == EINTR)) {
+			break;
+		}
+
+		// Zero sized read or a real error, the device is most likely gone.
+		int err = ret < 0 ? -errno : -EIO;
+		hid_reactor_remove_from_epoll_locked(slot);
+		slot->func(slot->ptr, NULL, err, timestamp_ns);
+		return;
+	}
+
+	if ((event->events & (EPOLLERR | EPOLLHUP)) != 0 && (event->events & EPOLLIN) == 0) {
+		hid_reactor_remove_from_epoll_locked(slot);
+		slot->func(slot->ptr, NULL, -EIO, timestamp_ns);
+	}
+}
+
+static void *
+hid_reactor_run(void *ptr)
+{
+	struct epoll_event events[HID_REACTOR_MAX_EVENTS];
+	uint8_t buffer[HID_REACTOR_MAX_REPORT_SIZE];
+
+	os_thread_helper_lock(&g_reactor.oth);
+	while (os_thread_helper_is_running_locked(&g_reactor.oth)) {
+		os_thread_helper_unlock(&g_reactor.oth);
+
+		int count = epoll_wait(g_reactor.epoll_fd, events, ARRAY_SIZE(events), -1);
+		if (count < 0 && errno != EINTR) {
+			return NULL;
+		}
+
+		// One timestamp for the whole batch, it's when we got woken up.
+		int64_t now_ns = (int64_t)os_monotonic_get_ns();
+
+		pthread_mutex_lock(&g_reactor.dispatch);
+		for (int i = 0; i < count; i++) {
+			if (events[i].data.u64 == HID_REACTOR_WAKE_DATA) {
+				// Stopping, the eventfd is never read so we keep waking until we see it.
+				continue;
+			}
+			hid_reactor_dispatch_locked(&events[i], buffer, now_ns);
+		}
+		pthread_mutex_unlock(&g_reactor.dispatch);
+
+		os_thread_helper_lock(&g_reactor.oth);
+	}
+	os_thread_helper_unlock(&g_reactor.oth);
+
+	return NULL;
+}
+
+static void
+hid_reactor_teardown_locked(void)
+{
+	if (g_reactor.oth.initialized) {
+		if (g_reactor.wake_fd >= 0) {
+			uint64_t one = 1;
+			ssize_t ret = write(g_reactor.wake_fd, &one, sizeof(one));
+			(void)ret;
+		}
+		os_thread_helper_destroy(&g_reactor.oth);
+	}
+
+	if (g_reactor.wake_fd >= 0) {
+		close(g_reactor.wake_fd);
+		g_reactor.wake_fd = -1;
+	}
+
+	if (g_reactor.epoll_fd >= 0) {
+		close(g_reactor.epoll_fd);
+		g_reactor.epoll_fd = -1;
+	}
+}
+
+static int
+hid_reactor_setup_locked(void)
+{
+	g_reactor.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (g_reactor.epoll_fd < 0) {
+		return -errno;
+	}
+
+	g_reactor.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (g_reactor.wake_fd < 0) {
+		int err = -errno;
+		hid_reactor_teardown_locked();
+		return err;
+	}
+
+	struct epoll_event event = {
+	    .events = EPOLLIN,
+	    .data.u64 = HID_REACTOR_WAKE_DATA,
+	};
+	if (epoll_ctl(g_reactor.epoll_fd, EPOLL_CTL_ADD, g_reactor.wake_fd, &event) < 0) {
+		int err = -errno;
+		hid_reactor_teardown_locked();
+		return err;
+	}
+
+	int ret = os_thread_helper_init(&g_reactor.oth);
+	if (ret != 0) {
+		hid_reactor_teardown_locked();
+		return -ret;
+	}
+
+	ret = os_thread_helper_start(&g_reactor.oth, hid_reactor_run, NULL);
+	if (ret != 0) {
+		hid_reactor_teardown_locked();
+		return ret < 0 ? ret : -ret;
+	}
+
+	os_thread_helper_name(&g_reactor.oth, "HID Reactor");
+
+	return 0;
+}
+
+int
+os_hid_reactor_register(struct os_hid_device *hid_dev, os_hid_report_func_t func, void *ptr)
+{
+	if (hid_dev == NULL || hid_dev->read != os_hidraw_read) {
+		return -ENOTSUP;
+	}
+
+	struct hid_hidraw *hrdev = (struct hid_hidraw *)hid_dev;
+	int ret = 0;
+
+	pthread_mutex_lock(&g_reactor.state);
+
+	if (hrdev->reactor_registered) {
+		ret = -EBUSY;
+		goto out_unlock;
+	}
+
+	uint32_t index = 0;
+	while (index < HID_REACTOR_MAX_DEVICES && g_reactor.slots[index].hrdev != NULL) {
+		index++;
+	}
+	if (index >= HID_REACTOR_MAX_DEVICES) {
+		ret = -ENOSPC;
+		goto out_unlock;
+	}
+
+	if (g_reactor.device_count == 0) {
+		ret = hid_reactor_setup_locked();
+		if (ret < 0) {
+			goto out_unlock;
+		}
+	}
+
+	// Reports are read until there are none left, so we must not block.
+	int flags = fcntl(hrdev->fd, F_GETFL);
+	if (flags < 0 || fcntl(hrdev->fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+		ret = -errno;
+		goto out_teardown;
+	}
+
+	struct hid_reactor_slot *slot = &g_reactor.slots[index];
+
+	pthread_mutex_lock(&g_reactor.dispatch);
+	slot->hrdev = hrdev;
+	slot->func = func;
+	slot->ptr = ptr;
+	slot->polled = true;
+
+	struct epoll_event event = {
+	    .events = EPOLLIN,
+	    .data.u64 = hid_reactor_make_data(index, slot->generation),
+	};
+	if (epoll_ctl(g_reactor.epoll_fd, EPOLL_CTL_ADD, hrdev->fd, &event) < 0) {
+		ret = -errno;
+		U_ZERO(slot);
+		pthread_mutex_unlock(&g_reactor.dispatch);
+		fcntl(hrdev->fd, F_SETFL, flags);
+		goto out_teardown;
+	}
+	pthread_mutex_unlock(&g_reactor.dispatch);
+
+	hrdev->reactor_registered = true;
+	hrdev->reactor_slot = index;
+	hrdev->reactor_saved_flags = flags;
+	g_reactor.device_count++;
+
+	goto out_unlock;
+
+out_teardown:
+	if (g_reactor.device_count == 0) {
+		hid_reactor_teardown_locked();
+	}
+out_unlock:
+	pthread_mutex_unlock(&g_reactor.state);
+
+	return ret;
+}
+
+void
+os_hid_reactor_unregister(struct os_hid_device *hid_dev)
+{
+	if (hid_dev == NULL || hid_dev->read != os_hidraw_read) {
+		return;
+	}
+
+	struct hid_hidraw *hrdev = (struct hid_hidraw *)hid_dev;
+
+	pthread_mutex_lock(&g_reactor.state);
+
+	if (!hrdev->reactor_registered) {
+		pthread_mutex_unlock(&g_reactor.state);
+		return;
+	}
+
+	// Waits for any callback in flight to finish.
+	pthread_mutex_lock(&g_reactor.dispatch);
+	struct hid_reactor_slot *slot = &g_reactor.slots[hrdev->reactor_slot];
+	hid_reactor_remove_from_epoll_locked(slot);
+	slot->hrdev = NULL;
+	slot->func = NULL;
+	slot->ptr = NULL;
+	slot->generation++;
+	pthread_mutex_unlock(&g_reactor.dispatch);
+
+	fcntl(hrdev->fd, F_SETFL, hrdev->reactor_saved_flags);
+	hrdev->reactor_registered = false;
+
+	if (--g_reactor.device_count == 0) {
+		hid_reactor_teardown_locked();
+	}
+
+	pthread_mutex_unlock(&g_reactor.state);
+}
+
+
+/*
+ *
+ * Device functions.
+ *
+ */
+
 static void
 os_hidraw_destroy(struct os_hid_device *ohdev)
 {
 	struct hid_hidraw *hrdev = (struct hid_hidraw *)ohdev;
 
+	// Includes the registered check.
+	os_hid_reactor_unregister(ohdev);
+
 	close(hrdev->fd);
 	free(hrdev);
 }
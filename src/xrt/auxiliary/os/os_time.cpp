@@ -9,12 +9,15 @@
  * over timepoints from @ref time_state for general usage in drivers, etc.
  *
  * @author Christoph Haag <christoph.haag@collabora.com>
+ * @author Jakob Bornecrantz <jakob@collabora.com>
  *
  * @ingroup aux_os
  */
 
 #include "xrt/xrt_config_os.h"
 
+#include "os/os_time.h"
+
 #ifdef XRT_OS_WINDOWS
 
 #include <inttypes.h>
@@ -29,3 +32,310 @@ os_realtime_get_ns(void)
 	return ret;
 }
 #endif
+
+
+/*
+ *
+ * Fast monotonic clock.
+ *
+ */
+
+#if defined(XRT_OS_LINUX) && (defined(__x86_64__) || defined(__aarch64__)) && defined(__GNUC__)
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+#include <atomic>
+#include <mutex>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+//! How long the startup calibration measures the counter for.
+constexpr int64_t kCalibrationNs = 20 * U_TIME_1MS_IN_NS;
+
+//! How often the mapping is checked against CLOCK_MONOTONIC.
+constexpr int64_t kRecheckNs = U_TIME_1S_IN_NS;
+
+//! If a check is off by more than this the counter can't be trusted.
+constexpr int64_t kMaxErrorNs = 100 * U_TIME_1US_IN_NS;
+
+//! Fixed point shift of the ns per tick multiplier.
+constexpr int kShift = 32;
+
+enum class State : int
+{
+	Uninitialized,
+	Enabled,
+	Disabled,
+};
+
+/*!
+ * Maps counter ticks to CLOCK_MONOTONIC nanoseconds, protected by a sequence
+ * lock so the hot path never takes a lock.
+ */
+struct FastClock
+{
+	std::atomic<State> state{State::Uninitialized};
+
+	std::atomic<uint32_t> seq{0};
+	std::atomic<uint64_t> base_ticks{0};
+	std::atomic<uint64_t> base_ns{0};
+	std::atomic<uint64_t> mult{0};
+
+	//! Ticks between checks, fixed after calibration.
+	uint64_t recheck_ticks = 0;
+
+	//! Only one thread does a check at a time, the others keep going.
+	std::atomic_flag checking = ATOMIC_FLAG_INIT;
+
+	//! First calibration sample, the long term rate is measured from it.
+	uint64_t first_ticks = 0;
+	uint64_t first_ns = 0;
+
+	std::once_flag once;
+};
+
+FastClock g_clock;
+
+inline uint64_t
+read_ticks()
+{
+#if defined(__x86_64__)
+	return __rdtsc();
+#else
+	uint64_t value;
+	__asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(value) : : "memory");
+	return value;
+#endif
+}
+
+bool
+counter_is_invariant()
+{
+#if defined(__x86_64__)
+	unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+	if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007) {
+		return false;
+	}
+	if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0) {
+		return false;
+	}
+
+	// Invariant TSC, runs at a constant rate in all ACPI P, C and T states.
+	return (edx & (1u << 8)) != 0;
+#else
+	// The generic timer of ARMv8 always runs at a fixed frequency.
+	return true;
+#endif
+}
+
+/*!
+ * Reads the counter on both sides of CLOCK_MONOTONIC, keeps the tightest of a
+ * few tries so a preemption doesn't skew the sample.
+ */
+void
+sample(uint64_t &out_ticks, uint64_t &out_ns)
+{
+	uint64_t best_window = UINT64_MAX;
+
+	for (int i = 0; i < 5; i++) {
+		uint64_t before = read_ticks();
+		uint64_t ns = os_monotonic_get_ns();
+		uint64_t after = read_ticks();
+
+		if (after - before < best_window) {
+			best_window = after - before;
+			out_ticks = before + (after - before) / 2;
+			out_ns = ns;
+		}
+	}
+}
+
+inline uint64_t
+ticks_to_ns(uint64_t ticks, uint64_t base_ticks, uint64_t base_ns, uint64_t mult)
+{
+	// Another thread may have rebased just after we read the counter.
+	if (ticks < base_ticks) {
+		return base_ns;
+	}
+
+	unsigned __int128 delta = ticks - base_ticks;
+	return base_ns + (uint64_t)((delta * mult) >> kShift);
+}
+
+void
+publish(uint64_t base_ticks, uint64_t base_ns, uint64_t mult)
+{
+	uint32_t seq = g_clock.seq.load(std::memory_order_relaxed);
+	g_clock.seq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	g_clock.base_ticks.store(base_ticks, std::memory_order_relaxed);
+	g_clock.base_ns.store(base_ns, std::memory_order_relaxed);
+	g_clock.mult.store(mult, std::memory_order_relaxed);
+
+	g_clock.seq.store(seq + 2, std::memory_order_release);
+}
+
+inline void
+read_mapping(uint64_t &out_base_ticks, uint64_t &out_base_ns, uint64_t &out_mult)
+{
+	uint32_t seq0, seq1;
+	do {
+		seq0 = g_clock.seq.load(std::memory_order_acquire);
+		out_base_ticks = g_clock.base_ticks.load(std::memory_order_relaxed);
+		out_base_ns = g_clock.base_ns.load(std::memory_order_relaxed);
+		out_mult = g_clock.mult.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		seq1 = g_clock.seq.load(std::memory_order_relaxed);
+	} while ((seq0 & 1) != 0 || seq0 != seq1);
+}
+
+uint64_t
+compute_mult(uint64_t delta_ns, uint64_t delta_ticks)
+{
+	return (uint64_t)(((unsigned __int128)delta_ns << kShift) / delta_ticks);
+}
+
+void
+calibrate()
+{
+	const char *env = std::getenv("XRT_FAST_CLOCK");
+	if (env != nullptr && (std::strcmp(env, "0") == 0 || std::strcmp(env, "false") == 0)) {
+		g_clock.state.store(State::Disabled);
+		return;
+	}
+
+	if (!counter_is_invariant()) {
+		g_clock.state.store(State::Disabled);
+		return;
+	}
+
+	uint64_t ticks0 = 0, ns0 = 0, ticks1 = 0, ns1 = 0;
+	sample(ticks0, ns0);
+	os_nanosleep(kCalibrationNs);
+	sample(ticks1, ns1);
+
+	// Anything outside of 1MHz to 10GHz is broken, also catches a stopped counter.
+	uint64_t delta_ticks = ticks1 - ticks0;
+	uint64_t delta_ns = ns1 - ns0;
+	if (ticks1 <= ticks0 || delta_ticks < delta_ns / 1000 || delta_ticks > delta_ns * 10) {
+		g_clock.state.store(State::Disabled);
+		return;
+	}
+
+	uint64_t mult = compute_mult(delta_ns, delta_ticks);
+
+	g_clock.first_ticks = ticks0;
+	g_clock.first_ns = ns0;
+	g_clock.recheck_ticks = (uint64_t)(((unsigned __int128)kRecheckNs << kShift) / mult);
+	publish(ticks1, ns1, mult);
+
+	// Make sure it agrees with CLOCK_MONOTONIC right away.
+	uint64_t ticks = 0, ns = 0;
+	sample(ticks, ns);
+	int64_t error_ns = (int64_t)(ns - ticks_to_ns(ticks, ticks1, ns1, mult));
+	if (error_ns > kMaxErrorNs || error_ns < -kMaxErrorNs) {
+		g_clock.state.store(State::Disabled);
+		return;
+	}
+
+	g_clock.state.store(State::Enabled, std::memory_order_release);
+}
+
+/*!
+ * Compares the mapping against CLOCK_MONOTONIC, the rate is then slewed so the
+ * mapping meets CLOCK_MONOTONIC at the next check instead of stepping it.
+ */
+void
+recheck()
+{
+	if (g_clock.checking.test_and_set(std::memory_order_acquire)) {
+		return;
+	}
+
+	uint64_t base_ticks, base_ns, mult;
+	read_mapping(base_ticks, base_ns, mult);
+
+	uint64_t ticks = 0, ns = 0;
+	sample(ticks, ns);
+
+	uint64_t predicted_ns = ticks_to_ns(ticks, base_ticks, base_ns, mult);
+	int64_t error_ns = (int64_t)(ns - predicted_ns);
+
+	if (error_ns > kMaxErrorNs || error_ns < -kMaxErrorNs || ticks <= g_clock.first_ticks) {
+		g_clock.state.store(State::Disabled, std::memory_order_release);
+		g_clock.checking.clear(std::memory_order_release);
+		return;
+	}
+
+	// Long term rate, then aim to line back up with CLOCK_MONOTONIC at the next check.
+	uint64_t long_mult = compute_mult(ns - g_clock.first_ns, ticks - g_clock.first_ticks);
+	uint64_t target_ns = ns + ((g_clock.recheck_ticks * (unsigned __int128)long_mult) >> kShift);
+	uint64_t new_mult = target_ns > predicted_ns ? compute_mult(target_ns - predicted_ns, g_clock.recheck_ticks)
+	                                             : long_mult;
+
+	publish(ticks, predicted_ns, new_mult);
+
+	g_clock.checking.clear(std::memory_order_release);
+}
+
+} // namespace
+
+extern "C" uint64_t
+os_monotonic_get_ns_fast(void)
+{
+	State state = g_clock.state.load(std::memory_order_acquire);
+	if (state == State::Uninitialized) {
+		std::call_once(g_clock.once, calibrate);
+		state = g_clock.state.load(std::memory_order_acquire);
+	}
+
+	if (state != State::Enabled) {
+		return os_monotonic_get_ns();
+	}
+
+	uint64_t base_ticks, base_ns, mult;
+	read_mapping(base_ticks, base_ns, mult);
+
+	uint64_t ticks = read_ticks();
+	if (ticks > base_ticks && ticks - base_ticks >= g_clock.recheck_ticks) {
+		recheck();
+
+		// Might have been turned off by the check.
+		if (g_clock.state.load(std::memory_order_acquire) != State::Enabled) {
+			return os_monotonic_get_ns();
+		}
+
+		read_mapping(base_ticks, base_ns, mult);
+	}
+
+	return ticks_to_ns(ticks, base_ticks, base_ns, mult);
+}
+
+extern "C" bool
+os_monotonic_fast_is_enabled(void)
+{
+	std::call_once(g_clock.once, calibrate);
+	return g_clock.state.load(std::memory_order_acquire) == State::Enabled;
+}
+
+#else
+
+extern "C" uint64_t
+os_monotonic_get_ns_fast(void)
+{
+	return os_monotonic_get_ns();
+}
+
+extern "C" bool
+os_monotonic_fast_is_enabled(void)
+{
+	return false;
+}
+
+#endif
@@ -78,6 +78,31 @@ extern "C" {
 static inline uint64_t
 os_monotonic_get_ns(void);
 
+/*!
+ * Return the same monotonic clock as @ref os_monotonic_get_ns but read from
+ * the CPU counter (TSC or CNTVCT) where that is invariant, which avoids a
+ * syscall on systems where the vDSO isn't used. The counter is calibrated
+ * against @ref os_monotonic_get_ns on the first call, which takes a few
+ * milliseconds, and checked against it about once a second after that. If it
+ * drifts too far the function falls back to @ref os_monotonic_get_ns for good.
+ * Setting the `XRT_FAST_CLOCK` env variable to `0` turns it off.
+ *
+ * Meant for hot paths that read the clock a lot, like spin loops.
+ *
+ * @ingroup aux_os_time
+ */
+uint64_t
+os_monotonic_get_ns_fast(void);
+
+/*!
+ * Is @ref os_monotonic_get_ns_fast reading the CPU counter, calibrates it if
+ * that has not been done yet.
+ *
+ * @ingroup aux_os_time
+ */
+bool
+os_monotonic_fast_is_enabled(void);
+
 /*!
  * Sleep the given number of nanoseconds.
  *
@@ -125,6 +150,26 @@ os_precise_sleeper_deinit(struct os_precise_sleeper *ops);
 static inline void
 os_precise_sleeper_nanosleep(struct os_precise_sleeper *ops, int32_t nsec);
 
+/*!
+ * Wait until the given monotonic time. Normally the same as sleeping for the
+ * time left, but if @ref os_precise_sleeper::hybrid is set it sleeps until a
+ * learned slack before the deadline and then spins for the rest. Every hybrid
+ * wait measures how late the OS woke it up and adjusts the slack to that.
+ *
+ * @public @memberof os_precise_sleeper
+ */
+static inline void
+os_precise_sleeper_wait_until(struct os_precise_sleeper *ops, uint64_t until_ns);
+
+/*!
+ * Hint to the CPU that we are in a spin loop, lets the other hyper-thread run
+ * and saves some power.
+ *
+ * @ingroup aux_os_time
+ */
+static inline void
+os_cpu_relax(void);
+
 #if defined(XRT_HAVE_TIMESPEC) || defined(XRT_DOXYGEN)
 /*!
  * Convert a timespec struct to nanoseconds.
@@ -204,13 +249,36 @@ os_nanosleep(int64_t nsec)
 #endif
 }
 
+//! Starting slack for hybrid waits, kernels regularly wake up this late.
+#define OS_PRECISE_SLEEPER_INITIAL_SLACK_NS (500 * U_TIME_1US_IN_NS)
+//! Never spin less than this.
+#define OS_PRECISE_SLEEPER_MIN_SLACK_NS (20 * U_TIME_1US_IN_NS)
+//! Never spin more than this, if waking up is worse spinning won't help.
+#define OS_PRECISE_SLEEPER_MAX_SLACK_NS (2 * U_TIME_1MS_IN_NS)
+
 struct os_precise_sleeper
 {
 #if defined(XRT_OS_WINDOWS)
 	HANDLE timer;
-#else
-	int unused_;
 #endif
+
+	//! Sleep until @ref slack_ns before the deadline then spin.
+	bool hybrid;
+
+	//! How long before the deadline hybrid waits stop sleeping, learned.
+	int64_t slack_ns;
+
+	//! Number of hybrid waits that slept.
+	uint64_t wait_count;
+
+	//! Number of hybrid waits that woke up after the deadline.
+	uint64_t late_count;
+
+	//! How late the OS woke us up on the last hybrid wait.
+	int64_t wake_error_last_ns;
+
+	//! Largest wake up error seen.
+	int64_t wake_error_max_ns;
 };
 
 static inline void
@@ -219,6 +287,12 @@ os_precise_sleeper_init(struct os_precise_sleeper *ops)
 #if defined(XRT_OS_WINDOWS)
 	ops->timer = CreateWaitableTimer(NULL, TRUE, NULL);
 #endif
+	ops->hybrid = false;
+	ops->slack_ns = OS_PRECISE_SLEEPER_INITIAL_SLACK_NS;
+	ops->wait_count = 0;
+	ops->late_count = 0;
+	ops->wake_error_last_ns = 0;
+	ops->wake_error_max_ns = 0;
 }
 
 static inline void
@@ -257,6 +331,69 @@ os_precise_sleeper_nanosleep(struct os_precise_sleeper *ops, int32_t nsec)
 #endif
 }
 
+static inline void
+os_cpu_relax(void)
+{
+#if defined(_MSC_VER)
+	YieldProcessor();
+#elif defined(__i386__) || defined(__x86_64__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+static inline void
+os_precise_sleeper_wait_until(struct os_precise_sleeper *ops, uint64_t until_ns)
+{
+	uint64_t now_ns = os_monotonic_get_ns();
+	if (now_ns >= until_ns) {
+		return;
+	}
+
+	if (!ops->hybrid) {
+		os_precise_sleeper_nanosleep(ops, (int32_t)(until_ns - now_ns));
+		return;
+	}
+
+	// Too close to bother sleeping, go straight to spinning.
+	if (until_ns - now_ns > (uint64_t)ops->slack_ns) {
+		uint64_t sleep_until_ns = until_ns - (uint64_t)ops->slack_ns;
+		os_precise_sleeper_nanosleep(ops, (int32_t)(sleep_until_ns - now_ns));
+		now_ns = os_monotonic_get_ns();
+
+		int64_t error_ns = (int64_t)(now_ns - sleep_until_ns);
+		ops->wake_error_last_ns = error_ns;
+		if (error_ns > ops->wake_error_max_ns) {
+			ops->wake_error_max_ns = error_ns;
+		}
+		ops->wait_count++;
+
+		// Go up quickly with some headroom, but only slowly come back down.
+		int64_t target_ns = error_ns + error_ns / 4;
+		if (target_ns > ops->slack_ns) {
+			ops->slack_ns += (target_ns - ops->slack_ns) / 4;
+		} else {
+			ops->slack_ns -= (ops->slack_ns - target_ns) / 32;
+		}
+
+		if (ops->slack_ns < OS_PRECISE_SLEEPER_MIN_SLACK_NS) {
+			ops->slack_ns = OS_PRECISE_SLEEPER_MIN_SLACK_NS;
+		} else if (ops->slack_ns > OS_PRECISE_SLEEPER_MAX_SLACK_NS) {
+			ops->slack_ns = OS_PRECISE_SLEEPER_MAX_SLACK_NS;
+		}
+
+		if (now_ns >= until_ns) {
+			ops->late_count++;
+			return;
+		}
+	}
+
+	while (os_monotonic_get_ns_fast() < until_ns) {
+		os_cpu_relax();
+	}
+}
+
 #if defined(XRT_HAVE_TIMESPEC)
 static inline uint64_t
 os_timespec_to_ns(const struct timespec *spec)
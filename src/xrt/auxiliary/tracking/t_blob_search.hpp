@@ -0,0 +1,136 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Windowed blob search with connected components for the LED trackers.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_tracking
+ */
+
+#pragma once
+
+#ifndef __cplusplus
+#error "This header is C++-only."
+#endif
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+
+namespace xrt::auxiliary::tracking {
+
+/*!
+ * Parameters for @ref search_blobs.
+ */
+struct BlobSearchParams
+{
+	//! Pixels brighter than this after rectification are part of a blob.
+	double threshold = 32.0;
+
+	//! Blobs with fewer or more pixels than this are dropped.
+	int min_area = 1;
+	int max_area = INT_MAX;
+};
+
+/*!
+ * Clip @p windows to @p bounds, drop the empty ones and merge the ones that
+ * overlap so that no pixel is searched, or blob found, twice.
+ */
+static inline void
+merge_blob_windows(std::vector<cv::Rect> &windows, const cv::Rect &bounds)
+{
+	for (cv::Rect &w : windows) {
+		w &= bounds;
+	}
+
+	bool merged = true;
+	while (merged) {
+		merged = false;
+		for (size_t i = 0; i < windows.size() && !merged; i++) {
+			for (size_t k = i + 1; k < windows.size(); k++) {
+				if ((windows[i] & windows[k]).area() <= 0) {
+					continue;
+				}
+				windows[i] |= windows[k];
+				windows.erase(windows.begin() + k);
+				merged = true;
+				break;
+			}
+		}
+	}
+
+	windows.erase(std::remove_if(windows.begin(), windows.end(), [](const cv::Rect &w) { return w.area() <= 0; }),
+	              windows.end());
+}
+
+/*!
+ * Undistort, rectify and threshold only the @p windows of @p grey into
+ * @p rectified, everything outside of them is cleared, and find the blobs in
+ * them with a connected components pass. An empty list of windows searches the
+ * whole view.
+ *
+ * The keypoints are in rectified pixels, at the centroid of each blob and with
+ * the diameter of a circle with the same area as the size, which is close to
+ * what cv::SimpleBlobDetector gives us for the same blobs.
+ */
+static inline void
+search_blobs(const cv::Mat &grey,
+             const cv::Mat &map_x,
+             const cv::Mat &map_y,
+             std::vector<cv::Rect> windows,
+             const BlobSearchParams &params,
+             cv::Mat &rectified,
+             std::vector<cv::KeyPoint> &out_keypoints)
+{
+	cv::Rect bounds(0, 0, map_x.cols, map_x.rows);
+
+	rectified.create(map_x.size(), CV_8UC1);
+	if (windows.empty()) {
+		windows.push_back(bounds);
+	} else {
+		rectified.setTo(cv::Scalar(0));
+		merge_blob_windows(windows, bounds);
+	}
+
+	cv::Mat labels, stats, centroids;
+	for (const cv::Rect &w : windows) {
+		// A header into rectified, so remap writes straight into it.
+		cv::Mat dst = rectified(w);
+
+		cv::remap(grey,                 // src
+		          dst,                  // dst
+		          map_x(w),             // map1
+		          map_y(w),             // map2
+		          cv::INTER_NEAREST,    // interpolation
+		          cv::BORDER_CONSTANT,  // borderMode
+		          cv::Scalar(0, 0, 0)); // borderValue
+
+		cv::threshold(dst,              // src
+		              dst,              // dst
+		              params.threshold, // thresh
+		              255.0,            // maxval
+		              cv::THRESH_BINARY);
+
+		int count = cv::connectedComponentsWithStats(dst, labels, stats, centroids, 8, CV_32S);
+
+		// Label zero is the background.
+		for (int i = 1; i < count; i++) {
+			int area = stats.at<int>(i, cv::CC_STAT_AREA);
+			if (area < params.min_area || area > params.max_area) {
+				continue;
+			}
+
+			float x = (float)(centroids.at<double>(i, 0) + w.x);
+			float y = (float)(centroids.at<double>(i, 1) + w.y);
+			float size = (float)(2.0 * std::sqrt(area / M_PI));
+
+			out_keypoints.emplace_back(x, y, size);
+		}
+	}
+}
+
+} // namespace xrt::auxiliary::tracking
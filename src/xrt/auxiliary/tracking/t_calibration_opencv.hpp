@@ -156,18 +156,55 @@ struct StereoCameraCalibrationWrapper
 /*!
  * @brief An x,y pair of matrices for the remap() function.
  *
+ * The maps from @ref calibration_get_undistort_map are in OpenCV's fixed-point
+ * format, which cv::remap() is a lot faster with than float maps. Use
+ * @ref remap_source_point to look up single pixels in them.
+ *
  * @see calibration_get_undistort_map
  */
 struct RemapPair
 {
+	//! Either CV_16SC2 integer source coordinates, or CV_32FC1 source x.
 	cv::Mat remap_x;
+	//! Either the CV_16UC1 interpolation table, or CV_32FC1 source y.
 	cv::Mat remap_y;
 };
 
+/*!
+ * @brief Where in the source image the pixel at @p x, @p y of the remapped
+ * image comes from, works with both fixed point and float maps.
+ *
+ * @see RemapPair
+ */
+static inline cv::Point2f
+remap_source_point(const cv::Mat &map1, const cv::Mat &map2, int x, int y)
+{
+	if (map1.type() == CV_32FC1) {
+		return cv::Point2f(map1.at<float>(y, x), map2.at<float>(y, x));
+	}
+
+	const cv::Vec2s &pt = map1.at<cv::Vec2s>(y, x);
+	if (map2.empty()) {
+		return cv::Point2f(pt[0], pt[1]);
+	}
+
+	// The table index holds the fractional parts, y in the upper bits.
+	int index = map2.at<uint16_t>(y, x) & (cv::INTER_TAB_SIZE2 - 1);
+	float fx = (float)(index % cv::INTER_TAB_SIZE) / (float)cv::INTER_TAB_SIZE;
+	float fy = (float)(index / cv::INTER_TAB_SIZE) / (float)cv::INTER_TAB_SIZE;
+
+	return cv::Point2f(pt[0] + fx, pt[1] + fy);
+}
+
 /*!
  * @brief Prepare undistortion/normalization remap structures for a rectilinear
  * or fisheye image.
  *
+ * The maps are converted to CV_16SC2/CV_16UC1, and kept in the on disk cache
+ * keyed on a hash of the calibration and transforms, see
+ * @ref u_distortion_cache_enabled, so the next tracker start skips computing
+ * them.
+ *
  * @param calib A single camera calibration structure.
  * @param rectify_transform_optional A rectification transform to apply, if
  * desired.
@@ -9,14 +9,17 @@
 
 #include "t_euroc_recorder.h"
 
+#include "math/m_api.h"
 #include "os/os_time.h"
 #include "util/u_frame.h"
 #include "util/u_sink.h"
 #include "util/u_var.h"
 #include "util/u_debug.h"
+#include "util/u_worker.h"
 #include "xrt/xrt_defines.h"
 #include "xrt/xrt_tracking.h"
 
+#include <atomic>
 #include <cassert>
 #include <ctime>
 #include <filesystem>
@@ -29,6 +32,11 @@
 #include <opencv2/imgcodecs.hpp>
 
 DEBUG_GET_ONCE_BOOL_OPTION(euroc_recorder_use_jpg, "EUROC_RECORDER_USE_JPG", false)
+DEBUG_GET_ONCE_OPTION(euroc_recorder_format, "EUROC_RECORDER_FORMAT", "png")
+DEBUG_GET_ONCE_NUM_OPTION(euroc_recorder_threads, "EUROC_RECORDER_THREADS", 4)
+
+//! "MERF" in little endian.
+#define EUROC_RAW_MAGIC 0x4652454dU
 
 using std::lock_guard;
 using std::mutex;
@@ -39,6 +47,27 @@ using std::to_string;
 using std::vector;
 using std::filesystem::create_directories;
 
+//! How camera images are stored.
+enum euroc_recorder_format
+{
+	EUROC_RECORDER_FORMAT_PNG, //!< Lossless, compressed in parallel on the worker pool
+	EUROC_RECORDER_FORMAT_JPG, //!< Lossy, compressed in parallel on the worker pool
+	EUROC_RECORDER_FORMAT_RAW, //!< Appended uncompressed to `camN/data.raw`, see @ref euroc_recorder_convert_raw
+};
+
+/*!
+ * Precedes every image in a `camN/data.raw` file, the image follows with its
+ * rows packed together.
+ */
+struct euroc_raw_record
+{
+	uint32_t magic;
+	uint32_t format; //!< Either XRT_FORMAT_L8 or XRT_FORMAT_R8G8B8
+	uint32_t width;
+	uint32_t height;
+	uint64_t timestamp;
+};
+
 struct euroc_recorder
 {
 	struct xrt_frame_node node;
@@ -49,7 +78,11 @@ struct euroc_recorder
 	bool recording;                    //!< Whether samples are being recorded
 	struct u_var_button recording_btn; //!< UI button to start/stop `recording`
 
-	bool use_jpg; //! Whether or not we should save images as .jpg files
+	enum euroc_recorder_format format; //!< How to store camera images
+
+	// Images are compressed on this pool so that the writer sinks keep up with the cameras
+	struct u_worker_thread_pool *pool;
+	struct u_worker_group *group;
 
 	// Cloner sinks: copy frame to heap for quick release of the original
 	struct xrt_slam_sinks cloner_queues; //!< Queue sinks that write into cloner sinks
@@ -74,6 +107,16 @@ struct euroc_recorder
 	ofstream *imu_csv = nullptr;
 	ofstream *gt_csv = nullptr;
 	ofstream *cams_csv[XRT_TRACKING_MAX_SLAM_CAMS] = {};
+	ofstream *cams_raw[XRT_TRACKING_MAX_SLAM_CAMS] = {}; //!< Only with @ref EUROC_RECORDER_FORMAT_RAW
+};
+
+//! An image to compress and write to disk on the worker pool.
+struct euroc_recorder_write_task
+{
+	struct xrt_frame *frame; //!< Referenced until written, only used when recording
+	cv::Mat img;             //!< Owned image, only used when converting
+	string img_path;
+	std::atomic<bool> *failed; //!< Set on failure if not null
 };
 
 
@@ -105,6 +148,11 @@ euroc_recorder_mkfiles(struct euroc_recorder *er)
 		create_directories(data_path);
 		er->cams_csv[i] = new ofstream{data_path + ".csv"};
 		*er->cams_csv[i] << "#timestamp [ns],filename" CSV_EOL;
+
+		if (er->format == EUROC_RECORDER_FORMAT_RAW) {
+			delete er->cams_raw[i];
+			er->cams_raw[i] = new ofstream{data_path + ".raw", std::ios::binary};
+		}
 	}
 }
 
@@ -150,6 +198,9 @@ euroc_recorder_flush(struct euroc_recorder *er)
 	er->gt_csv->flush();
 	for (int i = 0; i < er->cam_count; i++) {
 		er->cams_csv[i]->flush();
+		if (er->cams_raw[i] != nullptr) {
+			er->cams_raw[i]->flush();
+		}
 	}
 }
 
@@ -181,6 +232,45 @@ euroc_recorder_save_gt(xrt_pose_sink *sink, struct xrt_pose_sample *sample)
 	*er->gt_csv << o.w << "," << o.x << "," << o.y << "," << o.z << CSV_EOL;
 }
 
+static void
+euroc_recorder_write_task_func(void *ptr)
+{
+	struct euroc_recorder_write_task *task = (struct euroc_recorder_write_task *)ptr;
+
+	cv::Mat img = task->img;
+	if (task->frame != nullptr) {
+		struct xrt_frame *frame = task->frame;
+		auto img_type = frame->format == XRT_FORMAT_L8 ? CV_8UC1 : CV_8UC3;
+		img = cv::Mat{(int)frame->height, (int)frame->width, img_type, frame->data, frame->stride};
+	}
+
+	bool written = cv::imwrite(task->img_path, img);
+	if (!written) {
+		U_LOG_E("Failed to write '%s'", task->img_path.c_str());
+		if (task->failed != nullptr) {
+			*task->failed = true;
+		}
+	}
+
+	xrt_frame_reference(&task->frame, NULL);
+	delete task;
+}
+
+//! Appends the frame to the raw file of its camera, fast enough to do on the writer sink.
+static void
+euroc_recorder_save_raw_frame(euroc_recorder *er, struct xrt_frame *frame, int cam_index)
+{
+	ofstream &raw = *er->cams_raw[cam_index];
+
+	euroc_raw_record record = {EUROC_RAW_MAGIC, frame->format, frame->width, frame->height, frame->timestamp};
+	raw.write((const char *)&record, sizeof(record));
+
+	size_t row_size = frame->width * (frame->format == XRT_FORMAT_L8 ? 1 : 3);
+	for (uint32_t y = 0; y < frame->height; y++) {
+		raw.write((const char *)frame->data + y * frame->stride, row_size);
+	}
+}
+
 static void
 euroc_recorder_save_frame(euroc_recorder *er, struct xrt_frame *frame, int cam_index)
 {
@@ -188,12 +278,19 @@ euroc_recorder_save_frame(euroc_recorder *er, struct xrt_frame *frame, int cam_i
 	uint64_t ts = frame->timestamp;
 
 	assert(frame->format == XRT_FORMAT_L8 || frame->format == XRT_FORMAT_R8G8B8); // Only formats supported
-	auto img_type = frame->format == XRT_FORMAT_L8 ? CV_8UC1 : CV_8UC3;
-	string file_extension = er->use_jpg ? ".jpg" : ".png";
+	// Raw recordings get converted to png later on
+	string file_extension = er->format == EUROC_RECORDER_FORMAT_JPG ? ".jpg" : ".png";
 	string filename = std::to_string(ts) + file_extension;
-	string img_path = er->path + "/mav0/" + cam_name + "/data/" + filename;
-	cv::Mat img{(int)frame->height, (int)frame->width, img_type, frame->data, frame->stride};
-	cv::imwrite(img_path, img);
+
+	if (er->format == EUROC_RECORDER_FORMAT_RAW) {
+		euroc_recorder_save_raw_frame(er, frame, cam_index);
+	} else {
+		// The frame is kept alive by the task, compression happens on the pool
+		struct euroc_recorder_write_task *task = new euroc_recorder_write_task{};
+		xrt_frame_reference(&task->frame, frame);
+		task->img_path = er->path + "/mav0/" + cam_name + "/data/" + filename;
+		u_worker_group_push(er->group, euroc_recorder_write_task_func, task);
+	}
 
 	*er->cams_csv[cam_index] << ts << "," << filename << CSV_EOL;
 }
@@ -316,16 +413,27 @@ static void (*euroc_recorder_receive_cam[XRT_TRACKING_MAX_SLAM_CAMS])(struct xrt
 
 extern "C" void
 euroc_recorder_node_break_apart(struct xrt_frame_node *node)
-{}
+{
+	struct euroc_recorder *er = container_of(node, struct euroc_recorder, node);
+
+	// Finish writing the images still being compressed
+	u_worker_group_wait_all(er->group);
+}
 
 extern "C" void
 euroc_recorder_node_destroy(struct xrt_frame_node *node)
 {
 	struct euroc_recorder *er = container_of(node, struct euroc_recorder, node);
+
+	u_worker_group_wait_all(er->group);
+	u_worker_group_reference(&er->group, NULL);
+	u_worker_thread_pool_reference(&er->pool, NULL);
+
 	delete er->imu_csv;
 	delete er->gt_csv;
 	for (int i = 0; i < er->cam_count; i++) {
 		delete er->cams_csv[i];
+		delete er->cams_raw[i];
 	}
 	delete er;
 }
@@ -351,7 +459,18 @@ euroc_recorder_create(struct xrt_frame_context *xfctx, const char *record_path,
 	xfn->destroy = euroc_recorder_node_destroy;
 	xrt_frame_context_add(xfctx, xfn);
 
-	er->use_jpg = debug_get_bool_option_euroc_recorder_use_jpg();
+	string format = debug_get_option_euroc_recorder_format();
+	if (debug_get_bool_option_euroc_recorder_use_jpg() || format == "jpg") {
+		er->format = EUROC_RECORDER_FORMAT_JPG;
+	} else if (format == "raw") {
+		er->format = EUROC_RECORDER_FORMAT_RAW;
+	} else {
+		er->format = EUROC_RECORDER_FORMAT_PNG;
+	}
+
+	uint32_t thread_count = CLAMP(debug_get_num_option_euroc_recorder_threads(), 1, 32);
+	er->pool = u_worker_thread_pool_create(thread_count, thread_count, "EuRoC Recorder");
+	er->group = u_worker_group_create(er->pool);
 
 	// Setup sink pipeline
 
@@ -457,3 +576,69 @@ euroc_recorder_add_ui(struct xrt_slam_sinks *er_sinks, void *root, const char *p
 	(void)snprintf(tmp, sizeof(tmp), "%s%s", prefix, er->recording ? "Stop recording" : "Record EuRoC dataset");
 	u_var_add_button(root, &er->recording_btn, tmp);
 }
+
+extern "C" bool
+euroc_recorder_convert_raw(const char *dataset_path)
+{
+	uint32_t thread_count = CLAMP(debug_get_num_option_euroc_recorder_threads(), 1, 32);
+	struct u_worker_thread_pool *pool = u_worker_thread_pool_create(thread_count, thread_count, "EuRoC Convert");
+	struct u_worker_group *group = u_worker_group_create(pool);
+	std::atomic<bool> failed{false};
+	vector<string> converted_paths;
+
+	for (int i = 0; i < XRT_TRACKING_MAX_SLAM_CAMS; i++) {
+		string data_path = string(dataset_path) + "/mav0/cam" + to_string(i) + "/data";
+		std::ifstream raw{data_path + ".raw", std::ios::binary};
+		if (!raw.is_open()) {
+			continue;
+		}
+
+		U_LOG_I("Converting '%s.raw'", data_path.c_str());
+
+		euroc_raw_record record;
+		while (raw.read((char *)&record, sizeof(record))) {
+			bool valid = record.magic == EUROC_RAW_MAGIC &&
+			             (record.format == XRT_FORMAT_L8 || record.format == XRT_FORMAT_R8G8B8);
+			if (!valid) {
+				U_LOG_E("Corrupt record in '%s.raw'", data_path.c_str());
+				failed = true;
+				break;
+			}
+
+			auto img_type = record.format == XRT_FORMAT_L8 ? CV_8UC1 : CV_8UC3;
+			cv::Mat img{(int)record.height, (int)record.width, img_type};
+			if (!raw.read((char *)img.data, img.total() * img.elemSize())) {
+				// Happens when the recording was cut short, the image is also missing from the csv
+				U_LOG_W("Truncated last image in '%s.raw'", data_path.c_str());
+				break;
+			}
+
+			struct euroc_recorder_write_task *task = new euroc_recorder_write_task{};
+			task->img = img;
+			task->img_path = data_path + "/" + to_string(record.timestamp) + ".png";
+			task->failed = &failed;
+			u_worker_group_push(group, euroc_recorder_write_task_func, task);
+		}
+
+		converted_paths.push_back(data_path + ".raw");
+	}
+
+	u_worker_group_wait_all(group);
+	u_worker_group_reference(&group, NULL);
+	u_worker_thread_pool_reference(&pool, NULL);
+
+	if (converted_paths.empty()) {
+		U_LOG_E("No raw camera files found in '%s'", dataset_path);
+		return false;
+	}
+
+	if (failed) {
+		return false;
+	}
+
+	for (const string &path : converted_paths) {
+		std::filesystem::remove(path);
+	}
+
+	return true;
+}
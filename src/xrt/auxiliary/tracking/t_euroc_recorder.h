@@ -60,6 +60,19 @@ euroc_recorder_stop(struct xrt_slam_sinks *er_sinks);
 void
 euroc_recorder_add_ui(struct xrt_slam_sinks *er_sinks, void *root, const char *prefix);
 
+/*!
+ * Convert the `camN/data.raw` files written with `EUROC_RECORDER_FORMAT=raw`
+ * into png images in the usual EuRoC layout, compressing them in parallel.
+ * The raw files are removed once every image has been written.
+ *
+ * @param dataset_path Path of the recorded dataset, the one containing `mav0`.
+ * @return false if there were no raw files or any image failed to convert.
+ *
+ * @ingroup aux_tracking
+ */
+bool
+euroc_recorder_convert_raw(const char *dataset_path);
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,8 +13,12 @@
 #include "util/u_misc.h"
 #include "util/u_logging.h"
 #include "util/u_json.hpp"
+#include "util/u_distortion_cache.h"
 #include "os/os_time.h"
 
+#include <cstring>
+#include <vector>
+
 
 DEBUG_GET_ONCE_LOG_OPTION(calib_log, "CALIB_LOG", U_LOGGING_INFO)
 
@@ -67,6 +71,101 @@ write_cv_mat(FILE *f, cv::Mat *m);
  *
  */
 namespace xrt::auxiliary::tracking {
+namespace {
+
+//! Bumped when the layout of the cached remap tables changes.
+constexpr uint32_t REMAP_CACHE_VERSION = 1;
+
+//! Add the size and values of @p arr to @p hash, as doubles so the type doesn't matter.
+uint64_t
+hash_mat(uint64_t hash, cv::InputArray arr)
+{
+	cv::Mat mat;
+	if (!arr.empty()) {
+		arr.getMat().convertTo(mat, CV_64F);
+	}
+
+	int dims[2] = {mat.rows, mat.cols};
+	hash = u_distortion_cache_hash_bytes(hash, dims, sizeof(dims));
+	if (!mat.empty()) {
+		hash = u_distortion_cache_hash_bytes(hash, mat.data, mat.total() * mat.elemSize());
+	}
+
+	return hash;
+}
+
+//! Everything that goes into the remap tables, and the OpenCV version that makes them.
+uint64_t
+hash_undistort_map(const CameraCalibrationWrapper &wrap,
+                   cv::InputArray rectify_transform,
+                   const cv::Mat &new_camera_matrix)
+{
+	uint64_t hash = U_DISTORTION_CACHE_HASH_INIT;
+	uint32_t version = REMAP_CACHE_VERSION;
+	const char *cv_version = CV_VERSION;
+	int32_t model = wrap.distortion_model;
+
+	hash = u_distortion_cache_hash_bytes(hash, &version, sizeof(version));
+	hash = u_distortion_cache_hash_bytes(hash, cv_version, strlen(cv_version));
+	hash = u_distortion_cache_hash_bytes(hash, &wrap.image_size_pixels, sizeof(wrap.image_size_pixels));
+	hash = u_distortion_cache_hash_bytes(hash, &model, sizeof(model));
+	hash = hash_mat(hash, wrap.intrinsics_mat);
+	hash = hash_mat(hash, wrap.distortion_mat);
+	hash = hash_mat(hash, rectify_transform);
+	hash = hash_mat(hash, new_camera_matrix);
+
+	return hash;
+}
+
+/*!
+ * The cache entry holds the CV_16SC2 map followed by the CV_16UC1 table, this
+ * gets the size in bytes of the first and of both.
+ */
+void
+get_remap_cache_sizes(const cv::Size &size, size_t &out_map1_size, size_t &out_total_size)
+{
+	size_t pixels = (size_t)size.width * (size_t)size.height;
+	out_map1_size = pixels * 2 * sizeof(int16_t);
+	out_total_size = out_map1_size + pixels * sizeof(uint16_t);
+}
+
+bool
+load_remap_cache(uint64_t key, const cv::Size &size, RemapPair &out_pair)
+{
+	size_t map1_size = 0;
+	size_t total_size = 0;
+	get_remap_cache_sizes(size, map1_size, total_size);
+
+	std::vector<uint8_t> data(total_size);
+	if (!u_distortion_cache_load("remap", key, data.data(), data.size())) {
+		return false;
+	}
+
+	out_pair.remap_x.create(size, CV_16SC2);
+	out_pair.remap_y.create(size, CV_16UC1);
+	memcpy(out_pair.remap_x.data, data.data(), map1_size);
+	memcpy(out_pair.remap_y.data, data.data() + map1_size, total_size - map1_size);
+
+	return true;
+}
+
+void
+store_remap_cache(uint64_t key, const cv::Size &size, const RemapPair &pair)
+{
+	size_t map1_size = 0;
+	size_t total_size = 0;
+	get_remap_cache_sizes(size, map1_size, total_size);
+
+	// Freshly created by convertMaps, so they are continuous.
+	std::vector<uint8_t> data(total_size);
+	memcpy(data.data(), pair.remap_x.data, map1_size);
+	memcpy(data.data() + map1_size, pair.remap_y.data, total_size - map1_size);
+
+	u_distortion_cache_store("remap", key, data.data(), data.size());
+}
+
+} // namespace
+
 RemapPair
 calibration_get_undistort_map(t_camera_calibration &calib,
                               cv::InputArray rectify_transform_optional,
@@ -82,6 +181,15 @@ calibration_get_undistort_map(t_camera_calibration &calib,
 	//              calibration for does not match what was saved
 	cv::Size image_size(calib.image_size_pixels.w, calib.image_size_pixels.h);
 
+	uint64_t key = hash_undistort_map(wrap, rectify_transform_optional, new_camera_matrix_optional);
+	if (load_remap_cache(key, image_size, ret)) {
+		CALIB_DEBUG("Loaded cached remap tables %016llx", (unsigned long long)key);
+		return ret;
+	}
+
+	cv::Mat map_x;
+	cv::Mat map_y;
+
 	switch (calib.distortion_model) {
 	case (T_DISTORTION_FISHEYE_KB4):
 		cv::fisheye::initUndistortRectifyMap(wrap.intrinsics_mat,        // cameraMatrix
@@ -90,8 +198,8 @@ calibration_get_undistort_map(t_camera_calibration &calib,
 		                                     new_camera_matrix_optional, // newCameraMatrix
 		                                     image_size,                 // size
 		                                     CV_32FC1,                   // m1type
-		                                     ret.remap_x,                // map1
-		                                     ret.remap_y);               // map2
+		                                     map_x,                      // map1
+		                                     map_y);                     // map2
 		break;
 	case T_DISTORTION_OPENCV_RADTAN_5:
 		cv::initUndistortRectifyMap(wrap.intrinsics_mat,        // cameraMatrix
@@ -100,12 +208,22 @@ calibration_get_undistort_map(t_camera_calibration &calib,
 		                            new_camera_matrix_optional, // newCameraMatrix
 		                            image_size,                 // size
 		                            CV_32FC1,                   // m1type
-		                            ret.remap_x,                // map1
-		                            ret.remap_y);               // map2
+		                            map_x,                      // map1
+		                            map_y);                     // map2
 		break;
-	default: assert(false);
+	default: assert(false); return ret;
 	}
 
+	// Keep the interpolation table so linear remapping still works.
+	cv::convertMaps(map_x,       // map1
+	                map_y,       // map2
+	                ret.remap_x, // dstmap1
+	                ret.remap_y, // dstmap2
+	                CV_16SC2,    // dstmap1type
+	                false);      // nninterpolation
+
+	store_remap_cache(key, image_size, ret);
+
 	return ret;
 }
 
@@ -0,0 +1,91 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Sequential scalar Kalman correction for flexkalman states.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_tracking
+ */
+
+#pragma once
+
+#ifndef __cplusplus
+#error "This header is C++-only."
+#endif
+
+#include <Eigen/Core>
+
+#include "flexkalman/BaseTypes.h"
+#include "flexkalman/FlexibleKalmanBase.h"
+
+
+namespace xrt::auxiliary::tracking {
+
+/*!
+ * Correct a Kalman filter's state using a measurement that provides a
+ * Jacobian and has a diagonal covariance, like flexkalman::correctExtended.
+ *
+ * The components of such a measurement are independent, so they are applied
+ * one scalar at a time: each is a rank one update of the error covariance and
+ * a division instead of decomposing the innovation covariance. All matrices are
+ * sized at compile time from the state and measurement so nothing allocates,
+ * which is what we want for IMU rate corrections. The Jacobian and residual
+ * are evaluated once, at the state before the correction, which gives the same
+ * result as the batch update.
+ *
+ * Off-diagonal elements of the measurement covariance are ignored.
+ *
+ * @return false, with the state untouched, if the correction or new error
+ * covariance would not be finite.
+ */
+template <typename State, typename Measurement>
+static inline bool
+correctSequential(flexkalman::StateBase<State> &state, flexkalman::MeasurementBase<Measurement> &meas)
+{
+	namespace types = flexkalman::types;
+
+	//! Dimension of state
+	constexpr size_t n = flexkalman::getDimension<State>();
+	//! Dimension of measurement
+	constexpr size_t m = flexkalman::getDimension<Measurement>();
+
+	State &s = state.derived();
+	Measurement &z = meas.derived();
+
+	const types::Matrix<m, n> H = z.getJacobian(s);
+	const types::SquareMatrix<m> R = z.getCovariance(s);
+	const types::Vector<m> residual = z.getResidual(s);
+
+	types::SquareMatrix<n> P = s.errorCovariance();
+	types::Vector<n> correction = types::Vector<n>::Zero();
+
+	for (size_t i = 0; i < m; i++) {
+		const types::Vector<n> PHt = P * H.row(i).transpose();
+		const double S = H.row(i).dot(PHt) + R(i, i);
+		if (!(S > 0.0)) {
+			return false;
+		}
+
+		const types::Vector<n> K = PHt / S;
+
+		// Residual of this component after the ones before it are applied.
+		const double innovation = residual[i] - H.row(i).dot(correction);
+
+		correction += K * innovation;
+		P -= K * PHt.transpose();
+	}
+
+	if (!correction.allFinite() || !P.allFinite()) {
+		return false;
+	}
+
+	s.setStateVector(s.stateVector() + correction);
+	s.setErrorCovariance(P);
+
+	// Let the state do any cleanup it has to, like fixing externalized quaternions.
+	s.postCorrect();
+
+	return true;
+}
+
+} // namespace xrt::auxiliary::tracking
@@ -15,10 +15,25 @@
 #include "util/u_format.h"
 #include "util/u_trace_marker.h"
 
+#include "os/os_threading.h"
+
+#include "math/m_api.h"
+
 #include "tracking/t_tracking.h"
 
 #include <stdio.h>
 #include <assert.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define T_HSV_FILTER_AVX2
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(no_simd, "T_HSV_FILTER_NO_SIMD", false)
+DEBUG_GET_ONCE_BOOL_OPTION(use_roi, "T_HSV_FILTER_USE_ROI", true)
 
 
 #define MOD_180(v) ((uint32_t)(v) % 180)
@@ -118,12 +133,211 @@ t_hsv_build_optimized_table(struct t_hsv_filter_params *params, struct t_hsv_fil
 
 /*
  *
- * Sink filter
+ * Row functions.
  *
  */
 
 #define NUM_CHANNELS 4
 
+//! Frames a ROI hint is used for without being refreshed.
+#define ROI_MAX_AGE 10
+
+// The SIMD index math below relies on these.
+static_assert(T_HSV_SIZE == 32 && T_HSV_STEP == 8, "Update the table index math");
+
+/*!
+ * Classifies the pixels [x, end) of a row and writes all channels. Both
+ * @p src and @p dst point at the start of the rows.
+ */
+typedef void (*hsv_row_func_t)(const struct t_hsv_filter_optimized_table *t,
+                               const uint8_t *src,
+                               uint8_t *const dst[NUM_CHANNELS],
+                               uint32_t x,
+                               uint32_t end);
+
+struct hsv_row_funcs
+{
+	const char *name;
+	hsv_row_func_t yuv;
+	hsv_row_func_t yuyv;
+};
+
+static inline void
+write_bits(uint8_t bits, uint8_t *const dst[NUM_CHANNELS], uint32_t x)
+{
+	for (int c = 0; c < NUM_CHANNELS; c++) {
+		dst[c][x] = (bits & (1 << c)) ? 0xff : 0x00;
+	}
+}
+
+static void
+scalar_yuv_row(const struct t_hsv_filter_optimized_table *t,
+               const uint8_t *src,
+               uint8_t *const dst[NUM_CHANNELS],
+               uint32_t x,
+               uint32_t end)
+{
+	struct t_hsv_filter_optimized_table *table = (struct t_hsv_filter_optimized_table *)t;
+
+	for (; x < end; x++) {
+		const uint8_t *p = src + x * 3;
+		write_bits(t_hsv_filter_sample(table, p[0], p[1], p[2]), dst, x);
+	}
+}
+
+static void
+scalar_yuyv_row(const struct t_hsv_filter_optimized_table *t,
+                const uint8_t *src,
+                uint8_t *const dst[NUM_CHANNELS],
+                uint32_t x,
+                uint32_t end)
+{
+	struct t_hsv_filter_optimized_table *table = (struct t_hsv_filter_optimized_table *)t;
+
+	for (; x < end; x += 2) {
+		const uint8_t *p = src + x * 2;
+		uint8_t y1 = p[0];
+		uint8_t cb = p[1];
+		uint8_t y2 = p[2];
+		uint8_t cr = p[3];
+
+		write_bits(t_hsv_filter_sample(table, y1, cb, cr), dst, x);
+		write_bits(t_hsv_filter_sample(table, y2, cb, cr), dst, x + 1);
+	}
+}
+
+static const struct hsv_row_funcs scalar_funcs = {
+    .name = "scalar",
+    .yuv = scalar_yuv_row,
+    .yuyv = scalar_yuyv_row,
+};
+
+#ifdef T_HSV_FILTER_AVX2
+//! Same as @ref t_hsv_filter_sample but for the eight 32 bit lanes.
+TARGET_AVX2 static inline __m256i
+avx2_table_index(__m256i y, __m256i u, __m256i v)
+{
+	__m256i iy = _mm256_slli_epi32(_mm256_srli_epi32(y, 3), 10);
+	__m256i iu = _mm256_slli_epi32(_mm256_srli_epi32(u, 3), 5);
+	__m256i iv = _mm256_srli_epi32(v, 3);
+	return _mm256_or_si256(_mm256_or_si256(iy, iu), iv);
+}
+
+//! Looks up eight table entries, the filter pads the table so reading four bytes at the last entry is fine.
+TARGET_AVX2 static inline __m256i
+avx2_lookup(const struct t_hsv_filter_optimized_table *t, __m256i index)
+{
+	__m256i bits = _mm256_i32gather_epi32((const int *)&t->v[0][0][0], index, 1);
+	return _mm256_and_si256(bits, _mm256_set1_epi32(0xff));
+}
+
+//! Packs the low 16 bits of the eight lanes into 16 bytes, keeping the order.
+TARGET_AVX2 static inline __m128i
+avx2_pack_u16(__m256i v)
+{
+	__m256i packed = _mm256_packus_epi32(v, v);
+	packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+	return _mm256_castsi256_si128(packed);
+}
+
+//! Expands the bits of 16 (or 8 if @p half) pixels into the channels.
+TARGET_AVX2 static inline void
+avx2_store_channels(__m128i bits, uint8_t *const dst[NUM_CHANNELS], uint32_t x, bool half)
+{
+	for (int c = 0; c < NUM_CHANNELS; c++) {
+		__m128i mask = _mm_set1_epi8((char)(1 << c));
+		__m128i plane = _mm_cmpeq_epi8(_mm_and_si128(bits, mask), mask);
+		if (half) {
+			_mm_storel_epi64((__m128i *)(dst[c] + x), plane);
+		} else {
+			_mm_storeu_si128((__m128i *)(dst[c] + x), plane);
+		}
+	}
+}
+
+TARGET_AVX2 static void
+avx2_yuv_row(const struct t_hsv_filter_optimized_table *t,
+             const uint8_t *src,
+             uint8_t *const dst[NUM_CHANNELS],
+             uint32_t x,
+             uint32_t end)
+{
+	const __m256i byte_mask = _mm256_set1_epi32(0xff);
+	const __m256i offsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+
+	// Each lane reads one byte past its pixel, so stay a pixel away from the end.
+	for (; x + 9 <= end; x += 8) {
+		__m256i d = _mm256_i32gather_epi32((const int *)(src + x * 3), offsets, 1);
+		__m256i y = _mm256_and_si256(d, byte_mask);
+		__m256i u = _mm256_and_si256(_mm256_srli_epi32(d, 8), byte_mask);
+		__m256i v = _mm256_and_si256(_mm256_srli_epi32(d, 16), byte_mask);
+
+		__m128i bits = avx2_pack_u16(avx2_lookup(t, avx2_table_index(y, u, v)));
+		avx2_store_channels(_mm_packus_epi16(bits, bits), dst, x, true);
+	}
+
+	scalar_yuv_row(t, src, dst, x, end);
+}
+
+TARGET_AVX2 static void
+avx2_yuyv_row(const struct t_hsv_filter_optimized_table *t,
+              const uint8_t *src,
+              uint8_t *const dst[NUM_CHANNELS],
+              uint32_t x,
+              uint32_t end)
+{
+	const __m256i byte_mask = _mm256_set1_epi32(0xff);
+
+	for (; x + 16 <= end; x += 16) {
+		// Eight Y0 U Y1 V macropixels, one per lane.
+		__m256i d = _mm256_loadu_si256((const __m256i *)(src + x * 2));
+		__m256i y0 = _mm256_and_si256(d, byte_mask);
+		__m256i u = _mm256_and_si256(_mm256_srli_epi32(d, 8), byte_mask);
+		__m256i y1 = _mm256_and_si256(_mm256_srli_epi32(d, 16), byte_mask);
+		__m256i v = _mm256_srli_epi32(d, 24);
+
+		__m256i bits0 = avx2_lookup(t, avx2_table_index(y0, u, v));
+		__m256i bits1 = avx2_lookup(t, avx2_table_index(y1, u, v));
+
+		// Back into pixel order, the two pixels of a macropixel share a lane.
+		__m128i bits = avx2_pack_u16(_mm256_or_si256(bits0, _mm256_slli_epi32(bits1, 8)));
+		avx2_store_channels(bits, dst, x, false);
+	}
+
+	scalar_yuyv_row(t, src, dst, x, end);
+}
+
+static const struct hsv_row_funcs avx2_funcs = {
+    .name = "avx2",
+    .yuv = avx2_yuv_row,
+    .yuyv = avx2_yuyv_row,
+};
+#endif
+
+static const struct hsv_row_funcs *
+select_funcs(void)
+{
+	if (debug_get_bool_option_no_simd()) {
+		return &scalar_funcs;
+	}
+
+#ifdef T_HSV_FILTER_AVX2
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return &avx2_funcs;
+	}
+#endif
+
+	return &scalar_funcs;
+}
+
+
+/*
+ *
+ * Sink filter
+ *
+ */
+
 /*!
  * An @ref xrt_frame_sink that splits the input based on hue.
  * @implements xrt_frame_sink
@@ -143,110 +357,130 @@ struct t_hsv_filter
 
 	struct u_sink_debug usds[NUM_CHANNELS];
 
+	const struct hsv_row_funcs *funcs;
+
+	//! Protects @ref roi, which is set from the trackers' threads.
+	struct os_mutex roi_mutex;
+
+	struct
+	{
+		struct xrt_rect rects[T_HSV_MAX_ROIS];
+		uint32_t count;
+		uint32_t age; //!< Frames since the hint was last set
+	} roi[NUM_CHANNELS];
+
+	//! Whether to use the ROI hints, toggleable in the UI.
+	bool use_roi;
+
+	//! How much of the last frame was classified.
+	float processed_percent;
+
 	struct t_hsv_filter_optimized_table table;
+
+	//! The SIMD lookups read four bytes at a time, keep the last entries readable.
+	uint8_t table_padding[3];
 };
 
-static void
-process_sample(struct t_hsv_filter *f,
-               uint8_t y,
-               uint8_t cb,
-               uint8_t cr,
-               uint8_t *dst0,
-               uint8_t *dst1,
-               uint8_t *dst2,
-               uint8_t *dst3)
+/*!
+ * Collects the regions to classify this frame, false if the whole frame
+ * needs to be, which is the case as long as one channel with a sink doesn't
+ * have a fresh hint.
+ */
+static bool
+get_rois(struct t_hsv_filter *f, struct xrt_frame *xf, struct xrt_rect *out_rects, uint32_t *out_count)
 {
-	uint8_t bits = t_hsv_filter_sample(&f->table, y, cb, cr);
-	uint8_t v0 = (bits & (1 << 0)) ? 0xff : 0x00;
-	uint8_t v1 = (bits & (1 << 1)) ? 0xff : 0x00;
-	uint8_t v2 = (bits & (1 << 2)) ? 0xff : 0x00;
-	uint8_t v3 = (bits & (1 << 3)) ? 0xff : 0x00;
-
-	*dst0 = v0;
-	*dst1 = v1;
-	*dst2 = v2;
-	*dst3 = v3;
-}
+	bool whole = !f->use_roi;
+	bool any = false;
+	uint32_t count = 0;
 
-XRT_NO_INLINE static void
-hsv_process_frame_yuv(struct t_hsv_filter *f, struct xrt_frame *xf)
-{
-	SINK_TRACE_MARKER();
+	os_mutex_lock(&f->roi_mutex);
+	for (size_t i = 0; i < NUM_CHANNELS; i++) {
+		if (f->sinks[i] == NULL) {
+			continue;
+		}
+
+		any = true;
+		whole |= f->roi[i].count == 0 || f->roi[i].age >= ROI_MAX_AGE;
+		f->roi[i].age = MIN(f->roi[i].age + 1, ROI_MAX_AGE);
 
-	struct xrt_frame *f0 = f->frames[0];
-	struct xrt_frame *f1 = f->frames[1];
-	struct xrt_frame *f2 = f->frames[2];
-	struct xrt_frame *f3 = f->frames[3];
-
-	for (uint32_t y = 0; y < xf->height; y++) {
-		uint8_t *src = (uint8_t *)xf->data + y * xf->stride;
-		uint8_t *dst0 = f0->data + y * f0->stride;
-		uint8_t *dst1 = f1->data + y * f1->stride;
-		uint8_t *dst2 = f2->data + y * f2->stride;
-		uint8_t *dst3 = f3->data + y * f3->stride;
-
-		for (uint32_t x = 0; x < xf->width; x += 1) {
-			uint8_t y = src[0];
-			uint8_t cb = src[1];
-			uint8_t cr = src[2];
-			src += 3;
-
-			process_sample(f, y, cb, cr, dst0, dst1, dst2, dst3);
-			dst0 += 1;
-			dst1 += 1;
-			dst2 += 1;
-			dst3 += 1;
+		for (uint32_t k = 0; k < f->roi[i].count; k++) {
+			out_rects[count++] = f->roi[i].rects[k];
 		}
 	}
+	os_mutex_unlock(&f->roi_mutex);
+
+	if (whole || !any) {
+		return false;
+	}
+
+	// Clip to the frame, with x aligned to the YUYV macropixels.
+	uint32_t clipped_count = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		struct xrt_rect r = out_rects[i];
+		int x0 = CLAMP(r.offset.w, 0, (int)xf->width) & ~1;
+		int y0 = CLAMP(r.offset.h, 0, (int)xf->height);
+		int x1 = MIN((CLAMP(r.offset.w + r.extent.w, 0, (int)xf->width) + 1) & ~1, (int)xf->width);
+		int y1 = CLAMP(r.offset.h + r.extent.h, 0, (int)xf->height);
+		if (x1 <= x0 || y1 <= y0) {
+			continue;
+		}
+
+		out_rects[clipped_count++] = (struct xrt_rect){{x0, y0}, {x1 - x0, y1 - y0}};
+	}
+
+	*out_count = clipped_count;
+
+	return true;
+}
+
+static void
+process_rect(struct t_hsv_filter *f, struct xrt_frame *xf, const struct xrt_rect *r)
+{
+	hsv_row_func_t row = xf->format == XRT_FORMAT_YUV888 ? f->funcs->yuv : f->funcs->yuyv;
+	uint32_t x = r->offset.w;
+	uint32_t end = r->offset.w + r->extent.w;
+
+	for (int y = r->offset.h; y < r->offset.h + r->extent.h; y++) {
+		const uint8_t *src = xf->data + y * xf->stride;
+		uint8_t *const dst[NUM_CHANNELS] = {
+		    f->frames[0]->data + y * f->frames[0]->stride,
+		    f->frames[1]->data + y * f->frames[1]->stride,
+		    f->frames[2]->data + y * f->frames[2]->stride,
+		    f->frames[3]->data + y * f->frames[3]->stride,
+		};
+
+		row(&f->table, src, dst, x, end);
+	}
 }
 
 XRT_NO_INLINE static void
-hsv_process_frame_yuyv(struct t_hsv_filter *f, struct xrt_frame *xf)
+hsv_process_frame(struct t_hsv_filter *f, struct xrt_frame *xf)
 {
 	SINK_TRACE_MARKER();
 
-	struct xrt_frame *f0 = f->frames[0];
-	struct xrt_frame *f1 = f->frames[1];
-	struct xrt_frame *f2 = f->frames[2];
-	struct xrt_frame *f3 = f->frames[3];
-
-	for (uint32_t y = 0; y < xf->height; y++) {
-		uint8_t *src = (uint8_t *)xf->data + y * xf->stride;
-		uint8_t *dst0 = f0->data + y * f0->stride;
-		uint8_t *dst1 = f1->data + y * f1->stride;
-		uint8_t *dst2 = f2->data + y * f2->stride;
-		uint8_t *dst3 = f3->data + y * f3->stride;
-
-		for (uint32_t x = 0; x < xf->width; x += 2) {
-			uint8_t y1 = src[0];
-			uint8_t cb = src[1];
-			uint8_t y2 = src[2];
-			uint8_t cr = src[3];
-			src += 4;
-
-			uint8_t bits0 = t_hsv_filter_sample(&f->table, y1, cb, cr);
-			uint8_t bits1 = t_hsv_filter_sample(&f->table, y2, cb, cr);
-
-			uint8_t v0 = (bits0 & (1 << 0)) ? 0xff : 0x00;
-			uint8_t v1 = (bits0 & (1 << 1)) ? 0xff : 0x00;
-			uint8_t v2 = (bits0 & (1 << 2)) ? 0xff : 0x00;
-			uint8_t v3 = (bits0 & (1 << 3)) ? 0xff : 0x00;
-			uint8_t v4 = (bits1 & (1 << 0)) ? 0xff : 0x00;
-			uint8_t v5 = (bits1 & (1 << 1)) ? 0xff : 0x00;
-			uint8_t v6 = (bits1 & (1 << 2)) ? 0xff : 0x00;
-			uint8_t v7 = (bits1 & (1 << 3)) ? 0xff : 0x00;
-
-			*(uint16_t *)dst0 = v0 | v4 << 8;
-			*(uint16_t *)dst1 = v1 | v5 << 8;
-			*(uint16_t *)dst2 = v2 | v6 << 8;
-			*(uint16_t *)dst3 = v3 | v7 << 8;
-
-			dst0 += 2;
-			dst1 += 2;
-			dst2 += 2;
-			dst3 += 2;
-		}
+	struct xrt_rect rects[NUM_CHANNELS * T_HSV_MAX_ROIS];
+	uint32_t count = 0;
+
+	if (!get_rois(f, xf, rects, &count)) {
+		struct xrt_rect whole = {{0, 0}, {(int)xf->width, (int)xf->height}};
+		process_rect(f, xf, &whole);
+		f->processed_percent = 100.0f;
+		return;
+	}
+
+	// Outside of the regions nothing is found.
+	for (size_t i = 0; i < NUM_CHANNELS; i++) {
+		memset(f->frames[i]->data, 0, f->frames[i]->size);
 	}
+
+	// Overlapping regions just get classified twice.
+	uint64_t area = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		process_rect(f, xf, &rects[i]);
+		area += (uint64_t)rects[i].extent.w * rects[i].extent.h;
+	}
+
+	f->processed_percent = MIN(100.0f, 100.0f * (float)area / (float)(xf->width * xf->height));
 }
 
 static void
@@ -290,12 +524,9 @@ hsv_frame(struct xrt_frame_sink *xsink, struct xrt_frame *xf)
 
 	switch (xf->format) {
 	case XRT_FORMAT_YUV888:
-		ensure_buf_allocated(f, xf);
-		hsv_process_frame_yuv(f, xf);
-		break;
 	case XRT_FORMAT_YUYV422:
 		ensure_buf_allocated(f, xf);
-		hsv_process_frame_yuyv(f, xf);
+		hsv_process_frame(f, xf);
 		break;
 	default: U_LOG_E("Bad format '%s'", u_format_str(xf->format)); return;
 	}
@@ -320,6 +551,7 @@ hsv_destroy(struct xrt_frame_node *node)
 	for (size_t i = 0; i < ARRAY_SIZE(f->usds); i++) {
 		u_sink_debug_destroy(&f->usds[i]);
 	}
+	os_mutex_destroy(&f->roi_mutex);
 
 	free(f);
 }
@@ -340,14 +572,25 @@ t_hsv_filter_create(struct xrt_frame_context *xfctx,
 	f->sinks[2] = sinks[2];
 	f->sinks[3] = sinks[3];
 
+	f->funcs = select_funcs();
+	f->use_roi = debug_get_bool_option_use_roi();
+	os_mutex_init(&f->roi_mutex);
+	for (size_t i = 0; i < NUM_CHANNELS; i++) {
+		f->roi[i].age = ROI_MAX_AGE;
+	}
+
 	t_hsv_build_optimized_table(&f->params, &f->table);
 
+	U_LOG_D("Using '%s' HSV filter functions.", f->funcs->name);
+
 	xrt_frame_context_add(xfctx, &f->node);
 
 	for (size_t i = 0; i < NUM_CHANNELS; i++) {
 		u_sink_debug_init(&f->usds[i]);
 	}
 	u_var_add_root(f, "HSV Filter", true);
+	u_var_add_bool(f, &f->use_roi, "Use ROI hints");
+	u_var_add_ro_f32(f, &f->processed_percent, "Classified %");
 	u_var_add_sink_debug(f, &f->usds[0], "Red");
 	u_var_add_sink_debug(f, &f->usds[1], "Purple");
 	u_var_add_sink_debug(f, &f->usds[2], "Blue");
@@ -357,3 +600,18 @@ t_hsv_filter_create(struct xrt_frame_context *xfctx,
 
 	return 0;
 }
+
+void
+t_hsv_filter_set_roi(struct xrt_frame_sink *sink, uint32_t channel, const struct xrt_rect *rois, uint32_t roi_count)
+{
+	struct t_hsv_filter *f = (struct t_hsv_filter *)sink;
+	assert(channel < NUM_CHANNELS);
+
+	roi_count = MIN(roi_count, T_HSV_MAX_ROIS);
+
+	os_mutex_lock(&f->roi_mutex);
+	memcpy(f->roi[channel].rects, rois, sizeof(*rois) * roi_count);
+	f->roi[channel].count = roi_count;
+	f->roi[channel].age = 0;
+	os_mutex_unlock(&f->roi_mutex);
+}
@@ -12,6 +12,7 @@
 #include "xrt/xrt_tracking.h"
 
 #include "tracking/t_tracking.h"
+#include "tracking/t_blob_search.hpp"
 #include "tracking/t_calibration_opencv.hpp"
 #include "tracking/t_tracker_psmv_fusion.hpp"
 #include "tracking/t_helper_debug_sink.hpp"
@@ -24,17 +25,21 @@
 #include "util/u_trace_marker.h"
 
 #include "math/m_api.h"
+#include "math/m_vec3.h"
 
 #include "os/os_threading.h"
 
 #include <stdio.h>
 #include <assert.h>
 #include <pthread.h>
+#include <algorithm>
 #include <type_traits>
 
 
 using namespace xrt::auxiliary::tracking;
 
+DEBUG_GET_ONCE_BOOL_OPTION(psmv_windowed_search, "PSMV_WINDOWED_SEARCH", true)
+
 //! Namespace for PS Move tracking implementation
 namespace xrt::auxiliary::tracking::psmv {
 
@@ -116,9 +121,22 @@ public:
 
 	cv::Ptr<cv::SimpleBlobDetector> sbd;
 
+	//! Only search around the predicted ball, see @ref predict_search_windows.
+	bool windowed_search;
+
+	//! Inverse of @ref disparity_to_depth, to reproject predictions into the views.
+	cv::Matx44d depth_to_disparity;
+
+	//! Size of the ball in the left view the last time it was found.
+	float last_blob_size = 0.0f;
+
 	std::shared_ptr<PSMVFusionInterface> filter;
 
 	xrt_vec3 tracked_object_position;
+
+	//! HSV filter to send ROI hints to, see @ref t_psmv_set_hsv_filter.
+	struct xrt_frame_sink *hsv_filter = nullptr;
+	uint32_t hsv_channel = 0;
 };
 
 // Has to be standard layout because of first element casts we do.
@@ -128,15 +146,26 @@ static_assert(std::is_standard_layout<TrackerPSMV>::value);
  * @brief Perform per-view (two in a stereo camera image) processing on an
  * image, before tracking math is performed.
  *
- * Right now, this is mainly finding blobs/keypoints.
+ * Right now, this is mainly finding blobs/keypoints. With the windowed search
+ * only inside of @p windows, or in the whole view if there are none.
  */
 static void
-do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb)
+do_view(TrackerPSMV &t, View &view, cv::Mat &grey, const std::vector<cv::Rect> &windows, cv::Mat &rgb)
 {
 	XRT_TRACE_MARKER();
 
-	{
-		XRT_TRACE_IDENT(remap);
+	if (t.windowed_search) {
+		XRT_TRACE_IDENT(search);
+
+		search_blobs(grey,                         // grey
+		             view.undistort_rectify_map_x, // map_x
+		             view.undistort_rectify_map_y, // map_y
+		             windows,                      // windows
+		             BlobSearchParams{},           // params
+		             view.frame_undist_rectified,  // rectified
+		             view.keypoints);              // out_keypoints
+	} else {
+		XRT_TRACE_IDENT(detect);
 
 		// Undistort and rectify the whole image.
 		cv::remap(grey,                         // src
@@ -146,20 +175,12 @@ do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 		          cv::INTER_NEAREST,            // interpolation
 		          cv::BORDER_CONSTANT,          // borderMode
 		          cv::Scalar(0, 0, 0));         // borderValue
-	}
-
-	{
-		XRT_TRACE_IDENT(threshold);
 
 		cv::threshold(view.frame_undist_rectified, // src
 		              view.frame_undist_rectified, // dst
 		              32.0,                        // thresh
 		              255.0,                       // maxval
 		              0);                          // type
-	}
-
-	{
-		XRT_TRACE_IDENT(detect);
 
 		// Do blob detection with our masks.
 		//! @todo Re-enable masks.
@@ -168,7 +189,6 @@ do_view(TrackerPSMV &t, View &view, cv::Mat &grey, cv::Mat &rgb)
 		              cv::noArray());              // mask
 	}
 
-
 	// Debug is wanted, draw the keypoints.
 	if (rgb.cols > 0) {
 		cv::drawKeypoints(view.frame_undist_rectified,                // image
@@ -224,6 +244,55 @@ make_lowest_score_finder(FunctionType scoreFunctor)
 	return FindLowestScore<ValueType, FunctionType>{scoreFunctor};
 }
 
+//! A pair of blobs from the two views and the point they triangulate to.
+struct BlobMatch
+{
+	cv::Point3f world;
+	cv::KeyPoint left;
+	cv::Point2f right;
+};
+
+//! Half the size of the ROI hints, in multiples of the blob size and at least in pixels.
+constexpr float ROI_BLOB_SCALE = 2.0f;
+constexpr float ROI_MIN_HALF_SIZE = 32.0f;
+
+//! Region around a blob found in the rectified view, in pixels of the full unrectified frame.
+static struct xrt_rect
+roi_around_blob(const View &view, const cv::Point2f &pt, float blob_size, int x_offset)
+{
+	const cv::Mat &map_x = view.undistort_rectify_map_x;
+	const cv::Mat &map_y = view.undistort_rectify_map_y;
+	int x = CLAMP((int)pt.x, 0, map_x.cols - 1);
+	int y = CLAMP((int)pt.y, 0, map_x.rows - 1);
+
+	// The maps tell where in the unrectified view each rectified pixel is from.
+	cv::Point2f src = remap_source_point(map_x, map_y, x, y);
+	int half = (int)std::max(blob_size * ROI_BLOB_SCALE, ROI_MIN_HALF_SIZE);
+
+	return xrt_rect{{x_offset + (int)src.x - half, (int)src.y - half}, {half * 2, half * 2}};
+}
+
+//! Tell the HSV filter where to look in the next frames, everywhere if nothing was found.
+static void
+send_roi_hints(TrackerPSMV &t, const BlobMatch *match, int view_cols)
+{
+	if (t.hsv_filter == nullptr) {
+		return;
+	}
+
+	if (match == nullptr) {
+		t_hsv_filter_set_roi(t.hsv_filter, t.hsv_channel, nullptr, 0);
+		return;
+	}
+
+	// Both views share the frame side by side.
+	xrt_rect rois[2] = {
+	    roi_around_blob(t.view[0], match->left.pt, match->left.size, 0),
+	    roi_around_blob(t.view[1], match->right, match->left.size, view_cols),
+	};
+	t_hsv_filter_set_roi(t.hsv_filter, t.hsv_channel, rois, ARRAY_SIZE(rois));
+}
+
 //! Convert our 2d point + disparities into 3d points.
 static cv::Point3f
 world_point_from_blobs(const cv::Point2f &left, const cv::Point2f &right, const cv::Matx44d &disparity_to_depth)
@@ -251,6 +320,69 @@ world_point_from_blobs(const cv::Point2f &left, const cv::Point2f &right, const
 	return world_point;
 }
 
+//! Half the size of the search windows, in multiples of the last blob size and at least in pixels.
+constexpr float WINDOW_BLOB_SCALE = 3.0f;
+constexpr float WINDOW_MIN_HALF_SIZE = 24.0f;
+
+//! Inverse of @ref world_point_from_blobs, false if the point can't be seen.
+static bool
+blobs_from_world_point(const cv::Point3f &world, const cv::Matx44d &depth_to_disparity, cv::Point2f out_blobs[2])
+{
+	// Back to OpenCV camera space.
+	cv::Vec4d h_world(world.x, -world.y, -world.z, 1.0);
+	cv::Vec4d xydw = depth_to_disparity * h_world;
+
+	if (std::abs(xydw[3]) < 1e-9 || world.z >= 0.0f) {
+		return false;
+	}
+
+	cv::Point2f left(xydw[0] / xydw[3], xydw[1] / xydw[3]);
+	float disp = xydw[2] / xydw[3];
+
+	out_blobs[0] = left;
+	out_blobs[1] = cv::Point2f(left.x - disp, left.y);
+
+	return true;
+}
+
+/*!
+ * Windows in the two rectified views around where the fusion predicts the ball
+ * to be at @p when_ns, false if it has lost track of the controller and the
+ * whole views need to be searched.
+ */
+static bool
+predict_search_windows(TrackerPSMV &t, timepoint_ns when_ns, std::vector<cv::Rect> out_windows[2])
+{
+	struct xrt_space_relation rel;
+
+	os_thread_helper_lock(&t.oth);
+	t.filter->get_prediction(when_ns, &rel);
+	os_thread_helper_unlock(&t.oth);
+
+	if ((rel.relation_flags & XRT_SPACE_RELATION_POSITION_TRACKED_BIT) == 0 || t.last_blob_size <= 0.0f) {
+		return false;
+	}
+
+	// The fusion tracks the controller, the ball is at the lever arm it is given.
+	struct xrt_vec3 lever_arm = {0.0f, 0.09f, 0.0f};
+	struct xrt_vec3 ball;
+	math_quat_rotate_vec3(&rel.pose.orientation, &lever_arm, &ball);
+	ball = m_vec3_add(ball, rel.pose.position);
+
+	cv::Point2f blobs[2];
+	if (!blobs_from_world_point(cv::Point3f(ball.x, ball.y, ball.z), t.depth_to_disparity, blobs)) {
+		return false;
+	}
+
+	int half = (int)std::max(t.last_blob_size * WINDOW_BLOB_SCALE, WINDOW_MIN_HALF_SIZE);
+	for (int i = 0; i < 2; i++) {
+		cv::Rect window((int)blobs[i].x - half, (int)blobs[i].y - half, half * 2, half * 2);
+		out_windows[i].push_back(window);
+	}
+
+	return true;
+}
+
 /*!
  * @brief Perform tracking computations on a frame of video data.
  */
@@ -287,13 +419,19 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 	cv::Mat l_grey(rows, cols, CV_8UC1, xf->data, stride);
 	cv::Mat r_grey(rows, cols, CV_8UC1, xf->data + cols, stride);
 
-	do_view(t, t.view[0], l_grey, t.debug.rgb[0]);
-	do_view(t, t.view[1], r_grey, t.debug.rgb[1]);
+	// Without a prediction the windows are empty and the whole views are searched.
+	std::vector<cv::Rect> windows[2];
+	if (t.windowed_search) {
+		predict_search_windows(t, xf->timestamp, windows);
+	}
+
+	do_view(t, t.view[0], l_grey, windows[0], t.debug.rgb[0]);
+	do_view(t, t.view[1], r_grey, windows[1], t.debug.rgb[1]);
 
 	cv::Point3f last_point(t.tracked_object_position.x, t.tracked_object_position.y, t.tracked_object_position.z);
-	auto nearest_world = make_lowest_score_finder<cv::Point3f>([&](const cv::Point3f &world_point) {
+	auto nearest_world = make_lowest_score_finder<BlobMatch>([&](const BlobMatch &match) {
 		//! @todo don't really need the square root to be done here.
-		return cv::norm(world_point - last_point);
+		return cv::norm(match.world - last_point);
 	});
 	// do some basic matching to come up with likely disparity-pairs.
 
@@ -316,18 +454,22 @@ process(TrackerPSMV &t, struct xrt_frame *xf)
 		//! several times?
 		if (nearest_blob.got_one) {
 			cv::Point3f pt = world_point_from_blobs(l_blob, nearest_blob.best, disparity_to_depth);
-			nearest_world.handle_candidate(pt);
+			nearest_world.handle_candidate(BlobMatch{pt, l_keypoint, nearest_blob.best});
 		}
 	}
 
 	if (nearest_world.got_one) {
-		cv::Point3f world_point = nearest_world.best;
+		cv::Point3f world_point = nearest_world.best.world;
 		// update internal state
 		memcpy(&t.tracked_object_position, &world_point.x, sizeof(t.tracked_object_position));
+		t.last_blob_size = nearest_world.best.left.size;
 	} else {
 		t.filter->clear_position_tracked_flag();
+		t.last_blob_size = 0.0f;
 	}
 
+	send_roi_hints(t, nearest_world.got_one ? &nearest_world.best : nullptr, cols);
+
 	// We are done with the debug frame.
 	t.debug.submit();
 
@@ -557,6 +699,14 @@ t_psmv_start(struct xrt_tracked_psmv *xtmv)
 	return os_thread_helper_start(&t.oth, t_psmv_run, &t);
 }
 
+extern "C" void
+t_psmv_set_hsv_filter(struct xrt_tracked_psmv *xtmv, struct xrt_frame_sink *hsv_sink, uint32_t channel)
+{
+	auto &t = *container_of(xtmv, TrackerPSMV, base);
+	t.hsv_filter = hsv_sink;
+	t.hsv_channel = channel;
+}
+
 extern "C" int
 t_psmv_create(struct xrt_frame_context *xfctx,
               struct xrt_colour_rgb_f32 *rgb,
@@ -613,6 +763,7 @@ t_psmv_create(struct xrt_frame_context *xfctx,
 	t.view[0].populate_from_calib(data->view[0], rectify.view[0].rectify);
 	t.view[1].populate_from_calib(data->view[1], rectify.view[1].rectify);
 	t.disparity_to_depth = rectify.disparity_to_depth_mat;
+	t.depth_to_disparity = static_cast<cv::Matx44d>(t.disparity_to_depth).inv();
 	StereoCameraCalibrationWrapper wrapped(data);
 	t.r_cam_rotation = wrapped.camera_rotation_mat;
 	t.r_cam_translation = wrapped.camera_translation_mat;
@@ -636,11 +787,13 @@ t_psmv_create(struct xrt_frame_context *xfctx,
 	// clang-format on
 
 	t.sbd = cv::SimpleBlobDetector::create(blob_params);
+	t.windowed_search = debug_get_bool_option_psmv_windowed_search();
 	xrt_frame_context_add(xfctx, &t.node);
 
 	// Everything is safe, now setup the variable tracking.
 	u_var_add_root(&t, "PSMV Tracker", true);
 	u_var_add_vec3_f32(&t, &t.tracked_object_position, "last.ball.pos");
+	u_var_add_bool(&t, &t.windowed_search, "Windowed search");
 	u_var_add_sink_debug(&t, &t.debug.usd, "Debug");
 
 	*out_sink = &t.sink;
@@ -13,6 +13,7 @@
  */
 
 #include "tracking/t_fusion.hpp"
+#include "tracking/t_fusion_sequential.hpp"
 #include "tracking/t_imu_fusion.hpp"
 #include "tracking/t_tracker_psmv_fusion.hpp"
 
@@ -20,6 +21,7 @@
 #include "math/m_eigen_interop.hpp"
 
 #include "util/u_misc.h"
+#include "util/u_debug.h"
 
 #include "flexkalman/AbsoluteOrientationMeasurement.h"
 #include "flexkalman/FlexibleKalmanFilter.h"
@@ -28,6 +30,8 @@
 #include "flexkalman/PoseState.h"
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(psmv_fusion_unscented_imu, "PSMV_FUSION_UNSCENTED_IMU", false)
+
 namespace xrt::auxiliary::tracking {
 
 using namespace xrt::auxiliary::math;
@@ -127,11 +131,25 @@ namespace {
 			flexkalman::predict(filter_state, process_model, dt);
 		}
 		filter_time_ns = timestamp_ns;
-		auto meas = flexkalman::AbsoluteOrientationMeasurement{
-		    // Must rotate by 180 to align
-		    Eigen::Quaterniond(Eigen::AngleAxisd(EIGEN_PI, Eigen::Vector3d::UnitY())) * imu.getQuat(),
-		    variance};
-		if (flexkalman::correctUnscented(filter_state, meas)) {
+		// Must rotate by 180 to align
+		Eigen::Quaterniond quat =
+		    Eigen::Quaterniond(Eigen::AngleAxisd(EIGEN_PI, Eigen::Vector3d::UnitY())) * imu.getQuat();
+
+		/*
+		 * The orientation is linear in the state and the variance diagonal,
+		 * so the sequential update ends up very close to the unscented one
+		 * without evaluating any sigma points, this runs for every IMU sample.
+		 */
+		bool corrected = false;
+		if (debug_get_bool_option_psmv_fusion_unscented_imu()) {
+			auto meas = flexkalman::AbsoluteOrientationMeasurement{quat, variance};
+			corrected = flexkalman::correctUnscented(filter_state, meas);
+		} else {
+			auto meas = flexkalman::AbsoluteOrientationEKFMeasurement<State>{quat, variance};
+			corrected = correctSequential(filter_state, meas);
+		}
+
+		if (corrected) {
 			orientation_state.tracked = true;
 			orientation_state.valid = true;
 		} else {
@@ -11,6 +11,7 @@
 #include "xrt/xrt_tracking.h"
 
 #include "tracking/t_tracking.h"
+#include "tracking/t_blob_search.hpp"
 #include "tracking/t_calibration_opencv.hpp"
 #include "tracking/t_helper_debug_sink.hpp"
 
@@ -39,6 +40,7 @@
 
 
 DEBUG_GET_ONCE_LOG_OPTION(psvr_log, "PSVR_TRACKING_LOG", U_LOGGING_WARN)
+DEBUG_GET_ONCE_BOOL_OPTION(psvr_windowed_search, "PSVR_WINDOWED_SEARCH", true)
 
 #define PSVR_TRACE(...) U_LOG_IFL_T(t.log_level, __VA_ARGS__)
 #define PSVR_DEBUG(...) U_LOG_IFL_D(t.log_level, __VA_ARGS__)
@@ -55,6 +57,12 @@ DEBUG_GET_ONCE_LOG_OPTION(psvr_log, "PSVR_TRACKING_LOG", U_LOGGING_WARN)
  * How many LEDs do we need to do an optical solve/correction
  */
 #define PSVR_OPTICAL_SOLVE_THRESH 5
+/*!
+ * Half the size of the windows searched around the predicted LEDs, in
+ * multiples of the average blob size and at least in pixels.
+ */
+#define PSVR_WINDOW_BLOB_SCALE 3.0f
+#define PSVR_WINDOW_MIN_HALF_SIZE 24.0f
 /*!
  * If potential match vertex is further than this distance from the
  * measurement, reject the match - do not set too low
@@ -274,6 +282,16 @@ public:
 
 	cv::Ptr<cv::SimpleBlobDetector> sbd;
 	std::vector<cv::KeyPoint> l_blobs, r_blobs;
+
+	//! Only search around the predicted LEDs while locked on, see @ref predict_search_windows.
+	bool windowed_search;
+
+	//! Inverse of @ref disparity_to_depth, to reproject predictions into the views.
+	cv::Matx44d depth_to_disparity;
+
+	//! Average size of the blobs in the left view and how many LEDs were found last frame.
+	float last_blob_size = 0.0f;
+	size_t last_led_count = 0;
 	std::vector<match_model_t> matches;
 
 	// we refine our measurement by rejecting outliers and merging 'too
@@ -1225,27 +1243,74 @@ create_match_list(TrackerPSVR &t)
 	}
 }
 
+/*!
+ * Windows in the two rectified views around where the LED filters predict
+ * the LEDs to be, false if we are not locked on to the HMD and the whole views
+ * need to be searched. All LEDs get a window so that we find the ones that
+ * come into view as the HMD turns.
+ */
+static bool
+predict_search_windows(TrackerPSVR &t,
+                       const std::vector<match_data_t> &predicted_pose,
+                       std::vector<cv::Rect> out_windows[2])
+{
+	if (t.last_led_count < PSVR_OPTICAL_SOLVE_THRESH || t.last_blob_size <= 0.0f) {
+		return false;
+	}
+
+	int half = (int)std::max(t.last_blob_size * PSVR_WINDOW_BLOB_SCALE, PSVR_WINDOW_MIN_HALF_SIZE);
+
+	for (const match_data_t &led : predicted_pose) {
+		// Inverse of how the blobs are turned into points in process, with x inverted.
+		cv::Vec4d h_world(-led.position.x(), led.position.y(), led.position.z(), 1.0);
+		cv::Vec4d xydw = t.depth_to_disparity * h_world;
+		if (std::abs(xydw[3]) < 1e-9) {
+			continue;
+		}
+
+		float x = xydw[0] / xydw[3];
+		float y = xydw[1] / xydw[3];
+		float disp = xydw[2] / xydw[3];
+
+		out_windows[0].push_back(cv::Rect((int)x - half, (int)y - half, half * 2, half * 2));
+		out_windows[1].push_back(cv::Rect((int)(x + disp) - half, (int)y - half, half * 2, half * 2));
+	}
+
+	return !out_windows[0].empty();
+}
+
 static void
-do_view(TrackerPSVR &t, View &view, cv::Mat &grey, cv::Mat &rgb)
+do_view(TrackerPSVR &t, View &view, cv::Mat &grey, const std::vector<cv::Rect> &windows, cv::Mat &rgb)
 {
-	// Undistort and rectify the whole image.
-	cv::remap(grey,                         // src
-	          view.frame_undist_rectified,  // dst
-	          view.undistort_rectify_map_x, // map1
-	          view.undistort_rectify_map_y, // map2
-	          cv::INTER_NEAREST,            // interpolation - LINEAR seems
-	                                        // very slow on my setup
-	          cv::BORDER_CONSTANT,          // borderMode
-	          cv::Scalar(0, 0, 0));         // borderValue
-
-	cv::threshold(view.frame_undist_rectified, // src
-	              view.frame_undist_rectified, // dst
-	              32.0,                        // thresh
-	              255.0,                       // maxval
-	              0);
-	t.sbd->detect(view.frame_undist_rectified, // image
-	              view.keypoints,              // keypoints
-	              cv::noArray());              // mask
+	if (t.windowed_search) {
+		// Only inside the windows, or the whole image if there are none.
+		search_blobs(grey,                         // grey
+		             view.undistort_rectify_map_x, // map_x
+		             view.undistort_rectify_map_y, // map_y
+		             windows,                      // windows
+		             BlobSearchParams{},           // params
+		             view.frame_undist_rectified,  // rectified
+		             view.keypoints);              // out_keypoints
+	} else {
+		// Undistort and rectify the whole image.
+		cv::remap(grey,                         // src
+		          view.frame_undist_rectified,  // dst
+		          view.undistort_rectify_map_x, // map1
+		          view.undistort_rectify_map_y, // map2
+		          cv::INTER_NEAREST,            // interpolation - LINEAR seems
+		                                        // very slow on my setup
+		          cv::BORDER_CONSTANT,          // borderMode
+		          cv::Scalar(0, 0, 0));         // borderValue
+
+		cv::threshold(view.frame_undist_rectified, // src
+		              view.frame_undist_rectified, // dst
+		              32.0,                        // thresh
+		              255.0,                       // maxval
+		              0);
+		t.sbd->detect(view.frame_undist_rectified, // image
+		              view.keypoints,              // keypoints
+		              cv::noArray());              // mask
+	}
 
 	// Debug is wanted, draw the keypoints.
 	if (rgb.cols > 0) {
@@ -1545,8 +1610,14 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 	cv::Mat l_grey(rows, cols, CV_8UC1, xf->data, stride);
 	cv::Mat r_grey(rows, cols, CV_8UC1, xf->data + cols, stride);
 
-	do_view(t, t.view[0], l_grey, t.debug.rgb[0]);
-	do_view(t, t.view[1], r_grey, t.debug.rgb[1]);
+	// Without a prediction the windows are empty and the whole views are searched.
+	std::vector<cv::Rect> windows[2];
+	if (t.windowed_search) {
+		predict_search_windows(t, predicted_pose, windows);
+	}
+
+	do_view(t, t.view[0], l_grey, windows[0], t.debug.rgb[0]);
+	do_view(t, t.view[1], r_grey, windows[1], t.debug.rgb[1]);
 
 	// if we wish to confirm our camera input contents, dump frames
 	// to disk
@@ -1628,6 +1699,14 @@ process(TrackerPSVR &t, struct xrt_frame *xf)
 	// treated as separate leds
 	merge_close_points(&t.pruned_points, &t.merged_points, PSVR_MERGE_THRESH);
 
+	// Too few LEDs and the next frame falls back to searching everywhere.
+	float blob_size_sum = 0.0f;
+	for (const cv::KeyPoint &kp : t.l_blobs) {
+		blob_size_sum += kp.size;
+	}
+	t.last_blob_size = t.l_blobs.empty() ? 0.0f : blob_size_sum / t.l_blobs.size();
+	t.last_led_count = t.merged_points.size();
+
 
 	// uncomment to debug 'overpruning' or other issues
 	// that may be related to calibration scale
@@ -2066,6 +2145,7 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 	t.view[0].populate_from_calib(data->view[0], rectify.view[0].rectify);
 	t.view[1].populate_from_calib(data->view[1], rectify.view[1].rectify);
 	t.disparity_to_depth = rectify.disparity_to_depth_mat;
+	t.depth_to_disparity = static_cast<cv::Matx44d>(t.disparity_to_depth).inv();
 	StereoCameraCalibrationWrapper wrapped(data);
 	t.r_cam_rotation = wrapped.camera_rotation_mat;
 	t.r_cam_translation = wrapped.camera_translation_mat;
@@ -2090,6 +2170,7 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 	// clang-format on
 
 	t.sbd = cv::SimpleBlobDetector::create(blob_params);
+	t.windowed_search = debug_get_bool_option_psvr_windowed_search();
 
 	t.target_optical_rotation_correction = Eigen::Quaternionf(1.0f, 0.0f, 0.0f, 0.0f);
 	t.optical_rotation_correction = Eigen::Quaternionf(1.0f, 0.0f, 0.0f, 0.0f);
@@ -2140,6 +2221,7 @@ t_psvr_create(struct xrt_frame_context *xfctx,
 	// Everything is safe, now setup the variable tracking.
 	u_var_add_root(&t, "PSVR Tracker", true);
 	u_var_add_log_level(&t, &t.log_level, "Log level");
+	u_var_add_bool(&t, &t.windowed_search, "Windowed search");
 	u_var_add_sink_debug(&t, &t.debug.usd, "Debug");
 
 	*out_sink = &t.sink;
@@ -34,6 +34,7 @@
 
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/version.hpp>
+#include <opencv2/imgproc.hpp>
 
 #include <deque>
 #include <filesystem>
@@ -85,6 +86,15 @@ DEBUG_GET_ONCE_OPTION(slam_csv_path, "SLAM_CSV_PATH", "evaluation/")
 DEBUG_GET_ONCE_BOOL_OPTION(slam_timing_stat, "SLAM_TIMING_STAT", true)
 DEBUG_GET_ONCE_BOOL_OPTION(slam_features_stat, "SLAM_FEATURES_STAT", true)
 DEBUG_GET_ONCE_NUM_OPTION(slam_cam_count, "SLAM_CAM_COUNT", 2)
+DEBUG_GET_ONCE_OPTION(slam_roi, "SLAM_ROI", nullptr)
+DEBUG_GET_ONCE_NUM_OPTION(slam_downscale, "SLAM_DOWNSCALE", 1)
+DEBUG_GET_ONCE_BOOL_OPTION(slam_downscale_pyramid, "SLAM_DOWNSCALE_PYRAMID", false)
+DEBUG_GET_ONCE_NUM_OPTION(slam_max_skip, "SLAM_MAX_SKIP", 0)
+DEBUG_GET_ONCE_FLOAT_OPTION(slam_skip_lag_ms, "SLAM_SKIP_LAG_MS", 0)
+DEBUG_GET_ONCE_FLOAT_OPTION(slam_skip_static_rad, "SLAM_SKIP_STATIC_RAD", 0)
+DEBUG_GET_ONCE_OPTION(slam_shadow_vit_system_library_path, "SLAM_SHADOW_VIT_SYSTEM_LIBRARY_PATH", nullptr)
+DEBUG_GET_ONCE_OPTION(slam_shadow_config, "SLAM_SHADOW_CONFIG", nullptr)
+DEBUG_GET_ONCE_OPTION(slam_shadow_csv_path, "SLAM_SHADOW_CSV_PATH", "evaluation/shadow/")
 
 //! Namespace for the interface to the external SLAM tracking system
 namespace xrt::auxiliary::tracking::slam {
@@ -273,8 +283,10 @@ struct TrackerSlam
 
 	enum u_logging_level log_level; //!< Logging level for the SLAM tracker, set by SLAM_LOG var
 
-	struct xrt_slam_sinks *euroc_recorder; //!< EuRoC dataset recording sinks
-	struct openvr_tracker *ovr_tracker;    //!< OpenVR lighthouse tracker
+	struct xrt_slam_sinks *euroc_recorder;         //!< EuRoC dataset recording sinks
+	struct openvr_tracker *ovr_tracker;            //!< OpenVR lighthouse tracker
+	struct xrt_tracked_slam *shadow = nullptr;     //!< Tracker fed the same data whose poses are only recorded
+	struct xrt_slam_sinks *fanout_sinks = nullptr; //!< Sinks feeding both this tracker and @ref shadow
 
 	// Used mainly for checking that the timestamps come in order
 	timepoint_ns last_imu_ts;                     //!< Last received IMU sample timestamp
@@ -299,8 +311,28 @@ struct TrackerSlam
 	//! @todo Should be automatically computed instead of required to be filled manually through the UI.
 	xrt_vec3 gravity_correction{0, 0, -MATH_GRAVITY_M_S2};
 
-	struct xrt_space_relation last_rel = XRT_SPACE_RELATION_ZERO; //!< Last reported/tracked pose
-	timepoint_ns last_ts;                                         //!< Last reported/tracked pose timestamp
+	//! IMU samples integrated on top of the latest SLAM pose as they arrive, protected by @ref lock_ff.
+	struct
+	{
+		bool valid = false;
+		timepoint_ns base_ts = INT64_MIN;                        //!< Timestamp of the SLAM pose it starts from
+		struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO; //!< SLAM pose with the samples integrated
+		timepoint_ns ts = INT64_MIN;                             //!< Timestamp of the last integrated sample
+	} preinteg;
+
+	//! Processing of frames before submission, see @ref t_slam_tracker_config::preprocess
+	struct
+	{
+		decltype(t_slam_tracker_config::preprocess) config;
+		vector<cv::Mat> images;                  //!< Processed image of each camera, reused between frames
+		timepoint_ns skip_ts = INT64_MIN;        //!< Timestamp of the frames being skipped, decided on cam0
+		timepoint_ns last_submit_ts = INT64_MIN; //!< Timestamp of the last submitted cam0 frame
+		int skipped_in_row = 0;                  //!< Frames skipped since the last submitted one
+		int skipped_count = 0;                   //!< Total skipped frames, for the UI
+	} pre;
+
+	//! Predicted and filtered relations published by the IMU thread, the only thing pose queries read.
+	RelationHistory published_rels{};
 
 	//! Filters are used to smooth out the resulting trajectory
 	struct
@@ -501,6 +533,11 @@ timing_ui_push(TrackerSlam &t, const vit_pose_t *pose, int64_t ts)
 		std::vector<int64_t> data(timing.timestamps, timing.timestamps + timing.count);
 		tss.insert(tss.begin() + 1, data.begin(), data.end());
 
+		// Nobody is looking at the graph.
+		if (!u_var_is_observed()) {
+			return tss;
+		}
+
 		// The two timestamps to compare in the graph
 		timepoint_ns start = tss.at(t.timing.start_ts_idx);
 		timepoint_ns end = tss.at(t.timing.end_ts_idx);
@@ -732,6 +769,79 @@ gt_ui_push(TrackerSlam &t, timepoint_ns ts, xrt_pose tracked_pose)
  *
  */
 
+//! Integrates one synced gyroscope and accelerometer sample into @p rel, moving @p rel_ts to @p ts.
+static void
+integrate_imu_sample(const TrackerSlam &t,
+                     xrt_space_relation &rel,
+                     timepoint_ns &rel_ts,
+                     const xrt_vec3 &g,
+                     const xrt_vec3 &a,
+                     timepoint_ns ts)
+{
+	xrt_quat &o = rel.pose.orientation;
+	xrt_vec3 &p = rel.pose.position;
+	xrt_vec3 &w = rel.angular_velocity;
+	xrt_vec3 &v = rel.linear_velocity;
+
+	// Update time
+	float dt = (float)time_ns_to_s(ts - rel_ts);
+	rel_ts = ts;
+
+	// Integrate gyroscope
+	xrt_quat angvel_delta{};
+	xrt_vec3 scaled_half_g = g * dt * 0.5f;
+	math_quat_exp(&scaled_half_g, &angvel_delta); // Same as using math_quat_from_angle_vector(g/dt)
+	math_quat_rotate(&o, &angvel_delta, &o);      // Orientation
+	math_quat_rotate_derivative(&o, &g, &w);      // Angular velocity
+
+	// Integrate accelerometer
+	xrt_vec3 world_accel{};
+	math_quat_rotate_vec3(&o, &a, &world_accel);
+	world_accel += t.gravity_correction;
+	v += world_accel * dt;                        // Linear velocity
+	p += v * dt + world_accel * (dt * dt * 0.5f); // Position
+}
+
+//! Number of buffered IMU samples newer than @p ts, call with @ref TrackerSlam::lock_ff locked.
+static int
+count_imu_samples_after(TrackerSlam &t, timepoint_ns ts)
+{
+	int count = 0;
+	uint64_t imu_ts = 0;
+	xrt_vec3 _;
+	while (m_ff_vec3_f32_get(t.gyro_ff, count, &_, &imu_ts) && (int64_t)imu_ts > ts) {
+		count++;
+	}
+	return count;
+}
+
+/*!
+ * Restart the preintegration from a new SLAM pose, catching up with the IMU
+ * samples that arrived after it. Call with @ref TrackerSlam::lock_ff locked.
+ */
+static void
+preinteg_reset(TrackerSlam &t, const xrt_space_relation &base_rel, timepoint_ns base_ts)
+{
+	t.preinteg.valid = true;
+	t.preinteg.base_ts = base_ts;
+	t.preinteg.rel = base_rel;
+	t.preinteg.ts = base_ts;
+
+	// Decreasing i increases timestamp
+	for (int i = count_imu_samples_after(t, base_ts) - 1; i >= 0; i--) {
+		xrt_vec3 g{};
+		xrt_vec3 a{};
+		uint64_t g_ts{};
+		uint64_t a_ts{};
+		bool got = true;
+		got &= m_ff_vec3_f32_get(t.gyro_ff, i, &g, &g_ts);
+		got &= m_ff_vec3_f32_get(t.accel_ff, i, &a, &a_ts);
+		SLAM_DASSERT(got && g_ts == a_ts, "Failure getting synced gyro and accel samples");
+
+		integrate_imu_sample(t, t.preinteg.rel, t.preinteg.ts, g, a, (timepoint_ns)g_ts);
+	}
+}
+
 //! Dequeue all tracked poses from the SLAM system and update prediction data with them.
 static bool
 flush_poses(TrackerSlam &t)
@@ -748,6 +858,8 @@ flush_poses(TrackerSlam &t)
 		return false;
 	}
 
+	bool pushed = false;
+
 	do {
 		// New pose
 		vit_pose_data_t data;
@@ -785,6 +897,7 @@ flush_poses(TrackerSlam &t)
 		// Push to relationship history unless we are debugging prediction
 		if (t.dbg_pred_counter % t.dbg_pred_every == 0) {
 			t.slam_rels.push(rel, nts);
+			pushed = true;
 		}
 		t.dbg_pred_counter = (t.dbg_pred_counter + 1) % t.dbg_pred_every;
 
@@ -793,8 +906,11 @@ flush_poses(TrackerSlam &t)
 		xrt_pose_sample pose_sample = {nts, rel.pose};
 		xrt_sink_push_pose(t.euroc_recorder->gt, &pose_sample);
 
-		auto tss = timing_ui_push(t, pose, nts);
-		t.slam_times_writer->push(tss);
+		// The timestamps are only used for the graph and the csv.
+		if (t.slam_times_writer->enabled || u_var_is_observed()) {
+			auto tss = timing_ui_push(t, pose, nts);
+			t.slam_times_writer->push(tss);
+		}
 
 		if (t.features.enabled) {
 			vector feat_count = features_ui_push(t, pose, nts);
@@ -804,30 +920,31 @@ flush_poses(TrackerSlam &t)
 		t.vit.pose_destroy(pose);
 	} while (t.vit.tracker_pop_pose(t.tracker, &pose) == VIT_SUCCESS && pose);
 
+	if (pushed) {
+		xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+		uint64_t rel_ts;
+		t.slam_rels.get_latest(&rel_ts, &rel);
+
+		os_mutex_lock(&t.lock_ff);
+		preinteg_reset(t, rel, (timepoint_ns)rel_ts);
+		os_mutex_unlock(&t.lock_ff);
+	}
+
 	return true;
 }
 
-//! Integrates IMU samples on top of a base pose and predicts from that
+//! Integrates IMU samples on top of a base pose up to @p when_ns and predicts from that
 static void
-predict_pose_from_imu(TrackerSlam &t,
-                      timepoint_ns when_ns,
-                      xrt_space_relation base_rel, // Pose to integrate IMUs on top of
-                      timepoint_ns base_rel_ts,
-                      struct xrt_space_relation *out_relation)
+predict_pose_from_imu_history(TrackerSlam &t,
+                              timepoint_ns when_ns,
+                              xrt_space_relation base_rel, // Pose to integrate IMUs on top of
+                              timepoint_ns base_rel_ts,
+                              struct xrt_space_relation *out_relation)
 {
 	os_mutex_lock(&t.lock_ff);
 
-	// Find oldest imu index i that is newer than latest SLAM pose (or -1)
-	int i = 0;
-	uint64_t imu_ts = UINT64_MAX;
-	xrt_vec3 _;
-	while (m_ff_vec3_f32_get(t.gyro_ff, i, &_, &imu_ts)) {
-		if ((int64_t)imu_ts < base_rel_ts) {
-			i--; // Back to the oldest newer-than-SLAM IMU index (or -1)
-			break;
-		}
-		i++;
-	}
+	// Oldest imu index i that is newer than latest SLAM pose (or -1)
+	int i = count_imu_samples_after(t, base_rel_ts) - 1;
 
 	if (i == -1) {
 		SLAM_WARN("No IMU samples received after latest SLAM pose (and frame)");
@@ -835,11 +952,6 @@ predict_pose_from_imu(TrackerSlam &t,
 
 	xrt_space_relation integ_rel = base_rel;
 	timepoint_ns integ_rel_ts = base_rel_ts;
-	xrt_quat &o = integ_rel.pose.orientation;
-	xrt_vec3 &p = integ_rel.pose.position;
-	xrt_vec3 &w = integ_rel.angular_velocity;
-	xrt_vec3 &v = integ_rel.linear_velocity;
-	bool clamped = false; // If when_ns is older than the latest IMU ts
 
 	while (i >= 0) { // Decreasing i increases timestamp
 		// Get samples
@@ -852,10 +964,9 @@ predict_pose_from_imu(TrackerSlam &t,
 		got &= m_ff_vec3_f32_get(t.accel_ff, i, &a, &a_ts);
 		timepoint_ns ts = g_ts;
 
-
 		// Checks
-		if (ts > when_ns) {
-			clamped = true;
+		bool clamped = ts > when_ns; // If when_ns is older than this IMU ts
+		if (clamped) {
 			//! @todo Instead of using same a and g values, do an interpolated sample like this:
 			// a = prev_a + ((when_ns - prev_ts) / (ts - prev_ts)) * (a - prev_a);
 			// g = prev_g + ((when_ns - prev_ts) / (ts - prev_ts)) * (g - prev_g);
@@ -864,23 +975,7 @@ predict_pose_from_imu(TrackerSlam &t,
 		SLAM_DASSERT(got && g_ts == a_ts, "Failure getting synced gyro and accel samples");
 		SLAM_DASSERT(ts >= base_rel_ts, "Accessing imu sample that is older than latest SLAM pose");
 
-		// Update time
-		float dt = (float)time_ns_to_s(ts - integ_rel_ts);
-		integ_rel_ts = ts;
-
-		// Integrate gyroscope
-		xrt_quat angvel_delta{};
-		xrt_vec3 scaled_half_g = g * dt * 0.5f;
-		math_quat_exp(&scaled_half_g, &angvel_delta); // Same as using math_quat_from_angle_vector(g/dt)
-		math_quat_rotate(&o, &angvel_delta, &o);      // Orientation
-		math_quat_rotate_derivative(&o, &g, &w);      // Angular velocity
-
-		// Integrate accelerometer
-		xrt_vec3 world_accel{};
-		math_quat_rotate_vec3(&o, &a, &world_accel);
-		world_accel += t.gravity_correction;
-		v += world_accel * dt;                        // Linear velocity
-		p += v * dt + world_accel * (dt * dt * 0.5f); // Position
+		integrate_imu_sample(t, integ_rel, integ_rel_ts, g, a, ts);
 
 		if (clamped) {
 			break;
@@ -898,6 +993,47 @@ predict_pose_from_imu(TrackerSlam &t,
 	*out_relation = predicted_relation;
 }
 
+/*!
+ * Predicts from the preintegrated IMU samples, only the time after the last
+ * sample is extrapolated. Falls back to integrating the history when asked
+ * for a time older than the last sample.
+ */
+static void
+predict_pose_from_imu(TrackerSlam &t,
+                      timepoint_ns when_ns,
+                      xrt_space_relation base_rel, // Pose to integrate IMUs on top of
+                      timepoint_ns base_rel_ts,
+                      struct xrt_space_relation *out_relation)
+{
+	os_mutex_lock(&t.lock_ff);
+
+	if (!t.preinteg.valid || t.preinteg.base_ts != base_rel_ts) {
+		preinteg_reset(t, base_rel, base_rel_ts);
+	}
+
+	if (when_ns < t.preinteg.ts) {
+		os_mutex_unlock(&t.lock_ff);
+		predict_pose_from_imu_history(t, when_ns, base_rel, base_rel_ts, out_relation);
+		return;
+	}
+
+	xrt_space_relation integ_rel = t.preinteg.rel;
+	timepoint_ns integ_rel_ts = t.preinteg.ts;
+
+	os_mutex_unlock(&t.lock_ff);
+
+	if (integ_rel_ts == base_rel_ts) {
+		SLAM_WARN("No IMU samples received after latest SLAM pose (and frame)");
+	}
+
+	// Do the prediction based on the updated relation
+	double last_imu_to_now_dt = time_ns_to_s(when_ns - integ_rel_ts);
+	xrt_space_relation predicted_relation{};
+	m_predict_relation(&integ_rel, last_imu_to_now_dt, &predicted_relation);
+
+	*out_relation = predicted_relation;
+}
+
 //! Return our best guess of the relation at time @p when_ns using all the data the tracker has.
 static void
 predict_pose(TrackerSlam &t, timepoint_ns when_ns, struct xrt_space_relation *out_relation)
@@ -1022,6 +1158,35 @@ filter_pose(TrackerSlam &t, timepoint_ns when_ns, struct xrt_space_relation *out
 	}
 }
 
+/*!
+ * Dequeue the new SLAM poses and publish our best guess of the relation at
+ * @p ts, with the velocities derived from the IMU samples up to it, into
+ * @ref TrackerSlam::published_rels. Called from the IMU thread for each sample,
+ * so the filters and prediction state are only ever touched by it.
+ */
+static void
+publish_pose(TrackerSlam &t, timepoint_ns ts)
+{
+	XRT_TRACE_MARKER();
+
+	flush_poses(t);
+
+	xrt_space_relation rel{};
+	predict_pose(t, ts, &rel);
+
+	// Nothing tracked yet
+	if (rel.relation_flags == XRT_SPACE_RELATION_BITMASK_NONE) {
+		return;
+	}
+
+	t.pred_traj_writer->push({ts, rel.pose});
+
+	filter_pose(t, ts, &rel);
+	t.filt_traj_writer->push({ts, rel.pose});
+
+	t.published_rels.push(rel, ts);
+}
+
 static void
 setup_ui(TrackerSlam &t)
 {
@@ -1057,6 +1222,12 @@ setup_ui(TrackerSlam &t)
 	u_var_add_bool(&t, &t.gt.override_tracking, "Track with ground truth (if available)");
 	euroc_recorder_add_ui(t.euroc_recorder, &t, "");
 
+	u_var_add_gui_header(&t, NULL, "Frame Skipping");
+	u_var_add_i32(&t, &t.pre.config.max_skip, "Max frames in a row (0 disables)");
+	u_var_add_f32(&t, &t.pre.config.skip_lag_ms, "Skip when SLAM lags by (ms)");
+	u_var_add_f32(&t, &t.pre.config.skip_static_rad, "Skip when rotated less than (rad)");
+	u_var_add_ro_i32(&t, &t.pre.skipped_count, "Skipped frames");
+
 	u_var_add_gui_header(&t, NULL, "Trajectory Filter");
 	u_var_add_bool(&t, &t.filter.use_moving_average_filter, "Enable moving average filter");
 	u_var_add_f64(&t, &t.filter.window, "Window size (ms)");
@@ -1190,6 +1361,32 @@ add_imu_calibration(const TrackerSlam &t, const t_slam_imu_calibration *imu_cali
 	}
 }
 
+//! Makes the camera calibration describe the images after @ref preprocess_frame.
+static void
+preprocess_calibration(const TrackerSlam &t, t_slam_camera_calibration &calib)
+{
+	const auto &c = t.pre.config;
+	t_camera_calibration &view = calib.base;
+
+	if (c.roi.extent.w > 0 && c.roi.extent.h > 0) {
+		view.intrinsics[0][2] -= c.roi.offset.w;
+		view.intrinsics[1][2] -= c.roi.offset.h;
+		view.image_size_pixels.w = MIN(c.roi.extent.w, view.image_size_pixels.w - c.roi.offset.w);
+		view.image_size_pixels.h = MIN(c.roi.extent.h, view.image_size_pixels.h - c.roi.offset.h);
+	}
+
+	if (c.downscale > 1) {
+		// Pixel centers are at +0.5
+		double scale = 1.0 / c.downscale;
+		view.intrinsics[0][0] *= scale;
+		view.intrinsics[1][1] *= scale;
+		view.intrinsics[0][2] = (view.intrinsics[0][2] + 0.5) * scale - 0.5;
+		view.intrinsics[1][2] = (view.intrinsics[1][2] + 0.5) * scale - 0.5;
+		view.image_size_pixels.w = downscaled_size(t, view.image_size_pixels.w);
+		view.image_size_pixels.h = downscaled_size(t, view.image_size_pixels.h);
+	}
+}
+
 static void
 send_calibration(const TrackerSlam &t, const t_slam_calibration &c)
 {
@@ -1204,7 +1401,9 @@ send_calibration(const TrackerSlam &t, const t_slam_calibration &c)
 	if ((caps & VIT_TRACKER_CAPABILITY_CAMERA_CALIBRATION) != 0) {
 		for (int i = 0; i < c.cam_count; i++) {
 			SLAM_INFO("Sending Camera %d calibration from Monado", i);
-			add_camera_calibration(t, &c.cams[i], i);
+			t_slam_camera_calibration cam_calib = c.cams[i];
+			preprocess_calibration(t, cam_calib);
+			add_camera_calibration(t, &cam_calib, i);
 		}
 	} else {
 		SLAM_WARN("Tracker doesn't support camera calibration");
@@ -1237,24 +1436,16 @@ t_slam_get_tracked_pose(struct xrt_tracked_slam *xts, timepoint_ns when_ns, stru
 
 	auto &t = *container_of(xts, TrackerSlam, base);
 
-	//! @todo This should not be cached, the same timestamp can be requested at a
-	//! later time on the frame for a better prediction.
-	if (when_ns == t.last_ts) {
-		*out_relation = t.last_rel;
-		return;
+	// Lock free, interpolates or extrapolates from the published relations.
+	if (t.pred_type == SLAM_PRED_NONE) {
+		uint64_t latest_ts;
+		if (!t.published_rels.get_latest(&latest_ts, out_relation)) {
+			*out_relation = XRT_SPACE_RELATION_ZERO;
+		}
+	} else {
+		t.published_rels.get(when_ns, out_relation);
 	}
 
-	flush_poses(t);
-
-	predict_pose(t, when_ns, out_relation);
-	t.pred_traj_writer->push({when_ns, out_relation->pose});
-
-	filter_pose(t, when_ns, out_relation);
-	t.filt_traj_writer->push({when_ns, out_relation->pose});
-
-	t.last_rel = *out_relation;
-	t.last_ts = when_ns;
-
 	if (t.gt.override_tracking) {
 		out_relation->pose = gt2xr_pose(t.gt.origin, get_gt_pose_at(*t.gt.trajectory, when_ns));
 	}
@@ -1288,24 +1479,24 @@ t_slam_hand_mask_sink_push(struct xrt_hand_masks_sink *sink, struct xrt_hand_mas
 	t.last_hand_masks = *hand_masks;
 }
 
-//! Receive and send IMU samples to the external SLAM system
-extern "C" void
-t_slam_receive_imu(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
+/*!
+ * Checks and sends one IMU sample to the external SLAM system.
+ *
+ * @return false if the sample was dropped.
+ */
+static bool
+submit_imu_sample(TrackerSlam &t, const xrt_imu_sample &s)
 {
-	XRT_TRACE_MARKER();
-
-	auto &t = *container_of(sink, TrackerSlam, imu_sink);
-
-	timepoint_ns ts = s->timestamp_ns;
-	xrt_vec3_f64 a = s->accel_m_s2;
-	xrt_vec3_f64 w = s->gyro_rad_secs;
+	timepoint_ns ts = s.timestamp_ns;
+	xrt_vec3_f64 a = s.accel_m_s2;
+	xrt_vec3_f64 w = s.gyro_rad_secs;
 
 	timepoint_ns now = (timepoint_ns)os_monotonic_get_ns();
 	SLAM_TRACE("[%ld] imu t=%ld  a=[%f,%f,%f] w=[%f,%f,%f]", now, ts, a.x, a.y, a.z, w.x, w.y, w.z);
 	// Check monotonically increasing timestamps
 	if (ts <= t.last_imu_ts) {
 		SLAM_WARN("Sample (%ld) is older than last (%ld)", ts, t.last_imu_ts);
-		return;
+		return false;
 	}
 	t.last_imu_ts = ts;
 
@@ -1324,14 +1515,211 @@ t_slam_receive_imu(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
 		t.vit.tracker_push_imu_sample(t.tracker, &sample);
 	}
 
-	xrt_sink_push_imu(t.euroc_recorder->imu, s);
+	return true;
+}
 
-	struct xrt_vec3 gyro = {(float)w.x, (float)w.y, (float)w.z};
-	struct xrt_vec3 accel = {(float)a.x, (float)a.y, (float)a.z};
-	os_mutex_lock(&t.lock_ff);
-	m_ff_vec3_f32_push(t.gyro_ff, &gyro, ts);
-	m_ff_vec3_f32_push(t.accel_ff, &accel, ts);
-	os_mutex_unlock(&t.lock_ff);
+//! How many IMU samples of a batch are handled per lock of the filter fifos.
+constexpr uint32_t IMU_BATCH_CHUNK = 32;
+
+/*!
+ * Receive and send IMU samples to the external SLAM system, the filter fifos
+ * and preintegration are updated under one lock per chunk and a single pose is
+ * published for the whole batch.
+ */
+extern "C" void
+t_slam_receive_imu_batch(struct xrt_imu_sink *sink, struct xrt_imu_sample *samples, uint32_t count)
+{
+	XRT_TRACE_MARKER();
+
+	auto &t = *container_of(sink, TrackerSlam, imu_sink);
+
+	xrt_imu_sample accepted[IMU_BATCH_CHUNK];
+	xrt_vec3 gyros[IMU_BATCH_CHUNK];
+	xrt_vec3 accels[IMU_BATCH_CHUNK];
+	uint64_t timestamps[IMU_BATCH_CHUNK];
+	timepoint_ns last_ts = INT64_MIN;
+
+	uint32_t i = 0;
+	while (i < count) {
+		uint32_t n = 0;
+		for (; i < count && n < IMU_BATCH_CHUNK; i++) {
+			if (!submit_imu_sample(t, samples[i])) {
+				continue;
+			}
+
+			const xrt_imu_sample &s = samples[i];
+			accepted[n] = s;
+			gyros[n] = {(float)s.gyro_rad_secs.x, (float)s.gyro_rad_secs.y, (float)s.gyro_rad_secs.z};
+			accels[n] = {(float)s.accel_m_s2.x, (float)s.accel_m_s2.y, (float)s.accel_m_s2.z};
+			timestamps[n] = s.timestamp_ns;
+			n++;
+		}
+
+		if (n == 0) {
+			continue;
+		}
+
+		xrt_sink_push_imu_batch(t.euroc_recorder->imu, accepted, n);
+
+		os_mutex_lock(&t.lock_ff);
+		m_ff_vec3_f32_push_many(t.gyro_ff, gyros, timestamps, n);
+		m_ff_vec3_f32_push_many(t.accel_ff, accels, timestamps, n);
+		for (uint32_t k = 0; k < n; k++) {
+			timepoint_ns ts = accepted[k].timestamp_ns;
+			if (t.preinteg.valid && ts > t.preinteg.ts) {
+				integrate_imu_sample(t, t.preinteg.rel, t.preinteg.ts, gyros[k], accels[k], ts);
+			}
+		}
+		os_mutex_unlock(&t.lock_ff);
+
+		last_ts = accepted[n - 1].timestamp_ns;
+	}
+
+	if (last_ts != INT64_MIN) {
+		publish_pose(t, last_ts);
+	}
+}
+
+//! Receive and send IMU samples to the external SLAM system
+extern "C" void
+t_slam_receive_imu(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
+{
+	t_slam_receive_imu_batch(sink, s, 1);
+}
+
+/*!
+ * Decides on cam0 frames whether to skip the frames of this timestamp, the
+ * other cameras follow that decision.
+ */
+static bool
+should_skip_frame(TrackerSlam &t, timepoint_ns ts, uint32_t cam_index)
+{
+	auto &pre = t.pre;
+
+	if (cam_index != 0) {
+		return ts == pre.skip_ts;
+	}
+
+	bool skip = false;
+	bool can_skip = pre.config.max_skip > 0 && pre.skipped_in_row < pre.config.max_skip;
+
+	// The SLAM system is falling behind
+	xrt_space_relation rel{};
+	uint64_t rel_ts = 0;
+	if (can_skip && pre.config.skip_lag_ms > 0 && t.slam_rels.get_latest(&rel_ts, &rel)) {
+		skip |= time_ns_to_ms_f(ts - (timepoint_ns)rel_ts) > pre.config.skip_lag_ms;
+	}
+
+	// The headset has barely rotated since the last submitted frame
+	if (can_skip && !skip && pre.config.skip_static_rad > 0 && pre.last_submit_ts != INT64_MIN) {
+		xrt_vec3 avg_gyro{};
+		os_mutex_lock(&t.lock_ff);
+		int count = m_ff_vec3_f32_filter(t.gyro_ff, pre.last_submit_ts, ts, &avg_gyro);
+		os_mutex_unlock(&t.lock_ff);
+
+		float angle = m_vec3_len(avg_gyro) * (float)time_ns_to_s(ts - pre.last_submit_ts);
+		skip |= count > 0 && angle < pre.config.skip_static_rad;
+	}
+
+	if (skip) {
+		pre.skip_ts = ts;
+		pre.skipped_in_row++;
+		pre.skipped_count++;
+	} else {
+		pre.skipped_in_row = 0;
+		pre.last_submit_ts = ts;
+	}
+
+	return skip;
+}
+
+//! Size of an image side after downscaling it, like cv::resize or cv::pyrDown does.
+static int
+downscaled_size(const TrackerSlam &t, int size)
+{
+	int factor = t.pre.config.downscale;
+	if (!t.pre.config.pyramid) {
+		return size / factor;
+	}
+
+	for (; factor > 1; factor /= 2) {
+		size = (size + 1) / 2;
+	}
+	return size;
+}
+
+//! Crops and downscales the frame into the sample, the data is valid until the next frame of this camera.
+static bool
+preprocess_frame(TrackerSlam &t, struct xrt_frame *frame, uint32_t cam_index, vit_img_sample &sample)
+{
+	const auto &c = t.pre.config;
+	bool crop = c.roi.extent.w > 0 && c.roi.extent.h > 0;
+	bool downscale = c.downscale > 1;
+
+	if (!crop && !downscale) {
+		sample.data = frame->data;
+		sample.width = frame->width;
+		sample.height = frame->height;
+		sample.stride = frame->stride;
+		sample.size = frame->size;
+		return true;
+	}
+
+	int type = frame->format == XRT_FORMAT_L8 ? CV_8UC1 : CV_8UC3;
+	cv::Mat src(frame->height, frame->width, type, frame->data, frame->stride);
+
+	if (crop) {
+		cv::Rect roi(c.roi.offset.w, c.roi.offset.h, c.roi.extent.w, c.roi.extent.h);
+		roi &= cv::Rect(0, 0, src.cols, src.rows);
+		if (roi.empty()) {
+			SLAM_ERROR("ROI is outside of the %dx%d frames", src.cols, src.rows);
+			return false;
+		}
+		src = src(roi);
+	}
+
+	cv::Mat &dst = t.pre.images[cam_index];
+	if (!downscale) {
+		// Cropping alone can point into the frame
+		dst = src;
+	} else if (c.pyramid) {
+		cv::Mat level = src;
+		for (int factor = c.downscale; factor > 1; factor /= 2) {
+			cv::pyrDown(level, dst);
+			level = dst;
+		}
+	} else {
+		cv::Size size(downscaled_size(t, src.cols), downscaled_size(t, src.rows));
+		cv::resize(src, dst, size, 0, 0, cv::INTER_AREA);
+	}
+
+	sample.data = dst.data;
+	sample.width = dst.cols;
+	sample.height = dst.rows;
+	sample.stride = dst.step;
+	sample.size = dst.step * dst.rows;
+
+	return true;
+}
+
+//! Moves a rectangle from frame to submitted image coordinates.
+static void
+preprocess_mask(const TrackerSlam &t, vit_mask_t &mask)
+{
+	const auto &c = t.pre.config;
+
+	if (c.roi.extent.w > 0 && c.roi.extent.h > 0) {
+		mask.x -= c.roi.offset.w;
+		mask.y -= c.roi.offset.h;
+	}
+
+	if (c.downscale > 1) {
+		float scale = 1.0f / (float)c.downscale;
+		mask.x *= scale;
+		mask.y *= scale;
+		mask.w *= scale;
+		mask.h *= scale;
+	}
 }
 
 //! Push the frame to the external SLAM system
@@ -1347,10 +1735,6 @@ receive_frame(TrackerSlam &t, struct xrt_frame *frame, uint32_t cam_index)
 		return;
 	}
 
-	if (cam_index == t.cam_count - 1) {
-		flush_poses(t); // Useful to flush SLAM poses when no openxr app is open
-	}
-
 	SLAM_DASSERT(t.last_cam_ts[0] != INT64_MIN || cam_index == 0, "First frame was not a cam0 frame");
 
 	// Check monotonically increasing timestamps
@@ -1362,17 +1746,16 @@ receive_frame(TrackerSlam &t, struct xrt_frame *frame, uint32_t cam_index)
 	}
 	last_ts = ts;
 
+	if (should_skip_frame(t, ts, cam_index)) {
+		SLAM_TRACE("Skipping cam%d frame t=%ld", cam_index, ts);
+		return;
+	}
+
 	// Construct and send the image sample
 	vit_img_sample sample = {};
 	sample.cam_index = cam_index;
 	sample.timestamp = ts;
 
-	sample.data = frame->data;
-	sample.width = frame->width;
-	sample.height = frame->height;
-	sample.stride = frame->stride;
-	sample.size = frame->size;
-
 	// TODO check format before
 	switch (frame->format) {
 	case XRT_FORMAT_L8: sample.format = VIT_IMAGE_FORMAT_L8; break;
@@ -1380,6 +1763,10 @@ receive_frame(TrackerSlam &t, struct xrt_frame *frame, uint32_t cam_index)
 	default: SLAM_ERROR("Unknown image format"); return;
 	}
 
+	if (!preprocess_frame(t, frame, cam_index, sample)) {
+		return;
+	}
+
 	xrt_hand_masks_sample hand_masks{};
 	{
 		unique_lock lock(t.last_hand_masks_mutex);
@@ -1398,6 +1785,7 @@ receive_frame(TrackerSlam &t, struct xrt_frame *frame, uint32_t cam_index)
 			mask.y = hand.rect.y;
 			mask.w = hand.rect.w;
 			mask.h = hand.rect.h;
+			preprocess_mask(t, mask);
 			masks.push_back(mask);
 		}
 
@@ -1494,6 +1882,10 @@ t_slam_start(struct xrt_tracked_slam *xts)
 		return -1;
 	}
 
+	if (t.shadow != nullptr && t_slam_start(t.shadow) != 0) {
+		SLAM_WARN("Failed to start shadow SLAM tracker, continuing without it");
+	}
+
 	SLAM_DEBUG("SLAM tracker started");
 	return 0;
 }
@@ -1514,6 +1906,54 @@ t_slam_fill_default_config(struct t_slam_tracker_config *config)
 	config->features_stat = debug_get_bool_option_slam_features_stat();
 	config->cam_count = int(debug_get_num_option_slam_cam_count());
 	config->slam_calib = NULL;
+
+	config->preprocess = {};
+	const char *roi = debug_get_option_slam_roi();
+	if (roi != NULL) {
+		xrt_rect &r = config->preprocess.roi;
+		if (sscanf(roi, "%d,%d,%d,%d", &r.offset.w, &r.offset.h, &r.extent.w, &r.extent.h) != 4) {
+			U_LOG_IFL_W(config->log_level, "Invalid SLAM_ROI='%s', expected 'x,y,width,height'", roi);
+			r = {};
+		}
+	}
+	config->preprocess.downscale = int(debug_get_num_option_slam_downscale());
+	config->preprocess.pyramid = debug_get_bool_option_slam_downscale_pyramid();
+	config->preprocess.max_skip = int(debug_get_num_option_slam_max_skip());
+	config->preprocess.skip_lag_ms = debug_get_float_option_slam_skip_lag_ms();
+	config->preprocess.skip_static_rad = debug_get_float_option_slam_skip_static_rad();
+
+	config->shadow.vit_system_library_path = debug_get_option_slam_shadow_vit_system_library_path();
+	config->shadow.slam_config = debug_get_option_slam_shadow_config();
+	config->shadow.csv_path = debug_get_option_slam_shadow_csv_path();
+}
+
+/*!
+ * Create the shadow tracker of @p t, it gets the same configuration except for
+ * the VIT system, its config and where its CSVs go.
+ */
+static void
+create_shadow(TrackerSlam &t, struct xrt_frame_context *xfctx, const struct t_slam_tracker_config &config)
+{
+	struct t_slam_tracker_config shadow_config = config;
+	shadow_config.vit_system_library_path = config.shadow.vit_system_library_path;
+	shadow_config.slam_config = config.shadow.slam_config;
+	shadow_config.csv_path = config.shadow.csv_path;
+	shadow_config.slam_ui = false;
+	shadow_config.openvr_groundtruth_device = 0; // The groundtruth is fanned out to it instead
+	shadow_config.shadow = {};                   // No shadows of shadows
+
+	struct xrt_slam_sinks *shadow_sinks = nullptr;
+	if (t_slam_create(xfctx, &shadow_config, &t.shadow, &shadow_sinks) != 0) {
+		SLAM_WARN("Failed to create shadow SLAM tracker from '%s'", shadow_config.vit_system_library_path);
+		t.shadow = nullptr;
+		return;
+	}
+
+	// From now on frames reach both trackers by reference.
+	struct xrt_slam_sinks *downstreams[2] = {&t.sinks, shadow_sinks};
+	u_sink_slam_fanout_create(xfctx, downstreams, ARRAY_SIZE(downstreams), &t.fanout_sinks);
+
+	SLAM_INFO("Running '%s' in shadow mode", shadow_config.vit_system_library_path);
 }
 
 extern "C" int
@@ -1569,6 +2009,18 @@ t_slam_create(struct xrt_frame_context *xfctx,
 
 	t.base.get_tracked_pose = t_slam_get_tracked_pose;
 
+	t.pre.config = config->preprocess;
+	t.pre.images = vector<cv::Mat>(config->cam_count);
+	int downscale = t.pre.config.downscale;
+	if (t.pre.config.pyramid && (downscale < 2 || (downscale & (downscale - 1)) != 0)) {
+		SLAM_WARN("Pyramid downscale needs a power of two factor, not %d, using plain downscale", downscale);
+		t.pre.config.pyramid = false;
+	}
+	bool preprocessed = t.pre.config.downscale > 1 || t.pre.config.roi.extent.w > 0;
+	if (config_file && preprocessed) {
+		SLAM_WARN("Frames are cropped or downscaled, make sure '%s' matches the processed images", config_file);
+	}
+
 	if (!config_file) {
 		SLAM_INFO("Using calibration from driver and default pipeline settings");
 		send_calibration(t, *config->slam_calib); // Not null because of `some_calib`
@@ -1584,6 +2036,7 @@ t_slam_create(struct xrt_frame_context *xfctx,
 	}
 
 	t.imu_sink.push_imu = t_slam_receive_imu;
+	t.imu_sink.push_imu_batch = t_slam_receive_imu_batch;
 	t.sinks.imu = &t.imu_sink;
 
 	t.gt_sink.push_pose = t_slam_gt_sink_push;
@@ -1637,8 +2090,12 @@ t_slam_create(struct xrt_frame_context *xfctx,
 	// Get ownership
 	TrackerSlam *tracker = t_ptr.release();
 
+	if (config->shadow.vit_system_library_path != nullptr) {
+		create_shadow(*tracker, xfctx, *config);
+	}
+
 	*out_xts = &tracker->base;
-	*out_sink = &tracker->sinks;
+	*out_sink = tracker->shadow != nullptr ? tracker->fanout_sinks : &tracker->sinks;
 
 	SLAM_DEBUG("SLAM tracker created");
 	return 0;
@@ -546,6 +546,22 @@ t_hsv_filter_create(struct xrt_frame_context *xfctx,
                     struct xrt_frame_sink *sinks[4],
                     struct xrt_frame_sink **out_sink);
 
+//! Max regions of interest per channel, see @ref t_hsv_filter_set_roi.
+#define T_HSV_MAX_ROIS 4
+
+/*!
+ * Hint the filter that only the given regions, in pixels of the full frame,
+ * are of interest for @p channel. Once every channel with a sink has a hint
+ * only those regions are classified, the rest of the output frames is black.
+ * Pass zero regions to get whole frames again, like when the object is lost,
+ * hints that are not refreshed for a few frames expire too. Thread safe.
+ *
+ * @param sink The sink returned by @ref t_hsv_filter_create.
+ * @public @memberof t_hsv_filter
+ */
+void
+t_hsv_filter_set_roi(struct xrt_frame_sink *sink, uint32_t channel, const struct xrt_rect *rois, uint32_t roi_count);
+
 
 /*
  *
@@ -559,6 +575,16 @@ t_hsv_filter_create(struct xrt_frame_context *xfctx,
 int
 t_psmv_start(struct xrt_tracked_psmv *xtmv);
 
+/*!
+ * Send the regions around the blobs the tracker finds to the HSV filter as
+ * ROI hints for @p channel, the channel of the filter that feeds the tracker.
+ *
+ * @param hsv_sink The sink returned by @ref t_hsv_filter_create.
+ * @public @memberof xrt_tracked_psmv
+ */
+void
+t_psmv_set_hsv_filter(struct xrt_tracked_psmv *xtmv, struct xrt_frame_sink *hsv_sink, uint32_t channel);
+
 /*!
  * @public @memberof xrt_tracked_psmv
  */
@@ -661,6 +687,36 @@ struct t_slam_tracker_config
 
 	//!< Instead of a slam_config file you can set custom calibration data
 	const struct t_slam_calibration *slam_calib;
+
+	/*!
+	 * Processing of the camera frames before they are submitted, trades SLAM
+	 * accuracy for a steadier frame rate on slower machines. The calibration
+	 * in @ref slam_calib is adjusted to match, a @ref slam_config file must
+	 * already describe the processed images.
+	 */
+	struct
+	{
+		//! Crop of every camera image applied first, in pixels, a zero extent keeps the whole image
+		struct xrt_rect roi;
+		int downscale;         //!< Integer factor to shrink the images by, 1 or less to keep the size
+		bool pyramid;          //!< Halve the images repeatedly instead, @ref downscale must be a power of two
+		int max_skip;          //!< Most frames in a row that may be skipped, 0 never skips
+		float skip_lag_ms;     //!< Skip when the latest SLAM pose is older than the frame by this, 0 to disable
+		float skip_static_rad; //!< Skip while the rotation since the last submitted frame is below this
+	} preprocess;
+
+	/*!
+	 * A second VIT system that gets the same camera and IMU data, without
+	 * copying the frames, and whose poses are only recorded to its CSVs. For
+	 * evaluating a SLAM system next to the one in use, disabled if
+	 * @ref vit_system_library_path is NULL.
+	 */
+	struct
+	{
+		const char *vit_system_library_path; //!< Path to the VIT system library of the shadow tracker
+		const char *slam_config;             //!< Config file of the shadow tracker, may be NULL
+		const char *csv_path;                //!< Where to write the CSVs of the shadow tracker
+	} shadow;
 };
 
 /*!
@@ -0,0 +1,139 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Simple bump allocator for short lived allocations.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "util/u_arena.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+
+struct u_arena_block
+{
+	struct u_arena_block *next;
+	size_t size;
+	size_t used;
+
+	//! Padding so the data that follows is aligned.
+	size_t padding_;
+};
+
+static_assert(sizeof(struct u_arena_block) % U_ARENA_ALIGNMENT == 0, "Block header breaks alignment");
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static inline size_t
+align_up(size_t size)
+{
+	return (size + U_ARENA_ALIGNMENT - 1) & ~(size_t)(U_ARENA_ALIGNMENT - 1);
+}
+
+static inline uint8_t *
+block_data(struct u_arena_block *block)
+{
+	return (uint8_t *)&block[1];
+}
+
+static struct u_arena_block *
+block_create(size_t size)
+{
+	struct u_arena_block *block = malloc(sizeof(struct u_arena_block) + size);
+	if (block == NULL) {
+		return NULL;
+	}
+
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+
+	return block;
+}
+
+static void
+free_blocks(struct u_arena_block *block)
+{
+	while (block != NULL) {
+		struct u_arena_block *next = block->next;
+		free(block);
+		block = next;
+	}
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+u_arena_init(struct u_arena *arena, size_t block_size)
+{
+	arena->blocks = NULL;
+	arena->block_size = align_up(block_size > 0 ? block_size : U_ARENA_ALIGNMENT);
+}
+
+void *
+u_arena_alloc(struct u_arena *arena, size_t size)
+{
+	size = align_up(size);
+
+	struct u_arena_block *block = arena->blocks;
+	if (block == NULL || block->size - block->used < size) {
+		size_t block_size = size > arena->block_size ? size : arena->block_size;
+
+		struct u_arena_block *new_block = block_create(block_size);
+		if (new_block == NULL) {
+			return NULL;
+		}
+
+		new_block->next = block;
+		arena->blocks = block = new_block;
+	}
+
+	void *ptr = block_data(block) + block->used;
+	block->used += size;
+
+	return ptr;
+}
+
+void
+u_arena_reset(struct u_arena *arena)
+{
+	struct u_arena_block *block = arena->blocks;
+	if (block == NULL) {
+		return;
+	}
+
+	if (block->next == NULL) {
+		block->used = 0;
+		return;
+	}
+
+	// Replace all of the blocks with a single one that fits everything.
+	size_t total = 0;
+	for (struct u_arena_block *b = block; b != NULL; b = b->next) {
+		total += b->size;
+	}
+
+	free_blocks(block);
+
+	arena->blocks = block_create(total);
+}
+
+void
+u_arena_fini(struct u_arena *arena)
+{
+	free_blocks(arena->blocks);
+	arena->blocks = NULL;
+}
@@ -0,0 +1,88 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Simple bump allocator for short lived allocations.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//! Alignment of all allocations from a @ref u_arena.
+#define U_ARENA_ALIGNMENT (16)
+
+struct u_arena_block;
+
+/*!
+ * Bump allocator, memory is only given back all at once with
+ * @ref u_arena_reset. Meant to be reset once per frame or similar, after the
+ * first few resets it no longer allocates any memory itself.
+ *
+ * Not thread safe.
+ *
+ * @ingroup aux_util
+ */
+struct u_arena
+{
+	//! Block being allocated from, followed by older full blocks.
+	struct u_arena_block *blocks;
+
+	//! Minimum size of new blocks.
+	size_t block_size;
+};
+
+/*!
+ * Initialise the arena, no memory is allocated until the first allocation.
+ *
+ * @public @memberof u_arena
+ */
+void
+u_arena_init(struct u_arena *arena, size_t block_size);
+
+/*!
+ * Allocate @p size bytes aligned to @ref U_ARENA_ALIGNMENT, the memory is not
+ * zeroed. Returns NULL if out of memory.
+ *
+ * @public @memberof u_arena
+ */
+void *
+u_arena_alloc(struct u_arena *arena, size_t size);
+
+/*!
+ * Free all allocations at once. If more than one block was needed they are
+ * replaced with one block big enough to hold all of them, so a steady state is
+ * reached where no more blocks are allocated.
+ *
+ * @public @memberof u_arena
+ */
+void
+u_arena_reset(struct u_arena *arena);
+
+/*!
+ * Free all memory of the arena.
+ *
+ * @public @memberof u_arena
+ */
+void
+u_arena_fini(struct u_arena *arena);
+
+/*!
+ * Allocate an array of @p COUNT elements of @p TYPE from the arena.
+ *
+ * @ingroup aux_util
+ */
+#define U_ARENA_ALLOC_ARRAY(ARENA, TYPE, COUNT) ((TYPE *)u_arena_alloc((ARENA), sizeof(TYPE) * (COUNT)))
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -271,6 +271,77 @@ u_config_json_get_remote_settings(struct u_config_json *json, int *out_port, uin
 	return true;
 }
 
+bool
+u_config_json_get_thread_role_settings(struct u_config_json *json,
+                                       enum u_thread_role role,
+                                       struct u_thread_role_settings *inout_settings)
+{
+	if (json->root == NULL) {
+		return false;
+	}
+
+	// Optional node, so don't complain if it's missing.
+	cJSON *threads = cJSON_GetObjectItemCaseSensitive(json->root, "threads");
+	if (threads == NULL) {
+		return false;
+	}
+
+	cJSON *t = cJSON_GetObjectItemCaseSensitive(threads, u_thread_role_to_string(role));
+	if (t == NULL) {
+		return false;
+	}
+
+	struct u_thread_role_settings s = *inout_settings;
+	int tmp = 0;
+
+	if (cJSON_HasObjectItem(t, "realtime")) {
+		get_obj_bool(t, "realtime", &s.realtime);
+	}
+	if (cJSON_HasObjectItem(t, "priority") && get_obj_int(t, "priority", &tmp)) {
+		s.priority = tmp;
+	}
+	if (cJSON_HasObjectItem(t, "nice") && get_obj_int(t, "nice", &tmp)) {
+		s.nice = tmp;
+	}
+	if (cJSON_HasObjectItem(t, "mmcss_task")) {
+		get_obj_str(t, "mmcss_task", s.mmcss_task, sizeof(s.mmcss_task));
+	}
+
+	// List of CPU indices, an empty list means all CPUs.
+	cJSON *cpus = cJSON_GetObjectItemCaseSensitive(t, "cpus");
+	if (cJSON_IsArray(cpus)) {
+		s.cpu_mask = 0;
+
+		cJSON *cpu = NULL;
+		cJSON_ArrayForEach(cpu, cpus)
+		{
+			if (!u_json_get_int(cpu, &tmp) || tmp < 0 || tmp >= 64) {
+				U_LOG_E("Invalid CPU index in 'threads.%s.cpus'!", u_thread_role_to_string(role));
+				continue;
+			}
+			s.cpu_mask |= UINT64_C(1) << tmp;
+		}
+	}
+
+	*inout_settings = s;
+
+	return true;
+}
+
+void
+u_config_json_apply_thread_roles(struct u_config_json *json)
+{
+	for (uint32_t i = 0; i < U_THREAD_ROLE_COUNT; i++) {
+		enum u_thread_role role = (enum u_thread_role)i;
+		struct u_thread_role_settings s;
+
+		u_thread_role_get_settings(role, &s);
+		if (u_config_json_get_thread_role_settings(json, role, &s)) {
+			u_thread_role_set_settings(role, &s);
+		}
+	}
+}
+
 static cJSON *
 open_tracking_settings(struct u_config_json *json)
 {
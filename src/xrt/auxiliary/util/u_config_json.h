@@ -10,6 +10,7 @@
 #pragma once
 
 #include "util/u_json.h"
+#include "util/u_thread_role.h"
 #include "xrt/xrt_settings.h"
 
 #ifdef __cplusplus
@@ -102,6 +103,27 @@ u_config_json_get_tracking_overrides(struct u_config_json *json,
 bool
 u_config_json_get_remote_settings(struct u_config_json *json, int *out_port, uint32_t *out_view_count);
 
+/*!
+ * Read the scheduling settings of a thread role from the "threads" node, any
+ * fields not in the JSON are left as they where in @p inout_settings. Returns
+ * false if there was no entry for the role.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_config_json_get_thread_role_settings(struct u_config_json *json,
+                                       enum u_thread_role role,
+                                       struct u_thread_role_settings *inout_settings);
+
+/*!
+ * Reads the settings of all thread roles from the JSON and sets them with
+ * @ref u_thread_role_set_settings, call before creating any threads.
+ *
+ * @ingroup aux_util
+ */
+void
+u_config_json_apply_thread_roles(struct u_config_json *json);
+
 
 enum u_gui_state_scene
 {
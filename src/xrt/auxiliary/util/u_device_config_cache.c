@@ -0,0 +1,226 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  On disk cache for configuration blobs read from devices.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include "util/u_file.h"
+#include "util/u_misc.h"
+#include "util/u_debug.h"
+#include "util/u_logging.h"
+#include "util/u_device_config_cache.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef XRT_OS_LINUX
+#include <unistd.h>
+#include <linux/limits.h>
+#endif
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(device_config_cache, "XRT_DEVICE_CONFIG_CACHE", true)
+
+//! "MDCC" in little endian.
+#define CACHE_MAGIC 0x4343444dU
+
+//! Bumped whenever the layout of the file changes.
+#define CACHE_VERSION 1
+
+//! Nothing a device hands us should be bigger than this.
+#define CACHE_MAX_SIZE (16 * 1024 * 1024)
+
+/*!
+ * Placed at the start of every cache file.
+ */
+struct cache_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t checksum;
+	uint64_t size;
+
+	//! Hash of the data, catches files that got corrupted on disk.
+	uint64_t data_hash;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+#ifdef XRT_OS_LINUX
+static bool
+get_file_name(const char *name, const char *serial, const char *suffix, char *out_str, size_t out_size)
+{
+	char safe_serial[64] = {0};
+	if (serial != NULL) {
+		size_t len = strnlen(serial, sizeof(safe_serial) - 1);
+		for (size_t i = 0; i < len; i++) {
+			safe_serial[i] = isalnum((unsigned char)serial[i]) ? serial[i] : '_';
+		}
+	}
+
+	int ret = snprintf(out_str, out_size, "device-config-%s%s%s%s", name, serial != NULL ? "-" : "", safe_serial,
+	                   suffix);
+	return ret > 0 && ret < (int)out_size;
+}
+
+static bool
+get_file_path(const char *name, const char *serial, const char *suffix, char *out_str, size_t out_size)
+{
+	char file_name[192];
+	if (!get_file_name(name, serial, suffix, file_name, sizeof(file_name))) {
+		return false;
+	}
+
+	ssize_t ret = u_file_get_path_in_cache_dir(file_name, out_str, out_size);
+	return ret > 0 && ret < (ssize_t)out_size;
+}
+#endif
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+bool
+u_device_config_cache_enabled(void)
+{
+#ifdef XRT_OS_LINUX
+	return debug_get_bool_option_device_config_cache();
+#else
+	return false;
+#endif
+}
+
+uint64_t
+u_device_config_cache_hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+bool
+u_device_config_cache_load(
+    const char *name, const char *serial, uint64_t checksum, uint8_t **out_data, size_t *out_size)
+{
+#ifdef XRT_OS_LINUX
+	char path[PATH_MAX];
+	if (!u_device_config_cache_enabled() || !get_file_path(name, serial, "", path, sizeof(path))) {
+		return false;
+	}
+
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	struct cache_header header = {0};
+	if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != CACHE_MAGIC ||
+	    header.version != CACHE_VERSION || header.size > CACHE_MAX_SIZE) {
+		U_LOG_W("Ignoring invalid device config cache file '%s'", path);
+		fclose(file);
+		return false;
+	}
+
+	if (header.checksum != checksum) {
+		U_LOG_D("Device config cache '%s' is stale", path);
+		fclose(file);
+		return false;
+	}
+
+	uint8_t *data = U_TYPED_ARRAY_CALLOC(uint8_t, header.size + 1);
+	bool read = fread(data, 1, header.size, file) == header.size;
+	fclose(file);
+
+	if (!read ||
+	    u_device_config_cache_hash_bytes(U_DEVICE_CONFIG_CACHE_HASH_INIT, data, header.size) != header.data_hash) {
+		U_LOG_W("Ignoring corrupt device config cache file '%s'", path);
+		free(data);
+		return false;
+	}
+
+	U_LOG_D("Loaded device config cache '%s'", path);
+
+	*out_data = data;
+	*out_size = header.size;
+
+	return true;
+#else
+	(void)name;
+	(void)serial;
+	(void)checksum;
+	(void)out_data;
+	(void)out_size;
+	return false;
+#endif
+}
+
+bool
+u_device_config_cache_store(
+    const char *name, const char *serial, uint64_t checksum, const void *data, size_t size)
+{
+#ifdef XRT_OS_LINUX
+	char tmp_name[192];
+	char tmp_path[PATH_MAX];
+	char path[PATH_MAX];
+	if (!u_device_config_cache_enabled() || size > CACHE_MAX_SIZE ||
+	    !get_file_name(name, serial, ".tmp", tmp_name, sizeof(tmp_name)) ||
+	    !get_file_path(name, serial, ".tmp", tmp_path, sizeof(tmp_path)) ||
+	    !get_file_path(name, serial, "", path, sizeof(path))) {
+		return false;
+	}
+
+	FILE *file = u_file_open_file_in_cache_dir(tmp_name, "wb");
+	if (file == NULL) {
+		U_LOG_W("Failed to open device config cache file '%s'", tmp_path);
+		return false;
+	}
+
+	struct cache_header header = {
+	    .magic = CACHE_MAGIC,
+	    .version = CACHE_VERSION,
+	    .checksum = checksum,
+	    .size = size,
+	    .data_hash = u_device_config_cache_hash_bytes(U_DEVICE_CONFIG_CACHE_HASH_INIT, data, size),
+	};
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(data, 1, size, file) == size;
+	bool closed = fclose(file) == 0;
+
+	if (!written || !closed || rename(tmp_path, path) != 0) {
+		U_LOG_W("Failed to write device config cache file '%s'", path);
+		unlink(tmp_path);
+		return false;
+	}
+
+	U_LOG_D("Stored device config cache '%s'", path);
+
+	return true;
+#else
+	(void)name;
+	(void)serial;
+	(void)checksum;
+	(void)data;
+	(void)size;
+	return false;
+#endif
+}
@@ -0,0 +1,83 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  On disk cache for configuration blobs read from devices.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Starting value for @ref u_device_config_cache_hash_bytes.
+ *
+ * @ingroup aux_util
+ */
+#define U_DEVICE_CONFIG_CACHE_HASH_INIT 0xcbf29ce484222325ULL
+
+/*!
+ * Is the cache enabled, controlled with the `XRT_DEVICE_CONFIG_CACHE`
+ * environment variable, always false on platforms without support.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_device_config_cache_enabled(void);
+
+/*!
+ * Add @p size bytes to the running (FNV-1a) hash @p hash, for building the
+ * checksum passed to the functions below.
+ *
+ * @ingroup aux_util
+ */
+uint64_t
+u_device_config_cache_hash_bytes(uint64_t hash, const void *data, size_t size);
+
+/*!
+ * Load a cached config blob, there is one entry per @p name and @p serial.
+ *
+ * The @p checksum is whatever the driver can read from the device cheaply
+ * that changes when the blob does, a block header or the firmware version,
+ * the entry is only used if it was stored with the same value. The returned
+ * data has a zero byte after @p out_size, so text can be used directly, free
+ * it with free().
+ *
+ * @param name     Name of the blob, like "wmr-config", must be file name safe.
+ * @param serial   Serial of the device, may be NULL if the checksum alone
+ *                 identifies the blob.
+ * @param checksum Value to validate the entry with.
+ * @param out_data Returned data.
+ * @param out_size Size of the returned data.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_device_config_cache_load(
+    const char *name, const char *serial, uint64_t checksum, uint8_t **out_data, size_t *out_size);
+
+/*!
+ * Store a config blob in the cache, replacing any older entry for @p name and
+ * @p serial. Written under a temporary name and then renamed so a concurrent
+ * or crashed writer never leaves a partial entry.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_device_config_cache_store(
+    const char *name, const char *serial, uint64_t checksum, const void *data, size_t size);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,244 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  On disk cache for computed distortion data.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_distortion
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include "util/u_file.h"
+#include "util/u_debug.h"
+#include "util/u_logging.h"
+#include "util/u_distortion_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef XRT_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <linux/limits.h>
+#endif
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(distortion_cache, "XRT_DISTORTION_CACHE", true)
+
+//! "MDCF" in little endian.
+#define CACHE_MAGIC 0x4643444dU
+
+//! How many points per axis the distortion function is probed at.
+#define PROBE_COUNT 5
+
+/*!
+ * Placed at the start of every cache file.
+ */
+struct cache_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint64_t size;
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+#ifdef XRT_OS_LINUX
+static bool
+get_file_name(const char *name, uint64_t key, const char *suffix, char *out_str, size_t out_size)
+{
+	int ret = snprintf(out_str, out_size, "distortion-%s-%016llx%s", name, (unsigned long long)key, suffix);
+	return ret > 0 && ret < (int)out_size;
+}
+
+static bool
+get_file_path(const char *name, uint64_t key, const char *suffix, char *out_str, size_t out_size)
+{
+	char file_name[128];
+	if (!get_file_name(name, key, suffix, file_name, sizeof(file_name))) {
+		return false;
+	}
+
+	ssize_t ret = u_file_get_path_in_cache_dir(file_name, out_str, out_size);
+	return ret > 0 && ret < (ssize_t)out_size;
+}
+#endif
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+bool
+u_distortion_cache_enabled(void)
+{
+#ifdef XRT_OS_LINUX
+	return debug_get_bool_option_distortion_cache();
+#else
+	return false;
+#endif
+}
+
+uint64_t
+u_distortion_cache_hash_bytes(uint64_t hash, const void *data, size_t size)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+uint64_t
+u_distortion_cache_hash_device(uint64_t hash, struct xrt_device *xdev)
+{
+	const struct xrt_hmd_parts *hmd = xdev->hmd;
+	uint32_t version = U_DISTORTION_CACHE_VERSION;
+
+	hash = u_distortion_cache_hash_bytes(hash, &version, sizeof(version));
+	hash = u_distortion_cache_hash_bytes(hash, xdev->str, strnlen(xdev->str, sizeof(xdev->str)));
+	hash = u_distortion_cache_hash_bytes(hash, xdev->serial, strnlen(xdev->serial, sizeof(xdev->serial)));
+	hash = u_distortion_cache_hash_bytes(hash, &hmd->view_count, sizeof(hmd->view_count));
+
+	for (uint32_t view = 0; view < hmd->view_count; view++) {
+		const struct xrt_view *xview = &hmd->views[view];
+		const struct xrt_fov *fov = &hmd->distortion.fov[view];
+
+		hash = u_distortion_cache_hash_bytes(hash, &xview->display, sizeof(xview->display));
+		hash = u_distortion_cache_hash_bytes(hash, &xview->rot, sizeof(xview->rot));
+		hash = u_distortion_cache_hash_bytes(hash, fov, sizeof(*fov));
+
+		if (xdev->compute_distortion == NULL) {
+			continue;
+		}
+
+		for (uint32_t y = 0; y < PROBE_COUNT; y++) {
+			float v = (float)y / (float)(PROBE_COUNT - 1);
+
+			for (uint32_t x = 0; x < PROBE_COUNT; x++) {
+				float u = (float)x / (float)(PROBE_COUNT - 1);
+
+				struct xrt_uv_triplet result = {0};
+				xrt_device_compute_distortion(xdev, view, u, v, &result);
+				hash = u_distortion_cache_hash_bytes(hash, &result, sizeof(result));
+			}
+		}
+	}
+
+	return hash;
+}
+
+bool
+u_distortion_cache_load(const char *name, uint64_t key, void *out_data, size_t size)
+{
+#ifdef XRT_OS_LINUX
+	char path[PATH_MAX];
+	if (!u_distortion_cache_enabled() || !get_file_path(name, key, "", path, sizeof(path))) {
+		return false;
+	}
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+
+	size_t total_size = sizeof(struct cache_header) + size;
+
+	struct stat st = {0};
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size != total_size) {
+		close(fd);
+		return false;
+	}
+
+	void *map = mmap(NULL, total_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		return false;
+	}
+
+	const struct cache_header *header = (const struct cache_header *)map;
+	bool valid = header->magic == CACHE_MAGIC && header->version == U_DISTORTION_CACHE_VERSION &&
+	             header->key == key && header->size == size;
+	if (valid) {
+		memcpy(out_data, header + 1, size);
+	}
+
+	munmap(map, total_size);
+
+	if (!valid) {
+		U_LOG_W("Ignoring invalid distortion cache file '%s'", path);
+		return false;
+	}
+
+	U_LOG_D("Loaded distortion cache '%s'", path);
+
+	return true;
+#else
+	(void)name;
+	(void)key;
+	(void)out_data;
+	(void)size;
+	return false;
+#endif
+}
+
+bool
+u_distortion_cache_store(const char *name, uint64_t key, const void *data, size_t size)
+{
+#ifdef XRT_OS_LINUX
+	char tmp_name[128];
+	char tmp_path[PATH_MAX];
+	char path[PATH_MAX];
+	if (!u_distortion_cache_enabled() || !get_file_name(name, key, ".tmp", tmp_name, sizeof(tmp_name)) ||
+	    !get_file_path(name, key, ".tmp", tmp_path, sizeof(tmp_path)) ||
+	    !get_file_path(name, key, "", path, sizeof(path))) {
+		return false;
+	}
+
+	FILE *file = u_file_open_file_in_cache_dir(tmp_name, "wb");
+	if (file == NULL) {
+		U_LOG_W("Failed to open distortion cache file '%s'", tmp_path);
+		return false;
+	}
+
+	struct cache_header header = {
+	    .magic = CACHE_MAGIC,
+	    .version = U_DISTORTION_CACHE_VERSION,
+	    .key = key,
+	    .size = size,
+	};
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(data, size, 1, file) == 1;
+	bool closed = fclose(file) == 0;
+
+	if (!written || !closed || rename(tmp_path, path) != 0) {
+		U_LOG_W("Failed to write distortion cache file '%s'", path);
+		unlink(tmp_path);
+		return false;
+	}
+
+	U_LOG_D("Stored distortion cache '%s'", path);
+
+	return true;
+#else
+	(void)name;
+	(void)key;
+	(void)data;
+	(void)size;
+	return false;
+#endif
+}
@@ -0,0 +1,87 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  On disk cache for computed distortion data.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_distortion
+ */
+
+#pragma once
+
+#include "xrt/xrt_device.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Bumped whenever the layout of any cached data changes, part of every key.
+ *
+ * @ingroup aux_distortion
+ */
+#define U_DISTORTION_CACHE_VERSION 1
+
+/*!
+ * Starting value for the hash functions below.
+ *
+ * @ingroup aux_distortion
+ */
+#define U_DISTORTION_CACHE_HASH_INIT 0xcbf29ce484222325ULL
+
+/*!
+ * Is the cache enabled, controlled with the `XRT_DISTORTION_CACHE`
+ * environment variable, always false on platforms without support.
+ *
+ * @ingroup aux_distortion
+ */
+bool
+u_distortion_cache_enabled(void);
+
+/*!
+ * Add @p size bytes to the running (FNV-1a) hash @p hash.
+ *
+ * @ingroup aux_distortion
+ */
+uint64_t
+u_distortion_cache_hash_bytes(uint64_t hash, const void *data, size_t size);
+
+/*!
+ * Add the parts of the device that affect the distortion to @p hash: names,
+ * view sizes, rotations, fovs. The distortion function is opaque, so it is
+ * evaluated on a small grid of points for each view, this catches changed
+ * calibration data at a fraction of the cost of filling in a whole mesh.
+ *
+ * @ingroup aux_distortion
+ */
+uint64_t
+u_distortion_cache_hash_device(uint64_t hash, struct xrt_device *xdev);
+
+/*!
+ * Load cached data, the file is mapped and copied into @p out_data. Returns
+ * false if there is no entry for @p key or if its size doesn't match.
+ *
+ * @ingroup aux_distortion
+ */
+bool
+u_distortion_cache_load(const char *name, uint64_t key, void *out_data, size_t size);
+
+/*!
+ * Store data in the cache, the file is written under a temporary name and then
+ * renamed so a concurrent or crashed writer never leaves a partial entry.
+ *
+ * @ingroup aux_distortion
+ */
+bool
+u_distortion_cache_store(const char *name, uint64_t key, const void *data, size_t size);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -13,18 +13,27 @@
 #include "util/u_debug.h"
 #include "util/u_format.h"
 #include "util/u_distortion_mesh.h"
+#include "util/u_distortion_cache.h"
 
 #include "math/m_vec2.h"
 #include "math/m_api.h"
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 
 
 DEBUG_GET_ONCE_NUM_OPTION(mesh_size, "XRT_MESH_SIZE", 64)
 
 
+//! Number of uv pairs per vertex, one for each colour channel.
+#define UV_CHANNELS_COUNT 3
+
+//! Position followed by the uv pairs.
+#define STRIDE_IN_FLOATS (2 + UV_CHANNELS_COUNT * 2)
+
+
 typedef bool (*func_calc)(struct xrt_device *xdev, uint32_t view, float u, float v, struct xrt_uv_triplet *result);
 
 static int
@@ -33,35 +42,28 @@ index_for(int row, int col, uint32_t stride, uint32_t offset)
 	return row * stride + col + offset;
 }
 
-static void
-run_func(struct xrt_device *xdev, func_calc calc, struct xrt_hmd_parts *target, uint32_t num)
+static uint32_t
+get_vertex_float_count(uint32_t view_count, uint32_t num)
 {
-	assert(calc != NULL);
+	uint32_t vert_cols = num + 1;
+	uint32_t vert_rows = num + 1;
 
-	uint32_t view_count = target->view_count;
+	return vert_rows * vert_cols * view_count * STRIDE_IN_FLOATS;
+}
 
-	uint32_t vertex_offsets[XRT_MAX_VIEWS] = {0};
-	uint32_t index_offsets[XRT_MAX_VIEWS] = {0};
+static bool
+fill_in_vertices(struct xrt_device *xdev, func_calc calc, uint32_t view_count, uint32_t num, float *verts)
+{
+	assert(calc != NULL);
 
 	uint32_t cells_cols = num;
 	uint32_t cells_rows = num;
 	uint32_t vert_cols = cells_cols + 1;
 	uint32_t vert_rows = cells_rows + 1;
 
-	uint32_t vertex_count_per_view = vert_rows * vert_cols;
-	uint32_t vertex_count = vertex_count_per_view * view_count;
-
-	uint32_t uv_channels_count = 3;
-	uint32_t stride_in_floats = 2 + uv_channels_count * 2;
-	uint32_t float_count = vertex_count * stride_in_floats;
-
-	float *verts = U_TYPED_ARRAY_CALLOC(float, float_count);
-
 	// Setup the vertices for all views.
 	uint32_t i = 0;
 	for (uint32_t view = 0; view < view_count; view++) {
-		vertex_offsets[view] = i / stride_in_floats;
-
 		for (uint32_t r = 0; r < vert_rows; r++) {
 			// This goes from 0 to 1.0 inclusive.
 			float v = (float)r / (float)cells_rows;
@@ -75,22 +77,47 @@ run_func(struct xrt_device *xdev, func_calc calc, struct xrt_hmd_parts *target,
 				verts[i + 1] = v * 2.0f - 1.0f;
 
 				if (!calc(xdev, view, u, v, (struct xrt_uv_triplet *)&verts[i + 2])) {
-					// bail on error, without updating
-					// distortion.preferred
-					return;
+					return false;
 				}
 
-				i += stride_in_floats;
+				i += STRIDE_IN_FLOATS;
 			}
 		}
 	}
 
+	return true;
+}
+
+/*!
+ * Takes ownership of @p verts, which has been filled in by
+ * @ref fill_in_vertices or loaded from the cache.
+ */
+static void
+set_mesh(struct xrt_hmd_parts *target, uint32_t num, float *verts)
+{
+	uint32_t view_count = target->view_count;
+
+	uint32_t vertex_offsets[XRT_MAX_VIEWS] = {0};
+	uint32_t index_offsets[XRT_MAX_VIEWS] = {0};
+
+	uint32_t cells_cols = num;
+	uint32_t cells_rows = num;
+	uint32_t vert_cols = cells_cols + 1;
+	uint32_t vert_rows = cells_rows + 1;
+
+	uint32_t vertex_count_per_view = vert_rows * vert_cols;
+	uint32_t vertex_count = vertex_count_per_view * view_count;
+
+	for (uint32_t view = 0; view < view_count; view++) {
+		vertex_offsets[view] = vertex_count_per_view * view;
+	}
+
 	uint32_t index_count_per_view = cells_rows * (vert_cols * 2 + 2);
 	uint32_t index_count_total = index_count_per_view * view_count;
 	int *indices = U_TYPED_ARRAY_CALLOC(int, index_count_total);
 
 	// Set up indices for all views.
-	i = 0;
+	uint32_t i = 0;
 	for (uint32_t view = 0; view < view_count; view++) {
 		index_offsets[view] = i;
 
@@ -113,9 +140,9 @@ run_func(struct xrt_device *xdev, func_calc calc, struct xrt_hmd_parts *target,
 
 	target->distortion.models |= XRT_DISTORTION_MODEL_MESHUV;
 	target->distortion.mesh.vertices = verts;
-	target->distortion.mesh.stride = stride_in_floats * sizeof(float);
+	target->distortion.mesh.stride = STRIDE_IN_FLOATS * sizeof(float);
 	target->distortion.mesh.vertex_count = vertex_count;
-	target->distortion.mesh.uv_channels_count = uv_channels_count;
+	target->distortion.mesh.uv_channels_count = UV_CHANNELS_COUNT;
 	target->distortion.mesh.indices = indices;
 	target->distortion.mesh.index_count_total = index_count_total;
 	for (uint32_t view = 0; view < view_count; ++view) {
@@ -124,6 +151,52 @@ run_func(struct xrt_device *xdev, func_calc calc, struct xrt_hmd_parts *target,
 	}
 }
 
+static void
+run_func(struct xrt_device *xdev, func_calc calc, struct xrt_hmd_parts *target, uint32_t num)
+{
+	uint32_t float_count = get_vertex_float_count(target->view_count, num);
+	float *verts = U_TYPED_ARRAY_CALLOC(float, float_count);
+
+	if (!fill_in_vertices(xdev, calc, target->view_count, num, verts)) {
+		// bail on error, without updating distortion.preferred
+		free(verts);
+		return;
+	}
+
+	set_mesh(target, num, verts);
+}
+
+/*!
+ * Same as @ref run_func but goes through the on disk cache, the indices are
+ * cheap to generate so only the vertices are cached.
+ */
+static void
+run_func_cached(struct xrt_device *xdev, func_calc calc, struct xrt_hmd_parts *target, uint32_t num)
+{
+	uint64_t key = U_DISTORTION_CACHE_HASH_INIT;
+	key = u_distortion_cache_hash_device(key, xdev);
+	key = u_distortion_cache_hash_bytes(key, &num, sizeof(num));
+
+	uint32_t float_count = get_vertex_float_count(target->view_count, num);
+	size_t size = float_count * sizeof(float);
+	float *verts = U_TYPED_ARRAY_CALLOC(float, float_count);
+
+	if (u_distortion_cache_load("mesh", key, verts, size)) {
+		set_mesh(target, num, verts);
+		return;
+	}
+
+	if (!fill_in_vertices(xdev, calc, target->view_count, num, verts)) {
+		// bail on error, without updating distortion.preferred
+		free(verts);
+		return;
+	}
+
+	u_distortion_cache_store("mesh", key, verts, size);
+
+	set_mesh(target, num, verts);
+}
+
 bool
 u_compute_distortion_vive(struct u_vive_values *values, float u, float v, struct xrt_uv_triplet *result)
 {
@@ -483,5 +556,9 @@ u_distortion_mesh_fill_in_compute(struct xrt_device *xdev)
 
 	uint32_t num = (uint32_t)debug_get_num_option_mesh_size();
 
-	run_func(xdev, calc, target, num);
+	if (u_distortion_cache_enabled()) {
+		run_func_cached(xdev, calc, target, num);
+	} else {
+		run_func(xdev, calc, target, num);
+	}
 }
@@ -37,6 +37,15 @@ u_file_get_hand_tracking_models_dir(char *out_path, size_t out_path_size);
 ssize_t
 u_file_get_runtime_dir(char *out_path, size_t out_path_size);
 
+ssize_t
+u_file_get_cache_dir(char *out_path, size_t out_path_size);
+
+ssize_t
+u_file_get_path_in_cache_dir(const char *suffix, char *out_path, size_t out_path_size);
+
+FILE *
+u_file_open_file_in_cache_dir(const char *filename, const char *mode);
+
 char *
 u_file_read_content(FILE *file);
 
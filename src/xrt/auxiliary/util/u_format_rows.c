@@ -0,0 +1,724 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Row conversion kernels between pixel formats, with SIMD versions.
+ *
+ * The YUV to RGB conversion is done with integers using the BT.601 limited
+ * range coefficients scaled by 256, the SIMD versions use the same integer
+ * math so they give bit exact results compared to the plain C code.
+ *
+ * On x86 the SSE4.1 functions are built with the target attribute and selected
+ * if the CPU supports them, on AArch64 NEON is always available.
+ *
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "util/u_debug.h"
+#include "util/u_logging.h"
+#include "util/u_format_rows.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define U_FORMAT_ROWS_SSE41
+#include <immintrin.h>
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define U_FORMAT_ROWS_NEON
+#include <arm_neon.h>
+#endif
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(no_simd, "XRT_FORMAT_ROWS_NO_SIMD", false)
+
+
+/*
+ *
+ * Scalar functions.
+ *
+ */
+
+static inline int
+clamp_to_byte(int v)
+{
+	if (v < 0) {
+		return 0;
+	}
+	if (v >= 255) {
+		return 255;
+	}
+	return v;
+}
+
+static inline void
+YUV444_to_R8G8B8(int y, int u, int v, uint8_t *dst)
+{
+	int C = y - 16;
+	int D = u - 128;
+	int E = v - 128;
+
+	dst[0] = (uint8_t)clamp_to_byte((298 * C + 409 * E + 128) >> 8);
+	dst[1] = (uint8_t)clamp_to_byte((298 * C - 100 * D - 209 * E + 128) >> 8);
+	dst[2] = (uint8_t)clamp_to_byte((298 * C + 516 * D + 128) >> 8);
+}
+
+static void
+scalar_L8_to_R8G8B8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x++) {
+		dst[x * 3 + 2] = dst[x * 3 + 1] = dst[x * 3 + 0] = src[x];
+	}
+}
+
+static void
+scalar_YUYV422_to_L8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x++) {
+		dst[x] = src[x * 2];
+	}
+}
+
+static void
+scalar_YUYV422_to_R8G8B8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x += 2) {
+		const uint8_t *s = src + x * 2;
+		YUV444_to_R8G8B8(s[0], s[1], s[3], dst + x * 3);
+		YUV444_to_R8G8B8(s[2], s[1], s[3], dst + x * 3 + 3);
+	}
+}
+
+static void
+scalar_UYVY422_to_R8G8B8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x += 2) {
+		const uint8_t *s = src + x * 2;
+		YUV444_to_R8G8B8(s[1], s[0], s[2], dst + x * 3);
+		YUV444_to_R8G8B8(s[3], s[0], s[2], dst + x * 3 + 3);
+	}
+}
+
+static void
+scalar_YUV888_to_R8G8B8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x++) {
+		const uint8_t *s = src + x * 3;
+		YUV444_to_R8G8B8(s[0], s[1], s[2], dst + x * 3);
+	}
+}
+
+static void
+scalar_L8_INTERLEAVED_to_L8_SBS(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	uint32_t half_w = width / 2;
+	for (uint32_t x = 0; x < half_w; x++) {
+		dst[x] = src[x * 2];
+		dst[x + half_w] = src[x * 2 + 1];
+	}
+}
+
+//! BT.601 luma with weights that sum to 256.
+static inline uint8_t
+R8G8B8_to_L8(int r, int g, int b)
+{
+	return (uint8_t)((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+static void
+scalar_BAYER_GR8_to_R8G8B8(uint8_t *dst, const uint8_t *src0, const uint8_t *src1, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x++) {
+		// G R
+		// B G
+		dst[x * 3 + 0] = src0[x * 2 + 1];
+		dst[x * 3 + 1] = (uint8_t)((src0[x * 2] + src1[x * 2 + 1]) / 2);
+		dst[x * 3 + 2] = src1[x * 2];
+	}
+}
+
+static void
+scalar_BAYER_GR8_to_L8(uint8_t *dst, const uint8_t *src0, const uint8_t *src1, uint32_t width)
+{
+	for (uint32_t x = 0; x < width; x++) {
+		int r = src0[x * 2 + 1];
+		int g = (src0[x * 2] + src1[x * 2 + 1]) / 2;
+		int b = src1[x * 2];
+		dst[x] = R8G8B8_to_L8(r, g, b);
+	}
+}
+
+static const struct u_format_row_funcs scalar_funcs = {
+    .name = "scalar",
+    .L8_to_R8G8B8 = scalar_L8_to_R8G8B8,
+    .YUYV422_to_L8 = scalar_YUYV422_to_L8,
+    .YUYV422_to_R8G8B8 = scalar_YUYV422_to_R8G8B8,
+    .UYVY422_to_R8G8B8 = scalar_UYVY422_to_R8G8B8,
+    .YUV888_to_R8G8B8 = scalar_YUV888_to_R8G8B8,
+    .L8_INTERLEAVED_to_L8_SBS = scalar_L8_INTERLEAVED_to_L8_SBS,
+    .BAYER_GR8_to_R8G8B8 = scalar_BAYER_GR8_to_R8G8B8,
+    .BAYER_GR8_to_L8 = scalar_BAYER_GR8_to_L8,
+};
+
+
+/*
+ *
+ * SSE4.1 functions, 16 pixels at a time.
+ *
+ */
+
+#ifdef U_FORMAT_ROWS_SSE41
+
+#define Z (-128)
+
+//! Interleave 16 pixels worth of planes into 48 bytes of RGB.
+TARGET_SSE41 static inline void
+sse41_store_rgb(uint8_t *dst, __m128i r, __m128i g, __m128i b)
+{
+	const __m128i r0 = _mm_setr_epi8(0, Z, Z, 1, Z, Z, 2, Z, Z, 3, Z, Z, 4, Z, Z, 5);
+	const __m128i g0 = _mm_setr_epi8(Z, 0, Z, Z, 1, Z, Z, 2, Z, Z, 3, Z, Z, 4, Z, Z);
+	const __m128i b0 = _mm_setr_epi8(Z, Z, 0, Z, Z, 1, Z, Z, 2, Z, Z, 3, Z, Z, 4, Z);
+	const __m128i r1 = _mm_setr_epi8(Z, Z, 6, Z, Z, 7, Z, Z, 8, Z, Z, 9, Z, Z, 10, Z);
+	const __m128i g1 = _mm_setr_epi8(5, Z, Z, 6, Z, Z, 7, Z, Z, 8, Z, Z, 9, Z, Z, 10);
+	const __m128i b1 = _mm_setr_epi8(Z, 5, Z, Z, 6, Z, Z, 7, Z, Z, 8, Z, Z, 9, Z, Z);
+	const __m128i r2 = _mm_setr_epi8(Z, 11, Z, Z, 12, Z, Z, 13, Z, Z, 14, Z, Z, 15, Z, Z);
+	const __m128i g2 = _mm_setr_epi8(Z, Z, 11, Z, Z, 12, Z, Z, 13, Z, Z, 14, Z, Z, 15, Z);
+	const __m128i b2 = _mm_setr_epi8(10, Z, Z, 11, Z, Z, 12, Z, Z, 13, Z, Z, 14, Z, Z, 15);
+
+	__m128i out0 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r0), _mm_shuffle_epi8(g, g0)), //
+	                            _mm_shuffle_epi8(b, b0));
+	__m128i out1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r1), _mm_shuffle_epi8(g, g1)), //
+	                            _mm_shuffle_epi8(b, b1));
+	__m128i out2 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(r, r2), _mm_shuffle_epi8(g, g2)), //
+	                            _mm_shuffle_epi8(b, b2));
+
+	_mm_storeu_si128((__m128i *)(dst + 0), out0);
+	_mm_storeu_si128((__m128i *)(dst + 16), out1);
+	_mm_storeu_si128((__m128i *)(dst + 32), out2);
+}
+
+//! Split 48 bytes of packed three channel pixels into three planes.
+TARGET_SSE41 static inline void
+sse41_load_planes(const uint8_t *src, __m128i *out_a, __m128i *out_b, __m128i *out_c)
+{
+	const __m128i a0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z);
+	const __m128i a1 = _mm_setr_epi8(Z, Z, Z, Z, Z, Z, 2, 5, 8, 11, 14, Z, Z, Z, Z, Z);
+	const __m128i a2 = _mm_setr_epi8(Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, 1, 4, 7, 10, 13);
+	const __m128i b0 = _mm_setr_epi8(1, 4, 7, 10, 13, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z);
+	const __m128i b1 = _mm_setr_epi8(Z, Z, Z, Z, Z, 0, 3, 6, 9, 12, 15, Z, Z, Z, Z, Z);
+	const __m128i b2 = _mm_setr_epi8(Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, 2, 5, 8, 11, 14);
+	const __m128i c0 = _mm_setr_epi8(2, 5, 8, 11, 14, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z);
+	const __m128i c1 = _mm_setr_epi8(Z, Z, Z, Z, Z, 1, 4, 7, 10, 13, Z, Z, Z, Z, Z, Z);
+	const __m128i c2 = _mm_setr_epi8(Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, 0, 3, 6, 9, 12, 15);
+
+	__m128i in0 = _mm_loadu_si128((const __m128i *)(src + 0));
+	__m128i in1 = _mm_loadu_si128((const __m128i *)(src + 16));
+	__m128i in2 = _mm_loadu_si128((const __m128i *)(src + 32));
+
+	*out_a = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in0, a0), _mm_shuffle_epi8(in1, a1)), //
+	                      _mm_shuffle_epi8(in2, a2));
+	*out_b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in0, b0), _mm_shuffle_epi8(in1, b1)), //
+	                      _mm_shuffle_epi8(in2, b2));
+	*out_c = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in0, c0), _mm_shuffle_epi8(in1, c1)), //
+	                      _mm_shuffle_epi8(in2, c2));
+}
+
+#undef Z
+
+/*!
+ * Convert 8 pixels, given as 16 bit values, to 16 bit RGB values. Uses madd
+ * on interleaved pairs to do the same 32 bit math as the scalar code.
+ */
+TARGET_SSE41 static inline void
+sse41_yuv_to_rgb_8(__m128i y, __m128i u, __m128i v, __m128i *out_r, __m128i *out_g, __m128i *out_b)
+{
+	const __m128i k_r = _mm_setr_epi16(298, 409, 298, 409, 298, 409, 298, 409);
+	const __m128i k_g_cd = _mm_setr_epi16(298, -100, 298, -100, 298, -100, 298, -100);
+	const __m128i k_g_e1 = _mm_setr_epi16(-209, 128, -209, 128, -209, 128, -209, 128);
+	const __m128i k_b = _mm_setr_epi16(298, 516, 298, 516, 298, 516, 298, 516);
+	const __m128i round = _mm_set1_epi32(128);
+
+	__m128i c = _mm_sub_epi16(y, _mm_set1_epi16(16));
+	__m128i d = _mm_sub_epi16(u, _mm_set1_epi16(128));
+	__m128i e = _mm_sub_epi16(v, _mm_set1_epi16(128));
+	__m128i one = _mm_set1_epi16(1);
+
+	__m128i ce_lo = _mm_unpacklo_epi16(c, e);
+	__m128i ce_hi = _mm_unpackhi_epi16(c, e);
+	__m128i cd_lo = _mm_unpacklo_epi16(c, d);
+	__m128i cd_hi = _mm_unpackhi_epi16(c, d);
+	__m128i e1_lo = _mm_unpacklo_epi16(e, one);
+	__m128i e1_hi = _mm_unpackhi_epi16(e, one);
+
+	__m128i r_lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ce_lo, k_r), round), 8);
+	__m128i r_hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(ce_hi, k_r), round), 8);
+	__m128i g_lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cd_lo, k_g_cd), _mm_madd_epi16(e1_lo, k_g_e1)), 8);
+	__m128i g_hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cd_hi, k_g_cd), _mm_madd_epi16(e1_hi, k_g_e1)), 8);
+	__m128i b_lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cd_lo, k_b), round), 8);
+	__m128i b_hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(cd_hi, k_b), round), 8);
+
+	*out_r = _mm_packs_epi32(r_lo, r_hi);
+	*out_g = _mm_packs_epi32(g_lo, g_hi);
+	*out_b = _mm_packs_epi32(b_lo, b_hi);
+}
+
+//! Convert 16 pixels of 8 bit planes and store them as RGB.
+TARGET_SSE41 static inline void
+sse41_yuv_to_rgb_16(uint8_t *dst, __m128i y, __m128i u, __m128i v)
+{
+	__m128i r_lo, g_lo, b_lo, r_hi, g_hi, b_hi;
+
+	sse41_yuv_to_rgb_8(_mm_cvtepu8_epi16(y), _mm_cvtepu8_epi16(u), _mm_cvtepu8_epi16(v), &r_lo, &g_lo, &b_lo);
+	sse41_yuv_to_rgb_8(_mm_cvtepu8_epi16(_mm_srli_si128(y, 8)), _mm_cvtepu8_epi16(_mm_srli_si128(u, 8)),
+	                   _mm_cvtepu8_epi16(_mm_srli_si128(v, 8)), &r_hi, &g_hi, &b_hi);
+
+	// Saturates to 0 - 255, same as clamp_to_byte.
+	sse41_store_rgb(dst, _mm_packus_epi16(r_lo, r_hi), _mm_packus_epi16(g_lo, g_hi), _mm_packus_epi16(b_lo, b_hi));
+}
+
+/*!
+ * Split 16 pixels of 422 data, the luma is in the even bytes for YUYV and
+ * odd for UYVY. The chroma is duplicated for both pixels sharing it.
+ */
+TARGET_SSE41 static inline void
+sse41_split_422(const uint8_t *src, bool luma_first, __m128i *out_y, __m128i *out_u, __m128i *out_v)
+{
+	const __m128i low = _mm_set1_epi16(0x00ff);
+
+	__m128i in0 = _mm_loadu_si128((const __m128i *)(src + 0));
+	__m128i in1 = _mm_loadu_si128((const __m128i *)(src + 16));
+
+	__m128i even = _mm_packus_epi16(_mm_and_si128(in0, low), _mm_and_si128(in1, low));
+	__m128i odd = _mm_packus_epi16(_mm_srli_epi16(in0, 8), _mm_srli_epi16(in1, 8));
+
+	__m128i y = luma_first ? even : odd;
+	__m128i uv = luma_first ? odd : even;
+
+	// Low 8 bytes hold u0..u7 and v0..v7.
+	__m128i u = _mm_packus_epi16(_mm_and_si128(uv, low), _mm_setzero_si128());
+	__m128i v = _mm_packus_epi16(_mm_srli_epi16(uv, 8), _mm_setzero_si128());
+
+	*out_y = y;
+	*out_u = _mm_unpacklo_epi8(u, u);
+	*out_v = _mm_unpacklo_epi8(v, v);
+}
+
+TARGET_SSE41 static void
+sse41_L8_to_R8G8B8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i l = _mm_loadu_si128((const __m128i *)(src + x));
+		sse41_store_rgb(dst + x * 3, l, l, l);
+	}
+
+	scalar_L8_to_R8G8B8(dst + x * 3, src + x, width - x);
+}
+
+TARGET_SSE41 static void
+sse41_YUYV422_to_L8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	const __m128i low = _mm_set1_epi16(0x00ff);
+
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i in0 = _mm_loadu_si128((const __m128i *)(src + x * 2));
+		__m128i in1 = _mm_loadu_si128((const __m128i *)(src + x * 2 + 16));
+		__m128i y = _mm_packus_epi16(_mm_and_si128(in0, low), _mm_and_si128(in1, low));
+		_mm_storeu_si128((__m128i *)(dst + x), y);
+	}
+
+	scalar_YUYV422_to_L8(dst + x, src + x * 2, width - x);
+}
+
+TARGET_SSE41 static void
+sse41_YUYV422_to_R8G8B8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i y, u, v;
+		sse41_split_422(src + x * 2, true, &y, &u, &v);
+		sse41_yuv_to_rgb_16(dst + x * 3, y, u, v);
+	}
+
+	scalar_YUYV422_to_R8G8B8(dst + x * 3, src + x * 2, width - x);
+}
+
+TARGET_SSE41 static void
+sse41_UYVY422_to_R8G8B8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i y, u, v;
+		sse41_split_422(src + x * 2, false, &y, &u, &v);
+		sse41_yuv_to_rgb_16(dst + x * 3, y, u, v);
+	}
+
+	scalar_UYVY422_to_R8G8B8(dst + x * 3, src + x * 2, width - x);
+}
+
+TARGET_SSE41 static void
+sse41_YUV888_to_R8G8B8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i y, u, v;
+		sse41_load_planes(src + x * 3, &y, &u, &v);
+		sse41_yuv_to_rgb_16(dst + x * 3, y, u, v);
+	}
+
+	scalar_YUV888_to_R8G8B8(dst + x * 3, src + x * 3, width - x);
+}
+
+TARGET_SSE41 static void
+sse41_L8_INTERLEAVED_to_L8_SBS(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	const __m128i low = _mm_set1_epi16(0x00ff);
+	uint32_t half_w = width / 2;
+
+	uint32_t x = 0;
+	for (; x + 16 <= half_w; x += 16) {
+		__m128i in0 = _mm_loadu_si128((const __m128i *)(src + x * 2));
+		__m128i in1 = _mm_loadu_si128((const __m128i *)(src + x * 2 + 16));
+		__m128i even = _mm_packus_epi16(_mm_and_si128(in0, low), _mm_and_si128(in1, low));
+		__m128i odd = _mm_packus_epi16(_mm_srli_epi16(in0, 8), _mm_srli_epi16(in1, 8));
+		_mm_storeu_si128((__m128i *)(dst + x), even);
+		_mm_storeu_si128((__m128i *)(dst + half_w + x), odd);
+	}
+
+	for (; x < half_w; x++) {
+		dst[x] = src[x * 2];
+		dst[x + half_w] = src[x * 2 + 1];
+	}
+}
+
+//! Split 16 Bayer quads into R, G and B, G is the truncated mean of both greens.
+TARGET_SSE41 static inline void
+sse41_split_bayer_gr(const uint8_t *src0, const uint8_t *src1, __m128i *out_r, __m128i *out_g, __m128i *out_b)
+{
+	const __m128i low = _mm_set1_epi16(0x00ff);
+
+	__m128i a0 = _mm_loadu_si128((const __m128i *)(src0 + 0));
+	__m128i a1 = _mm_loadu_si128((const __m128i *)(src0 + 16));
+	__m128i b0 = _mm_loadu_si128((const __m128i *)(src1 + 0));
+	__m128i b1 = _mm_loadu_si128((const __m128i *)(src1 + 16));
+
+	// As 16 bit values, so the sum of the greens doesn't overflow.
+	__m128i g_lo = _mm_srli_epi16(_mm_add_epi16(_mm_and_si128(a0, low), _mm_srli_epi16(b0, 8)), 1);
+	__m128i g_hi = _mm_srli_epi16(_mm_add_epi16(_mm_and_si128(a1, low), _mm_srli_epi16(b1, 8)), 1);
+
+	*out_r = _mm_packus_epi16(_mm_srli_epi16(a0, 8), _mm_srli_epi16(a1, 8));
+	*out_g = _mm_packus_epi16(g_lo, g_hi);
+	*out_b = _mm_packus_epi16(_mm_and_si128(b0, low), _mm_and_si128(b1, low));
+}
+
+//! Luma of 8 pixels given as 16 bit values, fits in 16 bits as the weights sum to 256.
+TARGET_SSE41 static inline __m128i
+sse41_luma_8(__m128i r, __m128i g, __m128i b)
+{
+	__m128i sum = _mm_mullo_epi16(r, _mm_set1_epi16(77));
+	sum = _mm_add_epi16(sum, _mm_mullo_epi16(g, _mm_set1_epi16(150)));
+	sum = _mm_add_epi16(sum, _mm_mullo_epi16(b, _mm_set1_epi16(29)));
+	sum = _mm_add_epi16(sum, _mm_set1_epi16(128));
+	return _mm_srli_epi16(sum, 8);
+}
+
+TARGET_SSE41 static void
+sse41_BAYER_GR8_to_R8G8B8(uint8_t *dst, const uint8_t *src0, const uint8_t *src1, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i r, g, b;
+		sse41_split_bayer_gr(src0 + x * 2, src1 + x * 2, &r, &g, &b);
+		sse41_store_rgb(dst + x * 3, r, g, b);
+	}
+
+	scalar_BAYER_GR8_to_R8G8B8(dst + x * 3, src0 + x * 2, src1 + x * 2, width - x);
+}
+
+TARGET_SSE41 static void
+sse41_BAYER_GR8_to_L8(uint8_t *dst, const uint8_t *src0, const uint8_t *src1, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i r, g, b;
+		sse41_split_bayer_gr(src0 + x * 2, src1 + x * 2, &r, &g, &b);
+
+		__m128i r_hi = _mm_srli_si128(r, 8);
+		__m128i g_hi = _mm_srli_si128(g, 8);
+		__m128i b_hi = _mm_srli_si128(b, 8);
+
+		__m128i l_lo = sse41_luma_8(_mm_cvtepu8_epi16(r), _mm_cvtepu8_epi16(g), _mm_cvtepu8_epi16(b));
+		__m128i l_hi = sse41_luma_8(_mm_cvtepu8_epi16(r_hi), _mm_cvtepu8_epi16(g_hi), _mm_cvtepu8_epi16(b_hi));
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(l_lo, l_hi));
+	}
+
+	scalar_BAYER_GR8_to_L8(dst + x, src0 + x * 2, src1 + x * 2, width - x);
+}
+
+static const struct u_format_row_funcs sse41_funcs = {
+    .name = "sse4.1",
+    .L8_to_R8G8B8 = sse41_L8_to_R8G8B8,
+    .YUYV422_to_L8 = sse41_YUYV422_to_L8,
+    .YUYV422_to_R8G8B8 = sse41_YUYV422_to_R8G8B8,
+    .UYVY422_to_R8G8B8 = sse41_UYVY422_to_R8G8B8,
+    .YUV888_to_R8G8B8 = sse41_YUV888_to_R8G8B8,
+    .L8_INTERLEAVED_to_L8_SBS = sse41_L8_INTERLEAVED_to_L8_SBS,
+    .BAYER_GR8_to_R8G8B8 = sse41_BAYER_GR8_to_R8G8B8,
+    .BAYER_GR8_to_L8 = sse41_BAYER_GR8_to_L8,
+};
+
+#endif // U_FORMAT_ROWS_SSE41
+
+
+/*
+ *
+ * NEON functions, 16 pixels at a time.
+ *
+ */
+
+#ifdef U_FORMAT_ROWS_NEON
+
+//! Convert 8 pixels, vrshrn does the same add 128 and shift as the scalar code.
+static inline void
+neon_yuv_to_rgb_8(uint8x8_t y, uint8x8_t u, uint8x8_t v, uint8x8_t *out_r, uint8x8_t *out_g, uint8x8_t *out_b)
+{
+	int16x8_t c = vreinterpretq_s16_u16(vsubl_u8(y, vdup_n_u8(16)));
+	int16x8_t d = vreinterpretq_s16_u16(vsubl_u8(u, vdup_n_u8(128)));
+	int16x8_t e = vreinterpretq_s16_u16(vsubl_u8(v, vdup_n_u8(128)));
+
+	int32x4_t c_lo = vmull_n_s16(vget_low_s16(c), 298);
+	int32x4_t c_hi = vmull_n_s16(vget_high_s16(c), 298);
+
+	int32x4_t r_lo = vmlal_n_s16(c_lo, vget_low_s16(e), 409);
+	int32x4_t r_hi = vmlal_n_s16(c_hi, vget_high_s16(e), 409);
+
+	int32x4_t g_lo = vmlsl_n_s16(vmlsl_n_s16(c_lo, vget_low_s16(d), 100), vget_low_s16(e), 209);
+	int32x4_t g_hi = vmlsl_n_s16(vmlsl_n_s16(c_hi, vget_high_s16(d), 100), vget_high_s16(e), 209);
+
+	int32x4_t b_lo = vmlal_n_s16(c_lo, vget_low_s16(d), 516);
+	int32x4_t b_hi = vmlal_n_s16(c_hi, vget_high_s16(d), 516);
+
+	// Saturates to 0 - 255, same as clamp_to_byte.
+	*out_r = vqmovun_s16(vcombine_s16(vrshrn_n_s32(r_lo, 8), vrshrn_n_s32(r_hi, 8)));
+	*out_g = vqmovun_s16(vcombine_s16(vrshrn_n_s32(g_lo, 8), vrshrn_n_s32(g_hi, 8)));
+	*out_b = vqmovun_s16(vcombine_s16(vrshrn_n_s32(b_lo, 8), vrshrn_n_s32(b_hi, 8)));
+}
+
+//! 16 pixels of 422, the even and odd luma share the chroma.
+static inline void
+neon_422_to_rgb_16(uint8_t *dst, uint8x8_t y_even, uint8x8_t y_odd, uint8x8_t u, uint8x8_t v)
+{
+	uint8x8_t r_even, g_even, b_even, r_odd, g_odd, b_odd;
+	neon_yuv_to_rgb_8(y_even, u, v, &r_even, &g_even, &b_even);
+	neon_yuv_to_rgb_8(y_odd, u, v, &r_odd, &g_odd, &b_odd);
+
+	uint8x8x2_t r = vzip_u8(r_even, r_odd);
+	uint8x8x2_t g = vzip_u8(g_even, g_odd);
+	uint8x8x2_t b = vzip_u8(b_even, b_odd);
+
+	uint8x16x3_t rgb;
+	rgb.val[0] = vcombine_u8(r.val[0], r.val[1]);
+	rgb.val[1] = vcombine_u8(g.val[0], g.val[1]);
+	rgb.val[2] = vcombine_u8(b.val[0], b.val[1]);
+	vst3q_u8(dst, rgb);
+}
+
+static void
+neon_L8_to_R8G8B8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x16x3_t rgb;
+		rgb.val[0] = rgb.val[1] = rgb.val[2] = vld1q_u8(src + x);
+		vst3q_u8(dst + x * 3, rgb);
+	}
+
+	scalar_L8_to_R8G8B8(dst + x * 3, src + x, width - x);
+}
+
+static void
+neon_YUYV422_to_L8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x16x2_t in = vld2q_u8(src + x * 2);
+		vst1q_u8(dst + x, in.val[0]);
+	}
+
+	scalar_YUYV422_to_L8(dst + x, src + x * 2, width - x);
+}
+
+static void
+neon_YUYV422_to_R8G8B8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x8x4_t in = vld4_u8(src + x * 2); // Y0 U Y1 V
+		neon_422_to_rgb_16(dst + x * 3, in.val[0], in.val[2], in.val[1], in.val[3]);
+	}
+
+	scalar_YUYV422_to_R8G8B8(dst + x * 3, src + x * 2, width - x);
+}
+
+static void
+neon_UYVY422_to_R8G8B8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x8x4_t in = vld4_u8(src + x * 2); // U Y0 V Y1
+		neon_422_to_rgb_16(dst + x * 3, in.val[1], in.val[3], in.val[0], in.val[2]);
+	}
+
+	scalar_UYVY422_to_R8G8B8(dst + x * 3, src + x * 2, width - x);
+}
+
+static void
+neon_YUV888_to_R8G8B8(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x16x3_t in = vld3q_u8(src + x * 3);
+		uint8x8_t r_lo, g_lo, b_lo, r_hi, g_hi, b_hi;
+
+		neon_yuv_to_rgb_8(vget_low_u8(in.val[0]), vget_low_u8(in.val[1]), vget_low_u8(in.val[2]), //
+		                  &r_lo, &g_lo, &b_lo);
+		neon_yuv_to_rgb_8(vget_high_u8(in.val[0]), vget_high_u8(in.val[1]), vget_high_u8(in.val[2]), //
+		                  &r_hi, &g_hi, &b_hi);
+
+		uint8x16x3_t rgb;
+		rgb.val[0] = vcombine_u8(r_lo, r_hi);
+		rgb.val[1] = vcombine_u8(g_lo, g_hi);
+		rgb.val[2] = vcombine_u8(b_lo, b_hi);
+		vst3q_u8(dst + x * 3, rgb);
+	}
+
+	scalar_YUV888_to_R8G8B8(dst + x * 3, src + x * 3, width - x);
+}
+
+static void
+neon_L8_INTERLEAVED_to_L8_SBS(uint8_t *dst, const uint8_t *src, uint32_t width)
+{
+	uint32_t half_w = width / 2;
+
+	uint32_t x = 0;
+	for (; x + 16 <= half_w; x += 16) {
+		uint8x16x2_t in = vld2q_u8(src + x * 2);
+		vst1q_u8(dst + x, in.val[0]);
+		vst1q_u8(dst + half_w + x, in.val[1]);
+	}
+
+	for (; x < half_w; x++) {
+		dst[x] = src[x * 2];
+		dst[x + half_w] = src[x * 2 + 1];
+	}
+}
+
+static void
+neon_BAYER_GR8_to_R8G8B8(uint8_t *dst, const uint8_t *src0, const uint8_t *src1, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x16x2_t gr = vld2q_u8(src0 + x * 2);
+		uint8x16x2_t bg = vld2q_u8(src1 + x * 2);
+
+		uint8x16x3_t rgb;
+		rgb.val[0] = gr.val[1];
+		rgb.val[1] = vhaddq_u8(gr.val[0], bg.val[1]);
+		rgb.val[2] = bg.val[0];
+		vst3q_u8(dst + x * 3, rgb);
+	}
+
+	scalar_BAYER_GR8_to_R8G8B8(dst + x * 3, src0 + x * 2, src1 + x * 2, width - x);
+}
+
+//! Luma of 8 pixels, vrshrn does the same add 128 and shift as the scalar code.
+static inline uint8x8_t
+neon_luma_8(uint8x8_t r, uint8x8_t g, uint8x8_t b)
+{
+	uint16x8_t sum = vmull_u8(r, vdup_n_u8(77));
+	sum = vmlal_u8(sum, g, vdup_n_u8(150));
+	sum = vmlal_u8(sum, b, vdup_n_u8(29));
+	return vrshrn_n_u16(sum, 8);
+}
+
+static void
+neon_BAYER_GR8_to_L8(uint8_t *dst, const uint8_t *src0, const uint8_t *src1, uint32_t width)
+{
+	uint32_t x = 0;
+	for (; x + 16 <= width; x += 16) {
+		uint8x16x2_t gr = vld2q_u8(src0 + x * 2);
+		uint8x16x2_t bg = vld2q_u8(src1 + x * 2);
+
+		uint8x16_t r = gr.val[1];
+		uint8x16_t g = vhaddq_u8(gr.val[0], bg.val[1]);
+		uint8x16_t b = bg.val[0];
+
+		uint8x8_t l_lo = neon_luma_8(vget_low_u8(r), vget_low_u8(g), vget_low_u8(b));
+		uint8x8_t l_hi = neon_luma_8(vget_high_u8(r), vget_high_u8(g), vget_high_u8(b));
+		vst1q_u8(dst + x, vcombine_u8(l_lo, l_hi));
+	}
+
+	scalar_BAYER_GR8_to_L8(dst + x, src0 + x * 2, src1 + x * 2, width - x);
+}
+
+static const struct u_format_row_funcs neon_funcs = {
+    .name = "neon",
+    .L8_to_R8G8B8 = neon_L8_to_R8G8B8,
+    .YUYV422_to_L8 = neon_YUYV422_to_L8,
+    .YUYV422_to_R8G8B8 = neon_YUYV422_to_R8G8B8,
+    .UYVY422_to_R8G8B8 = neon_UYVY422_to_R8G8B8,
+    .YUV888_to_R8G8B8 = neon_YUV888_to_R8G8B8,
+    .L8_INTERLEAVED_to_L8_SBS = neon_L8_INTERLEAVED_to_L8_SBS,
+    .BAYER_GR8_to_R8G8B8 = neon_BAYER_GR8_to_R8G8B8,
+    .BAYER_GR8_to_L8 = neon_BAYER_GR8_to_L8,
+};
+
+#endif // U_FORMAT_ROWS_NEON
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+static const struct u_format_row_funcs *
+select_funcs(void)
+{
+	if (debug_get_bool_option_no_simd()) {
+		return &scalar_funcs;
+	}
+
+#if defined(U_FORMAT_ROWS_SSE41)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse4.1")) {
+		return &sse41_funcs;
+	}
+#elif defined(U_FORMAT_ROWS_NEON)
+	return &neon_funcs;
+#endif
+
+	return &scalar_funcs;
+}
+
+const struct u_format_row_funcs *
+u_format_row_funcs_get(void)
+{
+	// Racing threads all select the same functions, so this is benign.
+	static const struct u_format_row_funcs *funcs = NULL;
+
+	if (funcs == NULL) {
+		funcs = select_funcs();
+		U_LOG_D("Using '%s' pixel format conversion functions.", funcs->name);
+	}
+
+	return funcs;
+}
+
+const struct u_format_row_funcs *
+u_format_row_funcs_get_scalar(void)
+{
+	return &scalar_funcs;
+}
@@ -0,0 +1,81 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Row conversion kernels between pixel formats, with SIMD versions.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Converts @p width pixels of one row from @p src to @p dst, for the 422
+ * formats @p width must be even.
+ *
+ * @ingroup aux_util
+ */
+typedef void (*u_format_row_func_t)(uint8_t *dst, const uint8_t *src, uint32_t width);
+
+/*!
+ * Demosaics one row of 2x2 Bayer quads from the two source rows @p src0 and
+ * @p src1 into @p width pixels, so the output has half the width and height
+ * of the Bayer image.
+ *
+ * @ingroup aux_util
+ */
+typedef void (*u_format_bayer_row_func_t)(uint8_t *dst, const uint8_t *src0, const uint8_t *src1, uint32_t width);
+
+/*!
+ * A set of row conversion functions, all sets produce the exact same output.
+ *
+ * @ingroup aux_util
+ */
+struct u_format_row_funcs
+{
+	//! Name of the implementation, for logging.
+	const char *name;
+
+	u_format_row_func_t L8_to_R8G8B8;
+	u_format_row_func_t YUYV422_to_L8;
+	u_format_row_func_t YUYV422_to_R8G8B8;
+	u_format_row_func_t UYVY422_to_R8G8B8;
+	u_format_row_func_t YUV888_to_R8G8B8;
+	//! Even pixels go to the left half of @p dst and odd to the right half.
+	u_format_row_func_t L8_INTERLEAVED_to_L8_SBS;
+
+	u_format_bayer_row_func_t BAYER_GR8_to_R8G8B8;
+	//! Same as @ref BAYER_GR8_to_R8G8B8 followed by BT.601 luma, in one pass.
+	u_format_bayer_row_func_t BAYER_GR8_to_L8;
+};
+
+/*!
+ * Returns the fastest set of functions supported by the CPU, selected once at
+ * runtime. Setting the `XRT_FORMAT_ROWS_NO_SIMD` env variable forces the plain C
+ * functions.
+ *
+ * @ingroup aux_util
+ */
+const struct u_format_row_funcs *
+u_format_row_funcs_get(void);
+
+/*!
+ * Returns the plain C functions, used as reference.
+ *
+ * @ingroup aux_util
+ */
+const struct u_format_row_funcs *
+u_format_row_funcs_get_scalar(void);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,121 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Foveation helpers, fills fragment density maps.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "util/u_foveation.h"
+
+#include <math.h>
+#include <assert.h>
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static float
+clampf(float value, float min, float max)
+{
+	return value < min ? min : (value > max ? max : value);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+u_foveation_params_from_level(enum u_foveation_level level, struct xrt_foveation_params *out_params)
+{
+	struct xrt_foveation_params params = {0};
+
+	for (uint32_t i = 0; i < XRT_MAX_VIEWS; i++) {
+		params.centers[i].x = 0.5f;
+		params.centers[i].y = 0.5f;
+	}
+
+	switch (level) {
+	case U_FOVEATION_LEVEL_LOW:
+		params.inner_radius = 0.4f;
+		params.outer_radius = 0.8f;
+		params.outer_density = 0.5f;
+		break;
+	case U_FOVEATION_LEVEL_MEDIUM:
+		params.inner_radius = 0.3f;
+		params.outer_radius = 0.7f;
+		params.outer_density = 0.5f;
+		break;
+	case U_FOVEATION_LEVEL_HIGH:
+		params.inner_radius = 0.2f;
+		params.outer_radius = 0.6f;
+		params.outer_density = 0.25f;
+		break;
+	case U_FOVEATION_LEVEL_NONE:
+	default:
+		params.inner_radius = 1.0f;
+		params.outer_radius = 2.0f;
+		params.outer_density = 1.0f;
+		break;
+	}
+
+	*out_params = params;
+}
+
+float
+u_foveation_density(const struct xrt_foveation_params *params, uint32_t view, float aspect, float u, float v)
+{
+	assert(view < XRT_MAX_VIEWS);
+
+	float outer_density = clampf(params->outer_density, 0.0f, 1.0f);
+	float dx = (u - params->centers[view].x) * aspect;
+	float dy = v - params->centers[view].y;
+	float distance = sqrtf(dx * dx + dy * dy);
+
+	if (distance <= params->inner_radius) {
+		return 1.0f;
+	}
+	if (distance >= params->outer_radius) {
+		return outer_density;
+	}
+
+	// Linear fall off between the two radii.
+	float t = (distance - params->inner_radius) / (params->outer_radius - params->inner_radius);
+
+	return 1.0f + (outer_density - 1.0f) * t;
+}
+
+void
+u_foveation_fill_r8g8(const struct xrt_foveation_params *params,
+                      uint32_t view,
+                      uint32_t width,
+                      uint32_t height,
+                      uint8_t *out_texels)
+{
+	if (width == 0 || height == 0) {
+		return;
+	}
+
+	float aspect = (float)width / (float)height;
+
+	for (uint32_t y = 0; y < height; y++) {
+		float v = ((float)y + 0.5f) / (float)height;
+
+		for (uint32_t x = 0; x < width; x++) {
+			float u = ((float)x + 0.5f) / (float)width;
+			float density = u_foveation_density(params, view, aspect, u, v);
+			uint8_t value = (uint8_t)(density * 255.0f + 0.5f);
+
+			// Same density on both axes.
+			out_texels[(y * width + x) * 2 + 0] = value;
+			out_texels[(y * width + x) * 2 + 1] = value;
+		}
+	}
+}
@@ -0,0 +1,70 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Foveation helpers, fills fragment density maps.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compositor.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * How much the periphery is reduced, maps onto the levels of
+ * XR_FB_foveation_configuration.
+ *
+ * @ingroup aux_util
+ */
+enum u_foveation_level
+{
+	U_FOVEATION_LEVEL_NONE = 0,
+	U_FOVEATION_LEVEL_LOW = 1,
+	U_FOVEATION_LEVEL_MEDIUM = 2,
+	U_FOVEATION_LEVEL_HIGH = 3,
+};
+
+/*!
+ * Fill out @p out_params for the given @p level, the centers are put in the
+ * middle of the image.
+ *
+ * @ingroup aux_util
+ */
+void
+u_foveation_params_from_level(enum u_foveation_level level, struct xrt_foveation_params *out_params);
+
+/*!
+ * Density at the normalized image coordinate @p u @p v of @p view, @p aspect
+ * is the width of the image divided by the height.
+ *
+ * @return Density in the range [outer_density, 1].
+ * @ingroup aux_util
+ */
+float
+u_foveation_density(const struct xrt_foveation_params *params, uint32_t view, float aspect, float u, float v);
+
+/*!
+ * Fill a @p width by @p height R8G8 unorm fragment density map for @p view,
+ * sampling each texel at its center. @p out_texels must hold
+ * `width * height * 2` bytes.
+ *
+ * @ingroup aux_util
+ */
+void
+u_foveation_fill_r8g8(const struct xrt_foveation_params *params,
+                      uint32_t view,
+                      uint32_t width,
+                      uint32_t height,
+                      uint8_t *out_texels);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,11 +7,31 @@
  * @ingroup aux_util
  */
 
+#include "xrt/xrt_config_os.h"
+
+#include "os/os_threading.h"
+
 #include "util/u_misc.h"
+#include "util/u_debug.h"
 #include "util/u_frame.h"
 #include "util/u_format.h"
+#include "util/u_logging.h"
 
 #include <assert.h>
+#include <stdlib.h>
+
+#if defined(XRT_OS_WINDOWS)
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(frame_pool_huge_pages, "XRT_FRAME_POOL_HUGE_PAGES", false)
+DEBUG_GET_ONCE_BOOL_OPTION(frame_pool_locked, "XRT_FRAME_POOL_LOCKED", false)
+
+//! Size of the huge pages we ask for.
+#define HUGE_PAGE_SIZE (2u * 1024u * 1024u)
 
 
 static void
@@ -141,5 +161,343 @@ u_frame_create_roi(struct xrt_frame *original, struct xrt_rect roi, struct xrt_f
 	xf->source_sequence = original->source_sequence;
 	xf->source_id = original->source_id;
 
+	// Same memory, so importers can use the same buffer.
+	if (original->has_buffer_handle) {
+		xf->buffer_handle = original->buffer_handle;
+		xf->buffer_offset = original->buffer_offset + offset;
+		xf->has_buffer_handle = true;
+	}
+
 	xrt_frame_reference(out_frame, xf);
 }
+
+
+/*
+ *
+ * Frame pool.
+ *
+ */
+
+struct u_frame_pool_frame
+{
+	struct xrt_frame base;
+
+	struct u_frame_pool *pool;
+
+	//! Next in the free list of the pool.
+	struct u_frame_pool_frame *next;
+
+	//! Size of the allocation backing the data, can be larger than the frame.
+	size_t alloc_size;
+
+	//! Data was mapped directly with huge pages and needs to be unmapped.
+	bool mapped;
+
+	//! Data is locked into memory.
+	bool locked;
+};
+
+struct u_frame_pool
+{
+	//! One for the owner and one for each frame that has been handed out.
+	struct xrt_reference reference;
+
+	//! Protects the fields below, frames are released from any thread.
+	struct os_mutex mutex;
+
+	//! Free frames, most recently released first.
+	struct u_frame_pool_frame *free_list;
+
+	uint32_t free_count;
+
+	//! Set to zero when the owner destroys the pool.
+	uint32_t max_free_count;
+
+	//! How the pixel buffers are allocated, never changes.
+	enum u_frame_pool_flags flags;
+};
+
+static inline size_t
+align_size(size_t size, size_t alignment)
+{
+	return (size + alignment - 1) & ~(alignment - 1);
+}
+
+static void *
+aligned_malloc(size_t alignment, size_t size)
+{
+#if defined(XRT_OS_WINDOWS)
+	return _aligned_malloc(size, alignment);
+#else
+	void *ptr = NULL;
+	if (posix_memalign(&ptr, alignment, size) != 0) {
+		return NULL;
+	}
+	return ptr;
+#endif
+}
+
+static void
+aligned_free(void *ptr)
+{
+#if defined(XRT_OS_WINDOWS)
+	_aligned_free(ptr);
+#else
+	free(ptr);
+#endif
+}
+
+static void
+pool_frame_alloc_data(struct u_frame_pool *ufp, struct u_frame_pool_frame *upf)
+{
+	size_t size = align_size(upf->base.size, U_FRAME_POOL_ALIGNMENT);
+	void *ptr = NULL;
+
+#if defined(XRT_OS_LINUX)
+	if ((ufp->flags & U_FRAME_POOL_HUGE_PAGES) != 0) {
+		size_t huge_size = align_size(size, HUGE_PAGE_SIZE);
+
+		// Explicit huge pages only work if the admin has reserved some.
+		ptr = mmap(NULL, huge_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (ptr != MAP_FAILED) {
+			upf->mapped = true;
+			size = huge_size;
+		} else {
+			// Otherwise hint for transparent huge pages.
+			ptr = aligned_malloc(HUGE_PAGE_SIZE, huge_size);
+			if (ptr != NULL) {
+				(void)madvise(ptr, huge_size, MADV_HUGEPAGE);
+				size = huge_size;
+			}
+		}
+	}
+#endif
+
+	if (ptr == NULL) {
+		ptr = aligned_malloc(U_FRAME_POOL_ALIGNMENT, size);
+	}
+
+#if !defined(XRT_OS_WINDOWS)
+	if (ptr != NULL && (ufp->flags & U_FRAME_POOL_LOCKED) != 0) {
+		// Best effort, limited by RLIMIT_MEMLOCK.
+		upf->locked = mlock(ptr, size) == 0;
+		if (!upf->locked) {
+			U_LOG_W("Could not lock frame buffer of %zu bytes, check RLIMIT_MEMLOCK.", size);
+		}
+	}
+#endif
+
+	upf->base.data = (uint8_t *)ptr;
+	upf->alloc_size = size;
+}
+
+static void
+pool_frame_free(struct u_frame_pool_frame *upf)
+{
+#if !defined(XRT_OS_WINDOWS)
+	if (upf->locked) {
+		(void)munlock(upf->base.data, upf->alloc_size);
+	}
+
+	if (upf->mapped) {
+		(void)munmap(upf->base.data, upf->alloc_size);
+		upf->base.data = NULL;
+	}
+#endif
+
+	aligned_free(upf->base.data);
+	free(upf);
+}
+
+static void
+pool_unreference(struct u_frame_pool *ufp)
+{
+	if (!xrt_reference_dec_and_is_zero(&ufp->reference)) {
+		return;
+	}
+
+	// The free list was emptied when the owner destroyed the pool.
+	assert(ufp->free_list == NULL);
+
+	os_mutex_destroy(&ufp->mutex);
+	free(ufp);
+}
+
+static void
+pool_frame_release(struct xrt_frame *xf)
+{
+	assert(xf->reference.count == 0);
+
+	struct u_frame_pool_frame *upf = (struct u_frame_pool_frame *)xf;
+	struct u_frame_pool *ufp = upf->pool;
+
+	os_mutex_lock(&ufp->mutex);
+	if (ufp->free_count < ufp->max_free_count) {
+		upf->next = ufp->free_list;
+		ufp->free_list = upf;
+		ufp->free_count++;
+		upf = NULL;
+	}
+	os_mutex_unlock(&ufp->mutex);
+
+	if (upf != NULL) {
+		pool_frame_free(upf);
+	}
+
+	pool_unreference(ufp);
+}
+
+static struct u_frame_pool_frame *
+pool_take_free(struct u_frame_pool *ufp, enum xrt_format f, uint32_t width, uint32_t height)
+{
+	struct u_frame_pool_frame *ret = NULL;
+	struct u_frame_pool_frame *evict = NULL;
+
+	os_mutex_lock(&ufp->mutex);
+
+	struct u_frame_pool_frame **ptr = &ufp->free_list;
+	while (*ptr != NULL) {
+		struct u_frame_pool_frame *upf = *ptr;
+		if (upf->base.format == f && upf->base.width == width && upf->base.height == height) {
+			*ptr = upf->next;
+			ufp->free_count--;
+			ret = upf;
+			break;
+		}
+		ptr = &upf->next;
+	}
+
+	// The size changed, get rid of the oldest free frame so they don't pile up.
+	if (ret == NULL && ufp->free_count > 0 && ufp->free_count >= ufp->max_free_count) {
+		ptr = &ufp->free_list;
+		while ((*ptr)->next != NULL) {
+			ptr = &(*ptr)->next;
+		}
+		evict = *ptr;
+		*ptr = NULL;
+		ufp->free_count--;
+	}
+
+	os_mutex_unlock(&ufp->mutex);
+
+	if (evict != NULL) {
+		pool_frame_free(evict);
+	}
+
+	return ret;
+}
+
+struct u_frame_pool *
+u_frame_pool_create(uint32_t max_free_frames)
+{
+	return u_frame_pool_create_with_flags(max_free_frames, (enum u_frame_pool_flags)0);
+}
+
+struct u_frame_pool *
+u_frame_pool_create_with_flags(uint32_t max_free_frames, enum u_frame_pool_flags flags)
+{
+	if (debug_get_bool_option_frame_pool_huge_pages()) {
+		flags |= U_FRAME_POOL_HUGE_PAGES;
+	}
+	if (debug_get_bool_option_frame_pool_locked()) {
+		flags |= U_FRAME_POOL_LOCKED;
+	}
+
+	struct u_frame_pool *ufp = U_TYPED_CALLOC(struct u_frame_pool);
+
+	int ret = os_mutex_init(&ufp->mutex);
+	if (ret != 0) {
+		free(ufp);
+		return NULL;
+	}
+
+	ufp->reference.count = 1;
+	ufp->max_free_count = max_free_frames;
+	ufp->flags = flags;
+
+	return ufp;
+}
+
+void
+u_frame_pool_create_frame(struct u_frame_pool *ufp,
+                          enum xrt_format f,
+                          uint32_t width,
+                          uint32_t height,
+                          struct xrt_frame **out_frame)
+{
+	assert(width > 0);
+	assert(height > 0);
+	assert(u_format_is_blocks(f));
+
+	if (ufp == NULL) {
+		u_frame_create_one_off(f, width, height, out_frame);
+		return;
+	}
+
+	struct u_frame_pool_frame *upf = pool_take_free(ufp, f, width, height);
+
+	if (upf != NULL) {
+		// Keep the buffer, reset everything else.
+		uint8_t *data = upf->base.data;
+		size_t stride = upf->base.stride;
+		size_t size = upf->base.size;
+
+		U_ZERO(&upf->base);
+		upf->base.data = data;
+		upf->base.stride = stride;
+		upf->base.size = size;
+	} else {
+		upf = U_TYPED_CALLOC(struct u_frame_pool_frame);
+		upf->pool = ufp;
+
+		u_format_size_for_dimensions(f, width, height, &upf->base.stride, &upf->base.size);
+
+		if ((ufp->flags & U_FRAME_POOL_ALIGN_ROWS) != 0) {
+			// Only block formats, so the size is a whole number of rows.
+			size_t rows = upf->base.size / upf->base.stride;
+			upf->base.stride = align_size(upf->base.stride, U_FRAME_POOL_ALIGNMENT);
+			upf->base.size = upf->base.stride * rows;
+		}
+
+		pool_frame_alloc_data(ufp, upf);
+	}
+
+	upf->base.format = f;
+	upf->base.width = width;
+	upf->base.height = height;
+	upf->base.destroy = pool_frame_release;
+	upf->next = NULL;
+
+	// Each frame handed out keeps the pool alive.
+	xrt_reference_inc(&ufp->reference);
+
+	xrt_frame_reference(out_frame, &upf->base);
+}
+
+void
+u_frame_pool_destroy(struct u_frame_pool **ufp_ptr)
+{
+	struct u_frame_pool *ufp = *ufp_ptr;
+	if (ufp == NULL) {
+		return;
+	}
+
+	struct u_frame_pool_frame *free_list = NULL;
+
+	// Frames released from now on are freed straight away.
+	os_mutex_lock(&ufp->mutex);
+	free_list = ufp->free_list;
+	ufp->free_list = NULL;
+	ufp->free_count = 0;
+	ufp->max_free_count = 0;
+	os_mutex_unlock(&ufp->mutex);
+
+	while (free_list != NULL) {
+		struct u_frame_pool_frame *upf = free_list;
+		free_list = upf->next;
+		pool_frame_free(upf);
+	}
+
+	pool_unreference(ufp);
+	*ufp_ptr = NULL;
+}
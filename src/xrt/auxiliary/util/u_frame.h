@@ -37,6 +37,86 @@ u_frame_clone(struct xrt_frame *to_copy, struct xrt_frame **out_frame);
 void
 u_frame_create_roi(struct xrt_frame *original, struct xrt_rect roi, struct xrt_frame **out_frame);
 
+/*!
+ * A pool of frames that are kept around and reused when their reference
+ * reaches zero, instead of being freed. Used by code that creates frames at
+ * camera rate to not allocate a new frame and pixel buffer for every frame.
+ *
+ * Frames are matched by format and dimensions, so the stride and size also
+ * match. Frames can be released on any thread, and can outlive the pool.
+ *
+ * @ingroup aux_util
+ */
+struct u_frame_pool;
+
+/*!
+ * How the pixel buffers of a @ref u_frame_pool are allocated, buffers always
+ * start on a cache line.
+ *
+ * @ingroup aux_util
+ */
+enum u_frame_pool_flags
+{
+	//! Back buffers with huge pages, explicit ones if reserved otherwise transparent, Linux only.
+	U_FRAME_POOL_HUGE_PAGES = (1u << 0u),
+
+	//! Lock buffers into memory so they are never paged out, best effort.
+	U_FRAME_POOL_LOCKED = (1u << 1u),
+
+	//! Pad the stride of frames so that every row starts on a cache line.
+	U_FRAME_POOL_ALIGN_ROWS = (1u << 2u),
+};
+
+/*!
+ * Row and buffer alignment used by @ref u_frame_pool, enough for any SIMD
+ * loads the converters do.
+ *
+ * @ingroup aux_util
+ */
+#define U_FRAME_POOL_ALIGNMENT (64)
+
+/*!
+ * Create a frame pool, will keep at most @p max_free_frames frames around
+ * that are not referenced. The XRT_FRAME_POOL_HUGE_PAGES and
+ * XRT_FRAME_POOL_LOCKED environment variables turn on the matching
+ * @ref u_frame_pool_flags.
+ *
+ * @public @memberof u_frame_pool
+ */
+struct u_frame_pool *
+u_frame_pool_create(uint32_t max_free_frames);
+
+/*!
+ * Same as @ref u_frame_pool_create but with explicit @p flags, the
+ * environment variables are added on top of them.
+ *
+ * @public @memberof u_frame_pool
+ */
+struct u_frame_pool *
+u_frame_pool_create_with_flags(uint32_t max_free_frames, enum u_frame_pool_flags flags);
+
+/*!
+ * Same as @ref u_frame_create_one_off but reuses a free frame of the same
+ * format and size if there is one, the pixel data is not cleared. If
+ * @p ufp is NULL a one off frame is created.
+ *
+ * @public @memberof u_frame_pool
+ */
+void
+u_frame_pool_create_frame(struct u_frame_pool *ufp,
+                          enum xrt_format f,
+                          uint32_t width,
+                          uint32_t height,
+                          struct xrt_frame **out_frame);
+
+/*!
+ * Destroy the pool, frames still referenced are freed when released.
+ *
+ * @public @memberof u_frame_pool
+ */
+void
+u_frame_pool_destroy(struct u_frame_pool **ufp_ptr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,6 +3,10 @@
 /*!
  * @file
  * @brief  Hashmap for integer values header.
+ *
+ * Flat open addressing table with linear probing, erase shifts entries back
+ * so no tombstones are needed.
+ *
  * @author Jakob Bornecrantz <jakob@collabora.com>
  * @author Korcan Hussein <korcan.hussein@collabora.com>
  * @ingroup aux_util
@@ -10,7 +14,6 @@
 
 #include "util/u_hashmap.h"
 
-#include <unordered_map>
 #include <vector>
 
 
@@ -20,12 +23,75 @@
  *
  */
 
+//! Size of the table when the first item is inserted, must be a power of two.
+#define INITIAL_CAPACITY (16)
+
+namespace {
+
+struct slot
+{
+	uint64_t key;
+	void *value;
+	bool used;
+};
+
+} // namespace
+
 struct u_hashmap_int
 {
-	std::unordered_map<uint64_t, void *> map = {};
+	//! Power of two sized, or empty before the first insert.
+	std::vector<slot> slots = {};
+
+	size_t count = 0;
 };
 
 
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+//! Keys are often small or sequential ids, so mix them up well.
+static inline size_t
+hash_key(uint64_t key)
+{
+	key ^= key >> 33;
+	key *= UINT64_C(0xff51afd7ed558ccd);
+	key ^= key >> 33;
+	key *= UINT64_C(0xc4ceb9fe1a85ec53);
+	key ^= key >> 33;
+	return (size_t)key;
+}
+
+//! Returns the index of the key, or of the empty slot where it would go.
+static inline size_t
+probe(const u_hashmap_int &hmi, uint64_t key)
+{
+	size_t mask = hmi.slots.size() - 1;
+	size_t i = hash_key(key) & mask;
+
+	while (hmi.slots[i].used && hmi.slots[i].key != key) {
+		i = (i + 1) & mask;
+	}
+
+	return i;
+}
+
+static void
+grow(u_hashmap_int &hmi)
+{
+	std::vector<slot> old = std::move(hmi.slots);
+	hmi.slots = std::vector<slot>(old.empty() ? INITIAL_CAPACITY : old.size() * 2, slot{0, nullptr, false});
+
+	for (const slot &s : old) {
+		if (s.used) {
+			hmi.slots[probe(hmi, s.key)] = s;
+		}
+	}
+}
+
+
 /*
  *
  * "Exported" functions.
@@ -51,10 +117,13 @@ u_hashmap_int_destroy(struct u_hashmap_int **hmi)
 int
 u_hashmap_int_find(struct u_hashmap_int *hmi, uint64_t key, void **out_item)
 {
-	auto search = hmi->map.find(key);
+	if (hmi->count == 0) {
+		return -1;
+	}
 
-	if (search != hmi->map.end()) {
-		*out_item = search->second;
+	const slot &s = hmi->slots[probe(*hmi, key)];
+	if (s.used) {
+		*out_item = s.value;
 		return 0;
 	}
 	return -1;
@@ -63,21 +132,57 @@ u_hashmap_int_find(struct u_hashmap_int *hmi, uint64_t key, void **out_item)
 extern "C" int
 u_hashmap_int_insert(struct u_hashmap_int *hmi, uint64_t key, void *value)
 {
-	hmi->map[key] = value;
+	// Keep the load factor at or below 3/4.
+	if ((hmi->count + 1) * 4 > hmi->slots.size() * 3) {
+		grow(*hmi);
+	}
+
+	slot &s = hmi->slots[probe(*hmi, key)];
+	if (!s.used) {
+		s.used = true;
+		s.key = key;
+		hmi->count++;
+	}
+	s.value = value;
+
 	return 0;
 }
 
 extern "C" int
 u_hashmap_int_erase(struct u_hashmap_int *hmi, uint64_t key)
 {
-	hmi->map.erase(key);
+	if (hmi->count == 0) {
+		return 0;
+	}
+
+	size_t mask = hmi->slots.size() - 1;
+	size_t i = probe(*hmi, key);
+	if (!hmi->slots[i].used) {
+		return 0;
+	}
+
+	// Shift back following entries that would no longer be found.
+	for (size_t j = (i + 1) & mask; hmi->slots[j].used; j = (j + 1) & mask) {
+		size_t home = hash_key(hmi->slots[j].key) & mask;
+
+		// Can the entry at j move to i, is i cyclically within [home, j).
+		bool movable = i <= j ? (home <= i || home > j) : (home <= i && home > j);
+		if (movable) {
+			hmi->slots[i] = hmi->slots[j];
+			i = j;
+		}
+	}
+
+	hmi->slots[i].used = false;
+	hmi->count--;
+
 	return 0;
 }
 
 bool
 u_hashmap_int_empty(const struct u_hashmap_int *hmi)
 {
-	return hmi->map.empty();
+	return hmi->count == 0;
 }
 
 void
@@ -85,8 +190,10 @@ u_hashmap_int_for_each(const struct u_hashmap_int *hmi, u_hashmap_int_foreach_ca
 {
 	if (hmi == NULL || cb == NULL)
 		return;
-	for (const auto &keyval : hmi->map) {
-		cb(keyval.first, keyval.second, priv_ctx);
+	for (const slot &s : hmi->slots) {
+		if (s.used) {
+			cb(s.key, s.value, priv_ctx);
+		}
 	}
 }
 
@@ -94,13 +201,16 @@ extern "C" void
 u_hashmap_int_clear_and_call_for_each(struct u_hashmap_int *hmi, u_hashmap_int_callback cb, void *priv)
 {
 	std::vector<void *> tmp;
-	tmp.reserve(hmi->map.size());
+	tmp.reserve(hmi->count);
 
-	for (auto &n : hmi->map) {
-		tmp.push_back(n.second);
+	for (slot &s : hmi->slots) {
+		if (s.used) {
+			tmp.push_back(s.value);
+			s.used = false;
+		}
 	}
 
-	hmi->map.clear();
+	hmi->count = 0;
 
 	for (auto *n : tmp) {
 		cb(n, priv);
@@ -3,6 +3,11 @@
 /*!
  * @file
  * @brief  Hashset struct header.
+ *
+ * Flat open addressing table of item pointers with linear probing, the hash is
+ * stored in the items so lookups only hash the searched string and never
+ * allocate.
+ *
  * @author Jakob Bornecrantz <jakob@collabora.com>
  * @ingroup aux_util
  */
@@ -11,8 +16,7 @@
 #include "util/u_hashset.h"
 
 #include <cstring>
-#include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
 
@@ -22,12 +26,119 @@
  *
  */
 
+//! Size of the table when the first item is inserted, must be a power of two.
+#define INITIAL_CAPACITY (16)
+
 struct u_hashset
 {
-	std::unordered_map<std::string, struct u_hashset_item *> map = {};
+	//! Power of two sized, NULL for free slots, or empty before the first insert.
+	std::vector<struct u_hashset_item *> slots = {};
+
+	size_t count = 0;
 };
 
 
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static inline size_t
+hash_str(const char *str, size_t length)
+{
+	return std::hash<std::string_view>{}(std::string_view(str, length));
+}
+
+static inline bool
+item_equals(struct u_hashset_item *item, size_t hash, const char *str, size_t length)
+{
+	return item->hash == hash && item->length == length && memcmp(item->c_str(), str, length) == 0;
+}
+
+//! Returns the index of the string, or of the free slot where it would go.
+static inline size_t
+probe(const u_hashset &hs, size_t hash, const char *str, size_t length)
+{
+	size_t mask = hs.slots.size() - 1;
+	size_t i = hash & mask;
+
+	while (hs.slots[i] != NULL && !item_equals(hs.slots[i], hash, str, length)) {
+		i = (i + 1) & mask;
+	}
+
+	return i;
+}
+
+static void
+grow(u_hashset &hs)
+{
+	std::vector<struct u_hashset_item *> old = std::move(hs.slots);
+	hs.slots = std::vector<struct u_hashset_item *>(old.empty() ? INITIAL_CAPACITY : old.size() * 2, NULL);
+
+	size_t mask = hs.slots.size() - 1;
+	for (struct u_hashset_item *item : old) {
+		if (item == NULL) {
+			continue;
+		}
+
+		// All keys are unique, just find a free slot.
+		size_t i = item->hash & mask;
+		while (hs.slots[i] != NULL) {
+			i = (i + 1) & mask;
+		}
+		hs.slots[i] = item;
+	}
+}
+
+//! The item's hash must be set.
+static void
+insert(u_hashset &hs, struct u_hashset_item *item)
+{
+	// Keep the load factor at or below 3/4.
+	if ((hs.count + 1) * 4 > hs.slots.size() * 3) {
+		grow(hs);
+	}
+
+	size_t i = probe(hs, item->hash, item->c_str(), item->length);
+	if (hs.slots[i] == NULL) {
+		hs.count++;
+	}
+
+	// Replaces any item with the same string.
+	hs.slots[i] = item;
+}
+
+static void
+erase(u_hashset &hs, const char *str, size_t length)
+{
+	if (hs.count == 0) {
+		return;
+	}
+
+	size_t mask = hs.slots.size() - 1;
+	size_t i = probe(hs, hash_str(str, length), str, length);
+	if (hs.slots[i] == NULL) {
+		return;
+	}
+
+	// Shift back following items that would no longer be found.
+	for (size_t j = (i + 1) & mask; hs.slots[j] != NULL; j = (j + 1) & mask) {
+		size_t home = hs.slots[j]->hash & mask;
+
+		// Can the item at j move to i, is i cyclically within [home, j).
+		bool movable = i <= j ? (home <= i || home > j) : (home <= i && home > j);
+		if (movable) {
+			hs.slots[i] = hs.slots[j];
+			i = j;
+		}
+	}
+
+	hs.slots[i] = NULL;
+	hs.count--;
+}
+
+
 /*
  *
  * "Exported" functions.
@@ -53,11 +164,13 @@ u_hashset_destroy(struct u_hashset **hs)
 extern "C" int
 u_hashset_find_str(struct u_hashset *hs, const char *str, size_t length, struct u_hashset_item **out_item)
 {
-	std::string key = std::string(str, length);
-	auto search = hs->map.find(key);
+	if (hs->count == 0) {
+		return -1;
+	}
 
-	if (search != hs->map.end()) {
-		*out_item = search->second;
+	struct u_hashset_item *item = hs->slots[probe(*hs, hash_str(str, length), str, length)];
+	if (item != NULL) {
+		*out_item = item;
 		return 0;
 	}
 	return -1;
@@ -73,8 +186,8 @@ u_hashset_find_c_str(struct u_hashset *hs, const char *c_str, struct u_hashset_i
 extern "C" int
 u_hashset_insert_item(struct u_hashset *hs, struct u_hashset_item *item)
 {
-	std::string key = std::string(item->c_str(), item->length);
-	hs->map[key] = item;
+	item->hash = hash_str(item->c_str(), item->length);
+	insert(*hs, item);
 	return 0;
 }
 
@@ -109,8 +222,8 @@ u_hashset_create_and_insert_str(struct u_hashset *hs, const char *str, size_t le
 	}
 	store[length] = '\0';
 
-	std::string key = std::string(item->c_str(), item->length);
-	hs->map[key] = item;
+	item->hash = hash_str(item->c_str(), item->length);
+	insert(*hs, item);
 
 	*out_item = item;
 
@@ -127,16 +240,14 @@ u_hashset_create_and_insert_str_c(struct u_hashset *hs, const char *c_str, struc
 extern "C" int
 u_hashset_erase_item(struct u_hashset *hs, struct u_hashset_item *item)
 {
-	std::string key = std::string(item->c_str(), item->length);
-	hs->map.erase(key);
+	erase(*hs, item->c_str(), item->length);
 	return 0;
 }
 
 extern "C" int
 u_hashset_erase_str(struct u_hashset *hs, const char *str, size_t length)
 {
-	std::string key = std::string(str, length);
-	hs->map.erase(key);
+	erase(*hs, str, length);
 	return 0;
 }
 
@@ -151,13 +262,16 @@ extern "C" void
 u_hashset_clear_and_call_for_each(struct u_hashset *hs, u_hashset_callback cb, void *priv)
 {
 	std::vector<struct u_hashset_item *> tmp;
-	tmp.reserve(hs->map.size());
+	tmp.reserve(hs->count);
 
-	for (auto &n : hs->map) {
-		tmp.push_back(n.second);
+	for (struct u_hashset_item *&item : hs->slots) {
+		if (item != NULL) {
+			tmp.push_back(item);
+			item = NULL;
+		}
 	}
 
-	hs->map.clear();
+	hs->count = 0;
 
 	for (auto *n : tmp) {
 		cb(n, priv);
@@ -35,6 +35,7 @@ struct u_hashset;
  */
 struct u_hashset_item
 {
+	//! Hash of the string, set by the hashset when inserted.
 	size_t hash;
 	size_t length;
 
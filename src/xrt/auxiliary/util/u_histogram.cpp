@@ -0,0 +1,195 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Constant memory streaming histogram for percentiles of nano-second values.
+ *
+ * Values below 2^(bits + 1) get a bucket each, after that each power of two
+ * range gets 2^bits buckets. With the top set bit at position msb the index is
+ * `(msb - bits) * 2^bits + (value >> (msb - bits))`, which is continuous with
+ * the linear part.
+ *
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "u_histogram.h"
+
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+
+#define SUB_COUNT (1u << U_HIST_NS_SUB_BUCKET_BITS)
+
+struct u_hist_ns
+{
+	std::atomic<uint64_t> sum{0};
+	std::atomic<uint64_t> max{0};
+	std::atomic<uint64_t> buckets[U_HIST_NS_BUCKET_COUNT] = {};
+};
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static uint32_t
+top_bit(uint64_t value)
+{
+	uint32_t bit = 0;
+	for (uint32_t shift = 32; shift > 0; shift /= 2) {
+		if (value >> shift) {
+			value >>= shift;
+			bit += shift;
+		}
+	}
+	return bit;
+}
+
+static uint32_t
+bucket_index(uint64_t value)
+{
+	if (value < 2 * SUB_COUNT) {
+		return (uint32_t)value;
+	}
+
+	uint32_t msb = top_bit(value);
+	if (msb > U_HIST_NS_MAX_BIT) {
+		return U_HIST_NS_BUCKET_COUNT - 1;
+	}
+
+	uint32_t shift = msb - U_HIST_NS_SUB_BUCKET_BITS;
+	return shift * SUB_COUNT + (uint32_t)(value >> shift);
+}
+
+//! Middle of the range of values that goes into the bucket.
+static uint64_t
+bucket_value(uint32_t index)
+{
+	if (index < 2 * SUB_COUNT) {
+		return index;
+	}
+
+	uint32_t shift = index / SUB_COUNT - 1;
+	uint64_t lower = (uint64_t)(index - shift * SUB_COUNT) << shift;
+	return lower + ((1ull << shift) - 1) / 2;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+extern "C" struct u_hist_ns *
+u_hist_ns_create(void)
+{
+	return new u_hist_ns();
+}
+
+extern "C" void
+u_hist_ns_add(struct u_hist_ns *uhn, uint64_t value)
+{
+	/*
+	 * Only one thread adds, so plain loads and stores are enough and
+	 * cheaper than read-modify-write operations. Readers only need to see
+	 * each counter change atomically.
+	 */
+	std::atomic<uint64_t> &bucket = uhn->buckets[bucket_index(value)];
+	bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	uhn->sum.store(uhn->sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+
+	if (value > uhn->max.load(std::memory_order_relaxed)) {
+		uhn->max.store(value, std::memory_order_relaxed);
+	}
+}
+
+extern "C" void
+u_hist_ns_get_snapshot(struct u_hist_ns *uhn, struct u_hist_ns_snapshot *out_snapshot)
+{
+	uint64_t count = 0;
+	for (uint32_t i = 0; i < U_HIST_NS_BUCKET_COUNT; i++) {
+		uint64_t value = uhn->buckets[i].load(std::memory_order_relaxed);
+		out_snapshot->buckets[i] = value;
+		count += value;
+	}
+
+	// Counted from the buckets so it always matches them.
+	out_snapshot->count = count;
+	out_snapshot->sum = uhn->sum.load(std::memory_order_relaxed);
+	out_snapshot->max = uhn->max.load(std::memory_order_relaxed);
+}
+
+extern "C" void
+u_hist_ns_destroy(struct u_hist_ns **uhn_ptr)
+{
+	delete *uhn_ptr;
+	*uhn_ptr = NULL;
+}
+
+extern "C" void
+u_hist_ns_snapshot_merge(struct u_hist_ns_snapshot *dst, const struct u_hist_ns_snapshot *src)
+{
+	for (uint32_t i = 0; i < U_HIST_NS_BUCKET_COUNT; i++) {
+		dst->buckets[i] += src->buckets[i];
+	}
+
+	dst->count += src->count;
+	dst->sum += src->sum;
+	dst->max = std::max(dst->max, src->max);
+}
+
+extern "C" void
+u_hist_ns_snapshot_subtract(struct u_hist_ns_snapshot *dst, const struct u_hist_ns_snapshot *old)
+{
+	for (uint32_t i = 0; i < U_HIST_NS_BUCKET_COUNT; i++) {
+		dst->buckets[i] -= std::min(dst->buckets[i], old->buckets[i]);
+	}
+
+	dst->count -= std::min(dst->count, old->count);
+	dst->sum -= std::min(dst->sum, old->sum);
+}
+
+extern "C" uint64_t
+u_hist_ns_snapshot_get_percentile(const struct u_hist_ns_snapshot *snapshot, double percentile)
+{
+	if (snapshot->count == 0) {
+		return 0;
+	}
+
+	// Nearest rank, one based.
+	double fraction = std::min(std::max(percentile, 0.0), 100.0) / 100.0;
+	uint64_t rank = std::max((uint64_t)std::ceil(fraction * (double)snapshot->count), (uint64_t)1);
+
+	uint64_t seen = 0;
+	for (uint32_t i = 0; i < U_HIST_NS_BUCKET_COUNT; i++) {
+		seen += snapshot->buckets[i];
+		if (seen >= rank) {
+			// The middle of the bucket might be past the biggest value.
+			return std::min(bucket_value(i), snapshot->max);
+		}
+	}
+
+	return snapshot->max;
+}
+
+extern "C" void
+u_hist_ns_snapshot_get_stats(const struct u_hist_ns_snapshot *snapshot, struct u_hist_ns_stats *out_stats)
+{
+	if (snapshot->count == 0) {
+		*out_stats = {};
+		return;
+	}
+
+	out_stats->count = snapshot->count;
+	out_stats->mean = snapshot->sum / snapshot->count;
+	out_stats->p50 = u_hist_ns_snapshot_get_percentile(snapshot, 50.0);
+	out_stats->p90 = u_hist_ns_snapshot_get_percentile(snapshot, 90.0);
+	out_stats->p99 = u_hist_ns_snapshot_get_percentile(snapshot, 99.0);
+	out_stats->p99_9 = u_hist_ns_snapshot_get_percentile(snapshot, 99.9);
+	out_stats->worst = u_hist_ns_snapshot_get_percentile(snapshot, 100.0);
+}
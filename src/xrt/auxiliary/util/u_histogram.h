@@ -0,0 +1,157 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Constant memory streaming histogram for percentiles of nano-second values.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * Each power of two range is split into 2^bits buckets, giving a relative error
+ * of at most 1 / 2^bits, about 1.6%.
+ *
+ * @ingroup aux_util
+ */
+#define U_HIST_NS_SUB_BUCKET_BITS (6)
+
+/*!
+ * Highest bit of values that are tracked exactly, bigger values (over 18
+ * minutes) end up in the last bucket.
+ *
+ * @ingroup aux_util
+ */
+#define U_HIST_NS_MAX_BIT (39)
+
+/*!
+ * Total number of buckets of the histogram.
+ *
+ * @ingroup aux_util
+ */
+#define U_HIST_NS_BUCKET_COUNT ((U_HIST_NS_MAX_BIT - U_HIST_NS_SUB_BUCKET_BITS + 2) << U_HIST_NS_SUB_BUCKET_BITS)
+
+/*!
+ * Log-linear histogram (like HdrHistogram) of nano-second values, unlike
+ * @ref u_live_stats_ns it is never full and doesn't need sorting to get the
+ * percentiles. Can be added to from one thread while any other threads take
+ * snapshots of it, without any locking.
+ *
+ * @ingroup aux_util
+ */
+struct u_hist_ns;
+
+/*!
+ * A copy of the state of a @ref u_hist_ns, can be merged with other snapshots
+ * or subtracted from a newer one to get the values of an interval.
+ *
+ * @ingroup aux_util
+ */
+struct u_hist_ns_snapshot
+{
+	//! Number of values.
+	uint64_t count;
+
+	//! Sum of all values, for the mean.
+	uint64_t sum;
+
+	//! Biggest value ever added, not reduced by subtraction.
+	uint64_t max;
+
+	//! Number of values in each bucket.
+	uint64_t buckets[U_HIST_NS_BUCKET_COUNT];
+};
+
+/*!
+ * Summary of a snapshot, all values are zero if it has no values.
+ *
+ * @ingroup aux_util
+ */
+struct u_hist_ns_stats
+{
+	uint64_t count;
+	uint64_t mean;
+	uint64_t p50;
+	uint64_t p90;
+	uint64_t p99;
+	uint64_t p99_9;
+	uint64_t worst;
+};
+
+/*!
+ * Create a histogram.
+ *
+ * @public @memberof u_hist_ns
+ */
+struct u_hist_ns *
+u_hist_ns_create(void);
+
+/*!
+ * Add a value, must only be called from one thread at a time.
+ *
+ * @public @memberof u_hist_ns
+ */
+void
+u_hist_ns_add(struct u_hist_ns *uhn, uint64_t value);
+
+/*!
+ * Copy the current state, safe to call from any thread while values are added.
+ *
+ * @public @memberof u_hist_ns
+ */
+void
+u_hist_ns_get_snapshot(struct u_hist_ns *uhn, struct u_hist_ns_snapshot *out_snapshot);
+
+/*!
+ * Destroy the histogram.
+ *
+ * @public @memberof u_hist_ns
+ */
+void
+u_hist_ns_destroy(struct u_hist_ns **uhn_ptr);
+
+/*!
+ * Add all values of @p src to @p dst.
+ *
+ * @public @memberof u_hist_ns_snapshot
+ */
+void
+u_hist_ns_snapshot_merge(struct u_hist_ns_snapshot *dst, const struct u_hist_ns_snapshot *src);
+
+/*!
+ * Remove the values of the older snapshot @p old, of the same histogram, from
+ * @p dst leaving only the values added in between the two.
+ *
+ * @public @memberof u_hist_ns_snapshot
+ */
+void
+u_hist_ns_snapshot_subtract(struct u_hist_ns_snapshot *dst, const struct u_hist_ns_snapshot *old);
+
+/*!
+ * Get the value at @p percentile (0 to 100, nearest rank), returns 0 if there
+ * are no values.
+ *
+ * @public @memberof u_hist_ns_snapshot
+ */
+uint64_t
+u_hist_ns_snapshot_get_percentile(const struct u_hist_ns_snapshot *snapshot, double percentile);
+
+/*!
+ * Get the common percentiles, mean and worst value.
+ *
+ * @public @memberof u_hist_ns_snapshot
+ */
+void
+u_hist_ns_snapshot_get_stats(const struct u_hist_ns_snapshot *snapshot, struct u_hist_ns_stats *out_stats);
+
+
+#ifdef __cplusplus
+}
+#endif
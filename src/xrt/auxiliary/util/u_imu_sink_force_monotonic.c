@@ -27,28 +27,62 @@ struct u_imu_sink_force_monotonic
 	struct xrt_imu_sink *downstream;
 };
 
-static void
-split_sample(struct xrt_imu_sink *xfs, struct xrt_imu_sample *sample)
+//! Returns true and advances the last timestamp if @p sample may be passed on.
+static bool
+check_sample(struct u_imu_sink_force_monotonic *s, const struct xrt_imu_sample *sample)
 {
-	SINK_TRACE_MARKER();
-
-	struct u_imu_sink_force_monotonic *s = (struct u_imu_sink_force_monotonic *)xfs;
-
 	if (sample->timestamp_ns == s->last_ts) {
 		U_LOG_W("Got an IMU sample with a duplicate timestamp! Old: %" PRId64 "; New: %" PRId64 "", s->last_ts,
 		        sample->timestamp_ns);
-		return;
+		return false;
 	}
 	if (sample->timestamp_ns < s->last_ts) {
 		U_LOG_W("Got an IMU sample with a non-monotonically-increasing timestamp! Old: %" PRId64
 		        "; New: %" PRId64 "",
 		        s->last_ts, sample->timestamp_ns);
-		return;
+		return false;
 	}
 
 	s->last_ts = sample->timestamp_ns;
 
-	xrt_sink_push_imu(s->downstream, sample);
+	return true;
+}
+
+static void
+split_sample(struct xrt_imu_sink *xfs, struct xrt_imu_sample *sample)
+{
+	SINK_TRACE_MARKER();
+
+	struct u_imu_sink_force_monotonic *s = (struct u_imu_sink_force_monotonic *)xfs;
+
+	if (check_sample(s, sample)) {
+		xrt_sink_push_imu(s->downstream, sample);
+	}
+}
+
+static void
+split_samples(struct xrt_imu_sink *xfs, struct xrt_imu_sample *samples, uint32_t count)
+{
+	SINK_TRACE_MARKER();
+
+	struct u_imu_sink_force_monotonic *s = (struct u_imu_sink_force_monotonic *)xfs;
+
+	// Pass on runs of good samples as they are, only a bad sample splits the batch.
+	uint32_t start = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		if (check_sample(s, &samples[i])) {
+			continue;
+		}
+
+		if (i > start) {
+			xrt_sink_push_imu_batch(s->downstream, &samples[start], i - start);
+		}
+		start = i + 1;
+	}
+
+	if (count > start) {
+		xrt_sink_push_imu_batch(s->downstream, &samples[start], count - start);
+	}
 }
 
 static void
@@ -79,6 +113,7 @@ u_imu_sink_force_monotonic_create(struct xrt_frame_context *xfctx,
 
 	struct u_imu_sink_force_monotonic *s = U_TYPED_CALLOC(struct u_imu_sink_force_monotonic);
 	s->base.push_imu = split_sample;
+	s->base.push_imu_batch = split_samples;
 	s->node.break_apart = split_break_apart;
 	s->node.destroy = split_destroy;
 	s->downstream = downstream;
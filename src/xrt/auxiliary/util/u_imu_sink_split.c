@@ -36,6 +36,17 @@ split_sample(struct xrt_imu_sink *xfs, struct xrt_imu_sample *sample)
 	xrt_sink_push_imu(s->downstream_two, sample);
 }
 
+static void
+split_samples(struct xrt_imu_sink *xfs, struct xrt_imu_sample *samples, uint32_t count)
+{
+	SINK_TRACE_MARKER();
+
+	struct u_imu_sink_split *s = (struct u_imu_sink_split *)xfs;
+
+	xrt_sink_push_imu_batch(s->downstream_one, samples, count);
+	xrt_sink_push_imu_batch(s->downstream_two, samples, count);
+}
+
 static void
 split_break_apart(struct xrt_frame_node *node)
 {
@@ -65,6 +76,7 @@ u_imu_sink_split_create(struct xrt_frame_context *xfctx,
 
 	struct u_imu_sink_split *s = U_TYPED_CALLOC(struct u_imu_sink_split);
 	s->base.push_imu = split_sample;
+	s->base.push_imu_batch = split_samples;
 	s->node.break_apart = split_break_apart;
 	s->node.destroy = split_destroy;
 	s->downstream_one = downstream_one;
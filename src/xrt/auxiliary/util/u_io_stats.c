@@ -0,0 +1,178 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Health statistics for driver I/O threads.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "util/u_var.h"
+#include "util/u_misc.h"
+#include "util/u_time.h"
+#include "util/u_metrics.h"
+#include "util/u_io_stats.h"
+
+
+//! How often the values are published.
+#define PERIOD_NS (U_TIME_1S_IN_NS)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+end_period(struct u_io_stats *uis, uint64_t now_ns)
+{
+	uint64_t interval_mean_ns = 0;
+	if (uis->period.interval_count > 0) {
+		interval_mean_ns = uis->period.interval_sum_ns / uis->period.interval_count;
+	}
+
+	uint64_t process_mean_ns = 0;
+	if (uis->period.packet_count > 0) {
+		process_mean_ns = uis->period.process_sum_ns / uis->period.packet_count;
+	}
+
+	uis->interval_ms = (float)time_ns_to_ms_f((time_duration_ns)interval_mean_ns);
+	uis->interval_max_ms = (float)time_ns_to_ms_f((time_duration_ns)uis->period.interval_max_ns);
+	uis->process_us = (float)process_mean_ns / 1000.0f;
+	uis->process_max_us = (float)uis->period.process_max_ns / 1000.0f;
+	uis->backlog_max = uis->period.backlog_max;
+
+	if (u_metrics_is_active()) {
+		struct u_metrics_device_io_stats umdis = {
+		    .name = uis->name,
+		    .when_ns = now_ns,
+		    .period_ns = now_ns - uis->period.start_ns,
+		    .packet_count = uis->period.packet_count,
+		    .missed_count = uis->period.missed_count,
+		    .duplicate_count = uis->period.duplicate_count,
+		    .interval_mean_ns = interval_mean_ns,
+		    .interval_max_ns = uis->period.interval_max_ns,
+		    .process_mean_ns = process_mean_ns,
+		    .process_max_ns = uis->period.process_max_ns,
+		    .backlog_max = uis->period.backlog_max,
+		};
+
+		u_metrics_write_device_io_stats(&umdis);
+	}
+
+	U_ZERO(&uis->period);
+	uis->period.start_ns = now_ns;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+u_io_stats_init(struct u_io_stats *uis, const char *name)
+{
+	U_ZERO(uis);
+	uis->name = name;
+}
+
+void
+u_io_stats_add_vars(struct u_io_stats *uis, void *root)
+{
+	u_var_add_gui_header(root, NULL, uis->name);
+	u_var_add_ro_u64(root, &uis->packet_count, "Packets");
+	u_var_add_ro_u64(root, &uis->missed_count, "Missed (sequence)");
+	u_var_add_ro_u64(root, &uis->duplicate_count, "Duplicates (sequence)");
+	u_var_add_ro_f32(root, &uis->interval_ms, "Interval mean (ms)");
+	u_var_add_ro_f32(root, &uis->interval_max_ms, "Interval max (ms)");
+	u_var_add_ro_f32(root, &uis->process_us, "Processing mean (us)");
+	u_var_add_ro_f32(root, &uis->process_max_us, "Processing max (us)");
+	u_var_add_ro_u32(root, &uis->backlog_max, "Backlog max (packets)");
+}
+
+void
+u_io_stats_packet_begin(struct u_io_stats *uis, uint64_t now_ns)
+{
+	if (uis->period.start_ns == 0) {
+		uis->period.start_ns = now_ns;
+	}
+
+	if (uis->last_arrival_ns != 0 && now_ns >= uis->last_arrival_ns) {
+		uint64_t interval_ns = now_ns - uis->last_arrival_ns;
+
+		uis->period.interval_sum_ns += interval_ns;
+		uis->period.interval_count++;
+		if (interval_ns > uis->period.interval_max_ns) {
+			uis->period.interval_max_ns = interval_ns;
+		}
+	}
+
+	// The read returned right away, so the packet was waiting for us.
+	if (uis->last_end_ns != 0 && now_ns < uis->last_end_ns + U_IO_STATS_QUEUED_NS) {
+		uis->queued_run++;
+	} else {
+		uis->queued_run = 0;
+	}
+
+	if (uis->queued_run > uis->period.backlog_max) {
+		uis->period.backlog_max = uis->queued_run;
+	}
+
+	uis->last_arrival_ns = now_ns;
+	uis->begin_ns = now_ns;
+}
+
+void
+u_io_stats_packet_end(struct u_io_stats *uis, uint64_t now_ns)
+{
+	if (uis->begin_ns != 0 && now_ns >= uis->begin_ns) {
+		uint64_t process_ns = now_ns - uis->begin_ns;
+
+		uis->period.process_sum_ns += process_ns;
+		if (process_ns > uis->period.process_max_ns) {
+			uis->period.process_max_ns = process_ns;
+		}
+	}
+
+	uis->packet_count++;
+	uis->period.packet_count++;
+	uis->last_end_ns = now_ns;
+	uis->begin_ns = 0;
+
+	if (now_ns >= uis->period.start_ns + PERIOD_NS) {
+		end_period(uis, now_ns);
+	}
+}
+
+void
+u_io_stats_sequence(struct u_io_stats *uis, uint32_t seq, uint32_t mask)
+{
+	seq &= mask;
+
+	if (!uis->has_seq) {
+		uis->last_seq = seq;
+		uis->has_seq = true;
+		return;
+	}
+
+	uint32_t diff = (seq - uis->last_seq) & mask;
+
+	if (diff == 0) {
+		uis->duplicate_count++;
+		uis->period.duplicate_count++;
+		return;
+	}
+
+	// Going backwards, the device was probably reset, just resync.
+	if (diff > mask / 2) {
+		uis->last_seq = seq;
+		return;
+	}
+
+	uis->missed_count += diff - 1;
+	uis->period.missed_count += diff - 1;
+	uis->last_seq = seq;
+}
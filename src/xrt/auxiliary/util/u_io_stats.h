@@ -0,0 +1,132 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Health statistics for driver I/O threads.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * A packet that is read less than this long after the previous one was done
+ * being processed was already waiting, so the thread is behind.
+ *
+ * @ingroup aux_util
+ */
+#define U_IO_STATS_QUEUED_NS (100 * 1000)
+
+/*!
+ * Tracks how well a driver's I/O thread keeps up with its device: time
+ * between packets arriving, time spent processing each packet, how many
+ * packets were already queued up when read and sequence number gaps.
+ *
+ * Values are aggregated over a period of one second, then published to
+ * the fields shown by @ref u_io_stats_add_vars and written to the metrics
+ * stream. Must only be used from the I/O thread itself.
+ *
+ * @ingroup aux_util
+ */
+struct u_io_stats
+{
+	//! Used for the gui and metrics, not copied, so must outlive the stats.
+	const char *name;
+
+	//! @name Totals, since init.
+	//! @{
+	uint64_t packet_count;
+	uint64_t missed_count;
+	uint64_t duplicate_count;
+	//! @}
+
+	//! @name Values of the last period.
+	//! @{
+	float interval_ms;
+	float interval_max_ms;
+	float process_us;
+	float process_max_us;
+	uint32_t backlog_max;
+	//! @}
+
+	//! Accumulated for the current period.
+	struct
+	{
+		uint64_t start_ns;
+		uint32_t packet_count;
+		uint32_t interval_count;
+		uint32_t missed_count;
+		uint32_t duplicate_count;
+		uint64_t interval_sum_ns;
+		uint64_t interval_max_ns;
+		uint64_t process_sum_ns;
+		uint64_t process_max_ns;
+		uint32_t backlog_max;
+	} period;
+
+	uint64_t last_arrival_ns;
+	uint64_t last_end_ns;
+	uint64_t begin_ns;
+
+	//! Number of packets in a row that were already queued when read.
+	uint32_t queued_run;
+
+	uint32_t last_seq;
+	bool has_seq;
+};
+
+/*!
+ * Init the stats, @p name must outlive them.
+ *
+ * @public @memberof u_io_stats
+ */
+void
+u_io_stats_init(struct u_io_stats *uis, const char *name);
+
+/*!
+ * Adds the stats to an existing @ref u_var root, under a header.
+ *
+ * @public @memberof u_io_stats
+ */
+void
+u_io_stats_add_vars(struct u_io_stats *uis, void *root);
+
+/*!
+ * A packet has been read, call as soon after the read returned as possible.
+ *
+ * @public @memberof u_io_stats
+ */
+void
+u_io_stats_packet_begin(struct u_io_stats *uis, uint64_t now_ns);
+
+/*!
+ * The packet read in @ref u_io_stats_packet_begin has been processed, ends
+ * the period and publishes the values if it has run long enough.
+ *
+ * @public @memberof u_io_stats
+ */
+void
+u_io_stats_packet_end(struct u_io_stats *uis, uint64_t now_ns);
+
+/*!
+ * Record the sequence number of a packet, or of a sample inside of one. The
+ * number wraps at @p mask, so 0xff for an 8 bit counter. Only call for
+ * devices that have one.
+ *
+ * @public @memberof u_io_stats
+ */
+void
+u_io_stats_sequence(struct u_io_stats *uis, uint32_t seq, uint32_t mask);
+
+
+#ifdef __cplusplus
+}
+#endif
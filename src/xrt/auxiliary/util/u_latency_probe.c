@@ -0,0 +1,107 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Distribution of the latency from a pose being sampled to it being shown.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "util/u_misc.h"
+#include "util/u_time.h"
+#include "util/u_debug.h"
+#include "util/u_logging.h"
+#include "util/u_latency_probe.h"
+
+#include <stdlib.h>
+#include <inttypes.h>
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(latency_probe, "XRT_LATENCY_PROBE", false)
+
+//! How often the distribution is logged.
+#define PERIOD_NS (10 * (uint64_t)U_TIME_1S_IN_NS)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+log_period(struct u_latency_probe *ulp, uint64_t period_ns)
+{
+	// Too big for the stack.
+	struct u_hist_ns_snapshot *period = U_TYPED_CALLOC(struct u_hist_ns_snapshot);
+	struct u_hist_ns_stats stats;
+
+	// Only keep the values of this period, then make last equal to now again.
+	u_hist_ns_get_snapshot(ulp->hist, period);
+	u_hist_ns_snapshot_subtract(period, &ulp->last);
+	u_hist_ns_snapshot_merge(&ulp->last, period);
+
+	u_hist_ns_snapshot_get_stats(period, &stats);
+
+	U_LOG_I("Latency %s over %.1fs, %" PRIu64 " frames: mean %.2fms p50 %.2fms p90 %.2fms p99 %.2fms worst %.2fms",
+	        ulp->name, time_ns_to_s((time_duration_ns)period_ns), stats.count,
+	        time_ns_to_ms_f((time_duration_ns)stats.mean), time_ns_to_ms_f((time_duration_ns)stats.p50),
+	        time_ns_to_ms_f((time_duration_ns)stats.p90), time_ns_to_ms_f((time_duration_ns)stats.p99),
+	        time_ns_to_ms_f((time_duration_ns)stats.worst));
+
+	free(period);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+bool
+u_latency_probe_enabled(void)
+{
+	return debug_get_bool_option_latency_probe();
+}
+
+void
+u_latency_probe_init(struct u_latency_probe *ulp, const char *name)
+{
+	U_ZERO(ulp);
+	ulp->name = name;
+	ulp->hist = u_hist_ns_create();
+}
+
+void
+u_latency_probe_add(struct u_latency_probe *ulp, uint64_t sample_ns, uint64_t photon_ns)
+{
+	// Not inited, or a pose from a time we can't reason about.
+	if (ulp->hist == NULL || sample_ns == 0 || photon_ns < sample_ns) {
+		return;
+	}
+
+	u_hist_ns_add(ulp->hist, photon_ns - sample_ns);
+
+	if (ulp->period_start_ns == 0) {
+		ulp->period_start_ns = sample_ns;
+		return;
+	}
+
+	if (sample_ns < ulp->period_start_ns + PERIOD_NS) {
+		return;
+	}
+
+	uint64_t period_ns = sample_ns - ulp->period_start_ns;
+
+	log_period(ulp, period_ns);
+
+	ulp->period_start_ns = sample_ns;
+}
+
+void
+u_latency_probe_fini(struct u_latency_probe *ulp)
+{
+	// Does null checking.
+	u_hist_ns_destroy(&ulp->hist);
+}
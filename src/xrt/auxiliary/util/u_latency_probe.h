@@ -0,0 +1,83 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Distribution of the latency from a pose being sampled to it being shown.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include "util/u_histogram.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Collects how long it takes from a pose being sampled to the frame using it
+ * reaching the display, and logs the distribution of it periodically. One is
+ * made for each path a pose can take, like the app rendering with it or the
+ * compositor timewarping with it.
+ *
+ * @ingroup aux_util
+ */
+struct u_latency_probe
+{
+	//! Used when logging, not copied, so must outlive the probe.
+	const char *name;
+
+	//! Only added to from one thread.
+	struct u_hist_ns *hist;
+
+	//! State at the last log, subtracted to get the values of the period.
+	struct u_hist_ns_snapshot last;
+
+	//! Start of the current period, zero before the first sample.
+	uint64_t period_start_ns;
+};
+
+/*!
+ * Is the latency probe mode on, controlled by the `XRT_LATENCY_PROBE`
+ * environment variable. Users only set up their probes if this is true.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_latency_probe_enabled(void);
+
+/*!
+ * Init the probe, @p name must outlive it.
+ *
+ * @public @memberof u_latency_probe
+ */
+void
+u_latency_probe_init(struct u_latency_probe *ulp, const char *name);
+
+/*!
+ * Add the latency of one frame, @p sample_ns is when the pose was sampled
+ * and @p photon_ns when the frame is shown. Logs the distribution once per
+ * period, must only be called from one thread at a time.
+ *
+ * @public @memberof u_latency_probe
+ */
+void
+u_latency_probe_add(struct u_latency_probe *ulp, uint64_t sample_ns, uint64_t photon_ns);
+
+/*!
+ * Free all resources of the probe, safe to call on a zeroed probe.
+ *
+ * @public @memberof u_latency_probe
+ */
+void
+u_latency_probe_fini(struct u_latency_probe *ulp);
+
+
+#ifdef __cplusplus
+}
+#endif
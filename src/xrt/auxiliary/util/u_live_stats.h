@@ -35,6 +35,9 @@ extern "C" {
  * Struct to do live statistic tracking and printing of nano-seconds values,
  * used by amongst other the compositor pacing code.
  *
+ * Can only hold @ref U_LIVE_STATS_VALUE_COUNT values, use @ref u_hist_ns for
+ * an unbounded number of values or when reading often.
+ *
  * @ingroup aux_util
  */
 struct u_live_stats_ns
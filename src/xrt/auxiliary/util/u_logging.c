@@ -12,6 +12,7 @@
 #include "xrt/xrt_config_build.h"
 
 #include "util/u_debug.h"
+#include "util/u_logging_async.h"
 #include "u_json.h"
 #include "util/u_truncate_printf.h"
 
@@ -58,6 +59,8 @@
 
 DEBUG_GET_ONCE_LOG_OPTION(global_log, "XRT_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_BOOL_OPTION(json_log, "XRT_JSON_LOG", false)
+DEBUG_GET_ONCE_BOOL_OPTION(async_log, "XRT_LOG_ASYNC", false)
+DEBUG_GET_ONCE_BOOL_OPTION(async_log_block, "XRT_LOG_ASYNC_BLOCK", false)
 
 enum u_logging_level
 u_log_get_global_level(void)
@@ -396,6 +399,12 @@ do_print(const char *file, int line, const char *func, enum u_logging_level leve
 	OutputDebugStringA(storage);
 #endif
 
+	// Formatted on this thread, but written out by the writer thread.
+	if (debug_get_bool_option_async_log() &&
+	    u_log_async_push(storage, printed, debug_get_bool_option_async_log_block())) {
+		return printed;
+	}
+
 	fwrite(storage, printed, 1, stderr);
 
 #else
@@ -412,6 +421,14 @@ do_print(const char *file, int line, const char *func, enum u_logging_level leve
  *
  */
 
+void
+u_log_flush(void)
+{
+	if (debug_get_bool_option_async_log()) {
+		u_log_async_flush();
+	}
+}
+
 void
 u_log(const char *file, int line, const char *func, enum u_logging_level level, const char *format, ...)
 {
@@ -269,6 +269,17 @@ u_log_xdev_hex(const char *file,
 void
 u_log_set_sink(u_log_sink_func_t func, void *data);
 
+/*!
+ * Make sure all messages logged so far have been written out. Only does
+ * anything with the asynchronous backend, which is turned on by setting the
+ * `XRT_LOG_ASYNC` env variable. With it messages are formatted on the logging
+ * thread and written by a background thread, messages from different threads
+ * might be written out of order. When a thread logs faster then the writer
+ * keeps up messages are dropped, unless `XRT_LOG_ASYNC_BLOCK` is set.
+ */
+void
+u_log_flush(void);
+
 /*!
  * @}
  */
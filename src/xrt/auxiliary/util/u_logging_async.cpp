@@ -0,0 +1,307 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Asynchronous logging backend.
+ *
+ * Each logging thread gets its own single producer single consumer ring of
+ * already formatted messages, a writer thread drains all of the rings to
+ * stderr. Logging never takes a lock, except the first time a thread logs.
+ *
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_log
+ */
+
+#include "util/u_logging_async.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+//! Per thread ring size, must be a power of two.
+#define RING_SIZE (64 * 1024)
+
+//! Messages are truncated to this, so a single message can't fill a ring.
+#define MAX_RECORD_SIZE (RING_SIZE / 4)
+
+//! How often the writer checks for messages when not woken up.
+#define WRITER_TIMEOUT_MS (10)
+
+
+namespace {
+
+struct ring
+{
+	//! Only written by the logging thread.
+	std::atomic<uint64_t> head{0};
+
+	//! Only written by the writer, for the logging thread to see free space.
+	std::atomic<uint64_t> tail{0};
+
+	//! Messages dropped because the ring was full.
+	std::atomic<uint64_t> dropped{0};
+
+	//! The thread has exited, free when drained.
+	std::atomic<bool> abandoned{false};
+
+	char data[RING_SIZE];
+};
+
+struct writer
+{
+	//! Protects the list of rings and makes sure only one thread drains.
+	std::mutex mutex = {};
+	std::condition_variable cond = {};
+
+	std::vector<ring *> rings = {};
+
+	//! Is the writer waiting on @ref cond.
+	std::atomic<bool> sleeping{false};
+
+	std::atomic<bool> running{false};
+
+	std::thread thread = {};
+
+	//! Where the writer batches up messages before writing them.
+	char batch[RING_SIZE];
+};
+
+/*!
+ * Owned by the thread, marks the ring as abandoned when the thread goes away.
+ */
+struct ring_holder
+{
+	ring *r = nullptr;
+
+	~ring_holder()
+	{
+		if (r != nullptr) {
+			r->abandoned.store(true, std::memory_order_release);
+		}
+	}
+};
+
+std::once_flag g_once;
+
+/*!
+ * Never freed, logging can happen during static destruction, after being
+ * stopped messages are printed synchronously again.
+ */
+std::atomic<writer *> g_writer{nullptr};
+
+thread_local ring_holder t_ring;
+
+} // namespace
+
+
+/*
+ *
+ * Writer functions.
+ *
+ */
+
+static void
+copy_out(const ring *r, uint64_t pos, void *dst, size_t size)
+{
+	size_t offset = (size_t)(pos & (RING_SIZE - 1));
+	size_t first = size < RING_SIZE - offset ? size : RING_SIZE - offset;
+
+	memcpy(dst, r->data + offset, first);
+	memcpy((char *)dst + first, r->data, size - first);
+}
+
+static void
+copy_in(ring *r, uint64_t pos, const void *src, size_t size)
+{
+	size_t offset = (size_t)(pos & (RING_SIZE - 1));
+	size_t first = size < RING_SIZE - offset ? size : RING_SIZE - offset;
+
+	memcpy(r->data + offset, src, first);
+	memcpy(r->data, (const char *)src + first, size - first);
+}
+
+//! Must be called with the lock held, returns true if anything was written.
+static bool
+drain_locked(writer &w)
+{
+	bool wrote = false;
+	size_t batch_size = 0;
+
+	for (auto it = w.rings.begin(); it != w.rings.end();) {
+		ring *r = *it;
+
+		// Load abandoned first, so no message written before it is missed.
+		bool abandoned = r->abandoned.load(std::memory_order_acquire);
+		uint64_t tail = r->tail.load(std::memory_order_relaxed);
+		uint64_t head = r->head.load(std::memory_order_acquire);
+
+		while (tail < head) {
+			uint32_t size = 0;
+			copy_out(r, tail, &size, sizeof(size));
+
+			if (batch_size + size > sizeof(w.batch)) {
+				fwrite(w.batch, batch_size, 1, stderr);
+				batch_size = 0;
+			}
+
+			copy_out(r, tail + sizeof(size), w.batch + batch_size, size);
+			batch_size += size;
+			tail += sizeof(size) + size;
+			wrote = true;
+		}
+
+		// Free the space for the logging thread.
+		r->tail.store(tail, std::memory_order_release);
+
+		uint64_t dropped = r->dropped.exchange(0, std::memory_order_relaxed);
+		if (dropped > 0) {
+			fwrite(w.batch, batch_size, 1, stderr);
+			batch_size = 0;
+			fprintf(stderr, "[u_logging] %llu messages were dropped!\n", (unsigned long long)dropped);
+			wrote = true;
+		}
+
+		if (abandoned) {
+			delete r;
+			it = w.rings.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	if (batch_size > 0) {
+		fwrite(w.batch, batch_size, 1, stderr);
+	}
+
+	return wrote;
+}
+
+static void
+writer_run(writer *w)
+{
+	std::unique_lock<std::mutex> lock(w->mutex);
+
+	while (w->running.load()) {
+		if (drain_locked(*w)) {
+			continue;
+		}
+
+		w->sleeping.store(true);
+		w->cond.wait_for(lock, std::chrono::milliseconds(WRITER_TIMEOUT_MS));
+		w->sleeping.store(false);
+	}
+
+	// Last messages.
+	drain_locked(*w);
+}
+
+static void
+writer_stop(void)
+{
+	writer *w = g_writer.load();
+
+	{
+		std::unique_lock<std::mutex> lock(w->mutex);
+		w->running.store(false);
+	}
+	w->cond.notify_one();
+
+	if (w->thread.joinable()) {
+		w->thread.join();
+	}
+}
+
+static void
+writer_start(void)
+{
+	writer *w = new writer();
+	w->running.store(true);
+	w->thread = std::thread(writer_run, w);
+
+	g_writer.store(w);
+
+	// Drain and stop before the process goes away.
+	atexit(writer_stop);
+}
+
+static ring *
+get_ring(writer &w)
+{
+	if (t_ring.r != nullptr) {
+		return t_ring.r;
+	}
+
+	ring *r = new ring();
+
+	std::unique_lock<std::mutex> lock(w.mutex);
+	w.rings.push_back(r);
+	t_ring.r = r;
+
+	return r;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+extern "C" bool
+u_log_async_push(const char *str, size_t size, bool block)
+{
+	std::call_once(g_once, writer_start);
+
+	writer &w = *g_writer.load(std::memory_order_relaxed);
+	if (!w.running.load(std::memory_order_relaxed)) {
+		return false;
+	}
+
+	if (size > MAX_RECORD_SIZE) {
+		size = MAX_RECORD_SIZE;
+	}
+
+	ring *r = get_ring(w);
+	uint32_t record_size = (uint32_t)size;
+	uint64_t needed = sizeof(record_size) + size;
+	uint64_t head = r->head.load(std::memory_order_relaxed);
+
+	while (RING_SIZE - (head - r->tail.load(std::memory_order_acquire)) < needed) {
+		if (!block || !w.running.load(std::memory_order_relaxed)) {
+			r->dropped.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		w.cond.notify_one();
+		std::this_thread::yield();
+	}
+
+	copy_in(r, head, &record_size, sizeof(record_size));
+	copy_in(r, head + sizeof(record_size), str, size);
+	r->head.store(head + needed, std::memory_order_release);
+
+	if (w.sleeping.load(std::memory_order_relaxed)) {
+		w.cond.notify_one();
+	}
+
+	return true;
+}
+
+extern "C" void
+u_log_async_flush(void)
+{
+	writer *w = g_writer.load();
+	if (w == nullptr) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(w->mutex);
+	drain_locked(*w);
+}
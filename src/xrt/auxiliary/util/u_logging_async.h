@@ -0,0 +1,45 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Asynchronous logging backend, internal to the logging code.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_log
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Queue an already formatted message to be written to stderr by the writer
+ * thread, starts the thread on first use. When the calling thread's ring is
+ * full the message is either dropped and counted or, if @p block is set, it
+ * waits for the writer to make room.
+ *
+ * Returns false if the backend has been stopped, the caller should then print
+ * the message itself.
+ *
+ * @ingroup aux_log
+ */
+bool
+u_log_async_push(const char *str, size_t size, bool block);
+
+/*!
+ * Write out all messages queued so far, from the calling thread.
+ *
+ * @ingroup aux_log
+ */
+void
+u_log_async_flush(void);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,27 +7,29 @@
  * @ingroup aux_util
  */
 
-#include "os/os_threading.h"
-
 #include "util/u_metrics.h"
+#include "util/u_metrics_writer.h"
 #include "util/u_debug.h"
 
 #include "monado_metrics.pb.h"
 #include "pb_encode.h"
 
+#include <assert.h>
 #include <stdio.h>
 
 #define VERSION_MAJOR 1
-#define VERSION_MINOR 1
+#define VERSION_MINOR 3
 
 static FILE *g_file = NULL;
-static struct os_mutex g_file_mutex;
+static struct u_metrics_writer *g_writer = NULL;
 static bool g_metrics_initialized = false;
-static bool g_metrics_early_flush = false;
 
 DEBUG_GET_ONCE_OPTION(metrics_file, "XRT_METRICS_FILE", NULL)
+DEBUG_GET_ONCE_OPTION(metrics_socket, "XRT_METRICS_SOCKET", NULL)
 DEBUG_GET_ONCE_BOOL_OPTION(metrics_early_flush, "XRT_METRICS_EARLY_FLUSH", false)
 
+static_assert(monado_metrics_Record_size + 10 <= U_METRICS_WRITER_MAX_RECORD_SIZE, "Metrics records too big");
+
 
 
 /*
@@ -49,15 +51,8 @@ write_record(monado_metrics_Record *r)
 		return;
 	}
 
-	os_mutex_lock(&g_file_mutex);
-
-	fwrite(buffer, stream.bytes_written, 1, g_file);
-
-	if (g_metrics_early_flush) {
-		fflush(g_file);
-	}
-
-	os_mutex_unlock(&g_file_mutex);
+	// Never blocks, the writer thread does the actual writing.
+	u_metrics_writer_push(g_writer, buffer, stream.bytes_written);
 }
 
 static void
@@ -88,25 +83,38 @@ void
 u_metrics_init(void)
 {
 	const char *str = debug_get_option_metrics_file();
-	if (str == NULL) {
-		U_LOG_D("No metrics file!");
+	const char *socket_path = debug_get_option_metrics_socket();
+	if (str == NULL && socket_path == NULL) {
+		U_LOG_D("No metrics file or socket!");
 		return;
 	}
 
-	g_file = fopen(str, "wb");
-	if (g_file == NULL) {
-		U_LOG_E("Could not open '%s'!", str);
-		return;
+	if (str != NULL) {
+		g_file = fopen(str, "wb");
+		if (g_file == NULL) {
+			U_LOG_E("Could not open '%s'!", str);
+		}
 	}
 
-	os_mutex_init(&g_file_mutex);
+	g_writer = u_metrics_writer_create(g_file, socket_path, debug_get_bool_option_metrics_early_flush());
+	if (g_writer == NULL) {
+		if (g_file != NULL) {
+			fclose(g_file);
+			g_file = NULL;
+		}
+		return;
+	}
 
 	g_metrics_initialized = true;
-	g_metrics_early_flush = debug_get_bool_option_metrics_early_flush();
 
 	write_version(VERSION_MAJOR, VERSION_MINOR);
 
-	U_LOG_I("Opened metrics file: '%s'", str);
+	if (g_file != NULL) {
+		U_LOG_I("Opened metrics file: '%s'", str);
+	}
+	if (socket_path != NULL) {
+		U_LOG_I("Streaming metrics to socket: '%s'", socket_path);
+	}
 }
 
 void
@@ -116,18 +124,18 @@ u_metrics_close(void)
 		return;
 	}
 
-	U_LOG_I("Closing metrics file: '%s'", debug_get_option_metrics_file());
+	U_LOG_I("Closing metrics");
 
-	// At least try to avoid races.
-	os_mutex_lock(&g_file_mutex);
-	fflush(g_file);
-	fclose(g_file);
-	g_file = NULL;
-	os_mutex_unlock(&g_file_mutex);
+	// At least try to avoid races, stop new records before the writer goes.
+	g_metrics_initialized = false;
 
-	os_mutex_destroy(&g_file_mutex);
+	// Writes out all queued records.
+	u_metrics_writer_destroy(&g_writer);
 
-	g_metrics_initialized = false;
+	if (g_file != NULL) {
+		fclose(g_file);
+		g_file = NULL;
+	}
 }
 
 bool
@@ -216,6 +224,26 @@ u_metrics_write_system_gpu_info(struct u_metrics_system_gpu_info *umgi)
 	write_record(&record);
 }
 
+void
+u_metrics_write_system_gpu_phase(struct u_metrics_system_gpu_phase *umgp)
+{
+	if (!g_metrics_initialized) {
+		return;
+	}
+
+	monado_metrics_Record record = monado_metrics_Record_init_default;
+
+	// Select which filed is used.
+	record.which_record = monado_metrics_Record_system_gpu_phase_tag;
+
+#define COPY(_0, _1, _2, _3, FIELD, _4) (record.record.system_gpu_phase.FIELD = umgp->FIELD);
+	monado_metrics_SystemGpuPhase_FIELDLIST(COPY, 0);
+#undef COPY
+
+
+	write_record(&record);
+}
+
 void
 u_metrics_write_system_present_info(struct u_metrics_system_present_info *umpi)
 {
@@ -233,5 +261,35 @@ u_metrics_write_system_present_info(struct u_metrics_system_present_info *umpi)
 #undef COPY
 
 
+	write_record(&record);
+}
+
+void
+u_metrics_write_device_io_stats(struct u_metrics_device_io_stats *umdis)
+{
+	if (!g_metrics_initialized) {
+		return;
+	}
+
+	monado_metrics_Record record = monado_metrics_Record_init_default;
+
+	// Select which filed is used.
+	record.which_record = monado_metrics_Record_device_io_stats_tag;
+
+	monado_metrics_DeviceIoStats *r = &record.record.device_io_stats;
+	snprintf(r->name, sizeof(r->name), "%s", umdis->name != NULL ? umdis->name : "");
+
+	r->when_ns = umdis->when_ns;
+	r->period_ns = umdis->period_ns;
+	r->packet_count = umdis->packet_count;
+	r->missed_count = umdis->missed_count;
+	r->duplicate_count = umdis->duplicate_count;
+	r->interval_mean_ns = umdis->interval_mean_ns;
+	r->interval_max_ns = umdis->interval_max_ns;
+	r->process_mean_ns = umdis->process_mean_ns;
+	r->process_max_ns = umdis->process_max_ns;
+	r->backlog_max = umdis->backlog_max;
+
+
 	write_record(&record);
 }
@@ -60,6 +60,32 @@ struct u_metrics_system_gpu_info
 	uint64_t when_ns;
 };
 
+struct u_metrics_system_gpu_phase
+{
+	int64_t frame_id;
+	uint32_t phase;
+	uint32_t view_index;
+	uint64_t gpu_start_ns;
+	uint64_t gpu_end_ns;
+	uint64_t when_ns;
+};
+
+struct u_metrics_device_io_stats
+{
+	//! Truncated to fit the record.
+	const char *name;
+	uint64_t when_ns;
+	uint64_t period_ns;
+	uint32_t packet_count;
+	uint32_t missed_count;
+	uint32_t duplicate_count;
+	uint64_t interval_mean_ns;
+	uint64_t interval_max_ns;
+	uint64_t process_mean_ns;
+	uint64_t process_max_ns;
+	uint32_t backlog_max;
+};
+
 struct u_metrics_system_present_info
 {
 	int64_t frame_id;
@@ -101,9 +127,15 @@ u_metrics_write_system_frame(struct u_metrics_system_frame *umsf);
 void
 u_metrics_write_system_gpu_info(struct u_metrics_system_gpu_info *umgi);
 
+void
+u_metrics_write_system_gpu_phase(struct u_metrics_system_gpu_phase *umgp);
+
 void
 u_metrics_write_system_present_info(struct u_metrics_system_present_info *umpi);
 
+void
+u_metrics_write_device_io_stats(struct u_metrics_device_io_stats *umdis);
+
 
 #ifdef __cplusplus
 }
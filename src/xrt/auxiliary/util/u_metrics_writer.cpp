@@ -0,0 +1,364 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Asynchronous writer of encoded metrics records.
+ *
+ * The queue is a bounded multi producer queue where each slot has a sequence
+ * number, producers claim a slot with a compare exchange and then publish it by
+ * bumping its sequence. Only the writer thread consumes.
+ *
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include "util/u_logging.h"
+#include "util/u_metrics_writer.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <string.h>
+
+#ifdef XRT_OS_UNIX
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+
+//! Number of records that can be queued, must be a power of two.
+#define QUEUE_SIZE (4096)
+
+//! Size of the writes done to the file and socket.
+#define BATCH_SIZE (64 * 1024)
+
+//! How often the writer wakes up if not woken by a filling queue.
+#define WRITER_TIMEOUT_MS (20)
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+
+namespace {
+
+struct slot
+{
+	//! Equal to the position when free, position plus one when filled.
+	std::atomic<uint64_t> seq{0};
+
+	uint32_t size = 0;
+	uint8_t data[U_METRICS_WRITER_MAX_RECORD_SIZE];
+};
+
+} // namespace
+
+struct u_metrics_writer
+{
+	std::vector<slot> slots = std::vector<slot>(QUEUE_SIZE);
+
+	//! Producers claim slots here, in the hot path.
+	alignas(64) std::atomic<uint64_t> enqueue_pos{0};
+
+	//! Only written by the writer thread.
+	alignas(64) std::atomic<uint64_t> dequeue_pos{0};
+
+	std::atomic<uint64_t> dropped{0};
+
+	//! Is the writer waiting on @ref cond.
+	std::atomic<bool> sleeping{false};
+
+	std::mutex mutex = {};
+	std::condition_variable cond = {};
+	bool running = false;
+
+	std::thread thread = {};
+
+	FILE *file = nullptr;
+	bool early_flush = false;
+
+	int socket_fd = -1;
+
+	uint8_t batch[BATCH_SIZE];
+};
+
+
+/*
+ *
+ * Output functions.
+ *
+ */
+
+#ifdef XRT_OS_UNIX
+
+static int
+open_socket(const char *path)
+{
+	struct sockaddr_un addr = {};
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		U_LOG_E("Metrics socket path too long: '%s'", path);
+		return -1;
+	}
+
+	int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		U_LOG_E("Could not create metrics socket: %s", strerror(errno));
+		return -1;
+	}
+
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		U_LOG_E("Could not connect to metrics socket '%s': %s", path, strerror(errno));
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+static void
+write_socket(u_metrics_writer &w, const uint8_t *data, size_t size)
+{
+	while (size > 0 && w.socket_fd >= 0) {
+		ssize_t ret = send(w.socket_fd, data, size, MSG_NOSIGNAL);
+		if (ret < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ret <= 0) {
+			U_LOG_W("Metrics socket closed: %s", ret < 0 ? strerror(errno) : "EOF");
+			close(w.socket_fd);
+			w.socket_fd = -1;
+			return;
+		}
+
+		data += ret;
+		size -= (size_t)ret;
+	}
+}
+
+static void
+close_socket(u_metrics_writer &w)
+{
+	if (w.socket_fd >= 0) {
+		close(w.socket_fd);
+		w.socket_fd = -1;
+	}
+}
+
+#else
+
+static int
+open_socket(const char *path)
+{
+	U_LOG_E("Metrics socket not supported on this platform, not streaming to '%s'", path);
+	return -1;
+}
+
+static void
+write_socket(u_metrics_writer &w, const uint8_t *data, size_t size)
+{
+	(void)w;
+	(void)data;
+	(void)size;
+}
+
+static void
+close_socket(u_metrics_writer &w)
+{
+	(void)w;
+}
+
+#endif
+
+static void
+write_batch(u_metrics_writer &w, size_t size)
+{
+	if (size == 0) {
+		return;
+	}
+
+	if (w.file != nullptr) {
+		fwrite(w.batch, size, 1, w.file);
+		if (w.early_flush) {
+			fflush(w.file);
+		}
+	}
+
+	write_socket(w, w.batch, size);
+}
+
+
+/*
+ *
+ * Writer functions.
+ *
+ */
+
+//! Only called from the writer thread, or after it has stopped.
+static bool
+drain(u_metrics_writer &w)
+{
+	uint64_t pos = w.dequeue_pos.load(std::memory_order_relaxed);
+	size_t batch_size = 0;
+	bool wrote = false;
+
+	while (true) {
+		slot &s = w.slots[pos & (QUEUE_SIZE - 1)];
+		if (s.seq.load(std::memory_order_acquire) != pos + 1) {
+			break;
+		}
+
+		if (batch_size + s.size > sizeof(w.batch)) {
+			write_batch(w, batch_size);
+			batch_size = 0;
+		}
+
+		memcpy(w.batch + batch_size, s.data, s.size);
+		batch_size += s.size;
+
+		// Free the slot for the next lap.
+		s.seq.store(pos + QUEUE_SIZE, std::memory_order_release);
+		w.dequeue_pos.store(++pos, std::memory_order_relaxed);
+		wrote = true;
+	}
+
+	write_batch(w, batch_size);
+
+	uint64_t dropped = w.dropped.exchange(0, std::memory_order_relaxed);
+	if (dropped > 0) {
+		U_LOG_W("Dropped %" PRIu64 " metrics records, queue full!", dropped);
+	}
+
+	return wrote;
+}
+
+static void
+writer_run(u_metrics_writer *w)
+{
+	std::unique_lock<std::mutex> lock(w->mutex);
+
+	while (w->running) {
+		lock.unlock();
+		bool wrote = drain(*w);
+		lock.lock();
+
+		if (wrote || !w->running) {
+			continue;
+		}
+
+		w->sleeping.store(true);
+		w->cond.wait_for(lock, std::chrono::milliseconds(WRITER_TIMEOUT_MS));
+		w->sleeping.store(false);
+	}
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+extern "C" struct u_metrics_writer *
+u_metrics_writer_create(FILE *file, const char *socket_path, bool early_flush)
+{
+	int socket_fd = -1;
+	if (socket_path != NULL) {
+		socket_fd = open_socket(socket_path);
+	}
+
+	if (file == NULL && socket_fd < 0) {
+		return NULL;
+	}
+
+	u_metrics_writer *w = new u_metrics_writer();
+	for (uint64_t i = 0; i < QUEUE_SIZE; i++) {
+		w->slots[i].seq.store(i, std::memory_order_relaxed);
+	}
+
+	w->file = file;
+	w->early_flush = early_flush;
+	w->socket_fd = socket_fd;
+	w->running = true;
+	w->thread = std::thread(writer_run, w);
+
+	return w;
+}
+
+extern "C" bool
+u_metrics_writer_push(struct u_metrics_writer *w, const void *data, size_t size)
+{
+	if (size > U_METRICS_WRITER_MAX_RECORD_SIZE) {
+		U_LOG_E("Metrics record too big (%u bytes)!", (uint32_t)size);
+		return false;
+	}
+
+	uint64_t pos = w->enqueue_pos.load(std::memory_order_relaxed);
+	slot *s = nullptr;
+
+	while (true) {
+		s = &w->slots[pos & (QUEUE_SIZE - 1)];
+		uint64_t seq = s->seq.load(std::memory_order_acquire);
+
+		if (seq == pos) {
+			if (w->enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (seq < pos) {
+			// Not yet freed by the writer from last lap, full.
+			w->dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		} else {
+			pos = w->enqueue_pos.load(std::memory_order_relaxed);
+		}
+	}
+
+	memcpy(s->data, data, size);
+	s->size = (uint32_t)size;
+	s->seq.store(pos + 1, std::memory_order_release);
+
+	// Only make a syscall when the queue is filling up, the writer polls.
+	uint64_t fill = pos + 1 - w->dequeue_pos.load(std::memory_order_relaxed);
+	if (fill > QUEUE_SIZE / 2 && w->sleeping.load(std::memory_order_relaxed)) {
+		w->cond.notify_one();
+	}
+
+	return true;
+}
+
+extern "C" void
+u_metrics_writer_destroy(struct u_metrics_writer **w_ptr)
+{
+	u_metrics_writer *w = *w_ptr;
+	if (w == NULL) {
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(w->mutex);
+		w->running = false;
+	}
+	w->cond.notify_one();
+	w->thread.join();
+
+	// Anything pushed after the last drain of the thread.
+	drain(*w);
+
+	if (w->file != nullptr) {
+		fflush(w->file);
+	}
+	close_socket(*w);
+
+	delete w;
+	*w_ptr = NULL;
+}
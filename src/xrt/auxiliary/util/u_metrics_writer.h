@@ -0,0 +1,69 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Asynchronous writer of encoded metrics records.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include <stdio.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//! Largest record that can be pushed to a @ref u_metrics_writer.
+#define U_METRICS_WRITER_MAX_RECORD_SIZE (240)
+
+/*!
+ * Takes already encoded records from any number of threads, without locking,
+ * and writes them in batches from its own thread.
+ *
+ * @ingroup aux_util
+ */
+struct u_metrics_writer;
+
+/*!
+ * Create a writer and start its thread, at least one of @p file and
+ * @p socket_path must be given.
+ *
+ * @param file        File to write to, optional, does not take ownership.
+ * @param socket_path Path of a UNIX socket to connect to and stream to, optional.
+ * @param early_flush Flush the file after each batch.
+ *
+ * @return NULL if no output could be opened.
+ *
+ * @public @memberof u_metrics_writer
+ */
+struct u_metrics_writer *
+u_metrics_writer_create(FILE *file, const char *socket_path, bool early_flush);
+
+/*!
+ * Queue a record, never blocks. If the queue is full the record is dropped and
+ * counted, returns false in that case.
+ *
+ * @public @memberof u_metrics_writer
+ */
+bool
+u_metrics_writer_push(struct u_metrics_writer *umw, const void *data, size_t size);
+
+/*!
+ * Write all queued records, stop the thread and free the writer. Must not be
+ * called while other threads might still push.
+ *
+ * @public @memberof u_metrics_writer
+ */
+void
+u_metrics_writer_destroy(struct u_metrics_writer **umw_ptr);
+
+
+#ifdef __cplusplus
+}
+#endif
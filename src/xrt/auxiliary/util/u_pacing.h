@@ -456,6 +456,18 @@ struct u_pacing_app
 	             uint64_t predicted_display_period_ns,
 	             uint64_t extra_ns);
 
+	/*!
+	 * Move the app's GPU work earlier, used by the thing driving this
+	 * helper to stagger several apps so their GPU work doesn't all land
+	 * at the same time just before the compositor needs it.
+	 *
+	 * @param upa       Self pointer
+	 * @param offset_ns How long before the compositor needs the frame
+	 *                  the app's GPU work should be done, the time in
+	 *                  between is given to other apps.
+	 */
+	void (*set_gpu_slice)(struct u_pacing_app *upa, uint64_t offset_ns);
+
 	/*!
 	 * Destroy this u_pacing_app.
 	 */
@@ -555,6 +567,20 @@ u_pa_info(struct u_pacing_app *upa,
 	upa->info(upa, predicted_display_time_ns, predicted_display_period_ns, extra_ns);
 }
 
+/*!
+ * @copydoc u_pacing_app::set_gpu_slice
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof u_pacing_app
+ * @ingroup aux_pacing
+ */
+static inline void
+u_pa_set_gpu_slice(struct u_pacing_app *upa, uint64_t offset_ns)
+{
+	upa->set_gpu_slice(upa, offset_ns);
+}
+
 /*!
  * @copydoc u_pacing_app::latched
  *
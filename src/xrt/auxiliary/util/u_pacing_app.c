@@ -156,6 +156,8 @@ struct pacing_app
 		uint64_t predicted_display_period_ns;
 		//! The extra time needed by the thing driving this helper.
 		uint64_t extra_ns;
+		//! Time after the GPU work that is given to other apps.
+		uint64_t gpu_slice_offset_ns;
 	} last_input;
 
 	uint64_t last_returned_ns;
@@ -266,7 +268,7 @@ total_app_time_ns(const struct pacing_app *pa)
 static uint64_t
 total_compositor_time_ns(const struct pacing_app *pa)
 {
-	return margin_time(pa) + pa->last_input.extra_ns;
+	return margin_time(pa) + pa->last_input.extra_ns + pa->last_input.gpu_slice_offset_ns;
 }
 
 static uint64_t
@@ -685,6 +687,14 @@ pa_info(struct u_pacing_app *upa,
 	pa->last_input.extra_ns = extra_ns;
 }
 
+static void
+pa_set_gpu_slice(struct u_pacing_app *upa, uint64_t offset_ns)
+{
+	struct pacing_app *pa = pacing_app(upa);
+
+	pa->last_input.gpu_slice_offset_ns = offset_ns;
+}
+
 static void
 pa_destroy(struct u_pacing_app *upa)
 {
@@ -705,6 +715,7 @@ pa_create(int64_t session_id, struct u_pacing_app **out_upa)
 	pa->base.latched = pa_latched;
 	pa->base.retired = pa_retired;
 	pa->base.info = pa_info;
+	pa->base.set_gpu_slice = pa_set_gpu_slice;
 	pa->base.destroy = pa_destroy;
 	pa->session_id = session_id;
 	pa->app.cpu_time_ns = U_TIME_1MS_IN_NS * 2;
@@ -736,6 +747,7 @@ pa_create(int64_t session_id, struct u_pacing_app **out_upa)
 	u_var_add_ro_u64(pa, &pa->app.cpu_time_ns, "CPU time(ns)");
 	u_var_add_ro_u64(pa, &pa->app.draw_time_ns, "Draw time(ns)");
 	u_var_add_ro_u64(pa, &pa->app.gpu_time_ns, "GPU time(ns)");
+	u_var_add_ro_u64(pa, &pa->last_input.gpu_slice_offset_ns, "GPU slice offset(ns)");
 
 	*out_upa = &pa->base;
 
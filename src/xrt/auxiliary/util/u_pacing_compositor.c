@@ -12,16 +12,19 @@
 #include "util/u_time.h"
 #include "util/u_misc.h"
 #include "util/u_debug.h"
+#include "util/u_var.h"
 #include "util/u_pacing.h"
 #include "util/u_metrics.h"
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
+#include "util/u_rolling_stats.h"
 
 #include <stdio.h>
 #include <assert.h>
 #include <inttypes.h>
 
 DEBUG_GET_ONCE_LOG_OPTION(log_level, "U_PACING_COMPOSITOR_LOG", U_LOGGING_WARN)
+DEBUG_GET_ONCE_FLOAT_OPTION(percentile, "U_PACING_COMPOSITOR_PERCENTILE", 0.0f)
 
 #define UPC_LOG_T(...) U_LOG_IFL_T(debug_get_log_option_log_level(), __VA_ARGS__)
 #define UPC_LOG_D(...) U_LOG_IFL_D(debug_get_log_option_log_level(), __VA_ARGS__)
@@ -33,6 +36,9 @@ DEBUG_GET_ONCE_LOG_OPTION(log_level, "U_PACING_COMPOSITOR_LOG", U_LOGGING_WARN)
 
 #define PRESENT_SLOP_NS (U_TIME_HALF_MS_IN_NS)
 
+//! How many measured frames are needed before the percentile is used.
+#define MIN_PERCENTILE_SAMPLES (NUM_FRAMES)
+
 
 /*
  *
@@ -139,6 +145,34 @@ struct pacing_compositor
 	 * Frame store.
 	 */
 	struct frame frames[NUM_FRAMES];
+
+	/*!
+	 * Rolling distributions of measured compositor times: wake up to
+	 * submit (CPU), submit to GPU done (GPU) and wake up to GPU done. Also
+	 * how late the compositor woke up compared to when it was told to.
+	 */
+	struct
+	{
+		struct u_rolling_stats_ns cpu;
+		struct u_rolling_stats_ns gpu;
+		struct u_rolling_stats_ns total;
+		struct u_rolling_stats_ns oversleep;
+	} stats;
+
+	/*!
+	 * Percentile of the total measured time that is used as the compositor
+	 * time, zero uses the fixed step adjustments instead.
+	 */
+	struct u_var_draggable_f32 percentile;
+
+	//! Latest values of the distributions at @ref percentile.
+	struct
+	{
+		uint64_t cpu_ns;
+		uint64_t gpu_ns;
+		uint64_t total_ns;
+		uint64_t oversleep_ns;
+	} estimate;
 };
 
 
@@ -173,6 +207,25 @@ calc_total_comp_time(struct pacing_compositor *pc)
 	return pc->comp_time_ns + pc->margin_ns;
 }
 
+/*!
+ * How much earlier to wake up to make up for oversleeping, only used together
+ * with the percentile based compositor time since the total time is measured
+ * from when the compositor actually woke up.
+ */
+static uint64_t
+calc_wake_up_margin(struct pacing_compositor *pc)
+{
+	if (pc->percentile.val <= 0.0f || pc->stats.oversleep.value_count < MIN_PERCENTILE_SAMPLES) {
+		return 0;
+	}
+
+	if (pc->estimate.oversleep_ns > pc->comp_time_max_ns) {
+		return pc->comp_time_max_ns;
+	}
+
+	return pc->estimate.oversleep_ns;
+}
+
 static uint64_t
 calc_display_time_from_present_time(struct pacing_compositor *pc, uint64_t desired_present_time_ns)
 {
@@ -348,17 +401,68 @@ predict_next_frame(struct pacing_compositor *pc, uint64_t now_ns)
 	}
 
 	f->predicted_display_time_ns = calc_display_time_from_present_time(pc, f->desired_present_time_ns);
-	f->wake_up_time_ns = f->desired_present_time_ns - calc_total_comp_time(pc);
+	f->wake_up_time_ns = f->desired_present_time_ns - calc_total_comp_time(pc) - calc_wake_up_margin(pc);
 	f->current_comp_time_ns = pc->comp_time_ns;
 
 	return f;
 }
 
+static void
+add_samples(struct pacing_compositor *pc, const struct frame *f)
+{
+	// Same estimate of when the GPU was done as used in the tracing.
+	uint64_t gpu_end_ns = f->actual_present_time_ns - f->present_margin_ns;
+	float percentile = pc->percentile.val > 0.0f ? pc->percentile.val : 50.0f;
+
+	// Waking up early is fine, it's only being late that needs a margin.
+	uint64_t oversleep_ns = f->when_woke_ns > f->wake_up_time_ns ? f->when_woke_ns - f->wake_up_time_ns : 0;
+	u_rs_ns_add(&pc->stats.oversleep, oversleep_ns);
+	pc->estimate.oversleep_ns = u_rs_ns_get_percentile(&pc->stats.oversleep, percentile);
+
+	// Skip frames where the timestamps doesn't make sense.
+	if (f->when_submitted_ns < f->when_woke_ns || gpu_end_ns < f->when_submitted_ns) {
+		return;
+	}
+
+	u_rs_ns_add(&pc->stats.cpu, f->when_submitted_ns - f->when_woke_ns);
+	u_rs_ns_add(&pc->stats.gpu, gpu_end_ns - f->when_submitted_ns);
+	u_rs_ns_add(&pc->stats.total, gpu_end_ns - f->when_woke_ns);
+
+	pc->estimate.cpu_ns = u_rs_ns_get_percentile(&pc->stats.cpu, percentile);
+	pc->estimate.gpu_ns = u_rs_ns_get_percentile(&pc->stats.gpu, percentile);
+	pc->estimate.total_ns = u_rs_ns_get_percentile(&pc->stats.total, percentile);
+}
+
+/*!
+ * Use the measured distribution instead of stepping, a single spike only moves
+ * the value if it is in the targeted tail and it falls out of the window again.
+ */
+static bool
+adjust_comp_time_from_percentile(struct pacing_compositor *pc)
+{
+	if (pc->percentile.val <= 0.0f || pc->stats.total.value_count < MIN_PERCENTILE_SAMPLES) {
+		return false;
+	}
+
+	uint64_t comp_time_ns = pc->estimate.total_ns;
+	if (comp_time_ns > pc->comp_time_max_ns) {
+		comp_time_ns = pc->comp_time_max_ns;
+	}
+
+	pc->comp_time_ns = comp_time_ns;
+
+	return true;
+}
+
 static void
 adjust_comp_time(struct pacing_compositor *pc, struct frame *f)
 {
 	uint64_t comp_time_ns = pc->comp_time_ns;
 
+	if (adjust_comp_time_from_percentile(pc)) {
+		return;
+	}
+
 	if (f->actual_present_time_ns > f->desired_present_time_ns &&
 	    !is_within_half_ms(f->actual_present_time_ns, f->desired_present_time_ns)) {
 		double missed_ms = ns_to_ms(f->actual_present_time_ns - f->desired_present_time_ns);
@@ -431,7 +535,7 @@ do_metrics(struct pacing_compositor *pc, struct frame *f)
 static void
 do_tracing(struct pacing_compositor *pc, struct frame *f)
 {
-#ifdef U_TRACE_PERCETTO // Uses Percetto specific things.
+#if defined(U_TRACE_PERCETTO) || defined(U_TRACE_RECORDER) // Uses track events.
 	if (!U_TRACE_CATEGORY_IS_ENABLED(timing)) {
 		return;
 	}
@@ -658,7 +762,8 @@ pc_info(struct u_pacing_compositor *upc,
 		since_last_frame_ns = f->desired_present_time_ns - last->desired_present_time_ns;
 	}
 
-	// Adjust the frame timing.
+	// Add to the distributions and adjust the frame timing.
+	add_samples(pc, f);
 	adjust_comp_time(pc, f);
 
 	double present_margin_ms = ns_to_ms(present_margin_ns);
@@ -735,6 +840,8 @@ pc_destroy(struct u_pacing_compositor *upc)
 {
 	struct pacing_compositor *pc = pacing_compositor(upc);
 
+	u_var_remove_root(pc);
+
 	free(pc);
 }
 
@@ -779,6 +886,23 @@ u_pc_display_timing_create(uint64_t estimated_frame_period_ns,
 	pc->adjust_non_miss_ns = get_percent_of_time(estimated_frame_period_ns, config->adjust_non_miss_fraction);
 	// Extra margin that is added to compositor time.
 	pc->margin_ns = config->margin_ns;
+	// Target percentile of the measured compositor time, zero to step instead.
+	pc->percentile = (struct u_var_draggable_f32){
+	    .val = debug_get_float_option_percentile(),
+	    .min = 0.0,
+	    .step = 1.0,
+	    .max = 100.0,
+	};
+
+	// U variable tracking.
+	u_var_add_root(pc, "Compositor timing info", true);
+	u_var_add_draggable_f32(pc, &pc->percentile, "Target percentile (0 = off)");
+	u_var_add_ro_u64(pc, &pc->comp_time_ns, "Compositor time(ns)");
+	u_var_add_ro_u64(pc, &pc->margin_ns, "Margin(ns)");
+	u_var_add_ro_u64(pc, &pc->estimate.cpu_ns, "CPU time at percentile(ns)");
+	u_var_add_ro_u64(pc, &pc->estimate.gpu_ns, "GPU time at percentile(ns)");
+	u_var_add_ro_u64(pc, &pc->estimate.total_ns, "Total time at percentile(ns)");
+	u_var_add_ro_u64(pc, &pc->estimate.oversleep_ns, "Oversleep at percentile(ns)");
 
 	*out_upc = &pc->base;
 
@@ -19,6 +19,7 @@
 #include "util/u_live_stats.h"
 #include "util/u_trace_marker.h"
 
+#include <math.h>
 #include <stdio.h>
 #include <assert.h>
 #include <inttypes.h>
@@ -33,10 +34,20 @@
 DEBUG_GET_ONCE_FLOAT_OPTION(present_to_display_offset_ms, "U_PACING_COMP_PRESENT_TO_DISPLAY_OFFSET_MS", 4.0f)
 DEBUG_GET_ONCE_FLOAT_OPTION(min_comp_time_ms, "U_PACING_COMP_MIN_TIME_MS", 3.0f)
 DEBUG_GET_ONCE_BOOL_OPTION(live_stats, "U_PACING_LIVE_STATS", false)
+DEBUG_GET_ONCE_BOOL_OPTION(vblank_clock, "U_PACING_COMP_VBLANK_CLOCK", true)
 
 // We keep track of this number of frames.
 #define FRAME_COUNT 8
 
+//! Samples needed before the measured period replaces the nominal one.
+#define CLOCK_MIN_SAMPLES (32)
+
+//! More vblanks than this between two samples and the clock starts over.
+#define CLOCK_MAX_GAP (8)
+
+//! The measured period may not stray further than this fraction from the nominal one.
+#define CLOCK_MAX_PERIOD_DEVIATION (0.02)
+
 /*
  * Internal helper for keeping track of frame data.
  */
@@ -100,11 +111,43 @@ struct fake_timing
 	 */
 	uint64_t frame_period_ns;
 
+	/*!
+	 * The periodicity of the display, as given at creation.
+	 */
+	uint64_t nominal_frame_period_ns;
+
 	/*!
 	 * When the last frame was presented, not displayed.
 	 */
 	uint64_t last_present_time_ns;
 
+	/*!
+	 * Model of the display's vblank clock, built from the vblank timestamps
+	 * given to @ref u_pacing_compositor::update_vblank_from_display_control.
+	 * The timestamps are taken when a thread woke up from waiting on the
+	 * vblank so they are only ever late, never early.
+	 */
+	struct
+	{
+		//! Is the model used at all.
+		bool enabled;
+
+		//! Samples since the clock last started over.
+		uint64_t sample_count;
+
+		//! First sample since the clock last started over.
+		uint64_t anchor_ns;
+
+		//! Number of vblanks between the anchor and the last vblank.
+		uint64_t vblank_count;
+
+		//! Estimated time of the last vblank.
+		uint64_t last_vblank_ns;
+
+		//! How late the last sample was compared to the model.
+		int64_t last_error_ns;
+	} clock;
+
 	/*!
 	 * Very often the present time that we get from the system is only when
 	 * the display engine starts scanning out from the buffers we provided,
@@ -179,6 +222,75 @@ predict_next_frame_present_time(struct fake_timing *ft, uint64_t now_ns)
 	return predicted_present_time_ns;
 }
 
+static void
+clock_restart(struct fake_timing *ft, uint64_t vblank_ns)
+{
+	ft->clock.sample_count = 1;
+	ft->clock.anchor_ns = vblank_ns;
+	ft->clock.vblank_count = 0;
+	ft->clock.last_vblank_ns = vblank_ns;
+	ft->clock.last_error_ns = 0;
+}
+
+static void
+clock_update(struct fake_timing *ft, uint64_t vblank_ns)
+{
+	if (ft->clock.sample_count == 0 || vblank_ns < ft->clock.anchor_ns) {
+		clock_restart(ft, vblank_ns);
+		return;
+	}
+
+	// How many vblanks since the last one, rounded to the closest.
+	double period_ns = (double)ft->frame_period_ns;
+	double since_ns = (double)vblank_ns - (double)ft->clock.last_vblank_ns;
+	double vblanks = floor(since_ns / period_ns + 0.5);
+
+	// Another sample for a vblank we already have.
+	if (vblanks < 1.0) {
+		if (vblank_ns < ft->clock.last_vblank_ns) {
+			ft->clock.last_vblank_ns = vblank_ns;
+		}
+		return;
+	}
+
+	// Lost track, counting vblanks over a gap this long isn't reliable.
+	if (vblanks > CLOCK_MAX_GAP) {
+		clock_restart(ft, vblank_ns);
+		return;
+	}
+
+	ft->clock.vblank_count += (uint64_t)vblanks;
+	ft->clock.sample_count++;
+
+	/*
+	 * Over a long enough baseline the wake up latency of both ends is
+	 * small compared to the time between them, so the period comes from
+	 * the anchor and can be trusted once enough samples have gone in.
+	 */
+	if (ft->clock.sample_count >= CLOCK_MIN_SAMPLES) {
+		double measured_ns = (double)(vblank_ns - ft->clock.anchor_ns) / (double)ft->clock.vblank_count;
+		double nominal_ns = (double)ft->nominal_frame_period_ns;
+
+		if (fabs(measured_ns - nominal_ns) <= nominal_ns * CLOCK_MAX_PERIOD_DEVIATION) {
+			period_ns = measured_ns;
+			ft->frame_period_ns = (uint64_t)(measured_ns + 0.5);
+		}
+	}
+
+	double predicted_ns = (double)ft->clock.last_vblank_ns + vblanks * period_ns;
+	double error_ns = (double)vblank_ns - predicted_ns;
+
+	/*
+	 * The samples are late by however long the waiting thread took to
+	 * wake up, so an early sample means the model is late and is followed
+	 * quickly, while late samples are mostly noise and only nudge it.
+	 */
+	double gain = error_ns < 0.0 ? 0.5 : 1.0 / 16.0;
+
+	ft->clock.last_vblank_ns = (uint64_t)(predicted_ns + error_ns * gain);
+	ft->clock.last_error_ns = (int64_t)error_ns;
+}
+
 static uint64_t
 calc_display_time(struct fake_timing *ft, uint64_t present_time_ns)
 {
@@ -407,8 +519,16 @@ pc_update_vblank_from_display_control(struct u_pacing_compositor *upc, uint64_t
 {
 	struct fake_timing *ft = fake_timing(upc);
 
-	// Use the last vblank time to sync to the output.
-	ft->last_present_time_ns = last_vblank_ns;
+	if (!ft->clock.enabled) {
+		// Use the last vblank time to sync to the output.
+		ft->last_present_time_ns = last_vblank_ns;
+		return;
+	}
+
+	clock_update(ft, last_vblank_ns);
+
+	// Sync to the modelled vblank instead of the noisy sample.
+	ft->last_present_time_ns = ft->clock.last_vblank_ns;
 }
 
 static void
@@ -453,6 +573,8 @@ u_pc_fake_create(uint64_t estimated_frame_period_ns, uint64_t now_ns, struct u_p
 	ft->base.update_present_offset = pc_update_present_offset;
 	ft->base.destroy = pc_destroy;
 	ft->frame_period_ns = estimated_frame_period_ns;
+	ft->nominal_frame_period_ns = estimated_frame_period_ns;
+	ft->clock.enabled = debug_get_bool_option_vblank_clock();
 
 	snprintf(ft->cpu.name, ARRAY_SIZE(ft->cpu.name), "cpu");
 	snprintf(ft->draw.name, ARRAY_SIZE(ft->draw.name), "draw");
@@ -495,6 +617,9 @@ u_pc_fake_create(uint64_t estimated_frame_period_ns, uint64_t now_ns, struct u_p
 	u_var_add_ro_u64(ft, &ft->frame_period_ns, "Frame period(ns)");
 	u_var_add_ro_u64(ft, &ft->comp_time_ns, "Compositor time(ns)");
 	u_var_add_ro_u64(ft, &ft->last_present_time_ns, "Last present time(ns)");
+	u_var_add_bool(ft, &ft->clock.enabled, "VBlank clock model");
+	u_var_add_ro_u64(ft, &ft->clock.vblank_count, "VBlank clock counted vblanks");
+	u_var_add_ro_i64(ft, &ft->clock.last_error_ns, "VBlank clock last error(ns)");
 
 	// Return value.
 	*out_upc = &ft->base;
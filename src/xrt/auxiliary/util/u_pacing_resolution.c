@@ -0,0 +1,126 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Dynamic resolution controller, scales the recommended resolution.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "util/u_pacing_resolution.h"
+
+#include <math.h>
+
+
+/*
+ *
+ * Defines.
+ *
+ */
+
+//! The share of the display period the GPU time is steered towards.
+#define TARGET_LOAD (0.75)
+
+//! Above this share of the display period the scale is lowered.
+#define HIGH_LOAD (0.9)
+
+//! Below this share of the display period the scale may grow.
+#define LOW_LOAD (0.6)
+
+//! How many frames in a row must be below @ref LOW_LOAD before growing.
+#define GROW_FRAMES (45)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static float
+quantize(const struct u_pacing_resolution *upr, double scale)
+{
+	double steps = floor(scale / U_PACING_RESOLUTION_STEP + 0.5);
+	float value = (float)(steps * U_PACING_RESOLUTION_STEP);
+
+	if (value < upr->min_scale) {
+		return upr->min_scale;
+	}
+	if (value > 1.0f) {
+		return 1.0f;
+	}
+
+	return value;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+u_pr_init(struct u_pacing_resolution *upr, float min_scale)
+{
+	if (min_scale < U_PACING_RESOLUTION_STEP) {
+		min_scale = U_PACING_RESOLUTION_STEP;
+	}
+
+	upr->scale = 1.0f;
+	upr->min_scale = min_scale < 1.0f ? min_scale : 1.0f;
+	upr->gpu_avg_ns = 0;
+	upr->good_frames = 0;
+}
+
+bool
+u_pr_update(struct u_pacing_resolution *upr, uint64_t gpu_ns, uint64_t period_ns, bool missed)
+{
+	if (period_ns == 0 || upr->min_scale >= 1.0f) {
+		return false;
+	}
+
+	// One spike shouldn't move the resolution, a missed frame will.
+	if (upr->gpu_avg_ns == 0) {
+		upr->gpu_avg_ns = gpu_ns;
+	} else {
+		upr->gpu_avg_ns = (upr->gpu_avg_ns * 7 + gpu_ns) / 8;
+	}
+
+	double load = (double)upr->gpu_avg_ns / (double)period_ns;
+	float old_scale = upr->scale;
+	double new_scale = old_scale;
+
+	if (missed || load > HIGH_LOAD) {
+		upr->good_frames = 0;
+
+		// GPU time goes with the pixel count, the square of the scale.
+		if (load > TARGET_LOAD) {
+			new_scale = old_scale * sqrt(TARGET_LOAD / load);
+		}
+
+		// Always back off at least one step when missing frames.
+		if (missed && new_scale > old_scale - U_PACING_RESOLUTION_STEP) {
+			new_scale = old_scale - U_PACING_RESOLUTION_STEP;
+		}
+	} else if (load < LOW_LOAD) {
+		if (++upr->good_frames >= GROW_FRAMES) {
+			upr->good_frames = 0;
+			new_scale = old_scale + U_PACING_RESOLUTION_STEP;
+		}
+	} else {
+		upr->good_frames = 0;
+	}
+
+	upr->scale = quantize(upr, new_scale);
+
+	if (upr->scale == old_scale) {
+		return false;
+	}
+
+	// The average was measured at the old scale, adjust it to the new one.
+	double ratio = ((double)upr->scale * upr->scale) / ((double)old_scale * old_scale);
+	upr->gpu_avg_ns = (uint64_t)((double)upr->gpu_avg_ns * ratio);
+
+	return true;
+}
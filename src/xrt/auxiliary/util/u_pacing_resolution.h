@@ -0,0 +1,70 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Dynamic resolution controller, scales the recommended resolution.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+//! Granularity of the scale, keeps small changes in load from producing new values.
+#define U_PACING_RESOLUTION_STEP (1.0f / 32.0f)
+
+/*!
+ * Picks a scale for the recommended image size of a client from how long its
+ * GPU work takes compared to the display period. The GPU time is assumed to
+ * follow the number of pixels, so the scale per axis goes with its square root.
+ * It drops quickly when frames are missed and only climbs back slowly, one
+ * step at a time after a run of frames with plenty of headroom.
+ *
+ * Not thread safe, the owner protects it.
+ *
+ * @ingroup aux_util
+ */
+struct u_pacing_resolution
+{
+	//! Current scale of the recommended image size, per axis.
+	float scale;
+
+	//! Lowest scale that will be recommended.
+	float min_scale;
+
+	//! Smoothed GPU time.
+	uint64_t gpu_avg_ns;
+
+	//! Consecutive frames with enough headroom to grow.
+	uint32_t good_frames;
+};
+
+/*!
+ * Start out at full resolution, a @p min_scale of one or more disables scaling.
+ *
+ * @ingroup aux_util
+ */
+void
+u_pr_init(struct u_pacing_resolution *upr, float min_scale);
+
+/*!
+ * Feed the GPU time of one frame, @p missed is set if the frame did not make
+ * its display period.
+ *
+ * @return True if @ref u_pacing_resolution::scale changed.
+ * @ingroup aux_util
+ */
+bool
+u_pr_update(struct u_pacing_resolution *upr, uint64_t gpu_ns, uint64_t period_ns, bool missed);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,42 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Rolling window of values with percentile queries.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "u_rolling_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+extern "C" uint64_t
+u_rs_ns_get_percentile(const struct u_rolling_stats_ns *urs, float percentile)
+{
+	uint32_t count = urs->value_count;
+
+	if (count == 0) {
+		return 0;
+	}
+
+	// Nearest rank, one based.
+	double fraction = std::min(std::max((double)percentile, 0.0), 100.0) / 100.0;
+	uint32_t rank = (uint32_t)std::ceil(fraction * (double)count);
+	uint32_t index = rank > 0 ? rank - 1 : 0;
+
+	// Don't disturb the order, it's cheap to copy this few values.
+	uint64_t values[U_ROLLING_STATS_VALUE_COUNT];
+	std::copy(&urs->values[0], &urs->values[count], &values[0]);
+	std::nth_element(&values[0], &values[index], &values[count]);
+
+	return values[index];
+}
@@ -0,0 +1,74 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Rolling window of values with percentile queries.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*!
+ * Number of values the rolling window holds, older values are replaced.
+ *
+ * @ingroup aux_util
+ */
+#define U_ROLLING_STATS_VALUE_COUNT (128)
+
+/*!
+ * Keeps the latest @ref U_ROLLING_STATS_VALUE_COUNT nano-second values, unlike
+ * @ref u_live_stats_ns it is never full and is not reset when queried, so it
+ * can be used to track a distribution continuously.
+ *
+ * @ingroup aux_util
+ */
+struct u_rolling_stats_ns
+{
+	//! Number of values currently in struct, saturates at the max count.
+	uint32_t value_count;
+
+	//! Where the next value will be put, wraps around.
+	uint32_t next_index;
+
+	//! The latest values, in no particular order.
+	uint64_t values[U_ROLLING_STATS_VALUE_COUNT];
+};
+
+/*!
+ * Add a value to the window, replacing the oldest one if full.
+ *
+ * @public @memberof u_rolling_stats_ns
+ * @ingroup aux_util
+ */
+static inline void
+u_rs_ns_add(struct u_rolling_stats_ns *urs, uint64_t value)
+{
+	urs->values[urs->next_index] = value;
+	urs->next_index = (urs->next_index + 1) % ARRAY_SIZE(urs->values);
+
+	if (urs->value_count < ARRAY_SIZE(urs->values)) {
+		urs->value_count++;
+	}
+}
+
+/*!
+ * Get the value at @p percentile (0 to 100, nearest rank) of the values in the
+ * window, returns 0 if there are no values.
+ *
+ * @public @memberof u_rolling_stats_ns
+ * @ingroup aux_util
+ */
+uint64_t
+u_rs_ns_get_percentile(const struct u_rolling_stats_ns *urs, float percentile);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -13,6 +13,7 @@
 #include "os/os_threading.h"
 #include "xrt/xrt_frame.h"
 #include "xrt/xrt_tracking.h"
+#include "util/u_var.h"
 
 
 #ifdef __cplusplus
@@ -39,6 +40,23 @@ u_sink_create_format_converter(struct xrt_frame_context *xfctx,
                                struct xrt_frame_sink *downstream,
                                struct xrt_frame_sink **out_xfs);
 
+/*!
+ * Same as @ref u_sink_create_format_converter but MJPEG frames are decoded at
+ * 1 / @p jpeg_scale_denom of their size, which must be 1, 2, 4 or 8. This is
+ * done with DCT scaling in libjpeg, and for L8 only the luma is decoded, which
+ * is a lot cheaper than a full decode. Other formats are converted at full
+ * size.
+ *
+ * @public @memberof xrt_frame_sink
+ * @see xrt_frame_context
+ */
+void
+u_sink_create_format_converter_scaled(struct xrt_frame_context *xfctx,
+                                      enum xrt_format f,
+                                      uint32_t jpeg_scale_denom,
+                                      struct xrt_frame_sink *downstream,
+                                      struct xrt_frame_sink **out_xfs);
+
 /*!
  * @public @memberof xrt_frame_sink
  * @see xrt_frame_context
@@ -102,6 +120,69 @@ u_sink_deinterleaver_create(struct xrt_frame_context *xfctx,
                             struct xrt_frame_sink **out_xfs);
 
 /*!
+ * What a @ref u_sink_queue_create_with_params queue does when it is full.
+ */
+enum u_sink_queue_drop_policy
+{
+	//! Keep the queued frames and drop the incoming one.
+	U_SINK_QUEUE_DROP_NEWEST,
+
+	//! Drop the oldest queued frame to make room, lowest latency.
+	U_SINK_QUEUE_DROP_OLDEST,
+};
+
+/*!
+ * Parameters for @ref u_sink_queue_create_with_params.
+ */
+struct u_sink_queue_params
+{
+	//! Max amount of queued frames, 0 means unbounded.
+	uint64_t max_size;
+
+	//! Which frame to drop when full.
+	enum u_sink_queue_drop_policy drop_policy;
+
+	//! Name of the queue in the debug gui, NULL gives a default name.
+	const char *name;
+
+	/*!
+	 * Consume the frames as tasks on a worker pool shared by all queues,
+	 * instead of on a thread of its own. The consumer must not block for
+	 * long as it holds up the other queues. The `XRT_SINK_QUEUE_SHARED_POOL`
+	 * env variable turns this on for the queues made with
+	 * @ref u_sink_queue_create and @ref u_sink_simple_queue_create.
+	 */
+	bool use_shared_pool;
+};
+
+/*!
+ * A queue that pushes frames to @p downstream from its own thread. Tracks the
+ * number of dropped frames, how long frames wait in the queue and how busy the
+ * consumer is, these are shown in the debug gui.
+ *
+ * @public @memberof xrt_frame_sink
+ * @see xrt_frame_context
+ */
+bool
+u_sink_queue_create_with_params(struct xrt_frame_context *xfctx,
+                                const struct u_sink_queue_params *params,
+                                struct xrt_frame_sink *downstream,
+                                struct xrt_frame_sink **out_xfs);
+
+/*!
+ * Get how many frames was given to a queue and how many of them that were
+ * dropped, lets a recorder check that nothing was lost. @p xfs must be a sink
+ * made by one of the u_sink_queue functions.
+ *
+ * @public @memberof xrt_frame_sink
+ */
+void
+u_sink_queue_get_counts(struct xrt_frame_sink *xfs, uint64_t *out_pushed, uint64_t *out_dropped);
+
+/*!
+ * Same as @ref u_sink_queue_create_with_params with
+ * @ref U_SINK_QUEUE_DROP_NEWEST.
+ *
  * @public @memberof xrt_frame_sink
  * @see xrt_frame_context
  */
@@ -113,6 +194,10 @@ u_sink_queue_create(struct xrt_frame_context *xfctx,
 
 
 /*!
+ * A queue that only keeps the latest frame, same as
+ * @ref u_sink_queue_create_with_params with a max size of one and
+ * @ref U_SINK_QUEUE_DROP_OLDEST.
+ *
  * @public @memberof xrt_frame_sink
  * @see xrt_frame_context
  */
@@ -142,6 +227,23 @@ u_sink_split_create(struct xrt_frame_context *xfctx,
                     struct xrt_frame_sink *right,
                     struct xrt_frame_sink **out_xfs);
 
+//! Most downstreams a @ref u_sink_slam_fanout_create fan out can have.
+#define U_SINK_SLAM_FANOUT_MAX 4
+
+/*!
+ * @public @memberof xrt_slam_sinks
+ * @see xrt_frame_context
+ * Pushes everything pushed to @p out_sinks to all of @p downstreams, for example
+ * to run a second SLAM system in shadow mode next to the one in use. Frames are
+ * reference counted and never copied, each downstream only gets the cameras it
+ * has and sinks it leaves NULL are skipped.
+ */
+void
+u_sink_slam_fanout_create(struct xrt_frame_context *xfctx,
+                          struct xrt_slam_sinks **downstreams,
+                          uint32_t downstream_count,
+                          struct xrt_slam_sinks **out_sinks);
+
 /*!
  * Splits Stereo SBS frames into two independent frames
  */
@@ -199,6 +301,11 @@ u_sink_debug_init(struct u_sink_debug *usd)
 static inline bool
 u_sink_debug_is_active(struct u_sink_debug *usd)
 {
+	// Nothing can be hooked up if nothing is looking, skip the lock.
+	if (!u_var_is_observed()) {
+		return false;
+	}
+
 	os_mutex_lock(&usd->mutex);
 	bool active = usd->sink != NULL;
 	os_mutex_unlock(&usd->mutex);
@@ -209,6 +316,10 @@ u_sink_debug_is_active(struct u_sink_debug *usd)
 static inline void
 u_sink_debug_push_frame(struct u_sink_debug *usd, struct xrt_frame *xf)
 {
+	if (!u_var_is_observed()) {
+		return;
+	}
+
 	os_mutex_lock(&usd->mutex);
 	if (usd->sink != NULL) {
 		xrt_sink_push_frame(usd->sink, xf);
@@ -42,6 +42,9 @@ struct u_sink_combiner
 	//! The current queued frame.
 	struct xrt_frame *frames[2];
 
+	//! Combined frames, only used from the thread.
+	struct u_frame_pool *pool;
+
 	pthread_t thread;
 	pthread_mutex_t mutex;
 	pthread_cond_t cond;
@@ -98,7 +101,7 @@ combine_frames_r8g8b8(struct xrt_frame *l, struct xrt_frame *r, struct xrt_frame
 }
 
 static void
-combine_frames(struct xrt_frame *l, struct xrt_frame *r, struct xrt_frame **out_frame)
+combine_frames(struct u_frame_pool *pool, struct xrt_frame *l, struct xrt_frame *r, struct xrt_frame **out_frame)
 {
 	SINK_TRACE_MARKER();
 
@@ -112,7 +115,7 @@ combine_frames(struct xrt_frame *l, struct xrt_frame *r, struct xrt_frame **out_
 	uint32_t width = l->width + r->width;
 	enum xrt_format format = l->format;
 
-	u_frame_create_one_off(format, width, height, out_frame);
+	u_frame_pool_create_frame(pool, format, width, height, out_frame);
 
 	struct xrt_frame *f = *out_frame;
 	f->timestamp = l->timestamp - (diff_ns / 2); // Middle of both frames.
@@ -192,7 +195,7 @@ combiner_right_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 		assert(!(diff_ns < -U_TIME_1MS_IN_NS || diff_ns > U_TIME_1MS_IN_NS));
 
 		struct xrt_frame *frame = NULL;
-		combine_frames(frames[0], frames[1], &frame);
+		combine_frames(q->pool, frames[0], frames[1], &frame);
 
 		// Send to the consumer that does the work.
 		xrt_sink_push_frame(q->consumer, frame);
@@ -239,6 +242,7 @@ combiner_destroy(struct xrt_frame_node *node)
 	// Destroy resources.
 	pthread_mutex_destroy(&q->mutex);
 	pthread_cond_destroy(&q->cond);
+	u_frame_pool_destroy(&q->pool);
 	free(q);
 }
 
@@ -275,6 +279,8 @@ u_sink_combiner_create(struct xrt_frame_context *xfctx,
 		return false;
 	}
 
+	q->pool = u_frame_pool_create(4);
+
 	xrt_frame_context_add(xfctx, &q->node);
 
 
@@ -9,12 +9,16 @@
  */
 
 #include "xrt/xrt_config_have.h"
+#include "math/m_api.h"
 #include "util/u_logging.h"
 #include "util/u_misc.h"
 #include "util/u_sink.h"
 #include "util/u_frame.h"
 #include "util/u_format.h"
+#include "util/u_format_rows.h"
 #include "util/u_trace_marker.h"
+#include "util/u_worker.h"
+#include "util/u_debug.h"
 
 #include <stdio.h>
 
@@ -23,6 +27,15 @@
 #endif
 
 
+//! Most threads a single conversion is split over.
+#define MAX_THREADS (8)
+
+//! Fewest output rows given to each thread, smaller frames are not split.
+#define MIN_ROWS_PER_THREAD (32)
+
+DEBUG_GET_ONCE_NUM_OPTION(converter_threads, "XRT_SINK_CONVERTER_THREADS", 2)
+
+
 /*
  *
  * Structs
@@ -42,243 +55,286 @@ struct u_sink_converter
 	struct xrt_frame_sink *downstream;
 
 	enum xrt_format format;
+
+	//! Converted frames, created on first use.
+	struct u_frame_pool *pool;
+
+	//! MJPEG frames are decoded at 1 / this of their size, zero is same as one.
+	uint32_t jpeg_scale_denom;
+
+	//! Rows of big frames are split over these, created on first use.
+	struct u_worker_thread_pool *workers;
+	struct u_worker_group *group;
 };
 
 
 /*
  *
- * L8 functions.
+ * Row based functions, see @ref u_format_row_funcs.
  *
  */
 
-static void
-from_L8_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
+/*!
+ * A band of rows to convert, if @p bayer_func is set each output row is made
+ * from two source rows.
+ */
+struct convert_job
 {
-	SINK_TRACE_MARKER();
-
-	for (uint32_t y = 0; y < h; y++) {
-		for (uint32_t x = 0; x < w; x += 1) {
-			const uint8_t *src = data;
-			uint8_t *dst = dst_frame->data;
+	u_format_row_func_t func;
+	u_format_bayer_row_func_t bayer_func;
 
-			src = src + (y * stride) + x;
-			dst = dst + (y * dst_frame->stride) + (x * 3);
-			dst[2] = dst[1] = dst[0] = src[0];
-		}
-	}
-}
+	uint8_t *dst;
+	size_t dst_stride;
 
+	const uint8_t *src;
+	size_t src_stride;
 
-/*
- *
- * YUV functions.
- *
- */
+	uint32_t w;
+	uint32_t h;
+};
 
-static inline int
-clamp_to_byte(int v)
+static void
+convert_job_run(void *ptr)
 {
-	if (v < 0) {
-		return 0;
-	}
-	if (v >= 255) {
-		return 255;
+	struct convert_job *job = (struct convert_job *)ptr;
+
+	if (job->bayer_func != NULL) {
+		for (uint32_t y = 0; y < job->h; y++) {
+			const uint8_t *src0 = job->src + (y * 2) * job->src_stride;
+			const uint8_t *src1 = job->src + (y * 2 + 1) * job->src_stride;
+			job->bayer_func(job->dst + (y * job->dst_stride), src0, src1, job->w);
+		}
+	} else {
+		for (uint32_t y = 0; y < job->h; y++) {
+			job->func(job->dst + (y * job->dst_stride), job->src + (y * job->src_stride), job->w);
+		}
 	}
-	return v;
 }
 
-static inline uint32_t
-YUV444_to_RGBX8888(int y, int u, int v)
+static uint32_t
+get_band_count(struct u_sink_converter *s, uint32_t h)
 {
-	int C = y - 16;
-	int D = u - 128;
-	int E = v - 128;
+	// Including the calling thread.
+	uint32_t thread_count = (uint32_t)CLAMP(debug_get_num_option_converter_threads(), 1, MAX_THREADS);
 
-	int R = clamp_to_byte((298 * C + 409 * E + 128) >> 8);
-	int G = clamp_to_byte((298 * C - 100 * D - 209 * E + 128) >> 8);
-	int B = clamp_to_byte((298 * C + 516 * D + 128) >> 8);
+	uint32_t count = MIN(thread_count, h / MIN_ROWS_PER_THREAD);
+	if (count <= 1) {
+		return 1;
+	}
 
-	return B << 16 | G << 8 | R;
-}
+	if (s->group == NULL) {
+		// The calling thread does one band itself.
+		s->workers = u_worker_thread_pool_create_with_role(thread_count - 1, thread_count, "Converter",
+		                                                    U_THREAD_ROLE_TRACKING);
+		s->group = u_worker_group_create(s->workers);
+	}
 
-#undef USE_TABLE
-#ifdef USE_TABLE
-static uint32_t lookup_YUV_to_RGBX[256][256][256] = {0};
+	return count;
+}
 
+/*!
+ * Run the conversion, splitting it into bands of rows over the worker threads
+ * if the frame is big enough. @p src_rows_per_row is two for Bayer.
+ */
 static void
-generate_lookup_YUV_to_RGBX()
+run_job(struct u_sink_converter *s, const struct convert_job *job, uint32_t src_rows_per_row)
 {
-	if (lookup_YUV_to_RGBX[255][255][255] != 0) {
+	uint32_t count = get_band_count(s, job->h);
+	if (count == 1) {
+		struct convert_job copy = *job;
+		convert_job_run(&copy);
 		return;
 	}
 
-	int y;
-	int u;
-	int v;
+	struct convert_job bands[MAX_THREADS];
+	uint32_t y = 0;
 
-	for (y = 0; y < 256; y++) {
-		for (u = 0; u < 256; u++) {
-			for (v = 0; v < 256; v++) {
-				lookup_YUV_to_RGBX[y][u][v] = YUV444_to_RGBX8888(y, u, v);
-			}
-		}
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t rows = job->h / count + (i < job->h % count ? 1 : 0);
+
+		bands[i] = *job;
+		bands[i].dst = job->dst + y * job->dst_stride;
+		bands[i].src = job->src + y * src_rows_per_row * job->src_stride;
+		bands[i].h = rows;
+		y += rows;
+	}
+
+	for (uint32_t i = 1; i < count; i++) {
+		u_worker_group_push(s->group, convert_job_run, &bands[i]);
 	}
+
+	convert_job_run(&bands[0]);
+
+	u_worker_group_wait_all(s->group);
 }
-#endif
 
-XRT_MAYBE_UNUSED inline static void
-YUYV422_to_R8G8B8X8(const uint8_t *input, uint32_t *rgb1, uint32_t *rgb2)
+static inline void
+convert_rows(struct u_sink_converter *s,
+             u_format_row_func_t func,
+             struct xrt_frame *dst_frame,
+             uint32_t w,
+             uint32_t h,
+             size_t stride,
+             const uint8_t *data)
 {
-	uint8_t y0 = input[0];
-	uint8_t u = input[1];
-	uint8_t y1 = input[2];
-	uint8_t v = input[3];
+	struct convert_job job = {
+	    .func = func,
+	    .dst = dst_frame->data,
+	    .dst_stride = dst_frame->stride,
+	    .src = data,
+	    .src_stride = stride,
+	    .w = w,
+	    .h = h,
+	};
 
-#ifdef USE_TABLE
-	*rgb1 = lookup_YUV_to_RGBX[y0][u][v];
-	*rgb2 = lookup_YUV_to_RGBX[y1][u][v];
-#else
-	*rgb1 = YUV444_to_RGBX8888(y0, u, v);
-	*rgb2 = YUV444_to_RGBX8888(y1, u, v);
-#endif
+	run_job(s, &job, 1);
 }
 
-inline static void
-YUYV422_to_R8G8B8(const uint8_t *input, uint8_t *dst)
+static void
+from_L8_to_R8G8B8(
+    struct u_sink_converter *s, struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
 {
-	uint8_t y0 = input[0];
-	uint8_t u = input[1];
-	uint8_t y1 = input[2];
-	uint8_t v = input[3];
+	SINK_TRACE_MARKER();
 
-#ifdef USE_TABLE
-	uint8_t *rgb1 = (uint8_t *)&lookup_YUV_to_RGBX[y0][u][v];
-	uint8_t *rgb2 = (uint8_t *)&lookup_YUV_to_RGBX[y1][u][v];
-#else
-	uint32_t rgb1v = YUV444_to_RGBX8888(y0, u, v);
-	uint32_t rgb2v = YUV444_to_RGBX8888(y1, u, v);
-	uint8_t *rgb1 = (uint8_t *)&rgb1v;
-	uint8_t *rgb2 = (uint8_t *)&rgb2v;
-#endif
+	convert_rows(s, u_format_row_funcs_get()->L8_to_R8G8B8, dst_frame, w, h, stride, data);
+}
 
-	dst[0] = rgb1[0];
-	dst[1] = rgb1[1];
-	dst[2] = rgb1[2];
-	dst[3] = rgb2[0];
-	dst[4] = rgb2[1];
-	dst[5] = rgb2[2];
-}
-
-inline static void
-UYVY422_to_R8G8B8(const uint8_t *input, uint8_t *dst)
-{
-	uint8_t u = input[0];
-	uint8_t y0 = input[1];
-	uint8_t v = input[2];
-	uint8_t y1 = input[3];
-
-#ifdef USE_TABLE
-	uint8_t *rgb1 = (uint8_t *)&lookup_YUV_to_RGBX[y0][u][v];
-	uint8_t *rgb2 = (uint8_t *)&lookup_YUV_to_RGBX[y1][u][v];
-#else
-	uint32_t rgb1v = YUV444_to_RGBX8888(y0, u, v);
-	uint32_t rgb2v = YUV444_to_RGBX8888(y1, u, v);
-	uint8_t *rgb1 = (uint8_t *)&rgb1v;
-	uint8_t *rgb2 = (uint8_t *)&rgb2v;
-#endif
+static void
+from_YUYV422_to_R8G8B8(
+    struct u_sink_converter *s, struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
+{
+	SINK_TRACE_MARKER();
 
-	dst[0] = rgb1[0];
-	dst[1] = rgb1[1];
-	dst[2] = rgb1[2];
-	dst[3] = rgb2[0];
-	dst[4] = rgb2[1];
-	dst[5] = rgb2[2];
+	convert_rows(s, u_format_row_funcs_get()->YUYV422_to_R8G8B8, dst_frame, w, h, stride, data);
 }
 
-inline static void
-YUV444_to_R8G8B8(const uint8_t *input, uint8_t *dst)
+static void
+from_YUYV422_to_L8(
+    struct u_sink_converter *s, struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
 {
-	uint8_t y = input[0];
-	uint8_t u = input[1];
-	uint8_t v = input[2];
-
-#ifdef USE_TABLE
-	uint8_t *rgb = (uint8_t *)&lookup_YUV_to_RGBX[y][u][v];
-#else
-	uint32_t rgbv = YUV444_to_RGBX8888(y, u, v);
-	uint8_t *rgb = (uint8_t *)&rgbv;
-#endif
+	SINK_TRACE_MARKER();
 
-	dst[0] = rgb[0];
-	dst[1] = rgb[1];
-	dst[2] = rgb[2];
+	convert_rows(s, u_format_row_funcs_get()->YUYV422_to_L8, dst_frame, w, h, stride, data);
 }
 
 static void
-from_YUYV422_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
+from_UYVY422_to_R8G8B8(
+    struct u_sink_converter *s, struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
 {
 	SINK_TRACE_MARKER();
 
-	for (uint32_t y = 0; y < h; y++) {
-		for (uint32_t x = 0; x < w; x += 2) {
-			const uint8_t *src = data;
-			uint8_t *dst = dst_frame->data;
-
-			src = src + (y * stride) + (x * 2);
-			dst = dst + (y * dst_frame->stride) + (x * 3);
-			YUYV422_to_R8G8B8(src, dst);
-		}
-	}
+	convert_rows(s, u_format_row_funcs_get()->UYVY422_to_R8G8B8, dst_frame, w, h, stride, data);
 }
 
 static void
-from_YUYV422_to_L8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
+from_YUV888_to_R8G8B8(
+    struct u_sink_converter *s, struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
 {
 	SINK_TRACE_MARKER();
 
-	for (uint32_t y = 0; y < h; y++) {
-		const uint8_t *src = data + (y * stride);
-		uint8_t *dst = dst_frame->data + (y * dst_frame->stride);
+	convert_rows(s, u_format_row_funcs_get()->YUV888_to_R8G8B8, dst_frame, w, h, stride, data);
+}
 
-		for (uint32_t x = 0; x < w; x++) {
-			dst[x] = src[x * 2];
-		}
-	}
+
+/*
+ *
+ * Bayer, each 2x2 quad becomes one pixel so the output is half the size.
+ *
+ */
+
+static inline void
+convert_bayer_rows(struct u_sink_converter *s,
+                   u_format_bayer_row_func_t func,
+                   struct xrt_frame *dst_frame,
+                   uint32_t w,
+                   uint32_t h,
+                   size_t stride,
+                   const uint8_t *data)
+{
+	struct convert_job job = {
+	    .bayer_func = func,
+	    .dst = dst_frame->data,
+	    .dst_stride = dst_frame->stride,
+	    .src = data,
+	    .src_stride = stride,
+	    .w = w,
+	    .h = h,
+	};
+
+	run_job(s, &job, 2);
 }
 
 static void
-from_UYVY422_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
+from_BAYER_GR8_to_R8G8B8(
+    struct u_sink_converter *s, struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
 {
 	SINK_TRACE_MARKER();
 
-	for (uint32_t y = 0; y < h; y++) {
-		for (uint32_t x = 0; x < w; x += 2) {
-			const uint8_t *src = data;
-			uint8_t *dst = dst_frame->data;
-
-			src = src + (y * stride) + (x * 2);
-			dst = dst + (y * dst_frame->stride) + (x * 3);
-			UYVY422_to_R8G8B8(src, dst);
-		}
-	}
+	convert_bayer_rows(s, u_format_row_funcs_get()->BAYER_GR8_to_R8G8B8, dst_frame, w, h, stride, data);
 }
 
-
 static void
-from_YUV888_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
+from_BAYER_GR8_to_L8(
+    struct u_sink_converter *s, struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
 {
 	SINK_TRACE_MARKER();
 
-	for (uint32_t y = 0; y < h; y++) {
-		for (uint32_t x = 0; x < w; x++) {
-			const uint8_t *src = data;
-			uint8_t *dst = dst_frame->data;
+	convert_bayer_rows(s, u_format_row_funcs_get()->BAYER_GR8_to_L8, dst_frame, w, h, stride, data);
+}
 
-			src = src + (y * stride) + (x * 3);
-			dst = dst + (y * dst_frame->stride) + (x * 3);
-			YUV444_to_R8G8B8(src, dst);
-		}
+
+/*
+ *
+ * Misc functions.
+ *
+ */
+
+
+/*!
+ * Creates a frame that the conversion should happen to, allows to set the size.
+ */
+static bool
+create_frame_with_format_of_size(struct u_sink_converter *s,
+                                 struct xrt_frame *xf,
+                                 uint32_t w,
+                                 uint32_t h,
+                                 enum xrt_format format,
+                                 struct xrt_frame **out_frame)
+{
+	// Downstream might hold on to a couple of frames.
+	if (s->pool == NULL) {
+		s->pool = u_frame_pool_create(4);
 	}
+
+	struct xrt_frame *frame = NULL;
+	u_frame_pool_create_frame(s->pool, format, w, h, &frame);
+	if (frame == NULL) {
+		U_LOG_E("Failed to create target frame!");
+		*out_frame = NULL;
+		return false;
+	}
+
+	frame->timestamp = xf->timestamp;
+	frame->source_timestamp = xf->source_timestamp;
+	frame->source_sequence = xf->source_sequence;
+	frame->source_id = xf->source_id;
+	frame->stereo_format = xf->stereo_format;
+
+	*out_frame = frame;
+
+	return true;
+}
+
+/*!
+ * Creates a frame that the conversion should happen to.
+ */
+static bool
+create_frame_with_format(struct u_sink_converter *s,
+                         struct xrt_frame *xf,
+                         enum xrt_format format,
+                         struct xrt_frame **out_frame)
+{
+	return create_frame_with_format_of_size(s, xf, xf->width, xf->height, format, out_frame);
 }
 
 
@@ -305,15 +361,28 @@ check_header(size_t size, const uint8_t *data)
 	return true;
 }
 
+/*!
+ * Decode a MJPEG frame straight into a new frame of @p format, the size is
+ * taken from the JPEG header after libjpeg has applied the DCT scaling. For L8
+ * only the luma is decoded, skipping the chroma and color conversion.
+ */
 static bool
-from_MJPEG_to_R8G8B8(struct xrt_frame *dst_frame, size_t size, const uint8_t *data)
+decode_MJPEG(struct u_sink_converter *s, struct xrt_frame *xf, enum xrt_format format, struct xrt_frame **out_frame)
 {
 	SINK_TRACE_MARKER();
 
-	if (!check_header(size, data)) {
+	if (!check_header(xf->size, xf->data)) {
 		return false;
 	}
 
+	J_COLOR_SPACE color_space;
+	switch (format) {
+	case XRT_FORMAT_L8: color_space = JCS_GRAYSCALE; break;
+	case XRT_FORMAT_R8G8B8: color_space = JCS_RGB; break;
+	case XRT_FORMAT_YUV888: color_space = JCS_YCbCr; break;
+	default: assert(false); return false;
+	}
+
 	struct jpeg_decompress_struct cinfo = {0};
 	struct jpeg_error_mgr jerr = {0};
 
@@ -321,7 +390,7 @@ from_MJPEG_to_R8G8B8(struct xrt_frame *dst_frame, size_t size, const uint8_t *da
 	jerr.trace_level = 0;
 
 	jpeg_create_decompress(&cinfo);
-	jpeg_mem_src(&cinfo, data, size);
+	jpeg_mem_src(&cinfo, xf->data, xf->size);
 
 	int ret = jpeg_read_header(&cinfo, TRUE);
 	if (ret != JPEG_HEADER_OK) {
@@ -329,151 +398,39 @@ from_MJPEG_to_R8G8B8(struct xrt_frame *dst_frame, size_t size, const uint8_t *da
 		return false;
 	}
 
-	cinfo.out_color_space = JCS_RGB;
-	jpeg_start_decompress(&cinfo);
-
-	uint8_t *moving_ptr = dst_frame->data;
+	cinfo.out_color_space = color_space;
+	cinfo.scale_num = 1;
+	cinfo.scale_denom = s->jpeg_scale_denom > 0 ? s->jpeg_scale_denom : 1;
+	jpeg_calc_output_dimensions(&cinfo);
 
-	uint32_t scanlines_read = 0;
-	while (scanlines_read < cinfo.image_height) {
-		int read_count = jpeg_read_scanlines(&cinfo, &moving_ptr, 16);
-		moving_ptr += read_count * dst_frame->stride;
-		scanlines_read += read_count;
-	}
-
-	jpeg_finish_decompress(&cinfo);
-	jpeg_destroy_decompress(&cinfo);
-
-	return true;
-}
-
-static bool
-from_MJPEG_to_YUV888(struct xrt_frame *dst_frame, size_t size, const uint8_t *data)
-{
-	SINK_TRACE_MARKER();
-
-	if (!check_header(size, data)) {
-		return false;
-	}
-
-	struct jpeg_decompress_struct cinfo = {0};
-	struct jpeg_error_mgr jerr = {0};
-
-	cinfo.err = jpeg_std_error(&jerr);
-	jerr.trace_level = 0;
-
-	jpeg_create_decompress(&cinfo);
-	jpeg_mem_src(&cinfo, data, size);
-
-	int ret = jpeg_read_header(&cinfo, TRUE);
-	if (ret != JPEG_HEADER_OK) {
+	struct xrt_frame *frame = NULL;
+	if (!create_frame_with_format_of_size(s, xf, cinfo.output_width, cinfo.output_height, format, &frame)) {
 		jpeg_destroy_decompress(&cinfo);
 		return false;
 	}
 
-	cinfo.out_color_space = JCS_YCbCr;
 	jpeg_start_decompress(&cinfo);
 
-	uint8_t *moving_ptr = dst_frame->data;
+	while (cinfo.output_scanline < cinfo.output_height) {
+		JSAMPROW rows[16];
+		uint32_t count = cinfo.output_height - cinfo.output_scanline;
+		count = count < ARRAY_SIZE(rows) ? count : ARRAY_SIZE(rows);
 
-	uint32_t scanlines_read = 0;
-	while (scanlines_read < cinfo.image_height) {
-		int read_count = jpeg_read_scanlines(&cinfo, &moving_ptr, 16);
-		moving_ptr += read_count * dst_frame->stride;
-		scanlines_read += read_count;
-	}
-
-	jpeg_finish_decompress(&cinfo);
-	jpeg_destroy_decompress(&cinfo);
-
-	return true;
-}
-#endif
-
-
-/*
- *
- * Bayer
- *
- */
-
-static void
-from_BAYER_GR8_to_R8G8B8(struct xrt_frame *dst_frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
-{
-	SINK_TRACE_MARKER();
-
-	const uint8_t *src_data = data;
-	size_t src_stride = stride;
-
-	uint8_t *dst_data = dst_frame->data;
-	size_t dst_stride = dst_frame->stride;
-
-	for (uint32_t y = 0; y < h; y++) {
-		const uint8_t *src0 = src_data + (y * 2) * src_stride;
-		const uint8_t *src1 = src_data + (y * 2 + 1) * src_stride;
-		uint8_t *dst = dst_data + (y * dst_stride);
-
-		for (uint32_t x = 0; x < w; x++) {
-			uint8_t g0 = src0[0];
-			uint8_t r = src0[1];
-			uint8_t b = src1[0];
-			uint8_t g1 = src1[1];
-
-			dst[0] = r;
-			dst[1] = (g0 + g1) / 2;
-			dst[2] = b;
-
-			src0 += 2;
-			src1 += 2;
-			dst += 3;
+		for (uint32_t i = 0; i < count; i++) {
+			rows[i] = frame->data + (cinfo.output_scanline + i) * frame->stride;
 		}
-	}
-}
-
-
-/*
- *
- * Misc functions.
- *
- */
-
 
-/*!
- * Creates a frame that the conversion should happen to, allows to set the size.
- *
- * @todo Allocate from a pool of frames.
- */
-static bool
-create_frame_with_format_of_size(
-    struct xrt_frame *xf, uint32_t w, uint32_t h, enum xrt_format format, struct xrt_frame **out_frame)
-{
-	struct xrt_frame *frame = NULL;
-	u_frame_create_one_off(format, w, h, &frame);
-	if (frame == NULL) {
-		U_LOG_E("Failed to create target frame!");
-		*out_frame = NULL;
-		return false;
+		jpeg_read_scanlines(&cinfo, rows, count);
 	}
 
-	frame->timestamp = xf->timestamp;
-	frame->source_timestamp = xf->source_timestamp;
-	frame->source_sequence = xf->source_sequence;
-	frame->source_id = xf->source_id;
-	frame->stereo_format = xf->stereo_format;
+	jpeg_finish_decompress(&cinfo);
+	jpeg_destroy_decompress(&cinfo);
 
 	*out_frame = frame;
 
 	return true;
 }
-
-/*!
- * Creates a frame that the conversion should happen to.
- */
-static bool
-create_frame_with_format(struct xrt_frame *xf, enum xrt_format format, struct xrt_frame **out_frame)
-{
-	return create_frame_with_format_of_size(xf, xf->width, xf->height, format, out_frame);
-}
+#endif
 
 static void
 convert_frame_l8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
@@ -486,12 +443,27 @@ convert_frame_l8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 
 	switch (xf->format) {
 	case XRT_FORMAT_L8: s->downstream->push_frame(s->downstream, xf); return;
+	case XRT_FORMAT_BAYER_GR8:;
+		uint32_t w = xf->width / 2;
+		uint32_t h = xf->height / 2;
+		if (!create_frame_with_format_of_size(s, xf, w, h, XRT_FORMAT_L8, &converted)) {
+			return;
+		}
+		from_BAYER_GR8_to_L8(s, converted, w, h, xf->stride, xf->data);
+		break;
 	case XRT_FORMAT_YUYV422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_L8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_L8, &converted)) {
 			return;
 		}
-		from_YUYV422_to_L8(converted, xf->width, xf->height, xf->stride, xf->data);
+		from_YUYV422_to_L8(s, converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
+#ifdef XRT_HAVE_JPEG
+	case XRT_FORMAT_MJPEG:
+		if (!decode_MJPEG(s, xf, XRT_FORMAT_L8, &converted)) {
+			return;
+		}
+		break;
+#endif
 	default: U_LOG_E("Cannot convert from '%s' to L8!", u_format_str(xf->format)); return;
 	}
 
@@ -516,37 +488,32 @@ convert_frame_r8g8b8_or_l8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	case XRT_FORMAT_BAYER_GR8:;
 		uint32_t w = xf->width / 2;
 		uint32_t h = xf->height / 2;
-		if (!create_frame_with_format_of_size(xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format_of_size(s, xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
-		from_BAYER_GR8_to_R8G8B8(converted, w, h, xf->stride, xf->data);
+		from_BAYER_GR8_to_R8G8B8(s, converted, w, h, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUYV422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
-		from_YUYV422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
+		from_YUYV422_to_R8G8B8(s, converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_UYVY422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
-		from_UYVY422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
+		from_UYVY422_to_R8G8B8(s, converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUV888:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
-		from_YUV888_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
+		from_YUV888_to_R8G8B8(s, converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
-			return;
-		}
-		if (!from_MJPEG_to_R8G8B8(converted, xf->size, xf->data)) {
-			// Make sure to free frame when we fail to decode.
-			xrt_frame_reference(&converted, NULL);
+		if (!decode_MJPEG(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		break;
@@ -590,31 +557,26 @@ convert_frame_r8g8b8_bayer_or_l8(struct xrt_frame_sink *xs, struct xrt_frame *xf
 	case XRT_FORMAT_R8G8B8:
 	case XRT_FORMAT_BAYER_GR8:; s->downstream->push_frame(s->downstream, xf); return;
 	case XRT_FORMAT_YUYV422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
-		from_YUYV422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
+		from_YUYV422_to_R8G8B8(s, converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_UYVY422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
-		from_UYVY422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
+		from_UYVY422_to_R8G8B8(s, converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUV888:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
-		from_YUV888_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
+		from_YUV888_to_R8G8B8(s, converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
-			return;
-		}
-		if (!from_MJPEG_to_R8G8B8(converted, xf->size, xf->data)) {
-			// Make sure to free frame when we fail to decode.
-			xrt_frame_reference(&converted, NULL);
+		if (!decode_MJPEG(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		break;
@@ -640,45 +602,40 @@ convert_frame_r8g8b8(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	switch (xf->format) {
 	case XRT_FORMAT_R8G8B8: s->downstream->push_frame(s->downstream, xf); return;
 	case XRT_FORMAT_L8:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
-		from_L8_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
+		from_L8_to_R8G8B8(s, converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_BAYER_GR8:;
 		uint32_t w = xf->width / 2;
 		uint32_t h = xf->height / 2;
-		if (!create_frame_with_format_of_size(xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format_of_size(s, xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
-		from_BAYER_GR8_to_R8G8B8(converted, w, h, xf->stride, xf->data);
+		from_BAYER_GR8_to_R8G8B8(s, converted, w, h, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUYV422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
-		from_YUYV422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
+		from_YUYV422_to_R8G8B8(s, converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_UYVY422:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
-		from_UYVY422_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
+		from_UYVY422_to_R8G8B8(s, converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 	case XRT_FORMAT_YUV888:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
+		if (!create_frame_with_format(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
-		from_YUV888_to_R8G8B8(converted, xf->width, xf->height, xf->stride, xf->data);
+		from_YUV888_to_R8G8B8(s, converted, xf->width, xf->height, xf->stride, xf->data);
 		break;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_R8G8B8, &converted)) {
-			return;
-		}
-		if (!from_MJPEG_to_R8G8B8(converted, xf->size, xf->data)) {
-			// Make sure to free frame when we fail to decode.
-			xrt_frame_reference(&converted, NULL);
+		if (!decode_MJPEG(s, xf, XRT_FORMAT_R8G8B8, &converted)) {
 			return;
 		}
 		break;
@@ -709,10 +666,7 @@ convert_frame_rgb_yuv_yuyv_uyvy_or_l8(struct xrt_frame_sink *xs, struct xrt_fram
 	case XRT_FORMAT_YUV888: s->downstream->push_frame(s->downstream, xf); return;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_YUV888, &converted)) {
-			return;
-		}
-		if (!from_MJPEG_to_YUV888(converted, xf->size, xf->data)) {
+		if (!decode_MJPEG(s, xf, XRT_FORMAT_YUV888, &converted)) {
 			return;
 		}
 		break;
@@ -744,10 +698,7 @@ convert_frame_yuv_yuyv_uyvy_or_l8(struct xrt_frame_sink *xs, struct xrt_frame *x
 	case XRT_FORMAT_YUV888: s->downstream->push_frame(s->downstream, xf); return;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_YUV888, &converted)) {
-			return;
-		}
-		if (!from_MJPEG_to_YUV888(converted, xf->size, xf->data)) {
+		if (!decode_MJPEG(s, xf, XRT_FORMAT_YUV888, &converted)) {
 			return;
 		}
 		break;
@@ -780,10 +731,7 @@ convert_frame_yuv_or_yuyv(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	case XRT_FORMAT_YUV888: s->downstream->push_frame(s->downstream, xf); return;
 #ifdef XRT_HAVE_JPEG
 	case XRT_FORMAT_MJPEG:
-		if (!create_frame_with_format(xf, XRT_FORMAT_YUV888, &converted)) {
-			return;
-		}
-		if (!from_MJPEG_to_YUV888(converted, xf->size, xf->data)) {
+		if (!decode_MJPEG(s, xf, XRT_FORMAT_YUV888, &converted)) {
 			return;
 		}
 		break;
@@ -808,11 +756,11 @@ convert_frame_bayer(struct xrt_frame_sink *xs, struct xrt_frame *xf)
 	uint32_t h = xf->height / 2;
 	struct xrt_frame *converted = NULL;
 
-	if (!create_frame_with_format_of_size(xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
+	if (!create_frame_with_format_of_size(s, xf, w, h, XRT_FORMAT_R8G8B8, &converted)) {
 		return;
 	}
 
-	from_BAYER_GR8_to_R8G8B8(converted, w, h, xf->stride, xf->data);
+	from_BAYER_GR8_to_R8G8B8(s, converted, w, h, xf->stride, xf->data);
 
 	s->downstream->push_frame(s->downstream, converted);
 
@@ -829,6 +777,10 @@ destroy(struct xrt_frame_node *node)
 {
 	struct u_sink_converter *s = container_of(node, struct u_sink_converter, node);
 
+	u_worker_group_reference(&s->group, NULL);
+	u_worker_thread_pool_reference(&s->workers, NULL);
+	u_frame_pool_destroy(&s->pool);
+
 	free(s);
 }
 
@@ -844,8 +796,19 @@ u_sink_create_format_converter(struct xrt_frame_context *xfctx,
                                enum xrt_format format,
                                struct xrt_frame_sink *downstream,
                                struct xrt_frame_sink **out_xfs)
+{
+	u_sink_create_format_converter_scaled(xfctx, format, 1, downstream, out_xfs);
+}
+
+void
+u_sink_create_format_converter_scaled(struct xrt_frame_context *xfctx,
+                                      enum xrt_format format,
+                                      uint32_t jpeg_scale_denom,
+                                      struct xrt_frame_sink *downstream,
+                                      struct xrt_frame_sink **out_xfs)
 {
 	assert(downstream != NULL);
+	assert(jpeg_scale_denom == 1 || jpeg_scale_denom == 2 || jpeg_scale_denom == 4 || jpeg_scale_denom == 8);
 
 	void (*func)(struct xrt_frame_sink *, struct xrt_frame *);
 
@@ -855,15 +818,12 @@ u_sink_create_format_converter(struct xrt_frame_context *xfctx,
 	default: U_LOG_E("Format '%s' not supported", u_format_str(format)); return;
 	}
 
-#ifdef USE_TABLE
-	generate_lookup_YUV_to_RGBX();
-#endif
-
 	struct u_sink_converter *s = U_TYPED_CALLOC(struct u_sink_converter);
 	s->base.push_frame = func;
 	s->node.break_apart = break_apart;
 	s->node.destroy = destroy;
 	s->downstream = downstream;
+	s->jpeg_scale_denom = jpeg_scale_denom;
 
 	xrt_frame_context_add(xfctx, &s->node);
 
@@ -883,10 +843,6 @@ u_sink_create_to_r8g8b8_or_l8(struct xrt_frame_context *xfctx,
 	s->node.destroy = destroy;
 	s->downstream = downstream;
 
-#ifdef USE_TABLE
-	generate_lookup_YUV_to_RGBX();
-#endif
-
 	xrt_frame_context_add(xfctx, &s->node);
 
 	*out_xfs = &s->base;
@@ -905,10 +861,6 @@ u_sink_create_to_r8g8b8_r8g8b8a8_r8g8b8x8_or_l8(struct xrt_frame_context *xfctx,
 	s->node.destroy = destroy;
 	s->downstream = downstream;
 
-#ifdef USE_TABLE
-	generate_lookup_YUV_to_RGBX();
-#endif
-
 	xrt_frame_context_add(xfctx, &s->node);
 
 	*out_xfs = &s->base;
@@ -1,4 +1,4 @@
-// Copyright 2019-2021, Collabora, Ltd.
+// Copyright 2019-2024, Collabora, Ltd.
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
@@ -11,6 +11,7 @@
 #include "util/u_misc.h"
 #include "util/u_sink.h"
 #include "util/u_frame.h"
+#include "util/u_format_rows.h"
 #include "util/u_trace_marker.h"
 
 
@@ -25,6 +26,12 @@ struct u_sink_deinterleaver
 	struct xrt_frame_node node;
 
 	struct xrt_frame_sink *downstream;
+
+	//! Deinterleaved frames.
+	struct u_frame_pool *pool;
+
+	//! Row functions, SIMD if supported.
+	const struct u_format_row_funcs *funcs;
 };
 
 
@@ -34,30 +41,21 @@ struct u_sink_deinterleaver
  *
  */
 
-inline static void
-L8_interleaved_to_L8(const uint8_t *input, uint8_t *l8a, uint8_t *l8b)
-{
-	*l8a = input[0];
-	*l8b = input[1];
-}
-
 static void
-from_L8_interleaved_to_L8(struct xrt_frame *frame, uint32_t w, uint32_t h, size_t stride, const uint8_t *data)
+from_L8_interleaved_to_L8(struct u_sink_deinterleaver *de,
+                          struct xrt_frame *frame,
+                          uint32_t w,
+                          uint32_t h,
+                          size_t stride,
+                          const uint8_t *data)
 {
 	SINK_TRACE_MARKER();
 
-	uint32_t half_w = w / 2;
-
 	for (uint32_t y = 0; y < h; y++) {
 		const uint8_t *src = data + (y * stride);
 		uint8_t *dst = frame->data + (y * frame->stride);
 
-		for (uint32_t x = 0; x < half_w; x++) {
-			L8_interleaved_to_L8(src, dst, dst + half_w);
-
-			dst += 1;
-			src += 2;
-		}
+		de->funcs->L8_INTERLEAVED_to_L8_SBS(dst, src, w);
 	}
 }
 
@@ -92,7 +90,7 @@ deinterleave_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 	const uint8_t *data = xf->data;
 	struct xrt_frame *frame = NULL;
 
-	u_frame_create_one_off(format, w, h, &frame);
+	u_frame_pool_create_frame(de->pool, format, w, h, &frame);
 
 	// Copy directly from original frame.
 	frame->timestamp = xf->timestamp;
@@ -102,7 +100,7 @@ deinterleave_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 	frame->stereo_format = XRT_STEREO_FORMAT_SBS;
 
 	// Copy the data.
-	from_L8_interleaved_to_L8(frame, w, h, stride, data);
+	from_L8_interleaved_to_L8(de, frame, w, h, stride, data);
 
 	// Push downstream.
 	de->downstream->push_frame(de->downstream, frame);
@@ -122,6 +120,8 @@ deinterleave_destroy(struct xrt_frame_node *node)
 {
 	struct u_sink_deinterleaver *de = container_of(node, struct u_sink_deinterleaver, node);
 
+	u_frame_pool_destroy(&de->pool);
+
 	free(de);
 }
 
@@ -143,6 +143,8 @@ u_sink_deinterleaver_create(struct xrt_frame_context *xfctx,
 	de->node.break_apart = deinterleave_break_apart;
 	de->node.destroy = deinterleave_destroy;
 	de->downstream = downstream;
+	de->pool = u_frame_pool_create(4);
+	de->funcs = u_format_row_funcs_get();
 
 	xrt_frame_context_add(xfctx, &de->node);
 
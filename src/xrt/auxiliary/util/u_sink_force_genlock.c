@@ -1,4 +1,4 @@
-// Copyright 2019-2021, Collabora, Ltd.
+// Copyright 2019-2024, Collabora, Ltd.
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
@@ -8,6 +8,7 @@
  * @ingroup aux_util
  */
 
+#include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_sink.h"
 #include "util/u_frame.h"
@@ -15,13 +16,34 @@
 #include "util/u_trace_marker.h"
 
 #include <stdio.h>
+#include <assert.h>
 #include <pthread.h>
 #include <inttypes.h>
 
 
+//! Frames of one side kept around waiting for a match.
+#define STREAM_SIZE (4)
+
+//! Matched pairs waiting for the thread.
+#define READY_SIZE (2)
+
+//! Frames further apart then this are not a pair.
+#define MAX_DIFF_NS (U_TIME_1MS_IN_NS)
+
+/*!
+ * Frames of one side that has not been matched yet, sorted by timestamp with
+ * the oldest first.
+ */
+struct genlock_stream
+{
+	struct xrt_frame *frames[STREAM_SIZE];
+	uint32_t count;
+};
+
 /*!
  * An @ref xrt_frame_sink that takes two frames in any order, and pushes downstream in left-right order once it
- * has two frames that are close enough together. Shouldn't ever drop frames.
+ * has two frames that are close enough together. Frames that can no longer be matched, or that arrive after a
+ * newer pair has been matched, are dropped and counted.
  *
  * @implements xrt_frame_sink
  * @implements xrt_frame_node
@@ -41,8 +63,15 @@ struct u_sink_force_genlock
 	struct xrt_frame_sink *consumer_left;
 	struct xrt_frame_sink *consumer_right;
 
-	//! The current queued frame.
-	struct xrt_frame *frames[2];
+	//! Unmatched frames of the left and right side.
+	struct genlock_stream streams[2];
+
+	//! Matched pairs waiting to be pushed by the thread, oldest first.
+	struct xrt_frame *ready[READY_SIZE][2];
+	uint32_t ready_count;
+
+	//! Timestamp of the newest matched frame, older frames are late.
+	int64_t last_matched_ts;
 
 	pthread_t thread;
 	pthread_mutex_t mutex;
@@ -51,11 +80,208 @@ struct u_sink_force_genlock
 	//! Timestamp of the last frameset we pushed.
 	int64_t last_ts;
 
+	struct
+	{
+		//! Pairs of frames matched.
+		uint64_t matched;
+
+		//! Frames that were never matched or whose pair was replaced by newer ones.
+		uint64_t dropped;
+
+		//! Frames older then the last matched pair.
+		uint64_t late;
+	} stats;
+
 	//! Should we keep running?
 	//! currently, true upon startup, false as we're exiting.
 	bool running;
 };
 
+
+/*
+ *
+ * Matching functions, all called with the mutex held.
+ *
+ */
+
+static int64_t
+abs_diff(int64_t a, int64_t b)
+{
+	return a > b ? a - b : b - a;
+}
+
+//! Drops the @p count oldest frames of the stream.
+static void
+stream_drop_oldest(struct u_sink_force_genlock *q, struct genlock_stream *stream, uint32_t count)
+{
+	assert(count <= stream->count);
+
+	for (uint32_t i = 0; i < count; i++) {
+		xrt_frame_reference(&stream->frames[i], NULL);
+	}
+
+	for (uint32_t i = count; i < stream->count; i++) {
+		stream->frames[i - count] = stream->frames[i];
+	}
+
+	stream->count -= count;
+	for (uint32_t i = stream->count; i < stream->count + count; i++) {
+		stream->frames[i] = NULL;
+	}
+
+	q->stats.dropped += count;
+}
+
+//! Removes the oldest frame, the reference is moved to the caller.
+static struct xrt_frame *
+stream_take_front(struct genlock_stream *stream)
+{
+	assert(stream->count > 0);
+
+	struct xrt_frame *xf = stream->frames[0];
+	for (uint32_t i = 1; i < stream->count; i++) {
+		stream->frames[i - 1] = stream->frames[i];
+	}
+
+	stream->count--;
+	stream->frames[stream->count] = NULL;
+
+	return xf;
+}
+
+//! Keeps the stream sorted, the usual case of a newest frame is just an append.
+static void
+stream_insert(struct u_sink_force_genlock *q, struct genlock_stream *stream, struct xrt_frame *xf)
+{
+	if (stream->count == STREAM_SIZE) {
+		stream_drop_oldest(q, stream, 1);
+	}
+
+	uint32_t i = stream->count;
+	while (i > 0 && (int64_t)stream->frames[i - 1]->timestamp > (int64_t)xf->timestamp) {
+		stream->frames[i] = stream->frames[i - 1];
+		i--;
+	}
+
+	stream->frames[i] = NULL;
+	xrt_frame_reference(&stream->frames[i], xf);
+	stream->count++;
+}
+
+//! Index of the frame nearest to @p ts within @ref MAX_DIFF_NS, or -1.
+static int
+stream_find_nearest(struct genlock_stream *stream, int64_t ts)
+{
+	int best = -1;
+	int64_t best_diff = MAX_DIFF_NS + 1;
+
+	// Sorted, so stop once the frames get further away.
+	for (uint32_t i = 0; i < stream->count; i++) {
+		int64_t diff = abs_diff((int64_t)stream->frames[i]->timestamp, ts);
+		if (diff < best_diff) {
+			best = (int)i;
+			best_diff = diff;
+		} else if ((int64_t)stream->frames[i]->timestamp > ts) {
+			break;
+		}
+	}
+
+	return best;
+}
+
+static void
+push_ready(struct u_sink_force_genlock *q, struct xrt_frame *left, struct xrt_frame *right)
+{
+	// The thread is behind, drop the oldest pair.
+	if (q->ready_count == READY_SIZE) {
+		xrt_frame_reference(&q->ready[0][0], NULL);
+		xrt_frame_reference(&q->ready[0][1], NULL);
+		for (uint32_t i = 1; i < READY_SIZE; i++) {
+			q->ready[i - 1][0] = q->ready[i][0];
+			q->ready[i - 1][1] = q->ready[i][1];
+		}
+		q->ready[READY_SIZE - 1][0] = NULL;
+		q->ready[READY_SIZE - 1][1] = NULL;
+		q->ready_count--;
+		q->stats.dropped += 2;
+	}
+
+	// Moves the references.
+	q->ready[q->ready_count][0] = left;
+	q->ready[q->ready_count][1] = right;
+	q->ready_count++;
+
+	pthread_cond_signal(&q->cond);
+}
+
+static void
+push_and_match(struct u_sink_force_genlock *q, uint32_t side, struct xrt_frame *xf)
+{
+	int64_t ts = (int64_t)xf->timestamp;
+
+	if (q->stats.matched > 0 && ts <= q->last_matched_ts) {
+		q->stats.late++;
+		return;
+	}
+
+	struct genlock_stream *own = &q->streams[side];
+	struct genlock_stream *other = &q->streams[side ^ 1];
+
+	int index = stream_find_nearest(other, ts);
+	if (index < 0) {
+		stream_insert(q, own, xf);
+		return;
+	}
+
+	// Older frames can't be matched anymore as both sides move forward.
+	stream_drop_oldest(q, other, (uint32_t)index);
+
+	uint32_t own_older = 0;
+	while (own_older < own->count && (int64_t)own->frames[own_older]->timestamp < ts) {
+		own_older++;
+	}
+	stream_drop_oldest(q, own, own_older);
+
+	struct xrt_frame *match = stream_take_front(other);
+
+	struct xrt_frame *frame = NULL;
+	xrt_frame_reference(&frame, xf);
+
+	q->last_matched_ts = ts > (int64_t)match->timestamp ? ts : (int64_t)match->timestamp;
+	q->stats.matched++;
+
+	if (side == 0) {
+		push_ready(q, frame, match);
+	} else {
+		push_ready(q, match, frame);
+	}
+}
+
+static void
+clear_all(struct u_sink_force_genlock *q)
+{
+	for (uint32_t side = 0; side < 2; side++) {
+		struct genlock_stream *stream = &q->streams[side];
+		for (uint32_t i = 0; i < stream->count; i++) {
+			xrt_frame_reference(&stream->frames[i], NULL);
+		}
+		stream->count = 0;
+	}
+
+	for (uint32_t i = 0; i < q->ready_count; i++) {
+		xrt_frame_reference(&q->ready[i][0], NULL);
+		xrt_frame_reference(&q->ready[i][1], NULL);
+	}
+	q->ready_count = 0;
+}
+
+
+/*
+ *
+ * Thread and sink functions.
+ *
+ */
+
 static void *
 force_genlock_mainloop(void *ptr)
 {
@@ -67,8 +293,8 @@ force_genlock_mainloop(void *ptr)
 	pthread_mutex_lock(&q->mutex);
 
 	while (q->running) {
-		// Wait for both frames.
-		if (q->frames[0] == NULL || q->frames[1] == NULL) {
+		// Wait for a matched pair.
+		if (q->ready_count == 0) {
 			pthread_cond_wait(&q->cond, &q->mutex);
 		}
 
@@ -78,46 +304,25 @@ force_genlock_mainloop(void *ptr)
 			break;
 		}
 
-		if (q->frames[0] == NULL || q->frames[1] == NULL) {
+		if (q->ready_count == 0) {
 			continue;
 		}
 
 		SINK_TRACE_IDENT(force_genlock_frame);
 
 		/*
-		 * We need to take a reference on the current frame, this is to
-		 * keep it alive during the call to the consumer should it be
-		 * replaced. But we no longer need to hold onto the frame on the
-		 * queue so we move the pointer.
+		 * Take the oldest pair, the references are moved to us so they
+		 * stay alive during the call to the consumers.
 		 */
-		frames[0] = q->frames[0];
-		frames[1] = q->frames[1];
-		q->frames[0] = NULL;
-		q->frames[1] = NULL;
-
-		/*
-		 * Check timestamps.
-		 */
-		int64_t diff_ns = frames[0]->timestamp - frames[1]->timestamp;
-		if (diff_ns < -U_TIME_1MS_IN_NS || diff_ns > U_TIME_1MS_IN_NS) {
-
-			U_LOG_W("Frame differ in timestamps too much! (%lli)", (long long)diff_ns);
-
-			// Save the most recent frame.
-			if (diff_ns > 0) {
-				xrt_frame_reference(&q->frames[0], frames[0]);
-			} else {
-				xrt_frame_reference(&q->frames[1], frames[1]);
-			}
-			pthread_mutex_unlock(&q->mutex);
-
-			// Don't hold the lock while releasing the frames.
-			xrt_frame_reference(&frames[0], NULL);
-			xrt_frame_reference(&frames[1], NULL);
-
-			pthread_mutex_lock(&q->mutex);
-			continue;
+		frames[0] = q->ready[0][0];
+		frames[1] = q->ready[0][1];
+		for (uint32_t i = 1; i < q->ready_count; i++) {
+			q->ready[i - 1][0] = q->ready[i][0];
+			q->ready[i - 1][1] = q->ready[i][1];
 		}
+		q->ready_count--;
+		q->ready[q->ready_count][0] = NULL;
+		q->ready[q->ready_count][1] = NULL;
 
 		/*
 		 * Unlock the mutex when we do the work, so a new frame can be
@@ -153,6 +358,8 @@ force_genlock_mainloop(void *ptr)
 			xrt_sink_push_frame(q->consumer_left, frames[0]);
 			xrt_sink_push_frame(q->consumer_right, frames[1]);
 		}
+		q->last_ts = ts;
+
 		/*
 		 * Drop our reference - we don't need it anymore. If the consumer wants to keep it, they will have
 		 * referenced it in their push_frame handler.
@@ -180,12 +387,7 @@ force_genlock_left_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 
 	// Only schedule new frames if we are running.
 	if (q->running) {
-		xrt_frame_reference(&q->frames[0], xf);
-	}
-
-	// Wake up the thread, if both frames are here.
-	if (q->frames[0] != NULL && q->frames[1] != NULL) {
-		pthread_cond_signal(&q->cond);
+		push_and_match(q, 0, xf);
 	}
 
 	pthread_mutex_unlock(&q->mutex);
@@ -202,12 +404,7 @@ force_genlock_right_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 
 	// Only schedule new frames if we are running.
 	if (q->running) {
-		xrt_frame_reference(&q->frames[1], xf);
-	}
-
-	// Wake up the thread, if both frames are here.
-	if (q->frames[0] != NULL && q->frames[1] != NULL) {
-		pthread_cond_signal(&q->cond);
+		push_and_match(q, 1, xf);
 	}
 
 	pthread_mutex_unlock(&q->mutex);
@@ -226,8 +423,7 @@ force_genlock_break_apart(struct xrt_frame_node *node)
 	q->running = false;
 
 	// Release any frame waiting for submission.
-	xrt_frame_reference(&q->frames[0], NULL);
-	xrt_frame_reference(&q->frames[1], NULL);
+	clear_all(q);
 
 	// Wake up the thread.
 	pthread_cond_signal(&q->cond);
@@ -244,6 +440,9 @@ force_genlock_destroy(struct xrt_frame_node *node)
 {
 	struct u_sink_force_genlock *q = container_of(node, struct u_sink_force_genlock, node);
 
+	// Remove the variable tracking.
+	u_var_remove_root(q);
+
 	// Destroy resources.
 	pthread_mutex_destroy(&q->mutex);
 	pthread_cond_destroy(&q->cond);
@@ -296,6 +495,11 @@ u_sink_force_genlock_create(struct xrt_frame_context *xfctx,
 		return false;
 	}
 
+	u_var_add_root(q, "Force Genlock", true);
+	u_var_add_ro_u64(q, &q->stats.matched, "Matched pairs");
+	u_var_add_ro_u64(q, &q->stats.dropped, "Dropped frames");
+	u_var_add_ro_u64(q, &q->stats.late, "Late frames");
+
 	xrt_frame_context_add(xfctx, &q->node);
 
 	*out_left_xfs = &q->left;
@@ -1,4 +1,4 @@
-// Copyright 2019-2021, Collabora, Ltd.
+// Copyright 2019-2024, Collabora, Ltd.
 // SPDX-License-Identifier: BSL-1.0
 /*!
  * @file
@@ -7,23 +7,56 @@
  * @ingroup aux_util
  */
 
+#include "os/os_time.h"
+
+#include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_sink.h"
+#include "util/u_debug.h"
+#include "util/u_worker.h"
+#include "util/u_histogram.h"
 #include "util/u_trace_marker.h"
 
 #include <stdio.h>
 #include <pthread.h>
 
+
+//! How often the numbers shown in the debug gui are updated.
+#define STATS_PERIOD_NS (1000 * U_TIME_1MS_IN_NS)
+
+DEBUG_GET_ONCE_BOOL_OPTION(shared_pool, "XRT_SINK_QUEUE_SHARED_POOL", false)
+DEBUG_GET_ONCE_NUM_OPTION(shared_pool_threads, "XRT_SINK_QUEUE_SHARED_POOL_THREADS", 4)
+
 struct u_sink_queue_elem
 {
 	struct xrt_frame *frame;
 	struct u_sink_queue_elem *next;
+
+	//! When the frame was queued, for the latency.
+	int64_t enqueued_ns;
+};
+
+/*!
+ * Percentiles of a timing of the queue over the last stats period.
+ */
+struct u_sink_queue_timing
+{
+	//! Only added to from the queue thread.
+	struct u_hist_ns *hist;
+
+	//! State at the last update, subtracted to get the values of the period.
+	struct u_hist_ns_snapshot last;
+
+	//! For the debug gui.
+	float p50_ms;
+	float p99_ms;
+	float worst_ms;
 };
 
 /*!
  * An @ref xrt_frame_sink queue, any frames received will be pushed to the
- * downstream consumer on the queue thread. Will drop frames should multiple
- * frames be queued up.
+ * downstream consumer on the queue thread. Will drop frames, according to
+ * @ref u_sink_queue_drop_policy, should more then the max size be queued up.
  *
  * @implements xrt_frame_sink
  * @implements xrt_frame_node
@@ -47,17 +80,51 @@ struct u_sink_queue
 	//! Number of currently enqueued frames
 	uint64_t size;
 
-	//! Max amount of frames before dropping new ones. 0 means unbounded.
+	//! Max amount of frames before dropping frames. 0 means unbounded.
 	uint64_t max_size;
 
+	//! Which frame to drop when full.
+	enum u_sink_queue_drop_policy drop_policy;
+
+	//! Only used if not running on the shared pool.
 	pthread_t thread;
 	pthread_mutex_t mutex;
 
 	//! So we can wake the mainloop up
 	pthread_cond_t cond;
 
+	/*!
+	 * If set the frames are consumed by tasks on the shared pool instead
+	 * of on our own thread, one task at a time to keep them in order.
+	 */
+	struct u_worker_group *group;
+
+	//! Is there a task queued or running on @ref group.
+	bool task_scheduled;
+
 	//! Should we keep running.
 	bool running;
+
+	struct
+	{
+		//! Frames given to the queue, including dropped ones.
+		uint64_t pushed;
+
+		//! Frames that never reached the consumer.
+		uint64_t dropped;
+
+		//! Time from a frame being queued to given to the consumer.
+		struct u_sink_queue_timing latency;
+
+		//! Time spent in the consumer for each frame.
+		struct u_sink_queue_timing busy;
+
+		//! Part of the last stats period spent in the consumer.
+		float busy_percent;
+
+		int64_t period_start_ns;
+		uint64_t period_busy_ns;
+	} stats;
 };
 
 //! Call with q->mutex locked.
@@ -78,10 +145,11 @@ queue_is_full(struct u_sink_queue *q)
 //! Pops the oldest frame, reference counting unchanged.
 //! Call with q->mutex locked.
 static struct xrt_frame *
-queue_pop(struct u_sink_queue *q)
+queue_pop_with_time(struct u_sink_queue *q, int64_t *out_enqueued_ns)
 {
 	assert(!queue_is_empty(q));
 	struct xrt_frame *frame = q->front->frame;
+	*out_enqueued_ns = q->front->enqueued_ns;
 	struct u_sink_queue_elem *old_front = q->front;
 	q->front = q->front->next;
 	free(old_front);
@@ -93,16 +161,38 @@ queue_pop(struct u_sink_queue *q)
 	return frame;
 }
 
-//! Tries to push a frame and increases its reference count.
+//! Call with q->mutex locked.
+static struct xrt_frame *
+queue_pop(struct u_sink_queue *q)
+{
+	int64_t enqueued_ns = 0;
+	return queue_pop_with_time(q, &enqueued_ns);
+}
+
+//! Tries to push a frame and increases its reference count, if the queue is
+//! full either the oldest queued or this frame is dropped.
 //! Call with q->mutex locked.
 static bool
 queue_try_refpush(struct u_sink_queue *q, struct xrt_frame *xf)
 {
+	q->stats.pushed++;
+
 	if (queue_is_full(q)) {
-		return false;
+		SINK_TRACE_IDENT(queue_drop);
+
+		q->stats.dropped++;
+
+		if (q->drop_policy == U_SINK_QUEUE_DROP_NEWEST || queue_is_empty(q)) {
+			return false;
+		}
+
+		struct xrt_frame *oldest = queue_pop(q);
+		xrt_frame_reference(&oldest, NULL);
 	}
+
 	struct u_sink_queue_elem *elem = U_TYPED_CALLOC(struct u_sink_queue_elem);
 	xrt_frame_reference(&elem->frame, xf);
+	elem->enqueued_ns = os_monotonic_get_ns();
 	elem->next = NULL;
 	if (q->back == NULL) { // First frame
 		q->front = elem;
@@ -126,13 +216,195 @@ queue_refclear(struct u_sink_queue *q)
 	}
 }
 
+static void
+timing_init(struct u_sink_queue_timing *t)
+{
+	t->hist = u_hist_ns_create();
+}
+
+static void
+timing_update(struct u_sink_queue_timing *t)
+{
+	// Too big for the stack.
+	struct u_hist_ns_snapshot *period = U_TYPED_CALLOC(struct u_hist_ns_snapshot);
+	struct u_hist_ns_stats stats;
+
+	// Only keep the values of this period, then make last equal to now again.
+	u_hist_ns_get_snapshot(t->hist, period);
+	u_hist_ns_snapshot_subtract(period, &t->last);
+	u_hist_ns_snapshot_merge(&t->last, period);
+
+	u_hist_ns_snapshot_get_stats(period, &stats);
+	t->p50_ms = (float)time_ns_to_ms_f((time_duration_ns)stats.p50);
+	t->p99_ms = (float)time_ns_to_ms_f((time_duration_ns)stats.p99);
+	t->worst_ms = (float)time_ns_to_ms_f((time_duration_ns)stats.worst);
+
+	free(period);
+}
+
+static void
+timing_fini(struct u_sink_queue_timing *t)
+{
+	u_hist_ns_destroy(&t->hist);
+}
+
+//! Only called from the queue thread.
+static void
+stats_add(struct u_sink_queue *q, int64_t enqueued_ns, int64_t start_ns, int64_t end_ns)
+{
+	u_hist_ns_add(q->stats.latency.hist, (uint64_t)(start_ns - enqueued_ns));
+	u_hist_ns_add(q->stats.busy.hist, (uint64_t)(end_ns - start_ns));
+	q->stats.period_busy_ns += (uint64_t)(end_ns - start_ns);
+
+	int64_t period_ns = end_ns - q->stats.period_start_ns;
+	if (period_ns < STATS_PERIOD_NS) {
+		return;
+	}
+
+	timing_update(&q->stats.latency);
+	timing_update(&q->stats.busy);
+	q->stats.busy_percent = (float)(100.0 * (double)q->stats.period_busy_ns / (double)period_ns);
+
+	q->stats.period_start_ns = end_ns;
+	q->stats.period_busy_ns = 0;
+}
+
+/*
+ *
+ * Shared pool.
+ *
+ */
+
+static pthread_mutex_t shared_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct u_worker_thread_pool *shared_pool = NULL;
+static uint32_t shared_user_count = 0;
+
+//! Creates the pool for the first user, it is kept while there are any users.
+static struct u_worker_group *
+shared_pool_get_group(void)
+{
+	pthread_mutex_lock(&shared_mutex);
+
+	if (shared_pool == NULL) {
+		uint32_t count = (uint32_t)debug_get_num_option_shared_pool_threads();
+		count = count < 1 ? 1 : count;
+		shared_pool = u_worker_thread_pool_create_with_role(count, count, "Sink Queue", U_THREAD_ROLE_TRACKING);
+	}
+
+	struct u_worker_group *group = NULL;
+	if (shared_pool != NULL) {
+		group = u_worker_group_create(shared_pool);
+		shared_user_count++;
+	}
+
+	pthread_mutex_unlock(&shared_mutex);
+
+	return group;
+}
+
+static void
+shared_pool_put_group(struct u_worker_group **group_ptr)
+{
+	// Waits for any task of the group.
+	u_worker_group_reference(group_ptr, NULL);
+
+	pthread_mutex_lock(&shared_mutex);
+
+	assert(shared_user_count > 0);
+	if (--shared_user_count == 0) {
+		u_worker_thread_pool_reference(&shared_pool, NULL);
+	}
+
+	pthread_mutex_unlock(&shared_mutex);
+}
+
+
+/*
+ *
+ * Consuming functions.
+ *
+ */
+
+/*!
+ * Gives the oldest frame to the consumer, call with q->mutex locked and the
+ * queue not empty, unlocks it while the consumer runs.
+ */
+static void
+queue_consume_one(struct u_sink_queue *q)
+{
+	SINK_TRACE_IDENT(queue_frame);
+
+	int64_t enqueued_ns = 0;
+
+	/*
+	 * Dequeue frame.
+	 * We need to take a reference on the current frame, this is to
+	 * keep it alive during the call to the consumer should it be
+	 * replaced. But we no longer need to hold onto the frame on the
+	 * queue so we dequeue it.
+	 */
+	struct xrt_frame *frame = queue_pop_with_time(q, &enqueued_ns);
+
+	/*
+	 * Unlock the mutex when we do the work, so a new frame can be
+	 * queued.
+	 */
+	pthread_mutex_unlock(&q->mutex);
+
+	// Send to the consumer that does the work.
+	int64_t start_ns = os_monotonic_get_ns();
+	q->consumer->push_frame(q->consumer, frame);
+	int64_t end_ns = os_monotonic_get_ns();
+
+	stats_add(q, enqueued_ns, start_ns, end_ns);
+
+	/*
+	 * Drop our reference we don't need it anymore, or it's held by
+	 * the consumer.
+	 */
+	xrt_frame_reference(&frame, NULL);
+
+	// Have to lock it again.
+	pthread_mutex_lock(&q->mutex);
+}
+
+/*!
+ * Task on the shared pool, does one frame at a time so that busy queues don't
+ * starve the others. When pushed again from the worker it goes on the local
+ * deque of that worker, which keeps the frames of a queue on the same core.
+ */
+static void
+queue_task(void *ptr)
+{
+	struct u_sink_queue *q = (struct u_sink_queue *)ptr;
+
+	pthread_mutex_lock(&q->mutex);
+
+	if (q->running && !queue_is_empty(q)) {
+		queue_consume_one(q);
+	}
+
+	bool again = q->running && !queue_is_empty(q);
+	q->task_scheduled = again;
+
+	// Break apart waits for the last task.
+	if (!again) {
+		pthread_cond_signal(&q->cond);
+	}
+
+	pthread_mutex_unlock(&q->mutex);
+
+	if (again) {
+		u_worker_group_push(q->group, queue_task, q);
+	}
+}
+
 static void *
 queue_mainloop(void *ptr)
 {
 	U_TRACE_SET_THREAD_NAME("Sink Queue");
 
 	struct u_sink_queue *q = (struct u_sink_queue *)ptr;
-	struct xrt_frame *frame = NULL;
 
 	pthread_mutex_lock(&q->mutex);
 
@@ -152,34 +424,7 @@ queue_mainloop(void *ptr)
 			continue;
 		}
 
-		SINK_TRACE_IDENT(queue_frame);
-
-		/*
-		 * Dequeue frame.
-		 * We need to take a reference on the current frame, this is to
-		 * keep it alive during the call to the consumer should it be
-		 * replaced. But we no longer need to hold onto the frame on the
-		 * queue so we dequeue it.
-		 */
-		frame = queue_pop(q);
-
-		/*
-		 * Unlock the mutex when we do the work, so a new frame can be
-		 * queued.
-		 */
-		pthread_mutex_unlock(&q->mutex);
-
-		// Send to the consumer that does the work.
-		q->consumer->push_frame(q->consumer, frame);
-
-		/*
-		 * Drop our reference we don't need it anymore, or it's held by
-		 * the consumer.
-		 */
-		xrt_frame_reference(&frame, NULL);
-
-		// Have to lock it again.
-		pthread_mutex_lock(&q->mutex);
+		queue_consume_one(q);
 	}
 
 	pthread_mutex_unlock(&q->mutex);
@@ -194,6 +439,8 @@ queue_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 
 	struct u_sink_queue *q = (struct u_sink_queue *)xfs;
 
+	bool push_task = false;
+
 	pthread_mutex_lock(&q->mutex);
 
 	// Only schedule new frames if we are running.
@@ -201,10 +448,20 @@ queue_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 		queue_try_refpush(q, xf);
 	}
 
-	// Wake up the thread.
-	pthread_cond_signal(&q->cond);
+	if (q->group == NULL) {
+		// Wake up the thread.
+		pthread_cond_signal(&q->cond);
+	} else if (q->running && !q->task_scheduled && !queue_is_empty(q)) {
+		q->task_scheduled = true;
+		push_task = true;
+	}
 
 	pthread_mutex_unlock(&q->mutex);
+
+	// Not holding the lock, the pool might run the task right here.
+	if (push_task) {
+		u_worker_group_push(q->group, queue_task, q);
+	}
 }
 
 static void
@@ -225,11 +482,24 @@ queue_break_apart(struct xrt_frame_node *node)
 	// Wake up the thread.
 	pthread_cond_signal(&q->cond);
 
+	/*
+	 * A scheduled task will run, see that we are stopped and not push
+	 * itself again. Waiting for it also makes sure any queue_frame call
+	 * is done pushing it to the group.
+	 */
+	while (q->task_scheduled) {
+		pthread_cond_wait(&q->cond, &q->mutex);
+	}
+
 	// No longer need to protect fields.
 	pthread_mutex_unlock(&q->mutex);
 
-	// Wait for thread to finish.
-	pthread_join(q->thread, &retval);
+	// Wait for the thread or the tail of the last task to finish.
+	if (q->group != NULL) {
+		shared_pool_put_group(&q->group);
+	} else {
+		pthread_join(q->thread, &retval);
+	}
 }
 
 static void
@@ -237,12 +507,36 @@ queue_destroy(struct xrt_frame_node *node)
 {
 	struct u_sink_queue *q = container_of(node, struct u_sink_queue, node);
 
+	// Remove the variable tracking.
+	u_var_remove_root(q);
+
 	// Destroy resources.
+	timing_fini(&q->stats.latency);
+	timing_fini(&q->stats.busy);
 	pthread_mutex_destroy(&q->mutex);
 	pthread_cond_destroy(&q->cond);
 	free(q);
 }
 
+static void
+queue_add_vars(struct u_sink_queue *q, const char *name)
+{
+	u_var_add_root(q, name, true);
+	u_var_add_ro_u64(q, &q->max_size, "Max size");
+	u_var_add_ro_u64(q, &q->size, "Queued");
+	u_var_add_ro_u64(q, &q->stats.pushed, "Pushed");
+	u_var_add_ro_u64(q, &q->stats.dropped, "Dropped");
+	u_var_add_gui_header(q, NULL, "Latency (queued to consumer)");
+	u_var_add_ro_f32(q, &q->stats.latency.p50_ms, "p50 (ms)");
+	u_var_add_ro_f32(q, &q->stats.latency.p99_ms, "p99 (ms)");
+	u_var_add_ro_f32(q, &q->stats.latency.worst_ms, "Worst (ms)");
+	u_var_add_gui_header(q, NULL, "Consumer");
+	u_var_add_ro_f32(q, &q->stats.busy.p50_ms, "p50 (ms)");
+	u_var_add_ro_f32(q, &q->stats.busy.p99_ms, "p99 (ms)");
+	u_var_add_ro_f32(q, &q->stats.busy.worst_ms, "Worst (ms)");
+	u_var_add_ro_f32(q, &q->stats.busy_percent, "Busy (%)");
+}
+
 
 /*
  *
@@ -251,10 +545,10 @@ queue_destroy(struct xrt_frame_node *node)
  */
 
 bool
-u_sink_queue_create(struct xrt_frame_context *xfctx,
-                    uint64_t max_size,
-                    struct xrt_frame_sink *downstream,
-                    struct xrt_frame_sink **out_xfs)
+u_sink_queue_create_with_params(struct xrt_frame_context *xfctx,
+                                const struct u_sink_queue_params *params,
+                                struct xrt_frame_sink *downstream,
+                                struct xrt_frame_sink **out_xfs)
 {
 	struct u_sink_queue *q = U_TYPED_CALLOC(struct u_sink_queue);
 	int ret = 0;
@@ -266,7 +560,8 @@ u_sink_queue_create(struct xrt_frame_context *xfctx,
 	q->running = true;
 
 	q->size = 0;
-	q->max_size = max_size;
+	q->max_size = params->max_size;
+	q->drop_policy = params->drop_policy;
 
 	ret = pthread_mutex_init(&q->mutex, NULL);
 	if (ret != 0) {
@@ -281,17 +576,75 @@ u_sink_queue_create(struct xrt_frame_context *xfctx,
 		return false;
 	}
 
-	ret = pthread_create(&q->thread, NULL, queue_mainloop, q);
+	timing_init(&q->stats.latency);
+	timing_init(&q->stats.busy);
+	q->stats.period_start_ns = os_monotonic_get_ns();
+
+	// Falls back to a thread if the pool could not be created.
+	if (params->use_shared_pool) {
+		q->group = shared_pool_get_group();
+	}
+
+	ret = q->group != NULL ? 0 : pthread_create(&q->thread, NULL, queue_mainloop, q);
 	if (ret != 0) {
+		timing_fini(&q->stats.latency);
+		timing_fini(&q->stats.busy);
 		pthread_cond_destroy(&q->cond);
 		pthread_mutex_destroy(&q->mutex);
 		free(q);
 		return false;
 	}
 
+	queue_add_vars(q, params->name != NULL ? params->name : "Sink Queue");
+
 	xrt_frame_context_add(xfctx, &q->node);
 
 	*out_xfs = &q->base;
 
 	return true;
 }
+
+void
+u_sink_queue_get_counts(struct xrt_frame_sink *xfs, uint64_t *out_pushed, uint64_t *out_dropped)
+{
+	assert(xfs->push_frame == queue_frame);
+
+	struct u_sink_queue *q = (struct u_sink_queue *)xfs;
+
+	pthread_mutex_lock(&q->mutex);
+	*out_pushed = q->stats.pushed;
+	*out_dropped = q->stats.dropped;
+	pthread_mutex_unlock(&q->mutex);
+}
+
+bool
+u_sink_queue_create(struct xrt_frame_context *xfctx,
+                    uint64_t max_size,
+                    struct xrt_frame_sink *downstream,
+                    struct xrt_frame_sink **out_xfs)
+{
+	struct u_sink_queue_params params = {
+	    .max_size = max_size,
+	    .drop_policy = U_SINK_QUEUE_DROP_NEWEST,
+	    .name = "Sink Queue",
+	    .use_shared_pool = debug_get_bool_option_shared_pool(),
+	};
+
+	return u_sink_queue_create_with_params(xfctx, &params, downstream, out_xfs);
+}
+
+bool
+u_sink_simple_queue_create(struct xrt_frame_context *xfctx,
+                           struct xrt_frame_sink *downstream,
+                           struct xrt_frame_sink **out_xfs)
+{
+	// Only keep the latest frame.
+	struct u_sink_queue_params params = {
+	    .max_size = 1,
+	    .drop_policy = U_SINK_QUEUE_DROP_OLDEST,
+	    .name = "Simple Sink Queue",
+	    .use_shared_pool = debug_get_bool_option_shared_pool(),
+	};
+
+	return u_sink_queue_create_with_params(xfctx, &params, downstream, out_xfs);
+}
@@ -0,0 +1,185 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Fans one set of @ref xrt_slam_sinks out to several.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "util/u_misc.h"
+#include "util/u_sink.h"
+#include "util/u_trace_marker.h"
+
+#include <assert.h>
+
+
+/*!
+ * Fans one set of SLAM sinks out to several, frames are reference counted so
+ * every downstream gets the very same frame.
+ *
+ * @implements xrt_frame_node
+ */
+struct u_sink_slam_fanout
+{
+	struct xrt_slam_sinks base;
+	struct xrt_frame_node node;
+
+	struct xrt_frame_sink cams[XRT_TRACKING_MAX_SLAM_CAMS];
+	struct xrt_imu_sink imu;
+	struct xrt_pose_sink gt;
+	struct xrt_hand_masks_sink hand_masks;
+
+	struct xrt_slam_sinks *downstreams[U_SINK_SLAM_FANOUT_MAX];
+	uint32_t downstream_count;
+};
+
+static void
+fanout_imu(struct xrt_imu_sink *sink, struct xrt_imu_sample *sample)
+{
+	SINK_TRACE_MARKER();
+
+	struct u_sink_slam_fanout *f = container_of(sink, struct u_sink_slam_fanout, imu);
+
+	for (uint32_t i = 0; i < f->downstream_count; i++) {
+		if (f->downstreams[i]->imu != NULL) {
+			xrt_sink_push_imu(f->downstreams[i]->imu, sample);
+		}
+	}
+}
+
+static void
+fanout_imu_batch(struct xrt_imu_sink *sink, struct xrt_imu_sample *samples, uint32_t count)
+{
+	SINK_TRACE_MARKER();
+
+	struct u_sink_slam_fanout *f = container_of(sink, struct u_sink_slam_fanout, imu);
+
+	for (uint32_t i = 0; i < f->downstream_count; i++) {
+		if (f->downstreams[i]->imu != NULL) {
+			xrt_sink_push_imu_batch(f->downstreams[i]->imu, samples, count);
+		}
+	}
+}
+
+static void
+fanout_gt(struct xrt_pose_sink *sink, struct xrt_pose_sample *sample)
+{
+	SINK_TRACE_MARKER();
+
+	struct u_sink_slam_fanout *f = container_of(sink, struct u_sink_slam_fanout, gt);
+
+	for (uint32_t i = 0; i < f->downstream_count; i++) {
+		if (f->downstreams[i]->gt != NULL) {
+			xrt_sink_push_pose(f->downstreams[i]->gt, sample);
+		}
+	}
+}
+
+static void
+fanout_hand_masks(struct xrt_hand_masks_sink *sink, struct xrt_hand_masks_sample *hand_masks)
+{
+	SINK_TRACE_MARKER();
+
+	struct u_sink_slam_fanout *f = container_of(sink, struct u_sink_slam_fanout, hand_masks);
+
+	for (uint32_t i = 0; i < f->downstream_count; i++) {
+		if (f->downstreams[i]->hand_masks != NULL) {
+			xrt_sink_push_hand_masks(f->downstreams[i]->hand_masks, hand_masks);
+		}
+	}
+}
+
+static inline void
+fanout_cam(struct u_sink_slam_fanout *f, int cam_index, struct xrt_frame *xf)
+{
+	SINK_TRACE_MARKER();
+
+	for (uint32_t i = 0; i < f->downstream_count; i++) {
+		struct xrt_slam_sinks *d = f->downstreams[i];
+		if (cam_index < d->cam_count && d->cams[cam_index] != NULL) {
+			xrt_sink_push_frame(d->cams[cam_index], xf);
+		}
+	}
+}
+
+#define DEFINE_FANOUT_CAM(cam_id)                                                                                      \
+	static void fanout_cam##cam_id(struct xrt_frame_sink *sink, struct xrt_frame *xf)                              \
+	{                                                                                                              \
+		struct u_sink_slam_fanout *f = container_of(sink, struct u_sink_slam_fanout, cams[cam_id]);            \
+		fanout_cam(f, cam_id, xf);                                                                             \
+	}
+
+DEFINE_FANOUT_CAM(0)
+DEFINE_FANOUT_CAM(1)
+DEFINE_FANOUT_CAM(2)
+DEFINE_FANOUT_CAM(3)
+DEFINE_FANOUT_CAM(4)
+
+//! Pushes of each camera, extend with @ref DEFINE_FANOUT_CAM if more cameras are supported.
+static void (*fanout_cams[XRT_TRACKING_MAX_SLAM_CAMS])(struct xrt_frame_sink *, struct xrt_frame *) = {
+    fanout_cam0, fanout_cam1, fanout_cam2, fanout_cam3, fanout_cam4,
+};
+
+static void
+fanout_break_apart(struct xrt_frame_node *node)
+{
+	// Noop
+}
+
+static void
+fanout_destroy(struct xrt_frame_node *node)
+{
+	struct u_sink_slam_fanout *f = container_of(node, struct u_sink_slam_fanout, node);
+
+	free(f);
+}
+
+
+/*
+ *
+ * Exported functions.
+ *
+ */
+
+void
+u_sink_slam_fanout_create(struct xrt_frame_context *xfctx,
+                          struct xrt_slam_sinks **downstreams,
+                          uint32_t downstream_count,
+                          struct xrt_slam_sinks **out_sinks)
+{
+	assert(downstream_count <= U_SINK_SLAM_FANOUT_MAX);
+	assert(fanout_cams[ARRAY_SIZE(fanout_cams) - 1] != NULL);
+
+	struct u_sink_slam_fanout *f = U_TYPED_CALLOC(struct u_sink_slam_fanout);
+
+	int cam_count = 0;
+	for (uint32_t i = 0; i < downstream_count; i++) {
+		f->downstreams[i] = downstreams[i];
+		if (downstreams[i]->cam_count > cam_count) {
+			cam_count = downstreams[i]->cam_count;
+		}
+	}
+	f->downstream_count = downstream_count;
+
+	f->base.cam_count = cam_count;
+	for (int i = 0; i < XRT_TRACKING_MAX_SLAM_CAMS; i++) {
+		f->cams[i].push_frame = fanout_cams[i];
+		f->base.cams[i] = &f->cams[i];
+	}
+
+	f->imu.push_imu = fanout_imu;
+	f->imu.push_imu_batch = fanout_imu_batch;
+	f->base.imu = &f->imu;
+	f->gt.push_pose = fanout_gt;
+	f->base.gt = &f->gt;
+	f->hand_masks.push_hand_masks = fanout_hand_masks;
+	f->base.hand_masks = &f->hand_masks;
+
+	f->node.break_apart = fanout_break_apart;
+	f->node.destroy = fanout_destroy;
+
+	xrt_frame_context_add(xfctx, &f->node);
+
+	*out_sinks = &f->base;
+}
@@ -0,0 +1,268 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Vector and deque with inline storage, optionally growing into an arena.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include "util/u_arena.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Allocate memory for a small container, from the arena if given.
+ *
+ * @ingroup aux_util
+ */
+static inline void *
+u_small_alloc(struct u_arena *arena, size_t size)
+{
+	return arena != NULL ? u_arena_alloc(arena, size) : malloc(size);
+}
+
+/*!
+ * Grow the storage of a small container, @p heap is NULL while the elements
+ * are still in @p storage. Arena memory is never freed, heap memory is
+ * reallocated.
+ *
+ * @ingroup aux_util
+ */
+static inline void *
+u_small_grow(struct u_arena *arena, void *heap, void *storage, size_t used, size_t size)
+{
+	if (arena == NULL && heap != NULL) {
+		return realloc(heap, size);
+	}
+
+	void *ptr = u_small_alloc(arena, size);
+	if (ptr != NULL) {
+		memcpy(ptr, heap != NULL ? heap : storage, used);
+	}
+	return ptr;
+}
+
+/*!
+ * Declares a vector of @p TYPE called `struct u_small_vector_NAME`, the first
+ * @p N elements are stored inline so no memory is allocated until it grows
+ * past that. When it grows it either uses the heap or, if given one at init,
+ * the arena. Clear keeps the memory, only @p fini frees it. The container must
+ * be initialised again after the arena it uses has been reset.
+ *
+ * Functions are `u_small_vector_NAME_init`, `_data`, `_reserve`, `_push_back`,
+ * `_push_back_n`, `_at`, `_size`, `_clear` and `_fini`.
+ *
+ * @ingroup aux_util
+ */
+#define U_SMALL_VECTOR_DECLARATION(NAME, TYPE, N)                                                                      \
+	struct u_small_vector_##NAME                                                                                   \
+	{                                                                                                              \
+		TYPE *heap;                                                                                            \
+		struct u_arena *arena;                                                                                 \
+		size_t size;                                                                                           \
+		size_t capacity;                                                                                       \
+		TYPE storage[N];                                                                                       \
+	};                                                                                                             \
+                                                                                                                       \
+	static inline void u_small_vector_##NAME##_init(struct u_small_vector_##NAME *v, struct u_arena *arena)        \
+	{                                                                                                              \
+		v->heap = NULL;                                                                                        \
+		v->arena = arena;                                                                                      \
+		v->size = 0;                                                                                           \
+		v->capacity = (N);                                                                                     \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline TYPE *u_small_vector_##NAME##_data(struct u_small_vector_##NAME *v)                              \
+	{                                                                                                              \
+		return v->heap != NULL ? v->heap : v->storage;                                                         \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline bool u_small_vector_##NAME##_reserve(struct u_small_vector_##NAME *v, size_t count)              \
+	{                                                                                                              \
+		if (count <= v->capacity) {                                                                            \
+			return true;                                                                                   \
+		}                                                                                                      \
+		size_t capacity = v->capacity * 2 > count ? v->capacity * 2 : count;                                   \
+		TYPE *ptr = (TYPE *)u_small_grow(v->arena, v->heap, v->storage, sizeof(TYPE) * v->size,                \
+		                                 sizeof(TYPE) * capacity);                                             \
+		if (ptr == NULL) {                                                                                     \
+			return false;                                                                                  \
+		}                                                                                                      \
+		v->heap = ptr;                                                                                         \
+		v->capacity = capacity;                                                                                \
+		return true;                                                                                           \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline bool u_small_vector_##NAME##_push_back_n(struct u_small_vector_##NAME *v, const TYPE *e,         \
+	                                                         size_t count)                                         \
+	{                                                                                                              \
+		if (!u_small_vector_##NAME##_reserve(v, v->size + count)) {                                            \
+			return false;                                                                                  \
+		}                                                                                                      \
+		memcpy(u_small_vector_##NAME##_data(v) + v->size, e, sizeof(TYPE) * count);                            \
+		v->size += count;                                                                                      \
+		return true;                                                                                           \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline bool u_small_vector_##NAME##_push_back(struct u_small_vector_##NAME *v, TYPE e)                  \
+	{                                                                                                              \
+		return u_small_vector_##NAME##_push_back_n(v, &e, 1);                                                  \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline TYPE u_small_vector_##NAME##_at(struct u_small_vector_##NAME *v, size_t i)                       \
+	{                                                                                                              \
+		assert(i < v->size);                                                                                   \
+		return u_small_vector_##NAME##_data(v)[i];                                                             \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline size_t u_small_vector_##NAME##_size(const struct u_small_vector_##NAME *v)                       \
+	{                                                                                                              \
+		return v->size;                                                                                        \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline void u_small_vector_##NAME##_clear(struct u_small_vector_##NAME *v)                              \
+	{                                                                                                              \
+		v->size = 0;                                                                                           \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline void u_small_vector_##NAME##_fini(struct u_small_vector_##NAME *v)                               \
+	{                                                                                                              \
+		if (v->arena == NULL) {                                                                                \
+			free(v->heap);                                                                                 \
+		}                                                                                                      \
+		u_small_vector_##NAME##_init(v, v->arena);                                                             \
+	}
+
+/*!
+ * Declares a ring buffer deque of @p TYPE called `struct u_small_deque_NAME`,
+ * see @ref U_SMALL_VECTOR_DECLARATION for how storage works.
+ *
+ * Functions are `u_small_deque_NAME_init`, `_push_back`, `_push_back_n`,
+ * `_pop_front`, `_at`, `_size`, `_clear` and `_fini`.
+ *
+ * @ingroup aux_util
+ */
+#define U_SMALL_DEQUE_DECLARATION(NAME, TYPE, N)                                                                       \
+	struct u_small_deque_##NAME                                                                                    \
+	{                                                                                                              \
+		TYPE *heap;                                                                                            \
+		struct u_arena *arena;                                                                                 \
+		size_t head;                                                                                           \
+		size_t size;                                                                                           \
+		size_t capacity;                                                                                       \
+		TYPE storage[N];                                                                                       \
+	};                                                                                                             \
+                                                                                                                       \
+	static inline void u_small_deque_##NAME##_init(struct u_small_deque_##NAME *d, struct u_arena *arena)          \
+	{                                                                                                              \
+		d->heap = NULL;                                                                                        \
+		d->arena = arena;                                                                                      \
+		d->head = 0;                                                                                           \
+		d->size = 0;                                                                                           \
+		d->capacity = (N);                                                                                     \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline TYPE *u_small_deque_##NAME##_data(struct u_small_deque_##NAME *d)                                \
+	{                                                                                                              \
+		return d->heap != NULL ? d->heap : d->storage;                                                         \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline size_t u_small_deque_##NAME##_index(const struct u_small_deque_##NAME *d, size_t i)              \
+	{                                                                                                              \
+		size_t index = d->head + i;                                                                            \
+		return index >= d->capacity ? index - d->capacity : index;                                             \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline bool u_small_deque_##NAME##_grow(struct u_small_deque_##NAME *d, size_t count)                   \
+	{                                                                                                              \
+		size_t capacity = d->capacity * 2 > count ? d->capacity * 2 : count;                                   \
+		TYPE *old = u_small_deque_##NAME##_data(d);                                                            \
+		TYPE *ptr = (TYPE *)u_small_alloc(d->arena, sizeof(TYPE) * capacity);                                  \
+		if (ptr == NULL) {                                                                                     \
+			return false;                                                                                  \
+		}                                                                                                      \
+		/* Unwrap the elements into the new buffer. */                                                         \
+		size_t first = d->capacity - d->head < d->size ? d->capacity - d->head : d->size;                      \
+		memcpy(ptr, old + d->head, sizeof(TYPE) * first);                                                      \
+		memcpy(ptr + first, old, sizeof(TYPE) * (d->size - first));                                            \
+		if (d->arena == NULL) {                                                                                \
+			free(d->heap);                                                                                 \
+		}                                                                                                      \
+		d->heap = ptr;                                                                                         \
+		d->head = 0;                                                                                           \
+		d->capacity = capacity;                                                                                \
+		return true;                                                                                           \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline bool u_small_deque_##NAME##_push_back_n(struct u_small_deque_##NAME *d, const TYPE *e,           \
+	                                                        size_t count)                                          \
+	{                                                                                                              \
+		if (d->size + count > d->capacity && !u_small_deque_##NAME##_grow(d, d->size + count)) {               \
+			return false;                                                                                  \
+		}                                                                                                      \
+		TYPE *data = u_small_deque_##NAME##_data(d);                                                           \
+		for (size_t i = 0; i < count; i++) {                                                                   \
+			data[u_small_deque_##NAME##_index(d, d->size + i)] = e[i];                                     \
+		}                                                                                                      \
+		d->size += count;                                                                                      \
+		return true;                                                                                           \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline bool u_small_deque_##NAME##_push_back(struct u_small_deque_##NAME *d, TYPE e)                    \
+	{                                                                                                              \
+		return u_small_deque_##NAME##_push_back_n(d, &e, 1);                                                   \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline bool u_small_deque_##NAME##_pop_front(struct u_small_deque_##NAME *d, TYPE *e)                   \
+	{                                                                                                              \
+		if (d->size == 0) {                                                                                    \
+			return false;                                                                                  \
+		}                                                                                                      \
+		*e = u_small_deque_##NAME##_data(d)[d->head];                                                          \
+		d->head = u_small_deque_##NAME##_index(d, 1);                                                          \
+		d->size--;                                                                                             \
+		return true;                                                                                           \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline TYPE u_small_deque_##NAME##_at(struct u_small_deque_##NAME *d, size_t i)                         \
+	{                                                                                                              \
+		assert(i < d->size);                                                                                   \
+		return u_small_deque_##NAME##_data(d)[u_small_deque_##NAME##_index(d, i)];                             \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline size_t u_small_deque_##NAME##_size(const struct u_small_deque_##NAME *d)                         \
+	{                                                                                                              \
+		return d->size;                                                                                        \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline void u_small_deque_##NAME##_clear(struct u_small_deque_##NAME *d)                                \
+	{                                                                                                              \
+		d->head = 0;                                                                                           \
+		d->size = 0;                                                                                           \
+	}                                                                                                              \
+                                                                                                                       \
+	static inline void u_small_deque_##NAME##_fini(struct u_small_deque_##NAME *d)                                 \
+	{                                                                                                              \
+		if (d->arena == NULL) {                                                                                \
+			free(d->heap);                                                                                 \
+		}                                                                                                      \
+		u_small_deque_##NAME##_init(d, d->arena);                                                              \
+	}
+
+
+#ifdef __cplusplus
+}
+#endif
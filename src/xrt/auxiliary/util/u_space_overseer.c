@@ -15,12 +15,17 @@
 
 #include "os/os_time.h"
 
+#include "math/m_api.h"
 #include "math/m_space.h"
+#include "math/m_predict.h"
 
 #include "util/u_misc.h"
+#include "util/u_time.h"
+#include "util/u_debug.h"
 #include "util/u_hashmap.h"
 #include "util/u_logging.h"
 #include "util/u_space_overseer.h"
+#include "util/u_limited_unique_id.h"
 
 #include <assert.h>
 #include <pthread.h>
@@ -32,6 +37,21 @@
  *
  */
 
+//! Number of base and target space pairs that have their chain cached.
+#define U_SPACE_CHAIN_CACHE_SIZE (16)
+
+//! Number of device poses kept in the tracking snapshot.
+#define U_SPACE_SNAPSHOT_SIZE (32)
+
+//! Snapshot entries sampled longer ago than this are not used, newer tracking data might be available.
+#define U_SPACE_SNAPSHOT_MAX_AGE_NS (4 * U_TIME_1MS_IN_NS)
+
+/*!
+ * How far apart in time a locate can be from a snapshot entry and still be
+ * served from it, zero turns the snapshot off.
+ */
+DEBUG_GET_ONCE_NUM_OPTION(snapshot_tolerance_us, "U_SPACE_OVERSEER_SNAPSHOT_TOLERANCE_US", 1000)
+
 /*!
  * Keeps track of what kind of space it is.
  */
@@ -61,6 +81,12 @@ struct u_space
 	 */
 	enum u_space_type type;
 
+	/*!
+	 * Used as key in the chain cache, unlike the pointer it is never reused
+	 * for a new space after this one has been destroyed.
+	 */
+	xrt_limited_unique_id_t id;
+
 	union {
 		struct
 		{
@@ -75,6 +101,68 @@ struct u_space
 	};
 };
 
+/*!
+ * What a single step of a cached chain does.
+ */
+enum u_space_chain_step_type
+{
+	U_SPACE_CHAIN_STEP_POSE,
+	U_SPACE_CHAIN_STEP_DEVICE,
+	U_SPACE_CHAIN_STEP_DEVICE_INVERTED,
+};
+
+/*!
+ * A single step of a cached chain, either a static pose made from one or more
+ * offsets multiplied together or a device pose that is fetched at locate time.
+ */
+struct u_space_chain_step
+{
+	enum u_space_chain_step_type type;
+
+	union {
+		struct xrt_pose pose;
+
+		struct
+		{
+			struct xrt_device *xdev;
+			enum xrt_input_name xname;
+		} device;
+	};
+};
+
+/*!
+ * The static part of the relation chain between a base and target space.
+ */
+struct u_space_chain
+{
+	//! Graph version this chain was built from.
+	uint64_t version;
+
+	xrt_limited_unique_id_t base_id;
+	xrt_limited_unique_id_t target_id;
+
+	uint32_t step_count;
+	struct u_space_chain_step steps[XRT_RELATION_CHAIN_CAPACITY];
+};
+
+/*!
+ * A device pose sampled at a given time, shared by all locates close to that
+ * time, which usually comes from several clients locating for the same frame.
+ */
+struct u_space_snapshot_entry
+{
+	struct xrt_device *xdev;
+	enum xrt_input_name xname;
+
+	//! Time the relation is for.
+	uint64_t at_timestamp_ns;
+
+	//! Monotonic time when the relation was sampled.
+	uint64_t sampled_ns;
+
+	struct xrt_space_relation relation;
+};
+
 /*!
  * Default implementation of the xrt_space_overseer object.
  */
@@ -109,6 +197,37 @@ struct u_space_overseer
 	 * spaces and that they share the same parent.
 	 */
 	bool can_do_local_spaces_recenter;
+
+	struct
+	{
+		//! Protects the entries and version, may be taken with the main lock held.
+		pthread_mutex_t mutex;
+
+		/*!
+		 * Bumped with the main lock held for writing when the graph is
+		 * changed in a way that changes existing chains.
+		 */
+		uint64_t version;
+
+		//! Next entry to be replaced.
+		uint32_t next;
+
+		struct u_space_chain entries[U_SPACE_CHAIN_CACHE_SIZE];
+	} chain_cache;
+
+	struct
+	{
+		//! Protects the entries, only held while copying.
+		pthread_mutex_t mutex;
+
+		//! Zero if turned off, read once at creation.
+		uint64_t tolerance_ns;
+
+		//! Next entry to be replaced.
+		uint32_t next;
+
+		struct u_space_snapshot_entry entries[U_SPACE_SNAPSHOT_SIZE];
+	} snapshot;
 };
 
 
@@ -209,14 +328,28 @@ find_xdev_space_read_locked(struct u_space_overseer *uso, struct xrt_device *xde
 	return (struct u_space *)ptr;
 }
 
+/*!
+ * Makes all cached chains stale, must be called with the main lock held for
+ * writing so no chain is being built from the old graph.
+ */
+static void
+invalidate_chain_cache_write_locked(struct u_space_overseer *uso)
+{
+	pthread_mutex_lock(&uso->chain_cache.mutex);
+	uso->chain_cache.version++;
+	pthread_mutex_unlock(&uso->chain_cache.mutex);
+}
+
 /*!
  * Updates the offset of a NULL or OFFSET space.
  */
 static void
-update_offset_write_locked(struct u_space *us, const struct xrt_pose *new_offset)
+update_offset_write_locked(struct u_space_overseer *uso, struct u_space *us, const struct xrt_pose *new_offset)
 {
 	assert(us->type == U_SPACE_TYPE_NULL || us->type == U_SPACE_TYPE_OFFSET);
 
+	invalidate_chain_cache_write_locked(uso);
+
 	if (m_pose_is_identity(new_offset)) { // Small optimisation.
 		us->type = U_SPACE_TYPE_NULL;
 		U_ZERO(&us->offset.pose);
@@ -359,18 +492,6 @@ build_relation_chain_read_locked(struct u_space_overseer *uso,
 	traverse_then_push_inverse(xrc, base, at_timestamp_ns);
 }
 
-static void
-build_relation_chain(struct u_space_overseer *uso,
-                     struct xrt_relation_chain *xrc,
-                     struct u_space *base,
-                     struct u_space *target,
-                     uint64_t at_timestamp_ns)
-{
-	pthread_rwlock_rdlock(&uso->lock);
-	build_relation_chain_read_locked(uso, xrc, base, target, at_timestamp_ns);
-	pthread_rwlock_unlock(&uso->lock);
-}
-
 static inline void
 special_resolve(struct xrt_relation_chain *xrc, struct xrt_space_relation *out_relation)
 {
@@ -392,6 +513,247 @@ special_resolve(struct xrt_relation_chain *xrc, struct xrt_space_relation *out_r
 }
 
 
+/*
+ *
+ * Chain cache functions.
+ *
+ */
+
+/*!
+ * Pushes a static pose, multiplying it together with the previous step if that
+ * is also static so that fewer steps needs to be resolved at locate time.
+ */
+static void
+chain_push_pose(struct u_space_chain *chain, const struct xrt_pose *pose)
+{
+	if (m_pose_is_identity(pose)) {
+		return;
+	}
+
+	if (chain->step_count > 0 && chain->steps[chain->step_count - 1].type == U_SPACE_CHAIN_STEP_POSE) {
+		struct xrt_pose *prev = &chain->steps[chain->step_count - 1].pose;
+		math_pose_transform(pose, prev, prev);
+		return;
+	}
+
+	if (chain->step_count >= ARRAY_SIZE(chain->steps)) {
+		return;
+	}
+
+	struct u_space_chain_step *step = &chain->steps[chain->step_count++];
+	step->type = U_SPACE_CHAIN_STEP_POSE;
+	step->pose = *pose;
+}
+
+static void
+chain_push_inverted_pose(struct u_space_chain *chain, const struct xrt_pose *pose)
+{
+	struct xrt_pose inverted;
+	math_pose_invert(pose, &inverted);
+	chain_push_pose(chain, &inverted);
+}
+
+static void
+chain_push_device(struct u_space_chain *chain, bool inverted, const struct u_space *space)
+{
+	assert(space->pose.xdev != NULL);
+	assert(space->pose.xname != 0);
+
+	if (chain->step_count >= ARRAY_SIZE(chain->steps)) {
+		return;
+	}
+
+	struct u_space_chain_step *step = &chain->steps[chain->step_count++];
+	step->type = inverted ? U_SPACE_CHAIN_STEP_DEVICE_INVERTED : U_SPACE_CHAIN_STEP_DEVICE;
+	step->device.xdev = space->pose.xdev;
+	step->device.xname = space->pose.xname;
+}
+
+//! Same as @ref push_then_traverse but only records the steps.
+static void
+chain_push_then_traverse_read_locked(struct u_space_chain *chain, struct u_space *space)
+{
+	switch (space->type) {
+	case U_SPACE_TYPE_NULL: break; // No-op
+	case U_SPACE_TYPE_POSE: chain_push_device(chain, false, space); break;
+	case U_SPACE_TYPE_OFFSET: chain_push_pose(chain, &space->offset.pose); break;
+	case U_SPACE_TYPE_ROOT: return; // Stops the traversing.
+	}
+
+	assert(space->next != NULL);
+	chain_push_then_traverse_read_locked(chain, space->next);
+}
+
+//! Same as @ref traverse_then_push_inverse but only records the steps.
+static void
+chain_traverse_then_push_inverse_read_locked(struct u_space_chain *chain, struct u_space *space)
+{
+	if (space->type == U_SPACE_TYPE_ROOT) {
+		return; // Stops the traversing.
+	}
+
+	assert(space->next != NULL);
+	chain_traverse_then_push_inverse_read_locked(chain, space->next);
+
+	switch (space->type) {
+	case U_SPACE_TYPE_NULL: break; // No-op
+	case U_SPACE_TYPE_POSE: chain_push_device(chain, true, space); break;
+	case U_SPACE_TYPE_OFFSET: chain_push_inverted_pose(chain, &space->offset.pose); break;
+	case U_SPACE_TYPE_ROOT: assert(false); // Should not get here.
+	}
+}
+
+/*!
+ * Gets the static part of the chain from @p target to @p base, only walks the
+ * graph with the main lock held if the chain isn't cached already.
+ */
+static void
+get_chain(struct u_space_overseer *uso, struct u_space *base, struct u_space *target, struct u_space_chain *out_chain)
+{
+	pthread_mutex_lock(&uso->chain_cache.mutex);
+
+	for (uint32_t i = 0; i < U_SPACE_CHAIN_CACHE_SIZE; i++) {
+		const struct u_space_chain *entry = &uso->chain_cache.entries[i];
+
+		if (entry->version == uso->chain_cache.version && //
+		    entry->base_id.data == base->id.data &&       //
+		    entry->target_id.data == target->id.data) {
+			*out_chain = *entry;
+			pthread_mutex_unlock(&uso->chain_cache.mutex);
+			return;
+		}
+	}
+
+	pthread_mutex_unlock(&uso->chain_cache.mutex);
+
+
+	/*
+	 * Not cached, build it. The version can't change while we hold the
+	 * main lock as it is only bumped by holders of the write lock.
+	 */
+
+	struct u_space_chain chain = {0};
+	chain.base_id = base->id;
+	chain.target_id = target->id;
+
+	pthread_rwlock_rdlock(&uso->lock);
+
+	pthread_mutex_lock(&uso->chain_cache.mutex);
+	chain.version = uso->chain_cache.version;
+	pthread_mutex_unlock(&uso->chain_cache.mutex);
+
+	chain_push_then_traverse_read_locked(&chain, target);
+	chain_traverse_then_push_inverse_read_locked(&chain, base);
+
+	pthread_rwlock_unlock(&uso->lock);
+
+	// Replace the oldest entry, if the graph changed meanwhile it never hits.
+	pthread_mutex_lock(&uso->chain_cache.mutex);
+	uso->chain_cache.entries[uso->chain_cache.next] = chain;
+	uso->chain_cache.next = (uso->chain_cache.next + 1) % U_SPACE_CHAIN_CACHE_SIZE;
+	pthread_mutex_unlock(&uso->chain_cache.mutex);
+
+	*out_chain = chain;
+}
+
+/*!
+ * Gets the pose of the device from the snapshot if it has been sampled close
+ * enough to the timestamp, otherwise samples it and adds it to the snapshot.
+ * With multiple clients they all locate for the same frame at nearly the same
+ * time, so this stops the cost of that from scaling with the client count.
+ */
+static void
+get_device_pose(struct u_space_overseer *uso,
+                struct xrt_device *xdev,
+                enum xrt_input_name xname,
+                uint64_t at_timestamp_ns,
+                struct xrt_space_relation *out_relation)
+{
+	uint64_t tolerance_ns = uso->snapshot.tolerance_ns;
+
+	if (tolerance_ns == 0) {
+		xrt_device_get_tracked_pose(xdev, xname, at_timestamp_ns, out_relation);
+		return;
+	}
+
+	struct u_space_snapshot_entry found = {0};
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	pthread_mutex_lock(&uso->snapshot.mutex);
+
+	for (uint32_t i = 0; i < U_SPACE_SNAPSHOT_SIZE; i++) {
+		const struct u_space_snapshot_entry *entry = &uso->snapshot.entries[i];
+
+		if (entry->xdev != xdev || entry->xname != xname) {
+			continue;
+		}
+
+		uint64_t diff_ns = at_timestamp_ns > entry->at_timestamp_ns ? at_timestamp_ns - entry->at_timestamp_ns
+		                                                             : entry->at_timestamp_ns - at_timestamp_ns;
+
+		if (diff_ns <= tolerance_ns && now_ns - entry->sampled_ns < U_SPACE_SNAPSHOT_MAX_AGE_NS) {
+			found = *entry;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&uso->snapshot.mutex);
+
+	if (found.xdev != NULL) {
+		if (found.at_timestamp_ns == at_timestamp_ns) {
+			*out_relation = found.relation;
+		} else {
+			// Cheap compared to sampling the device.
+			int64_t delta_ns = (int64_t)at_timestamp_ns - (int64_t)found.at_timestamp_ns;
+			m_predict_relation(&found.relation, time_ns_to_s(delta_ns), out_relation);
+		}
+		return;
+	}
+
+	// Sample outside of the lock, devices may take a while.
+	xrt_device_get_tracked_pose(xdev, xname, at_timestamp_ns, out_relation);
+
+	pthread_mutex_lock(&uso->snapshot.mutex);
+
+	struct u_space_snapshot_entry *entry = &uso->snapshot.entries[uso->snapshot.next];
+	entry->xdev = xdev;
+	entry->xname = xname;
+	entry->at_timestamp_ns = at_timestamp_ns;
+	entry->sampled_ns = now_ns;
+	entry->relation = *out_relation;
+	uso->snapshot.next = (uso->snapshot.next + 1) % U_SPACE_SNAPSHOT_SIZE;
+
+	pthread_mutex_unlock(&uso->snapshot.mutex);
+}
+
+/*!
+ * Fetches the device poses of the cached chain and pushes all of the steps.
+ */
+static void
+push_cached_chain(struct u_space_overseer *uso,
+                  struct xrt_relation_chain *xrc,
+                  const struct u_space_chain *chain,
+                  uint64_t at_timestamp_ns)
+{
+	for (uint32_t i = 0; i < chain->step_count; i++) {
+		const struct u_space_chain_step *step = &chain->steps[i];
+		struct xrt_space_relation xsr;
+
+		switch (step->type) {
+		case U_SPACE_CHAIN_STEP_POSE: m_relation_chain_push_pose(xrc, &step->pose); break;
+		case U_SPACE_CHAIN_STEP_DEVICE:
+			get_device_pose(uso, step->device.xdev, step->device.xname, at_timestamp_ns, &xsr);
+			m_relation_chain_push_relation(xrc, &xsr);
+			break;
+		case U_SPACE_CHAIN_STEP_DEVICE_INVERTED:
+			get_device_pose(uso, step->device.xdev, step->device.xname, at_timestamp_ns, &xsr);
+			m_relation_chain_push_inverted_relation(xrc, &xsr);
+			break;
+		}
+	}
+}
+
+
 /*
  *
  * Direct space functions.
@@ -424,6 +786,7 @@ create_space(enum u_space_type type, struct u_space *parent)
 	us->base.reference.count = 1;
 	us->base.destroy = space_destroy;
 	us->type = type;
+	us->id = u_limited_unique_id_get();
 
 	u_space_reference(&us->next, parent);
 
@@ -523,7 +886,9 @@ locate_space(struct xrt_space_overseer *xso,
 	// crude optimization: If locating a space in itself, we don't actually need to locate the space itself.
 	// only the offsets need to be applied.
 	if (uspace != ubase_space) {
-		build_relation_chain(uso, &xrc, ubase_space, uspace, at_timestamp_ns);
+		struct u_space_chain chain;
+		get_chain(uso, ubase_space, uspace, &chain);
+		push_cached_chain(uso, &xrc, &chain, at_timestamp_ns);
 	}
 
 	m_relation_chain_push_inverted_pose_if_not_identity(&xrc, base_offset);
@@ -534,6 +899,41 @@ locate_space(struct xrt_space_overseer *xso,
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+locate_spaces(struct xrt_space_overseer *xso,
+              struct xrt_space *base_space,
+              const struct xrt_pose *base_offset,
+              uint64_t at_timestamp_ns,
+              struct xrt_space **spaces,
+              uint32_t space_count,
+              const struct xrt_pose *offsets,
+              struct xrt_space_relation *out_relations)
+{
+	struct u_space_overseer *uso = u_space_overseer(xso);
+
+	struct u_space *ubase_space = u_space(base_space);
+
+	for (uint32_t i = 0; i < space_count; i++) {
+		struct u_space *uspace = u_space(spaces[i]);
+		struct xrt_relation_chain xrc = {0};
+
+		m_relation_chain_push_pose_if_not_identity(&xrc, &offsets[i]);
+
+		// Same crude optimization as in locate_space.
+		if (uspace != ubase_space) {
+			struct u_space_chain chain;
+			get_chain(uso, ubase_space, uspace, &chain);
+			push_cached_chain(uso, &xrc, &chain, at_timestamp_ns);
+		}
+
+		m_relation_chain_push_inverted_pose_if_not_identity(&xrc, base_offset);
+
+		special_resolve(&xrc, &out_relations[i]);
+	}
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 locate_device(struct xrt_space_overseer *xso,
               struct xrt_space *base_space,
@@ -547,17 +947,19 @@ locate_device(struct xrt_space_overseer *xso,
 	struct u_space *ubase_space = u_space(base_space);
 
 	struct xrt_relation_chain xrc = {0};
+	struct u_space *uspace = NULL;
 
-	// Only need the read lock.
+	// Only need the read lock, hold a reference in case it is replaced.
 	pthread_rwlock_rdlock(&uso->lock);
+	u_space_reference(&uspace, find_xdev_space_read_locked(uso, xdev));
+	pthread_rwlock_unlock(&uso->lock);
 
-	struct u_space *uspace = find_xdev_space_read_locked(uso, xdev);
-	build_relation_chain_read_locked(uso, &xrc, ubase_space, uspace, at_timestamp_ns);
+	struct u_space_chain chain;
+	get_chain(uso, ubase_space, uspace, &chain);
+	push_cached_chain(uso, &xrc, &chain, at_timestamp_ns);
 
-	// Safe to unlock now.
-	pthread_rwlock_unlock(&uso->lock);
+	u_space_reference(&uspace, NULL);
 
-	// Do as much work outside of the lock.
 	m_relation_chain_push_inverted_pose_if_not_identity(&xrc, base_offset);
 	special_resolve(&xrc, out_relation);
 
@@ -691,8 +1093,8 @@ recenter_local_spaces(struct xrt_space_overseer *xso)
 	local_floor_offset.position.z = rel.pose.position.z;
 
 	// Update the offsets.
-	update_offset_write_locked(ulocal, &local_offset);
-	update_offset_write_locked(ulocal_floor, &local_floor_offset);
+	update_offset_write_locked(uso, ulocal, &local_offset);
+	update_offset_write_locked(uso, ulocal_floor, &local_floor_offset);
 
 	// Push the events.
 	union xrt_session_event xse = XRT_STRUCT_INIT;
@@ -743,6 +1145,8 @@ destroy(struct xrt_space_overseer *xso)
 	u_hashmap_int_clear_and_call_for_each(uso->xdev_map, hashmap_unreference_space_items, uso);
 	u_hashmap_int_destroy(&uso->xdev_map);
 
+	pthread_mutex_destroy(&uso->snapshot.mutex);
+	pthread_mutex_destroy(&uso->chain_cache.mutex);
 	pthread_rwlock_destroy(&uso->lock);
 
 	free(uso);
@@ -762,6 +1166,7 @@ u_space_overseer_create(struct xrt_session_event_sink *broadcast)
 	uso->base.create_offset_space = create_offset_space;
 	uso->base.create_pose_space = create_pose_space;
 	uso->base.locate_space = locate_space;
+	uso->base.locate_spaces = locate_spaces;
 	uso->base.locate_device = locate_device;
 	uso->base.ref_space_inc = ref_space_inc;
 	uso->base.ref_space_dec = ref_space_dec;
@@ -774,6 +1179,15 @@ u_space_overseer_create(struct xrt_session_event_sink *broadcast)
 	ret = pthread_rwlock_init(&uso->lock, NULL);
 	assert(ret == 0);
 
+	ret = pthread_mutex_init(&uso->chain_cache.mutex, NULL);
+	assert(ret == 0);
+
+	ret = pthread_mutex_init(&uso->snapshot.mutex, NULL);
+	assert(ret == 0);
+
+	long tolerance_us = debug_get_num_option_snapshot_tolerance_us();
+	uso->snapshot.tolerance_ns = tolerance_us > 0 ? (uint64_t)tolerance_us * 1000 : 0;
+
 	ret = u_hashmap_int_create(&uso->xdev_map);
 	assert(ret == 0);
 
@@ -0,0 +1,189 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Records how long the phases of starting the runtime take.
+ *
+ * The table is global and only ever grows, phases are few and started from
+ * whatever thread happens to be doing the work, so a single lock is plenty.
+ *
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "os/os_time.h"
+
+#include "util/u_time.h"
+#include "util/u_debug.h"
+#include "util/u_logging.h"
+#include "util/u_trace_marker.h"
+#include "util/u_pretty_print.h"
+#include "util/u_startup_timeline.h"
+
+#include <mutex>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(startup_timeline_log, "XRT_STARTUP_TIMELINE_LOG", false)
+
+
+namespace {
+
+struct timeline
+{
+	std::mutex mutex = {};
+
+	//! Never cleared, so the names can be given to the trace backends.
+	struct u_startup_phase phases[U_STARTUP_TIMELINE_MAX_PHASES] = {};
+
+	uint32_t count = 0;
+
+	//! Number of begun phases that have not ended yet.
+	uint32_t running = 0;
+};
+
+//! Never freed, phases can end during static destruction.
+timeline &g_timeline = *new timeline;
+
+double
+ns_to_ms(uint64_t ns)
+{
+	return (double)ns / (double)U_TIME_1MS_IN_NS;
+}
+
+} // namespace
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+extern "C" int32_t
+u_startup_timeline_begin(const char *format, ...)
+{
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	std::unique_lock<std::mutex> lock(g_timeline.mutex);
+
+	if (g_timeline.count >= U_STARTUP_TIMELINE_MAX_PHASES) {
+		return U_STARTUP_TIMELINE_INVALID_ID;
+	}
+
+	int32_t id = (int32_t)g_timeline.count++;
+	struct u_startup_phase *phase = &g_timeline.phases[id];
+
+	va_list args;
+	va_start(args, format);
+	vsnprintf(phase->name, sizeof(phase->name), format, args);
+	va_end(args);
+
+	phase->begin_ns = now_ns;
+	phase->end_ns = 0;
+	phase->depth = g_timeline.running++;
+
+	if (U_TRACE_CATEGORY_IS_ENABLED(xrt)) {
+		U_TRACE_EVENT_BEGIN_ON_TRACK(xrt, startup, now_ns, phase->name);
+	}
+
+	return id;
+}
+
+extern "C" void
+u_startup_timeline_end(int32_t id)
+{
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	if (id < 0 || id >= U_STARTUP_TIMELINE_MAX_PHASES) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(g_timeline.mutex);
+
+	struct u_startup_phase *phase = &g_timeline.phases[id];
+	if ((uint32_t)id >= g_timeline.count || phase->end_ns != 0) {
+		return;
+	}
+
+	phase->end_ns = now_ns;
+	g_timeline.running--;
+
+	if (U_TRACE_CATEGORY_IS_ENABLED(xrt)) {
+		U_TRACE_EVENT_END_ON_TRACK(xrt, startup, now_ns);
+	}
+}
+
+extern "C" void
+u_startup_timeline_mark(const char *name)
+{
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	std::unique_lock<std::mutex> lock(g_timeline.mutex);
+
+	if (g_timeline.count >= U_STARTUP_TIMELINE_MAX_PHASES) {
+		return;
+	}
+
+	struct u_startup_phase *phase = &g_timeline.phases[g_timeline.count++];
+
+	snprintf(phase->name, sizeof(phase->name), "%s", name);
+	phase->begin_ns = now_ns;
+	phase->end_ns = now_ns;
+	phase->depth = g_timeline.running;
+
+	if (U_TRACE_CATEGORY_IS_ENABLED(xrt)) {
+		U_TRACE_INSTANT_ON_TRACK(xrt, startup, now_ns, phase->name);
+	}
+}
+
+extern "C" uint32_t
+u_startup_timeline_get(uint32_t index, struct u_startup_phase *out_phase)
+{
+	std::unique_lock<std::mutex> lock(g_timeline.mutex);
+
+	if (index < g_timeline.count) {
+		*out_phase = g_timeline.phases[index];
+	}
+
+	return g_timeline.count;
+}
+
+extern "C" void
+u_startup_timeline_log(void)
+{
+	if (!debug_get_bool_option_startup_timeline_log()) {
+		return;
+	}
+
+	struct u_pp_sink_stack_only sink; // Not inited, very large.
+	u_pp_delegate_t dg = u_pp_sink_stack_only_init(&sink);
+
+	std::unique_lock<std::mutex> lock(g_timeline.mutex);
+
+	uint64_t start_ns = g_timeline.count > 0 ? g_timeline.phases[0].begin_ns : 0;
+
+	u_pp(dg, "Startup timeline:");
+	u_pp(dg, "\n\t%10s %10s  %s", "start", "duration", "phase");
+
+	for (uint32_t i = 0; i < g_timeline.count; i++) {
+		const struct u_startup_phase *phase = &g_timeline.phases[i];
+
+		u_pp(dg, "\n\t%8.1fms ", ns_to_ms(phase->begin_ns - start_ns));
+
+		if (phase->end_ns == 0) {
+			u_pp(dg, "%10s", "running");
+		} else {
+			u_pp(dg, "%8.1fms", ns_to_ms(phase->end_ns - phase->begin_ns));
+		}
+
+		u_pp(dg, "  %*s%s", (int)phase->depth * 2, "", phase->name);
+	}
+
+	lock.unlock();
+
+	U_LOG_I("%s", sink.buffer);
+}
@@ -0,0 +1,118 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Records how long the phases of starting the runtime take.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Phases after this many are not recorded.
+ *
+ * @ingroup aux_util
+ */
+#define U_STARTUP_TIMELINE_MAX_PHASES (64)
+
+/*!
+ * Longer phase names are truncated.
+ *
+ * @ingroup aux_util
+ */
+#define U_STARTUP_TIMELINE_NAME_LEN (64)
+
+/*!
+ * Returned by @ref u_startup_timeline_begin when the phase was not recorded.
+ *
+ * @ingroup aux_util
+ */
+#define U_STARTUP_TIMELINE_INVALID_ID (-1)
+
+/*!
+ * One recorded phase of starting up.
+ *
+ * @ingroup aux_util
+ */
+struct u_startup_phase
+{
+	char name[U_STARTUP_TIMELINE_NAME_LEN];
+
+	//! From @ref os_monotonic_get_ns.
+	uint64_t begin_ns;
+
+	//! From @ref os_monotonic_get_ns, zero if the phase has not ended yet.
+	uint64_t end_ns;
+
+	//! Number of phases that were running when this one began.
+	uint32_t depth;
+};
+
+/*!
+ * Begin a phase, the name is a printf style format string. Phases begun while
+ * another one is running are nested inside of it in the table. Also emitted as
+ * a span on the "Startup" trace track.
+ *
+ * @return Id to pass to @ref u_startup_timeline_end.
+ *
+ * @ingroup aux_util
+ */
+int32_t
+u_startup_timeline_begin(const char *format, ...) XRT_PRINTF_FORMAT(1, 2);
+
+/*!
+ * End a phase begun with @ref u_startup_timeline_begin, ignores
+ * @ref U_STARTUP_TIMELINE_INVALID_ID.
+ *
+ * @ingroup aux_util
+ */
+void
+u_startup_timeline_end(int32_t id);
+
+/*!
+ * Record a point in time as a phase with no length, like the first frame
+ * being presented.
+ *
+ * @ingroup aux_util
+ */
+void
+u_startup_timeline_mark(const char *name);
+
+/*!
+ * Get the phase at @p index, in the order they were begun.
+ *
+ * @param      index     Index of the phase.
+ * @param[out] out_phase The phase, untouched if @p index is out of range.
+ *
+ * @return The number of recorded phases.
+ *
+ * @ingroup aux_util
+ */
+uint32_t
+u_startup_timeline_get(uint32_t index, struct u_startup_phase *out_phase);
+
+/*!
+ * Log the recorded phases as a table, only if the `XRT_STARTUP_TIMELINE_LOG`
+ * environment variable is set.
+ *
+ * @ingroup aux_util
+ */
+void
+u_startup_timeline_log(void);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,222 @@
+// Copyright 2024, Collabora, Ltd.
+//
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Lock-free single producer single consumer ring buffer.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <stddef.h>
+
+
+namespace xrt::auxiliary::util {
+
+namespace detail {
+
+	/*!
+	 * Turns an ever increasing counter into an index, for a capacity known
+	 * at compile time. Powers of two compile down to a mask.
+	 */
+	template <size_t Capacity> struct SpscIndex
+	{
+		static constexpr bool is_power_of_two = (Capacity & (Capacity - 1)) == 0;
+
+		static constexpr size_t
+		wrap(size_t counter) noexcept
+		{
+			if constexpr (is_power_of_two) {
+				return counter & (Capacity - 1);
+			} else {
+				return counter % Capacity;
+			}
+		}
+	};
+
+} // namespace detail
+
+/*!
+ * @brief A ring buffer that one thread pushes to and another thread pops from,
+ * without any locks.
+ *
+ * Unlike @ref HistoryBuffer a full buffer is never overwritten, the push
+ * fails instead, as the consumer might be reading the oldest element. The
+ * indices are ever increasing counters that are published with release and
+ * read with acquire semantics, each on its own cache line together with the
+ * owning side's cached copy of the other index.
+ *
+ * Only the producer thread may call the push functions, and only the consumer
+ * thread the pop and peek functions. A capacity that is a power of two is
+ * cheapest.
+ */
+template <typename T, size_t MaxSize> class SpscHistoryBuffer
+{
+public:
+	static_assert(MaxSize > 0, "Need room for at least one element");
+	static_assert(MaxSize < (std::numeric_limits<size_t>::max() >> 1), "Cannot use most significant bit");
+
+	//! How many elements fit in the buffer.
+	static constexpr size_t
+	capacity() noexcept
+	{
+		return MaxSize;
+	}
+
+	/*!
+	 * @brief How many elements are in the buffer, from either thread this
+	 * is only a snapshot.
+	 */
+	size_t
+	size() const noexcept
+	{
+		size_t head = head_.load(std::memory_order_acquire);
+		size_t tail = tail_.load(std::memory_order_acquire);
+		return (std::min)(tail - head, MaxSize);
+	}
+
+	//! Is the buffer empty? Same caveats as @ref size.
+	bool
+	empty() const noexcept
+	{
+		return size() == 0;
+	}
+
+
+	/*
+	 *
+	 * Producer functions.
+	 *
+	 */
+
+	/*!
+	 * @brief Put @p element at the back, producer only.
+	 *
+	 * @return false if the buffer is full.
+	 */
+	bool
+	try_push_back(const T &element) noexcept
+	{
+		return push_back_bulk(&element, 1) == 1;
+	}
+
+	/*!
+	 * @brief Put as many of the @p count @p elements at the back as fit,
+	 * they become visible to the consumer all at once, producer only.
+	 *
+	 * @return How many elements were pushed.
+	 */
+	size_t
+	push_back_bulk(const T *elements, size_t count) noexcept
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+
+		// Only look at the consumer's index when the cached one says we are out of room.
+		if (MaxSize - (tail - producer_head_) < count) {
+			producer_head_ = head_.load(std::memory_order_acquire);
+		}
+
+		size_t n = (std::min)(count, MaxSize - (tail - producer_head_));
+		for (size_t i = 0; i < n; i++) {
+			buffer_[index::wrap(tail + i)] = elements[i];
+		}
+
+		tail_.store(tail + n, std::memory_order_release);
+
+		return n;
+	}
+
+
+	/*
+	 *
+	 * Consumer functions.
+	 *
+	 */
+
+	/*!
+	 * @brief Take the oldest element, consumer only.
+	 *
+	 * @return false if the buffer is empty.
+	 */
+	bool
+	try_pop_front(T &out_element) noexcept
+	{
+		return pop_front_bulk(&out_element, 1) == 1;
+	}
+
+	/*!
+	 * @brief Take up to @p max_count of the oldest elements, oldest first,
+	 * consumer only.
+	 *
+	 * @return How many elements were written to @p out_elements.
+	 */
+	size_t
+	pop_front_bulk(T *out_elements, size_t max_count) noexcept
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+
+		// Only look at the producer's index when the cached one says there is not enough.
+		if (consumer_tail_ - head < max_count) {
+			consumer_tail_ = tail_.load(std::memory_order_acquire);
+		}
+
+		size_t n = (std::min)(max_count, consumer_tail_ - head);
+		for (size_t i = 0; i < n; i++) {
+			out_elements[i] = buffer_[index::wrap(head + i)];
+		}
+
+		head_.store(head + n, std::memory_order_release);
+
+		return n;
+	}
+
+	/*!
+	 * @brief Look at the oldest element without taking it, consumer only.
+	 * The element stays valid until it is popped.
+	 *
+	 * @return nullptr if the buffer is empty.
+	 */
+	const T *
+	peek_front() noexcept
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+
+		if (consumer_tail_ == head) {
+			consumer_tail_ = tail_.load(std::memory_order_acquire);
+			if (consumer_tail_ == head) {
+				return nullptr;
+			}
+		}
+
+		return &buffer_[index::wrap(head)];
+	}
+
+
+private:
+	using index = detail::SpscIndex<MaxSize>;
+
+	//! Next element to pop, written by the consumer.
+	alignas(XRT_CACHE_LINE_SIZE) std::atomic<size_t> head_{0};
+
+	//! The consumer's last look at @ref tail_.
+	size_t consumer_tail_ = 0;
+
+	//! Next element to push, written by the producer.
+	alignas(XRT_CACHE_LINE_SIZE) std::atomic<size_t> tail_{0};
+
+	//! The producer's last look at @ref head_.
+	size_t producer_head_ = 0;
+
+	alignas(XRT_CACHE_LINE_SIZE) std::array<T, MaxSize> buffer_{};
+};
+
+
+} // namespace xrt::auxiliary::util
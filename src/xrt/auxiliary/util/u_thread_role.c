@@ -0,0 +1,207 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Thread roles, scheduling settings per kind of thread.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ *
+ * @ingroup aux_util
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include "util/u_debug.h"
+#include "util/u_logging.h"
+#include "util/u_thread_role.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(XRT_OS_LINUX)
+#include <pthread.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/resource.h>
+#elif defined(XRT_OS_WINDOWS)
+#include "xrt/xrt_windows.h"
+#include "util/u_windows.h"
+#include <avrt.h>
+#endif
+
+
+DEBUG_GET_ONCE_LOG_OPTION(log_level, "U_THREAD_ROLE_LOG", U_LOGGING_INFO)
+
+#define LOG_D(...) U_LOG_IFL_D(debug_get_log_option_log_level(), __VA_ARGS__)
+#define LOG_I(...) U_LOG_IFL_I(debug_get_log_option_log_level(), __VA_ARGS__)
+#define LOG_W(...) U_LOG_IFL_W(debug_get_log_option_log_level(), __VA_ARGS__)
+
+/*!
+ * The compositor and device reading threads have always tried to go realtime,
+ * keep doing that by default. The others are left alone unless configured.
+ */
+static struct u_thread_role_settings g_settings[U_THREAD_ROLE_COUNT] = {
+    [U_THREAD_ROLE_COMPOSITOR] = {.realtime = true, .mmcss_task = "Games"},
+    [U_THREAD_ROLE_REALTIME_IO] = {.realtime = true, .mmcss_task = "Pro Audio"},
+    [U_THREAD_ROLE_TRACKING] = {0},
+    [U_THREAD_ROLE_BACKGROUND] = {0},
+};
+
+
+/*
+ *
+ * Platform functions.
+ *
+ */
+
+#if defined(XRT_OS_LINUX)
+
+static void
+apply_cpu_mask(const char *name, uint64_t cpu_mask)
+{
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	for (uint32_t i = 0; i < 64; i++) {
+		if ((cpu_mask & (UINT64_C(1) << i)) != 0) {
+			CPU_SET(i, &set);
+		}
+	}
+
+	// Zero pid means the calling thread, also works on Android.
+	if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+		LOG_W("Could not set CPU mask 0x%" PRIx64 " on thread '%s'", cpu_mask, name);
+	}
+}
+
+static void
+apply_realtime(const char *name, int32_t priority)
+{
+	struct sched_param params = {0};
+	params.sched_priority = priority > 0 ? priority : sched_get_priority_max(SCHED_FIFO);
+
+	int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &params);
+	if (ret != 0) {
+		LOG_W("Could not set SCHED_FIFO priority %i on thread '%s': %i", params.sched_priority, name, ret);
+	}
+}
+
+static void
+apply_nice(const char *name, int32_t nice)
+{
+	// On Linux nice levels are per thread when given the thread id.
+	if (setpriority(PRIO_PROCESS, gettid(), nice) != 0) {
+		LOG_W("Could not set nice level %i on thread '%s'", nice, name);
+	}
+}
+
+static void
+apply_settings(const char *name, const struct u_thread_role_settings *s)
+{
+	if (s->cpu_mask != 0) {
+		apply_cpu_mask(name, s->cpu_mask);
+	}
+
+	if (s->realtime) {
+		apply_realtime(name, s->priority);
+	} else if (s->nice != 0) {
+		apply_nice(name, s->nice);
+	}
+}
+
+#elif defined(XRT_OS_WINDOWS)
+
+#define GET_LAST_ERROR_STR(BUF) (u_winerror(BUF, ARRAY_SIZE(BUF), GetLastError(), true))
+
+static void
+apply_settings(const char *name, const struct u_thread_role_settings *s)
+{
+	char buf[512];
+
+	if (s->cpu_mask != 0 && SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)s->cpu_mask) == 0) {
+		LOG_W("SetThreadAffinityMask on thread '%s': %s", name, GET_LAST_ERROR_STR(buf));
+	}
+
+	if (s->realtime) {
+		const char *task = s->mmcss_task[0] != '\0' ? s->mmcss_task : "Games";
+		DWORD task_index = 0;
+
+		// Never reverted, the thread keeps the MMCSS class until it exits.
+		HANDLE handle = AvSetMmThreadCharacteristicsA(task, &task_index);
+		if (handle == NULL) {
+			LOG_W("AvSetMmThreadCharacteristicsA('%s') on thread '%s': %s", task, name,
+			      GET_LAST_ERROR_STR(buf));
+		} else if (!AvSetMmThreadPriority(handle, AVRT_PRIORITY_HIGH)) {
+			LOG_W("AvSetMmThreadPriority on thread '%s': %s", name, GET_LAST_ERROR_STR(buf));
+		}
+	} else if (s->nice != 0) {
+		int priority = s->nice < 0 ? THREAD_PRIORITY_ABOVE_NORMAL : THREAD_PRIORITY_BELOW_NORMAL;
+		if (!SetThreadPriority(GetCurrentThread(), priority)) {
+			LOG_W("SetThreadPriority on thread '%s': %s", name, GET_LAST_ERROR_STR(buf));
+		}
+	}
+}
+
+#else
+
+static void
+apply_settings(const char *name, const struct u_thread_role_settings *s)
+{
+	LOG_D("Thread roles not supported on this platform, not applying to '%s'", name);
+}
+
+#endif
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+const char *
+u_thread_role_to_string(enum u_thread_role role)
+{
+	switch (role) {
+	case U_THREAD_ROLE_COMPOSITOR: return "compositor";
+	case U_THREAD_ROLE_REALTIME_IO: return "realtime_io";
+	case U_THREAD_ROLE_TRACKING: return "tracking";
+	case U_THREAD_ROLE_BACKGROUND: return "background";
+	default: return "unknown";
+	}
+}
+
+void
+u_thread_role_get_settings(enum u_thread_role role, struct u_thread_role_settings *out_settings)
+{
+	assert(role < U_THREAD_ROLE_COUNT);
+
+	*out_settings = g_settings[role];
+}
+
+void
+u_thread_role_set_settings(enum u_thread_role role, const struct u_thread_role_settings *settings)
+{
+	assert(role < U_THREAD_ROLE_COUNT);
+
+	g_settings[role] = *settings;
+	g_settings[role].mmcss_task[ARRAY_SIZE(g_settings[role].mmcss_task) - 1] = '\0';
+}
+
+void
+u_thread_role_apply_to_current_thread(enum u_thread_role role, const char *name)
+{
+	assert(role < U_THREAD_ROLE_COUNT);
+
+	if (name == NULL) {
+		name = "<unnamed>";
+	}
+
+	const struct u_thread_role_settings *s = &g_settings[role];
+
+	LOG_D("Applying role '%s' to thread '%s' (realtime: %s, priority: %i, nice: %i, cpu_mask: 0x%" PRIx64 ")",
+	      u_thread_role_to_string(role), name, s->realtime ? "true" : "false", s->priority, s->nice,
+	      s->cpu_mask);
+
+	apply_settings(name, s);
+}
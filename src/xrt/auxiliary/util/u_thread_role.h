@@ -0,0 +1,113 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Thread roles, scheduling settings per kind of thread.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ *
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * The kind of work a thread does, used to pick scheduling settings for it.
+ *
+ * @ingroup aux_util
+ */
+enum u_thread_role
+{
+	//! Compositor rendering and pacing threads.
+	U_THREAD_ROLE_COMPOSITOR,
+	//! Device reading and IPC threads that must not be starved.
+	U_THREAD_ROLE_REALTIME_IO,
+	//! Hand tracking, SLAM and other heavy tracking work.
+	U_THREAD_ROLE_TRACKING,
+	//! Everything else.
+	U_THREAD_ROLE_BACKGROUND,
+
+	U_THREAD_ROLE_COUNT,
+};
+
+/*!
+ * Scheduling settings applied to threads of a role.
+ *
+ * @ingroup aux_util
+ */
+struct u_thread_role_settings
+{
+	/*!
+	 * Use realtime scheduling, SCHED_FIFO on Linux and MMCSS on Windows.
+	 */
+	bool realtime;
+
+	/*!
+	 * Realtime priority, zero or less means the maximum available.
+	 */
+	int32_t priority;
+
+	/*!
+	 * Nice level used when not realtime, zero leaves it as is. On Windows
+	 * this maps to above or below normal thread priority.
+	 */
+	int32_t nice;
+
+	/*!
+	 * Bitmask of CPUs the thread is allowed to run on, zero means all.
+	 */
+	uint64_t cpu_mask;
+
+	/*!
+	 * Windows MMCSS task name used when realtime, like "Games" or
+	 * "Pro Audio", empty means "Games".
+	 */
+	char mmcss_task[32];
+};
+
+/*!
+ * Returns a string for the role, same as used in the config file.
+ *
+ * @ingroup aux_util
+ */
+const char *
+u_thread_role_to_string(enum u_thread_role role);
+
+/*!
+ * Get the current settings for the given role.
+ *
+ * @ingroup aux_util
+ */
+void
+u_thread_role_get_settings(enum u_thread_role role, struct u_thread_role_settings *out_settings);
+
+/*!
+ * Replace the settings of a role, not thread safe, so should be done at
+ * startup before any threads apply their role.
+ *
+ * @ingroup aux_util
+ */
+void
+u_thread_role_set_settings(enum u_thread_role role, const struct u_thread_role_settings *settings);
+
+/*!
+ * Apply the settings of the role to the calling thread, failing to apply them
+ * is not fatal and is only logged. The name is only used for logging, can be
+ * NULL.
+ *
+ * @ingroup aux_util
+ */
+void
+u_thread_role_apply_to_current_thread(enum u_thread_role role, const char *name);
+
+
+#ifdef __cplusplus
+}
+#endif
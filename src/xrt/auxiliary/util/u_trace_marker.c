@@ -41,6 +41,11 @@ PERCETTO_TRACK_DEFINE(pc_present, PERCETTO_TRACK_EVENTS);
 PERCETTO_TRACK_DEFINE(pa_cpu, PERCETTO_TRACK_EVENTS);
 PERCETTO_TRACK_DEFINE(pa_draw, PERCETTO_TRACK_EVENTS);
 PERCETTO_TRACK_DEFINE(pa_wait, PERCETTO_TRACK_EVENTS);
+PERCETTO_TRACK_DEFINE(gpu_squash, PERCETTO_TRACK_EVENTS);
+PERCETTO_TRACK_DEFINE(gpu_distortion, PERCETTO_TRACK_EVENTS);
+PERCETTO_TRACK_DEFINE(gpu_clear, PERCETTO_TRACK_EVENTS);
+PERCETTO_TRACK_DEFINE(gpu_mirror, PERCETTO_TRACK_EVENTS);
+PERCETTO_TRACK_DEFINE(startup, PERCETTO_TRACK_EVENTS);
 
 #if defined(__GNUC__)
 #pragma GCC diagnostic pop
@@ -66,6 +71,13 @@ u_trace_marker_setup(enum u_trace_which which)
 	I_PERCETTO_TRACK_PTR(pa_cpu)->name = "PA 1 App";
 	I_PERCETTO_TRACK_PTR(pa_draw)->name = "PA 2 Draw";
 	I_PERCETTO_TRACK_PTR(pa_wait)->name = "PA 3 Wait";
+
+	I_PERCETTO_TRACK_PTR(gpu_squash)->name = "GPU 1 Squash";
+	I_PERCETTO_TRACK_PTR(gpu_distortion)->name = "GPU 2 Distortion";
+	I_PERCETTO_TRACK_PTR(gpu_clear)->name = "GPU 3 Clear";
+	I_PERCETTO_TRACK_PTR(gpu_mirror)->name = "GPU 4 Mirror";
+
+	I_PERCETTO_TRACK_PTR(startup)->name = "Startup";
 }
 
 void
@@ -97,10 +109,33 @@ u_trace_marker_init(void)
 		PERCETTO_REGISTER_TRACK(pa_cpu);
 		PERCETTO_REGISTER_TRACK(pa_draw);
 		PERCETTO_REGISTER_TRACK(pa_wait);
+
+		PERCETTO_REGISTER_TRACK(gpu_squash);
+		PERCETTO_REGISTER_TRACK(gpu_distortion);
+		PERCETTO_REGISTER_TRACK(gpu_clear);
+		PERCETTO_REGISTER_TRACK(gpu_mirror);
+
+		PERCETTO_REGISTER_TRACK(startup);
 	}
 }
 
-#else // !U_TRACE_PERCETTO
+#elif defined(U_TRACE_RECORDER) // !U_TRACE_PERCETTO
+
+void
+u_trace_marker_setup(enum u_trace_which which)
+{
+	(void)which;
+
+	// Noop
+}
+
+void
+u_trace_marker_init(void)
+{
+	u_trace_recorder_init();
+}
+
+#else // !U_TRACE_PERCETTO && !U_TRACE_RECORDER
 
 void
 u_trace_marker_setup(enum u_trace_which which)
@@ -116,4 +151,4 @@ u_trace_marker_init(void)
 	// Noop
 }
 
-#endif // !U_TRACE_PERCETTO
+#endif // !U_TRACE_PERCETTO && !U_TRACE_RECORDER
@@ -55,6 +55,11 @@
 #endif
 #endif
 
+#if defined(XRT_FEATURE_TRACING) && !defined(XRT_HAVE_PERCETTO) && !defined(XRT_HAVE_TRACY)
+#define U_TRACE_RECORDER
+#include "util/u_trace_recorder.h"
+#endif
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -345,6 +350,11 @@ PERCETTO_TRACK_DECLARE(pc_present);
 PERCETTO_TRACK_DECLARE(pa_cpu);
 PERCETTO_TRACK_DECLARE(pa_draw);
 PERCETTO_TRACK_DECLARE(pa_wait);
+PERCETTO_TRACK_DECLARE(gpu_squash);
+PERCETTO_TRACK_DECLARE(gpu_distortion);
+PERCETTO_TRACK_DECLARE(gpu_clear);
+PERCETTO_TRACK_DECLARE(gpu_mirror);
+PERCETTO_TRACK_DECLARE(startup);
 
 #define U_TRACE_FUNC(CATEGORY) TRACE_EVENT(CATEGORY, __func__)
 #define U_TRACE_IDENT(CATEGORY, IDENT) TRACE_EVENT(CATEGORY, #IDENT)
@@ -373,11 +383,107 @@ PERCETTO_TRACK_DECLARE(pa_wait);
 		u_trace_marker_setup(WHICH);                                                                           \
 	}
 
-#else // !XRT_FEATURE_TRACING && !XRT_HAVE_PERCETTO && !XRT_HAVE_TRACY
+/*
+ *
+ * Built-in recorder support.
+ *
+ */
+
+#else // XRT_FEATURE_TRACING && !XRT_HAVE_PERCETTO && !XRT_HAVE_TRACY
+
+#ifdef __cplusplus
+
+/*!
+ * Ends the event when going out of scope.
+ *
+ * @ingroup aux_util
+ */
+struct u_trace_recorder_scope
+{
+	const char *category;
+
+	u_trace_recorder_scope(const char *category_, const char *name) : category(category_)
+	{
+		u_trace_recorder_event(category, name, U_TRACE_RECORDER_PHASE_BEGIN);
+	}
+
+	~u_trace_recorder_scope()
+	{
+		u_trace_recorder_event(category, NULL, U_TRACE_RECORDER_PHASE_END);
+	}
+};
+
+#define U_TRACE_FUNC(CATEGORY) u_trace_recorder_scope __trace_func(#CATEGORY, __func__)
+
+#define U_TRACE_IDENT(CATEGORY, IDENT) u_trace_recorder_scope __trace_scope_##IDENT(#CATEGORY, #IDENT)
+
+#elif !defined(XRT_OS_WINDOWS) // !__cplusplus
+
+static inline void
+u_trace_recorder_scope_cleanup(const char **category_ptr)
+{
+	u_trace_recorder_event(*category_ptr, NULL, U_TRACE_RECORDER_PHASE_END);
+}
+
+static inline const char *
+u_trace_recorder_scope_begin(const char *category, const char *name)
+{
+	u_trace_recorder_event(category, name, U_TRACE_RECORDER_PHASE_BEGIN);
+	return category;
+}
+
+#define U_TRACE_FUNC(CATEGORY)                                                                                         \
+	const char *__attribute__((cleanup(u_trace_recorder_scope_cleanup))) __trace_func =                            \
+	    u_trace_recorder_scope_begin(#CATEGORY, __func__);                                                         \
+	(void)__trace_func
+
+#define U_TRACE_IDENT(CATEGORY, IDENT)                                                                                 \
+	const char *__attribute__((cleanup(u_trace_recorder_scope_cleanup))) __trace_scope_##IDENT =                   \
+	    u_trace_recorder_scope_begin(#CATEGORY, #IDENT);                                                           \
+	(void)__trace_scope_##IDENT
+
+#else // !XRT_OS_WINDOWS && !__cplusplus
+
+#define U_TRACE_FUNC(CATEGORY)                                                                                         \
+	do {                                                                                                           \
+	} while (false)
+
+#define U_TRACE_IDENT(CATEGORY, IDENT)                                                                                 \
+	do {                                                                                                           \
+	} while (false)
+
+#endif // !XRT_OS_WINDOWS && !__cplusplus
+
+#define U_TRACE_BEGIN(CATEGORY, IDENT)                                                                                 \
+	int __trace_##IDENT = 0; /* To ensure they are balanced */                                                     \
+	u_trace_recorder_event(#CATEGORY, #IDENT, U_TRACE_RECORDER_PHASE_BEGIN)
 
-#error "Need to have Percetto/Perfetto"
+#define U_TRACE_END(CATEGORY, IDENT)                                                                                   \
+	do {                                                                                                           \
+		(void)__trace_##IDENT; /* To ensure they are balanced */                                               \
+		u_trace_recorder_event(#CATEGORY, NULL, U_TRACE_RECORDER_PHASE_END);                                   \
+	} while (false)
+
+#define U_TRACE_EVENT_BEGIN_ON_TRACK(CATEGORY, TRACK, TIME, NAME)                                                      \
+	u_trace_recorder_event_on_track(#CATEGORY, #TRACK, TIME, NAME, U_TRACE_RECORDER_PHASE_BEGIN)
+
+// The extra data is Percetto specific, so dropped.
+#define U_TRACE_EVENT_BEGIN_ON_TRACK_DATA(CATEGORY, TRACK, TIME, NAME, ...)                                            \
+	u_trace_recorder_event_on_track(#CATEGORY, #TRACK, TIME, NAME, U_TRACE_RECORDER_PHASE_BEGIN)
+
+#define U_TRACE_EVENT_END_ON_TRACK(CATEGORY, TRACK, TIME)                                                              \
+	u_trace_recorder_event_on_track(#CATEGORY, #TRACK, TIME, NULL, U_TRACE_RECORDER_PHASE_END)
+
+#define U_TRACE_INSTANT_ON_TRACK(CATEGORY, TRACK, TIME, NAME)                                                          \
+	u_trace_recorder_event_on_track(#CATEGORY, #TRACK, TIME, NAME, U_TRACE_RECORDER_PHASE_INSTANT)
+
+#define U_TRACE_CATEGORY_IS_ENABLED(_) (u_trace_recorder_is_enabled()) // All categories are recorded.
+
+#define U_TRACE_SET_THREAD_NAME(STRING) u_trace_recorder_set_thread_name(STRING)
+
+#define U_TRACE_TARGET_SETUP(WHICH)
 
-#endif // Error checking
+#endif // XRT_FEATURE_TRACING && !XRT_HAVE_PERCETTO && !XRT_HAVE_TRACY
 
 
 #ifdef __cplusplus
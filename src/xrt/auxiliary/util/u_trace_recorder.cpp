@@ -0,0 +1,546 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Built-in ring buffer trace recorder, see @ref tracing-recorder.
+ *
+ * Every thread that records gets its own ring of events that it alone writes
+ * to, old events are overwritten. Dumping reads the rings while they are being
+ * written and throws away anything that might have been overwritten.
+ *
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include "os/os_time.h"
+
+#include "util/u_file.h"
+#include "util/u_time.h"
+#include "util/u_debug.h"
+#include "util/u_logging.h"
+#include "util/u_trace_recorder.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <inttypes.h>
+#include <string.h>
+
+#if defined(XRT_OS_LINUX)
+#include <signal.h>
+#include <unistd.h>
+#include <semaphore.h>
+#elif defined(XRT_OS_WINDOWS)
+#include "xrt/xrt_windows.h"
+#endif
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(recorder, "XRT_TRACE_RECORDER", true)
+DEBUG_GET_ONCE_NUM_OPTION(recorder_seconds, "XRT_TRACE_RECORDER_SECONDS", 10)
+DEBUG_GET_ONCE_NUM_OPTION(recorder_events, "XRT_TRACE_RECORDER_EVENTS", 16384)
+
+//! Track events get thread ids starting at this in the dumped trace.
+#define TRACK_TID_BASE (1000000)
+
+
+namespace {
+
+/*!
+ * Fields are relaxed atomics so dumping can read them while the owning thread
+ * overwrites them, @ref seq works like a seqlock to detect torn events.
+ */
+struct event
+{
+	//! Index in the ring plus one, zero while being written.
+	std::atomic<uint64_t> seq{0};
+
+	std::atomic<uint64_t> timestamp_ns{0};
+	std::atomic<const char *> category{nullptr};
+	std::atomic<const char *> name{nullptr};
+
+	//! NULL for events on the thread itself.
+	std::atomic<const char *> track{nullptr};
+
+	std::atomic<char> phase{0};
+};
+
+struct ring
+{
+	//! Number of events ever written, only written by the owning thread.
+	std::atomic<uint64_t> head{0};
+
+	//! The thread has exited, can be reused by a new thread.
+	std::atomic<bool> abandoned{false};
+
+	//! Set by the owning thread, read when dumping.
+	std::mutex name_mutex = {};
+	char name[64] = {};
+
+	//! Stable per ring and used as the thread id in the trace.
+	uint32_t index = 0;
+
+	//! Power of two sized.
+	std::vector<event> events;
+
+	explicit ring(size_t size) : events(size) {}
+};
+
+struct recorder
+{
+	//! Protects the list of rings, and serializes dumps.
+	std::mutex mutex = {};
+
+	std::vector<ring *> rings = {};
+
+	uint64_t mask = 0;
+	uint64_t window_ns = 0;
+
+	//! Counts dumps for unique file names.
+	uint32_t dump_count = 0;
+};
+
+/*!
+ * Owned by the thread, marks the ring as reusable when the thread goes away.
+ */
+struct ring_holder
+{
+	ring *r = nullptr;
+
+	~ring_holder()
+	{
+		if (r != nullptr) {
+			r->abandoned.store(true, std::memory_order_release);
+		}
+	}
+};
+
+std::once_flag g_once;
+
+std::atomic<bool> g_enabled{false};
+
+//! Never freed, tracing can happen during static destruction.
+recorder *g_recorder = nullptr;
+
+thread_local ring_holder t_ring;
+
+} // namespace
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static uint64_t
+round_up_pow2(uint64_t v)
+{
+	uint64_t r = 1;
+	while (r < v) {
+		r <<= 1;
+	}
+	return r;
+}
+
+static uint32_t
+get_pid(void)
+{
+#if defined(XRT_OS_WINDOWS)
+	return (uint32_t)GetCurrentProcessId();
+#else
+	return (uint32_t)getpid();
+#endif
+}
+
+static ring *
+get_ring(void)
+{
+	if (t_ring.r != nullptr) {
+		return t_ring.r;
+	}
+
+	recorder &rec = *g_recorder;
+	std::unique_lock<std::mutex> lock(rec.mutex);
+
+	ring *r = nullptr;
+	for (ring *old : rec.rings) {
+		if (old->abandoned.load(std::memory_order_acquire)) {
+			r = old;
+			break;
+		}
+	}
+
+	if (r != nullptr) {
+		// The lock is held so nobody is dumping it.
+		r->head.store(0, std::memory_order_relaxed);
+		r->abandoned.store(false, std::memory_order_relaxed);
+		std::unique_lock<std::mutex> name_lock(r->name_mutex);
+		r->name[0] = '\0';
+	} else {
+		r = new ring((size_t)rec.mask + 1);
+		r->index = (uint32_t)rec.rings.size();
+		rec.rings.push_back(r);
+	}
+
+	t_ring.r = r;
+
+	return r;
+}
+
+static void
+push(const char *category, const char *track, uint64_t timestamp_ns, const char *name, char phase)
+{
+	ring *r = get_ring();
+
+	uint64_t head = r->head.load(std::memory_order_relaxed);
+	event &e = r->events[head & g_recorder->mask];
+
+	e.seq.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	e.timestamp_ns.store(timestamp_ns, std::memory_order_relaxed);
+	e.category.store(category, std::memory_order_relaxed);
+	e.name.store(name, std::memory_order_relaxed);
+	e.track.store(track, std::memory_order_relaxed);
+	e.phase.store(phase, std::memory_order_relaxed);
+
+	e.seq.store(head + 1, std::memory_order_release);
+	r->head.store(head + 1, std::memory_order_release);
+}
+
+static void
+write_string(FILE *file, const char *str)
+{
+	fputc('"', file);
+	for (const char *c = str; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', file);
+			fputc(*c, file);
+		} else if ((unsigned char)*c < 0x20) {
+			fprintf(file, "\\u%04x", (unsigned int)*c);
+		} else {
+			fputc(*c, file);
+		}
+	}
+	fputc('"', file);
+}
+
+static void
+write_metadata(FILE *file, bool *first, uint32_t pid, uint32_t tid, const char *name)
+{
+	fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%" PRIu32 ",\"tid\":%" PRIu32,
+	        *first ? "" : ",", pid, tid);
+	fputs(",\"args\":{\"name\":", file);
+	write_string(file, name);
+	fputs("}}", file);
+	*first = false;
+}
+
+//! Chrome JSON wants microseconds.
+static void
+write_timestamp(FILE *file, uint64_t timestamp_ns)
+{
+	fprintf(file, "%" PRIu64 ".%03" PRIu32, timestamp_ns / 1000, (uint32_t)(timestamp_ns % 1000));
+}
+
+//! Must be called with the lock held.
+static uint32_t
+write_locked(recorder &rec, FILE *file)
+{
+	uint32_t pid = get_pid();
+	uint64_t now_ns = os_monotonic_get_ns();
+	uint64_t cutoff_ns = now_ns > rec.window_ns ? now_ns - rec.window_ns : 0;
+	uint64_t size = rec.mask + 1;
+	uint32_t count = 0;
+	bool first = true;
+
+	// Tracks are identified by their name, give each unique name a id.
+	std::vector<const char *> tracks;
+
+	fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+
+	for (ring *r : rec.rings) {
+		uint64_t head = r->head.load(std::memory_order_acquire);
+		uint64_t start = head > size ? head - size : 0;
+
+		{
+			std::unique_lock<std::mutex> name_lock(r->name_mutex);
+			if (r->name[0] != '\0') {
+				write_metadata(file, &first, pid, r->index, r->name);
+			}
+		}
+
+		for (uint64_t i = start; i < head; i++) {
+			const event &e = r->events[i & rec.mask];
+
+			uint64_t seq = e.seq.load(std::memory_order_acquire);
+			if (seq != i + 1) {
+				continue;
+			}
+
+			uint64_t timestamp_ns = e.timestamp_ns.load(std::memory_order_relaxed);
+			const char *category = e.category.load(std::memory_order_relaxed);
+			const char *name = e.name.load(std::memory_order_relaxed);
+			const char *track = e.track.load(std::memory_order_relaxed);
+			char phase = e.phase.load(std::memory_order_relaxed);
+
+			// Was it overwritten while we were reading it?
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (e.seq.load(std::memory_order_relaxed) != seq) {
+				continue;
+			}
+
+			if (timestamp_ns < cutoff_ns) {
+				continue;
+			}
+
+			uint32_t tid = r->index;
+			if (track != nullptr) {
+				size_t t = 0;
+				while (t < tracks.size() && strcmp(tracks[t], track) != 0) {
+					t++;
+				}
+				if (t == tracks.size()) {
+					tracks.push_back(track);
+					write_metadata(file, &first, pid, TRACK_TID_BASE + (uint32_t)t, track);
+				}
+				tid = TRACK_TID_BASE + (uint32_t)t;
+			}
+
+			fprintf(file, "%s\n{\"ph\":\"%c\",\"pid\":%" PRIu32 ",\"tid\":%" PRIu32 ",\"ts\":",
+			        first ? "" : ",", phase, pid, tid);
+			write_timestamp(file, timestamp_ns);
+			if (category != nullptr) {
+				fputs(",\"cat\":", file);
+				write_string(file, category);
+			}
+			if (name != nullptr) {
+				fputs(",\"name\":", file);
+				write_string(file, name);
+			}
+			if (phase == U_TRACE_RECORDER_PHASE_INSTANT) {
+				fputs(",\"s\":\"t\"", file);
+			}
+			fputc('}', file);
+
+			first = false;
+			count++;
+		}
+	}
+
+	fputs("\n]}\n", file);
+
+	return count;
+}
+
+
+/*
+ *
+ * Signal handling.
+ *
+ */
+
+#if defined(XRT_OS_LINUX)
+
+static sem_t g_signal_sem;
+
+static void
+signal_handler(int sig)
+{
+	(void)sig;
+
+	// One of the few things that are safe to do in a signal handler.
+	sem_post(&g_signal_sem);
+}
+
+static void
+signal_thread_run(void)
+{
+	while (true) {
+		if (sem_wait(&g_signal_sem) != 0) {
+			continue;
+		}
+
+		char path[1024];
+		uint32_t count = 0;
+		if (u_trace_recorder_dump(path, sizeof(path), &count) == 0) {
+			U_LOG_I("Wrote %" PRIu32 " trace events to '%s'", count, path);
+		}
+	}
+}
+
+static void
+install_signal_handler(void)
+{
+	struct sigaction old = {};
+	if (sigaction(SIGUSR2, nullptr, &old) != 0 || old.sa_handler != SIG_DFL) {
+		U_LOG_W("SIGUSR2 already handled, not dumping traces on it.");
+		return;
+	}
+
+	if (sem_init(&g_signal_sem, 0, 0) != 0) {
+		return;
+	}
+
+	// Dumps for the lifetime of the process.
+	std::thread(signal_thread_run).detach();
+
+	struct sigaction sa = {};
+	sa.sa_handler = signal_handler;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGUSR2, &sa, nullptr);
+}
+
+#else
+
+static void
+install_signal_handler(void)
+{
+	// Only dumping with monado-ctl on this platform.
+}
+
+#endif
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+static void
+init_once(void)
+{
+	if (!debug_get_bool_option_recorder()) {
+		return;
+	}
+
+	int64_t events = debug_get_num_option_recorder_events();
+	int64_t seconds = debug_get_num_option_recorder_seconds();
+	if (events < 16) {
+		events = 16;
+	}
+	if (seconds < 1) {
+		seconds = 1;
+	}
+
+	recorder *rec = new recorder();
+	rec->mask = round_up_pow2((uint64_t)events) - 1;
+	rec->window_ns = (uint64_t)seconds * U_TIME_1S_IN_NS;
+	g_recorder = rec;
+
+	install_signal_handler();
+
+	g_enabled.store(true, std::memory_order_release);
+}
+
+extern "C" void
+u_trace_recorder_init(void)
+{
+	std::call_once(g_once, init_once);
+}
+
+extern "C" bool
+u_trace_recorder_is_enabled(void)
+{
+	return g_enabled.load(std::memory_order_relaxed);
+}
+
+extern "C" void
+u_trace_recorder_event(const char *category, const char *name, enum u_trace_recorder_phase phase)
+{
+	if (!g_enabled.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	push(category, nullptr, os_monotonic_get_ns(), name, (char)phase);
+}
+
+extern "C" void
+u_trace_recorder_event_on_track(const char *category,
+                                const char *track,
+                                uint64_t timestamp_ns,
+                                const char *name,
+                                enum u_trace_recorder_phase phase)
+{
+	if (!g_enabled.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	push(category, track, timestamp_ns, name, (char)phase);
+}
+
+extern "C" void
+u_trace_recorder_set_thread_name(const char *name)
+{
+	if (!g_enabled.load(std::memory_order_acquire)) {
+		return;
+	}
+
+	ring *r = get_ring();
+
+	std::unique_lock<std::mutex> lock(r->name_mutex);
+	snprintf(r->name, sizeof(r->name), "%s", name);
+}
+
+extern "C" void
+u_trace_recorder_write(FILE *file, uint32_t *out_event_count)
+{
+	uint32_t count = 0;
+
+	if (g_enabled.load(std::memory_order_acquire)) {
+		std::unique_lock<std::mutex> lock(g_recorder->mutex);
+		count = write_locked(*g_recorder, file);
+	} else {
+		fputs("{\"traceEvents\":[]}\n", file);
+	}
+
+	if (out_event_count != nullptr) {
+		*out_event_count = count;
+	}
+}
+
+extern "C" int
+u_trace_recorder_dump(char *out_path, size_t out_path_size, uint32_t *out_event_count)
+{
+	if (!g_enabled.load(std::memory_order_acquire)) {
+		return -1;
+	}
+
+	recorder &rec = *g_recorder;
+	std::unique_lock<std::mutex> lock(rec.mutex);
+
+	char file_name[64];
+	snprintf(file_name, sizeof(file_name), "monado_trace_%" PRIu32 "_%" PRIu32 ".json", get_pid(),
+	         rec.dump_count++);
+
+	char path[1024];
+	ssize_t ret = u_file_get_path_in_runtime_dir(file_name, path, sizeof(path));
+	if (ret <= 0 || (size_t)ret >= sizeof(path)) {
+		U_LOG_E("Could not get path for trace file '%s'", file_name);
+		return -1;
+	}
+
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		U_LOG_E("Could not open trace file '%s'", path);
+		return -1;
+	}
+
+	uint32_t count = write_locked(rec, file);
+	fclose(file);
+
+	if (out_path != NULL && out_path_size > 0) {
+		snprintf(out_path, out_path_size, "%s", path);
+	}
+	if (out_event_count != NULL) {
+		*out_event_count = count;
+	}
+
+	return 0;
+}
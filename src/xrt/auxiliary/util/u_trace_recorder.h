@@ -0,0 +1,112 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Built-in ring buffer trace recorder, see @ref tracing-recorder.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+
+#include <stdio.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Kind of event, same values as the Chrome JSON trace format uses.
+ *
+ * @ingroup aux_util
+ */
+enum u_trace_recorder_phase
+{
+	U_TRACE_RECORDER_PHASE_BEGIN = 'B',
+	U_TRACE_RECORDER_PHASE_END = 'E',
+	U_TRACE_RECORDER_PHASE_INSTANT = 'i',
+};
+
+/*!
+ * Reads the options and, if enabled, starts recording. Called by
+ * @ref u_trace_marker_init when the built-in backend is used.
+ *
+ * @ingroup aux_util
+ */
+void
+u_trace_recorder_init(void);
+
+/*!
+ * Is the recorder recording events.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_trace_recorder_is_enabled(void);
+
+/*!
+ * Record an event on the calling thread, timestamped now. The strings are not
+ * copied, must be string literals or otherwise live forever, like `__func__`.
+ *
+ * @ingroup aux_util
+ */
+void
+u_trace_recorder_event(const char *category, const char *name, enum u_trace_recorder_phase phase);
+
+/*!
+ * Record an event with the given timestamp on a named track instead of the
+ * calling thread. Same string lifetime requirements as
+ * @ref u_trace_recorder_event, name may be NULL for end events.
+ *
+ * @ingroup aux_util
+ */
+void
+u_trace_recorder_event_on_track(const char *category,
+                                const char *track,
+                                uint64_t timestamp_ns,
+                                const char *name,
+                                enum u_trace_recorder_phase phase);
+
+/*!
+ * Name the calling thread in the trace, the string is copied.
+ *
+ * @ingroup aux_util
+ */
+void
+u_trace_recorder_set_thread_name(const char *name);
+
+/*!
+ * Write the last seconds of recorded events, from all threads, as Chrome JSON
+ * trace to the given file. Can be loaded in Perfetto UI or chrome://tracing.
+ *
+ * @param file            File to write to.
+ * @param out_event_count Number of events written, optional.
+ *
+ * @ingroup aux_util
+ */
+void
+u_trace_recorder_write(FILE *file, uint32_t *out_event_count);
+
+/*!
+ * Dump the trace to a new file in the runtime directory, see
+ * @ref u_trace_recorder_write.
+ *
+ * @param out_path        Written path, optional.
+ * @param out_path_size   Size of @p out_path.
+ * @param out_event_count Number of events written, optional.
+ *
+ * @return Zero on success, negative if not enabled or the file can't be written.
+ *
+ * @ingroup aux_util
+ */
+int
+u_trace_recorder_dump(char *out_path, size_t out_path_size, uint32_t *out_event_count);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -12,8 +12,10 @@
 
 #include <string>
 #include <sstream>
+#include <cassert>
 #include <vector>
 #include <unordered_map>
+#include <atomic>
 #include <mutex>
 
 
@@ -59,6 +61,9 @@ public:
 	bool on = false;
 	bool tested = false;
 
+	//! Number of GUIs or inspectors looking at the variables, read from hot paths.
+	std::atomic<int32_t> observers = {0};
+
 public:
 	uint32_t
 	getNumber(const std::string &name)
@@ -125,6 +130,34 @@ u_var_force_on(void)
 	gTracker.tested = true;
 }
 
+extern "C" bool
+u_var_is_observed(void)
+{
+	return gTracker.observers.load(std::memory_order_relaxed) > 0;
+}
+
+extern "C" void
+u_var_add_observer(void)
+{
+	if (!get_on()) {
+		return;
+	}
+
+	gTracker.observers.fetch_add(1, std::memory_order_relaxed);
+}
+
+extern "C" void
+u_var_remove_observer(void)
+{
+	if (!get_on()) {
+		return;
+	}
+
+	int32_t old = gTracker.observers.fetch_sub(1, std::memory_order_relaxed);
+	assert(old > 0);
+	(void)old;
+}
+
 extern "C" void
 u_var_add_root(void *root, const char *c_name, bool suffix_with_number)
 {
@@ -366,6 +366,36 @@ u_var_visit(u_var_root_cb enter_cb, u_var_root_cb exit_cb, u_var_elm_cb elem_cb,
 void
 u_var_force_on(void);
 
+/*!
+ * Is anything looking at the tracked variables, like a debug GUI. Cheap
+ * enough to call every frame, code should use it to skip work that only feeds
+ * variables, such as pushing debug frames or filling plot buffers. Always
+ * false when variable tracking is off.
+ *
+ * @ingroup aux_util
+ */
+bool
+u_var_is_observed(void);
+
+/*!
+ * Called by a debug GUI or inspector when it starts looking at the tracked
+ * variables, must be paired with @ref u_var_remove_observer. Any debug sinks
+ * should be hooked up after this call.
+ *
+ * @ingroup aux_util
+ */
+void
+u_var_add_observer(void);
+
+/*!
+ * Called by a debug GUI or inspector when it stops looking at the tracked
+ * variables, any debug sinks should be unhooked before this call.
+ *
+ * @ingroup aux_util
+ */
+void
+u_var_remove_observer(void);
+
 #define U_VAR_ADD_FUNCS()                                                                                              \
 	ADD_FUNC(bool, bool, BOOL)                                                                                     \
 	ADD_FUNC(rgb_u8, struct xrt_colour_rgb_u8, RGB_U8)                                                             \
@@ -11,6 +11,7 @@
 
 #include "xrt/xrt_config_os.h"
 #include "os/os_time.h"
+#include "util/u_debug.h"
 
 #if defined(XRT_DOXYGEN)
 
@@ -31,6 +32,19 @@
 #endif
 
 
+/*!
+ * Init a @ref os_precise_sleeper for use with @ref u_wait_until, turns on the
+ * hybrid sleep then spin mode if the `U_WAIT_HYBRID` env variable is set.
+ *
+ * @ingroup aux_util
+ */
+static inline void
+u_wait_sleeper_init(struct os_precise_sleeper *sleeper)
+{
+	os_precise_sleeper_init(sleeper);
+	sleeper->hybrid = debug_get_bool_option("U_WAIT_HYBRID", false);
+}
+
 /*!
  * Waits until the given time using the @ref os_precise_sleeper.
  *
@@ -49,6 +63,12 @@ u_wait_until(struct os_precise_sleeper *sleeper, uint64_t until_ns)
 		return;
 	}
 
+	// Learns the scheduler latency itself.
+	if (sleeper->hybrid) {
+		os_precise_sleeper_wait_until(sleeper, until_ns);
+		return;
+	}
+
 	// Sufficiently in the future.
 	uint32_t delay = (uint32_t)(until_ns - now_ns - U_WAIT_MEASURED_SCHEDULER_LATENCY_NS);
 	os_precise_sleeper_nanosleep(sleeper, delay);
@@ -11,6 +11,23 @@
 #include "util/u_worker.hpp"
 
 
+using namespace xrt::auxiliary::util;
+
+struct RangeChunk
+{
+	std::function<void(size_t, size_t)> const *func;
+	size_t begin;
+	size_t end;
+};
+
+static void
+range_chunk_callback(void *data_ptr)
+{
+	auto &chunk = *static_cast<RangeChunk *>(data_ptr);
+	(*chunk.func)(chunk.begin, chunk.end);
+}
+
+
 void
 xrt::auxiliary::util::TaskCollection::cCallback(void *data_ptr)
 {
@@ -18,3 +35,92 @@ xrt::auxiliary::util::TaskCollection::cCallback(void *data_ptr)
 	f();
 	f = nullptr;
 }
+
+void
+xrt::auxiliary::util::parallelFor(SharedThreadGroup const &stg,
+                                  size_t begin,
+                                  size_t end,
+                                  size_t grain,
+                                  std::function<void(size_t, size_t)> const &func)
+{
+	if (end <= begin) {
+		return;
+	}
+	if (grain == 0) {
+		grain = 1;
+	}
+
+	size_t count = (end - begin + grain - 1) / grain;
+	size_t last = begin + (count - 1) * grain;
+
+	// Only one chunk, no need to involve the pool.
+	if (count == 1) {
+		func(begin, end);
+		return;
+	}
+
+	std::vector<RangeChunk> chunks(count - 1);
+	for (size_t i = 0; i < chunks.size(); i++) {
+		chunks[i].func = &func;
+		chunks[i].begin = begin + i * grain;
+		chunks[i].end = chunks[i].begin + grain;
+		u_worker_group_push(stg.mGroup, range_chunk_callback, &chunks[i]);
+	}
+
+	func(last, end);
+
+	u_worker_group_wait_all(stg.mGroup);
+}
+
+TaskGraph::Id
+TaskGraph::add(Functor func, std::vector<Id> const &dependencies)
+{
+	Id id = mNodes.size();
+
+	auto node = std::make_unique<Node>();
+	node->graph = this;
+	node->func = std::move(func);
+
+	for (Id dep : dependencies) {
+		assert(dep < id);
+		mNodes[dep]->dependents.push_back(id);
+		node->dependency_count++;
+	}
+
+	mNodes.push_back(std::move(node));
+
+	return id;
+}
+
+void
+TaskGraph::run()
+{
+	// Reset all before pushing anything, tasks start running right away.
+	for (auto &node : mNodes) {
+		node->remaining.store(node->dependency_count, std::memory_order_relaxed);
+	}
+
+	for (auto &node : mNodes) {
+		if (node->dependency_count == 0) {
+			u_worker_group_push(mGroup, &cCallback, node.get());
+		}
+	}
+
+	u_worker_group_wait_all(mGroup);
+}
+
+void
+TaskGraph::cCallback(void *data_ptr)
+{
+	auto &node = *static_cast<Node *>(data_ptr);
+	node.func();
+
+	for (Id id : node.dependents) {
+		Node &dependent = *node.graph->mNodes[id];
+
+		// The last dependency to finish pushes it, as a worker this goes on its own queue.
+		if (dependent.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			u_worker_group_push(node.graph->mGroup, &cCallback, &dependent);
+		}
+	}
+}
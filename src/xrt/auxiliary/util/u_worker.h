@@ -11,6 +11,7 @@
 #pragma once
 
 #include "xrt/xrt_defines.h"
+#include "util/u_thread_role.h"
 
 
 #ifdef __cplusplus
@@ -50,6 +51,19 @@ struct u_worker_thread_pool
 struct u_worker_thread_pool *
 u_worker_thread_pool_create(uint32_t starting_worker_count, uint32_t thread_count, const char *prefix);
 
+/*!
+ * Same as @ref u_worker_thread_pool_create but the worker threads apply the
+ * scheduling settings of the given role when they start, the plain version
+ * uses @ref U_THREAD_ROLE_BACKGROUND.
+ *
+ * @ingroup aux_util
+ */
+struct u_worker_thread_pool *
+u_worker_thread_pool_create_with_role(uint32_t starting_worker_count,
+                                      uint32_t thread_count,
+                                      const char *prefix,
+                                      enum u_thread_role role);
+
 /*!
  * Internal function, only called by reference.
  *
@@ -86,6 +100,32 @@ u_worker_thread_pool_reference(struct u_worker_thread_pool **dst, struct u_worke
 }
 
 
+/*!
+ * Get the process wide thread pool shared by the tracking code, it is created
+ * by the first caller with the thread count given by the
+ * `XRT_TRACKING_THREADS` environment variable. Sharing it keeps the threads of
+ * all trackers within one budget instead of each having their own pool.
+ *
+ * Each returned reference must be given back with
+ * @ref u_worker_thread_pool_put_tracking, not dropped with
+ * @ref u_worker_thread_pool_reference. The threads are stopped when the last
+ * user puts it back.
+ *
+ * @ingroup aux_util
+ */
+struct u_worker_thread_pool *
+u_worker_thread_pool_get_tracking(void);
+
+/*!
+ * Give back a pool gotten from @ref u_worker_thread_pool_get_tracking, sets
+ * @p uwtp_ptr to NULL.
+ *
+ * @ingroup aux_util
+ */
+void
+u_worker_thread_pool_put_tracking(struct u_worker_thread_pool **uwtp_ptr);
+
+
 /*
  *
  * Worker group.
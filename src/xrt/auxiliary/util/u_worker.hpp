@@ -12,6 +12,8 @@
 
 #include "util/u_worker.h"
 
+#include <atomic>
+#include <memory>
 #include <vector>
 #include <cassert>
 #include <functional>
@@ -20,6 +22,7 @@
 namespace xrt::auxiliary::util {
 
 class TaskCollection;
+class TaskGraph;
 class SharedThreadGroup;
 
 /*!
@@ -100,12 +103,28 @@ public:
 		mGroup = u_worker_group_create(stp.mPool);
 	}
 
+	/*!
+	 * Take a C worker group as argument, for C++ code that wants to use the
+	 * helpers below on a group it was given over C interfaces.
+	 */
+	explicit SharedThreadGroup(u_worker_group *uwg)
+	{
+		u_worker_group_reference(&mGroup, uwg);
+	}
+
 	~SharedThreadGroup()
 	{
 		u_worker_group_reference(&mGroup, nullptr);
 	}
 
 	friend TaskCollection;
+	friend TaskGraph;
+	friend void
+	parallelFor(SharedThreadGroup const &stg,
+	            size_t begin,
+	            size_t end,
+	            size_t grain,
+	            std::function<void(size_t, size_t)> const &func);
 
 	// No default constructor.
 	SharedThreadGroup() = delete;
@@ -183,6 +202,98 @@ public:
 	operator=(TaskCollection &&) = delete;
 
 
+private:
+	static void
+	cCallback(void *data_ptr);
+};
+
+/*!
+ * Splits the range [@p begin, @p end) into chunks of at most @p grain items
+ * and calls @p func with the begin and end of each chunk on the group. The
+ * calling thread runs the last chunk itself and then waits on the group, so
+ * any other tasks on the group are also waited on.
+ *
+ * @ingroup aux_util
+ */
+void
+parallelFor(SharedThreadGroup const &stg,
+            size_t begin,
+            size_t end,
+            size_t grain,
+            std::function<void(size_t, size_t)> const &func);
+
+/*!
+ * A small graph of tasks where each task can depend on earlier added tasks,
+ * a task is only pushed to the group once all tasks it depends on are done.
+ * Finishing tasks push their dependents from the worker thread directly, so
+ * there are no barriers between the stages of the graph.
+ *
+ * The graph can be run more than once, tasks can not be added while running.
+ *
+ * @ingroup aux_util
+ */
+class TaskGraph
+{
+public:
+	typedef std::function<void()> Functor;
+	typedef size_t Id;
+
+
+private:
+	struct Node
+	{
+		TaskGraph *graph = nullptr;
+		Functor func = {};
+
+		//! Tasks that depend on this one.
+		std::vector<Id> dependents = {};
+
+		//! Number of tasks this one depends on.
+		uint32_t dependency_count = 0;
+
+		//! Dependencies left before this task can be pushed, reset by run.
+		std::atomic<uint32_t> remaining = {0};
+	};
+
+	std::vector<std::unique_ptr<Node>> mNodes = {};
+	u_worker_group *mGroup = nullptr;
+
+
+public:
+	TaskGraph(SharedThreadGroup const &stg)
+	{
+		u_worker_group_reference(&mGroup, stg.mGroup);
+	}
+
+	~TaskGraph()
+	{
+		u_worker_group_reference(&mGroup, nullptr);
+	}
+
+	/*!
+	 * Add a task that runs after all tasks in @p dependencies are done, the
+	 * dependencies must have been added before it, which rules out cycles.
+	 */
+	Id
+	add(Functor func, std::vector<Id> const &dependencies = {});
+
+	/*!
+	 * Runs all tasks in the graph and waits for them, and any other tasks on
+	 * the same group, to complete.
+	 */
+	void
+	run();
+
+
+	// Do not move or copy the task graph.
+	TaskGraph(TaskGraph const &) = delete;
+	TaskGraph(TaskGraph &&) = delete;
+	TaskGraph &
+	operator=(TaskGraph const &) = delete;
+	TaskGraph &
+	operator=(TaskGraph &&) = delete;
+
+
 private:
 	static void
 	cCallback(void *data_ptr);
@@ -0,0 +1,791 @@
+// Copyright 2022-2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Work stealing worker pool.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ *
+ * Each worker thread has its own Chase-Lev deque, tasks pushed from a worker
+ * thread go onto its deque without taking any lock, idle workers steal from
+ * the other deques. Tasks pushed from other threads go into a small injection
+ * queue that workers move tasks out of in batches. Threads waiting on a group
+ * run the tasks of that group that are still queued before giving up their
+ * thread to the pool and going to sleep.
+ *
+ * @ingroup aux_util
+ */
+
+#include "os/os_threading.h"
+
+#include "util/u_misc.h"
+#include "util/u_debug.h"
+#include "util/u_logging.h"
+#include "util/u_worker.h"
+#include "util/u_thread_role.h"
+#include "util/u_trace_marker.h"
+
+#include <atomic>
+#include <mutex>
+#include <assert.h>
+#include <stdio.h>
+
+
+#define MAX_THREAD_COUNT (16)
+
+DEBUG_GET_ONCE_NUM_OPTION(tracking_threads, "XRT_TRACKING_THREADS", 4)
+
+//! Must be a power of two.
+#define DEQUE_SIZE (256)
+
+//! Tasks pushed from non-worker threads that can be queued in the pool.
+#define MAX_INJECT_COUNT (256)
+
+//! Max number of tasks a worker moves from the injection queue at a time.
+#define INJECT_BATCH_COUNT (8)
+
+struct group;
+struct pool;
+
+struct task
+{
+	//! Group this task was submitted from.
+	struct group *g;
+
+	//! Function.
+	u_worker_group_func_t func;
+
+	//! Function data.
+	void *data;
+};
+
+/*!
+ * A slot in a deque, the fields are atomic since a thief may read a slot at
+ * the same time as the owner writes it, in which case the thief will fail to
+ * claim it and throw the read away.
+ */
+struct deque_slot
+{
+	std::atomic<struct group *> g;
+	std::atomic<u_worker_group_func_t> func;
+	std::atomic<void *> data;
+};
+
+/*!
+ * Fixed size Chase-Lev deque, only the owning thread pushes and pops at the
+ * bottom, any thread can steal from the top.
+ */
+struct deque
+{
+	std::atomic<int64_t> top;
+	std::atomic<int64_t> bottom;
+
+	struct deque_slot slots[DEQUE_SIZE];
+};
+
+struct thread
+{
+	//! Pool this thread belongs to.
+	struct pool *p;
+
+	//! Index of the thread, used to spread out stealing.
+	uint32_t index;
+
+	//! Tasks pushed from this thread.
+	struct deque deque;
+
+	// Native thread.
+	struct os_thread thread;
+
+	//! Thread name.
+	char name[64];
+};
+
+struct pool
+{
+	struct u_worker_thread_pool base;
+
+	//! Only protects sleeping and waking up workers.
+	struct os_mutex mutex;
+
+	//! Idle workers wait on this.
+	struct os_cond cond;
+
+	//! Number of workers waiting on the cond.
+	std::atomic<uint32_t> sleeping_count;
+
+	//! Number of tasks queued in deques and the injection queue.
+	std::atomic<int64_t> queued_count;
+
+	//! Number of workers currently allowed to run tasks.
+	std::atomic<uint32_t> active_count;
+
+	//! Currently the number of workers that can work, waiting increases this.
+	std::atomic<uint32_t> worker_limit;
+
+	//! Given at creation.
+	uint32_t initial_worker_limit;
+
+	struct
+	{
+		//! Protects the injection queue.
+		struct os_mutex mutex;
+
+		//! Ring of tasks pushed from non-worker threads.
+		struct task tasks[MAX_INJECT_COUNT];
+
+		//! Logical index of the oldest task.
+		uint64_t head;
+
+		//! Logical index one past the newest task.
+		uint64_t tail;
+	} inject;
+
+	//! Number of created threads.
+	uint32_t thread_count;
+
+	//! The worker threads.
+	struct thread threads[MAX_THREAD_COUNT];
+
+	//! Is the pool up and running?
+	std::atomic<bool> running;
+
+	//! Prefix to use for thread names.
+	char prefix[32];
+
+	//! Scheduling role applied to all worker threads.
+	enum u_thread_role role;
+};
+
+struct group
+{
+	//! Base struct has to come first.
+	struct u_worker_group base;
+
+	//! Pointer to poll of threads.
+	struct u_worker_thread_pool *uwtp;
+
+	//! Protects the fields below.
+	struct os_mutex mutex;
+
+	//! Number of tasks that is pending or being worked on in this group.
+	size_t current_submitted_tasks_count;
+
+	struct
+	{
+		size_t count;
+		struct os_cond cond;
+	} waiting; //!< For wait_all
+};
+
+//! The worker thread the calling thread is, if any.
+static thread_local struct thread *t_current = nullptr;
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static inline struct group *
+group(struct u_worker_group *uwg)
+{
+	return (struct group *)uwg;
+}
+
+static inline struct pool *
+pool(struct u_worker_thread_pool *uwtp)
+{
+	return (struct pool *)uwtp;
+}
+
+static inline struct thread *
+current_thread_in(struct pool *p)
+{
+	struct thread *t = t_current;
+	return t != nullptr && t->p == p ? t : nullptr;
+}
+
+
+/*
+ *
+ * Deque functions.
+ *
+ */
+
+static inline void
+slot_store(struct deque_slot *slot, const struct task *task)
+{
+	slot->g.store(task->g, std::memory_order_relaxed);
+	slot->func.store(task->func, std::memory_order_relaxed);
+	slot->data.store(task->data, std::memory_order_relaxed);
+}
+
+static inline void
+slot_load(const struct deque_slot *slot, struct task *out_task)
+{
+	out_task->g = slot->g.load(std::memory_order_relaxed);
+	out_task->func = slot->func.load(std::memory_order_relaxed);
+	out_task->data = slot->data.load(std::memory_order_relaxed);
+}
+
+//! Only called by the owning thread.
+static bool
+deque_push(struct deque *d, const struct task *task)
+{
+	int64_t b = d->bottom.load(std::memory_order_relaxed);
+	int64_t t = d->top.load(std::memory_order_acquire);
+	if (b - t >= DEQUE_SIZE) {
+		return false;
+	}
+
+	slot_store(&d->slots[b & (DEQUE_SIZE - 1)], task);
+	std::atomic_thread_fence(std::memory_order_release);
+	d->bottom.store(b + 1, std::memory_order_relaxed);
+
+	return true;
+}
+
+//! Only called by the owning thread.
+static bool
+deque_pop(struct deque *d, struct task *out_task)
+{
+	int64_t b = d->bottom.load(std::memory_order_relaxed) - 1;
+	d->bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = d->top.load(std::memory_order_relaxed);
+
+	if (t > b) {
+		// Empty.
+		d->bottom.store(b + 1, std::memory_order_relaxed);
+		return false;
+	}
+
+	slot_load(&d->slots[b & (DEQUE_SIZE - 1)], out_task);
+	if (t < b) {
+		return true;
+	}
+
+	// Last task, race any thieves for it.
+	bool won = d->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	d->bottom.store(b + 1, std::memory_order_relaxed);
+
+	return won;
+}
+
+//! Can be called by any thread.
+static bool
+deque_steal(struct deque *d, struct task *out_task)
+{
+	int64_t t = d->top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b = d->bottom.load(std::memory_order_acquire);
+
+	if (t >= b) {
+		return false;
+	}
+
+	slot_load(&d->slots[t & (DEQUE_SIZE - 1)], out_task);
+
+	return d->top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+
+/*
+ *
+ * Internal pool functions.
+ *
+ */
+
+static void
+pool_wake_worker(struct pool *p)
+{
+	if (p->sleeping_count.load() == 0) {
+		return;
+	}
+
+	os_mutex_lock(&p->mutex);
+	os_cond_signal(&p->cond);
+	os_mutex_unlock(&p->mutex);
+}
+
+static bool
+pool_inject_push(struct pool *p, const struct task *task)
+{
+	os_mutex_lock(&p->inject.mutex);
+
+	bool pushed = p->inject.tail - p->inject.head < MAX_INJECT_COUNT;
+	if (pushed) {
+		p->inject.tasks[p->inject.tail++ % MAX_INJECT_COUNT] = *task;
+	}
+
+	os_mutex_unlock(&p->inject.mutex);
+
+	return pushed;
+}
+
+/*!
+ * Takes up to @p max_count tasks from the injection queue, returns how many
+ * were taken.
+ */
+static uint32_t
+pool_inject_take(struct pool *p, struct task *out_tasks, uint32_t max_count)
+{
+	os_mutex_lock(&p->inject.mutex);
+
+	// Leave some for the other workers.
+	uint64_t available = p->inject.tail - p->inject.head;
+	uint64_t count = (available + 1) / 2;
+	if (count > max_count) {
+		count = max_count;
+	}
+
+	for (uint64_t i = 0; i < count; i++) {
+		out_tasks[i] = p->inject.tasks[p->inject.head++ % MAX_INJECT_COUNT];
+	}
+
+	os_mutex_unlock(&p->inject.mutex);
+
+	return (uint32_t)count;
+}
+
+//! Takes one task belonging to @p g from the injection queue, order is not kept.
+static bool
+pool_inject_take_group(struct pool *p, struct group *g, struct task *out_task)
+{
+	bool found = false;
+
+	os_mutex_lock(&p->inject.mutex);
+
+	for (uint64_t i = p->inject.head; i < p->inject.tail; i++) {
+		struct task *task = &p->inject.tasks[i % MAX_INJECT_COUNT];
+		if (task->g != g) {
+			continue;
+		}
+
+		// Move the oldest task into the hole.
+		*out_task = *task;
+		*task = p->inject.tasks[p->inject.head++ % MAX_INJECT_COUNT];
+		found = true;
+		break;
+	}
+
+	os_mutex_unlock(&p->inject.mutex);
+
+	return found;
+}
+
+//! Only called from worker threads.
+static bool
+pool_find_task(struct pool *p, struct thread *t, struct task *out_task)
+{
+	// Newest task first from our own deque, that is still hot in the cache.
+	if (deque_pop(&t->deque, out_task)) {
+		p->queued_count--;
+		return true;
+	}
+
+	// Then move a batch over from the injection queue.
+	struct task tasks[INJECT_BATCH_COUNT];
+	uint32_t count = pool_inject_take(p, tasks, INJECT_BATCH_COUNT);
+	if (count > 0) {
+		for (uint32_t i = 1; i < count; i++) {
+			// There is always room as we just emptied the deque, but be safe.
+			if (!deque_push(&t->deque, &tasks[i]) && !pool_inject_push(p, &tasks[i])) {
+				assert(false);
+			}
+		}
+
+		// Others can steal the rest now.
+		if (count > 1) {
+			pool_wake_worker(p);
+		}
+
+		*out_task = tasks[0];
+		p->queued_count--;
+		return true;
+	}
+
+	// Lastly steal from the other workers.
+	uint32_t start = t->index + 1;
+	for (uint32_t i = 0; i < p->thread_count; i++) {
+		struct thread *other = &p->threads[(start + i) % p->thread_count];
+		if (other == t) {
+			continue;
+		}
+
+		if (deque_steal(&other->deque, out_task)) {
+			p->queued_count--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void
+pool_run_task(struct pool *p, const struct task *task)
+{
+	struct group *g = task->g;
+
+	task->func(task->data);
+
+	// Nothing may touch the group after the unlock, it might be destroyed.
+	os_mutex_lock(&g->mutex);
+
+	assert(g->current_submitted_tasks_count > 0);
+	g->current_submitted_tasks_count--;
+
+	if (g->current_submitted_tasks_count == 0 && g->waiting.count > 0) {
+		os_cond_broadcast(&g->waiting.cond);
+	}
+
+	os_mutex_unlock(&g->mutex);
+}
+
+
+/*
+ *
+ * Thread internal functions.
+ *
+ */
+
+static bool
+thread_try_become_active(struct pool *p)
+{
+	uint32_t active = p->active_count.load();
+	while (active < p->worker_limit.load()) {
+		if (p->active_count.compare_exchange_weak(active, active + 1)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void
+thread_wait_for_work(struct pool *p)
+{
+	os_mutex_lock(&p->mutex);
+
+	// Pairs with the push incrementing the queued count and then checking this.
+	p->sleeping_count++;
+
+	bool no_work = p->queued_count.load() <= 0;
+	bool at_limit = p->active_count.load() >= p->worker_limit.load();
+	if (p->running.load() && (no_work || at_limit)) {
+		os_cond_wait(&p->cond, &p->mutex);
+	}
+
+	p->sleeping_count--;
+
+	os_mutex_unlock(&p->mutex);
+}
+
+static void *
+run_func(void *ptr)
+{
+	struct thread *t = (struct thread *)ptr;
+	struct pool *p = t->p;
+
+	snprintf(t->name, sizeof(t->name), "%s: Worker", p->prefix);
+	U_TRACE_SET_THREAD_NAME(t->name);
+	u_thread_role_apply_to_current_thread(p->role, t->name);
+
+	t_current = t;
+
+	while (p->running.load()) {
+		if (thread_try_become_active(p)) {
+			struct task task;
+			while (pool_find_task(p, t, &task)) {
+				pool_run_task(p, &task);
+			}
+
+			p->active_count--;
+		}
+
+		thread_wait_for_work(p);
+	}
+
+	// Make sure all threads are woken up.
+	os_mutex_lock(&p->mutex);
+	os_cond_broadcast(&p->cond);
+	os_mutex_unlock(&p->mutex);
+
+	t_current = nullptr;
+
+	return NULL;
+}
+
+
+/*
+ *
+ * 'Exported' thread pool functions.
+ *
+ */
+
+extern "C" struct u_worker_thread_pool *
+u_worker_thread_pool_create(uint32_t starting_worker_count, uint32_t thread_count, const char *prefix)
+{
+	return u_worker_thread_pool_create_with_role(starting_worker_count, thread_count, prefix,
+	                                             U_THREAD_ROLE_BACKGROUND);
+}
+
+extern "C" struct u_worker_thread_pool *
+u_worker_thread_pool_create_with_role(uint32_t starting_worker_count,
+                                      uint32_t thread_count,
+                                      const char *prefix,
+                                      enum u_thread_role role)
+{
+	XRT_TRACE_MARKER();
+	int ret;
+
+	assert(starting_worker_count <= thread_count);
+	if (starting_worker_count > thread_count) {
+		return NULL;
+	}
+
+	assert(thread_count <= MAX_THREAD_COUNT);
+	if (thread_count > MAX_THREAD_COUNT) {
+		return NULL;
+	}
+
+	struct pool *p = new struct pool();
+	p->base.reference.count = 1;
+	p->initial_worker_limit = starting_worker_count;
+	p->worker_limit = starting_worker_count;
+	p->thread_count = thread_count;
+	p->running = true;
+	p->role = role;
+	snprintf(p->prefix, sizeof(p->prefix), "%s", prefix);
+
+	ret = os_mutex_init(&p->mutex);
+	if (ret != 0) {
+		goto err_alloc;
+	}
+
+	ret = os_cond_init(&p->cond);
+	if (ret != 0) {
+		goto err_mutex;
+	}
+
+	ret = os_mutex_init(&p->inject.mutex);
+	if (ret != 0) {
+		goto err_cond;
+	}
+
+	for (uint32_t i = 0; i < thread_count; i++) {
+		p->threads[i].p = p;
+		p->threads[i].index = i;
+		os_thread_init(&p->threads[i].thread);
+		os_thread_start(&p->threads[i].thread, run_func, &p->threads[i]);
+	}
+
+	return (struct u_worker_thread_pool *)p;
+
+
+err_cond:
+	os_cond_destroy(&p->cond);
+
+err_mutex:
+	os_mutex_destroy(&p->mutex);
+
+err_alloc:
+	delete p;
+
+	return NULL;
+}
+
+extern "C" void
+u_worker_thread_pool_destroy(struct u_worker_thread_pool *uwtp)
+{
+	XRT_TRACE_MARKER();
+
+	struct pool *p = pool(uwtp);
+
+	os_mutex_lock(&p->mutex);
+	p->running = false;
+	os_cond_broadcast(&p->cond);
+	os_mutex_unlock(&p->mutex);
+
+	// Wait for all threads.
+	for (uint32_t i = 0; i < p->thread_count; i++) {
+		os_thread_join(&p->threads[i].thread);
+		os_thread_destroy(&p->threads[i].thread);
+	}
+
+	os_mutex_destroy(&p->inject.mutex);
+	os_mutex_destroy(&p->mutex);
+	os_cond_destroy(&p->cond);
+
+	delete p;
+}
+
+
+/*
+ *
+ * 'Exported' shared tracking pool functions.
+ *
+ */
+
+static std::mutex tracking_mutex;
+static struct u_worker_thread_pool *tracking_pool = NULL;
+static uint32_t tracking_user_count = 0;
+
+extern "C" struct u_worker_thread_pool *
+u_worker_thread_pool_get_tracking(void)
+{
+	std::unique_lock<std::mutex> lock(tracking_mutex);
+
+	if (tracking_pool == NULL) {
+		int64_t option = debug_get_num_option_tracking_threads();
+		uint32_t count = (uint32_t)(option < 1 ? 1 : option > MAX_THREAD_COUNT ? MAX_THREAD_COUNT : option);
+
+		// The threads waiting on groups make up for the one less worker.
+		uint32_t starting = count > 1 ? count - 1 : 1;
+		tracking_pool =
+		    u_worker_thread_pool_create_with_role(starting, count, "Tracking", U_THREAD_ROLE_TRACKING);
+		if (tracking_pool == NULL) {
+			return NULL;
+		}
+	}
+
+	struct u_worker_thread_pool *ret = NULL;
+	u_worker_thread_pool_reference(&ret, tracking_pool);
+	tracking_user_count++;
+
+	return ret;
+}
+
+extern "C" void
+u_worker_thread_pool_put_tracking(struct u_worker_thread_pool **uwtp_ptr)
+{
+	if (*uwtp_ptr == NULL) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(tracking_mutex);
+
+	assert(*uwtp_ptr == tracking_pool);
+	assert(tracking_user_count > 0);
+
+	u_worker_thread_pool_reference(uwtp_ptr, NULL);
+
+	// The last user also drops the reference held here, stopping the threads.
+	if (--tracking_user_count == 0) {
+		u_worker_thread_pool_reference(&tracking_pool, NULL);
+	}
+}
+
+
+/*
+ *
+ * 'Exported' group functions.
+ *
+ */
+
+extern "C" struct u_worker_group *
+u_worker_group_create(struct u_worker_thread_pool *uwtp)
+{
+	XRT_TRACE_MARKER();
+
+	struct group *g = U_TYPED_CALLOC(struct group);
+	g->base.reference.count = 1;
+	u_worker_thread_pool_reference(&g->uwtp, uwtp);
+
+	os_mutex_init(&g->mutex);
+	os_cond_init(&g->waiting.cond);
+
+	return (struct u_worker_group *)g;
+}
+
+extern "C" void
+u_worker_group_push(struct u_worker_group *uwg, u_worker_group_func_t f, void *data)
+{
+	XRT_TRACE_MARKER();
+
+	struct group *g = group(uwg);
+	struct pool *p = pool(g->uwtp);
+	struct task task = {g, f, data};
+
+	os_mutex_lock(&g->mutex);
+	g->current_submitted_tasks_count++;
+	os_mutex_unlock(&g->mutex);
+
+	// Counted before it is visible so it never goes below zero for long.
+	p->queued_count++;
+
+	struct thread *t = current_thread_in(p);
+	bool queued = (t != nullptr && deque_push(&t->deque, &task)) || pool_inject_push(p, &task);
+	if (!queued) {
+		// Everything is full, do the work here instead of blocking.
+		p->queued_count--;
+		pool_run_task(p, &task);
+		return;
+	}
+
+	pool_wake_worker(p);
+}
+
+extern "C" void
+u_worker_group_wait_all(struct u_worker_group *uwg)
+{
+	XRT_TRACE_MARKER();
+
+	struct group *g = group(uwg);
+	struct pool *p = pool(g->uwtp);
+	struct thread *t = current_thread_in(p);
+
+	while (true) {
+		// Done when all tasks have been started and completed.
+		os_mutex_lock(&g->mutex);
+		bool done = g->current_submitted_tasks_count == 0;
+		os_mutex_unlock(&g->mutex);
+		if (done) {
+			return;
+		}
+
+		// Help out, worker threads can run anything while others stick to the group.
+		struct task task;
+		bool found = t != nullptr ? pool_find_task(p, t, &task) : pool_inject_take_group(p, g, &task);
+		if (found) {
+			if (t == nullptr) {
+				p->queued_count--;
+			}
+			pool_run_task(p, &task);
+			continue;
+		}
+
+		os_mutex_lock(&g->mutex);
+		if (g->current_submitted_tasks_count > 0) {
+			// Nothing to help with, "donate" this thread to the pool while waiting.
+			p->worker_limit++;
+			pool_wake_worker(p);
+
+			g->waiting.count++;
+			os_cond_wait(&g->waiting.cond, &g->mutex);
+			g->waiting.count--;
+
+			p->worker_limit--;
+		}
+		os_mutex_unlock(&g->mutex);
+	}
+}
+
+extern "C" void
+u_worker_group_destroy(struct u_worker_group *uwg)
+{
+	XRT_TRACE_MARKER();
+
+	struct group *g = group(uwg);
+	assert(g->base.reference.count == 0);
+
+	u_worker_group_wait_all(uwg);
+
+	u_worker_thread_pool_reference(&g->uwtp, NULL);
+
+	os_mutex_destroy(&g->mutex);
+	os_cond_destroy(&g->waiting.cond);
+
+	free(uwg);
+}
@@ -260,6 +260,26 @@ fill_in_device_features(struct vk_bundle *vk)
 	free(props);
 }
 
+static void
+fill_in_format_cache(struct vk_bundle *vk)
+{
+	static const VkFormat formats[] = {
+#define ENTRY(FORMAT) VK_FORMAT_##FORMAT,
+	    VK_CSCI_FORMATS(ENTRY, ENTRY, ENTRY, ENTRY)
+#undef ENTRY
+	};
+
+	static_assert(ARRAY_SIZE(formats) <= VK_FORMAT_CACHE_SIZE, "Format cache is too small");
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(formats); i++) {
+		VkFormatProperties *props = &vk->format_cache.properties[i];
+		vk->vkGetPhysicalDeviceFormatProperties(vk->physical_device, formats[i], props);
+		vk->format_cache.formats[i] = formats[i];
+	}
+
+	vk->format_cache.count = ARRAY_SIZE(formats);
+}
+
 static void
 get_external_image_support(struct vk_bundle *vk,
                            bool depth,
@@ -669,6 +689,27 @@ err_free:
 	return VK_ERROR_INITIALIZATION_FAILED;
 }
 
+static uint32_t
+get_queue_family_queue_count(struct vk_bundle *vk, uint32_t queue_family_index)
+{
+	uint32_t queue_family_count = 0;
+	vk->vkGetPhysicalDeviceQueueFamilyProperties(vk->physical_device, &queue_family_count, NULL);
+
+	if (queue_family_index >= queue_family_count) {
+		return 0;
+	}
+
+	VkQueueFamilyProperties *queue_family_props = U_TYPED_ARRAY_CALLOC(VkQueueFamilyProperties, queue_family_count);
+
+	vk->vkGetPhysicalDeviceQueueFamilyProperties(vk->physical_device, &queue_family_count, queue_family_props);
+
+	uint32_t queue_count = queue_family_props[queue_family_index].queueCount;
+
+	free(queue_family_props);
+
+	return queue_count;
+}
+
 static VkResult
 find_queue_family(struct vk_bundle *vk, VkQueueFlags required_flags, uint32_t *out_queue_family)
 {
@@ -754,7 +795,9 @@ fill_in_has_device_extensions(struct vk_bundle *vk, struct u_string_list *ext_li
 	vk->has_EXT_display_control = false;
 	vk->has_EXT_external_memory_dma_buf = false;
 	vk->has_EXT_global_priority = false;
+	vk->has_EXT_image_compression_control = false;
 	vk->has_EXT_image_drm_format_modifier = false;
+	vk->has_EXT_memory_budget = false;
 	vk->has_EXT_robustness2 = false;
 	vk->has_GOOGLE_display_timing = false;
 
@@ -869,6 +912,13 @@ fill_in_has_device_extensions(struct vk_bundle *vk, struct u_string_list *ext_li
 		}
 #endif // defined(VK_EXT_global_priority)
 
+#if defined(VK_EXT_image_compression_control)
+		if (strcmp(ext, VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME) == 0) {
+			vk->has_EXT_image_compression_control = true;
+			continue;
+		}
+#endif // defined(VK_EXT_image_compression_control)
+
 #if defined(VK_EXT_image_drm_format_modifier)
 		if (strcmp(ext, VK_EXT_IMAGE_DRM_FORMAT_MODIFIER_EXTENSION_NAME) == 0) {
 			vk->has_EXT_image_drm_format_modifier = true;
@@ -876,6 +926,13 @@ fill_in_has_device_extensions(struct vk_bundle *vk, struct u_string_list *ext_li
 		}
 #endif // defined(VK_EXT_image_drm_format_modifier)
 
+#if defined(VK_EXT_memory_budget)
+		if (strcmp(ext, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) {
+			vk->has_EXT_memory_budget = true;
+			continue;
+		}
+#endif // defined(VK_EXT_memory_budget)
+
 #if defined(VK_EXT_robustness2)
 		if (strcmp(ext, VK_EXT_ROBUSTNESS_2_EXTENSION_NAME) == 0) {
 			vk->has_EXT_robustness2 = true;
@@ -1030,6 +1087,13 @@ filter_device_features(struct vk_bundle *vk,
 	};
 #endif
 
+#ifdef VK_EXT_image_compression_control
+	VkPhysicalDeviceImageCompressionControlFeaturesEXT image_compression_control_info = {
+	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_COMPRESSION_CONTROL_FEATURES_EXT,
+	    .pNext = NULL,
+	};
+#endif
+
 	VkPhysicalDeviceFeatures2 physical_device_features = {
 	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
 	    .pNext = NULL,
@@ -1056,6 +1120,13 @@ filter_device_features(struct vk_bundle *vk,
 	}
 #endif
 
+#ifdef VK_EXT_image_compression_control
+	if (vk->has_EXT_image_compression_control) {
+		append_to_pnext_chain((VkBaseInStructure *)&physical_device_features,
+		                      (VkBaseInStructure *)&image_compression_control_info);
+	}
+#endif
+
 	vk->vkGetPhysicalDeviceFeatures2( //
 	    physical_device,              // physicalDevice
 	    &physical_device_features);   // pFeatures
@@ -1079,6 +1150,10 @@ filter_device_features(struct vk_bundle *vk,
 	CHECK(synchronization_2, synchronization_2_info.synchronization2);
 #endif
 
+#ifdef VK_EXT_image_compression_control
+	CHECK(image_compression_control, image_compression_control_info.imageCompressionControl);
+#endif
+
 	CHECK(shader_image_gather_extended, physical_device_features.features.shaderImageGatherExtended);
 
 	CHECK(shader_storage_image_write_without_format,
@@ -1093,12 +1168,14 @@ filter_device_features(struct vk_bundle *vk,
 	         "\n\tshader_image_gather_extended: %i"
 	         "\n\tshader_storage_image_write_without_format: %i"
 	         "\n\ttimeline_semaphore: %i"
-	         "\n\tsynchronization_2: %i",                                //
+	         "\n\tsynchronization_2: %i"
+	         "\n\timage_compression_control: %i",                        //
 	         device_features->null_descriptor,                           //
 	         device_features->shader_image_gather_extended,              //
 	         device_features->shader_storage_image_write_without_format, //
 	         device_features->timeline_semaphore,                        //
-	         device_features->synchronization_2);
+	         device_features->synchronization_2,                         //
+	         device_features->image_compression_control);
 }
 
 
@@ -1119,6 +1196,7 @@ vk_create_device(struct vk_bundle *vk,
                  int forced_index,
                  bool only_compute,
                  VkQueueGlobalPriorityEXT global_priority,
+                 bool async_queue,
                  struct u_string_list *required_device_ext_list,
                  struct u_string_list *optional_device_ext_list,
                  const struct vk_device_features *optional_device_features)
@@ -1145,6 +1223,7 @@ vk_create_device(struct vk_bundle *vk,
 	filter_device_features(vk, vk->physical_device, optional_device_features, &device_features);
 	vk->features.timeline_semaphore = device_features.timeline_semaphore;
 	vk->features.synchronization_2 = device_features.synchronization_2;
+	vk->features.image_compression_control = device_features.image_compression_control;
 
 
 	/*
@@ -1178,12 +1257,20 @@ vk_create_device(struct vk_bundle *vk,
 	VkDeviceQueueCreateInfo queue_create_info[2] = {0};
 	uint32_t queue_create_info_count = 1;
 
+	/*
+	 * The async queue goes in the same family, so images does not need any
+	 * ownership transfers, only relative priority can be given to it as
+	 * the global priority is per family.
+	 */
+	const float main_and_async_queue_priorities[2] = {queue_priority, 1.0f};
+	bool create_async_queue = async_queue && get_queue_family_queue_count(vk, vk->queue_family_index) >= 2;
+
 	// Compute or Graphics queue
 	queue_create_info[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 	queue_create_info[0].pNext = NULL;
-	queue_create_info[0].queueCount = 1;
+	queue_create_info[0].queueCount = create_async_queue ? 2 : 1;
 	queue_create_info[0].queueFamilyIndex = vk->queue_family_index;
-	queue_create_info[0].pQueuePriorities = &queue_priority;
+	queue_create_info[0].pQueuePriorities = main_and_async_queue_priorities;
 
 #ifdef VK_KHR_video_encode_queue
 	// Video encode queue
@@ -1243,6 +1330,14 @@ vk_create_device(struct vk_bundle *vk,
 	};
 #endif
 
+#ifdef VK_EXT_image_compression_control
+	VkPhysicalDeviceImageCompressionControlFeaturesEXT image_compression_control_info = {
+	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_COMPRESSION_CONTROL_FEATURES_EXT,
+	    .pNext = NULL,
+	    .imageCompressionControl = device_features.image_compression_control,
+	};
+#endif
+
 	VkPhysicalDeviceFeatures enabled_features = {
 	    .shaderImageGatherExtended = device_features.shader_image_gather_extended,
 	    .shaderStorageImageWriteWithoutFormat = device_features.shader_storage_image_write_without_format,
@@ -1277,6 +1372,13 @@ vk_create_device(struct vk_bundle *vk,
 	}
 #endif
 
+#ifdef VK_EXT_image_compression_control
+	if (vk->has_EXT_image_compression_control) {
+		append_to_pnext_chain((VkBaseInStructure *)&device_create_info,
+		                      (VkBaseInStructure *)&image_compression_control_info);
+	}
+#endif
+
 	ret = vk->vkCreateDevice(vk->physical_device, &device_create_info, NULL, &vk->device);
 
 	u_string_list_destroy(&device_ext_list);
@@ -1292,6 +1394,9 @@ vk_create_device(struct vk_bundle *vk,
 	// Fill in the device features we are interested in.
 	fill_in_device_features(vk);
 
+	// Before anything that queries the formats.
+	fill_in_format_cache(vk);
+
 	// We fill in these here as we want to be sure we have selected the physical device fully.
 	fill_in_external_object_properties(vk);
 
@@ -1301,6 +1406,13 @@ vk_create_device(struct vk_bundle *vk,
 		goto err_destroy;
 	}
 	vk->vkGetDeviceQueue(vk->device, vk->queue_family_index, 0, &vk->queue);
+	vk->async_queue = VK_NULL_HANDLE;
+	vk->async_queue_index = 0;
+	if (create_async_queue) {
+		vk->async_queue_index = 1;
+		vk->vkGetDeviceQueue(vk->device, vk->queue_family_index, vk->async_queue_index, &vk->async_queue);
+		VK_DEBUG(vk, "Created async queue, family index %d", vk->queue_family_index);
+	}
 #if defined(VK_KHR_video_encode_queue)
 	if (vk->encode_queue_family_index != VK_QUEUE_FAMILY_IGNORED) {
 		vk->vkGetDeviceQueue(vk->device, vk->encode_queue_family_index, 0, &vk->encode_queue);
@@ -1326,12 +1438,17 @@ vk_init_mutex(struct vk_bundle *vk)
 	if (os_mutex_init(&vk->queue_mutex) < 0) {
 		return VK_ERROR_INITIALIZATION_FAILED;
 	}
+	if (vk_memory_budget_init(&vk->budget) < 0) {
+		os_mutex_destroy(&vk->queue_mutex);
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
 	return VK_SUCCESS;
 }
 
 VkResult
 vk_deinit_mutex(struct vk_bundle *vk)
 {
+	vk_memory_budget_fini(&vk->budget);
 	os_mutex_destroy(&vk->queue_mutex);
 	return VK_SUCCESS;
 }
@@ -1414,6 +1531,9 @@ vk_init_from_given(struct vk_bundle *vk,
 	// Fill in the device features we are interested in.
 	fill_in_device_features(vk);
 
+	// Before anything that queries the formats.
+	fill_in_format_cache(vk);
+
 	// Fill in external object properties.
 	fill_in_external_object_properties(vk);
 
@@ -79,11 +79,21 @@ err_buffer:
 
 XRT_CHECK_RESULT VkResult
 vk_cmd_submit_locked(struct vk_bundle *vk, uint32_t count, const VkSubmitInfo *infos, VkFence fence)
+{
+	return vk_cmd_submit_to_queue_locked(vk, vk->queue, count, infos, fence);
+}
+
+XRT_CHECK_RESULT VkResult
+vk_cmd_submit_to_queue_locked(struct vk_bundle *vk,
+                              VkQueue queue,
+                              uint32_t count,
+                              const VkSubmitInfo *infos,
+                              VkFence fence)
 {
 	VkResult ret;
 
 	os_mutex_lock(&vk->queue_mutex);
-	ret = vk->vkQueueSubmit(vk->queue, count, infos, fence);
+	ret = vk->vkQueueSubmit(queue, count, infos, fence);
 	os_mutex_unlock(&vk->queue_mutex);
 
 	if (ret != VK_SUCCESS) {
@@ -165,6 +165,22 @@ vk_cmd_create_and_begin_cmd_buffer_locked(struct vk_bundle *vk,
 XRT_CHECK_RESULT VkResult
 vk_cmd_submit_locked(struct vk_bundle *vk, uint32_t count, const VkSubmitInfo *infos, VkFence fence);
 
+/*!
+ * Same as @ref vk_cmd_submit_locked but submits to @p queue, which must be one
+ * of the queues in @p vk that is guarded by @ref vk_bundle::queue_mutex.
+ *
+ * @pre The look for the command pool must be held, or the code must
+ * ensure that only the calling thread is accessing the command pool.
+ *
+ * @ingroup aux_vk
+ */
+XRT_CHECK_RESULT VkResult
+vk_cmd_submit_to_queue_locked(struct vk_bundle *vk,
+                              VkQueue queue,
+                              uint32_t count,
+                              const VkSubmitInfo *infos,
+                              VkFence fence);
+
 /*!
  * A do everything command buffer submission function, the `_locked` suffix
  * refers to the command pool not the queue, the queue lock will be taken during
@@ -8,6 +8,8 @@
  * @ingroup aux_vk
  */
 
+#include "util/u_misc.h"
+
 #include "vk/vk_cmd.h"
 #include "vk/vk_cmd_pool.h"
 
@@ -26,6 +28,9 @@ vk_cmd_pool_init(struct vk_bundle *vk, struct vk_cmd_pool *pool, VkCommandPoolCr
 	XRT_MAYBE_UNUSED int iret = os_mutex_init(&pool->mutex);
 	assert(iret == 0);
 
+	// Not in ring mode unless vk_cmd_pool_init_ring sets it up.
+	U_ZERO(&pool->ring);
+
 	VkCommandPoolCreateInfo cmd_pool_info = {
 	    .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
 	    .flags = flags,
@@ -41,6 +46,56 @@ vk_cmd_pool_init(struct vk_bundle *vk, struct vk_cmd_pool *pool, VkCommandPoolCr
 	return ret;
 }
 
+XRT_CHECK_RESULT VkResult
+vk_cmd_pool_init_ring(struct vk_bundle *vk, struct vk_cmd_pool *pool, uint32_t size)
+{
+	VkResult ret;
+
+	assert(size > 0 && size <= VK_CMD_POOL_RING_MAX_SIZE);
+
+	ret = vk_cmd_pool_init(vk, pool, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+	if (ret != VK_SUCCESS) {
+		return ret;
+	}
+
+	VkCommandBufferAllocateInfo cmd_buffer_info = {
+	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+	    .commandPool = pool->pool,
+	    .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+	    .commandBufferCount = size,
+	};
+
+	ret = vk->vkAllocateCommandBuffers(vk->device, &cmd_buffer_info, pool->ring.cmd_buffers);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkAllocateCommandBuffers: %s", vk_result_string(ret));
+		vk_cmd_pool_destroy(vk, pool);
+		return ret;
+	}
+
+	// Signaled so the first wait on each command buffer returns directly.
+	VkFenceCreateInfo fence_info = {
+	    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+	    .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+	};
+
+	for (uint32_t i = 0; i < size; i++) {
+		ret = vk->vkCreateFence(vk->device, &fence_info, NULL, &pool->ring.fences[i]);
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vkCreateFence: %s", vk_result_string(ret));
+			vk_cmd_pool_destroy(vk, pool);
+			return ret;
+		}
+
+		// Only count the ones that are created, for destroy.
+		pool->ring.size = i + 1;
+	}
+
+	// So that the first begin uses index zero.
+	pool->ring.index = size - 1;
+
+	return VK_SUCCESS;
+}
+
 void
 vk_cmd_pool_destroy(struct vk_bundle *vk, struct vk_cmd_pool *pool)
 {
@@ -49,6 +104,19 @@ vk_cmd_pool_destroy(struct vk_bundle *vk, struct vk_cmd_pool *pool)
 		return;
 	}
 
+	if (pool->ring.size > 0) {
+		// Make sure nothing is using the command buffers.
+		vk->vkWaitForFences(vk->device, pool->ring.size, pool->ring.fences, VK_TRUE, UINT64_MAX);
+	}
+
+	for (uint32_t i = 0; i < pool->ring.size; i++) {
+		vk->vkDestroyFence(vk->device, pool->ring.fences[i], NULL);
+		pool->ring.fences[i] = VK_NULL_HANDLE;
+		pool->ring.cmd_buffers[i] = VK_NULL_HANDLE;
+	}
+	pool->ring.size = 0;
+
+	// Also frees any command buffers allocated from it.
 	vk->vkDestroyCommandPool(vk->device, pool->pool, NULL);
 	pool->pool = VK_NULL_HANDLE;
 
@@ -142,6 +210,110 @@ vk_cmd_pool_submit_cmd_buffer_locked(struct vk_bundle *vk, struct vk_cmd_pool *p
 	return ret;
 }
 
+XRT_CHECK_RESULT VkResult
+vk_cmd_pool_ring_begin_cmd_buffer(struct vk_bundle *vk,
+                                  struct vk_cmd_pool *pool,
+                                  VkCommandBufferUsageFlags flags,
+                                  VkCommandBuffer *out_cmd_buffer)
+{
+	VkResult ret;
+
+	assert(pool->ring.size > 0);
+
+	uint32_t index = (pool->ring.index + 1) % pool->ring.size;
+
+	// Wait for the last use of this command buffer.
+	ret = vk->vkWaitForFences(vk->device, 1, &pool->ring.fences[index], VK_TRUE, UINT64_MAX);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkWaitForFences: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	// The pool has the reset bit so begin implicitly resets the command buffer.
+	VkCommandBufferBeginInfo begin_info = {
+	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+	    .flags = flags,
+	};
+
+	ret = vk->vkBeginCommandBuffer(pool->ring.cmd_buffers[index], &begin_info);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkBeginCommandBuffer: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	pool->ring.index = index;
+	*out_cmd_buffer = pool->ring.cmd_buffers[index];
+
+	return VK_SUCCESS;
+}
+
+XRT_CHECK_RESULT VkResult
+vk_cmd_pool_ring_end_and_submit_cmd_buffer(struct vk_bundle *vk,
+                                           struct vk_cmd_pool *pool,
+                                           VkCommandBuffer cmd_buffer,
+                                           bool wait)
+{
+	VkResult ret;
+
+	uint32_t index = pool->ring.index;
+	VkFence fence = pool->ring.fences[index];
+
+	assert(pool->ring.size > 0);
+	assert(pool->ring.cmd_buffers[index] == cmd_buffer);
+
+	ret = vk->vkEndCommandBuffer(cmd_buffer);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkEndCommandBuffer: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	// Only reset once we know it will be submitted, or the next begin would hang.
+	ret = vk->vkResetFences(vk->device, 1, &fence);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkResetFences: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .commandBufferCount = 1,
+	    .pCommandBuffers = &cmd_buffer,
+	};
+
+	ret = vk_cmd_submit_locked(vk, 1, &submit_info, fence);
+	if (ret != VK_SUCCESS) {
+		/*
+		 * The fence is now unsignaled and will never be signaled, replace
+		 * it with a new signaled one so the ring can still be used.
+		 */
+		VK_ERROR(vk, "vk_cmd_submit_locked: %s", vk_result_string(ret));
+
+		VkFenceCreateInfo fence_info = {
+		    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+		    .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+		};
+
+		VkFence new_fence = VK_NULL_HANDLE;
+		if (vk->vkCreateFence(vk->device, &fence_info, NULL, &new_fence) == VK_SUCCESS) {
+			vk->vkDestroyFence(vk->device, fence, NULL);
+			pool->ring.fences[index] = new_fence;
+		}
+
+		return ret;
+	}
+
+	if (!wait) {
+		return VK_SUCCESS;
+	}
+
+	ret = vk->vkWaitForFences(vk->device, 1, &fence, VK_TRUE, UINT64_MAX);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkWaitForFences: %s", vk_result_string(ret));
+	}
+
+	return ret;
+}
+
 #ifdef VK_EXT_debug_utils
 XRT_CHECK_RESULT VkResult
 vk_cmd_pool_create_begin_insert_label_and_end_cmd_buffer_locked(struct vk_bundle *vk,
@@ -24,15 +24,41 @@ extern "C" {
  *
  */
 
+/*!
+ * Max number of command buffers in a ring mode pool.
+ *
+ * @ingroup aux_vk
+ */
+#define VK_CMD_POOL_RING_MAX_SIZE (4)
+
 /*!
  * Small helper to manage lock around a command pool.
  *
+ * Can also be put in ring mode with @ref vk_cmd_pool_init_ring, where a fixed
+ * set of command buffers is allocated up front and reused round robin, each
+ * guarded by its own fence. A ring mode pool is meant to be owned by a single
+ * thread, which can then record and submit without allocating anything or
+ * taking the pool lock.
+ *
  * @ingroup aux_vk
  */
 struct vk_cmd_pool
 {
 	VkCommandPool pool;
 	struct os_mutex mutex;
+
+	//! Only used in ring mode, size is zero otherwise.
+	struct
+	{
+		VkCommandBuffer cmd_buffers[VK_CMD_POOL_RING_MAX_SIZE];
+		VkFence fences[VK_CMD_POOL_RING_MAX_SIZE];
+
+		//! Number of command buffers and fences in the ring.
+		uint32_t size;
+
+		//! Index of the last handed out command buffer.
+		uint32_t index;
+	} ring;
 };
 
 
@@ -50,6 +76,15 @@ struct vk_cmd_pool
 XRT_CHECK_RESULT VkResult
 vk_cmd_pool_init(struct vk_bundle *vk, struct vk_cmd_pool *pool, VkCommandPoolCreateFlags flags);
 
+/*!
+ * Create a command buffer pool in ring mode, with @p size pre-allocated
+ * resettable command buffers and fences, see @ref vk_cmd_pool.
+ *
+ * @public @memberof vk_cmd_pool
+ */
+XRT_CHECK_RESULT VkResult
+vk_cmd_pool_init_ring(struct vk_bundle *vk, struct vk_cmd_pool *pool, uint32_t size);
+
 /*!
  * Destroy a command buffer pool, lock must not be held, externally
  * synchronizable with all other pool commands.
@@ -222,6 +257,36 @@ vk_cmd_pool_end_submit_wait_and_free_cmd_buffer(struct vk_bundle *vk,
 	return ret;
 }
 
+/*!
+ * Get the next command buffer from the ring and begin it, waits for the last
+ * submission of that command buffer to complete first. No lock is taken.
+ *
+ * @pre The pool was created with @ref vk_cmd_pool_init_ring and is only used
+ * from the calling thread.
+ *
+ * @public @memberof vk_cmd_pool
+ */
+XRT_CHECK_RESULT VkResult
+vk_cmd_pool_ring_begin_cmd_buffer(struct vk_bundle *vk,
+                                  struct vk_cmd_pool *pool,
+                                  VkCommandBufferUsageFlags flags,
+                                  VkCommandBuffer *out_cmd_buffer);
+
+/*!
+ * End and submit the command buffer returned from the last call to
+ * @ref vk_cmd_pool_ring_begin_cmd_buffer along with its fence, will take the
+ * queue mutex. Optionally waits for the commands to complete.
+ *
+ * @pre Same as @ref vk_cmd_pool_ring_begin_cmd_buffer.
+ *
+ * @public @memberof vk_cmd_pool
+ */
+XRT_CHECK_RESULT VkResult
+vk_cmd_pool_ring_end_and_submit_cmd_buffer(struct vk_bundle *vk,
+                                           struct vk_cmd_pool *pool,
+                                           VkCommandBuffer cmd_buffer,
+                                           bool wait);
+
 #ifdef VK_EXT_debug_utils
 /*!
  * Small helper function that creates a command buffer and begins it,
@@ -174,7 +174,7 @@ VkImageUsageFlags
 vk_csci_get_image_usage_flags(struct vk_bundle *vk, VkFormat format, enum xrt_swapchain_usage_bits bits)
 {
 	VkFormatProperties prop;
-	vk->vkGetPhysicalDeviceFormatProperties(vk->physical_device, format, &prop);
+	vk_get_format_properties(vk, format, &prop);
 
 	VkImageUsageFlags image_usage = 0;
 
@@ -769,6 +769,19 @@ xrt_swapchain_usage_flag_string(enum xrt_swapchain_usage_bits bits, bool null_on
  *
  */
 
+void
+vk_get_format_properties(struct vk_bundle *vk, VkFormat format, VkFormatProperties *out_properties)
+{
+	for (uint32_t i = 0; i < vk->format_cache.count; i++) {
+		if (vk->format_cache.formats[i] == format) {
+			*out_properties = vk->format_cache.properties[i];
+			return;
+		}
+	}
+
+	vk->vkGetPhysicalDeviceFormatProperties(vk->physical_device, format, out_properties);
+}
+
 bool
 vk_get_memory_type(struct vk_bundle *vk, uint32_t type_bits, VkMemoryPropertyFlags memory_props, uint32_t *out_type_id)
 {
@@ -27,6 +27,8 @@
 #include "util/u_string_list.h"
 #include "os/os_threading.h"
 
+#include "vk/vk_memory_budget.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -38,6 +40,9 @@ extern "C" {
  *
  */
 
+//! Size of @ref vk_bundle::format_cache, must fit all of @ref VK_CSCI_FORMATS.
+#define VK_FORMAT_CACHE_SIZE (32)
+
 /*!
  * A bundle of Vulkan functions and objects, used by both @ref comp and @ref
  * comp_client. Note that they both have different instances of the object, and
@@ -57,6 +62,16 @@ struct vk_bundle
 	uint32_t queue_family_index;
 	uint32_t queue_index;
 	VkQueue queue;
+
+	/*!
+	 * Optional second queue from the same family as @ref queue but created
+	 * with a higher queue priority, VK_NULL_HANDLE if not created. Used so
+	 * that the timewarp can run while longer work is still in flight on
+	 * @ref queue, shares @ref queue_mutex with @ref queue.
+	 */
+	VkQueue async_queue;
+	uint32_t async_queue_index;
+
 #if defined(VK_KHR_video_encode_queue)
 	uint32_t encode_queue_family_index;
 	uint32_t encode_queue_index;
@@ -65,6 +80,9 @@ struct vk_bundle
 
 	struct os_mutex queue_mutex;
 
+	//! Accounting of device memory allocated with this bundle.
+	struct vk_memory_budget budget;
+
 	struct
 	{
 #if defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_WIN32_HANDLE)
@@ -140,7 +158,9 @@ struct vk_bundle
 	bool has_EXT_display_control;
 	bool has_EXT_external_memory_dma_buf;
 	bool has_EXT_global_priority;
+	bool has_EXT_image_compression_control;
 	bool has_EXT_image_drm_format_modifier;
+	bool has_EXT_memory_budget;
 	bool has_EXT_robustness2;
 	bool has_GOOGLE_display_timing;
 	// end of GENERATED device extension code - do not modify - used by scripts
@@ -167,11 +187,26 @@ struct vk_bundle
 
 		//! Was synchronization2 requested, available, and enabled?
 		bool synchronization_2;
+
+		//! Was image compression control requested, available, and enabled?
+		bool image_compression_control;
 	} features;
 
 	//! Is the GPU a tegra device.
 	bool is_tegra;
 
+	/*!
+	 * Properties of the @ref VK_CSCI_FORMATS, queried once when the device
+	 * is set up since swapchain creation asks for them over and over. Read
+	 * only after that, see @ref vk_get_format_properties.
+	 */
+	struct
+	{
+		VkFormat formats[VK_FORMAT_CACHE_SIZE];
+		VkFormatProperties properties[VK_FORMAT_CACHE_SIZE];
+		uint32_t count;
+	} format_cache;
+
 
 	VkDebugReportCallbackEXT debug_report_cb;
 
@@ -196,6 +231,7 @@ struct vk_bundle
 	PFN_vkGetPhysicalDeviceProperties2 vkGetPhysicalDeviceProperties2;
 	PFN_vkGetPhysicalDeviceFeatures2 vkGetPhysicalDeviceFeatures2;
 	PFN_vkGetPhysicalDeviceMemoryProperties vkGetPhysicalDeviceMemoryProperties;
+	PFN_vkGetPhysicalDeviceMemoryProperties2 vkGetPhysicalDeviceMemoryProperties2;
 	PFN_vkGetPhysicalDeviceQueueFamilyProperties vkGetPhysicalDeviceQueueFamilyProperties;
 	PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR vkGetPhysicalDeviceSurfaceCapabilitiesKHR;
 	PFN_vkGetPhysicalDeviceSurfaceFormatsKHR vkGetPhysicalDeviceSurfaceFormatsKHR;
@@ -346,6 +382,7 @@ struct vk_bundle
 
 	PFN_vkCreatePipelineCache vkCreatePipelineCache;
 	PFN_vkDestroyPipelineCache vkDestroyPipelineCache;
+	PFN_vkGetPipelineCacheData vkGetPipelineCacheData;
 
 	PFN_vkResetDescriptorPool vkResetDescriptorPool;
 	PFN_vkCreateDescriptorPool vkCreateDescriptorPool;
@@ -994,10 +1031,13 @@ struct vk_device_features
 	bool null_descriptor;
 	bool timeline_semaphore;
 	bool synchronization_2;
+	bool image_compression_control;
 };
 
 /*!
- * Creates a VkDevice and initialises the VkQueue.
+ * Creates a VkDevice and initialises the VkQueue, if @p async_queue is true
+ * and the queue family has room for it @ref vk_bundle::async_queue is also
+ * created.
  *
  * @ingroup aux_vk
  */
@@ -1006,6 +1046,7 @@ vk_create_device(struct vk_bundle *vk,
                  int forced_index,
                  bool only_compute,
                  VkQueueGlobalPriorityEXT global_priority,
+                 bool async_queue,
                  struct u_string_list *required_device_ext_list,
                  struct u_string_list *optional_device_ext_list,
                  const struct vk_device_features *optional_device_features);
@@ -1013,7 +1054,8 @@ vk_create_device(struct vk_bundle *vk,
 /*!
  * @brief Initialize mutexes in the @ref vk_bundle.
  *
- * Not required for all uses, but a precondition for some.
+ * Not required for all uses, but a precondition for some, including the
+ * @ref vk_memory_budget accounting.
  *
  * @ingroup aux_vk
  */
@@ -1061,6 +1103,15 @@ vk_init_from_given(struct vk_bundle *vk,
 bool
 vk_get_memory_type(struct vk_bundle *vk, uint32_t type_bits, VkMemoryPropertyFlags memory_props, uint32_t *out_type_id);
 
+/*!
+ * Same as vkGetPhysicalDeviceFormatProperties, but uses
+ * @ref vk_bundle::format_cache when the format is in it.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_get_format_properties(struct vk_bundle *vk, VkFormat format, VkFormatProperties *out_properties);
+
 /*!
  * Allocate memory for an image and bind it to that image.
  *
@@ -1381,6 +1432,18 @@ vk_create_descriptor_set(struct vk_bundle *vk,
                          VkDescriptorSetLayout descriptor_layout,
                          VkDescriptorSet *out_descriptor_set);
 
+/*!
+ * Creates @p count descriptor sets all using the same layout, in one call.
+ *
+ * Does error logging.
+ */
+VkResult
+vk_create_descriptor_sets(struct vk_bundle *vk,
+                          VkDescriptorPool descriptor_pool,
+                          VkDescriptorSetLayout descriptor_layout,
+                          uint32_t count,
+                          VkDescriptorSet *out_descriptor_sets);
+
 /*!
  * Creates a pipeline layout from a single descriptor set layout.
  *
@@ -1399,6 +1462,25 @@ vk_create_pipeline_layout(struct vk_bundle *vk,
 VkResult
 vk_create_pipeline_cache(struct vk_bundle *vk, VkPipelineCache *out_pipeline_cache);
 
+/*!
+ * Creates a pipeline cache, seeded with the data saved by
+ * @ref vk_save_pipeline_cache if there is any for this device and driver.
+ * Falls back to an empty pipeline cache if the data is rejected.
+ *
+ * Does error logging, in vk_pipeline_cache.c.
+ */
+VkResult
+vk_create_pipeline_cache_from_disk(struct vk_bundle *vk, VkPipelineCache *out_pipeline_cache);
+
+/*!
+ * Saves the data of the pipeline cache to the user cache directory, the file
+ * is keyed on the vendor, device and pipeline cache UUID of the driver.
+ *
+ * Does error logging, in vk_pipeline_cache.c.
+ */
+void
+vk_save_pipeline_cache(struct vk_bundle *vk, VkPipelineCache pipeline_cache);
+
 /*!
  * Creates a compute pipeline, assumes entry function is called 'main'.
  *
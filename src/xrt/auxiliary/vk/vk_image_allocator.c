@@ -81,8 +81,24 @@ add_format_non_dup(struct format_list_helper *flh, VkFormat format)
 	flh->formats[flh->format_count++] = format;
 }
 
+#ifdef VK_EXT_image_compression_control
+static VkImageCompressionFlagsEXT
+get_image_compression_flags(enum vk_image_compression compression)
+{
+	switch (compression) {
+	case VK_IMAGE_COMPRESSION_MODE_FIXED_RATE: return VK_IMAGE_COMPRESSION_FIXED_RATE_DEFAULT_EXT;
+	case VK_IMAGE_COMPRESSION_MODE_DISABLED: return VK_IMAGE_COMPRESSION_DISABLED_EXT;
+	case VK_IMAGE_COMPRESSION_MODE_DEFAULT:
+	default: return VK_IMAGE_COMPRESSION_DEFAULT_EXT;
+	}
+}
+#endif
+
 static VkResult
-create_image(struct vk_bundle *vk, const struct xrt_swapchain_create_info *info, struct vk_image *out_image)
+create_image(struct vk_bundle *vk,
+             const struct xrt_swapchain_create_info *info,
+             enum vk_image_compression compression,
+             struct vk_image *out_image)
 {
 	// This is the format we allocate the image in, can be changed further down.
 	VkFormat image_format = (VkFormat)info->format;
@@ -220,6 +236,26 @@ create_image(struct vk_bundle *vk, const struct xrt_swapchain_create_info *info,
 	}
 #endif
 
+#if defined(VK_EXT_image_compression_control) && !defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_AHARDWAREBUFFER)
+	/*
+	 * The fixed-rate flags are only used with the explicit mode. On Android
+	 * the compression of a AHardwareBuffer is decided by gralloc when it is
+	 * allocated, so the image has to follow that and can't ask for any.
+	 */
+	VkImageCompressionControlEXT image_compression_control = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_COMPRESSION_CONTROL_EXT,
+	    .flags = get_image_compression_flags(compression),
+	    .compressionControlPlaneCount = 0,
+	    .pFixedRateFlags = NULL,
+	};
+
+	if (vk->features.image_compression_control && compression != VK_IMAGE_COMPRESSION_MODE_DEFAULT) {
+		CHAIN(image_compression_control);
+	}
+#else
+	(void)compression;
+#endif
+
 	if (info->face_count == 6) {
 		image_create_flags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
 	}
@@ -348,6 +384,16 @@ vk_ic_allocate(struct vk_bundle *vk,
                const struct xrt_swapchain_create_info *xscci,
                uint32_t image_count,
                struct vk_image_collection *out_vkic)
+{
+	return vk_ic_allocate_with_compression(vk, xscci, VK_IMAGE_COMPRESSION_MODE_DEFAULT, image_count, out_vkic);
+}
+
+VkResult
+vk_ic_allocate_with_compression(struct vk_bundle *vk,
+                                const struct xrt_swapchain_create_info *xscci,
+                                enum vk_image_compression compression,
+                                uint32_t image_count,
+                                struct vk_image_collection *out_vkic)
 {
 	VkResult ret = VK_SUCCESS;
 
@@ -359,7 +405,7 @@ vk_ic_allocate(struct vk_bundle *vk,
 
 	size_t i = 0;
 	for (; i < image_count; i++) {
-		ret = create_image(vk, xscci, &out_vkic->images[i]);
+		ret = create_image(vk, xscci, compression, &out_vkic->images[i]);
 		if (ret != VK_SUCCESS) {
 			break;
 		}
@@ -503,3 +549,14 @@ vk_ic_get_handles(struct vk_bundle *vk,
 
 	return ret;
 }
+
+const char *
+vk_image_compression_string(enum vk_image_compression compression)
+{
+	switch (compression) {
+	case VK_IMAGE_COMPRESSION_MODE_DEFAULT: return "default";
+	case VK_IMAGE_COMPRESSION_MODE_FIXED_RATE: return "fixed_rate";
+	case VK_IMAGE_COMPRESSION_MODE_DISABLED: return "disabled";
+	default: return "unknown";
+	}
+}
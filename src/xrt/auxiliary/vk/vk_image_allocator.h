@@ -24,6 +24,22 @@ extern "C" {
  * @{
  */
 
+/*!
+ * Compression to ask the driver for when allocating images, only has an effect
+ * if `VK_EXT_image_compression_control` is enabled on the @ref vk_bundle.
+ */
+enum vk_image_compression
+{
+	//! Leave it to the driver, which is lossless compression if any.
+	VK_IMAGE_COMPRESSION_MODE_DEFAULT,
+
+	//! Lossy fixed-rate compression, the driver picks the rate.
+	VK_IMAGE_COMPRESSION_MODE_FIXED_RATE,
+
+	//! No compression at all, mostly useful for debugging.
+	VK_IMAGE_COMPRESSION_MODE_DISABLED,
+};
+
 struct vk_image
 {
 	VkImage handle;
@@ -55,6 +71,23 @@ vk_ic_allocate(struct vk_bundle *vk,
                uint32_t image_count,
                struct vk_image_collection *out_vkic);
 
+/*!
+ * Same as @ref vk_ic_allocate but asks for @p compression, images shared with
+ * another process must use the default as the importer can't know about it.
+ */
+VkResult
+vk_ic_allocate_with_compression(struct vk_bundle *vk,
+                                const struct xrt_swapchain_create_info *xscci,
+                                enum vk_image_compression compression,
+                                uint32_t image_count,
+                                struct vk_image_collection *out_vkic);
+
+/*!
+ * Returns a string for the compression mode.
+ */
+const char *
+vk_image_compression_string(enum vk_image_compression compression);
+
 /*!
  * Imports and set images from the given FDs.
  */
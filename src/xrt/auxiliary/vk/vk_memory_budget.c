@@ -0,0 +1,271 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Device memory accounting and budget tracking.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_vk
+ */
+
+#include "util/u_debug.h"
+#include "util/u_misc.h"
+
+#include "vk/vk_helpers.h"
+#include "vk/vk_memory_budget.h"
+
+#include <assert.h>
+
+
+DEBUG_GET_ONCE_NUM_OPTION(budget_mb, "XRT_COMPOSITOR_VRAM_BUDGET_MB", 0)
+DEBUG_GET_ONCE_NUM_OPTION(high_percent, "XRT_COMPOSITOR_VRAM_HIGH_PERCENT", 85)
+DEBUG_GET_ONCE_NUM_OPTION(critical_percent, "XRT_COMPOSITOR_VRAM_CRITICAL_PERCENT", 95)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static uint64_t
+get_tracked_locked(struct vk_memory_budget *vmb)
+{
+	uint64_t total = 0;
+	for (uint32_t i = 0; i < VK_MEMORY_CATEGORY_COUNT; i++) {
+		total += vmb->category_bytes[i];
+	}
+
+	return total;
+}
+
+static void
+add_locked(struct vk_memory_budget *vmb, enum vk_memory_category category, VkDeviceSize size)
+{
+	vmb->category_bytes[category] += size;
+
+	uint64_t total = get_tracked_locked(vmb);
+	if (total > vmb->peak_bytes) {
+		vmb->peak_bytes = total;
+	}
+}
+
+static void
+remove_locked(struct vk_memory_budget *vmb, enum vk_memory_category category, VkDeviceSize size)
+{
+	// Don't wrap around if the books don't balance, it only makes things worse.
+	if (vmb->category_bytes[category] < size) {
+		U_LOG_W("Removing more memory from '%s' than was added!", vk_memory_category_string(category));
+		vmb->category_bytes[category] = 0;
+	} else {
+		vmb->category_bytes[category] -= size;
+	}
+}
+
+static void
+get_device_local_heaps(struct vk_bundle *vk, uint64_t *out_budget, uint64_t *out_usage, bool *out_have_usage)
+{
+	uint64_t budget = 0;
+	uint64_t usage = 0;
+	bool have_usage = false;
+
+#ifdef VK_EXT_memory_budget
+	if (vk->has_EXT_memory_budget && vk->vkGetPhysicalDeviceMemoryProperties2 != NULL) {
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_props = {
+		    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT,
+		};
+		VkPhysicalDeviceMemoryProperties2 props = {
+		    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+		    .pNext = &budget_props,
+		};
+
+		vk->vkGetPhysicalDeviceMemoryProperties2(vk->physical_device, &props);
+
+		for (uint32_t i = 0; i < props.memoryProperties.memoryHeapCount; i++) {
+			if ((props.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) == 0) {
+				continue;
+			}
+
+			budget += budget_props.heapBudget[i];
+			usage += budget_props.heapUsage[i];
+		}
+
+		have_usage = true;
+	}
+#endif
+
+	if (!have_usage) {
+		const VkPhysicalDeviceMemoryProperties *props = &vk->device_memory_props;
+
+		for (uint32_t i = 0; i < props->memoryHeapCount; i++) {
+			if ((props->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0) {
+				budget += props->memoryHeaps[i].size;
+			}
+		}
+	}
+
+	*out_budget = budget;
+	*out_usage = usage;
+	*out_have_usage = have_usage;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+vk_memory_budget_init(struct vk_memory_budget *vmb)
+{
+	int ret = os_mutex_init(&vmb->mutex);
+	if (ret < 0) {
+		return ret;
+	}
+
+	U_ZERO_ARRAY(vmb->category_bytes);
+	vmb->peak_bytes = 0;
+	vmb->override_budget_bytes = (uint64_t)debug_get_num_option_budget_mb() * 1024 * 1024;
+	vmb->high_percent = (uint32_t)debug_get_num_option_high_percent();
+	vmb->critical_percent = (uint32_t)debug_get_num_option_critical_percent();
+
+	if (vmb->critical_percent < vmb->high_percent) {
+		vmb->critical_percent = vmb->high_percent;
+	}
+
+	return 0;
+}
+
+void
+vk_memory_budget_fini(struct vk_memory_budget *vmb)
+{
+	os_mutex_destroy(&vmb->mutex);
+}
+
+void
+vk_memory_budget_add(struct vk_bundle *vk, enum vk_memory_category category, VkDeviceSize size)
+{
+	assert(category < VK_MEMORY_CATEGORY_COUNT);
+
+	os_mutex_lock(&vk->budget.mutex);
+	add_locked(&vk->budget, category, size);
+	os_mutex_unlock(&vk->budget.mutex);
+}
+
+void
+vk_memory_budget_remove(struct vk_bundle *vk, enum vk_memory_category category, VkDeviceSize size)
+{
+	assert(category < VK_MEMORY_CATEGORY_COUNT);
+
+	os_mutex_lock(&vk->budget.mutex);
+	remove_locked(&vk->budget, category, size);
+	os_mutex_unlock(&vk->budget.mutex);
+}
+
+void
+vk_memory_budget_move(struct vk_bundle *vk,
+                      enum vk_memory_category from,
+                      enum vk_memory_category to,
+                      VkDeviceSize size)
+{
+	assert(from < VK_MEMORY_CATEGORY_COUNT);
+	assert(to < VK_MEMORY_CATEGORY_COUNT);
+
+	os_mutex_lock(&vk->budget.mutex);
+	remove_locked(&vk->budget, from, size);
+	add_locked(&vk->budget, to, size);
+	os_mutex_unlock(&vk->budget.mutex);
+}
+
+uint64_t
+vk_memory_budget_get_category(struct vk_bundle *vk, enum vk_memory_category category)
+{
+	assert(category < VK_MEMORY_CATEGORY_COUNT);
+
+	os_mutex_lock(&vk->budget.mutex);
+	uint64_t bytes = vk->budget.category_bytes[category];
+	os_mutex_unlock(&vk->budget.mutex);
+
+	return bytes;
+}
+
+void
+vk_memory_budget_query(struct vk_bundle *vk, VkDeviceSize extra_bytes, struct vk_memory_budget_status *out_status)
+{
+	struct vk_memory_budget *vmb = &vk->budget;
+
+	uint64_t budget = 0;
+	uint64_t usage = 0;
+	bool have_usage = false;
+	get_device_local_heaps(vk, &budget, &usage, &have_usage);
+
+	os_mutex_lock(&vmb->mutex);
+	uint64_t tracked = get_tracked_locked(vmb);
+	uint64_t override_budget = vmb->override_budget_bytes;
+	uint32_t high_percent = vmb->high_percent;
+	uint32_t critical_percent = vmb->critical_percent;
+	os_mutex_unlock(&vmb->mutex);
+
+	// Without the extension all we know about is our own allocations.
+	if (!have_usage) {
+		usage = tracked;
+	}
+
+	// When overridden pretend the GPU only has that much memory.
+	if (override_budget != 0) {
+		budget = override_budget;
+		usage = tracked;
+	}
+
+	uint64_t wanted = usage + extra_bytes;
+	enum vk_memory_pressure pressure = VK_MEMORY_PRESSURE_NONE;
+	if (budget == 0) {
+		// Nothing known, don't apply any policies.
+	} else if (wanted * 100 >= budget * critical_percent) {
+		pressure = VK_MEMORY_PRESSURE_CRITICAL;
+	} else if (wanted * 100 >= budget * high_percent) {
+		pressure = VK_MEMORY_PRESSURE_HIGH;
+	}
+
+	out_status->budget_bytes = budget;
+	out_status->usage_bytes = usage;
+	out_status->tracked_bytes = tracked;
+	out_status->pressure = pressure;
+}
+
+VkDeviceSize
+vk_memory_budget_image_size(struct vk_bundle *vk, VkImage image)
+{
+	if (image == VK_NULL_HANDLE) {
+		return 0;
+	}
+
+	VkMemoryRequirements memory_requirements;
+	vk->vkGetImageMemoryRequirements(vk->device, image, &memory_requirements);
+
+	return memory_requirements.size;
+}
+
+const char *
+vk_memory_category_string(enum vk_memory_category category)
+{
+	switch (category) {
+	case VK_MEMORY_CATEGORY_SWAPCHAIN: return "swapchain";
+	case VK_MEMORY_CATEGORY_SWAPCHAIN_POOL: return "swapchain_pool";
+	case VK_MEMORY_CATEGORY_SCRATCH: return "scratch";
+	case VK_MEMORY_CATEGORY_DISTORTION: return "distortion";
+	case VK_MEMORY_CATEGORY_MIRROR: return "mirror";
+	default: return "unknown";
+	}
+}
+
+const char *
+vk_memory_pressure_string(enum vk_memory_pressure pressure)
+{
+	switch (pressure) {
+	case VK_MEMORY_PRESSURE_NONE: return "none";
+	case VK_MEMORY_PRESSURE_HIGH: return "high";
+	case VK_MEMORY_PRESSURE_CRITICAL: return "critical";
+	default: return "unknown";
+	}
+}
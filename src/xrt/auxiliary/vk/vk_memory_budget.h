@@ -0,0 +1,202 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Device memory accounting and budget tracking.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_vk
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+#include "xrt/xrt_vulkan_includes.h"
+#include "os/os_threading.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+struct vk_bundle;
+
+/*!
+ * What a device memory allocation is used for.
+ *
+ * @ingroup aux_vk
+ */
+enum vk_memory_category
+{
+	//! Images of swapchains given out to clients.
+	VK_MEMORY_CATEGORY_SWAPCHAIN,
+	//! Images of destroyed swapchains kept around for reuse.
+	VK_MEMORY_CATEGORY_SWAPCHAIN_POOL,
+	//! Scratch images used when squashing layers.
+	VK_MEMORY_CATEGORY_SCRATCH,
+	//! Distortion images and buffers.
+	VK_MEMORY_CATEGORY_DISTORTION,
+	//! Images used to mirror the output to the debug gui.
+	VK_MEMORY_CATEGORY_MIRROR,
+
+	VK_MEMORY_CATEGORY_COUNT,
+};
+
+/*!
+ * How close the device is to running out of device local memory.
+ *
+ * @ingroup aux_vk
+ */
+enum vk_memory_pressure
+{
+	//! Plenty of memory left.
+	VK_MEMORY_PRESSURE_NONE,
+	//! Above the high watermark, give back memory that is not needed.
+	VK_MEMORY_PRESSURE_HIGH,
+	//! Above the critical watermark, refuse new allocations that can fail.
+	VK_MEMORY_PRESSURE_CRITICAL,
+};
+
+/*!
+ * Point in time view of the device local memory.
+ *
+ * @ingroup aux_vk
+ */
+struct vk_memory_budget_status
+{
+	//! How much memory the process can use, summed over device local heaps.
+	uint64_t budget_bytes;
+
+	/*!
+	 * How much of the device local memory is in use by this process, if
+	 * @ref vk_bundle::has_EXT_memory_budget is not set this is only what
+	 * has been tracked in the categories.
+	 */
+	uint64_t usage_bytes;
+
+	//! Sum of all categories.
+	uint64_t tracked_bytes;
+
+	//! Pressure with the extra bytes asked about added to the usage.
+	enum vk_memory_pressure pressure;
+};
+
+/*!
+ * Accounting of device memory allocated by the compositor, embedded in the
+ * @ref vk_bundle. Allocations are attributed to categories by the code that
+ * makes them, the budget comes from `VK_EXT_memory_budget` if supported and
+ * otherwise the size of the device local heaps.
+ *
+ * @ingroup aux_vk
+ */
+struct vk_memory_budget
+{
+	//! Protects the fields below, allocations happen on many threads.
+	struct os_mutex mutex;
+
+	//! Bytes currently allocated in each category.
+	uint64_t category_bytes[VK_MEMORY_CATEGORY_COUNT];
+
+	//! Highest total of all categories seen.
+	uint64_t peak_bytes;
+
+	//! If not zero, used instead of the budget reported by the driver.
+	uint64_t override_budget_bytes;
+
+	//! Usage over the budget in percent that counts as high pressure.
+	uint32_t high_percent;
+
+	//! Usage over the budget in percent that counts as critical pressure.
+	uint32_t critical_percent;
+};
+
+/*!
+ * Init the accounting, called by @ref vk_init_mutex.
+ *
+ * @public @memberof vk_memory_budget
+ */
+int
+vk_memory_budget_init(struct vk_memory_budget *vmb);
+
+/*!
+ * Destroy the accounting, called by @ref vk_deinit_mutex.
+ *
+ * @public @memberof vk_memory_budget
+ */
+void
+vk_memory_budget_fini(struct vk_memory_budget *vmb);
+
+/*!
+ * Attribute @p size bytes of device memory to @p category.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_memory_budget_add(struct vk_bundle *vk, enum vk_memory_category category, VkDeviceSize size);
+
+/*!
+ * Remove @p size bytes of device memory from @p category, must match an
+ * earlier call to @ref vk_memory_budget_add.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_memory_budget_remove(struct vk_bundle *vk, enum vk_memory_category category, VkDeviceSize size);
+
+/*!
+ * Move @p size bytes from one category to another, like when images are put
+ * into the swapchain pool.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_memory_budget_move(struct vk_bundle *vk,
+                      enum vk_memory_category from,
+                      enum vk_memory_category to,
+                      VkDeviceSize size);
+
+/*!
+ * Bytes currently attributed to @p category.
+ *
+ * @ingroup aux_vk
+ */
+uint64_t
+vk_memory_budget_get_category(struct vk_bundle *vk, enum vk_memory_category category);
+
+/*!
+ * Get the current budget and usage, the pressure is calculated as if
+ * @p extra_bytes more were allocated, pass zero for the current pressure.
+ * Queries the driver, so don't call it every frame.
+ *
+ * @ingroup aux_vk
+ */
+void
+vk_memory_budget_query(struct vk_bundle *vk, VkDeviceSize extra_bytes, struct vk_memory_budget_status *out_status);
+
+/*!
+ * Size of the memory backing @p image, to be given to @ref vk_memory_budget_add.
+ *
+ * @ingroup aux_vk
+ */
+VkDeviceSize
+vk_memory_budget_image_size(struct vk_bundle *vk, VkImage image);
+
+/*!
+ * Returns a string for the category.
+ *
+ * @ingroup aux_vk
+ */
+const char *
+vk_memory_category_string(enum vk_memory_category category);
+
+/*!
+ * Returns a string for the pressure level.
+ *
+ * @ingroup aux_vk
+ */
+const char *
+vk_memory_pressure_string(enum vk_memory_pressure pressure);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,248 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Persisting pipeline caches to disk.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup aux_vk
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include "util/u_file.h"
+#include "util/u_misc.h"
+
+#include "vk/vk_helpers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef XRT_OS_LINUX
+#include <unistd.h>
+#include <linux/limits.h>
+#endif
+
+
+/*!
+ * Don't load anything larger then this, guards against garbage files.
+ */
+#define MAX_CACHE_SIZE (64 * 1024 * 1024)
+
+/*!
+ * Size of the header version one: size, version, vendor, device and UUID.
+ */
+#define HEADER_SIZE (4 * sizeof(uint32_t) + VK_UUID_SIZE)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+#ifdef XRT_OS_LINUX
+static bool
+get_file_name(const VkPhysicalDeviceProperties *pdp, const char *suffix, char *out_name, size_t out_name_size)
+{
+	char uuid[VK_UUID_SIZE * 2 + 1] = {0};
+	for (uint32_t i = 0; i < VK_UUID_SIZE; i++) {
+		snprintf(&uuid[i * 2], 3, "%02x", pdp->pipelineCacheUUID[i]);
+	}
+
+	int ret = snprintf(                         //
+	    out_name,                               //
+	    out_name_size,                          //
+	    "vk_pipeline_cache-%04x-%04x-%s.bin%s", //
+	    pdp->vendorID,                          //
+	    pdp->deviceID,                          //
+	    uuid,                                   //
+	    suffix);                                //
+
+	return ret > 0 && ret < (int)out_name_size;
+}
+
+static bool
+get_file_path(const VkPhysicalDeviceProperties *pdp, const char *suffix, char *out_path, size_t out_path_size)
+{
+	char file_name[128];
+	if (!get_file_name(pdp, suffix, file_name, sizeof(file_name))) {
+		return false;
+	}
+
+	ssize_t ret = u_file_get_path_in_cache_dir(file_name, out_path, out_path_size);
+	return ret > 0 && ret < (ssize_t)out_path_size;
+}
+
+/*!
+ * The driver is required to reject incompatible data, but checking it here
+ * as well means we don't feed it a file that was truncated or is for another
+ * device that happened to get the same name.
+ */
+static bool
+is_header_valid(const VkPhysicalDeviceProperties *pdp, const uint8_t *data, size_t size)
+{
+	if (size < HEADER_SIZE) {
+		return false;
+	}
+
+	uint32_t values[4];
+	memcpy(values, data, sizeof(values));
+
+	// headerSize, headerVersion, vendorID, deviceID and pipelineCacheUUID.
+	return values[0] >= HEADER_SIZE && values[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+	       values[2] == pdp->vendorID && values[3] == pdp->deviceID &&
+	       memcmp(data + sizeof(values), pdp->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+static uint8_t *
+load_data(struct vk_bundle *vk, const VkPhysicalDeviceProperties *pdp, size_t *out_size)
+{
+	char path[PATH_MAX];
+	if (!get_file_path(pdp, "", path, sizeof(path))) {
+		return NULL;
+	}
+
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return NULL;
+	}
+
+	fseek(file, 0L, SEEK_END);
+	long file_size = ftell(file);
+	fseek(file, 0L, SEEK_SET);
+
+	if (file_size <= 0 || file_size > MAX_CACHE_SIZE) {
+		fclose(file);
+		return NULL;
+	}
+
+	size_t size = (size_t)file_size;
+	uint8_t *data = U_TYPED_ARRAY_CALLOC(uint8_t, size);
+	size_t read = fread(data, 1, size, file);
+	fclose(file);
+
+	if (read != size || !is_header_valid(pdp, data, size)) {
+		VK_WARN(vk, "Ignoring invalid pipeline cache file '%s'", path);
+		free(data);
+		return NULL;
+	}
+
+	VK_DEBUG(vk, "Loaded pipeline cache '%s' (%zu bytes)", path, size);
+
+	*out_size = size;
+
+	return data;
+}
+#endif
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+VkResult
+vk_create_pipeline_cache_from_disk(struct vk_bundle *vk, VkPipelineCache *out_pipeline_cache)
+{
+	uint8_t *data = NULL;
+	size_t size = 0;
+	VkResult ret;
+
+#ifdef XRT_OS_LINUX
+	VkPhysicalDeviceProperties pdp;
+	vk->vkGetPhysicalDeviceProperties(vk->physical_device, &pdp);
+
+	data = load_data(vk, &pdp, &size);
+#endif
+
+	VkPipelineCacheCreateInfo pipeline_cache_info = {
+	    .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+	    .initialDataSize = size,
+	    .pInitialData = data,
+	};
+
+	VkPipelineCache pipeline_cache;
+	ret = vk->vkCreatePipelineCache( //
+	    vk->device,                  // device
+	    &pipeline_cache_info,        // pCreateInfo
+	    NULL,                        // pAllocator
+	    &pipeline_cache);            // pPipelineCache
+
+	free(data);
+
+	if (ret != VK_SUCCESS && size > 0) {
+		VK_WARN(vk, "vkCreatePipelineCache with saved data failed: %s", vk_result_string(ret));
+		return vk_create_pipeline_cache(vk, out_pipeline_cache);
+	}
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkCreatePipelineCache failed: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	*out_pipeline_cache = pipeline_cache;
+
+	return VK_SUCCESS;
+}
+
+void
+vk_save_pipeline_cache(struct vk_bundle *vk, VkPipelineCache pipeline_cache)
+{
+#ifdef XRT_OS_LINUX
+	VkResult ret;
+
+	if (pipeline_cache == VK_NULL_HANDLE) {
+		return;
+	}
+
+	VkPhysicalDeviceProperties pdp;
+	vk->vkGetPhysicalDeviceProperties(vk->physical_device, &pdp);
+
+	char tmp_name[128];
+	char tmp_path[PATH_MAX];
+	char path[PATH_MAX];
+	if (!get_file_name(&pdp, ".tmp", tmp_name, sizeof(tmp_name)) ||
+	    !get_file_path(&pdp, ".tmp", tmp_path, sizeof(tmp_path)) ||
+	    !get_file_path(&pdp, "", path, sizeof(path))) {
+		return;
+	}
+
+	size_t size = 0;
+	ret = vk->vkGetPipelineCacheData(vk->device, pipeline_cache, &size, NULL);
+	if (ret != VK_SUCCESS || size == 0 || size > MAX_CACHE_SIZE) {
+		return;
+	}
+
+	uint8_t *data = U_TYPED_ARRAY_CALLOC(uint8_t, size);
+	ret = vk->vkGetPipelineCacheData(vk->device, pipeline_cache, &size, data);
+	if (ret != VK_SUCCESS) {
+		VK_WARN(vk, "vkGetPipelineCacheData failed: %s", vk_result_string(ret));
+		free(data);
+		return;
+	}
+
+	// Creates the directory if needed, the file is renamed into place below.
+	FILE *file = u_file_open_file_in_cache_dir(tmp_name, "wb");
+	if (file == NULL) {
+		VK_WARN(vk, "Failed to open pipeline cache file '%s'", tmp_path);
+		free(data);
+		return;
+	}
+
+	bool written = fwrite(data, size, 1, file) == 1;
+	bool closed = fclose(file) == 0;
+	free(data);
+
+	if (!written || !closed || rename(tmp_path, path) != 0) {
+		VK_WARN(vk, "Failed to write pipeline cache file '%s'", path);
+		unlink(tmp_path);
+		return;
+	}
+
+	VK_DEBUG(vk, "Saved pipeline cache '%s' (%zu bytes)", path, size);
+#else
+	(void)vk;
+	(void)pipeline_cache;
+#endif
+}
@@ -114,6 +114,49 @@ vk_create_descriptor_set(struct vk_bundle *vk,
 	return VK_SUCCESS;
 }
 
+VkResult
+vk_create_descriptor_sets(struct vk_bundle *vk,
+                          VkDescriptorPool descriptor_pool,
+                          VkDescriptorSetLayout descriptor_layout,
+                          uint32_t count,
+                          VkDescriptorSet *out_descriptor_sets)
+{
+	VkResult ret;
+
+	// Each set needs its own layout entry, allocate in chunks to keep them on the stack.
+	VkDescriptorSetLayout layouts[32];
+	for (uint32_t i = 0; i < ARRAY_SIZE(layouts); i++) {
+		layouts[i] = descriptor_layout;
+	}
+
+	for (uint32_t done = 0; done < count;) {
+		uint32_t chunk = count - done;
+		if (chunk > ARRAY_SIZE(layouts)) {
+			chunk = ARRAY_SIZE(layouts);
+		}
+
+		VkDescriptorSetAllocateInfo alloc_info = {
+		    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+		    .descriptorPool = descriptor_pool,
+		    .descriptorSetCount = chunk,
+		    .pSetLayouts = layouts,
+		};
+
+		ret = vk->vkAllocateDescriptorSets( //
+		    vk->device,                     // device
+		    &alloc_info,                    // pAllocateInfo
+		    &out_descriptor_sets[done]);    // pDescriptorSets
+		if (ret != VK_SUCCESS) {
+			VK_DEBUG(vk, "vkAllocateDescriptorSets failed: %s", vk_result_string(ret));
+			return ret;
+		}
+
+		done += chunk;
+	}
+
+	return VK_SUCCESS;
+}
+
 VkResult
 vk_create_pipeline_layout(struct vk_bundle *vk,
                           VkDescriptorSetLayout descriptor_set_layout,
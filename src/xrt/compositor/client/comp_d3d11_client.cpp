@@ -187,6 +187,12 @@ struct client_d3d11_swapchain_data
 
 	xrt::compositor::client::KeyedMutexCollection keyed_mutex_collection;
 
+	/*!
+	 * Are the images created with keyed mutexes, not needed when the native compositor waits on our fence
+	 * on layer commit, as it is then only ever touching the images after the app is done with them.
+	 */
+	bool use_keyed_mutex = true;
+
 	//! The shared DXGI handles for our images
 	std::vector<HANDLE> dxgi_handles;
 
@@ -283,7 +289,7 @@ client_d3d11_swapchain_wait_image(struct xrt_swapchain *xsc, uint64_t timeout_ns
 	// Pipe down call into imported swapchain in native compositor.
 	xrt_result_t xret = xrt_swapchain_wait_image(sc->xsc.get(), timeout_ns, index);
 
-	if (xret == XRT_SUCCESS) {
+	if (xret == XRT_SUCCESS && sc->data->use_keyed_mutex) {
 		// OK, we got the image in the native compositor, now need the keyed mutex in d3d11.
 		xret = sc->data->keyed_mutex_collection.waitKeyedMutex(index, timeout_ns);
 	}
@@ -306,7 +312,7 @@ client_d3d11_swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 	// Pipe down call into imported swapchain in native compositor.
 	xrt_result_t xret = xrt_swapchain_release_image(sc->xsc.get(), index);
 
-	if (xret == XRT_SUCCESS) {
+	if (xret == XRT_SUCCESS && sc->data->use_keyed_mutex) {
 		// Release the keyed mutex
 		xret = sc->data->keyed_mutex_collection.releaseKeyedMutex(index);
 	}
@@ -404,8 +410,13 @@ try {
 	std::unique_ptr<struct client_d3d11_swapchain> sc = std::make_unique<struct client_d3d11_swapchain>();
 	sc->data = std::make_unique<client_d3d11_swapchain_data>(c->log_level);
 	auto &data = sc->data;
-	xret = xrt::auxiliary::d3d::d3d11::allocateSharedImages(*(c->comp_device), xinfo, image_count, true,
-	                                                        data->comp_images, data->dxgi_handles);
+
+	// The fence shared with the native compositor orders all access for us, no CPU waits on keyed mutexes needed.
+	data->use_keyed_mutex = !c->timeline_semaphore;
+
+	xret = xrt::auxiliary::d3d::d3d11::allocateSharedImages(*(c->comp_device), xinfo, image_count,
+	                                                        data->use_keyed_mutex, data->comp_images,
+	                                                        data->dxgi_handles);
 	if (xret != XRT_SUCCESS) {
 		return xret;
 	}
@@ -424,10 +435,12 @@ try {
 	}
 
 	// Cache the keyed mutex interface
-	xret = data->keyed_mutex_collection.init(data->app_images);
-	if (xret != XRT_SUCCESS) {
-		D3D_ERROR(c, "Error retrieving keyex mutex interfaces");
-		return xret;
+	if (data->use_keyed_mutex) {
+		xret = data->keyed_mutex_collection.init(data->app_images);
+		if (xret != XRT_SUCCESS) {
+			D3D_ERROR(c, "Error retrieving keyex mutex interfaces");
+			return xret;
+		}
 	}
 
 	// Import into the native compositor, to create the corresponding swapchain which we wrap.
@@ -600,6 +600,10 @@ xrt_gfx_provider_create_gl_egl(struct xrt_compositor_native *xcn,
 	}
 
 	ceglc->base.base.base.destroy = client_egl_compositor_destroy;
+
+	// Our context is current and shares objects with the app's context.
+	client_gl_compositor_init_semaphore(&ceglc->base, (client_gl_get_proc_addr_func_t)get_gl_procaddr);
+
 	restore_context(&old);
 	*out_xcgl = &ceglc->base.base;
 
@@ -27,12 +27,32 @@
 
 #include "client/comp_gl_client.h"
 
+#include "util/u_handles.h"
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
 
 #include <inttypes.h>
 
 
+/*
+ * GL_EXT_semaphore_fd and GL_NV_timeline_semaphore are not part of our GLAD
+ * build, so the few bits of them that we need are loaded by hand.
+ */
+#ifndef GL_NV_timeline_semaphore
+#define GL_TIMELINE_SEMAPHORE_VALUE_NV 0x9595
+#define GL_SEMAPHORE_TYPE_NV 0x95B3
+#define GL_SEMAPHORE_TYPE_TIMELINE_NV 0x95B5
+#endif
+
+typedef void(GLAD_API_PTR *client_gl_import_semaphore_fd_func_t)(GLuint semaphore, GLenum handleType, GLint fd);
+typedef void(GLAD_API_PTR *client_gl_create_semaphores_func_t)(GLsizei n, GLuint *semaphores);
+typedef void(GLAD_API_PTR *client_gl_semaphore_parameteriv_func_t)(GLuint semaphore, GLenum pname, const GLint *params);
+
+static client_gl_import_semaphore_fd_func_t client_glImportSemaphoreFdEXT;
+static client_gl_create_semaphores_func_t client_glCreateSemaphoresNV;
+static client_gl_semaphore_parameteriv_func_t client_glSemaphoreParameterivNV;
+
+
 /*
  *
  * Helpers.
@@ -110,6 +130,55 @@ vk_format_to_gl(int64_t format)
 	}
 }
 
+static bool
+has_gl_extension(const char *name)
+{
+	if (glGetStringi == NULL) {
+		return false;
+	}
+
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+	for (GLint i = 0; i < count; i++) {
+		const char *ext = (const char *)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+		if (ext != NULL && strcmp(ext, name) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*!
+ * Called with the right context made current.
+ */
+static bool
+submit_semaphore(struct client_gl_compositor *c, xrt_result_t *out_xret)
+{
+	if (c->sync.xcsem == NULL) {
+		return false;
+	}
+
+	COMP_TRACE_IDENT(signal_semaphore);
+
+	GLuint64 value = ++(c->sync.value);
+
+	// The value to signal is given before the signal operation.
+	glSemaphoreParameterui64vEXT(c->sync.semaphore, GL_TIMELINE_SEMAPHORE_VALUE_NV, &value);
+	glSignalSemaphoreEXT(c->sync.semaphore, 0, NULL, 0, NULL, NULL);
+
+	// Make sure the signal operation is sent to the GPU, not waited upon.
+	glFlush();
+
+	*out_xret = xrt_comp_layer_commit_with_semaphore( //
+	    &c->xcn->base,                               // xc
+	    c->sync.xcsem,                               // xcsem
+	    value);                                      // value
+
+	return true;
+}
+
 /*!
  * Called with the right context made current.
  */
@@ -273,6 +342,34 @@ client_gl_compositor_layer_projection_depth(struct xrt_compositor *xc,
 	return xrt_comp_layer_projection_depth(xcn, xdev, xscn, d_xscn, &d);
 }
 
+static xrt_result_t
+client_gl_compositor_layer_projection_space_warp(struct xrt_compositor *xc,
+                                                 struct xrt_device *xdev,
+                                                 struct xrt_swapchain *xsc[XRT_MAX_VIEWS],
+                                                 struct xrt_swapchain *d_xsc[XRT_MAX_VIEWS],
+                                                 struct xrt_swapchain *mv_xsc[XRT_MAX_VIEWS],
+                                                 const struct xrt_layer_data *data)
+{
+	struct xrt_compositor *xcn;
+	struct xrt_swapchain *xscn[XRT_MAX_VIEWS];
+	struct xrt_swapchain *d_xscn[XRT_MAX_VIEWS];
+	struct xrt_swapchain *mv_xscn[XRT_MAX_VIEWS];
+
+	assert(data->type == XRT_LAYER_PROJECTION_DEPTH);
+
+	xcn = to_native_compositor(xc);
+	for (uint32_t i = 0; i < data->view_count; ++i) {
+		xscn[i] = to_native_swapchain(xsc[i]);
+		d_xscn[i] = to_native_swapchain(d_xsc[i]);
+		mv_xscn[i] = to_native_swapchain(mv_xsc[i]);
+	}
+
+	struct xrt_layer_data d = *data;
+	d.flip_y = !d.flip_y;
+
+	return xrt_comp_layer_projection_space_warp(xcn, xdev, xscn, d_xscn, mv_xscn, &d);
+}
+
 static xrt_result_t
 client_gl_compositor_layer_quad(struct xrt_compositor *xc,
                                 struct xrt_device *xdev,
@@ -388,6 +485,35 @@ client_gl_compositor_layer_passthrough(struct xrt_compositor *xc,
 	return xrt_comp_layer_passthrough(&c->xcn->base, xdev, &d);
 }
 
+static xrt_result_t
+client_gl_compositor_layer_batch(struct xrt_compositor *xc,
+                                 struct xrt_layer_batch_entry *entries,
+                                 uint32_t entry_count)
+{
+	COMP_TRACE_MARKER();
+
+	// Swap in the native swapchains in place, unused ones are NULL.
+	for (uint32_t i = 0; i < entry_count; i++) {
+		struct xrt_layer_batch_entry *e = &entries[i];
+
+		for (uint32_t k = 0; k < XRT_MAX_VIEWS; k++) {
+			if (e->xsc[k] != NULL) {
+				e->xsc[k] = to_native_swapchain(e->xsc[k]);
+			}
+			if (e->d_xsc[k] != NULL) {
+				e->d_xsc[k] = to_native_swapchain(e->d_xsc[k]);
+			}
+			if (e->mv_xsc[k] != NULL) {
+				e->mv_xsc[k] = to_native_swapchain(e->mv_xsc[k]);
+			}
+		}
+
+		e->data.flip_y = !e->data.flip_y;
+	}
+
+	return xrt_comp_layer_batch(to_native_compositor(xc), entries, entry_count);
+}
+
 static xrt_result_t
 client_gl_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_t sync_handle)
 {
@@ -407,8 +533,15 @@ client_gl_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_h
 
 	xrt_result_t xret = client_gl_compositor_context_begin(xc, CLIENT_GL_CONTEXT_REASON_SYNCHRONIZE);
 	if (xret == XRT_SUCCESS) {
-		sync_handle = handle_fencing_or_finish(c);
+		bool submitted = submit_semaphore(c, &xret);
+		if (!submitted) {
+			sync_handle = handle_fencing_or_finish(c);
+		}
 		client_gl_compositor_context_end(xc, CLIENT_GL_CONTEXT_REASON_SYNCHRONIZE);
+
+		if (submitted) {
+			return xret;
+		}
 	}
 
 	COMP_TRACE_IDENT(layer_commit);
@@ -581,9 +714,93 @@ client_gl_compositor_destroy(struct xrt_compositor *xc)
 void
 client_gl_compositor_close(struct client_gl_compositor *c)
 {
+	struct xrt_compositor *xc = &c->base.base;
+
+	if (c->sync.semaphore != 0) {
+		xrt_result_t xret = client_gl_compositor_context_begin(xc, CLIENT_GL_CONTEXT_REASON_SYNCHRONIZE);
+		if (xret == XRT_SUCCESS) {
+			glDeleteSemaphoresEXT(1, &c->sync.semaphore);
+			client_gl_compositor_context_end(xc, CLIENT_GL_CONTEXT_REASON_SYNCHRONIZE);
+		}
+		c->sync.semaphore = 0;
+	}
+
+	xrt_compositor_semaphore_reference(&c->sync.xcsem, NULL);
+
 	os_mutex_destroy(&c->context_mutex);
 }
 
+void
+client_gl_compositor_init_semaphore(struct client_gl_compositor *c, client_gl_get_proc_addr_func_t get_proc_addr)
+{
+#ifdef XRT_GRAPHICS_SYNC_HANDLE_IS_FD
+	xrt_graphics_sync_handle_t handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
+	struct xrt_compositor_semaphore *xcsem = NULL;
+	xrt_result_t xret;
+
+	xret = client_gl_compositor_context_begin(&c->base.base, CLIENT_GL_CONTEXT_REASON_SYNCHRONIZE);
+	if (xret != XRT_SUCCESS) {
+		return;
+	}
+
+	if (!GLAD_GL_EXT_semaphore || !has_gl_extension("GL_EXT_semaphore_fd") ||
+	    !has_gl_extension("GL_NV_timeline_semaphore")) {
+		U_LOG_D("GL_EXT_semaphore_fd or GL_NV_timeline_semaphore not available, not using semaphores");
+		goto out_end;
+	}
+
+	client_glImportSemaphoreFdEXT = (client_gl_import_semaphore_fd_func_t)get_proc_addr("glImportSemaphoreFdEXT");
+	client_glCreateSemaphoresNV = (client_gl_create_semaphores_func_t)get_proc_addr("glCreateSemaphoresNV");
+	client_glSemaphoreParameterivNV =
+	    (client_gl_semaphore_parameteriv_func_t)get_proc_addr("glSemaphoreParameterivNV");
+
+	if (client_glImportSemaphoreFdEXT == NULL || client_glCreateSemaphoresNV == NULL ||
+	    client_glSemaphoreParameterivNV == NULL) {
+		U_LOG_W("Failed to load GL semaphore functions, not using semaphores");
+		goto out_end;
+	}
+
+	xret = xrt_comp_create_semaphore(&c->xcn->base, &handle, &xcsem);
+	if (xret != XRT_SUCCESS) {
+		U_LOG_W("Failed to create semaphore, not using semaphores");
+		goto out_end;
+	}
+
+	// Clear any old errors.
+	while (glGetError() != GL_NO_ERROR) {
+	}
+
+	GLuint semaphore = 0;
+	GLint type = GL_SEMAPHORE_TYPE_TIMELINE_NV;
+	client_glCreateSemaphoresNV(1, &semaphore);
+	client_glSemaphoreParameterivNV(semaphore, GL_SEMAPHORE_TYPE_NV, &type);
+
+	// Ownership of the handle is transferred to GL on success.
+	client_glImportSemaphoreFdEXT(semaphore, GL_HANDLE_TYPE_OPAQUE_FD_EXT, handle);
+
+	GLenum err = glGetError();
+	if (err != GL_NO_ERROR) {
+		U_LOG_W("Failed to import semaphore (0x%04x), not using semaphores", err);
+		glDeleteSemaphoresEXT(1, &semaphore);
+		u_graphics_sync_unref(&handle);
+		xrt_compositor_semaphore_reference(&xcsem, NULL);
+		goto out_end;
+	}
+
+	U_LOG_D("Using timeline semaphore for synchronization");
+
+	c->sync.semaphore = semaphore;
+	c->sync.xcsem = xcsem; // No need to reference.
+	c->sync.value = 0;
+
+out_end:
+	client_gl_compositor_context_end(&c->base.base, CLIENT_GL_CONTEXT_REASON_SYNCHRONIZE);
+#else
+	(void)c;
+	(void)get_proc_addr;
+#endif
+}
+
 bool
 client_gl_compositor_init(struct client_gl_compositor *c,
                           struct xrt_compositor_native *xcn,
@@ -608,12 +825,14 @@ client_gl_compositor_init(struct client_gl_compositor *c,
 	c->base.base.layer_begin = client_gl_compositor_layer_begin;
 	c->base.base.layer_projection = client_gl_compositor_layer_projection;
 	c->base.base.layer_projection_depth = client_gl_compositor_layer_projection_depth;
+	c->base.base.layer_projection_space_warp = client_gl_compositor_layer_projection_space_warp;
 	c->base.base.layer_quad = client_gl_compositor_layer_quad;
 	c->base.base.layer_cube = client_gl_compositor_layer_cube;
 	c->base.base.layer_cylinder = client_gl_compositor_layer_cylinder;
 	c->base.base.layer_equirect1 = client_gl_compositor_layer_equirect1;
 	c->base.base.layer_equirect2 = client_gl_compositor_layer_equirect2;
 	c->base.base.layer_passthrough = client_gl_compositor_layer_passthrough;
+	c->base.base.layer_batch = client_gl_compositor_layer_batch;
 	c->base.base.layer_commit = client_gl_compositor_layer_commit;
 	c->base.base.destroy = client_gl_compositor_destroy;
 	c->context_begin_locked = context_begin_locked;
@@ -130,6 +130,18 @@ typedef struct xrt_swapchain *(*client_gl_swapchain_create_func_t)(struct xrt_co
 typedef xrt_result_t (*client_gl_insert_fence_func_t)(struct xrt_compositor *xc,
                                                       xrt_graphics_sync_handle_t *out_handle);
 
+/*!
+ * A generic function pointer, as returned by @ref client_gl_get_proc_addr_func_t.
+ */
+typedef void (*client_gl_proc_func_t)(void);
+
+/*!
+ * The type of the winsys function used to look up OpenGL functions, like
+ * eglGetProcAddress or glXGetProcAddress, it is used to load the functions
+ * that the GL loader doesn't.
+ */
+typedef client_gl_proc_func_t (*client_gl_get_proc_addr_func_t)(const char *name);
+
 /*!
  * @class client_gl_compositor
  *
@@ -165,6 +177,19 @@ struct client_gl_compositor
 	 */
 	client_gl_insert_fence_func_t insert_fence;
 
+	/*!
+	 * Timeline semaphore shared with the native compositor, imported into
+	 * OpenGL, used on xrt_compositor::layer_commit instead of fences or
+	 * glFinish when available. See @ref client_gl_compositor_init_semaphore.
+	 */
+	struct
+	{
+		//! The GL semaphore object, zero if not used.
+		uint32_t semaphore;
+		struct xrt_compositor_semaphore *xcsem;
+		uint64_t value;
+	} sync;
+
 	/*!
 	 * @ref client_gl_xlib_compositor::app_context can only be current on one thread; block other threads while we
 	 * know it is bound to a thread.
@@ -213,6 +238,21 @@ client_gl_compositor_init(struct client_gl_compositor *c,
                           client_gl_swapchain_create_func_t create_swapchain,
                           client_gl_insert_fence_func_t insert_fence);
 
+/*!
+ * Try to set up a timeline semaphore shared with the native compositor, this
+ * requires GL_EXT_semaphore_fd and GL_NV_timeline_semaphore. If it succeeds
+ * xrt_compositor::layer_commit signals the semaphore from the GL command
+ * stream instead of inserting a fence or calling glFinish, which stalls the
+ * application's thread until the GPU is idle.
+ *
+ * Must be called after @ref client_gl_compositor_init, failing to set up the
+ * semaphore is not an error, the other paths are used instead.
+ *
+ * @public @memberof client_gl_compositor
+ */
+void
+client_gl_compositor_init_semaphore(struct client_gl_compositor *c, client_gl_get_proc_addr_func_t get_proc_addr);
+
 /*!
  * Free all resources from the client_gl_compositor, does not free the
  * @ref client_gl_compositor itself. Nor does it free the
@@ -205,5 +205,7 @@ client_gl_xlib_compositor_create(struct xrt_compositor_native *xcn,
 
 	c->base.base.base.destroy = client_gl_xlib_compositor_destroy;
 
+	client_gl_compositor_init_semaphore(&c->base, (client_gl_get_proc_addr_func_t)glXGetProcAddress);
+
 	return c;
 }
@@ -12,12 +12,20 @@
 #include "util/u_handles.h"
 #include "util/u_trace_marker.h"
 #include "util/u_debug.h"
+#include "util/u_foveation.h"
 
 #include "comp_vk_client.h"
 
 //! We are not allowed to touch the queue in xrDestroySwapchain
 #define BREAK_OPENXR_SPEC_IN_DESTROY_SWAPCHAIN (true)
 
+/*!
+ * Size in pixels covered by one fragment density map texel, this is the
+ * largest maxFragmentDensityTexelSize in the wild, implementations may use
+ * smaller areas.
+ */
+#define FDM_TEXEL_SIZE (32)
+
 // Prefixed with OXR since the only user right now is the OpenXR state tracker.
 DEBUG_GET_ONCE_LOG_OPTION(vulkan_log, "OXR_VULKAN_LOG", U_LOGGING_INFO)
 
@@ -68,8 +76,30 @@ to_native_compositor(struct xrt_compositor *xc)
  *
  */
 
+//! Call with the pool locked.
+static VkResult
+wait_and_reset_fence_locked(struct vk_bundle *vk, VkFence fence)
+{
+	VkResult ret;
+
+	// Last used frames ago on the same image, so almost always signalled.
+	ret = vk->vkWaitForFences(vk->device, 1, &fence, VK_TRUE, UINT64_MAX);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkWaitForFences: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	ret = vk->vkResetFences(vk->device, 1, &fence);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vkResetFences: %s", vk_result_string(ret));
+		return ret;
+	}
+
+	return VK_SUCCESS;
+}
+
 static xrt_result_t
-submit_image_barrier(struct client_vk_swapchain *sc, VkCommandBuffer cmd_buffer)
+submit_image_barrier(struct client_vk_swapchain *sc, VkCommandBuffer cmd_buffer, VkFence fence, bool is_release)
 {
 	COMP_TRACE_MARKER();
 
@@ -77,10 +107,30 @@ submit_image_barrier(struct client_vk_swapchain *sc, VkCommandBuffer cmd_buffer)
 	struct vk_bundle *vk = &c->vk;
 	VkResult ret;
 
-	// Note we do not submit a fence here, it's not needed.
-	ret = vk_cmd_pool_submit_cmd_buffer(vk, &c->pool, cmd_buffer);
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .commandBufferCount = 1,
+	    .pCommandBuffers = &cmd_buffer,
+	};
+
+	vk_cmd_pool_lock(&c->pool);
+
+	ret = wait_and_reset_fence_locked(vk, fence);
+	if (ret != VK_SUCCESS) {
+		vk_cmd_pool_unlock(&c->pool);
+		return XRT_ERROR_VULKAN;
+	}
+
+	// The fence lets us wait on this image without idling the queue.
+	ret = vk_cmd_submit_locked(vk, 1, &submit_info, fence);
+	if (ret == VK_SUCCESS && is_release) {
+		c->sync.release_fence = fence;
+	}
+
+	vk_cmd_pool_unlock(&c->pool);
+
 	if (ret != VK_SUCCESS) {
-		VK_ERROR(vk, "vk_cmd_pool_submit_cmd_buffer: %s %u", vk_result_string(ret), ret);
+		VK_ERROR(vk, "vk_cmd_submit_locked: %s %u", vk_result_string(ret), ret);
 		return XRT_ERROR_FAILED_TO_SUBMIT_VULKAN_COMMANDS;
 	}
 
@@ -244,12 +294,24 @@ submit_fallback(struct client_vk_compositor *c, xrt_result_t *out_xret)
 	struct vk_bundle *vk = &c->vk;
 
 	{
-		COMP_TRACE_IDENT(device_wait_idle);
-
-		// Last course of action fallback.
-		os_mutex_lock(&vk->queue_mutex);
-		vk->vkQueueWaitIdle(vk->queue);
-		os_mutex_unlock(&vk->queue_mutex);
+		COMP_TRACE_IDENT(wait_release_fence);
+
+		/*
+		 * Last course of action fallback, wait for the app's work on the
+		 * released images. Work submitted after the last release, like
+		 * the next frame, is left in flight.
+		 */
+		vk_cmd_pool_lock(&c->pool);
+		VkFence fence = c->sync.release_fence;
+		c->sync.release_fence = VK_NULL_HANDLE;
+		vk_cmd_pool_unlock(&c->pool);
+
+		if (fence != VK_NULL_HANDLE) {
+			VkResult ret = vk->vkWaitForFences(vk->device, 1, &fence, VK_TRUE, UINT64_MAX);
+			if (ret != VK_SUCCESS) {
+				VK_ERROR(vk, "vkWaitForFences: %s", vk_result_string(ret));
+			}
+		}
 	}
 
 	*out_xret = xrt_comp_layer_commit(&c->xcn->base, XRT_GRAPHICS_SYNC_HANDLE_INVALID);
@@ -257,6 +319,226 @@ submit_fallback(struct client_vk_compositor *c, xrt_result_t *out_xret)
 }
 
 
+/*
+ *
+ * Fragment density map helpers.
+ *
+ */
+
+static void
+destroy_fdm(struct client_vk_swapchain *sc)
+{
+	struct vk_bundle *vk = &sc->c->vk;
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(sc->fdm.mems); i++) {
+		if (sc->base.fdm_images[i] != VK_NULL_HANDLE) {
+			vk->vkDestroyImage(vk->device, sc->base.fdm_images[i], NULL);
+			sc->base.fdm_images[i] = VK_NULL_HANDLE;
+		}
+
+		if (sc->fdm.mems[i] != VK_NULL_HANDLE) {
+			vk->vkFreeMemory(vk->device, sc->fdm.mems[i], NULL);
+			sc->fdm.mems[i] = VK_NULL_HANDLE;
+		}
+
+		if (sc->fdm.buffers[i] != VK_NULL_HANDLE) {
+			vk->vkDestroyBuffer(vk->device, sc->fdm.buffers[i], NULL);
+			sc->fdm.buffers[i] = VK_NULL_HANDLE;
+		}
+
+		if (sc->fdm.buffer_mems[i] != VK_NULL_HANDLE) {
+			// Freeing implicitly unmaps.
+			vk->vkFreeMemory(vk->device, sc->fdm.buffer_mems[i], NULL);
+			sc->fdm.buffer_mems[i] = VK_NULL_HANDLE;
+			sc->fdm.mapped[i] = NULL;
+		}
+	}
+}
+
+#ifdef VK_EXT_fragment_density_map
+static VkResult
+create_fdm_image(struct client_vk_swapchain *sc, uint32_t index)
+{
+	struct vk_bundle *vk = &sc->c->vk;
+	VkResult ret;
+
+	VkImageCreateInfo image_info = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+	    .imageType = VK_IMAGE_TYPE_2D,
+	    .format = VK_FORMAT_R8G8_UNORM,
+	    .extent =
+	        {
+	            .width = sc->base.fdm_width,
+	            .height = sc->base.fdm_height,
+	            .depth = 1,
+	        },
+	    .mipLevels = 1,
+	    .arrayLayers = sc->fdm.layer_count,
+	    .samples = VK_SAMPLE_COUNT_1_BIT,
+	    .tiling = VK_IMAGE_TILING_OPTIMAL,
+	    .usage = VK_IMAGE_USAGE_FRAGMENT_DENSITY_MAP_BIT_EXT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+	    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+	};
+
+	ret = vk->vkCreateImage(vk->device, &image_info, NULL, &sc->base.fdm_images[index]);
+	VK_CHK_AND_RET(ret, "vkCreateImage");
+
+	ret = vk_alloc_and_bind_image_memory( //
+	    vk,                               // vk_bundle
+	    sc->base.fdm_images[index],       // image
+	    SIZE_MAX,                         // max_size
+	    NULL,                             // pNext_for_allocate
+	    __func__,                         // caller_name
+	    &sc->fdm.mems[index],             // out_mem
+	    NULL);                            // out_size
+	VK_CHK_AND_RET(ret, "vk_alloc_and_bind_image_memory");
+
+	VkDeviceSize size = (VkDeviceSize)sc->base.fdm_width * sc->base.fdm_height * 2 * sc->fdm.layer_count;
+	bool bret = vk_buffer_init(                                                     //
+	    vk,                                                                         // vk_bundle
+	    size,                                                                       // size
+	    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,                                           // usage
+	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, // properties
+	    &sc->fdm.buffers[index],                                                    // out_buffer
+	    &sc->fdm.buffer_mems[index]);                                               // out_mem
+	if (!bret) {
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+	}
+
+	ret = vk->vkMapMemory(vk->device, sc->fdm.buffer_mems[index], 0, VK_WHOLE_SIZE, 0, &sc->fdm.mapped[index]);
+	VK_CHK_AND_RET(ret, "vkMapMemory");
+
+	VK_NAME_IMAGE(vk, sc->base.fdm_images[index], "client_vk_swapchain fragment density map");
+	VK_NAME_BUFFER(vk, sc->fdm.buffers[index], "client_vk_swapchain fragment density map staging buffer");
+
+	return VK_SUCCESS;
+}
+
+static VkResult
+record_fdm_upload_locked(struct client_vk_swapchain *sc, uint32_t index)
+{
+	struct client_vk_compositor *c = sc->c;
+	struct vk_bundle *vk = &c->vk;
+	VkCommandBuffer cmd = VK_NULL_HANDLE;
+	VkResult ret;
+
+	const VkCommandBufferUsageFlags flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+	ret = vk_cmd_pool_create_and_begin_cmd_buffer_locked(vk, &c->pool, flags, &cmd);
+	VK_CHK_AND_RET(ret, "vk_cmd_pool_create_and_begin_cmd_buffer_locked");
+	VK_NAME_COMMAND_BUFFER(vk, cmd, "client_vk_swapchain fragment density map upload command buffer");
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = sc->fdm.layer_count,
+	};
+
+	// The whole map is rewritten, so the old content can be discarded.
+	vk_cmd_image_barrier_locked(                            //
+	    vk,                                                 // vk_bundle
+	    cmd,                                                // cmd_buffer
+	    sc->base.fdm_images[index],                         // image
+	    VK_ACCESS_FRAGMENT_DENSITY_MAP_READ_BIT_EXT,        // src_access_mask
+	    VK_ACCESS_TRANSFER_WRITE_BIT,                       // dst_access_mask
+	    VK_IMAGE_LAYOUT_UNDEFINED,                          // old_image_layout
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,               // new_image_layout
+	    VK_PIPELINE_STAGE_FRAGMENT_DENSITY_PROCESS_BIT_EXT, // src_stage_mask
+	    VK_PIPELINE_STAGE_TRANSFER_BIT,                     // dst_stage_mask
+	    subresource_range);                                 // subresource_range
+
+	// Tightly packed, the layers follow each other.
+	VkBufferImageCopy region = {
+	    .bufferOffset = 0,
+	    .bufferRowLength = 0,
+	    .bufferImageHeight = 0,
+	    .imageSubresource =
+	        {
+	            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	            .mipLevel = 0,
+	            .baseArrayLayer = 0,
+	            .layerCount = sc->fdm.layer_count,
+	        },
+	    .imageExtent =
+	        {
+	            .width = sc->base.fdm_width,
+	            .height = sc->base.fdm_height,
+	            .depth = 1,
+	        },
+	};
+
+	vk->vkCmdCopyBufferToImage(               //
+	    cmd,                                  // commandBuffer
+	    sc->fdm.buffers[index],               // srcBuffer
+	    sc->base.fdm_images[index],           // dstImage
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // dstImageLayout
+	    1,                                    // regionCount
+	    &region);                             // pRegions
+
+	vk_cmd_image_barrier_locked(                            //
+	    vk,                                                 // vk_bundle
+	    cmd,                                                // cmd_buffer
+	    sc->base.fdm_images[index],                         // image
+	    VK_ACCESS_TRANSFER_WRITE_BIT,                       // src_access_mask
+	    VK_ACCESS_FRAGMENT_DENSITY_MAP_READ_BIT_EXT,        // dst_access_mask
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,               // old_image_layout
+	    VK_IMAGE_LAYOUT_FRAGMENT_DENSITY_MAP_OPTIMAL_EXT,   // new_image_layout
+	    VK_PIPELINE_STAGE_TRANSFER_BIT,                     // src_stage_mask
+	    VK_PIPELINE_STAGE_FRAGMENT_DENSITY_PROCESS_BIT_EXT, // dst_stage_mask
+	    subresource_range);                                 // subresource_range
+
+	ret = vk->vkEndCommandBuffer(cmd);
+	VK_CHK_AND_RET(ret, "vkEndCommandBuffer");
+
+	sc->fdm.upload[index] = cmd;
+
+	return VK_SUCCESS;
+}
+#endif
+
+static xrt_result_t
+create_fdm(struct client_vk_swapchain *sc, const struct xrt_swapchain_create_info *info)
+{
+#ifdef VK_EXT_fragment_density_map
+	struct client_vk_compositor *c = sc->c;
+	struct vk_bundle *vk = &c->vk;
+	VkResult ret;
+
+	sc->base.fdm_width = (info->width + FDM_TEXEL_SIZE - 1) / FDM_TEXEL_SIZE;
+	sc->base.fdm_height = (info->height + FDM_TEXEL_SIZE - 1) / FDM_TEXEL_SIZE;
+	sc->fdm.layer_count = info->array_size > 0 ? info->array_size : 1;
+
+	for (uint32_t i = 0; i < sc->base.base.image_count; i++) {
+		ret = create_fdm_image(sc, i);
+		if (ret != VK_SUCCESS) {
+			return XRT_ERROR_VULKAN;
+		}
+	}
+
+	vk_cmd_pool_lock(&c->pool);
+	for (uint32_t i = 0; i < sc->base.base.image_count; i++) {
+		ret = record_fdm_upload_locked(sc, i);
+		if (ret != VK_SUCCESS) {
+			vk_cmd_pool_unlock(&c->pool);
+			return XRT_ERROR_VULKAN;
+		}
+	}
+	vk_cmd_pool_unlock(&c->pool);
+
+	/*
+	 * The maps are left undefined, we may not touch the queue here. The
+	 * state tracker sets the foveation on every acquire instead.
+	 */
+
+	return XRT_SUCCESS;
+#else
+	return XRT_ERROR_SWAPCHAIN_FLAG_VALID_BUT_UNSUPPORTED;
+#endif
+}
+
+
 /*
  *
  * Swapchain function.
@@ -272,13 +554,43 @@ client_vk_swapchain_destroy(struct xrt_swapchain *xsc)
 	struct client_vk_compositor *c = sc->c;
 	struct vk_bundle *vk = &c->vk;
 
-	// Make sure images are not used anymore.
+	// Make sure images are not used anymore, only waits on our barriers.
 	if (BREAK_OPENXR_SPEC_IN_DESTROY_SWAPCHAIN) {
-		os_mutex_lock(&vk->queue_mutex);
-		vk->vkQueueWaitIdle(vk->queue);
-		os_mutex_unlock(&vk->queue_mutex);
+		VkFence fences[XRT_MAX_SWAPCHAIN_IMAGES * 2];
+		uint32_t fence_count = 0;
+		for (uint32_t i = 0; i < sc->base.base.image_count; i++) {
+			if (sc->acquire_fences[i] != VK_NULL_HANDLE) {
+				fences[fence_count++] = sc->acquire_fences[i];
+			}
+			if (sc->release_fences[i] != VK_NULL_HANDLE) {
+				fences[fence_count++] = sc->release_fences[i];
+			}
+		}
+		if (fence_count > 0) {
+			vk->vkWaitForFences(vk->device, fence_count, fences, VK_TRUE, UINT64_MAX);
+		}
+	}
+
+	vk_cmd_pool_lock(&c->pool);
+
+	for (uint32_t i = 0; i < sc->base.base.image_count; i++) {
+		if (c->sync.release_fence == sc->release_fences[i]) {
+			c->sync.release_fence = VK_NULL_HANDLE;
+		}
+
+		if (sc->acquire_fences[i] != VK_NULL_HANDLE) {
+			vk->vkDestroyFence(vk->device, sc->acquire_fences[i], NULL);
+			sc->acquire_fences[i] = VK_NULL_HANDLE;
+		}
+
+		if (sc->release_fences[i] != VK_NULL_HANDLE) {
+			vk->vkDestroyFence(vk->device, sc->release_fences[i], NULL);
+			sc->release_fences[i] = VK_NULL_HANDLE;
+		}
 	}
 
+	vk_cmd_pool_unlock(&c->pool);
+
 	for (uint32_t i = 0; i < sc->base.base.image_count; i++) {
 		if (sc->base.images[i] != VK_NULL_HANDLE) {
 			vk->vkDestroyImage(vk->device, sc->base.images[i], NULL);
@@ -291,6 +603,8 @@ client_vk_swapchain_destroy(struct xrt_swapchain *xsc)
 		}
 	}
 
+	destroy_fdm(sc);
+
 	// Drop our reference, does NULL checking.
 	xrt_swapchain_native_reference(&sc->xscn, NULL);
 
@@ -333,15 +647,12 @@ client_vk_swapchain_barrier_image(struct xrt_swapchain *xsc, enum xrt_barrier_di
 	COMP_TRACE_MARKER();
 
 	struct client_vk_swapchain *sc = client_vk_swapchain(xsc);
-	VkCommandBuffer cmd_buffer = VK_NULL_HANDLE;
 
 	switch (direction) {
-	case XRT_BARRIER_TO_APP: cmd_buffer = sc->acquire[index]; break;
-	case XRT_BARRIER_TO_COMP: cmd_buffer = sc->release[index]; break;
-	default: assert(false);
+	case XRT_BARRIER_TO_APP: return submit_image_barrier(sc, sc->acquire[index], sc->acquire_fences[index], false);
+	case XRT_BARRIER_TO_COMP: return submit_image_barrier(sc, sc->release[index], sc->release_fences[index], true);
+	default: assert(false); return XRT_ERROR_VULKAN;
 	}
-
-	return submit_image_barrier(sc, cmd_buffer);
 }
 
 static xrt_result_t
@@ -353,6 +664,34 @@ client_vk_swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 	return xrt_swapchain_release_image(to_native_swapchain(xsc), index);
 }
 
+static xrt_result_t
+client_vk_swapchain_set_foveation(struct xrt_swapchain *xsc, uint32_t index, const struct xrt_foveation_params *params)
+{
+	COMP_TRACE_MARKER();
+
+	struct client_vk_swapchain *sc = client_vk_swapchain(xsc);
+	uint32_t width = sc->base.fdm_width;
+	uint32_t height = sc->base.fdm_height;
+	uint8_t *texels = sc->fdm.mapped[index];
+
+	if (index >= xsc->image_count || texels == NULL) {
+		return XRT_ERROR_VULKAN;
+	}
+
+	/*
+	 * The last upload from this buffer was ordered before the application's
+	 * rendering to the image, which has completed now that the image has
+	 * been waited on, so the buffer is free to be written.
+	 */
+	for (uint32_t layer = 0; layer < sc->fdm.layer_count; layer++) {
+		// Array layers are views, a single layer is used for whichever view it is.
+		uint32_t view = layer < XRT_MAX_VIEWS ? layer : XRT_MAX_VIEWS - 1;
+		u_foveation_fill_r8g8(params, view, width, height, texels + (size_t)layer * width * height * 2);
+	}
+
+	return submit_image_barrier(sc, sc->fdm.upload[index]);
+}
+
 static xrt_result_t
 client_vk_compositor_passthrough_create(struct xrt_compositor *xc, const struct xrt_passthrough_create_info *info)
 {
@@ -516,6 +855,32 @@ client_vk_compositor_layer_stereo_projection_depth(struct xrt_compositor *xc,
 	return xrt_comp_layer_projection_depth(xcn, xdev, xscn, d_xscn, data);
 }
 
+static xrt_result_t
+client_vk_compositor_layer_projection_space_warp(struct xrt_compositor *xc,
+                                                 struct xrt_device *xdev,
+                                                 struct xrt_swapchain *xsc[XRT_MAX_VIEWS],
+                                                 struct xrt_swapchain *d_xsc[XRT_MAX_VIEWS],
+                                                 struct xrt_swapchain *mv_xsc[XRT_MAX_VIEWS],
+                                                 const struct xrt_layer_data *data)
+{
+	struct xrt_compositor *xcn;
+
+	struct xrt_swapchain *xscn[XRT_MAX_VIEWS];
+	struct xrt_swapchain *d_xscn[XRT_MAX_VIEWS];
+	struct xrt_swapchain *mv_xscn[XRT_MAX_VIEWS];
+
+	assert(data->type == XRT_LAYER_PROJECTION_DEPTH);
+
+	xcn = to_native_compositor(xc);
+	for (uint32_t i = 0; i < data->view_count; ++i) {
+		xscn[i] = to_native_swapchain(xsc[i]);
+		d_xscn[i] = to_native_swapchain(d_xsc[i]);
+		mv_xscn[i] = to_native_swapchain(mv_xsc[i]);
+	}
+
+	return xrt_comp_layer_projection_space_warp(xcn, xdev, xscn, d_xscn, mv_xscn, data);
+}
+
 static xrt_result_t
 client_vk_compositor_layer_quad(struct xrt_compositor *xc,
                                 struct xrt_device *xdev,
@@ -613,6 +978,33 @@ client_vk_compositor_layer_passthrough(struct xrt_compositor *xc,
 	return xrt_comp_layer_passthrough(&c->xcn->base, xdev, data);
 }
 
+static xrt_result_t
+client_vk_compositor_layer_batch(struct xrt_compositor *xc,
+                                 struct xrt_layer_batch_entry *entries,
+                                 uint32_t entry_count)
+{
+	COMP_TRACE_MARKER();
+
+	// Swap in the native swapchains in place, unused ones are NULL.
+	for (uint32_t i = 0; i < entry_count; i++) {
+		struct xrt_layer_batch_entry *e = &entries[i];
+
+		for (uint32_t k = 0; k < XRT_MAX_VIEWS; k++) {
+			if (e->xsc[k] != NULL) {
+				e->xsc[k] = to_native_swapchain(e->xsc[k]);
+			}
+			if (e->d_xsc[k] != NULL) {
+				e->d_xsc[k] = to_native_swapchain(e->d_xsc[k]);
+			}
+			if (e->mv_xsc[k] != NULL) {
+				e->mv_xsc[k] = to_native_swapchain(e->mv_xsc[k]);
+			}
+		}
+	}
+
+	return xrt_comp_layer_batch(to_native_compositor(xc), entries, entry_count);
+}
+
 static xrt_result_t
 client_vk_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_t sync_handle)
 {
@@ -729,6 +1121,26 @@ client_vk_swapchain_create(struct xrt_compositor *xc,
 		}
 		VK_NAME_COMMAND_BUFFER(vk, sc->release[i], "client_vk_swapchain release command buffer");
 
+		// Start signalled, the first barrier waits on them before resetting.
+		VkFenceCreateInfo fence_info = {
+		    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+		    .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+		};
+		ret = vk->vkCreateFence(vk->device, &fence_info, NULL, &sc->acquire_fences[i]);
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vkCreateFence: %s", vk_result_string(ret));
+			vk_cmd_pool_unlock(&c->pool);
+			return XRT_ERROR_VULKAN;
+		}
+		VK_NAME_FENCE(vk, sc->acquire_fences[i], "client_vk_swapchain acquire fence");
+		ret = vk->vkCreateFence(vk->device, &fence_info, NULL, &sc->release_fences[i]);
+		if (ret != VK_SUCCESS) {
+			VK_ERROR(vk, "vkCreateFence: %s", vk_result_string(ret));
+			vk_cmd_pool_unlock(&c->pool);
+			return XRT_ERROR_VULKAN;
+		}
+		VK_NAME_FENCE(vk, sc->release_fences[i], "client_vk_swapchain release fence");
+
 		VkImageSubresourceRange subresource_range = {
 		    .aspectMask = barrier_aspect_mask,
 		    .baseMipLevel = 0,
@@ -801,6 +1213,16 @@ client_vk_swapchain_create(struct xrt_compositor *xc,
 	}
 	vk_cmd_pool_unlock(&c->pool);
 
+	if ((info->create & XRT_SWAPCHAIN_CREATE_FOVEATION_FRAGMENT_DENSITY_MAP) != 0) {
+		sc->base.base.set_foveation = client_vk_swapchain_set_foveation;
+
+		xret = create_fdm(sc, &xinfo);
+		if (xret != XRT_SUCCESS) {
+			VK_ERROR(vk, "Failed to create fragment density maps: %u", xret);
+			return xret;
+		}
+	}
+
 
 	*out_xsc = &sc->base.base;
 
@@ -840,12 +1262,14 @@ client_vk_compositor_create(struct xrt_compositor_native *xcn,
 	c->base.base.layer_begin = client_vk_compositor_layer_begin;
 	c->base.base.layer_projection = client_vk_compositor_layer_projection;
 	c->base.base.layer_projection_depth = client_vk_compositor_layer_stereo_projection_depth;
+	c->base.base.layer_projection_space_warp = client_vk_compositor_layer_projection_space_warp;
 	c->base.base.layer_quad = client_vk_compositor_layer_quad;
 	c->base.base.layer_cube = client_vk_compositor_layer_cube;
 	c->base.base.layer_cylinder = client_vk_compositor_layer_cylinder;
 	c->base.base.layer_equirect1 = client_vk_compositor_layer_equirect1;
 	c->base.base.layer_equirect2 = client_vk_compositor_layer_equirect2;
 	c->base.base.layer_passthrough = client_vk_compositor_layer_passthrough;
+	c->base.base.layer_batch = client_vk_compositor_layer_batch;
 	c->base.base.layer_commit = client_vk_compositor_layer_commit;
 	c->base.base.destroy = client_vk_compositor_destroy;
 
@@ -891,10 +1315,11 @@ client_vk_compositor_create(struct xrt_compositor_native *xcn,
 	VK_NAME_COMMAND_POOL(&c->vk, c->pool.pool, "client_vk_compositor command pool");
 
 #ifdef VK_KHR_timeline_semaphore
+	// Preferred, keeps the app's work in flight, fences and waits are fallbacks.
 	if (vk_can_import_and_export_timeline_semaphore(&c->vk)) {
 		xret = setup_semaphore(c);
 		if (xret != XRT_SUCCESS) {
-			goto err_pool;
+			U_LOG_W("Native compositor can not share timeline semaphores, falling back to fences.");
 		}
 	}
 #endif
@@ -51,6 +51,31 @@ struct client_vk_swapchain
 	// Prerecorded swapchain image ownership/layout transition barriers
 	VkCommandBuffer acquire[XRT_MAX_SWAPCHAIN_IMAGES];
 	VkCommandBuffer release[XRT_MAX_SWAPCHAIN_IMAGES];
+
+	/*!
+	 * Signalled when the last submitted acquire and release barrier of each
+	 * image has completed, lets us wait on images instead of the queue.
+	 */
+	VkFence acquire_fences[XRT_MAX_SWAPCHAIN_IMAGES];
+	VkFence release_fences[XRT_MAX_SWAPCHAIN_IMAGES];
+
+	//! Fragment density maps, see @ref XRT_SWAPCHAIN_CREATE_FOVEATION_FRAGMENT_DENSITY_MAP.
+	struct
+	{
+		//! Number of array layers of each map.
+		uint32_t layer_count;
+
+		//! Memory of each map.
+		VkDeviceMemory mems[XRT_MAX_SWAPCHAIN_IMAGES];
+
+		//! Host visible staging buffer per map, persistently mapped.
+		VkBuffer buffers[XRT_MAX_SWAPCHAIN_IMAGES];
+		VkDeviceMemory buffer_mems[XRT_MAX_SWAPCHAIN_IMAGES];
+		void *mapped[XRT_MAX_SWAPCHAIN_IMAGES];
+
+		//! Prerecorded copy from the staging buffer to the map.
+		VkCommandBuffer upload[XRT_MAX_SWAPCHAIN_IMAGES];
+	} fdm;
 };
 
 /*!
@@ -73,6 +98,14 @@ struct client_vk_compositor
 		VkSemaphore semaphore;
 		struct xrt_compositor_semaphore *xcsem;
 		uint64_t value;
+
+		/*!
+		 * Fence of the last submitted release barrier, not owned and
+		 * protected by the pool lock. Queue order means all app work
+		 * submitted before it is done once it signals, waited on when
+		 * the native compositor can't be given a sync object.
+		 */
+		VkFence release_fence;
 	} sync;
 
 	struct vk_bundle vk;
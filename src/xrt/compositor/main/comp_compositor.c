@@ -58,6 +58,7 @@
 #include "util/u_handles.h"
 #include "util/u_trace_marker.h"
 #include "util/u_pretty_print.h"
+#include "util/u_startup_timeline.h"
 #include "util/u_distortion_mesh.h"
 #include "util/u_verify.h"
 
@@ -277,6 +278,11 @@ can_do_one_projection_layer_fast_path(struct comp_compositor *c)
 		return false;
 	}
 
+	// The motion vectors are applied when squashing the layers.
+	if ((layer->data.flags & XRT_LAYER_COMPOSITION_SPACE_WARP_BIT) != 0) {
+		return false;
+	}
+
 	return true;
 }
 
@@ -295,7 +301,6 @@ compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_t sy
 	 */
 	bool fast_path =                              //
 	    !c->peek &&                               //
-	    !c->mirroring_to_debug_gui &&             //
 	    !c->debug.disable_fast_path &&            //
 	    can_do_one_projection_layer_fast_path(c); //
 	c->base.slot.one_projection_layer_fast_path = fast_path;
@@ -353,6 +358,11 @@ compositor_destroy(struct xrt_compositor *xc)
 	// Need to do this as early as possible.
 	u_var_remove_root(c);
 
+	// Async timewarp may still be squashing into the scratch images.
+	if (c->r != NULL) {
+		comp_renderer_wait_idle(c->r);
+	}
+
 	// Destroy any Vulkan resources, even if not used.
 	for (uint32_t i = 0; i < ARRAY_SIZE(c->scratch.views); i++) {
 		comp_scratch_single_images_free(&c->scratch.views[i], &c->base.vk);
@@ -556,6 +566,12 @@ static const char *optional_device_extensions[] = {
 #ifdef VK_EXT_robustness2
     VK_EXT_ROBUSTNESS_2_EXTENSION_NAME,
 #endif
+#ifdef VK_EXT_memory_budget
+    VK_EXT_MEMORY_BUDGET_EXTENSION_NAME,
+#endif
+#ifdef VK_EXT_image_compression_control
+    VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME,
+#endif
 #ifdef VK_EXT_display_control
     VK_EXT_DISPLAY_CONTROL_EXTENSION_NAME,
 #endif
@@ -644,6 +660,7 @@ compositor_init_vulkan(struct comp_compositor *c)
 	    .selected_gpu_index = c->settings.selected_gpu_index,
 	    .client_gpu_index = c->settings.client_gpu_index,
 	    .timeline_semaphore = true, // Flag is optional, not a hard requirement.
+	    .async_queue = c->settings.async_timewarp,
 	};
 
 	struct comp_vulkan_results vk_res = {0};
@@ -715,6 +732,9 @@ const struct comp_target_factory *ctfs[] = {
 #ifdef VK_USE_PLATFORM_DISPLAY_KHR
     &comp_target_factory_vk_display,
 #endif
+#if defined(XRT_HAVE_GST) && defined(XRT_OS_LINUX)
+    &comp_target_factory_stream,
+#endif
 };
 
 static void
@@ -912,14 +932,24 @@ compositor_init_render_resources(struct comp_compositor *c)
 
 	struct vk_bundle *vk = get_vk(c);
 
-	if (!render_shaders_load(&c->shaders, vk)) {
+	int32_t phase = u_startup_timeline_begin("Load shaders");
+	bool bret = render_shaders_load(&c->shaders, vk);
+	u_startup_timeline_end(phase);
+	if (!bret) {
 		return false;
 	}
 
-	if (!render_resources_init(&c->nr, &c->shaders, get_vk(c), c->xdev)) {
+	phase = u_startup_timeline_begin("Init render resources");
+	bret = render_resources_init(&c->nr, &c->shaders, get_vk(c), c->xdev);
+	u_startup_timeline_end(phase);
+	if (!bret) {
 		return false;
 	}
 
+	c->nr.compute.distortion.foveation.enabled = c->settings.foveated_distortion;
+	c->nr.compute.distortion.foveation.inner_radius = c->settings.foveation_inner_radius;
+	c->nr.compute.distortion.foveation.outer_radius = c->settings.foveation_outer_radius;
+
 	return true;
 }
 
@@ -981,6 +1011,7 @@ comp_main_create_system_compositor(struct xrt_device *xdev,
 	// Init these before the renderer, not all might be used.
 	for (uint32_t i = 0; i < ARRAY_SIZE(c->scratch.views); i++) {
 		comp_scratch_single_images_init(&c->scratch.views[i]);
+		c->scratch.views[i].compression = c->settings.scratch_compression;
 	}
 
 	c->last_frame_time_ns = os_monotonic_get_ns();
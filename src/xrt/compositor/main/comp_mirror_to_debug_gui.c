@@ -10,9 +10,17 @@
 
 #include "xrt/xrt_results.h"
 #include "math/m_mathinclude.h"
+#include "util/u_debug.h"
 #include "main/comp_mirror_to_debug_gui.h"
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(zero_copy, "XRT_COMPOSITOR_MIRROR_ZERO_COPY", false)
+DEBUG_GET_ONCE_NUM_OPTION(push_every_x_frames, "XRT_COMPOSITOR_MIRROR_PUSH_EVERY_X_FRAMES", 2)
+
+//! The debug gui may still show one image while the next is blitted to.
+#define ZERO_COPY_IMAGE_COUNT (2)
+
+
 /*
  *
  * Helper functions.
@@ -269,6 +277,13 @@ comp_mirror_init(struct comp_mirror_to_debug_gui *m,
 	// Do this init as early as possible.
 	u_sink_debug_init(&m->debug_sink);
 
+	// Also needs to be done before any error path.
+	m->zero_copy.enabled = debug_get_bool_option_zero_copy();
+	if (m->zero_copy.enabled) {
+		comp_scratch_single_images_init(&m->zero_copy.images);
+		m->zero_copy.images.category = VK_MEMORY_CATEGORY_MIRROR;
+	}
+
 	double orig_width = extent.width;
 	double orig_height = extent.height;
 
@@ -293,15 +308,23 @@ comp_mirror_init(struct comp_mirror_to_debug_gui *m,
 	    XRT_FORMAT_R8G8B8X8,             // xrt_format
 	    VK_FORMAT_R8G8B8A8_UNORM);       // vk_format
 
-	ret = vk_cmd_pool_init(vk, &m->cmd_pool, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+	// Only used from the compositor thread and each readback is waited on.
+	ret = vk_cmd_pool_init_ring(vk, &m->cmd_pool, 1);
 	if (ret != VK_SUCCESS) {
-		VK_ERROR(vk, "vk_cmd_pool_init: %s", vk_result_string(ret));
+		VK_ERROR(vk, "vk_cmd_pool_init_ring: %s", vk_result_string(ret));
 		comp_mirror_fini(m, vk);
 		return ret;
 	}
 
 	VK_NAME_COMMAND_POOL(vk, m->cmd_pool.pool, "comp_mirror_to_debug_gui command pool");
 
+	if (m->zero_copy.enabled &&
+	    !comp_scratch_single_images_ensure(&m->zero_copy.images, vk, m->image_extent, ZERO_COPY_IMAGE_COUNT)) {
+		VK_ERROR(vk, "comp_scratch_single_images_ensure: false");
+		comp_mirror_fini(m, vk);
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+	}
+
 	struct vk_descriptor_pool_info blit_pool_info = {
 	    .uniform_per_descriptor_count = 0,
 	    .sampler_per_descriptor_count = 1,
@@ -351,7 +374,7 @@ void
 comp_mirror_add_debug_vars(struct comp_mirror_to_debug_gui *m, struct comp_compositor *c)
 {
 	// Reset state.
-	m->push_every_frame_out_of_X = 2;
+	m->push_every_frame_out_of_X = (int)debug_get_num_option_push_every_x_frames();
 
 	// Init widigts.
 	u_frame_times_widget_init(&m->push_frame_times, 0.f, 0.f);
@@ -366,7 +389,11 @@ comp_mirror_add_debug_vars(struct comp_mirror_to_debug_gui *m, struct comp_compo
 	u_var_add_ro_f32(m, &m->push_frame_times.fps, "FPS (Readback)");
 	u_var_add_f32_timing(m, m->push_frame_times.debug_var, "Frame Times (Readback)");
 
-	u_var_add_sink_debug(m, &m->debug_sink, "Left view!");
+	if (m->zero_copy.enabled) {
+		u_var_add_native_images_debug(m, &m->zero_copy.images.unid, "Left view!");
+	} else {
+		u_var_add_sink_debug(m, &m->debug_sink, "Left view!");
+	}
 }
 
 void
@@ -391,7 +418,9 @@ comp_mirror_is_ready_and_active(struct comp_mirror_to_debug_gui *m,
                                 struct comp_compositor *c,
                                 uint64_t predicted_display_time_ns)
 {
-	if (!c->mirroring_to_debug_gui || !u_sink_debug_is_active(&m->debug_sink)) {
+	// Can't tell if the zero copy images are looked at, the toggle has to do.
+	bool has_consumer = m->zero_copy.enabled || u_sink_debug_is_active(&m->debug_sink);
+	if (!c->mirroring_to_debug_gui || !has_consumer) {
 		return false;
 	}
 
@@ -414,6 +443,7 @@ comp_mirror_is_ready_and_active(struct comp_mirror_to_debug_gui *m,
 XRT_CHECK_RESULT xrt_result_t
 comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
                     struct vk_bundle *vk,
+                    struct render_resources *r,
                     uint64_t frame_id,
                     uint64_t predicted_display_time_ns,
                     VkImage from_image,
@@ -428,7 +458,10 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 
 	struct vk_image_readback_to_xf *wrap = NULL;
 
-	if (!vk_image_readback_to_xf_pool_get_unused_frame(vk, m->pool, &wrap)) {
+	// No readback is done in zero copy mode.
+	bool zero_copy = m->zero_copy.enabled;
+
+	if (!zero_copy && !vk_image_readback_to_xf_pool_get_unused_frame(vk, m->pool, &wrap)) {
 		return XRT_ERROR_VULKAN;
 	}
 
@@ -451,19 +484,30 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 
 	struct vk_cmd_pool *pool = &m->cmd_pool;
 
-	// For writing and submitting commands.
-	vk_cmd_pool_lock(pool);
-
+	// Ring mode pool owned by this thread, no need to lock it.
 	VkCommandBuffer cmd;
-	ret = vk_cmd_pool_create_and_begin_cmd_buffer_locked(vk, pool, 0, &cmd);
+	ret = vk_cmd_pool_ring_begin_cmd_buffer(vk, pool, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, &cmd);
 	if (ret != VK_SUCCESS) {
 		vk->vkResetDescriptorPool(vk->device, m->blit.descriptor_pool, 0);
-		vk_cmd_pool_unlock(pool);
 		return XRT_ERROR_VULKAN;
 	}
 
 	VK_NAME_COMMAND_BUFFER(vk, cmd, "comp_mirror_to_debug_ui command buffer");
 
+	// Where the blit goes, the bounce image unless doing zero copy.
+	VkImage blit_image = m->bounce.image;
+	VkImageView blit_view = m->bounce.unorm_view;
+
+	if (zero_copy) {
+		uint32_t index = 0;
+		comp_scratch_single_images_get(&m->zero_copy.images, &index);
+
+		blit_image = m->zero_copy.images.images[index].image;
+		blit_view = m->zero_copy.images.images[index].unorm_view;
+	}
+
+	render_resources_cmd_write_phase_timestamp(r, cmd, RENDER_TIMESTAMP_PHASE_MIRROR, 0, false);
+
 	// Barrier arguments.
 	VkImageSubresourceRange first_color_level_subresource_range = {
 	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
@@ -473,18 +517,18 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 	    .layerCount = 1,
 	};
 
-	// First mip view into the bounce image.
+	// First mip view into the bounce image, or zero copy image.
 	struct vk_cmd_first_mip_image bounce_fm_image = {
 	    .aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT,
 	    .base_array_layer = 0,
-	    .image = m->bounce.image,
+	    .image = blit_image,
 	};
 
-	// First mip view into the target image.
+	// First mip view into the target image, not used with zero copy.
 	struct vk_cmd_first_mip_image target_fm_image = {
 	    .aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT,
 	    .base_array_layer = 0,
-	    .image = wrap->image,
+	    .image = wrap != NULL ? wrap->image : VK_NULL_HANDLE,
 	};
 
 	VkImageLayout old_layout;
@@ -545,7 +589,7 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 		    vk,                     //
 		    from_sampler,           //
 		    from_view,              //
-		    m->bounce.unorm_view,   //
+		    blit_view,              //
 		    descriptor_set);        //
 
 		vk->vkCmdBindPipeline(              //
@@ -591,56 +635,72 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 		src_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 	}
 
-	// Copy arguments.
-	struct vk_cmd_copy_image_info copy_info = {
-	    .src.old_layout = old_layout,
-	    .src.src_access_mask = src_access_mask,
-	    .src.src_stage_mask = src_stage_mask,
-	    .src.fm_image = bounce_fm_image,
+	// The debug gui samples the zero copy image directly from GENERAL layout.
+	if (!zero_copy) {
+		// Copy arguments.
+		struct vk_cmd_copy_image_info copy_info = {
+		    .src.old_layout = old_layout,
+		    .src.src_access_mask = src_access_mask,
+		    .src.src_stage_mask = src_stage_mask,
+		    .src.fm_image = bounce_fm_image,
+
+		    .dst.old_layout = wrap->layout,
+		    .dst.src_access_mask = VK_ACCESS_HOST_READ_BIT,
+		    .dst.src_stage_mask = VK_PIPELINE_STAGE_HOST_BIT,
+		    .dst.fm_image = target_fm_image,
+
+		    .size.w = m->image_extent.width,
+		    .size.h = m->image_extent.height,
+		};
 
-	    .dst.old_layout = wrap->layout,
-	    .dst.src_access_mask = VK_ACCESS_HOST_READ_BIT,
-	    .dst.src_stage_mask = VK_PIPELINE_STAGE_HOST_BIT,
-	    .dst.fm_image = target_fm_image,
+		vk_cmd_copy_image_locked(vk, cmd, &copy_info);
 
-	    .size.w = m->image_extent.width,
-	    .size.h = m->image_extent.height,
-	};
+		// Barrier readback image to host so we can safely read
+		vk_cmd_image_barrier_locked(              //
+		    vk,                                   // vk_bundle
+		    cmd,                                  // cmdbuffer
+		    wrap->image,                          // image
+		    VK_ACCESS_TRANSFER_WRITE_BIT,         // srcAccessMask
+		    VK_ACCESS_HOST_READ_BIT,              // dstAccessMask
+		    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // oldImageLayout
+		    VK_IMAGE_LAYOUT_GENERAL,              // newImageLayout
+		    VK_PIPELINE_STAGE_TRANSFER_BIT,       // srcStageMask
+		    VK_PIPELINE_STAGE_HOST_BIT,           // dstStageMask
+		    first_color_level_subresource_range); // subresourceRange
+	}
 
-	vk_cmd_copy_image_locked(vk, cmd, &copy_info);
-
-	// Barrier readback image to host so we can safely read
-	vk_cmd_image_barrier_locked(              //
-	    vk,                                   // vk_bundle
-	    cmd,                                  // cmdbuffer
-	    wrap->image,                          // image
-	    VK_ACCESS_TRANSFER_WRITE_BIT,         // srcAccessMask
-	    VK_ACCESS_HOST_READ_BIT,              // dstAccessMask
-	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // oldImageLayout
-	    VK_IMAGE_LAYOUT_GENERAL,              // newImageLayout
-	    VK_PIPELINE_STAGE_TRANSFER_BIT,       // srcStageMask
-	    VK_PIPELINE_STAGE_HOST_BIT,           // dstStageMask
-	    first_color_level_subresource_range); // subresourceRange
+	render_resources_cmd_write_phase_timestamp(r, cmd, RENDER_TIMESTAMP_PHASE_MIRROR, 0, true);
 
 	// This takes a long time so make sure to trace it.
 	COMP_TRACE_BEGIN(submit_and_wait);
 
 	// Done writing commands, submit to queue, waits for command to finish.
-	ret = vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked(vk, pool, cmd);
+	ret = vk_cmd_pool_ring_end_and_submit_cmd_buffer(vk, pool, cmd, true);
 
 	// Stop this block.
 	COMP_TRACE_END(submit_and_wait);
 
-	// Done with everything, can unlock the pool now.
-	vk_cmd_pool_unlock(pool);
-
 	// Check results from submit.
 	if (ret != VK_SUCCESS) {
 		//! @todo Better handling of error?
-		VK_ERROR(vk, "vk_cmd_pool_end_submit_wait_and_free_cmd_buffer_locked: %s", vk_result_string(ret));
+		VK_ERROR(vk, "vk_cmd_pool_ring_end_and_submit_cmd_buffer: %s", vk_result_string(ret));
+		if (zero_copy) {
+			comp_scratch_single_images_discard(&m->zero_copy.images);
+		}
 		return XRT_ERROR_VULKAN;
 	}
 
+	if (zero_copy) {
+		// The commands have completed, safe to show in the debug gui.
+		comp_scratch_single_images_done(&m->zero_copy.images);
+
+		u_frame_times_widget_push_sample(&m->push_frame_times, predicted_display_time_ns);
+
+		// Tidies the descriptor we created.
+		vk->vkResetDescriptorPool(vk->device, m->blit.descriptor_pool, 0);
+		return XRT_SUCCESS;
+	}
+
 	wrap->base_frame.source_timestamp = wrap->base_frame.timestamp = predicted_display_time_ns;
 	wrap->base_frame.source_sequence = frame_id;
 
@@ -655,7 +715,7 @@ comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
 
 	// Tidies the descriptor we created.
 	vk->vkResetDescriptorPool(vk->device, m->blit.descriptor_pool, 0);
-	return XRT_ERROR_VULKAN;
+	return XRT_SUCCESS;
 }
 
 void
@@ -664,6 +724,13 @@ comp_mirror_fini(struct comp_mirror_to_debug_gui *m, struct vk_bundle *vk)
 	// Remove u_var root as early as possible.
 	u_var_remove_root(m);
 
+	// Nothing refers to the images once the root is removed.
+	if (m->zero_copy.enabled) {
+		comp_scratch_single_images_free(&m->zero_copy.images, vk);
+		comp_scratch_single_images_destroy(&m->zero_copy.images);
+		m->zero_copy.enabled = false;
+	}
+
 	// Left eye readback
 	vk_image_readback_to_xf_pool_destroy(vk, &m->pool);
 
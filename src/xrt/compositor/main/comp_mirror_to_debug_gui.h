@@ -14,6 +14,8 @@
 #include "util/u_sink.h"
 #include "vk/vk_image_readback_to_xf_pool.h"
 
+#include "util/comp_scratch.h"
+
 #include "main/comp_compositor.h"
 
 
@@ -73,6 +75,18 @@ struct comp_mirror_to_debug_gui
 	} blit;
 
 	struct vk_cmd_pool cmd_pool;
+
+	/*!
+	 * Zero copy mode, the blit goes into exportable images that the debug
+	 * gui imports directly, instead of being read back to the CPU.
+	 */
+	struct
+	{
+		bool enabled;
+
+		//! Shown through its u_native_images_debug, only valid if enabled.
+		struct comp_scratch_single_images images;
+	} zero_copy;
 };
 
 /*!
@@ -114,13 +128,15 @@ comp_mirror_is_ready_and_active(struct comp_mirror_to_debug_gui *m,
                                 uint64_t predicted_display_time_ns);
 
 /*!
- * Do the blit.
+ * Do the blit, the GPU time is recorded in the mirror phase timestamps of
+ * @p r so it should be the same resources that the frame was rendered with.
  *
  * @public @memberof comp_mirror_to_debug_gui
  */
 XRT_CHECK_RESULT xrt_result_t
 comp_mirror_do_blit(struct comp_mirror_to_debug_gui *m,
                     struct vk_bundle *vk,
+                    struct render_resources *r,
                     uint64_t frame_id,
                     uint64_t predicted_display_time_ns,
                     VkImage from_image,
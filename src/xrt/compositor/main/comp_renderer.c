@@ -21,12 +21,17 @@
 #include "math/m_api.h"
 #include "math/m_matrix_2x2.h"
 #include "math/m_space.h"
+#include "math/m_vec3.h"
 
 #include "util/u_misc.h"
+#include "util/u_metrics.h"
+#include "util/u_latency_probe.h"
 #include "util/u_trace_marker.h"
 #include "util/u_distortion_mesh.h"
 #include "util/u_sink.h"
+#include "util/u_startup_timeline.h"
 #include "util/u_var.h"
+#include "util/u_worker.h"
 #include "util/u_frame_times_widget.h"
 
 #include "util/comp_render.h"
@@ -88,6 +93,38 @@ enum comp_target_fov_source
 	COMP_TARGET_FOV_SOURCE_DEVICE_VIEWS,
 };
 
+/*!
+ * A view of a layer squash done for async timewarp or kept by the static layer
+ * cache, what is needed to timewarp from its scratch image later on.
+ */
+struct comp_async_squash_view
+{
+	//! Index of the scratch image for this view.
+	uint32_t index;
+
+	//! The pose the layers was squashed at.
+	struct xrt_pose world_pose;
+
+	//! The fov the layers was squashed with.
+	struct xrt_fov fov;
+};
+
+/*!
+ * What the static layer cache remembers of a squashed layer, if all of it is
+ * the same the layer will look the same when squashed again.
+ */
+struct comp_static_layer
+{
+	//! The layer data, with the timestamp cleared as it changes every frame.
+	struct xrt_layer_data data;
+
+	//! Which swapchains, by id as the memory of destroyed ones is reused.
+	uint64_t ids[XRT_MAX_VIEWS * 3];
+
+	//! How many times the swapchains had released images.
+	int32_t release_counts[XRT_MAX_VIEWS * 3];
+};
+
 /*!
  * Holds associated vulkan objects and state to render with a distortion.
  *
@@ -117,6 +154,87 @@ struct comp_renderer
 		} views[XRT_MAX_VIEWS];
 	} scratch;
 
+	/*!
+	 * Async timewarp, see @ref comp_settings::async_timewarp. Layers are
+	 * squashed into the scratch images on @ref vk_bundle::queue, while all
+	 * distortion and presenting is done on @ref vk_bundle::async_queue
+	 * from the last squash that has completed. A squash can stay in flight
+	 * over multiple frames, a new one is only started once it completes.
+	 */
+	struct
+	{
+		//! Decided at init, needs the settings and the queue.
+		bool enabled;
+
+		//! Signalled when the squash in flight has completed.
+		VkFence fence;
+
+		//! Resources of the squash in flight, only valid if @ref pending.
+		struct render_compute crc;
+
+		//! Is there a squash in flight, the scratch images are gotten while true.
+		bool pending;
+
+		//! Views of the squash in flight.
+		struct comp_async_squash_view pending_views[XRT_MAX_VIEWS];
+
+		//! Is there a completed squash in @ref last_views.
+		bool have_last;
+
+		//! Views of the last completed squash.
+		struct comp_async_squash_view last_views[XRT_MAX_VIEWS];
+
+		//! How long the last timewarp took on the GPU, used for the deadline.
+		uint64_t timewarp_gpu_ns;
+	} async;
+
+	/*!
+	 * Static layer cache, see @ref comp_settings::static_layer_cache. When
+	 * the layers are the same as the ones last squashed, the squash is
+	 * skipped and the distortion timewarps from the last scratch images.
+	 */
+	struct
+	{
+		//! Decided at init, not used with async timewarp.
+		bool enabled;
+
+		//! Do the scratch images in @ref views hold the squash of @ref layers.
+		bool valid;
+
+		//! Are all of the layers in view space, they then don't need any timewarp.
+		bool view_space;
+
+		//! Number of layers in @ref layers.
+		uint32_t layer_count;
+
+		//! The layers last squashed.
+		struct comp_static_layer layers[RENDER_MAX_LAYERS];
+
+		//! Views of the last squash.
+		struct comp_async_squash_view views[XRT_MAX_VIEWS];
+	} static_layers;
+
+	/*!
+	 * Records the layer squash of the views in parallel, only created if
+	 * @ref comp_settings::parallel_record is set and there is more than one view.
+	 */
+	struct u_worker_group *record_group;
+
+	//! Has a frame been presented, the first one goes on the startup timeline.
+	bool presented;
+
+	//! Latency from the head pose being sampled to the frame being shown.
+	struct
+	{
+		//! See @ref u_latency_probe_enabled, decided at init.
+		bool enabled;
+
+		//! When the head pose for the frame being rendered was last sampled.
+		uint64_t pose_sampled_ns;
+
+		struct u_latency_probe probe;
+	} latency;
+
 	//! @}
 
 	//! @name Image-dependent members
@@ -198,12 +316,356 @@ scratch_get_fini(struct comp_render_scratch_state *crss, struct comp_renderer *r
 	}
 }
 
+
+/*
+ *
+ * Async timewarp helpers.
+ *
+ */
+
+static void
+async_init(struct comp_renderer *r)
+{
+	struct vk_bundle *vk = &r->c->base.vk;
+
+	if (!r->settings->async_timewarp) {
+		return;
+	}
+
+	if (vk->async_queue == VK_NULL_HANDLE) {
+		COMP_WARN(r->c, "No async queue could be created, async timewarp disabled!");
+		return;
+	}
+
+	VkFenceCreateInfo fence_info = {
+	    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+	};
+
+	VkResult ret = vk->vkCreateFence( //
+	    vk->device,                   //
+	    &fence_info,                  //
+	    NULL,                         //
+	    &r->async.fence);             //
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(r->c, "vkCreateFence: %s", vk_result_string(ret));
+		return;
+	}
+
+	VK_NAME_FENCE(vk, r->async.fence, "Comp Renderer async squash");
+
+	r->async.enabled = true;
+
+	COMP_INFO(r->c, "Using async timewarp.");
+}
+
+/*!
+ * Wait for the squash in flight until @p deadline_ns, if it completes its
+ * scratch images becomes the last completed squash. Returns true if there
+ * is no longer any squash in flight.
+ */
+static bool
+async_wait_squash(struct comp_renderer *r, uint64_t deadline_ns)
+{
+	COMP_TRACE_MARKER();
+
+	struct comp_compositor *c = r->c;
+	struct vk_bundle *vk = &c->base.vk;
+
+	if (!r->async.pending) {
+		return true;
+	}
+
+	uint64_t now_ns = os_monotonic_get_ns();
+	uint64_t timeout_ns = deadline_ns > now_ns ? deadline_ns - now_ns : 0;
+
+	VkResult ret = vk->vkWaitForFences(vk->device, 1, &r->async.fence, VK_TRUE, timeout_ns);
+	if (ret == VK_TIMEOUT) {
+		return false;
+	}
+	if (ret != VK_SUCCESS) {
+		// Nothing we can do, treat it as done so we don't get stuck.
+		COMP_ERROR(c, "vkWaitForFences: %s", vk_result_string(ret));
+	}
+
+	render_compute_close(&r->async.crc);
+
+	for (uint32_t i = 0; i < c->nr.view_count; i++) {
+		comp_scratch_single_images_done(&c->scratch.views[i]);
+		r->async.last_views[i] = r->async.pending_views[i];
+	}
+
+	r->async.pending = false;
+	r->async.have_last = true;
+
+	return true;
+}
+
+static void
+async_fini(struct comp_renderer *r)
+{
+	struct vk_bundle *vk = &r->c->base.vk;
+
+	if (!r->async.enabled) {
+		return;
+	}
+
+	async_wait_squash(r, UINT64_MAX);
+
+	vk->vkDestroyFence(vk->device, r->async.fence, NULL);
+	r->async.fence = VK_NULL_HANDLE;
+	r->async.enabled = false;
+}
+
+
+/*
+ *
+ * Static layer cache helpers.
+ *
+ */
+
+/*!
+ * How far the head may move before static layers are squashed again, the
+ * timewarp only handles rotation so this shows up as parallax error.
+ */
+#define STATIC_LAYER_MAX_TRANSLATION_M (0.001f)
+
+/*!
+ * How far the head may turn before static layers are squashed again, the
+ * scratch images only cover the fov so this shows up as black edges.
+ */
+#define STATIC_LAYER_MAX_ROTATION_RAD (2.0f * (float)M_PI / 180.0f)
+
+static bool
+static_layer_is_cacheable(const struct comp_layer *layer)
+{
+	switch (layer->data.type) {
+	case XRT_LAYER_CYLINDER:
+	case XRT_LAYER_EQUIRECT2:
+	case XRT_LAYER_PROJECTION:
+	case XRT_LAYER_QUAD: return true;
+	default: return false; // Depth layers may be extrapolated by space warp.
+	}
+}
+
+static void
+static_layer_init(struct comp_static_layer *csl, const struct comp_layer *layer)
+{
+	U_ZERO(csl);
+
+	csl->data = layer->data;
+	csl->data.timestamp = 0;
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(layer->sc_array); i++) {
+		struct comp_swapchain *sc = layer->sc_array[i];
+		if (sc == NULL) {
+			continue;
+		}
+
+		csl->ids[i] = sc->base.limited_unique_id.data;
+		csl->release_counts[i] = xrt_atomic_s32_cmpxchg(&sc->release_count, 0, 0);
+	}
+}
+
+/*!
+ * Compared as bytes, padding that differs only makes the layer be squashed
+ * again which is always safe.
+ */
+static bool
+static_layer_is_same(const struct comp_static_layer *csl, const struct comp_layer *layer)
+{
+	struct comp_static_layer tmp;
+	static_layer_init(&tmp, layer);
+
+	return memcmp(&tmp, csl, sizeof(tmp)) == 0;
+}
+
+static bool
+static_layers_head_is_still(const struct comp_renderer *r, const struct xrt_pose *world_poses, uint32_t view_count)
+{
+	const float min_dot = cosf(STATIC_LAYER_MAX_ROTATION_RAD / 2.0f);
+
+	for (uint32_t i = 0; i < view_count; i++) {
+		const struct xrt_pose *old_pose = &r->static_layers.views[i].world_pose;
+		const struct xrt_pose *new_pose = &world_poses[i];
+
+		struct xrt_vec3 diff = m_vec3_sub(new_pose->position, old_pose->position);
+		if (m_vec3_len(diff) > STATIC_LAYER_MAX_TRANSLATION_M) {
+			return false;
+		}
+
+		// Half the angle between the orientations, either sign is the same rotation.
+		const struct xrt_quat *a = &old_pose->orientation;
+		const struct xrt_quat *b = &new_pose->orientation;
+		float dot = fabsf(a->x * b->x + a->y * b->y + a->z * b->z + a->w * b->w);
+		if (dot < min_dot) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*!
+ * Can the scratch images from the last squash be used for this frame, the
+ * layers needs to be the same and either all in view space or all in world
+ * space with the head not having moved too far.
+ */
+static bool
+static_layers_can_reuse(struct comp_renderer *r,
+                        const struct xrt_fov *fovs,
+                        const struct xrt_pose *world_poses,
+                        uint32_t view_count)
+{
+	struct comp_compositor *c = r->c;
+	const struct comp_layer *layers = c->base.slot.layers;
+	uint32_t layer_count = c->base.slot.layer_count;
+
+	if (!r->static_layers.valid || r->static_layers.layer_count != layer_count) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < layer_count; i++) {
+		if (!static_layer_is_same(&r->static_layers.layers[i], &layers[i])) {
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < view_count; i++) {
+		if (memcmp(&r->static_layers.views[i].fov, &fovs[i], sizeof(fovs[i])) != 0) {
+			return false;
+		}
+	}
+
+	return r->static_layers.view_space || static_layers_head_is_still(r, world_poses, view_count);
+}
+
+/*!
+ * Remember the layers that was just squashed into the scratch images, if
+ * they can be cached at all.
+ */
+static void
+static_layers_store(struct comp_renderer *r,
+                    const struct comp_render_scratch_state *crss,
+                    const struct xrt_fov *fovs,
+                    const struct xrt_pose *world_poses,
+                    uint32_t view_count)
+{
+	struct comp_compositor *c = r->c;
+	const struct comp_layer *layers = c->base.slot.layers;
+	uint32_t layer_count = c->base.slot.layer_count;
+
+	r->static_layers.valid = false;
+
+	if (layer_count == 0 || layer_count > ARRAY_SIZE(r->static_layers.layers)) {
+		return;
+	}
+
+	uint32_t view_space_count = 0;
+	for (uint32_t i = 0; i < layer_count; i++) {
+		if (!static_layer_is_cacheable(&layers[i])) {
+			return;
+		}
+		if ((layers[i].data.flags & XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT) != 0) {
+			view_space_count++;
+		}
+	}
+
+	// A mix of head and world locked layers can't be timewarped as one.
+	if (view_space_count != 0 && view_space_count != layer_count) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < layer_count; i++) {
+		static_layer_init(&r->static_layers.layers[i], &layers[i]);
+	}
+
+	for (uint32_t i = 0; i < view_count; i++) {
+		r->static_layers.views[i] = (struct comp_async_squash_view){
+		    .index = crss->views[i].index,
+		    .world_pose = world_poses[i],
+		    .fov = fovs[i],
+		};
+	}
+
+	r->static_layers.layer_count = layer_count;
+	r->static_layers.view_space = view_space_count == layer_count;
+	r->static_layers.valid = true;
+}
+
+/*!
+ * Checks if the last squash can be reused, if so the scratch images in @p crss
+ * are switched to the ones holding it, they are only read from this frame.
+ */
+static bool
+static_layers_begin(struct comp_renderer *r,
+                    struct comp_render_scratch_state *crss,
+                    const struct xrt_fov *fovs,
+                    const struct xrt_pose *world_poses,
+                    uint32_t view_count)
+{
+	struct comp_compositor *c = r->c;
+
+	if (!r->static_layers.enabled) {
+		return false;
+	}
+
+	// The fast path and clearing doesn't touch the scratch images, so can keep it.
+	if (c->base.slot.one_projection_layer_fast_path || c->base.slot.layer_count == 0) {
+		return false;
+	}
+
+	if (!static_layers_can_reuse(r, fovs, world_poses, view_count)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < view_count; i++) {
+		crss->views[i].index = r->static_layers.views[i].index;
+	}
+
+	return true;
+}
+
+/*!
+ * Called once the frame has been submitted, remembers a new squash.
+ */
+static void
+static_layers_end(struct comp_renderer *r,
+                  const struct comp_render_scratch_state *crss,
+                  bool reused,
+                  const struct xrt_fov *fovs,
+                  const struct xrt_pose *world_poses,
+                  uint32_t view_count)
+{
+	if (!r->static_layers.enabled || reused) {
+		return;
+	}
+
+	// Nothing new in the scratch images, what they hold stays valid.
+	if (!crss->views[0].used) {
+		return;
+	}
+
+	static_layers_store(r, crss, fovs, world_poses, view_count);
+}
+
+
 /*
  *
  * Functions.
  *
  */
 
+/*!
+ * The queue that distortion is submitted to and that presents are done on.
+ */
+static VkQueue
+renderer_get_queue(struct comp_renderer *r)
+{
+	struct vk_bundle *vk = &r->c->base.vk;
+
+	return r->async.enabled ? vk->async_queue : vk->queue;
+}
+
 static void
 renderer_wait_queue_idle(struct comp_renderer *r)
 {
@@ -211,7 +673,7 @@ renderer_wait_queue_idle(struct comp_renderer *r)
 	struct vk_bundle *vk = &r->c->base.vk;
 
 	os_mutex_lock(&vk->queue_mutex);
-	vk->vkQueueWaitIdle(vk->queue);
+	vk->vkQueueWaitIdle(renderer_get_queue(r));
 	os_mutex_unlock(&vk->queue_mutex);
 }
 
@@ -309,6 +771,9 @@ calc_pose_data(struct comp_renderer *r,
 	struct xrt_fov xdev_fovs[XRT_MAX_VIEWS] = XRT_STRUCT_INIT;
 	struct xrt_pose xdev_poses[XRT_MAX_VIEWS] = XRT_STRUCT_INIT;
 
+	// Late latching samples again, so this ends up being the latest sample.
+	r->latency.pose_sampled_ns = os_monotonic_get_ns();
+
 	xrt_device_get_view_poses(                           //
 	    r->c->xdev,                                      // xdev
 	    &default_eye_relation,                           // default_eye_relation
@@ -351,6 +816,34 @@ calc_pose_data(struct comp_renderer *r,
 	}
 }
 
+/*!
+ * Samples the pose again and rewrites the timewarp matrices that @p crc has
+ * recorded, called right before submit to cut the latency of the time spent
+ * recording the command buffer.
+ */
+static void
+late_latch_timewarp(struct comp_renderer *r, struct render_compute *crc, enum comp_target_fov_source fov_source)
+{
+	if (!r->c->settings.late_latch || !crc->late_latch.valid) {
+		return;
+	}
+
+	COMP_TRACE_MARKER();
+
+	struct xrt_fov fovs[XRT_MAX_VIEWS];
+	struct xrt_pose world_poses[XRT_MAX_VIEWS];
+	struct xrt_pose eye_poses[XRT_MAX_VIEWS];
+	calc_pose_data(          //
+	    r,                   // r
+	    fov_source,          // fov_source
+	    fovs,                // fovs
+	    world_poses,         // world_poses
+	    eye_poses,           // eye_poses
+	    crc->r->view_count); // view_count
+
+	render_compute_late_latch_timewarp(crc, world_poses);
+}
+
 //! @pre comp_target_has_images(r->c->target)
 static void
 renderer_build_rendering_target_resources(struct comp_renderer *r,
@@ -544,9 +1037,50 @@ renderer_ensure_images_and_renderings(struct comp_renderer *r, bool force_recrea
 
 	renderer_create_renderings_and_fences(r);
 
-	assert(r->buffer_count != 0);
+	assert(r->buffer_count != 0);
+
+	return true;
+}
+
+/*!
+ * Scratch images are the biggest allocation the compositor controls itself,
+ * if memory is already tight when starting make them smaller. Only done at
+ * init, the images are not reallocated when the pressure changes later.
+ */
+static VkExtent2D
+renderer_scale_scratch_for_pressure(struct comp_renderer *r, VkExtent2D extent)
+{
+	struct vk_bundle *vk = &r->c->base.vk;
+
+	struct vk_memory_budget_status status;
+	vk_memory_budget_query(vk, 0, &status);
+
+	uint32_t num = 1;
+	uint32_t den = 1;
+	switch (status.pressure) {
+	case VK_MEMORY_PRESSURE_NONE: return extent;
+	case VK_MEMORY_PRESSURE_HIGH:
+		num = 3;
+		den = 4;
+		break;
+	case VK_MEMORY_PRESSURE_CRITICAL:
+		num = 1;
+		den = 2;
+		break;
+	default: return extent;
+	}
+
+	VkExtent2D scaled = {
+	    .width = MAX(extent.width * num / den, 1),
+	    .height = MAX(extent.height * num / den, 1),
+	};
+
+	COMP_WARN(r->c,
+	          "VRAM pressure is %s (%" PRIu64 " of %" PRIu64 " MiB), shrinking scratch images from %ux%u to %ux%u",
+	          vk_memory_pressure_string(status.pressure), status.usage_bytes / (1024 * 1024),
+	          status.budget_bytes / (1024 * 1024), extent.width, extent.height, scaled.width, scaled.height);
 
-	return true;
+	return scaled;
 }
 
 //! Create renderer and initialize non-image-dependent members
@@ -559,10 +1093,35 @@ renderer_init(struct comp_renderer *r, struct comp_compositor *c, VkExtent2D scr
 	r->c = c;
 	r->settings = &c->settings;
 
+	r->latency.enabled = u_latency_probe_enabled();
+	if (r->latency.enabled) {
+		u_latency_probe_init(&r->latency.probe, "timewarp pose to photon");
+	}
+
+	// Needs to be done before any submits, picks the queue to use.
+	async_init(r);
+
+	// The async squash manages the scratch images on its own.
+	r->static_layers.enabled = r->settings->static_layer_cache && !r->async.enabled;
+
 	r->acquired_buffer = -1;
 	r->fenced_buffer = -1;
 	r->rtr_array = NULL;
 
+	// The compositor thread waits on the group and is donated, so one less.
+	uint32_t view_count = c->nr.view_count;
+	if (r->settings->parallel_record && view_count > 1) {
+		struct u_worker_thread_pool *pool = u_worker_thread_pool_create_with_role( //
+		    view_count - 1,                                                        // starting_worker_count
+		    view_count,                                                            // thread_count
+		    "Comp Record",                                                         // prefix
+		    U_THREAD_ROLE_COMPOSITOR);                                             // role
+		if (pool != NULL) {
+			r->record_group = u_worker_group_create(pool);
+			u_worker_thread_pool_reference(&pool, NULL);
+		}
+	}
+
 	// Shared render pass between all scratch images.
 	render_gfx_render_pass_init(                   //
 	    &r->scratch_render_pass,                   // rgrp
@@ -571,14 +1130,20 @@ renderer_init(struct comp_renderer *r, struct comp_compositor *c, VkExtent2D scr
 	    VK_ATTACHMENT_LOAD_OP_CLEAR,               // load_op
 	    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL); // final_layout
 
+	scratch_extent = renderer_scale_scratch_for_pressure(r, scratch_extent);
+
 	for (uint32_t i = 0; i < c->nr.view_count; i++) {
-		bret = comp_scratch_single_images_ensure(&r->c->scratch.views[i], &r->c->base.vk, scratch_extent);
+		bret = comp_scratch_single_images_ensure( //
+		    &r->c->scratch.views[i],              //
+		    &r->c->base.vk,                       //
+		    scratch_extent,                       //
+		    r->settings->scratch_image_count);    //
 		if (!bret) {
 			COMP_ERROR(c, "comp_scratch_single_images_ensure: false");
 			assert(false && "Whelp, can't return an error. But should never really fail.");
 		}
 
-		for (uint32_t k = 0; k < COMP_SCRATCH_NUM_IMAGES; k++) {
+		for (uint32_t k = 0; k < c->scratch.views[i].image_count; k++) {
 			struct render_scratch_color_image *rsci = &c->scratch.views[i].images[k];
 
 			render_gfx_target_resources_init(    //
@@ -713,15 +1278,25 @@ renderer_submit_queue(struct comp_renderer *r, VkCommandBuffer cmd, VkPipelineSt
 	 * The renderer command buffer pool is only accessed from one thread,
 	 * this satisfies the `_locked` requirement of the function. This lets
 	 * us avoid taking a lot of locks. The queue lock will be taken by
-	 * @ref vk_cmd_submit_locked tho.
+	 * @ref vk_cmd_submit_to_queue_locked tho.
 	 */
-	ret = vk_cmd_submit_locked(vk, 1, &comp_submit_info, r->fences[r->acquired_buffer]);
+	ret = vk_cmd_submit_to_queue_locked( //
+	    vk,                              // vk_bundle
+	    renderer_get_queue(r),           // queue
+	    1,                               // count
+	    &comp_submit_info,               // infos
+	    r->fences[r->acquired_buffer]);  // fence
 
 	// We have now completed the submit, even if we failed.
 	comp_target_mark_submit_end(ct, frame_id, os_monotonic_get_ns());
 
 	// Check after marking as submit complete.
-	VK_CHK_AND_RET(ret, "vk_cmd_submit_locked");
+	VK_CHK_AND_RET(ret, "vk_cmd_submit_to_queue_locked");
+
+	if (r->latency.enabled) {
+		uint64_t photon_ns = r->c->frame.rendering.predicted_display_time_ns;
+		u_latency_probe_add(&r->latency.probe, r->latency.pose_sampled_ns, photon_ns);
+	}
 
 	// This buffer now have a pending fence.
 	r->fenced_buffer = r->acquired_buffer;
@@ -793,13 +1368,18 @@ renderer_present_swapchain_image(struct comp_renderer *r, uint64_t desired_prese
 
 	ret = comp_target_present(        //
 	    r->c->target,                 //
-	    r->c->base.vk.queue,          //
+	    renderer_get_queue(r),        //
 	    r->acquired_buffer,           //
 	    render_complete_signal_value, //
 	    desired_present_time_ns,      //
 	    present_slop_ns);             //
 	r->acquired_buffer = -1;
 
+	if (!r->presented) {
+		u_startup_timeline_mark("First present");
+		r->presented = true;
+	}
+
 	if (ret == VK_ERROR_OUT_OF_DATE_KHR || ret == VK_SUBOPTIMAL_KHR) {
 		renderer_resize(r);
 		return;
@@ -817,12 +1397,21 @@ renderer_fini(struct comp_renderer *r)
 	// Command buffers
 	renderer_close_renderings_and_fences(r);
 
+	// Waits for any squash in flight.
+	async_fini(r);
+
+	// Safe to call when not enabled.
+	u_latency_probe_fini(&r->latency.probe);
+
+	// Does null checking.
+	u_worker_group_reference(&r->record_group, NULL);
+
 	// Do before layer render just in case it holds any references.
 	comp_mirror_fini(&r->mirror_to_debug_gui, vk);
 
 	// Do this after the layer renderer.
 	for (uint32_t i = 0; i < r->c->nr.view_count; i++) {
-		for (uint32_t k = 0; k < COMP_SCRATCH_NUM_IMAGES; k++) {
+		for (uint32_t k = 0; k < r->c->scratch.views[i].image_count; k++) {
 			render_gfx_target_resources_close(&r->scratch.views[i].targets[k]);
 		}
 	}
@@ -885,6 +1474,8 @@ dispatch_graphics(struct comp_renderer *r,
 	    eye_poses,          // eye_poses
 	    rr->r->view_count); // view_count
 
+	// Switches the scratch images to the last squash if it can be reused.
+	bool reuse_layers = static_layers_begin(r, crss, fovs, world_poses, rr->r->view_count);
 
 	// The arguments for the dispatch function.
 	struct comp_render_dispatch_data data;
@@ -893,6 +1484,14 @@ dispatch_graphics(struct comp_renderer *r,
 	    rtr,                      // rtr
 	    fast_path,                // fast_path
 	    do_timewarp);             // do_timewarp
+	data.reuse_layers = reuse_layers;
+	data.gfx.record_group = r->record_group;
+
+	// Head locked layers are the same from any pose, no timewarp needed.
+	if (reuse_layers && r->static_layers.view_space) {
+		data.do_timewarp = false;
+	}
+
 	for (uint32_t i = 0; i < rr->r->view_count; i++) {
 		// Which image of the scratch images for this view are we using.
 		uint32_t scratch_index = crss->views[i].index;
@@ -930,7 +1529,11 @@ dispatch_graphics(struct comp_renderer *r,
 		    &vertex_rots[i],      // vertex_rot
 		    &viewport_datas[i]);  // target_viewport_data
 
-		if (layer_count == 0) {
+		if (reuse_layers) {
+			data.views[i].layer_world_pose = r->static_layers.views[i].world_pose;
+		}
+
+		if (layer_count == 0 || reuse_layers) {
 			crss->views[i].used = false;
 		} else {
 			crss->views[i].used = !fast_path;
@@ -954,6 +1557,8 @@ dispatch_graphics(struct comp_renderer *r,
 	ret = renderer_submit_queue(r, rr->r->cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
 	VK_CHK_AND_RET(ret, "renderer_submit_queue");
 
+	static_layers_end(r, crss, reuse_layers, fovs, world_poses, rr->r->view_count);
+
 	return ret;
 }
 
@@ -997,6 +1602,9 @@ dispatch_compute(struct comp_renderer *r,
 	    eye_poses,           // eye_poses
 	    crc->r->view_count); // view_count
 
+	// Switches the scratch images to the last squash if it can be reused.
+	bool reuse_layers = static_layers_begin(r, crss, fovs, world_poses, crc->r->view_count);
+
 	// Target Vulkan resources..
 	VkImage target_image = r->c->target->images[r->acquired_buffer].handle;
 	VkImageView target_image_view = r->c->target->images[r->acquired_buffer].view;
@@ -1014,6 +1622,15 @@ dispatch_compute(struct comp_renderer *r,
 	    fast_path,               // fast_path
 	    do_timewarp);            // do_timewarp
 
+	// Space warp layers are extrapolated to when this frame is displayed.
+	data.display_time_ns = (int64_t)c->frame.rendering.predicted_display_time_ns;
+	data.reuse_layers = reuse_layers;
+
+	// Head locked layers are the same from any pose, no timewarp needed.
+	if (reuse_layers && r->static_layers.view_space) {
+		data.do_timewarp = false;
+	}
+
 	for (uint32_t i = 0; i < crc->r->view_count; i++) {
 		// Which image of the scratch images for this view are we using.
 		uint32_t scratch_index = crss->views[i].index;
@@ -1047,7 +1664,11 @@ dispatch_compute(struct comp_renderer *r,
 		    rsci->unorm_view,     // unorm_view
 		    &views[i]);           // target_viewport_data
 
-		if (layer_count == 0) {
+		if (reuse_layers) {
+			data.views[i].layer_world_pose = r->static_layers.views[i].world_pose;
+		}
+
+		if (layer_count == 0 || reuse_layers) {
 			crss->views[i].used = false;
 		} else {
 			crss->views[i].used = !fast_path;
@@ -1067,13 +1688,457 @@ dispatch_compute(struct comp_renderer *r,
 	// Make the command buffer submittable.
 	render_compute_end(crc);
 
+	// Use the freshest pose for the timewarp, if enabled.
+	late_latch_timewarp(r, crc, fov_source);
+
 	// Everything is ready, submit to the queue.
 	ret = renderer_submit_queue(r, crc->r->cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 	VK_CHK_AND_RET(ret, "renderer_submit_queue");
 
+	static_layers_end(r, crss, reuse_layers, fovs, world_poses, crc->r->view_count);
+
+	return ret;
+}
+
+
+/*
+ *
+ * Async timewarp.
+ *
+ */
+
+/*!
+ * When to stop waiting for the squash, uses the present timing that comes from
+ * the compositor pacing and leaves room for the timewarp itself.
+ */
+static uint64_t
+async_calc_deadline(struct comp_renderer *r)
+{
+	const struct comp_frame *f = &r->c->frame.rendering;
+
+	uint64_t budget_ns = r->settings->async_timewarp_margin_ns + r->async.timewarp_gpu_ns + f->present_slop_ns;
+	if (f->desired_present_time_ns <= budget_ns) {
+		return 0;
+	}
+
+	return f->desired_present_time_ns - budget_ns;
+}
+
+static XRT_CHECK_RESULT VkResult
+async_submit_squash(struct comp_renderer *r, enum comp_target_fov_source fov_source)
+{
+	COMP_TRACE_MARKER();
+
+	struct comp_compositor *c = r->c;
+	struct vk_bundle *vk = &c->base.vk;
+	struct render_compute *crc = &r->async.crc;
+	const uint32_t view_count = c->nr.view_count;
+	VkResult ret;
+
+	assert(!r->async.pending);
+
+	// Basics
+	const struct comp_layer *layers = c->base.slot.layers;
+	uint32_t layer_count = c->base.slot.layer_count;
+	bool do_timewarp = !c->debug.atw_off;
+
+	// Device view information.
+	struct xrt_fov fovs[XRT_MAX_VIEWS];
+	struct xrt_pose world_poses[XRT_MAX_VIEWS];
+	struct xrt_pose eye_poses[XRT_MAX_VIEWS];
+	calc_pose_data(  //
+	    r,           // r
+	    fov_source,  // fov_source
+	    fovs,        // fovs
+	    world_poses, // world_poses
+	    eye_poses,   // eye_poses
+	    view_count); // view_count
+
+	// Only the layer squashing is recorded, so no target.
+	struct comp_render_dispatch_data data;
+	comp_render_cs_initial_init( //
+	    &data,                   // data
+	    VK_NULL_HANDLE,          // target_image
+	    VK_NULL_HANDLE,          // target_unorm_view
+	    false,                   // fast_path
+	    do_timewarp);            // do_timewarp
+
+	for (uint32_t i = 0; i < view_count; i++) {
+		// The set of scratch images we are using for this view.
+		struct comp_scratch_single_images *scratch_view = &c->scratch.views[i];
+
+		// Which image of the scratch images for this view are we using.
+		uint32_t scratch_index = 0;
+		comp_scratch_single_images_get(scratch_view, &scratch_index);
+
+		// Scratch color image.
+		struct render_scratch_color_image *rsci = &scratch_view->images[scratch_index];
+
+		// Use the whole scratch image.
+		struct render_viewport_data layer_viewport_data = {
+		    .x = 0,
+		    .y = 0,
+		    .w = scratch_view->info.width,
+		    .h = scratch_view->info.height,
+		};
+
+		// Scratch image covers the whole image.
+		struct xrt_normalized_rect layer_norm_rect = {.x = 0.0f, .y = 0.0f, .w = 1.0f, .h = 1.0f};
+
+		// Not used, no distortion is recorded.
+		struct render_viewport_data target_viewport_data = {0};
+
+		comp_render_cs_add_view(    //
+		    &data,                  // data
+		    &world_poses[i],        // world_pose
+		    &eye_poses[i],          // eye_pose
+		    &fovs[i],               // fov
+		    &layer_viewport_data,   // layer_viewport_data
+		    &layer_norm_rect,       // layer_norm_rect
+		    rsci->image,            // image
+		    rsci->srgb_view,        // srgb_view
+		    rsci->unorm_view,       // unorm_view
+		    &target_viewport_data); // target_viewport_data
+
+		r->async.pending_views[i] = (struct comp_async_squash_view){
+		    .index = scratch_index,
+		    .world_pose = world_poses[i],
+		    .fov = fovs[i],
+		};
+	}
+
+	render_compute_init_async(crc, &c->nr);
+
+	// Start the compute pipeline.
+	render_compute_begin(crc);
+
+	// The timewarp reads the images afterwards.
+	comp_render_cs_layers(                         //
+	    crc,                                       // crc
+	    layers,                                    // layers
+	    layer_count,                               // layer_count
+	    &data,                                     // d
+	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL); // transition_to
+
+	// Make the command buffer submittable.
+	render_compute_end(crc);
+
+	ret = vk->vkResetFences(vk->device, 1, &r->async.fence);
+	if (ret == VK_SUCCESS) {
+		VkSubmitInfo submit_info = {
+		    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		    .commandBufferCount = 1,
+		    .pCommandBuffers = &crc->cmd,
+		};
+
+		// Goes on the normal queue, the timewarp goes on the async queue.
+		ret = vk_cmd_submit_locked(vk, 1, &submit_info, r->async.fence);
+	}
+
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(c, "Failed to submit squash: %s", vk_result_string(ret));
+
+		render_compute_close(crc);
+		for (uint32_t i = 0; i < view_count; i++) {
+			comp_scratch_single_images_discard(&c->scratch.views[i]);
+		}
+
+		return ret;
+	}
+
+	r->async.pending = true;
+
+	return VK_SUCCESS;
+}
+
+/*!
+ * Distort and timewarp from the last completed squash, clears the target if
+ * no squash has completed yet.
+ *
+ * @pre render_compute_init(crc, &c->nr)
+ */
+static XRT_CHECK_RESULT VkResult
+async_dispatch_timewarp(struct comp_renderer *r,
+                        struct render_compute *crc,
+                        struct comp_render_scratch_state *crss,
+                        enum comp_target_fov_source fov_source)
+{
+	COMP_TRACE_MARKER();
+
+	struct comp_compositor *c = r->c;
+	const uint32_t view_count = c->nr.view_count;
+	bool do_timewarp = !c->debug.atw_off;
+	VkResult ret;
+
+	// Device view information, as late as possible.
+	struct xrt_fov fovs[XRT_MAX_VIEWS];
+	struct xrt_pose world_poses[XRT_MAX_VIEWS];
+	struct xrt_pose eye_poses[XRT_MAX_VIEWS];
+	calc_pose_data(  //
+	    r,           // r
+	    fov_source,  // fov_source
+	    fovs,        // fovs
+	    world_poses, // world_poses
+	    eye_poses,   // eye_poses
+	    view_count); // view_count
+
+	// Target Vulkan resources..
+	VkImage target_image = r->c->target->images[r->acquired_buffer].handle;
+	VkImageView target_image_view = r->c->target->images[r->acquired_buffer].view;
+
+	// Target view information.
+	struct render_viewport_data views[XRT_MAX_VIEWS];
+	calc_viewport_data(r, views, view_count);
+
+	VkSampler src_samplers[XRT_MAX_VIEWS];
+	VkImageView src_image_views[XRT_MAX_VIEWS];
+	struct xrt_normalized_rect src_norm_rects[XRT_MAX_VIEWS];
+	struct xrt_pose src_poses[XRT_MAX_VIEWS];
+	struct xrt_fov src_fovs[XRT_MAX_VIEWS];
+
+	for (uint32_t i = 0; i < view_count; i++) {
+		const struct comp_async_squash_view *last = &r->async.last_views[i];
+		struct render_scratch_color_image *rsci = &c->scratch.views[i].images[last->index];
+
+		src_samplers[i] = c->nr.samplers.clamp_to_border_black;
+		src_image_views[i] = rsci->srgb_view; // Read with gamma curve.
+		src_norm_rects[i] = (struct xrt_normalized_rect){.x = 0.0f, .y = 0.0f, .w = 1.0f, .h = 1.0f};
+		src_poses[i] = last->world_pose;
+		src_fovs[i] = last->fov;
+
+		// For the mirror and peek.
+		crss->views[i].index = last->index;
+	}
+
+	// Start the compute pipeline.
+	render_compute_begin(crc);
+
+	if (!r->async.have_last) {
+		render_compute_clear(  //
+		    crc,               // crc
+		    target_image,      // target_image
+		    target_image_view, // target_image_view
+		    views);            // views
+	} else if (do_timewarp) {
+		render_compute_projection_timewarp( //
+		    crc,                            // crc
+		    src_samplers,                   // src_samplers
+		    src_image_views,                // src_image_views
+		    src_norm_rects,                 // src_rects
+		    src_poses,                      // src_poses
+		    src_fovs,                       // src_fovs
+		    world_poses,                    // new_poses
+		    target_image,                   // target_image
+		    target_image_view,              // target_image_view
+		    views);                         // views
+	} else {
+		render_compute_projection( //
+		    crc,                   // crc
+		    src_samplers,          // src_samplers
+		    src_image_views,       // src_image_views
+		    src_norm_rects,        // src_rects
+		    target_image,          // target_image
+		    target_image_view,     // target_image_view
+		    views);                // views
+	}
+
+	// Make the command buffer submittable.
+	render_compute_end(crc);
+
+	// Use the freshest pose for the timewarp, if enabled.
+	late_latch_timewarp(r, crc, fov_source);
+
+	// Everything is ready, submit to the async queue.
+	ret = renderer_submit_queue(r, crc->cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	VK_CHK_AND_RET(ret, "renderer_submit_queue");
+
 	return ret;
 }
 
+/*!
+ * Frames that only have a single projection layer, or none, goes straight to
+ * the distortion, like without async timewarp. Otherwise a new squash is
+ * started if none is in flight, and the timewarp waits for it until the
+ * deadline from @ref async_calc_deadline, if it hasn't completed by then the
+ * timewarp is done from the last completed squash instead.
+ *
+ * @pre render_compute_init(crc, &c->nr)
+ */
+static XRT_CHECK_RESULT VkResult
+dispatch_compute_async(struct comp_renderer *r,
+                       struct render_compute *crc,
+                       struct comp_render_scratch_state *crss,
+                       enum comp_target_fov_source fov_source)
+{
+	COMP_TRACE_MARKER();
+
+	struct comp_compositor *c = r->c;
+	VkResult ret;
+
+	uint32_t layer_count = c->base.slot.layer_count;
+	bool fast_path = c->base.slot.one_projection_layer_fast_path;
+
+	if (fast_path || layer_count == 0) {
+		// The last squash is stale after this frame.
+		r->async.have_last = false;
+
+		return dispatch_compute(r, crc, crss, fov_source);
+	}
+
+	uint64_t deadline_ns = async_calc_deadline(r);
+
+	// Pick up a squash from an earlier frame, if there is one.
+	if (async_wait_squash(r, deadline_ns)) {
+		ret = async_submit_squash(r, fov_source);
+		VK_CHK_AND_RET(ret, "async_submit_squash");
+
+		async_wait_squash(r, deadline_ns);
+	}
+
+	if (r->async.pending) {
+		COMP_DEBUG(c, "Squash not done by deadline, timewarping from last squash.");
+	}
+
+	return async_dispatch_timewarp(r, crc, crss, fov_source);
+}
+
+
+/*
+ *
+ * GPU phase timestamps.
+ *
+ */
+
+static void
+write_gpu_phase_metrics(int64_t frame_id, const struct render_phase_timestamps *rpt, uint64_t now_ns)
+{
+	if (!u_metrics_is_active()) {
+		return;
+	}
+
+	for (uint32_t phase = 0; phase < RENDER_TIMESTAMP_PHASE_COUNT; phase++) {
+		for (uint32_t view = 0; view < XRT_MAX_VIEWS; view++) {
+			if ((rpt->valid_mask & (1u << (phase * XRT_MAX_VIEWS + view))) == 0) {
+				continue;
+			}
+
+			struct u_metrics_system_gpu_phase umgp = {
+			    .frame_id = frame_id,
+			    .phase = phase,
+			    .view_index = view,
+			    .gpu_start_ns = rpt->gpu_start_ns[phase][view],
+			    .gpu_end_ns = rpt->gpu_end_ns[phase][view],
+			    .when_ns = now_ns,
+			};
+
+			u_metrics_write_system_gpu_phase(&umgp);
+		}
+	}
+}
+
+static void
+do_gpu_phase_tracing(int64_t frame_id, const struct render_phase_timestamps *rpt)
+{
+#ifdef U_TRACE_PERCETTO // Uses Percetto specific things.
+	if (!U_TRACE_CATEGORY_IS_ENABLED(timing)) {
+		return;
+	}
+
+#define TE_BEG(TRACK, TIME, NAME) U_TRACE_EVENT_BEGIN_ON_TRACK_DATA(timing, TRACK, TIME, NAME, PERCETTO_I(frame_id))
+#define TE_END(TRACK, TIME) U_TRACE_EVENT_END_ON_TRACK(timing, TRACK, TIME)
+#define TE_PHASE(TRACK, PHASE, NAME)                                                                                   \
+	for (uint32_t view = 0; view < XRT_MAX_VIEWS; view++) {                                                        \
+		if ((rpt->valid_mask & (1u << (PHASE * XRT_MAX_VIEWS + view))) != 0) {                                 \
+			TE_BEG(TRACK, rpt->gpu_start_ns[PHASE][view], NAME);                                           \
+			TE_END(TRACK, rpt->gpu_end_ns[PHASE][view]);                                                   \
+		}                                                                                                      \
+	}
+
+	TE_PHASE(gpu_squash, RENDER_TIMESTAMP_PHASE_SQUASH, "squash");
+	TE_PHASE(gpu_distortion, RENDER_TIMESTAMP_PHASE_DISTORTION, "distortion");
+	TE_PHASE(gpu_clear, RENDER_TIMESTAMP_PHASE_CLEAR, "clear");
+	TE_PHASE(gpu_mirror, RENDER_TIMESTAMP_PHASE_MIRROR, "mirror");
+
+#undef TE_PHASE
+#undef TE_END
+#undef TE_BEG
+#else
+	(void)frame_id;
+	(void)rpt;
+#endif
+}
+
+
+/*
+ *
+ * Mirror helpers.
+ *
+ */
+
+/*!
+ * Blit the first view to the debug gui. The fast path never writes the
+ * scratch images, so then the blit is done from the app's swapchain image,
+ * which means mirroring doesn't have to disable the fast path.
+ */
+static xrt_result_t
+mirror_to_debug_gui(struct comp_renderer *r,
+                    const struct comp_render_scratch_state *crss,
+                    uint64_t frame_id,
+                    uint64_t predicted_display_time_ns)
+{
+	struct comp_compositor *c = r->c;
+
+	// Used for both, want clamp to edge to no bring in black.
+	VkSampler clamp_to_edge = c->nr.samplers.clamp_to_edge;
+
+	VkImage image;
+	VkImageView view;
+	VkExtent2D extent;
+	struct xrt_normalized_rect rect;
+
+	if (c->base.slot.one_projection_layer_fast_path) {
+		const struct comp_layer *layer = &c->base.slot.layers[0];
+		const struct xrt_layer_projection_view_data *vd = layer->data.type == XRT_LAYER_PROJECTION_DEPTH
+		                                                      ? &layer->data.depth.v[0]
+		                                                      : &layer->data.proj.v[0];
+		struct comp_swapchain *sc = layer->sc_array[0];
+		uint32_t image_index = vd->sub.image_index;
+
+		// The mirror is always opaque.
+		image = sc->vkic.images[image_index].handle;
+		view = sc->images[image_index].views.no_alpha[vd->sub.array_index];
+		extent = (VkExtent2D){(uint32_t)vd->sub.rect.extent.w, (uint32_t)vd->sub.rect.extent.h};
+		rect = vd->sub.norm_rect;
+
+		if (layer->data.flip_y) {
+			rect.h = -rect.h;
+			rect.y = 1 + rect.y;
+		}
+	} else {
+		struct comp_scratch_single_images *scratch_view = &c->scratch.views[0];
+		struct render_scratch_color_image *rsci = &scratch_view->images[crss->views[0].index];
+
+		image = rsci->image;
+		view = rsci->srgb_view;
+		extent = (VkExtent2D){scratch_view->info.width, scratch_view->info.height};
+
+		// Covers the whole view.
+		rect = (struct xrt_normalized_rect){0, 0, 1.0f, 1.0f};
+	}
+
+	return comp_mirror_do_blit(    //
+	    &r->mirror_to_debug_gui,   //
+	    &c->base.vk,               //
+	    &c->nr,                    //
+	    frame_id,                  //
+	    predicted_display_time_ns, //
+	    image,                     //
+	    view,                      //
+	    clamp_to_edge,             //
+	    extent,                    //
+	    rect);                     //
+}
+
 
 /*
  *
@@ -1126,16 +2191,24 @@ comp_renderer_draw(struct comp_renderer *r)
 	const uint32_t view_count = c->nr.view_count;
 	enum comp_target_fov_source fov_source = COMP_TARGET_FOV_SOURCE_DISTORTION;
 
+	// The async squash gets and finishes its own scratch images.
+	bool use_async = r->async.enabled;
+
 	// For scratch image debugging.
-	struct comp_render_scratch_state crss;
-	scratch_get_init(&crss, r, view_count);
+	struct comp_render_scratch_state crss = {0};
+	if (!use_async) {
+		scratch_get_init(&crss, r, view_count);
+	}
 
 	bool use_compute = r->settings->use_compute;
 	struct render_gfx rr = {0};
 	struct render_compute crc = {0};
 
 	VkResult res = VK_SUCCESS;
-	if (use_compute) {
+	if (use_async) {
+		render_compute_init(&crc, &c->nr);
+		res = dispatch_compute_async(r, &crc, &crss, fov_source);
+	} else if (use_compute) {
 		render_compute_init(&crc, &c->nr);
 		res = dispatch_compute(r, &crc, &crss, fov_source);
 	} else {
@@ -1148,6 +2221,11 @@ comp_renderer_draw(struct comp_renderer *r)
 
 #ifdef XRT_FEATURE_WINDOW_PEEK
 	if (c->peek) {
+		// The blit is done on the normal queue, make sure the timewarp is done.
+		if (use_async) {
+			renderer_wait_queue_idle(r);
+		}
+
 		switch (comp_window_peek_get_eye(c->peek)) {
 		case COMP_WINDOW_PEEK_EYE_LEFT: {
 			struct comp_scratch_single_images *view = &c->scratch.views[0];
@@ -1188,27 +2266,7 @@ comp_renderer_draw(struct comp_renderer *r)
 	xrt_result_t xret = XRT_SUCCESS;
 	comp_mirror_fixup_ui_state(&r->mirror_to_debug_gui, c);
 	if (comp_mirror_is_ready_and_active(&r->mirror_to_debug_gui, c, predicted_display_time_ns)) {
-
-		struct comp_scratch_single_images *view = &c->scratch.views[0];
-		struct render_scratch_color_image *rsci = &view->images[crss.views[0].index];
-		VkExtent2D extent = {view->info.width, view->info.width};
-
-		// Used for both, want clamp to edge to no bring in black.
-		VkSampler clamp_to_edge = c->nr.samplers.clamp_to_edge;
-
-		// Covers the whole view.
-		struct xrt_normalized_rect rect = {0, 0, 1.0f, 1.0f};
-
-		xret = comp_mirror_do_blit(    //
-		    &r->mirror_to_debug_gui,   //
-		    &c->base.vk,               //
-		    frame_id,                  //
-		    predicted_display_time_ns, //
-		    rsci->image,               //
-		    rsci->srgb_view,           //
-		    clamp_to_edge,             //
-		    extent,                    //
-		    rect);                     //
+		xret = mirror_to_debug_gui(r, &crss, frame_id, predicted_display_time_ns);
 	}
 
 	/*
@@ -1221,7 +2279,9 @@ comp_renderer_draw(struct comp_renderer *r)
 	renderer_wait_queue_idle(r);
 
 	// Finalize the scratch images, send to debug UI if active.
-	scratch_get_fini(&crss, r, view_count);
+	if (!use_async) {
+		scratch_get_fini(&crss, r, view_count);
+	}
 
 	// Check timestamps.
 	if (xret == XRT_SUCCESS) {
@@ -1233,6 +2293,16 @@ comp_renderer_draw(struct comp_renderer *r)
 		if (render_resources_get_timestamps(&c->nr, &gpu_start_ns, &gpu_end_ns)) {
 			uint64_t now_ns = os_monotonic_get_ns();
 			comp_target_info_gpu(ct, frame_id, gpu_start_ns, gpu_end_ns, now_ns);
+
+			// Only the timewarp is timed when using async timewarp.
+			r->async.timewarp_gpu_ns = gpu_end_ns > gpu_start_ns ? gpu_end_ns - gpu_start_ns : 0;
+		}
+
+		// Squash, distortion, clear and mirror on their own.
+		struct render_phase_timestamps rpt;
+		if (render_resources_get_phase_timestamps(&c->nr, &rpt)) {
+			write_gpu_phase_metrics((int64_t)frame_id, &rpt, os_monotonic_get_ns());
+			do_gpu_phase_tracing((int64_t)frame_id, &rpt);
 		}
 	}
 
@@ -1310,6 +2380,18 @@ comp_renderer_destroy(struct comp_renderer **ptr_r)
 	*ptr_r = NULL;
 }
 
+void
+comp_renderer_wait_idle(struct comp_renderer *r)
+{
+	COMP_TRACE_MARKER();
+
+	if (r->async.enabled) {
+		async_wait_squash(r, UINT64_MAX);
+	}
+
+	renderer_wait_queue_idle(r);
+}
+
 void
 comp_renderer_add_debug_vars(struct comp_renderer *self)
 {
@@ -60,6 +60,17 @@ comp_renderer_destroy(struct comp_renderer **ptr_r);
 XRT_CHECK_RESULT xrt_result_t
 comp_renderer_draw(struct comp_renderer *r);
 
+/*!
+ * Wait for all GPU work from the renderer to complete, including any layer
+ * squashing still in flight from async timewarp. Must be called before the
+ * scratch images are freed.
+ *
+ * @public @memberof comp_renderer
+ * @ingroup comp_main
+ */
+void
+comp_renderer_wait_idle(struct comp_renderer *r);
+
 void
 comp_renderer_add_debug_vars(struct comp_renderer *self);
 
@@ -8,8 +8,13 @@
  */
 
 #include "util/u_debug.h"
+#include "util/u_time.h"
+#include "util/comp_scratch.h"
+
 #include "comp_settings.h"
 
+#include <string.h>
+
 // clang-format off
 DEBUG_GET_ONCE_LOG_OPTION(log, "XRT_COMPOSITOR_LOG", U_LOGGING_INFO)
 DEBUG_GET_ONCE_BOOL_OPTION(print_modes, "XRT_COMPOSITOR_PRINT_MODES", false)
@@ -20,6 +25,7 @@ DEBUG_GET_ONCE_OPTION(nvidia_display, "XRT_COMPOSITOR_FORCE_NVIDIA_DISPLAY", NUL
 DEBUG_GET_ONCE_NUM_OPTION(vk_display, "XRT_COMPOSITOR_FORCE_VK_DISPLAY", -1)
 DEBUG_GET_ONCE_BOOL_OPTION(force_xcb, "XRT_COMPOSITOR_FORCE_XCB", false)
 DEBUG_GET_ONCE_BOOL_OPTION(force_wayland, "XRT_COMPOSITOR_FORCE_WAYLAND", false)
+DEBUG_GET_ONCE_BOOL_OPTION(force_stream, "XRT_COMPOSITOR_FORCE_STREAM", false)
 DEBUG_GET_ONCE_NUM_OPTION(force_gpu_index, "XRT_COMPOSITOR_FORCE_GPU_INDEX", -1)
 DEBUG_GET_ONCE_NUM_OPTION(force_client_gpu_index, "XRT_COMPOSITOR_FORCE_CLIENT_GPU_INDEX", -1)
 DEBUG_GET_ONCE_NUM_OPTION(desired_mode, "XRT_COMPOSITOR_DESIRED_MODE", -1)
@@ -28,8 +34,38 @@ DEBUG_GET_ONCE_BOOL_OPTION(xcb_fullscreen, "XRT_COMPOSITOR_XCB_FULLSCREEN", fals
 DEBUG_GET_ONCE_NUM_OPTION(xcb_display, "XRT_COMPOSITOR_XCB_DISPLAY", -1)
 DEBUG_GET_ONCE_NUM_OPTION(default_framerate, "XRT_COMPOSITOR_DEFAULT_FRAMERATE", 60)
 DEBUG_GET_ONCE_BOOL_OPTION(compute, "XRT_COMPOSITOR_COMPUTE", false)
+DEBUG_GET_ONCE_BOOL_OPTION(async_timewarp, "XRT_COMPOSITOR_ASYNC_TIMEWARP", false)
+DEBUG_GET_ONCE_NUM_OPTION(async_timewarp_margin_us, "XRT_COMPOSITOR_ASYNC_TIMEWARP_MARGIN_US", 2000)
+DEBUG_GET_ONCE_BOOL_OPTION(foveated_distortion, "XRT_COMPOSITOR_FOVEATED_DISTORTION", false)
+DEBUG_GET_ONCE_NUM_OPTION(foveation_inner_percent, "XRT_COMPOSITOR_FOVEATION_INNER_PERCENT", 60)
+DEBUG_GET_ONCE_NUM_OPTION(foveation_outer_percent, "XRT_COMPOSITOR_FOVEATION_OUTER_PERCENT", 100)
+DEBUG_GET_ONCE_TRISTATE_OPTION(late_latch, "XRT_COMPOSITOR_LATE_LATCH")
+DEBUG_GET_ONCE_BOOL_OPTION(static_layer_cache, "XRT_COMPOSITOR_STATIC_LAYER_CACHE", true)
+DEBUG_GET_ONCE_BOOL_OPTION(parallel_record, "XRT_COMPOSITOR_PARALLEL_RECORD", false)
+DEBUG_GET_ONCE_NUM_OPTION(scratch_images, "XRT_COMPOSITOR_SCRATCH_IMAGES", COMP_SCRATCH_NUM_IMAGES)
+DEBUG_GET_ONCE_OPTION(scratch_compression, "XRT_COMPOSITOR_SCRATCH_COMPRESSION", NULL)
 // clang-format on
 
+static enum vk_image_compression
+get_scratch_compression(void)
+{
+	const char *str = debug_get_option_scratch_compression();
+	if (str == NULL || strcmp(str, "default") == 0) {
+		return VK_IMAGE_COMPRESSION_MODE_DEFAULT;
+	}
+	if (strcmp(str, "fixed_rate") == 0) {
+		return VK_IMAGE_COMPRESSION_MODE_FIXED_RATE;
+	}
+	if (strcmp(str, "disabled") == 0) {
+		return VK_IMAGE_COMPRESSION_MODE_DISABLED;
+	}
+
+	U_LOG_W("Unknown XRT_COMPOSITOR_SCRATCH_COMPRESSION '%s', valid are 'default', 'fixed_rate' and 'disabled'.",
+	        str);
+
+	return VK_IMAGE_COMPRESSION_MODE_DEFAULT;
+}
+
 static inline void
 add_format(struct comp_settings *s, VkFormat format)
 {
@@ -63,6 +99,33 @@ comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 	}
 
 	s->use_compute = debug_get_bool_option_compute();
+	s->async_timewarp = s->use_compute && debug_get_bool_option_async_timewarp();
+	long margin_us = debug_get_num_option_async_timewarp_margin_us();
+	s->async_timewarp_margin_ns = margin_us > 0 ? (uint64_t)margin_us * U_TIME_1US_IN_NS : 0;
+
+	s->foveated_distortion = s->use_compute && debug_get_bool_option_foveated_distortion();
+	s->foveation_inner_radius = debug_get_num_option_foveation_inner_percent() / 100.0f;
+	s->foveation_outer_radius = debug_get_num_option_foveation_outer_percent() / 100.0f;
+	if (s->foveation_outer_radius < s->foveation_inner_radius) {
+		s->foveation_outer_radius = s->foveation_inner_radius;
+	}
+
+	// By default only late latch when the device has a fresher pose to give.
+	enum debug_tristate_option late_latch = debug_get_tristate_option_late_latch();
+	bool want_late_latch = late_latch == DEBUG_TRISTATE_ON ||
+	                       (late_latch == DEBUG_TRISTATE_AUTO && xdev->late_pose_refinement_supported);
+	s->late_latch = s->use_compute && want_late_latch;
+	s->static_layer_cache = debug_get_bool_option_static_layer_cache();
+	s->parallel_record = debug_get_bool_option_parallel_record();
+
+	long scratch_images = debug_get_num_option_scratch_images();
+	if (s->async_timewarp || scratch_images > COMP_SCRATCH_NUM_IMAGES) {
+		scratch_images = COMP_SCRATCH_NUM_IMAGES;
+	} else if (scratch_images < 1) {
+		scratch_images = 1;
+	}
+	s->scratch_image_count = (uint32_t)scratch_images;
+	s->scratch_compression = get_scratch_compression();
 
 	if (s->use_compute) {
 		// This was the default before, keep it first.
@@ -156,4 +219,7 @@ comp_settings_init(struct comp_settings *s, struct xrt_device *xdev)
 		s->preferred.width /= 2;
 		s->preferred.height /= 2;
 	}
+	if (debug_get_bool_option_force_stream()) {
+		s->target_identifier = "stream";
+	}
 }
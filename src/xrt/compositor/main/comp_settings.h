@@ -16,6 +16,8 @@
 
 #include "util/u_logging.h"
 
+#include "vk/vk_image_allocator.h"
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -50,6 +52,59 @@ struct comp_settings
 
 	bool use_compute;
 
+	/*!
+	 * Squash layers on the normal queue and run the timewarp from the last
+	 * finished squash on a higher priority queue, only used with
+	 * @ref use_compute.
+	 */
+	bool async_timewarp;
+
+	//! How long before present the async timewarp stops waiting on the squash.
+	uint64_t async_timewarp_margin_ns;
+
+	/*!
+	 * Shade the outer parts of each view at a lower rate in the distortion
+	 * pass, only used with @ref use_compute.
+	 */
+	bool foveated_distortion;
+
+	//! Full rate radius of the foveation, in view normalized [-1, 1] space.
+	float foveation_inner_radius;
+
+	//! Half rate radius of the foveation, quarter rate outside of it.
+	float foveation_outer_radius;
+
+	/*!
+	 * Sample the pose again right before submit and rewrite the timewarp
+	 * matrices with it, only used with @ref use_compute. On by default for
+	 * devices with @ref xrt_device::late_pose_refinement_supported.
+	 */
+	bool late_latch;
+
+	/*!
+	 * Skip the layer squash when the layers are the same as last frame and
+	 * timewarp the scratch images from then instead.
+	 */
+	bool static_layer_cache;
+
+	/*!
+	 * Record the layer squash of each view on its own thread into
+	 * secondary command buffers, only used on the graphics path.
+	 */
+	bool parallel_record;
+
+	/*!
+	 * Number of scratch images per view, fewer uses less memory. Always the
+	 * max with @ref async_timewarp as it keeps the last squash around.
+	 */
+	uint32_t scratch_image_count;
+
+	/*!
+	 * Compression asked for on the scratch images, they never leave the
+	 * service so unlike swapchains they don't have to match an importer.
+	 */
+	enum vk_image_compression scratch_compression;
+
 	VkFormat formats[XRT_MAX_SWAPCHAIN_FORMATS];
 	uint32_t format_count;
 
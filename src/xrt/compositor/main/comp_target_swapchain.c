@@ -324,7 +324,13 @@ do_update_timings_google_display_timing(struct comp_target_swapchain *cts)
 		return;
 	}
 
-	VkPastPresentationTimingGOOGLE *timings = U_TYPED_ARRAY_CALLOC(VkPastPresentationTimingGOOGLE, count);
+	u_arena_reset(&cts->frame_arena);
+	VkPastPresentationTimingGOOGLE *timings =
+	    U_ARENA_ALLOC_ARRAY(&cts->frame_arena, VkPastPresentationTimingGOOGLE, count);
+	if (timings == NULL) {
+		return;
+	}
+
 	vk->vkGetPastPresentationTimingGOOGLE( //
 	    vk->device,                        //
 	    cts->swapchain.handle,             //
@@ -340,8 +346,6 @@ do_update_timings_google_display_timing(struct comp_target_swapchain *cts)
 		          timings[i].presentMargin,       //
 		          now_ns);                        //
 	}
-
-	free(timings);
 }
 
 static void
@@ -1059,6 +1063,8 @@ comp_target_swapchain_cleanup(struct comp_target_swapchain *cts)
 	target_fini_semaphores(cts);
 
 	u_pc_destroy(&cts->upc);
+
+	u_arena_fini(&cts->frame_arena);
 }
 
 void
@@ -1076,4 +1082,5 @@ comp_target_swapchain_init_and_set_fnptrs(struct comp_target_swapchain *cts,
 	cts->base.update_timings = comp_target_swapchain_update_timings;
 	cts->base.info_gpu = comp_target_swapchain_info_gpu;
 	os_thread_helper_init(&cts->vblank.event_thread);
+	u_arena_init(&cts->frame_arena, 4096);
 }
@@ -12,6 +12,8 @@
 
 #include "vk/vk_helpers.h"
 
+#include "util/u_arena.h"
+
 #include "main/comp_target.h"
 
 
@@ -47,6 +49,9 @@ struct comp_target_swapchain
 	//! Also works as a frame index.
 	int64_t current_frame_id;
 
+	//! Reset every frame, for temporary allocations like past timings.
+	struct u_arena frame_arena;
+
 	struct
 	{
 		/*!
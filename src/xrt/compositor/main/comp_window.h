@@ -14,6 +14,7 @@
 #include "main/comp_compositor.h"
 
 #include "xrt/xrt_config_os.h"
+#include "xrt/xrt_config_have.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -130,6 +131,20 @@ comp_window_mswin_create(struct comp_compositor *c);
 extern const struct comp_target_factory comp_target_factory_mswin;
 #endif // XRT_OS_WINDOWS
 
+#if defined(XRT_HAVE_GST) && defined(XRT_OS_LINUX)
+
+/*!
+ * Create a target that streams the output images to a GStreamer pipeline.
+ *
+ * @ingroup comp_main
+ * @public @memberof comp_window_stream
+ */
+struct comp_target *
+comp_window_stream_create(struct comp_compositor *c);
+
+extern const struct comp_target_factory comp_target_factory_stream;
+#endif // XRT_HAVE_GST && XRT_OS_LINUX
+
 #ifdef __cplusplus
 }
 #endif
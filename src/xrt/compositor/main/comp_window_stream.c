@@ -0,0 +1,895 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Target that streams the output images to a GStreamer pipeline.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup comp_main
+ */
+
+#include "os/os_time.h"
+#include "os/os_threading.h"
+
+#include "util/u_misc.h"
+#include "util/u_time.h"
+#include "util/u_debug.h"
+#include "util/u_pacing.h"
+#include "util/u_trace_marker.h"
+
+#include "vk/vk_cmd.h"
+#include "vk/vk_mini_helpers.h"
+
+#include "gstreamer/gst_sink.h"
+#include "gstreamer/gst_pipeline.h"
+
+#include "main/comp_window.h"
+
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <inttypes.h>
+
+
+/*
+ *
+ * Defines.
+ *
+ */
+
+//! Enough for one image being rendered with the encoder holding the others.
+#define STREAM_IMAGE_COUNT (4)
+
+//! Name of the appsrc element the images are pushed into.
+#define STREAM_APPSRC_NAME "comp_src"
+
+//! How long the pusher thread waits for rendering before dropping a frame.
+#define STREAM_FENCE_TIMEOUT_NS (U_TIME_1S_IN_NS)
+
+DEBUG_GET_ONCE_OPTION(stream_pipeline,
+                      "XRT_COMPOSITOR_STREAM_PIPELINE",
+                      "appsrc name=" STREAM_APPSRC_NAME
+                      " ! queue ! vapostproc ! vah264enc ! h264parse ! matroskamux ! filesink location=/tmp/monado.mkv")
+
+
+/*
+ *
+ * Structs.
+ *
+ */
+
+enum stream_image_state
+{
+	//! Not used by anybody.
+	STREAM_IMAGE_FREE,
+	//! Acquired by the renderer.
+	STREAM_IMAGE_RENDERING,
+	//! Presented, waiting for the pusher thread.
+	STREAM_IMAGE_QUEUED,
+	//! The pusher thread is waiting for the GPU to finish it.
+	STREAM_IMAGE_PUSHING,
+	//! Handed to GStreamer, waiting for it to be released.
+	STREAM_IMAGE_ENCODING,
+};
+
+struct comp_window_stream;
+
+/*!
+ * One exported image, its memory is shared with the encoder as a DMA-BUF.
+ */
+struct comp_window_stream_image
+{
+	struct comp_window_stream *cws;
+
+	VkDeviceMemory memory;
+	VkDeviceSize size;
+	VkSubresourceLayout layout;
+
+	//! Exported DMA-BUF, owned by this image.
+	int fd;
+
+	//! Signaled when rendering to the image is done.
+	VkFence fence;
+
+	enum stream_image_state state;
+
+	//! Buffers of this image GStreamer still holds on to.
+	uint32_t pending;
+
+	//! Used to find the oldest image when the encoder falls behind.
+	uint64_t sequence;
+
+	uint64_t timestamp_ns;
+	uint64_t present_ns;
+};
+
+/*!
+ * Zero copy streaming target, renders into linear images that are exported
+ * as DMA-BUFs and pushed into a GStreamer pipeline, where hardware encoders
+ * import them directly.
+ *
+ * @implements comp_target
+ */
+struct comp_window_stream
+{
+	struct comp_target base;
+
+	struct u_pacing_compositor *upc;
+
+	int64_t current_frame_id;
+
+	struct xrt_frame_context xfctx;
+	struct gstreamer_pipeline *gp;
+	struct gstreamer_sink *gs;
+
+	//! GStreamer name of the selected format.
+	const char *format_str;
+
+	//! Its lock protects the image states, the queue and the stats below.
+	struct os_thread_helper pusher;
+
+	struct comp_window_stream_image images[STREAM_IMAGE_COUNT];
+	struct comp_target_image target_images[STREAM_IMAGE_COUNT];
+
+	//! Presented images in order, consumed by the pusher thread.
+	uint32_t queue[STREAM_IMAGE_COUNT];
+	uint32_t queue_count;
+
+	uint64_t sequence;
+
+	//! Smoothed time from present to the encoder releasing the image.
+	uint64_t encode_ns;
+	bool encode_ns_updated;
+
+	//! Frames that reused an image the encoder had not released yet.
+	uint64_t dropped_frames;
+};
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static inline struct vk_bundle *
+get_vk(struct comp_window_stream *cws)
+{
+	return &cws->base.c->base.vk;
+}
+
+static const char *
+gst_format_from_vk_format(VkFormat format)
+{
+	switch (format) {
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB: return "BGRA";
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+	case VK_FORMAT_A8B8G8R8_SRGB_PACK32: return "RGBA";
+	default: return NULL;
+	}
+}
+
+static bool
+is_format_exportable(struct vk_bundle *vk, VkFormat format, VkImageUsageFlags usage)
+{
+	VkPhysicalDeviceExternalImageFormatInfo external_info = {
+	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_IMAGE_FORMAT_INFO,
+	    .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	VkPhysicalDeviceImageFormatInfo2 format_info = {
+	    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+	    .pNext = &external_info,
+	    .format = format,
+	    .type = VK_IMAGE_TYPE_2D,
+	    .tiling = VK_IMAGE_TILING_LINEAR,
+	    .usage = usage,
+	};
+
+	VkExternalImageFormatProperties external_props = {
+	    .sType = VK_STRUCTURE_TYPE_EXTERNAL_IMAGE_FORMAT_PROPERTIES,
+	};
+
+	VkImageFormatProperties2 props = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2,
+	    .pNext = &external_props,
+	};
+
+	VkResult ret = vk->vkGetPhysicalDeviceImageFormatProperties2(vk->physical_device, &format_info, &props);
+	if (ret != VK_SUCCESS) {
+		return false;
+	}
+
+	VkExternalMemoryFeatureFlags features = external_props.externalMemoryProperties.externalMemoryFeatures;
+	return (features & VK_EXTERNAL_MEMORY_FEATURE_EXPORTABLE_BIT) != 0;
+}
+
+static void
+destroy_images(struct comp_window_stream *cws)
+{
+	struct vk_bundle *vk = get_vk(cws);
+
+	for (uint32_t i = 0; i < cws->base.image_count; i++) {
+		struct comp_window_stream_image *img = &cws->images[i];
+		struct comp_target_image *ti = &cws->target_images[i];
+
+		if (img->fence != VK_NULL_HANDLE) {
+			vk->vkWaitForFences(vk->device, 1, &img->fence, VK_TRUE, UINT64_MAX);
+			vk->vkDestroyFence(vk->device, img->fence, NULL);
+			img->fence = VK_NULL_HANDLE;
+		}
+
+		D(ImageView, ti->view);
+		D(Image, ti->handle);
+		DF(Memory, img->memory);
+
+		if (img->fd >= 0) {
+			close(img->fd);
+			img->fd = -1;
+		}
+	}
+
+	if (cws->base.semaphores.render_complete != VK_NULL_HANDLE) {
+		vk->vkDestroySemaphore(vk->device, cws->base.semaphores.render_complete, NULL);
+		cws->base.semaphores.render_complete = VK_NULL_HANDLE;
+	}
+
+	cws->base.image_count = 0;
+	cws->queue_count = 0;
+}
+
+static VkResult
+create_image(struct comp_window_stream *cws, uint32_t index, VkImageUsageFlags usage)
+{
+	struct vk_bundle *vk = get_vk(cws);
+	struct comp_window_stream_image *img = &cws->images[index];
+	struct comp_target_image *ti = &cws->target_images[index];
+	VkResult ret;
+
+	img->cws = cws;
+	img->fd = -1;
+	img->state = STREAM_IMAGE_FREE;
+	img->pending = 0;
+
+	VkExternalMemoryImageCreateInfo external_info = {
+	    .sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO,
+	    .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	// Linear so the encoder does not need to know about any modifiers.
+	VkImageCreateInfo image_info = {
+	    .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+	    .pNext = &external_info,
+	    .imageType = VK_IMAGE_TYPE_2D,
+	    .format = cws->base.format,
+	    .extent = {cws->base.width, cws->base.height, 1},
+	    .mipLevels = 1,
+	    .arrayLayers = 1,
+	    .samples = VK_SAMPLE_COUNT_1_BIT,
+	    .tiling = VK_IMAGE_TILING_LINEAR,
+	    .usage = usage,
+	    .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+	    .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+	};
+
+	ret = vk->vkCreateImage(vk->device, &image_info, NULL, &ti->handle);
+	VK_CHK_AND_RET(ret, "vkCreateImage");
+
+	VK_NAME_IMAGE(vk, ti->handle, "comp_window_stream image");
+
+	VkMemoryDedicatedAllocateInfo dedicated_info = {
+	    .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+	    .image = ti->handle,
+	};
+
+	VkExportMemoryAllocateInfo export_info = {
+	    .sType = VK_STRUCTURE_TYPE_EXPORT_MEMORY_ALLOCATE_INFO,
+	    .pNext = &dedicated_info,
+	    .handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	ret = vk_alloc_and_bind_image_memory( //
+	    vk,                               // vk_bundle
+	    ti->handle,                       // image
+	    0,                                // max_size
+	    &export_info,                     // pNext_for_allocate
+	    __func__,                         // caller_name
+	    &img->memory,                     // out_mem
+	    &img->size);                      // out_size
+	VK_CHK_AND_RET(ret, "vk_alloc_and_bind_image_memory");
+
+	VkMemoryGetFdInfoKHR fd_info = {
+	    .sType = VK_STRUCTURE_TYPE_MEMORY_GET_FD_INFO_KHR,
+	    .memory = img->memory,
+	    .handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_DMA_BUF_BIT_EXT,
+	};
+
+	ret = vk->vkGetMemoryFdKHR(vk->device, &fd_info, &img->fd);
+	VK_CHK_AND_RET(ret, "vkGetMemoryFdKHR");
+
+	// The encoder needs to know where the rows are.
+	VkImageSubresource subresource = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .mipLevel = 0,
+	    .arrayLayer = 0,
+	};
+	vk->vkGetImageSubresourceLayout(vk->device, ti->handle, &subresource, &img->layout);
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	ret = vk_create_view(vk, ti->handle, VK_IMAGE_VIEW_TYPE_2D, cws->base.format, subresource_range, &ti->view);
+	VK_CHK_AND_RET(ret, "vk_create_view");
+
+	// Starts signaled so present can always wait and reset it.
+	VkFenceCreateInfo fence_info = {
+	    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+	    .flags = VK_FENCE_CREATE_SIGNALED_BIT,
+	};
+
+	ret = vk->vkCreateFence(vk->device, &fence_info, NULL, &img->fence);
+	VK_CHK_AND_RET(ret, "vkCreateFence");
+
+	VK_NAME_FENCE(vk, img->fence, "comp_window_stream fence");
+
+	return VK_SUCCESS;
+}
+
+static void
+image_released(void *user_data)
+{
+	struct comp_window_stream_image *img = (struct comp_window_stream_image *)user_data;
+	struct comp_window_stream *cws = img->cws;
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	os_thread_helper_lock(&cws->pusher);
+
+	assert(img->pending > 0);
+	img->pending--;
+
+	// May have been taken back by the renderer, keep that state then.
+	if (img->pending == 0 && img->state == STREAM_IMAGE_ENCODING) {
+		img->state = STREAM_IMAGE_FREE;
+
+		uint64_t sample_ns = now_ns - img->present_ns;
+		if (cws->encode_ns == 0) {
+			cws->encode_ns = sample_ns;
+		} else {
+			cws->encode_ns = (cws->encode_ns * 7 + sample_ns) / 8;
+		}
+		cws->encode_ns_updated = true;
+	}
+
+	os_thread_helper_unlock(&cws->pusher);
+}
+
+static void *
+run_pusher(void *ptr)
+{
+	struct comp_window_stream *cws = (struct comp_window_stream *)ptr;
+	struct vk_bundle *vk = get_vk(cws);
+
+	os_thread_helper_name(&cws->pusher, "Stream Pusher");
+
+	os_thread_helper_lock(&cws->pusher);
+
+	while (os_thread_helper_is_running_locked(&cws->pusher)) {
+		if (cws->queue_count == 0) {
+			os_thread_helper_wait_locked(&cws->pusher);
+			continue;
+		}
+
+		uint32_t index = cws->queue[0];
+		cws->queue_count--;
+		memmove(&cws->queue[0], &cws->queue[1], cws->queue_count * sizeof(cws->queue[0]));
+
+		struct comp_window_stream_image *img = &cws->images[index];
+		img->state = STREAM_IMAGE_PUSHING;
+
+		os_thread_helper_unlock(&cws->pusher);
+
+		VkResult ret = vk->vkWaitForFences(vk->device, 1, &img->fence, VK_TRUE, STREAM_FENCE_TIMEOUT_NS);
+
+		os_thread_helper_lock(&cws->pusher);
+
+		if (ret != VK_SUCCESS) {
+			COMP_ERROR(cws->base.c, "vkWaitForFences: %s, dropping frame", vk_result_string(ret));
+			img->state = STREAM_IMAGE_FREE;
+			continue;
+		}
+
+		// Set before pushing, the release can be called from within the push.
+		img->state = STREAM_IMAGE_ENCODING;
+		img->pending++;
+
+		os_thread_helper_unlock(&cws->pusher);
+
+		gstreamer_sink_push_dmabuf(            //
+		    cws->gs,                           // gs
+		    img->fd,                           // fd
+		    (size_t)img->size,                 // size
+		    (size_t)img->layout.offset,        // offset
+		    (uint32_t)img->layout.rowPitch,    // stride
+		    img->timestamp_ns,                 // timestamp_ns
+		    image_released,                    // release_func
+		    img);                              // user_data
+
+		os_thread_helper_lock(&cws->pusher);
+	}
+
+	os_thread_helper_unlock(&cws->pusher);
+
+	return NULL;
+}
+
+static uint32_t
+pick_image_locked(struct comp_window_stream *cws)
+{
+	uint32_t oldest_queued = UINT32_MAX;
+	uint32_t oldest_encoding = UINT32_MAX;
+
+	for (uint32_t i = 0; i < cws->base.image_count; i++) {
+		struct comp_window_stream_image *img = &cws->images[i];
+
+		if (img->state == STREAM_IMAGE_FREE) {
+			return i;
+		}
+
+		uint32_t *oldest = NULL;
+		if (img->state == STREAM_IMAGE_QUEUED) {
+			oldest = &oldest_queued;
+		} else if (img->state == STREAM_IMAGE_ENCODING) {
+			oldest = &oldest_encoding;
+		} else {
+			continue;
+		}
+
+		if (*oldest == UINT32_MAX || img->sequence < cws->images[*oldest].sequence) {
+			*oldest = i;
+		}
+	}
+
+	/*
+	 * The encoder is falling behind, never block the compositor on it.
+	 * Drop the oldest frame not yet handed over, otherwise render into
+	 * one the encoder is still reading, rather tear than stall.
+	 */
+	cws->dropped_frames++;
+
+	if (oldest_queued != UINT32_MAX) {
+		for (uint32_t i = 0; i < cws->queue_count; i++) {
+			if (cws->queue[i] != oldest_queued) {
+				continue;
+			}
+			cws->queue_count--;
+			memmove(&cws->queue[i], &cws->queue[i + 1], (cws->queue_count - i) * sizeof(cws->queue[0]));
+			break;
+		}
+		return oldest_queued;
+	}
+
+	assert(oldest_encoding != UINT32_MAX);
+
+	return oldest_encoding;
+}
+
+
+/*
+ *
+ * Member functions.
+ *
+ */
+
+static bool
+target_init_pre_vulkan(struct comp_target *ct)
+{
+	return true;
+}
+
+static bool
+target_init_post_vulkan(struct comp_target *ct, uint32_t preferred_width, uint32_t preferred_height)
+{
+	struct comp_window_stream *cws = (struct comp_window_stream *)ct;
+	struct vk_bundle *vk = get_vk(cws);
+
+	if (!vk->has_EXT_external_memory_dma_buf) {
+		COMP_ERROR(ct->c, "Stream target needs %s", VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME);
+		return false;
+	}
+
+	const char *pipeline_string = debug_get_option_stream_pipeline();
+	COMP_INFO(ct->c, "Streaming to '%s'", pipeline_string);
+
+	gstreamer_pipeline_create_from_string(&cws->xfctx, pipeline_string, &cws->gp);
+
+	int ret = os_thread_helper_start(&cws->pusher, run_pusher, cws);
+	if (ret != 0) {
+		COMP_ERROR(ct->c, "Failed to start pusher thread!");
+		return false;
+	}
+
+	return true;
+}
+
+static bool
+target_check_ready(struct comp_target *ct)
+{
+	return true;
+}
+
+static void
+target_create_images(struct comp_target *ct, const struct comp_target_create_images_info *create_info)
+{
+	struct comp_window_stream *cws = (struct comp_window_stream *)ct;
+	struct vk_bundle *vk = get_vk(cws);
+	uint64_t now_ns = os_monotonic_get_ns();
+	VkResult ret;
+
+	if (cws->upc == NULL) {
+		u_pc_fake_create(ct->c->settings.nominal_frame_interval_ns, now_ns, &cws->upc);
+	}
+
+	// The caps of the pipeline are fixed once streaming, keep the images.
+	if (cws->gs != NULL) {
+		if (create_info->extent.width != ct->width || create_info->extent.height != ct->height) {
+			COMP_ERROR(ct->c, "Can not change the size of the images while streaming!");
+		}
+		return;
+	}
+
+	destroy_images(cws);
+
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	const char *format_str = NULL;
+	for (uint32_t i = 0; i < create_info->format_count; i++) {
+		VkFormat f = create_info->formats[i];
+		const char *str = gst_format_from_vk_format(f);
+		if (str != NULL && is_format_exportable(vk, f, create_info->image_usage)) {
+			format = f;
+			format_str = str;
+			break;
+		}
+	}
+
+	if (format == VK_FORMAT_UNDEFINED) {
+		COMP_ERROR(ct->c, "No format that can be exported as a linear DMA-BUF!");
+		return;
+	}
+
+	ct->format = format;
+	ct->width = create_info->extent.width;
+	ct->height = create_info->extent.height;
+	ct->surface_transform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+	cws->format_str = format_str;
+
+	// Each image is created fully or not at all, so the count always matches.
+	for (uint32_t i = 0; i < STREAM_IMAGE_COUNT; i++) {
+		ct->image_count = i + 1;
+
+		ret = create_image(cws, i, create_info->image_usage);
+		if (ret != VK_SUCCESS) {
+			destroy_images(cws);
+			return;
+		}
+	}
+
+	VkSemaphoreCreateInfo semaphore_info = {
+	    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+	};
+
+	ct->semaphores.present_complete = VK_NULL_HANDLE;
+	ct->semaphores.render_complete_is_timeline = false;
+	ret = vk->vkCreateSemaphore(vk->device, &semaphore_info, NULL, &ct->semaphores.render_complete);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(ct->c, "vkCreateSemaphore: %s", vk_result_string(ret));
+		destroy_images(cws);
+		return;
+	}
+
+	VK_NAME_SEMAPHORE(vk, ct->semaphores.render_complete, "comp_window_stream semaphore render complete");
+
+	gstreamer_sink_create_dmabuf_with_pipeline( //
+	    cws->gp,                                // gp
+	    ct->width,                              // width
+	    ct->height,                             // height
+	    format_str,                             // format_str
+	    STREAM_APPSRC_NAME,                     // appsrc_name
+	    &cws->gs);                              // out_gs
+
+	gstreamer_pipeline_play(cws->gp);
+
+	COMP_INFO(ct->c, "Streaming %ux%u %s images, stride %u", ct->width, ct->height, format_str,
+	          (uint32_t)cws->images[0].layout.rowPitch);
+}
+
+static bool
+target_has_images(struct comp_target *ct)
+{
+	return ct->image_count > 0;
+}
+
+static VkResult
+target_acquire(struct comp_target *ct, uint32_t *out_index)
+{
+	struct comp_window_stream *cws = (struct comp_window_stream *)ct;
+
+	os_thread_helper_lock(&cws->pusher);
+
+	uint32_t index = pick_image_locked(cws);
+	cws->images[index].state = STREAM_IMAGE_RENDERING;
+	cws->images[index].sequence = cws->sequence++;
+
+	os_thread_helper_unlock(&cws->pusher);
+
+	*out_index = index;
+
+	return VK_SUCCESS;
+}
+
+static VkResult
+target_present(struct comp_target *ct,
+               VkQueue queue,
+               uint32_t index,
+               uint64_t timeline_semaphore_value,
+               uint64_t desired_present_time_ns,
+               uint64_t present_slop_ns)
+{
+	struct comp_window_stream *cws = (struct comp_window_stream *)ct;
+	struct vk_bundle *vk = get_vk(cws);
+	struct comp_window_stream_image *img = &cws->images[index];
+	VkResult ret;
+
+	assert(index < ct->image_count);
+	assert(img->state == STREAM_IMAGE_RENDERING);
+
+	// Only pending if the image was taken back before the pusher got to it.
+	vk->vkWaitForFences(vk->device, 1, &img->fence, VK_TRUE, UINT64_MAX);
+	vk->vkResetFences(vk->device, 1, &img->fence);
+
+	// Nothing to execute, only turns the semaphore into a fence for the pusher.
+	VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .waitSemaphoreCount = 1,
+	    .pWaitSemaphores = &ct->semaphores.render_complete,
+	    .pWaitDstStageMask = &wait_stage,
+	};
+
+	ret = vk_cmd_submit_to_queue_locked(vk, queue, 1, &submit_info, img->fence);
+	if (ret != VK_SUCCESS) {
+		COMP_ERROR(ct->c, "vk_cmd_submit_to_queue_locked: %s", vk_result_string(ret));
+
+		os_thread_helper_lock(&cws->pusher);
+		img->state = STREAM_IMAGE_FREE;
+		os_thread_helper_unlock(&cws->pusher);
+
+		return ret;
+	}
+
+	os_thread_helper_lock(&cws->pusher);
+
+	img->timestamp_ns = desired_present_time_ns;
+	img->present_ns = os_monotonic_get_ns();
+	img->state = STREAM_IMAGE_QUEUED;
+	cws->queue[cws->queue_count++] = index;
+
+	os_thread_helper_signal_locked(&cws->pusher);
+	os_thread_helper_unlock(&cws->pusher);
+
+	return VK_SUCCESS;
+}
+
+static void
+target_flush(struct comp_target *ct)
+{
+	(void)ct;
+}
+
+static void
+target_calc_frame_pacing(struct comp_target *ct,
+                         int64_t *out_frame_id,
+                         uint64_t *out_wake_up_time_ns,
+                         uint64_t *out_desired_present_time_ns,
+                         uint64_t *out_present_slop_ns,
+                         uint64_t *out_predicted_display_time_ns)
+{
+	struct comp_window_stream *cws = (struct comp_window_stream *)ct;
+
+	int64_t frame_id = -1;
+	uint64_t predicted_display_period_ns = 0;
+	uint64_t min_display_period_ns = 0;
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	u_pc_predict(cws->upc,                      //
+	             now_ns,                        //
+	             &frame_id,                     //
+	             out_wake_up_time_ns,           //
+	             out_desired_present_time_ns,   //
+	             out_present_slop_ns,           //
+	             out_predicted_display_time_ns, //
+	             &predicted_display_period_ns,  //
+	             &min_display_period_ns);       //
+
+	cws->current_frame_id = frame_id;
+
+	*out_frame_id = frame_id;
+}
+
+static void
+target_mark_timing_point(struct comp_target *ct,
+                         enum comp_target_timing_point point,
+                         int64_t frame_id,
+                         uint64_t when_ns)
+{
+	struct comp_window_stream *cws = (struct comp_window_stream *)ct;
+	assert(frame_id == cws->current_frame_id);
+
+	switch (point) {
+	case COMP_TARGET_TIMING_POINT_WAKE_UP:
+		u_pc_mark_point(cws->upc, U_TIMING_POINT_WAKE_UP, cws->current_frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_BEGIN:
+		u_pc_mark_point(cws->upc, U_TIMING_POINT_BEGIN, cws->current_frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_SUBMIT_BEGIN:
+		u_pc_mark_point(cws->upc, U_TIMING_POINT_SUBMIT_BEGIN, cws->current_frame_id, when_ns);
+		break;
+	case COMP_TARGET_TIMING_POINT_SUBMIT_END:
+		u_pc_mark_point(cws->upc, U_TIMING_POINT_SUBMIT_END, cws->current_frame_id, when_ns);
+		break;
+	default: assert(false);
+	}
+}
+
+static VkResult
+target_update_timings(struct comp_target *ct)
+{
+	COMP_TRACE_MARKER();
+
+	struct comp_window_stream *cws = (struct comp_window_stream *)ct;
+
+	os_thread_helper_lock(&cws->pusher);
+	bool updated = cws->encode_ns_updated;
+	uint64_t encode_ns = cws->encode_ns;
+	cws->encode_ns_updated = false;
+	os_thread_helper_unlock(&cws->pusher);
+
+	// The frame is "displayed" once the encoder is done with it.
+	if (updated && cws->upc != NULL) {
+		u_pc_update_present_offset(cws->upc, cws->current_frame_id, encode_ns);
+	}
+
+	return VK_SUCCESS;
+}
+
+static void
+target_info_gpu(
+    struct comp_target *ct, int64_t frame_id, uint64_t gpu_start_ns, uint64_t gpu_end_ns, uint64_t when_ns)
+{
+	COMP_TRACE_MARKER();
+
+	struct comp_window_stream *cws = (struct comp_window_stream *)ct;
+
+	u_pc_info_gpu(cws->upc, frame_id, gpu_start_ns, gpu_end_ns, when_ns);
+}
+
+static void
+target_set_title(struct comp_target *ct, const char *title)
+{
+	(void)ct;
+	(void)title;
+}
+
+static void
+target_destroy(struct comp_target *ct)
+{
+	struct comp_window_stream *cws = (struct comp_window_stream *)ct;
+
+	// Nothing new gets pushed after this.
+	os_thread_helper_stop_and_wait(&cws->pusher);
+
+	// Flushes the encoder, which releases all of the images.
+	if (cws->gs != NULL) {
+		gstreamer_sink_send_eos(cws->gs);
+		gstreamer_pipeline_stop(cws->gp);
+	}
+
+	xrt_frame_context_destroy_nodes(&cws->xfctx);
+
+	COMP_INFO(ct->c, "Stream target dropped %" PRIu64 " frames", cws->dropped_frames);
+
+	destroy_images(cws);
+
+	// The releases take the lock, only destroy it once they are done.
+	os_thread_helper_destroy(&cws->pusher);
+
+	u_pc_destroy(&cws->upc);
+
+	free(ct);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+struct comp_target *
+comp_window_stream_create(struct comp_compositor *c)
+{
+	struct comp_window_stream *cws = U_TYPED_CALLOC(struct comp_window_stream);
+
+	cws->base.name = "stream";
+	cws->base.c = c;
+	cws->base.images = cws->target_images;
+	cws->base.init_pre_vulkan = target_init_pre_vulkan;
+	cws->base.init_post_vulkan = target_init_post_vulkan;
+	cws->base.check_ready = target_check_ready;
+	cws->base.create_images = target_create_images;
+	cws->base.has_images = target_has_images;
+	cws->base.acquire = target_acquire;
+	cws->base.present = target_present;
+	cws->base.flush = target_flush;
+	cws->base.calc_frame_pacing = target_calc_frame_pacing;
+	cws->base.mark_timing_point = target_mark_timing_point;
+	cws->base.update_timings = target_update_timings;
+	cws->base.info_gpu = target_info_gpu;
+	cws->base.set_title = target_set_title;
+	cws->base.destroy = target_destroy;
+
+	os_thread_helper_init(&cws->pusher);
+
+	return &cws->base;
+}
+
+
+/*
+ *
+ * Factory
+ *
+ */
+
+static const char *device_extensions[] = {
+    VK_EXT_EXTERNAL_MEMORY_DMA_BUF_EXTENSION_NAME,
+};
+
+static bool
+detect(const struct comp_target_factory *ctf, struct comp_compositor *c)
+{
+	return false;
+}
+
+static bool
+create_target(const struct comp_target_factory *ctf, struct comp_compositor *c, struct comp_target **out_ct)
+{
+	struct comp_target *ct = comp_window_stream_create(c);
+	if (ct == NULL) {
+		return false;
+	}
+
+	*out_ct = ct;
+
+	return true;
+}
+
+const struct comp_target_factory comp_target_factory_stream = {
+    .name = "GStreamer Zero-Copy Stream",
+    .identifier = "stream",
+    .requires_vulkan_for_create = false,
+    .is_deferred = false,
+    .required_instance_version = 0,
+    .required_instance_extensions = NULL,
+    .required_instance_extension_count = 0,
+    .optional_device_extensions = device_extensions,
+    .optional_device_extension_count = ARRAY_SIZE(device_extensions),
+    .detect = detect,
+    .create_target = create_target,
+};
@@ -36,6 +36,10 @@
 #endif
 
 
+// Lowest per axis scale of the recommended resolution, 1.0 turns dynamic resolution off.
+DEBUG_GET_ONCE_FLOAT_OPTION(dynamic_resolution_min_scale, "XRT_COMPOSITOR_DYNAMIC_RESOLUTION_MIN_SCALE", 0.5f)
+
+
 /*
  *
  * Slot management functions.
@@ -43,6 +47,28 @@
  */
 
 
+/*!
+ * How much of the slot is in use, entries past the layer count are always
+ * zeroed so they never need to be copied or cleared.
+ */
+static inline size_t
+slot_used_size(const struct multi_layer_slot *slot)
+{
+	assert(slot->layer_count <= MULTI_MAX_LAYERS);
+
+	return offsetof(struct multi_layer_slot, layers) + sizeof(slot->layers[0]) * slot->layer_count;
+}
+
+/*!
+ * Zero the used part of a slot and mark it as not holding a frame.
+ */
+static inline void
+slot_zero(struct multi_layer_slot *slot)
+{
+	memset(slot, 0, slot_used_size(slot));
+	slot->data.frame_id = -1;
+}
+
 /*!
  * Clear a slot, need to have the list_and_timing_lock held.
  */
@@ -60,8 +86,7 @@ slot_clear_locked(struct multi_compositor *mc, struct multi_layer_slot *slot)
 		}
 	}
 
-	U_ZERO(slot);
-	slot->data.frame_id = -1;
+	slot_zero(slot);
 }
 
 /*!
@@ -74,10 +99,9 @@ slot_move_into_cleared(struct multi_layer_slot *dst, struct multi_layer_slot *sr
 	assert(dst->data.frame_id == -1);
 
 	// All references are kept.
-	*dst = *src;
+	memcpy(dst, src, slot_used_size(src));
 
-	U_ZERO(src);
-	src->data.frame_id = -1;
+	slot_zero(src);
 }
 
 /*!
@@ -90,6 +114,82 @@ slot_move_and_clear_locked(struct multi_compositor *mc, struct multi_layer_slot
 	slot_move_into_cleared(dst, src);
 }
 
+/*!
+ * Same as @ref slot_clear_locked but only takes the list_and_timing_lock for
+ * the pacer, the swapchain references are dropped outside of it.
+ */
+static void
+slot_clear(struct multi_compositor *mc, struct multi_layer_slot *slot)
+{
+	if (slot->active) {
+		uint64_t now_ns = os_monotonic_get_ns();
+
+		os_mutex_lock(&mc->msc->list_and_timing_lock);
+		u_pa_retired(mc->upa, slot->data.frame_id, now_ns);
+		os_mutex_unlock(&mc->msc->list_and_timing_lock);
+	}
+
+	for (size_t i = 0; i < slot->layer_count; i++) {
+		for (size_t k = 0; k < ARRAY_SIZE(slot->layers[i].xscs); k++) {
+			xrt_swapchain_reference(&slot->layers[i].xscs[k], NULL);
+		}
+	}
+
+	slot_zero(slot);
+}
+
+
+/*
+ *
+ * Snapshot functions.
+ *
+ */
+
+static int32_t
+snapshot_load(xrt_atomic_s32_t *p)
+{
+	// A compare and swap doubles as a load with a full barrier.
+	return xrt_atomic_s32_cmpxchg(p, 0, 0);
+}
+
+static int32_t
+snapshot_exchange(xrt_atomic_s32_t *p, int32_t value)
+{
+	int32_t old = *p;
+	int32_t prev;
+
+	while ((prev = xrt_atomic_s32_cmpxchg(p, old, value)) != old) {
+		old = prev;
+	}
+
+	return old;
+}
+
+/*!
+ * Called by the client thread, moves the progress slot into the back slot and
+ * swaps it with the middle slot.
+ */
+static void
+snapshot_publish_progress(struct multi_compositor *mc)
+{
+	int32_t back = mc->snapshot.back;
+	struct multi_layer_slot *slot = &mc->snapshot.slots[back];
+
+	slot_move_into_cleared(slot, &mc->progress);
+	mc->snapshot.seqs[back] = ++mc->snapshot.published_seq;
+	mc->snapshot.published_display_time_ns = slot->data.display_time_ns;
+
+	int32_t old = snapshot_exchange(&mc->snapshot.middle, back | MULTI_SNAPSHOT_FRESH_BIT);
+	mc->snapshot.back = old & ~MULTI_SNAPSHOT_FRESH_BIT;
+
+	/*
+	 * What we got back is either a slot that the render thread is done
+	 * with or a frame that was never picked up and has now been replaced,
+	 * clear it here so the render thread doesn't need to.
+	 */
+	slot_clear(mc, &mc->snapshot.slots[mc->snapshot.back]);
+}
+
 
 /*
  *
@@ -104,6 +204,20 @@ multi_compositor_push_event(struct multi_compositor *mc, const union xrt_session
 	return xrt_session_event_sink_push(mc->xses, xse);
 }
 
+static void
+push_resolution_change(struct multi_compositor *mc, float from_scale, float to_scale)
+{
+	union xrt_session_event xse = XRT_STRUCT_INIT;
+	xse.type = XRT_SESSION_EVENT_RECOMMENDED_RESOLUTION_CHANGE;
+	xse.resolution.from_scale = from_scale;
+	xse.resolution.to_scale = to_scale;
+
+	xrt_result_t xret = multi_compositor_push_event(mc, &xse);
+	if (xret != XRT_SUCCESS) {
+		U_LOG_W("Failed to push recommended resolution change event!");
+	}
+}
+
 
 /*
  *
@@ -174,23 +288,25 @@ wait_for_scheduled_free(struct multi_compositor *mc)
 {
 	COMP_TRACE_MARKER();
 
-	os_mutex_lock(&mc->slot_lock);
+	// Block here if the last published frame has not been delivered.
+	while (snapshot_load(&mc->snapshot.delivered_seq) != mc->snapshot.published_seq) {
+		uint64_t now_ns = os_monotonic_get_ns();
 
-	struct multi_compositor volatile *v_mc = mc;
+		os_mutex_lock(&mc->slot_lock);
+		uint64_t next_frame_display = mc->slot_next_frame_display;
+		os_mutex_unlock(&mc->slot_lock);
 
-	// Block here if the scheduled slot is not clear.
-	while (v_mc->scheduled.active) {
-		uint64_t now_ns = os_monotonic_get_ns();
+		uint64_t published_ns = mc->snapshot.published_display_time_ns;
 
 		// This frame is for the next frame, drop the old one no matter what.
-		if (time_is_within_half_ms(mc->progress.data.display_time_ns, mc->slot_next_frame_display)) {
+		if (time_is_within_half_ms(mc->progress.data.display_time_ns, next_frame_display)) {
 			U_LOG_W("%.3fms: Dropping old missed frame in favour for completed new frame",
 			        time_ns_to_ms_f(now_ns));
 			break;
 		}
 
 		// Replace the scheduled frame if it's in the past.
-		if (v_mc->scheduled.data.display_time_ns < now_ns) {
+		if (published_ns < now_ns) {
 			U_LOG_T("%.3fms: Replacing frame for time in past in favour of completed new frame",
 			        time_ns_to_ms_f(now_ns));
 			break;
@@ -203,32 +319,21 @@ wait_for_scheduled_free(struct multi_compositor *mc)
 		    "\n\tprogress: %fms (%" PRIu64
 		    ")  (latest completed frame)"
 		    "\n\tscheduled: %fms (%" PRIu64 ") (oldest waiting frame)",
-		    time_ns_to_ms_f((int64_t)v_mc->slot_next_frame_display - now_ns),        //
-		    v_mc->slot_next_frame_display,                                           //
-		    time_ns_to_ms_f((int64_t)v_mc->progress.data.display_time_ns - now_ns),  //
-		    v_mc->progress.data.display_time_ns,                                     //
-		    time_ns_to_ms_f((int64_t)v_mc->scheduled.data.display_time_ns - now_ns), //
-		    v_mc->scheduled.data.display_time_ns);                                   //
-
-		os_mutex_unlock(&mc->slot_lock);
+		    time_ns_to_ms_f((int64_t)next_frame_display - now_ns),                //
+		    next_frame_display,                                                   //
+		    time_ns_to_ms_f((int64_t)mc->progress.data.display_time_ns - now_ns), //
+		    mc->progress.data.display_time_ns,                                    //
+		    time_ns_to_ms_f((int64_t)published_ns - now_ns),                      //
+		    published_ns);                                                        //
 
 		os_precise_sleeper_nanosleep(&mc->scheduled_sleeper, U_TIME_1MS_IN_NS);
-
-		os_mutex_lock(&mc->slot_lock);
 	}
 
-	os_mutex_unlock(&mc->slot_lock);
-
 	/*
-	 * Need to take list_and_timing_lock before slot_lock because slot_lock
-	 * is taken in multi_compositor_deliver_any_frames with list_and_timing_lock
-	 * held to stop clients from going away.
+	 * Lockless, the render thread picks up the frame from the middle slot
+	 * on its own time and never waits on this thread.
 	 */
-	os_mutex_lock(&mc->msc->list_and_timing_lock);
-	os_mutex_lock(&mc->slot_lock);
-	slot_move_and_clear_locked(mc, &mc->scheduled, &mc->progress);
-	os_mutex_unlock(&mc->slot_lock);
-	os_mutex_unlock(&mc->msc->list_and_timing_lock);
+	snapshot_publish_progress(mc);
 }
 
 static void *
@@ -264,12 +369,14 @@ run_func(void *ptr)
 		}
 
 		int64_t frame_id = mc->wait_thread.frame_id;
+		uint64_t commit_ns = mc->wait_thread.commit_ns;
 		struct xrt_compositor_fence *xcf = mc->wait_thread.xcf;
 		struct xrt_compositor_semaphore *xcsem = mc->wait_thread.xcsem; // No need to ref, a move.
 		uint64_t value = mc->wait_thread.value;
 
 		// Ok to clear these on spurious wakeup as they are empty then anyways.
 		mc->wait_thread.frame_id = 0;
+		mc->wait_thread.commit_ns = 0;
 		mc->wait_thread.xcf = NULL;
 		mc->wait_thread.xcsem = NULL;
 		mc->wait_thread.value = 0;
@@ -296,8 +403,16 @@ run_func(void *ptr)
 
 		os_mutex_lock(&mc->msc->list_and_timing_lock);
 		u_pa_mark_gpu_done(mc->upa, frame_id, now_ns);
+		float from_scale = mc->upr.scale;
+		bool changed = multi_system_compositor_add_client_gpu_time_locked(mc->msc, mc, now_ns - commit_ns);
+		float to_scale = mc->upr.scale;
 		os_mutex_unlock(&mc->msc->list_and_timing_lock);
 
+		// Outside of the lock, the sink might take its own locks.
+		if (changed) {
+			push_resolution_change(mc, from_scale, to_scale);
+		}
+
 		// Wait for the delivery slot.
 		wait_for_scheduled_free(mc);
 
@@ -305,8 +420,8 @@ run_func(void *ptr)
 
 		/*
 		 * Finally no longer waiting, this must be done after
-		 * wait_for_scheduled_free because it moves the slots/layers
-		 * from progress to scheduled to be picked up by the compositor.
+		 * wait_for_scheduled_free because it publishes the slots/layers
+		 * from progress to be picked up by the compositor.
 		 */
 		mc->wait_thread.waiting = false;
 
@@ -362,6 +477,7 @@ push_fence_to_wait_thread(struct multi_compositor *mc, int64_t frame_id, struct
 	assert(mc->wait_thread.xcf == NULL);
 
 	mc->wait_thread.frame_id = frame_id;
+	mc->wait_thread.commit_ns = os_monotonic_get_ns();
 	mc->wait_thread.xcf = xcf;
 
 	os_thread_helper_signal_locked(&mc->wait_thread.oth);
@@ -384,6 +500,7 @@ push_semaphore_to_wait_thread(struct multi_compositor *mc,
 	assert(mc->wait_thread.xcsem == NULL);
 
 	mc->wait_thread.frame_id = frame_id;
+	mc->wait_thread.commit_ns = os_monotonic_get_ns();
 	xrt_compositor_semaphore_reference(&mc->wait_thread.xcsem, xcsem);
 	mc->wait_thread.value = value;
 
@@ -392,6 +509,16 @@ push_semaphore_to_wait_thread(struct multi_compositor *mc,
 	os_thread_helper_unlock(&mc->wait_thread.oth);
 }
 
+static void
+mark_committed(struct multi_compositor *mc)
+{
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	os_mutex_lock(&mc->msc->list_and_timing_lock);
+	multi_system_compositor_add_client_cpu_time_locked(mc->msc, mc, now_ns - mc->began.when_ns);
+	os_mutex_unlock(&mc->msc->list_and_timing_lock);
+}
+
 
 /*
  *
@@ -411,6 +538,63 @@ multi_compositor_get_swapchain_create_properties(struct xrt_compositor *xc,
 	return xrt_comp_get_swapchain_create_properties(&mc->msc->xcn->base, info, xsccp);
 }
 
+/*!
+ * The native compositor's swapchains are native ones, so the size of the
+ * images can be attributed to the client that created it.
+ */
+static void
+track_swapchain(struct multi_compositor *mc, struct xrt_swapchain *xsc)
+{
+	struct xrt_swapchain_native *xscn = (struct xrt_swapchain_native *)xsc;
+
+	uint64_t bytes = 0;
+	for (uint32_t i = 0; i < xsc->image_count; i++) {
+		bytes += xscn->images[i].size;
+	}
+
+	os_mutex_lock(&mc->msc->list_and_timing_lock);
+
+	U_ARRAY_REALLOC_OR_FREE(mc->swapchains.entries, struct multi_swapchain_entry, mc->swapchains.count + 1);
+	if (mc->swapchains.entries == NULL) {
+		// Lost track of all of them, the references leak but it's just accounting.
+		U_LOG_E("Failed to allocate swapchain tracking entry!");
+		mc->swapchains.count = 0;
+		mc->stats.swapchain_bytes = 0;
+		os_mutex_unlock(&mc->msc->list_and_timing_lock);
+		return;
+	}
+
+	struct multi_swapchain_entry *entry = &mc->swapchains.entries[mc->swapchains.count++];
+	entry->xsc = NULL;
+	entry->bytes = bytes;
+	xrt_swapchain_reference(&entry->xsc, xsc);
+
+	mc->stats.swapchain_bytes += bytes;
+
+	os_mutex_unlock(&mc->msc->list_and_timing_lock);
+}
+
+static void
+release_swapchains_locked(struct multi_compositor *mc, bool all)
+{
+	uint32_t kept = 0;
+
+	for (uint32_t i = 0; i < mc->swapchains.count; i++) {
+		struct multi_swapchain_entry *entry = &mc->swapchains.entries[i];
+
+		// Only our reference left, nothing else can grab a new one.
+		if (all || entry->xsc->reference.count == 1) {
+			mc->stats.swapchain_bytes -= entry->bytes;
+			xrt_swapchain_reference(&entry->xsc, NULL);
+			continue;
+		}
+
+		mc->swapchains.entries[kept++] = *entry;
+	}
+
+	mc->swapchains.count = kept;
+}
+
 static xrt_result_t
 multi_compositor_create_swapchain(struct xrt_compositor *xc,
                                   const struct xrt_swapchain_create_info *info,
@@ -420,7 +604,14 @@ multi_compositor_create_swapchain(struct xrt_compositor *xc,
 
 	struct multi_compositor *mc = multi_compositor(xc);
 
-	return xrt_comp_create_swapchain(&mc->msc->xcn->base, info, out_xsc);
+	xrt_result_t xret = xrt_comp_create_swapchain(&mc->msc->xcn->base, info, out_xsc);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	track_swapchain(mc, *out_xsc);
+
+	return XRT_SUCCESS;
 }
 
 static xrt_result_t
@@ -594,6 +785,9 @@ multi_compositor_begin_frame(struct xrt_compositor *xc, int64_t frame_id)
 	u_pa_mark_point(mc->upa, frame_id, U_TIMING_POINT_BEGIN, now_ns);
 	os_mutex_unlock(&mc->msc->list_and_timing_lock);
 
+	mc->began.frame_id = frame_id;
+	mc->began.when_ns = now_ns;
+
 	return XRT_SUCCESS;
 }
 
@@ -607,6 +801,7 @@ multi_compositor_discard_frame(struct xrt_compositor *xc, int64_t frame_id)
 
 	os_mutex_lock(&mc->msc->list_and_timing_lock);
 	u_pa_mark_discarded(mc->upa, frame_id, now_ns);
+	mc->stats.discarded_count++;
 	os_mutex_unlock(&mc->msc->list_and_timing_lock);
 
 	return XRT_SUCCESS;
@@ -625,7 +820,7 @@ multi_compositor_layer_begin(struct xrt_compositor *xc, const struct xrt_layer_f
 
 	/*
 	 * We have to block here for the waiting thread to push the last
-	 * submitted frame from the progress slot to the scheduled slot,
+	 * submitted frame from the progress slot to the snapshot slots,
 	 * it only does after the sync object has signaled completion.
 	 *
 	 * If the previous frame's GPU work has not completed that means we
@@ -636,11 +831,15 @@ multi_compositor_layer_begin(struct xrt_compositor *xc, const struct xrt_layer_f
 	wait_for_wait_thread(mc);
 
 	assert(mc->progress.layer_count == 0);
-	U_ZERO(&mc->progress);
+	slot_zero(&mc->progress);
 
 	mc->progress.active = true;
 	mc->progress.data = *data;
 
+	if (mc->began.frame_id == data->frame_id) {
+		mc->progress.when_began_ns = mc->began.when_ns;
+	}
+
 	return XRT_SUCCESS;
 }
 
@@ -684,6 +883,30 @@ multi_compositor_layer_projection_depth(struct xrt_compositor *xc,
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+multi_compositor_layer_projection_space_warp(struct xrt_compositor *xc,
+                                             struct xrt_device *xdev,
+                                             struct xrt_swapchain *xsc[XRT_MAX_VIEWS],
+                                             struct xrt_swapchain *d_xsc[XRT_MAX_VIEWS],
+                                             struct xrt_swapchain *mv_xsc[XRT_MAX_VIEWS],
+                                             const struct xrt_layer_data *data)
+{
+	struct multi_compositor *mc = multi_compositor(xc);
+
+	size_t index = mc->progress.layer_count++;
+	mc->progress.layers[index].xdev = xdev;
+
+	struct xrt_swapchain **xscs = mc->progress.layers[index].xscs;
+	for (uint32_t i = 0; i < data->view_count; ++i) {
+		xrt_swapchain_reference(&xscs[i], xsc[i]);
+		xrt_swapchain_reference(&xscs[i + data->view_count], d_xsc[i]);
+		xrt_swapchain_reference(&xscs[i + data->view_count * 2], mv_xsc[i]);
+	}
+	mc->progress.layers[index].data = *data;
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 multi_compositor_layer_quad(struct xrt_compositor *xc,
                             struct xrt_device *xdev,
@@ -773,6 +996,8 @@ multi_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handl
 	struct xrt_compositor_fence *xcf = NULL;
 	int64_t frame_id = mc->progress.data.frame_id;
 
+	mark_committed(mc);
+
 	do {
 		if (!xrt_graphics_sync_handle_is_valid(sync_handle)) {
 			break;
@@ -820,6 +1045,8 @@ multi_compositor_layer_commit_with_semaphore(struct xrt_compositor *xc,
 	struct multi_compositor *mc = multi_compositor(xc);
 	int64_t frame_id = mc->progress.data.frame_id;
 
+	mark_committed(mc);
+
 	push_semaphore_to_wait_thread(mc, frame_id, xcsem, value);
 
 	return XRT_SUCCESS;
@@ -883,10 +1110,15 @@ multi_compositor_destroy(struct xrt_compositor *xc)
 	// We are now off the rendering list, clear slots for any swapchains.
 	os_mutex_lock(&mc->msc->list_and_timing_lock);
 	slot_clear_locked(mc, &mc->progress);
-	slot_clear_locked(mc, &mc->scheduled);
+	for (uint32_t i = 0; i < ARRAY_SIZE(mc->snapshot.slots); i++) {
+		slot_clear_locked(mc, &mc->snapshot.slots[i]);
+	}
 	slot_clear_locked(mc, &mc->delivered);
+	release_swapchains_locked(mc, true);
 	os_mutex_unlock(&mc->msc->list_and_timing_lock);
 
+	free(mc->swapchains.entries);
+
 	// Does null checking.
 	u_pa_destroy(&mc->upa);
 
@@ -914,23 +1146,38 @@ log_frame_time_diff(uint64_t frame_time_ns, uint64_t display_time_ns)
 void
 multi_compositor_deliver_any_frames(struct multi_compositor *mc, uint64_t display_time_ns)
 {
-	os_mutex_lock(&mc->slot_lock);
+	/*
+	 * Pick up the latest published frame, this replaces any frame in the
+	 * front slot that is still waiting for its display time. Only the
+	 * client thread sets the fresh bit so it is still set on exchange.
+	 */
+	if ((snapshot_load(&mc->snapshot.middle) & MULTI_SNAPSHOT_FRESH_BIT) != 0) {
+		// Still waiting for its display time, so it will never be shown.
+		if (mc->snapshot.slots[mc->snapshot.front].active) {
+			mc->stats.dropped_count++;
+		}
 
-	if (!mc->scheduled.active) {
-		os_mutex_unlock(&mc->slot_lock);
+		int32_t old = snapshot_exchange(&mc->snapshot.middle, mc->snapshot.front);
+		mc->snapshot.front = old & ~MULTI_SNAPSHOT_FRESH_BIT;
+	}
+
+	int32_t front = mc->snapshot.front;
+	struct multi_layer_slot *slot = &mc->snapshot.slots[front];
+
+	if (!slot->active) {
 		return;
 	}
 
-	if (time_is_greater_then_or_within_half_ms(display_time_ns, mc->scheduled.data.display_time_ns)) {
-		slot_move_and_clear_locked(mc, &mc->delivered, &mc->scheduled);
+	if (time_is_greater_then_or_within_half_ms(display_time_ns, slot->data.display_time_ns)) {
+		slot_move_and_clear_locked(mc, &mc->delivered, slot);
+		snapshot_exchange(&mc->snapshot.delivered_seq, mc->snapshot.seqs[front]);
+		mc->stats.delivered_count++;
 
 		uint64_t frame_time_ns = mc->delivered.data.display_time_ns;
 		if (!time_is_within_half_ms(frame_time_ns, display_time_ns)) {
 			log_frame_time_diff(frame_time_ns, display_time_ns);
 		}
 	}
-
-	os_mutex_unlock(&mc->slot_lock);
 }
 
 void
@@ -939,17 +1186,20 @@ multi_compositor_latch_frame_locked(struct multi_compositor *mc, uint64_t when_n
 	u_pa_latched(mc->upa, mc->delivered.data.frame_id, when_ns, system_frame_id);
 }
 
+void
+multi_compositor_release_unused_swapchains_locked(struct multi_compositor *mc)
+{
+	release_swapchains_locked(mc, false);
+}
+
 void
 multi_compositor_retire_delivered_locked(struct multi_compositor *mc, uint64_t when_ns)
 {
 	slot_clear_locked(mc, &mc->delivered);
 }
 
-xrt_result_t
-multi_compositor_create(struct multi_system_compositor *msc,
-                        const struct xrt_session_info *xsi,
-                        struct xrt_session_event_sink *xses,
-                        struct xrt_compositor_native **out_xcn)
+struct multi_compositor *
+multi_compositor_create_spare(struct multi_system_compositor *msc)
 {
 	COMP_TRACE_MARKER();
 
@@ -970,6 +1220,7 @@ multi_compositor_create(struct multi_system_compositor *msc,
 	mc->base.base.layer_begin = multi_compositor_layer_begin;
 	mc->base.base.layer_projection = multi_compositor_layer_projection;
 	mc->base.base.layer_projection_depth = multi_compositor_layer_projection_depth;
+	mc->base.base.layer_projection_space_warp = multi_compositor_layer_projection_space_warp;
 	mc->base.base.layer_quad = multi_compositor_layer_quad;
 	mc->base.base.layer_cube = multi_compositor_layer_cube;
 	mc->base.base.layer_cylinder = multi_compositor_layer_cylinder;
@@ -982,12 +1233,19 @@ multi_compositor_create(struct multi_system_compositor *msc,
 	mc->base.base.get_display_refresh_rate = multi_compositor_get_display_refresh_rate;
 	mc->base.base.request_display_refresh_rate = multi_compositor_request_display_refresh_rate;
 	mc->msc = msc;
-	mc->xses = xses;
-	mc->xsi = *xsi;
 
 	os_mutex_init(&mc->slot_lock);
 	os_thread_helper_init(&mc->wait_thread.oth);
 
+	// All slots start out cleared, each index owned by one role.
+	for (uint32_t i = 0; i < ARRAY_SIZE(mc->snapshot.slots); i++) {
+		mc->snapshot.slots[i].data.frame_id = -1;
+	}
+	mc->began.frame_id = -1;
+	mc->snapshot.back = 0;
+	mc->snapshot.middle = 1;
+	mc->snapshot.front = 2;
+
 	// Passthrough our formats from the native compositor to the client.
 	mc->base.base.info = msc->xcn->base.info;
 
@@ -1000,6 +1258,40 @@ multi_compositor_create(struct multi_system_compositor *msc,
 	// This is safe to do without a lock since we are not on the list yet.
 	u_paf_create(msc->upaf, &mc->upa);
 
+	// Last start the wait thread.
+	os_thread_helper_start(&mc->wait_thread.oth, run_func, mc);
+
+	os_thread_helper_lock(&mc->wait_thread.oth);
+
+	// Wait for the wait thread to fully start.
+	while (!mc->wait_thread.alive) {
+		os_thread_helper_wait_locked(&mc->wait_thread.oth);
+	}
+
+	os_thread_helper_unlock(&mc->wait_thread.oth);
+
+	return mc;
+}
+
+xrt_result_t
+multi_compositor_create(struct multi_system_compositor *msc,
+                        const struct xrt_session_info *xsi,
+                        struct xrt_session_event_sink *xses,
+                        struct xrt_compositor_native **out_xcn)
+{
+	COMP_TRACE_MARKER();
+
+	// Only pay for setting up a new one if there was none ready.
+	struct multi_compositor *mc = multi_system_compositor_take_spare(msc);
+	if (mc == NULL) {
+		mc = multi_compositor_create_spare(msc);
+	}
+
+	// Not seen by anybody else until it is on the list.
+	mc->xses = xses;
+	mc->xsi = *xsi;
+	u_pr_init(&mc->upr, debug_get_float_option_dynamic_resolution_min_scale());
+
 	os_mutex_lock(&msc->list_and_timing_lock);
 
 	// If we have too many clients, just ignore it.
@@ -1019,19 +1311,6 @@ multi_compositor_create(struct multi_system_compositor *msc,
 
 	os_mutex_unlock(&msc->list_and_timing_lock);
 
-	// Last start the wait thread.
-	os_thread_helper_start(&mc->wait_thread.oth, run_func, mc);
-
-	os_thread_helper_lock(&mc->wait_thread.oth);
-
-	// Wait for the wait thread to fully start.
-	while (!mc->wait_thread.alive) {
-		os_thread_helper_wait_locked(&mc->wait_thread.oth);
-	}
-
-	os_thread_helper_unlock(&mc->wait_thread.oth);
-
-
 	*out_xcn = &mc->base;
 
 	return XRT_SUCCESS;
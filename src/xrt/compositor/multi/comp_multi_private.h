@@ -17,6 +17,8 @@
 #include "os/os_threading.h"
 
 #include "util/u_pacing.h"
+#include "util/u_pacing_resolution.h"
+#include "util/u_latency_probe.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -39,6 +41,22 @@ extern "C" {
  */
 #define MULTI_MAX_LAYERS 16
 
+/*!
+ * Number of max pre-created @ref multi_compositor objects kept around for
+ * new sessions to claim.
+ *
+ * @ingroup comp_multi
+ */
+#define MULTI_MAX_SPARE_CLIENTS 4
+
+/*!
+ * Set in @ref multi_compositor::snapshot middle when the slot has been
+ * published by the client thread but not yet picked up by the render thread.
+ *
+ * @ingroup comp_multi
+ */
+#define MULTI_SNAPSHOT_FRESH_BIT 0x4
+
 
 /*
  *
@@ -65,7 +83,7 @@ struct multi_layer_entry
 	 *
 	 * How many are actually used depends on the value of @p data.type
 	 */
-	struct xrt_swapchain *xscs[2 * XRT_MAX_VIEWS];
+	struct xrt_swapchain *xscs[3 * XRT_MAX_VIEWS];
 
 	/*!
 	 * All basic (trivially-serializable) data associated with a layer,
@@ -74,6 +92,20 @@ struct multi_layer_entry
 	struct xrt_layer_data data;
 };
 
+/*!
+ * A swapchain created by a client, kept to attribute its memory to the client.
+ *
+ * @ingroup comp_multi
+ */
+struct multi_swapchain_entry
+{
+	//! Holds a reference, released once nothing else holds one.
+	struct xrt_swapchain *xsc;
+
+	//! Size of the images of the swapchain.
+	uint64_t bytes;
+};
+
 /*!
  * Render state for a single client, including all layers.
  *
@@ -83,8 +115,19 @@ struct multi_layer_slot
 {
 	struct xrt_layer_frame_data data;
 	uint32_t layer_count;
-	struct multi_layer_entry layers[MULTI_MAX_LAYERS];
 	bool active;
+
+	/*!
+	 * When the app began this frame, taken as when it sampled the poses it
+	 * rendered with. Zero if not known or already given to the latency probe.
+	 */
+	uint64_t when_began_ns;
+
+	/*!
+	 * Must be last, slots are only copied and cleared up to
+	 * @ref layer_count so entries past it are always zeroed.
+	 */
+	struct multi_layer_entry layers[MULTI_MAX_LAYERS];
 };
 
 /*!
@@ -141,6 +184,9 @@ struct multi_compositor
 		//! Frame id of frame being waited on.
 		int64_t frame_id;
 
+		//! When the frame being waited on was committed.
+		uint64_t commit_ns;
+
 		//! The wait thread itself
 		struct os_thread_helper oth;
 
@@ -159,7 +205,7 @@ struct multi_compositor
 		bool blocked;
 	} wait_thread;
 
-	//! Lock for all of the slots.
+	//! Lock for @ref slot_next_frame_display, the slots are lockless.
 	struct os_mutex slot_lock;
 
 	/*!
@@ -173,8 +219,50 @@ struct multi_compositor
 	 */
 	struct multi_layer_slot progress;
 
-	//! Scheduled frames for a future timepoint.
-	struct multi_layer_slot scheduled;
+	//! The last begun frame, only touched by the client thread.
+	struct
+	{
+		int64_t frame_id;
+		uint64_t when_ns;
+	} began;
+
+	/*!
+	 * Triple buffered committed frames, the client thread publishes into
+	 * them and the render thread picks up the latest one without ever
+	 * waiting on the client. Which slot has which role is tracked by the
+	 * indices, together they are always a permutation of 0, 1 and 2.
+	 */
+	struct
+	{
+		struct multi_layer_slot slots[3];
+
+		//! Publish sequence number of each slot, follows the slot.
+		int32_t seqs[3];
+
+		//! Only touched by the client thread, the slot to publish next.
+		int32_t back;
+
+		/*!
+		 * Shared between the threads, last published slot index with
+		 * @ref MULTI_SNAPSHOT_FRESH_BIT set if not yet picked up.
+		 */
+		xrt_atomic_s32_t middle;
+
+		/*!
+		 * Only touched by the render thread, the last picked up slot,
+		 * holds a frame that is waiting for its display time if active.
+		 */
+		int32_t front;
+
+		//! Only touched by the client thread, sequence number of the last publish.
+		int32_t published_seq;
+
+		//! Only touched by the client thread, display time of the last publish.
+		uint64_t published_display_time_ns;
+
+		//! Written by the render thread, sequence number of last delivered frame.
+		xrt_atomic_s32_t delivered_seq;
+	} snapshot;
 
 	/*!
 	 * Fully ready to be used.
@@ -183,6 +271,19 @@ struct multi_compositor
 	struct multi_layer_slot delivered;
 
 	struct u_pacing_app *upa;
+
+	//! Frame and GPU time accounting, protected by the list_and_timing_lock.
+	struct xrt_multi_compositor_client_stats stats;
+
+	//! Recommended resolution from the GPU time, protected by the list_and_timing_lock.
+	struct u_pacing_resolution upr;
+
+	//! Swapchains created by the client, protected by the list_and_timing_lock.
+	struct
+	{
+		struct multi_swapchain_entry *entries;
+		uint32_t count;
+	} swapchains;
 };
 
 /*!
@@ -207,6 +308,17 @@ multi_compositor_create(struct multi_system_compositor *msc,
                         struct xrt_session_event_sink *xses,
                         struct xrt_compositor_native **out_xcn);
 
+/*!
+ * Create a multi client wrapper compositor that is not yet tied to a session,
+ * it has its pacer and running wait thread but is not on the list of clients.
+ * Used to pre-create compositors that @ref multi_compositor_create claims, can
+ * be destroyed as is with @ref xrt_comp_destroy.
+ *
+ * @ingroup comp_multi
+ */
+struct multi_compositor *
+multi_compositor_create_spare(struct multi_system_compositor *msc);
+
 /*!
  * Push a event to be delivered to the session that corresponds
  * to the given @ref multi_compositor.
@@ -219,7 +331,8 @@ multi_compositor_push_event(struct multi_compositor *mc, const union xrt_session
 
 /*!
  * Deliver any scheduled frames at that is to be display at or after the given @p display_time_ns. Called by the render
- * thread and copies data from multi_compositor::scheduled to multi_compositor::delivered while holding the slot_lock.
+ * thread, picks up the latest published frame from multi_compositor::snapshot and moves it to
+ * multi_compositor::delivered, never blocks on the client thread.
  *
  * @ingroup comp_multi
  * @private @memberof multi_compositor
@@ -247,6 +360,17 @@ multi_compositor_latch_frame_locked(struct multi_compositor *mc, uint64_t when_n
 void
 multi_compositor_retire_delivered_locked(struct multi_compositor *mc, uint64_t when_ns);
 
+/*!
+ * Drops the swapchains that the client and the layer slots no longer hold a
+ * reference to from the memory accounting, called by the render thread.
+ * The list_and_timing_lock is held when this function is called.
+ *
+ * @ingroup comp_multi
+ * @private @memberof multi_compositor
+ */
+void
+multi_compositor_release_unused_swapchains_locked(struct multi_compositor *mc);
+
 
 /*
  *
@@ -363,8 +487,41 @@ struct multi_system_compositor
 		uint64_t diff_ns;
 	} last_timings;
 
+	//! Render loop statistics, protected by the list_and_timing_lock.
+	struct xrt_multi_compositor_stats stats;
+
+	//! When the last frame was started, only touched by the render thread.
+	uint64_t last_frame_start_ns;
+
 	//! List of active clients.
 	struct multi_compositor *clients[MULTI_MAX_CLIENTS];
+
+	//! Latency from apps sampling their poses to their frames being shown, only used on the render thread.
+	struct
+	{
+		//! See @ref u_latency_probe_enabled, decided at creation.
+		bool enabled;
+
+		struct u_latency_probe probe;
+	} latency;
+
+	/*!
+	 * Compositors created ahead of time so that a new session does not
+	 * have to wait for the wait thread and pacer to be set up, refilled
+	 * by the thread in here. All fields protected by the thread's lock.
+	 */
+	struct
+	{
+		struct os_thread_helper oth;
+
+		struct multi_compositor *array[MULTI_MAX_SPARE_CLIENTS];
+
+		//! Number of compositors in @p array.
+		uint32_t count;
+
+		//! How many to keep around, the thread is not started if zero.
+		uint32_t target;
+	} spares;
 };
 
 /*!
@@ -389,6 +546,42 @@ multi_system_compositor(struct xrt_system_compositor *xsc)
 void
 multi_system_compositor_update_session_status(struct multi_system_compositor *msc, bool active);
 
+/*!
+ * Record how long the GPU took to finish the work of a committed frame of the
+ * client, measured from the commit to its fence or semaphore signalling.
+ * The list_and_timing_lock is held when this function is called.
+ *
+ * @return True if the recommended resolution scale of the client changed.
+ * @ingroup comp_multi
+ * @private @memberof multi_system_compositor
+ */
+bool
+multi_system_compositor_add_client_gpu_time_locked(struct multi_system_compositor *msc,
+                                                   struct multi_compositor *mc,
+                                                   uint64_t gpu_ns);
+
+/*!
+ * Record how long the client took from beginning a frame to committing it.
+ * The list_and_timing_lock is held when this function is called.
+ *
+ * @ingroup comp_multi
+ * @private @memberof multi_system_compositor
+ */
+void
+multi_system_compositor_add_client_cpu_time_locked(struct multi_system_compositor *msc,
+                                                   struct multi_compositor *mc,
+                                                   uint64_t cpu_ns);
+
+/*!
+ * Take one of the pre-created compositors, returns NULL if there are none
+ * left. Wakes up the thread that creates new ones.
+ *
+ * @ingroup comp_multi
+ * @private @memberof multi_system_compositor
+ */
+struct multi_compositor *
+multi_system_compositor_take_spare(struct multi_system_compositor *msc);
+
 
 #ifdef __cplusplus
 }
@@ -23,9 +23,10 @@
 #include "util/u_trace_marker.h"
 #include "util/u_distortion_mesh.h"
 
-#ifdef XRT_OS_LINUX
-#include "util/u_linux.h"
-#endif
+#include "math/m_api.h"
+#include "math/m_mathinclude.h"
+
+#include "util/u_thread_role.h"
 
 #include "multi/comp_multi_private.h"
 #include "multi/comp_multi_interface.h"
@@ -42,6 +43,81 @@
 #endif
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(cull_layers, "XRT_COMPOSITOR_MULTI_CULL_LAYERS", true)
+DEBUG_GET_ONCE_NUM_OPTION(spare_clients, "XRT_COMPOSITOR_MULTI_SPARE_CLIENTS", 1)
+DEBUG_GET_ONCE_BOOL_OPTION(gpu_slices, "XRT_COMPOSITOR_MULTI_GPU_SLICES", true)
+
+/*!
+ * Added to each side of the view frustum when culling quads, the native
+ * compositor predicts its own view poses so they differ slightly from ours.
+ */
+#define CULL_FOV_MARGIN_RAD (10.0 * M_PI / 180.0)
+
+//! Frustum planes are not moved beyond this angle, to keep the tangent sane.
+#define CULL_FOV_MAX_RAD (89.0 * M_PI / 180.0)
+
+//! Each new sample moves the GPU time averages this fraction of the way.
+#define STATS_AVG_DIV (8)
+
+/*!
+ * Each client's GPU slice is its average GPU time plus this fraction of it, so
+ * a frame a bit slower than the average doesn't run in to the next slice.
+ */
+#define GPU_SLICE_SLACK_DIV (4)
+
+
+/*
+ *
+ * Stats accounting.
+ *
+ */
+
+static uint64_t
+stats_smooth(uint64_t avg_ns, uint64_t sample_ns)
+{
+	if (avg_ns == 0) {
+		return sample_ns;
+	}
+
+	int64_t diff_ns = (int64_t)(sample_ns - avg_ns);
+
+	return (uint64_t)((int64_t)avg_ns + diff_ns / STATS_AVG_DIV);
+}
+
+/*!
+ * There are no per layer GPU timestamps, the compute path squashes all layers
+ * in one dispatch, so the predicted GPU time of the native compositor is
+ * shared out by the number of layers each client had composited.
+ */
+static void
+attribute_compositor_gpu_time_locked(struct multi_system_compositor *msc, uint64_t compositor_gpu_ns)
+{
+	uint32_t total_layers = 0;
+	for (size_t k = 0; k < ARRAY_SIZE(msc->clients); k++) {
+		if (msc->clients[k] != NULL) {
+			total_layers += msc->clients[k]->stats.layer_count;
+		}
+	}
+
+	for (size_t k = 0; k < ARRAY_SIZE(msc->clients); k++) {
+		struct multi_compositor *mc = msc->clients[k];
+		if (mc == NULL) {
+			continue;
+		}
+
+		struct xrt_multi_compositor_client_stats *stats = &mc->stats;
+
+		uint64_t share_ns = 0;
+		if (total_layers > 0) {
+			share_ns = compositor_gpu_ns * stats->layer_count / total_layers;
+		}
+
+		stats->compositor_gpu_ns = share_ns;
+		stats->compositor_gpu_avg_ns = stats_smooth(stats->compositor_gpu_avg_ns, share_ns);
+	}
+}
+
+
 /*
  *
  * Render thread.
@@ -82,14 +158,17 @@ do_projection_layer_depth(struct xrt_compositor *xc,
 
 	struct xrt_swapchain *xsc[XRT_MAX_VIEWS];
 	struct xrt_swapchain *d_xsc[XRT_MAX_VIEWS];
+	struct xrt_swapchain *mv_xsc[XRT_MAX_VIEWS];
 	// Cast away
 	struct xrt_layer_data *data = (struct xrt_layer_data *)&layer->data;
+	bool space_warp = (data->flags & XRT_LAYER_COMPOSITION_SPACE_WARP_BIT) != 0;
 
 	for (uint32_t j = 0; j < data->view_count; j++) {
 		xsc[j] = layer->xscs[j];
 		d_xsc[j] = layer->xscs[j + data->view_count];
+		mv_xsc[j] = layer->xscs[j + data->view_count * 2];
 
-		if (xsc[j] == NULL || d_xsc[j] == NULL) {
+		if (xsc[j] == NULL || d_xsc[j] == NULL || (space_warp && mv_xsc[j] == NULL)) {
 			U_LOG_E("Invalid swap chain for projection layer #%u!", i);
 			return;
 		}
@@ -101,7 +180,11 @@ do_projection_layer_depth(struct xrt_compositor *xc,
 	}
 
 
-	xrt_comp_layer_projection_depth(xc, xdev, xsc, d_xsc, data);
+	if (space_warp) {
+		xrt_comp_layer_projection_space_warp(xc, xdev, xsc, d_xsc, mv_xsc, data);
+	} else {
+		xrt_comp_layer_projection_depth(xc, xdev, xsc, d_xsc, data);
+	}
 }
 
 static bool
@@ -207,6 +290,226 @@ do_equirect2_layer(struct xrt_compositor *xc, struct multi_compositor *mc, struc
 	xrt_comp_layer_equirect2(xc, xdev, xcs, data);
 }
 
+
+/*
+ *
+ * Layer culling.
+ *
+ */
+
+/*!
+ * Views used to cull layers, lazily fetched from the device of the first
+ * layer that needs them.
+ */
+struct cull_views
+{
+	struct xrt_device *xdev;
+	uint32_t view_count;
+
+	//! Tangents of the frustum planes, with @ref CULL_FOV_MARGIN_RAD added.
+	struct xrt_fov tans[XRT_MAX_VIEWS];
+
+	//! Inverse of the eye poses relative to the head, for view space layers.
+	struct xrt_pose inv_eye[XRT_MAX_VIEWS];
+
+	//! Inverse of the eye poses in the tracking space.
+	struct xrt_pose inv_world[XRT_MAX_VIEWS];
+
+	//! Was the head pose valid, if not world space layers are never culled.
+	bool world_valid;
+};
+
+static float
+cull_tan(float angle, float sign)
+{
+	double a = fabs((double)angle) + CULL_FOV_MARGIN_RAD;
+	if (a > CULL_FOV_MAX_RAD) {
+		a = CULL_FOV_MAX_RAD;
+	}
+
+	return (float)(tan(a) * sign);
+}
+
+static void
+cull_views_update(struct cull_views *cv, struct xrt_device *xdev, uint64_t display_time_ns)
+{
+	if (cv->xdev == xdev) {
+		return;
+	}
+
+	struct xrt_vec3 default_eye_relation = {
+	    0.063000f, /*! @todo get actual ipd_meters */
+	    0.0f,
+	    0.0f,
+	};
+
+	struct xrt_space_relation head_relation = XRT_SPACE_RELATION_ZERO;
+	struct xrt_fov fovs[XRT_MAX_VIEWS] = XRT_STRUCT_INIT;
+	struct xrt_pose poses[XRT_MAX_VIEWS] = XRT_STRUCT_INIT;
+	uint32_t view_count = (uint32_t)xdev->hmd->view_count;
+
+	xrt_device_get_view_poses( //
+	    xdev,                  // xdev
+	    &default_eye_relation, // default_eye_relation
+	    display_time_ns,       // at_timestamp_ns
+	    view_count,            // view_count
+	    &head_relation,        // out_head_relation
+	    fovs,                  // out_fovs
+	    poses);                // out_poses
+
+	cv->xdev = xdev;
+	cv->view_count = view_count;
+	cv->world_valid = (head_relation.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) != 0;
+
+	for (uint32_t i = 0; i < view_count; i++) {
+		// Use the same fov as the native compositor renders with.
+		const struct xrt_fov *fov = &xdev->hmd->distortion.fov[i];
+		cv->tans[i].angle_left = cull_tan(fov->angle_left, -1.0f);
+		cv->tans[i].angle_right = cull_tan(fov->angle_right, 1.0f);
+		cv->tans[i].angle_up = cull_tan(fov->angle_up, 1.0f);
+		cv->tans[i].angle_down = cull_tan(fov->angle_down, -1.0f);
+
+		struct xrt_pose world;
+		math_pose_transform(&head_relation.pose, &poses[i], &world);
+		math_pose_invert(&poses[i], &cv->inv_eye[i]);
+		math_pose_invert(&world, &cv->inv_world[i]);
+	}
+}
+
+static bool
+is_quad_visible_to_view(const struct xrt_layer_quad_data *quad, uint32_t view_index)
+{
+	bool is_right = view_index % 2 == 1;
+
+	switch (quad->visibility) {
+	case XRT_LAYER_EYE_VISIBILITY_LEFT_BIT: return !is_right;
+	case XRT_LAYER_EYE_VISIBILITY_RIGHT_BIT: return is_right;
+	case XRT_LAYER_EYE_VISIBILITY_BOTH: return true;
+	case XRT_LAYER_EYE_VISIBILITY_NONE:
+	default: return false;
+	}
+}
+
+/*!
+ * Are all of the points outside of one of the frustum planes, the view looks
+ * down negative Z and all planes go through the eye.
+ */
+static bool
+are_points_outside_frustum(const struct xrt_fov *tans, const struct xrt_vec3 *points, uint32_t point_count)
+{
+	uint32_t left = 0, right = 0, up = 0, down = 0;
+
+	for (uint32_t i = 0; i < point_count; i++) {
+		const struct xrt_vec3 *p = &points[i];
+		float d = -p->z;
+
+		left += p->x < tans->angle_left * d ? 1 : 0;
+		right += p->x > tans->angle_right * d ? 1 : 0;
+		up += p->y > tans->angle_up * d ? 1 : 0;
+		down += p->y < tans->angle_down * d ? 1 : 0;
+	}
+
+	return left == point_count || right == point_count || up == point_count || down == point_count;
+}
+
+/*!
+ * Is the quad outside of the frustum of every view it is visible in.
+ */
+static bool
+is_quad_layer_culled(struct cull_views *cv, struct multi_layer_entry *layer, uint64_t display_time_ns)
+{
+	const struct xrt_layer_data *data = &layer->data;
+	const struct xrt_layer_quad_data *quad = &data->quad;
+	struct xrt_device *xdev = layer->xdev;
+
+	if (xdev == NULL || xdev->hmd == NULL) {
+		return false;
+	}
+
+	cull_views_update(cv, xdev, display_time_ns);
+
+	bool view_space = (data->flags & XRT_LAYER_COMPOSITION_VIEW_SPACE_BIT) != 0;
+	if (!view_space && !cv->world_valid) {
+		return false;
+	}
+
+	float hw = quad->size.x * 0.5f;
+	float hh = quad->size.y * 0.5f;
+	const struct xrt_vec3 local[4] = {
+	    {-hw, -hh, 0.0f},
+	    {hw, -hh, 0.0f},
+	    {hw, hh, 0.0f},
+	    {-hw, hh, 0.0f},
+	};
+
+	struct xrt_vec3 corners[4];
+	for (uint32_t i = 0; i < ARRAY_SIZE(local); i++) {
+		math_pose_transform_point(&quad->pose, &local[i], &corners[i]);
+	}
+
+	for (uint32_t view = 0; view < cv->view_count; view++) {
+		if (!is_quad_visible_to_view(quad, view)) {
+			continue;
+		}
+
+		const struct xrt_pose *inv = view_space ? &cv->inv_eye[view] : &cv->inv_world[view];
+
+		struct xrt_vec3 points[4];
+		for (uint32_t i = 0; i < ARRAY_SIZE(corners); i++) {
+			math_pose_transform_point(inv, &corners[i], &points[i]);
+		}
+
+		if (!are_points_outside_frustum(&cv->tans[view], points, ARRAY_SIZE(points))) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*!
+ * Does this layer hide all layers beneath it, it must be a projection layer
+ * without any blending whose fov covers the whole fov of every view.
+ */
+static bool
+is_layer_opaque_and_full_fov(const struct multi_layer_entry *layer)
+{
+	const struct xrt_layer_data *data = &layer->data;
+	const struct xrt_layer_projection_view_data *vds = NULL;
+
+	switch (data->type) {
+	case XRT_LAYER_PROJECTION: vds = data->proj.v; break;
+	case XRT_LAYER_PROJECTION_DEPTH: vds = data->depth.v; break;
+	default: return false;
+	}
+
+	const enum xrt_layer_composition_flags blending = XRT_LAYER_COMPOSITION_BLEND_TEXTURE_SOURCE_ALPHA_BIT |
+	                                                  XRT_LAYER_COMPOSITION_ADVANCED_BLENDING_BIT |
+	                                                  XRT_LAYER_COMPOSITION_DEPTH_TEST;
+	if ((data->flags & blending) != 0) {
+		return false;
+	}
+
+	struct xrt_device *xdev = layer->xdev;
+	if (xdev == NULL || xdev->hmd == NULL || data->view_count < xdev->hmd->view_count) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < xdev->hmd->view_count; i++) {
+		const struct xrt_fov *layer_fov = &vds[i].fov;
+		const struct xrt_fov *view_fov = &xdev->hmd->distortion.fov[i];
+
+		if (layer_fov->angle_left > view_fov->angle_left ||   //
+		    layer_fov->angle_right < view_fov->angle_right || //
+		    layer_fov->angle_up < view_fov->angle_up ||       //
+		    layer_fov->angle_down > view_fov->angle_down) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
 static int
 overlay_sort_func(const void *a, const void *b)
 {
@@ -225,7 +528,10 @@ overlay_sort_func(const void *a, const void *b)
 }
 
 static void
-transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_time_ns, int64_t system_frame_id)
+transfer_layers_locked(struct multi_system_compositor *msc,
+                       uint64_t display_time_ns,
+                       uint64_t compositor_gpu_ns,
+                       int64_t system_frame_id)
 {
 	COMP_TRACE_MARKER();
 
@@ -245,6 +551,12 @@ transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_tim
 			continue;
 		}
 
+		// Counted up again below for the layers that are composited.
+		mc->stats.layer_count = 0;
+
+		// Cheap, only looks at reference counts of the client's swapchains.
+		multi_compositor_release_unused_swapchains_locked(mc);
+
 		// Even if it's not shown, make sure that frames are delivered.
 		multi_compositor_deliver_any_frames(mc, display_time_ns);
 
@@ -272,20 +584,57 @@ transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_tim
 		// The list_and_timing_lock is held when callign this function.
 		multi_compositor_latch_frame_locked(mc, now_ns, system_frame_id);
 
+		// A frame can be shown for many system frames, only count the first.
+		if (msc->latency.enabled && mc->delivered.when_began_ns != 0) {
+			u_latency_probe_add(&msc->latency.probe, mc->delivered.when_began_ns, display_time_ns);
+			mc->delivered.when_began_ns = 0;
+		}
+
 		array[count++] = msc->clients[k];
 	}
 
 	// Sort the stack array
 	qsort(array, count, sizeof(struct multi_compositor *), overlay_sort_func);
 
+	bool cull = debug_get_bool_option_cull_layers();
+
+	/*
+	 * Find the top most layer that hides everything beneath it, all layers
+	 * before it both from the same and lower z-order clients are skipped.
+	 */
+	size_t first_client = 0;
+	uint32_t first_layer = 0;
+	for (size_t k = count; cull && k > 0; k--) {
+		struct multi_compositor *mc = array[k - 1];
+		uint32_t i = mc->delivered.layer_count;
+
+		while (i > 0 && !is_layer_opaque_and_full_fov(&mc->delivered.layers[i - 1])) {
+			i--;
+		}
+
+		if (i > 0) {
+			first_client = k - 1;
+			first_layer = i - 1;
+			break;
+		}
+	}
+
+	struct cull_views cv = {0};
+
 	// Copy all active layers.
-	for (size_t k = 0; k < count; k++) {
+	for (size_t k = first_client; k < count; k++) {
 		struct multi_compositor *mc = array[k];
 		assert(mc != NULL);
 
-		for (uint32_t i = 0; i < mc->delivered.layer_count; i++) {
+		uint32_t start = k == first_client ? first_layer : 0;
+		for (uint32_t i = start; i < mc->delivered.layer_count; i++) {
 			struct multi_layer_entry *layer = &mc->delivered.layers[i];
 
+			bool is_quad = layer->data.type == XRT_LAYER_QUAD;
+			if (cull && is_quad && is_quad_layer_culled(&cv, layer, display_time_ns)) {
+				continue;
+			}
+
 			switch (layer->data.type) {
 			case XRT_LAYER_PROJECTION: do_projection_layer(xc, mc, layer, i); break;
 			case XRT_LAYER_PROJECTION_DEPTH: do_projection_layer_depth(xc, mc, layer, i); break;
@@ -294,9 +643,93 @@ transfer_layers_locked(struct multi_system_compositor *msc, uint64_t display_tim
 			case XRT_LAYER_CYLINDER: do_cylinder_layer(xc, mc, layer, i); break;
 			case XRT_LAYER_EQUIRECT1: do_equirect1_layer(xc, mc, layer, i); break;
 			case XRT_LAYER_EQUIRECT2: do_equirect2_layer(xc, mc, layer, i); break;
-			default: U_LOG_E("Unhandled layer type '%i'!", layer->data.type); break;
+			default: U_LOG_E("Unhandled layer type '%i'!", layer->data.type); continue;
 			}
+
+			mc->stats.layer_count++;
+		}
+	}
+
+	attribute_compositor_gpu_time_locked(msc, compositor_gpu_ns);
+}
+
+static int
+gpu_slice_sort_func(const void *a, const void *b)
+{
+	struct multi_compositor *mc_a = *(struct multi_compositor **)a;
+	struct multi_compositor *mc_b = *(struct multi_compositor **)b;
+
+	if (mc_a->state.focused != mc_b->state.focused) {
+		return mc_a->state.focused ? -1 : 1;
+	}
+
+	return overlay_sort_func(a, b);
+}
+
+/*!
+ * Without this every app pacer puts the GPU work of its app right before the
+ * compositor needs it, so all apps wake up at once and fight over the GPU. This
+ * hands out back to back slices of the display period instead, each as long
+ * as the app's average GPU time, the focused app first and then the rest in
+ * z-order. Under contention it is the overlays that miss, not the focused app.
+ * Apps that don't fit in the period, and hidden ones, are not moved.
+ */
+static void
+assign_gpu_slices_locked(struct multi_system_compositor *msc, uint64_t predicted_display_period_ns)
+{
+	struct multi_compositor *array[MULTI_MAX_CLIENTS] = {0};
+	uint64_t slices_ns[MULTI_MAX_CLIENTS] = {0};
+	size_t count = 0;
+
+	for (size_t k = 0; k < ARRAY_SIZE(msc->clients); k++) {
+		struct multi_compositor *mc = msc->clients[k];
+		if (mc == NULL) {
+			continue;
+		}
+
+		// Not moved unless it gets a slice below.
+		u_pa_set_gpu_slice(mc->upa, 0);
+
+		if (!mc->state.visible || !mc->state.session_active) {
+			continue;
+		}
+
+		array[count++] = mc;
+	}
+
+	// Nothing to stagger.
+	if (count < 2 || !debug_get_bool_option_gpu_slices()) {
+		return;
+	}
+
+	qsort(array, count, sizeof(struct multi_compositor *), gpu_slice_sort_func);
+
+	// What is left of the period when the compositor has done its own work.
+	uint64_t compositor_ns = msc->stats.compositor_gpu_avg_ns;
+	uint64_t budget_ns = 0;
+	if (predicted_display_period_ns > compositor_ns) {
+		budget_ns = predicted_display_period_ns - compositor_ns;
+	}
+
+	// In priority order, until one doesn't fit.
+	uint64_t total_ns = 0;
+	size_t fitted = 0;
+	for (; fitted < count; fitted++) {
+		uint64_t gpu_ns = array[fitted]->stats.client_gpu_avg_ns;
+		uint64_t slice_ns = gpu_ns + gpu_ns / GPU_SLICE_SLACK_DIV;
+		if (total_ns + slice_ns > budget_ns) {
+			break;
 		}
+
+		slices_ns[fitted] = slice_ns;
+		total_ns += slice_ns;
+	}
+
+	// Each app's GPU work is to be done before the slices that come after it.
+	uint64_t offset_ns = total_ns;
+	for (size_t i = 0; i < fitted; i++) {
+		offset_ns -= slices_ns[i];
+		u_pa_set_gpu_slice(array[i]->upa, offset_ns);
 	}
 }
 
@@ -331,6 +764,8 @@ broadcast_timings_to_pacers(struct multi_system_compositor *msc,
 
 	os_mutex_lock(&msc->list_and_timing_lock);
 
+	assign_gpu_slices_locked(msc, predicted_display_period_ns);
+
 	for (size_t i = 0; i < ARRAY_SIZE(msc->clients); i++) {
 		struct multi_compositor *mc = msc->clients[i];
 		if (mc == NULL) {
@@ -355,6 +790,37 @@ broadcast_timings_to_pacers(struct multi_system_compositor *msc,
 	os_mutex_unlock(&msc->list_and_timing_lock);
 }
 
+static void
+record_frame_stats(struct multi_system_compositor *msc,
+                   uint64_t now_ns,
+                   uint64_t wake_up_time_ns,
+                   uint64_t predicted_gpu_time_ns,
+                   uint64_t predicted_display_period_ns)
+{
+	uint64_t period_ns = msc->last_frame_start_ns != 0 ? now_ns - msc->last_frame_start_ns : 0;
+	msc->last_frame_start_ns = now_ns;
+
+	os_mutex_lock(&msc->list_and_timing_lock);
+
+	struct xrt_multi_compositor_stats *stats = &msc->stats;
+
+	stats->frame_count++;
+	stats->display_period_ns = predicted_display_period_ns;
+	stats->compositor_gpu_ns = predicted_gpu_time_ns;
+	stats->compositor_gpu_avg_ns = stats_smooth(stats->compositor_gpu_avg_ns, predicted_gpu_time_ns);
+
+	if (period_ns > 0) {
+		stats->frame_period_ns = period_ns;
+		stats->frame_period_avg_ns = stats_smooth(stats->frame_period_avg_ns, period_ns);
+	}
+
+	if (now_ns > wake_up_time_ns && now_ns - wake_up_time_ns > predicted_display_period_ns / 2) {
+		stats->late_count++;
+	}
+
+	os_mutex_unlock(&msc->list_and_timing_lock);
+}
+
 static void
 wait_frame(struct os_precise_sleeper *sleeper, struct xrt_compositor *xc, int64_t frame_id, uint64_t wake_up_time_ns)
 {
@@ -438,16 +904,14 @@ multi_main_loop(struct multi_system_compositor *msc)
 	U_TRACE_SET_THREAD_NAME("Multi Client Module");
 	os_thread_helper_name(&msc->oth, "Multi Client Module");
 
-#ifdef XRT_OS_LINUX
 	// Try to raise priority of this thread.
-	u_linux_try_to_set_realtime_priority_on_thread(U_LOGGING_INFO, "Multi Client Module");
-#endif
+	u_thread_role_apply_to_current_thread(U_THREAD_ROLE_COMPOSITOR, "Multi Client Module");
 
 	struct xrt_compositor *xc = &msc->xcn->base;
 
 	// For wait frame.
 	struct os_precise_sleeper sleeper = {0};
-	os_precise_sleeper_init(&sleeper);
+	u_wait_sleeper_init(&sleeper);
 
 	// Protect the thread state and the sessions state.
 	os_thread_helper_lock(&msc->oth);
@@ -458,6 +922,9 @@ multi_main_loop(struct multi_system_compositor *msc)
 		update_session_state_locked(msc);
 
 		if (msc->sessions.state == MULTI_SYSTEM_STATE_STOPPED) {
+			// Don't count the time stopped as a frame period.
+			msc->last_frame_start_ns = 0;
+
 			// Sleep and wait to be signaled.
 			os_thread_helper_wait_locked(&msc->oth);
 
@@ -492,6 +959,8 @@ multi_main_loop(struct multi_system_compositor *msc)
 		uint64_t now_ns = os_monotonic_get_ns();
 		uint64_t diff_ns = predicted_display_time_ns - now_ns;
 
+		record_frame_stats(msc, now_ns, wake_up_time_ns, predicted_gpu_time_ns, predicted_display_period_ns);
+
 		// Now we know the diff, broadcast to pacers.
 		broadcast_timings_to_pacers(msc, predicted_display_time_ns, predicted_display_period_ns, diff_ns);
 
@@ -513,7 +982,7 @@ multi_main_loop(struct multi_system_compositor *msc)
 
 		// Make sure that the clients doesn't go away while we transfer layers.
 		os_mutex_lock(&msc->list_and_timing_lock);
-		transfer_layers_locked(msc, predicted_display_time_ns, frame_id);
+		transfer_layers_locked(msc, predicted_display_time_ns, predicted_gpu_time_ns, frame_id);
 		os_mutex_unlock(&msc->list_and_timing_lock);
 
 		xrt_comp_layer_commit(xc, XRT_GRAPHICS_SYNC_HANDLE_INVALID);
@@ -547,6 +1016,44 @@ thread_func(void *ptr)
 }
 
 
+/*
+ *
+ * Spares thread.
+ *
+ */
+
+static void *
+spares_thread_func(void *ptr)
+{
+	struct multi_system_compositor *msc = (struct multi_system_compositor *)ptr;
+
+	U_TRACE_SET_THREAD_NAME("Multi Client Module: Spares");
+	os_thread_helper_name(&msc->spares.oth, "Multi Client Module: Spares");
+
+	os_thread_helper_lock(&msc->spares.oth);
+
+	while (os_thread_helper_is_running_locked(&msc->spares.oth)) {
+		if (msc->spares.count >= msc->spares.target) {
+			// Woken up when one is taken or when stopping.
+			os_thread_helper_wait_locked(&msc->spares.oth);
+			continue;
+		}
+
+		// Starts the wait thread, so not done under the lock.
+		os_thread_helper_unlock(&msc->spares.oth);
+		struct multi_compositor *mc = multi_compositor_create_spare(msc);
+		os_thread_helper_lock(&msc->spares.oth);
+
+		// Only this thread adds, so there is always room.
+		msc->spares.array[msc->spares.count++] = mc;
+	}
+
+	os_thread_helper_unlock(&msc->spares.oth);
+
+	return NULL;
+}
+
+
 /*
  *
  * System multi compositor functions.
@@ -650,6 +1157,33 @@ system_compositor_notify_display_refresh_changed(struct xrt_system_compositor *x
 	return multi_compositor_push_event(mc, &xse);
 }
 
+static xrt_result_t
+system_compositor_get_client_stats(struct xrt_system_compositor *xsc,
+                                   struct xrt_compositor *xc,
+                                   struct xrt_multi_compositor_client_stats *out_stats)
+{
+	struct multi_system_compositor *msc = multi_system_compositor(xsc);
+	struct multi_compositor *mc = multi_compositor(xc);
+
+	os_mutex_lock(&msc->list_and_timing_lock);
+	*out_stats = mc->stats;
+	os_mutex_unlock(&msc->list_and_timing_lock);
+
+	return XRT_SUCCESS;
+}
+
+static xrt_result_t
+system_compositor_get_stats(struct xrt_system_compositor *xsc, struct xrt_multi_compositor_stats *out_stats)
+{
+	struct multi_system_compositor *msc = multi_system_compositor(xsc);
+
+	os_mutex_lock(&msc->list_and_timing_lock);
+	*out_stats = msc->stats;
+	os_mutex_unlock(&msc->list_and_timing_lock);
+
+	return XRT_SUCCESS;
+}
+
 
 /*
  *
@@ -673,9 +1207,20 @@ system_compositor_destroy(struct xrt_system_compositor *xsc)
 {
 	struct multi_system_compositor *msc = multi_system_compositor(xsc);
 
+	// Stop making spares, then get rid of the ones nobody claimed.
+	os_thread_helper_destroy(&msc->spares.oth);
+	for (uint32_t i = 0; i < msc->spares.count; i++) {
+		struct xrt_compositor *xc = &msc->spares.array[i]->base.base;
+		xrt_comp_destroy(&xc);
+	}
+	msc->spares.count = 0;
+
 	// Destroy the render thread first, destroy also stops the thread.
 	os_thread_helper_destroy(&msc->oth);
 
+	// Safe to call when not enabled.
+	u_latency_probe_fini(&msc->latency.probe);
+
 	u_paf_destroy(&msc->upaf);
 
 	xrt_comp_native_destroy(&msc->xcn);
@@ -711,6 +1256,59 @@ multi_system_compositor_update_session_status(struct multi_system_compositor *ms
 	os_thread_helper_unlock(&msc->oth);
 }
 
+bool
+multi_system_compositor_add_client_gpu_time_locked(struct multi_system_compositor *msc,
+                                                   struct multi_compositor *mc,
+                                                   uint64_t gpu_ns)
+{
+	struct xrt_multi_compositor_client_stats *stats = &mc->stats;
+
+	stats->client_gpu_ns = gpu_ns;
+	stats->client_gpu_avg_ns = stats_smooth(stats->client_gpu_avg_ns, gpu_ns);
+	stats->frame_count++;
+
+	// The client and the compositing of its layers share one display period.
+	uint64_t period_ns = msc->last_timings.predicted_display_period_ns;
+	uint64_t total_gpu_ns = gpu_ns + stats->compositor_gpu_ns;
+	bool over_budget = period_ns > 0 && total_gpu_ns > period_ns;
+	if (over_budget) {
+		stats->over_budget_count++;
+	}
+
+	return u_pr_update(&mc->upr, total_gpu_ns, period_ns, over_budget);
+}
+
+void
+multi_system_compositor_add_client_cpu_time_locked(struct multi_system_compositor *msc,
+                                                   struct multi_compositor *mc,
+                                                   uint64_t cpu_ns)
+{
+	(void)msc;
+
+	mc->stats.app_cpu_ns = cpu_ns;
+	mc->stats.app_cpu_avg_ns = stats_smooth(mc->stats.app_cpu_avg_ns, cpu_ns);
+}
+
+struct multi_compositor *
+multi_system_compositor_take_spare(struct multi_system_compositor *msc)
+{
+	struct multi_compositor *mc = NULL;
+
+	os_thread_helper_lock(&msc->spares.oth);
+
+	if (msc->spares.count > 0) {
+		mc = msc->spares.array[--msc->spares.count];
+		msc->spares.array[msc->spares.count] = NULL;
+
+		// Have the thread make a new one for the next session.
+		os_thread_helper_signal_locked(&msc->spares.oth);
+	}
+
+	os_thread_helper_unlock(&msc->spares.oth);
+
+	return mc;
+}
+
 xrt_result_t
 comp_multi_create_system_compositor(struct xrt_compositor_native *xcn,
                                     struct u_pacing_app_factory *upaf,
@@ -727,6 +1325,8 @@ comp_multi_create_system_compositor(struct xrt_compositor_native *xcn,
 	msc->xmcc.notify_loss_pending = system_compositor_notify_loss_pending;
 	msc->xmcc.notify_lost = system_compositor_notify_lost;
 	msc->xmcc.notify_display_refresh_changed = system_compositor_notify_display_refresh_changed;
+	msc->xmcc.get_client_stats = system_compositor_get_client_stats;
+	msc->xmcc.get_stats = system_compositor_get_stats;
 	msc->base.xmcc = &msc->xmcc;
 	msc->base.info = *xsci;
 	msc->upaf = upaf;
@@ -736,6 +1336,11 @@ comp_multi_create_system_compositor(struct xrt_compositor_native *xcn,
 
 	os_mutex_init(&msc->list_and_timing_lock);
 
+	msc->latency.enabled = u_latency_probe_enabled();
+	if (msc->latency.enabled) {
+		u_latency_probe_init(&msc->latency.probe, "app pose to photon");
+	}
+
 	//! @todo Make the clients not go from IDLE to READY before we have completed a first frame.
 	// Make sure there is at least some sort of valid frame data here.
 	msc->last_timings.predicted_display_time_ns = os_monotonic_get_ns();   // As good as any time.
@@ -747,8 +1352,26 @@ comp_multi_create_system_compositor(struct xrt_compositor_native *xcn,
 		return XRT_ERROR_THREADING_INIT_FAILURE;
 	}
 
+	ret = os_thread_helper_init(&msc->spares.oth);
+	if (ret < 0) {
+		return XRT_ERROR_THREADING_INIT_FAILURE;
+	}
+
+	int64_t spare_clients = debug_get_num_option_spare_clients();
+	if (spare_clients < 0) {
+		spare_clients = 0;
+	} else if (spare_clients > MULTI_MAX_SPARE_CLIENTS) {
+		spare_clients = MULTI_MAX_SPARE_CLIENTS;
+	}
+	msc->spares.target = (uint32_t)spare_clients;
+
 	os_thread_helper_start(&msc->oth, thread_func, msc);
 
+	// Created in the background, the first session might not get one.
+	if (msc->spares.target > 0) {
+		os_thread_helper_start(&msc->spares.oth, spares_thread_func, msc);
+	}
+
 	*out_xsysc = &msc->base;
 
 	return XRT_SUCCESS;
@@ -53,6 +53,7 @@ calc_dispatch_dims_1_view(const struct render_viewport_data views, uint32_t *out
 static void
 calc_dispatch_dims_views(const struct render_viewport_data views[XRT_MAX_VIEWS],
                          uint32_t view_count,
+                         uint32_t pixels_per_group,
                          uint32_t *out_w,
                          uint32_t *out_h)
 {
@@ -66,13 +67,31 @@ calc_dispatch_dims_views(const struct render_viewport_data views[XRT_MAX_VIEWS],
 #undef IMAX
 
 	// Power of two divide and round up.
-	w = uint_divide_and_round_up(w, 8);
-	h = uint_divide_and_round_up(h, 8);
+	w = uint_divide_and_round_up(w, pixels_per_group);
+	h = uint_divide_and_round_up(h, pixels_per_group);
 
 	*out_w = w;
 	*out_h = h;
 }
 
+/*
+ * A work group is 8x8 invocations, with foveation each invocation writes a
+ * 2x2 block of pixels so the group covers 16x16 pixels.
+ */
+static uint32_t
+get_distortion_pixels_per_group(const struct render_resources *r)
+{
+	return r->compute.distortion.foveation.enabled ? 16 : 8;
+}
+
+static void
+fill_foveation_ubo_data(const struct render_resources *r, struct render_compute_distortion_ubo_data *data)
+{
+	data->foveation_radii[0] = r->compute.distortion.foveation.inner_radius;
+	data->foveation_radii[1] = r->compute.distortion.foveation.outer_radius;
+	data->foveation_enabled = r->compute.distortion.foveation.enabled ? 1 : 0;
+}
+
 
 /*
  *
@@ -87,7 +106,7 @@ update_compute_layer_descriptor_set(struct vk_bundle *vk,
                                     VkImageView src_image_views[RENDER_MAX_IMAGES_SIZE],
                                     uint32_t image_count,
                                     uint32_t target_binding,
-                                    VkImageView target_image_view,
+                                    VkImageView target_image_views[XRT_MAX_VIEWS],
                                     uint32_t ubo_binding,
                                     VkBuffer ubo_buffer,
                                     VkDeviceSize ubo_size,
@@ -100,10 +119,12 @@ update_compute_layer_descriptor_set(struct vk_bundle *vk,
 		src_image_info[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 	}
 
-	VkDescriptorImageInfo target_image_info = {
-	    .imageView = target_image_view,
-	    .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
-	};
+	VkDescriptorImageInfo target_image_infos[XRT_MAX_VIEWS];
+	for (uint32_t i = 0; i < XRT_MAX_VIEWS; i++) {
+		target_image_infos[i].sampler = VK_NULL_HANDLE;
+		target_image_infos[i].imageView = target_image_views[i];
+		target_image_infos[i].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	}
 
 	VkDescriptorBufferInfo buffer_info = {
 	    .buffer = ubo_buffer,
@@ -124,9 +145,9 @@ update_compute_layer_descriptor_set(struct vk_bundle *vk,
 	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
 	        .dstSet = descriptor_set,
 	        .dstBinding = target_binding,
-	        .descriptorCount = 1,
+	        .descriptorCount = XRT_MAX_VIEWS,
 	        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-	        .pImageInfo = &target_image_info,
+	        .pImageInfo = target_image_infos,
 	    },
 	    {
 	        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -278,15 +299,13 @@ update_compute_descriptor_set_target(struct vk_bundle *vk,
 	    NULL);                             // pDescriptorCopies
 }
 
-
-/*
- *
- * 'Exported' functions.
- *
- */
-
-bool
-render_compute_init(struct render_compute *crc, struct render_resources *r)
+static bool
+init_with(struct render_compute *crc,
+          struct render_resources *r,
+          VkCommandPool cmd_pool,
+          VkCommandBuffer cmd,
+          VkDescriptorPool descriptor_pool,
+          bool timestamps)
 {
 	VkResult ret;
 
@@ -294,11 +313,15 @@ render_compute_init(struct render_compute *crc, struct render_resources *r)
 
 	struct vk_bundle *vk = r->vk;
 	crc->r = r;
+	crc->cmd = cmd;
+	crc->cmd_pool = cmd_pool;
+	crc->descriptor_pool = descriptor_pool;
+	crc->timestamps = timestamps;
 
 	for (uint32_t i = 0; i < RENDER_MAX_LAYER_RUNS_COUNT; i++) {
 		ret = vk_create_descriptor_set(             //
 		    vk,                                     // vk_bundle
-		    r->compute.descriptor_pool,             // descriptor_pool
+		    crc->descriptor_pool,                   // descriptor_pool
 		    r->compute.layer.descriptor_set_layout, // descriptor_set_layout
 		    &crc->layer_descriptor_sets[i]);        // descriptor_set
 		VK_CHK_WITH_RET(ret, "vk_create_descriptor_set", false);
@@ -308,7 +331,7 @@ render_compute_init(struct render_compute *crc, struct render_resources *r)
 
 	ret = vk_create_descriptor_set(                  //
 	    vk,                                          // vk_bundle
-	    r->compute.descriptor_pool,                  // descriptor_pool
+	    crc->descriptor_pool,                        // descriptor_pool
 	    r->compute.distortion.descriptor_set_layout, // descriptor_set_layout
 	    &crc->shared_descriptor_set);                // descriptor_set
 	VK_CHK_WITH_RET(ret, "vk_create_descriptor_set", false);
@@ -318,33 +341,66 @@ render_compute_init(struct render_compute *crc, struct render_resources *r)
 	return true;
 }
 
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+bool
+render_compute_init(struct render_compute *crc, struct render_resources *r)
+{
+	return init_with(               //
+	    crc,                        // crc
+	    r,                          // r
+	    r->cmd_pool,                // cmd_pool
+	    r->cmd,                     // cmd
+	    r->compute.descriptor_pool, // descriptor_pool
+	    true);                      // timestamps
+}
+
+bool
+render_compute_init_async(struct render_compute *crc, struct render_resources *r)
+{
+	return init_with(             //
+	    crc,                      // crc
+	    r,                        // r
+	    r->async.cmd_pool,        // cmd_pool
+	    r->async.cmd,             // cmd
+	    r->async.descriptor_pool, // descriptor_pool
+	    false);                   // timestamps
+}
+
 bool
 render_compute_begin(struct render_compute *crc)
 {
 	VkResult ret;
 	struct vk_bundle *vk = vk_from_crc(crc);
 
-	ret = vk->vkResetCommandPool(vk->device, crc->r->cmd_pool, 0);
+	ret = vk->vkResetCommandPool(vk->device, crc->cmd_pool, 0);
 	VK_CHK_WITH_RET(ret, "vkResetCommandPool", false);
 
+	crc->late_latch.valid = false;
+
 	VkCommandBufferBeginInfo begin_info = {
 	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
 	    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
 	};
 
 	ret = vk->vkBeginCommandBuffer( //
-	    crc->r->cmd,                // commandBuffer
+	    crc->cmd,                   // commandBuffer
 	    &begin_info);               // pBeginInfo
 	VK_CHK_WITH_RET(ret, "vkBeginCommandBuffer", false);
 
-	vk->vkCmdResetQueryPool( //
-	    crc->r->cmd,         // commandBuffer
-	    crc->r->query_pool,  // queryPool
-	    0,                   // firstQuery
-	    2);                  // queryCount
+	if (!crc->timestamps) {
+		return true;
+	}
+
+	render_resources_cmd_reset_timestamps(crc->r, crc->cmd);
 
 	vk->vkCmdWriteTimestamp(               //
-	    crc->r->cmd,                       // commandBuffer
+	    crc->cmd,                          // commandBuffer
 	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // pipelineStage
 	    crc->r->query_pool,                // queryPool
 	    0);                                // query
@@ -358,18 +414,33 @@ render_compute_end(struct render_compute *crc)
 	struct vk_bundle *vk = vk_from_crc(crc);
 	VkResult ret;
 
-	vk->vkCmdWriteTimestamp(                  //
-	    crc->r->cmd,                          // commandBuffer
-	    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, // pipelineStage
-	    crc->r->query_pool,                   // queryPool
-	    1);                                   // query
+	if (crc->timestamps) {
+		vk->vkCmdWriteTimestamp(                  //
+		    crc->cmd,                             // commandBuffer
+		    VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, // pipelineStage
+		    crc->r->query_pool,                   // queryPool
+		    1);                                   // query
+	}
 
-	ret = vk->vkEndCommandBuffer(crc->r->cmd);
+	ret = vk->vkEndCommandBuffer(crc->cmd);
 	VK_CHK_WITH_RET(ret, "vkEndCommandBuffer", false);
 
 	return true;
 }
 
+void
+render_compute_write_timestamp(struct render_compute *crc,
+                               enum render_timestamp_phase phase,
+                               uint32_t view_index,
+                               bool end)
+{
+	if (!crc->timestamps) {
+		return;
+	}
+
+	render_resources_cmd_write_phase_timestamp(crc->r, crc->cmd, phase, view_index, end);
+}
+
 void
 render_compute_close(struct render_compute *crc)
 {
@@ -383,9 +454,12 @@ render_compute_close(struct render_compute *crc)
 		crc->layer_descriptor_sets[i] = VK_NULL_HANDLE;
 	}
 
-	vk->vkResetDescriptorPool(vk->device, crc->r->compute.descriptor_pool, 0);
+	vk->vkResetDescriptorPool(vk->device, crc->descriptor_pool, 0);
 
 	crc->r = NULL;
+	crc->cmd = VK_NULL_HANDLE;
+	crc->cmd_pool = VK_NULL_HANDLE;
+	crc->descriptor_pool = VK_NULL_HANDLE;
 }
 
 void
@@ -397,7 +471,8 @@ render_compute_layers(struct render_compute *crc,
                       uint32_t num_srcs,
                       VkImageView target_image_view,
                       const struct render_viewport_data *view,
-                      bool do_timewarp)
+                      bool do_timewarp,
+                      enum render_layer_blend_mode blend_mode)
 {
 	assert(crc->r != NULL);
 
@@ -409,6 +484,12 @@ render_compute_layers(struct render_compute *crc,
 	 * Source, target and distortion images.
 	 */
 
+	// Only the first target is used, but all of them needs to be valid.
+	VkImageView target_image_views[XRT_MAX_VIEWS];
+	for (uint32_t i = 0; i < XRT_MAX_VIEWS; i++) {
+		target_image_views[i] = target_image_view;
+	}
+
 	update_compute_layer_descriptor_set( //
 	    vk,                              //
 	    r->compute.src_binding,          //
@@ -416,20 +497,20 @@ render_compute_layers(struct render_compute *crc,
 	    src_image_views,                 //
 	    num_srcs,                        //
 	    r->compute.target_binding,       //
-	    target_image_view,               //
+	    target_image_views,              //
 	    r->compute.ubo_binding,          //
 	    ubo,                             //
 	    VK_WHOLE_SIZE,                   //
 	    descriptor_set);                 //
 
-	VkPipeline pipeline = do_timewarp ? r->compute.layer.timewarp_pipeline : r->compute.layer.non_timewarp_pipeline;
+	VkPipeline pipeline = render_resources_get_compute_layer_pipeline(r, false, do_timewarp, blend_mode);
 	vk->vkCmdBindPipeline(              //
-	    crc->r->cmd,                    // commandBuffer
+	    crc->cmd,                       // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
 	    pipeline);                      // pipeline
 
 	vk->vkCmdBindDescriptorSets(          //
-	    r->cmd,                           // commandBuffer
+	    crc->cmd,                         // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,   // pipelineBindPoint
 	    r->compute.layer.pipeline_layout, // layout
 	    0,                                // firstSet
@@ -444,12 +525,84 @@ render_compute_layers(struct render_compute *crc,
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
-	    r->cmd,        // commandBuffer
+	    crc->cmd,      // commandBuffer
 	    w,             // groupCountX
 	    h,             // groupCountY
 	    1);            // groupCountZ
 }
 
+void
+render_compute_layers_all_views(struct render_compute *crc,
+                                VkDescriptorSet descriptor_set,
+                                VkBuffer ubo,
+                                VkSampler src_samplers[RENDER_MAX_IMAGES_SIZE],
+                                VkImageView src_image_views[RENDER_MAX_IMAGES_SIZE],
+                                uint32_t num_srcs,
+                                VkImageView target_image_views[XRT_MAX_VIEWS],
+                                const struct render_viewport_data views[XRT_MAX_VIEWS],
+                                uint32_t view_count,
+                                bool do_timewarp,
+                                enum render_layer_blend_mode blend_mode)
+{
+	assert(crc->r != NULL);
+	assert(view_count > 0 && view_count <= XRT_MAX_VIEWS);
+
+	struct vk_bundle *vk = vk_from_crc(crc);
+	struct render_resources *r = crc->r;
+
+
+	/*
+	 * Source, target and distortion images.
+	 */
+
+	// Fill out unused targets so that all of them are valid.
+	VkImageView all_target_image_views[XRT_MAX_VIEWS];
+	for (uint32_t i = 0; i < XRT_MAX_VIEWS; i++) {
+		all_target_image_views[i] = target_image_views[i < view_count ? i : 0];
+	}
+
+	update_compute_layer_descriptor_set( //
+	    vk,                              //
+	    r->compute.src_binding,          //
+	    src_samplers,                    //
+	    src_image_views,                 //
+	    num_srcs,                        //
+	    r->compute.target_binding,       //
+	    all_target_image_views,          //
+	    r->compute.ubo_binding,          //
+	    ubo,                             //
+	    VK_WHOLE_SIZE,                   //
+	    descriptor_set);                 //
+
+	VkPipeline pipeline = render_resources_get_compute_layer_pipeline(r, true, do_timewarp, blend_mode);
+	vk->vkCmdBindPipeline(              //
+	    crc->cmd,                       // commandBuffer
+	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
+	    pipeline);                      // pipeline
+
+	vk->vkCmdBindDescriptorSets(          //
+	    crc->cmd,                         // commandBuffer
+	    VK_PIPELINE_BIND_POINT_COMPUTE,   // pipelineBindPoint
+	    r->compute.layer.pipeline_layout, // layout
+	    0,                                // firstSet
+	    1,                                // descriptorSetCount
+	    &descriptor_set,                  // pDescriptorSets
+	    0,                                // dynamicOffsetCount
+	    NULL);                            // pDynamicOffsets
+
+
+	// The shader picks the view from the z workgroup id.
+	uint32_t w = 0, h = 0;
+	calc_dispatch_dims_views(views, view_count, 8, &w, &h);
+	assert(w != 0 && h != 0);
+
+	vk->vkCmdDispatch( //
+	    crc->cmd,      // commandBuffer
+	    w,             // groupCountX
+	    h,             // groupCountY
+	    view_count);   // groupCountZ
+}
+
 void
 render_compute_projection_timewarp(struct render_compute *crc,
                                    VkSampler src_samplers[XRT_MAX_VIEWS],
@@ -489,6 +642,14 @@ render_compute_projection_timewarp(struct render_compute *crc,
 		data->transforms[i] = time_warp_matrix[i];
 		data->post_transforms[i] = src_norm_rects[i];
 	}
+	fill_foveation_ubo_data(r, data);
+
+	// Saved so the matrices can be updated just before submit.
+	crc->late_latch.valid = true;
+	for (uint32_t i = 0; i < crc->r->view_count; ++i) {
+		crc->late_latch.src_poses[i] = src_poses[i];
+		crc->late_latch.src_fovs[i] = src_fovs[i];
+	}
 
 	/*
 	 * Source, target and distortion images.
@@ -504,7 +665,7 @@ render_compute_projection_timewarp(struct render_compute *crc,
 
 	vk_cmd_image_barrier_gpu_locked( //
 	    vk,                          //
-	    r->cmd,                      //
+	    crc->cmd,                    //
 	    target_image,                //
 	    0,                           //
 	    VK_ACCESS_SHADER_WRITE_BIT,  //
@@ -537,12 +698,12 @@ render_compute_projection_timewarp(struct render_compute *crc,
 	    crc->r->view_count);              //
 
 	vk->vkCmdBindPipeline(                        //
-	    r->cmd,                                   // commandBuffer
+	    crc->cmd,                                 // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,           // pipelineBindPoint
 	    r->compute.distortion.timewarp_pipeline); // pipeline
 
 	vk->vkCmdBindDescriptorSets(               //
-	    r->cmd,                                // commandBuffer
+	    crc->cmd,                              // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,        // pipelineBindPoint
 	    r->compute.distortion.pipeline_layout, // layout
 	    0,                                     // firstSet
@@ -553,11 +714,11 @@ render_compute_projection_timewarp(struct render_compute *crc,
 
 
 	uint32_t w = 0, h = 0;
-	calc_dispatch_dims_views(views, crc->r->view_count, &w, &h);
+	calc_dispatch_dims_views(views, crc->r->view_count, get_distortion_pixels_per_group(r), &w, &h);
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
-	    r->cmd,        // commandBuffer
+	    crc->cmd,      // commandBuffer
 	    w,             // groupCountX
 	    h,             // groupCountY
 	    2);            // groupCountZ
@@ -575,7 +736,7 @@ render_compute_projection_timewarp(struct render_compute *crc,
 	};
 
 	vk->vkCmdPipelineBarrier(                 //
-	    r->cmd,                               //
+	    crc->cmd,                             //
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
 	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
 	    0,                                    //
@@ -587,6 +748,32 @@ render_compute_projection_timewarp(struct render_compute *crc,
 	    &memoryBarrier);                      //
 }
 
+void
+render_compute_late_latch_timewarp(struct render_compute *crc, const struct xrt_pose new_poses[XRT_MAX_VIEWS])
+{
+	assert(crc->r != NULL);
+
+	struct render_resources *r = crc->r;
+
+	if (!crc->late_latch.valid) {
+		return;
+	}
+
+	/*
+	 * Host coherent memory, the submit makes the writes available to the
+	 * GPU so there is no need for any flush or barrier here.
+	 */
+	struct render_compute_distortion_ubo_data *data =
+	    (struct render_compute_distortion_ubo_data *)r->compute.distortion.ubo.mapped;
+	for (uint32_t i = 0; i < r->view_count; ++i) {
+		render_calc_time_warp_matrix(      //
+		    &crc->late_latch.src_poses[i], //
+		    &crc->late_latch.src_fovs[i],  //
+		    &new_poses[i],                 //
+		    &data->transforms[i]);         //
+	}
+}
+
 void
 render_compute_projection(struct render_compute *crc,
                           VkSampler src_samplers[XRT_MAX_VIEWS],
@@ -612,6 +799,7 @@ render_compute_projection(struct render_compute *crc,
 		data->views[i] = views[i];
 		data->post_transforms[i] = src_norm_rects[i];
 	}
+	fill_foveation_ubo_data(r, data);
 
 
 	/*
@@ -628,7 +816,7 @@ render_compute_projection(struct render_compute *crc,
 
 	vk_cmd_image_barrier_gpu_locked( //
 	    vk,                          //
-	    r->cmd,                      //
+	    crc->cmd,                    //
 	    target_image,                //
 	    0,                           //
 	    VK_ACCESS_SHADER_WRITE_BIT,  //
@@ -661,12 +849,12 @@ render_compute_projection(struct render_compute *crc,
 	    crc->r->view_count);              //
 
 	vk->vkCmdBindPipeline(               //
-	    r->cmd,                          // commandBuffer
+	    crc->cmd,                        // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,  // pipelineBindPoint
 	    r->compute.distortion.pipeline); // pipeline
 
 	vk->vkCmdBindDescriptorSets(               //
-	    r->cmd,                                // commandBuffer
+	    crc->cmd,                              // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,        // pipelineBindPoint
 	    r->compute.distortion.pipeline_layout, // layout
 	    0,                                     // firstSet
@@ -677,11 +865,11 @@ render_compute_projection(struct render_compute *crc,
 
 
 	uint32_t w = 0, h = 0;
-	calc_dispatch_dims_views(views, crc->r->view_count, &w, &h);
+	calc_dispatch_dims_views(views, crc->r->view_count, get_distortion_pixels_per_group(r), &w, &h);
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
-	    r->cmd,        // commandBuffer
+	    crc->cmd,      // commandBuffer
 	    w,             // groupCountX
 	    h,             // groupCountY
 	    2);            // groupCountZ
@@ -699,7 +887,7 @@ render_compute_projection(struct render_compute *crc,
 	};
 
 	vk->vkCmdPipelineBarrier(                 //
-	    r->cmd,                               //
+	    crc->cmd,                             //
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
 	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
 	    0,                                    //
@@ -753,7 +941,7 @@ render_compute_clear(struct render_compute *crc,                             //
 
 	vk_cmd_image_barrier_gpu_locked( //
 	    vk,                          //
-	    r->cmd,                      //
+	    crc->cmd,                    //
 	    target_image,                //
 	    0,                           //
 	    VK_ACCESS_SHADER_WRITE_BIT,  //
@@ -790,12 +978,12 @@ render_compute_clear(struct render_compute *crc,                             //
 	    crc->r->view_count);              // view_count
 
 	vk->vkCmdBindPipeline(              //
-	    r->cmd,                         // commandBuffer
+	    crc->cmd,                       // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
 	    r->compute.clear.pipeline);     // pipeline
 
 	vk->vkCmdBindDescriptorSets(               //
-	    r->cmd,                                // commandBuffer
+	    crc->cmd,                              // commandBuffer
 	    VK_PIPELINE_BIND_POINT_COMPUTE,        // pipelineBindPoint
 	    r->compute.distortion.pipeline_layout, // layout
 	    0,                                     // firstSet
@@ -806,11 +994,11 @@ render_compute_clear(struct render_compute *crc,                             //
 
 
 	uint32_t w = 0, h = 0;
-	calc_dispatch_dims_views(views, crc->r->view_count, &w, &h);
+	calc_dispatch_dims_views(views, crc->r->view_count, 8, &w, &h);
 	assert(w != 0 && h != 0);
 
 	vk->vkCmdDispatch( //
-	    r->cmd,        // commandBuffer
+	    crc->cmd,      // commandBuffer
 	    w,             // groupCountX
 	    h,             // groupCountY
 	    2);            // groupCountZ
@@ -828,7 +1016,7 @@ render_compute_clear(struct render_compute *crc,                             //
 	};
 
 	vk->vkCmdPipelineBarrier(                 //
-	    r->cmd,                               //
+	    crc->cmd,                             //
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, //
 	    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,    //
 	    0,                                    //
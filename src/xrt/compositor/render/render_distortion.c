@@ -10,14 +10,32 @@
 #include "xrt/xrt_device.h"
 
 #include "math/m_api.h"
+#include "math/m_half.h"
 #include "math/m_matrix_2x2.h"
 #include "math/m_vec2.h"
 
+#include "util/u_misc.h"
+#include "util/u_debug.h"
+#include "util/u_distortion_cache.h"
+
 #include "vk/vk_mini_helpers.h"
 
 #include "render/render_interface.h"
 
 
+/*
+ *
+ * Defines.
+ *
+ */
+
+/*
+ * Halves the memory and bandwidth used by the distortion images, the error
+ * for UVs in [0, 1] is at most 2^-12, half a pixel on a 2048 wide view.
+ */
+DEBUG_GET_ONCE_BOOL_OPTION(distortion_half_float, "XRT_COMPOSITOR_DISTORTION_HALF_FLOAT", false)
+
+
 /*
  *
  * Helper functions.
@@ -27,11 +45,11 @@
 XRT_CHECK_RESULT static VkResult
 create_distortion_image_and_view(struct vk_bundle *vk,
                                  VkExtent2D extent,
+                                 VkFormat format,
                                  VkDeviceMemory *out_device_memory,
                                  VkImage *out_image,
                                  VkImageView *out_image_view)
 {
-	VkFormat format = VK_FORMAT_R32G32_SFLOAT;
 	VkImage image = VK_NULL_HANDLE;
 	VkDeviceMemory device_memory = VK_NULL_HANDLE;
 	VkImageView image_view = VK_NULL_HANDLE;
@@ -144,6 +162,7 @@ create_and_queue_upload_locked(struct vk_bundle *vk,
                                struct vk_cmd_pool *pool,
                                VkCommandBuffer cmd,
                                VkBuffer src_buffer,
+                               VkFormat format,
                                VkDeviceMemory *out_image_device_memory,
                                VkImage *out_image,
                                VkImageView *out_image_view)
@@ -157,6 +176,7 @@ create_and_queue_upload_locked(struct vk_bundle *vk,
 	ret = create_distortion_image_and_view( //
 	    vk,                                 // vk_bundle
 	    extent,                             // extent
+	    format,                             // format
 	    &device_memory,                     // out_device_memory
 	    &image,                             // out_image
 	    &image_view);                       // out_image_view
@@ -184,12 +204,65 @@ struct texture
 	struct xrt_vec2 pixels[RENDER_DISTORTION_IMAGE_DIMENSIONS][RENDER_DISTORTION_IMAGE_DIMENSIONS];
 };
 
+/*!
+ * Same as @ref texture but in half floats, for VK_FORMAT_R16G16_SFLOAT.
+ */
+struct texture_half
+{
+	uint16_t pixels[RENDER_DISTORTION_IMAGE_DIMENSIONS][RENDER_DISTORTION_IMAGE_DIMENSIONS][2];
+};
+
 struct tan_angles_transforms
 {
 	struct xrt_vec2 offset;
 	struct xrt_vec2 scale;
 };
 
+static void
+fill_in_pixels(struct xrt_device *xdev,
+               uint32_t view,
+               const struct xrt_matrix_2x2 *rot,
+               struct texture *r,
+               struct texture *g,
+               struct texture *b)
+{
+	const double dim_minus_one_f64 = RENDER_DISTORTION_IMAGE_DIMENSIONS - 1;
+
+	for (int row = 0; row < RENDER_DISTORTION_IMAGE_DIMENSIONS; row++) {
+		// This goes from 0 to 1.0 inclusive.
+		float v = (float)(row / dim_minus_one_f64);
+
+		for (int col = 0; col < RENDER_DISTORTION_IMAGE_DIMENSIONS; col++) {
+			// This goes from 0 to 1.0 inclusive.
+			float u = (float)(col / dim_minus_one_f64);
+
+			// These need to go from -0.5 to 0.5 for the rotation
+			struct xrt_vec2 uv = {u - 0.5f, v - 0.5f};
+			m_mat2x2_transform_vec2(rot, &uv, &uv);
+			uv.x += 0.5f;
+			uv.y += 0.5f;
+
+			struct xrt_uv_triplet result;
+			xrt_device_compute_distortion(xdev, view, uv.x, uv.y, &result);
+
+			r->pixels[row][col] = result.r;
+			g->pixels[row][col] = result.g;
+			b->pixels[row][col] = result.b;
+		}
+	}
+}
+
+static void
+texture_to_half(const struct texture *src, struct texture_half *dst)
+{
+	for (int row = 0; row < RENDER_DISTORTION_IMAGE_DIMENSIONS; row++) {
+		for (int col = 0; col < RENDER_DISTORTION_IMAGE_DIMENSIONS; col++) {
+			dst->pixels[row][col][0] = m_float_to_half(src->pixels[row][col].x);
+			dst->pixels[row][col][1] = m_float_to_half(src->pixels[row][col].y);
+		}
+	}
+}
+
 XRT_CHECK_RESULT static VkResult
 create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
                                               struct xrt_device *xdev,
@@ -197,7 +270,8 @@ create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
                                               struct render_buffer *g_buffer,
                                               struct render_buffer *b_buffer,
                                               uint32_t view,
-                                              bool pre_rotate)
+                                              bool pre_rotate,
+                                              VkFormat format)
 {
 	VkBufferUsageFlags usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
@@ -217,7 +291,8 @@ create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
 		m_mat2x2_multiply(&rot, &rotation_90_cw, &rot);
 	}
 
-	VkDeviceSize size = sizeof(struct texture);
+	bool half = format == VK_FORMAT_R16G16_SFLOAT;
+	VkDeviceSize size = half ? sizeof(struct texture_half) : sizeof(struct texture);
 
 	ret = render_buffer_init(vk, r_buffer, usage_flags, properties, size);
 	VK_CHK_WITH_GOTO(ret, "render_buffer_init", err_buffers);
@@ -236,33 +311,41 @@ create_and_fill_in_distortion_buffer_for_view(struct vk_bundle *vk,
 	ret = render_buffer_map(vk, b_buffer);
 	VK_CHK_WITH_GOTO(ret, "render_buffer_map", err_buffers);
 
-	struct texture *r = r_buffer->mapped;
-	struct texture *g = g_buffer->mapped;
-	struct texture *b = b_buffer->mapped;
-
-	const double dim_minus_one_f64 = RENDER_DISTORTION_IMAGE_DIMENSIONS - 1;
-
-	for (int row = 0; row < RENDER_DISTORTION_IMAGE_DIMENSIONS; row++) {
-		// This goes from 0 to 1.0 inclusive.
-		float v = (float)(row / dim_minus_one_f64);
+	// Computed and cached as floats, converted after if needed.
+	struct texture *r = half ? U_TYPED_CALLOC(struct texture) : r_buffer->mapped;
+	struct texture *g = half ? U_TYPED_CALLOC(struct texture) : g_buffer->mapped;
+	struct texture *b = half ? U_TYPED_CALLOC(struct texture) : b_buffer->mapped;
+
+	uint64_t key = 0;
+	bool cached = false;
+	if (u_distortion_cache_enabled()) {
+		uint32_t values[3] = {view, pre_rotate ? 1 : 0, RENDER_DISTORTION_IMAGE_DIMENSIONS};
+		key = u_distortion_cache_hash_device(U_DISTORTION_CACHE_HASH_INIT, xdev);
+		key = u_distortion_cache_hash_bytes(key, values, sizeof(values));
+
+		cached = u_distortion_cache_load("image-r", key, r, sizeof(*r)) &&
+		         u_distortion_cache_load("image-g", key, g, sizeof(*g)) &&
+		         u_distortion_cache_load("image-b", key, b, sizeof(*b));
+	}
 
-		for (int col = 0; col < RENDER_DISTORTION_IMAGE_DIMENSIONS; col++) {
-			// This goes from 0 to 1.0 inclusive.
-			float u = (float)(col / dim_minus_one_f64);
+	if (!cached) {
+		fill_in_pixels(xdev, view, &rot, r, g, b);
+	}
 
-			// These need to go from -0.5 to 0.5 for the rotation
-			struct xrt_vec2 uv = {u - 0.5f, v - 0.5f};
-			m_mat2x2_transform_vec2(&rot, &uv, &uv);
-			uv.x += 0.5f;
-			uv.y += 0.5f;
+	if (!cached && u_distortion_cache_enabled()) {
+		u_distortion_cache_store("image-r", key, r, sizeof(*r));
+		u_distortion_cache_store("image-g", key, g, sizeof(*g));
+		u_distortion_cache_store("image-b", key, b, sizeof(*b));
+	}
 
-			struct xrt_uv_triplet result;
-			xrt_device_compute_distortion(xdev, view, uv.x, uv.y, &result);
+	if (half) {
+		texture_to_half(r, r_buffer->mapped);
+		texture_to_half(g, g_buffer->mapped);
+		texture_to_half(b, b_buffer->mapped);
 
-			r->pixels[row][col] = result.r;
-			g->pixels[row][col] = result.g;
-			b->pixels[row][col] = result.b;
-		}
+		free(r);
+		free(g);
+		free(b);
 	}
 
 	render_buffer_unmap(vk, r_buffer);
@@ -290,6 +373,7 @@ render_distortion_buffer_init(struct render_resources *r,
 	VkImage images[RENDER_DISTORTION_IMAGES_SIZE];
 	VkImageView image_views[RENDER_DISTORTION_IMAGES_SIZE];
 	VkCommandBuffer upload_buffer = VK_NULL_HANDLE;
+	VkFormat format = VK_FORMAT_R32G32_SFLOAT;
 	VkResult ret;
 
 
@@ -297,6 +381,10 @@ render_distortion_buffer_init(struct render_resources *r,
 	 * Basics
 	 */
 
+	if (debug_get_bool_option_distortion_half_float()) {
+		format = VK_FORMAT_R16G16_SFLOAT;
+	}
+
 	for (uint32_t i = 0; i < r->view_count; ++i) {
 		render_calc_uv_to_tangent_lengths_rect(&xdev->hmd->distortion.fov[i], &r->distortion.uv_to_tanangle[i]);
 	}
@@ -308,7 +396,8 @@ render_distortion_buffer_init(struct render_resources *r,
 	 */
 	for (uint32_t i = 0; i < r->view_count; ++i) {
 		ret = create_and_fill_in_distortion_buffer_for_view(vk, xdev, &bufs[i], &bufs[r->view_count + i],
-		                                                    &bufs[2 * r->view_count + i], i, pre_rotate);
+		                                                    &bufs[2 * r->view_count + i], i, pre_rotate,
+		                                                    format);
 		VK_CHK_WITH_GOTO(ret, "create_and_fill_in_distortion_buffer_for_view", err_resources);
 	}
 
@@ -330,6 +419,7 @@ render_distortion_buffer_init(struct render_resources *r,
 		    pool,                             // pool
 		    upload_buffer,                    // cmd
 		    bufs[i].buffer,                   // src_buffer
+		    format,                           // format
 		    &device_memories[i],              // out_image_device_memory
 		    &images[i],                       // out_image
 		    &image_views[i]);                 // out_image_view
@@ -346,13 +436,18 @@ render_distortion_buffer_init(struct render_resources *r,
 	 */
 
 	r->distortion.pre_rotated = pre_rotate;
+	r->distortion.format = format;
+	r->distortion.tracked_size = 0;
 
 	for (uint32_t i = 0; i < RENDER_DISTORTION_IMAGES_COUNT; i++) {
 		r->distortion.device_memories[i] = device_memories[i];
 		r->distortion.images[i] = images[i];
 		r->distortion.image_views[i] = image_views[i];
+		r->distortion.tracked_size += vk_memory_budget_image_size(vk, images[i]);
 	}
 
+	vk_memory_budget_add(vk, VK_MEMORY_CATEGORY_DISTORTION, r->distortion.tracked_size);
+
 
 	/*
 	 * Tidy
@@ -399,6 +494,9 @@ render_distortion_images_close(struct render_resources *r)
 		D(Image, r->distortion.images[i]);
 		DF(Memory, r->distortion.device_memories[i]);
 	}
+
+	vk_memory_budget_remove(vk, VK_MEMORY_CATEGORY_DISTORTION, r->distortion.tracked_size);
+	r->distortion.tracked_size = 0;
 }
 
 bool
@@ -8,6 +8,9 @@
  * @ingroup comp_render
  */
 
+#include "util/u_debug.h"
+#include "util/u_trace_marker.h"
+
 #include "vk/vk_mini_helpers.h"
 
 #include "render/render_interface.h"
@@ -15,6 +18,9 @@
 #include <stdio.h>
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(background_pipelines, "XRT_COMPOSITOR_BACKGROUND_PIPELINES", true)
+
+
 /*
  *
  * Common helpers
@@ -150,7 +156,8 @@ begin_render_pass(struct vk_bundle *vk,
                   VkFramebuffer framebuffer,
                   uint32_t width,
                   uint32_t height,
-                  const VkClearColorValue *color)
+                  const VkClearColorValue *color,
+                  VkSubpassContents contents)
 {
 	VkClearValue clear_color[1] = {{
 	    .color = *color,
@@ -177,7 +184,7 @@ begin_render_pass(struct vk_bundle *vk,
 	    .pClearValues = clear_color,
 	};
 
-	vk->vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+	vk->vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, contents);
 }
 
 static void
@@ -288,6 +295,98 @@ do_ubo_and_src_alloc_and_write(struct render_gfx *rr,
 	return VK_SUCCESS;
 }
 
+XRT_CHECK_RESULT static VkResult
+do_ubo_alloc_and_batch_write(struct render_gfx *rr,
+                             struct render_gfx_layer_batch *batch,
+                             const void *ubo_ptr,
+                             VkDeviceSize ubo_size,
+                             VkSampler src_sampler,
+                             VkImageView src_image_view,
+                             VkDescriptorSet *out_descriptor_set)
+{
+	struct render_sub_alloc ubo = XRT_STRUCT_INIT;
+	struct vk_bundle *vk = vk_from_rr(rr);
+
+	VkResult ret;
+
+	if (batch->count >= batch->allocated_count) {
+		VK_ERROR(vk, "Out of layer descriptor sets, allocated %u", batch->allocated_count);
+		return VK_ERROR_OUT_OF_POOL_MEMORY;
+	}
+
+
+	/*
+	 * Allocate and upload data.
+	 */
+	ret = render_sub_alloc_ubo_alloc_and_write( //
+	    vk,                                     // vk_bundle
+	    &rr->ubo_tracker,                       // rsat
+	    ubo_ptr,                                // ptr
+	    ubo_size,                               // size
+	    &ubo);                                  // out_rsa
+	VK_CHK_AND_RET(ret, "render_sub_alloc_ubo_alloc_and_write");
+
+
+	/*
+	 * Take a descriptor and queue up the writes, done by flush.
+	 */
+
+	uint32_t index = batch->count++;
+	VkDescriptorSet descriptor_set = batch->descriptor_sets[index];
+
+	batch->image_infos[index] = (VkDescriptorImageInfo){
+	    .sampler = src_sampler,
+	    .imageView = src_image_view,
+	    .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	};
+
+	batch->buffer_infos[index] = (VkDescriptorBufferInfo){
+	    .buffer = ubo.buffer,
+	    .offset = ubo.offset,
+	    .range = ubo.size,
+	};
+
+	batch->writes[index * 2 + 0] = (VkWriteDescriptorSet){
+	    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	    .dstSet = descriptor_set,
+	    .dstBinding = RENDER_BINDING_LAYER_SHARED_SRC,
+	    .descriptorCount = 1,
+	    .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	    .pImageInfo = &batch->image_infos[index],
+	};
+
+	batch->writes[index * 2 + 1] = (VkWriteDescriptorSet){
+	    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	    .dstSet = descriptor_set,
+	    .dstBinding = RENDER_BINDING_LAYER_SHARED_UBO,
+	    .descriptorCount = 1,
+	    .descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	    .pBufferInfo = &batch->buffer_infos[index],
+	};
+
+	*out_descriptor_set = descriptor_set;
+
+	return VK_SUCCESS;
+}
+
+static inline void
+bind_pipeline(struct render_gfx *rr, VkPipeline pipeline)
+{
+	struct vk_bundle *vk = vk_from_rr(rr);
+
+	// Pipeline state persists across render passes in the command buffer.
+	if (rr->bound.pipeline == pipeline) {
+		return;
+	}
+
+	vk->vkCmdBindPipeline(               //
+	    rr->cmd,                         // commandBuffer
+	    VK_PIPELINE_BIND_POINT_GRAPHICS, // pipelineBindPoint
+	    pipeline);                       // pipeline
+
+	rr->bound.pipeline = pipeline;
+}
+
 static inline void
 dispatch_no_vbo(struct render_gfx *rr, uint32_t vertex_count, VkPipeline pipeline, VkDescriptorSet descriptor_set)
 {
@@ -297,7 +396,7 @@ dispatch_no_vbo(struct render_gfx *rr, uint32_t vertex_count, VkPipeline pipelin
 
 	VkDescriptorSet descriptor_sets[1] = {descriptor_set};
 	vk->vkCmdBindDescriptorSets(             //
-	    r->cmd,                              // commandBuffer
+	    rr->cmd,                             // commandBuffer
 	    VK_PIPELINE_BIND_POINT_GRAPHICS,     // pipelineBindPoint
 	    r->gfx.layer.shared.pipeline_layout, // layout
 	    0,                                   // firstSet
@@ -306,15 +405,12 @@ dispatch_no_vbo(struct render_gfx *rr, uint32_t vertex_count, VkPipeline pipelin
 	    0,                                   // dynamicOffsetCount
 	    NULL);                               // pDynamicOffsets
 
-	vk->vkCmdBindPipeline(               //
-	    r->cmd,                          // commandBuffer
-	    VK_PIPELINE_BIND_POINT_GRAPHICS, // pipelineBindPoint
-	    pipeline);                       // pipeline
+	bind_pipeline(rr, pipeline);
 
 	// This pipeline doesn't have any VBO input or indices.
 
 	vk->vkCmdDraw(    //
-	    r->cmd,       // commandBuffer
+	    rr->cmd,      // commandBuffer
 	    vertex_count, // vertexCount
 	    1,            // instanceCount
 	    0,            // firstVertex
@@ -695,6 +791,138 @@ create_mesh_pipeline(struct vk_bundle *vk,
 	return VK_SUCCESS;
 }
 
+/*!
+ * Create the layer pipelines that are not needed for the first frame, which
+ * only needs the distortion mesh and projection layer ones.
+ */
+XRT_CHECK_RESULT static VkResult
+create_deferred_layer_pipelines(struct render_gfx_render_pass *rgrp)
+{
+	struct render_resources *r = rgrp->r;
+	struct vk_bundle *vk = r->vk;
+	VkResult ret;
+
+	const VkBlendFactor blend_factor_premultiplied_alpha = VK_BLEND_FACTOR_ONE;
+	const VkBlendFactor blend_factor_unpremultiplied_alpha = VK_BLEND_FACTOR_SRC_ALPHA;
+
+	// Cylinder
+	ret = create_layer_pipeline(                    //
+	    vk,                                         // vk
+	    rgrp->render_pass,                          // render_pass
+	    r->gfx.layer.shared.pipeline_layout,        // pipeline_layout
+	    r->pipeline_cache,                          // pipeline_cache
+	    blend_factor_premultiplied_alpha,           // src_blend_factor
+	    r->shaders->layer_cylinder_vert,            // module_vert
+	    r->shaders->layer_cylinder_frag,            // module_frag
+	    &rgrp->layer.cylinder_premultiplied_alpha); // out_pipeline
+	VK_CHK_AND_RET(ret, "create_layer_pipeline");
+	VK_NAME_PIPELINE(vk, rgrp->layer.cylinder_premultiplied_alpha,
+	                 "render_gfx_render_pass cylinder premultiplied alpha");
+
+	ret = create_layer_pipeline(                      //
+	    vk,                                           // vk
+	    rgrp->render_pass,                            // render_pass
+	    r->gfx.layer.shared.pipeline_layout,          // pipeline_layout
+	    r->pipeline_cache,                            // pipeline_cache
+	    blend_factor_unpremultiplied_alpha,           // src_blend_factor
+	    r->shaders->layer_cylinder_vert,              // module_vert
+	    r->shaders->layer_cylinder_frag,              // module_frag
+	    &rgrp->layer.cylinder_unpremultiplied_alpha); // out_pipeline
+	VK_CHK_AND_RET(ret, "create_layer_pipeline");
+	VK_NAME_PIPELINE(vk, rgrp->layer.cylinder_unpremultiplied_alpha,
+	                 "render_gfx_render_pass cylinder unpremultiplied alpha");
+
+	// Equirect2
+	ret = create_layer_pipeline(                     //
+	    vk,                                          // vk
+	    rgrp->render_pass,                           // render_pass
+	    r->gfx.layer.shared.pipeline_layout,         // pipeline_layout
+	    r->pipeline_cache,                           // pipeline_cache
+	    blend_factor_premultiplied_alpha,            // src_blend_factor
+	    r->shaders->layer_equirect2_vert,            // module_vert
+	    r->shaders->layer_equirect2_frag,            // module_frag
+	    &rgrp->layer.equirect2_premultiplied_alpha); // out_pipeline
+	VK_CHK_AND_RET(ret, "create_layer_pipeline");
+	VK_NAME_PIPELINE(vk, rgrp->layer.equirect2_premultiplied_alpha,
+	                 "render_gfx_render_pass equirect2 premultiplied alpha");
+
+	ret = create_layer_pipeline(                       //
+	    vk,                                            // vk
+	    rgrp->render_pass,                             // render_pass
+	    r->gfx.layer.shared.pipeline_layout,           // pipeline_layout
+	    r->pipeline_cache,                             // pipeline_cache
+	    blend_factor_unpremultiplied_alpha,            // src_blend_factor
+	    r->shaders->layer_equirect2_vert,              // module_vert
+	    r->shaders->layer_equirect2_frag,              // module_frag
+	    &rgrp->layer.equirect2_unpremultiplied_alpha); // out_pipeline
+	VK_CHK_AND_RET(ret, "create_layer_pipeline");
+	VK_NAME_PIPELINE(vk, rgrp->layer.equirect2_unpremultiplied_alpha,
+	                 "render_gfx_render_pass equirect2 unpremultiplied alpha");
+
+	// Quad
+	ret = create_layer_pipeline(                //
+	    vk,                                     // vk
+	    rgrp->render_pass,                      // render_pass
+	    r->gfx.layer.shared.pipeline_layout,    // pipeline_layout
+	    r->pipeline_cache,                      // pipeline_cache
+	    blend_factor_premultiplied_alpha,       // src_blend_factor
+	    r->shaders->layer_quad_vert,            // module_vert
+	    r->shaders->layer_shared_frag,          // module_frag
+	    &rgrp->layer.quad_premultiplied_alpha); // out_pipeline
+	VK_CHK_AND_RET(ret, "create_layer_pipeline");
+	VK_NAME_PIPELINE(vk, rgrp->layer.quad_premultiplied_alpha, "render_gfx_render_pass quad premultiplied alpha");
+
+	ret = create_layer_pipeline(                  //
+	    vk,                                       // vk
+	    rgrp->render_pass,                        // render_pass
+	    r->gfx.layer.shared.pipeline_layout,      // pipeline_layout
+	    r->pipeline_cache,                        // pipeline_cache
+	    blend_factor_unpremultiplied_alpha,       // src_blend_factor
+	    r->shaders->layer_quad_vert,              // module_vert
+	    r->shaders->layer_shared_frag,            // module_frag
+	    &rgrp->layer.quad_unpremultiplied_alpha); // out_pipeline
+	VK_CHK_AND_RET(ret, "create_layer_pipeline");
+	VK_NAME_PIPELINE(vk, rgrp->layer.quad_unpremultiplied_alpha,
+	                 "render_gfx_render_pass quad unpremultiplied alpha");
+
+	return VK_SUCCESS;
+}
+
+static void *
+deferred_layer_pipelines_thread(void *ptr)
+{
+	struct render_gfx_render_pass *rgrp = (struct render_gfx_render_pass *)ptr;
+
+	U_TRACE_SET_THREAD_NAME("Render: Pipelines");
+
+	VkResult ret = create_deferred_layer_pipelines(rgrp);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(rgrp->r->vk, "create_deferred_layer_pipelines: %s", vk_result_string(ret));
+	}
+
+	// The pipelines are only read after ready has been seen under the lock.
+	os_thread_helper_lock(&rgrp->deferred.oth);
+	rgrp->deferred.ready = true;
+	os_thread_helper_unlock(&rgrp->deferred.oth);
+
+	// Not signalling stop, close joins the thread.
+	return NULL;
+}
+
+static bool
+deferred_layer_pipelines_ready(struct render_gfx_render_pass *rgrp)
+{
+	if (!rgrp->deferred.started) {
+		return true;
+	}
+
+	os_thread_helper_lock(&rgrp->deferred.oth);
+	bool ready = rgrp->deferred.ready;
+	os_thread_helper_unlock(&rgrp->deferred.oth);
+
+	return ready;
+}
+
 
 /*
  *
@@ -762,60 +990,6 @@ render_gfx_render_pass_init(struct render_gfx_render_pass *rgrp,
 	const VkBlendFactor blend_factor_premultiplied_alpha = VK_BLEND_FACTOR_ONE;
 	const VkBlendFactor blend_factor_unpremultiplied_alpha = VK_BLEND_FACTOR_SRC_ALPHA;
 
-	// Cylinder
-	ret = create_layer_pipeline(                    //
-	    vk,                                         // vk
-	    rgrp->render_pass,                          // render_pass
-	    r->gfx.layer.shared.pipeline_layout,        // pipeline_layout
-	    r->pipeline_cache,                          // pipeline_cache
-	    blend_factor_premultiplied_alpha,           // src_blend_factor
-	    r->shaders->layer_cylinder_vert,            // module_vert
-	    r->shaders->layer_cylinder_frag,            // module_frag
-	    &rgrp->layer.cylinder_premultiplied_alpha); // out_pipeline
-	VK_CHK_WITH_RET(ret, "create_layer_pipeline", false);
-	VK_NAME_PIPELINE(vk, rgrp->layer.cylinder_premultiplied_alpha,
-	                 "render_gfx_render_pass cylinder premultiplied alpha");
-
-	ret = create_layer_pipeline(                      //
-	    vk,                                           // vk
-	    rgrp->render_pass,                            // render_pass
-	    r->gfx.layer.shared.pipeline_layout,          // pipeline_layout
-	    r->pipeline_cache,                            // pipeline_cache
-	    blend_factor_unpremultiplied_alpha,           // src_blend_factor
-	    r->shaders->layer_cylinder_vert,              // module_vert
-	    r->shaders->layer_cylinder_frag,              // module_frag
-	    &rgrp->layer.cylinder_unpremultiplied_alpha); // out_pipeline
-	VK_CHK_WITH_RET(ret, "create_layer_pipeline", false);
-	VK_NAME_PIPELINE(vk, rgrp->layer.cylinder_unpremultiplied_alpha,
-	                 "render_gfx_render_pass cylinder unpremultiplied alpha");
-
-	// Equirect2
-	ret = create_layer_pipeline(                     //
-	    vk,                                          // vk
-	    rgrp->render_pass,                           // render_pass
-	    r->gfx.layer.shared.pipeline_layout,         // pipeline_layout
-	    r->pipeline_cache,                           // pipeline_cache
-	    blend_factor_premultiplied_alpha,            // src_blend_factor
-	    r->shaders->layer_equirect2_vert,            // module_vert
-	    r->shaders->layer_equirect2_frag,            // module_frag
-	    &rgrp->layer.equirect2_premultiplied_alpha); // out_pipeline
-	VK_CHK_WITH_RET(ret, "create_layer_pipeline", false);
-	VK_NAME_PIPELINE(vk, rgrp->layer.equirect2_premultiplied_alpha,
-	                 "render_gfx_render_pass equirect2 premultiplied alpha");
-
-	ret = create_layer_pipeline(                       //
-	    vk,                                            // vk
-	    rgrp->render_pass,                             // render_pass
-	    r->gfx.layer.shared.pipeline_layout,           // pipeline_layout
-	    r->pipeline_cache,                             // pipeline_cache
-	    blend_factor_unpremultiplied_alpha,            // src_blend_factor
-	    r->shaders->layer_equirect2_vert,              // module_vert
-	    r->shaders->layer_equirect2_frag,              // module_frag
-	    &rgrp->layer.equirect2_unpremultiplied_alpha); // out_pipeline
-	VK_CHK_WITH_RET(ret, "create_layer_pipeline", false);
-	VK_NAME_PIPELINE(vk, rgrp->layer.equirect2_unpremultiplied_alpha,
-	                 "render_gfx_render_pass equirect2 unpremultiplied alpha");
-
 	// Projection.
 	ret = create_layer_pipeline(                //
 	    vk,                                     // vk
@@ -843,32 +1017,6 @@ render_gfx_render_pass_init(struct render_gfx_render_pass *rgrp,
 	VK_NAME_PIPELINE(vk, rgrp->layer.proj_unpremultiplied_alpha,
 	                 "render_gfx_render_pass projection unpremultiplied alpha");
 
-	// Quad
-	ret = create_layer_pipeline(                //
-	    vk,                                     // vk
-	    rgrp->render_pass,                      // render_pass
-	    r->gfx.layer.shared.pipeline_layout,    // pipeline_layout
-	    r->pipeline_cache,                      // pipeline_cache
-	    blend_factor_premultiplied_alpha,       // src_blend_factor
-	    r->shaders->layer_quad_vert,            // module_vert
-	    r->shaders->layer_shared_frag,          // module_frag
-	    &rgrp->layer.quad_premultiplied_alpha); // out_pipeline
-	VK_CHK_WITH_RET(ret, "create_layer_pipeline", false);
-	VK_NAME_PIPELINE(vk, rgrp->layer.quad_premultiplied_alpha, "render_gfx_render_pass quad premultiplied alpha");
-
-	ret = create_layer_pipeline(                  //
-	    vk,                                       // vk
-	    rgrp->render_pass,                        // render_pass
-	    r->gfx.layer.shared.pipeline_layout,      // pipeline_layout
-	    r->pipeline_cache,                        // pipeline_cache
-	    blend_factor_unpremultiplied_alpha,       // src_blend_factor
-	    r->shaders->layer_quad_vert,              // module_vert
-	    r->shaders->layer_shared_frag,            // module_frag
-	    &rgrp->layer.quad_unpremultiplied_alpha); // out_pipeline
-	VK_CHK_WITH_RET(ret, "create_layer_pipeline", false);
-	VK_NAME_PIPELINE(vk, rgrp->layer.quad_unpremultiplied_alpha,
-	                 "render_gfx_render_pass quad unpremultiplied alpha");
-
 	// Set fields.
 	rgrp->r = r;
 	rgrp->format = format;
@@ -876,6 +1024,21 @@ render_gfx_render_pass_init(struct render_gfx_render_pass *rgrp,
 	rgrp->load_op = load_op;
 	rgrp->final_layout = final_layout;
 
+	// Everything after this is not needed for the first frame.
+	if (debug_get_bool_option_background_pipelines() && os_thread_helper_init(&rgrp->deferred.oth) == 0) {
+		if (os_thread_helper_start(&rgrp->deferred.oth, deferred_layer_pipelines_thread, rgrp) == 0) {
+			os_thread_helper_name(&rgrp->deferred.oth, "Render: Pipelines");
+			rgrp->deferred.started = true;
+			return true;
+		}
+
+		VK_WARN(vk, "Failed to start pipeline thread, creating the layer pipelines here");
+		os_thread_helper_destroy(&rgrp->deferred.oth);
+	}
+
+	ret = create_deferred_layer_pipelines(rgrp);
+	VK_CHK_WITH_RET(ret, "create_deferred_layer_pipelines", false);
+
 	return true;
 }
 
@@ -884,6 +1047,11 @@ render_gfx_render_pass_close(struct render_gfx_render_pass *rgrp)
 {
 	struct vk_bundle *vk = rgrp->r->vk;
 
+	// Wait for the background pipeline creation to finish.
+	if (rgrp->deferred.started) {
+		os_thread_helper_destroy(&rgrp->deferred.oth);
+	}
+
 	D(RenderPass, rgrp->render_pass);
 	D(Pipeline, rgrp->mesh.pipeline);
 	D(Pipeline, rgrp->mesh.pipeline_timewarp);
@@ -957,6 +1125,7 @@ render_gfx_init(struct render_gfx *rr, struct render_resources *r)
 {
 	// Init fields.
 	rr->r = r;
+	rr->cmd = r->cmd;
 
 	// Used to sub-allocate UBOs from, restart from scratch each frame.
 	render_sub_alloc_tracker_init(&rr->ubo_tracker, &r->gfx.shared_ubo);
@@ -973,6 +1142,12 @@ render_gfx_begin(struct render_gfx *rr)
 	ret = vk->vkResetCommandPool(vk->device, rr->r->cmd_pool, 0);
 	VK_CHK_WITH_RET(ret, "vkResetCommandPool", false);
 
+	// Previous frame is done with the secondary command buffers too.
+	for (uint32_t i = 0; i < rr->r->view_count; i++) {
+		ret = vk->vkResetCommandPool(vk->device, rr->r->secondary.cmd_pools[i], 0);
+		VK_CHK_WITH_RET(ret, "vkResetCommandPool", false);
+	}
+
 
 	VkCommandBufferBeginInfo begin_info = {
 	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -984,11 +1159,11 @@ render_gfx_begin(struct render_gfx *rr)
 	    &begin_info);               // pBeginInfo
 	VK_CHK_WITH_RET(ret, "vkResetCommandPool", false);
 
-	vk->vkCmdResetQueryPool( //
-	    rr->r->cmd,          // commandBuffer
-	    rr->r->query_pool,   // queryPool
-	    0,                   // firstQuery
-	    2);                  // queryCount
+	// New command buffer, nothing is bound.
+	rr->cmd = rr->r->cmd;
+	U_ZERO(&rr->bound);
+
+	render_resources_cmd_reset_timestamps(rr->r, rr->r->cmd);
 
 	vk->vkCmdWriteTimestamp(               //
 	    rr->r->cmd,                        // commandBuffer
@@ -1017,6 +1192,12 @@ render_gfx_end(struct render_gfx *rr)
 	return true;
 }
 
+void
+render_gfx_write_timestamp(struct render_gfx *rr, enum render_timestamp_phase phase, uint32_t view_index, bool end)
+{
+	render_resources_cmd_write_phase_timestamp(rr->r, rr->r->cmd, phase, view_index, end);
+}
+
 void
 render_gfx_close(struct render_gfx *rr)
 {
@@ -1052,14 +1233,110 @@ render_gfx_begin_target(struct render_gfx *rr, struct render_gfx_target_resource
 	VkFramebuffer framebuffer = rtr->framebuffer;
 	VkExtent2D extent = rtr->extent;
 
-	begin_render_pass( //
-	    vk,            //
-	    rr->r->cmd,    //
-	    render_pass,   //
-	    framebuffer,   //
-	    extent.width,  //
-	    extent.height, //
-	    color);        //
+	begin_render_pass(               //
+	    vk,                          //
+	    rr->r->cmd,                  //
+	    render_pass,                 //
+	    framebuffer,                 //
+	    extent.width,                //
+	    extent.height,               //
+	    color,                       //
+	    VK_SUBPASS_CONTENTS_INLINE); //
+
+	return true;
+}
+
+bool
+render_gfx_begin_target_secondary(struct render_gfx *rr,
+                                  struct render_gfx_target_resources *rtr,
+                                  const VkClearColorValue *color)
+{
+	struct vk_bundle *vk = vk_from_rr(rr);
+
+	assert(rr->rtr == NULL);
+	rr->rtr = rtr;
+
+	VkRenderPass render_pass = rtr->rgrp->render_pass;
+	VkFramebuffer framebuffer = rtr->framebuffer;
+	VkExtent2D extent = rtr->extent;
+
+	begin_render_pass(                                  //
+	    vk,                                             //
+	    rr->r->cmd,                                     //
+	    render_pass,                                    //
+	    framebuffer,                                    //
+	    extent.width,                                   //
+	    extent.height,                                  //
+	    color,                                          //
+	    VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS); //
+
+	return true;
+}
+
+void
+render_gfx_execute_secondary(struct render_gfx *rr, uint32_t view_index)
+{
+	struct vk_bundle *vk = vk_from_rr(rr);
+
+	assert(rr->rtr != NULL);
+	assert(view_index < rr->r->view_count);
+
+	vk->vkCmdExecuteCommands(rr->r->cmd, 1, &rr->r->secondary.cmds[view_index]);
+
+	// Executing secondary command buffers leaves the bound state undefined.
+	U_ZERO(&rr->bound);
+}
+
+bool
+render_gfx_secondary_begin(struct render_gfx *rr,
+                           uint32_t view_index,
+                           struct render_gfx_target_resources *rtr,
+                           struct render_gfx *out_view_rr)
+{
+	struct vk_bundle *vk = vk_from_rr(rr);
+	VkResult ret;
+
+	assert(view_index < rr->r->view_count);
+
+	VkCommandBuffer cmd = rr->r->secondary.cmds[view_index];
+
+	VkCommandBufferInheritanceInfo inheritance_info = {
+	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+	    .renderPass = rtr->rgrp->render_pass,
+	    .subpass = 0,
+	    .framebuffer = rtr->framebuffer,
+	};
+
+	VkCommandBufferBeginInfo begin_info = {
+	    .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+	    .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+	    .pInheritanceInfo = &inheritance_info,
+	};
+
+	ret = vk->vkBeginCommandBuffer(cmd, &begin_info);
+	VK_CHK_WITH_RET(ret, "vkBeginCommandBuffer", false);
+
+	// Shares the resources, but has its own command buffer and bound state.
+	*out_view_rr = *rr;
+	out_view_rr->cmd = cmd;
+	out_view_rr->rtr = rtr;
+	U_ZERO(&out_view_rr->bound);
+
+	return true;
+}
+
+bool
+render_gfx_secondary_end(struct render_gfx *view_rr)
+{
+	struct vk_bundle *vk = vk_from_rr(view_rr);
+	VkResult ret;
+
+	assert(view_rr->cmd != view_rr->r->cmd);
+
+	ret = vk->vkEndCommandBuffer(view_rr->cmd);
+	VK_CHK_WITH_RET(ret, "vkEndCommandBuffer", false);
+
+	view_rr->rtr = NULL;
 
 	return true;
 }
@@ -1099,7 +1376,7 @@ render_gfx_begin_view(struct render_gfx *rr, uint32_t view, const struct render_
 	    .maxDepth = 1.0f,
 	};
 
-	vk->vkCmdSetViewport(rr->r->cmd, // commandBuffer
+	vk->vkCmdSetViewport(rr->cmd,    // commandBuffer
 	                     0,          // firstViewport
 	                     1,          // viewportCount
 	                     &viewport); // pViewports
@@ -1121,7 +1398,7 @@ render_gfx_begin_view(struct render_gfx *rr, uint32_t view, const struct render_
 	        },
 	};
 
-	vk->vkCmdSetScissor(rr->r->cmd, // commandBuffer
+	vk->vkCmdSetScissor(rr->cmd,    // commandBuffer
 	                    0,          // firstScissor
 	                    1,          // scissorCount
 	                    &scissor);  // pScissors
@@ -1169,7 +1446,7 @@ render_gfx_mesh_draw(struct render_gfx *rr, uint32_t mesh_index, VkDescriptorSet
 
 	VkDescriptorSet descriptor_sets[1] = {descriptor_set};
 	vk->vkCmdBindDescriptorSets(         //
-	    r->cmd,                          // commandBuffer
+	    rr->cmd,                         // commandBuffer
 	    VK_PIPELINE_BIND_POINT_GRAPHICS, // pipelineBindPoint
 	    r->mesh.pipeline_layout,         // layout
 	    0,                               // firstSet
@@ -1181,26 +1458,35 @@ render_gfx_mesh_draw(struct render_gfx *rr, uint32_t mesh_index, VkDescriptorSet
 	// Select which pipeline we want.
 	VkPipeline pipeline = do_timewarp ? rr->rtr->rgrp->mesh.pipeline_timewarp : rr->rtr->rgrp->mesh.pipeline;
 
-	vk->vkCmdBindPipeline(               //
-	    r->cmd,                          // commandBuffer
-	    VK_PIPELINE_BIND_POINT_GRAPHICS, // pipelineBindPoint
-	    pipeline);                       // pipeline
+	bind_pipeline(rr, pipeline);
 
 
 	/*
-	 * Vertex buffer.
+	 * Vertex and index buffers, shared by all views.
 	 */
 
-	VkBuffer buffers[1] = {r->mesh.vbo.buffer};
-	VkDeviceSize offsets[1] = {0};
-	assert(ARRAY_SIZE(buffers) == ARRAY_SIZE(offsets));
-
-	vk->vkCmdBindVertexBuffers( //
-	    r->cmd,                 // commandBuffer
-	    0,                      // firstBinding
-	    ARRAY_SIZE(buffers),    // bindingCount
-	    buffers,                // pBuffers
-	    offsets);               // pOffsets
+	if (!rr->bound.mesh_buffers) {
+		VkBuffer buffers[1] = {r->mesh.vbo.buffer};
+		VkDeviceSize offsets[1] = {0};
+		assert(ARRAY_SIZE(buffers) == ARRAY_SIZE(offsets));
+
+		vk->vkCmdBindVertexBuffers( //
+		    rr->cmd,                // commandBuffer
+		    0,                      // firstBinding
+		    ARRAY_SIZE(buffers),    // bindingCount
+		    buffers,                // pBuffers
+		    offsets);               // pOffsets
+
+		if (r->mesh.index_count_total > 0) {
+			vk->vkCmdBindIndexBuffer(  //
+			    rr->cmd,               // commandBuffer
+			    r->mesh.ibo.buffer,    // buffer
+			    0,                     // offset
+			    VK_INDEX_TYPE_UINT32); // indexType
+		}
+
+		rr->bound.mesh_buffers = true;
+	}
 
 
 	/*
@@ -1208,14 +1494,9 @@ render_gfx_mesh_draw(struct render_gfx *rr, uint32_t mesh_index, VkDescriptorSet
 	 */
 
 	if (r->mesh.index_count_total > 0) {
-		vk->vkCmdBindIndexBuffer(  //
-		    r->cmd,                // commandBuffer
-		    r->mesh.ibo.buffer,    // buffer
-		    0,                     // offset
-		    VK_INDEX_TYPE_UINT32); // indexType
 
 		vk->vkCmdDrawIndexed(                  //
-		    r->cmd,                            // commandBuffer
+		    rr->cmd,                           // commandBuffer
 		    r->mesh.index_counts[mesh_index],  // indexCount
 		    1,                                 // instanceCount
 		    r->mesh.index_offsets[mesh_index], // firstIndex
@@ -1223,7 +1504,7 @@ render_gfx_mesh_draw(struct render_gfx *rr, uint32_t mesh_index, VkDescriptorSet
 		    0);                                // firstInstance
 	} else {
 		vk->vkCmdDraw(            //
-		    r->cmd,               // commandBuffer
+		    rr->cmd,              // commandBuffer
 		    r->mesh.vertex_count, // vertexCount
 		    1,                    // instanceCount
 		    0,                    // firstVertex
@@ -1238,97 +1519,131 @@ render_gfx_mesh_draw(struct render_gfx *rr, uint32_t mesh_index, VkDescriptorSet
  *
  */
 
+XRT_CHECK_RESULT VkResult
+render_gfx_layer_batch_alloc(struct render_gfx *rr, uint32_t count, struct render_gfx_layer_batch *batch)
+{
+	struct vk_bundle *vk = vk_from_rr(rr);
+	struct render_resources *r = rr->r;
+	VkResult ret;
+
+	assert(count <= ARRAY_SIZE(batch->descriptor_sets));
+
+	batch->allocated_count = 0;
+	batch->count = 0;
+
+	if (count == 0) {
+		return VK_SUCCESS;
+	}
+
+	ret = vk_create_descriptor_sets(               //
+	    vk,                                        // vk_bundle
+	    r->gfx.ubo_and_src_descriptor_pool,        // descriptor_pool
+	    r->gfx.layer.shared.descriptor_set_layout, // descriptor_set_layout
+	    count,                                     // count
+	    batch->descriptor_sets);                   // out_descriptor_sets
+	VK_CHK_AND_RET(ret, "vk_create_descriptor_sets");
+
+	batch->allocated_count = count;
+
+	return VK_SUCCESS;
+}
+
+void
+render_gfx_layer_batch_flush(struct render_gfx *rr, struct render_gfx_layer_batch *batch)
+{
+	struct vk_bundle *vk = vk_from_rr(rr);
+
+	if (batch->count == 0) {
+		return;
+	}
+
+	vk->vkUpdateDescriptorSets( //
+	    vk->device,             //
+	    batch->count * 2,       // descriptorWriteCount
+	    batch->writes,          // pDescriptorWrites
+	    0,                      // descriptorCopyCount
+	    NULL);                  // pDescriptorCopies
+}
+
 XRT_CHECK_RESULT VkResult
 render_gfx_layer_cylinder_alloc_and_write(struct render_gfx *rr,
+                                          struct render_gfx_layer_batch *batch,
                                           const struct render_gfx_layer_cylinder_data *data,
                                           VkSampler src_sampler,
                                           VkImageView src_image_view,
                                           VkDescriptorSet *out_descriptor_set)
 {
-	struct render_resources *r = rr->r;
-
-	return do_ubo_and_src_alloc_and_write(         //
-	    rr,                                        // rr
-	    RENDER_BINDING_LAYER_SHARED_UBO,           // ubo_binding
-	    data,                                      // ubo_ptr
-	    sizeof(*data),                             // ubo_size
-	    RENDER_BINDING_LAYER_SHARED_SRC,           // src_binding
-	    src_sampler,                               // src_sampler
-	    src_image_view,                            // src_image_view
-	    r->gfx.ubo_and_src_descriptor_pool,        // descriptor_pool
-	    r->gfx.layer.shared.descriptor_set_layout, // descriptor_set_layout
-	    out_descriptor_set);                       // out_descriptor_set
+	return do_ubo_alloc_and_batch_write( //
+	    rr,                              // rr
+	    batch,                           // batch
+	    data,                            // ubo_ptr
+	    sizeof(*data),                   // ubo_size
+	    src_sampler,                     // src_sampler
+	    src_image_view,                  // src_image_view
+	    out_descriptor_set);             // out_descriptor_set
 }
 
 XRT_CHECK_RESULT VkResult
 render_gfx_layer_equirect2_alloc_and_write(struct render_gfx *rr,
+                                           struct render_gfx_layer_batch *batch,
                                            const struct render_gfx_layer_equirect2_data *data,
                                            VkSampler src_sampler,
                                            VkImageView src_image_view,
                                            VkDescriptorSet *out_descriptor_set)
 {
-	struct render_resources *r = rr->r;
-
-	return do_ubo_and_src_alloc_and_write(         //
-	    rr,                                        // rr
-	    RENDER_BINDING_LAYER_SHARED_UBO,           // ubo_binding
-	    data,                                      // ubo_ptr
-	    sizeof(*data),                             // ubo_size
-	    RENDER_BINDING_LAYER_SHARED_SRC,           // src_binding
-	    src_sampler,                               // src_sampler
-	    src_image_view,                            // src_image_view
-	    r->gfx.ubo_and_src_descriptor_pool,        // descriptor_pool
-	    r->gfx.layer.shared.descriptor_set_layout, // descriptor_set_layout
-	    out_descriptor_set);                       // out_descriptor_set
+	return do_ubo_alloc_and_batch_write( //
+	    rr,                              // rr
+	    batch,                           // batch
+	    data,                            // ubo_ptr
+	    sizeof(*data),                   // ubo_size
+	    src_sampler,                     // src_sampler
+	    src_image_view,                  // src_image_view
+	    out_descriptor_set);             // out_descriptor_set
 }
 
 XRT_CHECK_RESULT VkResult
 render_gfx_layer_projection_alloc_and_write(struct render_gfx *rr,
+                                            struct render_gfx_layer_batch *batch,
                                             const struct render_gfx_layer_projection_data *data,
                                             VkSampler src_sampler,
                                             VkImageView src_image_view,
                                             VkDescriptorSet *out_descriptor_set)
 {
-	struct render_resources *r = rr->r;
-
-	return do_ubo_and_src_alloc_and_write(         //
-	    rr,                                        // rr
-	    RENDER_BINDING_LAYER_SHARED_UBO,           // ubo_binding
-	    data,                                      // ubo_ptr
-	    sizeof(*data),                             // ubo_size
-	    RENDER_BINDING_LAYER_SHARED_SRC,           // src_binding
-	    src_sampler,                               // src_sampler
-	    src_image_view,                            // src_image_view
-	    r->gfx.ubo_and_src_descriptor_pool,        // descriptor_pool
-	    r->gfx.layer.shared.descriptor_set_layout, // descriptor_set_layout
-	    out_descriptor_set);                       // out_descriptor_set
+	return do_ubo_alloc_and_batch_write( //
+	    rr,                              // rr
+	    batch,                           // batch
+	    data,                            // ubo_ptr
+	    sizeof(*data),                   // ubo_size
+	    src_sampler,                     // src_sampler
+	    src_image_view,                  // src_image_view
+	    out_descriptor_set);             // out_descriptor_set
 }
 
 XRT_CHECK_RESULT VkResult
 render_gfx_layer_quad_alloc_and_write(struct render_gfx *rr,
+                                      struct render_gfx_layer_batch *batch,
                                       const struct render_gfx_layer_quad_data *data,
                                       VkSampler src_sampler,
                                       VkImageView src_image_view,
                                       VkDescriptorSet *out_descriptor_set)
 {
-	struct render_resources *r = rr->r;
-
-	return do_ubo_and_src_alloc_and_write(         //
-	    rr,                                        // rr
-	    RENDER_BINDING_LAYER_SHARED_UBO,           // ubo_binding
-	    data,                                      // ubo_ptr
-	    sizeof(*data),                             // ubo_size
-	    RENDER_BINDING_LAYER_SHARED_SRC,           // src_binding
-	    src_sampler,                               // src_sampler
-	    src_image_view,                            // src_image_view
-	    r->gfx.ubo_and_src_descriptor_pool,        // descriptor_pool
-	    r->gfx.layer.shared.descriptor_set_layout, // descriptor_set_layout
-	    out_descriptor_set);                       // out_descriptor_set
+	return do_ubo_alloc_and_batch_write( //
+	    rr,                              // rr
+	    batch,                           // batch
+	    data,                            // ubo_ptr
+	    sizeof(*data),                   // ubo_size
+	    src_sampler,                     // src_sampler
+	    src_image_view,                  // src_image_view
+	    out_descriptor_set);             // out_descriptor_set
 }
 
 void
 render_gfx_layer_cylinder(struct render_gfx *rr, bool premultiplied_alpha, VkDescriptorSet descriptor_set)
 {
+	if (!deferred_layer_pipelines_ready(rr->rtr->rgrp)) {
+		return; // Not drawn until the pipeline is ready.
+	}
+
 	VkPipeline pipeline =                                          //
 	    premultiplied_alpha                                        //
 	        ? rr->rtr->rgrp->layer.cylinder_premultiplied_alpha    //
@@ -1353,6 +1668,10 @@ render_gfx_layer_cylinder(struct render_gfx *rr, bool premultiplied_alpha, VkDes
 void
 render_gfx_layer_equirect2(struct render_gfx *rr, bool premultiplied_alpha, VkDescriptorSet descriptor_set)
 {
+	if (!deferred_layer_pipelines_ready(rr->rtr->rgrp)) {
+		return; // Not drawn until the pipeline is ready.
+	}
+
 	VkPipeline pipeline =                                           //
 	    premultiplied_alpha                                         //
 	        ? rr->rtr->rgrp->layer.equirect2_premultiplied_alpha    //
@@ -1385,6 +1704,10 @@ render_gfx_layer_projection(struct render_gfx *rr, bool premultiplied_alpha, VkD
 void
 render_gfx_layer_quad(struct render_gfx *rr, bool premultiplied_alpha, VkDescriptorSet descriptor_set)
 {
+	if (!deferred_layer_pipelines_ready(rr->rtr->rgrp)) {
+		return; // Not drawn until the pipeline is ready.
+	}
+
 	VkPipeline pipeline =                                      //
 	    premultiplied_alpha                                    //
 	        ? rr->rtr->rgrp->layer.quad_premultiplied_alpha    //
@@ -74,6 +74,13 @@ extern "C" {
 #define RENDER_MAX_LAYER_RUNS_SIZE (XRT_MAX_VIEWS)
 #define RENDER_MAX_LAYER_RUNS_COUNT (r->view_count)
 
+/*!
+ * Number of tiles along each axis of a view that the layer squasher keeps a
+ * list of contributing layers for, see
+ * @ref render_compute_layer_ubo_data::tile_layer_masks.
+ */
+#define RENDER_LAYER_TILE_GRID (16)
+
 //! How large in pixels the distortion image is.
 #define RENDER_DISTORTION_IMAGE_DIMENSIONS (128)
 
@@ -81,6 +88,13 @@ extern "C" {
 #define RENDER_DISTORTION_IMAGES_SIZE (3 * XRT_MAX_VIEWS)
 #define RENDER_DISTORTION_IMAGES_COUNT (3 * r->view_count)
 
+/*!
+ * Number of timestamp queries in @ref render_resources::query_pool, the first
+ * two are the start and end of all of the work, followed by a start and end
+ * pair for each @ref render_timestamp_phase and view.
+ */
+#define RENDER_TIMESTAMP_QUERY_COUNT (2 + RENDER_TIMESTAMP_PHASE_COUNT * XRT_MAX_VIEWS * 2)
+
 //! Which binding does the layer projection and quad shader has it's UBO on.
 #define RENDER_BINDING_LAYER_SHARED_UBO 0
 
@@ -88,6 +102,43 @@ extern "C" {
 #define RENDER_BINDING_LAYER_SHARED_SRC 1
 
 
+/*
+ *
+ * Enums.
+ *
+ */
+
+/*!
+ * The phases of the compositor work that have their own GPU timestamps, work
+ * that covers all views in a single dispatch is reported on view zero.
+ */
+enum render_timestamp_phase
+{
+	RENDER_TIMESTAMP_PHASE_SQUASH,
+	RENDER_TIMESTAMP_PHASE_DISTORTION,
+	RENDER_TIMESTAMP_PHASE_CLEAR,
+	RENDER_TIMESTAMP_PHASE_MIRROR,
+};
+
+//! Number of values in @ref render_timestamp_phase.
+#define RENDER_TIMESTAMP_PHASE_COUNT (4)
+
+/*!
+ * How the compute layer squasher blends the layers. When all layers blend the
+ * same way a pipeline specialized for that is used, which has no per layer
+ * branch on the blend mode. Must match the `blend_mode` values in layer.comp.
+ */
+enum render_layer_blend_mode
+{
+	//! Read from the UBO per layer, works for any mix of layers.
+	RENDER_LAYER_BLEND_MODE_PER_LAYER = 0,
+	//! All layers have premultiplied alpha.
+	RENDER_LAYER_BLEND_MODE_PREMULTIPLIED = 1,
+	//! All layers have unpremultiplied alpha.
+	RENDER_LAYER_BLEND_MODE_UNPREMULTIPLIED = 2,
+};
+
+
 /*
  *
  * Util functions.
@@ -104,6 +155,18 @@ render_calc_time_warp_matrix(const struct xrt_pose *src_pose,
                              const struct xrt_pose *new_pose,
                              struct xrt_matrix_4x4 *matrix);
 
+/*!
+ * The position of @p new_pose relative to @p src_pose put through the same
+ * projection as @ref render_calc_time_warp_matrix, only the x, y and w rows,
+ * the w row is returned in z. Added to the timewarped ray scaled by the
+ * distance along it, this gives the point seen from the new position.
+ */
+void
+render_calc_time_warp_translation(const struct xrt_pose *src_pose,
+                                  const struct xrt_fov *src_fov,
+                                  const struct xrt_pose *new_pose,
+                                  struct xrt_vec3 *out_translation);
+
 /*!
  * This function constructs a transformation in the form of a normalized rect
  * that lets you go from a UV coordinate on a projection plane to the a point on
@@ -135,6 +198,7 @@ render_calc_uv_to_tangent_lengths_rect(const struct xrt_fov *fov, struct xrt_nor
 struct render_shaders
 {
 	VkShaderModule blit_comp;
+	VkShaderModule camera_convert_comp;
 	VkShaderModule clear_comp;
 	VkShaderModule layer_comp;
 	VkShaderModule distortion_comp;
@@ -378,6 +442,19 @@ struct render_resources
 
 	VkQueryPool query_pool;
 
+	/*!
+	 * Which of the phase timestamp pairs have been written since the
+	 * @ref query_pool was last reset, one bit per phase and view.
+	 */
+	struct
+	{
+		//! Has the pool been reset at least once, writing is invalid before.
+		bool reset;
+
+		uint32_t begun_mask;
+		uint32_t ended_mask;
+	} timestamps;
+
 
 	/*
 	 * Static
@@ -386,6 +463,32 @@ struct render_resources
 	//! Command buffer for recording everything.
 	VkCommandBuffer cmd;
 
+	/*!
+	 * Secondary command buffers for recording the views in parallel, each
+	 * from its own pool as pools can only be used by one thread at a time.
+	 * Reset along with @ref cmd_pool, see @ref render_gfx_secondary_begin.
+	 */
+	struct
+	{
+		VkCommandPool cmd_pools[XRT_MAX_VIEWS];
+
+		VkCommandBuffer cmds[XRT_MAX_VIEWS];
+	} secondary;
+
+	/*!
+	 * Separate command buffer and descriptor pool, used to squash layers
+	 * on one queue while distortion is recorded into @ref cmd and
+	 * submitted on another, see @ref render_compute_init_async.
+	 */
+	struct
+	{
+		VkCommandPool cmd_pool;
+
+		VkCommandBuffer cmd;
+
+		VkDescriptorPool descriptor_pool;
+	} async;
+
 	struct
 	{
 		//! Sampler for mock/null images.
@@ -500,10 +603,29 @@ struct render_resources
 			//! Doesn't depend on target so is static.
 			VkPipeline timewarp_pipeline;
 
+			//! Squashes all views in one dispatch, doesn't depend on target so is static.
+			VkPipeline all_views_non_timewarp_pipeline;
+
+			//! Squashes all views in one dispatch, doesn't depend on target so is static.
+			VkPipeline all_views_timewarp_pipeline;
+
+			/*!
+			 * Pipelines specialized for all layers having the same blend
+			 * mode, created on first use, indexed by all views, timewarp
+			 * and the blend mode minus one.
+			 *
+			 * @see render_resources_get_compute_layer_pipeline
+			 */
+			VkPipeline uniform_blend_pipelines[2][2][2];
+
 			//! Size of combined image sampler array
 			uint32_t image_array_size;
 
-			//! Target info.
+			/*!
+			 * Target info, each holds @ref XRT_MAX_VIEWS of
+			 * @ref render_compute_layer_ubo_data so that the first
+			 * one can be used for all views in a single dispatch.
+			 */
 			struct render_buffer ubos[RENDER_MAX_LAYER_RUNS_SIZE];
 		} layer;
 
@@ -523,6 +645,21 @@ struct render_resources
 
 			//! Target info.
 			struct render_buffer ubo;
+
+			/*!
+			 * Fixed foveation, each 16x16 pixel tile is shaded with
+			 * fewer samples the further out from the center of the
+			 * view it is. Full rate inside of the inner radius,
+			 * half rate inside of the outer radius and quarter rate
+			 * outside of it. Radii are in view normalized [-1, 1]
+			 * space, so 1.0 is the middle of the view edges.
+			 */
+			struct
+			{
+				bool enabled;
+				float inner_radius;
+				float outer_radius;
+			} foveation;
 		} distortion;
 
 		struct
@@ -553,6 +690,12 @@ struct render_resources
 
 		//! Whether distortion images have been pre-rotated 90 degrees.
 		bool pre_rotated;
+
+		//! Format of the distortion images, full or half float UVs.
+		VkFormat format;
+
+		//! Size of the images added to the @ref vk_memory_budget.
+		VkDeviceSize tracked_size;
 	} distortion;
 };
 
@@ -577,6 +720,20 @@ render_resources_init(struct render_resources *r,
 void
 render_resources_close(struct render_resources *r);
 
+/*!
+ * Get the compute layer squasher pipeline for the given configuration. The
+ * pipelines for a uniform @p blend_mode are created on first use, through the
+ * pipeline cache so they are persisted with it. Falls back to the per layer
+ * blend pipeline if creation fails.
+ *
+ * @public @memberof render_resources
+ */
+VkPipeline
+render_resources_get_compute_layer_pipeline(struct render_resources *r,
+                                            bool all_views,
+                                            bool do_timewarp,
+                                            enum render_layer_blend_mode blend_mode);
+
 /*!
  * Creates or recreates the compute distortion textures if necessary.
  */
@@ -622,6 +779,52 @@ render_resources_get_timestamps(struct render_resources *r, uint64_t *out_gpu_st
 bool
 render_resources_get_duration(struct render_resources *r, uint64_t *out_gpu_duration_ns);
 
+/*!
+ * Start and end of each phase of the latest GPU work, filled in by
+ * @ref render_resources_get_phase_timestamps.
+ */
+struct render_phase_timestamps
+{
+	//! One bit per phase and view, `1 << (phase * XRT_MAX_VIEWS + view)`.
+	uint32_t valid_mask;
+
+	uint64_t gpu_start_ns[RENDER_TIMESTAMP_PHASE_COUNT][XRT_MAX_VIEWS];
+	uint64_t gpu_end_ns[RENDER_TIMESTAMP_PHASE_COUNT][XRT_MAX_VIEWS];
+};
+
+/*!
+ * Reset all of the timestamp queries, must be recorded before any of the
+ * timestamps can be written. Done by @ref render_gfx_begin and
+ * @ref render_compute_begin.
+ *
+ * @public @memberof render_resources
+ */
+void
+render_resources_cmd_reset_timestamps(struct render_resources *r, VkCommandBuffer cmd);
+
+/*!
+ * Write the start (@p end false) or end timestamp of a phase, does nothing if
+ * the pool hasn't been reset or the timestamp has already been written.
+ *
+ * @public @memberof render_resources
+ */
+void
+render_resources_cmd_write_phase_timestamp(struct render_resources *r,
+                                           VkCommandBuffer cmd,
+                                           enum render_timestamp_phase phase,
+                                           uint32_t view_index,
+                                           bool end);
+
+/*!
+ * Returns the timestamps of the phases of the latest GPU work, only phases
+ * that where recorded have their bit set in the valid mask. Same time domain
+ * and limitations as @ref render_resources_get_timestamps.
+ *
+ * @public @memberof render_resources
+ */
+bool
+render_resources_get_phase_timestamps(struct render_resources *r, struct render_phase_timestamps *out_rpt);
+
 
 /*
  *
@@ -734,6 +937,24 @@ struct render_gfx_render_pass
 		VkPipeline quad_premultiplied_alpha;
 		VkPipeline quad_unpremultiplied_alpha;
 	} layer;
+
+	/*!
+	 * The cylinder, equirect2 and quad layer pipelines are not needed to
+	 * get the first frame out, so they are created on this thread while
+	 * the compositor starts rendering. See @ref render_gfx_layer_quad for
+	 * what happens to those layers until they are ready. Projection layers
+	 * and the distortion mesh are always created in init.
+	 */
+	struct
+	{
+		struct os_thread_helper oth;
+
+		//! Was the thread started, if not the pipelines were created in init.
+		bool started;
+
+		//! Are the pipelines created, protected by the thread helper's lock.
+		bool ready;
+	} deferred;
 };
 
 /*!
@@ -825,6 +1046,46 @@ struct render_gfx
 
 	//! The current target we are rendering too, can change during command building.
 	struct render_gfx_target_resources *rtr;
+
+	/*!
+	 * Command buffer draws are recorded into, @ref render_resources::cmd
+	 * or the secondary one of a view, see @ref render_gfx_secondary_begin.
+	 */
+	VkCommandBuffer cmd;
+
+	/*!
+	 * State last bound on the command buffer, reset in @ref render_gfx_begin.
+	 * Views and layers are mostly drawn with the same pipeline and mesh
+	 * buffers, this lets us skip binding them again for every draw.
+	 */
+	struct
+	{
+		VkPipeline pipeline;
+		bool mesh_buffers;
+	} bound;
+};
+
+/*!
+ * Descriptor sets for all of the layers drawn in a frame, allocated with one
+ * call to the driver and written with one call, instead of one pair of calls
+ * per layer per view.
+ *
+ * @see render_gfx_layer_batch_alloc
+ */
+struct render_gfx_layer_batch
+{
+	//! Number of descriptor sets allocated.
+	uint32_t allocated_count;
+
+	//! Number of descriptor sets handed out and queued for writing.
+	uint32_t count;
+
+	VkDescriptorSet descriptor_sets[RENDER_MAX_IMAGES_SIZE];
+
+	//! Storage for the queued writes, two per descriptor set.
+	VkDescriptorImageInfo image_infos[RENDER_MAX_IMAGES_SIZE];
+	VkDescriptorBufferInfo buffer_infos[RENDER_MAX_IMAGES_SIZE];
+	VkWriteDescriptorSet writes[RENDER_MAX_IMAGES_SIZE * 2];
 };
 
 /*!
@@ -852,6 +1113,15 @@ render_gfx_begin(struct render_gfx *rr);
 bool
 render_gfx_end(struct render_gfx *rr);
 
+/*!
+ * Write the start or end timestamp of @p phase for @p view_index, see
+ * @ref render_resources_cmd_write_phase_timestamp.
+ *
+ * @public @memberof render_gfx
+ */
+void
+render_gfx_write_timestamp(struct render_gfx *rr, enum render_timestamp_phase phase, uint32_t view_index, bool end);
+
 /*!
  * Frees all resources held by the rendering, does not free the struct itself.
  *
@@ -951,6 +1221,52 @@ render_gfx_begin_target(struct render_gfx *rr, struct render_gfx_target_resource
 void
 render_gfx_end_target(struct render_gfx *rr);
 
+/*!
+ * Same as @ref render_gfx_begin_target but the contents of the render pass
+ * come from secondary command buffers, recorded with
+ * @ref render_gfx_secondary_begin and added with
+ * @ref render_gfx_execute_secondary, end with @ref render_gfx_end_target.
+ *
+ * @public @memberof render_gfx
+ */
+bool
+render_gfx_begin_target_secondary(struct render_gfx *rr,
+                                  struct render_gfx_target_resources *rtr,
+                                  const VkClearColorValue *color);
+
+/*!
+ * Add the secondary command buffer of the view to the current target, must
+ * have been begun with @ref render_gfx_begin_target_secondary.
+ *
+ * @public @memberof render_gfx
+ */
+void
+render_gfx_execute_secondary(struct render_gfx *rr, uint32_t view_index);
+
+/*!
+ * Begin recording the secondary command buffer of a view into @p out_view_rr,
+ * continuing the render pass of @p rtr. The view render_gfx can be used with
+ * @ref render_gfx_begin_view and the draw functions on any thread, each view
+ * has its own command pool. It shares the UBOs and descriptor sets with
+ * @p rr so they need to be allocated and written before. Call
+ * @ref render_gfx_secondary_end when done.
+ *
+ * @public @memberof render_gfx
+ */
+bool
+render_gfx_secondary_begin(struct render_gfx *rr,
+                           uint32_t view_index,
+                           struct render_gfx_target_resources *rtr,
+                           struct render_gfx *out_view_rr);
+
+/*!
+ * End the secondary command buffer begun with @ref render_gfx_secondary_begin.
+ *
+ * @public @memberof render_gfx
+ */
+bool
+render_gfx_secondary_end(struct render_gfx *view_rr);
+
 /*!
  * @public @memberof render_gfx
  */
@@ -990,52 +1306,79 @@ void
 render_gfx_mesh_draw(struct render_gfx *rr, uint32_t mesh_index, VkDescriptorSet descriptor_set, bool do_timewarp);
 
 /*!
- * Allocate and write a UBO and descriptor_set to be used for cylinder layer
- * rendering, the content of @p data need to be valid at the time of the call.
+ * Allocate @p count layer descriptor sets in one call, they are then handed
+ * out and written by the render_gfx_layer_*_alloc_and_write functions. Use
+ * @ref render_gfx_layer_batch_flush to write all of them before recording any
+ * draws that use them.
+ *
+ * @public @memberof render_gfx
+ */
+XRT_CHECK_RESULT VkResult
+render_gfx_layer_batch_alloc(struct render_gfx *rr, uint32_t count, struct render_gfx_layer_batch *batch);
+
+/*!
+ * Issue all of the queued up descriptor writes of @p batch in one call.
+ *
+ * @public @memberof render_gfx
+ */
+void
+render_gfx_layer_batch_flush(struct render_gfx *rr, struct render_gfx_layer_batch *batch);
+
+/*!
+ * Allocate and write a UBO, and take and queue the write of a descriptor_set
+ * from @p batch, to be used for cylinder layer rendering. The content of
+ * @p data need to be valid at the time of the call.
  *
  * @public @memberof render_gfx
  */
 XRT_CHECK_RESULT VkResult
 render_gfx_layer_cylinder_alloc_and_write(struct render_gfx *rr,
+                                          struct render_gfx_layer_batch *batch,
                                           const struct render_gfx_layer_cylinder_data *data,
                                           VkSampler src_sampler,
                                           VkImageView src_image_view,
                                           VkDescriptorSet *out_descriptor_set);
 
 /*!
- * Allocate and write a UBO and descriptor_set to be used for equirect2 layer
- * rendering, the content of @p data need to be valid at the time of the call.
+ * Allocate and write a UBO, and take and queue the write of a descriptor_set
+ * from @p batch, to be used for equirect2 layer rendering. The content of
+ * @p data need to be valid at the time of the call.
  *
  * @public @memberof render_gfx
  */
 XRT_CHECK_RESULT VkResult
 render_gfx_layer_equirect2_alloc_and_write(struct render_gfx *rr,
+                                           struct render_gfx_layer_batch *batch,
                                            const struct render_gfx_layer_equirect2_data *data,
                                            VkSampler src_sampler,
                                            VkImageView src_image_view,
                                            VkDescriptorSet *out_descriptor_set);
 
 /*!
- * Allocate and write a UBO and descriptor_set to be used for projection layer
- * rendering, the content of @p data need to be valid at the time of the call.
+ * Allocate and write a UBO, and take and queue the write of a descriptor_set
+ * from @p batch, to be used for projection layer rendering. The content of
+ * @p data need to be valid at the time of the call.
  *
  * @public @memberof render_gfx
  */
 XRT_CHECK_RESULT VkResult
 render_gfx_layer_projection_alloc_and_write(struct render_gfx *rr,
+                                            struct render_gfx_layer_batch *batch,
                                             const struct render_gfx_layer_projection_data *data,
                                             VkSampler src_sampler,
                                             VkImageView src_image_view,
                                             VkDescriptorSet *out_descriptor_set);
 
 /*!
- * Allocate and write a UBO and descriptor_set to be used for quad layer
- * rendering, the content of @p data need to be valid at the time of the call.
+ * Allocate and write a UBO, and take and queue the write of a descriptor_set
+ * from @p batch, to be used for quad layer rendering. The content of
+ * @p data need to be valid at the time of the call.
  *
  * @public @memberof render_gfx
  */
 XRT_CHECK_RESULT VkResult
 render_gfx_layer_quad_alloc_and_write(struct render_gfx *rr,
+                                      struct render_gfx_layer_batch *batch,
                                       const struct render_gfx_layer_quad_data *data,
                                       VkSampler src_sampler,
                                       VkImageView src_image_view,
@@ -1046,6 +1389,8 @@ render_gfx_layer_quad_alloc_and_write(struct render_gfx *rr,
  * allocate @p descriptor_set and ubo with
  * @ref render_gfx_layer_cylinder_alloc_and_write.
  *
+ * Not drawn until the pipeline is ready, see @ref render_gfx_layer_quad.
+ *
  * @public @memberof render_gfx
  */
 void
@@ -1056,6 +1401,8 @@ render_gfx_layer_cylinder(struct render_gfx *rr, bool premultiplied_alpha, VkDes
  * allocate @p descriptor_set and ubo with
  * @ref render_gfx_layer_equirect2_alloc_and_write.
  *
+ * Not drawn until the pipeline is ready, see @ref render_gfx_layer_quad.
+ *
  * @public @memberof render_gfx
  */
 void
@@ -1075,6 +1422,11 @@ render_gfx_layer_projection(struct render_gfx *rr, bool premultiplied_alpha, VkD
  * Dispatch a quad layer shader into the current target and view, allocate
  * @p descriptor_set and ubo with @ref render_gfx_layer_quad_alloc_and_write.
  *
+ * The pipeline is created in the background, see
+ * @ref render_gfx_render_pass::deferred, until it is ready the layer is not
+ * drawn. Layers under it still show and it pops in a few frames later,
+ * which is better than holding off the first frame for it.
+ *
  * @public @memberof render_gfx
  */
 void
@@ -1101,6 +1453,18 @@ struct render_compute
 	//! Shared resources.
 	struct render_resources *r;
 
+	//! Command buffer that everything is recorded into, owned by @ref r.
+	VkCommandBuffer cmd;
+
+	//! Pool that @ref cmd comes from, reset by @ref render_compute_begin.
+	VkCommandPool cmd_pool;
+
+	//! Pool that the descriptor sets come from, reset by @ref render_compute_close.
+	VkDescriptorPool descriptor_pool;
+
+	//! Should GPU timestamps be written into @ref render_resources::query_pool.
+	bool timestamps;
+
 	//! Layer descriptor set.
 	VkDescriptorSet layer_descriptor_sets[RENDER_MAX_LAYER_RUNS_SIZE];
 
@@ -1110,6 +1474,20 @@ struct render_compute
 	 * @ref render_compute_projection, and @ref render_compute_clear.
 	 */
 	VkDescriptorSet shared_descriptor_set;
+
+	/*!
+	 * Source poses and fovs given to the last call of
+	 * @ref render_compute_projection_timewarp, used to rewrite the timewarp
+	 * matrices in @ref render_compute_late_latch_timewarp.
+	 */
+	struct
+	{
+		//! Has a timewarp been recorded since @ref render_compute_begin.
+		bool valid;
+
+		struct xrt_pose src_poses[XRT_MAX_VIEWS];
+		struct xrt_fov src_fovs[XRT_MAX_VIEWS];
+	} late_latch;
 };
 
 /*!
@@ -1147,12 +1525,12 @@ struct render_compute_layer_ubo_data
 		uint32_t padding[XRT_MAX_VIEWS];
 	} layer_type[RENDER_MAX_LAYERS];
 
-	//! Which image/sampler(s) correspond to each layer.
+	//! Which image/sampler(s) correspond to each layer: color, depth and motion vectors.
 	struct
 	{
-		uint32_t images[XRT_MAX_VIEWS];
-		//! @todo Implement separated samplers and images (and change to samplers[2])
-		uint32_t padding[XRT_MAX_VIEWS];
+		uint32_t images[3];
+		//! @todo Implement separated samplers and images (and change to samplers[3])
+		uint32_t padding;
 	} images_samplers[RENDER_MAX_LAYERS];
 
 	//! Shared between cylinder and equirect2.
@@ -1214,6 +1592,59 @@ struct render_compute_layer_ubo_data
 		struct xrt_vec2 val;
 		float padding[XRT_MAX_VIEWS];
 	} quad_extent[RENDER_MAX_LAYERS];
+
+
+	/*!
+	 * Per tile layer lists
+	 */
+
+	//! Size of each tile in pixels, always a multiple of the workgroup size.
+	struct
+	{
+		uint32_t size_x;
+		uint32_t size_y;
+		uint32_t count_x;
+		uint32_t count_y;
+	} tiles;
+
+	//! One bit per layer for each tile, set if the layer may contribute to any pixel in it.
+	uint32_t tile_layer_masks[RENDER_LAYER_TILE_GRID * RENDER_LAYER_TILE_GRID];
+
+
+	/*!
+	 * For space warp projection layers
+	 */
+
+	//! Sub image of the motion vector image.
+	struct xrt_normalized_rect mv_post_transforms[RENDER_MAX_LAYERS];
+
+	//! Motion vector to layer uv scale, times the frames to extrapolate, zero disables it.
+	struct
+	{
+		struct xrt_vec2 val;
+		float padding[XRT_MAX_VIEWS];
+	} space_warp_scale[RENDER_MAX_LAYERS];
+
+
+	/*!
+	 * For positional reprojection of depth projection layers
+	 */
+
+	//! Depth to inverse linear depth.
+	struct
+	{
+		float inv_near;
+		float inv_far_minus_inv_near;
+		float min_depth;
+		float inv_depth_range;
+	} depth_data[RENDER_MAX_LAYERS];
+
+	//! See @ref render_calc_time_warp_translation, zero disables it.
+	struct
+	{
+		struct xrt_vec3 val;
+		float padding;
+	} depth_translation[RENDER_MAX_LAYERS];
 };
 
 /*!
@@ -1227,6 +1658,15 @@ struct render_compute_distortion_ubo_data
 	struct xrt_normalized_rect pre_transforms[XRT_MAX_VIEWS];
 	struct xrt_normalized_rect post_transforms[XRT_MAX_VIEWS];
 	struct xrt_matrix_4x4 transforms[XRT_MAX_VIEWS];
+
+	//! Inner and outer foveation radius, in view normalized [-1, 1] space.
+	float foveation_radii[2];
+
+	//! Non-zero if foveated distortion is enabled.
+	uint32_t foveation_enabled;
+
+	//! Keeps the size a multiple of 16 bytes as std140 requires.
+	uint32_t _padding;
 };
 
 /*!
@@ -1237,6 +1677,17 @@ struct render_compute_distortion_ubo_data
 bool
 render_compute_init(struct render_compute *crc, struct render_resources *r);
 
+/*!
+ * Same as @ref render_compute_init but records into the resources in
+ * @ref render_resources::async, this lets the command buffer stay in flight
+ * while another @ref render_compute is recorded and submitted. Does not write
+ * any GPU timestamps.
+ *
+ * @public @memberof render_compute
+ */
+bool
+render_compute_init_async(struct render_compute *crc, struct render_resources *r);
+
 /*!
  * Frees all resources held by the compute rendering, does not free the struct itself.
  *
@@ -1263,6 +1714,18 @@ render_compute_begin(struct render_compute *crc);
 bool
 render_compute_end(struct render_compute *crc);
 
+/*!
+ * Write the start or end timestamp of @p phase for @p view_index, does nothing
+ * if this @ref render_compute doesn't write timestamps.
+ *
+ * @public @memberof render_compute
+ */
+void
+render_compute_write_timestamp(struct render_compute *crc,
+                               enum render_timestamp_phase phase,
+                               uint32_t view_index,
+                               bool end);
+
 /*!
  * Updates the given @p descriptor_set and dispatches the layer shader. Unlike
  * other dispatch functions below this function doesn't do any layer barriers
@@ -1284,7 +1747,32 @@ render_compute_layers(struct render_compute *crc,                          //
                       uint32_t num_srcs,                                   //
                       VkImageView target_image_view,                       //
                       const struct render_viewport_data *view,             //
-                      bool timewarp);                                      //
+                      bool timewarp,                                       //
+                      enum render_layer_blend_mode blend_mode);            //
+
+/*!
+ * Same as @ref render_compute_layers but squashes all views in a single
+ * dispatch. The @p ubo must hold one @ref render_compute_layer_ubo_data per
+ * view, and the sources of all views are packed into one array.
+ *
+ * Expected layouts:
+ * * Source images: VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+ * * Target images: VK_IMAGE_LAYOUT_GENERAL
+ *
+ * @public @memberof render_compute
+ */
+void
+render_compute_layers_all_views(struct render_compute *crc,                             //
+                                VkDescriptorSet descriptor_set,                         //
+                                VkBuffer ubo,                                           //
+                                VkSampler src_samplers[RENDER_MAX_IMAGES_SIZE],         //
+                                VkImageView src_image_views[RENDER_MAX_IMAGES_SIZE],    //
+                                uint32_t num_srcs,                                      //
+                                VkImageView target_image_views[XRT_MAX_VIEWS],          //
+                                const struct render_viewport_data views[XRT_MAX_VIEWS], //
+                                uint32_t view_count,                                    //
+                                bool timewarp,                                          //
+                                enum render_layer_blend_mode blend_mode);               //
 
 /*!
  * @public @memberof render_compute
@@ -1301,6 +1789,18 @@ render_compute_projection_timewarp(struct render_compute *crc,
                                    VkImageView target_image_view,
                                    const struct render_viewport_data views[XRT_MAX_VIEWS]);
 
+/*!
+ * Recalculate the timewarp matrices of the last
+ * @ref render_compute_projection_timewarp using @p new_poses, does nothing if
+ * no timewarp was recorded. The UBO is persistently mapped and coherent, so
+ * this can be called after the command buffer has been recorded and right
+ * before it is submitted to use the freshest pose possible.
+ *
+ * @public @memberof render_compute
+ */
+void
+render_compute_late_latch_timewarp(struct render_compute *crc, const struct xrt_pose new_poses[XRT_MAX_VIEWS]);
+
 /*!
  * @public @memberof render_compute
  */
@@ -199,9 +199,10 @@ create_compute_layer_descriptor_set_layout(struct vk_bundle *vk,
 	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
 	    },
 	    {
+	        // One target per view for the all views pipelines.
 	        .binding = target_binding,
 	        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-	        .descriptorCount = 1,
+	        .descriptorCount = XRT_MAX_VIEWS,
 	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
 	    },
 	    {
@@ -293,6 +294,8 @@ struct compute_layer_params
 	VkBool32 do_color_correction;
 	uint32_t max_layers;
 	uint32_t image_array_size;
+	VkBool32 do_all_views;
+	uint32_t blend_mode;
 };
 
 struct compute_distortion_params
@@ -321,6 +324,8 @@ create_compute_layer_pipeline(struct vk_bundle *vk,
 	    ENTRY(2, do_color_correction), //
 	    ENTRY(3, max_layers),          //
 	    ENTRY(4, image_array_size),    //
+	    ENTRY(5, do_all_views),        //
+	    ENTRY(6, blend_mode),          //
 	};
 #undef ENTRY
 
@@ -670,8 +675,9 @@ render_resources_init(struct render_resources *r,
 	 * Shared
 	 */
 
-	ret = vk_create_pipeline_cache(vk, &r->pipeline_cache);
-	VK_CHK_WITH_RET(ret, "vk_create_pipeline_cache", false);
+	// Seeded from disk so pipelines don't need to be compiled on each start.
+	ret = vk_create_pipeline_cache_from_disk(vk, &r->pipeline_cache);
+	VK_CHK_WITH_RET(ret, "vk_create_pipeline_cache_from_disk", false);
 
 	VK_NAME_PIPELINE_CACHE(vk, r->pipeline_cache, "render_resources pipeline cache");
 
@@ -690,6 +696,40 @@ render_resources_init(struct render_resources *r,
 
 	VK_NAME_COMMAND_BUFFER(vk, r->cmd, "render_resources command buffer");
 
+	ret = vk->vkCreateCommandPool(vk->device, &command_pool_info, NULL, &r->async.cmd_pool);
+	VK_CHK_WITH_RET(ret, "vkCreateCommandPool", false);
+
+	VK_NAME_COMMAND_POOL(vk, r->async.cmd_pool, "render_resources async command pool");
+
+	cmd_buffer_info.commandPool = r->async.cmd_pool;
+
+	ret = vk->vkAllocateCommandBuffers( //
+	    vk->device,                     // device
+	    &cmd_buffer_info,               // pAllocateInfo
+	    &r->async.cmd);                 // pCommandBuffers
+	VK_CHK_WITH_RET(ret, "vkAllocateCommandBuffers", false);
+
+	VK_NAME_COMMAND_BUFFER(vk, r->async.cmd, "render_resources async command buffer");
+
+	cmd_buffer_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+
+	for (uint32_t i = 0; i < r->view_count; i++) {
+		ret = vk->vkCreateCommandPool(vk->device, &command_pool_info, NULL, &r->secondary.cmd_pools[i]);
+		VK_CHK_WITH_RET(ret, "vkCreateCommandPool", false);
+
+		VK_NAME_COMMAND_POOL(vk, r->secondary.cmd_pools[i], "render_resources secondary command pool");
+
+		cmd_buffer_info.commandPool = r->secondary.cmd_pools[i];
+
+		ret = vk->vkAllocateCommandBuffers( //
+		    vk->device,                     // device
+		    &cmd_buffer_info,               // pAllocateInfo
+		    &r->secondary.cmds[i]);         // pCommandBuffers
+		VK_CHK_WITH_RET(ret, "vkAllocateCommandBuffers", false);
+
+		VK_NAME_COMMAND_BUFFER(vk, r->secondary.cmds[i], "render_resources secondary command buffer");
+	}
+
 
 	/*
 	 * Gfx.
@@ -837,7 +877,7 @@ render_resources_init(struct render_resources *r,
 	    .uniform_per_descriptor_count = 1,
 	    // layer images
 	    .sampler_per_descriptor_count = r->compute.layer.image_array_size + RENDER_DISTORTION_IMAGES_COUNT,
-	    .storage_image_per_descriptor_count = 1,
+	    .storage_image_per_descriptor_count = XRT_MAX_VIEWS, // One per view for layers.
 	    .storage_buffer_per_descriptor_count = 0,
 	    .descriptor_count = compute_descriptor_count,
 	    .freeable = false,
@@ -851,6 +891,14 @@ render_resources_init(struct render_resources *r,
 
 	VK_NAME_DESCRIPTOR_POOL(vk, r->compute.descriptor_pool, "render_resources compute descriptor pool");
 
+	ret = vk_create_descriptor_pool(  //
+	    vk,                           // vk_bundle
+	    &compute_pool_info,           // info
+	    &r->async.descriptor_pool);   // out_descriptor_pool
+	VK_CHK_WITH_RET(ret, "vk_create_descriptor_pool", false);
+
+	VK_NAME_DESCRIPTOR_POOL(vk, r->async.descriptor_pool, "render_resources async descriptor pool");
+
 	/*
 	 * Layer pipeline
 	 */
@@ -880,6 +928,7 @@ render_resources_init(struct render_resources *r,
 	    .do_color_correction = true,
 	    .max_layers = RENDER_MAX_LAYERS,
 	    .image_array_size = r->compute.layer.image_array_size,
+	    .do_all_views = false,
 	};
 
 	ret = create_compute_layer_pipeline(          //
@@ -899,6 +948,7 @@ render_resources_init(struct render_resources *r,
 	    .do_color_correction = true,
 	    .max_layers = RENDER_MAX_LAYERS,
 	    .image_array_size = r->compute.layer.image_array_size,
+	    .do_all_views = false,
 	};
 
 	ret = create_compute_layer_pipeline(      //
@@ -912,7 +962,38 @@ render_resources_init(struct render_resources *r,
 
 	VK_NAME_PIPELINE(vk, r->compute.layer.timewarp_pipeline, "render_resources compute layer timewarp pipeline");
 
-	size_t layer_ubo_size = sizeof(struct render_compute_layer_ubo_data);
+	struct compute_layer_params layer_all_views_params = layer_params;
+	layer_all_views_params.do_all_views = true;
+
+	ret = create_compute_layer_pipeline(                    //
+	    vk,                                                 // vk_bundle
+	    r->pipeline_cache,                                  // pipeline_cache
+	    r->shaders->layer_comp,                             // shader
+	    r->compute.layer.pipeline_layout,                   // pipeline_layout
+	    &layer_all_views_params,                            // params
+	    &r->compute.layer.all_views_non_timewarp_pipeline); // out_compute_pipeline
+	VK_CHK_WITH_RET(ret, "create_compute_layer_pipeline", false);
+
+	VK_NAME_PIPELINE(vk, r->compute.layer.all_views_non_timewarp_pipeline,
+	                 "render_resources compute layer all views non timewarp pipeline");
+
+	struct compute_layer_params layer_all_views_timewarp_params = layer_timewarp_params;
+	layer_all_views_timewarp_params.do_all_views = true;
+
+	ret = create_compute_layer_pipeline(                //
+	    vk,                                             // vk_bundle
+	    r->pipeline_cache,                              // pipeline_cache
+	    r->shaders->layer_comp,                         // shader
+	    r->compute.layer.pipeline_layout,               // pipeline_layout
+	    &layer_all_views_timewarp_params,               // params
+	    &r->compute.layer.all_views_timewarp_pipeline); // out_compute_pipeline
+	VK_CHK_WITH_RET(ret, "create_compute_layer_pipeline", false);
+
+	VK_NAME_PIPELINE(vk, r->compute.layer.all_views_timewarp_pipeline,
+	                 "render_resources compute layer all views timewarp pipeline");
+
+	// Room for all views, so the first one can be used to squash all views at once.
+	size_t layer_ubo_size = sizeof(struct render_compute_layer_ubo_data) * XRT_MAX_VIEWS;
 
 	for (uint32_t i = 0; i < r->view_count; i++) {
 		ret = render_buffer_init(      //
@@ -1061,8 +1142,8 @@ render_resources_init(struct render_resources *r,
 	    .pNext = NULL,
 	    .flags = 0, // Reserved.
 	    .queryType = VK_QUERY_TYPE_TIMESTAMP,
-	    .queryCount = 2,         // Start & end
-	    .pipelineStatistics = 0, // Not used.
+	    .queryCount = RENDER_TIMESTAMP_QUERY_COUNT, // Start & end, then phases.
+	    .pipelineStatistics = 0,                    // Not used.
 	};
 
 	vk->vkCreateQueryPool( //
@@ -1109,6 +1190,8 @@ render_resources_close(struct render_resources *r)
 
 	D(DescriptorSetLayout, r->mesh.descriptor_set_layout);
 	D(PipelineLayout, r->mesh.pipeline_layout);
+	// Includes any pipelines created after init, like the per target ones.
+	vk_save_pipeline_cache(vk, r->pipeline_cache);
 	D(PipelineCache, r->pipeline_cache);
 	D(QueryPool, r->query_pool);
 	render_buffer_close(vk, &r->mesh.vbo);
@@ -1118,10 +1201,19 @@ render_resources_close(struct render_resources *r)
 	}
 
 	D(DescriptorPool, r->compute.descriptor_pool);
+	D(DescriptorPool, r->async.descriptor_pool);
 
 	D(DescriptorSetLayout, r->compute.layer.descriptor_set_layout);
 	D(Pipeline, r->compute.layer.non_timewarp_pipeline);
 	D(Pipeline, r->compute.layer.timewarp_pipeline);
+	D(Pipeline, r->compute.layer.all_views_non_timewarp_pipeline);
+	D(Pipeline, r->compute.layer.all_views_timewarp_pipeline);
+	for (uint32_t i = 0; i < 2; i++) {
+		for (uint32_t k = 0; k < 2; k++) {
+			D(Pipeline, r->compute.layer.uniform_blend_pipelines[i][k][0]);
+			D(Pipeline, r->compute.layer.uniform_blend_pipelines[i][k][1]);
+		}
+	}
 	D(PipelineLayout, r->compute.layer.pipeline_layout);
 
 	D(DescriptorSetLayout, r->compute.distortion.descriptor_set_layout);
@@ -1139,12 +1231,70 @@ render_resources_close(struct render_resources *r)
 	render_buffer_close(vk, &r->compute.distortion.ubo);
 
 	vk_cmd_pool_destroy(vk, &r->distortion_pool);
+	for (uint32_t i = 0; i < ARRAY_SIZE(r->secondary.cmd_pools); i++) {
+		D(CommandPool, r->secondary.cmd_pools[i]);
+	}
+	D(CommandPool, r->async.cmd_pool);
 	D(CommandPool, r->cmd_pool);
 
 	// Finally forget about the vk bundle. We do not own it!
 	r->vk = NULL;
 }
 
+VkPipeline
+render_resources_get_compute_layer_pipeline(struct render_resources *r,
+                                            bool all_views,
+                                            bool do_timewarp,
+                                            enum render_layer_blend_mode blend_mode)
+{
+	struct vk_bundle *vk = r->vk;
+	VkResult ret;
+
+	VkPipeline fallback;
+	if (all_views) {
+		fallback = do_timewarp ? r->compute.layer.all_views_timewarp_pipeline
+		                       : r->compute.layer.all_views_non_timewarp_pipeline;
+	} else {
+		fallback = do_timewarp ? r->compute.layer.timewarp_pipeline : r->compute.layer.non_timewarp_pipeline;
+	}
+
+	if (blend_mode == RENDER_LAYER_BLEND_MODE_PER_LAYER) {
+		return fallback;
+	}
+
+	VkPipeline *pipeline_ptr =
+	    &r->compute.layer.uniform_blend_pipelines[all_views ? 1 : 0][do_timewarp ? 1 : 0][blend_mode - 1];
+	if (*pipeline_ptr != VK_NULL_HANDLE) {
+		return *pipeline_ptr;
+	}
+
+	struct compute_layer_params params = {
+	    .do_timewarp = do_timewarp,
+	    .do_color_correction = true,
+	    .max_layers = RENDER_MAX_LAYERS,
+	    .image_array_size = r->compute.layer.image_array_size,
+	    .do_all_views = all_views,
+	    .blend_mode = blend_mode,
+	};
+
+	ret = create_compute_layer_pipeline(  //
+	    vk,                               // vk_bundle
+	    r->pipeline_cache,                // pipeline_cache
+	    r->shaders->layer_comp,           // shader
+	    r->compute.layer.pipeline_layout, // pipeline_layout
+	    &params,                          // params
+	    pipeline_ptr);                    // out_compute_pipeline
+	if (ret != VK_SUCCESS) {
+		VK_WARN(vk, "create_compute_layer_pipeline: %s, using per layer blend pipeline", vk_result_string(ret));
+		*pipeline_ptr = VK_NULL_HANDLE;
+		return fallback;
+	}
+
+	VK_NAME_PIPELINE(vk, *pipeline_ptr, "render_resources compute layer uniform blend pipeline");
+
+	return *pipeline_ptr;
+}
+
 bool
 render_resources_get_timestamps(struct render_resources *r, uint64_t *out_gpu_start_ns, uint64_t *out_gpu_end_ns)
 {
@@ -1236,6 +1386,134 @@ render_resources_get_duration(struct render_resources *r, uint64_t *out_gpu_dura
 	return true;
 }
 
+void
+render_resources_cmd_reset_timestamps(struct render_resources *r, VkCommandBuffer cmd)
+{
+	struct vk_bundle *vk = r->vk;
+
+	vk->vkCmdResetQueryPool(           //
+	    cmd,                           // commandBuffer
+	    r->query_pool,                 // queryPool
+	    0,                             // firstQuery
+	    RENDER_TIMESTAMP_QUERY_COUNT); // queryCount
+
+	r->timestamps.reset = true;
+	r->timestamps.begun_mask = 0;
+	r->timestamps.ended_mask = 0;
+}
+
+void
+render_resources_cmd_write_phase_timestamp(struct render_resources *r,
+                                           VkCommandBuffer cmd,
+                                           enum render_timestamp_phase phase,
+                                           uint32_t view_index,
+                                           bool end)
+{
+	struct vk_bundle *vk = r->vk;
+
+	assert(phase < RENDER_TIMESTAMP_PHASE_COUNT);
+	assert(view_index < XRT_MAX_VIEWS);
+
+	uint32_t index = phase * XRT_MAX_VIEWS + view_index;
+	uint32_t bit = 1u << index;
+	uint32_t *mask = end ? &r->timestamps.ended_mask : &r->timestamps.begun_mask;
+
+	// Writing a query twice without a reset is invalid, so is ending before starting.
+	if (!r->timestamps.reset || (*mask & bit) != 0 || (end && (r->timestamps.begun_mask & bit) == 0)) {
+		return;
+	}
+
+	VkPipelineStageFlagBits stage = end ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+	vk->vkCmdWriteTimestamp(            //
+	    cmd,                            // commandBuffer
+	    stage,                          // pipelineStage
+	    r->query_pool,                  // queryPool
+	    2 + index * 2 + (end ? 1 : 0)); // query
+
+	*mask |= bit;
+}
+
+bool
+render_resources_get_phase_timestamps(struct render_resources *r, struct render_phase_timestamps *out_rpt)
+{
+	struct vk_bundle *vk = r->vk;
+	VkResult ret = VK_SUCCESS;
+
+	// Simple pre-check, needed by vk_convert_timestamps_to_host_ns.
+	if (!vk->has_EXT_calibrated_timestamps) {
+		return false;
+	}
+
+	uint32_t valid_mask = r->timestamps.begun_mask & r->timestamps.ended_mask;
+	if (valid_mask == 0) {
+		return false;
+	}
+
+
+	/*
+	 * Query only the pairs that where written, waiting on a query that
+	 * was never written would never return.
+	 */
+
+	VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT;
+	uint64_t timestamps[RENDER_TIMESTAMP_PHASE_COUNT * XRT_MAX_VIEWS * 2] = {0};
+	uint32_t count = 0;
+
+	for (uint32_t index = 0; index < RENDER_TIMESTAMP_PHASE_COUNT * XRT_MAX_VIEWS; index++) {
+		if ((valid_mask & (1u << index)) == 0) {
+			continue;
+		}
+
+		ret = vk->vkGetQueryPoolResults( //
+		    vk->device,                  // device
+		    r->query_pool,               // queryPool
+		    2 + index * 2,               // firstQuery
+		    2,                           // queryCount
+		    sizeof(uint64_t) * 2,        // dataSize
+		    &timestamps[count],          // pData
+		    sizeof(uint64_t),            // stride
+		    flags);                      // flags
+		if (ret != VK_SUCCESS) {
+			return false;
+		}
+
+		count += 2;
+	}
+
+
+	/*
+	 * Convert from GPU context to CPU context, has to be
+	 * done fairly quickly after timestamps has been made.
+	 */
+	ret = vk_convert_timestamps_to_host_ns(vk, count, timestamps);
+	if (ret != VK_SUCCESS) {
+		return false;
+	}
+
+
+	/*
+	 * Done
+	 */
+
+	U_ZERO(out_rpt);
+	out_rpt->valid_mask = valid_mask;
+
+	count = 0;
+	for (uint32_t index = 0; index < RENDER_TIMESTAMP_PHASE_COUNT * XRT_MAX_VIEWS; index++) {
+		if ((valid_mask & (1u << index)) == 0) {
+			continue;
+		}
+
+		uint32_t phase = index / XRT_MAX_VIEWS;
+		uint32_t view = index % XRT_MAX_VIEWS;
+		out_rpt->gpu_start_ns[phase][view] = timestamps[count++];
+		out_rpt->gpu_end_ns[phase][view] = timestamps[count++];
+	}
+
+	return true;
+}
+
 
 /*
  *
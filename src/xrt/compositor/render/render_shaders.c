@@ -26,6 +26,7 @@
 #endif
 
 #include "shaders/blit.comp.h"
+#include "shaders/camera_convert.comp.h"
 #include "shaders/clear.comp.h"
 #include "shaders/layer.comp.h"
 #include "shaders/distortion.comp.h"
@@ -103,6 +104,8 @@ render_shaders_load(struct render_shaders *s, struct vk_bundle *vk)
 {
 	LOAD(blit_comp);
 
+	LOAD(camera_convert_comp);
+
 	LOAD(clear_comp);
 
 	LOAD(layer_comp);
@@ -129,6 +132,7 @@ void
 render_shaders_close(struct render_shaders *s, struct vk_bundle *vk)
 {
 	D(ShaderModule, s->blit_comp);
+	D(ShaderModule, s->camera_convert_comp);
 	D(ShaderModule, s->clear_comp);
 	D(ShaderModule, s->distortion_comp);
 	D(ShaderModule, s->layer_comp);
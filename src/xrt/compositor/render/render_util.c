@@ -8,6 +8,7 @@
  */
 
 #include "math/m_api.h"
+#include "math/m_vec3.h"
 #include "math/m_matrix_4x4_f64.h"
 
 #include "render/render_interface.h"
@@ -123,6 +124,29 @@ render_calc_time_warp_matrix(const struct xrt_pose *src_pose,
 	}
 }
 
+void
+render_calc_time_warp_translation(const struct xrt_pose *src_pose,
+                                  const struct xrt_fov *src_fov,
+                                  const struct xrt_pose *new_pose,
+                                  struct xrt_vec3 *out_translation)
+{
+	// Src projection matrix.
+	struct xrt_matrix_4x4_f64 src_proj;
+	calc_projection(src_fov, &src_proj);
+
+	// The new position relative to the src position, in the src view's space.
+	struct xrt_vec3 delta = m_vec3_sub(new_pose->position, src_pose->position);
+	struct xrt_quat src_q_inv;
+	math_quat_invert(&src_pose->orientation, &src_q_inv);
+	math_quat_rotate_vec3(&src_q_inv, &delta, &delta);
+
+	// Only the x, y and w rows of the projection, column major, a direction so no w column.
+	const double *m = src_proj.v;
+	out_translation->x = (float)(m[0] * delta.x + m[4] * delta.y + m[8] * delta.z);
+	out_translation->y = (float)(m[1] * delta.x + m[5] * delta.y + m[9] * delta.z);
+	out_translation->z = (float)(m[3] * delta.x + m[7] * delta.y + m[11] * delta.z);
+}
+
 void
 render_calc_uv_to_tangent_lengths_rect(const struct xrt_fov *fov, struct xrt_normalized_rect *out_rect)
 {
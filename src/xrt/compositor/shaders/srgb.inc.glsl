@@ -14,9 +14,9 @@ float from_linear_to_srgb_channel(float value)
 
 vec3 from_linear_to_srgb(vec3 linear_rgb)
 {
-	return vec3(
-		from_linear_to_srgb_channel(linear_rgb.r),
-		from_linear_to_srgb_channel(linear_rgb.g),
-		from_linear_to_srgb_channel(linear_rgb.b)
-	);
+	// Compute both and select, avoids per channel branches.
+	vec3 low = 12.92 * linear_rgb;
+	vec3 high = 1.055 * pow(linear_rgb, vec3(1.0 / 2.4)) - 0.055;
+
+	return mix(high, low, lessThan(linear_rgb, vec3(0.0031308)));
 }
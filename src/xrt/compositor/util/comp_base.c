@@ -159,6 +159,31 @@ base_layer_projection_depth(struct xrt_compositor *xc,
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+base_layer_projection_space_warp(struct xrt_compositor *xc,
+                                 struct xrt_device *xdev,
+                                 struct xrt_swapchain *xsc[XRT_MAX_VIEWS],
+                                 struct xrt_swapchain *d_xsc[XRT_MAX_VIEWS],
+                                 struct xrt_swapchain *mv_xsc[XRT_MAX_VIEWS],
+                                 const struct xrt_layer_data *data)
+{
+	struct comp_base *cb = comp_base(xc);
+
+	uint32_t layer_id = cb->slot.layer_count;
+
+	struct comp_layer *layer = &cb->slot.layers[layer_id];
+	for (uint32_t i = 0; i < data->view_count; ++i) {
+		layer->sc_array[i] = comp_swapchain(xsc[i]);
+		layer->sc_array[i + data->view_count] = comp_swapchain(d_xsc[i]);
+		layer->sc_array[i + data->view_count * 2] = comp_swapchain(mv_xsc[i]);
+	}
+	layer->data = *data;
+
+	cb->slot.layer_count++;
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 base_layer_quad(struct xrt_compositor *xc,
                 struct xrt_device *xdev,
@@ -257,6 +282,7 @@ comp_base_init(struct comp_base *cb)
 	cb->base.base.layer_begin = base_layer_begin;
 	cb->base.base.layer_projection = base_layer_projection;
 	cb->base.base.layer_projection_depth = base_layer_projection_depth;
+	cb->base.base.layer_projection_space_warp = base_layer_projection_space_warp;
 	cb->base.base.layer_quad = base_layer_quad;
 	cb->base.base.layer_cube = base_layer_cube;
 	cb->base.base.layer_cylinder = base_layer_cylinder;
@@ -266,7 +292,7 @@ comp_base_init(struct comp_base *cb)
 
 	u_threading_stack_init(&cb->cscs.destroy_swapchains);
 
-	os_precise_sleeper_init(&cb->sleeper);
+	u_wait_sleeper_init(&cb->sleeper);
 }
 
 void
@@ -29,11 +29,12 @@ extern "C" {
 struct comp_layer
 {
 	/*!
-	 * Up to four compositor swapchains referenced per layer.
+	 * Compositor swapchains referenced per layer: colour, then depth and
+	 * then motion vectors, one per view for projection layers.
 	 *
 	 * Unused elements should be set to null.
 	 */
-	struct comp_swapchain *sc_array[XRT_MAX_VIEWS * 2];
+	struct comp_swapchain *sc_array[XRT_MAX_VIEWS * 3];
 
 	/*!
 	 * All basic (trivially-serializable) data associated with a layer.
@@ -20,6 +20,7 @@ extern "C" {
 #endif
 
 struct comp_layer;
+struct u_worker_group;
 
 
 /*
@@ -80,6 +81,12 @@ struct comp_render_view_data
 	// Distortion target viewport data (aka target).
 	struct render_viewport_data target_viewport_data;
 
+	/*!
+	 * The pose the layer image was squashed at, only used with
+	 * @ref comp_render_dispatch_data::reuse_layers.
+	 */
+	struct xrt_pose layer_world_pose;
+
 	struct
 	{
 		//! Per-view layer target resources.
@@ -113,10 +120,26 @@ struct comp_render_dispatch_data
 	//! Very often true, can be disabled for debugging.
 	bool do_timewarp;
 
+	/*!
+	 * The layer images already hold these layers, squashed by an earlier
+	 * frame, so the squashing is skipped and the distortion timewarps from
+	 * @ref comp_render_view_data::layer_world_pose instead.
+	 */
+	bool reuse_layers;
+
+	//! When the frame will be displayed, used to extrapolate space warp layers, 0 disables it.
+	int64_t display_time_ns;
+
 	struct
 	{
 		// The resources needed for the target.
 		struct render_gfx_target_resources *rtr;
+
+		/*!
+		 * If set the layer squash of each view is recorded into its own
+		 * secondary command buffer as tasks on this group, in parallel.
+		 */
+		struct u_worker_group *record_group;
 	} gfx;
 
 	struct
@@ -205,6 +228,9 @@ comp_render_gfx_add_view(struct comp_render_dispatch_data *data,
  * * Scratch images: VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
  * * Target image: What the render pass of @p rtr specifies.
  *
+ * With @p comp_render_dispatch_data::reuse_layers the scratch images must
+ * already be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL and are only read.
+ *
  * @ingroup comp_util
  */
 void
@@ -291,7 +317,8 @@ comp_render_cs_layer(struct render_compute *crc,
                      const VkImage target_image,
                      const VkImageView target_image_view,
                      const struct render_viewport_data *target_view,
-                     bool do_timewarp);
+                     bool do_timewarp,
+                     int64_t display_time_ns);
 
 /*!
  * Helper function to dispatch the layer squasher, works on any number of views.
@@ -335,6 +362,9 @@ comp_render_cs_layers(struct render_compute *crc,
  * * Scratch images: VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
  * * Target image: VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
  *
+ * With @p comp_render_dispatch_data::reuse_layers the scratch images must
+ * already be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL and are only read.
+ *
  * @ingroup comp_util
  */
 void
@@ -14,9 +14,11 @@
 #include "os/os_time.h"
 
 #include "math/m_api.h"
+#include "math/m_vec3.h"
 #include "math/m_mathinclude.h"
 
 #include "util/u_misc.h"
+#include "util/u_debug.h"
 #include "util/u_trace_marker.h"
 
 #include "vk/vk_helpers.h"
@@ -28,6 +30,150 @@
 #include "util/comp_base.h"
 
 
+DEBUG_GET_ONCE_BOOL_OPTION(cs_all_views, "XRT_COMPOSITOR_COMPUTE_ALL_VIEWS", true)
+DEBUG_GET_ONCE_BOOL_OPTION(cs_depth_reprojection, "XRT_COMPOSITOR_DEPTH_REPROJECTION", false)
+
+//! Further than this from where the layer was rendered and it is only rotated, in meters.
+#define DEPTH_REPROJECTION_MAX_DISTANCE (0.25f)
+
+static_assert(RENDER_MAX_LAYERS <= 32, "Tile layer masks are 32 bits");
+
+
+/*
+ *
+ * Tile helpers.
+ *
+ */
+
+//! Bounds of a layer in the [0 .. 1] uv space of a view.
+struct tile_bounds
+{
+	float min_x, min_y;
+	float max_x, max_y;
+};
+
+static uint32_t
+tile_size_for(uint32_t extent)
+{
+	uint32_t size = (extent + RENDER_LAYER_TILE_GRID - 1) / RENDER_LAYER_TILE_GRID;
+
+	// Keep tiles on workgroup boundaries so that whole workgroups can exit early.
+	return ((size + 7) / 8) * 8;
+}
+
+static void
+tiles_init(struct render_compute_layer_ubo_data *ubo_data, const struct render_viewport_data *target_view)
+{
+	uint32_t size_x = tile_size_for(target_view->w);
+	uint32_t size_y = tile_size_for(target_view->h);
+
+	ubo_data->tiles.size_x = size_x;
+	ubo_data->tiles.size_y = size_y;
+	ubo_data->tiles.count_x = (target_view->w + size_x - 1) / size_x;
+	ubo_data->tiles.count_y = (target_view->h + size_y - 1) / size_y;
+
+	U_ZERO_ARRAY(ubo_data->tile_layer_masks);
+}
+
+static uint32_t
+tile_index_clamped(float uv, uint32_t extent, uint32_t size, uint32_t count)
+{
+	float pixel = floorf(uv * (float)extent);
+	if (pixel < 0.0f) {
+		return 0;
+	}
+
+	uint32_t index = (uint32_t)pixel / size;
+	return index < count ? index : count - 1;
+}
+
+/*!
+ * Mark the tiles that @p cur_layer may contribute to, with no @p bounds the
+ * layer is assumed to touch every tile.
+ */
+static void
+tiles_add_layer(struct render_compute_layer_ubo_data *ubo_data,
+                uint32_t cur_layer,
+                const struct render_viewport_data *target_view,
+                const struct tile_bounds *bounds)
+{
+	uint32_t x0 = 0, y0 = 0;
+	uint32_t x1 = ubo_data->tiles.count_x - 1;
+	uint32_t y1 = ubo_data->tiles.count_y - 1;
+
+	if (bounds != NULL) {
+		// Entirely outside of the view, touches no tile.
+		if (bounds->max_x < 0.0f || bounds->max_y < 0.0f || bounds->min_x > 1.0f || bounds->min_y > 1.0f) {
+			return;
+		}
+
+		x0 = tile_index_clamped(bounds->min_x, target_view->w, ubo_data->tiles.size_x, ubo_data->tiles.count_x);
+		x1 = tile_index_clamped(bounds->max_x, target_view->w, ubo_data->tiles.size_x, ubo_data->tiles.count_x);
+		y0 = tile_index_clamped(bounds->min_y, target_view->h, ubo_data->tiles.size_y, ubo_data->tiles.count_y);
+		y1 = tile_index_clamped(bounds->max_y, target_view->h, ubo_data->tiles.size_y, ubo_data->tiles.count_y);
+	}
+
+	for (uint32_t y = y0; y <= y1; y++) {
+		for (uint32_t x = x0; x <= x1; x++) {
+			ubo_data->tile_layer_masks[y * RENDER_LAYER_TILE_GRID + x] |= 1u << cur_layer;
+		}
+	}
+}
+
+/*!
+ * Project the corners of a quad into the view, returns false if the quad can
+ * not be bounded because it crosses the plane of the eye.
+ */
+static bool
+calc_quad_bounds(const struct xrt_layer_data *data,
+                 const struct xrt_matrix_4x4 *view_mat,
+                 const struct xrt_normalized_rect *pre_transform,
+                 struct tile_bounds *out_bounds)
+{
+	const struct xrt_layer_quad_data *q = &data->quad;
+
+	struct xrt_vec3 scale = {1.f, 1.f, 1.f};
+	struct xrt_matrix_4x4 model, model_view;
+	math_matrix_4x4_model(&q->pose, &scale, &model);
+	math_matrix_4x4_multiply(view_mat, &model, &model_view);
+
+	float hw = q->size.x / 2.f;
+	float hh = q->size.y / 2.f;
+	const struct xrt_vec3 corners[4] = {
+	    {-hw, -hh, 0.f},
+	    {hw, -hh, 0.f},
+	    {hw, hh, 0.f},
+	    {-hw, hh, 0.f},
+	};
+
+	struct tile_bounds bounds = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+
+	for (uint32_t i = 0; i < ARRAY_SIZE(corners); i++) {
+		struct xrt_vec3 p;
+		math_matrix_4x4_transform_vec3(&model_view, &corners[i], &p);
+
+		if (p.z > -0.001f) {
+			return false;
+		}
+
+		// To tangent space, then the inverse of the uv to tangent transform in the shader, which flips y.
+		float tan_x = p.x / -p.z;
+		float tan_y = p.y / -p.z;
+		float u = (tan_x - pre_transform->x) / pre_transform->w;
+		float v = (-tan_y - pre_transform->y) / pre_transform->h;
+
+		bounds.min_x = fminf(bounds.min_x, u);
+		bounds.min_y = fminf(bounds.min_y, v);
+		bounds.max_x = fmaxf(bounds.max_x, u);
+		bounds.max_y = fmaxf(bounds.max_y, v);
+	}
+
+	*out_bounds = bounds;
+
+	return true;
+}
+
+
 /*
  *
  * Compute layer data builders.
@@ -97,6 +243,70 @@ do_cs_equirect2_layer(const struct xrt_layer_data *data,
 	*out_cur_image = cur_image;
 }
 
+static inline bool
+is_layer_space_warp(const struct xrt_layer_data *data)
+{
+	return data->type == XRT_LAYER_PROJECTION_DEPTH && (data->flags & XRT_LAYER_COMPOSITION_SPACE_WARP_BIT) != 0;
+}
+
+/*!
+ * How many frame intervals past the layer's display time we are displaying it,
+ * clamped so that a stalled application doesn't smear its last frame too far.
+ */
+static inline float
+calc_space_warp_frames(const struct xrt_layer_data *data,
+                       const struct xrt_layer_space_warp_data *wvd,
+                       int64_t display_time_ns)
+{
+	if (display_time_ns <= 0 || wvd->frame_interval_ns <= 0) {
+		return 0.0f;
+	}
+
+	int64_t diff_ns = display_time_ns - (int64_t)data->timestamp;
+	float frames = (float)((double)diff_ns / (double)wvd->frame_interval_ns);
+
+	return CLAMP(frames, 0.0f, 2.0f);
+}
+
+/*!
+ * Sets up the positional reprojection of a depth layer, the translation is left
+ * at zero, which disables it in the shader, if the depth can't be used.
+ */
+static inline void
+set_depth_reprojection_data(const struct xrt_layer_projection_view_data *vd,
+                            const struct xrt_layer_depth_data *dvd,
+                            const struct xrt_pose *world_pose,
+                            uint32_t cur_layer,
+                            struct render_compute_layer_ubo_data *ubo_data)
+{
+	ubo_data->depth_translation[cur_layer].val = (struct xrt_vec3){0.0f, 0.0f, 0.0f};
+
+	// Reversed depth ranges and planes are fine, an infinite plane gives zero.
+	float depth_range = dvd->max_depth - dvd->min_depth;
+	if (depth_range == 0.0f || !(dvd->near_z > 0.0f) || !(dvd->far_z > 0.0f) || dvd->near_z == dvd->far_z) {
+		return;
+	}
+
+	struct xrt_vec3 delta = m_vec3_sub(world_pose->position, vd->pose.position);
+	if (m_vec3_len(delta) > DEPTH_REPROJECTION_MAX_DISTANCE) {
+		return;
+	}
+
+	float inv_near = 1.0f / dvd->near_z;
+	float inv_far = 1.0f / dvd->far_z;
+
+	ubo_data->depth_data[cur_layer].inv_near = inv_near;
+	ubo_data->depth_data[cur_layer].inv_far_minus_inv_near = inv_far - inv_near;
+	ubo_data->depth_data[cur_layer].min_depth = dvd->min_depth;
+	ubo_data->depth_data[cur_layer].inv_depth_range = 1.0f / depth_range;
+
+	render_calc_time_warp_translation(                //
+	    &vd->pose,                                    //
+	    &vd->fov,                                     //
+	    world_pose,                                   //
+	    &ubo_data->depth_translation[cur_layer].val); //
+}
+
 static inline void
 do_cs_projection_layer(const struct xrt_layer_data *data,
                        const struct comp_layer *layer,
@@ -110,6 +320,7 @@ do_cs_projection_layer(const struct xrt_layer_data *data,
                        VkImageView src_image_views[RENDER_MAX_IMAGES_SIZE],
                        struct render_compute_layer_ubo_data *ubo_data,
                        bool do_timewarp,
+                       int64_t display_time_ns,
                        uint32_t *out_cur_image)
 {
 	const struct xrt_layer_projection_view_data *vd = NULL;
@@ -147,6 +358,32 @@ do_cs_projection_layer(const struct xrt_layer_data *data,
 	    false,                                  // invert_flip
 	    &ubo_data->post_transforms[cur_layer]); // out_norm_rect
 
+	// Motion vectors, zero scale turns off extrapolation in the shader.
+	ubo_data->space_warp_scale[cur_layer].val = (struct xrt_vec2){0.0f, 0.0f};
+
+	if (is_layer_space_warp(data)) {
+		const struct xrt_layer_space_warp_data *wvd = &data->depth.w[view_index];
+		uint32_t mv_array_index = wvd->motion_sub.array_index;
+		const struct comp_swapchain_image *mv_image =
+		    &layer->sc_array[sc_array_index + 4]->images[wvd->motion_sub.image_index];
+
+		src_samplers[cur_image] = clamp_to_edge;
+		src_image_views[cur_image] = get_image_view(mv_image, data->flags, mv_array_index);
+		ubo_data->images_samplers[cur_layer + 0].images[2] = cur_image++;
+
+		set_post_transform_rect(                       //
+		    data,                                      // data
+		    &wvd->motion_sub.norm_rect,                // src_norm_rect
+		    false,                                     // invert_flip
+		    &ubo_data->mv_post_transforms[cur_layer]); // out_norm_rect
+
+		float frames = calc_space_warp_frames(data, wvd, display_time_ns);
+
+		// NDC to uv is half the size, OpenGL has y pointing up in both.
+		ubo_data->space_warp_scale[cur_layer].val.x = 0.5f * frames;
+		ubo_data->space_warp_scale[cur_layer].val.y = data->flip_y ? -0.5f * frames : 0.5f * frames;
+	}
+
 	// unused if timewarp is off
 	if (do_timewarp) {
 		render_calc_time_warp_matrix(          //
@@ -156,6 +393,14 @@ do_cs_projection_layer(const struct xrt_layer_data *data,
 		    &ubo_data->transforms[cur_layer]); //
 	}
 
+	// Needs the timewarp matrix, motion vector extrapolation takes precedence.
+	ubo_data->depth_translation[cur_layer].val = (struct xrt_vec3){0.0f, 0.0f, 0.0f};
+
+	if (do_timewarp && data->type == XRT_LAYER_PROJECTION_DEPTH && !is_layer_space_warp(data) &&
+	    debug_get_bool_option_cs_depth_reprojection()) {
+		set_depth_reprojection_data(vd, dvd, world_pose, cur_layer, ubo_data);
+	}
+
 	*out_cur_image = cur_image;
 }
 
@@ -329,11 +574,15 @@ do_cs_clear(struct render_compute *crc, const struct comp_render_dispatch_data *
 	}
 
 
+	render_compute_write_timestamp(crc, RENDER_TIMESTAMP_PHASE_CLEAR, 0, false);
+
 	render_compute_clear(        //
 	    crc,                     // crc
 	    d->cs.target_image,      // target_image
 	    d->cs.target_unorm_view, // target_image_view
 	    target_viewport_datas);  // views
+
+	render_compute_write_timestamp(crc, RENDER_TIMESTAMP_PHASE_CLEAR, 0, true);
 }
 
 static void
@@ -350,6 +599,9 @@ do_cs_distortion_from_scratch(struct render_compute *crc, const struct comp_rend
 	VkImageView src_image_views[XRT_MAX_VIEWS];
 	VkSampler src_samplers[XRT_MAX_VIEWS];
 	struct xrt_normalized_rect src_norm_rects[XRT_MAX_VIEWS];
+	struct xrt_pose src_poses[XRT_MAX_VIEWS];
+	struct xrt_fov src_fovs[XRT_MAX_VIEWS];
+	struct xrt_pose world_poses[XRT_MAX_VIEWS];
 
 	for (uint32_t i = 0; i < d->view_count; i++) {
 		// Data to be filled in.
@@ -367,16 +619,38 @@ do_cs_distortion_from_scratch(struct render_compute *crc, const struct comp_rend
 		src_image_views[i] = src_image_view;
 		src_samplers[i] = clamp_to_border_black;
 		src_norm_rects[i] = src_norm_rect;
+		src_poses[i] = d->views[i].layer_world_pose;
+		src_fovs[i] = d->views[i].fov;
+		world_poses[i] = d->views[i].world_pose;
 	}
 
-	render_compute_projection(   //
-	    crc,                     // crc
-	    src_samplers,            // src_samplers
-	    src_image_views,         // src_image_views
-	    src_norm_rects,          // src_rects
-	    d->cs.target_image,      // target_image
-	    d->cs.target_unorm_view, // target_image_view
-	    target_viewport_datas);  // views
+	render_compute_write_timestamp(crc, RENDER_TIMESTAMP_PHASE_DISTORTION, 0, false);
+
+	// A fresh squash was done with the new poses, only reused ones needs timewarp.
+	if (d->reuse_layers && d->do_timewarp) {
+		render_compute_projection_timewarp( //
+		    crc,                            // crc
+		    src_samplers,                   // src_samplers
+		    src_image_views,                // src_image_views
+		    src_norm_rects,                 // src_rects
+		    src_poses,                      // src_poses
+		    src_fovs,                       // src_fovs
+		    world_poses,                    // new_poses
+		    d->cs.target_image,             // target_image
+		    d->cs.target_unorm_view,        // target_image_view
+		    target_viewport_datas);         // views
+	} else {
+		render_compute_projection(   //
+		    crc,                     // crc
+		    src_samplers,            // src_samplers
+		    src_image_views,         // src_image_views
+		    src_norm_rects,          // src_rects
+		    d->cs.target_image,      // target_image
+		    d->cs.target_unorm_view, // target_image_view
+		    target_viewport_datas);  // views
+	}
+
+	render_compute_write_timestamp(crc, RENDER_TIMESTAMP_PHASE_DISTORTION, 0, true);
 }
 
 static void
@@ -439,6 +713,8 @@ do_cs_distortion_for_layer(struct render_compute *crc,
 		src_image_views[i] = src_image_view;
 	}
 
+	render_compute_write_timestamp(crc, RENDER_TIMESTAMP_PHASE_DISTORTION, 0, false);
+
 	if (!d->do_timewarp) {
 		render_compute_projection(   //
 		    crc,                     //
@@ -461,27 +737,36 @@ do_cs_distortion_for_layer(struct render_compute *crc,
 		    d->cs.target_unorm_view,        //
 		    target_viewport_datas);         //
 	}
+
+	render_compute_write_timestamp(crc, RENDER_TIMESTAMP_PHASE_DISTORTION, 0, true);
 }
 
 
 /*
  *
- * 'Exported' compute helpers.
+ * Layer squasher helpers.
  *
  */
 
-void
-comp_render_cs_layer(struct render_compute *crc,
+/*!
+ * Fills in @p ubo_data for one view and appends its images to the source
+ * arrays starting at @p cur_image, returns false if not all layers fit.
+ */
+static bool
+do_cs_layer_ubo_data(struct render_compute *crc,
                      uint32_t view_index,
                      const struct comp_layer *layers,
                      const uint32_t layer_count,
                      const struct xrt_normalized_rect *pre_transform,
                      const struct xrt_pose *world_pose,
                      const struct xrt_pose *eye_pose,
-                     const VkImage target_image,
-                     const VkImageView target_image_view,
                      const struct render_viewport_data *target_view,
-                     bool do_timewarp)
+                     bool do_timewarp,
+                     int64_t display_time_ns,
+                     struct render_compute_layer_ubo_data *ubo_data,
+                     VkSampler src_samplers[RENDER_MAX_IMAGES_SIZE],
+                     VkImageView src_image_views[RENDER_MAX_IMAGES_SIZE],
+                     uint32_t *in_out_cur_image)
 {
 	VkSampler clamp_to_edge = crc->r->samplers.clamp_to_edge;
 	VkSampler clamp_to_border_black = crc->r->samplers.clamp_to_border_black;
@@ -491,20 +776,18 @@ comp_render_cs_layer(struct render_compute *crc,
 	math_matrix_4x4_view_from_pose(world_pose, &world_view_mat);
 	math_matrix_4x4_view_from_pose(eye_pose, &eye_view_mat);
 
-	struct render_buffer *ubo = &crc->r->compute.layer.ubos[view_index];
-	struct render_compute_layer_ubo_data *ubo_data = ubo->mapped;
-
 	// Tightly pack layers in data struct.
 	uint32_t cur_layer = 0;
 
 	// Tightly pack color and optional depth images.
-	uint32_t cur_image = 0;
-	VkSampler src_samplers[RENDER_MAX_IMAGES_SIZE];
-	VkImageView src_image_views[RENDER_MAX_IMAGES_SIZE];
+	uint32_t cur_image = *in_out_cur_image;
+	bool all_fit = true;
 
 	ubo_data->view = *target_view;
 	ubo_data->pre_transform = *pre_transform;
 
+	tiles_init(ubo_data, target_view);
+
 	for (uint32_t c_layer_i = 0; c_layer_i < layer_count; c_layer_i++) {
 		const struct comp_layer *layer = &layers[c_layer_i];
 		const struct xrt_layer_data *data = &layer->data;
@@ -525,7 +808,7 @@ comp_render_cs_layer(struct render_compute *crc,
 		case XRT_LAYER_CYLINDER: required_image_samplers = 1; break;
 		case XRT_LAYER_EQUIRECT2: required_image_samplers = 1; break;
 		case XRT_LAYER_PROJECTION: required_image_samplers = 1; break;
-		case XRT_LAYER_PROJECTION_DEPTH: required_image_samplers = 2; break;
+		case XRT_LAYER_PROJECTION_DEPTH: required_image_samplers = is_layer_space_warp(data) ? 3 : 2; break;
 		case XRT_LAYER_QUAD: required_image_samplers = 1; break;
 		default:
 			VK_ERROR(crc->r->vk, "Skipping layer #%u, unknown type: %u", c_layer_i, data->type);
@@ -534,6 +817,7 @@ comp_render_cs_layer(struct render_compute *crc,
 
 		//! Exit loop if shader cannot receive more image samplers
 		if (cur_image + required_image_samplers > crc->r->compute.layer.image_array_size) {
+			all_fit = false;
 			break;
 		}
 
@@ -585,6 +869,7 @@ comp_render_cs_layer(struct render_compute *crc,
 			    src_image_views,       // src_image_views
 			    ubo_data,              // ubo_data
 			    do_timewarp,           // do_timewarp
+			    display_time_ns,       // display_time_ns
 			    &cur_image);           // out_cur_image
 		} break;
 		case XRT_LAYER_QUAD: {
@@ -613,6 +898,12 @@ comp_render_cs_layer(struct render_compute *crc,
 		ubo_data->layer_type[cur_layer].val = data->type;
 		ubo_data->layer_type[cur_layer].unpremultiplied = is_layer_unpremultiplied(data);
 
+		// Only quads are bounded, other layer types can cover the whole view.
+		struct tile_bounds bounds;
+		const struct xrt_matrix_4x4 *view_mat = is_layer_view_space(data) ? &eye_view_mat : &world_view_mat;
+		bool bounded = data->type == XRT_LAYER_QUAD && calc_quad_bounds(data, view_mat, pre_transform, &bounds);
+		tiles_add_layer(ubo_data, cur_layer, target_view, bounded ? &bounds : NULL);
+
 		// Finally okay to increment the current layer.
 		cur_layer++;
 	}
@@ -624,15 +915,179 @@ comp_render_cs_layer(struct render_compute *crc,
 		ubo_data->layer_type[i].val = UINT32_MAX;
 	}
 
+	*in_out_cur_image = cur_image;
+
+	return all_fit;
+}
+
+/*!
+ * If all layers blend the same way the squasher can use a pipeline specialized
+ * for that, looks at the layers and not the UBO as the latter is not cached.
+ */
+static enum render_layer_blend_mode
+get_blend_mode(const struct comp_layer *layers, uint32_t layer_count)
+{
+	bool any_premultiplied = false;
+	bool any_unpremultiplied = false;
+
+	for (uint32_t i = 0; i < layer_count; i++) {
+		if (is_layer_unpremultiplied(&layers[i].data)) {
+			any_unpremultiplied = true;
+		} else {
+			any_premultiplied = true;
+		}
+	}
+
+	if (any_premultiplied && any_unpremultiplied) {
+		return RENDER_LAYER_BLEND_MODE_PER_LAYER;
+	}
+	if (any_unpremultiplied) {
+		return RENDER_LAYER_BLEND_MODE_UNPREMULTIPLIED;
+	}
+
+	return RENDER_LAYER_BLEND_MODE_PREMULTIPLIED;
+}
+
+static void
+fill_unused_images(struct render_compute *crc,
+                   VkSampler src_samplers[RENDER_MAX_IMAGES_SIZE],
+                   VkImageView src_image_views[RENDER_MAX_IMAGES_SIZE],
+                   uint32_t *in_out_cur_image)
+{
+	uint32_t cur_image = *in_out_cur_image;
+
 	//! @todo: If Vulkan 1.2, use VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT and skip this
 	while (cur_image < crc->r->compute.layer.image_array_size) {
-		src_samplers[cur_image] = clamp_to_edge;
+		src_samplers[cur_image] = crc->r->samplers.clamp_to_edge;
 		src_image_views[cur_image] = crc->r->mock.color.image_view;
 		cur_image++;
 	}
 
+	*in_out_cur_image = cur_image;
+}
+
+/*!
+ * Squash all views in a single dispatch, returns false without recording
+ * anything if the images of all views do not fit in one descriptor set.
+ */
+static bool
+do_cs_layers_all_views(struct render_compute *crc,
+                       const struct comp_layer *layers,
+                       const uint32_t layer_count,
+                       const struct comp_render_dispatch_data *d)
+{
+	struct render_buffer *ubo = &crc->r->compute.layer.ubos[0];
+	struct render_compute_layer_ubo_data *ubo_datas = ubo->mapped;
+
+	uint32_t cur_image = 0;
+	VkSampler src_samplers[RENDER_MAX_IMAGES_SIZE];
+	VkImageView src_image_views[RENDER_MAX_IMAGES_SIZE];
+	VkImageView target_image_views[XRT_MAX_VIEWS];
+	struct render_viewport_data target_views[XRT_MAX_VIEWS];
+
+	for (uint32_t view_index = 0; view_index < d->view_count; view_index++) {
+		const struct comp_render_view_data *view = &d->views[view_index];
+
+		bool fit = do_cs_layer_ubo_data( //
+		    crc,                         //
+		    view_index,                  //
+		    layers,                      //
+		    layer_count,                 //
+		    &view->target_pre_transform, //
+		    &view->world_pose,           //
+		    &view->eye_pose,             //
+		    &view->layer_viewport_data,  //
+		    d->do_timewarp,              //
+		    d->display_time_ns,          //
+		    &ubo_datas[view_index],      //
+		    src_samplers,                //
+		    src_image_views,             //
+		    &cur_image);                 //
+		if (!fit) {
+			return false;
+		}
+
+		target_image_views[view_index] = view->cs.unorm_view;
+		target_views[view_index] = view->layer_viewport_data;
+	}
+
+	fill_unused_images(crc, src_samplers, src_image_views, &cur_image);
+
+	enum render_layer_blend_mode blend_mode = get_blend_mode(layers, layer_count);
+
+	render_compute_write_timestamp(crc, RENDER_TIMESTAMP_PHASE_SQUASH, 0, false);
+
+	render_compute_layers_all_views(   //
+	    crc,                           //
+	    crc->layer_descriptor_sets[0], //
+	    ubo->buffer,                   //
+	    src_samplers,                  //
+	    src_image_views,               //
+	    cur_image,                     //
+	    target_image_views,            //
+	    target_views,                  //
+	    d->view_count,                 //
+	    d->do_timewarp,                //
+	    blend_mode);                   //
+
+	render_compute_write_timestamp(crc, RENDER_TIMESTAMP_PHASE_SQUASH, 0, true);
+
+	return true;
+}
+
+
+/*
+ *
+ * 'Exported' compute helpers.
+ *
+ */
+
+void
+comp_render_cs_layer(struct render_compute *crc,
+                     uint32_t view_index,
+                     const struct comp_layer *layers,
+                     const uint32_t layer_count,
+                     const struct xrt_normalized_rect *pre_transform,
+                     const struct xrt_pose *world_pose,
+                     const struct xrt_pose *eye_pose,
+                     const VkImage target_image,
+                     const VkImageView target_image_view,
+                     const struct render_viewport_data *target_view,
+                     bool do_timewarp,
+                     int64_t display_time_ns)
+{
+	struct render_buffer *ubo = &crc->r->compute.layer.ubos[view_index];
+	struct render_compute_layer_ubo_data *ubo_data = ubo->mapped;
+
+	uint32_t cur_image = 0;
+	VkSampler src_samplers[RENDER_MAX_IMAGES_SIZE];
+	VkImageView src_image_views[RENDER_MAX_IMAGES_SIZE];
+
+	// Layers that do not fit are dropped.
+	do_cs_layer_ubo_data( //
+	    crc,              //
+	    view_index,       //
+	    layers,           //
+	    layer_count,      //
+	    pre_transform,    //
+	    world_pose,       //
+	    eye_pose,         //
+	    target_view,      //
+	    do_timewarp,      //
+	    display_time_ns,  //
+	    ubo_data,         //
+	    src_samplers,     //
+	    src_image_views,  //
+	    &cur_image);      //
+
+	fill_unused_images(crc, src_samplers, src_image_views, &cur_image);
+
+	enum render_layer_blend_mode blend_mode = get_blend_mode(layers, layer_count);
+
 	VkDescriptorSet descriptor_set = crc->layer_descriptor_sets[view_index];
 
+	render_compute_write_timestamp(crc, RENDER_TIMESTAMP_PHASE_SQUASH, view_index, false);
+
 	render_compute_layers( //
 	    crc,               //
 	    descriptor_set,    //
@@ -642,7 +1097,10 @@ comp_render_cs_layer(struct render_compute *crc,
 	    cur_image,         //
 	    target_image_view, //
 	    target_view,       //
-	    do_timewarp);      //
+	    do_timewarp,       //
+	    blend_mode);       //
+
+	render_compute_write_timestamp(crc, RENDER_TIMESTAMP_PHASE_SQUASH, view_index, true);
 }
 
 void
@@ -655,7 +1113,7 @@ comp_render_cs_layers(struct render_compute *crc,
 	cmd_barrier_view_images(                   //
 	    crc->r->vk,                            //
 	    d,                                     //
-	    crc->r->cmd,                           // cmd
+	    crc->cmd,                              // cmd
 	    0,                                     // src_access_mask
 	    VK_ACCESS_SHADER_WRITE_BIT,            // dst_access_mask
 	    VK_IMAGE_LAYOUT_UNDEFINED,             // transition_from
@@ -663,7 +1121,11 @@ comp_render_cs_layers(struct render_compute *crc,
 	    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,    // src_stage_mask
 	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT); // dst_stage_mask
 
-	for (uint32_t view_index = 0; view_index < d->view_count; view_index++) {
+	// Fall back to one dispatch per view if they do not fit in one.
+	bool all_views = debug_get_bool_option_cs_all_views() && d->view_count > 1 &&
+	                 do_cs_layers_all_views(crc, layers, layer_count, d);
+
+	for (uint32_t view_index = 0; !all_views && view_index < d->view_count; view_index++) {
 		const struct comp_render_view_data *view = &d->views[view_index];
 
 		comp_render_cs_layer(            //
@@ -677,13 +1139,14 @@ comp_render_cs_layers(struct render_compute *crc,
 		    view->image,                 //
 		    view->cs.unorm_view,         //
 		    &view->layer_viewport_data,  //
-		    d->do_timewarp);             //
+		    d->do_timewarp,              //
+		    d->display_time_ns);         //
 	}
 
 	cmd_barrier_view_images(                   //
 	    crc->r->vk,                            //
 	    d,                                     //
-	    crc->r->cmd,                           // cmd
+	    crc->cmd,                              // cmd
 	    VK_ACCESS_SHADER_WRITE_BIT,            // src_access_mask
 	    VK_ACCESS_MEMORY_READ_BIT,             // dst_access_mask
 	    VK_IMAGE_LAYOUT_GENERAL,               // transition_from
@@ -733,12 +1196,14 @@ comp_render_cs_dispatch(struct render_compute *crc,
 		    vds,                    // vds
 		    d);                     // d
 	} else if (layer_count > 0) {
-		comp_render_cs_layers( //
-		    crc,               //
-		    layers,            //
-		    layer_count,       //
-		    d,                 //
-		    transition_to);    //
+		if (!d->reuse_layers) {
+			comp_render_cs_layers( //
+			    crc,               //
+			    layers,            //
+			    layer_count,       //
+			    d,                 //
+			    transition_to);    //
+		}
 
 		do_cs_distortion_from_scratch( //
 		    crc,                       //
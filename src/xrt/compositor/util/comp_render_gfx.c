@@ -13,6 +13,7 @@
 #include "math/m_mathinclude.h"
 
 #include "util/u_misc.h"
+#include "util/u_worker.h"
 #include "util/u_trace_marker.h"
 
 #include "vk/vk_helpers.h"
@@ -72,6 +73,24 @@ struct gfx_layer_state
 	struct gfx_layer_view_state views[XRT_MAX_VIEWS];
 };
 
+/*
+ * A view of the layer squash recorded into a secondary command buffer on a
+ * worker thread.
+ */
+struct gfx_layer_record_task
+{
+	// Parent that the view render_gfx is made from, only read from.
+	struct render_gfx *rr;
+
+	struct render_gfx_target_resources *rtr;
+	const struct render_viewport_data *viewport_data;
+	const struct gfx_layer_view_state *state;
+	uint32_t view_index;
+
+	// Was the command buffer successfully recorded.
+	bool ok;
+};
+
 /*
  * Internal state for the mesh rendering step.
  */
@@ -226,6 +245,7 @@ add_layer(struct gfx_layer_view_state *state, const struct xrt_layer_data *data,
 
 static VkResult
 do_cylinder_layer(struct render_gfx *rr,
+                  struct render_gfx_layer_batch *batch,
                   const struct comp_layer *layer,
                   uint32_t view_index,
                   VkSampler clamp_to_edge,
@@ -275,6 +295,7 @@ do_cylinder_layer(struct render_gfx *rr,
 	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
 	ret = render_gfx_layer_cylinder_alloc_and_write( //
 	    rr,                                          // rr
+	    batch,                                       // batch
 	    &data,                                       // data
 	    src_sampler,                                 // src_sampler
 	    src_image_view,                              // src_image_view
@@ -290,6 +311,7 @@ do_cylinder_layer(struct render_gfx *rr,
 
 static VkResult
 do_equirect2_layer(struct render_gfx *rr,
+                   struct render_gfx_layer_batch *batch,
                    const struct comp_layer *layer,
                    uint32_t view_index,
                    VkSampler clamp_to_edge,
@@ -339,6 +361,7 @@ do_equirect2_layer(struct render_gfx *rr,
 	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
 	ret = render_gfx_layer_equirect2_alloc_and_write( //
 	    rr,                                           // rr
+	    batch,                                        // batch
 	    &data,                                        // data
 	    src_sampler,                                  // src_sampler
 	    src_image_view,                               // src_image_view
@@ -354,6 +377,7 @@ do_equirect2_layer(struct render_gfx *rr,
 
 static VkResult
 do_projection_layer(struct render_gfx *rr,
+                    struct render_gfx_layer_batch *batch,
                     const struct comp_layer *layer,
                     uint32_t view_index,
                     VkSampler clamp_to_edge,
@@ -401,6 +425,7 @@ do_projection_layer(struct render_gfx *rr,
 	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
 	ret = render_gfx_layer_projection_alloc_and_write( //
 	    rr,                                            // rr
+	    batch,                                         // batch
 	    &data,                                         // data
 	    src_sampler,                                   // src_sampler
 	    src_image_view,                                // src_image_view
@@ -416,6 +441,7 @@ do_projection_layer(struct render_gfx *rr,
 
 static VkResult
 do_quad_layer(struct render_gfx *rr,
+              struct render_gfx_layer_batch *batch,
               const struct comp_layer *layer,
               uint32_t view_index,
               VkSampler clamp_to_edge,
@@ -452,6 +478,7 @@ do_quad_layer(struct render_gfx *rr,
 	VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
 	ret = render_gfx_layer_quad_alloc_and_write( //
 	    rr,                                      // rr
+	    batch,                                   // batch
 	    &data,                                   // data
 	    src_sampler,                             // src_sampler
 	    src_image_view,                          // src_image_view
@@ -465,6 +492,115 @@ do_quad_layer(struct render_gfx *rr,
 	return VK_SUCCESS;
 }
 
+static void
+write_view_layers(struct render_gfx *rr, const struct gfx_layer_view_state *state)
+{
+	for (uint32_t i = 0; i < state->layer_count; i++) {
+		switch (state->types[i]) {
+		case XRT_LAYER_CYLINDER:
+			render_gfx_layer_cylinder(          //
+			    rr,                             //
+			    state->premultiplied_alphas[i], //
+			    state->descriptor_sets[i]);     //
+			break;
+		case XRT_LAYER_EQUIRECT2:
+			render_gfx_layer_equirect2(         //
+			    rr,                             //
+			    state->premultiplied_alphas[i], //
+			    state->descriptor_sets[i]);     //
+			break;
+		case XRT_LAYER_PROJECTION:
+		case XRT_LAYER_PROJECTION_DEPTH:
+			render_gfx_layer_projection(        //
+			    rr,                             //
+			    state->premultiplied_alphas[i], //
+			    state->descriptor_sets[i]);     //
+			break;
+		case XRT_LAYER_QUAD:
+			render_gfx_layer_quad(              //
+			    rr,                             //
+			    state->premultiplied_alphas[i], //
+			    state->descriptor_sets[i]);     //
+			break;
+		default: break;
+		}
+	}
+}
+
+static void
+record_view_task(void *ptr)
+{
+	COMP_TRACE_MARKER();
+
+	struct gfx_layer_record_task *t = (struct gfx_layer_record_task *)ptr;
+	struct render_gfx view_rr;
+
+	t->ok = render_gfx_secondary_begin(t->rr, t->view_index, t->rtr, &view_rr);
+	if (!t->ok) {
+		return;
+	}
+
+	render_gfx_begin_view(&view_rr, t->view_index, t->viewport_data);
+
+	write_view_layers(&view_rr, t->state);
+
+	render_gfx_end_view(&view_rr);
+
+	t->ok = render_gfx_secondary_end(&view_rr);
+}
+
+/*
+ * Records the draws of each view on the worker group, then puts them into the
+ * primary command buffer in order. The descriptor sets have been written
+ * already so the views only read shared state.
+ */
+static void
+do_layers_record_parallel(struct render_gfx *rr,
+                          const struct gfx_layer_state *ls,
+                          const VkClearColorValue *color,
+                          const struct comp_render_dispatch_data *d)
+{
+	COMP_TRACE_MARKER();
+
+	struct vk_bundle *vk = rr->r->vk;
+	struct gfx_layer_record_task tasks[XRT_MAX_VIEWS];
+
+	for (uint32_t view = 0; view < d->view_count; view++) {
+		tasks[view] = (struct gfx_layer_record_task){
+		    .rr = rr,
+		    .rtr = d->views[view].gfx.rtr,
+		    .viewport_data = &d->views[view].layer_viewport_data,
+		    .state = &ls->views[view],
+		    .view_index = view,
+		    .ok = false,
+		};
+
+		u_worker_group_push(d->gfx.record_group, record_view_task, &tasks[view]);
+	}
+
+	u_worker_group_wait_all(d->gfx.record_group);
+
+	for (uint32_t view = 0; view < d->view_count; view++) {
+		render_gfx_write_timestamp(rr, RENDER_TIMESTAMP_PHASE_SQUASH, view, false);
+
+		render_gfx_begin_target_secondary( //
+		    rr,                            //
+		    d->views[view].gfx.rtr,        //
+		    color);                        //
+
+		// A failed view is only cleared.
+		if (tasks[view].ok) {
+			render_gfx_execute_secondary(rr, view);
+		} else {
+			VK_ERROR(vk, "Failed to record the layers of view %u!", view);
+		}
+
+		render_gfx_end_target(rr);
+
+		render_gfx_write_timestamp(rr, RENDER_TIMESTAMP_PHASE_SQUASH, view, true);
+	}
+}
+
 static void
 do_layers(struct render_gfx *rr,
           const struct comp_layer *layers,
@@ -529,6 +665,20 @@ do_layers(struct render_gfx *rr,
 	VkSampler clamp_to_edge = rr->r->samplers.clamp_to_edge;
 	VkSampler clamp_to_border_black = rr->r->samplers.clamp_to_border_black;
 
+	// Count first so that all of the descriptor sets can be allocated and written in one go.
+	uint32_t draw_count = 0;
+	for (uint32_t view = 0; view < d->view_count; view++) {
+		for (uint32_t i = 0; i < layer_count; i++) {
+			if (is_layer_view_visible(&layers[i].data, view)) {
+				draw_count++;
+			}
+		}
+	}
+
+	struct render_gfx_layer_batch batch;
+	ret = render_gfx_layer_batch_alloc(rr, draw_count, &batch);
+	VK_CHK_WITH_GOTO(ret, "render_gfx_layer_batch_alloc", err_layer);
+
 	for (uint32_t view = 0; view < d->view_count; view++) {
 
 		// Source for data and written to as well, read and write.
@@ -544,6 +694,7 @@ do_layers(struct render_gfx *rr,
 			case XRT_LAYER_CYLINDER:
 				ret = do_cylinder_layer(   //
 				    rr,                    // rr
+				    &batch,                // batch
 				    &layers[i],            // layer
 				    view,                  // view_index
 				    clamp_to_edge,         // clamp_to_edge
@@ -554,6 +705,7 @@ do_layers(struct render_gfx *rr,
 			case XRT_LAYER_EQUIRECT2:
 				ret = do_equirect2_layer(  //
 				    rr,                    // rr
+				    &batch,                // batch
 				    &layers[i],            // layer
 				    view,                  // view_index
 				    clamp_to_edge,         // clamp_to_edge
@@ -565,6 +717,7 @@ do_layers(struct render_gfx *rr,
 			case XRT_LAYER_PROJECTION_DEPTH:
 				ret = do_projection_layer( //
 				    rr,                    // rr
+				    &batch,                // batch
 				    &layers[i],            // layer
 				    view,                  // view_index
 				    clamp_to_edge,         // clamp_to_edge
@@ -575,6 +728,7 @@ do_layers(struct render_gfx *rr,
 			case XRT_LAYER_QUAD:
 				ret = do_quad_layer(       //
 				    rr,                    // rr
+				    &batch,                // batch
 				    &layers[i],            // layer
 				    view,                  // view_index
 				    clamp_to_edge,         // clamp_to_edge
@@ -587,6 +741,8 @@ do_layers(struct render_gfx *rr,
 		}
 	}
 
+	render_gfx_layer_batch_flush(rr, &batch);
+
 
 	/*
 	 * Do command writing here.
@@ -594,11 +750,18 @@ do_layers(struct render_gfx *rr,
 
 	const VkClearColorValue *color = layer_count == 0 ? &background_color_idle : &background_color_active;
 
+	if (d->gfx.record_group != NULL && d->view_count > 1) {
+		do_layers_record_parallel(rr, &ls, color, d);
+		return;
+	}
+
 	for (uint32_t view = 0; view < d->view_count; view++) {
 
 		// Convenience.
 		const struct render_viewport_data *viewport_data = &d->views[view].layer_viewport_data;
 
+		render_gfx_write_timestamp(rr, RENDER_TIMESTAMP_PHASE_SQUASH, view, false);
+
 		render_gfx_begin_target(    //
 		    rr,                     //
 		    d->views[view].gfx.rtr, //
@@ -610,42 +773,13 @@ do_layers(struct render_gfx *rr,
 		    viewport_data);    // viewport_data
 
 		// Only source for data here, read only.
-		const struct gfx_layer_view_state *state = &ls.views[view];
-
-		for (uint32_t i = 0; i < state->layer_count; i++) {
-			switch (state->types[i]) {
-			case XRT_LAYER_CYLINDER:
-				render_gfx_layer_cylinder(          //
-				    rr,                             //
-				    state->premultiplied_alphas[i], //
-				    state->descriptor_sets[i]);     //
-				break;
-			case XRT_LAYER_EQUIRECT2:
-				render_gfx_layer_equirect2(         //
-				    rr,                             //
-				    state->premultiplied_alphas[i], //
-				    state->descriptor_sets[i]);     //
-				break;
-			case XRT_LAYER_PROJECTION:
-			case XRT_LAYER_PROJECTION_DEPTH:
-				render_gfx_layer_projection(        //
-				    rr,                             //
-				    state->premultiplied_alphas[i], //
-				    state->descriptor_sets[i]);     //
-				break;
-			case XRT_LAYER_QUAD:
-				render_gfx_layer_quad(              //
-				    rr,                             //
-				    state->premultiplied_alphas[i], //
-				    state->descriptor_sets[i]);     //
-				break;
-			default: break;
-			}
-		}
+		write_view_layers(rr, &ls.views[view]);
 
 		render_gfx_end_view(rr);
 
 		render_gfx_end_target(rr);
+
+		render_gfx_write_timestamp(rr, RENDER_TIMESTAMP_PHASE_SQUASH, view, true);
 	}
 
 
@@ -723,6 +857,8 @@ do_mesh(struct render_gfx *rr,
 		// Convenience.
 		const struct render_viewport_data *viewport_data = &d->views[i].target_viewport_data;
 
+		render_gfx_write_timestamp(rr, RENDER_TIMESTAMP_PHASE_DISTORTION, i, false);
+
 		render_gfx_begin_view( //
 		    rr,                //
 		    i,                 // view_index
@@ -735,6 +871,8 @@ do_mesh(struct render_gfx *rr,
 		    do_timewarp);          // do_timewarp
 
 		render_gfx_end_view(rr);
+
+		render_gfx_write_timestamp(rr, RENDER_TIMESTAMP_PHASE_DISTORTION, i, true);
 	}
 
 	render_gfx_end_target(rr);
@@ -847,40 +985,65 @@ comp_render_gfx_dispatch(struct render_gfx *rr,
 
 
 		/*
-		 * Layer squashing.
+		 * Layer squashing, skipped if the scratch images already hold it.
 		 */
 
-		do_layers(       //
-		    rr,          // rr
-		    layers,      // layers
-		    layer_count, // layer_count
-		    d);          // d
+		if (!d->reuse_layers) {
+			/*
+			 * The render pass only has the implicit external dependency,
+			 * which doesn't order against earlier reads. Scratch images
+			 * may be reused by the very next frame, so wait for all
+			 * previous work on them.
+			 */
+			cmd_barrier_view_images(                            //
+			    rr->r->vk,                                      //
+			    d,                                              //
+			    rr->r->cmd,                                     // cmd
+			    0,                                              // src_access_mask
+			    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,           // dst_access_mask
+			    VK_IMAGE_LAYOUT_UNDEFINED,                      // transition_from
+			    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,       // transition_to
+			    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,             // src_stage_mask
+			    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT); // dst_stage_mask
+
+			do_layers(       //
+			    rr,          // rr
+			    layers,      // layers
+			    layer_count, // layer_count
+			    d);          // d
+
+			VkImageLayout transition_from = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			VkImageLayout transition_to = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			cmd_barrier_view_images(                           //
+			    rr->r->vk,                                     //
+			    d,                                             //
+			    rr->r->cmd,                                    // cmd
+			    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,          // src_access_mask
+			    VK_ACCESS_SHADER_READ_BIT,                     // dst_access_mask
+			    transition_from,                               // transition_from
+			    transition_to,                                 // transition_to
+			    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // src_stage_mask
+			    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);        // dst_stage_mask
+		}
 
 
 		/*
 		 * Distortion.
 		 */
 
-		VkImageLayout transition_from = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-		VkImageLayout transition_to = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-		cmd_barrier_view_images(                           //
-		    rr->r->vk,                                     //
-		    d,                                             //
-		    rr->r->cmd,                                    // cmd
-		    VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,          // src_access_mask
-		    VK_ACCESS_SHADER_READ_BIT,                     // dst_access_mask
-		    transition_from,                               // transition_from
-		    transition_to,                                 // transition_to
-		    VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, // src_stage_mask
-		    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);        // dst_stage_mask
-
 		// Shared between all views.
 		VkSampler clamp_to_border_black = rr->r->samplers.clamp_to_border_black;
 
+		// A fresh squash was done with the new poses, only reused ones needs timewarp.
+		bool do_timewarp = d->reuse_layers && d->do_timewarp;
+
 		struct gfx_mesh_data md = XRT_STRUCT_INIT;
 		for (uint32_t i = 0; i < d->view_count; i++) {
 			struct xrt_pose src_pose = d->views[i].world_pose;
+			if (d->reuse_layers) {
+				src_pose = d->views[i].layer_world_pose;
+			}
 			struct xrt_fov src_fov = d->views[i].fov;
 			VkImageView src_image_view = d->views[i].srgb_view;
 			struct xrt_normalized_rect src_norm_rect = d->views[i].layer_norm_rect;
@@ -895,11 +1058,10 @@ comp_render_gfx_dispatch(struct render_gfx *rr,
 			    src_image_view);       // src_image_view
 		}
 
-		// We are passing in the same old and new poses.
-		do_mesh(   //
-		    rr,    //
-		    false, // do_timewarp
-		    &md,   // md
-		    d);    // d
+		do_mesh(         //
+		    rr,          // rr
+		    do_timewarp, // do_timewarp
+		    &md,         // md
+		    d);          // d
 	}
 }
@@ -73,15 +73,16 @@ indices_init(struct comp_scratch_indices *i)
 }
 
 static inline void
-indices_get(struct comp_scratch_indices *i, uint32_t *out_index)
+indices_get(struct comp_scratch_indices *i, uint32_t count, uint32_t *out_index)
 {
 	assert(i->current == INVALID_INDEX);
+	assert(count > 0 && count <= COMP_SCRATCH_NUM_IMAGES);
 
 	uint32_t current = i->last;
 	if (current == INVALID_INDEX) {
 		current = 0;
 	} else {
-		if (++current >= COMP_SCRATCH_NUM_IMAGES) {
+		if (++current >= count) {
 			current = 0;
 		}
 	}
@@ -134,7 +135,11 @@ struct tmp
 };
 
 static inline bool
-tmp_init_and_create(struct tmp *t, struct vk_bundle *vk, const struct xrt_swapchain_create_info *info)
+tmp_init_and_create(struct tmp *t,
+                    struct vk_bundle *vk,
+                    const struct xrt_swapchain_create_info *info,
+                    enum vk_image_compression compression,
+                    uint32_t count)
 {
 	VkResult ret;
 
@@ -145,8 +150,8 @@ tmp_init_and_create(struct tmp *t, struct vk_bundle *vk, const struct xrt_swapch
 	}
 
 	// Do the allocation.
-	ret = vk_ic_allocate(vk, info, COMP_SCRATCH_NUM_IMAGES, &t->vkic);
-	VK_CHK_WITH_RET(ret, "vk_ic_allocate", false);
+	ret = vk_ic_allocate_with_compression(vk, info, compression, count, &t->vkic);
+	VK_CHK_WITH_RET(ret, "vk_ic_allocate_with_compression", false);
 
 	ret = vk_ic_get_handles(vk, &t->vkic, COMP_SCRATCH_NUM_IMAGES, t->handles);
 	VK_CHK_WITH_GOTO(ret, "vk_ic_get_handles", err_destroy_vkic);
@@ -175,7 +180,7 @@ tmp_init_and_create(struct tmp *t, struct vk_bundle *vk, const struct xrt_swapch
 	    .layerCount = VK_REMAINING_ARRAY_LAYERS,
 	};
 
-	for (uint32_t i = 0; i < COMP_SCRATCH_NUM_IMAGES; i++) {
+	for (uint32_t i = 0; i < count; i++) {
 		VkImage image = t->vkic.images[i].handle;
 
 		ret = vk_create_view_usage( //
@@ -241,6 +246,17 @@ tmp_take(struct tmp *t,
 	U_ZERO(&t->vkic);
 }
 
+static inline VkDeviceSize
+get_native_images_size(const struct xrt_image_native *native_images, uint32_t count)
+{
+	VkDeviceSize size = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		size += native_images[i].size;
+	}
+
+	return size;
+}
+
 static inline void
 tmp_destroy(struct tmp *t, struct vk_bundle *vk)
 {
@@ -269,6 +285,9 @@ comp_scratch_single_images_init(struct comp_scratch_single_images *cssi)
 
 	u_native_images_debug_init(&cssi->unid);
 
+	cssi->category = VK_MEMORY_CATEGORY_SCRATCH;
+	cssi->compression = VK_IMAGE_COMPRESSION_MODE_DEFAULT;
+
 	// Invalid handle may be different to zero.
 	for (uint32_t i = 0; i < COMP_SCRATCH_NUM_IMAGES; i++) {
 		cssi->native_images[i].handle = XRT_GRAPHICS_BUFFER_HANDLE_INVALID;
@@ -276,9 +295,15 @@ comp_scratch_single_images_init(struct comp_scratch_single_images *cssi)
 }
 
 bool
-comp_scratch_single_images_ensure(struct comp_scratch_single_images *cssi, struct vk_bundle *vk, VkExtent2D extent)
+comp_scratch_single_images_ensure(struct comp_scratch_single_images *cssi,
+                                  struct vk_bundle *vk,
+                                  VkExtent2D extent,
+                                  uint32_t image_count)
 {
-	if (cssi->info.width == extent.width && cssi->info.height == extent.height) {
+	assert(image_count > 0 && image_count <= COMP_SCRATCH_NUM_IMAGES);
+
+	if (cssi->info.width == extent.width && cssi->info.height == extent.height &&
+	    cssi->image_count == image_count) {
 		// Our work here is done!
 		return true;
 	}
@@ -287,7 +312,7 @@ comp_scratch_single_images_ensure(struct comp_scratch_single_images *cssi, struc
 	fill_info(extent, &info);
 
 	struct tmp t; // Is initialized in function.
-	if (!tmp_init_and_create(&t, vk, &info)) {
+	if (!tmp_init_and_create(&t, vk, &info, cssi->compression, image_count)) {
 		VK_ERROR(vk, "Failed to allocate images");
 		return false;
 	}
@@ -298,8 +323,12 @@ comp_scratch_single_images_ensure(struct comp_scratch_single_images *cssi, struc
 	// Copy out images and information.
 	tmp_take(&t, cssi->native_images, cssi->images);
 
+	cssi->tracked_size = get_native_images_size(cssi->native_images, image_count);
+	vk_memory_budget_add(vk, cssi->category, cssi->tracked_size);
+
 	// Generate new unique id for caching and set info.
 	cssi->limited_unique_id = u_limited_unique_id_get();
+	cssi->image_count = image_count;
 	cssi->info = info;
 
 	return true;
@@ -320,8 +349,12 @@ comp_scratch_single_images_free(struct comp_scratch_single_images *cssi, struct
 		DF(Memory, cssi->images[i].device_memory);
 	}
 
+	vk_memory_budget_remove(vk, cssi->category, cssi->tracked_size);
+	cssi->tracked_size = 0;
+
 	// Clear info, so ensure will recreate.
 	U_ZERO(&cssi->info);
+	cssi->image_count = 0;
 
 	// Clear unique id so to force recreate.
 	cssi->limited_unique_id.data = 0;
@@ -333,7 +366,7 @@ comp_scratch_single_images_free(struct comp_scratch_single_images *cssi, struct
 void
 comp_scratch_single_images_get(struct comp_scratch_single_images *cssi, uint32_t *out_index)
 {
-	indices_get(&cssi->indices, out_index);
+	indices_get(&cssi->indices, cssi->image_count, out_index);
 }
 
 void
@@ -348,7 +381,7 @@ comp_scratch_single_images_done(struct comp_scratch_single_images *cssi)
 	    &cssi->unid,             //
 	    cssi->limited_unique_id, //
 	    cssi->native_images,     //
-	    COMP_SCRATCH_NUM_IMAGES, //
+	    cssi->image_count,       //
 	    &cssi->info,             //
 	    last,                    //
 	    false);                  //
@@ -412,12 +445,12 @@ comp_scratch_stereo_images_ensure(struct comp_scratch_stereo_images *cssi, struc
 	fill_info(extent, &info);
 
 	struct tmp ts[2]; // Is initialized in function.
-	if (!tmp_init_and_create(&ts[0], vk, &info)) {
+	if (!tmp_init_and_create(&ts[0], vk, &info, cssi->compression, COMP_SCRATCH_NUM_IMAGES)) {
 		VK_ERROR(vk, "Failed to allocate images for view 0");
 		return false;
 	}
 
-	if (!tmp_init_and_create(&ts[1], vk, &info)) {
+	if (!tmp_init_and_create(&ts[1], vk, &info, cssi->compression, COMP_SCRATCH_NUM_IMAGES)) {
 		VK_ERROR(vk, "Failed to allocate images for view 1");
 		goto err_destroy;
 	}
@@ -435,8 +468,12 @@ comp_scratch_stereo_images_ensure(struct comp_scratch_stereo_images *cssi, struc
 			cssi->rsis[i].extent = extent;
 			cssi->rsis[i].color[view] = images[i];
 		}
+
+		cssi->tracked_size += get_native_images_size(cssi->views[view].native_images, COMP_SCRATCH_NUM_IMAGES);
 	}
 
+	vk_memory_budget_add(vk, VK_MEMORY_CATEGORY_SCRATCH, cssi->tracked_size);
+
 	// Generate new unique id for caching and set info.
 	cssi->limited_unique_id = u_limited_unique_id_get();
 	cssi->info = info;
@@ -470,6 +507,9 @@ comp_scratch_stereo_images_free(struct comp_scratch_stereo_images *cssi, struct
 		}
 	}
 
+	vk_memory_budget_remove(vk, VK_MEMORY_CATEGORY_SCRATCH, cssi->tracked_size);
+	cssi->tracked_size = 0;
+
 	// Clear info, so ensure will recreate.
 	U_ZERO(&cssi->info);
 
@@ -483,7 +523,7 @@ comp_scratch_stereo_images_free(struct comp_scratch_stereo_images *cssi, struct
 void
 comp_scratch_stereo_images_get(struct comp_scratch_stereo_images *cssi, uint32_t *out_index)
 {
-	indices_get(&cssi->indices, out_index);
+	indices_get(&cssi->indices, COMP_SCRATCH_NUM_IMAGES, out_index);
 }
 
 void
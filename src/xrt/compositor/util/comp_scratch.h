@@ -13,6 +13,7 @@
 #include "util/u_native_images_debug.h"
 
 #include "vk/vk_helpers.h"
+#include "vk/vk_image_allocator.h"
 
 #include "render/render_interface.h"
 
@@ -28,7 +29,7 @@ extern "C" {
  *
  */
 
-//! The number of images for each view, works like a swapchain.
+//! The max number of images for each view, works like a swapchain.
 #define COMP_SCRATCH_NUM_IMAGES (4)
 
 
@@ -66,9 +67,12 @@ struct comp_scratch_indices
  */
 struct comp_scratch_single_images
 {
-	//! Images used when rendering.
+	//! Images used when rendering, only the first @ref image_count are valid.
 	struct render_scratch_color_image images[COMP_SCRATCH_NUM_IMAGES];
 
+	//! Number of allocated images, at most @ref COMP_SCRATCH_NUM_IMAGES.
+	uint32_t image_count;
+
 	//! To connect to the debug UI.
 	struct u_native_images_debug unid;
 
@@ -83,6 +87,15 @@ struct comp_scratch_single_images
 
 	//! Process unique id, used for caching.
 	xrt_limited_unique_id_t limited_unique_id;
+
+	//! What the memory is accounted as, set after init if not scratch.
+	enum vk_memory_category category;
+
+	//! Compression to ask for, set after init, must be default if exported.
+	enum vk_image_compression compression;
+
+	//! Size of the images added to the @ref vk_memory_budget.
+	VkDeviceSize tracked_size;
 };
 
 /*!
@@ -97,12 +110,19 @@ void
 comp_scratch_single_images_init(struct comp_scratch_single_images *cssi);
 
 /*!
- * Ensure that the scratch images are allocated and match @p extent size.
+ * Ensure that the scratch images are allocated, match @p extent size and that
+ * there are @p image_count of them. Fewer images uses less memory, but the
+ * next frame will then render to a image the current frame might still be
+ * reading from, which the render code handles with barriers. A count of one
+ * is only valid if the images are never kept over to the next frame.
  *
  * @ingroup comp_util
  */
 bool
-comp_scratch_single_images_ensure(struct comp_scratch_single_images *cssi, struct vk_bundle *vk, VkExtent2D extent);
+comp_scratch_single_images_ensure(struct comp_scratch_single_images *cssi,
+                                  struct vk_bundle *vk,
+                                  VkExtent2D extent,
+                                  uint32_t image_count);
 
 /*!
  * Free all images allocated, @p init must be called before calling this
@@ -193,6 +213,12 @@ struct comp_scratch_stereo_images
 
 	//! Process unique id, used for caching.
 	xrt_limited_unique_id_t limited_unique_id;
+
+	//! Compression to ask for, set after init, must be default if exported.
+	enum vk_image_compression compression;
+
+	//! Size of the images added to the @ref vk_memory_budget.
+	VkDeviceSize tracked_size;
 };
 
 void
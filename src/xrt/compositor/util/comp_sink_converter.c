@@ -0,0 +1,681 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Frame sink that converts camera frames on the GPU.
+ *
+ * The frame is copied into a host visible storage buffer, the compute shader
+ * reads the packed bytes from it and writes RGBA to a storage image, which is
+ * then copied to a linear image from @ref vk_image_readback_to_xf_pool that is
+ * pushed downstream as the converted frame.
+ *
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup comp_util
+ */
+
+#include "os/os_threading.h"
+
+#include "util/u_misc.h"
+#include "util/u_format.h"
+#include "util/u_logging.h"
+#include "util/u_trace_marker.h"
+
+#include "vk/vk_cmd.h"
+#include "vk/vk_cmd_pool.h"
+#include "vk/vk_mini_helpers.h"
+#include "vk/vk_image_readback_to_xf_pool.h"
+
+#include "render/render_interface.h"
+
+#include "util/comp_sink_converter.h"
+
+#include <string.h>
+
+
+/*!
+ * Input formats of the shader, must match the defines in camera_convert.comp.
+ */
+enum shader_format
+{
+	SHADER_FORMAT_L8 = 0,
+	SHADER_FORMAT_YUYV422 = 1,
+	SHADER_FORMAT_UYVY422 = 2,
+	SHADER_FORMAT_YUV888 = 3,
+	SHADER_FORMAT_BAYER_GR8 = 4,
+};
+
+/*!
+ * Push constants of camera_convert.comp.
+ */
+struct push_data
+{
+	uint32_t format;
+	uint32_t stride;
+	uint32_t scale;
+	uint32_t _pad;
+	uint32_t extent[2];
+};
+
+/*!
+ * A sink that converts frames with a compute shader.
+ *
+ * @implements xrt_frame_sink
+ * @implements xrt_frame_node
+ */
+struct comp_sink_converter
+{
+	struct xrt_frame_sink base;
+	struct xrt_frame_node node;
+
+	struct xrt_frame_sink *downstream;
+
+	struct vk_bundle *vk;
+
+	//! Each target pixel is the average of this many source pixels squared.
+	uint32_t downscale;
+
+	//! Serialises frames pushed from different threads, the pool is in ring mode.
+	struct os_mutex mutex;
+
+	struct vk_cmd_pool cmd_pool;
+
+	VkDescriptorPool descriptor_pool;
+	VkDescriptorSetLayout descriptor_set_layout;
+	VkDescriptorSet descriptor_set;
+	VkPipelineLayout pipeline_layout;
+	VkPipelineCache pipeline_cache;
+	VkPipeline pipeline;
+
+	//! The frame is copied here for the shader to read.
+	struct render_buffer upload;
+
+	//! Written by the shader and copied to the readback images.
+	struct
+	{
+		VkExtent2D extent;
+		VkDeviceMemory memory;
+		VkImage image;
+		VkImageView view;
+	} target;
+
+	//! Created with the target image, frames are pushed from this.
+	struct vk_image_readback_to_xf_pool *readback;
+};
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static void
+converter_fini(struct comp_sink_converter *s);
+
+/*!
+ * If `COND` is not VK_SUCCESS returns false.
+ */
+#define C(c)                                                                                                           \
+	do {                                                                                                           \
+		VkResult ret = c;                                                                                      \
+		if (ret != VK_SUCCESS) {                                                                               \
+			converter_fini(s);                                                                             \
+			return false;                                                                                  \
+		}                                                                                                      \
+	} while (false)
+
+static bool
+get_shader_format(const struct xrt_frame *xf, enum shader_format *out_format, VkExtent2D *out_extent)
+{
+	VkExtent2D extent = {xf->width, xf->height};
+
+	switch (xf->format) {
+	case XRT_FORMAT_L8: *out_format = SHADER_FORMAT_L8; break;
+	case XRT_FORMAT_YUYV422: *out_format = SHADER_FORMAT_YUYV422; break;
+	case XRT_FORMAT_UYVY422: *out_format = SHADER_FORMAT_UYVY422; break;
+	case XRT_FORMAT_YUV888: *out_format = SHADER_FORMAT_YUV888; break;
+	case XRT_FORMAT_BAYER_GR8:
+		*out_format = SHADER_FORMAT_BAYER_GR8;
+		extent.width /= 2;
+		extent.height /= 2;
+		break;
+	default: return false;
+	}
+
+	*out_extent = extent;
+
+	return true;
+}
+
+static void
+release_readback(struct vk_image_readback_to_xf *wrap)
+{
+	struct xrt_frame *xf = &wrap->base_frame;
+	xrt_frame_reference(&xf, NULL);
+}
+
+static VkResult
+create_descriptor_set_layout(struct vk_bundle *vk, VkDescriptorSetLayout *out_descriptor_set_layout)
+{
+	VkResult ret;
+
+	VkDescriptorSetLayoutBinding set_layout_bindings[2] = {
+	    {
+	        .binding = 0,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	        .descriptorCount = 1,
+	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	    },
+	    {
+	        .binding = 1,
+	        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+	        .descriptorCount = 1,
+	        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	    },
+	};
+
+	VkDescriptorSetLayoutCreateInfo set_layout_info = {
+	    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+	    .bindingCount = ARRAY_SIZE(set_layout_bindings),
+	    .pBindings = set_layout_bindings,
+	};
+
+	VkDescriptorSetLayout descriptor_set_layout = VK_NULL_HANDLE;
+	ret = vk->vkCreateDescriptorSetLayout( //
+	    vk->device,                        //
+	    &set_layout_info,                  //
+	    NULL,                              //
+	    &descriptor_set_layout);           //
+	VK_CHK_AND_RET(ret, "vkCreateDescriptorSetLayout");
+
+	*out_descriptor_set_layout = descriptor_set_layout;
+
+	return VK_SUCCESS;
+}
+
+static VkResult
+create_pipeline_layout(struct vk_bundle *vk,
+                       VkDescriptorSetLayout descriptor_set_layout,
+                       VkPipelineLayout *out_pipeline_layout)
+{
+	VkResult ret;
+
+	VkPipelineLayoutCreateInfo pipeline_layout_info = {
+	    .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+	    .flags = 0,
+	    .setLayoutCount = 1,
+	    .pSetLayouts = &descriptor_set_layout,
+	    .pushConstantRangeCount = 1,
+	    .pPushConstantRanges =
+	        &(VkPushConstantRange){
+	            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+	            .offset = 0,
+	            .size = sizeof(struct push_data),
+	        },
+	};
+
+	VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+	ret = vk->vkCreatePipelineLayout( //
+	    vk->device,                   // device
+	    &pipeline_layout_info,        // pCreateInfo
+	    NULL,                         // pAllocator
+	    &pipeline_layout);            // pPipelineLayout
+	VK_CHK_AND_RET(ret, "vkCreatePipelineLayout");
+
+	*out_pipeline_layout = pipeline_layout;
+
+	return VK_SUCCESS;
+}
+
+static bool
+ensure_upload(struct comp_sink_converter *s, VkDeviceSize size)
+{
+	struct vk_bundle *vk = s->vk;
+	VkResult ret;
+
+	// The shader reads whole words.
+	size = (size + 3) & ~(VkDeviceSize)3;
+
+	if (s->upload.buffer != VK_NULL_HANDLE && s->upload.size >= size) {
+		return true;
+	}
+
+	render_buffer_close(vk, &s->upload);
+
+	const VkMemoryPropertyFlags memory_property_flags = //
+	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |           //
+	    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;           //
+
+	ret = render_buffer_init(               //
+	    vk,                                 // vk_bundle
+	    &s->upload,                         // buffer
+	    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, // usage_flags
+	    memory_property_flags,              // memory_property_flags
+	    size);                              // size
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "render_buffer_init: %s", vk_result_string(ret));
+		return false;
+	}
+
+	VK_NAME_BUFFER(vk, s->upload.buffer, "comp_sink_converter upload buffer");
+
+	ret = render_buffer_map(vk, &s->upload);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "render_buffer_map: %s", vk_result_string(ret));
+		render_buffer_close(vk, &s->upload);
+		return false;
+	}
+
+	VkDescriptorBufferInfo buffer_info = {
+	    .buffer = s->upload.buffer,
+	    .offset = 0,
+	    .range = VK_WHOLE_SIZE,
+	};
+
+	VkWriteDescriptorSet write_descriptor_set = {
+	    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	    .dstSet = s->descriptor_set,
+	    .dstBinding = 0,
+	    .descriptorCount = 1,
+	    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	    .pBufferInfo = &buffer_info,
+	};
+
+	// Every submit is waited on, so the set is not in use.
+	vk->vkUpdateDescriptorSets(vk->device, 1, &write_descriptor_set, 0, NULL);
+
+	return true;
+}
+
+static bool
+ensure_target(struct comp_sink_converter *s, VkExtent2D extent)
+{
+	struct vk_bundle *vk = s->vk;
+	VkResult ret;
+
+	if (s->target.image != VK_NULL_HANDLE) {
+		/*
+		 * Downstream may hold frames from the readback pool, so it
+		 * can't be recreated for a new size.
+		 */
+		return s->target.extent.width == extent.width && s->target.extent.height == extent.height;
+	}
+
+	const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+	const VkImageUsageFlags usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+	ret = vk_create_image_simple( //
+	    vk,                       // vk_bundle
+	    extent,                   // extent
+	    format,                   // format
+	    usage,                    // usage
+	    &s->target.memory,        // out_mem
+	    &s->target.image);        // out_image
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_create_image_simple: %s", vk_result_string(ret));
+		return false;
+	}
+
+	VK_NAME_IMAGE(vk, s->target.image, "comp_sink_converter target image");
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	ret = vk_create_view(      //
+	    vk,                    // vk_bundle
+	    s->target.image,       // image
+	    VK_IMAGE_VIEW_TYPE_2D, // type
+	    format,                // format
+	    subresource_range,     // subresource_range
+	    &s->target.view);      // out_view
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_create_view: %s", vk_result_string(ret));
+		return false;
+	}
+
+	VK_NAME_IMAGE_VIEW(vk, s->target.view, "comp_sink_converter target image view");
+
+	VkDescriptorImageInfo image_info = {
+	    .imageView = s->target.view,
+	    .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+	};
+
+	VkWriteDescriptorSet write_descriptor_set = {
+	    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+	    .dstSet = s->descriptor_set,
+	    .dstBinding = 1,
+	    .descriptorCount = 1,
+	    .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+	    .pImageInfo = &image_info,
+	};
+
+	vk->vkUpdateDescriptorSets(vk->device, 1, &write_descriptor_set, 0, NULL);
+
+	vk_image_readback_to_xf_pool_create( //
+	    vk,                              // vk_bundle
+	    extent,                          // extent
+	    &s->readback,                    // out_pool
+	    XRT_FORMAT_R8G8B8X8,             // xrt_format
+	    format);                         // vk_format
+
+	s->target.extent = extent;
+
+	return true;
+}
+
+static bool
+convert(struct comp_sink_converter *s,
+        struct xrt_frame *xf,
+        enum shader_format format,
+        VkExtent2D extent,
+        struct xrt_frame **out_frame)
+{
+	SINK_TRACE_MARKER();
+
+	struct vk_bundle *vk = s->vk;
+	struct vk_image_readback_to_xf *wrap = NULL;
+	VkResult ret;
+
+	if (!vk_image_readback_to_xf_pool_get_unused_frame(vk, s->readback, &wrap)) {
+		return false;
+	}
+
+	// Upload the frame.
+	memcpy(s->upload.mapped, xf->data, xf->size);
+
+	VkCommandBuffer cmd;
+	ret = vk_cmd_pool_ring_begin_cmd_buffer(vk, &s->cmd_pool, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, &cmd);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_cmd_pool_ring_begin_cmd_buffer: %s", vk_result_string(ret));
+		release_readback(wrap);
+		return false;
+	}
+
+	VK_NAME_COMMAND_BUFFER(vk, cmd, "comp_sink_converter command buffer");
+
+	VkImageSubresourceRange first_color_level_subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	// The old content is not needed, the shader writes every pixel.
+	vk_cmd_image_barrier_locked(              //
+	    vk,                                   // vk_bundle
+	    cmd,                                  // cmdbuffer
+	    s->target.image,                      // image
+	    0,                                    // srcAccessMask
+	    VK_ACCESS_SHADER_WRITE_BIT,           // dstAccessMask
+	    VK_IMAGE_LAYOUT_UNDEFINED,            // oldImageLayout
+	    VK_IMAGE_LAYOUT_GENERAL,              // newImageLayout
+	    VK_PIPELINE_STAGE_TRANSFER_BIT,       // srcStageMask
+	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, // dstStageMask
+	    first_color_level_subresource_range); // subresourceRange
+
+	vk->vkCmdBindPipeline(              //
+	    cmd,                            // commandBuffer
+	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
+	    s->pipeline);                   // pipeline
+
+	vk->vkCmdBindDescriptorSets(        //
+	    cmd,                            // commandBuffer
+	    VK_PIPELINE_BIND_POINT_COMPUTE, // pipelineBindPoint
+	    s->pipeline_layout,             // layout
+	    0,                              // firstSet
+	    1,                              // descriptorSetCount
+	    &s->descriptor_set,             // pDescriptorSets
+	    0,                              // dynamicOffsetCount
+	    NULL);                          // pDynamicOffsets
+
+	struct push_data constants = {
+	    .format = format,
+	    .stride = (uint32_t)xf->stride,
+	    .scale = s->downscale,
+	    .extent = {extent.width, extent.height},
+	};
+
+	vk->vkCmdPushConstants(          //
+	    cmd,                         //
+	    s->pipeline_layout,          //
+	    VK_SHADER_STAGE_COMPUTE_BIT, //
+	    0,                           //
+	    sizeof(constants),           //
+	    &constants);                 //
+
+	vk->vkCmdDispatch(           //
+	    cmd,                     // commandBuffer
+	    (extent.width + 7) / 8,  // groupCountX
+	    (extent.height + 7) / 8, // groupCountY
+	    1);                      // groupCountZ
+
+	struct vk_cmd_copy_image_info copy_info = {
+	    .src.old_layout = VK_IMAGE_LAYOUT_GENERAL,
+	    .src.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+	    .src.src_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	    .src.fm_image.aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .src.fm_image.image = s->target.image,
+
+	    .dst.old_layout = wrap->layout,
+	    .dst.src_access_mask = VK_ACCESS_HOST_READ_BIT,
+	    .dst.src_stage_mask = VK_PIPELINE_STAGE_HOST_BIT,
+	    .dst.fm_image.aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .dst.fm_image.image = wrap->image,
+
+	    .size.w = extent.width,
+	    .size.h = extent.height,
+	};
+
+	vk_cmd_copy_image_locked(vk, cmd, &copy_info);
+
+	// Barrier readback image to host so we can safely read.
+	vk_cmd_image_barrier_locked(              //
+	    vk,                                   // vk_bundle
+	    cmd,                                  // cmdbuffer
+	    wrap->image,                          // image
+	    VK_ACCESS_TRANSFER_WRITE_BIT,         // srcAccessMask
+	    VK_ACCESS_HOST_READ_BIT,              // dstAccessMask
+	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, // oldImageLayout
+	    VK_IMAGE_LAYOUT_GENERAL,              // newImageLayout
+	    VK_PIPELINE_STAGE_TRANSFER_BIT,       // srcStageMask
+	    VK_PIPELINE_STAGE_HOST_BIT,           // dstStageMask
+	    first_color_level_subresource_range); // subresourceRange
+
+	// Done writing commands, submit to queue, waits for command to finish.
+	ret = vk_cmd_pool_ring_end_and_submit_cmd_buffer(vk, &s->cmd_pool, cmd, true);
+	if (ret != VK_SUCCESS) {
+		VK_ERROR(vk, "vk_cmd_pool_ring_end_and_submit_cmd_buffer: %s", vk_result_string(ret));
+		release_readback(wrap);
+		return false;
+	}
+
+	struct xrt_frame *frame = &wrap->base_frame;
+	frame->timestamp = xf->timestamp;
+	frame->source_timestamp = xf->source_timestamp;
+	frame->source_sequence = xf->source_sequence;
+	frame->source_id = xf->source_id;
+	frame->stereo_format = xf->stereo_format;
+
+	*out_frame = frame;
+
+	return true;
+}
+
+static void
+converter_fini(struct comp_sink_converter *s)
+{
+	struct vk_bundle *vk = s->vk;
+
+	// Every submit is waited on, nothing is in flight.
+	vk_image_readback_to_xf_pool_destroy(vk, &s->readback);
+
+	D(ImageView, s->target.view);
+	D(Image, s->target.image);
+	DF(Memory, s->target.memory);
+
+	render_buffer_close(vk, &s->upload);
+
+	D(Pipeline, s->pipeline);
+	D(PipelineLayout, s->pipeline_layout);
+	D(PipelineCache, s->pipeline_cache);
+	D(DescriptorPool, s->descriptor_pool);
+	D(DescriptorSetLayout, s->descriptor_set_layout);
+
+	if (s->cmd_pool.pool != VK_NULL_HANDLE) {
+		vk_cmd_pool_destroy(vk, &s->cmd_pool);
+	}
+
+	os_mutex_destroy(&s->mutex);
+	free(s);
+}
+
+
+/*
+ *
+ * Sink and node functions.
+ *
+ */
+
+static void
+converter_push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	SINK_TRACE_MARKER();
+
+	struct comp_sink_converter *s = container_of(xfs, struct comp_sink_converter, base);
+
+	enum shader_format format;
+	VkExtent2D extent;
+	if (!get_shader_format(xf, &format, &extent)) {
+		xrt_sink_push_frame(s->downstream, xf);
+		return;
+	}
+
+	extent.width /= s->downscale;
+	extent.height /= s->downscale;
+	if (extent.width == 0 || extent.height == 0) {
+		return;
+	}
+
+	struct xrt_frame *converted = NULL;
+
+	os_mutex_lock(&s->mutex);
+
+	bool ok = ensure_target(s, extent) && ensure_upload(s, xf->size) && convert(s, xf, format, extent, &converted);
+
+	os_mutex_unlock(&s->mutex);
+
+	if (!ok) {
+		U_LOG_W("Could not convert %ux%u %s frame on the GPU!", xf->width, xf->height,
+		        u_format_str(xf->format));
+		return;
+	}
+
+	xrt_sink_push_frame(s->downstream, converted);
+
+	xrt_frame_reference(&converted, NULL);
+}
+
+static void
+converter_break_apart(struct xrt_frame_node *node)
+{
+	// Noop
+}
+
+static void
+converter_destroy(struct xrt_frame_node *node)
+{
+	struct comp_sink_converter *s = container_of(node, struct comp_sink_converter, node);
+
+	converter_fini(s);
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+bool
+comp_sink_converter_create(struct vk_bundle *vk,
+                           struct render_shaders *shaders,
+                           struct xrt_frame_context *xfctx,
+                           uint32_t downscale,
+                           struct xrt_frame_sink *downstream,
+                           struct xrt_frame_sink **out_xfs)
+{
+	struct comp_sink_converter *s = U_TYPED_CALLOC(struct comp_sink_converter);
+	s->base.push_frame = converter_push_frame;
+	s->node.break_apart = converter_break_apart;
+	s->node.destroy = converter_destroy;
+	s->downstream = downstream;
+	s->vk = vk;
+	s->downscale = downscale > 0 ? downscale : 1;
+
+	if (os_mutex_init(&s->mutex) != 0) {
+		free(s);
+		return false;
+	}
+
+	// Only used with the mutex held and each conversion is waited on.
+	C(vk_cmd_pool_init_ring(vk, &s->cmd_pool, 1));
+
+	VK_NAME_COMMAND_POOL(vk, s->cmd_pool.pool, "comp_sink_converter command pool");
+
+	struct vk_descriptor_pool_info pool_info = {
+	    .uniform_per_descriptor_count = 0,
+	    .sampler_per_descriptor_count = 0,
+	    .storage_image_per_descriptor_count = 1,
+	    .storage_buffer_per_descriptor_count = 1,
+	    .descriptor_count = 1,
+	    .freeable = false,
+	};
+
+	C(vk_create_descriptor_pool( //
+	    vk,                      // vk_bundle
+	    &pool_info,              // info
+	    &s->descriptor_pool));   // out_descriptor_pool
+
+	VK_NAME_DESCRIPTOR_POOL(vk, s->descriptor_pool, "comp_sink_converter descriptor pool");
+
+	C(create_descriptor_set_layout(vk, &s->descriptor_set_layout));
+
+	VK_NAME_DESCRIPTOR_SET_LAYOUT(vk, s->descriptor_set_layout, "comp_sink_converter descriptor set layout");
+
+	C(vk_create_descriptor_set(   //
+	    vk,                       // vk_bundle
+	    s->descriptor_pool,       // descriptor_pool
+	    s->descriptor_set_layout, // descriptor_set_layout
+	    &s->descriptor_set));     // out_descriptor_set
+
+	C(create_pipeline_layout(     //
+	    vk,                       // vk_bundle
+	    s->descriptor_set_layout, // descriptor_set_layout
+	    &s->pipeline_layout));    // out_pipeline_layout
+
+	VK_NAME_PIPELINE_LAYOUT(vk, s->pipeline_layout, "comp_sink_converter pipeline layout");
+
+	C(vk_create_pipeline_cache(vk, &s->pipeline_cache));
+
+	C(vk_create_compute_pipeline(     //
+	    vk,                           // vk_bundle
+	    s->pipeline_cache,            // pipeline_cache
+	    shaders->camera_convert_comp, // shader
+	    s->pipeline_layout,           // pipeline_layout
+	    NULL,                         // specialization_info
+	    &s->pipeline));               // out_compute_pipeline
+
+	VK_NAME_PIPELINE(vk, s->pipeline, "comp_sink_converter pipeline");
+
+	xrt_frame_context_add(xfctx, &s->node);
+
+	*out_xfs = &s->base;
+
+	return true;
+}
@@ -0,0 +1,48 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Frame sink that converts camera frames on the GPU.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup comp_util
+ */
+
+#pragma once
+
+#include "xrt/xrt_frame.h"
+
+#include "vk/vk_helpers.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct render_shaders;
+
+
+/*!
+ * Create a sink that converts L8, YUYV422, UYVY422, YUV888 and BAYER_GR8 frames
+ * to R8G8B8X8 frames with a compute shader, and optionally downscales them by
+ * @p downscale with a box filter. Bayer frames are demosaiced to half size
+ * before downscaling, like the CPU converter does. Other formats are passed
+ * through unchanged.
+ *
+ * The frame is uploaded, converted and read back before the push returns, put
+ * a @ref u_sink_queue_create in front of it to not stall the camera thread.
+ * Both @p vk and @p shaders must outlive the frame context.
+ *
+ * @ingroup comp_util
+ */
+bool
+comp_sink_converter_create(struct vk_bundle *vk,
+                           struct render_shaders *shaders,
+                           struct xrt_frame_context *xfctx,
+                           uint32_t downscale,
+                           struct xrt_frame_sink *downstream,
+                           struct xrt_frame_sink **out_xfs);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -13,6 +13,7 @@
 #include "xrt/xrt_results.h"
 
 #include "util/u_misc.h"
+#include "util/u_debug.h"
 #include "util/u_handles.h"
 #include "util/u_trace_marker.h"
 #include "util/u_limited_unique_id.h"
@@ -31,6 +32,201 @@
 #include <errno.h>
 
 
+DEBUG_GET_ONCE_NUM_OPTION(image_pool_budget_mb, "XRT_COMPOSITOR_SWAPCHAIN_POOL_BUDGET_MB", 0)
+
+
+/*
+ *
+ * Image pool functions.
+ *
+ */
+
+static bool
+create_info_equal(const struct xrt_swapchain_create_info *a, const struct xrt_swapchain_create_info *b)
+{
+	if (a->create != b->create || a->bits != b->bits || a->format != b->format ||
+	    a->sample_count != b->sample_count || a->width != b->width || a->height != b->height ||
+	    a->face_count != b->face_count || a->array_size != b->array_size || a->mip_count != b->mip_count ||
+	    a->format_count != b->format_count) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < a->format_count; i++) {
+		if (a->formats[i] != b->formats[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static VkDeviceSize
+get_collection_size(const struct vk_image_collection *vkic)
+{
+	VkDeviceSize size = 0;
+	for (uint32_t i = 0; i < vkic->image_count; i++) {
+		size += vkic->images[i].size;
+	}
+
+	return size;
+}
+
+//! Destroys the images and removes them from the memory accounting.
+static void
+destroy_collection(struct vk_bundle *vk, enum vk_memory_category category, struct vk_image_collection *vkic)
+{
+	vk_memory_budget_remove(vk, category, get_collection_size(vkic));
+	vk_ic_destroy(vk, vkic);
+}
+
+//! Must be called with the pool mutex held.
+static void
+image_pool_remove_locked(struct comp_swapchain_shared *cscs, uint32_t index, struct vk_image_collection *out_vkic)
+{
+	struct vk_image_collection *entries = cscs->image_pool.entries;
+
+	*out_vkic = entries[index];
+	cscs->image_pool.size -= get_collection_size(out_vkic);
+
+	// Keep the oldest first order.
+	for (uint32_t i = index + 1; i < cscs->image_pool.entry_count; i++) {
+		entries[i - 1] = entries[i];
+	}
+
+	cscs->image_pool.entry_count--;
+	U_ZERO(&entries[cscs->image_pool.entry_count]);
+}
+
+/*!
+ * Try to take a collection with the exact same create info and image count
+ * from the pool, the newest matching entry is used.
+ */
+static bool
+image_pool_take(struct comp_swapchain_shared *cscs,
+                const struct xrt_swapchain_create_info *info,
+                uint32_t image_count,
+                struct vk_image_collection *out_vkic)
+{
+	bool found = false;
+
+	os_mutex_lock(&cscs->image_pool.mutex);
+
+	for (uint32_t i = cscs->image_pool.entry_count; i-- > 0;) {
+		const struct vk_image_collection *vkic = &cscs->image_pool.entries[i];
+
+		if (vkic->image_count != image_count || !create_info_equal(&vkic->info, info)) {
+			continue;
+		}
+
+		image_pool_remove_locked(cscs, i, out_vkic);
+		found = true;
+		break;
+	}
+
+	os_mutex_unlock(&cscs->image_pool.mutex);
+
+	return found;
+}
+
+/*!
+ * Gives the images to the pool, the oldest entries are freed to keep the pool
+ * within budget. If the collection is larger than the budget, or the device is
+ * low on memory, it's destroyed.
+ */
+static void
+image_pool_put(struct comp_swapchain_shared *cscs, struct vk_bundle *vk, struct vk_image_collection *vkic)
+{
+	VkDeviceSize size = get_collection_size(vkic);
+
+	if (size > cscs->image_pool.budget) {
+		destroy_collection(vk, VK_MEMORY_CATEGORY_SWAPCHAIN, vkic);
+		return;
+	}
+
+	// Don't hold on to idle images when memory is needed elsewhere.
+	struct vk_memory_budget_status status;
+	vk_memory_budget_query(vk, 0, &status);
+	if (status.pressure != VK_MEMORY_PRESSURE_NONE) {
+		VK_DEBUG(vk, "Not pooling swapchain images, memory pressure is %s",
+		         vk_memory_pressure_string(status.pressure));
+		destroy_collection(vk, VK_MEMORY_CATEGORY_SWAPCHAIN, vkic);
+		return;
+	}
+
+	os_mutex_lock(&cscs->image_pool.mutex);
+
+	while (cscs->image_pool.entry_count > 0 &&
+	       (cscs->image_pool.entry_count >= ARRAY_SIZE(cscs->image_pool.entries) ||
+	        cscs->image_pool.size + size > cscs->image_pool.budget)) {
+		struct vk_image_collection oldest;
+		image_pool_remove_locked(cscs, 0, &oldest);
+		destroy_collection(vk, VK_MEMORY_CATEGORY_SWAPCHAIN_POOL, &oldest);
+	}
+
+	cscs->image_pool.entries[cscs->image_pool.entry_count++] = *vkic;
+	cscs->image_pool.size += size;
+	vk_memory_budget_move(vk, VK_MEMORY_CATEGORY_SWAPCHAIN, VK_MEMORY_CATEGORY_SWAPCHAIN_POOL, size);
+
+	VK_DEBUG(vk, "Pooled swapchain images, %" PRIu32 " entries using %" PRIu64 " bytes", //
+	         cscs->image_pool.entry_count, (uint64_t)cscs->image_pool.size);
+
+	os_mutex_unlock(&cscs->image_pool.mutex);
+
+	// Ownership has been transferred to the pool.
+	U_ZERO(vkic);
+}
+
+static void
+image_pool_trim(struct comp_swapchain_shared *cscs, struct vk_bundle *vk)
+{
+	os_mutex_lock(&cscs->image_pool.mutex);
+
+	while (cscs->image_pool.entry_count > 0) {
+		struct vk_image_collection vkic;
+		image_pool_remove_locked(cscs, cscs->image_pool.entry_count - 1, &vkic);
+		destroy_collection(vk, VK_MEMORY_CATEGORY_SWAPCHAIN_POOL, &vkic);
+	}
+
+	os_mutex_unlock(&cscs->image_pool.mutex);
+}
+
+/*!
+ * Applies the memory pressure policies before allocating a new swapchain,
+ * first the pool is emptied and if that isn't enough the swapchain is denied.
+ */
+static xrt_result_t
+check_memory_pressure(struct comp_swapchain_shared *cscs,
+                      struct vk_bundle *vk,
+                      const struct xrt_swapchain_create_info *info)
+{
+	struct vk_memory_budget_status status;
+	vk_memory_budget_query(vk, 0, &status);
+	if (status.pressure == VK_MEMORY_PRESSURE_NONE) {
+		return XRT_SUCCESS;
+	}
+
+	// Idle pooled images are the cheapest thing to give back.
+	image_pool_trim(cscs, vk);
+
+	vk_memory_budget_query(vk, 0, &status);
+	if (status.pressure != VK_MEMORY_PRESSURE_CRITICAL) {
+		return XRT_SUCCESS;
+	}
+
+	uint64_t usage_mb = status.usage_bytes / (1024 * 1024);
+	uint64_t budget_mb = status.budget_bytes / (1024 * 1024);
+	uint64_t swapchain_mb = vk_memory_budget_get_category(vk, VK_MEMORY_CATEGORY_SWAPCHAIN) / (1024 * 1024);
+
+	VK_ERROR(vk,
+	         "Denying %" PRIu32 "x%" PRIu32 " swapchain, device memory is critically low: %" PRIu64 " of %" PRIu64
+	         " MiB in use, %" PRIu64 " MiB of it by swapchains. Close other applications or destroy unused "
+	         "swapchains, the limits are set with XRT_COMPOSITOR_VRAM_*.",
+	         info->width, info->height, usage_mb, budget_mb, swapchain_mb);
+
+	return XRT_ERROR_ALLOCATION;
+}
+
+
 /*
  *
  * Swapchain member functions.
@@ -209,6 +405,7 @@ swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 	int res = u_index_fifo_push(&sc->fifo, index);
 
 	if (res >= 0) {
+		xrt_atomic_s32_inc_return(&sc->release_count);
 		return XRT_SUCCESS;
 	}
 	// FIFO full
@@ -514,8 +711,24 @@ comp_swapchain_create_init(struct comp_swapchain *sc,
 
 	set_common_fields(sc, destroy_func, vk, cscs, xsccp->image_count);
 
-	// Use the image helper to allocate the images.
-	ret = vk_ic_allocate(vk, info, xsccp->image_count, &sc->vkic);
+	// Reuse the images of a destroyed swapchain if possible.
+	if (image_pool_take(cscs, info, xsccp->image_count, &sc->vkic)) {
+		VK_DEBUG(vk, "Reusing pooled images for %p", (void *)sc);
+		vk_memory_budget_move(vk, VK_MEMORY_CATEGORY_SWAPCHAIN_POOL, VK_MEMORY_CATEGORY_SWAPCHAIN,
+		                      get_collection_size(&sc->vkic));
+		ret = VK_SUCCESS;
+	} else {
+		xrt_result_t xret = check_memory_pressure(cscs, vk, info);
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+
+		// Use the image helper to allocate the images.
+		ret = vk_ic_allocate(vk, info, xsccp->image_count, &sc->vkic);
+		if (ret == VK_SUCCESS) {
+			vk_memory_budget_add(vk, VK_MEMORY_CATEGORY_SWAPCHAIN, get_collection_size(&sc->vkic));
+		}
+	}
 	if (ret == VK_ERROR_FEATURE_NOT_PRESENT) {
 		return XRT_ERROR_SWAPCHAIN_FLAG_VALID_BUT_UNSUPPORTED;
 	}
@@ -531,7 +744,7 @@ comp_swapchain_create_init(struct comp_swapchain *sc,
 	ret = vk_ic_get_handles(vk, &sc->vkic, ARRAY_SIZE(handles), handles);
 	if (ret != VK_SUCCESS) {
 		VK_ERROR(vk, "Failed to get native handles for images.");
-		vk_ic_destroy(vk, &sc->vkic);
+		destroy_collection(vk, VK_MEMORY_CATEGORY_SWAPCHAIN, &sc->vkic);
 		return XRT_ERROR_VULKAN;
 	}
 	for (uint32_t i = 0; i < sc->vkic.image_count; i++) {
@@ -542,10 +755,13 @@ comp_swapchain_create_init(struct comp_swapchain *sc,
 
 	xrt_result_t res = do_post_create_vulkan_setup(vk, info, sc);
 	if (res != XRT_SUCCESS) {
-		vk_ic_destroy(vk, &sc->vkic);
+		destroy_collection(vk, VK_MEMORY_CATEGORY_SWAPCHAIN, &sc->vkic);
 		return res;
 	}
 
+	// We own the images, not the app, so they can be given to the pool.
+	sc->recyclable = true;
+
 	return XRT_SUCCESS;
 }
 
@@ -615,7 +831,13 @@ comp_swapchain_teardown(struct comp_swapchain *sc)
 		u_graphics_buffer_unref(&sc->base.images[i].handle);
 	}
 
-	vk_ic_destroy(vk, &sc->vkic);
+	// The image cleanup above waited for the device so the images are idle.
+	if (sc->recyclable) {
+		image_pool_put(sc->cscs, vk, &sc->vkic);
+	} else {
+		// Imported, the memory belongs to the app and was never accounted.
+		vk_ic_destroy(vk, &sc->vkic);
+	}
 }
 
 
@@ -634,12 +856,24 @@ comp_swapchain_shared_init(struct comp_swapchain_shared *cscs, struct vk_bundle
 		return XRT_ERROR_VULKAN;
 	}
 
+	int iret = os_mutex_init(&cscs->image_pool.mutex);
+	if (iret != 0) {
+		VK_ERROR(vk, "os_mutex_init: %i", iret);
+		vk_cmd_pool_destroy(vk, &cscs->pool);
+		return XRT_ERROR_THREADING_INIT_FAILURE;
+	}
+
+	cscs->image_pool.budget = (VkDeviceSize)debug_get_num_option_image_pool_budget_mb() * 1024 * 1024;
+
 	return XRT_SUCCESS;
 }
 
 void
 comp_swapchain_shared_destroy(struct comp_swapchain_shared *cscs, struct vk_bundle *vk)
 {
+	image_pool_trim(cscs, vk);
+	os_mutex_destroy(&cscs->image_pool.mutex);
+
 	vk_cmd_pool_destroy(vk, &cscs->pool);
 }
 
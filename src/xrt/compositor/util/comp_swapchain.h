@@ -24,6 +24,13 @@ extern "C" {
 
 struct comp_swapchain;
 
+/*!
+ * Max number of image collections the swapchain image pool holds.
+ *
+ * @ingroup comp_util
+ */
+#define COMP_SWAPCHAIN_IMAGE_POOL_MAX_ENTRIES (16)
+
 /*!
  * Callback for implementing own destroy function, should call
  * @ref comp_swapchain_teardown and is responsible for memory.
@@ -46,6 +53,29 @@ struct comp_swapchain_shared
 	struct u_threading_stack destroy_swapchains;
 
 	struct vk_cmd_pool pool;
+
+	/*!
+	 * Images of destroyed swapchains that can be given to newly created
+	 * swapchains with a identical create info, avoiding reallocation.
+	 * Entries are kept oldest first, so trimming removes the oldest ones.
+	 */
+	struct
+	{
+		//! Protects the pool, swapchains are created from many threads.
+		struct os_mutex mutex;
+
+		//! Collections ready for reuse, the images are idle.
+		struct vk_image_collection entries[COMP_SWAPCHAIN_IMAGE_POOL_MAX_ENTRIES];
+
+		//! Number of valid entries.
+		uint32_t entry_count;
+
+		//! Total size of all images in the pool.
+		VkDeviceSize size;
+
+		//! Max size of all images in the pool, zero disables the pool.
+		VkDeviceSize budget;
+	} image_pool;
 };
 
 /*!
@@ -106,6 +136,12 @@ struct comp_swapchain
 
 	//! Virtual real destroy function.
 	comp_swapchain_destroy_func_t real_destroy;
+
+	//! The images are owned by us, not imported, so may be put in the pool.
+	bool recyclable;
+
+	//! Bumped on every release, tells the renderer that an image got new content.
+	xrt_atomic_s32_t release_count;
 };
 
 
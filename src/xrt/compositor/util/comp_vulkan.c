@@ -13,6 +13,7 @@
 #include "os/os_time.h"
 
 #include "util/u_handles.h"
+#include "util/u_startup_timeline.h"
 #include "util/u_trace_marker.h"
 
 #include "util/comp_vulkan.h"
@@ -165,6 +166,14 @@ fill_in_results(struct vk_bundle *vk, const struct comp_vulkan_arguments *vk_arg
 		}
 	}
 
+	// Most likely a hybrid system, every client swapchain crosses between the devices.
+	if (vk_res->client_gpu_index >= 0 && vk_res->client_gpu_index != vk_res->selected_gpu_index) {
+		VK_WARN(vk,
+		        "Clients are suggested GPU %d while the compositor runs on GPU %d, "
+		        "all swapchain images will be imported across devices.",
+		        vk_res->client_gpu_index, vk_res->selected_gpu_index);
+	}
+
 	return VK_SUCCESS;
 }
 
@@ -280,6 +289,7 @@ create_device(struct vk_bundle *vk, const struct comp_vulkan_arguments *vk_args)
 	    .null_descriptor = only_compute_queue,
 	    .timeline_semaphore = vk_args->timeline_semaphore,
 	    .synchronization_2 = true,
+	    .image_compression_control = true,
 	};
 
 	// No other way then to try to see if realtime is available.
@@ -289,6 +299,7 @@ create_device(struct vk_bundle *vk, const struct comp_vulkan_arguments *vk_args)
 		    vk_args->selected_gpu_index,         //
 		    only_compute_queue,                  // compute_only
 		    prios[i],                            // global_priority
+		    vk_args->async_queue,                // async_queue
 		    vk_args->required_device_extensions, //
 		    vk_args->optional_device_extensions, //
 		    &device_features);                   // optional_device_features
@@ -410,7 +421,7 @@ is_format_supported(struct vk_bundle *vk, VkFormat format, enum xrt_swapchain_us
 #endif
 
 	VkFormatProperties prop;
-	vk->vkGetPhysicalDeviceFormatProperties(vk->physical_device, format, &prop);
+	vk_get_format_properties(vk, format, &prop);
 	const VkFormatFeatureFlagBits bits = prop.optimalTilingFeatures;
 
 	if ((bits & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) == 0) {
@@ -517,13 +528,17 @@ comp_vulkan_init_bundle(struct vk_bundle *vk,
 		return false;
 	}
 
+	int32_t phase = u_startup_timeline_begin("Create VkInstance");
 	ret = create_instance(vk, vk_args);
+	u_startup_timeline_end(phase);
 	if (ret != VK_SUCCESS) {
 		// Error already reported.
 		return false;
 	}
 
+	phase = u_startup_timeline_begin("Create VkDevice");
 	ret = create_device(vk, vk_args);
+	u_startup_timeline_end(phase);
 	if (ret != VK_SUCCESS) {
 		// Error already reported.
 		return false;
@@ -52,6 +52,9 @@ struct comp_vulkan_arguments
 	//! Should we try to enable timeline semaphores if available
 	bool timeline_semaphore;
 
+	//! Should we try to create @ref vk_bundle::async_queue if available.
+	bool async_queue;
+
 	//! Vulkan physical device to be selected, -1 for auto.
 	int selected_gpu_index;
 
@@ -25,11 +25,10 @@
 #include "util/u_logging.h"
 #include "util/u_trace_marker.h"
 
-#ifdef XRT_OS_LINUX
-#include "util/u_linux.h"
-#endif
+#include "util/u_thread_role.h"
 
 #include "tracking/t_tracking.h"
+#include "tracking/t_hand_tracking.h"
 
 #include "depthai_interface.h"
 
@@ -40,8 +39,11 @@
 #include <unistd.h>
 #include <pthread.h>
 
+#include <algorithm>
+#include <chrono>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 /*
  *
@@ -61,6 +63,15 @@ DEBUG_GET_ONCE_NUM_OPTION(depthai_startup_wait_frames, "DEPTHAI_STARTUP_WAIT_FRA
 DEBUG_GET_ONCE_NUM_OPTION(depthai_imu_hz, "DEPTHAI_IMU_HZ", 500)
 DEBUG_GET_ONCE_NUM_OPTION(depthai_imu_batch_size, "DEPTHAI_IMU_BATCH_SIZE", 2)
 DEBUG_GET_ONCE_NUM_OPTION(depthai_imu_max_batch_size, "DEPTHAI_IMU_MAX_BATCH_SIZE", 2)
+DEBUG_GET_ONCE_OPTION(depthai_hand_detection_blob, "DEPTHAI_HAND_DETECTION_BLOB", NULL)
+DEBUG_GET_ONCE_NUM_OPTION(depthai_hand_detection_wait_ms, "DEPTHAI_HAND_DETECTION_WAIT_MS", 10)
+DEBUG_GET_ONCE_BOOL_OPTION(depthai_stereo_depth, "DEPTHAI_STEREO_DEPTH", false)
+
+//! Input size of Mercury's hand detection model, the blob has to be compiled from it.
+#define DEPTHAI_HAND_DETECTION_INPUT_SIZE (160)
+
+//! How many frame pairs of hand detections are kept for the hand tracker to pick up.
+#define DEPTHAI_HAND_DETECTION_HISTORY (4)
 
 
 
@@ -190,6 +201,39 @@ struct depthai_fs
 
 	uint32_t first_frames_idx;
 	uint32_t first_frames_camera_to_watch;
+
+	/*!
+	 * Hand detection model running on the device, on both gray cameras.
+	 * The results are matched to the frames by timestamp and handed to
+	 * the hand tracker through @ref base so it doesn't have to run it.
+	 */
+	struct
+	{
+		struct t_hand_detection_source base;
+
+		bool enabled;
+
+		//! Left and right.
+		dai::DataOutputQueue *queues[2];
+
+		//! Protects @ref history, the hand tracker reads it from its own thread.
+		struct os_mutex mutex;
+
+		struct
+		{
+			struct t_hand_detections detections;
+			bool have[2];
+		} history[DEPTHAI_HAND_DETECTION_HISTORY];
+		uint32_t next;
+	} hand_detection;
+
+	//! Stereo disparity computed on the device.
+	struct
+	{
+		bool enabled;
+		dai::DataOutputQueue *queue;
+		struct u_sink_debug debug_sink;
+	} depth;
 };
 
 
@@ -375,6 +419,162 @@ depthai_print_calib(struct depthai_fs *depthai)
 }
 
 
+/*!
+ * Turn the outputs of the detection model into camera pixels, the inverse of
+ * the letterboxing that the image manip node does on the device.
+ */
+static void
+depthai_hand_detection_interpret(struct depthai_fs *depthai, dai::NNData &nn, struct t_hand_detection out[2])
+{
+	std::vector<float> hand_exists = nn.getLayerFp16("hand_exists");
+	std::vector<float> cx = nn.getLayerFp16("cx");
+	std::vector<float> cy = nn.getLayerFp16("cy");
+	std::vector<float> size = nn.getLayerFp16("size");
+
+	if (hand_exists.size() < 2 || cx.size() < 2 || cy.size() < 2 || size.size() < 2) {
+		DEPTHAI_ERROR(depthai, "Hand detection model has the wrong outputs!");
+		return;
+	}
+
+	const float input_size = DEPTHAI_HAND_DETECTION_INPUT_SIZE;
+	float scale = (float)std::max(depthai->width, depthai->height) / input_size;
+	float offset_x = (input_size - depthai->width / scale) * 0.5f;
+	float offset_y = (input_size - depthai->height / scale) * 0.5f;
+
+	for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
+		// Same as Mercury does with the outputs, they are in -1 to 1 of the model input.
+		float x = (cx[hand_idx] + 1.0f) * 0.5f * input_size;
+		float y = (cy[hand_idx] + 1.0f) * 0.5f * input_size;
+
+		out[hand_idx].found = true;
+		out[hand_idx].confidence = hand_exists[hand_idx];
+		out[hand_idx].center_px.x = (x - offset_x) * scale;
+		out[hand_idx].center_px.y = (y - offset_y) * scale;
+		out[hand_idx].size_px = size[hand_idx] * input_size * 2.0f * scale;
+	}
+}
+
+//! Store the detections for one view, call with the mutex held.
+static void
+depthai_hand_detection_store_locked(struct depthai_fs *depthai,
+                                    uint32_t view,
+                                    uint64_t timestamp_ns,
+                                    struct t_hand_detection detections[2])
+{
+	uint32_t index = DEPTHAI_HAND_DETECTION_HISTORY;
+	for (uint32_t i = 0; i < DEPTHAI_HAND_DETECTION_HISTORY; i++) {
+		if (depthai->hand_detection.history[i].detections.timestamp_ns == timestamp_ns) {
+			index = i;
+			break;
+		}
+	}
+
+	// Not seen this timestamp before, replace the oldest.
+	if (index == DEPTHAI_HAND_DETECTION_HISTORY) {
+		index = depthai->hand_detection.next;
+		depthai->hand_detection.next = (index + 1) % DEPTHAI_HAND_DETECTION_HISTORY;
+
+		U_ZERO(&depthai->hand_detection.history[index]);
+		depthai->hand_detection.history[index].detections.timestamp_ns = timestamp_ns;
+	}
+
+	depthai->hand_detection.history[index].detections.views[view][0] = detections[0];
+	depthai->hand_detection.history[index].detections.views[view][1] = detections[1];
+	depthai->hand_detection.history[index].have[view] = true;
+}
+
+/*!
+ * The model runs behind the camera, wait a little for the detections of the
+ * frame before pushing it, so they are there when the hand tracker wants them.
+ * If they don't turn up the hand tracker runs detection itself.
+ */
+static void
+depthai_hand_detection_wait_for(struct depthai_fs *depthai, uint32_t view, uint64_t timestamp_ns)
+{
+	dai::DataOutputQueue *queue = depthai->hand_detection.queues[view];
+	auto timeout = std::chrono::milliseconds(debug_get_num_option_depthai_hand_detection_wait_ms());
+
+	while (true) {
+		bool timed_out = false;
+		std::shared_ptr<dai::NNData> nn = queue->get<dai::NNData>(timeout, timed_out);
+		if (timed_out || !nn) {
+			DEPTHAI_TRACE(depthai, "No hand detections for view %u in time", view);
+			return;
+		}
+
+		auto nano = std::chrono::duration_cast<std::chrono::duration<int64_t, std::nano>>(
+		    nn->getTimestamp().time_since_epoch());
+		uint64_t nn_timestamp_ns = nano.count();
+
+		struct t_hand_detection detections[2] = {};
+		depthai_hand_detection_interpret(depthai, *nn, detections);
+
+		os_mutex_lock(&depthai->hand_detection.mutex);
+		depthai_hand_detection_store_locked(depthai, view, nn_timestamp_ns, detections);
+		os_mutex_unlock(&depthai->hand_detection.mutex);
+
+		// The model drops frames when it can't keep up, so it might have skipped this one.
+		if (nn_timestamp_ns >= timestamp_ns) {
+			return;
+		}
+	}
+}
+
+static bool
+depthai_hand_detection_get(struct t_hand_detection_source *src, uint64_t timestamp_ns, struct t_hand_detections *out)
+{
+	struct depthai_fs *depthai = container_of(src, struct depthai_fs, hand_detection.base);
+	bool ret = false;
+
+	os_mutex_lock(&depthai->hand_detection.mutex);
+	for (uint32_t i = 0; i < DEPTHAI_HAND_DETECTION_HISTORY; i++) {
+		if (depthai->hand_detection.history[i].detections.timestamp_ns != timestamp_ns ||
+		    !depthai->hand_detection.history[i].have[0] || !depthai->hand_detection.history[i].have[1]) {
+			continue;
+		}
+
+		*out = depthai->hand_detection.history[i].detections;
+		ret = true;
+		break;
+	}
+	os_mutex_unlock(&depthai->hand_detection.mutex);
+
+	return ret;
+}
+
+//! Passes on any disparity images to the debug sink, doesn't wait for them.
+static void
+depthai_maybe_push_depth(struct depthai_fs *depthai)
+{
+	if (!depthai->depth.enabled) {
+		return;
+	}
+
+	std::shared_ptr<dai::ImgFrame> imgFrame = depthai->depth.queue->tryGet<dai::ImgFrame>();
+	if (!imgFrame || !u_sink_debug_is_active(&depthai->depth.debug_sink)) {
+		return;
+	}
+
+	auto nano = std::chrono::duration_cast<std::chrono::duration<int64_t, std::nano>>(
+	    imgFrame->getTimestamp().time_since_epoch());
+
+	DepthAIFrameWrapper *dfw = new DepthAIFrameWrapper(imgFrame);
+
+	// Disparity without subpixel is one byte per pixel.
+	struct xrt_frame *xf = &dfw->frame;
+	xf->width = imgFrame->getWidth();
+	xf->height = imgFrame->getHeight();
+	xf->format = XRT_FORMAT_L8;
+	xf->timestamp = nano.count();
+	xf->data = imgFrame->getData().data();
+
+	u_format_size_for_dimensions(xf->format, xf->width, xf->height, &xf->stride, &xf->size);
+
+	u_sink_debug_push_frame(&depthai->depth.debug_sink, xf);
+
+	xrt_frame_reference(&xf, NULL);
+}
+
 static void
 depthai_do_one_frame(struct depthai_fs *depthai)
 {
@@ -415,6 +615,11 @@ depthai_do_one_frame(struct depthai_fs *depthai)
 		return;
 	}
 
+	// Sinks are RGB, Left and Right, so the gray cameras are one and two.
+	if (depthai->hand_detection.enabled && (num == 1 || num == 2)) {
+		depthai_hand_detection_wait_for(depthai, num - 1, timestamp_ns);
+	}
+
 	// Create a wrapper that will keep the frame alive as long as the frame was alive.
 	DepthAIFrameWrapper *dfw = new DepthAIFrameWrapper(imgFrame);
 
@@ -489,6 +694,7 @@ depthai_mainloop(void *ptr)
 		os_thread_helper_unlock(&depthai->image_thread);
 
 		depthai_do_one_frame(depthai);
+		depthai_maybe_push_depth(depthai);
 
 		depthai_maybe_send_exposure_command(depthai);
 		depthai_maybe_send_floodlight_command(depthai);
@@ -620,10 +826,8 @@ depthai_imu_mainloop(void *ptr)
 	U_TRACE_SET_THREAD_NAME("DepthAI: IMU");
 	os_thread_helper_name(&depthai->imu_thread, "DepthAI: IMU");
 
-#ifdef XRT_OS_LINUX
 	// Try to raise priority of this thread.
-	u_linux_try_to_set_realtime_priority_on_thread(depthai->log_level, "DepthAI: IMU");
-#endif
+	u_thread_role_apply_to_current_thread(U_THREAD_ROLE_REALTIME_IO, "DepthAI: IMU");
 
 	DEPTHAI_DEBUG(depthai, "DepthAI: IMU thread called");
 
@@ -653,6 +857,7 @@ depthai_destroy(struct depthai_fs *depthai)
 	for (int i = 0; i < 4; i++) {
 		u_sink_debug_destroy(&depthai->debug_sinks[i]);
 	}
+	u_sink_debug_destroy(&depthai->depth.debug_sink);
 
 	// To work around use after free issue detected by ASan, v2.13.3 has this bug.
 	if (depthai->image_queue) {
@@ -661,6 +866,15 @@ depthai_destroy(struct depthai_fs *depthai)
 	if (depthai->imu_queue) {
 		depthai->imu_queue->close();
 	}
+	for (int i = 0; i < 2; i++) {
+		if (depthai->hand_detection.queues[i]) {
+			depthai->hand_detection.queues[i]->close();
+		}
+	}
+	if (depthai->depth.queue) {
+		depthai->depth.queue->close();
+	}
+	os_mutex_destroy(&depthai->hand_detection.mutex);
 	delete depthai->device;
 
 	free(depthai);
@@ -802,6 +1016,8 @@ depthai_setup_stereo_grayscale_pipeline(struct depthai_fs *depthai)
 
 	const char *name_images = "image_frames";
 	const char *name_imu = "imu_samples";
+	const char *name_disparity = "disparity";
+	const char *name_hand_detections[2] = {"hand_detections_left", "hand_detections_right"};
 
 	auto controlIn = p.create<dai::node::XLinkIn>();
 	controlIn->setStreamName("control");
@@ -816,6 +1032,16 @@ depthai_setup_stereo_grayscale_pipeline(struct depthai_fs *depthai)
 		    dai::CameraBoardSocket::RIGHT,
 		};
 
+		std::shared_ptr<dai::node::StereoDepth> stereo = nullptr;
+		if (depthai->depth.enabled) {
+			stereo = p.create<dai::node::StereoDepth>();
+			stereo->setLeftRightCheck(true);
+
+			std::shared_ptr<dai::node::XLinkOut> xlinkOut_depth = p.create<dai::node::XLinkOut>();
+			xlinkOut_depth->setStreamName(name_disparity);
+			stereo->disparity.link(xlinkOut_depth->input);
+		}
+
 		for (int i = 0; i < 2; i++) {
 			std::shared_ptr<dai::node::MonoCamera> grayCam = nullptr;
 
@@ -829,6 +1055,30 @@ depthai_setup_stereo_grayscale_pipeline(struct depthai_fs *depthai)
 			grayCam->out.link(xlinkOut->input);
 			// Link control to camera
 			controlIn->out.link(grayCam->inputControl);
+
+			if (stereo) {
+				grayCam->out.link(i == 0 ? stereo->left : stereo->right);
+			}
+
+			if (depthai->hand_detection.enabled) {
+				// Letterbox down to the model input, CAM -> MANIP -> NN -> XLINK.
+				auto manip = p.create<dai::node::ImageManip>();
+				manip->initialConfig.setResizeThumbnail(DEPTHAI_HAND_DETECTION_INPUT_SIZE,
+				                                        DEPTHAI_HAND_DETECTION_INPUT_SIZE);
+				manip->initialConfig.setFrameType(dai::ImgFrame::Type::GRAY8);
+				grayCam->out.link(manip->inputImage);
+
+				// Drop frames instead of holding up the cameras when the model can't keep up.
+				auto nn = p.create<dai::node::NeuralNetwork>();
+				nn->setBlobPath(debug_get_option_depthai_hand_detection_blob());
+				nn->input.setBlocking(false);
+				nn->input.setQueueSize(1);
+				manip->out.link(nn->input);
+
+				std::shared_ptr<dai::node::XLinkOut> xlinkOut_nn = p.create<dai::node::XLinkOut>();
+				xlinkOut_nn->setStreamName(name_hand_detections[i]);
+				nn->out.link(xlinkOut_nn->input);
+			}
 		}
 	}
 
@@ -895,6 +1145,17 @@ depthai_setup_stereo_grayscale_pipeline(struct depthai_fs *depthai)
 	if (depthai->want_imu) {
 		depthai->imu_queue = depthai->device->getOutputQueue(name_imu, 4, false).get(); // out of shared pointer
 	}
+	if (depthai->want_cameras && depthai->hand_detection.enabled) {
+		for (int i = 0; i < 2; i++) {
+			// out of shared pointer
+			depthai->hand_detection.queues[i] =
+			    depthai->device->getOutputQueue(name_hand_detections[i], 4, false).get();
+		}
+	}
+	if (depthai->want_cameras && depthai->depth.enabled) {
+		// out of shared pointer
+		depthai->depth.queue = depthai->device->getOutputQueue(name_disparity, 1, false).get();
+	}
 
 
 	depthai->control_queue = depthai->device->getInputQueue("control").get();
@@ -1168,6 +1429,9 @@ depthai_create_and_do_minimal_setup(void)
 	u_var_add_sink_debug(depthai, &depthai->debug_sinks[2], "Right");
 	u_var_add_sink_debug(depthai, &depthai->debug_sinks[3], "CamD");
 
+	u_sink_debug_init(&depthai->depth.debug_sink);
+	u_var_add_sink_debug(depthai, &depthai->depth.debug_sink, "Disparity");
+
 	u_var_add_bool(depthai, &depthai->manual_exposure.active, "Manual exposure");
 
 	u_var_add_draggable_u16(depthai, &depthai->manual_exposure.exposure_time_ui, "Exposure time");
@@ -1189,6 +1453,9 @@ depthai_create_and_do_minimal_setup(void)
 	os_thread_helper_init(&depthai->image_thread);
 	os_thread_helper_init(&depthai->imu_thread);
 
+	depthai->hand_detection.base.get = depthai_hand_detection_get;
+	os_mutex_init(&depthai->hand_detection.mutex);
+
 	return depthai;
 }
 
@@ -1238,6 +1505,16 @@ depthai_fs_slam(struct xrt_frame_context *xfctx, struct depthai_slam_startup_set
 	depthai->want_cameras = settings->want_cameras;
 	depthai->want_imu = settings->want_imu;
 	depthai->half_size_ov9282 = settings->half_size_ov9282;
+	depthai->depth.enabled = settings->want_cameras && //
+	                         (settings->want_depth || debug_get_bool_option_depthai_stereo_depth());
+
+	if (settings->want_cameras && settings->want_hand_detection) {
+		if (debug_get_option_depthai_hand_detection_blob() != NULL) {
+			depthai->hand_detection.enabled = true;
+		} else {
+			DEPTHAI_INFO(depthai, "No DEPTHAI_HAND_DETECTION_BLOB, not running hand detection on device.");
+		}
+	}
 
 	// Last bit is to setup the pipeline.
 	depthai_setup_stereo_grayscale_pipeline(depthai);
@@ -1324,3 +1601,15 @@ depthai_fs_get_stereo_calibration(struct xrt_fs *xfs, struct t_stereo_camera_cal
 
 	return depthai_get_gray_cameras_calibration(depthai, c_ptr);
 }
+
+extern "C" struct t_hand_detection_source *
+depthai_fs_get_hand_detection_source(struct xrt_fs *xfs)
+{
+	struct depthai_fs *depthai = depthai_fs(xfs);
+
+	if (!depthai->hand_detection.enabled) {
+		return NULL;
+	}
+
+	return &depthai->hand_detection.base;
+}
@@ -22,6 +22,7 @@ extern "C" {
 
 
 struct t_stereo_camera_calibration;
+struct t_hand_detection_source;
 
 
 #define DEPTHAI_VID 0x03e7
@@ -34,6 +35,12 @@ struct depthai_slam_startup_settings
 	bool want_imu;
 	bool half_size_ov9282;
 	int frames_per_second;
+
+	//! Run hand detection on the device, needs the model blob from DEPTHAI_HAND_DETECTION_BLOB.
+	bool want_hand_detection;
+
+	//! Compute stereo disparity on the device, also turned on with DEPTHAI_STEREO_DEPTH.
+	bool want_depth;
 };
 
 int
@@ -86,6 +93,15 @@ depthai_fs_stereo_rgb(struct xrt_frame_context *xfctx);
 bool
 depthai_fs_get_stereo_calibration(struct xrt_fs *xfs, struct t_stereo_camera_calibration **c_ptr);
 
+/*!
+ * Get the hand detections that a DepthAI frameserver runs on the device, to
+ * hand to the hand tracker. Returns NULL if it isn't running hand detection.
+ *
+ * @ingroup drv_depthai
+ */
+struct t_hand_detection_source *
+depthai_fs_get_hand_detection_source(struct xrt_fs *xfs);
+
 
 #ifdef __cplusplus
 }
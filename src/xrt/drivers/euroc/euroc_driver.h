@@ -37,6 +37,17 @@
 extern "C" {
 #endif
 
+/*!
+ * Fills in the pose count and time span of the trajectory in @p tracking_csv
+ * and its absolute trajectory error against the groundtruth of the dataset,
+ * if @p gt_device_name is given. Leaves @p stats untouched on failure.
+ */
+void
+euroc_evaluate_trajectory(const char *dataset_path,
+                          const char *gt_device_name,
+                          const char *tracking_csv,
+                          struct euroc_run_stats *stats);
+
 /*!
  * @}
  */
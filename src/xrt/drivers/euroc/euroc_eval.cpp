@@ -0,0 +1,162 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Evaluate trajectories tracked on EuRoC datasets.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup drv_euroc
+ */
+
+#include "euroc_driver.h"
+#include "util/u_time.h"
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+struct position_sample
+{
+	int64_t timestamp;
+	Eigen::Vector3d position;
+};
+
+/*!
+ * Reads the timestamp and position of each line in an EuRoC style pose csv
+ * (ts,px,py,pz,...), comments and lines that don't parse are skipped.
+ */
+bool
+read_positions(const string &path, vector<position_sample> &out)
+{
+	std::ifstream fin{path};
+	if (!fin.is_open()) {
+		return false;
+	}
+
+	string line;
+	while (getline(fin, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		const char *ptr = line.c_str();
+		char *end = nullptr;
+
+		int64_t timestamp = strtoll(ptr, &end, 10);
+		if (end == ptr) {
+			continue;
+		}
+
+		double v[3];
+		bool ok = true;
+		for (double &value : v) {
+			if (*end != ',') {
+				ok = false;
+				break;
+			}
+			ptr = end + 1;
+			value = strtod(ptr, &end);
+			ok &= end != ptr;
+		}
+
+		if (ok) {
+			out.push_back({timestamp, {v[0], v[1], v[2]}});
+		}
+	}
+
+	return true;
+}
+
+//! Linearly interpolated groundtruth position at @p timestamp, false if outside of the groundtruth.
+bool
+get_position_at(const vector<position_sample> &gt, int64_t timestamp, Eigen::Vector3d &out)
+{
+	auto it = std::lower_bound(gt.begin(), gt.end(), timestamp,
+	                           [](const position_sample &s, int64_t ts) { return s.timestamp < ts; });
+
+	if (it == gt.end()) {
+		return false;
+	}
+
+	if (it->timestamp == timestamp) {
+		out = it->position;
+		return true;
+	}
+
+	if (it == gt.begin()) {
+		return false;
+	}
+
+	const position_sample &right = *it;
+	const position_sample &left = *std::prev(it);
+	double t = double(timestamp - left.timestamp) / double(right.timestamp - left.timestamp);
+	out = left.position + t * (right.position - left.position);
+
+	return true;
+}
+
+} // namespace
+
+extern "C" void
+euroc_evaluate_trajectory(const char *dataset_path,
+                          const char *gt_device_name,
+                          const char *tracking_csv,
+                          struct euroc_run_stats *stats)
+{
+	vector<position_sample> tracked;
+	if (!read_positions(tracking_csv, tracked) || tracked.empty()) {
+		return;
+	}
+
+	stats->pose_count = tracked.size();
+	stats->dataset_time_s = double(tracked.back().timestamp - tracked.front().timestamp) / U_TIME_1S_IN_NS;
+
+	if (gt_device_name == nullptr) {
+		return;
+	}
+
+	vector<position_sample> gt;
+	string gt_csv = string(dataset_path) + "/mav0/" + gt_device_name + "/data.csv";
+	if (!read_positions(gt_csv, gt) || gt.size() < 2) {
+		return;
+	}
+
+	// Pairs of tracked and groundtruth positions at the tracked timestamps
+	Eigen::Matrix3Xd src(3, tracked.size());
+	Eigen::Matrix3Xd dst(3, tracked.size());
+	Eigen::Index count = 0;
+	for (const position_sample &s : tracked) {
+		Eigen::Vector3d gt_position;
+		if (get_position_at(gt, s.timestamp, gt_position)) {
+			src.col(count) = s.position;
+			dst.col(count) = gt_position;
+			count++;
+		}
+	}
+
+	// Too few to align
+	if (count < 3) {
+		return;
+	}
+
+	src.conservativeResize(3, count);
+	dst.conservativeResize(3, count);
+
+	// Rigid alignment of the whole trajectory, no scale as the tracker is metric
+	Eigen::Matrix4d T = Eigen::umeyama(src, dst, false);
+	Eigen::Matrix3Xd aligned = (T.topLeftCorner<3, 3>() * src).colwise() + T.topRightCorner<3, 1>();
+
+	stats->has_ate = true;
+	stats->ate_rmse_m = std::sqrt((aligned - dst).colwise().squaredNorm().mean());
+}
@@ -47,6 +47,9 @@ struct euroc_player_playback_config
 	bool use_source_ts;       //!< If true, use the original timestamps from the dataset
 	bool play_from_start;     //!< If set, the euroc player does not wait for user input to start
 	bool print_progress;      //!< Whether to print progress to stdout (useful for CLI runs)
+	int decode_ahead;         //!< Frames to decode ahead per camera on worker threads, 0 decodes on push
+	bool cache;               //!< Decode the images once into a raw cache file and map it on later runs
+	bool consumer_paced;      //!< Push all samples in order from one thread as fast as the sinks return
 };
 
 /*!
@@ -101,6 +104,31 @@ euroc_player_create(struct xrt_frame_context *xfctx, const char *path, struct eu
 struct xrt_auto_prober *
 euroc_create_auto_prober(void);
 
+/*!
+ * Options for @ref euroc_run_dataset_with_stats.
+ *
+ * @ingroup drv_euroc
+ */
+struct euroc_run_options
+{
+	double speed;        //!< Playback speed relative to the recording, 0 or less plays as fast as possible
+	bool print_progress; //!< Print the playback progress, disable when running datasets concurrently
+};
+
+/*!
+ * Results of tracking a dataset, see @ref euroc_run_dataset_with_stats.
+ *
+ * @ingroup drv_euroc
+ */
+struct euroc_run_stats
+{
+	double wall_time_s;    //!< How long the run took
+	double dataset_time_s; //!< Time span covered by the tracked poses
+	uint64_t pose_count;   //!< Number of poses the tracker estimated
+	bool has_ate;          //!< Whether @ref ate_rmse_m could be computed, needs groundtruth
+	double ate_rmse_m;     //!< Absolute trajectory error, RMSE of the positions after a rigid alignment
+};
+
 /*!
  * Tracks an euroc dataset with the SLAM tracker.
  *
@@ -117,6 +145,25 @@ euroc_run_dataset(const char *euroc_path,
                   const char *output_path,
                   const volatile bool *should_exit);
 
+/*!
+ * Same as @ref euroc_run_dataset but with playback options and returning
+ * stats. The stats are computed from the `tracking.csv` written to
+ * @p output_path, so SLAM_WRITE_CSVS must not be disabled. Several datasets
+ * can be run at the same time from different threads.
+ *
+ * @param options Playback options, NULL for the defaults of @ref euroc_run_dataset
+ * @param[out] out_stats Results of the run, zeroed if nothing was tracked
+ *
+ * @ingroup drv_euroc
+ */
+void
+euroc_run_dataset_with_stats(const char *euroc_path,
+                             const char *slam_config,
+                             const char *output_path,
+                             const struct euroc_run_options *options,
+                             const volatile bool *should_exit,
+                             struct euroc_run_stats *out_stats);
+
 /*!
  * @dir drivers/euroc
  *
@@ -7,15 +7,18 @@
  * @ingroup drv_euroc
  */
 
+#include "xrt/xrt_config_os.h"
 #include "xrt/xrt_frame.h"
 #include "xrt/xrt_tracking.h"
 #include "xrt/xrt_frameserver.h"
 #include "os/os_threading.h"
 #include "util/u_debug.h"
+#include "util/u_file.h"
 #include "util/u_misc.h"
 #include "util/u_time.h"
 #include "util/u_var.h"
 #include "util/u_sink.h"
+#include "util/u_worker.h"
 #include "tracking/t_frame_cv_mat_wrapper.hpp"
 #include "math/m_api.h"
 #include "math/m_filter_fifo.h"
@@ -24,15 +27,26 @@
 #include "euroc_interface.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstring>
 #include <stdint.h>
 #include <stdio.h>
 #include <fstream>
 #include <future>
+#include <mutex>
 #include <thread>
 #include <inttypes.h>
 
+#ifdef XRT_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <linux/limits.h>
+#endif
+
 //! @see euroc_player_playback_config
 DEBUG_GET_ONCE_LOG_OPTION(euroc_log, "EUROC_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_OPTION(gt_device_name, "EUROC_GT_DEVICE_NAME", nullptr)
@@ -48,12 +62,23 @@ DEBUG_GET_ONCE_BOOL_OPTION(send_all_imus_first, "EUROC_SEND_ALL_IMUS_FIRST", fal
 DEBUG_GET_ONCE_BOOL_OPTION(use_source_ts, "EUROC_USE_SOURCE_TS", false)
 DEBUG_GET_ONCE_BOOL_OPTION(play_from_start, "EUROC_PLAY_FROM_START", false)
 DEBUG_GET_ONCE_BOOL_OPTION(print_progress, "EUROC_PRINT_PROGRESS", false)
+DEBUG_GET_ONCE_NUM_OPTION(decode_ahead, "EUROC_DECODE_AHEAD", 8)
+DEBUG_GET_ONCE_NUM_OPTION(decode_threads, "EUROC_DECODE_THREADS", 4)
+DEBUG_GET_ONCE_BOOL_OPTION(cache, "EUROC_CACHE", false)
+DEBUG_GET_ONCE_BOOL_OPTION(consumer_paced, "EUROC_CONSUMER_PACED", false)
 
 #define EUROC_PLAYER_STR "Euroc Player"
 
 //! Match max cameras to slam sinks max camera count
 #define EUROC_MAX_CAMS XRT_TRACKING_MAX_SLAM_CAMS
 
+//! Upper bound of @ref euroc_player_playback_config::decode_ahead
+#define EUROC_MAX_DECODE_AHEAD 64
+
+//! "MERC" in little endian.
+#define EUROC_CACHE_MAGIC 0x4352454dU
+#define EUROC_CACHE_VERSION 1U
+
 using std::async;
 using std::find_if;
 using std::ifstream;
@@ -81,6 +106,62 @@ enum euroc_player_ui_state
 	STREAM_ENDED
 };
 
+/*!
+ * Placed at the start of every raw image cache file, followed by `frame_count`
+ * images of `width * height * channels` bytes each.
+ */
+struct euroc_cache_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t width;
+	uint32_t height;
+	uint32_t channels;
+	uint32_t padding;
+	uint64_t frame_count;
+	int64_t first_ts; //!< Timestamp of the first image, used to tell datasets apart
+	int64_t last_ts;  //!< Timestamp of the last image
+};
+
+/*!
+ * Decoded images of one camera, written on the first run with
+ * @ref euroc_player_playback_config::cache and mapped on the following ones.
+ */
+struct euroc_player_cache
+{
+	void *map;
+	size_t map_size;
+	struct euroc_cache_header header;
+	const uint8_t *frames; //!< First byte of the first image
+	size_t frame_size;     //!< Bytes per image
+};
+
+//! An image being decoded ahead of playback, owned by @ref euroc_player_decoder.
+struct euroc_decode_slot
+{
+	struct euroc_player *ep;
+	int cam_index;
+	uint64_t seq; //!< Frame this slot is decoding or holding
+	bool ready;   //!< Whether `img` holds the decoded frame `seq`
+	cv::Mat img;
+};
+
+/*!
+ * Decodes the images of the next frames on a worker pool while the playback
+ * thread pushes the current ones. Each camera gets a window of `window` frames
+ * starting at the `img_seq` being played; a slot is only reused once playback
+ * has taken its frame, so the lookahead is bounded in memory.
+ */
+struct euroc_player_decoder
+{
+	struct u_worker_group *group;
+	std::mutex mutex;
+	std::condition_variable cond;
+	uint64_t window;                 //!< Frames to decode ahead per camera
+	uint64_t next_seq;               //!< First frame that has not been queued yet
+	vector<euroc_decode_slot> slots; //!< `window * cam_count` slots, indexed by frame and camera
+};
+
 /*!
  * Euroc player is in charge of the playback of a particular dataset.
  *
@@ -115,6 +196,11 @@ struct euroc_player
 	vector<img_samples> *imgs; //!< List of all image names to read from the dataset per camera
 	gt_trajectory *gt;         //!< List of all groundtruth poses read from the dataset
 
+	// Image loading fields, set up at stream start
+	struct u_worker_thread_pool *decode_pool;          //!< Used for decoding ahead and building caches
+	struct euroc_player_decoder *decoder;              //!< Null when decoding on the playback thread
+	struct euroc_player_cache *caches[EUROC_MAX_CAMS]; //!< Mapped raw images per camera, null if unavailable
+
 	// Timestamp correction fields (can be disabled through `use_source_ts`)
 	timepoint_ns base_ts;   //!< First sample timestamp, stream timestamps are relative to this
 	timepoint_ns start_ts;  //!< When did the dataset started to be played
@@ -422,29 +508,390 @@ euroc_player_mapped_playback_ts(struct euroc_player *ep, timepoint_ns ts)
 	return euroc_player_mapped_ts(ep, ts);
 }
 
-static void
-euroc_player_load_next_frame(struct euroc_player *ep, int cam_index, struct xrt_frame *&xf)
+
+// Image loading functionality
+
+//! Read mode for the dataset images, influenced by the color playback option.
+static cv::ImreadModes
+euroc_player_read_mode(struct euroc_player *ep)
 {
-	using xrt::auxiliary::tracking::FrameMat;
-	img_sample sample = ep->imgs->at(cam_index).at(ep->img_seq);
-	ep->playback.scale = CLAMP(ep->playback.scale, 1.0 / 16, 4);
+	return ep->playback.color ? cv::IMREAD_ANYCOLOR : cv::IMREAD_GRAYSCALE;
+}
 
+//! Decodes image `seq` of camera `cam_index` from the cache if there is one or from disk otherwise.
+//! Safe to call from decoding workers, only reads from `ep`.
+static cv::Mat
+euroc_player_decode_image(struct euroc_player *ep, int cam_index, uint64_t seq)
+{
 	// Load will be influenced by these playback options
-	bool allow_color = ep->playback.color;
 	float scale = ep->playback.scale;
 
-	// Load image from disk
-	timepoint_ns timestamp = euroc_player_mapped_playback_ts(ep, sample.first);
-	string img_name = sample.second;
-	EUROC_TRACE(ep, "cam%d img t = %ld filename = %s", cam_index, timestamp, img_name.c_str());
-	cv::ImreadModes read_mode = allow_color ? cv::IMREAD_ANYCOLOR : cv::IMREAD_GRAYSCALE;
-	cv::Mat img = cv::imread(img_name, read_mode); // If colored, reads in BGR order
+	cv::Mat img;
+	struct euroc_player_cache *cache = ep->caches[cam_index];
+	if (cache != nullptr) {
+		const euroc_cache_header &h = cache->header;
+		void *data = (void *)(cache->frames + seq * cache->frame_size);
+		img = cv::Mat((int)h.height, (int)h.width, CV_8UC((int)h.channels), data);
+	} else {
+		const string &img_name = ep->imgs->at(cam_index).at(seq).second;
+		img = cv::imread(img_name, euroc_player_read_mode(ep)); // If colored, reads in BGR order
+	}
 
 	if (scale != 1.0) {
 		cv::Mat tmp;
 		cv::resize(img, tmp, cv::Size(), scale, scale);
 		img = tmp;
+	} else if (cache != nullptr) {
+		// Frames may outlive the mapping, so they get their own copy
+		img = img.clone();
+	}
+
+	return img;
+}
+
+static void
+euroc_player_decode_task(void *ptr)
+{
+	struct euroc_decode_slot *slot = (struct euroc_decode_slot *)ptr;
+	struct euroc_player_decoder *decoder = slot->ep->decoder;
+
+	cv::Mat img = euroc_player_decode_image(slot->ep, slot->cam_index, slot->seq);
+
+	{
+		std::unique_lock lock{decoder->mutex};
+		slot->img = img;
+		slot->ready = true;
+	}
+	decoder->cond.notify_all();
+}
+
+//! Queues the frames up to `window` frames past the one being played.
+static void
+euroc_player_decoder_fill(struct euroc_player *ep)
+{
+	struct euroc_player_decoder *decoder = ep->decoder;
+	uint64_t frame_count = ep->imgs->at(0).size();
+	uint64_t end_seq = MIN(ep->img_seq + decoder->window, frame_count);
+	int cam_count = ep->playback.cam_count;
+
+	for (; decoder->next_seq < end_seq; decoder->next_seq++) {
+		for (int i = 0; i < cam_count; i++) {
+			uint64_t seq = decoder->next_seq;
+			struct euroc_decode_slot *slot = &decoder->slots[(seq % decoder->window) * cam_count + i];
+			{
+				std::unique_lock lock{decoder->mutex};
+				slot->seq = seq;
+				slot->ready = false;
+				slot->img.release();
+			}
+			u_worker_group_push(decoder->group, euroc_player_decode_task, slot);
+		}
+	}
+}
+
+//! Waits for the decoded image of the frame being played and takes it out of its slot.
+static cv::Mat
+euroc_player_decoder_take(struct euroc_player *ep, int cam_index)
+{
+	struct euroc_player_decoder *decoder = ep->decoder;
+	uint64_t seq = ep->img_seq;
+
+	euroc_player_decoder_fill(ep);
+
+	struct euroc_decode_slot *slot = &decoder->slots[(seq % decoder->window) * ep->playback.cam_count + cam_index];
+	std::unique_lock lock{decoder->mutex};
+	decoder->cond.wait(lock, [slot, seq] { return slot->ready && slot->seq == seq; });
+
+	cv::Mat img = slot->img;
+	slot->img.release();
+	slot->ready = false;
+	return img;
+}
+
+static void
+euroc_player_decoder_create(struct euroc_player *ep)
+{
+	ep->playback.decode_ahead = CLAMP(ep->playback.decode_ahead, 0, EUROC_MAX_DECODE_AHEAD);
+	if (ep->playback.decode_ahead == 0 || ep->decode_pool == nullptr) {
+		return;
+	}
+
+	struct euroc_player_decoder *decoder = new euroc_player_decoder{};
+	decoder->group = u_worker_group_create(ep->decode_pool);
+	decoder->window = ep->playback.decode_ahead;
+	decoder->next_seq = ep->img_seq;
+	decoder->slots.resize(decoder->window * ep->playback.cam_count);
+	for (size_t i = 0; i < decoder->slots.size(); i++) {
+		decoder->slots[i].ep = ep;
+		decoder->slots[i].cam_index = (int)(i % ep->playback.cam_count);
+	}
+
+	ep->decoder = decoder;
+	EUROC_INFO(ep, "Decoding %" PRIu64 " frames ahead per camera", decoder->window);
+}
+
+static void
+euroc_player_decoder_destroy(struct euroc_player *ep)
+{
+	if (ep->decoder == nullptr) {
+		return;
+	}
+
+	// Playback may have stopped before taking every queued frame
+	u_worker_group_wait_all(ep->decoder->group);
+	u_worker_group_reference(&ep->decoder->group, NULL);
+
+	delete ep->decoder;
+	ep->decoder = nullptr;
+}
+
+
+// Raw image cache functionality
+
+#ifdef XRT_OS_LINUX
+//! Cache files are named after the dataset path and how its images are read.
+static bool
+euroc_player_cache_file_name(struct euroc_player *ep, int cam_index, const char *suffix, char *out, size_t size)
+{
+	// FNV-1a
+	uint64_t key = 0xcbf29ce484222325ULL;
+	for (const char *c = ep->dataset.path; *c != '\0'; c++) {
+		key = (key ^ (uint8_t)*c) * 0x100000001b3ULL;
+	}
+
+	const char *mode = ep->playback.color ? "color" : "gray";
+	int ret = snprintf(out, size, "euroc-%016llx-cam%d-%s.raw%s", (unsigned long long)key, cam_index, mode, suffix);
+	return ret > 0 && ret < (int)size;
+}
+
+static bool
+euroc_player_cache_file_path(struct euroc_player *ep, int cam_index, const char *suffix, char *out, size_t size)
+{
+	char file_name[128];
+	if (!euroc_player_cache_file_name(ep, cam_index, suffix, file_name, sizeof(file_name))) {
+		return false;
+	}
+
+	ssize_t ret = u_file_get_path_in_cache_dir(file_name, out, size);
+	return ret > 0 && ret < (ssize_t)size;
+}
+
+//! The header a valid cache for camera `cam_index` must have, false if the first image can't be read.
+static bool
+euroc_player_cache_expected_header(struct euroc_player *ep, int cam_index, struct euroc_cache_header *out)
+{
+	const img_samples &imgs = ep->imgs->at(cam_index);
+	cv::Mat first = cv::imread(imgs.front().second, euroc_player_read_mode(ep));
+	if (first.empty()) {
+		return false;
+	}
+
+	*out = {};
+	out->magic = EUROC_CACHE_MAGIC;
+	out->version = EUROC_CACHE_VERSION;
+	out->width = first.cols;
+	out->height = first.rows;
+	out->channels = first.channels();
+	out->frame_count = imgs.size();
+	out->first_ts = imgs.front().first;
+	out->last_ts = imgs.back().first;
+	return true;
+}
+
+static size_t
+euroc_player_cache_frame_size(const struct euroc_cache_header &header)
+{
+	return (size_t)header.width * header.height * header.channels;
+}
+
+static struct euroc_player_cache *
+euroc_player_cache_map(const char *path, const struct euroc_cache_header &expected)
+{
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return nullptr;
+	}
+
+	size_t frame_size = euroc_player_cache_frame_size(expected);
+	size_t total_size = sizeof(expected) + frame_size * expected.frame_count;
+
+	struct stat st = {};
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size != total_size) {
+		close(fd);
+		return nullptr;
+	}
+
+	void *map = mmap(NULL, total_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		return nullptr;
+	}
+
+	if (memcmp(map, &expected, sizeof(expected)) != 0) {
+		munmap(map, total_size);
+		return nullptr;
+	}
+
+	// Playback mostly reads forward
+	(void)madvise(map, total_size, MADV_SEQUENTIAL);
+
+	struct euroc_player_cache *cache = new euroc_player_cache{};
+	cache->map = map;
+	cache->map_size = total_size;
+	cache->header = expected;
+	cache->frames = (const uint8_t *)map + sizeof(expected);
+	cache->frame_size = frame_size;
+	return cache;
+}
+
+//! One image to decode into a cache file being built.
+struct euroc_cache_build_task
+{
+	const string *img_name;
+	cv::ImreadModes read_mode;
+	const struct euroc_cache_header *header;
+	uint8_t *dst;
+	std::atomic<bool> *failed;
+};
+
+static void
+euroc_player_cache_build_task(void *ptr)
+{
+	struct euroc_cache_build_task *task = (struct euroc_cache_build_task *)ptr;
+	const struct euroc_cache_header &h = *task->header;
+
+	cv::Mat img = cv::imread(*task->img_name, task->read_mode);
+	bool matches = img.cols == (int)h.width && img.rows == (int)h.height && img.channels() == (int)h.channels;
+	if (!matches || !img.isContinuous()) {
+		*task->failed = true;
+		return;
+	}
+
+	memcpy(task->dst, img.data, euroc_player_cache_frame_size(h));
+}
+
+//! Decodes all images of camera `cam_index` in parallel into a new cache file at `path`.
+static bool
+euroc_player_cache_build(struct euroc_player *ep, int cam_index, const char *path, const euroc_cache_header &header)
+{
+	char tmp_name[128];
+	char tmp_path[PATH_MAX];
+	if (!euroc_player_cache_file_name(ep, cam_index, ".tmp", tmp_name, sizeof(tmp_name)) ||
+	    !euroc_player_cache_file_path(ep, cam_index, ".tmp", tmp_path, sizeof(tmp_path))) {
+		return false;
+	}
+
+	FILE *file = u_file_open_file_in_cache_dir(tmp_name, "wb+");
+	if (file == NULL) {
+		EUROC_WARN(ep, "Failed to open cache file '%s'", tmp_path);
+		return false;
+	}
+
+	size_t total_size = sizeof(header) + euroc_player_cache_frame_size(header) * header.frame_count;
+
+	// Reserve the space upfront, running out of it while writing through the map would crash
+	void *map = MAP_FAILED;
+	if (posix_fallocate(fileno(file), 0, (off_t)total_size) == 0) {
+		map = mmap(NULL, total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(file), 0);
+	}
+	(void)fclose(file);
+
+	if (map == MAP_FAILED) {
+		EUROC_WARN(ep, "Failed to allocate %zu bytes for cache file '%s'", total_size, tmp_path);
+		unlink(tmp_path);
+		return false;
+	}
+
+	EUROC_INFO(ep, "Building cache for cam%d at '%s', only done once", cam_index, path);
+
+	const img_samples &imgs = ep->imgs->at(cam_index);
+	uint8_t *frames = (uint8_t *)map + sizeof(header);
+	std::atomic<bool> failed{false};
+
+	vector<euroc_cache_build_task> tasks(imgs.size());
+	struct u_worker_group *group = u_worker_group_create(ep->decode_pool);
+	for (size_t i = 0; i < imgs.size(); i++) {
+		tasks[i] = {&imgs[i].second, euroc_player_read_mode(ep), &header,
+		            frames + i * euroc_player_cache_frame_size(header), &failed};
+		u_worker_group_push(group, euroc_player_cache_build_task, &tasks[i]);
+	}
+	u_worker_group_wait_all(group);
+	u_worker_group_reference(&group, NULL);
+
+	// Header goes in last, a partially written file never looks valid
+	memcpy(map, &header, sizeof(header));
+	bool written = !failed && msync(map, total_size, MS_SYNC) == 0;
+	munmap(map, total_size);
+
+	if (!written || rename(tmp_path, path) != 0) {
+		EUROC_WARN(ep, "Failed to build cache file '%s', images of different sizes?", path);
+		unlink(tmp_path);
+		return false;
+	}
+
+	return true;
+}
+#endif
+
+//! Maps the raw image caches of each camera, building the missing ones.
+static void
+euroc_player_caches_open(struct euroc_player *ep)
+{
+	if (!ep->playback.cache || ep->decode_pool == nullptr) {
+		return;
+	}
+
+#ifdef XRT_OS_LINUX
+	for (int i = 0; i < ep->playback.cam_count; i++) {
+		char path[PATH_MAX];
+		struct euroc_cache_header header;
+		if (!euroc_player_cache_file_path(ep, i, "", path, sizeof(path)) ||
+		    !euroc_player_cache_expected_header(ep, i, &header)) {
+			EUROC_WARN(ep, "Can't use a cache for cam%d", i);
+			continue;
+		}
+
+		struct euroc_player_cache *cache = euroc_player_cache_map(path, header);
+		if (cache == nullptr && euroc_player_cache_build(ep, i, path, header)) {
+			cache = euroc_player_cache_map(path, header);
+		}
+
+		if (cache == nullptr) {
+			EUROC_WARN(ep, "No cache for cam%d, decoding its images from disk", i);
+		}
+		ep->caches[i] = cache;
+	}
+#else
+	EUROC_WARN(ep, "Raw image caches are not supported on this platform");
+#endif
+}
+
+static void
+euroc_player_caches_close(struct euroc_player *ep)
+{
+	for (struct euroc_player_cache *&cache : ep->caches) {
+		if (cache == nullptr) {
+			continue;
+		}
+#ifdef XRT_OS_LINUX
+		munmap(cache->map, cache->map_size);
+#endif
+		delete cache;
+		cache = nullptr;
 	}
+}
+
+static void
+euroc_player_load_next_frame(struct euroc_player *ep, int cam_index, struct xrt_frame *&xf)
+{
+	using xrt::auxiliary::tracking::FrameMat;
+	img_sample sample = ep->imgs->at(cam_index).at(ep->img_seq);
+
+	// Load image from disk, the cache or the decoder
+	timepoint_ns timestamp = euroc_player_mapped_playback_ts(ep, sample.first);
+	EUROC_TRACE(ep, "cam%d img t = %ld filename = %s", cam_index, timestamp, sample.second.c_str());
+	cv::Mat img = ep->decoder != nullptr ? euroc_player_decoder_take(ep, cam_index)
+	                                     : euroc_player_decode_image(ep, cam_index, ep->img_seq);
 
 	// Create xrt_frame, it will be freed by FrameMat destructor
 	EUROC_ASSERT(xf == NULL || xf->reference.count > 0, "Must be given a valid or NULL frame ptr");
@@ -520,6 +967,15 @@ euroc_player_push_all_gt(struct euroc_player *ep)
 	}
 }
 
+static void
+euroc_player_wait_while_paused(struct euroc_player *ep)
+{
+	while (ep->playback.paused) {
+		constexpr int64_t PAUSE_POLL_INTERVAL_NS = 15L * U_TIME_1MS_IN_NS;
+		os_nanosleep(PAUSE_POLL_INTERVAL_NS);
+	}
+}
+
 template <typename SamplesType>
 timepoint_ns
 euroc_player_get_next_euroc_ts(struct euroc_player *ep)
@@ -585,10 +1041,7 @@ euroc_player_stream_samples(struct euroc_player *ep)
 	    euroc_player_get_stream_set<SamplesType>(ep);
 
 	while (*sample_seq < samples->size() && ep->is_running) {
-		while (ep->playback.paused) {
-			constexpr int64_t PAUSE_POLL_INTERVAL_NS = 15L * U_TIME_1MS_IN_NS;
-			os_nanosleep(PAUSE_POLL_INTERVAL_NS);
-		}
+		euroc_player_wait_while_paused(ep);
 
 		if (!ep->playback.max_speed) {
 			sleep_until_next_sample(ep);
@@ -598,6 +1051,28 @@ euroc_player_stream_samples(struct euroc_player *ep)
 	}
 }
 
+//! Pushes IMU samples and frames from a single thread in timestamp order and
+//! without sleeping, so playback only advances as fast as the sinks return.
+static void
+euroc_player_stream_consumer_paced(struct euroc_player *ep)
+{
+	size_t imu_count = ep->imus->size();
+	size_t frame_count = ep->imgs->at(0).size();
+
+	while ((ep->imu_seq < imu_count || ep->img_seq < frame_count) && ep->is_running) {
+		euroc_player_wait_while_paused(ep);
+
+		bool imu_first = ep->img_seq >= frame_count ||
+		                 (ep->imu_seq < imu_count && euroc_player_get_next_euroc_ts<imu_samples>(ep) <=
+		                                                 euroc_player_get_next_euroc_ts<img_samples>(ep));
+		if (imu_first) {
+			euroc_player_push_next_imu(ep);
+		} else {
+			euroc_player_push_next_frame(ep);
+		}
+	}
+}
+
 static void *
 euroc_player_stream(void *ptr)
 {
@@ -606,9 +1081,21 @@ euroc_player_stream(void *ptr)
 	EUROC_INFO(ep, "Starting euroc playback");
 
 	euroc_player_preload(ep);
+
+	// Image loading options can't change once the stream starts
+	ep->playback.scale = CLAMP(ep->playback.scale, 1.0 / 16, 4);
+	if (ep->playback.decode_ahead > 0 || ep->playback.cache) {
+		uint32_t thread_count = CLAMP(debug_get_num_option_decode_threads(), 1, 16);
+		ep->decode_pool = u_worker_thread_pool_create(thread_count, thread_count, "EuRoC Decode");
+	}
+
+	// Before taking the start time, building the caches can take a while
+	euroc_player_caches_open(ep);
+
 	ep->base_ts = MIN(ep->imgs->at(0).at(0).first, ep->imus->at(0).timestamp_ns);
 	ep->start_ts = os_monotonic_get_ts();
 	euroc_player_user_skip(ep);
+	euroc_player_decoder_create(ep);
 
 	// Push all IMU samples now if requested
 	if (ep->playback.send_all_imus_first) {
@@ -622,18 +1109,26 @@ euroc_player_stream(void *ptr)
 		euroc_player_push_all_gt(ep);
 	}
 
-	// Launch image and IMU producers
-	auto serve_imus = async(launch::async, [ep] { euroc_player_stream_samples<imu_samples>(ep); });
-	auto serve_imgs = async(launch::async, [ep] { euroc_player_stream_samples<img_samples>(ep); });
-	// Note that the only fields of `ep` being modified in the threads are: img_seq, imu_seq and
-	// progress_text in single locations, thus no race conditions should occur.
-
-	// Wait for the end of both streams
-	serve_imgs.get();
-	serve_imus.get();
+	if (ep->playback.consumer_paced) {
+		euroc_player_stream_consumer_paced(ep);
+	} else {
+		// Launch image and IMU producers
+		auto serve_imus = async(launch::async, [ep] { euroc_player_stream_samples<imu_samples>(ep); });
+		auto serve_imgs = async(launch::async, [ep] { euroc_player_stream_samples<img_samples>(ep); });
+		// Note that the only fields of `ep` being modified in the threads are: img_seq, imu_seq and
+		// progress_text in single locations, thus no race conditions should occur.
+
+		// Wait for the end of both streams
+		serve_imgs.get();
+		serve_imus.get();
+	}
 
 	ep->is_running = false;
 
+	euroc_player_decoder_destroy(ep);
+	euroc_player_caches_close(ep);
+	u_worker_thread_pool_reference(&ep->decode_pool, NULL);
+
 	EUROC_INFO(ep, "Euroc dataset playback finished");
 	euroc_player_set_ui_state(ep, STREAM_ENDED);
 
@@ -910,6 +1405,9 @@ euroc_player_setup_gui(struct euroc_player *ep)
 	u_var_add_f64(ep, &ep->playback.speed, "Speed");
 	u_var_add_bool(ep, &ep->playback.send_all_imus_first, "Send all IMU samples first");
 	u_var_add_bool(ep, &ep->playback.use_source_ts, "Use original timestamps");
+	u_var_add_bool(ep, &ep->playback.consumer_paced, "As fast as the consumer (overrides speed)");
+	u_var_add_i32(ep, &ep->playback.decode_ahead, "Frames to decode ahead");
+	u_var_add_bool(ep, &ep->playback.cache, "Raw image cache");
 
 	u_var_add_gui_header(ep, NULL, "Streams");
 	u_var_add_ro_ff_vec3_f32(ep, ep->gyro_ff, "Gyroscope");
@@ -946,6 +1444,9 @@ euroc_player_fill_default_config_for(struct euroc_player_config *config, const c
 	playback.use_source_ts = debug_get_bool_option_use_source_ts();
 	playback.play_from_start = debug_get_bool_option_play_from_start();
 	playback.print_progress = debug_get_bool_option_print_progress();
+	playback.decode_ahead = (int)debug_get_num_option_decode_ahead();
+	playback.cache = debug_get_bool_option_cache();
+	playback.consumer_paced = debug_get_bool_option_consumer_paced();
 
 	config->log_level = debug_get_log_option_euroc_log();
 	config->dataset = dataset;
@@ -30,6 +30,17 @@ euroc_run_dataset(const char *euroc_path,
                   const volatile bool *should_exit)
 {}
 
+void
+euroc_run_dataset_with_stats(const char *euroc_path,
+                             const char *slam_config,
+                             const char *output_path,
+                             const struct euroc_run_options *options,
+                             const volatile bool *should_exit,
+                             struct euroc_run_stats *out_stats)
+{
+	*out_stats = (struct euroc_run_stats){0};
+}
+
 #else
 
 static struct euroc_player_config *
@@ -85,12 +96,27 @@ make_slam_tracker_config(const char *slam_config, const char *output_path)
 }
 
 void
-euroc_run_dataset(const char *euroc_path,
-                  const char *slam_config,
-                  const char *output_path,
-                  const volatile bool *should_exit)
+euroc_run_dataset_with_stats(const char *euroc_path,
+                             const char *slam_config,
+                             const char *output_path,
+                             const struct euroc_run_options *options,
+                             const volatile bool *should_exit,
+                             struct euroc_run_stats *out_stats)
 {
+	*out_stats = (struct euroc_run_stats){0};
+	uint64_t start_ns = os_monotonic_get_ns();
+
 	struct euroc_player_config *ep_config = make_euroc_player_config(euroc_path);
+	if (options != NULL) {
+		ep_config->playback.max_speed = options->speed <= 0;
+		ep_config->playback.speed = options->speed > 0 ? options->speed : 1;
+		ep_config->playback.print_progress = options->print_progress;
+	}
+	if (getenv("EUROC_CONSUMER_PACED") == NULL) {
+		// Unpaced runs go as fast as the tracker consumes the samples, in order
+		ep_config->playback.consumer_paced = ep_config->playback.max_speed;
+	}
+
 	struct t_slam_tracker_config *st_config = make_slam_tracker_config(slam_config, output_path);
 	st_config->cam_count = ep_config->dataset.cam_count;
 
@@ -125,9 +151,28 @@ euroc_run_dataset(const char *euroc_path,
 		streaming = xrt_fs_is_running(xfs);
 	}
 
+	// Also closes the CSV files of the tracker.
 	xrt_frame_context_destroy_nodes(&xfctx);
+
+	out_stats->wall_time_s = (double)(os_monotonic_get_ns() - start_ns) / U_TIME_1S_IN_NS;
+
+	char tracking_csv[1024];
+	(void)snprintf(tracking_csv, sizeof(tracking_csv), "%s/tracking.csv", output_path);
+	const char *gt_device_name = ep_config->dataset.has_gt ? ep_config->dataset.gt_device_name : NULL;
+	euroc_evaluate_trajectory(ep_config->dataset.path, gt_device_name, tracking_csv, out_stats);
+
 	free(st_config);
 	free(ep_config);
 }
 
+void
+euroc_run_dataset(const char *euroc_path,
+                  const char *slam_config,
+                  const char *output_path,
+                  const volatile bool *should_exit)
+{
+	struct euroc_run_stats stats;
+	euroc_run_dataset_with_stats(euroc_path, slam_config, output_path, NULL, should_exit, &stats);
+}
+
 #endif
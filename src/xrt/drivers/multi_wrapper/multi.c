@@ -19,6 +19,9 @@
 
 DEBUG_GET_ONCE_LOG_OPTION(multi_log, "MULTI_LOG", U_LOGGING_WARN)
 
+//! How many poses @ref get_tracked_poses gets from the devices at a time.
+#define MULTI_POSE_BATCH_SIZE 16
+
 #define MULTI_TRACE(d, ...) U_LOG_XDEV_IFL_T(&d->base, d->log_level, __VA_ARGS__)
 #define MULTI_DEBUG(d, ...) U_LOG_XDEV_IFL_D(&d->base, d->log_level, __VA_ARGS__)
 #define MULTI_INFO(d, ...) U_LOG_XDEV_IFL_I(&d->base, d->log_level, __VA_ARGS__)
@@ -36,6 +39,12 @@ struct multi_device
 		struct xrt_device *tracker;
 		enum xrt_input_name input_name;
 		struct xrt_pose offset_inv;
+
+		//! @ref offset_inv as a fully tracked relation, made once at creation.
+		struct xrt_space_relation offset_inv_relation;
+
+		//! The offset doesn't change, so neither does this.
+		bool offset_is_identity;
 	} tracking_override;
 
 	enum xrt_tracking_override_type override_type;
@@ -47,7 +56,9 @@ direct_override(struct multi_device *d,
                 struct xrt_space_relation *out_relation)
 {
 	struct xrt_relation_chain xrc = {0};
-	m_relation_chain_push_pose_if_not_identity(&xrc, &d->tracking_override.offset_inv);
+	if (!d->tracking_override.offset_is_identity) {
+		m_relation_chain_push_relation(&xrc, &d->tracking_override.offset_inv_relation);
+	}
 	m_relation_chain_push_relation(&xrc, tracker_relation);
 	m_relation_chain_resolve(&xrc, out_relation);
 }
@@ -73,12 +84,40 @@ attached_override(struct multi_device *d,
 
 	struct xrt_relation_chain xrc = {0};
 	m_relation_chain_push_relation(&xrc, target_relation);
-	m_relation_chain_push_pose_if_not_identity(&xrc, &d->tracking_override.offset_inv);
+	if (!d->tracking_override.offset_is_identity) {
+		m_relation_chain_push_relation(&xrc, &d->tracking_override.offset_inv_relation);
+	}
 	m_relation_chain_push_relation(&xrc, tracker_relation);
 	m_relation_chain_push_relation(&xrc, in_target_space);
 	m_relation_chain_resolve(&xrc, out_relation);
 }
 
+//! Combines the poses of the devices, @p target_relation is only used for attached overrides.
+static void
+override_relation(struct multi_device *d,
+                  struct xrt_space_relation *target_relation,
+                  struct xrt_space_relation *tracker_relation,
+                  struct xrt_space_relation *out_relation)
+{
+	switch (d->override_type) {
+	case XRT_TRACKING_OVERRIDE_DIRECT: {
+		direct_override(d, tracker_relation, out_relation);
+	} break;
+	case XRT_TRACKING_OVERRIDE_ATTACHED: {
+		// just use the origin of the tracker space as reference frame
+		struct xrt_space_relation in_target_space;
+		m_space_relation_ident(&in_target_space);
+		in_target_space.relation_flags = tracker_relation->relation_flags;
+
+		struct xrt_pose *target_offset = &d->tracking_override.target->tracking_origin->offset;
+		struct xrt_pose *tracker_offset = &d->tracking_override.tracker->tracking_origin->offset;
+
+		attached_override(d, target_relation, target_offset, tracker_relation, tracker_offset,
+		                  &in_target_space, out_relation);
+	} break;
+	}
+}
+
 static void
 get_tracked_pose(struct xrt_device *xdev,
                  enum xrt_input_name name,
@@ -90,31 +129,44 @@ get_tracked_pose(struct xrt_device *xdev,
 	enum xrt_input_name tracker_input_name = d->tracking_override.input_name;
 
 	struct xrt_space_relation tracker_relation;
-
 	xrt_device_get_tracked_pose(tracker, tracker_input_name, at_timestamp_ns, &tracker_relation);
 
-	switch (d->override_type) {
-	case XRT_TRACKING_OVERRIDE_DIRECT: {
-		direct_override(d, &tracker_relation, out_relation);
-	} break;
-	case XRT_TRACKING_OVERRIDE_ATTACHED: {
-		struct xrt_device *target = d->tracking_override.target;
+	struct xrt_space_relation target_relation = XRT_SPACE_RELATION_ZERO;
+	if (d->override_type == XRT_TRACKING_OVERRIDE_ATTACHED) {
+		xrt_device_get_tracked_pose(d->tracking_override.target, name, at_timestamp_ns, &target_relation);
+	}
+
+	override_relation(d, &target_relation, &tracker_relation, out_relation);
+}
 
-		struct xrt_space_relation target_relation;
-		xrt_device_get_tracked_pose(target, name, at_timestamp_ns, &target_relation);
+static void
+get_tracked_poses(struct xrt_device *xdev,
+                  enum xrt_input_name name,
+                  const uint64_t *at_timestamps_ns,
+                  uint32_t count,
+                  struct xrt_space_relation *out_relations)
+{
+	struct multi_device *d = (struct multi_device *)xdev;
+	struct xrt_device *tracker = d->tracking_override.tracker;
+	enum xrt_input_name tracker_input_name = d->tracking_override.input_name;
 
+	// One call to each device per batch, so they can search their histories once.
+	for (uint32_t first = 0; first < count; first += MULTI_POSE_BATCH_SIZE) {
+		uint32_t batch = count - first < MULTI_POSE_BATCH_SIZE ? count - first : MULTI_POSE_BATCH_SIZE;
+		const uint64_t *timestamps = &at_timestamps_ns[first];
 
-		// just use the origin of the tracker space as reference frame
-		struct xrt_space_relation in_target_space;
-		m_space_relation_ident(&in_target_space);
-		in_target_space.relation_flags = tracker_relation.relation_flags;
+		struct xrt_space_relation tracker_relations[MULTI_POSE_BATCH_SIZE];
+		xrt_device_get_tracked_poses(tracker, tracker_input_name, timestamps, batch, tracker_relations);
 
-		struct xrt_pose *target_offset = &d->tracking_override.target->tracking_origin->offset;
-		struct xrt_pose *tracker_offset = &d->tracking_override.tracker->tracking_origin->offset;
+		struct xrt_space_relation target_relations[MULTI_POSE_BATCH_SIZE];
+		if (d->override_type == XRT_TRACKING_OVERRIDE_ATTACHED) {
+			xrt_device_get_tracked_poses(d->tracking_override.target, name, timestamps, batch,
+			                             target_relations);
+		}
 
-		attached_override(d, &target_relation, target_offset, &tracker_relation, tracker_offset,
-		                  &in_target_space, out_relation);
-	} break;
+		for (uint32_t i = 0; i < batch; i++) {
+			override_relation(d, &target_relations[i], &tracker_relations[i], &out_relations[first + i]);
+		}
 	}
 }
 
@@ -249,12 +301,15 @@ multi_create_tracking_override(enum xrt_tracking_override_type override_type,
 	// tracked thing, we want to transform its pose by y-=.1m relative to the tracker. Multiple target devices may
 	// share a single tracker, therefore we cannot simply adjust the tracker's tracking origin.
 	math_pose_invert(offset, &d->tracking_override.offset_inv);
+	m_space_relation_from_pose(&d->tracking_override.offset_inv, true, &d->tracking_override.offset_inv_relation);
+	d->tracking_override.offset_is_identity = m_pose_is_identity(&d->tracking_override.offset_inv);
 
 	d->tracking_override.target = tracking_override_target;
 	d->tracking_override.tracker = tracking_override_tracker;
 	d->tracking_override.input_name = tracking_override_input_name;
 
 	d->base.get_tracked_pose = get_tracked_pose;
+	d->base.get_tracked_poses = get_tracked_poses;
 	d->base.destroy = destroy;
 	d->base.get_hand_tracking = get_hand_tracking;
 	d->base.set_output = set_output;
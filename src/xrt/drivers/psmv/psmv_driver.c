@@ -59,6 +59,7 @@
 // clang-format on
 
 DEBUG_GET_ONCE_LOG_OPTION(psmv_log, "PSMV_LOG", U_LOGGING_WARN)
+DEBUG_GET_ONCE_BOOL_OPTION(psmv_hid_reactor, "PSMV_HID_REACTOR", true)
 
 /*!
  * Indices where each input is in the input list.
@@ -439,6 +440,12 @@ struct psmv_device
 
 	struct os_thread_helper oth;
 
+	//! Reports are read by the shared hid reactor instead of our own thread.
+	bool use_reactor;
+
+	//! When the previous packet was read, zero until the first is seen.
+	timepoint_ns last_packet_ns;
+
 	struct
 	{
 		int64_t resend_time;
@@ -633,7 +640,8 @@ psmv_led_and_trigger_update(struct psmv_device *psmv, int64_t time)
 
 static void
 update_fusion(struct psmv_device *psmv,
-              struct psmv_parsed_sample *sample,
+              const struct xrt_vec3 *accel,
+              const struct xrt_vec3 *gyro,
               timepoint_ns timestamp_ns,
               time_duration_ns delta_ns)
 {
@@ -641,11 +649,8 @@ update_fusion(struct psmv_device *psmv,
 
 	(void)mag;
 
-
-	struct xrt_vec3_i32 *ra = &sample->accel;
-	struct xrt_vec3_i32 *rg = &sample->gyro;
-
-	m_imu_pre_filter_data(&psmv->calibration.prefilter, ra, rg, &psmv->read.accel, &psmv->read.gyro);
+	psmv->read.accel = *accel;
+	psmv->read.gyro = *gyro;
 
 	if (psmv->ball != NULL) {
 		// We have positional tracking
@@ -704,6 +709,59 @@ psmv_read_one_packet(struct psmv_device *psmv, uint8_t *buffer, size_t size)
 	return false;
 }
 
+/*!
+ * Parses one input packet and feeds it to the fusion, @p now_ns is when the
+ * packet was read.
+ */
+static void
+psmv_handle_packet(struct psmv_device *psmv, void *buffer, timepoint_ns now_ns)
+{
+	struct psmv_parsed_input input = {0};
+
+	int num = psmv_parse_input(psmv, buffer, &input);
+
+	time_duration_ns delta_ns = now_ns - psmv->last_packet_ns;
+	psmv->last_packet_ns = now_ns;
+
+	// Lock last and the fusion.
+	os_mutex_lock(&psmv->lock);
+
+	// Make sure the leds stays on.
+	psmv_led_and_trigger_update_locked(psmv, now_ns);
+
+	// Copy to device.
+	psmv->last = input;
+
+	// Pre-filter all of the samples in the packet in one go, ZCM2 only has one.
+	uint32_t count = num == 2 ? 2 : 1;
+	struct xrt_vec3_i32 raw_accel[2];
+	struct xrt_vec3_i32 raw_gyro[2];
+	struct xrt_vec3 accel[2];
+	struct xrt_vec3 gyro[2];
+	for (uint32_t i = 0; i < count; i++) {
+		raw_accel[i] = input.samples[i].accel;
+		raw_gyro[i] = input.samples[i].gyro;
+	}
+	m_imu_pre_filter_data_array(&psmv->calibration.prefilter, raw_accel, raw_gyro, count, accel, gyro);
+
+	// Process the parsed data.
+	if (num == 2) {
+		// ZCM1
+		update_fusion(psmv, &accel[0], &gyro[0], now_ns - (delta_ns / 2.0), (delta_ns / 2.0));
+		update_fusion(psmv, &accel[1], &gyro[1], now_ns, (delta_ns / 2.0));
+		psmv->last_timestamp_ns = now_ns;
+	} else if (num == 1) {
+		// ZCM2
+		update_fusion(psmv, &accel[0], &gyro[0], now_ns, delta_ns);
+		psmv->last_timestamp_ns = now_ns;
+	} else {
+		assert(false);
+	}
+
+	// Now done.
+	os_mutex_unlock(&psmv->lock);
+}
+
 static void *
 psmv_run_thread(void *ptr)
 {
@@ -716,8 +774,6 @@ psmv_run_thread(void *ptr)
 		struct psmv_input_zcm1 input;
 	} data;
 
-	struct psmv_parsed_input input = {0};
-
 	while (os_hid_read(psmv->hid, data.buffer, sizeof(data), 0) > 0) {
 		// Empty queue first
 	}
@@ -727,46 +783,42 @@ psmv_run_thread(void *ptr)
 		return NULL;
 	}
 
-	timepoint_ns then_ns = os_monotonic_get_ns();
+	psmv->last_packet_ns = os_monotonic_get_ns();
 
 	while (psmv_read_one_packet(psmv, data.buffer, sizeof(data))) {
+		psmv_handle_packet(psmv, data.buffer, os_monotonic_get_ns());
+	}
 
-		timepoint_ns now_ns = os_monotonic_get_ns();
-
-		int num = psmv_parse_input(psmv, data.buffer, &input);
-
-		time_duration_ns delta_ns = now_ns - then_ns;
-		then_ns = now_ns;
+	return NULL;
+}
 
-		// Lock last and the fusion.
-		os_mutex_lock(&psmv->lock);
+#ifdef XRT_OS_LINUX
+static void
+psmv_reactor_report(void *ptr, const uint8_t *data, int size, int64_t timestamp_ns)
+{
+	struct psmv_device *psmv = (struct psmv_device *)ptr;
 
-		// Make sure the leds stays on.
-		psmv_led_and_trigger_update_locked(psmv, now_ns);
+	if (size < 0) {
+		PSMV_ERROR(psmv, "Failed to read device '%i'!", size);
+		return;
+	}
 
-		// Copy to device.
-		psmv->last = input;
+	// The first packet is only used to sync up, it's discarded but that's okay.
+	if (psmv->last_packet_ns == 0) {
+		psmv->last_packet_ns = timestamp_ns;
+		return;
+	}
 
-		// Process the parsed data.
-		if (num == 2) {
-			// ZCM1
-			update_fusion(psmv, &input.samples[0], now_ns - (delta_ns / 2.0), (delta_ns / 2.0));
-			update_fusion(psmv, &input.samples[1], now_ns, (delta_ns / 2.0));
-			psmv->last_timestamp_ns = now_ns;
-		} else if (num == 1) {
-			// ZCM2
-			update_fusion(psmv, &input.sample, now_ns, delta_ns);
-			psmv->last_timestamp_ns = now_ns;
-		} else {
-			assert(false);
-		}
+	union {
+		uint8_t buffer[256];
+		struct psmv_input_zcm1 input;
+	} packet = {0};
 
-		// Now done.
-		os_mutex_unlock(&psmv->lock);
-	}
+	memcpy(packet.buffer, data, MIN((size_t)size, sizeof(packet)));
 
-	return NULL;
+	psmv_handle_packet(psmv, packet.buffer, timestamp_ns);
 }
+#endif
 
 static void
 psmv_get_fusion_pose(struct psmv_device *psmv,
@@ -835,6 +887,13 @@ psmv_device_destroy(struct xrt_device *xdev)
 	// Destroy the thread object.
 	os_thread_helper_destroy(&psmv->oth);
 
+#ifdef XRT_OS_LINUX
+	// Waits for the reactor to be done with us.
+	if (psmv->use_reactor) {
+		os_hid_reactor_unregister(psmv->hid);
+	}
+#endif
+
 	// Now that the thread is not running we can destroy the lock.
 	os_mutex_destroy(&psmv->lock);
 
@@ -1173,7 +1232,18 @@ psmv_device_create(struct xrt_prober *xp, struct xrt_prober_device *xpdev, struc
 	// Send the first update package.
 	psmv_led_and_trigger_update(psmv, 1);
 
-	ret = os_thread_helper_start(&psmv->oth, psmv_run_thread, psmv);
+#ifdef XRT_OS_LINUX
+	// Let the shared reactor read the device if we can, fall back to our own thread.
+	if (debug_get_bool_option_psmv_hid_reactor()) {
+		ret = os_hid_reactor_register(psmv->hid, psmv_reactor_report, psmv);
+		psmv->use_reactor = ret == 0;
+		if (ret != 0) {
+			PSMV_DEBUG(psmv, "Not using the hid reactor '%i'", ret);
+		}
+	}
+#endif
+
+	ret = psmv->use_reactor ? 0 : os_thread_helper_start(&psmv->oth, psmv_run_thread, psmv);
 	if (ret != 0) {
 		PSMV_ERROR(psmv, "Failed to start thread!");
 		psmv_device_destroy(&psmv->base);
@@ -577,6 +577,12 @@ rs2xrt_frame(struct rs_source *rs, rs2_frame *rframe, struct xrt_frame **out_xfr
 	RS_DASSERT(rs_stride == stride, "%d != %d", rs_stride, stride);
 #endif
 
+	// The xrt_frame wraps the librealsense buffer without copying it and
+	// owns the rframe reference until it is destroyed. Downstream, like the
+	// SLAM queues, can hold on to frames for a while so take the frame out of
+	// the pool librealsense cycles through, it would stall capture otherwise.
+	rs2_keep_frame(rframe);
+
 	struct xrt_frame *xf = U_TYPED_CALLOC(struct xrt_frame);
 	xf->reference.count = 1;
 	xf->destroy = rs_source_frame_destroy;
@@ -624,7 +630,8 @@ handle_frameset(struct rs_source *rs, rs2_frame *frames)
 		struct xrt_frame *xf_right = NULL;
 		rs2xrt_frame(rs, rframe_right, &xf_right);
 
-		if (xf_left->timestamp == xf_right->timestamp) {
+		// The timestamp field is only set below, compare the device ones.
+		if (xf_left->source_timestamp == xf_right->source_timestamp) {
 
 			// Correct timestamps to same monotonic time
 			uint64_t now_monotonic = os_monotonic_get_ns();
@@ -638,7 +645,7 @@ handle_frameset(struct rs_source *rs, rs2_frame *frames)
 		} else {
 			// This usually happens only once at start and never again
 			RS_WARN(rs, "Realsense device sent left and right frames with different timestamps %ld != %ld",
-			        xf_left->timestamp, xf_right->timestamp);
+			        xf_left->source_timestamp, xf_right->source_timestamp);
 		}
 
 		xrt_frame_reference(&xf_right, NULL);
@@ -928,10 +935,8 @@ receive_right_frame(struct xrt_frame_sink *sink, struct xrt_frame *xf)
 }
 
 static void
-receive_imu_sample(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
+debug_imu_sample(struct rs_source *rs, const struct xrt_imu_sample *s)
 {
-	struct rs_source *rs = container_of(sink, struct rs_source, imu_sink);
-
 	timepoint_ns ts = s->timestamp_ns;
 	struct xrt_vec3_f64 a = s->accel_m_s2;
 	struct xrt_vec3_f64 w = s->gyro_rad_secs;
@@ -943,12 +948,34 @@ receive_imu_sample(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
 	struct xrt_vec3 accel = {(float)a.x, (float)a.y, (float)a.z};
 	m_ff_vec3_f32_push(rs->gyro_ff, &gyro, ts);
 	m_ff_vec3_f32_push(rs->accel_ff, &accel, ts);
+}
+
+static void
+receive_imu_sample(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
+{
+	struct rs_source *rs = container_of(sink, struct rs_source, imu_sink);
+
+	debug_imu_sample(rs, s);
 
 	if (rs->out_sinks.imu) {
 		xrt_sink_push_imu(rs->out_sinks.imu, s);
 	}
 }
 
+static void
+receive_imu_samples(struct xrt_imu_sink *sink, struct xrt_imu_sample *samples, uint32_t count)
+{
+	struct rs_source *rs = container_of(sink, struct rs_source, imu_sink);
+
+	for (uint32_t i = 0; i < count; i++) {
+		debug_imu_sample(rs, &samples[i]);
+	}
+
+	if (rs->out_sinks.imu) {
+		xrt_sink_push_imu_batch(rs->out_sinks.imu, samples, count);
+	}
+}
+
 
 /*
  *
@@ -1092,6 +1119,7 @@ rs_source_create(struct xrt_frame_context *xfctx, int device_idx)
 	rs->left_sink.push_frame = receive_left_frame;
 	rs->right_sink.push_frame = receive_right_frame;
 	rs->imu_sink.push_imu = receive_imu_sample;
+	rs->imu_sink.push_imu_batch = receive_imu_samples;
 	rs->in_sinks.cam_count = 2;
 	rs->in_sinks.cams[0] = &rs->left_sink;
 	rs->in_sinks.cams[1] = &rs->right_sink;
@@ -56,6 +56,8 @@ r_device_update_inputs(struct xrt_device *xdev)
 	struct r_device *rd = r_device(xdev);
 	struct r_hub *r = rd->r;
 
+	r_hub_poll(r);
+
 	uint64_t now = os_monotonic_get_ns();
 	struct r_remote_controller_data *latest = rd->is_left ? &r->latest.left : &r->latest.right;
 
@@ -108,27 +110,11 @@ r_device_get_tracked_pose(struct xrt_device *xdev,
 		return;
 	}
 
-	struct r_remote_controller_data *latest = rd->is_left ? &r->latest.left : &r->latest.right;
+	r_hub_poll(r);
 
-	/*
-	 * It's easier to reason about angular velocity if it's controlled in
-	 * body space, but the angular velocity returned in the relation is in
-	 * the base space.
-	 */
-	math_quat_rotate_derivative(&latest->pose.orientation, &latest->angular_velocity,
-	                            &out_relation->angular_velocity);
-
-	out_relation->pose = latest->pose;
-	out_relation->linear_velocity = latest->linear_velocity;
-
-	if (latest->active) {
-		out_relation->relation_flags = (enum xrt_space_relation_flags)(
-		    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
-		    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT |
-		    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
-	} else {
-		out_relation->relation_flags = 0;
-	}
+	// Pushed with the angular velocity already in the base space.
+	struct m_relation_history *history = rd->is_left ? r->history.left : r->history.right;
+	m_relation_history_get(history, at_timestamp_ns, out_relation);
 }
 
 static void
@@ -36,12 +36,11 @@ r_hmd(struct xrt_device *xdev)
 }
 
 static inline void
-copy_head_center_to_relation(struct r_hmd *rh, struct xrt_space_relation *out_relation)
+get_head_center_relation(struct r_hmd *rh, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
 {
-	out_relation->pose = rh->r->latest.head.center;
-	out_relation->relation_flags = (enum xrt_space_relation_flags)(
-	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
-	    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT);
+	r_hub_poll(rh->r);
+
+	m_relation_history_get(rh->r->history.head, at_timestamp_ns, out_relation);
 }
 
 static void
@@ -65,7 +64,7 @@ r_hmd_get_tracked_pose(struct xrt_device *xdev,
 	struct r_hmd *rh = r_hmd(xdev);
 
 	switch (name) {
-	case XRT_INPUT_GENERIC_HEAD_POSE: copy_head_center_to_relation(rh, out_relation); break;
+	case XRT_INPUT_GENERIC_HEAD_POSE: get_head_center_relation(rh, at_timestamp_ns, out_relation); break;
 	case XRT_INPUT_GENERIC_STAGE_SPACE_POSE:
 		// STAGE is implicitly defined as the space poses are returned in, therefore STAGE origin is (0, 0, 0).
 		*out_relation = (struct xrt_space_relation)XRT_SPACE_RELATION_ZERO;
@@ -97,6 +96,8 @@ r_hmd_get_view_poses(struct xrt_device *xdev,
 {
 	struct r_hmd *rh = r_hmd(xdev);
 
+	r_hub_poll(rh->r);
+
 	if (!rh->r->latest.head.per_view_data_valid) {
 		u_device_get_view_poses(  //
 		    xdev,                 //
@@ -116,7 +117,7 @@ r_hmd_get_view_poses(struct xrt_device *xdev,
 		return;
 	}
 
-	copy_head_center_to_relation(rh, out_head_relation);
+	get_head_center_relation(rh, at_timestamp_ns, out_head_relation);
 
 	for (uint32_t i = 0; i < view_count; i++) {
 		out_poses[i] = rh->r->latest.head.views[i].pose;
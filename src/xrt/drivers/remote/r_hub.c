@@ -9,6 +9,10 @@
 
 #include "r_internal.h"
 
+#include "os/os_time.h"
+
+#include "math/m_api.h"
+
 #include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_debug.h"
@@ -17,6 +21,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 
 #if defined(XRT_OS_WINDOWS)
 #include <winsock2.h>
@@ -30,6 +35,9 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 
 #ifndef _BSD_SOURCE
@@ -57,6 +65,14 @@
  */
 
 DEBUG_GET_ONCE_LOG_OPTION(remote_log, "REMOTE_LOG", U_LOGGING_INFO)
+DEBUG_GET_ONCE_BOOL_OPTION(remote_udp, "REMOTE_UDP", false)
+DEBUG_GET_ONCE_OPTION(remote_shm, "REMOTE_SHM", NULL)
+
+/*!
+ * A sequence number this far behind the last one is taken to be from a
+ * restarted producer rather than a late packet.
+ */
+#define R_SEQUENCE_RESTART_DISTANCE 1024
 
 #define R_TRACE(R, ...) U_LOG_IFL_T((R)->rc.log_level, __VA_ARGS__)
 #define R_DEBUG(R, ...) U_LOG_IFL_D((R)->rc.log_level, __VA_ARGS__)
@@ -91,6 +107,18 @@ socket_create(void)
 	return socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
 }
 
+static inline r_socket_t
+socket_create_udp(void)
+{
+	return socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+}
+
+static inline ssize_t
+socket_recv_datagram(r_socket_t id, void *ptr, size_t size)
+{
+	return recv(id, (char *)ptr, (int)size, 0);
+}
+
 static inline int
 socket_set_opt(r_socket_t id, int flag)
 {
@@ -123,6 +151,18 @@ socket_create(void)
 	return socket(AF_INET, SOCK_STREAM, 0);
 }
 
+static inline r_socket_t
+socket_create_udp(void)
+{
+	return socket(AF_INET, SOCK_DGRAM, 0);
+}
+
+static inline ssize_t
+socket_recv_datagram(r_socket_t id, void *ptr, size_t size)
+{
+	return recv(id, ptr, size, 0);
+}
+
 static inline int
 socket_set_opt(r_socket_t id, int flag)
 {
@@ -206,7 +246,7 @@ cleanup:
 }
 
 static bool
-wait_for_read_and_to_continue(struct r_hub *r, r_socket_t socket)
+wait_for_read_and_to_continue(struct r_hub *r, struct os_thread_helper *oth, r_socket_t socket)
 {
 	fd_set set;
 	int ret = 0;
@@ -216,7 +256,7 @@ wait_for_read_and_to_continue(struct r_hub *r, r_socket_t socket)
 		return false;
 	}
 
-	while (os_thread_helper_is_running(&r->oth) && ret == 0) {
+	while (os_thread_helper_is_running(oth) && ret == 0) {
 		// Select can modify timeout, reset each loop.
 		struct timeval timeout = {.tv_sec = 1, .tv_usec = 0};
 
@@ -242,7 +282,7 @@ do_accept(struct r_hub *r)
 {
 	struct sockaddr_in addr = {0};
 	r_socket_t ret = 0;
-	if (!wait_for_read_and_to_continue(r, r->accept_fd)) {
+	if (!wait_for_read_and_to_continue(r, &r->oth, r->accept_fd)) {
 		R_ERROR(r, "Failed to wait for id " R_SOCKET_FMT, r->accept_fd);
 		return -1;
 	}
@@ -282,7 +322,7 @@ read_one(struct r_hub *r, struct r_remote_data *data)
 	while (current < size) {
 		void *ptr = (uint8_t *)data + current;
 
-		if (!wait_for_read_and_to_continue(r, rc->fd)) {
+		if (!wait_for_read_and_to_continue(r, &r->oth, rc->fd)) {
 			return -1;
 		}
 
@@ -337,7 +377,7 @@ run_thread(void *ptr)
 				break;
 			}
 
-			r->latest = data;
+			r_hub_push_data(r, &data, 0);
 		}
 	}
 
@@ -346,6 +386,186 @@ run_thread(void *ptr)
 	return NULL;
 }
 
+static bool
+is_newer_sequence(bool have_sequence, uint64_t last_sequence, uint64_t sequence)
+{
+	if (!have_sequence || sequence > last_sequence) {
+		return true;
+	}
+
+	// A big jump backwards is a restarted producer.
+	return last_sequence - sequence > R_SEQUENCE_RESTART_DISTANCE;
+}
+
+static r_socket_t
+setup_udp_fd(struct r_hub *r)
+{
+	struct sockaddr_in address = {0};
+
+	r_socket_t ret = socket_create_udp();
+	if (ret < 0) {
+		R_ERROR(r, "socket: " R_SOCKET_FMT, ret);
+		return ret;
+	}
+
+	r->udp.fd = ret;
+
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(r->port);
+
+	ret = bind(r->udp.fd, (struct sockaddr *)&address, sizeof(address));
+	if (ret < 0) {
+		R_ERROR(r, "bind: " R_SOCKET_FMT, ret);
+		socket_close(r->udp.fd);
+		r->udp.fd = -1;
+		return ret;
+	}
+
+	R_INFO(r, "Receiving pose packets on UDP port %d", r->port);
+
+	return 0;
+}
+
+static void *
+run_udp_thread(void *ptr)
+{
+	struct r_hub *r = (struct r_hub *)ptr;
+
+#if defined(XRT_OS_WINDOWS)
+	// Reference counted, so fine to do on both threads.
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+		R_ERROR(r, "Failed to do WSAStartup %d", WSAGetLastError());
+		return NULL;
+	}
+#endif
+
+	bool ok = setup_udp_fd(r) >= 0;
+
+	while (ok && wait_for_read_and_to_continue(r, &r->udp.oth, r->udp.fd)) {
+		struct r_remote_pose_packet packet;
+
+		ssize_t ret = socket_recv_datagram(r->udp.fd, &packet, sizeof(packet));
+		if (ret != (ssize_t)sizeof(packet) || packet.header != R_POSE_PACKET_HEADER_VALUE) {
+			R_TRACE(r, "Dropping malformed packet of %zi bytes", ret);
+			continue;
+		}
+
+		// Newest wins, a late packet is worth less than no packet.
+		if (!is_newer_sequence(r->udp.have_sequence, r->udp.last_sequence, packet.sequence)) {
+			R_TRACE(r, "Dropping old packet %" PRIu64 " (last %" PRIu64 ")", packet.sequence,
+			        r->udp.last_sequence);
+			continue;
+		}
+
+		r->udp.last_sequence = packet.sequence;
+		r->udp.have_sequence = true;
+
+		r_hub_push_data(r, &packet.data, packet.timestamp_ns);
+	}
+
+#if defined(XRT_OS_WINDOWS)
+	WSACleanup();
+#endif
+
+	R_INFO(r, "Leaving UDP thread");
+
+	return NULL;
+}
+
+#if defined(XRT_OS_UNIX)
+static void
+setup_shm(struct r_hub *r, const char *name)
+{
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0) {
+		R_ERROR(r, "Failed to open shared memory '%s'", name);
+		return;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(struct r_remote_shm)) {
+		R_ERROR(r, "Shared memory '%s' is too small", name);
+		close(fd);
+		return;
+	}
+
+	void *ptr = mmap(NULL, sizeof(struct r_remote_shm), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (ptr == MAP_FAILED) {
+		R_ERROR(r, "Failed to map shared memory '%s'", name);
+		return;
+	}
+
+	if (os_mutex_init(&r->shm.mutex) != 0) {
+		munmap(ptr, sizeof(struct r_remote_shm));
+		return;
+	}
+
+	r->shm.ptr = (const struct r_remote_shm *)ptr;
+
+	R_INFO(r, "Reading pose packets from shared memory '%s'", name);
+}
+
+static bool
+read_shm(const struct r_remote_shm *shm, struct r_remote_pose_packet *out_packet)
+{
+	// The producer writes at most a few hundred Hz, so it is rarely mid write, don't spin for long.
+	for (int i = 0; i < 4; i++) {
+		uint32_t seq = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+		if ((seq & 1) != 0) {
+			continue;
+		}
+
+		memcpy(out_packet, (const void *)&shm->packet, sizeof(*out_packet));
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&shm->seq, __ATOMIC_RELAXED) == seq) {
+			return true;
+		}
+	}
+
+	return false;
+}
+#endif
+
+static void
+push_controller(struct m_relation_history *rh, const struct r_remote_controller_data *data, uint64_t ts)
+{
+	struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+	relation.pose = data->pose;
+	relation.linear_velocity = data->linear_velocity;
+
+	/*
+	 * It's easier to reason about angular velocity if it's controlled in
+	 * body space, but the angular velocity in the relation is in the base
+	 * space.
+	 */
+	math_quat_rotate_derivative(&data->pose.orientation, &data->angular_velocity, &relation.angular_velocity);
+
+	if (data->active) {
+		relation.relation_flags = (enum xrt_space_relation_flags)(
+		    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+		    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT |
+		    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+	}
+
+	m_relation_history_push(rh, &relation, ts);
+}
+
+static void
+push_head(struct m_relation_history *rh, const struct r_head_data *data, uint64_t ts)
+{
+	struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+	relation.pose = data->center;
+	relation.relation_flags = (enum xrt_space_relation_flags)(
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT);
+
+	m_relation_history_push(rh, &relation, ts);
+}
+
 static xrt_result_t
 r_hub_system_devices_get_roles(struct xrt_system_devices *xsysd, struct xrt_system_roles *out_roles)
 {
@@ -368,8 +588,11 @@ r_hub_system_devices_destroy(struct xrt_system_devices *xsysd)
 
 	R_DEBUG(r, "Destroying");
 
-	// Stop the thread first.
+	// Stop the threads first.
 	os_thread_helper_stop_and_wait(&r->oth);
+	if (r->udp.oth.initialized) {
+		os_thread_helper_stop_and_wait(&r->udp.oth);
+	}
 
 	// Destroy all of the devices now.
 	for (uint32_t i = 0; i < ARRAY_SIZE(r->base.xdevs); i++) {
@@ -387,6 +610,23 @@ r_hub_system_devices_destroy(struct xrt_system_devices *xsysd)
 		r->rc.fd = -1;
 	}
 
+	if (r->udp.fd >= 0) {
+		socket_close(r->udp.fd);
+		r->udp.fd = -1;
+	}
+
+#if defined(XRT_OS_UNIX)
+	if (r->shm.ptr != NULL) {
+		munmap((void *)r->shm.ptr, sizeof(struct r_remote_shm));
+		r->shm.ptr = NULL;
+		os_mutex_destroy(&r->shm.mutex);
+	}
+#endif
+
+	m_relation_history_destroy(&r->history.head);
+	m_relation_history_destroy(&r->history.left);
+	m_relation_history_destroy(&r->history.right);
+
 	free(r);
 
 #if defined(XRT_OS_WINDOWS)
@@ -396,6 +636,52 @@ r_hub_system_devices_destroy(struct xrt_system_devices *xsysd)
 }
 
 
+/*
+ *
+ * 'Exported' hub functions.
+ *
+ */
+
+void
+r_hub_push_data(struct r_hub *r, const struct r_remote_data *data, int64_t timestamp_ns)
+{
+	uint64_t ts = timestamp_ns > 0 ? (uint64_t)timestamp_ns : os_monotonic_get_ns();
+
+	r->latest = *data;
+
+	push_head(r->history.head, &data->head, ts);
+	push_controller(r->history.left, &data->left, ts);
+	push_controller(r->history.right, &data->right, ts);
+}
+
+void
+r_hub_poll(struct r_hub *r)
+{
+#if defined(XRT_OS_UNIX)
+	if (r->shm.ptr == NULL) {
+		return;
+	}
+
+	struct r_remote_pose_packet packet;
+	if (!read_shm(r->shm.ptr, &packet) || packet.header != R_POSE_PACKET_HEADER_VALUE) {
+		return;
+	}
+
+	// Queried from many threads, only one of them gets to push a new packet.
+	os_mutex_lock(&r->shm.mutex);
+	if (is_newer_sequence(r->shm.have_sequence, r->shm.last_sequence, packet.sequence)) {
+		r->shm.last_sequence = packet.sequence;
+		r->shm.have_sequence = true;
+
+		r_hub_push_data(r, &packet.data, packet.timestamp_ns);
+	}
+	os_mutex_unlock(&r->shm.mutex);
+#else
+	(void)r;
+#endif
+}
+
+
 /*
  *
  * 'Exported' create function.
@@ -440,9 +726,22 @@ r_create_devices(uint16_t port,
 	r->view_count = view_count;
 	r->accept_fd = -1;
 	r->rc.fd = -1;
+	r->udp.fd = -1;
 
 	snprintf(r->origin.name, sizeof(r->origin.name), "Remote Simulator");
 
+	m_relation_history_create(&r->history.head);
+	m_relation_history_create(&r->history.left);
+	m_relation_history_create(&r->history.right);
+	r_hub_push_data(r, &r->reset, 0);
+
+#if defined(XRT_OS_UNIX)
+	const char *shm_name = debug_get_option_remote_shm();
+	if (shm_name != NULL) {
+		setup_shm(r, shm_name);
+	}
+#endif
+
 	ret = os_thread_helper_init(&r->oth);
 	if (ret != 0) {
 		R_ERROR(r, "Failed to init threading!");
@@ -457,6 +756,18 @@ r_create_devices(uint16_t port,
 		return XRT_ERROR_ALLOCATION;
 	}
 
+	if (debug_get_bool_option_remote_udp()) {
+		ret = os_thread_helper_init(&r->udp.oth);
+		if (ret == 0) {
+			ret = os_thread_helper_start(&r->udp.oth, run_udp_thread, r);
+		}
+		if (ret != 0) {
+			R_ERROR(r, "Failed to start UDP thread!");
+			r_hub_system_devices_destroy(&r->base);
+			return XRT_ERROR_ALLOCATION;
+		}
+	}
+
 
 	/*
 	 * Setup system devices.
@@ -144,6 +144,58 @@ struct r_remote_data
 	struct r_remote_controller_data left, right;
 };
 
+/*!
+ * Header value to be set in @ref r_remote_pose_packet.
+ *
+ * @ingroup drv_remote
+ */
+#define R_POSE_PACKET_HEADER_VALUE (*(uint64_t *)"mndrmtp\0")
+
+/*!
+ * A single datagram of the UDP transport, and what the shared memory transport
+ * holds. Unlike the stream the packets can be lost or arrive out of order, so
+ * each carries a sequence number and only ever the newest one is used.
+ *
+ * @ingroup drv_remote
+ */
+struct r_remote_pose_packet
+{
+	//! Must be @ref R_POSE_PACKET_HEADER_VALUE.
+	uint64_t header;
+
+	//! Increased by the producer for every packet, older or repeated ones are dropped.
+	uint64_t sequence;
+
+	/*!
+	 * When the poses were sampled in CLOCK_MONOTONIC nanoseconds of the host
+	 * running Monado, or zero to use the time the packet was received.
+	 */
+	int64_t timestamp_ns;
+
+	struct r_remote_data data;
+};
+
+/*!
+ * Shared memory for producers on the same host, the producer creates it with
+ * shm_open and the hub maps it read only, it gives the name in the
+ * `REMOTE_SHM` environment variable.
+ *
+ * The producer writes it like a sequence lock: increment @ref seq to odd,
+ * write @ref packet, then increment @ref seq to even again with release
+ * semantics. No system call is needed on either side.
+ *
+ * @ingroup drv_remote
+ */
+struct r_remote_shm
+{
+	//! Odd while the producer is writing the packet.
+	uint32_t seq;
+
+	uint32_t _pad;
+
+	struct r_remote_pose_packet packet;
+};
+
 /*!
  * Shared connection.
  *
@@ -19,6 +19,8 @@
 
 #include "util/u_hand_tracking.h"
 
+#include "math/m_relation_history.h"
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -49,6 +51,37 @@ struct r_hub
 	//! Incoming connection socket.
 	r_socket_t accept_fd;
 
+	//! Poses of the devices, so they can be predicted.
+	struct
+	{
+		struct m_relation_history *head, *left, *right;
+	} history;
+
+	//! Optional UDP pose transport, on the same port number as the stream.
+	struct
+	{
+		r_socket_t fd;
+
+		struct os_thread_helper oth;
+
+		//! Sequence of the newest packet used.
+		uint64_t last_sequence;
+		bool have_sequence;
+	} udp;
+
+	//! Optional shared memory pose transport, polled when the devices are queried.
+	struct
+	{
+		struct os_mutex mutex;
+
+		//! Mapped read only, NULL if not used.
+		const struct r_remote_shm *ptr;
+
+		//! Sequence of the newest packet used.
+		uint64_t last_sequence;
+		bool have_sequence;
+	} shm;
+
 	uint16_t port;
 	uint32_t view_count;
 
@@ -95,6 +128,24 @@ struct r_device
 };
 
 
+/*!
+ * Make @p data the latest and push its poses into the histories, called from
+ * the transport that received it. A @p timestamp_ns of zero means now.
+ *
+ * @public @memberof r_hub
+ */
+void
+r_hub_push_data(struct r_hub *r, const struct r_remote_data *data, int64_t timestamp_ns);
+
+/*!
+ * Pick up a new packet from the shared memory transport if there is one,
+ * called before the latest data or the histories are used.
+ *
+ * @public @memberof r_hub
+ */
+void
+r_hub_poll(struct r_hub *r);
+
 struct xrt_device *
 r_hmd_create(struct r_hub *r);
 
@@ -174,6 +174,7 @@ rift_s_system_create(struct xrt_prober *xp,
 	}
 	//
 	// Thread and other state.
+	u_io_stats_init(&sys->io_stats, "Rift S: Packet I/O");
 	ret = os_thread_helper_init(&sys->oth);
 	if (ret != 0) {
 		RIFT_S_ERROR("Failed to init packet processing thread");
@@ -526,6 +527,7 @@ handle_packets(struct rift_s_system *sys)
 			}
 
 			now = os_monotonic_get_ns();
+			u_io_stats_packet_begin(&sys->io_stats, now);
 
 			if (buf[0] == 0x65)
 				handle_hmd_report(sys, now, buf, size);
@@ -543,6 +545,8 @@ handle_packets(struct rift_s_system *sys)
 			} else {
 				RIFT_S_WARN("Unknown Rift S report 0x%02x!", buf[0]);
 			}
+
+			u_io_stats_packet_end(&sys->io_stats, os_monotonic_get_ns());
 		}
 	}
 
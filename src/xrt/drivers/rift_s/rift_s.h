@@ -19,6 +19,7 @@
 
 #include "os/os_threading.h"
 #include "util/u_logging.h"
+#include "util/u_io_stats.h"
 #include "xrt/xrt_defines.h"
 #include "xrt/xrt_frame.h"
 #include "xrt/xrt_frameserver.h"
@@ -81,6 +82,9 @@ struct rift_s_system
 	struct os_hid_device *handles[3];
 	uint64_t last_keep_alive;
 
+	/* How well the packet thread keeps up, over all of the interfaces */
+	struct u_io_stats io_stats;
+
 	/* state tracking for tracked devices on our radio link */
 	int num_active_tracked_devices;
 	struct rift_s_tracked_device tracked_device[MAX_TRACKED_DEVICES];
@@ -12,6 +12,12 @@
  * The Rift S camera module, handles reception and dispatch
  * of camera frames.
  *
+ * The cameras are a UVC device, so the frames come from the v4l2 frameserver
+ * in its mmap or userptr buffers, which are requeued when the last reference
+ * is released. Everything pushed to SLAM, hand tracking and the debug sinks
+ * is a @ref u_frame_create_roi view into those buffers, nothing is copied
+ * unless the camera only offers MJPEG and the frames have to be decoded.
+ *
  * @author Jan Schmidt <jan@centricular.com>
  * @ingroup drv_rift_s
  */
@@ -393,10 +399,13 @@ receive_cam_frame(struct xrt_frame_sink *sink, struct xrt_frame *xf)
 		int y_offset = get_y_offset(cam, 0, &row_data);
 		struct xrt_rect roi = {.offset = {0, y_offset}, .extent = {.w = xf->width, .h = 480}};
 
-		struct xrt_frame *xf_crop = NULL;
-		u_frame_create_roi(xf, roi, &xf_crop);
-		u_sink_debug_push_frame(&cam->debug_sinks[0], xf_crop);
-		xrt_frame_reference(&xf_crop, NULL);
+		// Only make the cropped frame if the debug UI wants it.
+		if (u_sink_debug_is_active(&cam->debug_sinks[0])) {
+			struct xrt_frame *xf_crop = NULL;
+			u_frame_create_roi(xf, roi, &xf_crop);
+			u_sink_debug_push_frame(&cam->debug_sinks[0], xf_crop);
+			xrt_frame_reference(&xf_crop, NULL);
+		}
 
 		/* Extract camera frames and push to the tracker */
 		struct xrt_frame *frames[RIFT_S_CAMERA_COUNT] = {0};
@@ -415,12 +424,14 @@ receive_cam_frame(struct xrt_frame_sink *sink, struct xrt_frame *xf)
 			xrt_frame_reference(&frames[i], NULL);
 		}
 	} else {
-		struct xrt_rect roi = {.offset = {0, 40}, .extent = {.w = xf->width, .h = 480}};
-		struct xrt_frame *xf_crop = NULL;
+		if (u_sink_debug_is_active(&cam->debug_sinks[1])) {
+			struct xrt_rect roi = {.offset = {0, 40}, .extent = {.w = xf->width, .h = 480}};
+			struct xrt_frame *xf_crop = NULL;
 
-		u_frame_create_roi(xf, roi, &xf_crop);
-		u_sink_debug_push_frame(&cam->debug_sinks[1], xf_crop);
-		xrt_frame_reference(&xf_crop, NULL);
+			u_frame_create_roi(xf, roi, &xf_crop);
+			u_sink_debug_push_frame(&cam->debug_sinks[1], xf_crop);
+			xrt_frame_reference(&xf_crop, NULL);
+		}
 	}
 	if (release_xf)
 		xrt_frame_reference(&xf, NULL);
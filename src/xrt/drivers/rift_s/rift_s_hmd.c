@@ -73,7 +73,12 @@ rift_s_hmd_handle_report(struct rift_s_hmd *hmd, timepoint_ns local_ts, rift_s_h
 
 	int n_samples = 0;
 
-	for (int i = 0; i < 3; i++) {
+	uint64_t timestamps_ns[RIFT_S_TRACKER_MAX_IMU_SAMPLES];
+	struct xrt_vec3 accels[RIFT_S_TRACKER_MAX_IMU_SAMPLES];
+	struct xrt_vec3 gyros[RIFT_S_TRACKER_MAX_IMU_SAMPLES];
+	uint32_t count = 0;
+
+	for (int i = 0; i < RIFT_S_TRACKER_MAX_IMU_SAMPLES; i++) {
 		rift_s_hmd_imu_sample_t *s = report->samples + i;
 		if (s->marker & 0x80)
 			break; /* Sample (and remaining ones) are invalid */
@@ -142,13 +147,20 @@ rift_s_hmd_handle_report(struct rift_s_hmd *hmd, timepoint_ns local_ts, rift_s_h
 			gyro.x, gyro.y, gyro.z);
 #endif
 
-		// Send the sample to the pose tracker
-		rift_s_tracker_imu_update(hmd->tracker, hmd->last_imu_timestamp_ns, &accel, &gyro);
+		timestamps_ns[count] = hmd->last_imu_timestamp_ns;
+		accels[count] = accel;
+		gyros[count] = gyro;
+		count++;
 
 		hmd->last_imu_timestamp_ns += (uint64_t)dt * OS_NS_PER_USEC;
 		hmd->last_imu_timestamp32 += dt;
 		dt = TICK_LEN_US;
 	}
+
+	// Send the samples of the whole report to the pose tracker at once
+	if (count > 0) {
+		rift_s_tracker_imu_update(hmd->tracker, timestamps_ns, accels, gyros, count);
+	}
 }
 
 static bool
@@ -218,6 +230,7 @@ rift_s_hmd_create(struct rift_s_system *sys, const unsigned char *hmd_serial_no,
 	hmd->base.destroy = rift_s_hmd_destroy;
 	hmd->base.name = XRT_DEVICE_GENERIC_HMD;
 	hmd->base.device_type = XRT_DEVICE_TYPE_HMD;
+	hmd->base.late_pose_refinement_supported = true;
 
 	hmd->tracker = rift_s_system_get_tracker(sys);
 
@@ -330,6 +343,9 @@ rift_s_hmd_create(struct rift_s_system *sys, const unsigned char *hmd_serial_no,
 	/* Add tracker variables to the HMD debug */
 	rift_s_tracker_add_debug_ui(hmd->tracker, hmd);
 
+	/* Written by the packet thread of the system */
+	u_io_stats_add_vars(&hmd->sys->io_stats, hmd);
+
 	u_var_add_gui_header(hmd, NULL, "Misc");
 	u_var_add_log_level(hmd, &rift_s_log_level, "log_level");
 
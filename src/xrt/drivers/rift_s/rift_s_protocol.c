@@ -29,6 +29,8 @@
 #include "os/os_hid.h"
 #include "os/os_time.h"
 
+#include "util/u_device_config_cache.h"
+
 #include "xrt/xrt_defines.h"
 
 #include "rift_s.h"
@@ -261,10 +263,29 @@ rift_s_read_firmware_block(struct os_hid_device *dev, uint8_t block_id, char **d
 	if (block_len < 0xC || block_len == 0xFFFFFFFF)
 		return -1; /* Invalid block */
 
-#if 0
+	/*
+	 * The header is cheap to read compared to the contents, and what
+	 * looks like a checksum in it changes with them, so use it to find
+	 * the block on disk. Set XRT_DEVICE_CONFIG_CACHE=false to always read.
+	 */
 	uint64_t checksum = *(uint64_t *)(buf + 8);
-	printf ("FW Block %02x Header. Checksum(?) %08lx len %d\n", block_id, checksum, block_len);
-#endif
+	uint64_t cache_key = U_DEVICE_CONFIG_CACHE_HASH_INIT;
+	cache_key = u_device_config_cache_hash_bytes(cache_key, &checksum, sizeof(checksum));
+	cache_key = u_device_config_cache_hash_bytes(cache_key, &block_len, sizeof(block_len));
+
+	char cache_name[32];
+	snprintf(cache_name, sizeof(cache_name), "rift_s-fw-block-%02x", block_id);
+
+	uint8_t *cached = NULL;
+	size_t cached_size = 0;
+	if (u_device_config_cache_load(cache_name, NULL, cache_key, &cached, &cached_size)) {
+		if (cached_size == block_len) {
+			*data_out = (char *)cached;
+			*len_out = block_len;
+			return 0;
+		}
+		free(cached);
+	}
 
 	/* Copy the contents of the fw block, minus the header */
 	outbuf = malloc(block_len + 1);
@@ -303,6 +324,8 @@ rift_s_read_firmware_block(struct os_hid_device *dev, uint8_t block_id, char **d
 #endif
 	}
 
+	u_device_config_cache_store(cache_name, NULL, cache_key, outbuf, block_len);
+
 	*data_out = (char *)(outbuf);
 	*len_out = block_len;
 
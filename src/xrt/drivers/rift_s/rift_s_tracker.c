@@ -494,10 +494,14 @@ clock_hw2mono_get(struct rift_s_tracker *t, uint64_t device_ts, timepoint_ns *ou
 
 void
 rift_s_tracker_imu_update(struct rift_s_tracker *t,
-                          uint64_t device_timestamp_ns,
-                          const struct xrt_vec3 *accel,
-                          const struct xrt_vec3 *gyro)
+                          const uint64_t *device_timestamps_ns,
+                          const struct xrt_vec3 *accels,
+                          const struct xrt_vec3 *gyros,
+                          uint32_t count)
 {
+	struct xrt_imu_sample samples[RIFT_S_TRACKER_MAX_IMU_SAMPLES];
+	assert(count <= RIFT_S_TRACKER_MAX_IMU_SAMPLES);
+
 	os_mutex_lock(&t->mutex);
 
 	/* Ignore packets before we're ready and clock is stable */
@@ -506,39 +510,48 @@ rift_s_tracker_imu_update(struct rift_s_tracker *t,
 		return;
 	}
 
-	/* Get the smoothed monotonic time estimate for this IMU sample */
-	timepoint_ns local_timestamp_ns;
-
-	clock_hw2mono_get(t, device_timestamp_ns, &local_timestamp_ns);
+	for (uint32_t i = 0; i < count; i++) {
+		uint64_t device_timestamp_ns = device_timestamps_ns[i];
+		const struct xrt_vec3 *accel = &accels[i];
+		const struct xrt_vec3 *gyro = &gyros[i];
 
-	if (t->fusion.last_imu_local_timestamp_ns != 0 && local_timestamp_ns < t->fusion.last_imu_local_timestamp_ns) {
-		RIFT_S_WARN("IMU time went backward by %" PRId64 " ns",
-		            local_timestamp_ns - t->fusion.last_imu_local_timestamp_ns);
-	} else {
-		m_imu_3dof_update(&t->fusion.i3dof, local_timestamp_ns, accel, gyro);
-	}
+		/* Get the smoothed monotonic time estimate for this IMU sample */
+		timepoint_ns local_timestamp_ns;
 
-	RIFT_S_TRACE("IMU timestamp %" PRIu64 " (dt %f) hw2mono local ts %" PRIu64 " (dt %f) offset %" PRId64,
-	             device_timestamp_ns,
-	             (double)(device_timestamp_ns - t->fusion.last_imu_timestamp_ns) / 1000000000.0, local_timestamp_ns,
-	             (double)(local_timestamp_ns - t->fusion.last_imu_local_timestamp_ns) / 1000000000.0, t->hw2mono);
+		clock_hw2mono_get(t, device_timestamp_ns, &local_timestamp_ns);
 
-	t->fusion.last_angular_velocity = *gyro;
-	t->fusion.last_imu_timestamp_ns = device_timestamp_ns;
-	t->fusion.last_imu_local_timestamp_ns = local_timestamp_ns;
+		if (t->fusion.last_imu_local_timestamp_ns != 0 &&
+		    local_timestamp_ns < t->fusion.last_imu_local_timestamp_ns) {
+			RIFT_S_WARN("IMU time went backward by %" PRId64 " ns",
+			            local_timestamp_ns - t->fusion.last_imu_local_timestamp_ns);
+		} else {
+			m_imu_3dof_update(&t->fusion.i3dof, local_timestamp_ns, accel, gyro);
+		}
 
-	t->pose.orientation = t->fusion.i3dof.rot;
+		RIFT_S_TRACE("IMU timestamp %" PRIu64 " (dt %f) hw2mono local ts %" PRIu64 " (dt %f) offset %" PRId64,
+		             device_timestamp_ns,
+		             (double)(device_timestamp_ns - t->fusion.last_imu_timestamp_ns) / 1000000000.0,
+		             local_timestamp_ns,
+		             (double)(local_timestamp_ns - t->fusion.last_imu_local_timestamp_ns) / 1000000000.0,
+		             t->hw2mono);
 
-	os_mutex_unlock(&t->mutex);
+		t->fusion.last_angular_velocity = *gyro;
+		t->fusion.last_imu_timestamp_ns = device_timestamp_ns;
+		t->fusion.last_imu_local_timestamp_ns = local_timestamp_ns;
 
-	if (t->slam_sinks.imu) {
-		/* Push IMU sample to the SLAM tracker */
 		struct xrt_vec3_f64 accel64 = {accel->x, accel->y, accel->z};
 		struct xrt_vec3_f64 gyro64 = {gyro->x, gyro->y, gyro->z};
-		struct xrt_imu_sample sample = {
+		samples[i] = (struct xrt_imu_sample){
 		    .timestamp_ns = local_timestamp_ns, .accel_m_s2 = accel64, .gyro_rad_secs = gyro64};
+	}
+
+	t->pose.orientation = t->fusion.i3dof.rot;
 
-		xrt_sink_push_imu(t->slam_sinks.imu, &sample);
+	os_mutex_unlock(&t->mutex);
+
+	if (t->slam_sinks.imu) {
+		/* Push the IMU samples of the report to the SLAM tracker in one go */
+		xrt_sink_push_imu_batch(t->slam_sinks.imu, samples, count);
 	}
 }
 
@@ -654,13 +667,13 @@ rift_s_tracker_get_tracked_pose(struct rift_s_tracker *t,
 		struct xrt_space_relation imu_relation = XRT_SPACE_RELATION_ZERO;
 
 		os_mutex_lock(&t->mutex);
-		// TODO: Estimate pose at timestamp at_timestamp_ns
-		math_quat_normalize(&t->pose.orientation);
-		imu_relation.pose = t->pose;
-		imu_relation.angular_velocity = t->fusion.last_angular_velocity;
+		// The fusion runs on local timestamps, predict from its newest sample.
+		int64_t prediction_ns = (int64_t)at_timestamp_ns - t->fusion.last_imu_local_timestamp_ns;
+		m_imu_3dof_predict(&t->fusion.i3dof, prediction_ns, &imu_relation);
+		imu_relation.pose.position = t->pose.position;
 		imu_relation.relation_flags = (enum xrt_space_relation_flags)(
 		    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
-		    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
+		    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
 
 		m_relation_chain_push_relation(&xrc, &imu_relation);
 
@@ -31,6 +31,9 @@
 
 struct rift_s_hmd_config;
 
+//! Most IMU samples carried by one HMD report.
+#define RIFT_S_TRACKER_MAX_IMU_SAMPLES 3
+
 enum rift_s_tracker_pose
 {
 	RIFT_S_TRACKER_POSE_IMU,
@@ -139,11 +142,16 @@ rift_s_tracker_get_hand_tracking_device(struct rift_s_tracker *t);
 void
 rift_s_tracker_clock_update(struct rift_s_tracker *t, uint64_t device_timestamp_ns, timepoint_ns local_timestamp_ns);
 
+/*!
+ * Feeds the up to @ref RIFT_S_TRACKER_MAX_IMU_SAMPLES IMU samples of one
+ * report, oldest first.
+ */
 void
 rift_s_tracker_imu_update(struct rift_s_tracker *t,
-                          uint64_t device_timestamp_ns,
-                          const struct xrt_vec3 *accel,
-                          const struct xrt_vec3 *gyro);
+                          const uint64_t *device_timestamps_ns,
+                          const struct xrt_vec3 *accels,
+                          const struct xrt_vec3 *gyros,
+                          uint32_t count);
 
 void
 rift_s_tracker_push_slam_frames(struct rift_s_tracker *t,
@@ -21,7 +21,7 @@
 #include "math/m_api.h"
 #include "math/m_imu_3dof.h"
 #include "math/m_mathinclude.h"
-#include "math/m_predict.h"
+#include "math/m_relation_history.h"
 
 #include "util/u_debug.h"
 #include "util/u_device.h"
@@ -29,9 +29,7 @@
 #include "util/u_trace_marker.h"
 #include "util/u_var.h"
 
-#ifdef XRT_OS_LINUX
-#include "util/u_linux.h"
-#endif
+#include "util/u_thread_role.h"
 
 
 
@@ -49,10 +47,14 @@
 #define ROKID_USB_BUFFER_LEN 0x40
 #define ROKID_USB_TRANSFER_TIMEOUT_MS 1000
 
+/*!
+ * Only touched by the USB thread, the fused poses are handed to readers
+ * through the lock-free @ref relation_hist.
+ */
 struct rokid_fusion
 {
-	struct os_mutex mutex;
 	struct m_imu_3dof i3dof;
+	struct m_relation_history *relation_hist;
 	struct xrt_space_relation last_relation;
 	uint64_t last_update;
 	struct xrt_vec3 last_gyro;
@@ -60,6 +62,17 @@ struct rokid_fusion
 	uint64_t gyro_ts_device;
 	uint64_t accel_ts_device;
 
+	//! Samples summed up to be fused together.
+	struct
+	{
+		struct xrt_vec3 accel;
+		struct xrt_vec3 gyro;
+		uint32_t count;
+
+		//! From ROKID_IMU_BATCH.
+		uint32_t size;
+	} batch;
+
 	bool initialized;
 };
 
@@ -142,6 +155,15 @@ struct rokid_usb_pkt_sensor
 
 DEBUG_GET_ONCE_LOG_OPTION(rokid_log, "ROKID_LOG", U_LOGGING_WARN)
 
+/*!
+ * How many IMU samples are averaged and fused as one, the glasses send them
+ * at 1kHz which is more than weak hosts want to run the fusion at.
+ */
+DEBUG_GET_ONCE_NUM_OPTION(rokid_imu_batch, "ROKID_IMU_BATCH", 1)
+
+//! Don't predict further than this past the latest fused sample.
+#define ROKID_MAX_PREDICTION_NS (100 * U_TIME_1MS_IN_NS)
+
 #define ROKID_TRACE(hmd, ...) U_LOG_XDEV_IFL_T(&hmd->base, hmd->log_level, __VA_ARGS__)
 #define ROKID_DEBUG(hmd, ...) U_LOG_XDEV_IFL_D(&hmd->base, hmd->log_level, __VA_ARGS__)
 #define ROKID_INFO(hmd, ...) U_LOG_XDEV_IFL_I(&hmd->base, hmd->log_level, __VA_ARGS__)
@@ -175,10 +197,14 @@ rokid_hmd(struct xrt_device *xdev)
 static void
 rokid_fusion_create(struct rokid_fusion *fusion)
 {
-	os_mutex_init(&fusion->mutex);
 	m_imu_3dof_init(&fusion->i3dof, M_IMU_3DOF_USE_GRAVITY_DUR_300MS);
+	m_relation_history_create(&fusion->relation_hist);
 	struct xrt_space_relation zero_relation = XRT_SPACE_RELATION_ZERO;
 	fusion->last_relation = zero_relation;
+
+	int64_t batch_size = debug_get_num_option_rokid_imu_batch();
+	fusion->batch.size = batch_size > 1 ? (uint32_t)batch_size : 1;
+
 	fusion->initialized = true;
 }
 
@@ -216,39 +242,66 @@ rokid_fusion_parse_usb_packet(struct rokid_fusion *fusion, unsigned char usb_buf
 	}
 
 	// Only update fusion once we have data from both sensors for this timestamp
-	if (fusion->gyro_ts_device == fusion->accel_ts_device) {
-		uint64_t now = os_monotonic_get_ns();
-		m_imu_3dof_update(&fusion->i3dof, now, &fusion->last_accel, &fusion->last_gyro);
-		struct xrt_vec3 angular_velocity_ws;
-		math_quat_rotate_vec3(&fusion->i3dof.rot, &fusion->last_gyro, &angular_velocity_ws);
-		fusion->last_relation.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
-		                                       XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT |
-		                                       XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT;
-		fusion->last_relation.pose.orientation = fusion->i3dof.rot;
-		fusion->last_relation.angular_velocity = angular_velocity_ws;
-		fusion->last_update = now;
+	if (fusion->gyro_ts_device != fusion->accel_ts_device) {
+		return;
 	}
+
+	math_vec3_accum(&fusion->last_accel, &fusion->batch.accel);
+	math_vec3_accum(&fusion->last_gyro, &fusion->batch.gyro);
+	if (++fusion->batch.count < fusion->batch.size) {
+		return;
+	}
+
+	/*
+	 * The fusion integrates the gyro over the time since the last update,
+	 * so the average of the batch gives it the same rotation.
+	 */
+	struct xrt_vec3 accel = fusion->batch.accel;
+	struct xrt_vec3 gyro = fusion->batch.gyro;
+	math_vec3_scalar_mul(1.0f / (float)fusion->batch.count, &accel);
+	math_vec3_scalar_mul(1.0f / (float)fusion->batch.count, &gyro);
+
+	U_ZERO(&fusion->batch.accel);
+	U_ZERO(&fusion->batch.gyro);
+	fusion->batch.count = 0;
+
+	uint64_t now = os_monotonic_get_ns();
+	m_imu_3dof_update(&fusion->i3dof, now, &accel, &gyro);
+	struct xrt_vec3 angular_velocity_ws;
+	math_quat_rotate_vec3(&fusion->i3dof.rot, &gyro, &angular_velocity_ws);
+	fusion->last_relation.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
+	                                       XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT |
+	                                       XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT;
+	fusion->last_relation.pose.orientation = fusion->i3dof.rot;
+	fusion->last_relation.angular_velocity = angular_velocity_ws;
+	fusion->last_update = now;
+
+	m_relation_history_push(fusion->relation_hist, &fusion->last_relation, now);
 }
 
 
 static void
 rokid_fusion_get_pose(struct rokid_fusion *fusion, uint64_t at_timestamp_ns, struct xrt_space_relation *out_relation)
 {
-	if (at_timestamp_ns > fusion->last_update) {
-		double time_diff = time_ns_to_s(at_timestamp_ns - fusion->last_update);
-		if (time_diff > 0.1) {
-			time_diff = 0.1;
-		}
-		m_predict_relation(&fusion->last_relation, time_diff, out_relation);
-	} else {
-		*out_relation = fusion->last_relation;
+	uint64_t latest_ns = 0;
+	struct xrt_space_relation latest;
+	if (!m_relation_history_get_latest(fusion->relation_hist, &latest_ns, &latest)) {
+		*out_relation = (struct xrt_space_relation)XRT_SPACE_RELATION_ZERO;
+		return;
+	}
+
+	// Past this point the prediction is worse than just staying put.
+	if (at_timestamp_ns > latest_ns + ROKID_MAX_PREDICTION_NS) {
+		at_timestamp_ns = latest_ns + ROKID_MAX_PREDICTION_NS;
 	}
+
+	m_relation_history_get(fusion->relation_hist, at_timestamp_ns, out_relation);
 }
 
 static void
 rokid_fusion_destroy(struct rokid_fusion *fusion)
 {
-	os_mutex_destroy(&fusion->mutex);
+	m_relation_history_destroy(&fusion->relation_hist);
 	m_imu_3dof_close(&fusion->i3dof);
 
 	fusion->initialized = false;
@@ -278,10 +331,8 @@ rokid_usb_thread(void *ptr)
 	U_TRACE_SET_THREAD_NAME("Rokid USB thread");
 	struct rokid_hmd *rokid = ptr;
 
-#ifdef XRT_OS_LINUX
 	// Try to raise priority of this thread, so we don't miss packets under load
-	u_linux_try_to_set_realtime_priority_on_thread(U_LOGGING_INFO, "Rokid USB thread");
-#endif
+	u_thread_role_apply_to_current_thread(U_THREAD_ROLE_REALTIME_IO, "Rokid USB thread");
 
 	int last_libusb_result = LIBUSB_SUCCESS;
 
@@ -296,9 +347,7 @@ rokid_usb_thread(void *ptr)
 		    libusb_interrupt_transfer(rokid->usb_dev, ROKID_INTERRUPT_IN_ENDPOINT, usb_buffer,
 		                              sizeof(usb_buffer), &read_length, ROKID_USB_TRANSFER_TIMEOUT_MS);
 		if (last_libusb_result == LIBUSB_SUCCESS) {
-			os_mutex_lock(&rokid->fusion.mutex);
 			rokid_fusion_parse_usb_packet(&rokid->fusion, usb_buffer);
-			os_mutex_unlock(&rokid->fusion.mutex);
 		}
 
 		os_thread_helper_lock(&rokid->usb_thread);
@@ -442,9 +491,7 @@ rokid_hmd_get_tracked_pose(struct xrt_device *xdev,
 		ROKID_ERROR(rokid, "unknown input name");
 		return;
 	}
-	os_mutex_lock(&rokid->fusion.mutex);
 	rokid_fusion_get_pose(&rokid->fusion, at_timestamp_ns, out_relation);
-	os_mutex_unlock(&rokid->fusion.mutex);
 }
 
 static struct xrt_device *
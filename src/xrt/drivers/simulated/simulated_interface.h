@@ -43,6 +43,37 @@ enum simulated_movement
 	SIMULATED_MOVEMENT_STATIONARY,
 };
 
+/*!
+ * Config for the load generating devices, used to scale test the runtime
+ * without hardware. Each device runs its own generator thread.
+ *
+ * @ingroup drv_simulated
+ */
+struct simulated_load_config
+{
+	//! Number of generic trackers to create.
+	uint32_t tracker_count;
+
+	//! Number of controllers to create.
+	uint32_t controller_count;
+
+	//! How often each device pushes a new pose, zero computes poses on demand.
+	uint32_t pose_rate_hz;
+
+	//! How often the input values of each device change, zero for never.
+	uint32_t input_rate_hz;
+
+	//! Do the controllers also provide hand tracking.
+	bool hand_tracking;
+
+	//! Frame rate of the camera stream of each device, zero for no stream.
+	uint32_t camera_fps;
+
+	//! Size of the camera frames.
+	uint32_t camera_width;
+	uint32_t camera_height;
+};
+
 /*!
  * Return the logging level that we want for the simulated related code.
  *
@@ -67,6 +98,27 @@ simulated_create_auto_prober(void);
 struct xrt_device *
 simulated_hmd_create(enum simulated_movement movement, const struct xrt_pose *center);
 
+/*!
+ * Fill out @p config with the defaults, no devices are created with them.
+ *
+ * @ingroup drv_simulated
+ */
+void
+simulated_load_config_defaults(struct simulated_load_config *config);
+
+/*!
+ * Create a load generating device, @p type is either
+ * XRT_DEVICE_TYPE_GENERIC_TRACKER or XRT_DEVICE_TYPE_ANY_HAND_CONTROLLER,
+ * @p index spreads the devices out and picks the hand for hand tracking.
+ *
+ * @ingroup drv_simulated
+ */
+struct xrt_device *
+simulated_load_create(const struct simulated_load_config *config,
+                      enum xrt_device_type type,
+                      uint32_t index,
+                      const struct xrt_pose *center);
+
 /*!
  * Create a simulated controller.
  *
@@ -0,0 +1,576 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Simulated load generating devices, used for scale testing.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup drv_simulated
+ */
+
+#include "xrt/xrt_device.h"
+#include "xrt/xrt_frame.h"
+
+#include "os/os_time.h"
+#include "os/os_threading.h"
+
+#include "math/m_api.h"
+#include "math/m_mathinclude.h"
+#include "math/m_relation_history.h"
+
+#include "util/u_var.h"
+#include "util/u_misc.h"
+#include "util/u_sink.h"
+#include "util/u_time.h"
+#include "util/u_frame.h"
+#include "util/u_device.h"
+#include "util/u_logging.h"
+#include "util/u_trace_marker.h"
+#include "util/u_hand_tracking.h"
+#include "util/u_hand_simulation.h"
+
+#include "simulated_interface.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+
+/*
+ *
+ * Structs and defines.
+ *
+ */
+
+//! Longest the generator thread sleeps, bounds how long stopping it takes.
+#define MAX_SLEEP_NS (10 * U_TIME_1MS_IN_NS)
+
+//! Radius of the circle the devices move along.
+#define MOVEMENT_RADIUS_M (0.25)
+
+//! Number of free frames kept around for the camera stream.
+#define FRAME_POOL_SIZE (4)
+
+/*!
+ * A device that generates a configurable amount of work for the rest of the
+ * runtime, poses, input changes, hand tracking and camera frames.
+ *
+ * @implements xrt_device
+ */
+struct simulated_load_device
+{
+	struct xrt_device base;
+
+	//! Copy of the config this device was created with.
+	struct simulated_load_config config;
+
+	//! Which of the load devices this is, offsets the movement.
+	uint32_t index;
+
+	//! Center of the movement.
+	struct xrt_pose center;
+
+	//! Index of the pose input.
+	uint32_t pose_input;
+
+	//! Index of the hand tracking input, only valid if hand tracking is on.
+	uint32_t hand_input;
+
+	//! Generated poses, thread safe.
+	struct m_relation_history *history;
+
+	//! Time the device was created, start of the movement.
+	uint64_t created_ns;
+
+	//! Runs the generators.
+	struct os_thread_helper oth;
+
+	//! Protects @ref churn.
+	struct os_mutex mutex;
+
+	//! Bumped at the input churn rate, all input values are derived from it.
+	uint64_t churn;
+
+	//! Last @ref churn written into the inputs, only touched in update_inputs.
+	uint64_t applied_churn;
+
+	//! Owns the frame graph of the camera stream.
+	struct xrt_frame_context xfctx;
+
+	//! Reuses camera frames.
+	struct u_frame_pool *pool;
+
+	//! Entry of the camera stream frame graph.
+	struct xrt_frame_sink *camera_sink;
+
+	//! End of the camera stream frame graph, counts and shows frames.
+	struct xrt_frame_sink counting_sink;
+
+	//! Lets the debug UI look at the camera stream.
+	struct u_sink_debug debug_sink;
+
+	struct
+	{
+		uint64_t poses;
+		uint64_t churns;
+		uint64_t frames_pushed;
+		uint64_t frames_received;
+		int64_t frame_latency_ns;
+	} stats;
+
+	enum u_logging_level log_level;
+};
+
+
+/*
+ *
+ * Helper functions.
+ *
+ */
+
+static inline struct simulated_load_device *
+simulated_load_device(struct xrt_device *xdev)
+{
+	return (struct simulated_load_device *)xdev;
+}
+
+static uint64_t
+rate_to_period_ns(uint32_t rate_hz)
+{
+	if (rate_hz == 0) {
+		return 0;
+	}
+
+	return U_TIME_1S_IN_NS / rate_hz;
+}
+
+static uint64_t
+next_deadline(uint64_t deadline_ns, uint64_t period_ns, uint64_t now_ns)
+{
+	deadline_ns += period_ns;
+
+	// Don't try to catch up if we have fallen behind, skip instead.
+	if (deadline_ns < now_ns) {
+		deadline_ns = now_ns + period_ns;
+	}
+
+	return deadline_ns;
+}
+
+static void
+compute_relation(struct simulated_load_device *sld, uint64_t timestamp_ns, struct xrt_space_relation *out_relation)
+{
+	// Spread the devices out along the circle and have them move at slightly different speeds.
+	const double phase = (double)sld->index * 0.5;
+	const double speed = 1.0 + (double)(sld->index % 4) * 0.25;
+	const double angle = time_ns_to_s(timestamp_ns - sld->created_ns) * speed + phase;
+	const double r = MOVEMENT_RADIUS_M;
+	const struct xrt_vec3 up = {0, 1, 0};
+
+	struct xrt_pose tmp = XRT_POSE_IDENTITY;
+	tmp.position.x = (float)(cos(angle) * r);
+	tmp.position.y = (float)(sin(angle * 2.0) * r * 0.25);
+	tmp.position.z = (float)(sin(angle) * r);
+	math_quat_from_angle_vector((float)angle, &up, &tmp.orientation);
+
+	struct xrt_vec3 linear_velocity = {
+	    (float)(-sin(angle) * r * speed),
+	    (float)(cos(angle * 2.0) * r * 0.5 * speed),
+	    (float)(cos(angle) * r * speed),
+	};
+	struct xrt_vec3 angular_velocity = {0, (float)speed, 0};
+
+	math_pose_transform(&sld->center, &tmp, &out_relation->pose);
+	math_quat_rotate_vec3(&sld->center.orientation, &linear_velocity, &out_relation->linear_velocity);
+	math_quat_rotate_vec3(&sld->center.orientation, &angular_velocity, &out_relation->angular_velocity);
+
+	out_relation->relation_flags = (enum xrt_space_relation_flags)(
+	    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT |
+	    XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT);
+}
+
+static void
+push_pose(struct simulated_load_device *sld, uint64_t now_ns)
+{
+	struct xrt_space_relation relation = XRT_SPACE_RELATION_ZERO;
+	compute_relation(sld, now_ns, &relation);
+
+	m_relation_history_push(sld->history, &relation, now_ns);
+	sld->stats.poses++;
+}
+
+static void
+push_churn(struct simulated_load_device *sld)
+{
+	os_mutex_lock(&sld->mutex);
+	sld->churn++;
+	os_mutex_unlock(&sld->mutex);
+
+	sld->stats.churns++;
+}
+
+static void
+push_frame(struct simulated_load_device *sld, uint64_t now_ns)
+{
+	SINK_TRACE_MARKER();
+
+	const uint32_t w = sld->config.camera_width;
+	const uint32_t h = sld->config.camera_height;
+
+	struct xrt_frame *xf = NULL;
+	u_frame_pool_create_frame(sld->pool, XRT_FORMAT_L8, w, h, &xf);
+	if (xf == NULL) {
+		return;
+	}
+
+	// A moving gradient, cheap to generate but changes every frame.
+	const uint8_t offset = (uint8_t)sld->stats.frames_pushed;
+	for (uint32_t y = 0; y < h; y++) {
+		memset(xf->data + y * xf->stride, (uint8_t)(y + offset), w);
+	}
+
+	xf->timestamp = now_ns;
+	xf->source_timestamp = now_ns;
+	xf->source_sequence = sld->stats.frames_pushed++;
+	xf->source_id = (int)sld->index;
+
+	xrt_sink_push_frame(sld->camera_sink, xf);
+	xrt_frame_reference(&xf, NULL);
+}
+
+static void *
+simulated_load_run(void *ptr)
+{
+	struct simulated_load_device *sld = (struct simulated_load_device *)ptr;
+
+	os_thread_helper_name(&sld->oth, "Simulated Load");
+
+	const uint64_t pose_period_ns = rate_to_period_ns(sld->config.pose_rate_hz);
+	const uint64_t input_period_ns = rate_to_period_ns(sld->config.input_rate_hz);
+	const uint64_t frame_period_ns = sld->camera_sink != NULL ? rate_to_period_ns(sld->config.camera_fps) : 0;
+
+	uint64_t now_ns = os_monotonic_get_ns();
+	uint64_t pose_ns = now_ns;
+	uint64_t input_ns = now_ns;
+	uint64_t frame_ns = now_ns;
+
+	os_thread_helper_lock(&sld->oth);
+	while (os_thread_helper_is_running_locked(&sld->oth)) {
+		os_thread_helper_unlock(&sld->oth);
+
+		now_ns = os_monotonic_get_ns();
+		uint64_t wake_ns = now_ns + MAX_SLEEP_NS;
+
+		if (pose_period_ns > 0) {
+			if (now_ns >= pose_ns) {
+				push_pose(sld, now_ns);
+				pose_ns = next_deadline(pose_ns, pose_period_ns, now_ns);
+			}
+			wake_ns = pose_ns < wake_ns ? pose_ns : wake_ns;
+		}
+
+		if (input_period_ns > 0) {
+			if (now_ns >= input_ns) {
+				push_churn(sld);
+				input_ns = next_deadline(input_ns, input_period_ns, now_ns);
+			}
+			wake_ns = input_ns < wake_ns ? input_ns : wake_ns;
+		}
+
+		if (frame_period_ns > 0) {
+			if (now_ns >= frame_ns) {
+				push_frame(sld, now_ns);
+				frame_ns = next_deadline(frame_ns, frame_period_ns, now_ns);
+			}
+			wake_ns = frame_ns < wake_ns ? frame_ns : wake_ns;
+		}
+
+		now_ns = os_monotonic_get_ns();
+		if (wake_ns > now_ns) {
+			os_nanosleep((int64_t)(wake_ns - now_ns));
+		}
+
+		os_thread_helper_lock(&sld->oth);
+	}
+	os_thread_helper_unlock(&sld->oth);
+
+	return NULL;
+}
+
+static void
+set_input_value(struct xrt_input *input, uint32_t bit, uint64_t churn)
+{
+	const float t = (float)((churn + bit) % 16) / 15.0f;
+
+	switch (XRT_GET_INPUT_TYPE(input->name)) {
+	case XRT_INPUT_TYPE_BOOLEAN: input->value.boolean = ((churn >> (bit % 8)) & 1) != 0; break;
+	case XRT_INPUT_TYPE_VEC1_ZERO_TO_ONE: input->value.vec1.x = t; break;
+	case XRT_INPUT_TYPE_VEC1_MINUS_ONE_TO_ONE: input->value.vec1.x = t * 2.0f - 1.0f; break;
+	case XRT_INPUT_TYPE_VEC2_MINUS_ONE_TO_ONE:
+		input->value.vec2.x = t * 2.0f - 1.0f;
+		input->value.vec2.y = 1.0f - t * 2.0f;
+		break;
+	default: break;
+	}
+}
+
+
+/*
+ *
+ * Frame sink functions.
+ *
+ */
+
+static void
+counting_sink_push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	struct simulated_load_device *sld = container_of(xfs, struct simulated_load_device, counting_sink);
+
+	sld->stats.frames_received++;
+	sld->stats.frame_latency_ns = (int64_t)(os_monotonic_get_ns() - xf->timestamp);
+
+	u_sink_debug_push_frame(&sld->debug_sink, xf);
+}
+
+
+/*
+ *
+ * Member functions.
+ *
+ */
+
+static void
+simulated_load_destroy(struct xrt_device *xdev)
+{
+	struct simulated_load_device *sld = simulated_load_device(xdev);
+
+	// Stop generating work before tearing the rest down.
+	os_thread_helper_destroy(&sld->oth);
+
+	// Remove the variable tracking.
+	u_var_remove_root(sld);
+
+	// Stops the queue thread, nothing is pushed into the counting sink after this.
+	xrt_frame_context_destroy_nodes(&sld->xfctx);
+	u_frame_pool_destroy(&sld->pool);
+	u_sink_debug_destroy(&sld->debug_sink);
+
+	m_relation_history_destroy(&sld->history);
+	os_mutex_destroy(&sld->mutex);
+
+	u_device_free(&sld->base);
+}
+
+static void
+simulated_load_update_inputs(struct xrt_device *xdev)
+{
+	struct simulated_load_device *sld = simulated_load_device(xdev);
+
+	os_mutex_lock(&sld->mutex);
+	uint64_t churn = sld->churn;
+	os_mutex_unlock(&sld->mutex);
+
+	// Values and timestamps only change when the generator has churned.
+	if (churn == sld->applied_churn) {
+		return;
+	}
+	sld->applied_churn = churn;
+
+	uint64_t now = os_monotonic_get_ns();
+
+	for (uint32_t i = 0; i < xdev->input_count; i++) {
+		set_input_value(&xdev->inputs[i], i, churn);
+		xdev->inputs[i].timestamp = now;
+	}
+}
+
+static void
+simulated_load_get_tracked_pose(struct xrt_device *xdev,
+                                enum xrt_input_name name,
+                                uint64_t at_timestamp_ns,
+                                struct xrt_space_relation *out_relation)
+{
+	struct simulated_load_device *sld = simulated_load_device(xdev);
+
+	if (name != xdev->inputs[sld->pose_input].name) {
+		U_LOG_E("Unknown input name: 0x%0x", name);
+		return;
+	}
+
+	// Without a generator thread poses are computed on demand.
+	if (sld->config.pose_rate_hz == 0) {
+		compute_relation(sld, at_timestamp_ns, out_relation);
+		return;
+	}
+
+	m_relation_history_get(sld->history, at_timestamp_ns, out_relation);
+}
+
+static void
+simulated_load_get_hand_tracking(struct xrt_device *xdev,
+                                 enum xrt_input_name name,
+                                 uint64_t requested_timestamp_ns,
+                                 struct xrt_hand_joint_set *out_value,
+                                 uint64_t *out_timestamp_ns)
+{
+	struct simulated_load_device *sld = simulated_load_device(xdev);
+
+	if (!sld->config.hand_tracking || name != xdev->inputs[sld->hand_input].name) {
+		U_LOG_E("Unknown input name: 0x%0x", name);
+		return;
+	}
+
+	enum xrt_hand hand = name == XRT_INPUT_GENERIC_HAND_TRACKING_LEFT ? XRT_HAND_LEFT : XRT_HAND_RIGHT;
+
+	struct xrt_space_relation root = XRT_SPACE_RELATION_ZERO;
+	simulated_load_get_tracked_pose(xdev, xdev->inputs[sld->pose_input].name, requested_timestamp_ns, &root);
+
+	// Open and close the hand about once a second.
+	const double time_s = time_ns_to_s(requested_timestamp_ns - sld->created_ns);
+	const float curl = (float)(0.5 + 0.5 * sin(time_s * M_PI * 2.0 + (double)sld->index));
+
+	struct u_hand_tracking_values values = {
+	    .little = {.joint_count = 5},
+	    .ring = {.joint_count = 5},
+	    .middle = {.joint_count = 5},
+	    .index = {.joint_count = 5},
+	    .thumb = {.joint_count = 4},
+	};
+	for (int i = 0; i < 4; i++) {
+		values.little.joint_curls[i] = curl;
+		values.ring.joint_curls[i] = curl;
+		values.middle.joint_curls[i] = curl;
+		values.index.joint_curls[i] = curl;
+		values.thumb.joint_curls[i] = curl * 0.5f;
+	}
+
+	u_hand_sim_simulate_generic(&values, hand, &root, out_value);
+
+	out_value->is_active = true;
+	*out_timestamp_ns = requested_timestamp_ns;
+}
+
+
+/*
+ *
+ * Various data driven arrays.
+ *
+ */
+
+static enum xrt_input_name tracker_inputs_array[] = {
+    XRT_INPUT_GENERIC_TRACKER_POSE,
+};
+
+static enum xrt_input_name controller_inputs_array[] = {
+    XRT_INPUT_SIMPLE_SELECT_CLICK,
+    XRT_INPUT_SIMPLE_MENU_CLICK,
+    XRT_INPUT_SIMPLE_GRIP_POSE,
+    XRT_INPUT_SIMPLE_AIM_POSE,
+};
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+void
+simulated_load_config_defaults(struct simulated_load_config *config)
+{
+	U_ZERO(config);
+	config->pose_rate_hz = 1000;
+	config->input_rate_hz = 10;
+	config->camera_width = 640;
+	config->camera_height = 480;
+}
+
+struct xrt_device *
+simulated_load_create(const struct simulated_load_config *config,
+                      enum xrt_device_type type,
+                      uint32_t index,
+                      const struct xrt_pose *center)
+{
+	const enum u_device_alloc_flags flags = U_DEVICE_ALLOC_TRACKING_NONE;
+	const bool is_tracker = type == XRT_DEVICE_TYPE_GENERIC_TRACKER;
+	const bool hand_tracking = !is_tracker && config->hand_tracking;
+
+	enum xrt_input_name *inputs = is_tracker ? tracker_inputs_array : controller_inputs_array;
+	uint32_t input_count = is_tracker ? ARRAY_SIZE(tracker_inputs_array) : ARRAY_SIZE(controller_inputs_array);
+	uint32_t hand_input = input_count;
+	if (hand_tracking) {
+		input_count++;
+	}
+
+	struct simulated_load_device *sld =
+	    U_DEVICE_ALLOCATE(struct simulated_load_device, flags, input_count, 0);
+	sld->base.update_inputs = simulated_load_update_inputs;
+	sld->base.get_tracked_pose = simulated_load_get_tracked_pose;
+	sld->base.get_hand_tracking = simulated_load_get_hand_tracking;
+	sld->base.get_view_poses = u_device_ni_get_view_poses;
+	sld->base.destroy = simulated_load_destroy;
+	sld->base.name = is_tracker ? XRT_DEVICE_VIVE_TRACKER : XRT_DEVICE_SIMPLE_CONTROLLER;
+	sld->base.device_type = type;
+	sld->base.orientation_tracking_supported = true;
+	sld->base.position_tracking_supported = true;
+	sld->base.hand_tracking_supported = hand_tracking;
+	sld->base.tracking_origin->type = XRT_TRACKING_TYPE_OTHER;
+	sld->base.tracking_origin->offset = (struct xrt_pose)XRT_POSE_IDENTITY;
+
+	const char *kind = is_tracker ? "Tracker" : "Controller";
+	snprintf(sld->base.str, sizeof(sld->base.str), "Load %s %u (Simulated)", kind, index);
+	snprintf(sld->base.serial, sizeof(sld->base.serial), "Load %s %u (Simulated)", kind, index);
+
+	for (uint32_t i = 0; i < hand_input; i++) {
+		sld->base.inputs[i].active = true;
+		sld->base.inputs[i].name = inputs[i];
+	}
+
+	// Alternate the hands so both hand tracking inputs see traffic.
+	if (hand_tracking) {
+		sld->base.inputs[hand_input].active = true;
+		sld->base.inputs[hand_input].name =
+		    index % 2 == 0 ? XRT_INPUT_GENERIC_HAND_TRACKING_LEFT : XRT_INPUT_GENERIC_HAND_TRACKING_RIGHT;
+	}
+
+	sld->pose_input = is_tracker ? 0 : 2; // XRT_INPUT_SIMPLE_GRIP_POSE
+	sld->hand_input = hand_input;
+
+	sld->config = *config;
+	sld->index = index;
+	sld->center = *center;
+	sld->created_ns = os_monotonic_get_ns();
+	sld->log_level = simulated_log_level();
+
+	m_relation_history_create(&sld->history);
+	os_mutex_init(&sld->mutex);
+	os_thread_helper_init(&sld->oth);
+	u_sink_debug_init(&sld->debug_sink);
+
+	// Camera stream, goes through a queue like the frames of a real camera.
+	if (config->camera_fps > 0 && config->camera_width > 0 && config->camera_height > 0) {
+		sld->pool = u_frame_pool_create(FRAME_POOL_SIZE);
+		sld->counting_sink.push_frame = counting_sink_push_frame;
+		u_sink_simple_queue_create(&sld->xfctx, &sld->counting_sink, &sld->camera_sink);
+	}
+
+	// Setup variable tracker.
+	u_var_add_root(sld, sld->base.str, true);
+	u_var_add_pose(sld, &sld->center, "center");
+	u_var_add_ro_u64(sld, &sld->stats.poses, "Poses pushed");
+	u_var_add_ro_u64(sld, &sld->stats.churns, "Input changes");
+	u_var_add_ro_u64(sld, &sld->stats.frames_pushed, "Frames pushed");
+	u_var_add_ro_u64(sld, &sld->stats.frames_received, "Frames received");
+	u_var_add_ro_i64(sld, &sld->stats.frame_latency_ns, "Frame latency (ns)");
+	u_var_add_sink_debug(sld, &sld->debug_sink, "Camera");
+	u_var_add_log_level(sld, &sld->log_level, "Log level");
+
+	int ret = os_thread_helper_start(&sld->oth, simulated_load_run, sld);
+	if (ret != 0) {
+		U_LOG_E("Failed to start load generator thread!");
+		simulated_load_destroy(&sld->base);
+		return NULL;
+	}
+
+	return &sld->base;
+}
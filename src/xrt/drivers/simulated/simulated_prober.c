@@ -19,6 +19,14 @@
 
 
 DEBUG_GET_ONCE_BOOL_OPTION(simulated_rotate, "SIMULATED_ROTATE", false)
+DEBUG_GET_ONCE_NUM_OPTION(load_trackers, "SIMULATED_LOAD_TRACKERS", 0)
+DEBUG_GET_ONCE_NUM_OPTION(load_controllers, "SIMULATED_LOAD_CONTROLLERS", 0)
+DEBUG_GET_ONCE_NUM_OPTION(load_pose_hz, "SIMULATED_LOAD_POSE_HZ", 1000)
+DEBUG_GET_ONCE_NUM_OPTION(load_input_hz, "SIMULATED_LOAD_INPUT_HZ", 10)
+DEBUG_GET_ONCE_BOOL_OPTION(load_hand_tracking, "SIMULATED_LOAD_HAND_TRACKING", false)
+DEBUG_GET_ONCE_NUM_OPTION(load_camera_fps, "SIMULATED_LOAD_CAMERA_FPS", 0)
+DEBUG_GET_ONCE_NUM_OPTION(load_camera_width, "SIMULATED_LOAD_CAMERA_WIDTH", 640)
+DEBUG_GET_ONCE_NUM_OPTION(load_camera_height, "SIMULATED_LOAD_CAMERA_HEIGHT", 480)
 
 /*!
  * @implements xrt_auto_prober
@@ -44,6 +52,59 @@ simulated_prober_destroy(struct xrt_auto_prober *p)
 	free(dp);
 }
 
+static uint32_t
+get_u32_option(int64_t value)
+{
+	return value < 0 ? 0 : (uint32_t)value;
+}
+
+static void
+get_load_config(struct simulated_load_config *config)
+{
+	simulated_load_config_defaults(config);
+
+	config->tracker_count = get_u32_option(debug_get_num_option_load_trackers());
+	config->controller_count = get_u32_option(debug_get_num_option_load_controllers());
+	config->pose_rate_hz = get_u32_option(debug_get_num_option_load_pose_hz());
+	config->input_rate_hz = get_u32_option(debug_get_num_option_load_input_hz());
+	config->hand_tracking = debug_get_bool_option_load_hand_tracking();
+	config->camera_fps = get_u32_option(debug_get_num_option_load_camera_fps());
+	config->camera_width = get_u32_option(debug_get_num_option_load_camera_width());
+	config->camera_height = get_u32_option(debug_get_num_option_load_camera_height());
+}
+
+static int
+create_load_devices(const struct simulated_load_config *config, int offset, struct xrt_device **out_xdevs)
+{
+	int count = offset;
+
+	for (uint32_t i = 0; i < config->tracker_count + config->controller_count; i++) {
+		if (count >= XRT_MAX_DEVICES_PER_PROBE) {
+			U_LOG_W("Can only create %d load devices!", XRT_MAX_DEVICES_PER_PROBE - offset);
+			break;
+		}
+
+		bool is_tracker = i < config->tracker_count;
+		enum xrt_device_type type =
+		    is_tracker ? XRT_DEVICE_TYPE_GENERIC_TRACKER : XRT_DEVICE_TYPE_ANY_HAND_CONTROLLER;
+
+		// Place them in a grid in front of the user.
+		struct xrt_pose center = XRT_POSE_IDENTITY;
+		center.position.x = (float)(i % 4) * 0.5f - 0.75f;
+		center.position.y = 1.0f + (float)(i / 16) * 0.5f;
+		center.position.z = -1.0f - (float)((i / 4) % 4) * 0.5f;
+
+		struct xrt_device *xdev = simulated_load_create(config, type, i, &center);
+		if (xdev == NULL) {
+			break;
+		}
+
+		out_xdevs[count++] = xdev;
+	}
+
+	return count - offset;
+}
+
 //! @public @memberof simulated_prober
 static int
 simulated_prober_autoprobe(struct xrt_auto_prober *xap,
@@ -55,9 +116,12 @@ simulated_prober_autoprobe(struct xrt_auto_prober *xap,
 	struct simulated_prober *dp = simulated_prober(xap);
 	(void)dp;
 
-	// Do not create a simulated HMD if we are not looking for HMDs.
+	struct simulated_load_config config;
+	get_load_config(&config);
+
+	// Do not create a simulated HMD if we are not looking for HMDs, load devices are still created.
 	if (no_hmds) {
-		return 0;
+		return create_load_devices(&config, 0, out_xdevs);
 	}
 
 	// Select the type of movement.
@@ -68,8 +132,11 @@ simulated_prober_autoprobe(struct xrt_auto_prober *xap,
 
 	const struct xrt_pose center = XRT_POSE_IDENTITY;
 	out_xdevs[0] = simulated_hmd_create(movement, &center);
+	if (out_xdevs[0] == NULL) {
+		return 0;
+	}
 
-	return 1;
+	return 1 + create_load_devices(&config, 1, out_xdevs);
 }
 
 struct xrt_auto_prober *
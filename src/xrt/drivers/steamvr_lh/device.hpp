@@ -40,6 +40,12 @@ class Device : public xrt_device
 {
 
 public:
+	/*!
+	 * Poses from the driver threads, the only state shared between
+	 * @ref update_pose and @ref get_tracked_pose. The history never blocks
+	 * readers, so don't take @ref frame_mutex or any of the other device
+	 * locks on either path.
+	 */
 	m_relation_history *relation_hist;
 
 	virtual ~Device();
@@ -50,6 +56,7 @@ public:
 	void
 	update_inputs();
 
+	//! Called from SteamVR driver threads through @ref Context::TrackedDevicePoseUpdated.
 	void
 	update_pose(const vr::DriverPose_t &newPose) const;
 
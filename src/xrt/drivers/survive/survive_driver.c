@@ -44,6 +44,7 @@
 #include "util/u_hand_tracking.h"
 #include "util/u_hand_simulation.h"
 #include "util/u_logging.h"
+#include "util/u_rolling_stats.h"
 #include "math/m_relation_history.h"
 
 #include "math/m_predict.h"
@@ -65,6 +66,12 @@
 //! excl HMD we support 16 devices (controllers, trackers, ...)
 #define MAX_TRACKED_DEVICE_COUNT 16
 
+//! Most events handled in one go by the event thread, so it gets to push the poses now and then.
+#define SURVIVE_EVENT_BATCH_MAX 64
+
+//! Most poses a device holds on to before they are pushed to its history.
+#define SURVIVE_POSE_BATCH_MAX 16
+
 DEBUG_GET_ONCE_BOOL_OPTION(survive_disable_hand_emulation, "SURVIVE_DISABLE_HAND_EMULATION", false)
 DEBUG_GET_ONCE_BOOL_OPTION(survive_default_ipd, "SURVIVE_DEFAULT_IPD", false)
 DEBUG_GET_ONCE_FLOAT_OPTION(survive_timecode_offset_ms, "SURVIVE_TIMECODE_OFFSET_MS", 0.0)
@@ -131,6 +138,17 @@ struct survive_device
 
 	struct m_relation_history *relation_hist;
 
+	/*!
+	 * Poses from the current batch of events, pushed to @ref relation_hist
+	 * in one go at the end of it. Only touched by the event thread.
+	 */
+	struct
+	{
+		struct xrt_space_relation relations[SURVIVE_POSE_BATCH_MAX];
+		uint64_t timestamps[SURVIVE_POSE_BATCH_MAX];
+		uint32_t count;
+	} pending_poses;
+
 	//! Number of inputs.
 	size_t num_last_inputs;
 	//! Array of input structs.
@@ -175,6 +193,19 @@ struct survive_system
 
 	struct os_thread_helper event_thread;
 	struct os_mutex lock;
+
+	//! Time from libsurvive's pose timestamp until it is in the history, written by the event thread.
+	struct
+	{
+		struct u_rolling_stats_ns stats;
+		uint32_t samples_since_update;
+
+		uint64_t median_ns;
+		uint64_t p99_ns;
+
+		//! Events handled in the last batch.
+		uint32_t batch_events;
+	} latency;
 };
 
 static void
@@ -366,6 +397,37 @@ survive_device_get_tracked_pose(struct xrt_device *xdev,
 	              p->position.z, p->orientation.x, p->orientation.y, p->orientation.z, p->orientation.w);
 }
 
+static void
+survive_device_get_tracked_poses(struct xrt_device *xdev,
+                                 enum xrt_input_name name,
+                                 const uint64_t *at_timestamps_ns,
+                                 uint32_t count,
+                                 struct xrt_space_relation *out_relations)
+{
+	struct survive_device *survive = (struct survive_device *)xdev;
+
+	// Only the poses from the history are worth doing together.
+	if (!verify_device_name(survive, name) || name == XRT_INPUT_GENERIC_STAGE_SPACE_POSE || !survive->survive_obj) {
+		for (uint32_t i = 0; i < count; i++) {
+			survive_device_get_tracked_pose(xdev, name, at_timestamps_ns[i], &out_relations[i]);
+		}
+		return;
+	}
+
+	struct xrt_pose pose_offset = XRT_POSE_IDENTITY;
+	vive_poses_get_pose_offset(survive->base.name, survive->base.device_type, name, &pose_offset);
+
+	// Searches the history once for all of them.
+	m_relation_history_get_many(survive->relation_hist, at_timestamps_ns, count, out_relations, NULL);
+
+	for (uint32_t i = 0; i < count; i++) {
+		struct xrt_relation_chain relation_chain = {0};
+		m_relation_chain_push_pose(&relation_chain, &pose_offset);
+		m_relation_chain_push_relation(&relation_chain, &out_relations[i]);
+		m_relation_chain_resolve(&relation_chain, &out_relations[i]);
+	}
+}
+
 static int
 survive_controller_haptic_pulse(struct survive_device *survive, const union xrt_output_value *value)
 {
@@ -802,14 +864,60 @@ get_device_by_object(struct survive_system *sys, const SurviveSimpleObject *obje
 static void
 add_device(struct survive_system *ss, const struct SurviveSimpleConfigEvent *e);
 
+static void
+_push_pending_poses(struct survive_device *survive)
+{
+	uint32_t count = survive->pending_poses.count;
+	if (count == 0) {
+		return;
+	}
+
+	m_relation_history_push_many(survive->relation_hist, survive->pending_poses.relations,
+	                             survive->pending_poses.timestamps, count);
+	survive->pending_poses.count = 0;
+
+	// They can now be gotten with get_tracked_pose.
+	struct survive_system *ss = survive->sys;
+	timepoint_ns now = os_monotonic_get_ns();
+	for (uint32_t i = 0; i < count; i++) {
+		uint64_t ts = survive->pending_poses.timestamps[i];
+		u_rs_ns_add(&ss->latency.stats, now > (timepoint_ns)ts ? now - ts : 0);
+	}
+
+	// Sorting the window for every pose is a waste, the UI can be a bit behind.
+	ss->latency.samples_since_update += count;
+	if (ss->latency.samples_since_update >= U_ROLLING_STATS_VALUE_COUNT / 2) {
+		ss->latency.samples_since_update = 0;
+		ss->latency.median_ns = u_rs_ns_get_percentile(&ss->latency.stats, 50.0f);
+		ss->latency.p99_ns = u_rs_ns_get_percentile(&ss->latency.stats, 99.0f);
+	}
+}
+
+//! Push the poses of all devices from this batch of events to their histories.
+static void
+_push_all_pending_poses(struct survive_system *ss)
+{
+	if (ss->hmd != NULL) {
+		_push_pending_poses(ss->hmd);
+	}
+
+	for (int i = 0; i < MAX_TRACKED_DEVICE_COUNT; i++) {
+		if (ss->controllers[i] != NULL) {
+			_push_pending_poses(ss->controllers[i]);
+		}
+	}
+}
+
 static void
 _process_pose_event(struct survive_device *survive, const struct SurviveSimplePoseUpdatedEvent *e)
 {
-	struct xrt_space_relation rel;
-	timepoint_ns ts;
-	pose_to_relation(&e->pose, &e->velocity, &rel);
-	ts = survive_timecode_to_monotonic(survive, e->time);
-	m_relation_history_push(survive->relation_hist, &rel, ts);
+	if (survive->pending_poses.count >= SURVIVE_POSE_BATCH_MAX) {
+		_push_pending_poses(survive);
+	}
+
+	uint32_t index = survive->pending_poses.count++;
+	pose_to_relation(&e->pose, &e->velocity, &survive->pending_poses.relations[index]);
+	survive->pending_poses.timestamps[index] = survive_timecode_to_monotonic(survive, e->time);
 
 	SURVIVE_TRACE(survive, "Process pose event for %s", survive->base.str);
 }
@@ -918,6 +1026,7 @@ _create_hmd_device(struct survive_system *sys, const struct SurviveSimpleObject
 	survive->base.destroy = survive_device_destroy;
 	survive->base.update_inputs = survive_device_update_inputs;
 	survive->base.get_tracked_pose = survive_device_get_tracked_pose;
+	survive->base.get_tracked_poses = survive_device_get_tracked_poses;
 	survive->base.get_view_poses = survive_device_get_view_poses;
 	survive->base.tracking_origin = &sys->base;
 
@@ -1082,6 +1191,7 @@ _create_controller_device(struct survive_system *sys,
 	survive->base.destroy = survive_device_destroy;
 	survive->base.update_inputs = survive_device_update_inputs;
 	survive->base.get_tracked_pose = survive_device_get_tracked_pose;
+	survive->base.get_tracked_poses = survive_device_get_tracked_poses;
 	survive->base.set_output = survive_controller_device_set_output;
 	snprintf(survive->base.serial, XRT_DEVICE_NAME_LEN, "%s", survive->ctrl.config.firmware.device_serial_number);
 
@@ -1303,10 +1413,20 @@ run_event_thread(void *ptr)
 		struct SurviveSimpleEvent event = {0};
 		survive_simple_wait_for_event(ss->ctx, &event);
 
+		// Handle what else is already queued up along with it, so the lock is taken once per batch.
+		uint32_t event_count = 0;
 		os_mutex_lock(&ss->lock);
-		_process_event(ss, &event);
+		do {
+			_process_event(ss, &event);
+			event_count++;
+		} while (event_count < SURVIVE_EVENT_BATCH_MAX &&
+		         survive_simple_next_event(ss->ctx, &event) != SurviveSimpleEventType_None);
 		os_mutex_unlock(&ss->lock);
 
+		// The histories have their own locking, readers don't wait on the lock above.
+		_push_all_pending_poses(ss);
+		ss->latency.batch_events = event_count;
+
 		// Just keep swimming.
 		os_thread_helper_lock(&ss->event_thread);
 	}
@@ -1415,6 +1535,9 @@ survive_get_devices(struct xrt_device **out_xdevs, struct vive_config **out_vive
 
 	u_var_add_root(ss, "Survive system", true);
 	u_var_add_draggable_f32(ss, &ss->timecode_offset_ms, "Timecode offset(ms)");
+	u_var_add_ro_u64(ss, &ss->latency.median_ns, "Pose latency median(ns)");
+	u_var_add_ro_u64(ss, &ss->latency.p99_ns, "Pose latency 99th percentile(ns)");
+	u_var_add_ro_u32(ss, &ss->latency.batch_events, "Events in last batch");
 
 	return out_idx;
 }
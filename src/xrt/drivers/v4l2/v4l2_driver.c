@@ -58,6 +58,7 @@
 
 DEBUG_GET_ONCE_LOG_OPTION(v4l2_log, "V4L2_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_NUM_OPTION(v4l2_exposure_absolute, "V4L2_EXPOSURE_ABSOLUTE", 10)
+DEBUG_GET_ONCE_BOOL_OPTION(v4l2_export_dmabuf, "V4L2_EXPORT_DMABUF", false)
 
 /*!
  * Streaming thread entrypoint
@@ -300,6 +301,42 @@ v4l2_setup_mmap_buffer(struct v4l2_fs *vid, struct v4l2_frame *vf, struct v4l2_b
 	return 0;
 }
 
+static int
+v4l2_export_dmabuf(struct v4l2_fs *vid, struct v4l2_frame *vf)
+{
+	struct v4l2_exportbuffer expbuf;
+	U_ZERO(&expbuf);
+	expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	expbuf.index = vf->v_buf.index;
+	expbuf.flags = O_RDONLY | O_CLOEXEC;
+
+	if (ioctl(vid->fd, VIDIOC_EXPBUF, &expbuf) < 0) {
+		V4L2_WARN(vid, "Could not export buffer %u as a dma-buf.", vf->v_buf.index);
+		return -1;
+	}
+
+	vf->dmabuf_fd = expbuf.fd;
+
+	return 0;
+}
+
+static void
+v4l2_close_dmabufs(struct v4l2_fs *vid)
+{
+	if (!vid->capture.dmabuf) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < NUM_V4L2_BUFFERS; i++) {
+		if (vid->frames[i].dmabuf_fd >= 0) {
+			close(vid->frames[i].dmabuf_fd);
+		}
+		vid->frames[i].dmabuf_fd = -1;
+	}
+
+	vid->capture.dmabuf = false;
+}
+
 static int
 v4l2_setup_userptr_buffer(struct v4l2_fs *vid, struct v4l2_frame *vf, struct v4l2_buffer *v_buf)
 {
@@ -634,6 +671,8 @@ v4l2_fs_destroy(struct v4l2_fs *vid)
 		vid->num_descriptors = 0;
 	}
 
+	v4l2_close_dmabufs(vid);
+
 	vid->capture.mmap = false;
 	if (vid->capture.userptr) {
 		vid->capture.userptr = false;
@@ -746,11 +785,24 @@ v4l2_fs_mainloop(void *ptr)
 	v_bufrequest.count = NUM_V4L2_BUFFERS;
 	v_bufrequest.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
-	if (v4l2_try_userptr(vid, &v_bufrequest) != 0 && v4l2_try_mmap(vid, &v_bufrequest) != 0) {
+	// Only kernel allocated buffers can be exported, so try mmap first.
+	bool export_dmabuf = debug_get_bool_option_v4l2_export_dmabuf();
+	int ret = export_dmabuf ? v4l2_try_mmap(vid, &v_bufrequest) : -1;
+
+	if (ret != 0 && v4l2_try_userptr(vid, &v_bufrequest) != 0 && v4l2_try_mmap(vid, &v_bufrequest) != 0) {
 		V4L2_ERROR(vid, "error: Driver does not support mmap or userptr.");
 		return NULL;
 	}
 
+	// From a previous stream.
+	v4l2_close_dmabufs(vid);
+	if (export_dmabuf && vid->capture.mmap) {
+		for (uint32_t i = 0; i < NUM_V4L2_BUFFERS; i++) {
+			vid->frames[i].dmabuf_fd = -1;
+		}
+		vid->capture.dmabuf = true;
+	}
+
 
 	for (uint32_t i = 0; i < NUM_V4L2_BUFFERS; i++) {
 		struct v4l2_frame *vf = &vid->frames[i];
@@ -775,6 +827,11 @@ v4l2_fs_mainloop(void *ptr)
 			return NULL;
 		}
 
+		// Not fatal, the frame is still usable from the CPU.
+		if (vid->capture.dmabuf) {
+			v4l2_export_dmabuf(vid, vf);
+		}
+
 		// Silence valgrind.
 		memset(vf->mem, 0, v_buf->length);
 
@@ -836,6 +893,12 @@ v4l2_fs_mainloop(void *ptr)
 		xf->source_id = vid->base.source_id;
 		xf->source_sequence = v_buf.sequence;
 
+		if (vid->capture.dmabuf && vf->dmabuf_fd >= 0) {
+			xf->buffer_handle = vf->dmabuf_fd;
+			xf->buffer_offset = desc->offset;
+			xf->has_buffer_handle = true;
+		}
+
 		if ((v_buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC) != 0) {
 			xf->timestamp = os_timeval_to_ns(&v_buf.timestamp);
 			xf->source_timestamp = xf->timestamp;
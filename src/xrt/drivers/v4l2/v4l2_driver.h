@@ -46,6 +46,9 @@ struct v4l2_frame
 
 	void *mem; //!< Data might be at an offset, so we need base memory.
 
+	//! Exported dma-buf of the buffer, only valid if v4l2_fs::capture::dmabuf.
+	int dmabuf_fd;
+
 	struct v4l2_buffer v_buf;
 };
 
@@ -108,6 +111,9 @@ struct v4l2_fs
 	{
 		bool mmap;
 		bool userptr;
+
+		//! The mmap buffers are also exported as dma-bufs.
+		bool dmabuf;
 	} capture;
 
 	struct xrt_frame_sink *sink;
@@ -19,9 +19,7 @@
 #include "util/u_time.h"
 #include "util/u_trace_marker.h"
 
-#ifdef XRT_OS_LINUX
-#include "util/u_linux.h"
-#endif
+#include "util/u_thread_role.h"
 
 #include "math/m_api.h"
 #include "math/m_predict.h"
@@ -389,6 +387,7 @@ update_imu(struct vive_device *d, const void *buffer)
 	XRT_TRACE_MARKER();
 
 	uint64_t now_ns = os_monotonic_get_ns();
+	u_io_stats_packet_begin(&d->sensors_io_stats, now_ns);
 
 	const struct vive_imu_report *report = buffer;
 	const struct vive_imu_sample *sample = report->sample;
@@ -497,15 +496,15 @@ update_imu(struct vive_device *d, const void *buffer)
 		convert_imu_to_openxr(d, &acceleration, &angular_velocity);
 		convert_imu_to_openxr(d, &raw_accel, &raw_gyro);
 
+		u_io_stats_sequence(&d->sensors_io_stats, seq, 0xff);
 		d->imu.sequence = seq;
 
 		struct xrt_space_relation rel = {0};
-		rel.relation_flags =
-		    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT;
 
+		// With the angular velocity the history can predict up to scanout.
 		os_mutex_lock(&d->fusion.mutex);
 		m_imu_3dof_update(&d->fusion.i3dof, d->imu.last_sample_ts_ns, &acceleration, &angular_velocity);
-		rel.pose.orientation = d->fusion.i3dof.rot;
+		m_imu_3dof_predict(&d->fusion.i3dof, 0, &rel);
 		os_mutex_unlock(&d->fusion.mutex);
 
 		m_relation_history_push(d->fusion.relation_hist, &rel, now_ns);
@@ -515,6 +514,8 @@ update_imu(struct vive_device *d, const void *buffer)
 
 		vive_source_push_imu_packet(d->source, age, d->imu.last_sample_ts_ns, raw_accel, raw_gyro);
 	}
+
+	u_io_stats_packet_end(&d->sensors_io_stats, os_monotonic_get_ns());
 }
 
 static void
@@ -809,6 +810,8 @@ vive_sensors_read_lighthouse_msg(struct vive_device *d)
 
 	DRV_TRACE_IDENT(packet);
 
+	u_io_stats_packet_begin(&d->watchman_io_stats, os_monotonic_get_ns());
+
 	int expected; // size;
 
 	switch (buffer[0]) {
@@ -839,6 +842,8 @@ vive_sensors_read_lighthouse_msg(struct vive_device *d)
 		           _sensors_get_report_string(buffer[0]), buffer[0], ret);
 	}
 
+	u_io_stats_packet_end(&d->watchman_io_stats, os_monotonic_get_ns());
+
 	return true;
 }
 
@@ -872,10 +877,8 @@ vive_sensors_run_thread(void *ptr)
 	U_TRACE_SET_THREAD_NAME("Vive: Sensors");
 	os_thread_helper_name(&d->sensors_thread, "Vive: Sensors");
 
-#ifdef XRT_OS_LINUX
 	// Try to raise priority of this thread.
-	u_linux_try_to_set_realtime_priority_on_thread(d->log_level, "Vive: Sensors");
-#endif
+	u_thread_role_apply_to_current_thread(U_THREAD_ROLE_REALTIME_IO, "Vive: Sensors");
 
 	/*
 	 * We want to drain all old packets to avoid old ones,
@@ -945,6 +948,7 @@ vive_device_setup_ui(struct vive_device *d)
 
 	u_var_add_gui_header(d, NULL, "3DoF Tracking");
 	m_imu_3dof_add_vars(&d->fusion.i3dof, d, "");
+	m_relation_history_add_vars(d->fusion.relation_hist, d, "");
 	u_var_add_gui_header(d, NULL, "Calibration");
 	u_var_add_vec3_f32(d, &d->config.imu.acc_scale, "acc_scale");
 	u_var_add_vec3_f32(d, &d->config.imu.acc_bias, "acc_bias");
@@ -957,6 +961,9 @@ vive_device_setup_ui(struct vive_device *d)
 
 	u_var_add_gui_header(d, NULL, "Hand Tracking");
 	u_var_add_ro_text(d, d->gui.hand_status, "Tracker status");
+
+	u_io_stats_add_vars(&d->sensors_io_stats, d);
+	u_io_stats_add_vars(&d->watchman_io_stats, d);
 }
 
 static bool
@@ -988,6 +995,7 @@ vive_set_trackers_status(struct vive_device *d, struct vive_tracking_status stat
 	bool hand_enabled = status.hand_enabled;
 
 	d->base.orientation_tracking_supported = dof3_enabled || slam_enabled;
+	d->base.late_pose_refinement_supported = dof3_enabled || slam_enabled;
 	d->base.position_tracking_supported = slam_enabled;
 	d->base.hand_tracking_supported = false; // this is handled by a separate hand device
 	d->base.device_type = XRT_DEVICE_TYPE_HMD;
@@ -1157,6 +1165,8 @@ vive_device_create(struct os_hid_device *mainboard_dev,
 	precompute_sensor_transforms(d);
 
 	// Init threads.
+	u_io_stats_init(&d->sensors_io_stats, "Vive: Sensors I/O");
+	u_io_stats_init(&d->watchman_io_stats, "Vive: Watchman I/O");
 	os_thread_helper_init(&d->mainboard_thread);
 	os_thread_helper_init(&d->sensors_thread);
 	os_thread_helper_init(&d->watchman_thread);
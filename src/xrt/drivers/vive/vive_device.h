@@ -15,6 +15,7 @@
 #include "util/u_debug.h"
 #include "util/u_time.h"
 #include "util/u_var.h"
+#include "util/u_io_stats.h"
 #include "math/m_imu_3dof.h"
 #include "math/m_relation_history.h"
 
@@ -43,6 +44,10 @@ struct vive_device
 	struct os_thread_helper watchman_thread;
 	struct os_thread_helper mainboard_thread;
 
+	//! How well the sensors and watchman threads keep up with their devices.
+	struct u_io_stats sensors_io_stats;
+	struct u_io_stats watchman_io_stats;
+
 	struct
 	{
 		timepoint_ns last_sample_ts_ns;
@@ -15,13 +15,15 @@
 
 #include "math/m_clock_offset.h"
 
-#include "util/u_deque.h"
 #include "util/u_logging.h"
+#include "util/u_small_containers.h"
 #include "util/u_trace_marker.h"
 
 #include "vive.h"
 
 
+U_SMALL_DEQUE_DECLARATION(timepoint_ns, timepoint_ns, 16)
+
 /*!
  * Manages the data streaming state related to a vive headset.
  *
@@ -43,10 +45,10 @@ struct vive_source
 	bool waiting_for_first_nonempty_frame;    //!< Whether the first good frame has been received
 
 	// Frame timestamps
-	struct u_deque_timepoint_ns frame_timestamps; //! Queue of yet unused frame hw timestamps
-	struct os_mutex frame_timestamps_lock;        //! Lock for accessing frame_timestamps
-	uint32_t last_frame_ticks;                    //! Last frame timestamp in device ticks
-	timepoint_ns last_frame_ts_ns;                //! Last frame timestamp in device nanoseconds
+	struct u_small_deque_timepoint_ns frame_timestamps; //! Queue of yet unused frame hw timestamps
+	struct os_mutex frame_timestamps_lock;              //! Lock for accessing frame_timestamps
+	uint32_t last_frame_ticks;                          //! Last frame timestamp in device ticks
+	timepoint_ns last_frame_ts_ns;                      //! Last frame timestamp in device nanoseconds
 
 	// Clock offsets
 	time_duration_ns hw2mono; //!< Estimated offset from IMU to monotonic clock
@@ -70,12 +72,12 @@ vive_source_try_convert_v4l2_timestamp(struct vive_source *vs, struct xrt_frame
 	}
 	vs->timestamps_have_been_zero_until_now = false;
 
-	struct u_deque_timepoint_ns vive_timestamps = vs->frame_timestamps;
+	struct u_small_deque_timepoint_ns *vive_timestamps = &vs->frame_timestamps;
 	struct os_mutex *vive_timestamps_lock = &vs->frame_timestamps_lock;
 
 	timepoint_ns v4l2_ts = xf->timestamp;
 
-	size_t vive_ts_count = u_deque_timepoint_ns_size(vive_timestamps);
+	size_t vive_ts_count = u_small_deque_timepoint_ns_size(vive_timestamps);
 	if (vive_ts_count == 0) { // This seems to happen in some runs
 		// This code assumes vive_timestamps will always be populated before v4l2
 		// receives a frame, thus if we reach this, this assumption has failed.
@@ -93,7 +95,7 @@ vive_source_try_convert_v4l2_timestamp(struct vive_source *vs, struct xrt_frame
 	timepoint_ns vive_ts = -1;
 	time_duration_ns min_distance = INT64_MAX;
 	for (size_t i = 0; i < vive_ts_count; i++) {
-		vive_ts = u_deque_timepoint_ns_at(vive_timestamps, i);
+		vive_ts = u_small_deque_timepoint_ns_at(vive_timestamps, i);
 		timepoint_ns v4l2_ts_est = vive_ts + vs->hw2v4l2;
 		time_duration_ns distance = llabs(v4l2_ts_est - v4l2_ts);
 		if (distance < min_distance) {
@@ -105,7 +107,7 @@ vive_source_try_convert_v4l2_timestamp(struct vive_source *vs, struct xrt_frame
 	// Discard missed frames and set vive_timestamp to use in this frame
 	timepoint_ns vive_timestamp = 0;
 	for (; closer_i >= 0; closer_i--) {
-		u_deque_timepoint_ns_pop_front(vive_timestamps, &vive_timestamp);
+		u_small_deque_timepoint_ns_pop_front(vive_timestamps, &vive_timestamp);
 	}
 
 	os_mutex_unlock(vive_timestamps_lock);
@@ -165,7 +167,7 @@ vive_source_node_destroy(struct xrt_frame_node *node)
 {
 	struct vive_source *vs = container_of(node, struct vive_source, node);
 	os_mutex_destroy(&vs->frame_timestamps_lock);
-	u_deque_timepoint_ns_destroy(&vs->frame_timestamps);
+	u_small_deque_timepoint_ns_fini(&vs->frame_timestamps);
 
 	free(vs);
 }
@@ -193,7 +195,7 @@ vive_source_create(struct xrt_frame_context *xfctx)
 	vs->timestamps_have_been_zero_until_now = true;
 	vs->waiting_for_first_nonempty_frame = true;
 
-	vs->frame_timestamps = u_deque_timepoint_ns_create();
+	u_small_deque_timepoint_ns_init(&vs->frame_timestamps, NULL);
 	os_mutex_init(&vs->frame_timestamps_lock);
 
 	// Setup node
@@ -277,7 +279,10 @@ void
 vive_source_push_frame_ticks(struct vive_source *vs, timepoint_ns ticks)
 {
 	ticks_to_ns(ticks, &vs->last_frame_ticks, &vs->last_frame_ts_ns);
-	u_deque_timepoint_ns_push_back(vs->frame_timestamps, vs->last_frame_ts_ns);
+
+	os_mutex_lock(&vs->frame_timestamps_lock);
+	u_small_deque_timepoint_ns_push_back(&vs->frame_timestamps, vs->last_frame_ts_ns);
+	os_mutex_unlock(&vs->frame_timestamps_lock);
 }
 
 void
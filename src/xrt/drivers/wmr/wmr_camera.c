@@ -18,6 +18,7 @@
 
 #include "math/m_api.h"
 #include "os/os_threading.h"
+#include "util/u_misc.h"
 #include "util/u_autoexpgain.h"
 #include "util/u_debug.h"
 #include "util/u_var.h"
@@ -52,7 +53,11 @@ update_expgain(struct wmr_camera *cam, struct xrt_frame **frames);
 
 #define CAM_ENDPOINT 0x05
 
-#define NUM_XFERS 4
+/*!
+ * Frames are backed by the transfer buffers and downstream can hold on to a
+ * few of them, so keep enough around that some are always in flight.
+ */
+#define NUM_XFERS 8
 
 #define WMR_CAMERA_CMD_GAIN 0x80
 #define WMR_CAMERA_CMD_ON 0x81
@@ -85,6 +90,42 @@ struct wmr_camera_gain_cmd
 	__le16 camera_id2; //!< same as camera_id
 } __attribute__((packed));
 
+/*!
+ * A bulk transfer whose buffer, once the slice headers are stripped from it,
+ * is handed downstream as the frame. It is resubmitted when the last
+ * reference to the frame is released.
+ */
+struct wmr_camera_xfer
+{
+	struct xrt_frame frame;
+
+	struct wmr_camera_xfers *xfers;
+
+	//! Freed by the camera, NULL after that, protected by the mutex in @ref wmr_camera_xfers.
+	struct libusb_transfer *transfer;
+
+	//! Owned by us and not the transfer so frames can outlive the camera.
+	uint8_t *buffer;
+};
+
+/*!
+ * All of the transfers, frames can be released from any thread and after the
+ * camera has been freed so this is reference counted separately.
+ */
+struct wmr_camera_xfers
+{
+	//! One for the camera and one for each frame that is held downstream.
+	struct xrt_reference reference;
+
+	//! Protects streaming and the transfers against frames being released.
+	struct os_mutex mutex;
+
+	//! Should released transfers be resubmitted.
+	bool streaming;
+
+	struct wmr_camera_xfer xfers[NUM_XFERS];
+};
+
 struct wmr_camera
 {
 	libusb_context *ctx;
@@ -107,7 +148,8 @@ struct wmr_camera
 	/* Unwrapped frame sequence number */
 	uint64_t frame_sequence;
 
-	struct libusb_transfer *xfers[NUM_XFERS];
+	/* Transfers, their buffers are the full camera frames */
+	struct wmr_camera_xfers *xfers;
 
 	struct wmr_camera_expgain
 	{
@@ -276,12 +318,58 @@ set_active(struct wmr_camera *cam, bool active)
 	return send_buffer_to_device(cam, (uint8_t *)&cmd, sizeof(cmd));
 }
 
+static void
+xfers_unreference(struct wmr_camera_xfers *xfers)
+{
+	if (!xrt_reference_dec_and_is_zero(&xfers->reference)) {
+		return;
+	}
+
+	// The camera has freed the transfers by now.
+	for (int i = 0; i < NUM_XFERS; i++) {
+		assert(xfers->xfers[i].transfer == NULL);
+		free(xfers->xfers[i].buffer);
+	}
+
+	os_mutex_destroy(&xfers->mutex);
+	free(xfers);
+}
+
+static void
+xfer_resubmit(struct wmr_camera_xfer *x)
+{
+	struct wmr_camera_xfers *xfers = x->xfers;
+
+	os_mutex_lock(&xfers->mutex);
+	if (xfers->streaming && x->transfer != NULL) {
+		libusb_submit_transfer(x->transfer);
+	}
+	os_mutex_unlock(&xfers->mutex);
+}
+
+static void
+xfer_frame_release(struct xrt_frame *xf)
+{
+	struct wmr_camera_xfer *x = container_of(xf, struct wmr_camera_xfer, frame);
+	struct wmr_camera_xfers *xfers = x->xfers;
+
+	// The buffer is free again, let the transfer fill it.
+	xfer_resubmit(x);
+
+	xfers_unreference(xfers);
+}
+
 static void LIBUSB_CALL
 img_xfer_cb(struct libusb_transfer *xfer)
 {
 	DRV_TRACE_MARKER();
 
-	struct wmr_camera *cam = xfer->user_data;
+	struct wmr_camera_xfer *x = xfer->user_data;
+	struct wmr_camera *cam = x->frame.owner;
+
+	if (xfer->status == LIBUSB_TRANSFER_CANCELLED) {
+		return;
+	}
 
 	if (xfer->status != LIBUSB_TRANSFER_COMPLETED) {
 		WMR_CAM_DEBUG(cam, "Camera transfer completed with status: %s (%u)", libusb_error_name(xfer->status),
@@ -299,8 +387,12 @@ img_xfer_cb(struct libusb_transfer *xfer)
 	/* Convert the output into frames and send them off to debug / tracking */
 	struct xrt_frame *xf = NULL;
 
-	/* There's always one extra line of pixels with exposure info */
-	u_frame_create_one_off(XRT_FORMAT_L8, cam->frame_width, cam->frame_height + 1, &xf);
+	/*
+	 * The frame lives in the transfer buffer, the slices are moved down in
+	 * place over the headers. Each frame handed out holds the transfers.
+	 */
+	xrt_reference_inc(&x->xfers->reference);
+	xrt_frame_reference(&xf, &x->frame);
 
 	const uint8_t *src = xfer->buffer;
 
@@ -308,7 +400,7 @@ img_xfer_cb(struct libusb_transfer *xfer)
 	size_t dst_remain = xf->size;
 	const size_t chunk_size = 0x6000 - 32;
 
-	DRV_TRACE_BEGIN(copy_to_frame);
+	DRV_TRACE_BEGIN(strip_slice_headers);
 	while (dst_remain > 0) {
 		const size_t to_copy = dst_remain > chunk_size ? chunk_size : dst_remain;
 
@@ -322,12 +414,13 @@ img_xfer_cb(struct libusb_transfer *xfer)
 		 */
 		src += 0x20;
 
-		memcpy(dst, src, to_copy);
+		// Overlaps with the source, but always moves down.
+		memmove(dst, src, to_copy);
 		src += to_copy;
 		dst += to_copy;
 		dst_remain -= to_copy;
 	}
-	DRV_TRACE_END(copy_to_frame);
+	DRV_TRACE_END(strip_slice_headers);
 
 	/* There should be exactly a 26 byte footer left over */
 	assert(xfer->buffer + xfer->length - src == 26);
@@ -402,10 +495,12 @@ img_xfer_cb(struct libusb_transfer *xfer)
 		}
 	}
 
+	// Resubmits the transfer if nobody downstream kept the frame.
 	xrt_frame_reference(&xf, NULL);
+	return;
 
 out:
-	libusb_submit_transfer(xfer);
+	xfer_resubmit(x);
 }
 
 
@@ -461,9 +556,22 @@ wmr_camera_open(struct wmr_camera_open_config *config)
 		goto fail;
 	}
 
+	cam->xfers = U_TYPED_CALLOC(struct wmr_camera_xfers);
+	cam->xfers->reference.count = 1;
+	if (os_mutex_init(&cam->xfers->mutex) != 0) {
+		free(cam->xfers);
+		cam->xfers = NULL;
+		res = LIBUSB_ERROR_OTHER;
+		goto fail;
+	}
+
 	for (i = 0; i < NUM_XFERS; i++) {
-		cam->xfers[i] = libusb_alloc_transfer(0);
-		if (cam->xfers[i] == NULL) {
+		struct wmr_camera_xfer *x = &cam->xfers->xfers[i];
+		x->xfers = cam->xfers;
+		x->frame.owner = cam;
+		x->frame.destroy = xfer_frame_release;
+		x->transfer = libusb_alloc_transfer(0);
+		if (x->transfer == NULL) {
 			res = LIBUSB_ERROR_NO_MEM;
 			goto fail;
 		}
@@ -553,13 +661,20 @@ wmr_camera_free(struct wmr_camera *cam)
 
 		os_thread_helper_destroy(&cam->usb_thread);
 
-		for (i = 0; i < NUM_XFERS; i++) {
-			if (cam->xfers[i] == NULL) {
-				continue;
+		// Frames still held downstream keep the buffers alive but not the transfers.
+		if (cam->xfers != NULL) {
+			os_mutex_lock(&cam->xfers->mutex);
+			cam->xfers->streaming = false;
+			for (i = 0; i < NUM_XFERS; i++) {
+				struct wmr_camera_xfer *x = &cam->xfers->xfers[i];
+				if (x->transfer == NULL) {
+					continue;
+				}
+
+				libusb_free_transfer(x->transfer);
+				x->transfer = NULL;
 			}
-
-			libusb_free_transfer(cam->xfers[i]);
-			cam->xfers[i] = NULL;
+			os_mutex_unlock(&cam->xfers->mutex);
 		}
 
 		libusb_exit(cam->ctx);
@@ -571,6 +686,11 @@ wmr_camera_free(struct wmr_camera *cam)
 	u_sink_debug_destroy(&cam->debug_sinks[WMR_DEBUG_SINK_SLAM]);
 	u_sink_debug_destroy(&cam->debug_sinks[WMR_DEBUG_SINK_CONTROLLER]);
 
+	if (cam->xfers != NULL) {
+		xfers_unreference(cam->xfers);
+		cam->xfers = NULL;
+	}
+
 	free(cam);
 }
 
@@ -601,18 +721,42 @@ wmr_camera_start(struct wmr_camera *cam)
 		goto fail;
 	}
 
+	cam->running = true;
+
+	os_mutex_lock(&cam->xfers->mutex);
+	cam->xfers->streaming = true;
 	for (int i = 0; i < NUM_XFERS; i++) {
-		uint8_t *recv_buf = malloc(cam->xfer_size);
+		struct wmr_camera_xfer *x = &cam->xfers->xfers[i];
+
+		if (x->buffer == NULL) {
+			x->buffer = malloc(cam->xfer_size);
+		}
+		if (x->buffer == NULL) {
+			res = LIBUSB_ERROR_NO_MEM;
+			break;
+		}
+
+		/* There's always one extra line of pixels with exposure info */
+		x->frame.format = XRT_FORMAT_L8;
+		x->frame.width = cam->frame_width;
+		x->frame.height = cam->frame_height + 1;
+		x->frame.stride = cam->frame_width;
+		x->frame.size = x->frame.stride * x->frame.height;
+		x->frame.data = x->buffer;
 
-		libusb_fill_bulk_transfer(cam->xfers[i], cam->dev, LIBUSB_ENDPOINT_IN | 5, recv_buf, cam->xfer_size,
-		                          img_xfer_cb, cam, 0);
-		cam->xfers[i]->flags |= LIBUSB_TRANSFER_FREE_BUFFER;
+		libusb_fill_bulk_transfer(x->transfer, cam->dev, LIBUSB_ENDPOINT_IN | 5, x->buffer, cam->xfer_size,
+		                          img_xfer_cb, x, 0);
 
-		res = libusb_submit_transfer(cam->xfers[i]);
+		res = libusb_submit_transfer(x->transfer);
 		if (res < 0) {
-			goto fail;
+			break;
 		}
 	}
+	os_mutex_unlock(&cam->xfers->mutex);
+
+	if (res < 0) {
+		goto fail;
+	}
 
 	WMR_CAM_INFO(cam, "WMR camera started");
 
@@ -642,11 +786,15 @@ wmr_camera_stop(struct wmr_camera *cam)
 	}
 	cam->running = false;
 
+	// Under the lock so no transfer released downstream gets resubmitted after this.
+	os_mutex_lock(&cam->xfers->mutex);
+	cam->xfers->streaming = false;
 	for (i = 0; i < NUM_XFERS; i++) {
-		if (cam->xfers[i] != NULL) {
-			libusb_cancel_transfer(cam->xfers[i]);
+		if (cam->xfers->xfers[i].transfer != NULL) {
+			libusb_cancel_transfer(cam->xfers->xfers[i].transfer);
 		}
 	}
+	os_mutex_unlock(&cam->xfers->mutex);
 
 	res = set_active(cam, false);
 	if (res < 0) {
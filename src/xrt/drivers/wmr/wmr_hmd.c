@@ -26,7 +26,6 @@
 
 #include "math/m_api.h"
 #include "math/m_mathinclude.h"
-#include "math/m_predict.h"
 #include "math/m_vec2.h"
 
 #include "util/u_var.h"
@@ -34,13 +33,12 @@
 #include "util/u_time.h"
 #include "util/u_debug.h"
 #include "util/u_device.h"
+#include "util/u_device_config_cache.h"
 #include "util/u_trace_marker.h"
 #include "util/u_distortion_mesh.h"
 #include "util/u_sink.h"
 
-#ifdef XRT_OS_LINUX
-#include "util/u_linux.h"
-#endif
+#include "util/u_thread_role.h"
 
 #include "tracking/t_tracking.h"
 
@@ -451,24 +449,30 @@ hololens_handle_sensors_all(struct wmr_hmd *wh, const unsigned char *buffer, int
 		math_quat_rotate_vec3(&wh->config.sensors.transforms.P_oxr_acc.orientation, ca, ca);
 	}
 
-	// Fusion tracking
-	os_mutex_lock(&wh->fusion.mutex);
+	uint64_t timestamps_ns[IMU_SAMPLES_PER_PACKET];
 	for (int i = 0; i < IMU_SAMPLES_PER_PACKET; i++) {
-		m_imu_3dof_update(                                              //
-		    &wh->fusion.i3dof,                                          //
-		    wh->packet.gyro_timestamp[i] * WMR_MS_HOLOLENS_NS_PER_TICK, //
-		    &calib_accel[i],                                            //
-		    &calib_gyro[i]);                                            //
+		timestamps_ns[i] = wh->packet.gyro_timestamp[i] * WMR_MS_HOLOLENS_NS_PER_TICK;
 	}
+
+	// Fusion tracking
+	os_mutex_lock(&wh->fusion.mutex);
+	m_imu_3dof_update_batch(     //
+	    &wh->fusion.i3dof,       //
+	    timestamps_ns,           //
+	    calib_accel,             //
+	    calib_gyro,              //
+	    IMU_SAMPLES_PER_PACKET); //
 	wh->fusion.last_imu_timestamp_ns = now_ns;
 	wh->fusion.last_angular_velocity = calib_gyro[3];
 	os_mutex_unlock(&wh->fusion.mutex);
 
 	// SLAM tracking
+	timepoint_ns slam_timestamps_ns[IMU_SAMPLES_PER_PACKET];
 	for (int i = 0; i < IMU_SAMPLES_PER_PACKET; i++) {
-		timepoint_ns t = wh->packet.gyro_timestamp[i] * WMR_MS_HOLOLENS_NS_PER_TICK;
-		wmr_source_push_imu_packet(wh->tracking.source, t, raw_accel[i], raw_gyro[i]);
+		slam_timestamps_ns[i] = (timepoint_ns)timestamps_ns[i];
 	}
+	wmr_source_push_imu_packets(wh->tracking.source, slam_timestamps_ns, raw_accel, raw_gyro,
+	                            IMU_SAMPLES_PER_PACKET);
 }
 
 static void
@@ -508,6 +512,8 @@ hololens_sensors_read_packets(struct wmr_hmd *wh)
 		WMR_TRACE(wh, "Read %u bytes", size);
 	}
 
+	u_io_stats_packet_begin(&wh->io_stats, os_monotonic_get_ns());
+
 	switch (buffer[0]) {
 	case WMR_MS_HOLOLENS_MSG_SENSORS: //
 		hololens_handle_sensors(wh, buffer, size);
@@ -533,6 +539,8 @@ hololens_sensors_read_packets(struct wmr_hmd *wh)
 		break;
 	}
 
+	u_io_stats_packet_end(&wh->io_stats, os_monotonic_get_ns());
+
 	return true;
 }
 
@@ -661,10 +669,8 @@ wmr_run_thread(void *ptr)
 	U_TRACE_SET_THREAD_NAME("WMR: USB-HMD");
 	os_thread_helper_name(&wh->oth, "WMR: USB-HMD");
 
-#ifdef XRT_OS_LINUX
 	// Try to raise priority of this thread.
-	u_linux_try_to_set_realtime_priority_on_thread(wh->log_level, "WMR: USB-HMD");
-#endif
+	u_thread_role_apply_to_current_thread(U_THREAD_ROLE_REALTIME_IO, "WMR: USB-HMD");
 
 
 	os_thread_helper_lock(&wh->oth);
@@ -970,7 +976,7 @@ wmr_read_config_part(struct wmr_hmd *wh, unsigned char type, unsigned char *data
 }
 
 XRT_MAYBE_UNUSED static int
-wmr_read_config_raw(struct wmr_hmd *wh, uint8_t **out_data, size_t *out_size)
+wmr_read_config_raw(struct wmr_hmd *wh, const char *serial, uint8_t **out_data, size_t *out_size)
 {
 	DRV_TRACE_MARKER();
 
@@ -991,6 +997,22 @@ wmr_read_config_raw(struct wmr_hmd *wh, uint8_t **out_data, size_t *out_size)
 	 * seem to be little endian size of the data store.
 	 */
 	data_size = meta[0] | (meta[1] << 8);
+
+	/*
+	 * The metadata is a fraction of the data store, so use it together
+	 * with the serial to check if the copy on disk is still good. Without
+	 * a serial we can't tell two headsets of the same model apart.
+	 */
+	uint64_t cache_key = u_device_config_cache_hash_bytes(U_DEVICE_CONFIG_CACHE_HASH_INIT, meta, sizeof(meta));
+	if (serial != NULL && u_device_config_cache_load("wmr-config", serial, cache_key, &data, out_size)) {
+		if (*out_size == (size_t)data_size) {
+			WMR_DEBUG(wh, "Using cached %d-byte config data", data_size);
+			*out_data = data;
+			return 0;
+		}
+		free(data);
+	}
+
 	data = calloc(1, data_size + 1);
 	if (!data) {
 		return -1;
@@ -1006,6 +1028,10 @@ wmr_read_config_raw(struct wmr_hmd *wh, uint8_t **out_data, size_t *out_size)
 
 	WMR_DEBUG(wh, "Read %d-byte config data", data_size);
 
+	if (serial != NULL) {
+		u_device_config_cache_store("wmr-config", serial, cache_key, data, size);
+	}
+
 	*out_data = data;
 	*out_size = size;
 
@@ -1013,7 +1039,7 @@ wmr_read_config_raw(struct wmr_hmd *wh, uint8_t **out_data, size_t *out_size)
 }
 
 static int
-wmr_read_config(struct wmr_hmd *wh)
+wmr_read_config(struct wmr_hmd *wh, const char *serial)
 {
 	DRV_TRACE_MARKER();
 
@@ -1023,7 +1049,7 @@ wmr_read_config(struct wmr_hmd *wh)
 	int ret;
 
 	// Read config
-	ret = wmr_read_config_raw(wh, &data, &data_size);
+	ret = wmr_read_config_raw(wh, serial, &data, &data_size);
 	if (ret < 0)
 		return ret;
 
@@ -1087,30 +1113,19 @@ wmr_hmd_get_3dof_tracked_pose(struct xrt_device *xdev,
 		return;
 	}
 
-	// Variables needed for prediction.
-	uint64_t last_imu_timestamp_ns = 0;
 	struct xrt_space_relation relation = {0};
-	relation.relation_flags = XRT_SPACE_RELATION_BITMASK_ALL;
-	relation.pose.position = wh->pose.position;
-	relation.linear_velocity = (struct xrt_vec3){0, 0, 0};
 
-	// Get data while holding the lock.
+	// Predict from the newest fused sample while holding the lock.
 	os_mutex_lock(&wh->fusion.mutex);
-	relation.pose.orientation = wh->fusion.i3dof.rot;
-	relation.angular_velocity = wh->fusion.last_angular_velocity;
-	last_imu_timestamp_ns = wh->fusion.last_imu_timestamp_ns;
+	int64_t prediction_ns = (int64_t)(at_timestamp_ns - wh->fusion.last_imu_timestamp_ns);
+	m_imu_3dof_predict(&wh->fusion.i3dof, prediction_ns, &relation);
 	os_mutex_unlock(&wh->fusion.mutex);
 
-	// No prediction needed.
-	if (at_timestamp_ns < last_imu_timestamp_ns) {
-		*out_relation = relation;
-		return;
-	}
-
-	uint64_t prediction_ns = at_timestamp_ns - last_imu_timestamp_ns;
-	double prediction_s = time_ns_to_s(prediction_ns);
+	relation.relation_flags = XRT_SPACE_RELATION_BITMASK_ALL;
+	relation.pose.position = wh->pose.position;
+	relation.linear_velocity = (struct xrt_vec3){0, 0, 0};
 
-	m_predict_relation(&relation, prediction_s, out_relation);
+	*out_relation = relation;
 	wh->pose = out_relation->pose;
 }
 
@@ -1788,6 +1803,8 @@ wmr_hmd_setup_ui(struct wmr_hmd *wh)
 		u_var_add_button(wh, &wh->gui.hmd_screen_enable_btn, "HMD Screen [On/Off]");
 	}
 
+	u_io_stats_add_vars(&wh->io_stats, wh);
+
 	u_var_add_gui_header(wh, NULL, "Misc");
 	u_var_add_log_level(wh, &wh->log_level, "log_level");
 }
@@ -1829,6 +1846,7 @@ wmr_hmd_setup_trackers(struct wmr_hmd *wh, struct xrt_slam_sinks *out_sinks, str
 	bool hand_enabled = hand_supported && hand_wanted;
 
 	wh->base.orientation_tracking_supported = dof3_enabled || slam_enabled;
+	wh->base.late_pose_refinement_supported = dof3_enabled || slam_enabled;
 	wh->base.position_tracking_supported = slam_enabled;
 	wh->base.hand_tracking_supported = false; // out_handtracker will handle it
 
@@ -1921,6 +1939,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
                struct os_hid_device *hid_holo,
                struct os_hid_device *hid_ctrl,
                struct xrt_prober_device *dev_holo,
+               const char *serial,
                enum u_logging_level log_level,
                struct xrt_device **out_hmd,
                struct xrt_device **out_handtracker,
@@ -1989,6 +2008,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 	}
 
 	// Thread and other state.
+	u_io_stats_init(&wh->io_stats, "WMR: USB-HMD I/O");
 	ret = os_thread_helper_init(&wh->oth);
 	if (ret != 0) {
 		WMR_ERROR(wh, "Failed to init threading!");
@@ -2001,7 +2021,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
 	wh->base.inputs[0].name = XRT_INPUT_GENERIC_HEAD_POSE;
 
 	// Read config file from HMD
-	if (wmr_read_config(wh) < 0) {
+	if (wmr_read_config(wh, serial) < 0) {
 		WMR_ERROR(wh, "Failed to load headset configuration!");
 		wmr_hmd_destroy(&wh->base);
 		wh = NULL;
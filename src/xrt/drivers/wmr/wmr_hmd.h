@@ -21,6 +21,7 @@
 #include "os/os_threading.h"
 #include "math/m_imu_3dof.h"
 #include "util/u_logging.h"
+#include "util/u_io_stats.h"
 #include "util/u_distortion_mesh.h"
 #include "util/u_var.h"
 
@@ -83,6 +84,9 @@ struct wmr_hmd
 	//! Packet reading thread.
 	struct os_thread_helper oth;
 
+	//! How well the reading thread keeps up with the Hololens Sensors packets.
+	struct u_io_stats io_stats;
+
 	enum u_logging_level log_level;
 
 	int32_t left_view_y_offset, right_view_y_offset;
@@ -209,6 +213,7 @@ wmr_hmd_create(enum wmr_headset_type hmd_type,
                struct os_hid_device *hid_holo,
                struct os_hid_device *hid_ctrl,
                struct xrt_prober_device *dev_holo,
+               const char *serial,
                enum u_logging_level log_level,
                struct xrt_device **out_hmd,
                struct xrt_device **out_handtracker,
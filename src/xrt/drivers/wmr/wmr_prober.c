@@ -350,12 +350,18 @@ wmr_create_headset(struct xrt_prober *xp,
 		goto error_holo;
 	}
 
+	// Only used to find the cached config, so it's fine if there is none.
+	unsigned char serial[XRT_DEVICE_NAME_LEN] = {0};
+	ret = xrt_prober_get_string_descriptor(xp, xpdev_holo, XRT_PROBER_STRING_SERIAL_NUMBER, serial,
+	                                       sizeof(serial) - 1);
+	bool have_serial = ret > 0 && serial[0] != '\0';
+
 	struct xrt_device *hmd = NULL;
 	struct xrt_device *ht = NULL;
 	struct xrt_device *two_hands[2] = {NULL, NULL}; // Must initialize, always returned.
 	struct xrt_device *hmd_left_ctrl = NULL, *hmd_right_ctrl = NULL;
-	wmr_hmd_create(type, hid_holo, hid_companion, xpdev_holo, log_level, &hmd, &ht, &hmd_left_ctrl,
-	               &hmd_right_ctrl);
+	wmr_hmd_create(type, hid_holo, hid_companion, xpdev_holo, have_serial ? (const char *)serial : NULL, log_level,
+	               &hmd, &ht, &hmd_left_ctrl, &hmd_right_ctrl);
 
 	if (hmd == NULL) {
 		U_LOG_IFL_E(log_level, "Failed to create WMR HMD device.");
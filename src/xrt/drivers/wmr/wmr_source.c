@@ -27,6 +27,9 @@
 
 #define WMR_SOURCE_STR "WMR Source"
 
+//! Most IMU samples converted and pushed downstream at once.
+#define WMR_MAX_IMU_SAMPLES_PER_PUSH (8)
+
 #define WMR_TRACE(w, ...) U_LOG_IFL_T(w->log_level, __VA_ARGS__)
 #define WMR_DEBUG(w, ...) U_LOG_IFL_D(w->log_level, __VA_ARGS__)
 #define WMR_INFO(w, ...) U_LOG_IFL_I(w->log_level, __VA_ARGS__)
@@ -114,11 +117,13 @@ void (*receive_cam[WMR_MAX_CAMERAS])(struct xrt_frame_sink *, struct xrt_frame *
     receive_cam3, //
 };
 
-static void
-receive_imu_sample(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
+/*!
+ * Moves the sample to the monotonic clock in place and pushes it to the debug
+ * UI, returns false if the sample should be dropped.
+ */
+static bool
+process_imu_sample(struct wmr_source *ws, struct xrt_imu_sample *s)
 {
-	struct wmr_source *ws = container_of(sink, struct wmr_source, imu_sink);
-
 	// Convert hardware timestamp into monotonic clock. Update offset estimate hw2mono.
 	// Note this is only done with IMU samples as they have the smallest USB transmission time.
 	const float IMU_FREQ = 250.f; //!< @todo use 1000 if "average_imus" is false
@@ -133,7 +138,7 @@ receive_imu_sample(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
 	if (ws->last_imu_ns > ts) {
 		WMR_WARN(ws, "Received sample from the past, new: %" PRIu64 ", last: %" PRIu64 ", diff: %" PRIu64, ts,
 		         s->timestamp_ns, ts - s->timestamp_ns);
-		return;
+		return false;
 	}
 
 	ws->first_imu_received = true;
@@ -150,11 +155,37 @@ receive_imu_sample(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
 	m_ff_vec3_f32_push(ws->gyro_ff, &gyro, ts);
 	m_ff_vec3_f32_push(ws->accel_ff, &accel, ts);
 
-	if (ws->out_sinks.imu) {
+	return true;
+}
+
+static void
+receive_imu_sample(struct xrt_imu_sink *sink, struct xrt_imu_sample *s)
+{
+	struct wmr_source *ws = container_of(sink, struct wmr_source, imu_sink);
+
+	if (process_imu_sample(ws, s) && ws->out_sinks.imu) {
 		xrt_sink_push_imu(ws->out_sinks.imu, s);
 	}
 }
 
+static void
+receive_imu_samples(struct xrt_imu_sink *sink, struct xrt_imu_sample *samples, uint32_t count)
+{
+	struct wmr_source *ws = container_of(sink, struct wmr_source, imu_sink);
+
+	// Samples are converted in place, squeeze out the dropped ones.
+	uint32_t n = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		if (process_imu_sample(ws, &samples[i])) {
+			samples[n++] = samples[i];
+		}
+	}
+
+	if (n > 0 && ws->out_sinks.imu) {
+		xrt_sink_push_imu_batch(ws->out_sinks.imu, samples, n);
+	}
+}
+
 
 /*
  *
@@ -321,6 +352,7 @@ wmr_source_create(struct xrt_frame_context *xfctx, struct xrt_prober_device *dev
 		ws->cam_sinks[i].push_frame = receive_cam[i];
 	}
 	ws->imu_sink.push_imu = receive_imu_sample;
+	ws->imu_sink.push_imu_batch = receive_imu_samples;
 
 	ws->in_sinks.cam_count = cfg.tcam_count;
 	for (int i = 0; i < cfg.tcam_count; i++) {
@@ -377,3 +409,29 @@ wmr_source_push_imu_packet(struct xrt_fs *xfs, timepoint_ns t, struct xrt_vec3 a
 	struct xrt_imu_sample sample = {.timestamp_ns = t, .accel_m_s2 = accel_f64, .gyro_rad_secs = gyro_f64};
 	xrt_sink_push_imu(&ws->imu_sink, &sample);
 }
+
+void
+wmr_source_push_imu_packets(struct xrt_fs *xfs,
+                            const timepoint_ns *timestamps_ns,
+                            const struct xrt_vec3 *accels,
+                            const struct xrt_vec3 *gyros,
+                            uint32_t count)
+{
+	DRV_TRACE_MARKER();
+	struct wmr_source *ws = wmr_source_from_xfs(xfs);
+	struct xrt_imu_sample samples[WMR_MAX_IMU_SAMPLES_PER_PUSH];
+
+	for (uint32_t i = 0; i < count; i += WMR_MAX_IMU_SAMPLES_PER_PUSH) {
+		uint32_t n = count - i < WMR_MAX_IMU_SAMPLES_PER_PUSH ? count - i : WMR_MAX_IMU_SAMPLES_PER_PUSH;
+		for (uint32_t k = 0; k < n; k++) {
+			const struct xrt_vec3 *a = &accels[i + k];
+			const struct xrt_vec3 *g = &gyros[i + k];
+			samples[k] = (struct xrt_imu_sample){
+			    .timestamp_ns = timestamps_ns[i + k],
+			    .accel_m_s2 = {a->x, a->y, a->z},
+			    .gyro_rad_secs = {g->x, g->y, g->z},
+			};
+		}
+		xrt_sink_push_imu_batch(&ws->imu_sink, samples, n);
+	}
+}
@@ -37,6 +37,14 @@ wmr_source_create(struct xrt_frame_context *xfctx, struct xrt_prober_device *dev
 void
 wmr_source_push_imu_packet(struct xrt_fs *xfs, timepoint_ns t, struct xrt_vec3 accel, struct xrt_vec3 gyro);
 
+//! Same as @ref wmr_source_push_imu_packet but for all the samples of a packet at once.
+void
+wmr_source_push_imu_packets(struct xrt_fs *xfs,
+                            const timepoint_ns *timestamps_ns,
+                            const struct xrt_vec3 *accels,
+                            const struct xrt_vec3 *gyros,
+                            uint32_t count);
+
 /*!
  * @}
  */
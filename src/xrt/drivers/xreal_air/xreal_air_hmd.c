@@ -16,6 +16,7 @@
 #include "math/m_api.h"
 #include "math/m_imu_3dof.h"
 
+#include "util/u_debug.h"
 #include "util/u_device.h"
 #include "util/u_distortion_mesh.h"
 #include "util/u_trace_marker.h"
@@ -40,6 +41,12 @@
 #define SENSOR_HEAD 0xFD
 #define CONTROL_HEAD 0xFD
 
+/*!
+ * How many IMU samples are averaged and fused as one, the glasses send them
+ * at 1kHz which is more than weak hosts want to run the fusion at.
+ */
+DEBUG_GET_ONCE_NUM_OPTION(xreal_air_imu_batch, "XREAL_AIR_IMU_BATCH", 1)
+
 /*!
  * Private struct for the xreal_air device.
  *
@@ -105,8 +112,20 @@ struct xreal_air_hmd
 		bool calibration;
 	} gui;
 
+	//! Only touched from the sensor thread, readers only use the lock-free @ref relation_hist.
 	struct m_imu_3dof fusion;
 	struct m_relation_history *relation_hist;
+
+	//! Samples summed up to be fused together, only touched from the sensor thread.
+	struct
+	{
+		struct xrt_vec3 accel;
+		struct xrt_vec3 gyro;
+		uint32_t count;
+
+		//! From XREAL_AIR_IMU_BATCH.
+		uint32_t size;
+	} batch;
 };
 
 /*
@@ -303,24 +322,37 @@ read_sample_and_apply_calibration(struct xreal_air_hmd *hmd,
 }
 
 static void
-update_fusion_locked(struct xreal_air_hmd *hmd, struct xreal_air_parsed_sample *sample, uint64_t timestamp_ns)
+update_fusion(struct xreal_air_hmd *hmd, struct xreal_air_parsed_sample *sample, uint64_t timestamp_ns)
 {
 	read_sample_and_apply_calibration(hmd, sample, &hmd->read.accel, &hmd->read.gyro, &hmd->read.mag);
-	m_imu_3dof_update(&hmd->fusion, timestamp_ns, &hmd->read.accel, &hmd->read.gyro);
-}
 
-static void
-update_fusion(struct xreal_air_hmd *hmd, struct xreal_air_parsed_sample *sample, uint64_t timestamp_ns)
-{
+	math_vec3_accum(&hmd->read.accel, &hmd->batch.accel);
+	math_vec3_accum(&hmd->read.gyro, &hmd->batch.gyro);
+	if (++hmd->batch.count < hmd->batch.size) {
+		return;
+	}
+
+	/*
+	 * The fusion integrates the gyro over the time since the last update,
+	 * so the average of the batch gives it the same rotation.
+	 */
+	struct xrt_vec3 accel = hmd->batch.accel;
+	struct xrt_vec3 gyro = hmd->batch.gyro;
+	math_vec3_scalar_mul(1.0f / (float)hmd->batch.count, &accel);
+	math_vec3_scalar_mul(1.0f / (float)hmd->batch.count, &gyro);
+
+	U_ZERO(&hmd->batch.accel);
+	U_ZERO(&hmd->batch.gyro);
+	hmd->batch.count = 0;
+
+	// Nothing else touches the fusion, so no lock is needed.
+	m_imu_3dof_update(&hmd->fusion, timestamp_ns, &accel, &gyro);
+
 	struct xrt_space_relation rel;
 	U_ZERO(&rel); // Clear out the relation.
 	rel.relation_flags = (enum xrt_space_relation_flags)(XRT_SPACE_RELATION_ORIENTATION_VALID_BIT |
 	                                                     XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT);
-
-	os_mutex_lock(&hmd->device_mutex);
-	update_fusion_locked(hmd, sample, timestamp_ns);
 	rel.pose.orientation = hmd->fusion.rot; // We have no tracking, don't return a position.
-	os_mutex_unlock(&hmd->device_mutex);
 
 	m_relation_history_push(hmd->relation_hist, &rel, timestamp_ns);
 }
@@ -1129,6 +1161,9 @@ xreal_air_hmd_create_device(struct os_hid_device *sensor_device,
 	m_imu_3dof_init(&hmd->fusion, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
 	m_relation_history_create(&hmd->relation_hist);
 
+	int64_t batch_size = debug_get_num_option_xreal_air_imu_batch();
+	hmd->batch.size = batch_size > 1 ? (uint32_t)batch_size : 1;
+
 	hmd->static_id = 0;
 	hmd->display_on = false;
 	hmd->imu_stream_state = 0;
@@ -1206,6 +1241,7 @@ xreal_air_hmd_create_device(struct os_hid_device *sensor_device,
 	u_var_add_ro_vec3_f32(hmd, &hmd->read.mag, "read.mag");
 	u_var_add_log_level(hmd, &hmd->log_level, "Log level");
 	m_imu_3dof_add_vars(&hmd->fusion, hmd, "Fusion");
+	m_relation_history_add_vars(hmd->relation_hist, hmd, "Fusion");
 	u_var_add_gui_header(hmd, &hmd->gui.calibration, "Calibration");
 	u_var_add_ro_u32(hmd, &hmd->calibration_buffer_len, "calibration_buffer_len");
 	u_var_add_ro_u32(hmd, &hmd->calibration_buffer_pos, "calibration_buffer_pos");
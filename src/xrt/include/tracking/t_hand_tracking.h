@@ -18,6 +18,8 @@
 extern "C" {
 #endif
 
+struct u_worker_thread_pool;
+
 /*!
  * @brief Image boundary type.
  *
@@ -104,6 +106,60 @@ struct t_camera_extra_info
 	struct t_camera_extra_info_one_view views[2];
 };
 
+/*!
+ * A hand found by a hand detector, in the pixels of the camera image.
+ *
+ * @ingroup xrt_iface
+ */
+struct t_hand_detection
+{
+	bool found;
+	float confidence;
+	struct xrt_vec2 center_px;
+	float size_px;
+};
+
+/*!
+ * The hands found in both views of a pair of frames.
+ *
+ * @ingroup xrt_iface
+ */
+struct t_hand_detections
+{
+	//! Timestamp of the frames the detections were made on.
+	uint64_t timestamp_ns;
+
+	//!@todo Hardcoded to 2 views, like @ref t_camera_extra_info. Indexed by view then hand, left hand first.
+	struct t_hand_detection views[2][2];
+};
+
+/*!
+ * Something that runs hand detection on the frames before the hand tracker
+ * gets them, like a camera that runs the detection model on the device. The
+ * tracker uses these instead of running its own detection for the frames.
+ *
+ * @ingroup xrt_iface
+ */
+struct t_hand_detection_source
+{
+	/*!
+	 * Get detections made for the frames with @p timestamp_ns, returns
+	 * false if there are none and the tracker has to detect itself.
+	 */
+	bool (*get)(struct t_hand_detection_source *src, uint64_t timestamp_ns, struct t_hand_detections *out);
+};
+
+/*!
+ * @copydoc t_hand_detection_source::get
+ *
+ * @public @memberof t_hand_detection_source
+ */
+static inline bool
+t_hand_detection_source_get(struct t_hand_detection_source *src, uint64_t timestamp_ns, struct t_hand_detections *out)
+{
+	return src->get(src, timestamp_ns, out);
+}
+
 /*!
  * Creation info for the creation of a hand tracker
  */
@@ -111,6 +167,12 @@ struct t_hand_tracking_create_info
 {
 	struct t_camera_extra_info cams_info;   //!< Extra camera info
 	struct xrt_hand_masks_sink *masks_sink; //!< Optional sink to stream hand bounding boxes to
+
+	//! Optional thread pool to run on, the tracker takes its own reference. If NULL it picks one itself.
+	struct u_worker_thread_pool *pool;
+
+	//! Optional source of hand detections, must outlive the tracker. If NULL the tracker detects hands itself.
+	struct t_hand_detection_source *detections;
 };
 
 /*!
@@ -128,6 +190,19 @@ struct t_hand_tracking_sync
 	                struct xrt_hand_joint_set *out_right_hand,
 	                uint64_t *out_timestamp_ns);
 
+	/*!
+	 * Optional, start work on a pair of frames that only needs the images,
+	 * like looking for new hands. Can run at the same time as @ref process
+	 * for the previous pair, but not at the same time as itself.
+	 *
+	 * Every call is followed by a call to @ref process with the same
+	 * frames, which finishes the work and returns the result as usual.
+	 * Set to NULL if the tracker has nothing to do ahead of time.
+	 */
+	void (*process_begin)(struct t_hand_tracking_sync *ht_sync,
+	                      struct xrt_frame *left_frame,
+	                      struct xrt_frame *right_frame);
+
 	/*!
 	 * Destroy this hand tracker sync object.
 	 */
@@ -150,6 +225,19 @@ t_ht_sync_process(struct t_hand_tracking_sync *ht_sync,
 	ht_sync->process(ht_sync, left_frame, right_frame, out_left_hand, out_right_hand, out_timestamp_ns);
 }
 
+/*!
+ * @copydoc t_hand_tracking_sync::process_begin
+ *
+ * @public @memberof t_hand_tracking_sync
+ */
+static inline void
+t_ht_sync_process_begin(struct t_hand_tracking_sync *ht_sync,
+                        struct xrt_frame *left_frame,
+                        struct xrt_frame *right_frame)
+{
+	ht_sync->process_begin(ht_sync, left_frame, right_frame);
+}
+
 /*!
  * @copydoc t_hand_tracking_sync::destroy
  *
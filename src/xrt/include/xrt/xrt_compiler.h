@@ -81,6 +81,25 @@
 #endif
 
 
+/*!
+ * Size of a cache line on the platforms we run on, used to keep data that is
+ * written by different threads or processes apart. Plain literal because
+ * `__declspec(align())` doesn't take an expression.
+ */
+#define XRT_CACHE_LINE_SIZE 64
+
+/*
+ * To align a struct member, goes in front of the declaration.
+ */
+#if defined(__cplusplus)
+#define XRT_ALIGNAS(N) alignas(N)
+#elif defined(_MSC_VER)
+#define XRT_ALIGNAS(N) __declspec(align(N))
+#else
+#define XRT_ALIGNAS(N) _Alignas(N)
+#endif
+
+
 #ifdef XRT_DOXYGEN
 /*!
  * To trigger a trap/break in the debugger.
@@ -130,6 +130,13 @@ enum xrt_layer_composition_flags
 	 * see XrCompositionLayerDepthTestFB.
 	 */
 	XRT_LAYER_COMPOSITION_DEPTH_TEST = 1u << 10u,
+
+	/*!
+	 * The projection depth layer has motion vectors, so the compositor may
+	 * extrapolate it to frames the app did not render, see
+	 * @ref xrt_layer_space_warp_data and XrCompositionLayerSpaceWarpInfoFB.
+	 */
+	XRT_LAYER_COMPOSITION_SPACE_WARP_BIT = 1u << 11u,
 };
 
 /*!
@@ -250,6 +257,25 @@ struct xrt_layer_depth_data
 	float far_z;
 };
 
+/*!
+ * The motion vectors for one view of a projection depth layer, only valid if
+ * @ref XRT_LAYER_COMPOSITION_SPACE_WARP_BIT is set.
+ *
+ * The @ref xrt_swapchain references and @ref xrt_device are provided outside of
+ * this struct.
+ */
+struct xrt_layer_space_warp_data
+{
+	//! Motion vectors in NDC, from the previous frame to this one, in the red and green channels.
+	struct xrt_sub_image motion_sub;
+
+	//! Motion of the layer's space since the previous frame.
+	struct xrt_pose app_space_delta_pose;
+
+	//! Time between the previous frame and this one, what the motion vectors span, 0 if not known.
+	int64_t frame_interval_ns;
+};
+
 struct xrt_layer_depth_test_data
 {
 	bool depth_mask;
@@ -268,6 +294,9 @@ struct xrt_layer_projection_depth_data
 	struct xrt_layer_projection_view_data v[XRT_MAX_VIEWS];
 
 	struct xrt_layer_depth_data d[XRT_MAX_VIEWS];
+
+	//! Only valid if @ref XRT_LAYER_COMPOSITION_SPACE_WARP_BIT is set.
+	struct xrt_layer_space_warp_data w[XRT_MAX_VIEWS];
 };
 
 /*!
@@ -481,6 +510,29 @@ struct xrt_layer_frame_data
 	enum xrt_blend_mode env_blend_mode;
 };
 
+/*!
+ * A single layer given to @ref xrt_compositor::layer_batch, which swapchains
+ * are used depends on xrt_layer_data::type, the same way as for the individual
+ * layer functions, unused swapchain pointers must be NULL.
+ */
+struct xrt_layer_batch_entry
+{
+	//! The device the layer is relative to.
+	struct xrt_device *xdev;
+
+	//! Colour swapchains, one per view for projection layers, otherwise only the first is used.
+	struct xrt_swapchain *xsc[XRT_MAX_VIEWS];
+
+	//! Depth swapchains, only used for @ref XRT_LAYER_PROJECTION_DEPTH layers.
+	struct xrt_swapchain *d_xsc[XRT_MAX_VIEWS];
+
+	//! Motion vector swapchains, only used if @ref XRT_LAYER_COMPOSITION_SPACE_WARP_BIT is set.
+	struct xrt_swapchain *mv_xsc[XRT_MAX_VIEWS];
+
+	//! All of the pure data bits, same as for the individual layer functions.
+	struct xrt_layer_data data;
+};
+
 
 /*
  *
@@ -497,6 +549,8 @@ enum xrt_swapchain_create_flags
 	XRT_SWAPCHAIN_CREATE_PROTECTED_CONTENT = (1u << 0u),
 	//! Signals that the allocator should only allocate one image.
 	XRT_SWAPCHAIN_CREATE_STATIC_IMAGE = (1u << 1u),
+	//! The client should create a fragment density map per image, only the Vulkan client does.
+	XRT_SWAPCHAIN_CREATE_FOVEATION_FRAGMENT_DENSITY_MAP = (1u << 2u),
 };
 
 /*!
@@ -523,6 +577,27 @@ enum xrt_barrier_direction
 	XRT_BARRIER_TO_COMP = 2,
 };
 
+/*!
+ * Describes where and how much a swapchain image may be rendered at lower
+ * density, the density is full inside of @ref inner_radius and falls off to
+ * @ref outer_density at @ref outer_radius. All distances are in normalized
+ * image coordinates, with the horizontal axis scaled to match the vertical.
+ */
+struct xrt_foveation_params
+{
+	//! Center of foveation per view, in normalized image coordinates.
+	struct xrt_vec2 centers[XRT_MAX_VIEWS];
+
+	//! Full density inside of this distance from the center.
+	float inner_radius;
+
+	//! Distance at which the density reaches @ref outer_density.
+	float outer_radius;
+
+	//! Density of the periphery, in the range (0, 1].
+	float outer_density;
+};
+
 /*!
  * @interface xrt_swapchain
  *
@@ -604,6 +679,20 @@ struct xrt_swapchain
 	 * See xrReleaseSwapchainImage, state tracker needs to track index.
 	 */
 	xrt_result_t (*release_image)(struct xrt_swapchain *xsc, uint32_t index);
+
+	/*!
+	 * Update the foveation of image @p index, called after the image has
+	 * been waited on and before the application renders to it. Only
+	 * swapchains created with @ref XRT_SWAPCHAIN_CREATE_FOVEATION_FRAGMENT_DENSITY_MAP
+	 * implement this, optional.
+	 *
+	 * @param xsc    Self pointer
+	 * @param index  Image index to update.
+	 * @param params Foveation to apply.
+	 */
+	xrt_result_t (*set_foveation)(struct xrt_swapchain *xsc,
+	                              uint32_t index,
+	                              const struct xrt_foveation_params *params);
 };
 
 /*!
@@ -717,6 +806,23 @@ xrt_swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 	return xsc->release_image(xsc, index);
 }
 
+/*!
+ * @copydoc xrt_swapchain::set_foveation
+ *
+ * Helper for calling through the function pointer.
+ *
+ * @public @memberof xrt_swapchain
+ */
+static inline xrt_result_t
+xrt_swapchain_set_foveation(struct xrt_swapchain *xsc, uint32_t index, const struct xrt_foveation_params *params)
+{
+	if (xsc->set_foveation == NULL) {
+		return XRT_ERROR_COMPOSITOR_FUNCTION_NOT_IMPLEMENTED;
+	}
+
+	return xsc->set_foveation(xsc, index, params);
+}
+
 
 /*
  *
@@ -1240,6 +1346,29 @@ struct xrt_compositor
 	                                       struct xrt_swapchain *d_xsc[XRT_MAX_VIEWS],
 	                                       const struct xrt_layer_data *data);
 
+	/*!
+	 * @brief Adds a projection layer with depth and motion vectors for
+	 * submission, @p data has @ref XRT_LAYER_COMPOSITION_SPACE_WARP_BIT set.
+	 *
+	 * Optional, compositors that can't use the motion vectors leave this
+	 * NULL and get a plain depth projection layer instead.
+	 *
+	 * @param xc          Self pointer
+	 * @param xdev        The device the layer is relative to.
+	 * @param xsc         Swapchain objects containing the RGB data.
+	 * @param d_xsc       Swapchain objects containing the depth data.
+	 * @param mv_xsc      Swapchain objects containing the motion vectors.
+	 * @param data        All of the pure data bits (not pointers/handles),
+	 *                    including what parts of the supplied swapchain
+	 *                    objects to use for each view.
+	 */
+	xrt_result_t (*layer_projection_space_warp)(struct xrt_compositor *xc,
+	                                            struct xrt_device *xdev,
+	                                            struct xrt_swapchain *xsc[XRT_MAX_VIEWS],
+	                                            struct xrt_swapchain *d_xsc[XRT_MAX_VIEWS],
+	                                            struct xrt_swapchain *mv_xsc[XRT_MAX_VIEWS],
+	                                            const struct xrt_layer_data *data);
+
 	/*!
 	 * Adds a quad layer for submission, the center of the quad is specified
 	 * by the pose and extends outwards from it.
@@ -1330,6 +1459,23 @@ struct xrt_compositor
 	                                  struct xrt_device *xdev,
 	                                  const struct xrt_layer_data *data);
 
+	/*!
+	 * Adds a number of layers of any type for submission in one call, this
+	 * is equivalent to calling the individual layer functions in order.
+	 *
+	 * Optional, @ref xrt_comp_layer_batch falls back to the individual
+	 * layer functions if not implemented.
+	 *
+	 * @param xc          Self pointer
+	 * @param entries     Layers to add, the compositor may modify the
+	 *                    entries in place, for example to swap in the
+	 *                    native swapchains before passing them on.
+	 * @param entry_count Number of entries.
+	 */
+	xrt_result_t (*layer_batch)(struct xrt_compositor *xc,
+	                            struct xrt_layer_batch_entry *entries,
+	                            uint32_t entry_count);
+
 	/*!
 	 * @brief Commits all of the submitted layers.
 	 *
@@ -1716,6 +1862,32 @@ xrt_comp_layer_projection_depth(struct xrt_compositor *xc,
 	return xc->layer_projection_depth(xc, xdev, xsc, d_xsc, data);
 }
 
+/*!
+ * @copydoc xrt_compositor::layer_projection_space_warp
+ *
+ * Helper for calling through the function pointer, drops the motion vectors
+ * and adds a depth projection layer if the compositor doesn't implement it.
+ *
+ * @public @memberof xrt_compositor
+ */
+static inline xrt_result_t
+xrt_comp_layer_projection_space_warp(struct xrt_compositor *xc,
+                                     struct xrt_device *xdev,
+                                     struct xrt_swapchain *xsc[XRT_MAX_VIEWS],
+                                     struct xrt_swapchain *d_xsc[XRT_MAX_VIEWS],
+                                     struct xrt_swapchain *mv_xsc[XRT_MAX_VIEWS],
+                                     const struct xrt_layer_data *data)
+{
+	if (xc->layer_projection_space_warp != NULL) {
+		return xc->layer_projection_space_warp(xc, xdev, xsc, d_xsc, mv_xsc, data);
+	}
+
+	struct xrt_layer_data depth_data = *data;
+	depth_data.flags = (enum xrt_layer_composition_flags)(data->flags & ~XRT_LAYER_COMPOSITION_SPACE_WARP_BIT);
+
+	return xc->layer_projection_depth(xc, xdev, xsc, d_xsc, &depth_data);
+}
+
 /*!
  * @copydoc xrt_compositor::layer_quad
  *
@@ -1810,6 +1982,52 @@ xrt_comp_layer_passthrough(struct xrt_compositor *xc, struct xrt_device *xdev, c
 	return xc->layer_passthrough(xc, xdev, data);
 }
 
+/*!
+ * @copydoc xrt_compositor::layer_batch
+ *
+ * Helper for calling through the function pointer, calls the individual layer
+ * functions if the compositor doesn't implement it.
+ *
+ * @public @memberof xrt_compositor
+ */
+static inline xrt_result_t
+xrt_comp_layer_batch(struct xrt_compositor *xc, struct xrt_layer_batch_entry *entries, uint32_t entry_count)
+{
+	if (xc->layer_batch != NULL) {
+		return xc->layer_batch(xc, entries, entry_count);
+	}
+
+	for (uint32_t i = 0; i < entry_count; i++) {
+		struct xrt_layer_batch_entry *e = &entries[i];
+		xrt_result_t xret;
+
+		switch (e->data.type) {
+		case XRT_LAYER_PROJECTION: xret = xc->layer_projection(xc, e->xdev, e->xsc, &e->data); break;
+		case XRT_LAYER_PROJECTION_DEPTH:
+			if ((e->data.flags & XRT_LAYER_COMPOSITION_SPACE_WARP_BIT) != 0) {
+				xret = xrt_comp_layer_projection_space_warp(xc, e->xdev, e->xsc, e->d_xsc, e->mv_xsc,
+				                                            &e->data);
+			} else {
+				xret = xc->layer_projection_depth(xc, e->xdev, e->xsc, e->d_xsc, &e->data);
+			}
+			break;
+		case XRT_LAYER_QUAD: xret = xc->layer_quad(xc, e->xdev, e->xsc[0], &e->data); break;
+		case XRT_LAYER_CUBE: xret = xc->layer_cube(xc, e->xdev, e->xsc[0], &e->data); break;
+		case XRT_LAYER_CYLINDER: xret = xc->layer_cylinder(xc, e->xdev, e->xsc[0], &e->data); break;
+		case XRT_LAYER_EQUIRECT1: xret = xc->layer_equirect1(xc, e->xdev, e->xsc[0], &e->data); break;
+		case XRT_LAYER_EQUIRECT2: xret = xc->layer_equirect2(xc, e->xdev, e->xsc[0], &e->data); break;
+		case XRT_LAYER_PASSTHROUGH: xret = xc->layer_passthrough(xc, e->xdev, &e->data); break;
+		default: xret = XRT_ERROR_COMPOSITOR_FUNCTION_NOT_IMPLEMENTED; break;
+		}
+
+		if (xret != XRT_SUCCESS) {
+			return xret;
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
 /*!
  * @copydoc xrt_compositor::layer_commit
  *
@@ -2013,6 +2231,16 @@ struct xrt_swapchain_vk
 
 	//! Images to be used by the caller.
 	VkImage images[XRT_MAX_SWAPCHAIN_IMAGES];
+
+	/*!
+	 * Fragment density map for each image, only set when created with
+	 * @ref XRT_SWAPCHAIN_CREATE_FOVEATION_FRAGMENT_DENSITY_MAP, has the
+	 * same number of array layers as the images.
+	 */
+	VkImage fdm_images[XRT_MAX_SWAPCHAIN_IMAGES];
+
+	//! Size of the fragment density maps in texels.
+	uint32_t fdm_width, fdm_height;
 };
 
 /*!
@@ -2343,6 +2571,74 @@ struct xrt_system_compositor_info
 
 struct xrt_system_compositor;
 
+/*!
+ * Frame and GPU time statistics of one client of a multi client system
+ * compositor, counters only ever go up and averages are smoothed over the
+ * last few frames.
+ *
+ * @see xrt_multi_compositor_control::get_client_stats
+ */
+struct xrt_multi_compositor_client_stats
+{
+	//! From the client beginning a frame to committing it.
+	uint64_t app_cpu_ns;
+	uint64_t app_cpu_avg_ns;
+
+	//! From the client committing a frame to its GPU work being done.
+	uint64_t client_gpu_ns;
+	uint64_t client_gpu_avg_ns;
+
+	//! This client's share of the GPU time the compositor spends on layers.
+	uint64_t compositor_gpu_ns;
+	uint64_t compositor_gpu_avg_ns;
+
+	//! Layers of this client given to the compositor last frame.
+	uint32_t layer_count;
+
+	//! Number of client frames whose GPU work was measured.
+	uint64_t frame_count;
+
+	//! Frames whose GPU work took longer than a display period.
+	uint64_t over_budget_count;
+
+	//! Frames picked up by the compositor to be shown.
+	uint64_t delivered_count;
+
+	//! Frames replaced by a newer one before being shown.
+	uint64_t dropped_count;
+
+	//! Frames discarded by the client.
+	uint64_t discarded_count;
+
+	//! Memory of the swapchains created by this client, imported ones are not counted.
+	uint64_t swapchain_bytes;
+};
+
+/*!
+ * Frame statistics of the render loop of a multi client system compositor.
+ *
+ * @see xrt_multi_compositor_control::get_stats
+ */
+struct xrt_multi_compositor_stats
+{
+	//! Number of frames given to the native compositor.
+	uint64_t frame_count;
+
+	//! Time between the starts of two frames.
+	uint64_t frame_period_ns;
+	uint64_t frame_period_avg_ns;
+
+	//! Display period the native compositor predicted.
+	uint64_t display_period_ns;
+
+	//! GPU time the native compositor predicted for its own work.
+	uint64_t compositor_gpu_ns;
+	uint64_t compositor_gpu_avg_ns;
+
+	//! Frames that started more than half a display period late.
+	uint64_t late_count;
+};
+
 /*!
  * @interface xrt_multi_compositor_control
  * Special functions to control multi session/clients.
@@ -2397,6 +2693,20 @@ struct xrt_multi_compositor_control
 	                                               struct xrt_compositor *xc,
 	                                               float from_display_refresh_rate_hz,
 	                                               float to_display_refresh_rate_hz);
+
+	/*!
+	 * Get the frame statistics of this client and how much GPU time it and
+	 * the compositing of its layers takes, so that misbehaving clients can
+	 * be found and throttled.
+	 */
+	xrt_result_t (*get_client_stats)(struct xrt_system_compositor *xsc,
+	                                 struct xrt_compositor *xc,
+	                                 struct xrt_multi_compositor_client_stats *out_stats);
+
+	/*!
+	 * Get the frame statistics of the render loop combining the clients.
+	 */
+	xrt_result_t (*get_stats)(struct xrt_system_compositor *xsc, struct xrt_multi_compositor_stats *out_stats);
 };
 
 /*!
@@ -2573,6 +2883,48 @@ xrt_syscomp_notify_display_refresh_changed(struct xrt_system_compositor *xsc,
 	                                                 to_display_refresh_rate_hz);
 }
 
+/*!
+ * @copydoc xrt_multi_compositor_control::get_client_stats
+ *
+ * Helper for calling through the function pointer.
+ *
+ * If the system compositor @p xsc does not implement @ref xrt_multi_compositor_control,
+ * this returns @ref XRT_ERROR_MULTI_SESSION_NOT_IMPLEMENTED.
+ *
+ * @public @memberof xrt_system_compositor
+ */
+static inline xrt_result_t
+xrt_syscomp_get_client_stats(struct xrt_system_compositor *xsc,
+                             struct xrt_compositor *xc,
+                             struct xrt_multi_compositor_client_stats *out_stats)
+{
+	if (xsc->xmcc == NULL) {
+		return XRT_ERROR_MULTI_SESSION_NOT_IMPLEMENTED;
+	}
+
+	return xsc->xmcc->get_client_stats(xsc, xc, out_stats);
+}
+
+/*!
+ * @copydoc xrt_multi_compositor_control::get_stats
+ *
+ * Helper for calling through the function pointer.
+ *
+ * If the system compositor @p xsc does not implement @ref xrt_multi_compositor_control,
+ * this returns @ref XRT_ERROR_MULTI_SESSION_NOT_IMPLEMENTED.
+ *
+ * @public @memberof xrt_system_compositor
+ */
+static inline xrt_result_t
+xrt_syscomp_get_stats(struct xrt_system_compositor *xsc, struct xrt_multi_compositor_stats *out_stats)
+{
+	if (xsc->xmcc == NULL) {
+		return XRT_ERROR_MULTI_SESSION_NOT_IMPLEMENTED;
+	}
+
+	return xsc->xmcc->get_stats(xsc, out_stats);
+}
+
 /*!
  * @copydoc xrt_system_compositor::create_native_compositor
  *
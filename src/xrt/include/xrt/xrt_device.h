@@ -269,6 +269,13 @@ struct xrt_device
 	bool stage_supported;
 	bool face_tracking_supported;
 
+	/*!
+	 * The head pose is predicted from the newest IMU sample at the time of
+	 * the call, so querying it again right before scanout gives a fresher
+	 * pose. The compositor uses this to turn on late latching.
+	 */
+	bool late_pose_refinement_supported;
+
 	/*
 	 *
 	 * Functions.
@@ -311,6 +318,25 @@ struct xrt_device
 	                         uint64_t at_timestamp_ns,
 	                         struct xrt_space_relation *out_relation);
 
+	/*!
+	 * Optional, same as @ref get_tracked_pose but for several timestamps
+	 * at once, for devices that can answer them cheaper together than one
+	 * by one. Set to NULL if not implemented, then
+	 * @ref xrt_device_get_tracked_poses calls @ref get_tracked_pose for
+	 * each timestamp.
+	 *
+	 * @param[in] xdev             The device.
+	 * @param[in] name             Which pose, see @ref get_tracked_pose.
+	 * @param[in] at_timestamps_ns Array of @p count timestamps.
+	 * @param[in] count            Number of timestamps.
+	 * @param[out] out_relations   Array of @p count relations read from the device.
+	 */
+	void (*get_tracked_poses)(struct xrt_device *xdev,
+	                          enum xrt_input_name name,
+	                          const uint64_t *at_timestamps_ns,
+	                          uint32_t count,
+	                          struct xrt_space_relation *out_relations);
+
 	/*!
 	 * @brief Get relationship of hand joints to the tracking origin space as
 	 * the base space.
@@ -507,6 +533,31 @@ xrt_device_get_tracked_pose(struct xrt_device *xdev,
 	xdev->get_tracked_pose(xdev, name, at_timestamp_ns, out_relation);
 }
 
+/*!
+ * Helper function for @ref xrt_device::get_tracked_poses, falls back to
+ * calling @ref xrt_device::get_tracked_pose for each timestamp.
+ *
+ * @copydoc xrt_device::get_tracked_poses
+ *
+ * @public @memberof xrt_device
+ */
+static inline void
+xrt_device_get_tracked_poses(struct xrt_device *xdev,
+                             enum xrt_input_name name,
+                             const uint64_t *at_timestamps_ns,
+                             uint32_t count,
+                             struct xrt_space_relation *out_relations)
+{
+	if (xdev->get_tracked_poses != NULL) {
+		xdev->get_tracked_poses(xdev, name, at_timestamps_ns, count, out_relations);
+		return;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		xdev->get_tracked_pose(xdev, name, at_timestamps_ns[i], &out_relations[i]);
+	}
+}
+
 /*!
  * Helper function for @ref xrt_device::get_hand_tracking.
  *
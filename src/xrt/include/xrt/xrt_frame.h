@@ -10,6 +10,7 @@
 #pragma once
 
 #include "xrt/xrt_defines.h"
+#include "xrt/xrt_handles.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,6 +41,21 @@ struct xrt_frame
 	uint64_t source_timestamp;
 	uint64_t source_sequence; //!< sequence id
 	uint64_t source_id;       //!< Which @ref xrt_fs this frame originated from.
+
+	/*!
+	 * Optional native buffer (a dma-buf on Linux) that @ref data is a CPU
+	 * mapping of, so GPU consumers can import the frame without a copy.
+	 * Only valid if @ref has_buffer_handle is set. Owned by the producer
+	 * and only valid while the frame is alive, consumers that keep it
+	 * around need to duplicate it.
+	 */
+	xrt_graphics_buffer_handle_t buffer_handle;
+
+	//! Offset in bytes of the first pixel from the start of @ref buffer_handle.
+	size_t buffer_offset;
+
+	//! Is @ref buffer_handle valid, frames are often zero initialized.
+	bool has_buffer_handle;
 };
 
 
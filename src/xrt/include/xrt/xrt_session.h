@@ -61,6 +61,9 @@ enum xrt_session_event_type
 
 	//! The passthrough state of the session has changed
 	XRT_SESSION_EVENT_PASSTHRU_STATE_CHANGE = 8,
+
+	//! The compositor recommends a different resolution for the session.
+	XRT_SESSION_EVENT_RECOMMENDED_RESOLUTION_CHANGE = 9,
 };
 
 /*!
@@ -164,6 +167,23 @@ struct xrt_session_event_passthrough_state_change
 	enum xrt_passthrough_state state;
 };
 
+/*!
+ * Recommended resolution change event,
+ * type @ref XRT_SESSION_EVENT_RECOMMENDED_RESOLUTION_CHANGE.
+ *
+ * The scale applies per axis to the recommended image size of the views, the
+ * session can render to a smaller image rect of the same swapchains.
+ *
+ * @see xrt_session_event
+ * @ingroup xrt_iface
+ */
+struct xrt_session_event_recommended_resolution_change
+{
+	enum xrt_session_event_type type;
+	float from_scale;
+	float to_scale;
+};
+
 /*!
  * Union of all session events, used to return multiple events through one call.
  * Each event struct must start with a @ref xrt_session_event_type field.
@@ -181,6 +201,7 @@ union xrt_session_event {
 	struct xrt_session_event_reference_space_change_pending ref_change;
 	struct xrt_session_event_perf_change performance;
 	struct xrt_session_event_passthrough_state_change passthru;
+	struct xrt_session_event_recommended_resolution_change resolution;
 };
 
 /*!
@@ -171,6 +171,13 @@ struct xrt_imu_sink
 	 * Push an IMU sample into the sink
 	 */
 	void (*push_imu)(struct xrt_imu_sink *, struct xrt_imu_sample *sample);
+
+	/*!
+	 * Push @p count IMU samples, oldest first, into the sink in one go.
+	 * Optional, @ref xrt_sink_push_imu_batch falls back to calling
+	 * @ref push_imu for each sample when this is NULL.
+	 */
+	void (*push_imu_batch)(struct xrt_imu_sink *, struct xrt_imu_sample *samples, uint32_t count);
 };
 
 /*!
@@ -314,6 +321,25 @@ xrt_sink_push_imu(struct xrt_imu_sink *sink, struct xrt_imu_sample *sample)
 	sink->push_imu(sink, sample);
 }
 
+/*!
+ * Push several IMU samples, oldest first, uses the batch function of the sink
+ * if it has one.
+ *
+ * @public @memberof xrt_imu_sink
+ */
+static inline void
+xrt_sink_push_imu_batch(struct xrt_imu_sink *sink, struct xrt_imu_sample *samples, uint32_t count)
+{
+	if (sink->push_imu_batch != NULL) {
+		sink->push_imu_batch(sink, samples, count);
+		return;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		sink->push_imu(sink, &samples[i]);
+	}
+}
+
 //! @public @memberof xrt_pose_sink
 static inline void
 xrt_sink_push_pose(struct xrt_pose_sink *sink, struct xrt_pose_sample *sample)
@@ -17,6 +17,9 @@
 #include "util/u_threading.h"
 #include "util/u_logging.h"
 
+#include "shared/ipc_ring.h"
+#include "shared/ipc_capture.h"
+#include "shared/ipc_scratch.h"
 #include "shared/ipc_utils.h"
 #include "shared/ipc_protocol.h"
 #include "shared/ipc_message_channel.h"
@@ -36,6 +39,14 @@
 #define IPC_WARN(IPC_C, ...) U_LOG_IFL_W((IPC_C)->imc.log_level, __VA_ARGS__)
 #define IPC_ERROR(IPC_C, ...) U_LOG_IFL_E((IPC_C)->imc.log_level, __VA_ARGS__)
 
+/*!
+ * How many calls of a command are collected by @ref ipc_client_record_call_locked
+ * before the latencies are sent to the service.
+ *
+ * @ingroup ipc_client
+ */
+#define IPC_CLIENT_STATS_REPORT_INTERVAL 256
+
 /*!
  * This define will error if `XRET` is not `XRT_SUCCESS`, printing out that the
  * @p FUNC_STR string has failed, then returns @p XRET. The argument @p IPC_C
@@ -159,6 +170,24 @@ struct ipc_connection
 	struct ipc_shared_memory *ism;
 	xrt_shmem_handle_t ism_handle;
 
+	//! Size of the mapping of @ref ism, given to us by the service.
+	size_t ism_size;
+
+	//! Shared memory ring for calls without handles, if set up by the server.
+	struct ipc_ring ring;
+
+	//! Arena for variable length payloads, payloads go inline if not active.
+	struct ipc_scratch scratch;
+
+	//! End-to-end latency of calls not yet reported to the service, protected by @ref mutex.
+	struct ipc_latency_histogram call_stats[IPC_MAX_COMMANDS];
+
+	//! Calls are written to this file if capturing, protected by @ref mutex.
+	FILE *capture_file;
+
+	//! Timestamps in the capture file are relative to this.
+	uint64_t capture_start_ns;
+
 	struct os_mutex mutex;
 
 #ifdef XRT_OS_ANDROID
@@ -179,6 +208,9 @@ struct ipc_client_xdev
 	struct ipc_connection *ipc_c;
 
 	uint32_t device_id;
+
+	//! Generation of the inputs from the last update, zero if the next call can not be skipped.
+	int32_t input_generation;
 };
 
 
@@ -188,6 +220,85 @@ struct ipc_client_xdev
  *
  */
 
+/*!
+ * Write a call to the capture file, see @ref ipc_capture_record. Only called
+ * when capturing, the connection mutex must be held.
+ *
+ * @ingroup ipc_client
+ */
+void
+ipc_client_capture_call_locked(struct ipc_connection *ipc_c, const void *msg, size_t msg_size, uint32_t reply_size);
+
+/*!
+ * Send a message and wait for its reply, uses the shared memory ring if it
+ * is active and the message fits, otherwise falls back to the socket. Only for
+ * calls without any handles, the connection mutex must be held.
+ *
+ * @ingroup ipc_client
+ */
+static inline xrt_result_t
+ipc_client_transact_locked(
+    struct ipc_connection *ipc_c, const void *msg, size_t msg_size, void *out_reply, size_t reply_size)
+{
+	if (ipc_c->capture_file != NULL) {
+		ipc_client_capture_call_locked(ipc_c, msg, msg_size, (uint32_t)reply_size);
+	}
+
+	if (ipc_ring_is_active(&ipc_c->ring) && msg_size <= IPC_BUF_SIZE && reply_size <= IPC_RING_SLOT_SIZE) {
+		return ipc_ring_client_call(&ipc_c->ring, &ipc_c->imc, msg, msg_size, out_reply, reply_size);
+	}
+
+	xrt_result_t xret = ipc_send(&ipc_c->imc, msg, msg_size);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	return ipc_receive(&ipc_c->imc, out_reply, reply_size);
+}
+
+/*!
+ * Send a message without waiting for a reply, for one-way calls, uses the ring
+ * if it is active. Any failure on the service side is returned by the next
+ * call that does have a reply, the connection mutex must be held.
+ *
+ * @ingroup ipc_client
+ */
+static inline xrt_result_t
+ipc_client_post_locked(struct ipc_connection *ipc_c, const void *msg, size_t msg_size)
+{
+	if (ipc_c->capture_file != NULL) {
+		ipc_client_capture_call_locked(ipc_c, msg, msg_size, IPC_CAPTURE_NO_REPLY);
+	}
+
+	if (ipc_ring_is_active(&ipc_c->ring) && msg_size <= IPC_BUF_SIZE) {
+		return ipc_ring_client_send(&ipc_c->ring, &ipc_c->imc, msg, msg_size);
+	}
+
+	return ipc_send(&ipc_c->imc, msg, msg_size);
+}
+
+/*!
+ * Record how long a call took from the callers point of view, the collected
+ * samples are sent to the service every
+ * @ref IPC_CLIENT_STATS_REPORT_INTERVAL calls of a command and when the
+ * connection is closed. The connection mutex must be held.
+ *
+ * @ingroup ipc_client
+ */
+void
+ipc_client_record_call_locked(struct ipc_connection *ipc_c, uint32_t command, uint64_t duration_ns);
+
+/*!
+ * Bring the private copy of the inputs up to date with the service. If the
+ * service has published exactly one generation since the last update only the
+ * changed inputs are copied from the shared memory, otherwise the update call
+ * is made and all of them are copied.
+ *
+ * @ingroup ipc_client
+ */
+void
+ipc_client_xdev_update_inputs(struct ipc_client_xdev *icx);
+
 /*!
  * Convenience helper to go from a xdev to @ref ipc_client_xdev.
  *
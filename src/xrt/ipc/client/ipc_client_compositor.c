@@ -19,6 +19,7 @@
 #include "util/u_misc.h"
 #include "util/u_wait.h"
 #include "util/u_handles.h"
+#include "util/u_index_fifo.h"
 #include "util/u_trace_marker.h"
 #include "util/u_limited_unique_id.h"
 
@@ -74,6 +75,12 @@ struct ipc_client_compositor
 		uint32_t layer_count;
 	} layers;
 
+	/*!
+	 * Images not used by the compositor as of the last commit, bit per
+	 * image indexed by swapchain id, lets wait image skip the IPC call.
+	 */
+	uint32_t unused_images[IPC_MAX_CLIENT_SWAPCHAINS];
+
 	//! Has the native compositor been created, only supports one for now.
 	bool compositor_created;
 
@@ -97,6 +104,13 @@ struct ipc_client_swapchain
 	struct ipc_client_compositor *icc;
 
 	uint32_t id;
+
+	//! Images released by the app, acquire and release never go to the server.
+	struct u_index_fifo fifo;
+
+	//! Our own references to images from the client side allocator, given back to it on destroy.
+	struct xrt_image_native allocated_images[XRT_MAX_SWAPCHAIN_IMAGES];
+	uint32_t allocated_image_count;
 };
 
 /*!
@@ -137,6 +151,29 @@ ipc_client_compositor_semaphore(struct xrt_compositor_semaphore *xcsem)
 	return (struct ipc_client_compositor_semaphore *)xcsem;
 }
 
+static void
+swapchain_init_image_state(struct ipc_client_compositor *icc, struct ipc_client_swapchain *ics)
+{
+	uint32_t image_count = ics->base.base.image_count;
+
+	for (uint32_t i = 0; i < image_count; i++) {
+		u_index_fifo_push(&ics->fifo, i);
+	}
+
+	// A new swapchain hasn't been used by the compositor yet.
+	if (ics->id < IPC_MAX_CLIENT_SWAPCHAINS) {
+		icc->unused_images[ics->id] = (uint32_t)((1ull << image_count) - 1);
+	}
+}
+
+static void
+update_image_states(struct ipc_client_compositor *icc, const struct ipc_swapchain_image_states *states)
+{
+	for (uint32_t i = 0; i < IPC_MAX_CLIENT_SWAPCHAINS; i++) {
+		icc->unused_images[i] = states->unused_masks[i];
+	}
+}
+
 
 /*
  *
@@ -179,6 +216,11 @@ ipc_compositor_swapchain_destroy(struct xrt_swapchain *xsc)
 	// Can't return anything here, just continue.
 	IPC_CHK_ONLY_PRINT(icc->ipc_c, xret, "ipc_call_compositor_semaphore_destroy");
 
+	// The server is done with them, let the allocator reuse the images.
+	if (ics->allocated_image_count > 0) {
+		xrt_images_free(icc->xina, ics->allocated_image_count, ics->allocated_images);
+	}
+
 	free(xsc);
 }
 
@@ -189,6 +231,14 @@ ipc_compositor_swapchain_wait_image(struct xrt_swapchain *xsc, uint64_t timeout_
 	struct ipc_client_compositor *icc = ics->icc;
 	xrt_result_t xret;
 
+	/*
+	 * The compositor only starts using images on commit, so if it wasn't
+	 * using the image at the last commit it still isn't, no need to ask.
+	 */
+	if (ics->id < IPC_MAX_CLIENT_SWAPCHAINS && (icc->unused_images[ics->id] & (1u << index)) != 0) {
+		return XRT_SUCCESS;
+	}
+
 	xret = ipc_call_swapchain_wait_image(icc->ipc_c, ics->id, timeout_ns, index);
 	IPC_CHK_ALWAYS_RET(icc->ipc_c, xret, "ipc_call_swapchain_wait_image");
 }
@@ -197,22 +247,23 @@ static xrt_result_t
 ipc_compositor_swapchain_acquire_image(struct xrt_swapchain *xsc, uint32_t *out_index)
 {
 	struct ipc_client_swapchain *ics = ipc_client_swapchain(xsc);
-	struct ipc_client_compositor *icc = ics->icc;
-	xrt_result_t xret;
 
-	xret = ipc_call_swapchain_acquire_image(icc->ipc_c, ics->id, out_index);
-	IPC_CHK_ALWAYS_RET(icc->ipc_c, xret, "ipc_call_swapchain_acquire_image");
+	// Returns negative on empty fifo.
+	if (u_index_fifo_pop(&ics->fifo, out_index) < 0) {
+		return XRT_ERROR_NO_IMAGE_AVAILABLE;
+	}
+
+	return XRT_SUCCESS;
 }
 
 static xrt_result_t
 ipc_compositor_swapchain_release_image(struct xrt_swapchain *xsc, uint32_t index)
 {
 	struct ipc_client_swapchain *ics = ipc_client_swapchain(xsc);
-	struct ipc_client_compositor *icc = ics->icc;
-	xrt_result_t xret;
 
-	xret = ipc_call_swapchain_release_image(icc->ipc_c, ics->id, index);
-	IPC_CHK_ALWAYS_RET(icc->ipc_c, xret, "ipc_call_swapchain_release_image");
+	u_index_fifo_push(&ics->fifo, index);
+
+	return XRT_SUCCESS;
 }
 
 
@@ -300,6 +351,7 @@ swapchain_server_create(struct ipc_client_compositor *icc,
 	ics->base.limited_unique_id = u_limited_unique_id_get();
 	ics->icc = icc;
 	ics->id = handle;
+	swapchain_init_image_state(icc, ics);
 
 	for (uint32_t i = 0; i < image_count; i++) {
 		ics->base.images[i].handle = remote_handles[i];
@@ -357,6 +409,7 @@ swapchain_server_import(struct ipc_client_compositor *icc,
 	ics->base.limited_unique_id = u_limited_unique_id_get();
 	ics->icc = icc;
 	ics->id = id;
+	swapchain_init_image_state(icc, ics);
 
 	// The handles were copied in the IPC call so we can reuse them here.
 	for (uint32_t i = 0; i < image_count; i++) {
@@ -397,6 +450,13 @@ swapchain_allocator_create(struct ipc_client_compositor *icc,
 	IPC_CHK_ONLY_PRINT(icc->ipc_c, xret, "swapchain_server_import");
 	if (xret != XRT_SUCCESS) {
 		xrt_images_free(xina, xsccp.image_count, images);
+	} else {
+		// Other users of the swapchain release the handles themselves, keep an extra reference.
+		struct ipc_client_swapchain *ics = ipc_client_swapchain(*out_xsc);
+		for (uint32_t i = 0; i < xsccp.image_count; i++) {
+			ics->allocated_images[i].handle = u_graphics_buffer_ref(images[i].handle);
+		}
+		ics->allocated_image_count = xsccp.image_count;
 	}
 
 out_free:
@@ -573,7 +633,7 @@ ipc_compositor_layer_begin(struct xrt_compositor *xc, const struct xrt_layer_fra
 	struct ipc_client_compositor *icc = ipc_client_compositor(xc);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shared_memory_slots(ism)[icc->layers.slot_id];
 
 	slot->data = *data;
 
@@ -591,7 +651,7 @@ ipc_compositor_layer_projection(struct xrt_compositor *xc,
 	assert(data->type == XRT_LAYER_PROJECTION);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shared_memory_slots(ism)[icc->layers.slot_id];
 	struct ipc_layer_entry *layer = &slot->layers[icc->layers.layer_count];
 	layer->xdev_id = 0; //! @todo Real id.
 	layer->data = *data;
@@ -617,7 +677,7 @@ ipc_compositor_layer_projection_depth(struct xrt_compositor *xc,
 	assert(data->type == XRT_LAYER_PROJECTION_DEPTH);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shared_memory_slots(ism)[icc->layers.slot_id];
 	struct ipc_layer_entry *layer = &slot->layers[icc->layers.layer_count];
 	struct ipc_client_swapchain *xscn[XRT_MAX_VIEWS];
 	struct ipc_client_swapchain *d_xscn[XRT_MAX_VIEWS];
@@ -639,6 +699,38 @@ ipc_compositor_layer_projection_depth(struct xrt_compositor *xc,
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+ipc_compositor_layer_projection_space_warp(struct xrt_compositor *xc,
+                                           struct xrt_device *xdev,
+                                           struct xrt_swapchain *xsc[XRT_MAX_VIEWS],
+                                           struct xrt_swapchain *d_xsc[XRT_MAX_VIEWS],
+                                           struct xrt_swapchain *mv_xsc[XRT_MAX_VIEWS],
+                                           const struct xrt_layer_data *data)
+{
+	struct ipc_client_compositor *icc = ipc_client_compositor(xc);
+
+	assert(data->type == XRT_LAYER_PROJECTION_DEPTH);
+	assert((data->flags & XRT_LAYER_COMPOSITION_SPACE_WARP_BIT) != 0);
+
+	struct ipc_shared_memory *ism = icc->ipc_c->ism;
+	struct ipc_layer_slot *slot = &ipc_shared_memory_slots(ism)[icc->layers.slot_id];
+	struct ipc_layer_entry *layer = &slot->layers[icc->layers.layer_count];
+	for (uint32_t i = 0; i < data->view_count; ++i) {
+		layer->swapchain_ids[i] = ipc_client_swapchain(xsc[i])->id;
+		layer->swapchain_ids[i + data->view_count] = ipc_client_swapchain(d_xsc[i])->id;
+		layer->swapchain_ids[i + data->view_count * 2] = ipc_client_swapchain(mv_xsc[i])->id;
+	}
+
+	layer->xdev_id = 0; //! @todo Real id.
+
+	layer->data = *data;
+
+	// Increment the number of layers.
+	icc->layers.layer_count++;
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 handle_layer(struct xrt_compositor *xc,
              struct xrt_device *xdev,
@@ -651,7 +743,7 @@ handle_layer(struct xrt_compositor *xc,
 	assert(data->type == type);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shared_memory_slots(ism)[icc->layers.slot_id];
 	struct ipc_layer_entry *layer = &slot->layers[icc->layers.layer_count];
 	struct ipc_client_swapchain *ics = ipc_client_swapchain(xsc);
 
@@ -721,7 +813,7 @@ ipc_compositor_layer_passthrough(struct xrt_compositor *xc, struct xrt_device *x
 	assert(data->type == XRT_LAYER_PASSTHROUGH);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shared_memory_slots(ism)[icc->layers.slot_id];
 	struct ipc_layer_entry *layer = &slot->layers[icc->layers.layer_count];
 
 	layer->xdev_id = 0; //! @todo Real id.
@@ -733,16 +825,65 @@ ipc_compositor_layer_passthrough(struct xrt_compositor *xc, struct xrt_device *x
 	return XRT_SUCCESS;
 }
 
+static xrt_result_t
+ipc_compositor_layer_batch(struct xrt_compositor *xc, struct xrt_layer_batch_entry *entries, uint32_t entry_count)
+{
+	struct ipc_client_compositor *icc = ipc_client_compositor(xc);
+
+	struct ipc_shared_memory *ism = icc->ipc_c->ism;
+	struct ipc_layer_slot *slot = &ipc_shared_memory_slots(ism)[icc->layers.slot_id];
+
+	if (icc->layers.layer_count + entry_count > ARRAY_SIZE(slot->layers)) {
+		IPC_ERROR(icc->ipc_c, "Too many layers: %u", icc->layers.layer_count + entry_count);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	// Write all layers straight into the shared memory slot.
+	for (uint32_t i = 0; i < entry_count; i++) {
+		const struct xrt_layer_batch_entry *e = &entries[i];
+		struct ipc_layer_entry *layer = &slot->layers[icc->layers.layer_count++];
+		uint32_t view_count = e->data.view_count;
+
+		layer->xdev_id = 0; //! @todo Real id.
+		layer->data = e->data;
+
+		for (uint32_t k = 0; k < ARRAY_SIZE(layer->swapchain_ids); k++) {
+			layer->swapchain_ids[k] = -1;
+		}
+
+		switch (e->data.type) {
+		case XRT_LAYER_PROJECTION:
+		case XRT_LAYER_PROJECTION_DEPTH:
+			for (uint32_t k = 0; k < view_count; k++) {
+				layer->swapchain_ids[k] = ipc_client_swapchain(e->xsc[k])->id;
+				if (e->data.type == XRT_LAYER_PROJECTION_DEPTH) {
+					layer->swapchain_ids[k + view_count] = ipc_client_swapchain(e->d_xsc[k])->id;
+				}
+				if ((e->data.flags & XRT_LAYER_COMPOSITION_SPACE_WARP_BIT) != 0) {
+					uint32_t mv_id = ipc_client_swapchain(e->mv_xsc[k])->id;
+					layer->swapchain_ids[k + view_count * 2] = mv_id;
+				}
+			}
+			break;
+		case XRT_LAYER_PASSTHROUGH: break;
+		default: layer->swapchain_ids[0] = ipc_client_swapchain(e->xsc[0])->id; break;
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
 static xrt_result_t
 ipc_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_t sync_handle)
 {
 	struct ipc_client_compositor *icc = ipc_client_compositor(xc);
+	struct ipc_swapchain_image_states states = {0};
 	xrt_result_t xret;
 
 	bool valid_sync = xrt_graphics_sync_handle_is_valid(sync_handle);
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shared_memory_slots(ism)[icc->layers.slot_id];
 
 	// Last bit of data to put in the shared memory area.
 	slot->layer_count = icc->layers.layer_count;
@@ -752,13 +893,17 @@ ipc_compositor_layer_commit(struct xrt_compositor *xc, xrt_graphics_sync_handle_
 	    icc->layers.slot_id,               //
 	    &sync_handle,                      //
 	    valid_sync ? 1 : 0,                //
-	    &icc->layers.slot_id);             //
+	    &icc->layers.slot_id,              //
+	    &states);                          //
 
 	/*
 	 * We are probably in a really bad state if we fail, at
 	 * least print out the error and continue as best we can.
 	 */
 	IPC_CHK_ONLY_PRINT(icc->ipc_c, xret, "ipc_call_compositor_layer_sync_with_semaphore");
+	if (xret == XRT_SUCCESS) {
+		update_image_states(icc, &states);
+	}
 
 	// Reset.
 	icc->layers.layer_count = 0;
@@ -778,10 +923,11 @@ ipc_compositor_layer_commit_with_semaphore(struct xrt_compositor *xc,
 {
 	struct ipc_client_compositor *icc = ipc_client_compositor(xc);
 	struct ipc_client_compositor_semaphore *iccs = ipc_client_compositor_semaphore(xcsem);
+	struct ipc_swapchain_image_states states = {0};
 	xrt_result_t xret;
 
 	struct ipc_shared_memory *ism = icc->ipc_c->ism;
-	struct ipc_layer_slot *slot = &ism->slots[icc->layers.slot_id];
+	struct ipc_layer_slot *slot = &ipc_shared_memory_slots(ism)[icc->layers.slot_id];
 
 	// Last bit of data to put in the shared memory area.
 	slot->layer_count = icc->layers.layer_count;
@@ -791,13 +937,17 @@ ipc_compositor_layer_commit_with_semaphore(struct xrt_compositor *xc,
 	    icc->layers.slot_id,                              //
 	    iccs->id,                                         //
 	    value,                                            //
-	    &icc->layers.slot_id);                            //
+	    &icc->layers.slot_id,                             //
+	    &states);                                         //
 
 	/*
 	 * We are probably in a really bad state if we fail, at
 	 * least print out the error and continue as best we can.
 	 */
 	IPC_CHK_ONLY_PRINT(icc->ipc_c, xret, "ipc_call_compositor_layer_sync_with_semaphore");
+	if (xret == XRT_SUCCESS) {
+		update_image_states(icc, &states);
+	}
 
 	// Reset.
 	icc->layers.layer_count = 0;
@@ -898,12 +1048,14 @@ ipc_compositor_init(struct ipc_client_compositor *icc, struct xrt_compositor_nat
 	icc->base.base.layer_begin = ipc_compositor_layer_begin;
 	icc->base.base.layer_projection = ipc_compositor_layer_projection;
 	icc->base.base.layer_projection_depth = ipc_compositor_layer_projection_depth;
+	icc->base.base.layer_projection_space_warp = ipc_compositor_layer_projection_space_warp;
 	icc->base.base.layer_quad = ipc_compositor_layer_quad;
 	icc->base.base.layer_cube = ipc_compositor_layer_cube;
 	icc->base.base.layer_cylinder = ipc_compositor_layer_cylinder;
 	icc->base.base.layer_equirect1 = ipc_compositor_layer_equirect1;
 	icc->base.base.layer_equirect2 = ipc_compositor_layer_equirect2;
 	icc->base.base.layer_passthrough = ipc_compositor_layer_passthrough;
+	icc->base.base.layer_batch = ipc_compositor_layer_batch;
 	icc->base.base.layer_commit = ipc_compositor_layer_commit;
 	icc->base.base.layer_commit_with_semaphore = ipc_compositor_layer_commit_with_semaphore;
 	icc->base.base.destroy = ipc_compositor_destroy;
@@ -19,6 +19,8 @@
 #include "xrt/xrt_config_os.h"
 #include "xrt/xrt_config_android.h"
 
+#include "os/os_time.h"
+
 #include "util/u_var.h"
 #include "util/u_misc.h"
 #include "util/u_file.h"
@@ -27,6 +29,7 @@
 #include "util/u_system_helpers.h"
 
 #include "shared/ipc_utils.h"
+#include "shared/ipc_stats.h"
 #include "shared/ipc_protocol.h"
 #include "client/ipc_client_connection.h"
 
@@ -34,6 +37,7 @@
 
 
 #include <stdio.h>
+#include <string.h>
 #if !defined(XRT_OS_WINDOWS)
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -56,6 +60,9 @@
 #endif // XRT_OS_ANDROID
 
 DEBUG_GET_ONCE_BOOL_OPTION(ipc_ignore_version, "IPC_IGNORE_VERSION", false)
+DEBUG_GET_ONCE_BOOL_OPTION(ipc_use_ring, "IPC_USE_RING", true)
+DEBUG_GET_ONCE_BOOL_OPTION(ipc_use_scratch, "IPC_USE_SCRATCH", true)
+DEBUG_GET_ONCE_OPTION(ipc_capture, "IPC_CAPTURE", NULL)
 
 #ifdef XRT_OS_ANDROID
 
@@ -256,17 +263,23 @@ ipc_client_setup_shm(struct ipc_connection *ipc_c)
 	 * Get our shared memory area from the server.
 	 */
 
-	xrt_result_t xret = ipc_call_instance_get_shm_fd(ipc_c, &ipc_c->ism_handle, 1);
+	uint32_t shm_size = 0;
+	xrt_result_t xret = ipc_call_instance_get_shm_fd(ipc_c, &shm_size, &ipc_c->ism_handle, 1);
 	if (xret != XRT_SUCCESS) {
 		IPC_ERROR(ipc_c, "Failed to retrieve shm fd!");
 		return xret;
 	}
 
+	if (shm_size < sizeof(struct ipc_shared_memory)) {
+		IPC_ERROR(ipc_c, "Shared memory too small (%u bytes)!", shm_size);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
 	/*
-	 * Now map it.
+	 * Now map it, the service sizes it at startup.
 	 */
 
-	const size_t size = sizeof(struct ipc_shared_memory);
+	const size_t size = shm_size;
 
 #ifdef XRT_OS_WINDOWS
 	DWORD access = FILE_MAP_READ | FILE_MAP_WRITE;
@@ -284,6 +297,101 @@ ipc_client_setup_shm(struct ipc_connection *ipc_c)
 		return XRT_ERROR_IPC_FAILURE;
 	}
 
+	ipc_c->ism_size = size;
+
+	return XRT_SUCCESS;
+}
+
+static bool
+check_shared_array(struct ipc_connection *ipc_c, const char *name, uint32_t offset, uint32_t count, size_t element_size)
+{
+	if (offset >= sizeof(struct ipc_shared_memory) && offset <= ipc_c->ism_size &&
+	    (uint64_t)count * element_size <= ipc_c->ism_size - offset) {
+		return true;
+	}
+
+	IPC_ERROR(ipc_c, "Shared memory array '%s' out of bounds (offset: %u, count: %u)!", name, offset, count);
+
+	return false;
+}
+
+static xrt_result_t
+ipc_client_check_shm_layout(struct ipc_connection *ipc_c)
+{
+	const struct ipc_shared_layout *layout = &ipc_c->ism->layout;
+
+#define CHECK(NAME, TYPE)                                                                                              \
+	do {                                                                                                           \
+		if (!check_shared_array(ipc_c, #NAME, layout->NAME##_offset, layout->NAME##_count, sizeof(TYPE))) {    \
+			return XRT_ERROR_IPC_FAILURE;                                                                  \
+		}                                                                                                      \
+	} while (false)
+
+	CHECK(input, struct xrt_input);
+	CHECK(output, struct xrt_output);
+	CHECK(binding_profile, struct ipc_shared_binding_profile);
+	CHECK(input_pair, struct xrt_binding_input_pair);
+	CHECK(output_pair, struct xrt_binding_output_pair);
+	CHECK(slot, struct ipc_layer_slot);
+
+#undef CHECK
+
+	return XRT_SUCCESS;
+}
+
+static void
+ipc_client_setup_ring(struct ipc_connection *ipc_c)
+{
+	if (!debug_get_bool_option_ipc_use_ring()) {
+		IPC_DEBUG(ipc_c, "Shared memory ring disabled, using socket for all calls.");
+		return;
+	}
+
+	// The ring shared memory followed by the doorbell.
+	xrt_shmem_handle_t handles[2] = {XRT_SHMEM_HANDLE_INVALID, XRT_SHMEM_HANDLE_INVALID};
+
+	xrt_result_t xret = ipc_call_instance_get_ring(ipc_c, handles, ARRAY_SIZE(handles));
+	if (xret != XRT_SUCCESS) {
+		// Not fatal, the socket still works.
+		IPC_DEBUG(ipc_c, "Service did not give us a shared memory ring, using socket for all calls.");
+		return;
+	}
+
+	xret = ipc_ring_import(&ipc_c->ring, ipc_c->imc.log_level, handles[0], handles[1]);
+	if (xret != XRT_SUCCESS) {
+		IPC_WARN(ipc_c, "Failed to import shared memory ring, using socket for all calls.");
+		return;
+	}
+}
+
+static xrt_result_t
+ipc_client_setup_scratch(struct ipc_connection *ipc_c)
+{
+	if (!debug_get_bool_option_ipc_use_scratch()) {
+		IPC_DEBUG(ipc_c, "Scratch arena disabled, sending large payloads inline.");
+		return XRT_SUCCESS;
+	}
+
+	xrt_shmem_handle_t handle = XRT_SHMEM_HANDLE_INVALID;
+	uint32_t size = 0;
+
+	xrt_result_t xret = ipc_call_instance_get_scratch(ipc_c, &size, &handle, 1);
+	if (xret != XRT_SUCCESS) {
+		// Not fatal, the service sends everything inline then.
+		IPC_DEBUG(ipc_c, "Service did not give us a scratch arena, sending large payloads inline.");
+		return XRT_SUCCESS;
+	}
+
+	/*
+	 * Fatal, the service will now put payloads in the arena and we would
+	 * not be able to read them.
+	 */
+	xret = ipc_scratch_import(&ipc_c->scratch, handle, size);
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(ipc_c, "Failed to import scratch arena!");
+		return xret;
+	}
+
 	return XRT_SUCCESS;
 }
 
@@ -329,6 +437,53 @@ ipc_client_describe_client(struct ipc_connection *ipc_c, const struct xrt_instan
 	return XRT_SUCCESS;
 }
 
+static void
+ipc_client_setup_capture(struct ipc_connection *ipc_c)
+{
+	const char *path = debug_get_option_ipc_capture();
+	if (path == NULL) {
+		return;
+	}
+
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		IPC_WARN(ipc_c, "Could not open capture file '%s'!", path);
+		return;
+	}
+
+	struct ipc_capture_header header = {
+	    .magic = IPC_CAPTURE_MAGIC,
+	    .version = IPC_CAPTURE_VERSION,
+	};
+	snprintf(header.u_git_tag, sizeof(header.u_git_tag), "%s", u_git_tag);
+
+	if (fwrite(&header, sizeof(header), 1, file) != 1) {
+		IPC_WARN(ipc_c, "Could not write capture file '%s'!", path);
+		fclose(file);
+		return;
+	}
+
+	IPC_INFO(ipc_c, "Capturing IPC calls to '%s'.", path);
+
+	ipc_c->capture_file = file;
+	ipc_c->capture_start_ns = os_monotonic_get_ns();
+}
+
+static void
+ipc_client_report_call_stats_locked(struct ipc_connection *ipc_c, uint32_t command)
+{
+	struct ipc_instance_report_ipc_stats_msg msg = {
+	    .cmd = IPC_INSTANCE_REPORT_IPC_STATS,
+	    .command = command,
+	    .latency = ipc_c->call_stats[command],
+	};
+
+	U_ZERO(&ipc_c->call_stats[command]);
+
+	// Best effort, if the connection is broken the next call will notice.
+	ipc_client_post_locked(ipc_c, &msg, sizeof(msg));
+}
+
 
 /*
  *
@@ -384,26 +539,104 @@ ipc_client_connection_init(struct ipc_connection *ipc_c,
 		goto err_fini; // Already logged.
 	}
 
+	// Only after the version check, the layout header must match.
+	xret = ipc_client_check_shm_layout(ipc_c);
+	if (xret != XRT_SUCCESS) {
+		goto err_fini; // Already logged.
+	}
+
+	// Only after the version check, the ring layout must match.
+	ipc_client_setup_ring(ipc_c);
+
+	xret = ipc_client_setup_scratch(ipc_c);
+	if (xret != XRT_SUCCESS) {
+		goto err_fini; // Already logged.
+	}
+
 	// Do this last.
 	xret = ipc_client_describe_client(ipc_c, i_info);
 	if (xret != XRT_SUCCESS) {
 		goto err_fini; // Already logged.
 	}
 
+	// Only capture what the application does, not the setup.
+	ipc_client_setup_capture(ipc_c);
+
 	return XRT_SUCCESS;
 
 err_fini:
+	// The service might not even understand the stats report call.
+	U_ZERO(&ipc_c->call_stats);
+
 	ipc_client_connection_fini(ipc_c);
 
 	return xret;
 }
 
+void
+ipc_client_record_call_locked(struct ipc_connection *ipc_c, uint32_t command, uint64_t duration_ns)
+{
+	if (command >= IPC_MAX_COMMANDS) {
+		return;
+	}
+
+	struct ipc_latency_histogram *h = &ipc_c->call_stats[command];
+	ipc_latency_histogram_add(h, duration_ns);
+
+	if (h->count >= IPC_CLIENT_STATS_REPORT_INTERVAL) {
+		ipc_client_report_call_stats_locked(ipc_c, command);
+	}
+}
+
+void
+ipc_client_capture_call_locked(struct ipc_connection *ipc_c, const void *msg, size_t msg_size, uint32_t reply_size)
+{
+	ipc_command_t cmd = IPC_ERR;
+	memcpy(&cmd, msg, sizeof(cmd));
+
+	// Bookkeeping of this connection, a replaying connection does its own.
+	if (cmd == IPC_INSTANCE_REPORT_IPC_STATS) {
+		return;
+	}
+
+	struct ipc_capture_record record = {
+	    .timestamp_ns = os_monotonic_get_ns() - ipc_c->capture_start_ns,
+	    .msg_size = (uint32_t)msg_size,
+	    .reply_size = reply_size,
+	};
+
+	if (fwrite(&record, sizeof(record), 1, ipc_c->capture_file) != 1 ||
+	    fwrite(msg, msg_size, 1, ipc_c->capture_file) != 1) {
+		IPC_WARN(ipc_c, "Failed to write to capture file, stopping capture.");
+		fclose(ipc_c->capture_file);
+		ipc_c->capture_file = NULL;
+	}
+}
+
 void
 ipc_client_connection_fini(struct ipc_connection *ipc_c)
 {
+	// Hand over what is left so short lived clients show up in the stats.
+	if (xrt_ipc_handle_is_valid(ipc_c->imc.ipc_handle)) {
+		os_mutex_lock(&ipc_c->mutex);
+		for (uint32_t i = 0; i < IPC_MAX_COMMANDS; i++) {
+			if (ipc_c->call_stats[i].count > 0) {
+				ipc_client_report_call_stats_locked(ipc_c, i);
+			}
+		}
+		os_mutex_unlock(&ipc_c->mutex);
+	}
+
+
 	if (ipc_c->ism_handle != XRT_SHMEM_HANDLE_INVALID) {
 		/// @todo how to tear down the shared memory?
 	}
+	if (ipc_c->capture_file != NULL) {
+		fclose(ipc_c->capture_file);
+		ipc_c->capture_file = NULL;
+	}
+	ipc_ring_destroy(&ipc_c->ring);
+	ipc_scratch_destroy(&ipc_c->scratch);
 	ipc_message_channel_close(&ipc_c->imc);
 	os_mutex_destroy(&ipc_c->mutex);
 
@@ -57,6 +57,39 @@ ipc_client_device(struct xrt_device *xdev)
 	return (ipc_client_device_t *)xdev;
 }
 
+static void
+copy_changed_inputs(struct ipc_client_xdev *icx, struct ipc_shared_memory *ism, uint32_t first_input_index)
+{
+	const struct xrt_input *src = &ipc_shared_memory_inputs(ism)[first_input_index];
+	const uint32_t *bits = ipc_shared_memory_changed_inputs(ism);
+
+	for (uint32_t i = 0; i < icx->base.input_count; i++) {
+		uint32_t index = first_input_index + i;
+		if ((bits[index / 32] & (1u << (index % 32))) != 0) {
+			icx->base.inputs[i] = src[i];
+		}
+	}
+}
+
+static bool
+try_apply_changed_inputs(struct ipc_client_xdev *icx, int32_t generation)
+{
+	struct ipc_shared_memory *ism = icx->ipc_c->ism;
+	uint32_t device_id = icx->device_id;
+
+	// The bits only describe going from the generation just before.
+	if (icx->input_generation == 0 || (uint32_t)generation != (uint32_t)icx->input_generation + 1u ||
+	    ism->changed_input_generations[device_id] != generation) {
+		return false;
+	}
+
+	copy_changed_inputs(icx, ism, ism->isdevs[device_id].first_input_index);
+
+	// The service published again while copying, what we have might be torn.
+	return ism->input_generations[device_id] == generation &&
+	       ism->changed_input_generations[device_id] == generation;
+}
+
 static void
 ipc_client_device_destroy(struct xrt_device *xdev)
 {
@@ -66,7 +99,6 @@ ipc_client_device_destroy(struct xrt_device *xdev)
 	u_var_remove_root(icd);
 
 	// We do not own these, so don't free them.
-	icd->base.inputs = NULL;
 	icd->base.outputs = NULL;
 
 	// Free this device with the helper.
@@ -76,10 +108,7 @@ ipc_client_device_destroy(struct xrt_device *xdev)
 static void
 ipc_client_device_update_inputs(struct xrt_device *xdev)
 {
-	ipc_client_device_t *icd = ipc_client_device(xdev);
-
-	xrt_result_t xret = ipc_call_device_update_input(icd->ipc_c, icd->device_id);
-	IPC_CHK_ONLY_PRINT(icd->ipc_c, xret, "ipc_call_device_update_input");
+	ipc_client_xdev_update_inputs(ipc_client_xdev(xdev));
 }
 
 static void
@@ -108,7 +137,26 @@ ipc_client_device_get_hand_tracking(struct xrt_device *xdev,
 {
 	ipc_client_device_t *icd = ipc_client_device(xdev);
 
-	xrt_result_t xret = ipc_call_device_get_hand_tracking( //
+	struct m_hand_joint_set_compact compact;
+	bool is_compact = false;
+
+	xrt_result_t xret = ipc_call_device_get_hand_tracking_compact( //
+	    icd->ipc_c,                                                //
+	    icd->device_id,                                            //
+	    name,                                                      //
+	    at_timestamp_ns,                                           //
+	    &compact,                                                  //
+	    &is_compact,                                               //
+	    out_timestamp_ns);                                         //
+	IPC_CHK_ONLY_PRINT(icd->ipc_c, xret, "ipc_call_device_get_hand_tracking_compact");
+
+	if (is_compact) {
+		m_hand_joint_set_compact_decode(&compact, out_value);
+		return;
+	}
+
+	// Has velocities or mixed flags, needs the full set.
+	xret = ipc_call_device_get_hand_tracking( //
 	    icd->ipc_c,                                        //
 	    icd->device_id,                                    //
 	    name,                                              //
@@ -168,6 +216,36 @@ ipc_client_device_get_visibility_mask(struct xrt_device *xdev,
 /*!
  * @public @memberof ipc_client_device
  */
+void
+ipc_client_xdev_update_inputs(struct ipc_client_xdev *icx)
+{
+	struct ipc_shared_memory *ism = icx->ipc_c->ism;
+	struct ipc_shared_device *isdev = &ism->isdevs[icx->device_id];
+
+	int32_t generation = ism->input_generations[icx->device_id];
+
+	// The service has not published any new inputs since the last call.
+	if (icx->input_generation != 0 && icx->input_generation == generation) {
+		return;
+	}
+
+	// Published once since the last update, only a few inputs to copy.
+	if (try_apply_changed_inputs(icx, generation)) {
+		icx->input_generation = generation;
+		return;
+	}
+
+	xrt_result_t xret = ipc_call_device_update_input(icx->ipc_c, icx->device_id, &icx->input_generation);
+	if (xret != XRT_SUCCESS) {
+		icx->input_generation = 0;
+		IPC_CHK_ONLY_PRINT(icx->ipc_c, xret, "ipc_call_device_update_input");
+		return;
+	}
+
+	memcpy(icx->base.inputs, &ipc_shared_memory_inputs(ism)[isdev->first_input_index],
+	       sizeof(struct xrt_input) * isdev->input_count);
+}
+
 struct xrt_device *
 ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origin *xtrack, uint32_t device_id)
 {
@@ -177,7 +255,7 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 
 	// Allocate and setup the basics.
 	enum u_device_alloc_flags flags = (enum u_device_alloc_flags)(U_DEVICE_ALLOC_HMD);
-	ipc_client_device_t *icd = U_DEVICE_ALLOCATE(ipc_client_device_t, flags, 0, 0);
+	ipc_client_device_t *icd = U_DEVICE_ALLOCATE(ipc_client_device_t, flags, isdev->input_count, 0);
 	icd->ipc_c = ipc_c;
 	icd->base.update_inputs = ipc_client_device_update_inputs;
 	icd->base.get_tracked_pose = ipc_client_device_get_tracked_pose;
@@ -197,15 +275,15 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 	snprintf(icd->base.str, XRT_DEVICE_NAME_LEN, "%s", isdev->str);
 	snprintf(icd->base.serial, XRT_DEVICE_NAME_LEN, "%s", isdev->serial);
 
-	// Setup inputs, by pointing directly to the shared memory.
+	// Setup inputs, a private copy so they don't change during a sync.
 	assert(isdev->input_count > 0);
-	icd->base.inputs = &ism->inputs[isdev->first_input_index];
-	icd->base.input_count = isdev->input_count;
+	memcpy(icd->base.inputs, &ipc_shared_memory_inputs(ism)[isdev->first_input_index],
+	       sizeof(struct xrt_input) * isdev->input_count);
 
 	// Setup outputs, if any point directly into the shared memory.
 	icd->base.output_count = isdev->output_count;
 	if (isdev->output_count > 0) {
-		icd->base.outputs = &ism->outputs[isdev->first_output_index];
+		icd->base.outputs = &ipc_shared_memory_outputs(ism)[isdev->first_output_index];
 	} else {
 		icd->base.outputs = NULL;
 	}
@@ -219,15 +297,15 @@ ipc_client_device_create(struct ipc_connection *ipc_c, struct xrt_tracking_origi
 	for (size_t i = 0; i < isdev->binding_profile_count; i++) {
 		struct xrt_binding_profile *xbp = &icd->base.binding_profiles[i];
 		struct ipc_shared_binding_profile *isbp =
-		    &ism->binding_profiles[isdev->first_binding_profile_index + i];
+		    &ipc_shared_memory_binding_profiles(ism)[isdev->first_binding_profile_index + i];
 
 		xbp->name = isbp->name;
 		if (isbp->input_count > 0) {
-			xbp->inputs = &ism->input_pairs[isbp->first_input_index];
+			xbp->inputs = &ipc_shared_memory_input_pairs(ism)[isbp->first_input_index];
 			xbp->input_count = isbp->input_count;
 		}
 		if (isbp->output_count > 0) {
-			xbp->outputs = &ism->output_pairs[isbp->first_output_index];
+			xbp->outputs = &ipc_shared_memory_output_pairs(ism)[isbp->first_output_index];
 			xbp->output_count = isbp->output_count;
 		}
 	}
@@ -100,12 +100,12 @@ call_get_view_poses_raw(ipc_client_hmd_t *ich,
 	}
 
 	// We can read directly to the output variables.
-	xret = ipc_receive(&ipc_c->imc, out_fovs, sizeof(struct xrt_fov) * view_count);
-	IPC_CHK_WITH_GOTO(ich->ipc_c, xret, "ipc_receive(1)", out);
+	xret = ipc_scratch_receive(&ipc_c->scratch, &ipc_c->imc, out_fovs, sizeof(struct xrt_fov) * view_count);
+	IPC_CHK_WITH_GOTO(ich->ipc_c, xret, "ipc_scratch_receive(1)", out);
 
 	// We can read directly to the output variables.
-	xret = ipc_receive(&ipc_c->imc, out_poses, sizeof(struct xrt_pose) * view_count);
-	IPC_CHK_WITH_GOTO(ich->ipc_c, xret, "ipc_receive(2)", out);
+	xret = ipc_scratch_receive(&ipc_c->scratch, &ipc_c->imc, out_poses, sizeof(struct xrt_pose) * view_count);
+	IPC_CHK_WITH_GOTO(ich->ipc_c, xret, "ipc_scratch_receive(2)", out);
 
 	/*
 	 * Finally set the head_relation that we got in the reply, mostly to
@@ -133,7 +133,6 @@ ipc_client_hmd_destroy(struct xrt_device *xdev)
 	u_var_remove_root(ich);
 
 	// We do not own these, so don't free them.
-	ich->base.inputs = NULL;
 	ich->base.outputs = NULL;
 
 	// Free this device with the helper.
@@ -143,10 +142,7 @@ ipc_client_hmd_destroy(struct xrt_device *xdev)
 static void
 ipc_client_hmd_update_inputs(struct xrt_device *xdev)
 {
-	ipc_client_hmd_t *ich = ipc_client_hmd(xdev);
-
-	xrt_result_t xret = ipc_call_device_update_input(ich->ipc_c, ich->device_id);
-	IPC_CHK_ONLY_PRINT(ich->ipc_c, xret, "ipc_call_device_update_input");
+	ipc_client_xdev_update_inputs(ipc_client_xdev(xdev));
 }
 
 static void
@@ -280,8 +276,8 @@ ipc_client_hmd_get_visibility_mask(struct xrt_device *xdev,
 		goto err_mask_unlock;
 	}
 
-	xret = ipc_receive(&ipc_c->imc, mask, mask_size);
-	IPC_CHK_WITH_GOTO(ipc_c, xret, "ipc_receive", err_mask_free);
+	xret = ipc_scratch_receive(&ipc_c->scratch, &ipc_c->imc, mask, mask_size);
+	IPC_CHK_WITH_GOTO(ipc_c, xret, "ipc_scratch_receive", err_mask_free);
 
 	*out_mask = mask;
 	ipc_client_connection_unlock(ipc_c);
@@ -307,7 +303,7 @@ ipc_client_hmd_create(struct ipc_connection *ipc_c, struct xrt_tracking_origin *
 
 
 	enum u_device_alloc_flags flags = (enum u_device_alloc_flags)(U_DEVICE_ALLOC_HMD);
-	ipc_client_hmd_t *ich = U_DEVICE_ALLOCATE(ipc_client_hmd_t, flags, 0, 0);
+	ipc_client_hmd_t *ich = U_DEVICE_ALLOCATE(ipc_client_hmd_t, flags, isdev->input_count, 0);
 	ich->ipc_c = ipc_c;
 	ich->device_id = device_id;
 	ich->base.update_inputs = ipc_client_hmd_update_inputs;
@@ -327,10 +323,10 @@ ipc_client_hmd_create(struct ipc_connection *ipc_c, struct xrt_tracking_origin *
 	snprintf(ich->base.str, XRT_DEVICE_NAME_LEN, "%s", isdev->str);
 	snprintf(ich->base.serial, XRT_DEVICE_NAME_LEN, "%s", isdev->serial);
 
-	// Setup inputs, by pointing directly to the shared memory.
+	// Setup inputs, a private copy so they don't change during a sync.
 	assert(isdev->input_count > 0);
-	ich->base.inputs = &ism->inputs[isdev->first_input_index];
-	ich->base.input_count = isdev->input_count;
+	memcpy(ich->base.inputs, &ipc_shared_memory_inputs(ism)[isdev->first_input_index],
+	       sizeof(struct xrt_input) * isdev->input_count);
 
 #if 0
 	// Setup info.
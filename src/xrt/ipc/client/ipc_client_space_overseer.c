@@ -10,8 +10,16 @@
 #include "xrt/xrt_defines.h"
 #include "xrt/xrt_space.h"
 
+#include "math/m_space.h"
+
+#include "shared/ipc_relation_history.h"
+#include "client/ipc_client.h"
+#include "client/ipc_client_connection.h"
+
 #include "ipc_client_generated.h"
 
+#include <assert.h>
+
 
 struct ipc_client_space
 {
@@ -150,6 +158,173 @@ locate_space(struct xrt_space_overseer *xso,
 	IPC_CHK_ALWAYS_RET(icspo->ipc_c, xret, "ipc_call_space_locate_space");
 }
 
+static xrt_result_t
+locate_spaces_chunk(struct ipc_client_space_overseer *icspo,
+                    uint32_t base_space_id,
+                    const struct xrt_pose *base_offset,
+                    uint64_t at_timestamp_ns,
+                    struct xrt_space **spaces,
+                    uint32_t space_count,
+                    const struct xrt_pose *offsets,
+                    struct xrt_space_relation *out_relations)
+{
+	struct ipc_connection *ipc_c = icspo->ipc_c;
+	xrt_result_t xret;
+
+	assert(space_count > 0 && space_count <= IPC_MAX_LOCATE_SPACES);
+
+	uint32_t space_ids[IPC_MAX_LOCATE_SPACES];
+	for (uint32_t i = 0; i < space_count; i++) {
+		space_ids[i] = ipc_client_space(spaces[i])->id;
+	}
+
+	ipc_client_connection_lock(ipc_c);
+
+	xret = ipc_send_space_locate_spaces_locked( //
+	    ipc_c,                                  //
+	    base_space_id,                          //
+	    base_offset,                            //
+	    at_timestamp_ns,                        //
+	    space_count);                           //
+	IPC_CHK_WITH_GOTO(ipc_c, xret, "ipc_send_space_locate_spaces_locked", out);
+
+	xret = ipc_scratch_send(&ipc_c->scratch, &ipc_c->imc, space_ids, sizeof(uint32_t) * space_count);
+	IPC_CHK_WITH_GOTO(ipc_c, xret, "ipc_scratch_send(1)", out);
+
+	xret = ipc_scratch_send(&ipc_c->scratch, &ipc_c->imc, offsets, sizeof(struct xrt_pose) * space_count);
+	IPC_CHK_WITH_GOTO(ipc_c, xret, "ipc_scratch_send(2)", out);
+
+	uint32_t returned_space_count = 0;
+	xret = ipc_receive_space_locate_spaces_locked(ipc_c, &returned_space_count);
+	IPC_CHK_WITH_GOTO(ipc_c, xret, "ipc_receive_space_locate_spaces_locked", out);
+
+	if (space_count != returned_space_count) {
+		IPC_ERROR(ipc_c, "Wrong space counts (sent: %u != got: %u)", space_count, returned_space_count);
+		xret = XRT_ERROR_IPC_FAILURE;
+		goto out;
+	}
+
+	// We can read directly to the output variables.
+	xret = ipc_scratch_receive(                          //
+	    &ipc_c->scratch,                                 //
+	    &ipc_c->imc,                                     //
+	    out_relations,                                   //
+	    sizeof(struct xrt_space_relation) * space_count); //
+	IPC_CHK_WITH_GOTO(ipc_c, xret, "ipc_scratch_receive(1)", out);
+
+out:
+	ipc_client_connection_unlock(ipc_c);
+
+	return xret;
+}
+
+static xrt_result_t
+locate_spaces(struct xrt_space_overseer *xso,
+              struct xrt_space *base_space,
+              const struct xrt_pose *base_offset,
+              uint64_t at_timestamp_ns,
+              struct xrt_space **spaces,
+              uint32_t space_count,
+              const struct xrt_pose *offsets,
+              struct xrt_space_relation *out_relations)
+{
+	struct ipc_client_space_overseer *icspo = ipc_client_space_overseer(xso);
+	xrt_result_t xret;
+
+	uint32_t base_space_id = ipc_client_space(base_space)->id;
+
+	// Split up batches that are larger than what the server takes in one go.
+	for (uint32_t i = 0; i < space_count; i += IPC_MAX_LOCATE_SPACES) {
+		uint32_t count = space_count - i;
+		if (count > IPC_MAX_LOCATE_SPACES) {
+			count = IPC_MAX_LOCATE_SPACES;
+		}
+
+		xret = locate_spaces_chunk( //
+		    icspo,                  //
+		    base_space_id,          //
+		    base_offset,            //
+		    at_timestamp_ns,        //
+		    &spaces[i],             //
+		    count,                  //
+		    &offsets[i],            //
+		    &out_relations[i]);     //
+		IPC_CHK_AND_RET(icspo->ipc_c, xret, "locate_spaces_chunk");
+	}
+
+	return XRT_SUCCESS;
+}
+
+static bool
+get_semantic_space_type(struct xrt_space_overseer *xso, struct xrt_space *xs, enum xrt_reference_space_type *out_type)
+{
+	if (xs == NULL) {
+		return false;
+	}
+
+	if (xs == xso->semantic.view) {
+		*out_type = XRT_SPACE_REFERENCE_TYPE_VIEW;
+	} else if (xs == xso->semantic.local) {
+		*out_type = XRT_SPACE_REFERENCE_TYPE_LOCAL;
+	} else if (xs == xso->semantic.local_floor) {
+		*out_type = XRT_SPACE_REFERENCE_TYPE_LOCAL_FLOOR;
+	} else if (xs == xso->semantic.stage) {
+		*out_type = XRT_SPACE_REFERENCE_TYPE_STAGE;
+	} else if (xs == xso->semantic.unbounded) {
+		*out_type = XRT_SPACE_REFERENCE_TYPE_UNBOUNDED;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+/*!
+ * Try to answer a locate_device call from the relations the server publishes
+ * in the shared memory, only works for the root and semantic spaces.
+ */
+static bool
+locate_device_from_shared(struct ipc_client_space_overseer *icspo,
+                          struct xrt_space *base_space,
+                          const struct xrt_pose *base_offset,
+                          uint64_t at_timestamp_ns,
+                          uint32_t xdev_id,
+                          struct xrt_space_relation *out_relation)
+{
+	struct xrt_space_overseer *xso = &icspo->base;
+	struct ipc_shared_memory *ism = icspo->ipc_c->ism;
+
+	if (!ism->relations.enabled || xdev_id >= XRT_SYSTEM_MAX_DEVICES) {
+		return false;
+	}
+
+	enum xrt_reference_space_type type = XRT_SPACE_REFERENCE_TYPE_INVALID;
+	bool is_root = base_space == xso->semantic.root;
+	if (!is_root && !get_semantic_space_type(xso, base_space, &type)) {
+		return false;
+	}
+
+	struct xrt_space_relation T_root_xdev = XRT_SPACE_RELATION_ZERO;
+	if (!ipc_relation_history_get(&ism->relations.devices[xdev_id], at_timestamp_ns, &T_root_xdev)) {
+		return false;
+	}
+
+	struct xrt_space_relation T_root_base = XRT_SPACE_RELATION_ZERO;
+	if (!is_root && !ipc_relation_history_get(&ism->relations.semantic[type], at_timestamp_ns, &T_root_base)) {
+		return false;
+	}
+
+	struct xrt_relation_chain xrc = {0};
+	m_relation_chain_push_relation(&xrc, &T_root_xdev);
+	if (!is_root) {
+		m_relation_chain_push_inverted_relation(&xrc, &T_root_base);
+	}
+	m_relation_chain_push_inverted_pose_if_not_identity(&xrc, base_offset);
+	m_relation_chain_resolve(&xrc, out_relation);
+
+	return true;
+}
+
 static xrt_result_t
 locate_device(struct xrt_space_overseer *xso,
               struct xrt_space *base_space,
@@ -164,6 +339,10 @@ locate_device(struct xrt_space_overseer *xso,
 	struct ipc_client_space *icsp_base_space = ipc_client_space(base_space);
 	uint32_t xdev_id = ipc_client_xdev(xdev)->device_id;
 
+	if (locate_device_from_shared(icspo, base_space, base_offset, at_timestamp_ns, xdev_id, out_relation)) {
+		return XRT_SUCCESS;
+	}
+
 	xret = ipc_call_space_locate_device( //
 	    icspo->ipc_c,                    //
 	    icsp_base_space->id,             //
@@ -265,6 +444,7 @@ ipc_client_space_overseer_create(struct ipc_connection *ipc_c)
 	icspo->base.create_offset_space = create_offset_space;
 	icspo->base.create_pose_space = create_pose_space;
 	icspo->base.locate_space = locate_space;
+	icspo->base.locate_spaces = locate_spaces;
 	icspo->base.locate_device = locate_device;
 	icspo->base.ref_space_inc = ref_space_inc;
 	icspo->base.ref_space_dec = ref_space_dec;
@@ -19,12 +19,16 @@
 
 #include "util/u_logging.h"
 
+#include "shared/ipc_ring.h"
+#include "shared/ipc_scratch.h"
 #include "shared/ipc_protocol.h"
 #include "shared/ipc_message_channel.h"
 
 #include <stdio.h>
 
 
+struct u_worker_group;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -49,7 +53,6 @@ extern "C" {
  */
 
 #define IPC_MAX_CLIENT_SEMAPHORES 8
-#define IPC_MAX_CLIENT_SWAPCHAINS 32
 #define IPC_MAX_CLIENT_SPACES 128
 
 struct xrt_instance;
@@ -126,6 +129,27 @@ struct ipc_client_state
 	//! Socket fd used for client comms
 	struct ipc_message_channel imc;
 
+	//! Shared memory ring for calls without handles, created on request.
+	struct ipc_ring ring;
+
+	//! Is the command currently being dispatched from the ring.
+	bool dispatching_from_ring;
+
+	//! Arena for variable length payloads, created on request.
+	struct ipc_scratch scratch;
+
+	//! First failure of a one-way call, returned by the next call that has a reply.
+	xrt_result_t deferred_result;
+
+	//! Dispatched by the mainloop worker pool, has no thread of its own.
+	bool pooled;
+
+	/*!
+	 * Per command statistics, only written by the thread dispatching this
+	 * client so no locking is needed, readers may see slightly old values.
+	 */
+	struct ipc_command_stats stats[IPC_MAX_COMMANDS];
+
 	struct ipc_app_state client_state;
 
 	int server_thread_index;
@@ -254,6 +278,18 @@ struct ipc_server_mainloop
 	//! The socket filename we bound to, if any.
 	char *socket_filename;
 
+	/*!
+	 * If not NULL clients are dispatched as tasks on this group, instead
+	 * of each client getting its own thread.
+	 */
+	struct u_worker_group *worker_group;
+
+	//! Epoll fd for all client sockets, only used with @ref worker_group.
+	int client_epoll_fd;
+
+	//! Thread waiting on @ref client_epoll_fd and pushing tasks.
+	struct os_thread_helper client_thread;
+
 	/*! @} */
 
 #define XRT_IPC_GOT_IMPL
@@ -306,6 +342,18 @@ ipc_server_mainloop_init(struct ipc_server_mainloop *ml);
 void
 ipc_server_mainloop_poll(struct ipc_server *vs, struct ipc_server_mainloop *ml);
 
+#if (defined(XRT_OS_LINUX) && !defined(XRT_OS_ANDROID)) || defined(XRT_DOXYGEN)
+/*!
+ * Start dispatching a newly connected client on the worker pool, only valid
+ * if the mainloop has a worker group.
+ *
+ * @return <0 on error.
+ * @public @memberof ipc_server_mainloop
+ */
+int
+ipc_server_mainloop_add_client(struct ipc_server_mainloop *ml, volatile struct ipc_client_state *ics);
+#endif
+
 /*!
  * Main IPC object for the server.
  *
@@ -338,6 +386,9 @@ struct ipc_server
 	struct ipc_shared_memory *ism;
 	xrt_shmem_handle_t ism_handle;
 
+	//! Size of the shared memory segment, picked at startup.
+	size_t ism_size;
+
 	struct ipc_server_mainloop ml;
 
 	// Is the mainloop supposed to run.
@@ -348,7 +399,11 @@ struct ipc_server
 
 	enum u_logging_level log_level;
 
-	struct ipc_thread threads[IPC_MAX_CLIENTS];
+	//! One per client, @ref max_clients long.
+	struct ipc_thread *threads;
+
+	//! How many clients can be connected at the same time, picked at startup.
+	uint32_t max_clients;
 
 	volatile uint32_t current_slot_index;
 
@@ -362,6 +417,22 @@ struct ipc_server
 
 		struct os_mutex lock;
 	} global_state;
+
+	//! Serializes writers of ipc_shared_memory::relations.
+	struct os_mutex relations_lock;
+
+	/*!
+	 * Polls all devices and publishes changed inputs, only started if
+	 * @ref publish_inputs is set. The helper lock protects the device
+	 * inputs and ipc_shared_memory::inputs while it is running.
+	 */
+	struct os_thread_helper inputs_thread;
+
+	//! Is @ref inputs_thread running, set once at startup.
+	bool publish_inputs;
+
+	//! Statistics of disconnected clients, protected by the global state lock.
+	struct ipc_command_stats retired_stats[IPC_MAX_COMMANDS];
 };
 
 
@@ -373,6 +444,14 @@ struct ipc_server
 xrt_result_t
 ipc_server_get_client_app_state(struct ipc_server *s, uint32_t client_id, struct ipc_app_state *out_ias);
 
+/*!
+ * Get the current state of all connected clients.
+ *
+ * @ingroup ipc_server
+ */
+xrt_result_t
+ipc_server_get_client_app_states(struct ipc_server *s, struct ipc_app_states *out_states);
+
 /*!
  * Set the new active client.
  *
@@ -421,6 +500,55 @@ ipc_server_update_state(struct ipc_server *s);
 void *
 ipc_server_client_thread(void *_ics);
 
+#if !defined(XRT_OS_WINDOWS) || defined(XRT_DOXYGEN)
+/*!
+ * Worker pool version of @ref ipc_server_client_thread, dispatches commands
+ * waiting on the socket of the client, never waits for new ones to arrive.
+ *
+ * @return False if the client has disconnected or failed, it must then be shut
+ *         down with @ref ipc_server_client_pooled_shutdown.
+ * @ingroup ipc_server
+ */
+bool
+ipc_server_client_dispatch_ready(volatile struct ipc_client_state *ics);
+
+/*!
+ * Shut down a client dispatched by the worker pool, the client slot can be
+ * reused once this has returned.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_client_pooled_shutdown(volatile struct ipc_client_state *ics);
+#endif
+
+/*!
+ * Send the reply for the command currently being dispatched, goes over the
+ * ring if that is where the command came from, otherwise the socket.
+ *
+ * @ingroup ipc_server
+ */
+xrt_result_t
+ipc_server_client_send_reply(volatile struct ipc_client_state *ics, const void *data, size_t size);
+
+/*!
+ * Record the result of a one-way call, only the first failure is kept until
+ * it has been returned to the client.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_client_defer_result(volatile struct ipc_client_state *ics, xrt_result_t result);
+
+/*!
+ * If an earlier one-way call has failed, and @p result is a success, replace
+ * @p result with that failure and clear it.
+ *
+ * @ingroup ipc_server
+ */
+void
+ipc_server_client_take_deferred_result(volatile struct ipc_client_state *ics, xrt_result_t *result);
+
 /*!
  * This destroys the native compositor for this client and any extra objects
  * created from it, like all of the swapchains.
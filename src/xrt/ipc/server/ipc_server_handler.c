@@ -13,8 +13,12 @@
 #include "util/u_handles.h"
 #include "util/u_pretty_print.h"
 #include "util/u_visibility_mask.h"
+#include "util/u_startup_timeline.h"
 #include "util/u_trace_marker.h"
+#include "util/u_trace_recorder.h"
 
+#include "shared/ipc_stats.h"
+#include "shared/ipc_relation_history.h"
 #include "server/ipc_server.h"
 #include "ipc_server_generated.h"
 
@@ -114,6 +118,97 @@ validate_space_id(volatile struct ipc_client_state *ics, int64_t space_id, struc
 	return XRT_SUCCESS;
 }
 
+static bool
+get_semantic_space_type(struct xrt_space_overseer *xso, struct xrt_space *xs, enum xrt_reference_space_type *out_type)
+{
+	if (xs == NULL) {
+		return false;
+	}
+
+	if (xs == xso->semantic.view) {
+		*out_type = XRT_SPACE_REFERENCE_TYPE_VIEW;
+	} else if (xs == xso->semantic.local) {
+		*out_type = XRT_SPACE_REFERENCE_TYPE_LOCAL;
+	} else if (xs == xso->semantic.local_floor) {
+		*out_type = XRT_SPACE_REFERENCE_TYPE_LOCAL_FLOOR;
+	} else if (xs == xso->semantic.stage) {
+		*out_type = XRT_SPACE_REFERENCE_TYPE_STAGE;
+	} else if (xs == xso->semantic.unbounded) {
+		*out_type = XRT_SPACE_REFERENCE_TYPE_UNBOUNDED;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+/*!
+ * Publish the device space, and the base space if it is a semantic space, in
+ * the root space to the shared memory so clients can skip the round trip if
+ * they ask for the same timestamp again, or one in between.
+ */
+static void
+publish_device_relations(volatile struct ipc_client_state *ics,
+                         struct xrt_space *base_space,
+                         uint32_t xdev_id,
+                         struct xrt_device *xdev,
+                         uint64_t at_timestamp_ns)
+{
+	struct ipc_server *s = ics->server;
+	struct ipc_shared_memory *ism = s->ism;
+	struct xrt_space_overseer *xso = s->xso;
+	const struct xrt_pose identity = XRT_POSE_IDENTITY;
+
+	if (xdev_id >= XRT_SYSTEM_MAX_DEVICES || xso->semantic.root == NULL) {
+		return;
+	}
+
+	struct xrt_space_relation T_root_xdev = XRT_SPACE_RELATION_ZERO;
+	xrt_space_overseer_locate_device( //
+	    xso,                          //
+	    xso->semantic.root,           //
+	    &identity,                    //
+	    at_timestamp_ns,              //
+	    xdev,                         //
+	    &T_root_xdev);                //
+
+	enum xrt_reference_space_type type = XRT_SPACE_REFERENCE_TYPE_INVALID;
+	struct xrt_space_relation T_root_base = XRT_SPACE_RELATION_ZERO;
+	bool have_base = get_semantic_space_type(xso, base_space, &type);
+	if (have_base) {
+		xrt_space_overseer_locate_space( //
+		    xso,                         //
+		    xso->semantic.root,          //
+		    &identity,                   //
+		    at_timestamp_ns,             //
+		    base_space,                  //
+		    &identity,                   //
+		    &T_root_base);               //
+	}
+
+	os_mutex_lock(&s->relations_lock);
+	ipc_relation_history_publish(&ism->relations.devices[xdev_id], at_timestamp_ns, &T_root_xdev);
+	if (have_base) {
+		ipc_relation_history_publish(&ism->relations.semantic[type], at_timestamp_ns, &T_root_base);
+	}
+	os_mutex_unlock(&s->relations_lock);
+}
+
+static void
+clear_published_relations(struct ipc_server *s)
+{
+	struct ipc_shared_memory *ism = s->ism;
+
+	os_mutex_lock(&s->relations_lock);
+	for (uint32_t i = 0; i < ARRAY_SIZE(ism->relations.devices); i++) {
+		ipc_relation_history_clear(&ism->relations.devices[i]);
+	}
+	for (uint32_t i = 0; i < ARRAY_SIZE(ism->relations.semantic); i++) {
+		ipc_relation_history_clear(&ism->relations.semantic[i]);
+	}
+	os_mutex_unlock(&s->relations_lock);
+}
+
 static xrt_result_t
 get_new_space_id(volatile struct ipc_client_state *ics, uint32_t *out_id)
 {
@@ -162,6 +257,7 @@ track_space(volatile struct ipc_client_state *ics, struct xrt_space *xs, uint32_
 
 xrt_result_t
 ipc_handle_instance_get_shm_fd(volatile struct ipc_client_state *ics,
+                               uint32_t *out_size,
                                uint32_t max_handle_capacity,
                                xrt_shmem_handle_t *out_handles,
                                uint32_t *out_handle_count)
@@ -172,6 +268,72 @@ ipc_handle_instance_get_shm_fd(volatile struct ipc_client_state *ics,
 
 	out_handles[0] = ics->server->ism_handle;
 	*out_handle_count = 1;
+	*out_size = (uint32_t)ics->server->ism_size;
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_handle_instance_get_ring(volatile struct ipc_client_state *ics,
+                             uint32_t max_handle_capacity,
+                             xrt_shmem_handle_t *out_handles,
+                             uint32_t *out_handle_count)
+{
+	IPC_TRACE_MARKER();
+
+	// Cast away volatile.
+	struct ipc_ring *ring = (struct ipc_ring *)&ics->ring;
+
+	if (max_handle_capacity < 2 || ipc_ring_is_active(ring)) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	// The worker pool only waits on the socket, client falls back to it.
+	if (ics->pooled) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	xrt_result_t xret = ipc_ring_create(ring, ics->server->log_level);
+	if (xret != XRT_SUCCESS) {
+		// Client falls back to using the socket.
+		IPC_WARN(ics->server, "Could not create shared memory ring for client.");
+		return xret;
+	}
+
+	// The client loop picks up the doorbell after this call has returned.
+	out_handles[0] = ring->shmem_handle;
+	out_handles[1] = ring->doorbell_handle;
+	*out_handle_count = 2;
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_handle_instance_get_scratch(volatile struct ipc_client_state *ics,
+                                uint32_t *out_size,
+                                uint32_t max_handle_capacity,
+                                xrt_shmem_handle_t *out_handles,
+                                uint32_t *out_handle_count)
+{
+	IPC_TRACE_MARKER();
+
+	// Cast away volatile.
+	struct ipc_scratch *scratch = (struct ipc_scratch *)&ics->scratch;
+
+	if (max_handle_capacity < 1 || ipc_scratch_is_active(scratch)) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	xrt_result_t xret = ipc_scratch_create(scratch, IPC_SCRATCH_SIZE);
+	if (xret != XRT_SUCCESS) {
+		// Client sends everything inline.
+		IPC_WARN(ics->server, "Could not create scratch arena for client.");
+		return xret;
+	}
+
+	out_handles[0] = scratch->handle;
+	*out_handle_count = 1;
+	*out_size = IPC_SCRATCH_SIZE;
 
 	return XRT_SUCCESS;
 }
@@ -215,6 +377,22 @@ ipc_handle_instance_describe_client(volatile struct ipc_client_state *ics,
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_instance_report_ipc_stats(volatile struct ipc_client_state *ics,
+                                     uint32_t command,
+                                     const struct ipc_latency_histogram *latency)
+{
+	if (command >= IPC_MAX_COMMANDS) {
+		IPC_ERROR(ics->server, "Invalid command in stats report!");
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	// Cast away volatile, only this thread writes to the stats.
+	ipc_latency_histogram_merge((struct ipc_latency_histogram *)&ics->stats[command].client, latency);
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 ipc_handle_system_compositor_get_info(volatile struct ipc_client_state *ics,
                                       struct xrt_system_compositor_info *out_info)
@@ -226,6 +404,15 @@ ipc_handle_system_compositor_get_info(volatile struct ipc_client_state *ics,
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_system_compositor_get_stats(volatile struct ipc_client_state *ics,
+                                       struct xrt_multi_compositor_stats *out_stats)
+{
+	IPC_TRACE_MARKER();
+
+	return xrt_syscomp_get_stats(ics->server->xsysc, out_stats);
+}
+
 xrt_result_t
 ipc_handle_session_create(volatile struct ipc_client_state *ics,
                           const struct xrt_session_info *xsi,
@@ -486,6 +673,100 @@ ipc_handle_space_locate_space(volatile struct ipc_client_state *ics,
 	    out_relation);                      //
 }
 
+xrt_result_t
+ipc_handle_space_locate_spaces(volatile struct ipc_client_state *ics,
+                               uint32_t base_space_id,
+                               const struct xrt_pose *base_offset,
+                               uint64_t at_timestamp,
+                               uint32_t space_count)
+{
+	IPC_TRACE_MARKER();
+
+	// Cast away volatile.
+	struct ipc_message_channel *imc = (struct ipc_message_channel *)&ics->imc;
+	struct ipc_scratch *scratch = (struct ipc_scratch *)&ics->scratch;
+	struct ipc_space_locate_spaces_reply reply = XRT_STRUCT_INIT;
+	struct xrt_space_overseer *xso = ics->server->xso;
+	struct xrt_space *base_space = NULL;
+	xrt_result_t xret;
+
+	if (space_count == 0 || space_count > IPC_MAX_LOCATE_SPACES) {
+		IPC_ERROR(ics->server, "Client asked for zero or too many spaces! (%u)", space_count);
+
+		/*
+		 * The client never sends more than it is allowed to, so this is
+		 * a broken client, the data it sent after the message has not
+		 * been read so the connection is not usable after this.
+		 */
+		reply.result = XRT_ERROR_IPC_FAILURE;
+		return ipc_send(imc, &reply, sizeof(reply));
+	}
+
+	uint32_t space_ids[IPC_MAX_LOCATE_SPACES];
+	struct xrt_pose offsets[IPC_MAX_LOCATE_SPACES];
+	struct xrt_space *spaces[IPC_MAX_LOCATE_SPACES];
+	struct xrt_space_relation relations[IPC_MAX_LOCATE_SPACES];
+
+	// Always read the arrays so that the stream stays in sync.
+	xret = ipc_scratch_receive(scratch, imc, space_ids, sizeof(uint32_t) * space_count);
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(ics->server, "Failed to receive space ids!");
+		return xret;
+	}
+
+	xret = ipc_scratch_receive(scratch, imc, offsets, sizeof(struct xrt_pose) * space_count);
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(ics->server, "Failed to receive offsets!");
+		return xret;
+	}
+
+	xret = validate_space_id(ics, base_space_id, &base_space);
+	if (xret != XRT_SUCCESS) {
+		U_LOG_E("Invalid base_space_id!");
+		reply.result = xret;
+		return ipc_send(imc, &reply, sizeof(reply));
+	}
+
+	for (uint32_t i = 0; i < space_count; i++) {
+		xret = validate_space_id(ics, space_ids[i], &spaces[i]);
+		if (xret != XRT_SUCCESS) {
+			U_LOG_E("Invalid space_id (index %u)!", i);
+			reply.result = xret;
+			return ipc_send(imc, &reply, sizeof(reply));
+		}
+	}
+
+	reply.result = xrt_space_overseer_locate_spaces( //
+	    xso,                                         //
+	    base_space,                                  //
+	    base_offset,                                 //
+	    at_timestamp,                                //
+	    spaces,                                      //
+	    space_count,                                 //
+	    offsets,                                     //
+	    relations);                                  //
+	if (reply.result != XRT_SUCCESS) {
+		return ipc_send(imc, &reply, sizeof(reply));
+	}
+
+	reply.space_count = space_count;
+
+	xret = ipc_send(imc, &reply, sizeof(reply));
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(ics->server, "Failed to send reply!");
+		return xret;
+	}
+
+	// The relations only follow a successful reply.
+	xret = ipc_scratch_send(scratch, imc, relations, sizeof(struct xrt_space_relation) * space_count);
+	if (xret != XRT_SUCCESS) {
+		IPC_ERROR(ics->server, "Failed to send relations!");
+		return xret;
+	}
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 ipc_handle_space_locate_device(volatile struct ipc_client_state *ics,
                                uint32_t base_space_id,
@@ -513,6 +794,10 @@ ipc_handle_space_locate_device(volatile struct ipc_client_state *ics,
 		return xret;
 	}
 
+	if (ics->server->ism->relations.enabled) {
+		publish_device_relations(ics, base_space, xdev_id, xdev, at_timestamp);
+	}
+
 	return xrt_space_overseer_locate_device( //
 	    xso,                                 //
 	    base_space,                          //
@@ -606,7 +891,14 @@ ipc_handle_space_recenter_local_spaces(volatile struct ipc_client_state *ics)
 {
 	struct xrt_space_overseer *xso = ics->server->xso;
 
-	return xrt_space_overseer_recenter_local_spaces(xso);
+	xrt_result_t xret = xrt_space_overseer_recenter_local_spaces(xso);
+
+	// Any published relations are now out of date.
+	if (ics->server->ism->relations.enabled) {
+		clear_published_relations(ics->server);
+	}
+
+	return xret;
 }
 
 xrt_result_t
@@ -787,6 +1079,8 @@ _update_projection_layer_depth(struct xrt_compositor *xc,
 
 	struct xrt_swapchain *xcs[XRT_MAX_VIEWS];
 	struct xrt_swapchain *d_xcs[XRT_MAX_VIEWS];
+	struct xrt_swapchain *mv_xcs[XRT_MAX_VIEWS];
+	bool space_warp = (data->flags & XRT_LAYER_COMPOSITION_SPACE_WARP_BIT) != 0;
 
 	for (uint32_t j = 0; j < data->view_count; j++) {
 		int xsci = layer->swapchain_ids[j];
@@ -798,9 +1092,23 @@ _update_projection_layer_depth(struct xrt_compositor *xc,
 			U_LOG_E("Invalid swap chain for projection layer #%u!", i);
 			return false;
 		}
+
+		if (space_warp) {
+			int mv_xsci = layer->swapchain_ids[j + data->view_count * 2];
+
+			mv_xcs[j] = ics->xscs[mv_xsci];
+			if (mv_xcs[j] == NULL) {
+				U_LOG_E("Invalid motion vector swap chain for projection layer #%u!", i);
+				return false;
+			}
+		}
 	}
 
-	xrt_comp_layer_projection_depth(xc, xdev, xcs, d_xcs, data);
+	if (space_warp) {
+		xrt_comp_layer_projection_space_warp(xc, xdev, xcs, d_xcs, mv_xcs, data);
+	} else {
+		xrt_comp_layer_projection_depth(xc, xdev, xcs, d_xcs, data);
+	}
 
 	return true;
 }
@@ -1016,10 +1324,37 @@ _update_layers(volatile struct ipc_client_state *ics, struct xrt_compositor *xc,
 	return true;
 }
 
+/*!
+ * Polls which images of the client's swapchains are not used by the
+ * compositor, this lets the client skip the wait image call for them.
+ */
+static void
+_get_image_states(volatile struct ipc_client_state *ics, struct ipc_swapchain_image_states *out_image_states)
+{
+	U_ZERO(out_image_states);
+
+	for (uint32_t id = 0; id < IPC_MAX_CLIENT_SWAPCHAINS; id++) {
+		struct xrt_swapchain *xsc = ics->xscs[id];
+		if (xsc == NULL) {
+			continue;
+		}
+
+		uint32_t mask = 0;
+		for (uint32_t i = 0; i < xsc->image_count; i++) {
+			if (xrt_swapchain_wait_image(xsc, 0, i) == XRT_SUCCESS) {
+				mask |= 1u << i;
+			}
+		}
+
+		out_image_states->unused_masks[id] = mask;
+	}
+}
+
 xrt_result_t
 ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
                                  uint32_t slot_id,
                                  uint32_t *out_free_slot_id,
+                                 struct ipc_swapchain_image_states *out_image_states,
                                  const xrt_graphics_sync_handle_t *handles,
                                  const uint32_t handle_count)
 {
@@ -1030,7 +1365,6 @@ ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
 	}
 
 	struct ipc_shared_memory *ism = ics->server->ism;
-	struct ipc_layer_slot *slot = &ism->slots[slot_id];
 	xrt_graphics_sync_handle_t sync_handle = XRT_GRAPHICS_SYNC_HANDLE_INVALID;
 
 	// If we have one or more save the first handle.
@@ -1045,7 +1379,15 @@ ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
 		u_graphics_sync_unref(&tmp);
 	}
 
+	// The slot count is picked by the service at startup.
+	if (slot_id >= ism->layout.slot_count) {
+		IPC_ERROR(ics->server, "Invalid slot id %u!", slot_id);
+		u_graphics_sync_unref(&sync_handle);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
 	// Copy current slot data.
+	struct ipc_layer_slot *slot = &ipc_shared_memory_slots(ism)[slot_id];
 	struct ipc_layer_slot copy = *slot;
 
 
@@ -1066,11 +1408,13 @@ ipc_handle_compositor_layer_sync(volatile struct ipc_client_state *ics,
 
 	os_mutex_lock(&ics->server->global_state.lock);
 
-	*out_free_slot_id = (ics->server->current_slot_index + 1) % IPC_MAX_SLOTS;
+	*out_free_slot_id = (ics->server->current_slot_index + 1) % ism->layout.slot_count;
 	ics->server->current_slot_index = *out_free_slot_id;
 
 	os_mutex_unlock(&ics->server->global_state.lock);
 
+	_get_image_states(ics, out_image_states);
+
 	return XRT_SUCCESS;
 }
 
@@ -1079,7 +1423,8 @@ ipc_handle_compositor_layer_sync_with_semaphore(volatile struct ipc_client_state
                                                 uint32_t slot_id,
                                                 uint32_t semaphore_id,
                                                 uint64_t semaphore_value,
-                                                uint32_t *out_free_slot_id)
+                                                uint32_t *out_free_slot_id,
+                                                struct ipc_swapchain_image_states *out_image_states)
 {
 	IPC_TRACE_MARKER();
 
@@ -1098,7 +1443,14 @@ ipc_handle_compositor_layer_sync_with_semaphore(volatile struct ipc_client_state
 	struct xrt_compositor_semaphore *xcsem = ics->xcsems[semaphore_id];
 
 	struct ipc_shared_memory *ism = ics->server->ism;
-	struct ipc_layer_slot *slot = &ism->slots[slot_id];
+
+	// The slot count is picked by the service at startup.
+	if (slot_id >= ism->layout.slot_count) {
+		IPC_ERROR(ics->server, "Invalid slot id %u!", slot_id);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	struct ipc_layer_slot *slot = &ipc_shared_memory_slots(ism)[slot_id];
 
 	// Copy current slot data.
 	struct ipc_layer_slot copy = *slot;
@@ -1122,11 +1474,13 @@ ipc_handle_compositor_layer_sync_with_semaphore(volatile struct ipc_client_state
 
 	os_mutex_lock(&ics->server->global_state.lock);
 
-	*out_free_slot_id = (ics->server->current_slot_index + 1) % IPC_MAX_SLOTS;
+	*out_free_slot_id = (ics->server->current_slot_index + 1) % ism->layout.slot_count;
 	ics->server->current_slot_index = *out_free_slot_id;
 
 	os_mutex_unlock(&ics->server->global_state.lock);
 
+	_get_image_states(ics, out_image_states);
+
 	return XRT_SUCCESS;
 }
 
@@ -1208,7 +1562,7 @@ ipc_handle_system_get_clients(volatile struct ipc_client_state *_ics, struct ipc
 	os_mutex_lock(&s->global_state.lock);
 
 	uint32_t count = 0;
-	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+	for (uint32_t i = 0; i < s->max_clients; i++) {
 
 		volatile struct ipc_client_state *ics = &s->threads[i].ics;
 
@@ -1246,6 +1600,14 @@ ipc_handle_system_get_client_info(volatile struct ipc_client_state *_ics,
 	return ipc_server_get_client_app_state(s, client_id, out_ias);
 }
 
+xrt_result_t
+ipc_handle_system_get_client_states(volatile struct ipc_client_state *_ics, struct ipc_app_states *out_states)
+{
+	struct ipc_server *s = _ics->server;
+
+	return ipc_server_get_client_app_states(s, out_states);
+}
+
 xrt_result_t
 ipc_handle_system_set_primary_client(volatile struct ipc_client_state *_ics, uint32_t client_id)
 {
@@ -1285,6 +1647,88 @@ ipc_handle_system_toggle_io_device(volatile struct ipc_client_state *ics, uint32
 
 	idev->io_active = !idev->io_active;
 
+	// Make clients fetch the inputs again, they go from or to being masked.
+	xrt_atomic_s32_inc_return(&ics->server->ism->input_generations[device_id]);
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_handle_system_get_ipc_stats(volatile struct ipc_client_state *ics,
+                                uint32_t command,
+                                struct ipc_command_stats *out_stats)
+{
+	struct ipc_server *s = ics->server;
+
+	if (command >= IPC_MAX_COMMANDS) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	// Lock-free on the client side, the lock keeps the client list stable.
+	os_mutex_lock(&s->global_state.lock);
+
+	struct ipc_command_stats stats = s->retired_stats[command];
+
+	for (uint32_t i = 0; i < s->max_clients; i++) {
+		volatile struct ipc_client_state *_ics = &s->threads[i].ics;
+		if (_ics->server_thread_index < 0) {
+			continue;
+		}
+
+		// Cast away volatile.
+		ipc_command_stats_merge(&stats, (struct ipc_command_stats *)&_ics->stats[command]);
+	}
+
+	os_mutex_unlock(&s->global_state.lock);
+
+	*out_stats = stats;
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_handle_system_dump_trace(volatile struct ipc_client_state *ics, struct ipc_trace_dump_info *out_info)
+{
+	struct ipc_server *s = ics->server;
+
+	struct ipc_trace_dump_info info = {0};
+
+	// Not an error, the service might just not be built with the recorder.
+	if (!u_trace_recorder_is_enabled()) {
+		*out_info = info;
+		return XRT_SUCCESS;
+	}
+
+	if (u_trace_recorder_dump(info.path, sizeof(info.path), &info.event_count) != 0) {
+		IPC_ERROR(s, "Failed to dump trace!");
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	IPC_INFO(s, "Wrote %u trace events to '%s'", info.event_count, info.path);
+
+	*out_info = info;
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_handle_system_get_startup_phase(volatile struct ipc_client_state *ics,
+                                    uint32_t index,
+                                    struct ipc_startup_phase *out_phase)
+{
+	struct u_startup_phase phase = {0};
+	struct ipc_startup_phase info = {0};
+
+	info.count = u_startup_timeline_get(index, &phase);
+	if (index < info.count) {
+		info.depth = phase.depth;
+		info.begin_ns = phase.begin_ns;
+		info.end_ns = phase.end_ns;
+		snprintf(info.name, sizeof(info.name), "%s", phase.name);
+	}
+
+	*out_phase = info;
+
 	return XRT_SUCCESS;
 }
 
@@ -1562,21 +2006,26 @@ ipc_handle_compositor_semaphore_destroy(volatile struct ipc_client_state *ics, u
  */
 
 xrt_result_t
-ipc_handle_device_update_input(volatile struct ipc_client_state *ics, uint32_t id)
+ipc_handle_device_update_input(volatile struct ipc_client_state *ics, uint32_t id, int32_t *out_generation)
 {
 	// To make the code a bit more readable.
 	uint32_t device_id = id;
-	struct ipc_shared_memory *ism = ics->server->ism;
+	struct ipc_server *s = ics->server;
+	struct ipc_shared_memory *ism = s->ism;
 	struct ipc_device *idev = get_idev(ics, device_id);
 	struct xrt_device *xdev = idev->xdev;
 	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
 
-	// Update inputs.
-	xrt_device_update_inputs(xdev);
+	// The publisher thread polls the device, only keep it out while copying.
+	if (s->publish_inputs) {
+		os_thread_helper_lock(&s->inputs_thread);
+	} else {
+		xrt_device_update_inputs(xdev);
+	}
 
 	// Copy data into the shared memory.
 	struct xrt_input *src = xdev->inputs;
-	struct xrt_input *dst = &ism->inputs[isdev->first_input_index];
+	struct xrt_input *dst = &ipc_shared_memory_inputs(ism)[isdev->first_input_index];
 	size_t size = sizeof(struct xrt_input) * isdev->input_count;
 
 	bool io_active = ics->io_active && idev->io_active;
@@ -1595,6 +2044,15 @@ ipc_handle_device_update_input(volatile struct ipc_client_state *ics, uint32_t i
 		}
 	}
 
+	// Zero tells the client to not skip the next call, masked inputs are never published.
+	*out_generation = 0;
+	if (s->publish_inputs) {
+		if (io_active) {
+			*out_generation = ism->input_generations[device_id];
+		}
+		os_thread_helper_unlock(&s->inputs_thread);
+	}
+
 	// Reply.
 	return XRT_SUCCESS;
 }
@@ -1604,7 +2062,7 @@ find_input(volatile struct ipc_client_state *ics, uint32_t device_id, enum xrt_i
 {
 	struct ipc_shared_memory *ism = ics->server->ism;
 	struct ipc_shared_device *isdev = &ism->isdevs[device_id];
-	struct xrt_input *io = &ism->inputs[isdev->first_input_index];
+	struct xrt_input *io = &ipc_shared_memory_inputs(ism)[isdev->first_input_index];
 
 	for (uint32_t i = 0; i < isdev->input_count; i++) {
 		if (io[i].name == name) {
@@ -1672,6 +2130,31 @@ ipc_handle_device_get_hand_tracking(volatile struct ipc_client_state *ics,
 	return XRT_SUCCESS;
 }
 
+xrt_result_t
+ipc_handle_device_get_hand_tracking_compact(volatile struct ipc_client_state *ics,
+                                            uint32_t id,
+                                            enum xrt_input_name name,
+                                            uint64_t at_timestamp,
+                                            struct m_hand_joint_set_compact *out_value,
+                                            bool *out_compact,
+                                            uint64_t *out_timestamp)
+{
+	// To make the code a bit more readable.
+	uint32_t device_id = id;
+	struct xrt_device *xdev = get_xdev(ics, device_id);
+
+	struct xrt_hand_joint_set value;
+	U_ZERO(&value);
+
+	// Get the joints.
+	xrt_device_get_hand_tracking(xdev, name, at_timestamp, &value, out_timestamp);
+
+	// Client needs to fall back to the full call if the set didn't fit.
+	*out_compact = m_hand_joint_set_compact_encode(&value, out_value);
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 ipc_handle_device_get_view_poses(volatile struct ipc_client_state *ics,
                                  uint32_t id,
@@ -1679,7 +2162,9 @@ ipc_handle_device_get_view_poses(volatile struct ipc_client_state *ics,
                                  uint64_t at_timestamp_ns,
                                  uint32_t view_count)
 {
+	// Cast away volatile.
 	struct ipc_message_channel *imc = (struct ipc_message_channel *)&ics->imc;
+	struct ipc_scratch *scratch = (struct ipc_scratch *)&ics->scratch;
 	struct ipc_device_get_view_poses_reply reply = XRT_STRUCT_INIT;
 	struct ipc_server *s = ics->server;
 	xrt_result_t xret;
@@ -1735,14 +2220,14 @@ ipc_handle_device_get_view_poses(volatile struct ipc_client_state *ics,
 	}
 
 	// Send the fovs that we got.
-	xret = ipc_send(imc, fovs, sizeof(struct xrt_fov) * view_count);
+	xret = ipc_scratch_send(scratch, imc, fovs, sizeof(struct xrt_fov) * view_count);
 	if (xret != XRT_SUCCESS) {
 		IPC_ERROR(s, "Failed to send fovs!");
 		return xret;
 	}
 
 	// And finally the poses.
-	xret = ipc_send(imc, poses, sizeof(struct xrt_pose) * view_count);
+	xret = ipc_scratch_send(scratch, imc, poses, sizeof(struct xrt_pose) * view_count);
 	if (xret != XRT_SUCCESS) {
 		IPC_ERROR(s, "Failed to send poses!");
 		return xret;
@@ -1815,7 +2300,9 @@ ipc_handle_device_get_visibility_mask(volatile struct ipc_client_state *ics,
                                       enum xrt_visibility_mask_type type,
                                       uint32_t view_index)
 {
+	// Cast away volatile.
 	struct ipc_message_channel *imc = (struct ipc_message_channel *)&ics->imc;
+	struct ipc_scratch *scratch = (struct ipc_scratch *)&ics->scratch;
 	struct ipc_device_get_visibility_mask_reply reply = XRT_STRUCT_INIT;
 	struct ipc_server *s = ics->server;
 	xrt_result_t xret;
@@ -1847,7 +2334,7 @@ ipc_handle_device_get_visibility_mask(volatile struct ipc_client_state *ics,
 		goto out_free;
 	}
 
-	xret = ipc_send(imc, mask, reply.mask_size);
+	xret = ipc_scratch_send(scratch, imc, mask, reply.mask_size);
 	if (xret != XRT_SUCCESS) {
 		IPC_ERROR(s, "Failed to send mask");
 		goto out_free;
@@ -21,6 +21,7 @@
 #include "util/u_debug.h"
 #include "util/u_trace_marker.h"
 #include "util/u_file.h"
+#include "util/u_worker.h"
 
 #include "shared/ipc_shmem.h"
 #include "server/ipc_server.h"
@@ -56,6 +57,17 @@
  */
 DEBUG_GET_ONCE_BOOL_OPTION(skip_stdin, "XRT_NO_STDIN", false)
 
+/*
+ * Dispatch clients as tasks on a small worker pool instead of giving each one a
+ * thread of its own, cuts down on wakeups when a lot of clients are connected.
+ */
+DEBUG_GET_ONCE_BOOL_OPTION(worker_pool, "IPC_WORKER_POOL", false)
+DEBUG_GET_ONCE_NUM_OPTION(worker_count, "IPC_WORKER_COUNT", 2)
+
+#define NUM_POLL_EVENTS 8
+#define NO_SLEEP 0
+#define MAX_WORKER_COUNT 8
+
 /*
  *
  * Static functions.
@@ -211,6 +223,129 @@ init_epoll(struct ipc_server_mainloop *ml)
 	return 0;
 }
 
+static int
+arm_client(struct ipc_server_mainloop *ml, volatile struct ipc_client_state *ics, int op)
+{
+	/*
+	 * One shot, so only one task per client is ever in flight which keeps
+	 * the commands of each client in order, re-armed when a task is done.
+	 */
+	struct epoll_event ev = {0};
+	ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	ev.data.ptr = (void *)ics;
+
+	return epoll_ctl(ml->client_epoll_fd, op, ics->imc.ipc_handle, &ev);
+}
+
+static void
+client_task(void *ptr)
+{
+	volatile struct ipc_client_state *ics = (volatile struct ipc_client_state *)ptr;
+	struct ipc_server_mainloop *ml = &ics->server->ml;
+
+	if (ipc_server_client_dispatch_ready(ics)) {
+		int ret = arm_client(ml, ics, EPOLL_CTL_MOD);
+		if (ret == 0) {
+			return;
+		}
+
+		U_LOG_E("epoll_ctl(client) failed '%i', disconnecting client.", ret);
+	}
+
+	epoll_ctl(ml->client_epoll_fd, EPOLL_CTL_DEL, ics->imc.ipc_handle, NULL);
+
+	ipc_server_client_pooled_shutdown(ics);
+}
+
+static void *
+run_client_thread(void *ptr)
+{
+	struct ipc_server_mainloop *ml = (struct ipc_server_mainloop *)ptr;
+	const int half_a_second_ms = 500;
+
+	U_TRACE_SET_THREAD_NAME("IPC Clients");
+
+	os_thread_helper_lock(&ml->client_thread);
+	while (os_thread_helper_is_running_locked(&ml->client_thread)) {
+		os_thread_helper_unlock(&ml->client_thread);
+
+		struct epoll_event events[NUM_POLL_EVENTS] = {0};
+
+		// Timeout so that we notice being stopped.
+		int ret = epoll_wait(ml->client_epoll_fd, events, NUM_POLL_EVENTS, half_a_second_ms);
+		if (ret < 0 && errno != EINTR) {
+			U_LOG_E("epoll_wait(clients) failed with '%i'.", ret);
+			os_thread_helper_lock(&ml->client_thread);
+			break;
+		}
+
+		for (int i = 0; i < ret; i++) {
+			u_worker_group_push(ml->worker_group, client_task, events[i].data.ptr);
+		}
+
+		os_thread_helper_lock(&ml->client_thread);
+	}
+	os_thread_helper_unlock(&ml->client_thread);
+
+	return NULL;
+}
+
+static int
+init_worker_pool(struct ipc_server_mainloop *ml)
+{
+	ml->worker_group = NULL;
+	ml->client_epoll_fd = -1;
+
+	if (!debug_get_bool_option_worker_pool()) {
+		return 0;
+	}
+
+	int64_t count = debug_get_num_option_worker_count();
+	if (count < 1) {
+		count = 1;
+	} else if (count > MAX_WORKER_COUNT) {
+		count = MAX_WORKER_COUNT;
+	}
+
+	int ret = os_thread_helper_init(&ml->client_thread);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = epoll_create1(EPOLL_CLOEXEC);
+	if (ret < 0) {
+		return ret;
+	}
+
+	ml->client_epoll_fd = ret;
+
+	struct u_worker_thread_pool *uwtp =
+	    u_worker_thread_pool_create_with_role(count, count, "IPC Worker", U_THREAD_ROLE_REALTIME_IO);
+	if (uwtp == NULL) {
+		U_LOG_E("Failed to create worker thread pool.");
+		return -1;
+	}
+
+	ml->worker_group = u_worker_group_create(uwtp);
+	u_worker_thread_pool_reference(&uwtp, NULL);
+	if (ml->worker_group == NULL) {
+		U_LOG_E("Failed to create worker group.");
+		return -1;
+	}
+
+	ret = os_thread_helper_start(&ml->client_thread, run_client_thread, ml);
+	if (ret != 0) {
+		U_LOG_E("Failed to start client thread '%i'.", ret);
+		return -1;
+	}
+
+	os_thread_helper_name(&ml->client_thread, "IPC Clients");
+
+	U_LOG_I("Dispatching clients on a pool of %u workers.", (uint32_t)count);
+
+	return 0;
+}
+
 static void
 handle_listen(struct ipc_server *vs, struct ipc_server_mainloop *ml)
 {
@@ -225,9 +360,6 @@ handle_listen(struct ipc_server *vs, struct ipc_server_mainloop *ml)
 	ipc_server_handle_client_connected(vs, ret);
 }
 
-#define NUM_POLL_EVENTS 8
-#define NO_SLEEP 0
-
 /*
  *
  * Exported functions
@@ -281,6 +413,26 @@ ipc_server_mainloop_init(struct ipc_server_mainloop *ml)
 		ipc_server_mainloop_deinit(ml);
 		return ret;
 	}
+
+	ret = init_worker_pool(ml);
+	if (ret < 0) {
+		ipc_server_mainloop_deinit(ml);
+		return ret;
+	}
+	return 0;
+}
+
+int
+ipc_server_mainloop_add_client(struct ipc_server_mainloop *ml, volatile struct ipc_client_state *ics)
+{
+	assert(ml->worker_group != NULL);
+
+	int ret = arm_client(ml, ics, EPOLL_CTL_ADD);
+	if (ret < 0) {
+		U_LOG_E("epoll_ctl(client) failed '%i'", ret);
+		return ret;
+	}
+
 	return 0;
 }
 
@@ -303,5 +455,19 @@ ipc_server_mainloop_deinit(struct ipc_server_mainloop *ml)
 			ml->socket_filename = NULL;
 		}
 	}
+
+	// Stop pushing new tasks, then let the ones in flight finish.
+	if (ml->client_thread.initialized) {
+		os_thread_helper_destroy(&ml->client_thread);
+	}
+	if (ml->worker_group != NULL) {
+		u_worker_group_wait_all(ml->worker_group);
+		u_worker_group_reference(&ml->worker_group, NULL);
+	}
+	if (ml->client_epoll_fd > 0) {
+		close(ml->client_epoll_fd);
+		ml->client_epoll_fd = -1;
+	}
+
 	//! @todo close epoll_fd?
 }
@@ -8,9 +8,12 @@
  * @ingroup ipc_server
  */
 
+#include "os/os_time.h"
+
 #include "util/u_misc.h"
 #include "util/u_trace_marker.h"
 
+#include "shared/ipc_stats.h"
 #include "shared/ipc_utils.h"
 #include "server/ipc_server.h"
 #include "ipc_server_generated.h"
@@ -46,6 +49,14 @@ common_shutdown(volatile struct ipc_client_state *ics)
 	os_mutex_lock(&ics->server->global_state.lock);
 
 	ipc_message_channel_close((struct ipc_message_channel *)&ics->imc);
+	ipc_ring_destroy((struct ipc_ring *)&ics->ring);
+	ipc_scratch_destroy((struct ipc_scratch *)&ics->scratch);
+
+	// Keep the statistics around after the client has gone.
+	for (uint32_t i = 0; i < IPC_MAX_COMMANDS; i++) {
+		// Cast away volatile.
+		ipc_command_stats_merge(&ics->server->retired_stats[i], (struct ipc_command_stats *)&ics->stats[i]);
+	}
 
 	ics->server->threads[ics->server_thread_index].state = IPC_THREAD_STOPPING;
 	ics->server_thread_index = -1;
@@ -86,6 +97,26 @@ common_shutdown(volatile struct ipc_client_state *ics)
 	ipc_server_deactivate_session(ics);
 }
 
+/*!
+ * Dispatch a command and record how long it took, the command has already
+ * been validated by the callers.
+ */
+static xrt_result_t
+timed_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
+{
+	uint64_t start_ns = os_monotonic_get_ns();
+
+	xrt_result_t result = timed_dispatch(ics, ipc_command);
+
+	uint64_t duration_ns = os_monotonic_get_ns() - start_ns;
+	if (*ipc_command < IPC_MAX_COMMANDS) {
+		// Cast away volatile.
+		ipc_latency_histogram_add((struct ipc_latency_histogram *)&ics->stats[*ipc_command].server, duration_ns);
+	}
+
+	return result;
+}
+
 
 /*
  *
@@ -121,6 +152,107 @@ setup_epoll(volatile struct ipc_client_state *ics)
 	return epoll_fd;
 }
 
+static int
+add_ring_to_epoll(volatile struct ipc_client_state *ics, int epoll_fd)
+{
+	struct epoll_event ev = XRT_STRUCT_INIT;
+
+	ev.events = EPOLLIN;
+	ev.data.fd = ics->ring.doorbell_handle;
+	int ret = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, ics->ring.doorbell_handle, &ev);
+	if (ret < 0) {
+		IPC_ERROR(ics->server, "Error epoll_ctl(doorbell) failed '%i'.", ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+/*!
+ * Dispatch all commands waiting in the ring, if @p keep_spinning is set keeps
+ * spinning a short while after each command as clients tend to issue a bunch
+ * of calls back to back.
+ */
+static bool
+dispatch_ring(volatile struct ipc_client_state *ics, bool keep_spinning)
+{
+	// Cast away volatile.
+	struct ipc_ring *ring = (struct ipc_ring *)&ics->ring;
+	uint8_t buf[IPC_BUF_SIZE];
+	size_t len = 0;
+	bool spin = false;
+
+	while (ipc_ring_server_pop(ring, spin, buf, &len)) {
+		ipc_command_t *ipc_command = (ipc_command_t *)buf;
+
+		if (len < sizeof(*ipc_command) || !ipc_command_is_ring_capable(*ipc_command) ||
+		    ipc_command_size(*ipc_command) != len) {
+			IPC_ERROR(ics->server, "Invalid command received on ring, disconnecting client.");
+			return false;
+		}
+
+		ics->dispatching_from_ring = true;
+
+		xrt_result_t result = timed_dispatch(ics, ipc_command);
+
+		ics->dispatching_from_ring = false;
+
+		if (result != XRT_SUCCESS) {
+			IPC_ERROR(ics->server, "During ring packet handling, disconnecting client.");
+			return false;
+		}
+
+		spin = keep_spinning;
+	}
+
+	return true;
+}
+
+/*!
+ * Read one command from the socket and dispatch it, blocks until the whole
+ * command has arrived.
+ */
+static bool
+dispatch_socket(volatile struct ipc_client_state *ics)
+{
+	// Peek the first 4 bytes to get the command type
+	enum ipc_command cmd;
+	ssize_t len = recv(ics->imc.ipc_handle, &cmd, sizeof(cmd), MSG_PEEK);
+	if (len != sizeof(cmd)) {
+		IPC_ERROR(ics->server, "Invalid command received.");
+		return false;
+	}
+
+	size_t cmd_size = ipc_command_size(cmd);
+	if (cmd_size == 0) {
+		IPC_ERROR(ics->server, "Invalid command size.");
+		return false;
+	}
+
+	// Read the whole command now that we know its size
+	uint8_t buf[IPC_BUF_SIZE] = {0};
+
+	len = recv(ics->imc.ipc_handle, &buf, cmd_size, 0);
+	if (len != (ssize_t)cmd_size) {
+		IPC_ERROR(ics->server, "Invalid packet received, disconnecting client.");
+		return false;
+	}
+
+	// Check the first 4 bytes of the message and dispatch.
+	ipc_command_t *ipc_command = (ipc_command_t *)buf;
+
+	IPC_TRACE_BEGIN(ipc_dispatch);
+	xrt_result_t result = ipc_dispatch(ics, ipc_command);
+	IPC_TRACE_END(ipc_dispatch);
+
+	if (result != XRT_SUCCESS) {
+		IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
+		return false;
+	}
+
+	return true;
+}
+
 static void
 client_loop(volatile struct ipc_client_state *ics)
 {
@@ -134,11 +266,30 @@ client_loop(volatile struct ipc_client_state *ics)
 		return;
 	}
 
+	// Has the doorbell of the ring been added to epoll.
+	bool ring_in_epoll = false;
+
 	while (ics->server->running) {
 		const int half_a_second_ms = 500;
 		struct epoll_event event = XRT_STRUCT_INIT;
 		int ret = 0;
 
+		// The ring is created by a call, pick it up when that has happened.
+		if (!ring_in_epoll && ipc_ring_is_active((struct ipc_ring *)&ics->ring)) {
+			if (add_ring_to_epoll(ics, epoll_fd) < 0) {
+				break;
+			}
+			ring_in_epoll = true;
+		}
+
+		// Tell the client to ring the doorbell, unless there are already commands.
+		if (ring_in_epoll && ipc_ring_server_prepare_wait((struct ipc_ring *)&ics->ring)) {
+			if (!dispatch_ring(ics, true)) {
+				break;
+			}
+			continue;
+		}
+
 		// On temporary failures retry.
 		do {
 			// We use epoll here to be able to timeout.
@@ -155,53 +306,79 @@ client_loop(volatile struct ipc_client_state *ics)
 			continue;
 		}
 
+		// Commands on the ring, the doorbell is cleared in prepare wait.
+		if (ring_in_epoll && event.data.fd == ics->ring.doorbell_handle) {
+			if (!dispatch_ring(ics, true)) {
+				break;
+			}
+			continue;
+		}
+
 		// Detect clients disconnecting gracefully.
 		if (ret > 0 && (event.events & EPOLLHUP) != 0) {
 			IPC_INFO(ics->server, "Client disconnected.");
 			break;
 		}
 
-		// Peek the first 4 bytes to get the command type
-		enum ipc_command cmd;
-		ssize_t len = recv(ics->imc.ipc_handle, &cmd, sizeof(cmd), MSG_PEEK);
-		if (len != sizeof(cmd)) {
-			IPC_ERROR(ics->server, "Invalid command received.");
+		/*
+		 * One-way calls posted on the ring before this command was sent
+		 * must be dispatched first, they are already visible as the
+		 * client wrote them before writing to the socket.
+		 */
+		if (ring_in_epoll && !dispatch_ring(ics, false)) {
 			break;
 		}
 
-		size_t cmd_size = ipc_command_size(cmd);
-		if (cmd_size == 0) {
-			IPC_ERROR(ics->server, "Invalid command size.");
+		if (!dispatch_socket(ics)) {
 			break;
 		}
+	}
 
-		// Read the whole command now that we know its size
-		uint8_t buf[IPC_BUF_SIZE] = {0};
+	close(epoll_fd);
+	epoll_fd = -1;
 
-		len = recv(ics->imc.ipc_handle, &buf, cmd_size, 0);
-		if (len != (ssize_t)cmd_size) {
-			IPC_ERROR(ics->server, "Invalid packet received, disconnecting client.");
-			break;
-		}
+	// Following code is same for all platforms.
+	common_shutdown(ics);
+}
 
-		// Check the first 4 bytes of the message and dispatch.
-		ipc_command_t *ipc_command = (ipc_command_t *)buf;
+bool
+ipc_server_client_dispatch_ready(volatile struct ipc_client_state *ics)
+{
+	// Let other clients have a go after this many commands.
+	const uint32_t max_commands = 16;
+
+	for (uint32_t i = 0; i < max_commands; i++) {
+		enum ipc_command cmd;
+		ssize_t len = recv(ics->imc.ipc_handle, &cmd, sizeof(cmd), MSG_PEEK | MSG_DONTWAIT);
+		if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+			return true;
+		}
 
-		IPC_TRACE_BEGIN(ipc_dispatch);
-		xrt_result_t result = ipc_dispatch(ics, ipc_command);
-		IPC_TRACE_END(ipc_dispatch);
+		if (len == 0) {
+			IPC_INFO(ics->server, "Client disconnected.");
+			return false;
+		}
 
-		if (result != XRT_SUCCESS) {
-			IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
-			break;
+		if (!dispatch_socket(ics)) {
+			return false;
 		}
 	}
 
-	close(epoll_fd);
-	epoll_fd = -1;
+	return true;
+}
+
+void
+ipc_server_client_pooled_shutdown(volatile struct ipc_client_state *ics)
+{
+	struct ipc_server *s = ics->server;
+	int index = ics->server_thread_index;
 
-	// Following code is same for all platforms.
 	common_shutdown(ics);
+
+	// There is no thread to join, the slot is free now that we are done.
+	os_mutex_lock(&s->global_state.lock);
+	s->threads[index].state = IPC_THREAD_READY;
+	os_mutex_unlock(&s->global_state.lock);
 }
 
 #else // XRT_OS_WINDOWS
@@ -270,9 +447,7 @@ client_loop(volatile struct ipc_client_state *ics)
 			break;
 		}
 
-		IPC_TRACE_BEGIN(ipc_dispatch);
-		xrt_result_t result = ipc_dispatch(ics, cmd_ptr);
-		IPC_TRACE_END(ipc_dispatch);
+		xrt_result_t result = timed_dispatch(ics, cmd_ptr);
 
 		if (result != XRT_SUCCESS) {
 			IPC_ERROR(ics->server, "During packet handling, disconnecting client.");
@@ -293,6 +468,41 @@ client_loop(volatile struct ipc_client_state *ics)
  *
  */
 
+xrt_result_t
+ipc_server_client_send_reply(volatile struct ipc_client_state *ics, const void *data, size_t size)
+{
+	if (ics->dispatching_from_ring) {
+		// Cast away volatile.
+		return ipc_ring_server_reply((struct ipc_ring *)&ics->ring, data, size);
+	}
+
+	// Cast away volatile.
+	return ipc_send((struct ipc_message_channel *)&ics->imc, data, size);
+}
+
+void
+ipc_server_client_defer_result(volatile struct ipc_client_state *ics, xrt_result_t result)
+{
+	if (result == XRT_SUCCESS || ics->deferred_result != XRT_SUCCESS) {
+		return;
+	}
+
+	IPC_WARN(ics->server, "One-way call failed with %d, returning it with the next reply.", result);
+
+	ics->deferred_result = result;
+}
+
+void
+ipc_server_client_take_deferred_result(volatile struct ipc_client_state *ics, xrt_result_t *result)
+{
+	if (ics->deferred_result == XRT_SUCCESS || *result != XRT_SUCCESS) {
+		return;
+	}
+
+	*result = ics->deferred_result;
+	ics->deferred_result = XRT_SUCCESS;
+}
+
 void
 ipc_server_client_destroy_session_and_compositor(volatile struct ipc_client_state *ics)
 {
@@ -315,10 +525,13 @@ ipc_server_client_destroy_session_and_compositor(volatile struct ipc_client_stat
 		IPC_TRACE(ics->server, "Destroyed compositor semaphore %d.", j);
 	}
 
+	// Other threads look at the compositor under the lock, like for the client state.
+	struct xrt_compositor *xc = ics->xc;
+	ics->xc = NULL;
+
 	os_mutex_unlock(&ics->server->global_state.lock);
 
-	// Cast away volatile.
-	xrt_comp_destroy((struct xrt_compositor **)&ics->xc);
+	xrt_comp_destroy(&xc);
 
 	// Cast away volatile.
 	xrt_session_destroy((struct xrt_session **)&ics->xs);
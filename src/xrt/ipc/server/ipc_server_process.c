@@ -26,10 +26,12 @@
 #include "util/u_process.h"
 #include "util/u_debug_gui.h"
 #include "util/u_pretty_print.h"
+#include "util/u_startup_timeline.h"
 
 #include "util/u_git_tag.h"
 
 #include "shared/ipc_shmem.h"
+#include "shared/ipc_relation_history.h"
 #include "server/ipc_server.h"
 #include "server/ipc_server_interface.h"
 
@@ -58,6 +60,13 @@
 
 DEBUG_GET_ONCE_BOOL_OPTION(exit_on_disconnect, "IPC_EXIT_ON_DISCONNECT", false)
 DEBUG_GET_ONCE_LOG_OPTION(ipc_log, "IPC_LOG", U_LOGGING_INFO)
+DEBUG_GET_ONCE_BOOL_OPTION(publish_relations, "IPC_PUBLISH_RELATIONS", false)
+DEBUG_GET_ONCE_BOOL_OPTION(publish_inputs, "IPC_PUBLISH_INPUTS", false)
+DEBUG_GET_ONCE_NUM_OPTION(publish_inputs_period_ms, "IPC_PUBLISH_INPUTS_PERIOD_MS", 2)
+DEBUG_GET_ONCE_NUM_OPTION(max_clients, "IPC_MAX_CLIENTS", 8)
+DEBUG_GET_ONCE_NUM_OPTION(slot_count, "IPC_SLOT_COUNT", 128)
+DEBUG_GET_ONCE_BOOL_OPTION(shm_prefault, "IPC_SHM_PREFAULT", true)
+DEBUG_GET_ONCE_BOOL_OPTION(shm_lock, "IPC_SHM_LOCK", false)
 
 
 /*
@@ -195,6 +204,9 @@ teardown_all(struct ipc_server *s)
 {
 	u_var_remove_root(s);
 
+	// Stop polling the devices before they go away.
+	os_thread_helper_destroy(&s->inputs_thread);
+
 	xrt_syscomp_destroy(&s->xsysc);
 
 	teardown_idevs(s);
@@ -209,7 +221,12 @@ teardown_all(struct ipc_server *s)
 
 	u_process_destroy(s->process);
 
-	ipc_shmem_destroy(&s->ism_handle, (void **)&s->ism, sizeof(struct ipc_shared_memory));
+	ipc_shmem_destroy(&s->ism_handle, (void **)&s->ism, s->ism_size);
+
+	os_mutex_destroy(&s->relations_lock);
+
+	free(s->threads);
+	s->threads = NULL;
 
 	// Destroyed last.
 	os_mutex_destroy(&s->global_state.lock);
@@ -244,7 +261,7 @@ init_tracking_origins(struct ipc_server *s)
 
 static void
 handle_binding(struct ipc_shared_memory *ism,
-               struct xrt_binding_profile *xbp,
+               const struct xrt_binding_profile *xbp,
                struct ipc_shared_binding_profile *isbp,
                uint32_t *input_pair_index_ptr,
                uint32_t *output_pair_index_ptr)
@@ -257,7 +274,7 @@ handle_binding(struct ipc_shared_memory *ism,
 	// Copy the initial state and also count the number in input_pairs.
 	uint32_t input_pair_start = input_pair_index;
 	for (size_t k = 0; k < xbp->input_count; k++) {
-		ism->input_pairs[input_pair_index++] = xbp->inputs[k];
+		ipc_shared_memory_input_pairs(ism)[input_pair_index++] = xbp->inputs[k];
 	}
 
 	// Setup the 'offsets' and number of input_pairs.
@@ -269,7 +286,7 @@ handle_binding(struct ipc_shared_memory *ism,
 	// Copy the initial state and also count the number in outputs.
 	uint32_t output_pair_start = output_pair_index;
 	for (size_t k = 0; k < xbp->output_count; k++) {
-		ism->output_pairs[output_pair_index++] = xbp->outputs[k];
+		ipc_shared_memory_output_pairs(ism)[output_pair_index++] = xbp->outputs[k];
 	}
 
 	// Setup the 'offsets' and number of output_pairs.
@@ -282,18 +299,109 @@ handle_binding(struct ipc_shared_memory *ism,
 	*output_pair_index_ptr = output_pair_index;
 }
 
+static uint32_t
+place_array(size_t *offset_ptr, uint64_t count, size_t element_size)
+{
+	// Every array starts a cache line, they have different writers.
+	size_t offset = (*offset_ptr + XRT_CACHE_LINE_SIZE - 1) & ~(size_t)(XRT_CACHE_LINE_SIZE - 1);
+
+	*offset_ptr = offset + element_size * count;
+
+	return (uint32_t)offset;
+}
+
+static int
+init_shm_layout(struct ipc_server *s, struct ipc_shared_layout *layout)
+{
+	uint64_t input_count = 0;
+	uint64_t output_count = 0;
+	uint64_t binding_profile_count = 0;
+	uint64_t input_pair_count = 0;
+	uint64_t output_pair_count = 0;
+
+	// Size the arrays for exactly the devices we have.
+	for (size_t i = 0; i < XRT_SYSTEM_MAX_DEVICES; i++) {
+		struct xrt_device *xdev = s->idevs[i].xdev;
+		if (xdev == NULL) {
+			continue;
+		}
+
+		input_count += xdev->input_count;
+		output_count += xdev->output_count;
+		binding_profile_count += xdev->binding_profile_count;
+
+		for (size_t k = 0; k < xdev->binding_profile_count; k++) {
+			input_pair_count += xdev->binding_profiles[k].input_count;
+			output_pair_count += xdev->binding_profiles[k].output_count;
+		}
+	}
+
+	// One bit per input.
+	uint64_t changed_input_count = (input_count + 31) / 32;
+
+	long slot_count = debug_get_num_option_slot_count();
+	if (slot_count < 2 || slot_count > 4096) {
+		IPC_WARN(s, "IPC_SLOT_COUNT must be between 2 and 4096, using 128.");
+		slot_count = 128;
+	}
+
+	size_t offset = sizeof(struct ipc_shared_memory);
+	layout->input_offset = place_array(&offset, input_count, sizeof(struct xrt_input));
+	layout->changed_input_offset = place_array(&offset, changed_input_count, sizeof(uint32_t));
+	layout->output_offset = place_array(&offset, output_count, sizeof(struct xrt_output));
+	layout->binding_profile_offset =
+	    place_array(&offset, binding_profile_count, sizeof(struct ipc_shared_binding_profile));
+	layout->input_pair_offset = place_array(&offset, input_pair_count, sizeof(struct xrt_binding_input_pair));
+	layout->output_pair_offset = place_array(&offset, output_pair_count, sizeof(struct xrt_binding_output_pair));
+	layout->slot_offset = place_array(&offset, (uint64_t)slot_count, sizeof(struct ipc_layer_slot));
+
+	if (offset > UINT32_MAX) {
+		IPC_ERROR(s, "Shared memory would be too large (%zu bytes)!", offset);
+		return -1;
+	}
+
+	layout->size = (uint32_t)offset;
+	layout->input_count = (uint32_t)input_count;
+	layout->changed_input_count = (uint32_t)changed_input_count;
+	layout->output_count = (uint32_t)output_count;
+	layout->binding_profile_count = (uint32_t)binding_profile_count;
+	layout->input_pair_count = (uint32_t)input_pair_count;
+	layout->output_pair_count = (uint32_t)output_pair_count;
+	layout->slot_count = (uint32_t)slot_count;
+
+	return 0;
+}
+
 static int
 init_shm(struct ipc_server *s)
 {
-	const size_t size = sizeof(struct ipc_shared_memory);
+	struct ipc_shared_layout layout = {0};
+	int ret = init_shm_layout(s, &layout);
+	if (ret < 0) {
+		return ret;
+	}
+
 	xrt_shmem_handle_t handle;
-	xrt_result_t result = ipc_shmem_create(size, &handle, (void **)&s->ism);
+	xrt_result_t result = ipc_shmem_create(layout.size, &handle, (void **)&s->ism);
 	if (result != XRT_SUCCESS) {
 		return -1;
 	}
 
+	// Fault it all in now, instead of whatever thread first writes to a page.
+	if (debug_get_bool_option_shm_prefault() || debug_get_bool_option_shm_lock()) {
+		result = ipc_shmem_prefault(s->ism, layout.size, debug_get_bool_option_shm_lock());
+		if (result != XRT_SUCCESS) {
+			IPC_WARN(s, "Could not lock the shared memory, check RLIMIT_MEMLOCK.");
+		}
+	}
+
 	// we have a filehandle, we will pass this to our client
 	s->ism_handle = handle;
+	s->ism_size = layout.size;
+	s->ism->layout = layout;
+
+	IPC_INFO(s, "Shared memory is %u bytes with %u inputs and %u layer slots.", layout.size, layout.input_count,
+	         layout.slot_count);
 
 
 	/*
@@ -307,6 +415,9 @@ init_shm(struct ipc_server *s)
 
 	ism->startup_timestamp = os_monotonic_get_ns();
 
+	// Opt-in, lets clients locate devices without a round trip.
+	ism->relations.enabled = debug_get_bool_option_publish_relations() && ipc_relation_history_is_supported();
+
 	// Setup the tracking origins.
 	count = 0;
 	for (size_t i = 0; i < XRT_SYSTEM_MAX_DEVICES; i++) {
@@ -392,8 +503,9 @@ init_shm(struct ipc_server *s)
 		// Bindings
 		uint32_t binding_start = binding_index;
 		for (size_t k = 0; k < xdev->binding_profile_count; k++) {
-			handle_binding(ism, &xdev->binding_profiles[k], &ism->binding_profiles[binding_index++],
-			               &input_pair_index, &output_pair_index);
+			handle_binding(ism, &xdev->binding_profiles[k],
+			               &ipc_shared_memory_binding_profiles(ism)[binding_index++], &input_pair_index,
+			               &output_pair_index);
 		}
 
 		// Setup the 'offsets' and number of bindings.
@@ -405,7 +517,7 @@ init_shm(struct ipc_server *s)
 		// Copy the initial state and also count the number in inputs.
 		uint32_t input_start = input_index;
 		for (size_t k = 0; k < xdev->input_count; k++) {
-			ism->inputs[input_index++] = xdev->inputs[k];
+			ipc_shared_memory_inputs(ism)[input_index++] = xdev->inputs[k];
 		}
 
 		// Setup the 'offsets' and number of inputs.
@@ -417,7 +529,7 @@ init_shm(struct ipc_server *s)
 		// Copy the initial state and also count the number in outputs.
 		uint32_t output_start = output_index;
 		for (size_t k = 0; k < xdev->output_count; k++) {
-			ism->outputs[output_index++] = xdev->outputs[k];
+			ipc_shared_memory_outputs(ism)[output_index++] = xdev->outputs[k];
 		}
 
 		// Setup the 'offsets' and number of outputs.
@@ -452,13 +564,108 @@ init_server_state(struct ipc_server *s)
 	s->global_state.last_active_client_index = -1;
 	s->current_slot_index = 0;
 
-	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+	for (uint32_t i = 0; i < s->max_clients; i++) {
 		volatile struct ipc_client_state *ics = &s->threads[i].ics;
 		ics->server = s;
 		ics->server_thread_index = -1;
 	}
 }
 
+static inline bool
+input_changed(const struct xrt_input *src, const struct xrt_input *dst)
+{
+	return src->active != dst->active || memcmp(&src->value, &dst->value, sizeof(src->value)) != 0;
+}
+
+static void
+publish_device_inputs_locked(struct ipc_server *s, uint32_t device_id)
+{
+	struct ipc_device *idev = &s->idevs[device_id];
+	struct ipc_shared_device *isdev = &s->ism->isdevs[device_id];
+	struct xrt_device *xdev = idev->xdev;
+
+	// Inactive devices are masked by the update call for each client.
+	if (xdev == NULL || !idev->io_active) {
+		return;
+	}
+
+	xrt_device_update_inputs(xdev);
+
+	struct xrt_input *src = xdev->inputs;
+	struct xrt_input *dst = &ipc_shared_memory_inputs(s->ism)[isdev->first_input_index];
+
+	bool changed = false;
+	for (uint32_t i = 0; i < isdev->input_count && !changed; i++) {
+		changed = input_changed(&src[i], &dst[i]);
+	}
+
+	if (!changed) {
+		return;
+	}
+
+	// Clients must not use the bits while they are being rewritten.
+	s->ism->changed_input_generations[device_id] = 0;
+
+	// Only copy what changed, and mark it for clients one generation behind.
+	uint32_t *bits = ipc_shared_memory_changed_inputs(s->ism);
+	for (uint32_t i = 0; i < isdev->input_count; i++) {
+		uint32_t index = isdev->first_input_index + i;
+		uint32_t mask = 1u << (index % 32);
+
+		if (!input_changed(&src[i], &dst[i])) {
+			bits[index / 32] &= ~mask;
+			continue;
+		}
+
+		dst[i] = src[i];
+		bits[index / 32] |= mask;
+	}
+
+	int32_t generation = xrt_atomic_s32_inc_return(&s->ism->input_generations[device_id]);
+	s->ism->changed_input_generations[device_id] = generation;
+}
+
+static void *
+input_publisher_thread(void *ptr)
+{
+	struct ipc_server *s = (struct ipc_server *)ptr;
+	const int64_t period_ns = debug_get_num_option_publish_inputs_period_ms() * U_TIME_1MS_IN_NS;
+
+	os_thread_helper_lock(&s->inputs_thread);
+	while (os_thread_helper_is_running_locked(&s->inputs_thread)) {
+		for (uint32_t i = 0; i < XRT_SYSTEM_MAX_DEVICES; i++) {
+			publish_device_inputs_locked(s, i);
+		}
+
+		// Let update calls from clients in while sleeping.
+		os_thread_helper_unlock(&s->inputs_thread);
+		os_nanosleep(period_ns);
+		os_thread_helper_lock(&s->inputs_thread);
+	}
+	os_thread_helper_unlock(&s->inputs_thread);
+
+	return NULL;
+}
+
+static int
+init_input_publisher(struct ipc_server *s)
+{
+	// Opt-in, lets clients skip update calls when nothing has changed.
+	if (!debug_get_bool_option_publish_inputs()) {
+		return 0;
+	}
+
+	int ret = os_thread_helper_start(&s->inputs_thread, input_publisher_thread, s);
+	if (ret < 0) {
+		return ret;
+	}
+
+	os_thread_helper_name(&s->inputs_thread, "IPC Input Publisher");
+	s->publish_inputs = true;
+
+	return 0;
+}
+
 static int
 init_all(struct ipc_server *s, enum u_logging_level log_level)
 {
@@ -476,6 +683,29 @@ init_all(struct ipc_server *s, enum u_logging_level log_level)
 		return ret;
 	}
 
+	ret = os_mutex_init(&s->relations_lock);
+	if (ret < 0) {
+		IPC_ERROR(s, "Relations lock mutex failed to init!");
+		os_mutex_destroy(&s->global_state.lock);
+		return ret;
+	}
+
+	ret = os_thread_helper_init(&s->inputs_thread);
+	if (ret < 0) {
+		IPC_ERROR(s, "Inputs thread helper failed to init!");
+		os_mutex_destroy(&s->relations_lock);
+		os_mutex_destroy(&s->global_state.lock);
+		return ret;
+	}
+
+	long max_clients = debug_get_num_option_max_clients();
+	if (max_clients < 1 || max_clients > IPC_MAX_CLIENTS) {
+		IPC_WARN(s, "IPC_MAX_CLIENTS must be between 1 and %d, using 8.", IPC_MAX_CLIENTS);
+		max_clients = 8;
+	}
+	s->max_clients = (uint32_t)max_clients;
+	s->threads = U_TYPED_ARRAY_CALLOC(struct ipc_thread, s->max_clients);
+
 	s->process = u_process_create_if_not_running();
 
 	if (!s->process) {
@@ -488,14 +718,18 @@ init_all(struct ipc_server *s, enum u_logging_level log_level)
 	s->running = true;
 	s->exit_on_disconnect = debug_get_bool_option_exit_on_disconnect();
 
+	int32_t phase = u_startup_timeline_begin("Create instance");
 	xret = xrt_instance_create(NULL, &s->xinst);
+	u_startup_timeline_end(phase);
 	if (xret != XRT_SUCCESS) {
 		IPC_ERROR(s, "Failed to create instance!");
 		teardown_all(s);
 		return -1;
 	}
 
+	phase = u_startup_timeline_begin("Create system");
 	xret = xrt_instance_create_system(s->xinst, &s->xsys, &s->xsysd, &s->xso, &s->xsysc);
+	u_startup_timeline_end(phase);
 	if (xret != XRT_SUCCESS) {
 		IPC_ERROR(s, "Could not create system!");
 		teardown_all(s);
@@ -516,14 +750,25 @@ init_all(struct ipc_server *s, enum u_logging_level log_level)
 		return ret;
 	}
 
+	phase = u_startup_timeline_begin("Init shared memory");
 	ret = init_shm(s);
+	u_startup_timeline_end(phase);
 	if (ret < 0) {
 		IPC_ERROR(s, "Could not init shared memory!");
 		teardown_all(s);
 		return ret;
 	}
 
+	ret = init_input_publisher(s);
+	if (ret < 0) {
+		IPC_ERROR(s, "Failed to start input publisher thread!");
+		teardown_all(s);
+		return ret;
+	}
+
+	phase = u_startup_timeline_begin("Init main loop");
 	ret = ipc_server_mainloop_init(&s->ml);
+	u_startup_timeline_end(phase);
 	if (ret < 0) {
 		IPC_ERROR(s, "Failed to init ipc main loop!");
 		teardown_all(s);
@@ -628,7 +873,7 @@ handle_focused_client_events(volatile struct ipc_client_state *ics, int active_i
 static void
 flush_state_to_all_clients_locked(struct ipc_server *s)
 {
-	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+	for (uint32_t i = 0; i < s->max_clients; i++) {
 		volatile struct ipc_client_state *ics = &s->threads[i].ics;
 
 		// Not running?
@@ -673,7 +918,7 @@ update_server_state_locked(struct ipc_server *s)
 	int fallback_active_application = -1;
 
 	// do we have a fallback application?
-	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+	for (uint32_t i = 0; i < s->max_clients; i++) {
 		volatile struct ipc_client_state *ics = &s->threads[i].ics;
 		if (ics->client_state.session_overlay == false && ics->server_thread_index >= 0 &&
 		    ics->client_state.session_active) {
@@ -713,7 +958,7 @@ find_client_locked(struct ipc_server *s, uint32_t client_id)
 		return NULL;
 	}
 
-	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+	for (uint32_t i = 0; i < s->max_clients; i++) {
 		volatile struct ipc_client_state *ics = &s->threads[i].ics;
 
 		// Is this the client we are looking for?
@@ -735,14 +980,11 @@ find_client_locked(struct ipc_server *s, uint32_t client_id)
 	return NULL;
 }
 
-static xrt_result_t
-get_client_app_state_locked(struct ipc_server *s, uint32_t client_id, struct ipc_app_state *out_ias)
+static void
+fill_client_app_state_locked(struct ipc_server *s,
+                             volatile struct ipc_client_state *ics,
+                             struct ipc_app_state *out_ias)
 {
-	volatile struct ipc_client_state *ics = find_client_locked(s, client_id);
-	if (ics == NULL) {
-		return XRT_ERROR_IPC_FAILURE;
-	}
-
 	struct ipc_app_state ias = ics->client_state;
 	ias.io_active = ics->io_active;
 
@@ -756,7 +998,24 @@ get_client_app_state_locked(struct ipc_server *s, uint32_t client_id, struct ipc
 		ias.primary_application = true;
 	}
 
+	// Only clients with a session have a compositor.
+	U_ZERO(&ias.stats);
+	if (ics->xc != NULL) {
+		xrt_syscomp_get_client_stats(s->xsysc, ics->xc, &ias.stats);
+	}
+
 	*out_ias = ias;
+}
+
+static xrt_result_t
+get_client_app_state_locked(struct ipc_server *s, uint32_t client_id, struct ipc_app_state *out_ias)
+{
+	volatile struct ipc_client_state *ics = find_client_locked(s, client_id);
+	if (ics == NULL) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	fill_client_app_state_locked(s, ics, out_ias);
 
 	return XRT_SUCCESS;
 }
@@ -789,6 +1048,11 @@ toggle_io_client_locked(struct ipc_server *s, uint32_t client_id)
 
 	ics->io_active = !ics->io_active;
 
+	// Make the client fetch the inputs again, they go from or to being masked.
+	for (uint32_t i = 0; i < XRT_SYSTEM_MAX_DEVICES; i++) {
+		xrt_atomic_s32_inc_return(&s->ism->input_generations[i]);
+	}
+
 	return XRT_SUCCESS;
 }
 
@@ -809,6 +1073,31 @@ ipc_server_get_client_app_state(struct ipc_server *s, uint32_t client_id, struct
 	return xret;
 }
 
+xrt_result_t
+ipc_server_get_client_app_states(struct ipc_server *s, struct ipc_app_states *out_states)
+{
+	uint32_t count = 0;
+
+	os_mutex_lock(&s->global_state.lock);
+
+	for (uint32_t i = 0; i < s->max_clients; i++) {
+		volatile struct ipc_client_state *ics = &s->threads[i].ics;
+
+		// Is this thread running?
+		if (ics->server_thread_index < 0) {
+			continue;
+		}
+
+		fill_client_app_state_locked(s, ics, &out_states->states[count++]);
+	}
+
+	os_mutex_unlock(&s->global_state.lock);
+
+	out_states->count = count;
+
+	return XRT_SUCCESS;
+}
+
 xrt_result_t
 ipc_server_set_active_client(struct ipc_server *s, uint32_t client_id)
 {
@@ -912,8 +1201,14 @@ ipc_server_handle_client_connected(struct ipc_server *vs, xrt_ipc_handle_t ipc_h
 
 	// find the next free thread in our array (server_thread_index is -1)
 	// and have it handle this connection
-	for (uint32_t i = 0; i < IPC_MAX_CLIENTS; i++) {
+	for (uint32_t i = 0; i < vs->max_clients; i++) {
 		volatile struct ipc_client_state *_cs = &vs->threads[i].ics;
+
+		// Pooled clients have no thread to join, wait for the shutdown to finish.
+		if (_cs->pooled && vs->threads[i].state != IPC_THREAD_READY) {
+			continue;
+		}
+
 		if (_cs->server_thread_index < 0) {
 			ics = _cs;
 			cs_index = i;
@@ -964,6 +1259,25 @@ ipc_server_handle_client_connected(struct ipc_server *vs, xrt_ipc_handle_t ipc_h
 	ics->server_thread_index = cs_index;
 	ics->io_active = true;
 
+#if defined(XRT_OS_LINUX) && !defined(XRT_OS_ANDROID)
+	if (vs->ml.worker_group != NULL) {
+		ics->pooled = true;
+		it->state = IPC_THREAD_RUNNING;
+
+		if (ipc_server_mainloop_add_client(&vs->ml, ics) < 0) {
+			U_LOG_E("Failed to add client to the worker pool!");
+			xrt_ipc_handle_close(ipc_handle);
+			ics->imc.ipc_handle = XRT_IPC_HANDLE_INVALID;
+			ics->server_thread_index = -1;
+			it->state = IPC_THREAD_READY;
+		}
+
+		// Unlock when we are done.
+		os_mutex_unlock(&vs->global_state.lock);
+		return;
+	}
+#endif
+
 	os_thread_start(&it->thread, ipc_server_client_thread, (void *)ics);
 
 	// Unlock when we are done.
@@ -1001,7 +1315,9 @@ ipc_server_main(int argc, char **argv)
 	 */
 	u_debug_gui_create(&s->debug_gui);
 
+	int32_t phase = u_startup_timeline_begin("Service init");
 	int ret = init_all(s, log_level);
+	u_startup_timeline_end(phase);
 	if (ret < 0) {
 #ifdef XRT_OS_LINUX
 		// Print information how to debug issues.
@@ -1020,6 +1336,10 @@ ipc_server_main(int argc, char **argv)
 	// Print a very clear service started message.
 	print_linux_end_user_started_information(log_level);
 #endif
+
+	// Only printed if asked for.
+	u_startup_timeline_log();
+
 	// Main loop.
 	ret = main_loop(s);
 
@@ -1051,13 +1371,18 @@ ipc_server_main_android(struct ipc_server **ps, void (*startup_complete_callback
 	struct ipc_server *s = U_TYPED_CALLOC(struct ipc_server);
 	U_LOG_D("Created IPC server!");
 
+	int32_t phase = u_startup_timeline_begin("Service init");
 	int ret = init_all(s, log_level);
+	u_startup_timeline_end(phase);
 	if (ret < 0) {
 		free(s);
 		startup_complete_callback(data);
 		return ret;
 	}
 
+	// Only printed if asked for.
+	u_startup_timeline_log();
+
 	*ps = s;
 	startup_complete_callback(data);
 
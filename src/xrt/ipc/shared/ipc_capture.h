@@ -0,0 +1,80 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  File format for captured IPC call streams.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "shared/ipc_protocol.h"
+
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * First four bytes of a capture file, "MIPC" in little endian.
+ *
+ * @ingroup ipc_shared
+ */
+#define IPC_CAPTURE_MAGIC 0x4350494dU
+
+/*!
+ * Bumped whenever the layout of the file changes.
+ *
+ * @ingroup ipc_shared
+ */
+#define IPC_CAPTURE_VERSION 1
+
+/*!
+ * Value of @ref ipc_capture_record::reply_size for one-way calls.
+ *
+ * @ingroup ipc_shared
+ */
+#define IPC_CAPTURE_NO_REPLY UINT32_MAX
+
+/*!
+ * Start of a capture file, followed by any number of records.
+ *
+ * Command ids are only stable within a single build, so the git tag is
+ * recorded to detect replaying against a different service.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_capture_header
+{
+	uint32_t magic;
+	uint32_t version;
+	char u_git_tag[IPC_VERSION_NAME_LEN];
+};
+
+/*!
+ * A single call, followed by @ref msg_size bytes of the message exactly as it
+ * was sent to the service. Only calls without handles or extra payloads are
+ * captured, as only those can be replayed from a file.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_capture_record
+{
+	//! When the call was made, relative to the start of the capture.
+	uint64_t timestamp_ns;
+
+	//! Size of the message that follows.
+	uint32_t msg_size;
+
+	//! Size of the reply, or @ref IPC_CAPTURE_NO_REPLY.
+	uint32_t reply_size;
+};
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -25,6 +25,8 @@
 #include "xrt/xrt_tracking.h"
 #include "xrt/xrt_config_build.h"
 
+#include "math/m_hand_compact.h"
+
 #include <sys/types.h>
 
 
@@ -34,14 +36,17 @@
 #define IPC_MAX_FORMATS 32 // max formats our server-side compositor supports
 #define IPC_MAX_DEVICES 8  // max number of devices we will map using shared mem
 #define IPC_MAX_LAYERS 16
-#define IPC_MAX_SLOTS 128
-#define IPC_MAX_CLIENTS 8
-#define IPC_MAX_RAW_VIEWS 32 // Max views that we can get, artificial limit.
+#define IPC_MAX_CLIENT_SWAPCHAINS 32
+#define IPC_MAX_CLIENTS 32 // Upper bound, the service picks the real limit at startup.
+#define IPC_MAX_RAW_VIEWS 32     // Max views that we can get, artificial limit.
+#define IPC_MAX_LOCATE_SPACES 256 // Max spaces located in one call, clients split bigger batches.
 #define IPC_EVENT_QUEUE_SIZE 32
+#define IPC_MAX_COMMANDS 128        // Must be larger then the largest command id.
+#define IPC_LATENCY_BUCKET_COUNT 16 // Power of two microsecond buckets.
+#define IPC_TRACE_DUMP_PATH_LEN 256
+#define IPC_STARTUP_PHASE_NAME_LEN 64
 
-#define IPC_SHARED_MAX_INPUTS 1024
-#define IPC_SHARED_MAX_OUTPUTS 128
-#define IPC_SHARED_MAX_BINDINGS 64
+#define IPC_SHARED_MAX_RELATION_SAMPLES 4
 
 // example: v21.0.0-560-g586d33b5
 #define IPC_VERSION_NAME_LEN 64
@@ -93,6 +98,39 @@ struct ipc_shared_binding_profile
 	uint32_t first_output_index;
 };
 
+/*!
+ * A single timestamped relation in a @ref ipc_shared_relation_history.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_relation_sample
+{
+	uint64_t timestamp_ns;
+	struct xrt_space_relation relation;
+};
+
+/*!
+ * The latest relations of a space in the root space, written by the server
+ * and read without any locks or syscalls by the clients. Protected by a
+ * sequence lock, see @ref ipc_relation_history_publish.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_relation_history
+{
+	//! Sequence counter, odd while the server is writing, starts a cache line.
+	XRT_ALIGNAS(XRT_CACHE_LINE_SIZE) uint32_t seq;
+
+	//! Number of valid samples.
+	uint32_t sample_count;
+
+	//! Where the next sample will be written.
+	uint32_t next_index;
+
+	//! Not sorted, written in the order they were published.
+	struct ipc_shared_relation_sample samples[IPC_SHARED_MAX_RELATION_SAMPLES];
+};
+
 /*!
  * A device in the shared memory area.
  *
@@ -151,11 +189,13 @@ struct ipc_layer_entry
 	uint32_t xdev_id;
 
 	/*!
-	 * Up to two indices of swapchains to use.
+	 * Indices of swapchains to use, colour, then depth and then motion
+	 * vectors, one per view for projection layers.
 	 *
-	 * How many are actually used depends on the value of @p data.type
+	 * How many are actually used depends on the value of @p data.type and
+	 * @p data.flags.
 	 */
-	uint32_t swapchain_ids[XRT_MAX_VIEWS * 2];
+	uint32_t swapchain_ids[XRT_MAX_VIEWS * 3];
 
 	/*!
 	 * All basic (trivially-serializable) data associated with a layer,
@@ -164,6 +204,19 @@ struct ipc_layer_entry
 	struct xrt_layer_data data;
 };
 
+/*!
+ * Which images of a client's swapchains are not in use by the compositor,
+ * returned by the layer commit calls. The use of a image only goes down until
+ * the next commit, so the client can skip the wait call for these images.
+ *
+ * @ingroup ipc
+ */
+struct ipc_swapchain_image_states
+{
+	//! Bit per image, indexed by swapchain id.
+	uint32_t unused_masks[IPC_MAX_CLIENT_SWAPCHAINS];
+};
+
 /*!
  * Render state for a single client, including all layers.
  *
@@ -171,21 +224,72 @@ struct ipc_layer_entry
  */
 struct ipc_layer_slot
 {
-	struct xrt_layer_frame_data data;
+	//! Each slot starts a cache line, as neighbouring slots have different writers.
+	XRT_ALIGNAS(XRT_CACHE_LINE_SIZE) struct xrt_layer_frame_data data;
 	uint32_t layer_count;
 	struct ipc_layer_entry layers[IPC_MAX_LAYERS];
 };
 
+/*!
+ * Where the variable sized arrays live in the shared memory segment, the
+ * service sizes them at startup. All offsets are in bytes from the start of
+ * @ref ipc_shared_memory, use the accessor functions to get to the arrays.
+ *
+ * @ingroup ipc
+ */
+struct ipc_shared_layout
+{
+	//! Size of the whole segment in bytes.
+	uint32_t size;
+
+	uint32_t input_offset;
+	uint32_t input_count;
+
+	//! Words in the changed inputs bitmap, one bit per input.
+	uint32_t changed_input_offset;
+	uint32_t changed_input_count;
+
+	uint32_t output_offset;
+	uint32_t output_count;
+
+	uint32_t binding_profile_offset;
+	uint32_t binding_profile_count;
+
+	uint32_t input_pair_offset;
+	uint32_t input_pair_count;
+
+	uint32_t output_pair_offset;
+	uint32_t output_pair_count;
+
+	uint32_t slot_offset;
+	uint32_t slot_count;
+};
+
 /*!
  * A big struct that contains all data that is shared to a client, no pointers
- * allowed in this. To get the inputs of a device you go:
+ * allowed in this. The fixed size part is followed by the arrays described by
+ * @ref layout.
+ *
+ * Data is split by who writes it and when, so a write from one process never
+ * invalidates a cache line the other process is reading:
+ *
+ * - Startup: everything in the fixed part up to @ref input_generations, only
+ *   written by the service before any client connects.
+ * - Service, at runtime: @ref input_generations, @ref changed_input_generations
+ *   and @ref relations, each on their own cache lines. Clients only read these.
+ * - The inputs and changed inputs arrays are written by the service at
+ *   runtime, the outputs, binding profiles and pairs only at startup.
+ * - Clients: the slots array, each client writes to the slot it was handed
+ *   and every slot starts a new cache line.
+ *
+ * All arrays start on a cache line. To get the inputs of a device you go:
  *
  * ```C++
  * struct xrt_input *
  * helper(struct ipc_shared_memory *ism, uint32_t device_id, uint32_t input)
  * {
  * 	uint32_t index = ism->isdevs[device_id]->first_input_index + input;
- * 	return &ism->inputs[index];
+ * 	return &ipc_shared_memory_inputs(ism)[index];
  * }
  * ```
  *
@@ -198,6 +302,12 @@ struct ipc_shared_memory
 	 */
 	char u_git_tag[IPC_VERSION_NAME_LEN];
 
+	/*!
+	 * Where the variable sized arrays are, only valid if @ref u_git_tag
+	 * matches the client.
+	 */
+	struct ipc_shared_layout layout;
+
 	/*!
 	 * Number of elements in @ref itracks that are populated/valid.
 	 */
@@ -266,19 +376,125 @@ struct ipc_shared_memory
 		uint32_t blend_mode_count;
 	} hmd;
 
-	struct xrt_input inputs[IPC_SHARED_MAX_INPUTS];
+	uint64_t startup_timestamp;
+
+	/*!
+	 * Bumped by the service every time it publishes changed input values
+	 * for a device, same index as @ref isdevs. Kept together so a client
+	 * checking all of its devices touches as few cache lines as possible.
+	 */
+	XRT_ALIGNAS(XRT_CACHE_LINE_SIZE) xrt_atomic_s32_t input_generations[XRT_SYSTEM_MAX_DEVICES];
 
-	struct xrt_output outputs[IPC_SHARED_MAX_OUTPUTS];
+	/*!
+	 * The generation the bits of a device in the changed inputs bitmap
+	 * describe, set after @ref input_generations is bumped by the publisher.
+	 * The bits are the inputs that changed going to that generation from the
+	 * one before it, zero while they are being written. Same index as
+	 * @ref isdevs.
+	 */
+	xrt_atomic_s32_t changed_input_generations[XRT_SYSTEM_MAX_DEVICES];
 
-	struct ipc_shared_binding_profile binding_profiles[IPC_SHARED_MAX_BINDINGS];
-	struct xrt_binding_input_pair input_pairs[IPC_SHARED_MAX_INPUTS];
-	struct xrt_binding_output_pair output_pairs[IPC_SHARED_MAX_OUTPUTS];
+	/*!
+	 * Opt-in relations published by the server whenever it locates a
+	 * device, lets clients locate devices without a round trip if the
+	 * timestamp falls inside of the published samples.
+	 */
+	struct
+	{
+		//! Is the server publishing relations, set once at startup.
+		bool enabled;
 
-	struct ipc_layer_slot slots[IPC_MAX_SLOTS];
+		//! Device tracking spaces in the root space, same index as @ref isdevs.
+		struct ipc_shared_relation_history devices[XRT_SYSTEM_MAX_DEVICES];
 
-	uint64_t startup_timestamp;
+		//! Semantic spaces in the root space, indexed by @ref xrt_reference_space_type.
+		struct ipc_shared_relation_history semantic[XRT_SPACE_REFERENCE_TYPE_COUNT];
+	} relations;
 };
 
+// Helper for the accessor functions below.
+#define IPC_SHARED_ARRAY(ISM, TYPE, NAME) ((TYPE *)((uint8_t *)(ISM) + (ISM)->layout.NAME##_offset))
+
+/*!
+ * Inputs of all devices, @ref ipc_shared_layout::input_count long.
+ *
+ * @public @memberof ipc_shared_memory
+ */
+static inline struct xrt_input *
+ipc_shared_memory_inputs(struct ipc_shared_memory *ism)
+{
+	return IPC_SHARED_ARRAY(ism, struct xrt_input, input);
+}
+
+/*!
+ * Bitmap of inputs that changed in the last published generation, indexed the
+ * same as @ref ipc_shared_memory_inputs, see
+ * @ref ipc_shared_memory::changed_input_generations.
+ * @ref ipc_shared_layout::changed_input_count words long.
+ *
+ * @public @memberof ipc_shared_memory
+ */
+static inline uint32_t *
+ipc_shared_memory_changed_inputs(struct ipc_shared_memory *ism)
+{
+	return IPC_SHARED_ARRAY(ism, uint32_t, changed_input);
+}
+
+/*!
+ * Outputs of all devices, @ref ipc_shared_layout::output_count long.
+ *
+ * @public @memberof ipc_shared_memory
+ */
+static inline struct xrt_output *
+ipc_shared_memory_outputs(struct ipc_shared_memory *ism)
+{
+	return IPC_SHARED_ARRAY(ism, struct xrt_output, output);
+}
+
+/*!
+ * Binding profiles of all devices, @ref ipc_shared_layout::binding_profile_count long.
+ *
+ * @public @memberof ipc_shared_memory
+ */
+static inline struct ipc_shared_binding_profile *
+ipc_shared_memory_binding_profiles(struct ipc_shared_memory *ism)
+{
+	return IPC_SHARED_ARRAY(ism, struct ipc_shared_binding_profile, binding_profile);
+}
+
+/*!
+ * Input pairs of all binding profiles, @ref ipc_shared_layout::input_pair_count long.
+ *
+ * @public @memberof ipc_shared_memory
+ */
+static inline struct xrt_binding_input_pair *
+ipc_shared_memory_input_pairs(struct ipc_shared_memory *ism)
+{
+	return IPC_SHARED_ARRAY(ism, struct xrt_binding_input_pair, input_pair);
+}
+
+/*!
+ * Output pairs of all binding profiles, @ref ipc_shared_layout::output_pair_count long.
+ *
+ * @public @memberof ipc_shared_memory
+ */
+static inline struct xrt_binding_output_pair *
+ipc_shared_memory_output_pairs(struct ipc_shared_memory *ism)
+{
+	return IPC_SHARED_ARRAY(ism, struct xrt_binding_output_pair, output_pair);
+}
+
+/*!
+ * Layer slots shared by all clients, @ref ipc_shared_layout::slot_count long.
+ *
+ * @public @memberof ipc_shared_memory
+ */
+static inline struct ipc_layer_slot *
+ipc_shared_memory_slots(struct ipc_shared_memory *ism)
+{
+	return IPC_SHARED_ARRAY(ism, struct ipc_layer_slot, slot);
+}
+
 /*!
  * Initial info from a client when it connects.
  */
@@ -313,6 +529,86 @@ struct ipc_app_state
 	uint32_t z_order;
 	pid_t pid;
 	struct xrt_instance_info info;
+
+	//! Zeroed if the system compositor does not track GPU time per client.
+	struct xrt_multi_compositor_client_stats stats;
+};
+
+/*!
+ * State of all connected applications, so monitoring tools can get all of
+ * them with one call instead of one call per client.
+ *
+ * @ingroup ipc
+ */
+struct ipc_app_states
+{
+	struct ipc_app_state states[IPC_MAX_CLIENTS];
+	uint32_t count;
+};
+
+
+/*!
+ * Latency histogram for one command, bucket zero counts calls faster than one
+ * microsecond, bucket N calls that took at least 2^(N-1) microseconds and less
+ * than 2^N. The last bucket also counts everything slower than that.
+ *
+ * @ingroup ipc
+ */
+struct ipc_latency_histogram
+{
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint32_t buckets[IPC_LATENCY_BUCKET_COUNT];
+};
+
+/*!
+ * Statistics for one command, summed over all clients.
+ *
+ * @ingroup ipc
+ */
+struct ipc_command_stats
+{
+	//! Time spent by the service dispatching the command, including the reply.
+	struct ipc_latency_histogram server;
+
+	//! Time seen by the clients, from calling to having the reply.
+	struct ipc_latency_histogram client;
+};
+
+/*!
+ * Result of dumping the built-in trace recorder of the service.
+ *
+ * @ingroup ipc
+ */
+struct ipc_trace_dump_info
+{
+	//! Number of events written.
+	uint32_t event_count;
+
+	//! Where the trace was written, empty if the recorder is not enabled.
+	char path[IPC_TRACE_DUMP_PATH_LEN];
+};
+
+/*!
+ * One phase of the service starting up, fetched one at a time since the whole
+ * timeline does not fit in a message.
+ *
+ * @ingroup ipc
+ */
+struct ipc_startup_phase
+{
+	//! Number of recorded phases, the phase itself is zeroed if the index is not below this.
+	uint32_t count;
+
+	//! Number of phases that were running when this one began.
+	uint32_t depth;
+
+	//! Monotonic time, the end is zero if the phase has not ended yet.
+	uint64_t begin_ns;
+	uint64_t end_ns;
+
+	char name[IPC_STARTUP_PHASE_NAME_LEN];
 };
 
 
@@ -0,0 +1,257 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Sequence locked relation history in shared memory.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup ipc_shared
+ */
+
+#include "math/m_space.h"
+
+#include "shared/ipc_relation_history.h"
+
+#include <string.h>
+
+
+/*!
+ * How many times a reader tries to get a consistent copy before giving up and
+ * letting the caller go the slow path.
+ */
+#define READ_ATTEMPTS 8
+
+
+#if defined(__GNUC__)
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline uint32_t
+load_acquire(const uint32_t *ptr)
+{
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void
+store_relaxed(uint32_t *ptr, uint32_t value)
+{
+	__atomic_store_n(ptr, value, __ATOMIC_RELAXED);
+}
+
+static inline void
+store_release(uint32_t *ptr, uint32_t value)
+{
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+static inline void
+fence_acquire(void)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+
+static inline void
+fence_release(void)
+{
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void
+write_begin(struct ipc_shared_relation_history *irh)
+{
+	// Only one writer, so no need for a atomic increment.
+	store_relaxed(&irh->seq, irh->seq + 1);
+	fence_release();
+}
+
+static inline void
+write_end(struct ipc_shared_relation_history *irh)
+{
+	store_release(&irh->seq, irh->seq + 1);
+}
+
+static bool
+read_copy(const struct ipc_shared_relation_history *irh, struct ipc_shared_relation_history *out_copy)
+{
+	for (uint32_t i = 0; i < READ_ATTEMPTS; i++) {
+		uint32_t seq = load_acquire(&irh->seq);
+		if ((seq & 1) != 0) {
+			continue;
+		}
+
+		memcpy(out_copy, irh, sizeof(*out_copy));
+
+		fence_acquire();
+		if (seq == load_acquire(&irh->seq)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool
+find_and_interpolate(const struct ipc_shared_relation_history *copy,
+                     uint64_t timestamp_ns,
+                     struct xrt_space_relation *out_relation)
+{
+	const struct ipc_shared_relation_sample *before = NULL;
+	const struct ipc_shared_relation_sample *after = NULL;
+
+	uint32_t count = copy->sample_count;
+	if (count > IPC_SHARED_MAX_RELATION_SAMPLES) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+		const struct ipc_shared_relation_sample *sample = &copy->samples[i];
+
+		if (sample->timestamp_ns <= timestamp_ns &&
+		    (before == NULL || sample->timestamp_ns > before->timestamp_ns)) {
+			before = sample;
+		}
+
+		if (sample->timestamp_ns >= timestamp_ns &&
+		    (after == NULL || sample->timestamp_ns < after->timestamp_ns)) {
+			after = sample;
+		}
+	}
+
+	if (before == NULL || after == NULL) {
+		return false;
+	}
+
+	if (before == after) {
+		*out_relation = before->relation;
+		return true;
+	}
+
+	uint64_t range_ns = after->timestamp_ns - before->timestamp_ns;
+	float t = (float)((double)(timestamp_ns - before->timestamp_ns) / (double)range_ns);
+
+	struct xrt_space_relation a = before->relation;
+	struct xrt_space_relation b = after->relation;
+	enum xrt_space_relation_flags flags = (enum xrt_space_relation_flags)(a.relation_flags & b.relation_flags);
+
+	m_space_relation_interpolate(&a, &b, t, flags, out_relation);
+
+	return true;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+bool
+ipc_relation_history_is_supported(void)
+{
+	return true;
+}
+
+void
+ipc_relation_history_publish(struct ipc_shared_relation_history *irh,
+                             uint64_t timestamp_ns,
+                             const struct xrt_space_relation *relation)
+{
+	uint32_t count = irh->sample_count;
+	uint32_t index = irh->next_index % IPC_SHARED_MAX_RELATION_SAMPLES;
+	bool replace = false;
+
+	// Same timestamp as already published, newer data wins.
+	for (uint32_t i = 0; i < count; i++) {
+		if (irh->samples[i].timestamp_ns == timestamp_ns) {
+			index = i;
+			replace = true;
+			break;
+		}
+	}
+
+	write_begin(irh);
+
+	irh->samples[index].timestamp_ns = timestamp_ns;
+	irh->samples[index].relation = *relation;
+
+	if (!replace) {
+		irh->next_index = (index + 1) % IPC_SHARED_MAX_RELATION_SAMPLES;
+		if (count < IPC_SHARED_MAX_RELATION_SAMPLES) {
+			irh->sample_count = count + 1;
+		}
+	}
+
+	write_end(irh);
+}
+
+void
+ipc_relation_history_clear(struct ipc_shared_relation_history *irh)
+{
+	write_begin(irh);
+
+	irh->sample_count = 0;
+	irh->next_index = 0;
+
+	write_end(irh);
+}
+
+bool
+ipc_relation_history_get(const struct ipc_shared_relation_history *irh,
+                         uint64_t timestamp_ns,
+                         struct xrt_space_relation *out_relation)
+{
+	struct ipc_shared_relation_history copy;
+
+	if (!read_copy(irh, &copy)) {
+		return false;
+	}
+
+	return find_and_interpolate(&copy, timestamp_ns, out_relation);
+}
+
+
+#else // !defined(__GNUC__)
+
+/*
+ * No fences available, the server does not enable publishing and clients
+ * always go the slow path.
+ */
+
+bool
+ipc_relation_history_is_supported(void)
+{
+	return false;
+}
+
+void
+ipc_relation_history_publish(struct ipc_shared_relation_history *irh,
+                             uint64_t timestamp_ns,
+                             const struct xrt_space_relation *relation)
+{
+	(void)irh;
+	(void)timestamp_ns;
+	(void)relation;
+}
+
+void
+ipc_relation_history_clear(struct ipc_shared_relation_history *irh)
+{
+	(void)irh;
+}
+
+bool
+ipc_relation_history_get(const struct ipc_shared_relation_history *irh,
+                         uint64_t timestamp_ns,
+                         struct xrt_space_relation *out_relation)
+{
+	(void)irh;
+	(void)timestamp_ns;
+	(void)out_relation;
+
+	return false;
+}
+
+#endif
@@ -0,0 +1,72 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Sequence locked relation history in shared memory.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "xrt/xrt_defines.h"
+
+#include "shared/ipc_protocol.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Is publishing and reading of relation histories supported on this
+ * platform, needs compiler support for fences.
+ *
+ * @ingroup ipc_shared
+ */
+bool
+ipc_relation_history_is_supported(void);
+
+/*!
+ * Server side: add a sample to the history, replacing the oldest one if full.
+ * Samples with the same timestamp as one already published are replaced.
+ *
+ * Only one writer at a time, the caller needs to serialize calls to this
+ * function and @ref ipc_relation_history_clear.
+ *
+ * @public @memberof ipc_shared_relation_history
+ */
+void
+ipc_relation_history_publish(struct ipc_shared_relation_history *irh,
+                             uint64_t timestamp_ns,
+                             const struct xrt_space_relation *relation);
+
+/*!
+ * Server side: remove all samples, used when the relations have changed in
+ * a way that makes old samples invalid, like a recenter.
+ *
+ * @public @memberof ipc_shared_relation_history
+ */
+void
+ipc_relation_history_clear(struct ipc_shared_relation_history *irh);
+
+/*!
+ * Client side: get the relation at @p timestamp_ns, interpolating between the
+ * two closest samples. Never blocks, gives up if the server keeps writing.
+ *
+ * @return True if @p timestamp_ns was inside of the published samples.
+ * @public @memberof ipc_shared_relation_history
+ */
+bool
+ipc_relation_history_get(const struct ipc_shared_relation_history *irh,
+                         uint64_t timestamp_ns,
+                         struct xrt_space_relation *out_relation);
+
+
+#ifdef __cplusplus
+}
+#endif
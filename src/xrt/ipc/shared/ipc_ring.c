@@ -0,0 +1,483 @@
+// Copyright 2020-2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Shared memory request/reply ring used for hot IPC calls.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup ipc_shared
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include "os/os_time.h"
+
+#include "util/u_misc.h"
+#include "util/u_logging.h"
+
+#include "shared/ipc_ring.h"
+#include "shared/ipc_shmem.h"
+
+#include <string.h>
+#include <assert.h>
+
+
+/*
+ *
+ * Logging
+ *
+ */
+
+#define RING_ERROR(r, ...) U_LOG_IFL_E(r->log_level, __VA_ARGS__)
+
+
+#if defined(XRT_OS_LINUX)
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+
+
+/*
+ *
+ * Defines.
+ *
+ */
+
+/*!
+ * How long to busy wait for the other side before going to sleep, calls are
+ * typically issued back to back so this catches most of them. Only done if
+ * there is more then one core, otherwise we would just be delaying the other
+ * side from running.
+ */
+#define RING_SPIN_NS (50 * U_TIME_1US_IN_NS)
+
+//! How long to block before checking that the other side is still there.
+#define RING_WAIT_TIMEOUT_NS (100 * U_TIME_1MS_IN_NS)
+
+//! How long a producer will wait for space in the ring before giving up.
+#define RING_FULL_TIMEOUT_NS (U_TIME_1S_IN_NS)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static inline uint32_t
+load_acquire(const uint32_t *ptr)
+{
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+static inline void
+store_release(uint32_t *ptr, uint32_t value)
+{
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+static inline void
+store_seq_cst(uint32_t *ptr, uint32_t value)
+{
+	__atomic_store_n(ptr, value, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t
+load_seq_cst(const uint32_t *ptr)
+{
+	return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+}
+
+static inline void
+cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ volatile("yield");
+#endif
+}
+
+static int
+futex_wait(uint32_t *addr, uint32_t value, uint64_t timeout_ns)
+{
+	struct timespec ts;
+	os_ns_to_timespec(timeout_ns, &ts);
+
+	// Not FUTEX_PRIVATE_FLAG, the word lives in memory shared between processes.
+	return syscall(SYS_futex, addr, FUTEX_WAIT, value, &ts, NULL, 0);
+}
+
+static void
+futex_wake(uint32_t *addr)
+{
+	syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static bool
+is_peer_gone(struct ipc_message_channel *imc)
+{
+	struct pollfd pfd = {
+	    .fd = imc->ipc_handle,
+	    .events = 0,
+	};
+
+	int ret = poll(&pfd, 1, 0);
+	if (ret < 0) {
+		return errno != EINTR;
+	}
+
+	return (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)) != 0;
+}
+
+static uint64_t
+get_spin_ns(void)
+{
+	return sysconf(_SC_NPROCESSORS_ONLN) > 1 ? RING_SPIN_NS : 0;
+}
+
+static void
+spin_for_data(struct ipc_ring *ring, struct ipc_ring_queue *q)
+{
+	if (ring->spin_ns == 0) {
+		return;
+	}
+
+	uint64_t spin_until_ns = os_monotonic_get_ns() + ring->spin_ns;
+	while (load_acquire(&q->head) == load_acquire(&q->tail) && os_monotonic_get_ns() < spin_until_ns) {
+		cpu_relax();
+	}
+}
+
+static inline bool
+queue_has_data(struct ipc_ring_queue *q)
+{
+	return load_acquire(&q->head) != load_acquire(&q->tail);
+}
+
+static xrt_result_t
+queue_push(struct ipc_ring *ring, struct ipc_ring_queue *q, const void *data, size_t size)
+{
+	if (size == 0 || size > IPC_RING_SLOT_SIZE) {
+		RING_ERROR(ring, "Invalid message size %u!", (uint32_t)size);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	// Only we write the head.
+	uint32_t head = q->head;
+
+	// Wait for space, only happens if the consumer is falling behind.
+	uint64_t start_ns = 0;
+	while (head - load_acquire(&q->tail) >= IPC_RING_SLOT_COUNT) {
+		uint64_t now_ns = os_monotonic_get_ns();
+		if (start_ns == 0) {
+			start_ns = now_ns;
+		} else if (now_ns - start_ns > RING_FULL_TIMEOUT_NS) {
+			RING_ERROR(ring, "Timed out waiting for space in ring!");
+			return XRT_ERROR_IPC_FAILURE;
+		}
+		os_nanosleep(U_TIME_1US_IN_NS * 100);
+	}
+
+	struct ipc_ring_slot *slot = &q->slots[head % IPC_RING_SLOT_COUNT];
+	memcpy(slot->data, data, size);
+	slot->size = (uint32_t)size;
+
+	/*
+	 * Sequentially consistent so that the load of consumer_waiting below
+	 * can not be reordered before it, pairs with the consumer setting the
+	 * flag and then re-checking the head before sleeping.
+	 */
+	store_seq_cst(&q->head, head + 1);
+
+	return XRT_SUCCESS;
+}
+
+static bool
+queue_pop(struct ipc_ring_queue *q, void *out_data, size_t max_size, size_t *out_size)
+{
+	// Only we write the tail.
+	uint32_t tail = q->tail;
+
+	if (load_acquire(&q->head) == tail) {
+		return false;
+	}
+
+	struct ipc_ring_slot *slot = &q->slots[tail % IPC_RING_SLOT_COUNT];
+	uint32_t size = slot->size;
+	if (size > max_size) {
+		size = (uint32_t)max_size;
+	}
+	memcpy(out_data, slot->data, size);
+	*out_size = size;
+
+	store_release(&q->tail, tail + 1);
+
+	return true;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+xrt_result_t
+ipc_ring_create(struct ipc_ring *ring, enum u_logging_level log_level)
+{
+	assert(ring->shared == NULL);
+
+	xrt_shmem_handle_t shmem_handle = XRT_SHMEM_HANDLE_INVALID;
+	void *map = NULL;
+	const size_t size = sizeof(struct ipc_ring_shared);
+
+	ring->log_level = log_level;
+
+	xrt_result_t xret = ipc_shmem_create(size, &shmem_handle, &map);
+	if (xret != XRT_SUCCESS) {
+		RING_ERROR(ring, "Failed to create shared memory for ring!");
+		return xret;
+	}
+
+	int doorbell = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (doorbell < 0) {
+		RING_ERROR(ring, "eventfd failed: '%s'!", strerror(errno));
+		ipc_shmem_destroy(&shmem_handle, &map, size);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	memset(map, 0, size);
+
+	ring->shmem_handle = shmem_handle;
+	ring->doorbell_handle = doorbell;
+	ring->spin_ns = get_spin_ns();
+	ring->shared = (struct ipc_ring_shared *)map;
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_ring_import(struct ipc_ring *ring,
+                enum u_logging_level log_level,
+                xrt_shmem_handle_t shmem_handle,
+                xrt_shmem_handle_t doorbell_handle)
+{
+	assert(ring->shared == NULL);
+
+	void *map = NULL;
+
+	ring->log_level = log_level;
+
+	xrt_result_t xret = ipc_shmem_map(shmem_handle, sizeof(struct ipc_ring_shared), &map);
+	if (xret != XRT_SUCCESS) {
+		RING_ERROR(ring, "Failed to map ring shared memory!");
+		close(shmem_handle);
+		close(doorbell_handle);
+		return xret;
+	}
+
+	ring->shmem_handle = shmem_handle;
+	ring->doorbell_handle = doorbell_handle;
+	ring->spin_ns = get_spin_ns();
+	ring->shared = (struct ipc_ring_shared *)map;
+
+	return XRT_SUCCESS;
+}
+
+void
+ipc_ring_destroy(struct ipc_ring *ring)
+{
+	if (ring->shared == NULL) {
+		return;
+	}
+
+	void *map = ring->shared;
+	ipc_shmem_destroy(&ring->shmem_handle, &map, sizeof(struct ipc_ring_shared));
+
+	close(ring->doorbell_handle);
+	ring->doorbell_handle = -1;
+	ring->shared = NULL;
+}
+
+xrt_result_t
+ipc_ring_client_send(struct ipc_ring *ring, struct ipc_message_channel *imc, const void *data, size_t size)
+{
+	struct ipc_ring_queue *q = &ring->shared->requests;
+
+	xrt_result_t xret = queue_push(ring, q, data, size);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	// Only syscall if the server has gone to sleep.
+	if (load_seq_cst(&q->consumer_waiting) == 0) {
+		return XRT_SUCCESS;
+	}
+
+	uint64_t one = 1;
+	ssize_t ret = write(ring->doorbell_handle, &one, sizeof(one));
+	if (ret != sizeof(one) && errno != EAGAIN) {
+		RING_ERROR(ring, "Failed to ring doorbell: '%s'!", strerror(errno));
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_ring_client_receive(struct ipc_ring *ring, struct ipc_message_channel *imc, void *out_data, size_t size)
+{
+	struct ipc_ring_queue *q = &ring->shared->replies;
+	size_t read_size = 0;
+
+	// The server is usually fast, avoid the futex syscalls if we can.
+	spin_for_data(ring, q);
+
+	while (!queue_has_data(q)) {
+		uint32_t head = load_acquire(&q->head);
+		store_seq_cst(&q->consumer_waiting, 1);
+
+		// Re-check now that the flag is visible, pairs with queue_push.
+		if (load_seq_cst(&q->head) == head) {
+			int ret = futex_wait(&q->head, head, RING_WAIT_TIMEOUT_NS);
+			if (ret < 0 && errno == ETIMEDOUT && is_peer_gone(imc)) {
+				store_seq_cst(&q->consumer_waiting, 0);
+				RING_ERROR(ring, "Server went away while waiting for reply!");
+				return XRT_ERROR_IPC_FAILURE;
+			}
+		}
+
+		store_seq_cst(&q->consumer_waiting, 0);
+	}
+
+	if (!queue_pop(q, out_data, size, &read_size)) {
+		return XRT_ERROR_IPC_FAILURE; // Can't happen, we are the only consumer.
+	}
+
+	if (read_size != size) {
+		RING_ERROR(ring, "Wrong reply size '%u', expected '%u'!", (uint32_t)read_size, (uint32_t)size);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	return XRT_SUCCESS;
+}
+
+bool
+ipc_ring_server_pop(struct ipc_ring *ring, bool spin, void *out_buf, size_t *out_size)
+{
+	struct ipc_ring_queue *q = &ring->shared->requests;
+
+	// We are awake now, the client doesn't need to ring the doorbell.
+	if (q->consumer_waiting != 0) {
+		store_seq_cst(&q->consumer_waiting, 0);
+	}
+
+	if (spin) {
+		spin_for_data(ring, q);
+	}
+
+	return queue_pop(q, out_buf, IPC_BUF_SIZE, out_size);
+}
+
+xrt_result_t
+ipc_ring_server_reply(struct ipc_ring *ring, const void *data, size_t size)
+{
+	struct ipc_ring_queue *q = &ring->shared->replies;
+
+	xrt_result_t xret = queue_push(ring, q, data, size);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	if (load_seq_cst(&q->consumer_waiting) != 0) {
+		futex_wake(&q->head);
+	}
+
+	return XRT_SUCCESS;
+}
+
+bool
+ipc_ring_server_prepare_wait(struct ipc_ring *ring)
+{
+	struct ipc_ring_queue *q = &ring->shared->requests;
+
+	// Drain the doorbell, it is non-blocking so this is fine if empty.
+	uint64_t value = 0;
+	(void)!read(ring->doorbell_handle, &value, sizeof(value));
+
+	store_seq_cst(&q->consumer_waiting, 1);
+
+	// Re-check now that the flag is visible, pairs with queue_push.
+	if (load_seq_cst(&q->head) != load_seq_cst(&q->tail)) {
+		store_seq_cst(&q->consumer_waiting, 0);
+		return true;
+	}
+
+	return false;
+}
+
+#else // !XRT_OS_LINUX
+
+
+/*
+ *
+ * Not supported on this platform, everything goes over the socket.
+ *
+ */
+
+xrt_result_t
+ipc_ring_create(struct ipc_ring *ring, enum u_logging_level log_level)
+{
+	return XRT_ERROR_IPC_FAILURE;
+}
+
+xrt_result_t
+ipc_ring_import(struct ipc_ring *ring,
+                enum u_logging_level log_level,
+                xrt_shmem_handle_t shmem_handle,
+                xrt_shmem_handle_t doorbell_handle)
+{
+	return XRT_ERROR_IPC_FAILURE;
+}
+
+void
+ipc_ring_destroy(struct ipc_ring *ring)
+{
+	// Never active.
+}
+
+xrt_result_t
+ipc_ring_client_send(struct ipc_ring *ring, struct ipc_message_channel *imc, const void *data, size_t size)
+{
+	return XRT_ERROR_IPC_FAILURE;
+}
+
+xrt_result_t
+ipc_ring_client_receive(struct ipc_ring *ring, struct ipc_message_channel *imc, void *out_data, size_t size)
+{
+	return XRT_ERROR_IPC_FAILURE;
+}
+
+bool
+ipc_ring_server_pop(struct ipc_ring *ring, bool spin, void *out_buf, size_t *out_size)
+{
+	return false;
+}
+
+xrt_result_t
+ipc_ring_server_reply(struct ipc_ring *ring, const void *data, size_t size)
+{
+	return XRT_ERROR_IPC_FAILURE;
+}
+
+bool
+ipc_ring_server_prepare_wait(struct ipc_ring *ring)
+{
+	return false;
+}
+
+#endif // !XRT_OS_LINUX
@@ -0,0 +1,243 @@
+// Copyright 2020-2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Shared memory request/reply ring used for hot IPC calls.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "xrt/xrt_handles.h"
+#include "xrt/xrt_results.h"
+
+#include "util/u_logging.h"
+
+#include "shared/ipc_protocol.h"
+#include "shared/ipc_message_channel.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Number of messages that can be in flight in each direction of a ring.
+ *
+ * @ingroup ipc_shared
+ */
+#define IPC_RING_SLOT_COUNT 16
+
+/*!
+ * Largest message that fits in a slot, requests are bounded by
+ * @ref IPC_BUF_SIZE but replies can be larger. Calls with bigger replies keep
+ * going over the socket.
+ *
+ * @ingroup ipc_shared
+ */
+#define IPC_RING_SLOT_SIZE 4096
+
+/*!
+ * A single message in a @ref ipc_ring_queue.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_ring_slot
+{
+	//! Number of valid bytes in @ref data.
+	uint32_t size;
+
+	//! The message, same layout as what would be sent over the socket.
+	uint8_t data[IPC_RING_SLOT_SIZE];
+};
+
+/*!
+ * Single producer single consumer queue living in shared memory.
+ *
+ * The @ref head and @ref tail fields are free running counters, the slot
+ * index is the counter modulo @ref IPC_RING_SLOT_COUNT.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_ring_queue
+{
+	//! Incremented by the producer after a slot has been filled.
+	uint32_t head;
+
+	//! Incremented by the consumer after a slot has been read.
+	uint32_t tail;
+
+	//! Set by the consumer when it is about to block waiting for a message.
+	uint32_t consumer_waiting;
+
+	//! The message storage.
+	struct ipc_ring_slot slots[IPC_RING_SLOT_COUNT];
+};
+
+/*!
+ * The per client shared memory segment, requests flow from the client to the
+ * server and replies go the other way.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_ring_shared
+{
+	struct ipc_ring_queue requests;
+	struct ipc_ring_queue replies;
+};
+
+/*!
+ * Process local state for a ring, the server creates it and sends the shared
+ * memory and doorbell handles to the client which imports them.
+ *
+ * The server is woken up through the doorbell (a eventfd on Linux) so it can
+ * wait on both the ring and socket at the same time, the client is woken via a
+ * futex on the reply queue. Both sides spin for a short while before blocking
+ * so back to back calls do not need any syscalls at all.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_ring
+{
+	//! Mapping of the shared segment, NULL if the ring is not active.
+	struct ipc_ring_shared *shared;
+
+	//! Handle to the shared memory segment.
+	xrt_shmem_handle_t shmem_handle;
+
+	//! Handle used to wake up the server, only valid if @ref shared is set.
+	xrt_shmem_handle_t doorbell_handle;
+
+	//! How long to busy wait before blocking, zero on single core systems.
+	uint64_t spin_ns;
+
+	//! Logging level, for errors.
+	enum u_logging_level log_level;
+};
+
+/*!
+ * Is the ring set up and ready to be used.
+ *
+ * @public @memberof ipc_ring
+ */
+static inline bool
+ipc_ring_is_active(const struct ipc_ring *ring)
+{
+	return ring->shared != NULL;
+}
+
+/*!
+ * Create a new ring, done on the server side, the handles in the ring are then
+ * sent to the client.
+ *
+ * @public @memberof ipc_ring
+ */
+xrt_result_t
+ipc_ring_create(struct ipc_ring *ring, enum u_logging_level log_level);
+
+/*!
+ * Import a ring created by the server, takes ownership of the handles.
+ *
+ * @public @memberof ipc_ring
+ */
+xrt_result_t
+ipc_ring_import(struct ipc_ring *ring,
+                enum u_logging_level log_level,
+                xrt_shmem_handle_t shmem_handle,
+                xrt_shmem_handle_t doorbell_handle);
+
+/*!
+ * Unmap and close all handles of the ring, safe to call on a inactive ring.
+ *
+ * @public @memberof ipc_ring
+ */
+void
+ipc_ring_destroy(struct ipc_ring *ring);
+
+/*!
+ * Client side: post a request to the server, blocks if the ring is full.
+ *
+ * @param ring Ring to post on.
+ * @param imc  Socket channel of the same connection, used to detect the server
+ *             going away while blocking.
+ * @param data Message, must be no larger than @ref IPC_RING_SLOT_SIZE.
+ * @param size Size of message.
+ *
+ * @public @memberof ipc_ring
+ */
+xrt_result_t
+ipc_ring_client_send(struct ipc_ring *ring, struct ipc_message_channel *imc, const void *data, size_t size);
+
+/*!
+ * Client side: wait for and read the next reply, @p size must match the size
+ * of the reply the server sent.
+ *
+ * @public @memberof ipc_ring
+ */
+xrt_result_t
+ipc_ring_client_receive(struct ipc_ring *ring, struct ipc_message_channel *imc, void *out_data, size_t size);
+
+/*!
+ * Client side: helper that posts a request and waits for its reply.
+ *
+ * @public @memberof ipc_ring
+ */
+static inline xrt_result_t
+ipc_ring_client_call(struct ipc_ring *ring,
+                     struct ipc_message_channel *imc,
+                     const void *data,
+                     size_t size,
+                     void *out_reply,
+                     size_t reply_size)
+{
+	xrt_result_t xret = ipc_ring_client_send(ring, imc, data, size);
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	return ipc_ring_client_receive(ring, imc, out_reply, reply_size);
+}
+
+/*!
+ * Server side: pop the next request if there is one, never blocks. Spins for
+ * a short while if @p spin is true and the ring is empty.
+ *
+ * @param ring         Ring to read from.
+ * @param spin         Busy wait a little while for a request to show up.
+ * @param[out] out_buf Buffer of at least @ref IPC_BUF_SIZE bytes to copy to.
+ * @param[out] out_size Size of the message read.
+ *
+ * @return True if a message was read.
+ * @public @memberof ipc_ring
+ */
+bool
+ipc_ring_server_pop(struct ipc_ring *ring, bool spin, void *out_buf, size_t *out_size);
+
+/*!
+ * Server side: post a reply to the client, wakes it up if it is sleeping.
+ *
+ * @public @memberof ipc_ring
+ */
+xrt_result_t
+ipc_ring_server_reply(struct ipc_ring *ring, const void *data, size_t size);
+
+/*!
+ * Server side: called before blocking on the doorbell, clears any pending
+ * doorbell rings and tells the client that it needs to ring the doorbell.
+ *
+ * @return True if there are already requests waiting, do not block then.
+ * @public @memberof ipc_ring
+ */
+bool
+ipc_ring_server_prepare_wait(struct ipc_ring *ring);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,173 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Per client shared memory arena and framing for large IPC payloads.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup ipc_shared
+ */
+
+#include "util/u_misc.h"
+#include "util/u_logging.h"
+
+#include "shared/ipc_scratch.h"
+#include "shared/ipc_shmem.h"
+
+#include <string.h>
+#include <assert.h>
+
+
+#define SCRATCH_ERROR(imc, ...) U_LOG_IFL_E(imc->log_level, __VA_ARGS__)
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+setup_halves(struct ipc_scratch *scratch, void *map, size_t size, bool is_server)
+{
+	uint8_t *lower = (uint8_t *)map;
+	uint8_t *upper = lower + size / 2;
+
+	scratch->data = lower;
+	scratch->half_size = size / 2;
+	scratch->send_offset = 0;
+	scratch->send = is_server ? upper : lower;
+	scratch->recv = is_server ? lower : upper;
+}
+
+static size_t
+aligned_size(size_t size)
+{
+	return (size + 15) & ~(size_t)15;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+xrt_result_t
+ipc_scratch_create(struct ipc_scratch *scratch, size_t size)
+{
+	assert(scratch->data == NULL);
+
+	xrt_shmem_handle_t handle = XRT_SHMEM_HANDLE_INVALID;
+	void *map = NULL;
+
+	xrt_result_t xret = ipc_shmem_create(size, &handle, &map);
+	if (xret != XRT_SUCCESS) {
+		U_LOG_E("Failed to create shared memory for scratch arena!");
+		return xret;
+	}
+
+	scratch->handle = handle;
+	setup_halves(scratch, map, size, true);
+
+	return XRT_SUCCESS;
+}
+
+xrt_result_t
+ipc_scratch_import(struct ipc_scratch *scratch, xrt_shmem_handle_t handle, size_t size)
+{
+	assert(scratch->data == NULL);
+
+	void *map = NULL;
+
+	xrt_result_t xret = ipc_shmem_map(handle, size, &map);
+	if (xret != XRT_SUCCESS) {
+		U_LOG_E("Failed to map scratch arena shared memory!");
+		ipc_shmem_destroy(&handle, &map, size);
+		return xret;
+	}
+
+	scratch->handle = handle;
+	setup_halves(scratch, map, size, false);
+
+	return XRT_SUCCESS;
+}
+
+void
+ipc_scratch_destroy(struct ipc_scratch *scratch)
+{
+	if (scratch->data == NULL) {
+		return;
+	}
+
+	void *map = scratch->data;
+	ipc_shmem_destroy(&scratch->handle, &map, scratch->half_size * 2);
+
+	U_ZERO(scratch);
+	scratch->handle = XRT_SHMEM_HANDLE_INVALID;
+}
+
+xrt_result_t
+ipc_scratch_send(struct ipc_scratch *scratch, struct ipc_message_channel *imc, const void *data, size_t size)
+{
+	if (size > UINT32_MAX) {
+		SCRATCH_ERROR(imc, "Payload too large %zu!", size);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	struct ipc_varlen_header header = {
+	    .size = (uint32_t)size,
+	    .offset = IPC_VARLEN_INLINE,
+	};
+
+	if (ipc_scratch_is_active(scratch) && size > 0 && size <= scratch->half_size) {
+		// Wrap around if it doesn't fit after the last payload.
+		if (scratch->send_offset + size > scratch->half_size) {
+			scratch->send_offset = 0;
+		}
+
+		header.offset = (uint32_t)scratch->send_offset;
+		memcpy(scratch->send + scratch->send_offset, data, size);
+		scratch->send_offset += aligned_size(size);
+	}
+
+	xrt_result_t xret = ipc_send(imc, &header, sizeof(header));
+	if (xret != XRT_SUCCESS || header.offset != IPC_VARLEN_INLINE || size == 0) {
+		return xret;
+	}
+
+	return ipc_send(imc, data, size);
+}
+
+xrt_result_t
+ipc_scratch_receive(struct ipc_scratch *scratch, struct ipc_message_channel *imc, void *out_data, size_t size)
+{
+	struct ipc_varlen_header header = {0};
+
+	xrt_result_t xret = ipc_receive(imc, &header, sizeof(header));
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	if (header.size != size) {
+		SCRATCH_ERROR(imc, "Payload size mismatch, got %u expected %zu!", header.size, size);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	if (header.offset == IPC_VARLEN_INLINE) {
+		if (size == 0) {
+			return XRT_SUCCESS;
+		}
+		return ipc_receive(imc, out_data, size);
+	}
+
+	// Never trust the other side, the offset must be inside of its half.
+	if (!ipc_scratch_is_active(scratch) || header.offset > scratch->half_size ||
+	    size > scratch->half_size - header.offset) {
+		SCRATCH_ERROR(imc, "Invalid scratch payload offset %u size %u!", header.offset, header.size);
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	memcpy(out_data, scratch->recv + header.offset, size);
+
+	return XRT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Per client shared memory arena and framing for large IPC payloads.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "xrt/xrt_handles.h"
+#include "xrt/xrt_results.h"
+
+#include "shared/ipc_message_channel.h"
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Size of the whole arena, half of it is used for each direction.
+ *
+ * @ingroup ipc_shared
+ */
+#define IPC_SCRATCH_SIZE (256 * 1024)
+
+/*!
+ * Value of @ref ipc_varlen_header::offset when the payload follows the header
+ * on the channel instead of being in the arena.
+ *
+ * @ingroup ipc_shared
+ */
+#define IPC_VARLEN_INLINE UINT32_MAX
+
+/*!
+ * Sent over the channel in front of every variable length payload.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_varlen_header
+{
+	//! Size of payload in bytes.
+	uint32_t size;
+
+	//! Offset into the senders half of the arena, or @ref IPC_VARLEN_INLINE.
+	uint32_t offset;
+};
+
+/*!
+ * Process local state for the scratch arena. The server creates the arena and
+ * sends the handle to the client, the client writes to the first half and the
+ * server writes to the second half. Each side allocates from its own half in a
+ * wrapping fashion, since calls are synchronous the receiver has always copied
+ * out a payload before the sender gets around to reusing that space.
+ *
+ * @ingroup ipc_shared
+ */
+struct ipc_scratch
+{
+	//! Mapping of the whole arena, NULL if not active.
+	uint8_t *data;
+
+	//! Handle to the shared memory.
+	xrt_shmem_handle_t handle;
+
+	//! Start of the half we write to.
+	uint8_t *send;
+
+	//! Start of the half the other side writes to.
+	const uint8_t *recv;
+
+	//! Size of each half.
+	size_t half_size;
+
+	//! Where the next payload we send is placed in the send half.
+	size_t send_offset;
+};
+
+/*!
+ * Is the arena set up and ready to be used.
+ *
+ * @public @memberof ipc_scratch
+ */
+static inline bool
+ipc_scratch_is_active(const struct ipc_scratch *scratch)
+{
+	return scratch->data != NULL;
+}
+
+/*!
+ * Create the arena, done on the server side.
+ *
+ * @public @memberof ipc_scratch
+ */
+xrt_result_t
+ipc_scratch_create(struct ipc_scratch *scratch, size_t size);
+
+/*!
+ * Import a arena created by the server, takes ownership of the handle.
+ *
+ * @public @memberof ipc_scratch
+ */
+xrt_result_t
+ipc_scratch_import(struct ipc_scratch *scratch, xrt_shmem_handle_t handle, size_t size);
+
+/*!
+ * Unmap and close the arena, safe to call on a inactive arena.
+ *
+ * @public @memberof ipc_scratch
+ */
+void
+ipc_scratch_destroy(struct ipc_scratch *scratch);
+
+/*!
+ * Send a variable length payload, only a small header goes over the channel if
+ * the payload fits in the arena, otherwise the payload follows it inline. Works
+ * with an inactive arena, then all payloads are sent inline.
+ *
+ * @public @memberof ipc_scratch
+ */
+xrt_result_t
+ipc_scratch_send(struct ipc_scratch *scratch, struct ipc_message_channel *imc, const void *data, size_t size);
+
+/*!
+ * Receive a payload sent with @ref ipc_scratch_send, @p size must match the
+ * size given to the sender. The payload is copied out of the arena so the
+ * other side can not change it while it is being used.
+ *
+ * @public @memberof ipc_scratch
+ */
+xrt_result_t
+ipc_scratch_receive(struct ipc_scratch *scratch, struct ipc_message_channel *imc, void *out_data, size_t size);
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -10,6 +10,7 @@
  */
 
 #include <xrt/xrt_config_os.h>
+#include <xrt/xrt_compiler.h>
 
 #include "shared/ipc_shmem.h"
 
@@ -24,6 +25,7 @@
 // non-android unix
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <stdio.h>
 #endif
 
 #if defined(XRT_OS_ANDROID)
@@ -52,16 +54,28 @@ ipc_shmem_create(size_t size, xrt_shmem_handle_t *out_handle, void **out_map)
 #elif defined(XRT_OS_UNIX)
 
 #define MONADO_SHMEM_NAME "/monado_shm"
+
+//! Makes the names unique, more then one region can be created at the same time.
+static xrt_atomic_s32_t shmem_counter;
+
 // Impl for non-Android Unix.
 xrt_result_t
 ipc_shmem_create(size_t size, xrt_shmem_handle_t *out_handle, void **out_map)
 {
 	*out_handle = -1;
-	int fd = shm_open(MONADO_SHMEM_NAME, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+
+	char name[64];
+	int32_t counter = xrt_atomic_s32_inc_return(&shmem_counter);
+	snprintf(name, sizeof(name), MONADO_SHMEM_NAME "_%i_%i", (int)getpid(), counter);
+
+	int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
 	if (fd < 0) {
 		return XRT_ERROR_IPC_FAILURE;
 	}
 
+	// Don't need the name entry anymore, we can share the FD.
+	shm_unlink(name);
+
 	if (ftruncate(fd, size) < 0) {
 		close(fd);
 		return XRT_ERROR_IPC_FAILURE;
@@ -72,8 +86,6 @@ ipc_shmem_create(size_t size, xrt_shmem_handle_t *out_handle, void **out_map)
 		return result;
 	}
 
-	// Don't need the name entry anymore, we can share the FD.
-	shm_unlink(MONADO_SHMEM_NAME);
 	*out_handle = fd;
 	return XRT_SUCCESS;
 }
@@ -130,7 +142,7 @@ ipc_shmem_map(xrt_shmem_handle_t handle, size_t size, void **out_map)
 	const int access = PROT_READ | PROT_WRITE;
 	const int flags = MAP_SHARED;
 	void *ptr = mmap(NULL, size, access, flags, handle, 0);
-	if (ptr == NULL) {
+	if (ptr == MAP_FAILED) {
 		return XRT_ERROR_IPC_FAILURE;
 	}
 	*out_map = ptr;
@@ -147,6 +159,32 @@ ipc_shmem_unmap(void **map_ptr, size_t size)
 	*map_ptr = NULL;
 }
 
+xrt_result_t
+ipc_shmem_prefault(void *map, size_t size, bool lock)
+{
+	long page_size = sysconf(_SC_PAGESIZE);
+	if (page_size <= 0) {
+		page_size = 4096;
+	}
+
+#ifdef MADV_HUGEPAGE
+	// Best effort, only does something if transparent huge pages are enabled for shared memory.
+	(void)madvise(map, size, MADV_HUGEPAGE);
+#endif
+
+	// The region is new and zeroed, so writing zeros does not change it.
+	volatile uint8_t *bytes = (volatile uint8_t *)map;
+	for (size_t i = 0; i < size; i += (size_t)page_size) {
+		bytes[i] = 0;
+	}
+
+	if (lock && mlock(map, size) != 0) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	return XRT_SUCCESS;
+}
+
 #elif defined(XRT_OS_WINDOWS)
 
 void
@@ -188,6 +226,25 @@ ipc_shmem_unmap(void **map_ptr, size_t size)
 	*map_ptr = NULL;
 }
 
+xrt_result_t
+ipc_shmem_prefault(void *map, size_t size, bool lock)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	// The region is new and zeroed, so writing zeros does not change it.
+	volatile uint8_t *bytes = (volatile uint8_t *)map;
+	for (size_t i = 0; i < size; i += info.dwPageSize) {
+		bytes[i] = 0;
+	}
+
+	if (lock && !VirtualLock(map, size)) {
+		return XRT_ERROR_IPC_FAILURE;
+	}
+
+	return XRT_SUCCESS;
+}
+
 #else
 #error "OS not yet supported"
 #endif
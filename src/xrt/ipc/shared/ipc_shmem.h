@@ -63,6 +63,23 @@ ipc_shmem_map(xrt_shmem_handle_t handle, size_t size, void **out_map);
 void
 ipc_shmem_unmap(void **map_ptr, size_t size);
 
+/*!
+ * Back all of a freshly created region with memory, so that the first write
+ * to each page does not fault at some latency critical point later on. Also
+ * asks for huge pages where the platform can do that without configuration.
+ * Writes to every page, so call it before the region is shared.
+ *
+ * @param[in] map  Mapping of the region.
+ * @param[in] size Size of the region.
+ * @param[in] lock Also lock the region into memory so it is never paged out.
+ *
+ * @return XRT_ERROR_IPC_FAILURE if locking failed, the pages are still faulted in.
+ *
+ * @public @memberof xrt_shmem_handle_t
+ */
+xrt_result_t
+ipc_shmem_prefault(void *map, size_t size, bool lock);
+
 /*!
  * Destroy a handle to a shared memory region.
  *
@@ -0,0 +1,89 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Helpers for the per command IPC latency statistics.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup ipc_shared
+ */
+
+#pragma once
+
+#include "shared/ipc_protocol.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*!
+ * Which bucket of a @ref ipc_latency_histogram does @p duration_ns go into.
+ *
+ * @ingroup ipc_shared
+ */
+static inline uint32_t
+ipc_latency_histogram_bucket(uint64_t duration_ns)
+{
+	uint64_t us = duration_ns / 1000;
+	uint32_t bucket = 0;
+
+	while (us > 0 && bucket < IPC_LATENCY_BUCKET_COUNT - 1) {
+		us >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+/*!
+ * Add a single sample, histograms are only ever written by one thread at a time
+ * so no locking or atomics are used, readers may see slightly stale values.
+ *
+ * @public @memberof ipc_latency_histogram
+ */
+static inline void
+ipc_latency_histogram_add(struct ipc_latency_histogram *h, uint64_t duration_ns)
+{
+	h->count++;
+	h->total_ns += duration_ns;
+	if (duration_ns > h->max_ns) {
+		h->max_ns = duration_ns;
+	}
+	h->buckets[ipc_latency_histogram_bucket(duration_ns)]++;
+}
+
+/*!
+ * Add all samples from @p src to @p dst.
+ *
+ * @public @memberof ipc_latency_histogram
+ */
+static inline void
+ipc_latency_histogram_merge(struct ipc_latency_histogram *dst, const struct ipc_latency_histogram *src)
+{
+	dst->count += src->count;
+	dst->total_ns += src->total_ns;
+	if (src->max_ns > dst->max_ns) {
+		dst->max_ns = src->max_ns;
+	}
+	for (uint32_t i = 0; i < IPC_LATENCY_BUCKET_COUNT; i++) {
+		dst->buckets[i] += src->buckets[i];
+	}
+}
+
+/*!
+ * Add all samples from @p src to @p dst.
+ *
+ * @public @memberof ipc_command_stats
+ */
+static inline void
+ipc_command_stats_merge(struct ipc_command_stats *dst, const struct ipc_command_stats *src)
+{
+	ipc_latency_histogram_merge(&dst->server, &src->server);
+	ipc_latency_histogram_merge(&dst->client, &src->client);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -107,12 +107,13 @@ class Arg:
     """An IPC call argument."""
 
     # Keep all these synchronized with the definitions in the JSON Schema.
-    SCALAR_TYPES = set(("uint32_t",
+    SCALAR_TYPES = set(("int32_t",
+                        "uint32_t",
                         "int64_t",
                         "uint64_t",
                         "bool",
                         "float"))
-    AGGREGATE_RE = re.compile(r"((const )?struct|union) (xrt|ipc)_[a-z_]+")
+    AGGREGATE_RE = re.compile(r"((const )?struct|union) (xrt|ipc|m)_[a-z_]+")
     ENUM_RE = re.compile(r"enum xrt_[a-z_]+")
 
     @classmethod
@@ -287,6 +288,16 @@ class Call:
         """Decide whether this call needs a msg struct."""
         return self.in_args or self.in_handles
 
+    @property
+    def needs_reply(self):
+        """Decide whether the server sends a reply for this call."""
+        return not self.oneway
+
+    @property
+    def ring_capable(self):
+        """Decide whether this call can go over the shared memory ring."""
+        return not (self.varlen or self.in_handles or self.out_handles)
+
     def __init__(self, name, data):
         """Construct a call from call name and call data dictionary."""
         self.id = None
@@ -296,6 +307,7 @@ class Call:
         self.in_handles = None
         self.out_handles = None
         self.varlen = False
+        self.oneway = False
         for key, val in data.items():
             if key == 'id':
                 self.id = val
@@ -309,12 +321,17 @@ class Call:
                 self.in_handles = HandleType(val)
             elif key == 'varlen':
                 self.varlen = val
+            elif key == 'oneway':
+                self.oneway = val
             else:
                 raise RuntimeError("Unrecognized key")
         if not self.id:
             self.id = "IPC_" + name.upper()
         if self.varlen and (self.in_handles or self.out_handles):
             raise Exception("Can not have handles with varlen functions")
+        if self.oneway and (self.varlen or self.out_args or
+                            self.in_handles or self.out_handles):
+            raise Exception("One-way functions can only have in arguments")
 
 
 class Proto:
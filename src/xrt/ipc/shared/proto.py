@@ -21,6 +21,18 @@ header = '''// Copyright 2020-2023, Collabora, Ltd.
 '''
 
 
+def write_start_time(f):
+    """Write the start of the end-to-end latency measurement of a call."""
+    f.write("\n\t// Includes waiting for the lock, it is what the caller sees\n")
+    f.write("\tuint64_t _start_ns = os_monotonic_get_ns();\n")
+
+
+def write_record_time(f, call):
+    """Write the recording of the end-to-end latency, with the lock held."""
+    f.write("\tipc_client_record_call_locked(ipc_c, " + call.id +
+            ", os_monotonic_get_ns() - _start_ns);\n\n")
+
+
 def write_send_definition(f, call):
     """Write a ipc_send_CALLNAME_locked function."""
     call.write_send_decl(f)
@@ -55,6 +67,81 @@ def write_receive_definition(f, call):
     f.write("\n\treturn _reply.result;\n}\n")
 
 
+def write_ring_call_definition(f, call):
+    """Write a ipc_call_CALLNAME function that may use the shared memory ring."""
+    call.write_call_decl(f)
+    f.write("\n{\n")
+
+    f.write("\tIPC_TRACE(ipc_c, \"Calling " + call.name + "\");\n\n")
+
+    write_msg_struct(f, call, '\t')
+    write_reply_struct(f, call, '\t')
+    write_start_time(f)
+
+    f.write("""
+\t// Other threads must not read/write the fd or ring while we wait for reply
+\tos_mutex_lock(&ipc_c->mutex);
+""")
+    cleanup = "os_mutex_unlock(&ipc_c->mutex);"
+
+    f.write("\n\t// Send our request and await the reply, over the ring if set up")
+    write_invocation(
+        f,
+        'xrt_result_t ret',
+        'ipc_client_transact_locked',
+        (
+            'ipc_c',
+            '&_msg',
+            'sizeof(_msg)',
+            '&_reply',
+            'sizeof(_reply)'
+        ),
+        indent="\t"
+    )
+    f.write(';')
+    write_result_handler(f, 'ret', cleanup, indent="\t")
+    write_record_time(f, call)
+
+    for arg in call.out_args:
+        f.write("\t*out_" + arg.name + " = _reply." + arg.name + ";\n")
+    f.write("\n\t" + cleanup)
+    f.write("\n\treturn _reply.result;\n}\n")
+
+
+def write_oneway_call_definition(f, call):
+    """Write a ipc_call_CALLNAME function that does not wait for a reply."""
+    call.write_call_decl(f)
+    f.write("\n{\n")
+
+    f.write("\tIPC_TRACE(ipc_c, \"Calling " + call.name + "\");\n\n")
+
+    write_msg_struct(f, call, '\t')
+    write_start_time(f)
+
+    f.write("""
+\t// Other threads must not write the fd or ring at the same time
+\tos_mutex_lock(&ipc_c->mutex);
+""")
+
+    f.write("\n\t// No reply, errors are returned by the next call that has one")
+    write_invocation(
+        f,
+        'xrt_result_t ret',
+        'ipc_client_post_locked',
+        (
+            'ipc_c',
+            '&_msg',
+            'sizeof(_msg)'
+        ),
+        indent="\t"
+    )
+    f.write(';\n')
+    write_record_time(f, call)
+
+    f.write("\tos_mutex_unlock(&ipc_c->mutex);")
+    f.write("\n\treturn ret;\n}\n")
+
+
 def write_call_definition(f, call):
     """Write a ipc_call_CALLNAME function."""
     call.write_call_decl(f)
@@ -64,6 +151,7 @@ def write_call_definition(f, call):
 
     write_msg_struct(f, call, '\t')
     write_reply_struct(f, call, '\t')
+    write_start_time(f)
 
     f.write("""
 \t// Other threads must not read/write the fd while we wait for reply
@@ -124,6 +212,7 @@ def write_call_definition(f, call):
     write_invocation(f, 'ret', func, args, indent="\t")
     f.write(';')
     write_result_handler(f, 'ret', cleanup, indent="\t")
+    write_record_time(f, call)
 
     for arg in call.out_args:
         f.write("\t*out_" + arg.name + " = _reply." + arg.name + ";\n")
@@ -215,6 +304,8 @@ def generate_client_c(file, p):
     f = open(file, "w")
     f.write(header.format(brief='Generated IPC client code', suffix='_client'))
     f.write('''
+#include "os/os_time.h"
+
 #include "client/ipc_client.h"
 #include "ipc_protocol_generated.h"
 
@@ -226,6 +317,10 @@ def generate_client_c(file, p):
         if call.varlen:
             write_send_definition(f, call)
             write_receive_definition(f, call)
+        elif call.oneway:
+            write_oneway_call_definition(f, call)
+        elif call.ring_capable:
+            write_ring_call_definition(f, call)
         else:
             write_call_definition(f, call)
 
@@ -277,8 +372,12 @@ def generate_server_c(file, p):
 
 #include "ipc_server_generated.h"
 
+#include <assert.h>
+
 ''')
 
+    f.write('\nstatic_assert(%s < IPC_MAX_COMMANDS, "Increase IPC_MAX_COMMANDS");\n' % p.calls[-1].id)
+
     f.write('''
 xrt_result_t
 ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
@@ -297,7 +396,7 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
                 "\t\tstruct ipc_{}_msg *msg = ".format(call.name))
             f.write("(struct ipc_{}_msg *)ipc_command;\n".format(call.name))
 
-        if call.varlen:
+        if call.varlen or call.oneway:
             f.write("\t\t// No return arguments")
         elif call.out_args:
             f.write("\t\tstruct ipc_%s_reply reply = {0};\n" % call.name)
@@ -385,6 +484,8 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
         return_target = 'reply.result'
         if call.varlen:
             return_target = 'xrt_result_t xret'
+        elif call.oneway:
+            return_target = 'xrt_result_t result'
 
         write_invocation(f, return_target, 'ipc_handle_' +
                          call.name, args, indent="\t\t")
@@ -393,7 +494,21 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
         # TODO do we check reply.result and
         # error out before replying if it's not success?
 
-        if not call.varlen:
+        if call.needs_reply and not call.varlen:
+            # Report any failed one-way call made before this one.
+            f.write("\t\tipc_server_client_take_deferred_result(ics, &reply.result);\n")
+
+        if call.oneway:
+            # Nobody is waiting for the result, hand it to the next reply.
+            f.write("\t\tipc_server_client_defer_result(ics, result);\n")
+        elif call.ring_capable:
+            # Goes back the same way the command came in, ring or socket.
+            args = ["ics",
+                    "&reply",
+                    "sizeof(reply)"]
+            write_invocation(f, 'xrt_result_t xret', 'ipc_server_client_send_reply', args, indent="\t\t")
+            f.write(";")
+        elif not call.varlen:
             func = 'ipc_send'
             args = ["(struct ipc_message_channel *)&ics->imc",
                     "&reply",
@@ -404,7 +519,10 @@ ipc_dispatch(volatile struct ipc_client_state *ics, ipc_command_t *ipc_command)
             write_invocation(f, 'xrt_result_t xret', func, args, indent="\t\t")
             f.write(";")
 
-        f.write("\n\t\treturn xret;\n")
+        if call.oneway:
+            f.write("\n\t\treturn XRT_SUCCESS;\n")
+        else:
+            f.write("\n\t\treturn xret;\n")
         f.write("\t}\n")
     f.write('''\tdefault:
 \t\tU_LOG_E("UNHANDLED IPC MESSAGE! %d", *ipc_command);
@@ -433,6 +551,25 @@ ipc_command_size(const enum ipc_command cmd)
 \t}
 }
 
+''')
+
+    f.write('''
+bool
+ipc_command_is_ring_capable(const enum ipc_command cmd)
+{
+\tswitch (cmd) {
+''')
+
+    for call in p.calls:
+        if call.ring_capable:
+            f.write("\tcase " + call.id + ":\n")
+
+    f.write('''\t\treturn true;
+\tdefault:
+\t\treturn false;
+\t}
+}
+
 ''')
 
     f.close()
@@ -482,6 +619,16 @@ def generate_server_header(file, p):
     )
     f.write(";\n")
 
+    write_decl(
+        f,
+        "bool",
+        "ipc_command_is_ring_capable",
+        [
+            "const enum ipc_command cmd"
+        ]
+    )
+    f.write(";\n")
+
     for call in p.calls:
         call.write_handler_decl(f)
         f.write(";\n")
@@ -983,6 +983,9 @@ scene_destroy(struct gui_scene *scene, struct gui_program *p)
 	// Remove the sink interceptors.
 	u_var_visit(on_root_enter_sink, on_root_exit_sink, on_elem_sink_debug_remove, NULL);
 
+	// After the sinks are gone.
+	u_var_remove_observer();
+
 	if (ds->xfctx != NULL) {
 		xrt_frame_context_destroy_nodes(ds->xfctx);
 		ds->xfctx = NULL;
@@ -1011,5 +1014,8 @@ gui_scene_debug(struct gui_program *p)
 	ds->base.render = scene_render;
 	ds->base.destroy = scene_destroy;
 
+	// Lets code doing work only for the variables know someone is looking.
+	u_var_add_observer();
+
 	gui_scene_push_front(p, &ds->base);
 }
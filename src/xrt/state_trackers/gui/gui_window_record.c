@@ -52,73 +52,72 @@
  */
 
 #ifdef XRT_HAVE_GST
+
+/*!
+ * Frames the recording may fall behind before they are dropped, the drop count
+ * is shown so a recording can be checked for lost frames.
+ */
+#define RECORD_QUEUE_SIZE (16)
+
 static void
 create_pipeline(struct gui_record_window *rw)
 {
 	const char *source_name = "source_name";
-	const char *bitrate = NULL;
-	const char *speed_preset = NULL;
+	uint32_t bitrate = 0;
 
-	char pipeline_string[2048];
+	struct gstreamer_encoder_params params = {
+	    .encoder = GSTREAMER_ENCODER_SOFTWARE_H264,
+	    .appsrc_name = source_name,
+	    .filename = rw->gst.filename,
+	};
 
 	switch (rw->gst.bitrate) {
 	default:
-	case GUI_RECORD_BITRATE_32768: bitrate = "32768"; break;
-	case GUI_RECORD_BITRATE_4096: bitrate = "4096"; break;
-	case GUI_RECORD_BITRATE_2048: bitrate = "2048"; break;
-	case GUI_RECORD_BITRATE_1024: bitrate = "1024"; break;
+	case GUI_RECORD_BITRATE_32768: bitrate = 32768; break;
+	case GUI_RECORD_BITRATE_4096: bitrate = 4096; break;
+	case GUI_RECORD_BITRATE_2048: bitrate = 2048; break;
+	case GUI_RECORD_BITRATE_1024: bitrate = 1024; break;
 	}
 
 	switch (rw->gst.pipeline) {
-	case GUI_RECORD_PIPELINE_SOFTWARE_ULTRAFAST: speed_preset = "ultrafast"; break;
-	case GUI_RECORD_PIPELINE_SOFTWARE_VERYFAST: speed_preset = "veryfast"; break;
-	case GUI_RECORD_PIPELINE_SOFTWARE_FAST: speed_preset = "fast"; break;
-	case GUI_RECORD_PIPELINE_SOFTWARE_MEDIUM: speed_preset = "medium"; break;
-	case GUI_RECORD_PIPELINE_SOFTWARE_SLOW: speed_preset = "slow"; break;
-	case GUI_RECORD_PIPELINE_SOFTWARE_VERYSLOW: speed_preset = "veryslow"; break;
+	case GUI_RECORD_PIPELINE_SOFTWARE_ULTRAFAST: params.speed_preset = "ultrafast"; break;
+	case GUI_RECORD_PIPELINE_SOFTWARE_VERYFAST: params.speed_preset = "veryfast"; break;
+	case GUI_RECORD_PIPELINE_SOFTWARE_FAST: params.speed_preset = "fast"; break;
+	case GUI_RECORD_PIPELINE_SOFTWARE_MEDIUM: params.speed_preset = "medium"; break;
+	case GUI_RECORD_PIPELINE_SOFTWARE_SLOW: params.speed_preset = "slow"; break;
+	case GUI_RECORD_PIPELINE_SOFTWARE_VERYSLOW: params.speed_preset = "veryslow"; break;
+	case GUI_RECORD_PIPELINE_VAAPI_H246: params.encoder = GSTREAMER_ENCODER_VAAPI_H264; break;
+	case GUI_RECORD_PIPELINE_NVENC_H264: params.encoder = GSTREAMER_ENCODER_NVENC_H264; break;
+	case GUI_RECORD_PIPELINE_V4L2_H264: params.encoder = GSTREAMER_ENCODER_V4L2_H264; break;
 	default: break;
 	}
 
-	if (speed_preset != NULL) {
-		snprintf(pipeline_string,         //
-		         sizeof(pipeline_string), //
-		         "appsrc name=\"%s\" ! "
-		         "queue ! "
-		         "videoconvert ! "
-		         "queue ! "
-		         "x264enc bitrate=\"%s\" speed-preset=\"%s\" ! "
-		         "video/x-h264,profile=main ! "
-		         "h264parse ! "
-		         "queue ! "
-		         "mp4mux ! "
-		         "filesink location=\"%s\"",
-		         source_name, bitrate, speed_preset, rw->gst.filename);
-	} else {
-		snprintf(pipeline_string,         //
-		         sizeof(pipeline_string), //
-		         "appsrc name=\"%s\" ! "
-		         "queue ! "
-		         "videoconvert ! "
-		         "video/x-raw,format=NV12 ! "
-		         "queue ! "
-		         "vaapih264enc rate-control=cbr bitrate=\"%s\" tune=high-compression ! "
-		         "video/x-h264,profile=main ! "
-		         "h264parse ! "
-		         "queue ! "
-		         "mp4mux ! "
-		         "filesink location=\"%s\"",
-		         source_name, bitrate, rw->gst.filename);
+	switch (rw->gst.latency) {
+	default:
+	case GUI_RECORD_LATENCY_QUALITY: params.latency = GSTREAMER_ENCODER_LATENCY_QUALITY; break;
+	case GUI_RECORD_LATENCY_LOW: params.latency = GSTREAMER_ENCODER_LATENCY_LOW; break;
 	}
 
-	struct xrt_frame_sink *tmp = NULL;
-	struct gstreamer_pipeline *gp = NULL;
-
-	gstreamer_pipeline_create_from_string(&rw->gst.xfctx, pipeline_string, &gp);
+	params.bitrate_kbps = bitrate;
 
 	uint32_t width = rw->source.width;
 	uint32_t height = rw->source.height;
 	enum xrt_format format = rw->source.format;
 
+	// Only single plane formats can be described as a DMA-BUF by the sink.
+	bool dmabuf_format = format == XRT_FORMAT_YUYV422 || format == XRT_FORMAT_L8;
+
+	params.dmabuf = rw->gst.use_dmabuf && rw->source.has_buffer_handle && dmabuf_format &&
+	                gstreamer_encoder_supports_dmabuf(params.encoder);
+
+	struct xrt_frame_sink *tmp = NULL;
+	struct gstreamer_pipeline *gp = NULL;
+
+	if (!gstreamer_pipeline_create_encoder(&rw->gst.xfctx, &params, &gp)) {
+		U_LOG_E("Could not create recording pipeline!");
+		return;
+	}
+
 	bool do_convert = false;
 	if (format == XRT_FORMAT_MJPEG) {
 		format = XRT_FORMAT_R8G8B8;
@@ -126,16 +125,32 @@ create_pipeline(struct gui_record_window *rw)
 	}
 
 	struct gstreamer_sink *gs = NULL;
-	gstreamer_sink_create_with_pipeline(gp, width, height, format, source_name, &gs, &tmp);
+	if (params.dmabuf) {
+		gstreamer_sink_create_dmabuf_frames_with_pipeline(gp, width, height, format, source_name, &gs, &tmp);
+	} else {
+		gstreamer_sink_create_with_pipeline(gp, width, height, format, source_name, &gs, &tmp);
+	}
 	if (do_convert) {
 		u_sink_create_to_r8g8b8_or_l8(&rw->gst.xfctx, tmp, &tmp);
 	}
-	u_sink_simple_queue_create(&rw->gst.xfctx, tmp, &tmp);
+
+	/*
+	 * Keep the frames in order and count the ones that doesn't fit, with
+	 * DMA-BUFs the camera runs out of buffers before this queue is full.
+	 */
+	struct u_sink_queue_params queue_params = {
+	    .max_size = RECORD_QUEUE_SIZE,
+	    .drop_policy = U_SINK_QUEUE_DROP_NEWEST,
+	    .name = "Record Queue",
+	};
+	u_sink_queue_create_with_params(&rw->gst.xfctx, &queue_params, tmp, &tmp);
 
 	os_mutex_lock(&rw->gst.mutex);
 	rw->gst.gs = gs;
 	rw->gst.sink = tmp;
+	rw->gst.queue = tmp;
 	rw->gst.gp = gp;
+	rw->gst.dmabuf = params.dmabuf;
 	gstreamer_pipeline_play(rw->gst.gp);
 	os_mutex_unlock(&rw->gst.mutex);
 }
@@ -151,6 +166,14 @@ destroy_pipeline(struct gui_record_window *rw)
 	rw->gst.sink = NULL;
 	os_mutex_unlock(&rw->gst.mutex);
 
+	if (rw->gst.queue != NULL) {
+		uint64_t pushed = 0;
+		uint64_t dropped = 0;
+		u_sink_queue_get_counts(rw->gst.queue, &pushed, &dropped);
+		U_LOG_I("Recorded %" PRIu64 " frames, dropped %" PRIu64, pushed - dropped, dropped);
+		rw->gst.queue = NULL;
+	}
+
 	// Stop the pipeline.
 	gstreamer_pipeline_stop(rw->gst.gp);
 	rw->gst.gp = NULL;
@@ -173,9 +196,13 @@ draw_gst(struct gui_record_window *rw)
 	os_mutex_unlock(&rw->gst.mutex);
 
 	igComboStr("Pipeline", (int *)&rw->gst.pipeline,
-	           "SW Ultrafast\0SW Veryfast\0SW Fast\0SW Medium\0SW Slow\0SW Veryslow\0VAAPI H264\0\0", 5);
+	           "SW Ultrafast\0SW Veryfast\0SW Fast\0SW Medium\0SW Slow\0SW Veryslow\0"
+	           "VAAPI H264\0NVENC H264\0V4L2 H264\0\0",
+	           5);
 	igComboStr("Bitrate", (int *)&rw->gst.bitrate, "32768bps (Be careful!)\0004096bps\0002048bps\0001024bps\0\0",
 	           3);
+	igComboStr("Latency", (int *)&rw->gst.latency, "Quality\0Low latency\0\0", 2);
+	igCheckbox("Use DMA-BUF frames (VAAPI and V4L2 only)", &rw->gst.use_dmabuf);
 
 	igInputText("Filename", rw->gst.filename, sizeof(rw->gst.filename), 0, NULL, NULL);
 
@@ -185,6 +212,14 @@ draw_gst(struct gui_record_window *rw)
 
 	if (recording && igButton("Stop", button_dims)) {
 		destroy_pipeline(rw);
+		recording = false;
+	}
+
+	if (recording) {
+		uint64_t pushed = 0;
+		uint64_t dropped = 0;
+		u_sink_queue_get_counts(rw->gst.queue, &pushed, &dropped);
+		igText("Frames %" PRIu64 ", dropped %" PRIu64 "%s", pushed, dropped, rw->gst.dmabuf ? " (DMA-BUF)" : "");
 	}
 }
 #endif
@@ -257,6 +292,7 @@ window_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
 		rw->source.width = xf->width;
 		rw->source.height = xf->height;
 		rw->source.format = xf->format;
+		rw->source.has_buffer_handle = xf->has_buffer_handle;
 	}
 
 #ifdef XRT_HAVE_GST
@@ -293,6 +329,8 @@ gui_window_record_init(struct gui_record_window *rw)
 	snprintf(rw->gst.filename, sizeof(rw->gst.filename), "/tmp/capture.mp4");
 	rw->gst.bitrate = GUI_RECORD_BITRATE_4096;
 	rw->gst.pipeline = GUI_RECORD_PIPELINE_SOFTWARE_FAST;
+	rw->gst.latency = GUI_RECORD_LATENCY_QUALITY;
+	rw->gst.use_dmabuf = true;
 #endif
 
 
@@ -361,6 +399,7 @@ gui_window_record_close(struct gui_record_window *rw)
 		os_mutex_lock(&rw->gst.mutex);
 		rw->gst.gs = NULL;
 		rw->gst.sink = NULL;
+		rw->gst.queue = NULL;
 		os_mutex_unlock(&rw->gst.mutex);
 
 		gstreamer_pipeline_stop(rw->gst.gp);
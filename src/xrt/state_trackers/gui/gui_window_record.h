@@ -42,6 +42,14 @@ enum gui_record_pipeline
 	GUI_RECORD_PIPELINE_SOFTWARE_SLOW,
 	GUI_RECORD_PIPELINE_SOFTWARE_VERYSLOW,
 	GUI_RECORD_PIPELINE_VAAPI_H246,
+	GUI_RECORD_PIPELINE_NVENC_H264,
+	GUI_RECORD_PIPELINE_V4L2_H264,
+};
+
+enum gui_record_latency
+{
+	GUI_RECORD_LATENCY_QUALITY,
+	GUI_RECORD_LATENCY_LOW,
 };
 
 struct gui_record_window
@@ -52,6 +60,9 @@ struct gui_record_window
 	{
 		uint32_t width, height;
 		enum xrt_format format;
+
+		//! Do the frames have DMA-BUF buffer handles.
+		bool has_buffer_handle;
 	} source;
 
 	struct
@@ -72,11 +83,22 @@ struct gui_record_window
 
 		enum gui_record_pipeline pipeline;
 
+		enum gui_record_latency latency;
+
+		//! Give DMA-BUF frames straight to hardware encoders.
+		bool use_dmabuf;
+
+		//! Is the current recording fed DMA-BUFs.
+		bool dmabuf;
+
 		struct xrt_frame_context xfctx;
 
 		//! When not null we are recording.
 		struct xrt_frame_sink *sink;
 
+		//! The queue in front of the pipeline, its drop count shows lost frames.
+		struct xrt_frame_sink *queue;
+
 		//! Protects sink
 		struct os_mutex mutex;
 
@@ -18,6 +18,7 @@
 
 #include "oxr_api_funcs.h"
 #include "oxr_api_verify.h"
+#include "oxr_api_stats.h"
 #include "oxr_chain.h"
 #include "oxr_subaction.h"
 
@@ -129,7 +130,7 @@ process_dpad(struct oxr_logger *log,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrSyncActions(XrSession session, const XrActionsSyncInfo *syncInfo)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -170,7 +171,7 @@ oxr_xrSyncActions(XrSession session, const XrActionsSyncInfo *syncInfo)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrAttachSessionActionSets(XrSession session, const XrSessionActionSetsAttachInfo *bindInfo)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -202,7 +203,7 @@ XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrSuggestInteractionProfileBindings(XrInstance instance,
                                         const XrInteractionProfileSuggestedBinding *suggestedBindings)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -506,7 +507,7 @@ oxr_xrGetCurrentInteractionProfile(XrSession session,
                                    XrPath topLevelUserPath,
                                    XrInteractionProfileState *interactionProfile)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst = NULL;
 	struct oxr_session *sess = NULL;
@@ -559,7 +560,7 @@ oxr_xrGetInputSourceLocalizedName(XrSession session,
                                   uint32_t *bufferCountOutput,
                                   char *buffer)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst = NULL;
 	struct oxr_session *sess;
@@ -615,7 +616,7 @@ oxr_xrGetInputSourceLocalizedName(XrSession session,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrCreateActionSet(XrInstance instance, const XrActionSetCreateInfo *createInfo, XrActionSet *actionSet)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_action_set *act_set = NULL;
 	struct oxr_instance *inst = NULL;
@@ -666,7 +667,7 @@ oxr_xrCreateActionSet(XrInstance instance, const XrActionSetCreateInfo *createIn
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroyActionSet(XrActionSet actionSet)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_action_set *act_set;
 	struct oxr_logger log;
@@ -685,7 +686,7 @@ oxr_xrDestroyActionSet(XrActionSet actionSet)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrCreateAction(XrActionSet actionSet, const XrActionCreateInfo *createInfo, XrAction *action)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_action_set *act_set;
 	struct u_hashset_item *d = NULL;
@@ -750,7 +751,7 @@ oxr_xrCreateAction(XrActionSet actionSet, const XrActionCreateInfo *createInfo,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroyAction(XrAction action)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_action *act;
 	struct oxr_logger log;
@@ -762,7 +763,7 @@ oxr_xrDestroyAction(XrAction action)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrGetActionStateBoolean(XrSession session, const XrActionStateGetInfo *getInfo, XrActionStateBoolean *data)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess = NULL;
 	struct oxr_action *act = NULL;
@@ -791,7 +792,7 @@ oxr_xrGetActionStateBoolean(XrSession session, const XrActionStateGetInfo *getIn
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrGetActionStateFloat(XrSession session, const XrActionStateGetInfo *getInfo, XrActionStateFloat *data)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess = NULL;
 	struct oxr_action *act = NULL;
@@ -820,7 +821,7 @@ oxr_xrGetActionStateFloat(XrSession session, const XrActionStateGetInfo *getInfo
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrGetActionStateVector2f(XrSession session, const XrActionStateGetInfo *getInfo, XrActionStateVector2f *data)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess = NULL;
 	struct oxr_action *act = NULL;
@@ -849,7 +850,7 @@ oxr_xrGetActionStateVector2f(XrSession session, const XrActionStateGetInfo *getI
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrGetActionStatePose(XrSession session, const XrActionStateGetInfo *getInfo, XrActionStatePose *data)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess = NULL;
 	struct oxr_action *act = NULL;
@@ -882,7 +883,7 @@ oxr_xrEnumerateBoundSourcesForAction(XrSession session,
                                      uint32_t *sourceCountOutput,
                                      XrPath *sources)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess = NULL;
 	struct oxr_action *act = NULL;
@@ -914,7 +915,7 @@ oxr_xrApplyHapticFeedback(XrSession session,
                           const XrHapticActionInfo *hapticActionInfo,
                           const XrHapticBaseHeader *hapticEvent)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess = NULL;
 	struct oxr_action *act = NULL;
@@ -943,7 +944,7 @@ oxr_xrApplyHapticFeedback(XrSession session,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrStopHapticFeedback(XrSession session, const XrHapticActionInfo *hapticActionInfo)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess = NULL;
 	struct oxr_action *act = NULL;
@@ -14,13 +14,14 @@
 
 #include "oxr_api_funcs.h"
 #include "oxr_api_verify.h"
+#include "oxr_api_stats.h"
 
 
 
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrSetDebugUtilsObjectNameEXT(XrInstance instance, const XrDebugUtilsObjectNameInfoEXT *nameInfo)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -34,7 +35,7 @@ oxr_xrCreateDebugUtilsMessengerEXT(XrInstance instance,
                                    const XrDebugUtilsMessengerCreateInfoEXT *createInfo,
                                    XrDebugUtilsMessengerEXT *messenger)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_debug_messenger *mssngr;
@@ -58,7 +59,7 @@ oxr_xrCreateDebugUtilsMessengerEXT(XrInstance instance,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroyDebugUtilsMessengerEXT(XrDebugUtilsMessengerEXT messenger)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_debug_messenger *mssngr;
 	struct oxr_logger log;
@@ -74,7 +75,7 @@ oxr_xrSubmitDebugUtilsMessageEXT(XrInstance instance,
                                  XrDebugUtilsMessageTypeFlagsEXT messageTypes,
                                  const XrDebugUtilsMessengerCallbackDataEXT *callbackData)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -88,7 +89,7 @@ oxr_xrSubmitDebugUtilsMessageEXT(XrInstance instance,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrSessionBeginDebugUtilsLabelRegionEXT(XrSession session, const XrDebugUtilsLabelEXT *labelInfo)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -102,7 +103,7 @@ oxr_xrSessionBeginDebugUtilsLabelRegionEXT(XrSession session, const XrDebugUtils
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrSessionEndDebugUtilsLabelRegionEXT(XrSession session)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -116,7 +117,7 @@ oxr_xrSessionEndDebugUtilsLabelRegionEXT(XrSession session)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrSessionInsertDebugUtilsLabelEXT(XrSession session, const XrDebugUtilsLabelEXT *labelInfo)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -0,0 +1,57 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Foveation profile entrypoints for the OpenXR state tracker.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup oxr_api
+ */
+
+#include "util/u_trace_marker.h"
+
+#include "oxr_objects.h"
+#include "oxr_logger.h"
+#include "oxr_handle.h"
+
+#include "oxr_api_funcs.h"
+#include "oxr_api_verify.h"
+#include "oxr_api_stats.h"
+
+
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrCreateFoveationProfileFB(XrSession session,
+                               const XrFoveationProfileCreateInfoFB *createInfo,
+                               XrFoveationProfileFB *profile)
+{
+	OXR_API_MARKER();
+
+	struct oxr_session *sess;
+	struct oxr_logger log;
+	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrCreateFoveationProfileFB");
+	OXR_VERIFY_SESSION_NOT_LOST(&log, sess);
+	OXR_VERIFY_EXTENSION(&log, sess->sys->inst, FB_foveation);
+	OXR_VERIFY_ARG_TYPE_AND_NOT_NULL(&log, createInfo, XR_TYPE_FOVEATION_PROFILE_CREATE_INFO_FB);
+	OXR_VERIFY_ARG_NOT_NULL(&log, profile);
+
+	struct oxr_foveation_profile *fp = NULL;
+	XrResult ret = oxr_foveation_profile_create(&log, sess, createInfo, &fp);
+	if (ret != XR_SUCCESS) {
+		return ret;
+	}
+
+	*profile = oxr_foveation_profile_to_openxr(fp);
+
+	return oxr_session_success_result(sess);
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrDestroyFoveationProfileFB(XrFoveationProfileFB profile)
+{
+	OXR_API_MARKER();
+
+	struct oxr_foveation_profile *fp;
+	struct oxr_logger log;
+	OXR_VERIFY_FOVEATION_PROFILE_AND_INIT_LOG(&log, profile, fp, "xrDestroyFoveationProfileFB");
+
+	return oxr_handle_destroy(&log, &fp->handle);
+}
@@ -326,6 +326,14 @@ oxr_xrPerfSettingsSetPerformanceLevelEXT(XrSession session,
                                          XrPerfSettingsLevelEXT level);
 #endif // OXR_HAVE_EXT_performance_settings
 
+#ifdef OXR_HAVE_META_recommended_layer_resolution
+//! OpenXR API function @ep{xrGetRecommendedLayerResolutionMETA}
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrGetRecommendedLayerResolutionMETA(XrSession session,
+                                        const XrRecommendedLayerResolutionGetInfoMETA *info,
+                                        XrRecommendedLayerResolutionMETA *resolution);
+#endif // OXR_HAVE_META_recommended_layer_resolution
+
 #ifdef OXR_HAVE_EXT_thermal_query
 //! OpenXR API function @ep{xrThermalGetTemperatureTrendEXT}
 XRAPI_ATTR XrResult XRAPI_CALL
@@ -366,6 +374,12 @@ oxr_xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroySpace(XrSpace space);
 
+#ifdef OXR_HAVE_KHR_locate_spaces
+//! OpenXR API function @ep{xrLocateSpacesKHR}
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrLocateSpacesKHR(XrSession session, const XrSpacesLocateInfoKHR *locateInfo, XrSpaceLocationsKHR *spaceLocations);
+#endif // OXR_HAVE_KHR_locate_spaces
+
 
 /*
  *
@@ -407,6 +421,16 @@ oxr_xrWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo *
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo *releaseInfo);
 
+#ifdef OXR_HAVE_FB_swapchain_update_state
+//! OpenXR API function @ep{xrUpdateSwapchainFB}
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrUpdateSwapchainFB(XrSwapchain swapchain, const XrSwapchainStateBaseHeaderFB *state);
+
+//! OpenXR API function @ep{xrGetSwapchainStateFB}
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrGetSwapchainStateFB(XrSwapchain swapchain, XrSwapchainStateBaseHeaderFB *state);
+#endif // OXR_HAVE_FB_swapchain_update_state
+
 
 /*
  *
@@ -610,6 +634,23 @@ XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrPassthroughStartFB(XrPassthroughFB passthrough);
 #endif
 
+/*
+ *
+ * oxr_api_foveation.c
+ *
+ */
+#ifdef OXR_HAVE_FB_foveation
+//! OpenXR API function @ep{xrCreateFoveationProfileFB}
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrCreateFoveationProfileFB(XrSession session,
+                               const XrFoveationProfileCreateInfoFB *createInfo,
+                               XrFoveationProfileFB *profile);
+
+//! OpenXR API function @ep{xrDestroyFoveationProfileFB}
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrDestroyFoveationProfileFB(XrFoveationProfileFB profile);
+#endif // OXR_HAVE_FB_foveation
+
 #ifdef OXR_HAVE_HTC_facial_tracking
 //! OpenXR API function @ep{xrCreateFacialTrackerHTC}
 XRAPI_ATTR XrResult XRAPI_CALL
@@ -20,6 +20,7 @@
 
 #include "oxr_api_funcs.h"
 #include "oxr_api_verify.h"
+#include "oxr_api_stats.h"
 
 
 #ifdef XRT_OS_ANDROID
@@ -45,7 +46,7 @@ oxr_xrEnumerateInstanceExtensionProperties(const char *layerName,
                                            uint32_t *propertyCountOutput,
                                            XrExtensionProperties *properties)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_logger log;
 	oxr_log_init(&log, "xrEnumerateInstanceExtensionProperties");
@@ -58,6 +59,8 @@ oxr_xrEnumerateInstanceExtensionProperties(const char *layerName,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrInitializeLoaderKHR(const XrLoaderInitInfoBaseHeaderKHR *loaderInitInfo)
 {
+	OXR_API_MARKER();
+
 	struct oxr_logger log;
 	oxr_log_init(&log, "oxr_xrInitializeLoaderKHR");
 
@@ -132,7 +135,7 @@ oxr_check_android_extensions(struct oxr_logger *log,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrCreateInstance(const XrInstanceCreateInfo *createInfo, XrInstance *out_instance)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	XrResult ret;
 	struct oxr_logger log;
@@ -210,7 +213,7 @@ oxr_xrCreateInstance(const XrInstanceCreateInfo *createInfo, XrInstance *out_ins
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroyInstance(XrInstance instance)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -222,7 +225,7 @@ oxr_xrDestroyInstance(XrInstance instance)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrGetInstanceProperties(XrInstance instance, XrInstanceProperties *instanceProperties)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -234,7 +237,7 @@ oxr_xrGetInstanceProperties(XrInstance instance, XrInstanceProperties *instanceP
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrPollEvent(XrInstance instance, XrEventDataBuffer *eventData)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -247,7 +250,7 @@ oxr_xrPollEvent(XrInstance instance, XrEventDataBuffer *eventData)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrResultToString(XrInstance instance, XrResult value, char buffer[XR_MAX_RESULT_STRING_SIZE])
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -270,7 +273,7 @@ oxr_xrResultToString(XrInstance instance, XrResult value, char buffer[XR_MAX_RES
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrStructureTypeToString(XrInstance instance, XrStructureType value, char buffer[XR_MAX_STRUCTURE_NAME_SIZE])
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -291,7 +294,7 @@ oxr_xrStructureTypeToString(XrInstance instance, XrStructureType value, char buf
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrStringToPath(XrInstance instance, const char *pathString, XrPath *out_path)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -318,7 +321,7 @@ XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrPathToString(
     XrInstance instance, XrPath path, uint32_t bufferCapacityInput, uint32_t *bufferCountOutput, char *buffer)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -347,7 +350,7 @@ oxr_xrPathToString(
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrConvertTimespecTimeToTimeKHR(XrInstance instance, const struct timespec *timespecTime, XrTime *time)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	//! @todo do we need to check and see if this extension was
 	//! enabled first?
@@ -363,7 +366,7 @@ oxr_xrConvertTimespecTimeToTimeKHR(XrInstance instance, const struct timespec *t
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrConvertTimeToTimespecTimeKHR(XrInstance instance, XrTime time, struct timespec *timespecTime)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -387,7 +390,7 @@ oxr_xrConvertWin32PerformanceCounterToTimeKHR(XrInstance instance,
                                               const LARGE_INTEGER *performanceCounter,
                                               XrTime *time)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	//! @todo do we need to check and see if this extension was
 	//! enabled first?
@@ -410,7 +413,7 @@ oxr_xrConvertWin32PerformanceCounterToTimeKHR(XrInstance instance,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrConvertTimeToWin32PerformanceCounterKHR(XrInstance instance, XrTime time, LARGE_INTEGER *performanceCounter)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -22,6 +22,7 @@
 
 #include "oxr_api_funcs.h"
 #include "oxr_api_verify.h"
+#include "oxr_api_stats.h"
 
 
 
@@ -90,6 +91,8 @@ oxr_xrEnumerateApiLayerProperties(uint32_t propertyCapacityInput,
                                   uint32_t *propertyCountOutput,
                                   XrApiLayerProperties *properties)
 {
+	OXR_API_MARKER();
+
 	struct oxr_logger log;
 	oxr_log_init(&log, "xrEnumerateApiLayerProperties");
 
@@ -262,6 +265,20 @@ handle_non_null(struct oxr_instance *inst, struct oxr_logger *log, const char *n
 	ENTRY_IF_EXT(xrPassthroughStartFB, FB_passthrough);
 #endif // OXR_HAVE_FB_passthrough
 
+#ifdef OXR_HAVE_FB_foveation
+	ENTRY_IF_EXT(xrCreateFoveationProfileFB, FB_foveation);
+	ENTRY_IF_EXT(xrDestroyFoveationProfileFB, FB_foveation);
+#endif // OXR_HAVE_FB_foveation
+
+#ifdef OXR_HAVE_FB_swapchain_update_state
+	ENTRY_IF_EXT(xrUpdateSwapchainFB, FB_swapchain_update_state);
+	ENTRY_IF_EXT(xrGetSwapchainStateFB, FB_swapchain_update_state);
+#endif // OXR_HAVE_FB_swapchain_update_state
+
+#ifdef OXR_HAVE_META_recommended_layer_resolution
+	ENTRY_IF_EXT(xrGetRecommendedLayerResolutionMETA, META_recommended_layer_resolution);
+#endif // OXR_HAVE_META_recommended_layer_resolution
+
 #ifdef OXR_HAVE_EXT_debug_utils
 	ENTRY_IF_EXT(xrSetDebugUtilsObjectNameEXT, EXT_debug_utils);
 	ENTRY_IF_EXT(xrCreateDebugUtilsMessengerEXT, EXT_debug_utils);
@@ -272,6 +289,10 @@ handle_non_null(struct oxr_instance *inst, struct oxr_logger *log, const char *n
 	ENTRY_IF_EXT(xrSessionInsertDebugUtilsLabelEXT, EXT_debug_utils);
 #endif // OXR_HAVE_EXT_debug_utils
 
+#ifdef OXR_HAVE_KHR_locate_spaces
+	ENTRY_IF_EXT(xrLocateSpacesKHR, KHR_locate_spaces);
+#endif // OXR_HAVE_KHR_locate_spaces
+
 #ifdef OXR_HAVE_KHR_opengl_enable
 	ENTRY_IF_EXT(xrGetOpenGLGraphicsRequirementsKHR, KHR_opengl_enable);
 #endif // OXR_HAVE_KHR_opengl_enable
@@ -344,6 +365,8 @@ handle_null(struct oxr_logger *log, const char *name, PFN_xrVoidFunction *out_fu
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrGetInstanceProcAddr(XrInstance instance, const char *name, PFN_xrVoidFunction *function)
 {
+	OXR_API_MARKER();
+
 	struct oxr_logger log;
 
 	// We need to set this unconditionally, per the spec.
@@ -16,6 +16,7 @@
 
 #include "oxr_api_funcs.h"
 #include "oxr_api_verify.h"
+#include "oxr_api_stats.h"
 #include "oxr_chain.h"
 #include "oxr_subaction.h"
 
@@ -27,7 +28,7 @@ oxr_xrCreateGeometryInstanceFB(XrSession session,
                                const XrGeometryInstanceCreateInfoFB *createInfo,
                                XrGeometryInstanceFB *outGeometryInstance)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 	struct oxr_logger log;
 	oxr_log_init(&log, "oxr_xrCreateGeometryInstanceFB");
 	return oxr_error(&log, XR_ERROR_RUNTIME_FAILURE, " not implemented");
@@ -38,7 +39,7 @@ oxr_xrCreatePassthroughFB(XrSession session,
                           const XrPassthroughCreateInfoFB *createInfo,
                           XrPassthroughFB *outPassthrough)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -63,7 +64,7 @@ oxr_xrCreatePassthroughLayerFB(XrSession session,
                                const XrPassthroughLayerCreateInfoFB *createInfo,
                                XrPassthroughLayerFB *outLayer)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -88,7 +89,7 @@ oxr_xrCreatePassthroughLayerFB(XrSession session,
 XrResult
 oxr_xrDestroyGeometryInstanceFB(XrGeometryInstanceFB instance)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 	struct oxr_logger log;
 	oxr_log_init(&log, "oxr_xrDestroyGeometryInstanceFB");
 	return oxr_error(&log, XR_ERROR_RUNTIME_FAILURE, " not implemented");
@@ -97,7 +98,7 @@ oxr_xrDestroyGeometryInstanceFB(XrGeometryInstanceFB instance)
 XrResult
 oxr_xrDestroyPassthroughFB(XrPassthroughFB passthrough)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_passthrough *pt;
 	struct oxr_logger log;
@@ -111,7 +112,7 @@ oxr_xrDestroyPassthroughFB(XrPassthroughFB passthrough)
 XrResult
 oxr_xrDestroyPassthroughLayerFB(XrPassthroughLayerFB layer)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_passthrough_layer *pl;
 	struct oxr_logger log;
@@ -123,7 +124,7 @@ oxr_xrDestroyPassthroughLayerFB(XrPassthroughLayerFB layer)
 XrResult
 oxr_xrGeometryInstanceSetTransformFB(XrGeometryInstanceFB instance, const XrGeometryInstanceTransformFB *transformation)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 	struct oxr_logger log;
 	oxr_log_init(&log, "oxr_xrGeometryInstanceSetTransformFB");
 	return oxr_error(&log, XR_ERROR_RUNTIME_FAILURE, " not implemented");
@@ -132,7 +133,7 @@ oxr_xrGeometryInstanceSetTransformFB(XrGeometryInstanceFB instance, const XrGeom
 XrResult
 oxr_xrPassthroughLayerPauseFB(XrPassthroughLayerFB layer)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 	struct oxr_passthrough_layer *pl;
 	struct oxr_logger log;
 	OXR_VERIFY_PASSTHROUGH_LAYER_AND_INIT_LOG(&log, layer, pl, "oxr_xrPassthroughLayerPauseFB");
@@ -143,7 +144,7 @@ oxr_xrPassthroughLayerPauseFB(XrPassthroughLayerFB layer)
 XrResult
 oxr_xrPassthroughLayerResumeFB(XrPassthroughLayerFB layer)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 	struct oxr_passthrough_layer *pl;
 	struct oxr_logger log;
 	OXR_VERIFY_PASSTHROUGH_LAYER_AND_INIT_LOG(&log, layer, pl, "oxr_xrPassthroughLayerResumeFB");
@@ -154,7 +155,7 @@ oxr_xrPassthroughLayerResumeFB(XrPassthroughLayerFB layer)
 XrResult
 oxr_xrPassthroughLayerSetStyleFB(XrPassthroughLayerFB layer, const XrPassthroughStyleFB *style)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 	struct oxr_passthrough_layer *pl;
 	struct oxr_logger log;
 	OXR_VERIFY_PASSTHROUGH_LAYER_AND_INIT_LOG(&log, layer, pl, "oxr_xrPassthroughLayerResumeFB");
@@ -185,7 +186,7 @@ oxr_xrPassthroughLayerSetStyleFB(XrPassthroughLayerFB layer, const XrPassthrough
 XrResult
 oxr_xrPassthroughPauseFB(XrPassthroughFB passthrough)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 	struct oxr_passthrough *pt;
 	struct oxr_logger log;
 	OXR_VERIFY_PASSTHROUGH_AND_INIT_LOG(&log, passthrough, pt, "oxr_xrPassthroughPauseFB");
@@ -196,7 +197,7 @@ oxr_xrPassthroughPauseFB(XrPassthroughFB passthrough)
 XrResult
 oxr_xrPassthroughStartFB(XrPassthroughFB passthrough)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 	struct oxr_passthrough *pt;
 	struct oxr_logger log;
 	OXR_VERIFY_PASSTHROUGH_AND_INIT_LOG(&log, passthrough, pt, "oxr_xrPassthroughStartFB");
@@ -24,6 +24,7 @@
 
 #include "oxr_api_funcs.h"
 #include "oxr_api_verify.h"
+#include "oxr_api_stats.h"
 #include "oxr_handle.h"
 #include "oxr_chain.h"
 
@@ -31,7 +32,7 @@
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrCreateSession(XrInstance instance, const XrSessionCreateInfo *createInfo, XrSession *out_session)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	XrResult ret;
 	struct oxr_instance *inst;
@@ -65,7 +66,7 @@ oxr_xrCreateSession(XrInstance instance, const XrSessionCreateInfo *createInfo,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroySession(XrSession session)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_session **link;
@@ -87,7 +88,7 @@ oxr_xrDestroySession(XrSession session)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrBeginSession(XrSession session, const XrSessionBeginInfo *beginInfo)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -106,7 +107,7 @@ oxr_xrBeginSession(XrSession session, const XrSessionBeginInfo *beginInfo)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrEndSession(XrSession session)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -120,7 +121,7 @@ oxr_xrEndSession(XrSession session)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrWaitFrame(XrSession session, const XrFrameWaitInfo *frameWaitInfo, XrFrameState *frameState)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -137,7 +138,7 @@ oxr_xrWaitFrame(XrSession session, const XrFrameWaitInfo *frameWaitInfo, XrFrame
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrBeginFrame(XrSession session, const XrFrameBeginInfo *frameBeginInfo)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -163,7 +164,7 @@ oxr_xrBeginFrame(XrSession session, const XrFrameBeginInfo *frameBeginInfo)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrEndFrame(XrSession session, const XrFrameEndInfo *frameEndInfo)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -188,7 +189,7 @@ oxr_xrEndFrame(XrSession session, const XrFrameEndInfo *frameEndInfo)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrRequestExitSession(XrSession session)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -207,7 +208,7 @@ oxr_xrLocateViews(XrSession session,
                   uint32_t *viewCountOutput,
                   XrView *views)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_space *spc;
@@ -266,7 +267,7 @@ oxr_xrGetVisibilityMaskKHR(XrSession session,
                            XrVisibilityMaskTypeKHR visibilityMaskType,
                            XrVisibilityMaskKHR *visibilityMask)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess = NULL;
 	struct oxr_logger log;
@@ -321,7 +322,7 @@ oxr_xrPerfSettingsSetPerformanceLevelEXT(XrSession session,
                                          XrPerfSettingsDomainEXT domain,
                                          XrPerfSettingsLevelEXT level)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -362,7 +363,7 @@ oxr_xrThermalGetTemperatureTrendEXT(XrSession session,
                                     float *tempHeadroom,
                                     float *tempSlope)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -387,6 +388,7 @@ oxr_hand_tracker_destroy_cb(struct oxr_logger *log, struct oxr_handle_base *hb)
 {
 	struct oxr_hand_tracker *hand_tracker = (struct oxr_hand_tracker *)hb;
 
+	os_mutex_destroy(&hand_tracker->joint_cache.mutex);
 	free(hand_tracker);
 
 	return XR_SUCCESS;
@@ -409,6 +411,7 @@ oxr_hand_tracker_create(struct oxr_logger *log,
 	hand_tracker->sess = sess;
 	hand_tracker->hand = createInfo->hand;
 	hand_tracker->hand_joint_set = createInfo->handJointSet;
+	os_mutex_init(&hand_tracker->joint_cache.mutex);
 
 	// Find the assigned device.
 	struct xrt_device *xdev = NULL;
@@ -449,7 +452,7 @@ oxr_xrCreateHandTrackerEXT(XrSession session,
                            const XrHandTrackerCreateInfoEXT *createInfo,
                            XrHandTrackerEXT *handTracker)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_hand_tracker *hand_tracker = NULL;
 	struct oxr_session *sess = NULL;
@@ -479,7 +482,7 @@ oxr_xrCreateHandTrackerEXT(XrSession session,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroyHandTrackerEXT(XrHandTrackerEXT handTracker)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_hand_tracker *hand_tracker;
 	struct oxr_logger log;
@@ -493,7 +496,7 @@ oxr_xrLocateHandJointsEXT(XrHandTrackerEXT handTracker,
                           const XrHandJointsLocateInfoEXT *locateInfo,
                           XrHandJointLocationsEXT *locations)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_hand_tracker *hand_tracker;
 	struct oxr_space *spc;
@@ -553,7 +556,7 @@ oxr_xrLocateHandJointsEXT(XrHandTrackerEXT handTracker,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrApplyForceFeedbackCurlMNDX(XrHandTrackerEXT handTracker, const XrForceFeedbackCurlApplyLocationsMNDX *locations)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_hand_tracker *hand_tracker;
 	struct oxr_logger log;
@@ -579,6 +582,8 @@ oxr_xrEnumerateDisplayRefreshRatesFB(XrSession session,
                                      uint32_t *displayRefreshRateCountOutput,
                                      float *displayRefreshRates)
 {
+	OXR_API_MARKER();
+
 	struct oxr_session *sess = NULL;
 	struct oxr_logger log;
 	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrEnumerateDisplayRefreshRatesFB");
@@ -598,6 +603,8 @@ oxr_xrEnumerateDisplayRefreshRatesFB(XrSession session,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrGetDisplayRefreshRateFB(XrSession session, float *displayRefreshRate)
 {
+	OXR_API_MARKER();
+
 	struct oxr_session *sess = NULL;
 	struct oxr_logger log;
 	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrGetDisplayRefreshRateFB");
@@ -619,6 +626,8 @@ oxr_xrGetDisplayRefreshRateFB(XrSession session, float *displayRefreshRate)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrRequestDisplayRefreshRateFB(XrSession session, float displayRefreshRate)
 {
+	OXR_API_MARKER();
+
 	struct oxr_session *sess = NULL;
 	struct oxr_logger log;
 	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrRequestDisplayRefreshRateFB");
@@ -648,6 +657,56 @@ oxr_xrRequestDisplayRefreshRateFB(XrSession session, float displayRefreshRate)
 
 #endif
 
+/*
+ *
+ * XR_META_recommended_layer_resolution
+ *
+ */
+
+#ifdef OXR_HAVE_META_recommended_layer_resolution
+
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrGetRecommendedLayerResolutionMETA(XrSession session,
+                                        const XrRecommendedLayerResolutionGetInfoMETA *info,
+                                        XrRecommendedLayerResolutionMETA *resolution)
+{
+	OXR_API_MARKER();
+
+	struct oxr_session *sess = NULL;
+	struct oxr_logger log;
+	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrGetRecommendedLayerResolutionMETA");
+	OXR_VERIFY_SESSION_NOT_LOST(&log, sess);
+	OXR_VERIFY_EXTENSION(&log, sess->sys->inst, META_recommended_layer_resolution);
+	OXR_VERIFY_ARG_TYPE_AND_NOT_NULL(&log, info, XR_TYPE_RECOMMENDED_LAYER_RESOLUTION_GET_INFO_META);
+	OXR_VERIFY_ARG_TYPE_AND_NOT_NULL(&log, resolution, XR_TYPE_RECOMMENDED_LAYER_RESOLUTION_META);
+	OXR_VERIFY_ARG_NOT_NULL(&log, info->layer);
+
+	if (info->predictedDisplayTime <= (XrTime)0) {
+		return oxr_error(&log, XR_ERROR_TIME_INVALID, "(info->predictedDisplayTime == %" PRIi64 ") is not valid",
+		                 info->predictedDisplayTime);
+	}
+
+	// Only projection layers follow the recommended size of the views.
+	if (info->layer->type != XR_TYPE_COMPOSITION_LAYER_PROJECTION) {
+		resolution->recommendedImageDimensions.width = 0;
+		resolution->recommendedImageDimensions.height = 0;
+		resolution->isValid = XR_FALSE;
+		return XR_SUCCESS;
+	}
+
+	// The compositor accepts smaller image rects of the same swapchains.
+	float scale = sess->recommended_resolution_scale;
+	const XrViewConfigurationView *view = &sess->sys->views[0];
+
+	resolution->recommendedImageDimensions.width = (int32_t)(view->recommendedImageRectWidth * scale);
+	resolution->recommendedImageDimensions.height = (int32_t)(view->recommendedImageRectHeight * scale);
+	resolution->isValid = XR_TRUE;
+
+	return XR_SUCCESS;
+}
+
+#endif // OXR_HAVE_META_recommended_layer_resolution
+
 /*
  *
  * XR_KHR_android_thread_settings
@@ -659,7 +718,7 @@ oxr_xrRequestDisplayRefreshRateFB(XrSession session, float displayRefreshRate)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrSetAndroidApplicationThreadKHR(XrSession session, XrAndroidThreadTypeKHR threadType, uint32_t threadId)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess = NULL;
 	struct oxr_logger log;
@@ -753,7 +812,7 @@ oxr_xrCreateFacialTrackerHTC(XrSession session,
                              const XrFacialTrackerCreateInfoHTC *createInfo,
                              XrFacialTrackerHTC *facialTracker)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_logger log;
 	XrResult ret = XR_SUCCESS;
@@ -778,7 +837,7 @@ oxr_xrCreateFacialTrackerHTC(XrSession session,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroyFacialTrackerHTC(XrFacialTrackerHTC facialTracker)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_logger log;
 	struct oxr_facial_tracker_htc *facial_tracker_htc = NULL;
@@ -790,7 +849,7 @@ oxr_xrDestroyFacialTrackerHTC(XrFacialTrackerHTC facialTracker)
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrGetFacialExpressionsHTC(XrFacialTrackerHTC facialTracker, XrFacialExpressionsHTC *facialExpressions)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_logger log;
 	struct oxr_facial_tracker_htc *facial_tracker_htc = NULL;
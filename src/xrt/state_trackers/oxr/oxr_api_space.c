@@ -9,6 +9,7 @@
 
 #include "xrt/xrt_compiler.h"
 
+#include "util/u_misc.h"
 #include "util/u_debug.h"
 #include "util/u_trace_marker.h"
 
@@ -18,9 +19,11 @@
 #include "oxr_logger.h"
 #include "oxr_conversions.h"
 #include "oxr_two_call.h"
+#include "oxr_chain.h"
 
 #include "oxr_api_funcs.h"
 #include "oxr_api_verify.h"
+#include "oxr_api_stats.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -102,7 +105,7 @@ is_reference_space_type_supported(struct oxr_logger *log,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrCreateActionSpace(XrSession session, const XrActionSpaceCreateInfo *createInfo, XrSpace *space)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_action *act;
@@ -130,7 +133,7 @@ oxr_xrEnumerateReferenceSpaces(XrSession session,
                                uint32_t *spaceCountOutput,
                                XrReferenceSpaceType *spaces)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -149,7 +152,7 @@ oxr_xrEnumerateReferenceSpaces(XrSession session,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrGetReferenceSpaceBoundsRect(XrSession session, XrReferenceSpaceType referenceSpaceType, XrExtent2Df *bounds)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	XrResult ret;
 	struct oxr_session *sess;
@@ -174,7 +177,7 @@ oxr_xrGetReferenceSpaceBoundsRect(XrSession session, XrReferenceSpaceType refere
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo *createInfo, XrSpace *out_space)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	XrResult ret;
 	struct oxr_session *sess;
@@ -216,7 +219,7 @@ oxr_xrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo *
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation *location)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_space *spc;
 	struct oxr_space *baseSpc;
@@ -233,10 +236,74 @@ oxr_xrLocateSpace(XrSpace space, XrSpace baseSpace, XrTime time, XrSpaceLocation
 	return oxr_space_locate(&log, spc, baseSpc, time, location);
 }
 
+#ifdef OXR_HAVE_KHR_locate_spaces
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrLocateSpacesKHR(XrSession session, const XrSpacesLocateInfoKHR *locateInfo, XrSpaceLocationsKHR *spaceLocations)
+{
+	OXR_API_MARKER();
+
+	struct oxr_session *sess;
+	struct oxr_space *baseSpc;
+	struct oxr_logger log;
+	OXR_VERIFY_SESSION_AND_INIT_LOG(&log, session, sess, "xrLocateSpacesKHR");
+	OXR_VERIFY_SESSION_NOT_LOST(&log, sess);
+	OXR_VERIFY_EXTENSION(&log, sess->sys->inst, KHR_locate_spaces);
+	OXR_VERIFY_ARG_TYPE_AND_NOT_NULL(&log, locateInfo, XR_TYPE_SPACES_LOCATE_INFO_KHR);
+	OXR_VERIFY_ARG_TYPE_AND_NOT_NULL(&log, spaceLocations, XR_TYPE_SPACE_LOCATIONS_KHR);
+	OXR_VERIFY_SPACE_NOT_NULL(&log, locateInfo->baseSpace, baseSpc);
+	OXR_VERIFY_ARG_NOT_NULL(&log, locateInfo->spaces);
+	OXR_VERIFY_ARG_NOT_NULL(&log, spaceLocations->locations);
+
+	if (locateInfo->time <= (XrTime)0) {
+		return oxr_error(&log, XR_ERROR_TIME_INVALID, "(locateInfo->time == %" PRIi64 ") is not a valid time.",
+		                 locateInfo->time);
+	}
+
+	uint32_t space_count = locateInfo->spaceCount;
+	if (space_count == 0) {
+		return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE, "(locateInfo->spaceCount == 0)");
+	}
+
+	if (spaceLocations->locationCount != space_count) {
+		return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE,
+		                 "(spaceLocations->locationCount == %u) != (locateInfo->spaceCount == %u)",
+		                 spaceLocations->locationCount, space_count);
+	}
+
+	const XrSpaceVelocitiesKHR *velocities =
+	    OXR_GET_INPUT_FROM_CHAIN(spaceLocations->next, XR_TYPE_SPACE_VELOCITIES_KHR, XrSpaceVelocitiesKHR);
+	if (velocities != NULL) {
+		OXR_VERIFY_ARG_NOT_NULL(&log, velocities->velocities);
+
+		if (velocities->velocityCount != space_count) {
+			return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE,
+			                 "(velocities->velocityCount == %u) != (locateInfo->spaceCount == %u)",
+			                 velocities->velocityCount, space_count);
+		}
+	}
+
+	for (uint32_t i = 0; i < space_count; i++) {
+		struct oxr_space *spc;
+		OXR_VERIFY_SPACE_NOT_NULL(&log, locateInfo->spaces[i], spc);
+	}
+
+	struct oxr_space **spcs = U_TYPED_ARRAY_CALLOC(struct oxr_space *, space_count);
+	for (uint32_t i = 0; i < space_count; i++) {
+		spcs[i] = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, locateInfo->spaces[i]);
+	}
+
+	XrResult ret = oxr_spaces_locate(&log, spcs, space_count, baseSpc, locateInfo->time, spaceLocations);
+
+	free(spcs);
+
+	return ret;
+}
+#endif // OXR_HAVE_KHR_locate_spaces
+
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroySpace(XrSpace space)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_space *spc;
 	struct oxr_logger log;
@@ -0,0 +1,228 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Per entrypoint call counts and timing.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup oxr_api
+ */
+
+#include "os/os_time.h"
+#include "util/u_var.h"
+#include "util/u_debug.h"
+
+#include "oxr_objects.h"
+#include "oxr_logger.h"
+#include "oxr_api_stats.h"
+
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(api_stats, "OXR_API_STATS", false)
+
+//! More then the number of entrypoints.
+#define MAX_FUNCTIONS (256)
+
+/*!
+ * Only ever touched by the thread owning it while counting, so counting does
+ * not need any locking or atomics. Readers may see slightly stale values.
+ */
+struct thread_stats
+{
+	uint64_t call_count[MAX_FUNCTIONS];
+	uint64_t total_ns[MAX_FUNCTIONS];
+};
+
+struct registry
+{
+	std::mutex mutex = {};
+
+	//! Names of the registered entrypoints, the index is the id minus one.
+	const char *names[MAX_FUNCTIONS] = {};
+	uint32_t count = 0;
+
+	/*!
+	 * Counters of all threads that have made calls, never freed as a thread
+	 * can't tell us when it goes away.
+	 */
+	std::vector<thread_stats *> threads = {};
+
+	//! Sum of all threads, updated on dump and from the debug UI.
+	uint64_t call_count[MAX_FUNCTIONS] = {};
+	uint64_t total_ns[MAX_FUNCTIONS] = {};
+
+	struct u_var_button update_button = {};
+};
+
+static registry g_registry;
+
+static thread_local thread_stats *t_stats = nullptr;
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+//! Must be called with the lock held.
+static void
+update_totals_locked(registry &r)
+{
+	memset(r.call_count, 0, sizeof(r.call_count));
+	memset(r.total_ns, 0, sizeof(r.total_ns));
+
+	for (thread_stats *ts : r.threads) {
+		for (uint32_t i = 0; i < r.count; i++) {
+			r.call_count[i] += ts->call_count[i];
+			r.total_ns[i] += ts->total_ns[i];
+		}
+	}
+}
+
+static void
+update_button_cb(void *ptr)
+{
+	registry &r = *(registry *)ptr;
+
+	std::unique_lock<std::mutex> lock(r.mutex);
+	update_totals_locked(r);
+}
+
+static uint32_t
+register_function(uint32_t *id_cache, const char *name)
+{
+	registry &r = g_registry;
+
+	std::unique_lock<std::mutex> lock(r.mutex);
+
+	// Another thread might have gotten here first.
+	if (*id_cache != 0) {
+		return *id_cache;
+	}
+
+	if (r.count >= MAX_FUNCTIONS) {
+		return 0;
+	}
+
+	if (r.count == 0) {
+		r.update_button.cb = update_button_cb;
+		r.update_button.ptr = &r;
+		snprintf(r.update_button.label, sizeof(r.update_button.label), "Update");
+
+		u_var_add_root(&r, "OpenXR API stats", false);
+		u_var_add_button(&r, &r.update_button, "Update");
+	}
+
+	// Drop the prefix so the names match the OpenXR functions.
+	if (strncmp(name, "oxr_", 4) == 0) {
+		name += 4;
+	}
+
+	uint32_t index = r.count++;
+	r.names[index] = name;
+
+	char str[128];
+	snprintf(str, sizeof(str), "%s calls", name);
+	u_var_add_ro_u64(&r, &r.call_count[index], str);
+	snprintf(str, sizeof(str), "%s total(ns)", name);
+	u_var_add_ro_u64(&r, &r.total_ns[index], str);
+
+	*id_cache = index + 1;
+
+	return index + 1;
+}
+
+static thread_stats *
+get_thread_stats()
+{
+	if (t_stats != nullptr) {
+		return t_stats;
+	}
+
+	thread_stats *ts = new thread_stats();
+
+	std::unique_lock<std::mutex> lock(g_registry.mutex);
+	g_registry.threads.push_back(ts);
+	t_stats = ts;
+
+	return ts;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+extern "C" struct oxr_api_stats_scope
+oxr_api_stats_scope_begin(uint32_t *id_cache, const char *name)
+{
+	struct oxr_api_stats_scope scope = {};
+
+	if (!debug_get_bool_option_api_stats()) {
+		return scope;
+	}
+
+	// Only ever goes from zero to the id, and is re-checked under the lock.
+	uint32_t id = *id_cache;
+	if (id == 0) {
+		id = register_function(id_cache, name);
+	}
+
+	scope.id = id;
+	scope.start_ns = os_monotonic_get_ns();
+
+	return scope;
+}
+
+extern "C" void
+oxr_api_stats_scope_end(struct oxr_api_stats_scope *scope)
+{
+	if (scope->id == 0) {
+		return;
+	}
+
+	int64_t duration_ns = os_monotonic_get_ns() - scope->start_ns;
+	thread_stats *ts = get_thread_stats();
+
+	ts->call_count[scope->id - 1]++;
+	ts->total_ns[scope->id - 1] += (uint64_t)duration_ns;
+}
+
+extern "C" void
+oxr_api_stats_dump(struct oxr_logger *log)
+{
+	if (!debug_get_bool_option_api_stats()) {
+		return;
+	}
+
+	registry &r = g_registry;
+
+	std::unique_lock<std::mutex> lock(r.mutex);
+	update_totals_locked(r);
+
+	std::vector<uint32_t> order;
+	for (uint32_t i = 0; i < r.count; i++) {
+		if (r.call_count[i] > 0) {
+			order.push_back(i);
+		}
+	}
+
+	std::sort(order.begin(), order.end(), [&r](uint32_t a, uint32_t b) { return r.total_ns[a] > r.total_ns[b]; });
+
+	oxr_log(log, "API stats, %u threads:", (uint32_t)r.threads.size());
+	for (uint32_t i : order) {
+		double total_ms = (double)r.total_ns[i] / 1000000.0;
+		double avg_us = (double)r.total_ns[i] / (double)r.call_count[i] / 1000.0;
+
+		oxr_log(log, "\t%-40s %10" PRIu64 " calls %12.3fms total %10.3fus avg", r.names[i], r.call_count[i],
+		        total_ms, avg_us);
+	}
+}
@@ -0,0 +1,82 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Per entrypoint call counts and timing.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup oxr_api
+ */
+
+#pragma once
+
+#include "xrt/xrt_compiler.h"
+#include "util/u_trace_marker.h"
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+struct oxr_logger;
+
+/*!
+ * A single timed call of an entrypoint, started by @ref OXR_API_MARKER and
+ * ended when it goes out of scope.
+ *
+ * @ingroup oxr_api
+ */
+struct oxr_api_stats_scope
+{
+	//! Index of the entrypoint plus one, zero if not counting.
+	uint32_t id;
+
+	//! When the call was started.
+	int64_t start_ns;
+};
+
+/*!
+ * Start timing a call, @p id_cache is a per entrypoint static that holds the
+ * id of it once registered. Does nothing unless OXR_API_STATS is set.
+ *
+ * @ingroup oxr_api
+ */
+struct oxr_api_stats_scope
+oxr_api_stats_scope_begin(uint32_t *id_cache, const char *name);
+
+/*!
+ * Add the call to the calling thread's counters.
+ *
+ * @ingroup oxr_api
+ */
+void
+oxr_api_stats_scope_end(struct oxr_api_stats_scope *scope);
+
+/*!
+ * Log the counters of all threads summed up, sorted by total time spent.
+ *
+ * @ingroup oxr_api
+ */
+void
+oxr_api_stats_dump(struct oxr_logger *log);
+
+/*!
+ * Put at the top of every entrypoint, adds a trace marker and when enabled
+ * with OXR_API_STATS counts the calls and time spent in it.
+ *
+ * @ingroup oxr_api
+ */
+#if defined(__GNUC__)
+#define OXR_API_MARKER()                                                                                               \
+	OXR_TRACE_MARKER();                                                                                            \
+	static uint32_t oxr_api_stats_id = 0;                                                                          \
+	struct oxr_api_stats_scope __attribute__((cleanup(oxr_api_stats_scope_end))) oxr_api_stats_scope =             \
+	    oxr_api_stats_scope_begin(&oxr_api_stats_id, __func__)
+#else
+#define OXR_API_MARKER() OXR_TRACE_MARKER()
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
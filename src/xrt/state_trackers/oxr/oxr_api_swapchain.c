@@ -19,6 +19,7 @@
 
 #include "oxr_api_funcs.h"
 #include "oxr_api_verify.h"
+#include "oxr_api_stats.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -32,7 +33,7 @@ oxr_xrEnumerateSwapchainFormats(XrSession session,
                                 uint32_t *formatCountOutput,
                                 int64_t *formats)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_session *sess;
 	struct oxr_logger log;
@@ -45,7 +46,7 @@ oxr_xrEnumerateSwapchainFormats(XrSession session,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrCreateSwapchain(XrSession session, const XrSwapchainCreateInfo *createInfo, XrSwapchain *out_swapchain)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	XrResult ret;
 	struct oxr_session *sess;
@@ -151,7 +152,7 @@ oxr_xrCreateSwapchain(XrSession session, const XrSwapchainCreateInfo *createInfo
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrDestroySwapchain(XrSwapchain swapchain)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_swapchain *sc;
 	struct oxr_logger log;
@@ -166,7 +167,7 @@ oxr_xrEnumerateSwapchainImages(XrSwapchain swapchain,
                                uint32_t *imageCountOutput,
                                XrSwapchainImageBaseHeader *images)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_swapchain *sc;
 	struct oxr_logger log;
@@ -190,7 +191,7 @@ oxr_xrEnumerateSwapchainImages(XrSwapchain swapchain,
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrAcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo *acquireInfo, uint32_t *index)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_swapchain *sc;
 	struct oxr_logger log;
@@ -205,7 +206,7 @@ oxr_xrAcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquire
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo *waitInfo)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_swapchain *sc;
 	struct oxr_logger log;
@@ -219,7 +220,7 @@ oxr_xrWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo *
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo *releaseInfo)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_swapchain *sc;
 	struct oxr_logger log;
@@ -229,3 +230,63 @@ oxr_xrReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageRelease
 
 	return sc->release_image(&log, sc, releaseInfo);
 }
+
+#ifdef OXR_HAVE_FB_swapchain_update_state
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrUpdateSwapchainFB(XrSwapchain swapchain, const XrSwapchainStateBaseHeaderFB *state)
+{
+	OXR_API_MARKER();
+
+	struct oxr_swapchain *sc;
+	struct oxr_logger log;
+	OXR_VERIFY_SWAPCHAIN_AND_INIT_LOG(&log, swapchain, sc, "xrUpdateSwapchainFB");
+	OXR_VERIFY_SESSION_NOT_LOST(&log, sc->sess);
+	OXR_VERIFY_EXTENSION(&log, sc->sess->sys->inst, FB_swapchain_update_state);
+	OXR_VERIFY_ARG_NOT_NULL(&log, state);
+
+	switch (state->type) {
+#ifdef OXR_HAVE_FB_foveation
+	case XR_TYPE_SWAPCHAIN_STATE_FOVEATION_FB: {
+		OXR_VERIFY_EXTENSION(&log, sc->sess->sys->inst, FB_foveation);
+
+		const XrSwapchainStateFoveationFB *foveation = (const XrSwapchainStateFoveationFB *)state;
+		struct oxr_foveation_profile *profile;
+		OXR_VERIFY_FOVEATION_PROFILE_NOT_NULL(&log, foveation->profile, profile);
+
+		oxr_swapchain_set_foveation_profile(sc, profile);
+
+		return oxr_session_success_result(sc->sess);
+	}
+#endif
+	default: return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE, "(state->type == 0x%08x) unsupported", state->type);
+	}
+}
+
+XRAPI_ATTR XrResult XRAPI_CALL
+oxr_xrGetSwapchainStateFB(XrSwapchain swapchain, XrSwapchainStateBaseHeaderFB *state)
+{
+	OXR_API_MARKER();
+
+	struct oxr_swapchain *sc;
+	struct oxr_logger log;
+	OXR_VERIFY_SWAPCHAIN_AND_INIT_LOG(&log, swapchain, sc, "xrGetSwapchainStateFB");
+	OXR_VERIFY_SESSION_NOT_LOST(&log, sc->sess);
+	OXR_VERIFY_EXTENSION(&log, sc->sess->sys->inst, FB_swapchain_update_state);
+	OXR_VERIFY_ARG_NOT_NULL(&log, state);
+
+	switch (state->type) {
+#ifdef OXR_HAVE_FB_foveation
+	case XR_TYPE_SWAPCHAIN_STATE_FOVEATION_FB: {
+		OXR_VERIFY_EXTENSION(&log, sc->sess->sys->inst, FB_foveation);
+
+		XrSwapchainStateFoveationFB *foveation = (XrSwapchainStateFoveationFB *)state;
+		foveation->flags = 0;
+		foveation->profile = sc->foveation.profile;
+
+		return oxr_session_success_result(sc->sess);
+	}
+#endif
+	default: return oxr_error(&log, XR_ERROR_VALIDATION_FAILURE, "(state->type == 0x%08x) unsupported", state->type);
+	}
+}
+#endif // OXR_HAVE_FB_swapchain_update_state
@@ -25,6 +25,7 @@
 
 #include "oxr_api_funcs.h"
 #include "oxr_api_verify.h"
+#include "oxr_api_stats.h"
 
 
 /*!
@@ -51,7 +52,7 @@
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrGetSystem(XrInstance instance, const XrSystemGetInfo *getInfo, XrSystemId *systemId)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -76,7 +77,7 @@ oxr_xrGetSystem(XrInstance instance, const XrSystemGetInfo *getInfo, XrSystemId
 XRAPI_ATTR XrResult XRAPI_CALL
 oxr_xrGetSystemProperties(XrInstance instance, XrSystemId systemId, XrSystemProperties *properties)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -94,7 +95,7 @@ oxr_xrEnumerateViewConfigurations(XrInstance instance,
                                   uint32_t *viewConfigurationTypeCountOutput,
                                   XrViewConfigurationType *viewConfigurationTypes)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -113,7 +114,7 @@ oxr_xrEnumerateEnvironmentBlendModes(XrInstance instance,
                                      uint32_t *environmentBlendModeCountOutput,
                                      XrEnvironmentBlendMode *environmentBlendModes)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -138,7 +139,7 @@ oxr_xrGetViewConfigurationProperties(XrInstance instance,
                                      XrViewConfigurationType viewConfigurationType,
                                      XrViewConfigurationProperties *configurationProperties)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -157,7 +158,7 @@ oxr_xrEnumerateViewConfigurationViews(XrInstance instance,
                                       uint32_t *viewCountOutput,
                                       XrViewConfigurationView *views)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -186,7 +187,7 @@ oxr_xrGetOpenGLESGraphicsRequirementsKHR(XrInstance instance,
                                          XrSystemId systemId,
                                          XrGraphicsRequirementsOpenGLESKHR *graphicsRequirements)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -223,7 +224,7 @@ oxr_xrGetOpenGLGraphicsRequirementsKHR(XrInstance instance,
                                        XrSystemId systemId,
                                        XrGraphicsRequirementsOpenGLKHR *graphicsRequirements)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -262,7 +263,7 @@ oxr_xrGetVulkanInstanceExtensionsKHR(XrInstance instance,
                                      uint32_t *namesCountOutput,
                                      char *namesString)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -280,7 +281,7 @@ oxr_xrGetVulkanDeviceExtensionsKHR(XrInstance instance,
                                    uint32_t *namesCountOutput,
                                    char *namesString)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -301,7 +302,7 @@ oxr_xrGetVulkanGraphicsDeviceKHR(XrInstance instance,
                                  VkInstance vkInstance,
                                  VkPhysicalDevice *vkPhysicalDevice)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -318,7 +319,7 @@ oxr_xrGetVulkanGraphicsDevice2KHR(XrInstance instance,
                                   const XrVulkanGraphicsDeviceGetInfoKHR *getInfo,
                                   VkPhysicalDevice *vkPhysicalDevice)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -338,7 +339,7 @@ oxr_xrGetVulkanGraphicsRequirementsKHR(XrInstance instance,
                                        XrSystemId systemId,
                                        XrGraphicsRequirementsVulkanKHR *graphicsRequirements)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -355,7 +356,7 @@ oxr_xrGetVulkanGraphicsRequirements2KHR(XrInstance instance,
                                         XrSystemId systemId,
                                         XrGraphicsRequirementsVulkan2KHR *graphicsRequirements)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -375,7 +376,7 @@ oxr_xrCreateVulkanInstanceKHR(XrInstance instance,
                               VkInstance *vulkanInstance,
                               VkResult *vulkanResult)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -407,7 +408,7 @@ oxr_xrCreateVulkanDeviceKHR(XrInstance instance,
                             VkDevice *vulkanDevice,
                             VkResult *vulkanResult)
 {
-	OXR_TRACE_MARKER();
+	OXR_API_MARKER();
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -454,6 +455,8 @@ oxr_xrGetD3D11GraphicsRequirementsKHR(XrInstance instance,
                                       XrSystemId systemId,
                                       XrGraphicsRequirementsD3D11KHR *graphicsRequirements)
 {
+	OXR_API_MARKER();
+
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -482,6 +485,8 @@ oxr_xrGetD3D12GraphicsRequirementsKHR(XrInstance instance,
                                       XrSystemId systemId,
                                       XrGraphicsRequirementsD3D12KHR *graphicsRequirements)
 {
+	OXR_API_MARKER();
+
 
 	struct oxr_instance *inst;
 	struct oxr_logger log;
@@ -18,9 +18,151 @@
 #include "oxr_two_call.h"
 #include "oxr_subaction.h"
 
+#include <stdlib.h>
+
 #include <stdio.h>
 
 
+/*
+ *
+ * Lookup tables.
+ *
+ */
+
+static int
+compare_lookup(const void *a_ptr, const void *b_ptr)
+{
+	const struct oxr_binding_lookup *a = (const struct oxr_binding_lookup *)a_ptr;
+	const struct oxr_binding_lookup *b = (const struct oxr_binding_lookup *)b_ptr;
+
+	if (a->value != b->value) {
+		return a->value < b->value ? -1 : 1;
+	}
+	if (a->binding_index != b->binding_index) {
+		return a->binding_index < b->binding_index ? -1 : 1;
+	}
+	if (a->path_index != b->path_index) {
+		return a->path_index < b->path_index ? -1 : 1;
+	}
+	return 0;
+}
+
+/*!
+ * Returns the index of the first entry with @p value, or @p count if none.
+ */
+static size_t
+lookup_find_first(const struct oxr_binding_lookup *lookup, size_t count, uint64_t value)
+{
+	size_t low = 0;
+	size_t high = count;
+
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (lookup[mid].value < value) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	if (low < count && lookup[low].value == value) {
+		return low;
+	}
+
+	return count;
+}
+
+/*!
+ * Build the table that maps every path of every binding to that binding, the
+ * paths never change after the profile has been created.
+ */
+static void
+build_path_lookup(struct oxr_interaction_profile *p)
+{
+	size_t count = 0;
+	for (size_t x = 0; x < p->binding_count; x++) {
+		count += p->bindings[x].path_count;
+	}
+
+	free(p->path_lookup);
+	p->path_lookup = NULL;
+	p->path_lookup_count = 0;
+
+	if (count == 0) {
+		return;
+	}
+
+	p->path_lookup = U_TYPED_ARRAY_CALLOC(struct oxr_binding_lookup, count);
+
+	for (size_t x = 0; x < p->binding_count; x++) {
+		struct oxr_binding *b = &p->bindings[x];
+
+		for (uint32_t y = 0; y < b->path_count; y++) {
+			struct oxr_binding_lookup *l = &p->path_lookup[p->path_lookup_count++];
+			l->value = b->paths[y];
+			l->binding_index = (uint32_t)x;
+			l->path_index = y;
+		}
+	}
+
+	qsort(p->path_lookup, p->path_lookup_count, sizeof(*p->path_lookup), compare_lookup);
+}
+
+/*!
+ * Build the table that maps action keys to bindings, needs to be called each
+ * time the keys of the bindings change.
+ */
+static void
+build_key_lookup(struct oxr_interaction_profile *p)
+{
+	size_t count = 0;
+	for (size_t x = 0; x < p->binding_count; x++) {
+		count += p->bindings[x].key_count;
+	}
+
+	free(p->key_lookup);
+	p->key_lookup = NULL;
+	p->key_lookup_count = 0;
+
+	if (count == 0) {
+		return;
+	}
+
+	p->key_lookup = U_TYPED_ARRAY_CALLOC(struct oxr_binding_lookup, count);
+
+	for (size_t x = 0; x < p->binding_count; x++) {
+		struct oxr_binding *b = &p->bindings[x];
+
+		for (uint32_t y = 0; y < b->key_count; y++) {
+			struct oxr_binding_lookup *l = &p->key_lookup[p->key_lookup_count++];
+			l->value = b->keys[y];
+			l->binding_index = (uint32_t)x;
+			l->path_index = 0;
+		}
+	}
+
+	qsort(p->key_lookup, p->key_lookup_count, sizeof(*p->key_lookup), compare_lookup);
+}
+
+static void
+destroy_lookups(struct oxr_interaction_profile *p)
+{
+	free(p->path_lookup);
+	p->path_lookup = NULL;
+	p->path_lookup_count = 0;
+
+	free(p->key_lookup);
+	p->key_lookup = NULL;
+	p->key_lookup_count = 0;
+}
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
 static void
 setup_paths(struct oxr_logger *log,
             struct oxr_instance *inst,
@@ -113,11 +255,7 @@ interaction_profile_find_or_create_in_instance(struct oxr_logger *log,
 	struct profile_template *templ = NULL;
 
 	for (size_t x = 0; x < NUM_PROFILE_TEMPLATES; x++) {
-		XrPath t_path = XR_NULL_PATH;
-
-		oxr_path_get_or_create(log, inst, profile_templates[x].path, strlen(profile_templates[x].path),
-		                       &t_path);
-		if (t_path == path) {
+		if (oxr_path_get_profile_template(inst, x) == path) {
 			templ = &profile_templates[x];
 			break;
 		}
@@ -180,6 +318,8 @@ interaction_profile_find_or_create_in_instance(struct oxr_logger *log,
 		d->activate = t->activate;
 	}
 
+	build_path_lookup(p);
+
 	// Add to the list of currently created interaction profiles.
 	U_ARRAY_REALLOC_OR_FREE(inst->profiles, struct oxr_interaction_profile *, (inst->profile_count + 1));
 	inst->profiles[inst->profile_count++] = p;
@@ -208,25 +348,21 @@ reset_all_keys(struct oxr_binding *bindings, size_t binding_count)
 }
 
 static void
-add_key_to_matching_bindings(struct oxr_binding *bindings, size_t binding_count, XrPath path, uint32_t key)
+add_key_to_matching_bindings(struct oxr_interaction_profile *p, XrPath path, uint32_t key)
 {
-	for (size_t x = 0; x < binding_count; x++) {
-		struct oxr_binding *b = &bindings[x];
+	size_t first = lookup_find_first(p->path_lookup, p->path_lookup_count, path);
 
-		bool found = false;
-		uint32_t preferred_path_index;
-		for (uint32_t y = 0; y < b->path_count; y++) {
-			if (b->paths[y] == path) {
-				found = true;
-				preferred_path_index = y;
-				break;
-			}
-		}
+	for (size_t x = first; x < p->path_lookup_count && p->path_lookup[x].value == path; x++) {
+		const struct oxr_binding_lookup *l = &p->path_lookup[x];
 
-		if (!found) {
+		// Sorted on path index within a binding, only use the first one.
+		if (x > first && p->path_lookup[x - 1].binding_index == l->binding_index) {
 			continue;
 		}
 
+		struct oxr_binding *b = &p->bindings[l->binding_index];
+		uint32_t preferred_path_index = l->path_index;
+
 		U_ARRAY_REALLOC_OR_FREE(b->keys, uint32_t, (b->key_count + 1));
 		U_ARRAY_REALLOC_OR_FREE(b->preferred_binding_path_index, uint32_t, (b->key_count + 1));
 		b->preferred_binding_path_index[b->key_count] = preferred_path_index;
@@ -439,19 +575,21 @@ oxr_binding_find_bindings_from_key(struct oxr_logger *log,
 	size_t binding_count = 0;
 
 	/*
-	 * Loop over all app provided bindings for this profile
-	 * and return those matching the action.
+	 * Look up all app provided bindings for this profile matching the
+	 * action, they are sorted on binding within the same key.
 	 */
-	for (size_t y = 0; y < p->binding_count; y++) {
-		struct oxr_binding *b = &p->bindings[y];
+	size_t first = lookup_find_first(p->key_lookup, p->key_lookup_count, key);
 
-		for (size_t z = 0; z < b->key_count; z++) {
-			if (b->keys[z] == key) {
-				bindings[binding_count++] = b;
-				break;
-			}
+	for (size_t x = first; x < p->key_lookup_count && p->key_lookup[x].value == key; x++) {
+		const struct oxr_binding_lookup *l = &p->key_lookup[x];
+
+		// A binding can only have the same key once, but be safe.
+		if (x > first && p->key_lookup[x - 1].binding_index == l->binding_index) {
+			continue;
 		}
 
+		bindings[binding_count++] = &p->bindings[l->binding_index];
+
 		//! @todo Should return total count instead of fixed max.
 		if (binding_count >= max_bounding_count) {
 			oxr_warn(log, "Internal limit reached, action has too many bindings!");
@@ -542,6 +680,13 @@ oxr_clone_profile(const struct oxr_interaction_profile *src_profile)
 	dst_profile->dpad_state = empty_dpad_state;
 	oxr_dpad_state_clone(&dst_profile->dpad_state, &src_profile->dpad_state);
 
+	// Bindings can't be suggested on a clone, so it only needs the keys.
+	dst_profile->path_lookup = NULL;
+	dst_profile->path_lookup_count = 0;
+	dst_profile->key_lookup = NULL;
+	dst_profile->key_lookup_count = 0;
+	build_key_lookup(dst_profile);
+
 	return dst_profile;
 }
 
@@ -569,6 +714,8 @@ oxr_destroy_profiles(struct oxr_interaction_profile **profiles, const size_t pro
 		p->bindings = NULL;
 		p->binding_count = 0;
 
+		destroy_lookups(p);
+
 		oxr_dpad_state_deinit(&p->dpad_state);
 
 		free(p);
@@ -630,9 +777,11 @@ oxr_action_suggest_interaction_profile_bindings(struct oxr_logger *log,
 		const XrActionSuggestedBinding *s = &suggestedBindings->suggestedBindings[i];
 		struct oxr_action *act = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_action *, s->action);
 
-		add_key_to_matching_bindings(bindings, binding_count, s->binding, act->act_key);
+		add_key_to_matching_bindings(p, s->binding, act->act_key);
 	}
 
+	build_key_lookup(p);
+
 out:
 	oxr_dpad_state_deinit(dpad_state); // if it hasn't been moved
 
@@ -29,6 +29,7 @@
 #define OXR_XR_DEBUG_PASSTHROUGH    	(*(uint64_t *)"oxrpass\0")
 #define OXR_XR_DEBUG_PASSTHROUGH_LAYER  (*(uint64_t *)"oxrptla\0")
 #define OXR_XR_DEBUG_FTRACKER  (*(uint64_t *)"oxrftra\0")
+#define OXR_XR_DEBUG_FOVEATION (*(uint64_t *)"oxrfove\0")
 // clang-format on
 
 /*!
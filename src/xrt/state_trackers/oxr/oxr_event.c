@@ -15,6 +15,7 @@
 #include "oxr_logger.h"
 #include "oxr_conversions.h"
 
+#include <assert.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -22,105 +23,81 @@
 
 /*
  *
- * Struct and defines.
+ * Internal helpers.
  *
  */
 
-struct oxr_event
-{
-	struct oxr_event *next;
-	size_t length;
-	XrResult result;
-};
-
-
-/*
- *
- * Internal helpers.
- *
+/*!
+ * Sets up the event to hold a event struct of @p TYPE and returns a pointer to
+ * it, the struct must fit in the pre-allocated event slots.
  */
+#define EVENT_DATA(EVENT, TYPE)                                                                                        \
+	((TYPE *)init_event(EVENT, sizeof(TYPE)));                                                                     \
+	static_assert(sizeof(TYPE) <= OXR_EVENT_MAX_SIZE, "Event struct too large")
 
-void
+static void
 lock(struct oxr_instance *inst)
 {
 	os_mutex_lock(&inst->event.mutex);
 }
 
-void
+static void
 unlock(struct oxr_instance *inst)
 {
 	os_mutex_unlock(&inst->event.mutex);
 }
 
-void *
-oxr_event_extra(struct oxr_event *event)
-{
-	return &event[1];
-}
-
-struct oxr_event *
-pop(struct oxr_instance *inst)
+static void *
+init_event(struct oxr_event *event, size_t length)
 {
-	struct oxr_event *ret = inst->event.next;
-	if (ret == NULL) {
-		return NULL;
-	}
-
-	inst->event.next = ret->next;
-	ret->next = NULL;
-
-	if (ret == inst->event.last) {
-		inst->event.last = NULL;
-	}
+	U_ZERO(event);
+	event->length = length;
+	event->result = XR_SUCCESS;
 
-	return ret;
+	return &event->data;
 }
 
-void
-push(struct oxr_instance *inst, struct oxr_event *event)
+//! Get the queued event at @p index, zero being the oldest one.
+static struct oxr_event *
+get_queued(struct oxr_instance *inst, uint32_t index)
 {
-	struct oxr_event *last = inst->event.last;
-	if (last != NULL) {
-		last->next = event;
-	}
-	inst->event.last = event;
-
-	if (inst->event.next == NULL) {
-		inst->event.next = event;
-	}
+	return &inst->event.slots[(inst->event.head + index) % OXR_EVENT_QUEUE_SIZE];
 }
 
-#define ALLOC(log, inst, event, extra)                                                                                 \
-	do {                                                                                                           \
-		XrResult ret = oxr_event_alloc(log, inst, sizeof(**extra), event);                                     \
-		if (ret != XR_SUCCESS) {                                                                               \
-			return ret;                                                                                    \
-		}                                                                                                      \
-		*((void **)extra) = oxr_event_extra(*event);                                                           \
-	} while (false)
-
-static XrResult
-oxr_event_alloc(struct oxr_logger *log, struct oxr_instance *inst, size_t size, struct oxr_event **out_event)
+/*!
+ * Must be called with the lock held, copies the event into the queue. The last
+ * free slot is used for a XrEventDataEventsLost event, events pushed while the
+ * queue is full only bump the count of it.
+ */
+static void
+push(struct oxr_instance *inst, const struct oxr_event *event)
 {
-	struct oxr_event *event = U_CALLOC_WITH_CAST(struct oxr_event, sizeof(struct oxr_event) + size);
+	uint32_t count = (uint32_t)inst->event.count;
 
-	if (event == NULL) {
-		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Out of memory");
+	if (count == OXR_EVENT_QUEUE_SIZE) {
+		XrEventDataEventsLost *lost = (XrEventDataEventsLost *)&get_queued(inst, count - 1)->data;
+		assert(lost->type == XR_TYPE_EVENT_DATA_EVENTS_LOST);
+		lost->lostEventCount++;
+		return;
 	}
 
-	event->next = NULL;
-	event->length = size;
-	event->result = XR_SUCCESS;
+	struct oxr_event *slot = get_queued(inst, count);
 
-	*out_event = event;
+	if (count == OXR_EVENT_QUEUE_SIZE - 1) {
+		XrEventDataEventsLost *lost = EVENT_DATA(slot, XrEventDataEventsLost);
+		lost->type = XR_TYPE_EVENT_DATA_EVENTS_LOST;
+		lost->lostEventCount = 1;
+	} else {
+		*slot = *event;
+	}
 
-	return XR_SUCCESS;
+	xrt_atomic_s32_inc_return(&inst->event.count);
 }
 
 static bool
 is_session_link_to_event(struct oxr_event *event, XrSession session)
 {
-	XrStructureType *type = oxr_event_extra(event);
+	XrStructureType *type = (XrStructureType *)&event->data;
 
 	switch (*type) {
 	case XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED: {
@@ -153,20 +130,18 @@ oxr_event_push_XrEventDataSessionStateChanged(struct oxr_logger *log,
                                               XrTime time)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataSessionStateChanged *changed;
-	struct oxr_event *event = NULL;
-
-	ALLOC(log, inst, &event, &changed);
+	struct oxr_event event;
+	XrEventDataSessionStateChanged *changed = EVENT_DATA(&event, XrEventDataSessionStateChanged);
 
 	changed->type = XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED;
 	changed->session = oxr_session_to_openxr(sess);
 	changed->state = state;
 	changed->time = time;
 
-	event->result = XR_SUCCESS;
+	event.result = XR_SUCCESS;
 
 	lock(inst);
-	push(inst, event);
+	push(inst, &event);
 	unlock(inst);
 
 	return XR_SUCCESS;
@@ -176,16 +151,14 @@ XrResult
 oxr_event_push_XrEventDataInteractionProfileChanged(struct oxr_logger *log, struct oxr_session *sess)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataSessionStateChanged *changed;
-	struct oxr_event *event = NULL;
-
-	ALLOC(log, inst, &event, &changed);
+	struct oxr_event event;
+	XrEventDataInteractionProfileChanged *changed = EVENT_DATA(&event, XrEventDataInteractionProfileChanged);
 
 	changed->type = XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED;
 	changed->session = oxr_session_to_openxr(sess);
 
 	lock(inst);
-	push(inst, event);
+	push(inst, &event);
 	unlock(inst);
 
 	return XR_SUCCESS;
@@ -200,10 +173,8 @@ oxr_event_push_XrEventDataReferenceSpaceChangePending(struct oxr_logger *log,
                                                       const XrPosef *poseInPreviousSpace)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataReferenceSpaceChangePending *pending;
-	struct oxr_event *event = NULL;
-
-	ALLOC(log, inst, &event, &pending);
+	struct oxr_event event;
+	XrEventDataReferenceSpaceChangePending *pending = EVENT_DATA(&event, XrEventDataReferenceSpaceChangePending);
 
 	pending->type = XR_TYPE_EVENT_DATA_REFERENCE_SPACE_CHANGE_PENDING;
 	pending->session = oxr_session_to_openxr(sess);
@@ -211,10 +182,10 @@ oxr_event_push_XrEventDataReferenceSpaceChangePending(struct oxr_logger *log,
 	pending->changeTime = changeTime;
 	pending->poseValid = poseValid;
 	pending->poseInPreviousSpace = *poseInPreviousSpace;
-	event->result = XR_SUCCESS;
+	event.result = XR_SUCCESS;
 
 	lock(inst);
-	push(inst, event);
+	push(inst, &event);
 	unlock(inst);
 
 	return XR_SUCCESS;
@@ -228,16 +199,14 @@ oxr_event_push_XrEventDataDisplayRefreshRateChangedFB(struct oxr_logger *log,
                                                       float toDisplayRefreshRate)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataDisplayRefreshRateChangedFB *changed;
-	struct oxr_event *event = NULL;
-
-	ALLOC(log, inst, &event, &changed);
+	struct oxr_event event;
+	XrEventDataDisplayRefreshRateChangedFB *changed = EVENT_DATA(&event, XrEventDataDisplayRefreshRateChangedFB);
 	changed->type = XR_TYPE_EVENT_DATA_DISPLAY_REFRESH_RATE_CHANGED_FB;
 	changed->fromDisplayRefreshRate = fromDisplayRefreshRate;
 	changed->toDisplayRefreshRate = toDisplayRefreshRate;
-	event->result = XR_SUCCESS;
+	event.result = XR_SUCCESS;
 	lock(inst);
-	push(inst, event);
+	push(inst, &event);
 	unlock(inst);
 
 	return XR_SUCCESS;
@@ -251,16 +220,15 @@ oxr_event_push_XrEventDataMainSessionVisibilityChangedEXTX(struct oxr_logger *lo
                                                            bool visible)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataMainSessionVisibilityChangedEXTX *changed;
-	struct oxr_event *event = NULL;
-
-	ALLOC(log, inst, &event, &changed);
+	struct oxr_event event;
+	XrEventDataMainSessionVisibilityChangedEXTX *changed =
+	    EVENT_DATA(&event, XrEventDataMainSessionVisibilityChangedEXTX);
 	changed->type = XR_TYPE_EVENT_DATA_MAIN_SESSION_VISIBILITY_CHANGED_EXTX;
 	changed->flags = 0;
 	changed->visible = visible;
-	event->result = XR_SUCCESS;
+	event.result = XR_SUCCESS;
 	lock(inst);
-	push(inst, event);
+	push(inst, &event);
 	unlock(inst);
 
 	return XR_SUCCESS;
@@ -278,18 +246,16 @@ oxr_event_push_XrEventDataPerfSettingsEXTX(struct oxr_logger *log,
                                            enum xrt_perf_notify_level toLevel)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataPerfSettingsEXT *changed;
-	struct oxr_event *event = NULL;
-
-	ALLOC(log, inst, &event, &changed);
+	struct oxr_event event;
+	XrEventDataPerfSettingsEXT *changed = EVENT_DATA(&event, XrEventDataPerfSettingsEXT);
 	changed->type = XR_TYPE_EVENT_DATA_PERF_SETTINGS_EXT;
 	changed->domain = xrt_perf_domain_to_xr(domain);
 	changed->subDomain = xrt_perf_sub_domain_to_xr(subDomain);
 	changed->fromLevel = xrt_perf_notify_level_to_xr(fromLevel);
 	changed->toLevel = xrt_perf_notify_level_to_xr(toLevel);
-	event->result = XR_SUCCESS;
+	event.result = XR_SUCCESS;
 	lock(inst);
-	push(inst, event);
+	push(inst, &event);
 	unlock(inst);
 
 	return XR_SUCCESS;
@@ -303,15 +269,13 @@ oxr_event_push_XrEventDataPassthroughStateChangedFB(struct oxr_logger *log,
                                                     XrPassthroughStateChangedFlagsFB flags)
 {
 	struct oxr_instance *inst = sess->sys->inst;
-	XrEventDataPassthroughStateChangedFB *changed;
-	struct oxr_event *event = NULL;
-
-	ALLOC(log, inst, &event, &changed);
+	struct oxr_event event;
+	XrEventDataPassthroughStateChangedFB *changed = EVENT_DATA(&event, XrEventDataPassthroughStateChangedFB);
 	changed->type = XR_TYPE_EVENT_DATA_PASSTHROUGH_STATE_CHANGED_FB;
 	changed->flags = flags;
-	event->result = XR_SUCCESS;
+	event.result = XR_SUCCESS;
 	lock(inst);
-	push(inst, event);
+	push(inst, &event);
 	unlock(inst);
 
 	return XR_SUCCESS;
@@ -326,24 +290,21 @@ oxr_event_remove_session_events(struct oxr_logger *log, struct oxr_session *sess
 
 	lock(inst);
 
-	struct oxr_event *e = inst->event.next;
-	while (e != NULL) {
-		struct oxr_event *cur = e;
-		e = e->next;
-
-		if (!is_session_link_to_event(cur, session)) {
+	// Compact the queue in place, keeping the order.
+	uint32_t count = (uint32_t)inst->event.count;
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		struct oxr_event *e = get_queued(inst, i);
+		if (is_session_link_to_event(e, session)) {
 			continue;
 		}
 
-		if (cur == inst->event.next) {
-			inst->event.next = cur->next;
+		if (kept != i) {
+			*get_queued(inst, kept) = *e;
 		}
-
-		if (cur == inst->event.last) {
-			inst->event.last = NULL;
-		}
-		free(cur);
+		kept++;
 	}
+	inst->event.count = (int32_t)kept;
 
 	unlock(inst);
 
@@ -365,17 +326,26 @@ oxr_poll_event(struct oxr_logger *log, struct oxr_instance *inst, XrEventDataBuf
 		sess = sess->next;
 	}
 
+	// Apps poll until there are no events left, so make that case cheap.
+	if (inst->event.count == 0) {
+		return XR_EVENT_UNAVAILABLE;
+	}
+
 	lock(inst);
-	struct oxr_event *event = pop(inst);
-	unlock(inst);
 
-	if (event == NULL) {
+	if (inst->event.count == 0) {
+		unlock(inst);
 		return XR_EVENT_UNAVAILABLE;
 	}
 
+	struct oxr_event *event = get_queued(inst, 0);
 	ret = event->result;
-	memcpy(eventData, oxr_event_extra(event), event->length);
-	free(event);
+	memcpy(eventData, &event->data, event->length);
+
+	inst->event.head = (inst->event.head + 1) % OXR_EVENT_QUEUE_SIZE;
+	xrt_atomic_s32_dec_return(&inst->event.count);
+
+	unlock(inst);
 
 	return ret;
 }
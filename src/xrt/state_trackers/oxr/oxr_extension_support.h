@@ -179,6 +179,17 @@
 #endif
 
 
+/*
+ * XR_KHR_locate_spaces
+ */
+#if defined(XR_KHR_locate_spaces)
+#define OXR_HAVE_KHR_locate_spaces
+#define OXR_EXTENSION_SUPPORT_KHR_locate_spaces(_) _(KHR_locate_spaces, KHR_LOCATE_SPACES)
+#else
+#define OXR_EXTENSION_SUPPORT_KHR_locate_spaces(_)
+#endif
+
+
 /*
  * XR_KHR_opengl_enable
  */
@@ -439,6 +450,36 @@
 #define OXR_EXTENSION_SUPPORT_FB_display_refresh_rate(_)
 #endif
 
+/*
+ * XR_FB_foveation
+ */
+#if defined(XR_FB_foveation) && defined(XRT_FEATURE_OPENXR_FOVEATION_FB)
+#define OXR_HAVE_FB_foveation
+#define OXR_EXTENSION_SUPPORT_FB_foveation(_) _(FB_foveation, FB_FOVEATION)
+#else
+#define OXR_EXTENSION_SUPPORT_FB_foveation(_)
+#endif
+
+/*
+ * XR_FB_foveation_configuration
+ */
+#if defined(XR_FB_foveation_configuration) && defined(XRT_FEATURE_OPENXR_FOVEATION_FB)
+#define OXR_HAVE_FB_foveation_configuration
+#define OXR_EXTENSION_SUPPORT_FB_foveation_configuration(_) _(FB_foveation_configuration, FB_FOVEATION_CONFIGURATION)
+#else
+#define OXR_EXTENSION_SUPPORT_FB_foveation_configuration(_)
+#endif
+
+/*
+ * XR_FB_foveation_vulkan
+ */
+#if defined(XR_FB_foveation_vulkan) && defined(XR_USE_GRAPHICS_API_VULKAN) && defined(XRT_FEATURE_OPENXR_FOVEATION_FB)
+#define OXR_HAVE_FB_foveation_vulkan
+#define OXR_EXTENSION_SUPPORT_FB_foveation_vulkan(_) _(FB_foveation_vulkan, FB_FOVEATION_VULKAN)
+#else
+#define OXR_EXTENSION_SUPPORT_FB_foveation_vulkan(_)
+#endif
+
 /*
  * XR_FB_passthrough
  */
@@ -449,6 +490,37 @@
 #define OXR_EXTENSION_SUPPORT_FB_passthrough(_)
 #endif
 
+/*
+ * XR_FB_space_warp
+ */
+#if defined(XR_FB_space_warp) && defined(XRT_FEATURE_OPENXR_LAYER_FB_SPACE_WARP)
+#define OXR_HAVE_FB_space_warp
+#define OXR_EXTENSION_SUPPORT_FB_space_warp(_) _(FB_space_warp, FB_SPACE_WARP)
+#else
+#define OXR_EXTENSION_SUPPORT_FB_space_warp(_)
+#endif
+
+/*
+ * XR_FB_swapchain_update_state
+ */
+#if defined(XR_FB_swapchain_update_state) && defined(XRT_FEATURE_OPENXR_FOVEATION_FB)
+#define OXR_HAVE_FB_swapchain_update_state
+#define OXR_EXTENSION_SUPPORT_FB_swapchain_update_state(_) _(FB_swapchain_update_state, FB_SWAPCHAIN_UPDATE_STATE)
+#else
+#define OXR_EXTENSION_SUPPORT_FB_swapchain_update_state(_)
+#endif
+
+/*
+ * XR_META_recommended_layer_resolution
+ */
+#if defined(XR_META_recommended_layer_resolution) && defined(XRT_FEATURE_OPENXR_META_RECOMMENDED_LAYER_RESOLUTION)
+#define OXR_HAVE_META_recommended_layer_resolution
+#define OXR_EXTENSION_SUPPORT_META_recommended_layer_resolution(_)                                                     \
+	_(META_recommended_layer_resolution, META_RECOMMENDED_LAYER_RESOLUTION)
+#else
+#define OXR_EXTENSION_SUPPORT_META_recommended_layer_resolution(_)
+#endif
+
 /*
  * XR_ML_ml2_controller_interaction
  */
@@ -645,6 +717,7 @@
     OXR_EXTENSION_SUPPORT_KHR_D3D12_enable(_) \
     OXR_EXTENSION_SUPPORT_KHR_loader_init(_) \
     OXR_EXTENSION_SUPPORT_KHR_loader_init_android(_) \
+    OXR_EXTENSION_SUPPORT_KHR_locate_spaces(_) \
     OXR_EXTENSION_SUPPORT_KHR_opengl_enable(_) \
     OXR_EXTENSION_SUPPORT_KHR_opengl_es_enable(_) \
     OXR_EXTENSION_SUPPORT_KHR_swapchain_usage_input_attachment_bit(_) \
@@ -668,7 +741,13 @@
     OXR_EXTENSION_SUPPORT_FB_composition_layer_settings(_) \
     OXR_EXTENSION_SUPPORT_FB_composition_layer_depth_test(_)  \
     OXR_EXTENSION_SUPPORT_FB_display_refresh_rate(_) \
+    OXR_EXTENSION_SUPPORT_FB_foveation(_) \
+    OXR_EXTENSION_SUPPORT_FB_foveation_configuration(_) \
+    OXR_EXTENSION_SUPPORT_FB_foveation_vulkan(_) \
     OXR_EXTENSION_SUPPORT_FB_passthrough(_) \
+    OXR_EXTENSION_SUPPORT_FB_space_warp(_) \
+    OXR_EXTENSION_SUPPORT_FB_swapchain_update_state(_) \
+    OXR_EXTENSION_SUPPORT_META_recommended_layer_resolution(_) \
     OXR_EXTENSION_SUPPORT_ML_ml2_controller_interaction(_) \
     OXR_EXTENSION_SUPPORT_MND_headless(_) \
     OXR_EXTENSION_SUPPORT_MND_swapchain_usage_input_attachment_bit(_) \
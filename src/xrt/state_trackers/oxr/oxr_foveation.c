@@ -0,0 +1,208 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Foveation profiles and fragment density map updates.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup oxr_main
+ */
+
+#include "os/os_time.h"
+#include "math/m_api.h"
+#include "util/u_misc.h"
+#include "util/u_foveation.h"
+
+#include "oxr_objects.h"
+#include "oxr_logger.h"
+#include "oxr_handle.h"
+#include "oxr_chain.h"
+#include "oxr_xret.h"
+
+#include <math.h>
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static XrResult
+oxr_foveation_profile_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
+{
+	struct oxr_foveation_profile *profile = (struct oxr_foveation_profile *)hb;
+	free(profile);
+	return XR_SUCCESS;
+}
+
+static enum u_foveation_level
+get_level(struct oxr_swapchain *sc)
+{
+	XrFoveationLevelFB level = sc->foveation.level;
+
+	/*
+	 * A dynamic level is the most the app allows, only go all the way
+	 * when the compositor is also lowering the resolution for this app.
+	 */
+	if (sc->foveation.dynamic && level > XR_FOVEATION_LEVEL_NONE_FB &&
+	    sc->sess->recommended_resolution_scale >= 1.0f) {
+		level--;
+	}
+
+	switch (level) {
+	case XR_FOVEATION_LEVEL_LOW_FB: return U_FOVEATION_LEVEL_LOW;
+	case XR_FOVEATION_LEVEL_MEDIUM_FB: return U_FOVEATION_LEVEL_MEDIUM;
+	case XR_FOVEATION_LEVEL_HIGH_FB: return U_FOVEATION_LEVEL_HIGH;
+	default: return U_FOVEATION_LEVEL_NONE;
+	}
+}
+
+/*!
+ * Gaze direction in head space, straight ahead if there is no eye tracking
+ * or no valid gaze, the devices are assumed to share a tracking origin.
+ */
+static struct xrt_vec3
+get_gaze_direction(struct oxr_session *sess)
+{
+	struct xrt_device *head = GET_XDEV_BY_ROLE(sess->sys, head);
+	struct xrt_device *eyes = GET_XDEV_BY_ROLE(sess->sys, eyes);
+	struct xrt_vec3 forward = {0.0f, 0.0f, -1.0f};
+
+	if (eyes == NULL || head == NULL || !eyes->eye_gaze_supported) {
+		return forward;
+	}
+
+	uint64_t now_ns = os_monotonic_get_ns();
+	struct xrt_space_relation gaze_rel = XRT_SPACE_RELATION_ZERO;
+	xrt_device_get_tracked_pose(eyes, XRT_INPUT_GENERIC_EYE_GAZE_POSE, now_ns, &gaze_rel);
+	if ((gaze_rel.relation_flags & XRT_SPACE_RELATION_ORIENTATION_VALID_BIT) == 0) {
+		return forward;
+	}
+
+	struct xrt_pose gaze = gaze_rel.pose;
+	if (eyes != head) {
+		struct xrt_space_relation head_rel = XRT_SPACE_RELATION_ZERO;
+		xrt_device_get_tracked_pose(head, XRT_INPUT_GENERIC_HEAD_POSE, now_ns, &head_rel);
+
+		struct xrt_pose head_inv;
+		math_pose_invert(&head_rel.pose, &head_inv);
+		math_pose_transform(&head_inv, &gaze_rel.pose, &gaze);
+	}
+
+	struct xrt_vec3 dir;
+	math_quat_rotate_vec3(&gaze.orientation, &forward, &dir);
+
+	return dir;
+}
+
+/*!
+ * Where @p dir lands in the image of a view with @p fov, in normalized image
+ * coordinates, clamped to the image.
+ */
+static struct xrt_vec2
+direction_to_uv(const struct xrt_fov *fov, struct xrt_vec3 dir, float vertical_offset_deg)
+{
+	struct xrt_vec2 center = {0.5f, 0.5f};
+
+	// Looking backwards or sideways, nothing sensible to do.
+	if (dir.z > -0.01f) {
+		return center;
+	}
+
+	float tan_x = dir.x / -dir.z;
+	float tan_y = tanf(atanf(dir.y / -dir.z) + vertical_offset_deg * (float)(M_PI / 180.0));
+
+	float tan_left = tanf(fov->angle_left);
+	float tan_right = tanf(fov->angle_right);
+	float tan_up = tanf(fov->angle_up);
+	float tan_down = tanf(fov->angle_down);
+
+	if (tan_right - tan_left <= 0.0f || tan_up - tan_down <= 0.0f) {
+		return center;
+	}
+
+	// Image coordinates go downwards.
+	float u = (tan_x - tan_left) / (tan_right - tan_left);
+	float v = (tan_up - tan_y) / (tan_up - tan_down);
+
+	center.x = u < 0.0f ? 0.0f : (u > 1.0f ? 1.0f : u);
+	center.y = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+
+	return center;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+XrResult
+oxr_foveation_profile_create(struct oxr_logger *log,
+                             struct oxr_session *sess,
+                             const XrFoveationProfileCreateInfoFB *createInfo,
+                             struct oxr_foveation_profile **out_profile)
+{
+	struct oxr_foveation_profile *profile = NULL;
+	OXR_ALLOCATE_HANDLE_OR_RETURN(log, profile, OXR_XR_DEBUG_FOVEATION, oxr_foveation_profile_destroy,
+	                              &sess->handle);
+
+	profile->sess = sess;
+	profile->level = XR_FOVEATION_LEVEL_NONE_FB;
+
+#ifdef OXR_HAVE_FB_foveation_configuration
+	const XrFoveationLevelProfileCreateInfoFB *level_info = NULL;
+	if (sess->sys->inst->extensions.FB_foveation_configuration) {
+		level_info = OXR_GET_INPUT_FROM_CHAIN(createInfo, XR_TYPE_FOVEATION_LEVEL_PROFILE_CREATE_INFO_FB,
+		                                      XrFoveationLevelProfileCreateInfoFB);
+	}
+
+	if (level_info != NULL) {
+		profile->level = level_info->level;
+		profile->vertical_offset_deg = level_info->verticalOffset;
+		profile->dynamic = level_info->dynamic == XR_FOVEATION_DYNAMIC_LEVEL_ENABLED_FB;
+	}
+#endif
+
+	*out_profile = profile;
+
+	return XR_SUCCESS;
+}
+
+void
+oxr_swapchain_set_foveation_profile(struct oxr_swapchain *sc, struct oxr_foveation_profile *profile)
+{
+	sc->foveation.profile = oxr_foveation_profile_to_openxr(profile);
+	sc->foveation.level = profile->level;
+	sc->foveation.vertical_offset_deg = profile->vertical_offset_deg;
+	sc->foveation.dynamic = profile->dynamic;
+}
+
+XrResult
+oxr_swapchain_update_foveation(struct oxr_logger *log, struct oxr_swapchain *sc, uint32_t index)
+{
+	if (!sc->foveation.fdm) {
+		return XR_SUCCESS;
+	}
+
+	struct oxr_session *sess = sc->sess;
+	struct xrt_device *head = GET_XDEV_BY_ROLE(sess->sys, head);
+
+	struct xrt_foveation_params params;
+	u_foveation_params_from_level(get_level(sc), &params);
+
+	if (head != NULL && head->hmd != NULL) {
+		struct xrt_vec3 dir = get_gaze_direction(sess);
+		float offset_deg = sc->foveation.vertical_offset_deg;
+
+		for (uint32_t i = 0; i < head->hmd->view_count && i < XRT_MAX_VIEWS; i++) {
+			params.centers[i] = direction_to_uv(&head->hmd->distortion.fov[i], dir, offset_deg);
+		}
+	}
+
+	xrt_result_t xret = xrt_swapchain_set_foveation(sc->swapchain, index, &params);
+	OXR_CHECK_XRET(log, sess, xret, xrt_swapchain_set_foveation);
+
+	return XR_SUCCESS;
+}
@@ -90,6 +90,70 @@ oxr_handle_allocate_and_init(struct oxr_logger *log,
 		}                                                                                                      \
 	} while (0)
 
+/*!
+ * Get memory for a handle from a pool, and initialize it as a handle.
+ *
+ * Mainly for internal use - use OXR_ALLOCATE_POOLED_HANDLE_OR_RETURN instead
+ * which wraps this. The destroy function must give the memory back with
+ * @ref oxr_handle_pool_free instead of calling free.
+ *
+ * @relates oxr_handle_base
+ */
+XrResult
+oxr_handle_allocate_from_pool_and_init(struct oxr_logger *log,
+                                       struct oxr_handle_pool *pool,
+                                       size_t size,
+                                       uint64_t debug,
+                                       oxr_handle_destroyer destroy,
+                                       struct oxr_handle_base *parent,
+                                       void **out);
+
+/*!
+ * Same as OXR_ALLOCATE_HANDLE_OR_RETURN() but gets the memory from @p POOL.
+ *
+ * @relates oxr_handle_base
+ */
+#define OXR_ALLOCATE_POOLED_HANDLE_OR_RETURN(LOG, OUT, POOL, DEBUG, DESTROY, PARENT)                                   \
+	do {                                                                                                           \
+		XrResult allocResult = oxr_handle_allocate_from_pool_and_init(LOG, POOL, sizeof(*OUT), DEBUG, DESTROY, \
+		                                                              PARENT, (void **)&OUT);                  \
+		if (allocResult != XR_SUCCESS) {                                                                       \
+			return allocResult;                                                                            \
+		}                                                                                                      \
+	} while (0)
+
+/*!
+ * Init a pool for handles no larger then @p item_size.
+ *
+ * @public @memberof oxr_handle_pool
+ */
+void
+oxr_handle_pool_init(struct oxr_handle_pool *pool, size_t item_size);
+
+/*!
+ * Frees all memory of the pool, all handles must have been given back.
+ *
+ * @public @memberof oxr_handle_pool
+ */
+void
+oxr_handle_pool_fini(struct oxr_handle_pool *pool);
+
+/*!
+ * Get zeroed memory for a single item.
+ *
+ * @public @memberof oxr_handle_pool
+ */
+void *
+oxr_handle_pool_alloc(struct oxr_handle_pool *pool);
+
+/*!
+ * Give back a item, it is zeroed.
+ *
+ * @public @memberof oxr_handle_pool
+ */
+void
+oxr_handle_pool_free(struct oxr_handle_pool *pool, void *ptr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -15,10 +15,27 @@
 #include "oxr_logger.h"
 
 #include <assert.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdlib.h>
 
 
+//! Number of items allocated at once by a handle pool.
+#define POOL_SLAB_ITEM_COUNT (32)
+
+/*!
+ * A single allocation of a handle pool, the union keeps the items aligned.
+ */
+struct oxr_handle_pool_slab
+{
+	union {
+		struct oxr_handle_pool_slab *next;
+		max_align_t align;
+	};
+
+	uint8_t data[];
+};
+
 #define HANDLE_LIFECYCLE_LOG(log, ...)                                                                                 \
 	if (log->inst != NULL && log->inst->lifecycle_verbose) {                                                       \
 		oxr_log(log, " Handle Lifecycle: " __VA_ARGS__);                                                       \
@@ -122,6 +139,28 @@ oxr_handle_allocate_and_init(struct oxr_logger *log,
 	return result;
 }
 
+XrResult
+oxr_handle_allocate_from_pool_and_init(struct oxr_logger *log,
+                                       struct oxr_handle_pool *pool,
+                                       size_t size,
+                                       uint64_t debug,
+                                       oxr_handle_destroyer destroy,
+                                       struct oxr_handle_base *parent,
+                                       void **out)
+{
+	assert(size <= pool->item_size);
+	(void)size;
+
+	struct oxr_handle_base *hb = (struct oxr_handle_base *)oxr_handle_pool_alloc(pool);
+	XrResult result = oxr_handle_init(log, hb, debug, destroy, parent);
+	if (result != XR_SUCCESS) {
+		oxr_handle_pool_free(pool, hb);
+		return result;
+	}
+	*out = (void *)hb;
+	return result;
+}
+
 /*!
  * This is the actual recursive call that destroys handles.
  *
@@ -212,3 +251,85 @@ oxr_handle_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 	}
 	HANDLE_LIFECYCLE_LOG_SCOPED_END;
 }
+
+
+/*
+ *
+ * Handle pool.
+ *
+ */
+
+static void
+pool_grow_locked(struct oxr_handle_pool *pool)
+{
+	size_t size = sizeof(struct oxr_handle_pool_slab) + pool->item_size * POOL_SLAB_ITEM_COUNT;
+	struct oxr_handle_pool_slab *slab = U_CALLOC_WITH_CAST(struct oxr_handle_pool_slab, size);
+	slab->next = pool->slabs;
+	pool->slabs = slab;
+
+	// Room for every item, so that freeing never needs to allocate.
+	pool->free_capacity += POOL_SLAB_ITEM_COUNT;
+	U_ARRAY_REALLOC_OR_FREE(pool->free_items, void *, pool->free_capacity);
+
+	// Pushed in reverse so that items are handed out in address order.
+	for (uint32_t i = POOL_SLAB_ITEM_COUNT; i > 0; i--) {
+		pool->free_items[pool->free_count++] = &slab->data[pool->item_size * (i - 1)];
+	}
+}
+
+void
+oxr_handle_pool_init(struct oxr_handle_pool *pool, size_t item_size)
+{
+	U_ZERO(pool);
+	os_mutex_init(&pool->mutex);
+
+	// Keep every item as aligned as the slab data.
+	size_t align = sizeof(max_align_t);
+	pool->item_size = (item_size + align - 1) / align * align;
+}
+
+void
+oxr_handle_pool_fini(struct oxr_handle_pool *pool)
+{
+	struct oxr_handle_pool_slab *slab = pool->slabs;
+	while (slab != NULL) {
+		struct oxr_handle_pool_slab *next = slab->next;
+		free(slab);
+		slab = next;
+	}
+
+	free(pool->free_items);
+	os_mutex_destroy(&pool->mutex);
+	U_ZERO(pool);
+}
+
+void *
+oxr_handle_pool_alloc(struct oxr_handle_pool *pool)
+{
+	os_mutex_lock(&pool->mutex);
+
+	if (pool->free_count == 0) {
+		pool_grow_locked(pool);
+	}
+
+	void *ptr = pool->free_items[--pool->free_count];
+
+	os_mutex_unlock(&pool->mutex);
+
+	return ptr;
+}
+
+void
+oxr_handle_pool_free(struct oxr_handle_pool *pool, void *ptr)
+{
+	// Zeroed here, so the pool always hands out zeroed memory.
+	memset(ptr, 0, pool->item_size);
+
+	os_mutex_lock(&pool->mutex);
+
+	// There is always room, the array holds every item ever allocated.
+	assert(pool->free_count < pool->free_capacity);
+	pool->free_items[pool->free_count++] = ptr;
+
+	os_mutex_unlock(&pool->mutex);
+}
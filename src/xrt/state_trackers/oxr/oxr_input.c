@@ -362,7 +362,7 @@ oxr_action_destroy_cb(struct oxr_logger *log, struct oxr_handle_base *hb)
 		act->loc_item = NULL;
 	}
 
-	free(act);
+	oxr_handle_pool_free(&act->act_set->inst->handle_pools.actions, act);
 
 	return XR_SUCCESS;
 }
@@ -385,7 +385,8 @@ oxr_action_create(struct oxr_logger *log,
 	}
 
 	struct oxr_action *act = NULL;
-	OXR_ALLOCATE_HANDLE_OR_RETURN(log, act, OXR_XR_DEBUG_ACTION, oxr_action_destroy_cb, &act_set->handle);
+	OXR_ALLOCATE_POOLED_HANDLE_OR_RETURN(log, act, &inst->handle_pools.actions, OXR_XR_DEBUG_ACTION,
+	                                     oxr_action_destroy_cb, &act_set->handle);
 
 
 	struct oxr_action_ref *act_ref = U_TYPED_CALLOC(struct oxr_action_ref);
@@ -1093,6 +1094,110 @@ oxr_input_combine_input(struct oxr_session *sess,
 	return true;
 }
 
+static inline bool
+oxr_input_snapshot_equal(const struct oxr_input_snapshot *snapshot, const struct xrt_input *input)
+{
+	return snapshot->active == input->active && snapshot->timestamp == input->timestamp &&
+	       memcmp(&snapshot->value, &input->value, sizeof(snapshot->value)) == 0;
+}
+
+static inline void
+oxr_input_snapshot_take(struct oxr_input_snapshot *snapshot, const struct xrt_input *input)
+{
+	snapshot->active = input->active;
+	snapshot->timestamp = input->timestamp;
+	snapshot->value = input->value;
+}
+
+/*!
+ * Has anything that goes into combining the inputs of this cache changed since
+ * it was last done, the transforms only depend on the inputs so they are safe
+ * to skip as well.
+ *
+ * @private @memberof oxr_action_cache
+ */
+static bool
+oxr_action_cache_inputs_changed(struct oxr_session *sess, struct oxr_action_cache *cache)
+{
+	if (!cache->combined.valid || cache->combined.generation != sess->action_sync_generation) {
+		return true;
+	}
+
+	for (size_t i = 0; i < cache->input_count; i++) {
+		struct oxr_action_input *action_input = &cache->inputs[i];
+
+		if (!oxr_input_snapshot_equal(&action_input->snapshot, action_input->input)) {
+			return true;
+		}
+
+		if (action_input->dpad_activate != NULL &&
+		    !oxr_input_snapshot_equal(&action_input->dpad_activate_snapshot, action_input->dpad_activate)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*!
+ * Combine the inputs of the cache, or reuse the last result if none of them
+ * have changed, see @ref oxr_action_cache_inputs_changed.
+ *
+ * @private @memberof oxr_action_cache
+ */
+static bool
+oxr_action_cache_combine_input(struct oxr_session *sess,
+                               uint32_t countActionSets,
+                               const XrActiveActionSet *actionSets,
+                               struct oxr_action_attachment *act_attached,
+                               struct oxr_subaction_paths *subaction_path,
+                               struct oxr_action_cache *cache,
+                               struct oxr_input_value_tagged *out_input,
+                               int64_t *out_timestamp,
+                               bool *out_is_active)
+{
+	if (!oxr_action_cache_inputs_changed(sess, cache)) {
+		out_input->type = cache->combined.type;
+		out_input->value = cache->combined.value;
+		*out_timestamp = cache->combined.timestamp;
+		*out_is_active = cache->combined.is_active;
+		return true;
+	}
+
+	// Take the snapshots first, so they match what was combined.
+	for (size_t i = 0; i < cache->input_count; i++) {
+		struct oxr_action_input *action_input = &cache->inputs[i];
+
+		oxr_input_snapshot_take(&action_input->snapshot, action_input->input);
+
+		if (action_input->dpad_activate != NULL) {
+			oxr_input_snapshot_take(&action_input->dpad_activate_snapshot, action_input->dpad_activate);
+		}
+	}
+
+	cache->combined.valid = oxr_input_combine_input( //
+	    sess,                                        // sess
+	    countActionSets,                             // countActionSets
+	    actionSets,                                  // actionSets
+	    act_attached,                                // act_attached
+	    subaction_path,                              // subaction_path
+	    cache,                                       // cache
+	    out_input,                                   // out_input
+	    out_timestamp,                               // out_timestamp
+	    out_is_active);                              // out_is_active
+	if (!cache->combined.valid) {
+		return false;
+	}
+
+	cache->combined.generation = sess->action_sync_generation;
+	cache->combined.is_active = *out_is_active;
+	cache->combined.timestamp = *out_timestamp;
+	cache->combined.type = out_input->type;
+	cache->combined.value = out_input->value;
+
+	return true;
+}
+
 /*!
  * Called during xrSyncActions.
  *
@@ -1131,16 +1236,16 @@ oxr_action_cache_update(struct oxr_logger *log,
 	} else if (cache->input_count > 0) {
 
 		bool is_active = false;
-		bool bret = oxr_input_combine_input( //
-		    sess,                            // sess
-		    countActionSets,                 // countActionSets
-		    actionSets,                      // actionSets
-		    act_attached,                    // act_attached
-		    subaction_path,                  // subaction_path
-		    cache,                           // cache
-		    &combined,                       // out_input
-		    &timestamp,                      // out_timestamp
-		    &is_active);                     // out_is_active
+		bool bret = oxr_action_cache_combine_input( //
+		    sess,                                   // sess
+		    countActionSets,                        // countActionSets
+		    actionSets,                             // actionSets
+		    act_attached,                           // act_attached
+		    subaction_path,                         // subaction_path
+		    cache,                                  // cache
+		    &combined,                              // out_input
+		    &timestamp,                             // out_timestamp
+		    &is_active);                            // out_is_active
 		if (!bret) {
 			oxr_log(log, "Failed to get/combine input values '%s'", act_attached->act_ref->name);
 			return;
@@ -1858,6 +1963,22 @@ oxr_action_sync_data(struct oxr_logger *log,
 		}
 	}
 
+	// Input suppression depends on what is synced, redo all combines if changed.
+	bool sync_changed = false;
+	for (size_t i = 0; i < sess->action_set_attachment_count; ++i) {
+		act_set_attached = &sess->act_set_attachments[i];
+		struct oxr_subaction_paths *requested = &act_set_attached->requested_subaction_paths;
+		struct oxr_subaction_paths *last = &act_set_attached->last_requested_subaction_paths;
+
+		if (memcmp(requested, last, sizeof(*requested)) != 0) {
+			sync_changed = true;
+		}
+		*last = *requested;
+	}
+	if (sync_changed) {
+		sess->action_sync_generation++;
+	}
+
 	// Now, update all action attachments
 	for (size_t i = 0; i < sess->action_set_attachment_count; ++i) {
 		act_set_attached = &sess->act_set_attachments[i];
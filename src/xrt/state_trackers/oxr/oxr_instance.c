@@ -35,6 +35,7 @@
 #include "oxr_extension_support.h"
 #include "oxr_subaction.h"
 #include "oxr_chain.h"
+#include "oxr_api_stats.h"
 
 #include <sys/types.h>
 #ifdef XRT_OS_UNIX
@@ -61,6 +62,9 @@ oxr_instance_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 
 	u_var_remove_root((void *)inst);
 
+	// Counters are for the whole process, but this is a good time to show them.
+	oxr_api_stats_dump(log);
+
 	oxr_binding_destroy_all(log, inst);
 
 	oxr_path_destroy(log, inst);
@@ -76,6 +80,10 @@ oxr_instance_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 
 	xrt_space_overseer_destroy(&inst->system.xso);
 	os_mutex_destroy(&inst->system.sync_actions_mutex);
+
+	// All spaces and actions are children, so they are already destroyed.
+	oxr_handle_pool_fini(&inst->handle_pools.spaces);
+	oxr_handle_pool_fini(&inst->handle_pools.actions);
 	xrt_system_devices_destroy(&inst->system.xsysd);
 
 #ifdef XRT_FEATURE_CLIENT_DEBUG_GUI
@@ -210,6 +218,9 @@ oxr_instance_create(struct oxr_logger *log,
 	inst->debug_views = debug_get_bool_option_debug_views();
 	inst->debug_bindings = debug_get_bool_option_debug_bindings();
 
+	oxr_handle_pool_init(&inst->handle_pools.spaces, sizeof(struct oxr_space));
+	oxr_handle_pool_init(&inst->handle_pools.actions, sizeof(struct oxr_action));
+
 	m_ret = os_mutex_init(&inst->event.mutex);
 	if (m_ret < 0) {
 		ret = oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to init mutex");
@@ -24,6 +24,7 @@
 
 #include "os/os_threading.h"
 
+#include "util/u_arena.h"
 #include "util/u_index_fifo.h"
 #include "util/u_hashset.h"
 #include "util/u_hashmap.h"
@@ -110,6 +111,8 @@ struct oxr_action_set;
 struct oxr_action;
 struct oxr_debug_messenger;
 struct oxr_handle_base;
+struct oxr_handle_pool;
+struct oxr_handle_pool_slab;
 struct oxr_subaction_paths;
 struct oxr_action_attachment;
 struct oxr_action_set_attachment;
@@ -120,6 +123,9 @@ struct oxr_binding;
 struct oxr_interaction_profile;
 struct oxr_action_set_ref;
 struct oxr_action_ref;
+struct oxr_path;
+struct oxr_path_chunk;
+struct oxr_locate_cache;
 struct oxr_hand_tracker;
 struct oxr_facial_tracker_htc;
 
@@ -338,6 +344,15 @@ XrResult
 oxr_path_get_string(
     struct oxr_logger *log, const struct oxr_instance *inst, XrPath path, const char **out_str, size_t *out_length);
 
+/*!
+ * Get the path of the @p index'th interaction profile template, the static
+ * paths are the same for every instance so no lookup is needed.
+ *
+ * @public @memberof oxr_instance
+ */
+XrPath
+oxr_path_get_profile_template(struct oxr_instance *inst, size_t index);
+
 /*!
  * Destroy the path system and all paths that the instance has created.
  *
@@ -845,6 +860,27 @@ XrResult
 oxr_space_locate(
     struct oxr_logger *log, struct oxr_space *spc, struct oxr_space *baseSpc, XrTime time, XrSpaceLocation *location);
 
+#ifdef OXR_HAVE_KHR_locate_spaces
+/*!
+ * Locate multiple spaces in the same base space, all of the spaces are
+ * located with a single call to the @ref xrt_space_overseer.
+ *
+ * @param      log       Logging struct.
+ * @param      spcs      Array of spaces to locate.
+ * @param      spc_count Number of spaces, must match the counts in @p locations.
+ * @param      baseSpc   Base space where the spaces are to be located.
+ * @param[in]  time      Time in OpenXR domain.
+ * @param[out] locations Returns the locations, and velocities if chained.
+ */
+XrResult
+oxr_spaces_locate(struct oxr_logger *log,
+                  struct oxr_space **spcs,
+                  uint32_t spc_count,
+                  struct oxr_space *baseSpc,
+                  XrTime time,
+                  XrSpaceLocationsKHR *locations);
+#endif // OXR_HAVE_KHR_locate_spaces
+
 /*!
  * Locate the @ref xrt_device in the given base space, useful for implementing
  * hand tracking location look ups and the like.
@@ -864,6 +900,26 @@ oxr_space_locate_device(struct oxr_logger *log,
                         XrTime time,
                         struct xrt_space_relation *out_relation);
 
+/*!
+ * @public @memberof oxr_locate_cache
+ */
+void
+oxr_locate_cache_init(struct oxr_locate_cache *cache, bool enabled);
+
+/*!
+ * @public @memberof oxr_locate_cache
+ */
+void
+oxr_locate_cache_fini(struct oxr_locate_cache *cache);
+
+/*!
+ * Drop all cached locates, called at the start of each frame.
+ *
+ * @public @memberof oxr_locate_cache
+ */
+void
+oxr_locate_cache_clear(struct oxr_locate_cache *cache);
+
 
 /*
  *
@@ -1334,6 +1390,31 @@ struct oxr_handle_base
 	oxr_handle_destroyer destroy;
 };
 
+/*!
+ * Slab allocator for handles of a single type, keeps them close together and
+ * once warmed up creating and destroying handles doesn't go to malloc. Freed
+ * handles are zeroed, so a stale handle fails validation until its slot is
+ * reused.
+ *
+ * Functions are in oxr_handle.h.
+ */
+struct oxr_handle_pool
+{
+	//! Handles are created and destroyed from any thread.
+	struct os_mutex mutex;
+
+	//! Size of each item, at least the size of the handle struct.
+	size_t item_size;
+
+	//! All slabs, linked list.
+	struct oxr_handle_pool_slab *slabs;
+
+	//! Stack of free items.
+	void **free_items;
+	uint32_t free_count;
+	uint32_t free_capacity;
+};
+
 /*!
  * Single or multiple devices grouped together to form a system that sessions
  * can be created from. Might need to open devices to get all
@@ -1499,6 +1580,65 @@ struct oxr_extension_status
 };
 #undef MAKE_EXT_STATUS
 
+/*!
+ * Number of events that can be queued on an instance, the last slot is used
+ * to tell the app that events were lost.
+ */
+#define OXR_EVENT_QUEUE_SIZE (32)
+
+/*!
+ * Largest event struct that can be queued.
+ */
+#define OXR_EVENT_MAX_SIZE (256)
+
+/*!
+ * A single queued event, see @ref oxr_instance::event.
+ *
+ * @ingroup oxr_main
+ */
+struct oxr_event
+{
+	//! Size of the event struct in data.
+	size_t length;
+
+	XrResult result;
+
+	//! Holds one of the XrEventData* structs.
+	union {
+		XrEventDataBaseHeader base;
+		int64_t align;
+		uint8_t bytes[OXR_EVENT_MAX_SIZE];
+	} data;
+};
+
+/*!
+ * A store of paths, for looking up paths, see oxr_path.c.
+ *
+ * The static paths that come from the interaction profile templates live in a
+ * single store that is shared between all instances in the process, each
+ * instance has its own store for the paths created by the app whose IDs come
+ * after the static ones.
+ */
+struct oxr_path_store
+{
+	//! Mapping from ID minus @ref first_id to path, stored by value.
+	struct oxr_path *paths;
+	//! Number of paths in the array.
+	size_t count;
+	//! Total length of path array.
+	size_t capacity;
+	//! ID of the first path in the array, 0 (the null path) for the static store.
+	XrPath first_id;
+
+	//! Open addressing table of path IDs, keyed on the string hash.
+	XrPath *table;
+	//! Length of the table, always a power of two.
+	size_t table_length;
+
+	//! Chunks that the path strings are bump allocated from.
+	struct oxr_path_chunk *chunks;
+};
+
 /*!
  * Main object that ties everything together.
  *
@@ -1530,21 +1670,34 @@ struct oxr_instance
 		struct u_hashset *loc_store;
 	} action_sets;
 
-	//! Path store, for looking up paths.
-	struct u_hashset *path_store;
-	//! Mapping from ID to path.
-	struct oxr_path **path_array;
-	//! Total length of path array.
-	size_t path_array_length;
-	//! Number of paths in the array (0 is always null).
-	size_t path_num;
+	//! Pools for the handles that apps create and destroy a lot of.
+	struct
+	{
+		struct oxr_handle_pool spaces;
+		struct oxr_handle_pool actions;
+	} handle_pools;
+
+	/*!
+	 * Path store for the paths the app creates, it comes after the process
+	 * wide store of static paths, see oxr_path.c.
+	 */
+	struct oxr_path_store path_store;
 
-	// Event queue.
+	/*!
+	 * Event queue, a ring of pre-allocated events. Pushing and popping is
+	 * done with the mutex held, the count is also read without it.
+	 */
 	struct
 	{
 		struct os_mutex mutex;
-		struct oxr_event *last;
-		struct oxr_event *next;
+
+		//! Number of queued events, checked without the lock.
+		xrt_atomic_s32_t count;
+
+		//! Slot of the oldest queued event.
+		uint32_t head;
+
+		struct oxr_event slots[OXR_EVENT_QUEUE_SIZE];
 	} event;
 
 	//! Interaction profile bindings that have been suggested by the client.
@@ -1622,6 +1775,71 @@ struct oxr_instance
 #endif
 };
 
+/*!
+ * Number of locate results kept per session, see @ref oxr_locate_cache.
+ */
+#define OXR_LOCATE_CACHE_SIZE (16)
+
+/*!
+ * A single cached locate, either of a space or a device in a base space.
+ *
+ * @ingroup oxr_main
+ */
+struct oxr_locate_cache_entry
+{
+	struct xrt_space *xbase;
+	struct xrt_pose base_offset;
+
+	//! Only one of these two is set.
+	struct xrt_space *xtarget;
+	struct xrt_device *xdev;
+	struct xrt_pose target_offset;
+
+	uint64_t at_timestamp_ns;
+
+	struct xrt_space_relation relation;
+};
+
+/*!
+ * Per frame cache of space and device locates, so that locating the same thing
+ * at the same time several times during a frame, like xrLocateViews followed
+ * by xrLocateSpace on the view space, only goes down to the space overseer and
+ * device once. Cleared in xrWaitFrame and when a space is destroyed.
+ *
+ * @ingroup oxr_main
+ */
+struct oxr_locate_cache
+{
+	//! Locates can happen from any thread.
+	struct os_mutex mutex;
+
+	//! Can be turned off with OXR_LOCATE_CACHE, nothing is cached then.
+	bool enabled;
+
+	//! Number of valid entries, and where the next one will be put.
+	uint32_t count;
+	uint32_t next;
+
+	//! Bumped every time the cache is cleared, lets others tie their caches to it.
+	uint64_t generation;
+
+	struct oxr_locate_cache_entry entries[OXR_LOCATE_CACHE_SIZE];
+
+	//! The last view poses and fovs from @ref xrt_device_get_view_poses.
+	struct
+	{
+		bool valid;
+		struct xrt_device *xdev;
+		struct xrt_vec3 eye_relation;
+		uint64_t at_timestamp_ns;
+		uint32_t view_count;
+
+		struct xrt_space_relation head_relation;
+		struct xrt_fov fovs[XRT_MAX_VIEWS];
+		struct xrt_pose poses[XRT_MAX_VIEWS];
+	} views;
+};
+
 /*!
  * Object that client program interact with.
  *
@@ -1660,6 +1878,9 @@ struct oxr_session
 	bool compositor_visible;
 	bool compositor_focused;
 
+	//! Per axis scale of the recommended image size, from the compositor's load.
+	float recommended_resolution_scale;
+
 	// the number of xrWaitFrame calls that did not yet have a corresponding
 	// xrEndFrame or xrBeginFrame (discarded frame) call
 	int active_wait_frames;
@@ -1694,6 +1915,13 @@ struct oxr_session
 	 */
 	size_t action_set_attachment_count;
 
+	/*!
+	 * Bumped by xrSyncActions when the synced action sets or their
+	 * requested sub-action paths change, input suppression depends on them
+	 * so any input combined under an older generation has to be redone.
+	 */
+	uint64_t action_sync_generation;
+
 	/*!
 	 * A map of action set key to action set attachments.
 	 *
@@ -1740,6 +1968,32 @@ struct oxr_session
 	 */
 	float ipd_meters;
 
+	//! Locates done during the current frame.
+	struct oxr_locate_cache locate_cache;
+
+	/*!
+	 * Transient allocations made while building a frame in xrEndFrame,
+	 * reset at the start of every xrEndFrame call.
+	 */
+	struct u_arena frame_arena;
+
+	/*!
+	 * Layers gathered in xrEndFrame, given to the compositor with a single
+	 * @ref xrt_comp_layer_batch call, allocated from @ref frame_arena.
+	 */
+	struct
+	{
+		struct xrt_layer_batch_entry *entries;
+		uint32_t count;
+		uint32_t capacity;
+	} layer_batch;
+
+	/*!
+	 * Display time of the previously ended frame, the motion vectors of
+	 * XR_FB_space_warp span from it to the current frame.
+	 */
+	int64_t last_display_time_ns;
+
 	/*!
 	 * Frame timing debug output.
 	 */
@@ -1861,6 +2115,18 @@ struct oxr_dpad_emulation
 	enum xrt_input_name activate; // Can be zero
 };
 
+/*!
+ * Entry in one of the sorted binding lookup tables of a
+ * @ref oxr_interaction_profile, maps a path or an action key to a binding.
+ */
+struct oxr_binding_lookup
+{
+	//! Either a XrPath or an action key, the table is sorted on this.
+	uint64_t value;
+	uint32_t binding_index;
+	uint32_t path_index;
+};
+
 /*!
  * A single interaction profile.
  */
@@ -1881,6 +2147,14 @@ struct oxr_interaction_profile
 	size_t dpad_count;
 
 	struct oxr_dpad_state dpad_state;
+
+	//! All paths of all bindings, built once when the profile is created.
+	struct oxr_binding_lookup *path_lookup;
+	size_t path_lookup_count;
+
+	//! All action keys of all bindings, rebuilt when the keys change.
+	struct oxr_binding_lookup *key_lookup;
+	size_t key_lookup_count;
 };
 
 /*!
@@ -1994,6 +2268,9 @@ struct oxr_action_set_attachment
 	//! Which sub-action paths are requested on the latest sync.
 	struct oxr_subaction_paths requested_subaction_paths;
 
+	//! Sub-action paths requested on the sync before, to detect changes.
+	struct oxr_subaction_paths last_requested_subaction_paths;
+
 	//! An array of action attachments we own.
 	struct oxr_action_attachment *act_attachments;
 
@@ -2039,6 +2316,21 @@ struct oxr_action_state
 	XrTime timestamp;
 };
 
+/*!
+ * What a @ref xrt_input looked like when it was last combined into an action
+ * cache, lets xrSyncActions skip caches whose inputs haven't changed.
+ *
+ * Not all drivers update the timestamp, so the value is kept too.
+ *
+ * @ingroup oxr_input
+ */
+struct oxr_input_snapshot
+{
+	bool active;
+	int64_t timestamp;
+	union xrt_input_value value;
+};
+
 /*!
  * A input action pair of a @ref xrt_input and a @ref xrt_device, along with the
  * required transform.
@@ -2057,6 +2349,10 @@ struct oxr_action_input
 	struct oxr_input_transform *transforms;
 	size_t transform_count;
 	XrPath bound_path;
+
+	//! State of @ref input and @ref dpad_activate at the last combine.
+	struct oxr_input_snapshot snapshot;
+	struct oxr_input_snapshot dpad_activate_snapshot;
 };
 
 /*!
@@ -2094,6 +2390,20 @@ struct oxr_action_cache
 	size_t input_count;
 	struct oxr_action_input *inputs;
 
+	/*!
+	 * Result of the last combine of @ref inputs, reused when none of them
+	 * have changed and the session's action sync generation is the same.
+	 */
+	struct
+	{
+		bool valid;
+		uint64_t generation;
+		bool is_active;
+		int64_t timestamp;
+		enum xrt_input_type type;
+		union xrt_input_value value;
+	} combined;
+
 	int64_t stop_output_time;
 	size_t output_count;
 	struct oxr_action_output *outputs;
@@ -2263,6 +2573,21 @@ struct oxr_swapchain
 	// Is this a static swapchain, needed for acquire semantics.
 	bool is_static;
 
+#ifdef OXR_HAVE_FB_foveation
+	struct
+	{
+		//! Created with a fragment density map per image.
+		bool fdm;
+
+		//! The profile last set with xrUpdateSwapchainFB, may be destroyed since.
+		XrFoveationProfileFB profile;
+
+		//! Copied from the profile, it may be destroyed while in use.
+		XrFoveationLevelFB level;
+		float vertical_offset_deg;
+		bool dynamic;
+	} foveation;
+#endif
 
 	XrResult (*destroy)(struct oxr_logger *, struct oxr_swapchain *);
 
@@ -2485,6 +2810,11 @@ struct oxr_debug_messenger
 	void *XR_MAY_ALIAS user_data;
 };
 
+/*!
+ * Number of hand joint sets kept per hand tracker, see @ref oxr_hand_tracker.
+ */
+#define OXR_HAND_JOINT_CACHE_SIZE (4)
+
 /*!
  * A hand tracker.
  *
@@ -2510,6 +2840,25 @@ struct oxr_hand_tracker
 
 	XrHandEXT hand;
 	XrHandJointSetEXT hand_joint_set;
+
+	/*!
+	 * The last few joint sets gotten from the device, apps often locate the
+	 * same hand at the same time in several base spaces. Entries are only
+	 * valid for the @ref oxr_locate_cache generation they were made in.
+	 */
+	struct
+	{
+		struct os_mutex mutex;
+		uint32_t count;
+		uint32_t next;
+
+		struct
+		{
+			uint64_t generation;
+			XrTime at_time;
+			struct xrt_hand_joint_set value;
+		} entries[OXR_HAND_JOINT_CACHE_SIZE];
+	} joint_cache;
 };
 
 #ifdef OXR_HAVE_FB_passthrough
@@ -2576,6 +2925,72 @@ oxr_event_push_XrEventDataPassthroughStateChangedFB(struct oxr_logger *log,
 
 #endif // OXR_HAVE_FB_passthrough
 
+#ifdef OXR_HAVE_FB_foveation
+/*!
+ * A foveation profile, applied to swapchains with xrUpdateSwapchainFB.
+ *
+ * Parent type/handle is @ref oxr_session
+ *
+ * @obj{XrFoveationProfileFB}
+ * @extends oxr_handle_base
+ */
+struct oxr_foveation_profile
+{
+	//! Common structure for things referred to by OpenXR handles.
+	struct oxr_handle_base handle;
+
+	//! Owner of this profile.
+	struct oxr_session *sess;
+
+	//! How much to reduce the periphery.
+	XrFoveationLevelFB level;
+
+	//! Vertical offset of the foveation center, in degrees.
+	float vertical_offset_deg;
+
+	//! May the runtime change the level.
+	bool dynamic;
+};
+
+/*!
+ * @public @memberof oxr_foveation_profile
+ */
+XrResult
+oxr_foveation_profile_create(struct oxr_logger *log,
+                             struct oxr_session *sess,
+                             const XrFoveationProfileCreateInfoFB *createInfo,
+                             struct oxr_foveation_profile **out_profile);
+
+/*!
+ * To go back to a OpenXR object.
+ *
+ * @relates oxr_foveation_profile
+ */
+static inline XrFoveationProfileFB
+oxr_foveation_profile_to_openxr(struct oxr_foveation_profile *profile)
+{
+	return XRT_CAST_PTR_TO_OXR_HANDLE(XrFoveationProfileFB, profile);
+}
+
+/*!
+ * Copy the settings of @p profile to @p sc, used by xrUpdateSwapchainFB.
+ *
+ * @public @memberof oxr_swapchain
+ */
+void
+oxr_swapchain_set_foveation_profile(struct oxr_swapchain *sc, struct oxr_foveation_profile *profile);
+
+/*!
+ * Update the fragment density map of image @p index from the profile and the
+ * current eye gaze, called when the image is acquired. Does nothing for
+ * swapchains created without a fragment density map.
+ *
+ * @public @memberof oxr_swapchain
+ */
+XrResult
+oxr_swapchain_update_foveation(struct oxr_logger *log, struct oxr_swapchain *sc, uint32_t index);
+#endif // OXR_HAVE_FB_foveation
+
 /*!
  * HTC specific Facial tracker.
  *
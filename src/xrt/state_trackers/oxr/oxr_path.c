@@ -7,28 +7,89 @@
  * @ingroup oxr_main
  */
 
+#include <assert.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include "math/m_api.h"
+#include "os/os_threading.h"
 #include "util/u_misc.h"
 
 #include "oxr_objects.h"
 #include "oxr_logger.h"
+#include "oxr_subaction.h"
 
+#include "bindings/b_generated_bindings.h"
+
+
+/*!
+ * Size of each chunk that path strings are bump allocated from, strings that
+ * are longer get a chunk of their own.
+ */
+#define CHUNK_SIZE (16 * 1024)
+
+/*!
+ * Number of paths the path array grows by.
+ */
+#define PATH_ARRAY_GROW_COUNT (256)
+
+/*!
+ * Initial length of the intern table, must be a power of two.
+ */
+#define TABLE_INITIAL_LENGTH (1024)
 
 /*!
- * Internal representation of a path, item follows this struct in memory and
- * that in turn is followed by the string.
+ * Internal representation of a path, lives by value in the path array and the
+ * string lives in one of the chunks.
  *
  * @ingroup oxr_main
  */
 struct oxr_path
 {
 	uint64_t debug;
-	XrPath id;
 	void *attached;
+	size_t hash;
+	size_t length;
+	const char *str;
+};
+
+/*!
+ * A chunk of memory that path strings are bump allocated from, chunks are
+ * never moved or freed before the store is, so strings are stable.
+ *
+ * @ingroup oxr_main
+ */
+struct oxr_path_chunk
+{
+	struct oxr_path_chunk *next;
+	size_t used;
+	size_t size;
+	char data[];
+};
+
+
+/*!
+ * The paths of the interaction profile templates and the subaction paths, they
+ * are the same for every instance so they are created once and then shared by
+ * all instances in the process. Never changed after it has been built, so it
+ * is read without any locking, it is freed with the last instance.
+ *
+ * @ingroup oxr_main
+ */
+static struct
+{
+	pthread_mutex_t mutex;
+
+	//! Number of instances using the store, protected by the mutex.
+	uint32_t users;
+
+	struct oxr_path_store store;
+
+	//! Paths of the templates, in the same order as @ref profile_templates.
+	XrPath profile_paths[NUM_PROFILE_TEMPLATES];
+} g_static = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
 };
 
 
@@ -38,22 +99,126 @@ struct oxr_path
  *
  */
 
-static inline XrPath
-to_xr_path(struct oxr_path *path)
+static const char *
+store_string(struct oxr_path_store *ps, const char *str, size_t length)
+{
+	struct oxr_path_chunk *chunk = ps->chunks;
+	size_t needed = length + 1; // Null terminate it.
+
+	if (chunk == NULL || chunk->size - chunk->used < needed) {
+		size_t size = needed > CHUNK_SIZE ? needed : CHUNK_SIZE;
+
+		chunk = (struct oxr_path_chunk *)calloc(1, sizeof(struct oxr_path_chunk) + size);
+		if (chunk == NULL) {
+			return NULL;
+		}
+
+		chunk->size = size;
+		chunk->next = ps->chunks;
+		ps->chunks = chunk;
+	}
+
+	char *store = &chunk->data[chunk->used];
+	memcpy(store, str, length);
+	store[length] = '\0';
+	chunk->used += needed;
+
+	return store;
+}
+
+static void
+table_insert(XrPath *table, size_t table_length, size_t hash, XrPath id)
+{
+	size_t mask = table_length - 1;
+	size_t index = hash & mask;
+
+	while (table[index] != XR_NULL_PATH) {
+		index = (index + 1) & mask;
+	}
+
+	table[index] = id;
+}
+
+static bool
+table_ensure_space(struct oxr_path_store *ps)
 {
-	return path->id;
+	// Keep the load factor at or below one half, so probe chains stay short.
+	if ((ps->count + 1) * 2 <= ps->table_length) {
+		return true;
+	}
+
+	size_t new_length = ps->table_length * 2;
+	XrPath *new_table = U_TYPED_ARRAY_CALLOC(XrPath, new_length);
+	if (new_table == NULL) {
+		return false;
+	}
+
+	// Zero is XR_NULL_PATH which is never in the table.
+	for (size_t i = 0; i < ps->count; i++) {
+		XrPath id = ps->first_id + i;
+		if (id != XR_NULL_PATH) {
+			table_insert(new_table, new_length, ps->paths[i].hash, id);
+		}
+	}
+
+	free(ps->table);
+	ps->table = new_table;
+	ps->table_length = new_length;
+
+	return true;
 }
 
-static inline struct u_hashset_item *
-get_item(struct oxr_path *path)
+static XrPath
+table_find(const struct oxr_path_store *ps, const char *str, size_t length, size_t hash)
 {
-	return (struct u_hashset_item *)&path[1];
+	size_t mask = ps->table_length - 1;
+	size_t index = hash & mask;
+
+	while (true) {
+		XrPath id = ps->table[index];
+		if (id == XR_NULL_PATH) {
+			return XR_NULL_PATH;
+		}
+
+		const struct oxr_path *path = &ps->paths[id - ps->first_id];
+		if (path->hash == hash && path->length == length && memcmp(path->str, str, length) == 0) {
+			return id;
+		}
+
+		index = (index + 1) & mask;
+	}
 }
 
-static inline struct oxr_path *
-from_item(struct u_hashset_item *item)
+static const struct oxr_path *
+store_get_path_or_null(const struct oxr_path_store *ps, XrPath xr_path)
 {
-	return &((struct oxr_path *)item)[-1];
+	if (xr_path == XR_NULL_PATH || xr_path < ps->first_id || xr_path - ps->first_id >= ps->count) {
+		return NULL;
+	}
+
+	return &ps->paths[xr_path - ps->first_id];
+}
+
+static const struct oxr_path *
+get_path_or_null(const struct oxr_instance *inst, XrPath xr_path)
+{
+	if (xr_path < inst->path_store.first_id) {
+		return store_get_path_or_null(&g_static.store, xr_path);
+	}
+
+	return store_get_path_or_null(&inst->path_store, xr_path);
+}
+
+static XrPath
+find(const struct oxr_instance *inst, const char *str, size_t length, size_t hash)
+{
+	// The static paths are the most common ones.
+	XrPath id = table_find(&g_static.store, str, length, hash);
+	if (id != XR_NULL_PATH) {
+		return id;
+	}
+
+	return table_find(&inst->path_store, str, length, hash);
 }
 
 
@@ -64,84 +229,192 @@ from_item(struct u_hashset_item *item)
  */
 
 static XrResult
-oxr_ensure_array_length(struct oxr_logger *log, struct oxr_instance *inst, XrPath *out_id)
+oxr_ensure_array_length(struct oxr_logger *log, struct oxr_path_store *ps)
 {
-	size_t num = inst->path_num + 1;
-
-	if (num < inst->path_array_length) {
-		*out_id = inst->path_num++;
+	if (ps->count < ps->capacity) {
 		return XR_SUCCESS;
 	}
 
-	size_t new_size = inst->path_array_length;
-	while (new_size < num) {
-		new_size += 64;
+	size_t new_capacity = ps->capacity + PATH_ARRAY_GROW_COUNT;
+	struct oxr_path *new_paths = U_TYPED_ARRAY_CALLOC(struct oxr_path, new_capacity);
+	if (new_paths == NULL) {
+		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to allocate path array");
 	}
 
-	U_ARRAY_REALLOC_OR_FREE(inst->path_array, struct oxr_path *, new_size);
-	inst->path_array_length = new_size;
+	if (ps->paths != NULL) {
+		memcpy(new_paths, ps->paths, sizeof(struct oxr_path) * ps->count);
+		free(ps->paths);
+	}
 
-	*out_id = inst->path_num++;
+	ps->paths = new_paths;
+	ps->capacity = new_capacity;
 
 	return XR_SUCCESS;
 }
 
 static XrResult
 oxr_allocate_path(
-    struct oxr_logger *log, struct oxr_instance *inst, const char *str, size_t length, struct oxr_path **out_path)
+    struct oxr_logger *log, struct oxr_path_store *ps, const char *str, size_t length, size_t hash, XrPath *out_id)
 {
-	struct u_hashset_item *item = NULL;
-	struct oxr_path *path = NULL;
-	size_t size = 0;
-	int ret;
-
-	size += sizeof(struct oxr_path);       // Main path object.
-	size += sizeof(struct u_hashset_item); // Embedded hashset item.
-	size += length;                        // String.
-	size += 1;                             // Null terminate it.
-
-	// Now allocate and setup the path.
-	path = U_CALLOC_WITH_CAST(struct oxr_path, size);
-	if (path == NULL) {
+	XrResult ret;
+
+	ret = oxr_ensure_array_length(log, ps);
+	if (ret != XR_SUCCESS) {
+		return ret;
+	}
+
+	if (!table_ensure_space(ps)) {
+		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to grow path table");
+	}
+
+	const char *store = store_string(ps, str, length);
+	if (store == NULL) {
 		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to allocate path");
 	}
+
+	XrPath id = ps->first_id + ps->count++;
+
+	struct oxr_path *path = &ps->paths[id - ps->first_id];
 	path->debug = OXR_XR_DEBUG_PATH;
+	path->hash = hash;
+	path->length = length;
+	path->str = store;
+
+	table_insert(ps->table, ps->table_length, hash, id);
+
+	*out_id = id;
 
-	// Setup the item.
-	item = get_item(path);
-	item->hash = math_hash_string(str, length);
-	item->length = length;
+	return XR_SUCCESS;
+}
+
+static XrResult
+store_init(struct oxr_logger *log, struct oxr_path_store *ps, XrPath first_id)
+{
+	U_ZERO(ps);
 
-	// Yes a const cast! D:
-	char *store = (char *)item->c_str;
-	for (size_t i = 0; i < length; i++) {
-		store[i] = str[i];
+	ps->table = U_TYPED_ARRAY_CALLOC(XrPath, TABLE_INITIAL_LENGTH);
+	if (ps->table == NULL) {
+		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to create path table");
 	}
-	store[length] = '\0';
+	ps->table_length = TABLE_INITIAL_LENGTH;
+	ps->first_id = first_id;
+
+	return oxr_ensure_array_length(log, ps);
+}
 
-	// Insert and return.
-	ret = u_hashset_insert_item(inst->path_store, item);
-	if (ret) {
-		free(path);
-		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to insert item");
+static void
+store_destroy(struct oxr_path_store *ps)
+{
+	struct oxr_path_chunk *chunk = ps->chunks;
+	while (chunk != NULL) {
+		struct oxr_path_chunk *next = chunk->next;
+		free(chunk);
+		chunk = next;
 	}
 
-	oxr_ensure_array_length(log, inst, &path->id);
-	inst->path_array[path->id] = path;
+	free(ps->paths);
+	free(ps->table);
+
+	U_ZERO(ps);
+}
 
-	*out_path = path;
+static XrResult
+static_add(struct oxr_logger *log, const char *str, XrPath *out_path)
+{
+	size_t length = strlen(str);
+	size_t hash = math_hash_string(str, length);
 
-	return XR_SUCCESS;
+	XrPath id = table_find(&g_static.store, str, length, hash);
+	if (id != XR_NULL_PATH) {
+		*out_path = id;
+		return XR_SUCCESS;
+	}
+
+	return oxr_allocate_path(log, &g_static.store, str, length, hash, out_path);
 }
 
-struct oxr_path *
-get_path_or_null(struct oxr_logger *log, const struct oxr_instance *inst, XrPath xr_path)
+static XrResult
+static_add_paths(struct oxr_logger *log, const char *subaction_path, const char *const *paths)
 {
-	if (xr_path >= inst->path_array_length) {
-		return NULL;
+	XrPath dummy;
+	XrResult ret = static_add(log, subaction_path, &dummy);
+
+	for (size_t i = 0; ret == XR_SUCCESS && i < PATHS_PER_BINDING_TEMPLATE && paths[i] != NULL; i++) {
+		ret = static_add(log, paths[i], &dummy);
+	}
+
+	return ret;
+}
+
+static XrResult
+static_build(struct oxr_logger *log)
+{
+	XrResult ret = store_init(log, &g_static.store, 0);
+	if (ret != XR_SUCCESS) {
+		return ret;
+	}
+	g_static.store.count = 1; // Reserve space for XR_NULL_PATH
+
+	XrPath dummy;
+#define ADD_SUBACTION_PATH(NAME, NAME_CAPS, PATH)                                                                      \
+	if (ret == XR_SUCCESS) {                                                                                       \
+		ret = static_add(log, PATH, &dummy);                                                                   \
+	}
+	OXR_FOR_EACH_SUBACTION_PATH_DETAILED(ADD_SUBACTION_PATH)
+#undef ADD_SUBACTION_PATH
+
+	for (size_t x = 0; ret == XR_SUCCESS && x < NUM_PROFILE_TEMPLATES; x++) {
+		const struct profile_template *templ = &profile_templates[x];
+
+		ret = static_add(log, templ->path, &g_static.profile_paths[x]);
+
+		for (size_t i = 0; ret == XR_SUCCESS && i < templ->binding_count; i++) {
+			ret = static_add_paths(log, templ->bindings[i].subaction_path, templ->bindings[i].paths);
+		}
+
+		for (size_t i = 0; ret == XR_SUCCESS && i < templ->dpad_count; i++) {
+			ret = static_add_paths(log, templ->dpads[i].subaction_path, templ->dpads[i].paths);
+		}
+	}
+
+	if (ret != XR_SUCCESS) {
+		store_destroy(&g_static.store);
+	}
+
+	return ret;
+}
+
+static XrResult
+static_ref(struct oxr_logger *log)
+{
+	XrResult ret = XR_SUCCESS;
+
+	pthread_mutex_lock(&g_static.mutex);
+
+	if (g_static.users == 0) {
+		ret = static_build(log);
+	}
+	if (ret == XR_SUCCESS) {
+		g_static.users++;
+	}
+
+	pthread_mutex_unlock(&g_static.mutex);
+
+	return ret;
+}
+
+static void
+static_unref(void)
+{
+	pthread_mutex_lock(&g_static.mutex);
+
+	assert(g_static.users > 0);
+	if (--g_static.users == 0) {
+		store_destroy(&g_static.store);
+		U_ZERO_ARRAY(g_static.profile_paths);
 	}
 
-	return inst->path_array[xr_path];
+	pthread_mutex_unlock(&g_static.mutex);
 }
 
 
@@ -154,13 +427,13 @@ get_path_or_null(struct oxr_logger *log, const struct oxr_instance *inst, XrPath
 bool
 oxr_path_is_valid(struct oxr_logger *log, struct oxr_instance *inst, XrPath xr_path)
 {
-	return get_path_or_null(log, inst, xr_path) != NULL;
+	return get_path_or_null(inst, xr_path) != NULL;
 }
 
 void *
 oxr_path_get_attached(struct oxr_logger *log, struct oxr_instance *inst, XrPath xr_path)
 {
-	struct oxr_path *path = get_path_or_null(log, inst, xr_path);
+	const struct oxr_path *path = get_path_or_null(inst, xr_path);
 	if (path == NULL) {
 		return NULL;
 	}
@@ -172,43 +445,27 @@ XrResult
 oxr_path_get_or_create(
     struct oxr_logger *log, struct oxr_instance *inst, const char *str, size_t length, XrPath *out_path)
 {
-	struct u_hashset_item *item;
-	struct oxr_path *path = NULL;
-	XrResult ret;
-	int h_ret;
+	size_t hash = math_hash_string(str, length);
 
-	// Look it up the instance path store.
-	h_ret = u_hashset_find_str(inst->path_store, str, length, &item);
-	if (h_ret == 0) {
-		*out_path = to_xr_path(from_item(item));
+	// Look it up in the static and then the instance path store.
+	XrPath id = find(inst, str, length, hash);
+	if (id != XR_NULL_PATH) {
+		*out_path = id;
 		return XR_SUCCESS;
 	}
 
-	// Create the path since it was not found.
-	ret = oxr_allocate_path(log, inst, str, length, &path);
-	if (ret != XR_SUCCESS) {
-		return ret;
-	}
-
-	*out_path = to_xr_path(path);
-
-	return XR_SUCCESS;
+	// Create the path in the instance store since it was not found.
+	return oxr_allocate_path(log, &inst->path_store, str, length, hash, out_path);
 }
 
 XrResult
 oxr_path_only_get(struct oxr_logger *log, struct oxr_instance *inst, const char *str, size_t length, XrPath *out_path)
 {
-	struct u_hashset_item *item;
-	int h_ret;
+	size_t hash = math_hash_string(str, length);
 
-	// Look it up the instance path store.
-	h_ret = u_hashset_find_str(inst->path_store, str, length, &item);
-	if (h_ret == 0) {
-		*out_path = to_xr_path(from_item(item));
-		return XR_SUCCESS;
-	}
+	// Look it up the path stores, XR_NULL_PATH if not found.
+	*out_path = find(inst, str, length, hash);
 
-	*out_path = XR_NULL_PATH;
 	return XR_SUCCESS;
 }
 
@@ -216,37 +473,43 @@ XrResult
 oxr_path_get_string(
     struct oxr_logger *log, const struct oxr_instance *inst, XrPath xr_path, const char **out_str, size_t *out_length)
 {
-	struct oxr_path *path = get_path_or_null(log, inst, xr_path);
+	const struct oxr_path *path = get_path_or_null(inst, xr_path);
 	if (path == NULL) {
 		return XR_ERROR_PATH_INVALID;
 	}
 
-	*out_str = get_item(path)->c_str;
-	*out_length = get_item(path)->length;
+	*out_str = path->str;
+	*out_length = path->length;
 
 	return XR_SUCCESS;
 }
 
-void
-destroy_callback(struct u_hashset_item *item, void *priv)
+XrPath
+oxr_path_get_profile_template(struct oxr_instance *inst, size_t index)
 {
-	struct oxr_path *path = from_item(item);
+	assert(index < NUM_PROFILE_TEMPLATES);
+	assert(inst->path_store.first_id != XR_NULL_PATH);
 
-	free(path);
+	return g_static.profile_paths[index];
 }
 
 XrResult
 oxr_path_init(struct oxr_logger *log, struct oxr_instance *inst)
 {
-	int h_ret = u_hashset_create(&inst->path_store);
-	if (h_ret != 0) {
-		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to create hashset");
+	U_ZERO(&inst->path_store);
+
+	XrResult ret = static_ref(log);
+	if (ret != XR_SUCCESS) {
+		return ret;
 	}
 
-	size_t new_size = 64;
-	U_ARRAY_REALLOC_OR_FREE(inst->path_array, struct oxr_path *, new_size);
-	inst->path_array_length = new_size;
-	inst->path_num = 1; // Reserve space for XR_NULL_PATH
+	// Paths created by the app come after the static ones.
+	ret = store_init(log, &inst->path_store, (XrPath)g_static.store.count);
+	if (ret != XR_SUCCESS) {
+		store_destroy(&inst->path_store);
+		static_unref();
+		return ret;
+	}
 
 	return XR_SUCCESS;
 }
@@ -254,18 +517,11 @@ oxr_path_init(struct oxr_logger *log, struct oxr_instance *inst)
 void
 oxr_path_destroy(struct oxr_logger *log, struct oxr_instance *inst)
 {
-	if (inst->path_array != NULL) {
-		free(inst->path_array);
-	}
-
-	inst->path_array = NULL;
-	inst->path_num = 0;
-	inst->path_array_length = 0;
-
-	if (inst->path_store == NULL) {
+	// Not initialized, or already destroyed.
+	if (inst->path_store.first_id == XR_NULL_PATH) {
 		return;
 	}
 
-	u_hashset_clear_and_call_for_each(inst->path_store, destroy_callback, inst);
-	u_hashset_destroy(&inst->path_store);
+	store_destroy(&inst->path_store);
+	static_unref();
 }
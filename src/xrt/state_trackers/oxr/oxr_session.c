@@ -54,6 +54,7 @@
 DEBUG_GET_ONCE_NUM_OPTION(ipd, "OXR_DEBUG_IPD_MM", 63)
 DEBUG_GET_ONCE_NUM_OPTION(wait_frame_sleep, "OXR_DEBUG_WAIT_FRAME_EXTRA_SLEEP_MS", 0)
 DEBUG_GET_ONCE_BOOL_OPTION(frame_timing_spew, "OXR_FRAME_TIMING_SPEW", false)
+DEBUG_GET_ONCE_BOOL_OPTION(locate_cache, "OXR_LOCATE_CACHE", true)
 
 
 /*
@@ -400,6 +401,10 @@ oxr_session_poll(struct oxr_logger *log, struct oxr_session *sess)
 			    log, sess, xrt_to_passthrough_state_flags(xse.passthru.state));
 #endif // OXR_HAVE_FB_passthrough
 			break;
+		case XRT_SESSION_EVENT_RECOMMENDED_RESOLUTION_CHANGE:
+			// Picked up by xrGetRecommendedLayerResolutionMETA, there is no OpenXR event for it.
+			sess->recommended_resolution_scale = xse.resolution.to_scale;
+			break;
 		default: U_LOG_W("unhandled event type! %d", xse.type); break;
 		}
 	}
@@ -442,6 +447,58 @@ xrt_to_view_state_flags(enum xrt_space_relation_flags flags)
 	return res;
 }
 
+/*!
+ * Same as @ref xrt_device_get_view_poses but reuses the last result if called
+ * with the same arguments during the same frame, see @ref oxr_locate_cache.
+ */
+static void
+get_view_poses_cached(struct oxr_session *sess,
+                      struct xrt_device *xdev,
+                      const struct xrt_vec3 *default_eye_relation,
+                      uint64_t at_timestamp_ns,
+                      uint32_t view_count,
+                      struct xrt_space_relation *out_head_relation,
+                      struct xrt_fov *out_fovs,
+                      struct xrt_pose *out_poses)
+{
+	struct oxr_locate_cache *cache = &sess->locate_cache;
+
+	if (!cache->enabled) {
+		xrt_device_get_view_poses(xdev, default_eye_relation, at_timestamp_ns, view_count, out_head_relation,
+		                          out_fovs, out_poses);
+		return;
+	}
+
+	os_mutex_lock(&cache->mutex);
+
+	bool hit = cache->views.valid && cache->views.xdev == xdev && cache->views.at_timestamp_ns == at_timestamp_ns &&
+	           cache->views.view_count == view_count &&
+	           memcmp(&cache->views.eye_relation, default_eye_relation, sizeof(*default_eye_relation)) == 0;
+
+	if (!hit) {
+		xrt_device_get_view_poses(       //
+		    xdev,                        //
+		    default_eye_relation,        //
+		    at_timestamp_ns,             //
+		    view_count,                  //
+		    &cache->views.head_relation, //
+		    cache->views.fovs,           //
+		    cache->views.poses);         //
+
+		cache->views.valid = true;
+		cache->views.xdev = xdev;
+		cache->views.eye_relation = *default_eye_relation;
+		cache->views.at_timestamp_ns = at_timestamp_ns;
+		cache->views.view_count = view_count;
+	}
+
+	*out_head_relation = cache->views.head_relation;
+	memcpy(out_fovs, cache->views.fovs, sizeof(*out_fovs) * view_count);
+	memcpy(out_poses, cache->views.poses, sizeof(*out_poses) * view_count);
+
+	os_mutex_unlock(&cache->mutex);
+}
+
 XrResult
 oxr_session_locate_views(struct oxr_logger *log,
                          struct oxr_session *sess,
@@ -494,14 +551,15 @@ oxr_session_locate_views(struct oxr_logger *log,
 	struct xrt_fov fovs[XRT_MAX_VIEWS] = {0};
 	struct xrt_pose poses[XRT_MAX_VIEWS] = {0};
 
-	xrt_device_get_view_poses( //
+	get_view_poses_cached(     //
+	    sess,                  //
 	    xdev,                  //
 	    &default_eye_relation, //
 	    xdisplay_time,         //
 	    view_count,            //
 	    &T_xdev_head,          //
 	    fovs,                  //
-	    poses);
+	    poses);                //
 
 	// The xdev pose in the base space.
 	struct xrt_space_relation T_base_xdev = XRT_SPACE_RELATION_ZERO;
@@ -693,6 +751,9 @@ oxr_session_frame_wait(struct oxr_logger *log, struct oxr_session *sess, XrFrame
 		oxr_log(log, "Finished waiting for previous frame begin at %8.3fms", ts_ms(sess));
 	}
 
+	// New frame, locates from the last frame shouldn't be reused.
+	oxr_locate_cache_clear(&sess->locate_cache);
+
 	int64_t frame_id = -1;
 	uint64_t predicted_display_time = 0;
 	uint64_t predicted_display_period = 0;
@@ -825,6 +886,8 @@ oxr_session_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 	os_precise_sleeper_deinit(&sess->sleeper);
 	os_semaphore_destroy(&sess->sem);
 	os_mutex_destroy(&sess->active_wait_frames_lock);
+	oxr_locate_cache_fini(&sess->locate_cache);
+	u_arena_fini(&sess->frame_arena);
 
 	free(sess);
 
@@ -855,11 +918,20 @@ oxr_session_allocate_and_init(struct oxr_logger *log,
 	sess->active_wait_frames = 0;
 	os_mutex_init(&sess->active_wait_frames_lock);
 
+	// Full resolution until the compositor says otherwise.
+	sess->recommended_resolution_scale = 1.0f;
+
 	// Debug and user options.
 	sess->ipd_meters = debug_get_num_option_ipd() / 1000.0f;
 	sess->frame_timing_spew = debug_get_bool_option_frame_timing_spew();
 	sess->frame_timing_wait_sleep_ms = debug_get_num_option_wait_frame_sleep();
 
+	// Per frame cache of space and device locates.
+	oxr_locate_cache_init(&sess->locate_cache, debug_get_bool_option_locate_cache());
+
+	// Per frame allocations in xrEndFrame, sized to hold a few layers.
+	u_arena_init(&sess->frame_arena, 16 * sizeof(struct xrt_layer_batch_entry));
+
 	// Action system hashmaps.
 	u_hashmap_int_create(&sess->act_sets_attachments_by_key);
 	u_hashmap_int_create(&sess->act_attachments_by_key);
@@ -1159,6 +1231,57 @@ xrt_to_xr_pose(struct xrt_pose *xrt_pose, XrPosef *xr_pose)
 	xr_pose->position.z = xrt_pose->position.z;
 }
 
+/*!
+ * Gets the joints from the device, or from the hand tracker's cache if they
+ * have already been gotten for this time during the current frame. The joints
+ * are relative to the device so can be shared by locates in any base space.
+ */
+static void
+get_hand_joints_cached(struct oxr_logger *log,
+                       struct oxr_hand_tracker *hand_tracker,
+                       XrTime at_time,
+                       struct xrt_hand_joint_set *out_value)
+{
+	struct oxr_session *sess = hand_tracker->sess;
+	struct oxr_instance *inst = sess->sys->inst;
+	struct xrt_device *xdev = hand_tracker->xdev;
+	enum xrt_input_name name = hand_tracker->input_name;
+
+	if (!sess->locate_cache.enabled) {
+		oxr_xdev_get_hand_tracking_at(log, inst, xdev, name, at_time, out_value);
+		return;
+	}
+
+	os_mutex_lock(&sess->locate_cache.mutex);
+	uint64_t generation = sess->locate_cache.generation;
+	os_mutex_unlock(&sess->locate_cache.mutex);
+
+	os_mutex_lock(&hand_tracker->joint_cache.mutex);
+	for (uint32_t i = 0; i < hand_tracker->joint_cache.count; i++) {
+		if (hand_tracker->joint_cache.entries[i].generation == generation &&
+		    hand_tracker->joint_cache.entries[i].at_time == at_time) {
+			*out_value = hand_tracker->joint_cache.entries[i].value;
+			os_mutex_unlock(&hand_tracker->joint_cache.mutex);
+			return;
+		}
+	}
+	os_mutex_unlock(&hand_tracker->joint_cache.mutex);
+
+	// Not holding the lock while calling into the device, might be an IPC call.
+	oxr_xdev_get_hand_tracking_at(log, inst, xdev, name, at_time, out_value);
+
+	os_mutex_lock(&hand_tracker->joint_cache.mutex);
+	uint32_t index = hand_tracker->joint_cache.next;
+	hand_tracker->joint_cache.entries[index].generation = generation;
+	hand_tracker->joint_cache.entries[index].at_time = at_time;
+	hand_tracker->joint_cache.entries[index].value = *out_value;
+	hand_tracker->joint_cache.next = (index + 1) % OXR_HAND_JOINT_CACHE_SIZE;
+	if (hand_tracker->joint_cache.count < OXR_HAND_JOINT_CACHE_SIZE) {
+		hand_tracker->joint_cache.count++;
+	}
+	os_mutex_unlock(&hand_tracker->joint_cache.mutex);
+}
+
 XrResult
 oxr_session_hand_joints(struct oxr_logger *log,
                         struct oxr_hand_tracker *hand_tracker,
@@ -1167,8 +1290,6 @@ oxr_session_hand_joints(struct oxr_logger *log,
 {
 	struct oxr_space *baseSpc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_space *, locateInfo->baseSpace);
 
-	struct oxr_session *sess = hand_tracker->sess;
-
 	XrHandJointVelocitiesEXT *vel =
 	    OXR_GET_OUTPUT_FROM_CHAIN(locations, XR_TYPE_HAND_JOINT_VELOCITIES_EXT, XrHandJointVelocitiesEXT);
 
@@ -1178,12 +1299,11 @@ oxr_session_hand_joints(struct oxr_logger *log,
 	}
 
 	struct xrt_device *xdev = hand_tracker->xdev;
-	enum xrt_input_name name = hand_tracker->input_name;
 
 	XrTime at_time = locateInfo->time;
 	struct xrt_hand_joint_set value;
 
-	oxr_xdev_get_hand_tracking_at(log, sess->sys->inst, xdev, name, at_time, &value);
+	get_hand_joints_cached(log, hand_tracker, at_time, &value);
 
 	// The hand pose is returned in the xdev's space.
 	struct xrt_space_relation T_xdev_hand = value.hand_pose;
@@ -572,6 +572,111 @@ verify_depth_layer(struct xrt_compositor *xc,
 	return XR_SUCCESS;
 }
 
+#ifdef OXR_HAVE_FB_space_warp
+static XrResult
+verify_space_warp_sub_image(struct oxr_logger *log,
+                            uint32_t layer_index,
+                            uint32_t i,
+                            const char *name,
+                            const XrSwapchainSubImage *sub)
+{
+	if (sub->swapchain == XR_NULL_HANDLE) {
+		return oxr_error(log, XR_ERROR_HANDLE_INVALID,
+		                 "(frameEndInfo->layers[%u]->views[%i]->next<XrCompositionLayerSpaceWarpInfoFB>.%s."
+		                 "swapchain) is XR_NULL_HANDLE",
+		                 layer_index, i, name);
+	}
+
+	struct oxr_swapchain *sc = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, sub->swapchain);
+
+	if (!sc->released.yes) {
+		return oxr_error(log, XR_ERROR_LAYER_INVALID,
+		                 "(frameEndInfo->layers[%u]->views[%i]->next<XrCompositionLayerSpaceWarpInfoFB>.%s."
+		                 "swapchain) swapchain has not been released",
+		                 layer_index, i, name);
+	}
+
+	if (sc->released.index >= (int)sc->swapchain->image_count) {
+		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE,
+		                 "(frameEndInfo->layers[%u]->views[%i]->next<XrCompositionLayerSpaceWarpInfoFB>.%s."
+		                 "swapchain) internal image index out of bounds",
+		                 layer_index, i, name);
+	}
+
+	if (sc->array_layer_count <= sub->imageArrayIndex) {
+		return oxr_error(log, XR_ERROR_VALIDATION_FAILURE,
+		                 "(frameEndInfo->layers[%u]->views[%i]->next<XrCompositionLayerSpaceWarpInfoFB>.%s."
+		                 "imageArrayIndex == %u) Invalid swapchain array index (%u).",
+		                 layer_index, i, name, sub->imageArrayIndex, sc->array_layer_count);
+	}
+
+	if (is_rect_neg(&sub->imageRect)) {
+		return oxr_error(log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
+		                 "(frameEndInfo->layers[%u]->views[%i]->next<XrCompositionLayerSpaceWarpInfoFB>.%s."
+		                 "imageRect.offset == {%i, %i}) has negative component(s)",
+		                 layer_index, i, name, sub->imageRect.offset.x, sub->imageRect.offset.y);
+	}
+
+	if (is_rect_out_of_bounds(&sub->imageRect, sc)) {
+		return oxr_error(log, XR_ERROR_SWAPCHAIN_RECT_INVALID,
+		                 "(frameEndInfo->layers[%u]->views[%i]->next<XrCompositionLayerSpaceWarpInfoFB>.%s."
+		                 "imageRect == {{%i, %i}, {%u, %u}}) imageRect out of image bounds (%u, %u)",
+		                 layer_index, i, name, sub->imageRect.offset.x, sub->imageRect.offset.y,
+		                 sub->imageRect.extent.width, sub->imageRect.extent.height, sc->width, sc->height);
+	}
+
+	return XR_SUCCESS;
+}
+
+static XrResult
+verify_space_warp_info(struct oxr_logger *log,
+                       uint32_t layer_index,
+                       uint32_t i,
+                       const XrCompositionLayerSpaceWarpInfoFB *info)
+{
+	if ((info->layerFlags & ~XR_COMPOSITION_LAYER_SPACE_WARP_INFO_FRAME_SKIP_BIT_FB) != 0) {
+		return oxr_error(log, XR_ERROR_VALIDATION_FAILURE,
+		                 "(frameEndInfo->layers[%u]->views[%i]->next<XrCompositionLayerSpaceWarpInfoFB>."
+		                 "layerFlags == 0x%" PRIx64 ") unknown flags",
+		                 layer_index, i, info->layerFlags);
+	}
+
+	XrResult ret = verify_space_warp_sub_image(log, layer_index, i, "motionVectorSubImage",
+	                                           &info->motionVectorSubImage);
+	if (ret != XR_SUCCESS) {
+		return ret;
+	}
+
+	ret = verify_space_warp_sub_image(log, layer_index, i, "depthSubImage", &info->depthSubImage);
+	if (ret != XR_SUCCESS) {
+		return ret;
+	}
+
+	if (!math_quat_validate_within_1_percent((struct xrt_quat *)&info->appSpaceDeltaPose.orientation)) {
+		return oxr_error(log, XR_ERROR_POSE_INVALID,
+		                 "(frameEndInfo->layers[%u]->views[%i]->next<XrCompositionLayerSpaceWarpInfoFB>."
+		                 "appSpaceDeltaPose.orientation) is not a valid quat",
+		                 layer_index, i);
+	}
+
+	if (info->minDepth < 0.0f || info->maxDepth > 1.0f || info->minDepth > info->maxDepth) {
+		return oxr_error(log, XR_ERROR_LAYER_INVALID,
+		                 "(frameEndInfo->layers[%u]->views[%i]->next<XrCompositionLayerSpaceWarpInfoFB>."
+		                 "minDepth/maxDepth == %f/%f) must be in [0.0,1.0] and ordered",
+		                 layer_index, i, info->minDepth, info->maxDepth);
+	}
+
+	if (info->nearZ == info->farZ) {
+		return oxr_error(log, XR_ERROR_LAYER_INVALID,
+		                 "(frameEndInfo->layers[%u]->views[%i]->next<XrCompositionLayerSpaceWarpInfoFB>.nearZ) "
+		                 "%f must be != farZ %f ",
+		                 layer_index, i, info->nearZ, info->farZ);
+	}
+
+	return XR_SUCCESS;
+}
+#endif // OXR_HAVE_FB_space_warp
+
 static XrResult
 verify_projection_layer(struct oxr_session *sess,
                         struct xrt_compositor *xc,
@@ -634,6 +739,9 @@ verify_projection_layer(struct oxr_session *sess,
 	// number of depth layers must be 0 or proj->viewCount
 	uint32_t depth_layer_count = 0;
 
+	// Same for the space warp infos.
+	uint32_t space_warp_count = 0;
+
 	// Check for valid swapchain states.
 	for (uint32_t i = 0; i < proj->viewCount; i++) {
 		const XrCompositionLayerProjectionView *view = &proj->views[i];
@@ -724,6 +832,22 @@ verify_projection_layer(struct oxr_session *sess,
 			depth_layer_count++;
 		}
 #endif // OXR_HAVE_KHR_composition_layer_depth
+
+#ifdef OXR_HAVE_FB_space_warp
+		const XrCompositionLayerSpaceWarpInfoFB *space_warp_info = NULL;
+		if (sess->sys->inst->extensions.FB_space_warp) {
+			space_warp_info = OXR_GET_INPUT_FROM_CHAIN(view, XR_TYPE_COMPOSITION_LAYER_SPACE_WARP_INFO_FB,
+			                                           XrCompositionLayerSpaceWarpInfoFB);
+		}
+
+		if (space_warp_info) {
+			ret = verify_space_warp_info(log, layer_index, i, space_warp_info);
+			if (ret != XR_SUCCESS) {
+				return ret;
+			}
+			space_warp_count++;
+		}
+#endif // OXR_HAVE_FB_space_warp
 	}
 
 #ifdef OXR_HAVE_KHR_composition_layer_depth
@@ -735,6 +859,13 @@ verify_projection_layer(struct oxr_session *sess,
 	}
 #endif // OXR_HAVE_KHR_composition_layer_depth
 
+	if (space_warp_count > 0 && space_warp_count != proj->viewCount) {
+		return oxr_error(
+		    log, XR_ERROR_VALIDATION_FAILURE,
+		    "(frameEndInfo->layers[%u] projection layer must have %u space warp infos or none, but has: %u)",
+		    layer_index, proj->viewCount, space_warp_count);
+	}
+
 	return XR_SUCCESS;
 }
 
@@ -1229,9 +1360,36 @@ handle_space(struct oxr_logger *log,
 	return true;
 }
 
+/*!
+ * Add a layer to the batch given to the compositor at the end of xrEndFrame,
+ * returns the entry so that the caller can add any extra swapchains.
+ */
+static struct xrt_layer_batch_entry *
+push_layer(struct oxr_session *sess,
+           struct xrt_device *xdev,
+           struct xrt_swapchain **xsc,
+           uint32_t xsc_count,
+           struct xrt_swapchain **d_xsc,
+           const struct xrt_layer_data *data)
+{
+	// Space for all of the layers is reserved before submitting them.
+	assert(sess->layer_batch.count < sess->layer_batch.capacity);
+
+	struct xrt_layer_batch_entry *e = &sess->layer_batch.entries[sess->layer_batch.count++];
+	U_ZERO(e);
+
+	e->xdev = xdev;
+	for (uint32_t i = 0; i < xsc_count; i++) {
+		e->xsc[i] = xsc[i];
+		e->d_xsc[i] = d_xsc != NULL ? d_xsc[i] : NULL;
+	}
+	e->data = *data;
+
+	return e;
+}
+
 static XrResult
 submit_quad_layer(struct oxr_session *sess,
-                  struct xrt_compositor *xc,
                   struct oxr_logger *log,
                   XrCompositionLayerQuad *quad,
                   struct xrt_device *head,
@@ -1274,15 +1432,13 @@ submit_quad_layer(struct oxr_session *sess,
 	fill_in_layer_settings(sess, (XrCompositionLayerBaseHeader *)quad, &data);
 	fill_in_depth_test(sess, (XrCompositionLayerBaseHeader *)quad, &data);
 
-	xrt_result_t xret = xrt_comp_layer_quad(xc, head, sc->swapchain, &data);
-	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_quad);
+	push_layer(sess, head, &sc->swapchain, 1, NULL, &data);
 
 	return XR_SUCCESS;
 }
 
 static XrResult
 submit_projection_layer(struct oxr_session *sess,
-                        struct xrt_compositor *xc,
                         struct oxr_logger *log,
                         XrCompositionLayerProjection *proj,
                         struct xrt_device *head,
@@ -1302,6 +1458,7 @@ submit_projection_layer(struct oxr_session *sess,
 
 	for (uint32_t i = 0; i < proj->viewCount; i++) {
 		scs[i] = XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, proj->views[i].subImage.swapchain);
+		d_scs[i] = NULL;
 		pose_ptr = (struct xrt_pose *)&proj->views[i].pose;
 
 		if (!handle_space(log, sess, spc, pose_ptr, inv_offset, oxr_timestamp, &pose[i])) {
@@ -1337,7 +1494,6 @@ submit_projection_layer(struct oxr_session *sess,
 	// number of depth layers must be 0 or proj->viewCount
 	const XrCompositionLayerDepthInfoKHR *d_is[XRT_MAX_VIEWS];
 	for (uint32_t i = 0; i < proj->viewCount; ++i) {
-		d_scs[i] = NULL;
 		d_is[i] = OXR_GET_INPUT_FROM_CHAIN(&proj->views[i], XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR,
 		                                   XrCompositionLayerDepthInfoKHR);
 		if (d_is[i]) {
@@ -1353,6 +1509,55 @@ submit_projection_layer(struct oxr_session *sess,
 		}
 	}
 #endif // OXR_HAVE_KHR_composition_layer_depth
+
+#ifdef OXR_HAVE_FB_space_warp
+	// Either all of the views have motion vectors for this frame or none.
+	const XrCompositionLayerSpaceWarpInfoFB *w_is[XRT_MAX_VIEWS] = {0};
+	struct xrt_swapchain *mv_swapchains[XRT_MAX_VIEWS];
+	bool space_warp = sess->sys->inst->extensions.FB_space_warp;
+	for (uint32_t i = 0; space_warp && i < proj->viewCount; i++) {
+		w_is[i] = OXR_GET_INPUT_FROM_CHAIN(&proj->views[i], XR_TYPE_COMPOSITION_LAYER_SPACE_WARP_INFO_FB,
+		                                   XrCompositionLayerSpaceWarpInfoFB);
+		space_warp = w_is[i] != NULL &&
+		             (w_is[i]->layerFlags & XR_COMPOSITION_LAYER_SPACE_WARP_INFO_FRAME_SKIP_BIT_FB) == 0;
+	}
+
+	// The motion vectors span from the previous frame to this one.
+	int64_t frame_interval_ns = 0;
+	if (sess->last_display_time_ns != 0 && (int64_t)xrt_timestamp > sess->last_display_time_ns) {
+		frame_interval_ns = (int64_t)xrt_timestamp - sess->last_display_time_ns;
+	}
+
+	for (uint32_t i = 0; space_warp && i < proj->viewCount; i++) {
+		struct xrt_layer_space_warp_data *w = &data.depth.w[i];
+		struct oxr_swapchain *mv_sc =
+		    XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, w_is[i]->motionVectorSubImage.swapchain);
+
+		fill_in_sub_image(mv_sc, &w_is[i]->motionVectorSubImage, &w->motion_sub);
+		w->app_space_delta_pose = *(const struct xrt_pose *)&w_is[i]->appSpaceDeltaPose;
+		w->frame_interval_ns = frame_interval_ns;
+		mv_swapchains[i] = mv_sc->swapchain;
+
+		// The app can give depth both ways, prefer XrCompositionLayerDepthInfoKHR.
+		if (d_scs[i] == NULL) {
+			struct oxr_swapchain *sc =
+			    XRT_CAST_OXR_HANDLE_TO_PTR(struct oxr_swapchain *, w_is[i]->depthSubImage.swapchain);
+
+			data.depth.d[i].far_z = w_is[i]->farZ;
+			data.depth.d[i].near_z = w_is[i]->nearZ;
+			data.depth.d[i].max_depth = w_is[i]->maxDepth;
+			data.depth.d[i].min_depth = w_is[i]->minDepth;
+			fill_in_sub_image(sc, &w_is[i]->depthSubImage, &data.depth.d[i].sub);
+			d_scs[i] = sc;
+			d_swapchains[i] = sc->swapchain;
+		}
+	}
+
+	if (space_warp) {
+		data.flags |= XRT_LAYER_COMPOSITION_SPACE_WARP_BIT;
+	}
+#endif // OXR_HAVE_FB_space_warp
+
 	bool d_scs_valid = true;
 	for (uint32_t i = 0; i < proj->viewCount; i++) {
 		if (d_scs[i] == NULL) {
@@ -1361,26 +1566,23 @@ submit_projection_layer(struct oxr_session *sess,
 		}
 	}
 	if (d_scs_valid) {
-#ifdef OXR_HAVE_KHR_composition_layer_depth
+#if defined(OXR_HAVE_KHR_composition_layer_depth) || defined(OXR_HAVE_FB_space_warp)
 		fill_in_depth_test(sess, (XrCompositionLayerBaseHeader *)proj, &data);
 		data.type = XRT_LAYER_PROJECTION_DEPTH;
-		xrt_result_t xret = xrt_comp_layer_projection_depth( //
-		    xc,                                              // compositor
-		    head,                                            // xdev
-		    swapchains,                                      // swapchains
-		    d_swapchains,                                    // depth swapchains
-		    &data);                                          // data
-		OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_projection_depth);
+		struct xrt_layer_batch_entry *e =
+		    push_layer(sess, head, swapchains, proj->viewCount, d_swapchains, &data);
+		(void)e;
+
+#ifdef OXR_HAVE_FB_space_warp
+		for (uint32_t i = 0; space_warp && i < proj->viewCount; i++) {
+			e->mv_xsc[i] = mv_swapchains[i];
+		}
+#endif // OXR_HAVE_FB_space_warp
 #else
 		assert(false && "Should not get here");
-#endif // OXR_HAVE_KHR_composition_layer_depth
+#endif // OXR_HAVE_KHR_composition_layer_depth || OXR_HAVE_FB_space_warp
 	} else {
-		xrt_result_t xret = xrt_comp_layer_projection( //
-		    xc,                                        // compositor
-		    head,                                      // xdev
-		    swapchains,                                // swapchains
-		    &data);                                    // data
-		OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_projection);
+		push_layer(sess, head, swapchains, proj->viewCount, NULL, &data);
 	}
 
 	return XR_SUCCESS;
@@ -1388,7 +1590,6 @@ submit_projection_layer(struct oxr_session *sess,
 
 static XrResult
 submit_cube_layer(struct oxr_session *sess,
-                  struct xrt_compositor *xc,
                   struct oxr_logger *log,
                   const XrCompositionLayerCubeKHR *cube,
                   struct xrt_device *head,
@@ -1435,15 +1636,13 @@ submit_cube_layer(struct oxr_session *sess,
 		return XR_SUCCESS;
 	}
 
-	xrt_result_t xret = xrt_comp_layer_cube(xc, head, sc->swapchain, &data);
-	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_cube);
+	push_layer(sess, head, &sc->swapchain, 1, NULL, &data);
 
 	return XR_SUCCESS;
 }
 
 static XrResult
 submit_cylinder_layer(struct oxr_session *sess,
-                      struct xrt_compositor *xc,
                       struct oxr_logger *log,
                       const XrCompositionLayerCylinderKHR *cylinder,
                       struct xrt_device *head,
@@ -1487,15 +1686,13 @@ submit_cylinder_layer(struct oxr_session *sess,
 	fill_in_layer_settings(sess, (XrCompositionLayerBaseHeader *)cylinder, &data);
 	fill_in_depth_test(sess, (XrCompositionLayerBaseHeader *)cylinder, &data);
 
-	xrt_result_t xret = xrt_comp_layer_cylinder(xc, head, sc->swapchain, &data);
-	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_cylinder);
+	push_layer(sess, head, &sc->swapchain, 1, NULL, &data);
 
 	return XR_SUCCESS;
 }
 
 static XrResult
 submit_equirect1_layer(struct oxr_session *sess,
-                       struct xrt_compositor *xc,
                        struct oxr_logger *log,
                        const XrCompositionLayerEquirectKHR *equirect,
                        struct xrt_device *head,
@@ -1541,8 +1738,7 @@ submit_equirect1_layer(struct oxr_session *sess,
 	data.equirect1.scale = *scale;
 	data.equirect1.bias = *bias;
 
-	xrt_result_t xret = xrt_comp_layer_equirect1(xc, head, sc->swapchain, &data);
-	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_equirect1);
+	push_layer(sess, head, &sc->swapchain, 1, NULL, &data);
 
 	return XR_SUCCESS;
 }
@@ -1558,7 +1754,6 @@ do_synchronize_state_change(struct oxr_logger *log, struct oxr_session *sess)
 
 static XrResult
 submit_equirect2_layer(struct oxr_session *sess,
-                       struct xrt_compositor *xc,
                        struct oxr_logger *log,
                        const XrCompositionLayerEquirect2KHR *equirect,
                        struct xrt_device *head,
@@ -1601,15 +1796,13 @@ submit_equirect2_layer(struct oxr_session *sess,
 	fill_in_layer_settings(sess, (XrCompositionLayerBaseHeader *)equirect, &data);
 	fill_in_depth_test(sess, (XrCompositionLayerBaseHeader *)equirect, &data);
 
-	xrt_result_t xret = xrt_comp_layer_equirect2(xc, head, sc->swapchain, &data);
-	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_equirect2);
+	push_layer(sess, head, &sc->swapchain, 1, NULL, &data);
 
 	return XR_SUCCESS;
 }
 
 static XrResult
 submit_passthrough_layer(struct oxr_session *sess,
-                         struct xrt_compositor *xc,
                          struct oxr_logger *log,
                          const XrCompositionLayerPassthroughFB *passthrough,
                          struct xrt_device *head,
@@ -1628,8 +1821,7 @@ submit_passthrough_layer(struct oxr_session *sess,
 	fill_in_passthrough(sess, (XrCompositionLayerBaseHeader *)passthrough, &data);
 	fill_in_blend_factors(sess, (XrCompositionLayerBaseHeader *)passthrough, &data);
 
-	xrt_result_t xret = xrt_comp_layer_passthrough(xc, head, &data);
-	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_passthrough);
+	push_layer(sess, head, NULL, 0, NULL, &data);
 
 	return XR_SUCCESS;
 }
@@ -1795,6 +1987,21 @@ oxr_session_frame_end(struct oxr_logger *log, struct oxr_session *sess, const Xr
 	    .env_blend_mode = blend_mode,
 	};
 
+	/*
+	 * Everything allocated for the previous frame is done with, after the
+	 * first few frames the arena no longer allocates any memory itself.
+	 */
+	u_arena_reset(&sess->frame_arena);
+
+	// The layers are given to the compositor in one go, only what this frame needs.
+	sess->layer_batch.entries =
+	    U_ARENA_ALLOC_ARRAY(&sess->frame_arena, struct xrt_layer_batch_entry, frameEndInfo->layerCount);
+	if (sess->layer_batch.entries == NULL) {
+		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to allocate layers for frame");
+	}
+	sess->layer_batch.capacity = frameEndInfo->layerCount;
+	sess->layer_batch.count = 0;
+
 	xrt_result_t xret;
 	xret = xrt_comp_layer_begin(xc, &data);
 	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_begin);
@@ -1805,40 +2012,44 @@ oxr_session_frame_end(struct oxr_logger *log, struct oxr_session *sess, const Xr
 
 		switch (layer->type) {
 		case XR_TYPE_COMPOSITION_LAYER_PROJECTION:
-			submit_projection_layer(sess, xc, log, (XrCompositionLayerProjection *)layer, xdev, &inv_offset,
+			submit_projection_layer(sess, log, (XrCompositionLayerProjection *)layer, xdev, &inv_offset,
 			                        frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_QUAD:
-			submit_quad_layer(sess, xc, log, (XrCompositionLayerQuad *)layer, xdev, &inv_offset,
+			submit_quad_layer(sess, log, (XrCompositionLayerQuad *)layer, xdev, &inv_offset,
 			                  frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_CUBE_KHR:
-			submit_cube_layer(sess, xc, log, (XrCompositionLayerCubeKHR *)layer, xdev, &inv_offset,
+			submit_cube_layer(sess, log, (XrCompositionLayerCubeKHR *)layer, xdev, &inv_offset,
 			                  frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_CYLINDER_KHR:
-			submit_cylinder_layer(sess, xc, log, (XrCompositionLayerCylinderKHR *)layer, xdev, &inv_offset,
+			submit_cylinder_layer(sess, log, (XrCompositionLayerCylinderKHR *)layer, xdev, &inv_offset,
 			                      frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_EQUIRECT_KHR:
-			submit_equirect1_layer(sess, xc, log, (XrCompositionLayerEquirectKHR *)layer, xdev, &inv_offset,
+			submit_equirect1_layer(sess, log, (XrCompositionLayerEquirectKHR *)layer, xdev, &inv_offset,
 			                       frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_EQUIRECT2_KHR:
-			submit_equirect2_layer(sess, xc, log, (XrCompositionLayerEquirect2KHR *)layer, xdev,
+			submit_equirect2_layer(sess, log, (XrCompositionLayerEquirect2KHR *)layer, xdev,
 			                       &inv_offset, frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		case XR_TYPE_COMPOSITION_LAYER_PASSTHROUGH_FB:
-			submit_passthrough_layer(sess, xc, log, (XrCompositionLayerPassthroughFB *)layer, xdev,
+			submit_passthrough_layer(sess, log, (XrCompositionLayerPassthroughFB *)layer, xdev,
 			                         &inv_offset, frameEndInfo->displayTime, xrt_display_time_ns);
 			break;
 		default: assert(false && "invalid layer type");
 		}
 	}
 
+	xret = xrt_comp_layer_batch(xc, sess->layer_batch.entries, sess->layer_batch.count);
+	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_batch);
+
 	xret = xrt_comp_layer_commit(xc, XRT_GRAPHICS_SYNC_HANDLE_INVALID);
 	OXR_CHECK_XRET(log, sess, xret, xrt_comp_layer_commit);
 
+	sess->last_display_time_ns = xrt_display_time_ns;
 	sess->frame_id.begun = -1;
 	sess->frame_started = false;
 
@@ -30,6 +30,134 @@
 #include <string.h>
 
 
+/*
+ *
+ * Locate cache functions.
+ *
+ */
+
+static bool
+locate_cache_match(const struct oxr_locate_cache_entry *e, const struct oxr_locate_cache_entry *key)
+{
+	return e->xbase == key->xbase && e->xtarget == key->xtarget && e->xdev == key->xdev &&
+	       e->at_timestamp_ns == key->at_timestamp_ns &&
+	       memcmp(&e->base_offset, &key->base_offset, sizeof(e->base_offset)) == 0 &&
+	       memcmp(&e->target_offset, &key->target_offset, sizeof(e->target_offset)) == 0;
+}
+
+static bool
+locate_cache_find(struct oxr_locate_cache *cache,
+                  const struct oxr_locate_cache_entry *key,
+                  struct xrt_space_relation *out_relation)
+{
+	if (!cache->enabled) {
+		return false;
+	}
+
+	bool found = false;
+
+	os_mutex_lock(&cache->mutex);
+	for (uint32_t i = 0; i < cache->count; i++) {
+		if (locate_cache_match(&cache->entries[i], key)) {
+			*out_relation = cache->entries[i].relation;
+			found = true;
+			break;
+		}
+	}
+	os_mutex_unlock(&cache->mutex);
+
+	return found;
+}
+
+static void
+locate_cache_store(struct oxr_locate_cache *cache,
+                   const struct oxr_locate_cache_entry *key,
+                   const struct xrt_space_relation *relation)
+{
+	if (!cache->enabled) {
+		return;
+	}
+
+	os_mutex_lock(&cache->mutex);
+
+	// Replace the oldest entry once full.
+	struct oxr_locate_cache_entry *e = &cache->entries[cache->next];
+	*e = *key;
+	e->relation = *relation;
+
+	cache->next = (cache->next + 1) % ARRAY_SIZE(cache->entries);
+	if (cache->count < ARRAY_SIZE(cache->entries)) {
+		cache->count++;
+	}
+
+	os_mutex_unlock(&cache->mutex);
+}
+
+static void
+locate_space_cached(struct oxr_session *sess,
+                    struct xrt_space *xbase,
+                    const struct xrt_pose *base_offset,
+                    uint64_t at_timestamp_ns,
+                    struct xrt_space *xtarget,
+                    const struct xrt_pose *target_offset,
+                    struct xrt_space_relation *out_relation)
+{
+	struct oxr_locate_cache_entry key = {
+	    .xbase = xbase,
+	    .base_offset = *base_offset,
+	    .xtarget = xtarget,
+	    .target_offset = *target_offset,
+	    .at_timestamp_ns = at_timestamp_ns,
+	};
+
+	if (locate_cache_find(&sess->locate_cache, &key, out_relation)) {
+		return;
+	}
+
+	xrt_space_overseer_locate_space( //
+	    sess->sys->xso,              //
+	    xbase,                       //
+	    base_offset,                 //
+	    at_timestamp_ns,             //
+	    xtarget,                     //
+	    target_offset,               //
+	    out_relation);               //
+
+	locate_cache_store(&sess->locate_cache, &key, out_relation);
+}
+
+static void
+locate_device_cached(struct oxr_session *sess,
+                     struct xrt_space *xbase,
+                     const struct xrt_pose *base_offset,
+                     uint64_t at_timestamp_ns,
+                     struct xrt_device *xdev,
+                     struct xrt_space_relation *out_relation)
+{
+	struct oxr_locate_cache_entry key = {
+	    .xbase = xbase,
+	    .base_offset = *base_offset,
+	    .xdev = xdev,
+	    .target_offset = XRT_POSE_IDENTITY,
+	    .at_timestamp_ns = at_timestamp_ns,
+	};
+
+	if (locate_cache_find(&sess->locate_cache, &key, out_relation)) {
+		return;
+	}
+
+	xrt_space_overseer_locate_device( //
+	    sess->sys->xso,               //
+	    xbase,                        //
+	    base_offset,                  //
+	    at_timestamp_ns,              //
+	    xdev,                         //
+	    out_relation);                //
+
+	locate_cache_store(&sess->locate_cache, &key, out_relation);
+}
+
+
 /*
  *
  * To xrt_space functions.
@@ -131,7 +259,10 @@ oxr_space_destroy(struct oxr_logger *log, struct oxr_handle_base *hb)
 	spc->action.xdev = NULL;
 	spc->action.name = 0;
 
-	free(spc);
+	// The xrt_space might go away, make sure no stale entry matches a new one.
+	oxr_locate_cache_clear(&spc->sess->locate_cache);
+
+	oxr_handle_pool_free(&spc->sess->sys->inst->handle_pools.spaces, spc);
 
 	return XR_SUCCESS;
 }
@@ -147,7 +278,8 @@ oxr_space_action_create(struct oxr_logger *log,
 	struct oxr_subaction_paths subaction_paths = {0};
 
 	struct oxr_space *spc = NULL;
-	OXR_ALLOCATE_HANDLE_OR_RETURN(log, spc, OXR_XR_DEBUG_SPACE, oxr_space_destroy, &sess->handle);
+	OXR_ALLOCATE_POOLED_HANDLE_OR_RETURN(log, spc, &sess->sys->inst->handle_pools.spaces, OXR_XR_DEBUG_SPACE,
+	                                     oxr_space_destroy, &sess->handle);
 
 	oxr_classify_subaction_paths(log, inst, 1, &createInfo->subactionPath, &subaction_paths);
 
@@ -196,7 +328,8 @@ oxr_space_reference_create(struct oxr_logger *log,
 	enum xrt_reference_space_type xtype = oxr_ref_space_to_xrt(oxr_type);
 
 	struct oxr_space *spc = NULL;
-	OXR_ALLOCATE_HANDLE_OR_RETURN(log, spc, OXR_XR_DEBUG_SPACE, oxr_space_destroy, &sess->handle);
+	OXR_ALLOCATE_POOLED_HANDLE_OR_RETURN(log, spc, &sess->sys->inst->handle_pools.spaces, OXR_XR_DEBUG_SPACE,
+	                                     oxr_space_destroy, &sess->handle);
 	spc->sess = sess;
 	spc->space_type = oxr_type;
 	memcpy(&spc->pose, &createInfo->poseInReferenceSpace, sizeof(spc->pose));
@@ -259,15 +392,15 @@ oxr_space_locate(
 		// Convert at_time to monotonic and give to device.
 		uint64_t at_timestamp_ns = time_state_ts_to_monotonic_ns(sys->inst->timekeeping, time);
 
-		// Ask the space overseer to locate the spaces.
-		xrt_space_overseer_locate_space( //
-		    sys->xso,                    //
-		    xbase,                       //
-		    &baseSpc->pose,              //
-		    at_timestamp_ns,             //
-		    xtarget,                     //
-		    &spc->pose,                  //
-		    &result);                    //
+		// Ask the space overseer to locate the spaces, unless done this frame.
+		locate_space_cached( //
+		    spc->sess,       //
+		    xbase,           //
+		    &baseSpc->pose,  //
+		    at_timestamp_ns, //
+		    xtarget,         //
+		    &spc->pose,      //
+		    &result);        //
 	}
 
 
@@ -344,6 +477,142 @@ oxr_space_locate(
 	return oxr_session_success_result(spc->sess);
 }
 
+#ifdef OXR_HAVE_KHR_locate_spaces
+static void
+relation_to_location_data(const struct xrt_space_relation *relation,
+                          XrSpaceLocationDataKHR *location,
+                          XrSpaceVelocityDataKHR *velocity)
+{
+	if (relation->relation_flags == 0) {
+		location->locationFlags = 0;
+		OXR_XRT_POSE_TO_XRPOSEF(XRT_POSE_IDENTITY, location->pose);
+	} else {
+		location->locationFlags = xrt_to_xr_space_location_flags(relation->relation_flags);
+		OXR_XRT_POSE_TO_XRPOSEF(relation->pose, location->pose);
+	}
+
+	if (velocity == NULL) {
+		return;
+	}
+
+	velocity->velocityFlags = 0;
+	if ((relation->relation_flags & XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT) != 0) {
+		velocity->linearVelocity.x = relation->linear_velocity.x;
+		velocity->linearVelocity.y = relation->linear_velocity.y;
+		velocity->linearVelocity.z = relation->linear_velocity.z;
+		velocity->velocityFlags |= XR_SPACE_VELOCITY_LINEAR_VALID_BIT;
+	} else {
+		U_ZERO(&velocity->linearVelocity);
+	}
+
+	if ((relation->relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT) != 0) {
+		velocity->angularVelocity.x = relation->angular_velocity.x;
+		velocity->angularVelocity.y = relation->angular_velocity.y;
+		velocity->angularVelocity.z = relation->angular_velocity.z;
+		velocity->velocityFlags |= XR_SPACE_VELOCITY_ANGULAR_VALID_BIT;
+	} else {
+		U_ZERO(&velocity->angularVelocity);
+	}
+}
+
+XrResult
+oxr_spaces_locate(struct oxr_logger *log,
+                  struct oxr_space **spcs,
+                  uint32_t spc_count,
+                  struct oxr_space *baseSpc,
+                  XrTime time,
+                  XrSpaceLocationsKHR *locations)
+{
+	struct oxr_system *sys = baseSpc->sess->sys;
+
+	XrSpaceVelocitiesKHR *velocities =
+	    OXR_GET_OUTPUT_FROM_CHAIN(locations->next, XR_TYPE_SPACE_VELOCITIES_KHR, XrSpaceVelocitiesKHR);
+
+
+	/*
+	 * Seek knowledge about the spaces from the space overseer.
+	 */
+
+	struct xrt_space *xbase = NULL;
+	XrResult ret = get_xrt_space(log, baseSpc, &xbase);
+
+	// Only the spaces that have a xrt_space are sent to the space overseer.
+	struct xrt_space **xtargets = U_TYPED_ARRAY_CALLOC(struct xrt_space *, spc_count);
+	struct xrt_pose *offsets = U_TYPED_ARRAY_CALLOC(struct xrt_pose, spc_count);
+	struct xrt_space_relation *results = U_TYPED_ARRAY_CALLOC(struct xrt_space_relation, spc_count);
+	uint32_t *indices = U_TYPED_ARRAY_CALLOC(uint32_t, spc_count);
+	uint32_t located_count = 0;
+
+	for (uint32_t i = 0; i < spc_count && ret == XR_SUCCESS && xbase != NULL; i++) {
+		struct xrt_space *xtarget = NULL;
+
+		// Any error stops the loop.
+		ret = get_xrt_space(log, spcs[i], &xtarget);
+		if (xtarget == NULL) {
+			continue;
+		}
+
+		xtargets[located_count] = xtarget;
+		offsets[located_count] = spcs[i]->pose;
+		indices[located_count] = i;
+		located_count++;
+	}
+
+	if (located_count > 0) {
+		// Convert at_time to monotonic and give to device.
+		uint64_t at_timestamp_ns = time_state_ts_to_monotonic_ns(sys->inst->timekeeping, time);
+
+		// Ask the space overseer to locate all of the spaces in one go.
+		xrt_result_t xret = xrt_space_overseer_locate_spaces( //
+		    sys->xso,                                         //
+		    xbase,                                            //
+		    &baseSpc->pose,                                   //
+		    at_timestamp_ns,                                  //
+		    xtargets,                                         //
+		    located_count,                                    //
+		    offsets,                                          //
+		    results);                                         //
+		if (xret != XRT_SUCCESS) {
+			located_count = 0;
+			if (ret == XR_SUCCESS) {
+				ret = oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to locate spaces");
+			}
+		}
+	}
+
+
+	/*
+	 * Combine and copy
+	 */
+
+	XrSpaceVelocityDataKHR *velocity_data = velocities != NULL ? velocities->velocities : NULL;
+	struct xrt_space_relation invalid = XRT_SPACE_RELATION_ZERO;
+
+	// Spaces that could not be located get an invalid relation.
+	for (uint32_t i = 0; i < spc_count; i++) {
+		relation_to_location_data(&invalid, &locations->locations[i],
+		                          velocity_data != NULL ? &velocity_data[i] : NULL);
+	}
+
+	for (uint32_t k = 0; k < located_count; k++) {
+		uint32_t i = indices[k];
+		relation_to_location_data(&results[k], &locations->locations[i],
+		                          velocity_data != NULL ? &velocity_data[i] : NULL);
+	}
+
+	free(xtargets);
+	free(offsets);
+	free(results);
+	free(indices);
+
+	if (ret != XR_SUCCESS) {
+		return ret; // Return any error.
+	}
+
+	return oxr_session_success_result(baseSpc->sess);
+}
+#endif // OXR_HAVE_KHR_locate_spaces
+
 
 /*
  *
@@ -371,14 +640,44 @@ oxr_space_locate_device(struct oxr_logger *log,
 	// Convert at_time to monotonic and give to device.
 	uint64_t at_timestamp_ns = time_state_ts_to_monotonic_ns(sys->inst->timekeeping, time);
 
-	// Ask the space overseer to locate the spaces.
-	xrt_space_overseer_locate_device( //
-	    sys->xso,                     //
-	    xbase,                        //
-	    &baseSpc->pose,               //
-	    at_timestamp_ns,              //
-	    xdev,                         //
-	    out_relation);                //
+	// Ask the space overseer to locate the device, unless done this frame.
+	locate_device_cached( //
+	    baseSpc->sess,    //
+	    xbase,            //
+	    &baseSpc->pose,   //
+	    at_timestamp_ns,  //
+	    xdev,             //
+	    out_relation);    //
 
 	return ret;
 }
+
+void
+oxr_locate_cache_init(struct oxr_locate_cache *cache, bool enabled)
+{
+	U_ZERO(cache);
+	os_mutex_init(&cache->mutex);
+	cache->enabled = enabled;
+}
+
+void
+oxr_locate_cache_fini(struct oxr_locate_cache *cache)
+{
+	os_mutex_destroy(&cache->mutex);
+	U_ZERO(cache);
+}
+
+void
+oxr_locate_cache_clear(struct oxr_locate_cache *cache)
+{
+	if (!cache->enabled) {
+		return;
+	}
+
+	os_mutex_lock(&cache->mutex);
+	cache->count = 0;
+	cache->next = 0;
+	cache->generation++;
+	cache->views.valid = false;
+	os_mutex_unlock(&cache->mutex);
+}
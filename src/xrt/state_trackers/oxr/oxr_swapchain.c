@@ -310,6 +310,19 @@ oxr_swapchain_common_create(struct oxr_logger *log,
 	}
 #endif
 
+#ifdef OXR_HAVE_FB_foveation_vulkan
+	// Only the Vulkan client compositor can create fragment density maps.
+	const XrSwapchainCreateInfoFoveationFB *foveation = NULL;
+	if (sess->gfx_ext == OXR_SESSION_GRAPHICS_EXT_VULKAN && sess->sys->inst->extensions.FB_foveation_vulkan) {
+		foveation = OXR_GET_INPUT_FROM_CHAIN(createInfo, XR_TYPE_SWAPCHAIN_CREATE_INFO_FOVEATION_FB,
+		                                     XrSwapchainCreateInfoFoveationFB);
+	}
+
+	if (foveation != NULL && (foveation->flags & XR_SWAPCHAIN_CREATE_FOVEATION_FRAGMENT_DENSITY_MAP_BIT_FB) != 0) {
+		info.create |= XRT_SWAPCHAIN_CREATE_FOVEATION_FRAGMENT_DENSITY_MAP;
+	}
+#endif
+
 	struct xrt_swapchain *xsc = NULL; // Has to be NULL.
 	xret = xrt_comp_create_swapchain(sess->compositor, &info, &xsc);
 	if (xret == XRT_ERROR_SWAPCHAIN_FLAG_VALID_BUT_UNSUPPORTED) {
@@ -321,6 +334,10 @@ oxr_swapchain_common_create(struct oxr_logger *log,
 		return oxr_error(log, XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED,
 		                 "Specified swapchain format is not supported");
 	}
+	if (xret == XRT_ERROR_ALLOCATION) {
+		return oxr_error(log, XR_ERROR_OUT_OF_MEMORY,
+		                 "Not enough GPU memory left for the swapchain, the compositor is over its budget");
+	}
 	if (xret != XRT_SUCCESS) {
 		return oxr_error(log, XR_ERROR_RUNTIME_FAILURE, "Failed to create swapchain");
 	}
@@ -335,6 +352,10 @@ oxr_swapchain_common_create(struct oxr_logger *log,
 	sc->array_layer_count = createInfo->arraySize;
 	sc->face_count = createInfo->faceCount;
 	sc->is_static = (createInfo->createFlags & XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT) != 0;
+#ifdef OXR_HAVE_FB_foveation
+	sc->foveation.fdm = (info.create & XRT_SWAPCHAIN_CREATE_FOVEATION_FRAGMENT_DENSITY_MAP) != 0;
+	sc->foveation.level = XR_FOVEATION_LEVEL_NONE_FB;
+#endif
 
 	// Functions.
 	sc->wait_image = implicit_wait_image;
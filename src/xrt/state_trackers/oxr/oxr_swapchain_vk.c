@@ -10,6 +10,7 @@
 
 #include "util/u_debug.h"
 
+#include "oxr_chain.h"
 #include "oxr_objects.h"
 #include "oxr_logger.h"
 #include "oxr_swapchain_common.h"
@@ -42,6 +43,11 @@ vk_implicit_acquire_image(struct oxr_logger *log,
 		OXR_CHECK_XRET(log, sc->sess, xret, xrt_swapchain_wait_image);
 	}
 
+#ifdef OXR_HAVE_FB_foveation_vulkan
+	// Needs the compositor to be done with the image, and like the barrier below uses the queue.
+	CHECK_OXR_RET(oxr_swapchain_update_foveation(log, sc, index));
+#endif
+
 	/*
 	 * The non-explicit transition versions of XR_vulkan_enable[_2] states
 	 * that we can only use the queue in xrAcquireSwapchainImage so must be
@@ -95,6 +101,20 @@ vk_enumerate_images(struct oxr_logger *log,
 
 	for (uint32_t i = 0; i < count; i++) {
 		vk_imgs[i].image = xscvk->images[i];
+
+#ifdef OXR_HAVE_FB_foveation_vulkan
+		XrSwapchainImageFoveationVulkanFB *fdm = NULL;
+		if (sc->foveation.fdm) {
+			fdm = OXR_GET_OUTPUT_FROM_CHAIN(&vk_imgs[i], XR_TYPE_SWAPCHAIN_IMAGE_FOVEATION_VULKAN_FB,
+			                                XrSwapchainImageFoveationVulkanFB);
+		}
+
+		if (fdm != NULL) {
+			fdm->image = xscvk->fdm_images[i];
+			fdm->width = xscvk->fdm_width;
+			fdm->height = xscvk->fdm_height;
+		}
+#endif
 	}
 
 	return oxr_session_success_result(sc->sess);
@@ -370,6 +370,20 @@ oxr_system_get_properties(struct oxr_logger *log, struct oxr_system *sys, XrSyst
 	}
 #endif
 
+#ifdef OXR_HAVE_FB_space_warp
+	XrSystemSpaceWarpPropertiesFB *space_warp_props = NULL;
+	if (sys->inst->extensions.FB_space_warp) {
+		space_warp_props = OXR_GET_OUTPUT_FROM_CHAIN(properties, XR_TYPE_SYSTEM_SPACE_WARP_PROPERTIES_FB,
+		                                             XrSystemSpaceWarpPropertiesFB);
+	}
+
+	if (space_warp_props) {
+		// Motion is smooth, half of the view in each direction is plenty.
+		space_warp_props->recommendedMotionVectorImageRectWidth = sys->views[0].recommendedImageRectWidth / 2;
+		space_warp_props->recommendedMotionVectorImageRectHeight = sys->views[0].recommendedImageRectHeight / 2;
+	}
+#endif // OXR_HAVE_FB_space_warp
+
 #ifdef OXR_HAVE_HTC_facial_tracking
 	XrSystemFacialTrackingPropertiesHTC *htc_facial_tracking_props = NULL;
 	if (sys->inst->extensions.HTC_facial_tracking) {
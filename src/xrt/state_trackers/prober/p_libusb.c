@@ -37,10 +37,8 @@ p_libusb_teardown(struct prober *p)
 }
 
 int
-p_libusb_probe(struct prober *p)
+p_libusb_enumerate(struct prober *p)
 {
-	int ret;
-
 	// Free old list first.
 	if (p->usb.list != NULL) {
 		libusb_free_device_list(p->usb.list, 1);
@@ -54,6 +52,14 @@ p_libusb_probe(struct prober *p)
 		return -1;
 	}
 
+	return 0;
+}
+
+int
+p_libusb_probe(struct prober *p)
+{
+	int ret;
+
 	for (ssize_t i = 0; i < p->usb.count; i++) {
 		libusb_device *device = p->usb.list[i];
 		struct libusb_device_descriptor desc;
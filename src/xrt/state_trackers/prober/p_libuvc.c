@@ -37,7 +37,7 @@ p_libuvc_teardown(struct prober *p)
 }
 
 int
-p_libuvc_probe(struct prober *p)
+p_libuvc_enumerate(struct prober *p)
 {
 	int ret;
 
@@ -58,6 +58,14 @@ p_libuvc_probe(struct prober *p)
 		p->uvc.count++;
 	}
 
+	return 0;
+}
+
+int
+p_libuvc_probe(struct prober *p)
+{
+	int ret;
+
 	for (ssize_t k = 0; k < p->uvc.count; k++) {
 		uvc_device_t *device = p->uvc.list[k];
 		struct uvc_device_descriptor *desc;
@@ -17,7 +17,9 @@
 #include "util/u_config_json.h"
 #include "util/u_debug.h"
 #include "util/u_pretty_print.h"
+#include "util/u_startup_timeline.h"
 #include "util/u_trace_marker.h"
+#include "util/u_worker.h"
 
 #include "os/os_hid.h"
 #include "p_prober.h"
@@ -57,6 +59,7 @@ DEBUG_GET_ONCE_BOOL_OPTION(qwerty_combine, "QWERTY_COMBINE", false)
 DEBUG_GET_ONCE_OPTION(vf_path, "VF_PATH", NULL)
 DEBUG_GET_ONCE_OPTION(euroc_path, "EUROC_PATH", NULL)
 DEBUG_GET_ONCE_NUM_OPTION(rs_source_index, "RS_SOURCE_INDEX", -1)
+DEBUG_GET_ONCE_BOOL_OPTION(prober_parallel, "PROBER_PARALLEL", true)
 
 
 /*
@@ -462,6 +465,9 @@ initialize(struct prober *p, struct xrt_prober_entry_lists *lists)
 
 	u_config_json_open_or_create_main_file(&p->json);
 
+	// Before any devices are opened, since they start their threads then.
+	u_config_json_apply_thread_roles(&p->json);
+
 	ret = collect_entries(p);
 	if (ret != 0) {
 		teardown(p);
@@ -484,6 +490,11 @@ initialize(struct prober *p, struct xrt_prober_entry_lists *lists)
 	}
 #endif
 
+#ifdef XRT_HAVE_LIBUDEV
+	// Before the first probe, so nothing plugged in after it is missed.
+	p_udev_monitor_init(p);
+#endif
+
 	ret = p_tracking_init(p);
 	if (ret != 0) {
 		teardown(p);
@@ -613,6 +624,10 @@ teardown(struct prober *p)
 
 	teardown_devices(p);
 
+#ifdef XRT_HAVE_LIBUDEV
+	p_udev_monitor_teardown(p);
+#endif
+
 #ifdef XRT_HAVE_LIBUVC
 	p_libuvc_teardown(p);
 #endif
@@ -838,6 +853,81 @@ find_builder_by_identifier(struct prober *p, const char *ident)
 	return NULL;
 }
 
+/*!
+ * One backend's device list enumeration, run on a worker while the other
+ * backends enumerate theirs.
+ */
+struct enumerate_task
+{
+	struct prober *p;
+	int (*func)(struct prober *p);
+	int ret;
+};
+
+static void
+enumerate_task_run(void *ptr)
+{
+	struct enumerate_task *task = (struct enumerate_task *)ptr;
+
+	task->ret = task->func(task->p);
+}
+
+/*!
+ * Get the device lists of libusb and libuvc, while udev is probed on this
+ * thread. Getting the lists only touches each backend's own fields, the
+ * devices are added afterwards, in the same order as always, so the device
+ * list comes out the same as when probing one backend after another.
+ */
+static int
+enumerate_and_probe_udev(struct prober *p)
+{
+	struct enumerate_task tasks[2];
+	uint32_t task_count = 0;
+	int ret = 0;
+
+#ifdef XRT_HAVE_LIBUSB
+	tasks[task_count++] = (struct enumerate_task){.p = p, .func = p_libusb_enumerate};
+#endif
+#ifdef XRT_HAVE_LIBUVC
+	tasks[task_count++] = (struct enumerate_task){.p = p, .func = p_libuvc_enumerate};
+#endif
+
+	struct u_worker_thread_pool *pool = NULL;
+	struct u_worker_group *group = NULL;
+	if (debug_get_bool_option_prober_parallel() && task_count > 0) {
+		pool = u_worker_thread_pool_create(task_count, task_count, "Prober");
+		group = u_worker_group_create(pool);
+		for (uint32_t i = 0; i < task_count; i++) {
+			u_worker_group_push(group, enumerate_task_run, &tasks[i]);
+		}
+	}
+
+#ifdef XRT_HAVE_LIBUDEV
+	ret = p_udev_probe(p);
+	if (ret != 0) {
+		P_ERROR(p, "Failed to enumerate udev devices\n");
+	}
+#endif
+
+	if (group != NULL) {
+		u_worker_group_wait_all(group);
+		u_worker_group_reference(&group, NULL);
+		u_worker_thread_pool_reference(&pool, NULL);
+	} else {
+		for (uint32_t i = 0; i < task_count; i++) {
+			enumerate_task_run(&tasks[i]);
+		}
+	}
+
+	for (uint32_t i = 0; i < task_count; i++) {
+		if (tasks[i].ret != 0) {
+			ret = tasks[i].ret;
+		}
+	}
+
+	return ret;
+}
+
 static void
 print_system_devices(u_pp_delegate_t dg, struct xrt_system_devices *xsysd)
 {
@@ -891,16 +981,26 @@ p_probe(struct xrt_prober *xp)
 		return XRT_ERROR_PROBER_LIST_LOCKED;
 	}
 
+#ifdef XRT_HAVE_LIBUDEV
+	// Always drained, so old events don't make a later probe redo the work.
+	bool changed = p_udev_monitor_has_changes(p);
+	if (p->devices_valid && !changed) {
+		P_DEBUG(p, "No devices added or removed since last probe, keeping the device list");
+		return XRT_SUCCESS;
+	}
+#endif
+
 	// Free old list first.
+	p->devices_valid = false;
 	teardown_devices(p);
 
-#ifdef XRT_HAVE_LIBUDEV
-	ret = p_udev_probe(p);
+	// The libusb and libuvc enumeration is done here too, merging is cheap.
+	int32_t phase = u_startup_timeline_begin("Probe devices");
+	ret = enumerate_and_probe_udev(p);
+	u_startup_timeline_end(phase);
 	if (ret != 0) {
-		P_ERROR(p, "Failed to enumerate udev devices\n");
 		return XRT_ERROR_PROBING_FAILED;
 	}
-#endif
 
 #ifdef XRT_HAVE_LIBUSB
 	ret = p_libusb_probe(p);
@@ -918,6 +1018,8 @@ p_probe(struct xrt_prober *xp)
 	}
 #endif
 
+	p->devices_valid = true;
+
 	return XRT_SUCCESS;
 }
 
@@ -1031,6 +1133,30 @@ p_create_system(struct xrt_prober *xp,
 	 * Estimate.
 	 */
 
+	/*
+	 * Estimating can be slow, some builders read from the devices, so each
+	 * builder is only asked once and the answers are used for both passes.
+	 */
+	struct xrt_builder_estimate *estimates = NULL;
+	if (select == NULL && p->builder_count > 0) {
+		estimates = U_TYPED_ARRAY_CALLOC(struct xrt_builder_estimate, p->builder_count);
+
+		for (size_t i = 0; i < p->builder_count; i++) {
+			struct xrt_builder *xb = p->builders[i];
+
+			if (xb->exclude_from_automatic_discovery) {
+				continue;
+			}
+
+			xrt_builder_estimate_system(xb, p->json.root, xp, &estimates[i]);
+
+			// Nothing after a certain builder gets looked at.
+			if (estimates[i].certain.head) {
+				break;
+			}
+		}
+	}
+
 	//! @todo Improve estimation selection logic.
 	if (select == NULL) {
 		for (size_t i = 0; i < p->builder_count; i++) {
@@ -1040,10 +1166,7 @@ p_create_system(struct xrt_prober *xp,
 				continue;
 			}
 
-			struct xrt_builder_estimate estimate = {0};
-			xrt_builder_estimate_system(xb, p->json.root, xp, &estimate);
-
-			if (estimate.certain.head) {
+			if (estimates[i].certain.head) {
 				select = xb;
 				break;
 			}
@@ -1064,10 +1187,7 @@ p_create_system(struct xrt_prober *xp,
 				continue;
 			}
 
-			struct xrt_builder_estimate estimate = {0};
-			xrt_builder_estimate_system(xb, p->json.root, xp, &estimate);
-
-			if (estimate.maybe.head) {
+			if (estimates[i].maybe.head) {
 				select = xb;
 				break;
 			}
@@ -1082,6 +1202,7 @@ p_create_system(struct xrt_prober *xp,
 
 	if (select != NULL) {
 		u_pp(dg, "\n\tUsing builder %s: %s", select->identifier, select->name);
+		int32_t phase = u_startup_timeline_begin("Open system with builder %s", select->identifier);
 		xret = xrt_builder_open_system( //
 		    select,                     //
 		    p->json.root,               //
@@ -1089,6 +1210,7 @@ p_create_system(struct xrt_prober *xp,
 		    broadcast,                  //
 		    out_xsysd,                  //
 		    out_xso);                   //
+		u_startup_timeline_end(phase);
 
 		if (xret == XRT_SUCCESS) {
 			print_system_devices(dg, *out_xsysd);
@@ -1098,6 +1220,8 @@ p_create_system(struct xrt_prober *xp,
 		xret = XRT_ERROR_DEVICE_CREATION_FAILED;
 	}
 
+	free(estimates);
+
 	u_pp(dg, "\n\tResult: ");
 	u_pp_xrt_result(dg, xret);
 
@@ -1195,7 +1319,10 @@ p_open_hid_interface(struct xrt_prober *xp,
 			continue;
 		}
 
+		int32_t phase = u_startup_timeline_begin("Open hid %04x:%04x interface %i", pdev->base.vendor_id,
+		                                         pdev->base.product_id, interface);
 		ret = os_hid_open_hidraw(hidraw->path, out_hid_dev);
+		u_startup_timeline_end(phase);
 		if (ret != 0) {
 			U_LOG_E("Failed to open device '%s' got '%i'", hidraw->path, ret);
 			return ret;
@@ -1258,8 +1385,11 @@ p_open_video_device(struct xrt_prober *xp,
 		return -1;
 	}
 
+	int32_t phase =
+	    u_startup_timeline_begin("Open video %04x:%04x", pdev->base.vendor_id, pdev->base.product_id);
 	struct xrt_fs *xfs =
 	    v4l2_fs_create(xfctx, pdev->v4ls[0].path, pdev->usb.product, pdev->usb.manufacturer, pdev->usb.serial);
+	u_startup_timeline_end(phase);
 	if (xfs == NULL) {
 		return -1;
 	}
@@ -161,6 +161,19 @@ struct prober
 	} uvc;
 #endif
 
+#ifdef XRT_HAVE_LIBUDEV
+	struct
+	{
+		struct udev *udev;
+
+		//! Tells us about devices being added or removed, NULL if not available.
+		struct udev_monitor *monitor;
+	} udev;
+#endif
+
+	//! The device list is from a probe that succeeded.
+	bool devices_valid;
+
 
 	struct xrt_auto_prober *auto_probers[XRT_MAX_AUTO_PROBERS];
 
@@ -262,6 +275,17 @@ void
 p_libusb_teardown(struct prober *p);
 
 /*!
+ * Get the list of devices from libusb, only touches the libusb fields of
+ * @p p so it can run at the same time as the other backends' enumeration.
+ *
+ * @private @memberof prober
+ */
+int
+p_libusb_enumerate(struct prober *p);
+
+/*!
+ * Add the devices from the list gotten by @ref p_libusb_enumerate.
+ *
  * @private @memberof prober
  */
 int
@@ -306,6 +330,17 @@ void
 p_libuvc_teardown(struct prober *p);
 
 /*!
+ * Get the list of devices from libuvc, only touches the libuvc fields of
+ * @p p so it can run at the same time as the other backends' enumeration.
+ *
+ * @private @memberof prober
+ */
+int
+p_libuvc_enumerate(struct prober *p);
+
+/*!
+ * Add the devices from the list gotten by @ref p_libuvc_enumerate.
+ *
  * @private @memberof prober
  */
 int
@@ -326,6 +361,30 @@ p_libuvc_probe(struct prober *p);
  */
 int
 p_udev_probe(struct prober *p);
+
+/*!
+ * Start listening for devices being added and removed, not being able to is
+ * not an error, the prober then re-probes everything every time.
+ *
+ * @private @memberof prober
+ */
+void
+p_udev_monitor_init(struct prober *p);
+
+/*!
+ * @private @memberof prober
+ */
+void
+p_udev_monitor_teardown(struct prober *p);
+
+/*!
+ * Consume all pending events, returns true if any device has been added or
+ * removed since the last call, or if that can't be known.
+ *
+ * @private @memberof prober
+ */
+bool
+p_udev_monitor_has_changes(struct prober *p);
 /*!
  * @}
  */
@@ -188,6 +188,12 @@ p_factory_ensure_frameserver(struct p_factory *fact)
 	struct t_hsv_filter_params params = T_HSV_DEFAULT_PARAMS();
 	t_hsv_filter_create(&fact->xfctx, &params, xsinks, &xsink);
 
+#if defined(XRT_BUILD_DRIVER_PSMV)
+	// Only classify the parts of the frames around the controllers.
+	t_psmv_set_hsv_filter(fact->xtmv[0], xsink, 0);
+	t_psmv_set_hsv_filter(fact->xtmv[1], xsink, 1);
+#endif
+
 	// The filter only supports yuv or yuyv formats.
 	u_sink_create_to_yuv_or_yuyv(&fact->xfctx, xsink, &xsink);
 
@@ -8,11 +8,14 @@
  */
 
 #include "util/u_misc.h"
+#include "util/u_debug.h"
 #include "p_prober.h"
 
 #include <stdio.h>
+#include <errno.h>
 #include <assert.h>
 #include <string.h>
+#include <unistd.h>
 #include <libudev.h>
 #include <inttypes.h>
 #include <linux/hidraw.h>
@@ -29,6 +32,15 @@
 #define HIDRAW_BUS_I2C_MAYBE_QUESTION_MARK 24
 
 
+/*
+ *
+ * Env variable options.
+ *
+ */
+
+DEBUG_GET_ONCE_BOOL_OPTION(udev_monitor, "PROBER_UDEV_MONITOR", true)
+
+
 /*
  *
  * Pre-declare functions.
@@ -138,6 +150,100 @@ p_udev_probe(struct prober *p)
 	return 0;
 }
 
+void
+p_udev_monitor_init(struct prober *p)
+{
+	if (!debug_get_bool_option_udev_monitor()) {
+		return;
+	}
+
+	/*
+	 * The monitor only gets events from the udev daemon, without one it
+	 * would never say anything changed, so don't trust it then.
+	 */
+	if (access("/run/udev/control", F_OK) != 0) {
+		P_DEBUG(p, "No udev daemon, not monitoring for devices");
+		return;
+	}
+
+	struct udev *udev = udev_new();
+	if (udev == NULL) {
+		P_WARN(p, "Can't create udev, not monitoring for devices");
+		return;
+	}
+
+	// Non-blocking, so pending events can be drained when probing.
+	struct udev_monitor *monitor = udev_monitor_new_from_netlink(udev, "udev");
+	if (monitor == NULL) {
+		P_WARN(p, "Can't create udev monitor, not monitoring for devices");
+		udev_unref(udev);
+		return;
+	}
+
+	// The subsystems that p_udev_probe looks at.
+	udev_monitor_filter_add_match_subsystem_devtype(monitor, "usb", "usb_device");
+	udev_monitor_filter_add_match_subsystem_devtype(monitor, "video4linux", NULL);
+	udev_monitor_filter_add_match_subsystem_devtype(monitor, "hidraw", NULL);
+
+	if (udev_monitor_enable_receiving(monitor) < 0) {
+		P_WARN(p, "Can't enable udev monitor, not monitoring for devices");
+		udev_monitor_unref(monitor);
+		udev_unref(udev);
+		return;
+	}
+
+	p->udev.udev = udev;
+	p->udev.monitor = monitor;
+}
+
+void
+p_udev_monitor_teardown(struct prober *p)
+{
+	if (p->udev.monitor != NULL) {
+		udev_monitor_unref(p->udev.monitor);
+		p->udev.monitor = NULL;
+	}
+
+	if (p->udev.udev != NULL) {
+		udev_unref(p->udev.udev);
+		p->udev.udev = NULL;
+	}
+}
+
+bool
+p_udev_monitor_has_changes(struct prober *p)
+{
+	if (p->udev.monitor == NULL) {
+		return true;
+	}
+
+	bool changed = false;
+
+	while (true) {
+		errno = 0;
+		struct udev_device *dev = udev_monitor_receive_device(p->udev.monitor);
+		if (dev == NULL) {
+			// Events were dropped, no telling what they were.
+			if (errno == ENOBUFS) {
+				changed = true;
+			}
+			break;
+		}
+
+		const char *action = udev_device_get_action(dev);
+		P_DEBUG(p, "udev event '%s' for '%s'", action != NULL ? action : "(null)",
+		        udev_device_get_syspath(dev));
+
+		if (action != NULL && (strcmp(action, "add") == 0 || strcmp(action, "remove") == 0)) {
+			changed = true;
+		}
+
+		udev_device_unref(dev);
+	}
+
+	return changed;
+}
+
 
 /*
  *
@@ -11,8 +11,11 @@
  * @ingroup st_ovrd
  */
 
+#include <atomic>
+#include <chrono>
 #include <cstring>
 #include <thread>
+#include <type_traits>
 
 #include "math/m_api.h"
 #include "ovrd_log.hpp"
@@ -52,6 +55,9 @@ DEBUG_GET_ONCE_BOOL_OPTION(emulate_index_controller, "STEAMVR_EMULATE_INDEX_CONT
 
 DEBUG_GET_ONCE_NUM_OPTION(scale_percentage, "XRT_COMPOSITOR_SCALE_PERCENTAGE", 140)
 
+//! How often the pose pump thread samples all devices, about IMU rate.
+DEBUG_GET_ONCE_NUM_OPTION(pose_pump_period_us, "STEAMVR_POSE_PUMP_PERIOD_US", 1000)
+
 #define MODELNUM_LEN (XRT_DEVICE_NAME_LEN + 9) // "[Monado] "
 
 #define OPENVR_BONE_COUNT 31
@@ -61,6 +67,90 @@ DEBUG_GET_ONCE_NUM_OPTION(scale_percentage, "XRT_COMPOSITOR_SCALE_PERCENTAGE", 1
 #undef DUMP_POSE_CONTROLLERS
 
 
+/*
+ *
+ * Pose slot
+ *
+ */
+
+/*!
+ * Holds the latest value written by a single thread, readers on any thread
+ * never block the writer nor each other. Readers retry when they raced with a
+ * write, which only takes a copy. The value is kept as relaxed atomic words so
+ * a torn read is detected rather than being a data race.
+ */
+template <typename T> class LatestSlot
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Value is copied word by word");
+
+public:
+	//! Writer thread only.
+	void
+	store(const T &value)
+	{
+		uint64_t words[kWordCount] = {};
+		memcpy(words, &value, sizeof(T));
+
+		uint32_t seq = m_seq.load(std::memory_order_relaxed);
+		m_seq.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (size_t i = 0; i < kWordCount; i++) {
+			m_words[i].store(words[i], std::memory_order_relaxed);
+		}
+
+		m_seq.store(seq + 2, std::memory_order_release);
+	}
+
+	//! Returns false if nothing has been stored yet.
+	bool
+	load(T &out_value) const
+	{
+		uint64_t words[kWordCount];
+		uint32_t before = 0;
+		uint32_t after = 0;
+
+		do {
+			before = m_seq.load(std::memory_order_acquire);
+			for (size_t i = 0; i < kWordCount; i++) {
+				words[i] = m_words[i].load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = m_seq.load(std::memory_order_relaxed);
+		} while ((before & 1) != 0 || before != after);
+
+		if (before == 0) {
+			return false;
+		}
+
+		memcpy(&out_value, words, sizeof(T));
+
+		return true;
+	}
+
+private:
+	static constexpr size_t kWordCount = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	//! Odd while a write is in progress, zero until the first write.
+	std::atomic<uint32_t> m_seq{0};
+	std::atomic<uint64_t> m_words[kWordCount] = {};
+};
+
+//! Returned to SteamVR before the pose pump has sampled a device.
+static vr::DriverPose_t
+make_uninitialized_pose()
+{
+	vr::DriverPose_t pose = {};
+	pose.poseIsValid = false;
+	pose.deviceIsConnected = true;
+	pose.result = vr::TrackingResult_Uninitialized;
+	pose.qWorldFromDriverRotation = {1, 0, 0, 0};
+	pose.qDriverFromHeadRotation = {1, 0, 0, 0};
+	pose.qRotation = {1, 0, 0, 0};
+	return pose;
+}
+
+
 /*
  * Controller
  */
@@ -707,22 +797,21 @@ public:
 		}
 	}
 
+	/*!
+	 * Called from the pose pump thread, samples the device into the slot
+	 * and hands it to SteamVR.
+	 */
 	void
-	PoseUpdateThreadFunction()
+	PublishPose()
 	{
-		ovrd_log("Starting controller pose update thread for %s\n", m_xdev->str);
-
-		while (m_poseUpdating) {
-			//! @todo figure out the best pose update rate
-			std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-			if (m_unObjectId != vr::k_unTrackedDeviceIndexInvalid) {
-				vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_unObjectId, GetPose(),
-				                                                   sizeof(vr::DriverPose_t));
-			}
+		if (!m_active.load(std::memory_order_acquire)) {
+			return;
 		}
 
-		ovrd_log("Stopping controller pose update thread for %s\n", m_xdev->str);
+		vr::DriverPose_t pose = SamplePose();
+		m_poseSlot.store(pose);
+
+		vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_unObjectId, pose, sizeof(vr::DriverPose_t));
 	}
 
 	vr::EVRInitError
@@ -802,11 +891,8 @@ public:
 
 		ovrd_log("Controller %d activated\n", m_unObjectId);
 
-		m_poseUpdateThread = new std::thread(&CDeviceDriver_Monado_Controller::PoseUpdateThreadFunction, this);
-		if (!m_poseUpdateThread) {
-			ovrd_log("Unable to create pose updated thread for %s\n", m_xdev->str);
-			return vr::VRInitError_Driver_Failed;
-		}
+		// The pose pump thread starts sampling this device now.
+		m_active.store(true, std::memory_order_release);
 
 		return vr::VRInitError_None;
 	}
@@ -815,9 +901,7 @@ public:
 	Deactivate()
 	{
 		ovrd_log("deactivate controller\n");
-		m_poseUpdating = false;
-		m_poseUpdateThread->join();
-		m_unObjectId = vr::k_unTrackedDeviceIndexInvalid;
+		m_active.store(false, std::memory_order_release);
 	}
 
 	void
@@ -843,8 +927,20 @@ public:
 			pchResponseBuffer[0] = 0;
 	}
 
+	//! Called by SteamVR on any thread, never touches the Monado device.
 	vr::DriverPose_t
 	GetPose()
+	{
+		vr::DriverPose_t pose;
+		if (!m_poseSlot.load(pose)) {
+			pose = make_uninitialized_pose();
+		}
+		return pose;
+	}
+
+	//! Only called from the pose pump thread.
+	vr::DriverPose_t
+	SamplePose()
 	{
 		// monado predicts pose "now", see xrt_device_get_tracked_pose
 		m_pose.poseTimeOffset = 0;
@@ -1043,8 +1139,9 @@ private:
 
 	std::string m_input_profile;
 
-	bool m_poseUpdating = true;
-	std::thread *m_poseUpdateThread = NULL;
+	//! Set while activated, the pose pump thread only samples active devices.
+	std::atomic<bool> m_active{false};
+	LatestSlot<vr::DriverPose_t> m_poseSlot;
 };
 
 /*
@@ -1102,6 +1199,9 @@ public:
 	virtual void DebugRequest(const char *pchRequest, char *pchResponseBuffer, uint32_t unResponseBufferSize);
 	virtual vr::DriverPose_t GetPose();
 
+	// Pose pump thread
+	void PublishPose();
+
 	// IVRDisplayComponent
 	virtual void GetWindowBounds(int32_t *pnX, int32_t *pnY, uint32_t *pnWidth, uint32_t *pnHeight);
 	virtual bool IsDisplayOnDesktop();
@@ -1128,9 +1228,11 @@ private:
 	struct xrt_fov m_fovs[2];
 	struct xrt_pose m_view_pose[2];
 
-	bool m_poseUpdating = true;
-	std::thread *m_poseUpdateThread = NULL;
-	virtual void PoseUpdateThreadFunction();
+	//! Set while activated, the pose pump thread only samples active devices.
+	std::atomic<bool> m_active{false};
+	LatestSlot<vr::DriverPose_t> m_poseSlot;
+
+	vr::DriverPose_t SamplePose();
 
 	// clang-format on
 };
@@ -1155,17 +1257,16 @@ create_translation_rotation_matrix(struct xrt_pose *pose, struct vr::HmdMatrix34
 }
 
 void
-CDeviceDriver_Monado::PoseUpdateThreadFunction()
+CDeviceDriver_Monado::PublishPose()
 {
-	ovrd_log("Starting HMD pose update thread\n");
-
-	while (m_poseUpdating) {
-		//! @todo figure out the best pose update rate
-		std::this_thread::sleep_for(std::chrono::milliseconds(1));
-		vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_trackedDeviceIndex, GetPose(),
-		                                                   sizeof(vr::DriverPose_t));
+	if (!m_active.load(std::memory_order_acquire)) {
+		return;
 	}
-	ovrd_log("Stopping HMD pose update thread\n");
+
+	vr::DriverPose_t pose = SamplePose();
+	m_poseSlot.store(pose);
+
+	vr::VRServerDriverHost()->TrackedDevicePoseUpdated(m_trackedDeviceIndex, pose, sizeof(vr::DriverPose_t));
 }
 
 vr::EVRInitError
@@ -1206,12 +1307,8 @@ CDeviceDriver_Monado::Activate(vr::TrackedDeviceIndex_t unObjectId)
 
 	vr::VRServerDriverHost()->SetDisplayEyeToHead(m_trackedDeviceIndex, left, right);
 
-
-	m_poseUpdateThread = new std::thread(&CDeviceDriver_Monado::PoseUpdateThreadFunction, this);
-	if (!m_poseUpdateThread) {
-		ovrd_log("Unable to create pose updated thread for %s\n", m_xdev->str);
-		return vr::VRInitError_Driver_Failed;
-	}
+	// The pose pump thread starts sampling the HMD now.
+	m_active.store(true, std::memory_order_release);
 
 	return vr::VRInitError_None;
 }
@@ -1219,8 +1316,7 @@ CDeviceDriver_Monado::Activate(vr::TrackedDeviceIndex_t unObjectId)
 void
 CDeviceDriver_Monado::Deactivate()
 {
-	m_poseUpdating = false;
-	m_poseUpdateThread->join();
+	m_active.store(false, std::memory_order_release);
 	ovrd_log("Deactivate\n");
 }
 
@@ -1262,7 +1358,17 @@ HmdQuaternion_Init(double w, double x, double y, double z)
 vr::DriverPose_t
 CDeviceDriver_Monado::GetPose()
 {
+	// Called by SteamVR, only reads what the pose pump thread sampled.
+	vr::DriverPose_t pose;
+	if (!m_poseSlot.load(pose)) {
+		pose = make_uninitialized_pose();
+	}
+	return pose;
+}
 
+vr::DriverPose_t
+CDeviceDriver_Monado::SamplePose()
+{
 	timepoint_ns now_ns = os_monotonic_get_ns();
 	struct xrt_space_relation rel;
 	xrt_device_get_tracked_pose(m_xdev, XRT_INPUT_GENERIC_HEAD_POSE, now_ns, &rel);
@@ -1444,6 +1550,12 @@ public:
 	// clang-format on
 
 private:
+	void
+	PosePumpThreadFunction();
+
+	std::atomic<bool> m_posePumping{false};
+	std::thread *m_posePumpThread = NULL;
+
 	struct xrt_instance *m_xinst = NULL;
 	struct xrt_system *m_xsys = NULL;
 	struct xrt_system_devices *m_xsysd = NULL;
@@ -1524,12 +1636,60 @@ CServerDriver_Monado::Init(vr::IVRDriverContext *pDriverContext)
 		ovrd_log("Added right Controller: %s\n", right_xdev->str);
 	}
 
+	m_posePumping = true;
+	m_posePumpThread = new std::thread(&CServerDriver_Monado::PosePumpThreadFunction, this);
+
 	return vr::VRInitError_None;
 }
 
+void
+CServerDriver_Monado::PosePumpThreadFunction()
+{
+	ovrd_log("Starting pose pump thread\n");
+
+	long period_us = debug_get_num_option_pose_pump_period_us();
+	auto period = std::chrono::microseconds(period_us > 0 ? period_us : 1000);
+	auto next = std::chrono::steady_clock::now();
+
+	/*
+	 * All devices are sampled here at the same tick, SteamVR's threads only
+	 * read the slots so they never wait on locks inside the Monado drivers.
+	 */
+	while (m_posePumping) {
+		next += period;
+		std::this_thread::sleep_until(next);
+
+		if (m_MonadoDeviceDriver) {
+			m_MonadoDeviceDriver->PublishPose();
+		}
+		if (m_left) {
+			m_left->PublishPose();
+		}
+		if (m_right) {
+			m_right->PublishPose();
+		}
+
+		// Don't try to catch up after a stall, just skip the missed ticks.
+		auto now = std::chrono::steady_clock::now();
+		if (now > next + period) {
+			next = now;
+		}
+	}
+
+	ovrd_log("Stopping pose pump thread\n");
+}
+
 void
 CServerDriver_Monado::Cleanup()
 {
+	// Stop sampling before the devices go away.
+	m_posePumping = false;
+	if (m_posePumpThread) {
+		m_posePumpThread->join();
+		delete m_posePumpThread;
+		m_posePumpThread = NULL;
+	}
+
 	if (m_MonadoDeviceDriver != NULL) {
 		delete m_MonadoDeviceDriver;
 		m_MonadoDeviceDriver = NULL;
@@ -0,0 +1,47 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Converts raw EuRoC recordings to png images.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include "xrt/xrt_compiler.h"
+#include "xrt/xrt_config_have.h"
+#include "xrt/xrt_config_os.h"
+
+#include "cli_common.h"
+
+#if defined(XRT_HAVE_OPENCV) && !defined(XRT_OS_WINDOWS)
+#include "tracking/t_euroc_recorder.h"
+#endif
+
+#include <stdio.h>
+
+#define P(...) fprintf(stderr, __VA_ARGS__)
+
+int
+cli_cmd_euroc_convert(int argc, const char **argv)
+{
+#if defined(XRT_HAVE_OPENCV) && !defined(XRT_OS_WINDOWS)
+	if (argc < 3) {
+		P("Usage: %s %s <dataset>...\n", argv[0], argv[1]);
+		P("Converts the images of datasets recorded with EUROC_RECORDER_FORMAT=raw to png.\n");
+		return 1;
+	}
+
+	int ret = 0;
+	for (int i = 2; i < argc; i++) {
+		P("Converting '%s'\n", argv[i]);
+		if (!euroc_recorder_convert_raw(argv[i])) {
+			P("Failed to convert '%s'!\n", argv[i]);
+			ret = 1;
+		}
+	}
+
+	return ret;
+#else
+	P("Not compiled with XRT_HAVE_OPENCV, so can't convert recordings!\n");
+	return 1;
+#endif
+}
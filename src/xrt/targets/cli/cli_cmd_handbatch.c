@@ -0,0 +1,552 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Mercury hand tracking benchmark on EuRoC datasets.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include "xrt/xrt_config_build.h"
+#include "xrt/xrt_config_drivers.h"
+#include "xrt/xrt_frame.h"
+#include "xrt/xrt_frameserver.h"
+
+#include "os/os_time.h"
+#include "util/u_logging.h"
+#include "util/u_misc.h"
+
+#include "cli_common.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(XRT_BUILD_DRIVER_HANDTRACKING) && defined(XRT_BUILD_DRIVER_EUROC)
+#include "euroc/euroc_interface.h"
+#include "os/os_threading.h"
+#include "tracking/t_hand_tracking.h"
+#include "tracking/t_tracking.h"
+#include "util/u_file.h"
+#include "util/u_histogram.h"
+#include "../../tracking/hand/mercury/hg_interface.h"
+
+#include <cjson/cJSON.h>
+#endif
+
+#define P(...) fprintf(stderr, __VA_ARGS__)
+#define I(...) U_LOG(U_LOGGING_INFO, __VA_ARGS__)
+
+#if defined(XRT_BUILD_DRIVER_HANDTRACKING) && defined(XRT_BUILD_DRIVER_EUROC)
+
+enum stage
+{
+	STAGE_CONVERT,
+	STAGE_DETECT,
+	STAGE_WARP,
+	STAGE_KEYPOINT,
+	STAGE_KINE_LM,
+	STAGE_TOTAL,
+	STAGE_COUNT,
+};
+
+static const char *stage_names[STAGE_COUNT] = {"convert", "detect", "warp", "keypoint", "kine_lm", "total"};
+
+//! Settings that change what is being benchmarked, recorded in the summary.
+static const char *settings_env_vars[] = {
+    "MERCURY_MODEL_VARIANT",        "MERCURY_ORT_PROVIDER",           "MERCURY_ORT_INTRA_OP_THREADS",
+    "MERCURY_ORT_INTER_OP_THREADS", "MERCURY_ORT_OPTIMIZATION_LEVEL", "MERCURY_BATCHED_INFERENCE",
+    "MERCURY_ADAPTIVE_DETECTION",   "MERCURY_EXACT_DISTORT",          "MERCURY_THREADS",
+    "MERCURY_SHARED_POOL",          "XRT_TRACKING_THREADS",
+};
+
+struct handbatch
+{
+	struct xrt_frame_sink left_sink;
+	struct xrt_frame_sink right_sink;
+
+	//! Waiting for the right frame with the same timestamp.
+	struct xrt_frame *left;
+
+	struct t_hand_tracking_sync *sync;
+
+	FILE *timings_csv;
+	FILE *joints_csv;
+
+	//! Joints of an earlier run to compare with, optional.
+	FILE *reference_csv;
+
+	struct u_hist_ns *hists[STAGE_COUNT];
+
+	uint64_t frame_count;
+	uint64_t active_count[2];
+
+	//! Only for frames and hands that are tracked both here and in the reference.
+	double error_sum_m;
+	uint64_t error_count;
+
+	//! Frames and hands that are tracked in only one of this run and the reference.
+	uint64_t mismatch_count;
+
+	uint64_t reference_frame_count;
+};
+
+static bool should_exit = false;
+
+static void *
+wait_for_exit_key(void *ptr)
+{
+	getchar();
+	should_exit = true;
+	return NULL;
+}
+
+
+/*
+ *
+ * Joints files.
+ *
+ */
+
+static void
+write_joints(FILE *file, uint64_t timestamp, int hand_idx, const struct xrt_hand_joint_set *set)
+{
+	fprintf(file, "%" PRIu64 ",%d,%d", timestamp, hand_idx, set->is_active ? 1 : 0);
+
+	for (int i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		const struct xrt_vec3 *p = &set->values.hand_joint_set_default[i].relation.pose.position;
+		fprintf(file, ",%f,%f,%f", p->x, p->y, p->z);
+	}
+
+	fprintf(file, "\n");
+}
+
+//! Reads one line of a joints file, returns false at the end or on lines that don't parse.
+static bool
+read_joints(FILE *file, uint64_t *out_timestamp, int *out_hand_idx, bool *out_active, struct xrt_vec3 *out_joints)
+{
+	char line[4096];
+
+	do {
+		if (fgets(line, sizeof(line), file) == NULL) {
+			return false;
+		}
+	} while (line[0] == '#');
+
+	char *ptr = line;
+	char *end = NULL;
+
+	*out_timestamp = strtoull(ptr, &end, 10);
+	if (end == ptr || *end != ',') {
+		return false;
+	}
+	ptr = end + 1;
+
+	*out_hand_idx = (int)strtol(ptr, &end, 10);
+	if (end == ptr || *end != ',') {
+		return false;
+	}
+	ptr = end + 1;
+
+	*out_active = strtol(ptr, &end, 10) != 0;
+	if (end == ptr) {
+		return false;
+	}
+
+	for (int i = 0; i < XRT_HAND_JOINT_COUNT * 3; i++) {
+		if (*end != ',') {
+			return false;
+		}
+		ptr = end + 1;
+
+		float value = strtof(ptr, &end);
+		if (end == ptr) {
+			return false;
+		}
+
+		(&out_joints[i / 3].x)[i % 3] = value;
+	}
+
+	return true;
+}
+
+//! Compares the hands with the reference lines of the same timestamp, both files are in frame order.
+static void
+compare_with_reference(struct handbatch *hb, uint64_t timestamp, const struct xrt_hand_joint_set hands[2])
+{
+	uint64_t ref_timestamp = 0;
+	int ref_hand_idx = 0;
+	bool ref_active = false;
+	struct xrt_vec3 ref_joints[XRT_HAND_JOINT_COUNT];
+	bool counted_frame = false;
+
+	while (true) {
+		long pos = ftell(hb->reference_csv);
+
+		if (!read_joints(hb->reference_csv, &ref_timestamp, &ref_hand_idx, &ref_active, ref_joints)) {
+			return;
+		}
+
+		if (ref_timestamp < timestamp) {
+			continue;
+		}
+
+		if (ref_timestamp > timestamp || ref_hand_idx < 0 || ref_hand_idx > 1) {
+			// Belongs to a later frame, read it again then.
+			fseek(hb->reference_csv, pos, SEEK_SET);
+			return;
+		}
+
+		if (!counted_frame) {
+			hb->reference_frame_count++;
+			counted_frame = true;
+		}
+
+		const struct xrt_hand_joint_set *set = &hands[ref_hand_idx];
+
+		if (set->is_active != ref_active) {
+			hb->mismatch_count++;
+			continue;
+		}
+
+		if (!ref_active) {
+			continue;
+		}
+
+		double sum = 0;
+		for (int i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+			const struct xrt_vec3 *p = &set->values.hand_joint_set_default[i].relation.pose.position;
+			double dx = p->x - ref_joints[i].x;
+			double dy = p->y - ref_joints[i].y;
+			double dz = p->z - ref_joints[i].z;
+			sum += sqrt(dx * dx + dy * dy + dz * dz);
+		}
+
+		hb->error_sum_m += sum / XRT_HAND_JOINT_COUNT;
+		hb->error_count++;
+	}
+}
+
+
+/*
+ *
+ * Sinks.
+ *
+ */
+
+static void
+process_frames(struct handbatch *hb, struct xrt_frame *left, struct xrt_frame *right)
+{
+	struct xrt_hand_joint_set hands[2] = {0};
+	uint64_t timestamp = 0;
+
+	t_ht_sync_process(hb->sync, left, right, &hands[0], &hands[1], &timestamp);
+
+	struct t_hand_tracking_mercury_timings timings = {0};
+	t_hand_tracking_sync_mercury_get_timings(hb->sync, &timings);
+
+	uint64_t values[STAGE_COUNT] = {
+	    [STAGE_CONVERT] = timings.convert_ns,   [STAGE_DETECT] = timings.detect_ns,
+	    [STAGE_WARP] = timings.warp_ns,         [STAGE_KEYPOINT] = timings.keypoint_ns,
+	    [STAGE_KINE_LM] = timings.kine_lm_ns,   [STAGE_TOTAL] = timings.total_ns,
+	};
+
+	fprintf(hb->timings_csv, "%" PRIu64, left->timestamp);
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		u_hist_ns_add(hb->hists[i], values[i]);
+		fprintf(hb->timings_csv, ",%" PRIu64, values[i]);
+	}
+	fprintf(hb->timings_csv, ",%d,%d\n", hands[0].is_active ? 1 : 0, hands[1].is_active ? 1 : 0);
+
+	for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
+		write_joints(hb->joints_csv, left->timestamp, hand_idx, &hands[hand_idx]);
+		hb->active_count[hand_idx] += hands[hand_idx].is_active ? 1 : 0;
+	}
+
+	if (hb->reference_csv != NULL) {
+		compare_with_reference(hb, left->timestamp, hands);
+	}
+
+	hb->frame_count++;
+}
+
+static void
+receive_left(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	struct handbatch *hb = container_of(xfs, struct handbatch, left_sink);
+
+	xrt_frame_reference(&hb->left, xf);
+}
+
+static void
+receive_right(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+{
+	struct handbatch *hb = container_of(xfs, struct handbatch, right_sink);
+
+	// The player pushes both views of each timestamp from one thread, left first.
+	if (hb->left != NULL && hb->left->timestamp == xf->timestamp) {
+		process_frames(hb, hb->left, xf);
+	}
+
+	xrt_frame_reference(&hb->left, NULL);
+}
+
+
+/*
+ *
+ * Summary.
+ *
+ */
+
+static void
+write_summary(struct handbatch *hb, const char *path, const char *dataset_path, uint64_t wall_ns)
+{
+	cJSON *root = cJSON_CreateObject();
+
+	cJSON_AddStringToObject(root, "dataset", dataset_path);
+	cJSON_AddNumberToObject(root, "frames", (double)hb->frame_count);
+	cJSON_AddNumberToObject(root, "wall_time_s", (double)wall_ns / U_TIME_1S_IN_NS);
+
+	// Wall time includes loading the images, the tracking one only Mercury itself.
+	double fps = wall_ns > 0 ? (double)hb->frame_count * U_TIME_1S_IN_NS / (double)wall_ns : 0;
+	cJSON_AddNumberToObject(root, "fps", fps);
+
+	cJSON *settings = cJSON_AddObjectToObject(root, "settings");
+	for (size_t i = 0; i < ARRAY_SIZE(settings_env_vars); i++) {
+		const char *value = getenv(settings_env_vars[i]);
+		if (value != NULL) {
+			cJSON_AddStringToObject(settings, settings_env_vars[i], value);
+		}
+	}
+
+	struct u_hist_ns_snapshot *snapshot = U_TYPED_CALLOC(struct u_hist_ns_snapshot);
+	cJSON *stages = cJSON_AddObjectToObject(root, "stages_ms");
+
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		struct u_hist_ns_stats stats = {0};
+		u_hist_ns_get_snapshot(hb->hists[i], snapshot);
+		u_hist_ns_snapshot_get_stats(snapshot, &stats);
+
+		cJSON *stage = cJSON_AddObjectToObject(stages, stage_names[i]);
+		cJSON_AddNumberToObject(stage, "mean", (double)stats.mean / U_TIME_1MS_IN_NS);
+		cJSON_AddNumberToObject(stage, "p50", (double)stats.p50 / U_TIME_1MS_IN_NS);
+		cJSON_AddNumberToObject(stage, "p90", (double)stats.p90 / U_TIME_1MS_IN_NS);
+		cJSON_AddNumberToObject(stage, "p99", (double)stats.p99 / U_TIME_1MS_IN_NS);
+		cJSON_AddNumberToObject(stage, "worst", (double)stats.worst / U_TIME_1MS_IN_NS);
+
+		if (i == STAGE_TOTAL) {
+			double tracking_fps = stats.mean > 0 ? (double)U_TIME_1S_IN_NS / (double)stats.mean : 0;
+			cJSON_AddNumberToObject(root, "tracking_fps", tracking_fps);
+		}
+	}
+
+	free(snapshot);
+
+	cJSON *active = cJSON_AddArrayToObject(root, "active_frames");
+	cJSON_AddItemToArray(active, cJSON_CreateNumber((double)hb->active_count[0]));
+	cJSON_AddItemToArray(active, cJSON_CreateNumber((double)hb->active_count[1]));
+
+	if (hb->reference_csv != NULL) {
+		cJSON *reference = cJSON_AddObjectToObject(root, "reference");
+		double mean_error_mm = hb->error_count > 0 ? hb->error_sum_m / (double)hb->error_count * 1000 : 0;
+
+		cJSON_AddNumberToObject(reference, "frames", (double)hb->reference_frame_count);
+		cJSON_AddNumberToObject(reference, "compared_hands", (double)hb->error_count);
+		cJSON_AddNumberToObject(reference, "mean_joint_error_mm", mean_error_mm);
+		cJSON_AddNumberToObject(reference, "active_mismatches", (double)hb->mismatch_count);
+	}
+
+	char *str = cJSON_Print(root);
+	FILE *file = fopen(path, "w");
+	if (file != NULL) {
+		fprintf(file, "%s\n", str);
+		fclose(file);
+	} else {
+		P("Could not write '%s'\n", path);
+	}
+
+	printf("%s\n", str);
+
+	cJSON_free(str);
+	cJSON_Delete(root);
+}
+
+
+/*
+ *
+ * Running.
+ *
+ */
+
+static FILE *
+open_output(const char *output_path, const char *name)
+{
+	char path[1024];
+	snprintf(path, sizeof(path), "%s/%s", output_path, name);
+
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		P("Could not open '%s', does the output directory exist?\n", path);
+	}
+
+	return file;
+}
+
+static void
+close_files(struct handbatch *hb)
+{
+	FILE **files[] = {&hb->timings_csv, &hb->joints_csv, &hb->reference_csv};
+
+	for (size_t i = 0; i < ARRAY_SIZE(files); i++) {
+		if (*files[i] != NULL) {
+			fclose(*files[i]);
+			*files[i] = NULL;
+		}
+	}
+}
+
+static int
+run_dataset(const char *dataset_path, const char *calib_path, const char *output_path, const char *reference_path)
+{
+	struct t_stereo_camera_calibration *calib = NULL;
+	if (!t_stereo_camera_calibration_load(calib_path, &calib)) {
+		P("Could not load calibration '%s'\n", calib_path);
+		return EXIT_FAILURE;
+	}
+
+	char models_path[1024] = {0};
+	if (u_file_get_hand_tracking_models_dir(models_path, ARRAY_SIZE(models_path)) < 0) {
+		P("Could not find the hand tracking models, run ./scripts/get-ht-models.sh\n");
+		t_stereo_camera_calibration_reference(&calib, NULL);
+		return EXIT_FAILURE;
+	}
+
+	struct handbatch hb = {0};
+	hb.left_sink.push_frame = receive_left;
+	hb.right_sink.push_frame = receive_right;
+
+	hb.timings_csv = open_output(output_path, "timings.csv");
+	hb.joints_csv = open_output(output_path, "joints.csv");
+	if (reference_path != NULL) {
+		hb.reference_csv = fopen(reference_path, "r");
+		if (hb.reference_csv == NULL) {
+			P("Could not open reference '%s'\n", reference_path);
+		}
+	}
+
+	if (hb.timings_csv == NULL || hb.joints_csv == NULL || (reference_path != NULL && hb.reference_csv == NULL)) {
+		close_files(&hb);
+		t_stereo_camera_calibration_reference(&calib, NULL);
+		return EXIT_FAILURE;
+	}
+
+	fprintf(hb.timings_csv, "#timestamp [ns]");
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		fprintf(hb.timings_csv, ",%s [ns]", stage_names[i]);
+	}
+	fprintf(hb.timings_csv, ",left_active,right_active\n");
+
+	fprintf(hb.joints_csv, "#timestamp [ns],hand,active");
+	for (int i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		fprintf(hb.joints_csv, ",j%d_x [m],j%d_y [m],j%d_z [m]", i, i, i);
+	}
+	fprintf(hb.joints_csv, "\n");
+
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		hb.hists[i] = u_hist_ns_create();
+	}
+
+	struct t_hand_tracking_create_info create_info = {0};
+	hb.sync = t_hand_tracking_sync_mercury_create(calib, create_info, models_path);
+	t_stereo_camera_calibration_reference(&calib, NULL);
+
+	// Play every frame as fast as the tracker takes them.
+	struct euroc_player_config *ep_config = U_TYPED_CALLOC(struct euroc_player_config);
+	euroc_player_fill_default_config_for(ep_config, dataset_path);
+	ep_config->playback.cam_count = 2;
+	ep_config->playback.color = false;
+	ep_config->playback.gt = false;
+	ep_config->playback.max_speed = true;
+	ep_config->playback.use_source_ts = true;
+	ep_config->playback.play_from_start = true;
+	ep_config->playback.print_progress = true;
+
+	if (ep_config->dataset.cam_count < 2) {
+		P("Dataset '%s' needs at least two cameras\n", dataset_path);
+	} else {
+		struct xrt_frame_context xfctx = {0};
+		struct xrt_slam_sinks sinks = {0};
+		sinks.cam_count = 2;
+		sinks.cams[0] = &hb.left_sink;
+		sinks.cams[1] = &hb.right_sink;
+
+		I("Dataset path: %s", dataset_path);
+
+		uint64_t start_ns = os_monotonic_get_ns();
+
+		struct xrt_fs *xfs = euroc_player_create(&xfctx, dataset_path, ep_config);
+		xrt_fs_slam_stream_start(xfs, &sinks);
+
+		while (xrt_fs_is_running(xfs) && !should_exit) {
+			os_nanosleep(U_TIME_1MS_IN_NS * 100);
+		}
+
+		// Stops the player, it may be in the middle of a frame.
+		xrt_frame_context_destroy_nodes(&xfctx);
+
+		uint64_t wall_ns = os_monotonic_get_ns() - start_ns;
+
+		char summary_path[1024];
+		snprintf(summary_path, sizeof(summary_path), "%s/summary.json", output_path);
+		write_summary(&hb, summary_path, dataset_path, wall_ns);
+	}
+
+	xrt_frame_reference(&hb.left, NULL);
+	t_ht_sync_destroy(&hb.sync);
+	for (int i = 0; i < STAGE_COUNT; i++) {
+		u_hist_ns_destroy(&hb.hists[i]);
+	}
+	close_files(&hb);
+	free(ep_config);
+
+	return EXIT_SUCCESS;
+}
+
+#endif
+
+int
+cli_cmd_handbatch(int argc, const char **argv)
+{
+#if !defined(XRT_BUILD_DRIVER_HANDTRACKING)
+	P("Hand tracking not built.\n");
+	return EXIT_FAILURE;
+#elif !defined(XRT_BUILD_DRIVER_EUROC)
+	P("Euroc driver not built, can't reproduce datasets.\n");
+	return EXIT_FAILURE;
+#else
+	// Do not count "monado-cli" and "handbatch" as args
+	int nof_args = argc - 2;
+	const char **args = &argv[2];
+
+	if (nof_args != 3 && nof_args != 4) {
+		P("Benchmark of Mercury hand tracking on a EuRoC dataset.\n");
+		P("Usage: %s %s <euroc_path> <calibration> <output_path> [<reference_joints.csv>]\n", argv[0], argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	// Allow pressing enter to quit the program by launching a new thread
+	struct os_thread_helper wfk_thread;
+	os_thread_helper_init(&wfk_thread);
+	os_thread_helper_start(&wfk_thread, wait_for_exit_key, NULL);
+
+	int ret = run_dataset(args[0], args[1], args[2], nof_args == 4 ? args[3] : NULL);
+
+	pthread_cancel(wfk_thread.thread);
+
+	// Destroy also stops the thread.
+	os_thread_helper_destroy(&wfk_thread);
+
+	return ret;
+#endif
+}
@@ -0,0 +1,441 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Summarizes the pacing of a metrics file written by the service.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include "xrt/xrt_compiler.h"
+
+#include "util/u_time.h"
+
+#include "cli_common.h"
+
+#include "monado_metrics.pb.h"
+#include "pb_decode.h"
+
+#include <inttypes.h>
+#include <string.h>
+#include <stdio.h>
+
+#define P(...) fprintf(stderr, __VA_ARGS__)
+
+//! Sessions beyond this many are folded into the last one.
+#define MAX_SESSIONS (32)
+
+
+/*
+ *
+ * Structs.
+ *
+ */
+
+/*!
+ * Min, max and average of a signed duration, durations like how late
+ * something happened compared to its prediction can be negative.
+ */
+struct dur_stat
+{
+	uint64_t count;
+	int64_t sum;
+	int64_t min;
+	int64_t max;
+};
+
+struct system_summary
+{
+	uint64_t frames;
+	uint64_t missed;
+	uint64_t no_present_info;
+	uint64_t last_present_ns;
+
+	struct dur_stat present_margin;
+	struct dur_stat present_error;
+	struct dur_stat present_period;
+	struct dur_stat wake_up_late;
+	struct dur_stat comp_time;
+	struct dur_stat expected_comp_time;
+	struct dur_stat gpu_time;
+};
+
+struct session_summary
+{
+	int64_t session_id;
+
+	uint64_t frames;
+	uint64_t discarded;
+	uint64_t used;
+	uint64_t late;
+	uint64_t moved_display_time;
+
+	struct dur_stat wake_up_late;
+	struct dur_stat frame_time;
+	struct dur_stat predicted_frame_time;
+	struct dur_stat gpu_done_error;
+};
+
+struct summary
+{
+	uint32_t version_major;
+	uint32_t version_minor;
+	uint64_t records;
+
+	struct system_summary sys;
+
+	struct session_summary sessions[MAX_SESSIONS];
+	uint32_t session_count;
+};
+
+enum csv_mode
+{
+	CSV_NONE,
+	CSV_SYSTEM,
+	CSV_SESSION,
+};
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static void
+stat_add(struct dur_stat *s, int64_t value)
+{
+	if (s->count == 0 || value < s->min) {
+		s->min = value;
+	}
+	if (s->count == 0 || value > s->max) {
+		s->max = value;
+	}
+
+	s->sum += value;
+	s->count++;
+}
+
+static int64_t
+diff_ns(uint64_t a, uint64_t b)
+{
+	return (int64_t)(a - b);
+}
+
+static void
+print_stat(const char *name, const struct dur_stat *s)
+{
+	if (s->count == 0) {
+		printf("\t%-24s %10s\n", name, "-");
+		return;
+	}
+
+	double avg = (double)s->sum / (double)s->count;
+
+	printf("\t%-24s %8.3fms avg %8.3fms min %8.3fms max\n", name, //
+	       avg / (double)U_TIME_1MS_IN_NS,                        //
+	       (double)s->min / (double)U_TIME_1MS_IN_NS,             //
+	       (double)s->max / (double)U_TIME_1MS_IN_NS);
+}
+
+static void
+print_count(const char *name, uint64_t count, uint64_t total)
+{
+	double percent = total > 0 ? (double)count * 100.0 / (double)total : 0.0;
+
+	printf("\t%-24s %10" PRIu64 " (%.1f%%)\n", name, count, percent);
+}
+
+static struct session_summary *
+get_session(struct summary *sum, int64_t session_id)
+{
+	for (uint32_t i = 0; i < sum->session_count; i++) {
+		if (sum->sessions[i].session_id == session_id) {
+			return &sum->sessions[i];
+		}
+	}
+
+	if (sum->session_count >= MAX_SESSIONS) {
+		return &sum->sessions[MAX_SESSIONS - 1];
+	}
+
+	struct session_summary *ss = &sum->sessions[sum->session_count++];
+	ss->session_id = session_id;
+
+	return ss;
+}
+
+/*!
+ * Reads one record, each one is prefixed with its size as a varint.
+ *
+ * @return 1 if a record was read, 0 at the end of the file and -1 on error.
+ */
+static int
+read_record(FILE *file, monado_metrics_Record *out_record)
+{
+	uint8_t buffer[monado_metrics_Record_size];
+	uint64_t size = 0;
+
+	for (uint32_t shift = 0;; shift += 7) {
+		int c = fgetc(file);
+		if (c == EOF) {
+			// Only clean if we are between records.
+			return shift == 0 ? 0 : -1;
+		}
+		if (shift >= 64) {
+			return -1;
+		}
+
+		size |= (uint64_t)(c & 0x7f) << shift;
+		if ((c & 0x80) == 0) {
+			break;
+		}
+	}
+
+	if (size > sizeof(buffer)) {
+		return -1;
+	}
+
+	if (fread(buffer, 1, (size_t)size, file) != size) {
+		return -1;
+	}
+
+	*out_record = (monado_metrics_Record)monado_metrics_Record_init_default;
+
+	pb_istream_t stream = pb_istream_from_buffer(buffer, (size_t)size);
+	if (!pb_decode(&stream, &monado_metrics_Record_msg, out_record)) {
+		return -1;
+	}
+
+	return 1;
+}
+
+
+/*
+ *
+ * Record handling.
+ *
+ */
+
+static void
+handle_present_info(struct summary *sum, const monado_metrics_SystemPresentInfo *pi, enum csv_mode csv)
+{
+	struct system_summary *sys = &sum->sys;
+
+	if (csv == CSV_SYSTEM) {
+		printf("%" PRId64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+		       ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+		       pi->frame_id, pi->predicted_display_time_ns, pi->predicted_wake_up_time_ns, pi->when_woke_ns,
+		       pi->when_began_ns, pi->when_submitted_ns, pi->predicted_done_time_ns,
+		       pi->desired_present_time_ns, pi->actual_present_time_ns, pi->present_margin_ns,
+		       pi->expected_comp_time_ns);
+	}
+
+	sys->frames++;
+
+	stat_add(&sys->wake_up_late, diff_ns(pi->when_woke_ns, pi->predicted_wake_up_time_ns));
+	stat_add(&sys->comp_time, diff_ns(pi->when_submitted_ns, pi->when_began_ns));
+	stat_add(&sys->expected_comp_time, (int64_t)pi->expected_comp_time_ns);
+
+	// Not all targets can tell us when the frame was presented.
+	if (pi->actual_present_time_ns == 0) {
+		sys->no_present_info++;
+		return;
+	}
+
+	if (pi->actual_present_time_ns > pi->desired_present_time_ns + pi->present_slop_ns) {
+		sys->missed++;
+	}
+
+	stat_add(&sys->present_margin, (int64_t)pi->present_margin_ns);
+	stat_add(&sys->present_error, diff_ns(pi->actual_present_time_ns, pi->desired_present_time_ns));
+
+	if (sys->last_present_ns != 0 && pi->actual_present_time_ns > sys->last_present_ns) {
+		stat_add(&sys->present_period, diff_ns(pi->actual_present_time_ns, sys->last_present_ns));
+	}
+	sys->last_present_ns = pi->actual_present_time_ns;
+}
+
+static void
+handle_session_frame(struct summary *sum, const monado_metrics_SessionFrame *sf, enum csv_mode csv)
+{
+	if (csv == CSV_SESSION) {
+		printf("%" PRId64 ",%" PRId64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64
+		       ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%d\n",
+		       sf->session_id, sf->frame_id, sf->predicted_display_time_ns, sf->display_time_ns,
+		       sf->predicted_wake_up_time_ns, sf->when_wait_woke_ns, sf->when_begin_ns,
+		       sf->when_delivered_ns, sf->predicted_gpu_done_time_ns, sf->when_gpu_done_ns,
+		       sf->predicted_frame_time_ns, sf->discarded ? 1 : 0);
+	}
+
+	struct session_summary *ss = get_session(sum, sf->session_id);
+
+	ss->frames++;
+
+	if (sf->discarded) {
+		ss->discarded++;
+		return;
+	}
+
+	if (sf->display_time_ns != sf->predicted_display_time_ns) {
+		ss->moved_display_time++;
+	}
+
+	stat_add(&ss->wake_up_late, diff_ns(sf->when_wait_woke_ns, sf->predicted_wake_up_time_ns));
+	stat_add(&ss->predicted_frame_time, (int64_t)sf->predicted_frame_time_ns);
+
+	// Only frames that got as far as the GPU being done.
+	if (sf->when_gpu_done_ns == 0) {
+		return;
+	}
+
+	if (sf->when_gpu_done_ns > sf->predicted_gpu_done_time_ns) {
+		ss->late++;
+	}
+
+	stat_add(&ss->frame_time, diff_ns(sf->when_gpu_done_ns, sf->when_wait_woke_ns));
+	stat_add(&ss->gpu_done_error, diff_ns(sf->when_gpu_done_ns, sf->predicted_gpu_done_time_ns));
+}
+
+static void
+handle_record(struct summary *sum, const monado_metrics_Record *r, enum csv_mode csv)
+{
+	sum->records++;
+
+	switch (r->which_record) {
+	case monado_metrics_Record_version_tag:
+		sum->version_major = r->record.version.major;
+		sum->version_minor = r->record.version.minor;
+		break;
+	case monado_metrics_Record_session_frame_tag: handle_session_frame(sum, &r->record.session_frame, csv); break;
+	case monado_metrics_Record_used_tag: get_session(sum, r->record.used.session_id)->used++; break;
+	case monado_metrics_Record_system_present_info_tag:
+		handle_present_info(sum, &r->record.system_present_info, csv);
+		break;
+	case monado_metrics_Record_system_gpu_info_tag:
+		stat_add(&sum->sys.gpu_time,
+		         diff_ns(r->record.system_gpu_info.gpu_end_ns, r->record.system_gpu_info.gpu_start_ns));
+		break;
+	default: break;
+	}
+}
+
+
+/*
+ *
+ * Printing.
+ *
+ */
+
+static void
+print_summary(const struct summary *sum)
+{
+	const struct system_summary *sys = &sum->sys;
+
+	printf("Metrics version %u.%u, %" PRIu64 " records\n", sum->version_major, sum->version_minor,
+	       sum->records);
+
+	printf("\nCompositor, %" PRIu64 " frames\n", sys->frames);
+	print_count("missed present", sys->missed, sys->frames - sys->no_present_info);
+	print_count("no present info", sys->no_present_info, sys->frames);
+	print_stat("present margin", &sys->present_margin);
+	print_stat("present - desired", &sys->present_error);
+	print_stat("present period", &sys->present_period);
+	print_stat("woke - predicted", &sys->wake_up_late);
+	print_stat("submit - begin", &sys->comp_time);
+	print_stat("expected comp time", &sys->expected_comp_time);
+	print_stat("gpu time", &sys->gpu_time);
+
+	for (uint32_t i = 0; i < sum->session_count; i++) {
+		const struct session_summary *ss = &sum->sessions[i];
+		uint64_t shown = ss->frames - ss->discarded;
+
+		printf("\nSession %" PRId64 ", %" PRIu64 " frames\n", ss->session_id, ss->frames);
+		print_count("discarded", ss->discarded, ss->frames);
+		print_count("gpu done late", ss->late, shown);
+		print_count("display time moved", ss->moved_display_time, shown);
+		// Can be more than the frames, a frame is used again if the next one is late.
+		printf("\t%-24s %10" PRIu64 "\n", "used by compositor", ss->used);
+		print_stat("woke - predicted", &ss->wake_up_late);
+		print_stat("frame time", &ss->frame_time);
+		print_stat("predicted frame time", &ss->predicted_frame_time);
+		print_stat("gpu done - predicted", &ss->gpu_done_error);
+	}
+}
+
+static int
+print_help(const char *name)
+{
+	P("Usage: %s pacing <file> [--csv system|session]\n", name);
+	P("\n");
+	P("Summarizes a metrics file written with XRT_METRICS_FILE set, or with\n");
+	P("--csv writes the compositor or per session frames as CSV to stdout.\n");
+
+	return 1;
+}
+
+
+/*
+ *
+ * 'Exported' functions.
+ *
+ */
+
+int
+cli_cmd_pacing(int argc, const char **argv)
+{
+	enum csv_mode csv = CSV_NONE;
+
+	if (argc < 3) {
+		return print_help(argv[0]);
+	}
+
+	if (argc >= 5 && strcmp(argv[3], "--csv") == 0) {
+		if (strcmp(argv[4], "system") == 0) {
+			csv = CSV_SYSTEM;
+		} else if (strcmp(argv[4], "session") == 0) {
+			csv = CSV_SESSION;
+		} else {
+			return print_help(argv[0]);
+		}
+	} else if (argc != 3) {
+		return print_help(argv[0]);
+	}
+
+	const char *filename = argv[2];
+	FILE *file = fopen(filename, "rb");
+	if (file == NULL) {
+		P("Could not open '%s'!\n", filename);
+		return 1;
+	}
+
+	if (csv == CSV_SYSTEM) {
+		printf("frame_id,predicted_display_time_ns,predicted_wake_up_time_ns,when_woke_ns,when_began_ns,"
+		       "when_submitted_ns,predicted_done_time_ns,desired_present_time_ns,actual_present_time_ns,"
+		       "present_margin_ns,expected_comp_time_ns\n");
+	} else if (csv == CSV_SESSION) {
+		printf("session_id,frame_id,predicted_display_time_ns,display_time_ns,predicted_wake_up_time_ns,"
+		       "when_wait_woke_ns,when_begin_ns,when_delivered_ns,predicted_gpu_done_time_ns,"
+		       "when_gpu_done_ns,predicted_frame_time_ns,discarded\n");
+	}
+
+	struct summary sum = {0};
+
+	monado_metrics_Record record;
+	int ret;
+	while ((ret = read_record(file, &record)) > 0) {
+		handle_record(&sum, &record, csv);
+	}
+
+	fclose(file);
+
+	if (ret < 0) {
+		// A service that was killed can leave a partial record at the end.
+		P("Stopped at a bad or truncated record after %" PRIu64 " records.\n", sum.records);
+	}
+
+	if (csv == CSV_NONE) {
+		print_summary(&sum);
+	}
+
+	return 0;
+}
@@ -9,11 +9,15 @@
 #include "euroc/euroc_interface.h"
 #include "os/os_threading.h"
 #include "util/u_logging.h"
+#include "util/u_misc.h"
 #include "xrt/xrt_config_build.h"
 #include "xrt/xrt_config_have.h"
 #include "xrt/xrt_config_drivers.h"
 
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define P(...) fprintf(stderr, __VA_ARGS__)
 #define I(...) U_LOG(U_LOGGING_INFO, __VA_ARGS__)
@@ -29,8 +33,92 @@ wait_for_exit_key(void *ptr)
 	should_exit = true;
 	return NULL;
 }
+
+struct job
+{
+	const char *dataset_path;
+	const char *slam_config;
+	const char *output_path;
+	struct euroc_run_stats stats;
+	bool done;
+};
+
+//! Shared by the threads running the datasets.
+struct batch
+{
+	struct os_mutex mutex;
+	struct job *jobs;
+	int job_count;
+	int next_job;
+	struct euroc_run_options options;
+};
+
+static void *
+run_jobs(void *ptr)
+{
+	struct batch *b = (struct batch *)ptr;
+
+	while (!should_exit) {
+		os_mutex_lock(&b->mutex);
+		int i = b->next_job++;
+		os_mutex_unlock(&b->mutex);
+
+		if (i >= b->job_count) {
+			break;
+		}
+
+		struct job *j = &b->jobs[i];
+		I("Running dataset %d out of %d", i + 1, b->job_count);
+		I("Dataset path: %s", j->dataset_path);
+		I("SLAM config path: %s", j->slam_config);
+		I("Output path: %s", j->output_path);
+
+		// Each run has its own frame context, tracker and player.
+		euroc_run_dataset_with_stats(j->dataset_path, j->slam_config, j->output_path, &b->options,
+		                             &should_exit, &j->stats);
+		j->done = !should_exit;
+	}
+
+	return NULL;
+}
+
+static void
+print_summary(const struct batch *b)
+{
+	printf("\n%-40s %10s %8s %10s %9s %10s\n", "Dataset", "Wall [s]", "Poses", "Poses/s", "Realtime", "ATE [m]");
+
+	for (int i = 0; i < b->job_count; i++) {
+		const struct job *j = &b->jobs[i];
+		const struct euroc_run_stats *s = &j->stats;
+
+		// Keep the end of long paths, that is where the dataset names are
+		const char *name = j->dataset_path;
+		size_t len = strlen(name);
+		if (len > 40) {
+			name += len - 40;
+		}
+
+		if (!j->done) {
+			printf("%-40s %10s\n", name, "not run");
+			continue;
+		}
+
+		double poses_per_s = s->wall_time_s > 0 ? (double)s->pose_count / s->wall_time_s : 0;
+		double realtime = s->wall_time_s > 0 ? s->dataset_time_s / s->wall_time_s : 0;
+
+		printf("%-40s %10.2f %8" PRIu64 " %10.1f %8.2fx ", name, s->wall_time_s, s->pose_count, poses_per_s,
+		       realtime);
+		if (s->has_ate) {
+			printf("%10.4f\n", s->ate_rmse_m);
+		} else {
+			printf("%10s\n", "-");
+		}
+	}
+}
 #endif
 
+#define MAX_JOBS 64
+
 int
 cli_cmd_slambatch(int argc, const char **argv)
 {
@@ -46,31 +134,66 @@ cli_cmd_slambatch(int argc, const char **argv)
 	int nof_args = argc - 2;
 	const char **args = &argv[2];
 
-	if (nof_args == 0 || nof_args % 3 != 0) {
+	int jobs = 1;
+	double speed = 0;
+	while (nof_args >= 2 && strncmp(args[0], "--", 2) == 0) {
+		if (strcmp(args[0], "--jobs") == 0) {
+			jobs = atoi(args[1]);
+		} else if (strcmp(args[0], "--speed") == 0) {
+			speed = atof(args[1]);
+		} else {
+			break;
+		}
+		nof_args -= 2;
+		args += 2;
+	}
+
+	if (nof_args == 0 || nof_args % 3 != 0 || jobs < 1 || jobs > MAX_JOBS) {
 		P("Batch evaluator of SLAM datasets.\n");
-		P("Usage: %s %s [<euroc_path> <slam_config> <output_path>]...\n", argv[0], argv[1]);
+		P("Usage: %s %s [--jobs <n>] [--speed <factor>] [<euroc_path> <slam_config> <output_path>]...\n",
+		  argv[0], argv[1]);
+		P("\n");
+		P("  --jobs <n>        Datasets to run at the same time, 1 to %d (default 1).\n", MAX_JOBS);
+		P("  --speed <factor>  Playback speed relative to the recording, 0 is as fast as possible (default).\n");
 		return EXIT_FAILURE;
 	}
 
+	struct batch b = {0};
+	os_mutex_init(&b.mutex);
+	b.job_count = nof_args / 3;
+	b.jobs = U_TYPED_ARRAY_CALLOC(struct job, b.job_count);
+	b.options.speed = speed;
+	b.options.print_progress = jobs == 1; // Several progress bars would garble each other
+
+	for (int i = 0; i < b.job_count; i++) {
+		b.jobs[i].dataset_path = args[i * 3];
+		b.jobs[i].slam_config = args[i * 3 + 1];
+		b.jobs[i].output_path = args[i * 3 + 2];
+	}
+
+	jobs = jobs < b.job_count ? jobs : b.job_count;
+
 	// Allow pressing enter to quit the program by launching a new thread
 	struct os_thread_helper wfk_thread;
 	os_thread_helper_init(&wfk_thread);
 	os_thread_helper_start(&wfk_thread, wait_for_exit_key, NULL);
 
 	timepoint_ns start_time = os_monotonic_get_ns();
-	int nof_datasets = nof_args / 3;
-	for (int i = 0; i < nof_datasets && !should_exit; i++) {
-		const char *dataset_path = args[i * 3];
-		const char *slam_config = args[i * 3 + 1];
-		const char *output_path = args[i * 3 + 2];
-
-		I("Running dataset %d out of %d", i + 1, nof_datasets);
-		I("Dataset path: %s", dataset_path);
-		I("SLAM config path: %s", slam_config);
-		I("Output path: %s", output_path);
-
-		euroc_run_dataset(dataset_path, slam_config, output_path, &should_exit);
+
+	struct os_thread threads[MAX_JOBS];
+	for (int i = 1; i < jobs; i++) {
+		os_thread_init(&threads[i]);
+		os_thread_start(&threads[i], run_jobs, &b);
+	}
+
+	// This thread is the first job runner.
+	run_jobs(&b);
+
+	for (int i = 1; i < jobs; i++) {
+		os_thread_join(&threads[i]);
+		os_thread_destroy(&threads[i]);
 	}
+
 	timepoint_ns end_time = os_monotonic_get_ns();
 
 	pthread_cancel(wfk_thread.thread);
@@ -78,7 +201,11 @@ cli_cmd_slambatch(int argc, const char **argv)
 	// Destroy also stops the thread.
 	os_thread_helper_destroy(&wfk_thread);
 
+	print_summary(&b);
 	printf("Done in %.2fs.\n", (double)(end_time - start_time) / U_TIME_1S_IN_NS);
+
+	free(b.jobs);
+	os_mutex_destroy(&b.mutex);
 #endif
 	return EXIT_SUCCESS;
 }
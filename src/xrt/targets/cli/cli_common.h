@@ -20,12 +20,21 @@ cli_cmd_calibrate(int argc, const char **argv);
 int
 cli_cmd_calibration_dump(int argc, const char **argv);
 
+int
+cli_cmd_euroc_convert(int argc, const char **argv);
+
+int
+cli_cmd_handbatch(int argc, const char **argv);
+
 int
 cli_cmd_info(int argc, const char **argv);
 
 int
 cli_cmd_lighthouse(int argc, const char **argv);
 
+int
+cli_cmd_pacing(int argc, const char **argv);
+
 int
 cli_cmd_probe(int argc, const char **argv);
 
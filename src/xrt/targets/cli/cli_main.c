@@ -34,6 +34,9 @@ cli_print_help(int argc, const char **argv)
 	P("  calibrate  - Calibrate a camera and save config (not implemented yet).\n");
 	P("  calib-dumb - Load and dump a calibration to stdout.\n");
 	P("  slambatch  - Runs a sequence of EuRoC datasets with the SLAM tracker.\n");
+	P("  handbatch  - Benchmarks Mercury hand tracking on a EuRoC dataset.\n");
+	P("  euroc-conv - Converts raw EuRoC recordings to png images.\n");
+	P("  pacing     - Summarizes the frame pacing in a metrics file.\n");
 
 	return 1;
 }
@@ -68,5 +71,14 @@ main(int argc, const char **argv)
 	if (strcmp(argv[1], "slambatch") == 0) {
 		return cli_cmd_slambatch(argc, argv);
 	}
+	if (strcmp(argv[1], "handbatch") == 0) {
+		return cli_cmd_handbatch(argc, argv);
+	}
+	if (strcmp(argv[1], "euroc-conv") == 0) {
+		return cli_cmd_euroc_convert(argc, argv);
+	}
+	if (strcmp(argv[1], "pacing") == 0) {
+		return cli_cmd_pacing(argc, argv);
+	}
 	return cli_print_help(argc, argv);
 }
@@ -284,6 +284,10 @@ ns_setup_depthai_device(struct ns_builder *nsb,
 	settings.half_size_ov9282 = true;
 	settings.want_cameras = true;
 	settings.want_imu = true;
+#ifdef XRT_BUILD_DRIVER_HANDTRACKING
+	// The model is run on the images as they come off the camera, so upside down it would see upside down hands.
+	settings.want_hand_detection = !nsb->depthai_device.upside_down;
+#endif
 
 	struct xrt_fs *the_fs = depthai_fs_slam(xfctx, &settings);
 
@@ -323,7 +327,11 @@ ns_setup_depthai_device(struct ns_builder *nsb,
 	extra_camera_info.views[0].boundary_type = HT_IMAGE_BOUNDARY_NONE;
 	extra_camera_info.views[1].boundary_type = HT_IMAGE_BOUNDARY_NONE;
 
-	struct t_hand_tracking_create_info create_info = {.cams_info = extra_camera_info, .masks_sink = masks_sink};
+	struct t_hand_tracking_create_info create_info = {
+	    .cams_info = extra_camera_info,
+	    .masks_sink = masks_sink,
+	    .detections = depthai_fs_get_hand_detection_source(the_fs),
+	};
 
 	int create_status = ht_device_create( //
 	    xfctx,                            //
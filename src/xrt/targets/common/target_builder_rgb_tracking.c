@@ -151,6 +151,12 @@ setup_pipeline(struct xrt_prober *xp, struct build_state *build)
 	struct t_hsv_filter_params params = T_HSV_DEFAULT_PARAMS();
 	t_hsv_filter_create(build->xfctx, &params, xsinks, &xsink);
 
+#if defined(XRT_HAVE_OPENCV) && defined(XRT_BUILD_DRIVER_PSMV)
+	// Only classify the parts of the frames around the controllers.
+	t_psmv_set_hsv_filter(build->psmv_red, xsink, 0);
+	t_psmv_set_hsv_filter(build->psmv_purple, xsink, 1);
+#endif
+
 	// The filter only supports yuv or yuyv formats.
 	u_sink_create_to_yuv_or_yuyv(build->xfctx, xsink, &xsink);
 
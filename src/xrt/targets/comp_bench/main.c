@@ -0,0 +1,1015 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Headless benchmark of the compositor render paths.
+ *
+ * Renders synthetic layers through the same dispatch helpers as the main
+ * compositor, @ref comp_render_gfx_dispatch and @ref comp_render_cs_dispatch,
+ * into an offscreen target and reports CPU and GPU time per frame. No window,
+ * display or client is needed so it can run on CI machines.
+ *
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup comp_util
+ */
+
+#include "xrt/xrt_device.h"
+
+#include "os/os_time.h"
+
+#include "math/m_mathinclude.h"
+
+#include "util/u_misc.h"
+#include "util/u_time.h"
+#include "util/u_device.h"
+#include "util/u_histogram.h"
+#include "util/u_string_list.h"
+#include "util/u_distortion_mesh.h"
+
+#include "vk/vk_cmd.h"
+#include "vk/vk_helpers.h"
+#include "vk/vk_mini_helpers.h"
+
+#include "render/render_interface.h"
+
+#include "util/comp_base.h"
+#include "util/comp_render.h"
+#include "util/comp_vulkan.h"
+#include "util/comp_swapchain.h"
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define P(...) fprintf(stdout, __VA_ARGS__)
+#define PE(...) fprintf(stderr, __VA_ARGS__)
+
+#define MAX_LAYERS XRT_MAX_LAYERS
+
+//! Images per synthetic swapchain, like a client would have.
+#define SWAPCHAIN_IMAGE_COUNT 3
+
+//! Format of the offscreen target, must support storage for the compute path.
+#define TARGET_FORMAT VK_FORMAT_R8G8B8A8_UNORM
+
+
+/*
+ *
+ * Structs
+ *
+ */
+
+enum bench_distortion
+{
+	BENCH_DISTORTION_NONE,
+	BENCH_DISTORTION_PANOTOOLS,
+};
+
+/*!
+ * What to render, filled in from the command line.
+ */
+struct bench_args
+{
+	uint32_t frames;
+	uint32_t warmup;
+	uint32_t view_count;
+	uint32_t width;
+	uint32_t height;
+	uint32_t projection_count;
+	uint32_t quad_count;
+	enum bench_distortion distortion;
+	bool compute;
+	bool timewarp;
+};
+
+/*!
+ * Fake HMD, only used to feed the distortion into the render resources.
+ */
+struct bench_device
+{
+	struct xrt_device base;
+
+	struct u_panotools_values vals;
+};
+
+/*!
+ * Everything needed to render, a much cut down main compositor.
+ */
+struct bench
+{
+	struct bench_args args;
+
+	struct vk_bundle vk;
+	struct comp_swapchain_shared cscs;
+
+	struct xrt_device *xdev;
+
+	struct render_shaders shaders;
+	struct render_resources r;
+
+	//! Shared by all projection layers, one per view.
+	struct xrt_swapchain *proj_xscs[XRT_MAX_VIEWS];
+
+	//! Shared by all quad layers.
+	struct xrt_swapchain *quad_xsc;
+
+	struct comp_layer layers[MAX_LAYERS];
+	uint32_t layer_count;
+
+	struct xrt_fov fovs[XRT_MAX_VIEWS];
+	struct xrt_pose eye_poses[XRT_MAX_VIEWS];
+
+	struct render_scratch_images scratch;
+	struct render_gfx_render_pass scratch_rgrp;
+	struct render_gfx_target_resources scratch_rtrs[XRT_MAX_VIEWS];
+
+	struct
+	{
+		VkExtent2D extent;
+		VkDeviceMemory mem;
+		VkImage image;
+		VkImageView view;
+
+		struct render_gfx_render_pass rgrp;
+		struct render_gfx_target_resources rtr;
+	} target;
+
+	VkFence fence;
+
+	struct u_hist_ns *cpu_hist;
+	struct u_hist_ns *gpu_hist;
+	uint32_t gpu_missing;
+};
+
+
+/*
+ *
+ * Device.
+ *
+ */
+
+static inline struct bench_device *
+bench_device(struct xrt_device *xdev)
+{
+	return (struct bench_device *)xdev;
+}
+
+static void
+bench_device_get_tracked_pose(struct xrt_device *xdev,
+                              enum xrt_input_name name,
+                              uint64_t at_timestamp_ns,
+                              struct xrt_space_relation *out_relation)
+{
+	*out_relation = (struct xrt_space_relation)XRT_SPACE_RELATION_ZERO;
+	out_relation->pose = (struct xrt_pose)XRT_POSE_IDENTITY;
+	out_relation->relation_flags = XRT_SPACE_RELATION_BITMASK_ALL;
+}
+
+static bool
+bench_device_compute_distortion(
+    struct xrt_device *xdev, uint32_t view, float u, float v, struct xrt_uv_triplet *out_result)
+{
+	return u_compute_distortion_panotools(&bench_device(xdev)->vals, u, v, out_result);
+}
+
+static void
+bench_device_destroy(struct xrt_device *xdev)
+{
+	u_device_free(xdev);
+}
+
+static struct xrt_device *
+bench_device_create(const struct bench_args *args)
+{
+	enum u_device_alloc_flags flags =
+	    (enum u_device_alloc_flags)(U_DEVICE_ALLOC_HMD | U_DEVICE_ALLOC_TRACKING_NONE);
+	struct bench_device *bd = U_DEVICE_ALLOCATE(struct bench_device, flags, 1, 0);
+	bd->base.update_inputs = u_device_noop_update_inputs;
+	bd->base.get_tracked_pose = bench_device_get_tracked_pose;
+	bd->base.get_view_poses = u_device_get_view_poses;
+	bd->base.destroy = bench_device_destroy;
+	bd->base.name = XRT_DEVICE_GENERIC_HMD;
+	bd->base.device_type = XRT_DEVICE_TYPE_HMD;
+	bd->base.inputs[0].name = XRT_INPUT_GENERIC_HEAD_POSE;
+	bd->base.hmd->view_count = args->view_count;
+
+	snprintf(bd->base.str, XRT_DEVICE_NAME_LEN, "Compositor Bench HMD");
+	snprintf(bd->base.serial, XRT_DEVICE_NAME_LEN, "Compositor Bench HMD");
+
+	// Made up panel, only the pixel size matters.
+	struct u_device_simple_info info;
+	info.display.w_pixels = args->width * args->view_count;
+	info.display.h_pixels = args->height;
+	info.display.w_meters = 0.13f;
+	info.display.h_meters = 0.07f;
+	info.lens_horizontal_separation_meters = 0.13f / 2.0f;
+	info.lens_vertical_position_meters = 0.07f / 2.0f;
+
+	bool ret;
+	if (args->view_count == 1) {
+		info.fov[0] = 120.0f * (M_PI / 180.0f);
+		ret = u_device_setup_one_eye(&bd->base, &info);
+	} else {
+		info.fov[0] = 100.0f * (M_PI / 180.0f);
+		info.fov[1] = 100.0f * (M_PI / 180.0f);
+		ret = u_device_setup_split_side_by_side(&bd->base, &info);
+	}
+	if (!ret) {
+		PE("Failed to setup basic device info\n");
+		bench_device_destroy(&bd->base);
+		return NULL;
+	}
+
+	if (args->distortion == BENCH_DISTORTION_NONE) {
+		u_distortion_mesh_set_none(&bd->base);
+		return &bd->base;
+	}
+
+	// Values from the PS VR, a fairly strong distortion.
+	float w = (float)args->width;
+	float h = (float)args->height;
+	bd->vals.distortion_k[0] = 0.75f;
+	bd->vals.distortion_k[1] = -0.01f;
+	bd->vals.distortion_k[2] = 0.75f;
+	bd->vals.distortion_k[3] = 0.0f;
+	bd->vals.distortion_k[4] = 3.8f;
+	bd->vals.aberration_k[0] = 0.999f;
+	bd->vals.aberration_k[1] = 1.008f;
+	bd->vals.aberration_k[2] = 1.018f;
+	bd->vals.scale = 1.2f * w;
+	bd->vals.viewport_size.x = w;
+	bd->vals.viewport_size.y = h;
+	bd->vals.lens_center.x = w / 2.0f;
+	bd->vals.lens_center.y = h / 2.0f;
+
+	bd->base.compute_distortion = bench_device_compute_distortion;
+	bd->base.hmd->distortion.models = XRT_DISTORTION_MODEL_COMPUTE;
+	bd->base.hmd->distortion.preferred = XRT_DISTORTION_MODEL_COMPUTE;
+
+	// The graphics path needs the mesh.
+	u_distortion_mesh_fill_in_compute(&bd->base);
+
+	return &bd->base;
+}
+
+
+/*
+ *
+ * Vulkan.
+ *
+ */
+
+static const char *instance_extensions[] = {
+    VK_KHR_EXTERNAL_FENCE_CAPABILITIES_EXTENSION_NAME,      //
+    VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME,     //
+    VK_KHR_EXTERNAL_SEMAPHORE_CAPABILITIES_EXTENSION_NAME,  //
+    VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, //
+};
+
+// Same as the null compositor, the swapchains are created exportable.
+static const char *required_device_extensions[] = {
+    VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME,      //
+    VK_KHR_EXTERNAL_FENCE_EXTENSION_NAME,            //
+    VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME,           //
+    VK_KHR_EXTERNAL_SEMAPHORE_EXTENSION_NAME,        //
+    VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME, //
+
+// Platform version of "external_memory"
+#if defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_FD)
+    VK_KHR_EXTERNAL_MEMORY_FD_EXTENSION_NAME,
+
+#elif defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_AHARDWAREBUFFER)
+    VK_ANDROID_EXTERNAL_MEMORY_ANDROID_HARDWARE_BUFFER_EXTENSION_NAME,
+
+#elif defined(XRT_GRAPHICS_BUFFER_HANDLE_IS_WIN32_HANDLE)
+    VK_KHR_EXTERNAL_MEMORY_WIN32_EXTENSION_NAME,
+
+#else
+#error "Need port!"
+#endif
+};
+
+static const char *optional_device_extensions[] = {
+#ifdef VK_KHR_image_format_list
+    VK_KHR_IMAGE_FORMAT_LIST_EXTENSION_NAME,
+#endif
+#ifdef VK_KHR_maintenance1
+    VK_KHR_MAINTENANCE_1_EXTENSION_NAME,
+#endif
+#ifdef VK_KHR_maintenance2
+    VK_KHR_MAINTENANCE_2_EXTENSION_NAME,
+#endif
+#ifdef VK_KHR_timeline_semaphore
+    VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME,
+#endif
+#ifdef VK_EXT_calibrated_timestamps
+    VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME,
+#endif
+#ifdef VK_EXT_robustness2
+    VK_EXT_ROBUSTNESS_2_EXTENSION_NAME,
+#endif
+};
+
+static bool
+init_vulkan(struct bench *b)
+{
+	struct vk_bundle *vk = &b->vk;
+
+	struct u_string_list *required_instance_ext_list =
+	    u_string_list_create_from_array(instance_extensions, ARRAY_SIZE(instance_extensions));
+	struct u_string_list *optional_instance_ext_list = u_string_list_create();
+	struct u_string_list *required_device_extension_list =
+	    u_string_list_create_from_array(required_device_extensions, ARRAY_SIZE(required_device_extensions));
+	struct u_string_list *optional_device_extension_list =
+	    u_string_list_create_from_array(optional_device_extensions, ARRAY_SIZE(optional_device_extensions));
+
+	struct comp_vulkan_arguments vk_args = {
+	    .get_instance_proc_address = vkGetInstanceProcAddr,
+	    .required_instance_version = VK_MAKE_VERSION(1, 0, 0),
+	    .required_instance_extensions = required_instance_ext_list,
+	    .optional_instance_extensions = optional_instance_ext_list,
+	    .required_device_extensions = required_device_extension_list,
+	    .optional_device_extensions = optional_device_extension_list,
+	    .log_level = U_LOGGING_WARN,
+	    .only_compute_queue = false, // Need both.
+	    .selected_gpu_index = -1,    // Auto
+	    .client_gpu_index = -1,      // Auto
+	    .timeline_semaphore = false, // Not importing any.
+	};
+
+	struct comp_vulkan_results vk_res = {0};
+	bool bret = comp_vulkan_init_bundle(vk, &vk_args, &vk_res);
+
+	u_string_list_destroy(&required_instance_ext_list);
+	u_string_list_destroy(&optional_instance_ext_list);
+	u_string_list_destroy(&required_device_extension_list);
+	u_string_list_destroy(&optional_device_extension_list);
+
+	if (!bret) {
+		PE("Failed to init Vulkan\n");
+		return false;
+	}
+
+	if (comp_swapchain_shared_init(&b->cscs, vk) != XRT_SUCCESS) {
+		PE("comp_swapchain_shared_init failed\n");
+		return false;
+	}
+
+	VkFenceCreateInfo fence_info = {
+	    .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+	};
+
+	VkResult ret = vk->vkCreateFence(vk->device, &fence_info, NULL, &b->fence);
+	if (ret != VK_SUCCESS) {
+		PE("vkCreateFence: %s\n", vk_result_string(ret));
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+ *
+ * Setup.
+ *
+ */
+
+static bool
+init_render(struct bench *b)
+{
+	struct vk_bundle *vk = &b->vk;
+
+	if (!render_shaders_load(&b->shaders, vk)) {
+		PE("render_shaders_load failed\n");
+		return false;
+	}
+
+	if (!render_resources_init(&b->r, &b->shaders, vk, b->xdev)) {
+		PE("render_resources_init failed\n");
+		return false;
+	}
+
+	if (!render_distortion_images_ensure(&b->r, vk, b->xdev, false)) {
+		PE("render_distortion_images_ensure failed\n");
+		return false;
+	}
+
+	VkExtent2D scratch_extent = {.width = b->args.width, .height = b->args.height};
+	if (!render_scratch_images_ensure(&b->r, &b->scratch, scratch_extent)) {
+		PE("render_scratch_images_ensure failed\n");
+		return false;
+	}
+
+	// Same setup as the main renderer.
+	render_gfx_render_pass_init(                   //
+	    &b->scratch_rgrp,                          // rgrp
+	    &b->r,                                     // r
+	    VK_FORMAT_R8G8B8A8_SRGB,                   // format
+	    VK_ATTACHMENT_LOAD_OP_CLEAR,               // load_op
+	    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL); // final_layout
+
+	for (uint32_t i = 0; i < b->args.view_count; i++) {
+		render_gfx_target_resources_init(  //
+		    &b->scratch_rtrs[i],           //
+		    &b->r,                         //
+		    &b->scratch_rgrp,              //
+		    b->scratch.color[i].srgb_view, //
+		    scratch_extent);               //
+	}
+
+	return true;
+}
+
+static bool
+init_target(struct bench *b)
+{
+	struct vk_bundle *vk = &b->vk;
+	VkResult ret;
+
+	// All views side by side, like a real display.
+	b->target.extent.width = b->args.width * b->args.view_count;
+	b->target.extent.height = b->args.height;
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+
+	ret = vk_create_image_simple( //
+	    vk,                       // vk_bundle
+	    b->target.extent,         // extent
+	    TARGET_FORMAT,            // format
+	    usage,                    // usage
+	    &b->target.mem,           // out_mem
+	    &b->target.image);        // out_image
+	if (ret != VK_SUCCESS) {
+		PE("vk_create_image_simple: %s\n", vk_result_string(ret));
+		return false;
+	}
+
+	VkImageSubresourceRange subresource_range = {
+	    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+	    .baseMipLevel = 0,
+	    .levelCount = 1,
+	    .baseArrayLayer = 0,
+	    .layerCount = 1,
+	};
+
+	ret = vk_create_view(        //
+	    vk,                      // vk_bundle
+	    b->target.image,         // image
+	    VK_IMAGE_VIEW_TYPE_2D,   // type
+	    TARGET_FORMAT,           // format
+	    subresource_range,       // subresource_range
+	    &b->target.view);        // out_view
+	if (ret != VK_SUCCESS) {
+		PE("vk_create_view: %s\n", vk_result_string(ret));
+		return false;
+	}
+
+	render_gfx_render_pass_init(                   //
+	    &b->target.rgrp,                           // rgrp
+	    &b->r,                                     // r
+	    TARGET_FORMAT,                             // format
+	    VK_ATTACHMENT_LOAD_OP_CLEAR,               // load_op
+	    VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL); // final_layout
+
+	render_gfx_target_resources_init( //
+	    &b->target.rtr,               //
+	    &b->r,                        //
+	    &b->target.rgrp,              //
+	    b->target.view,               //
+	    b->target.extent);            //
+
+	return true;
+}
+
+static bool
+create_swapchain(struct bench *b, struct xrt_swapchain **out_xsc)
+{
+	struct xrt_swapchain_create_info info = {
+	    .bits = XRT_SWAPCHAIN_USAGE_COLOR | XRT_SWAPCHAIN_USAGE_SAMPLED,
+	    .format = VK_FORMAT_R8G8B8A8_SRGB,
+	    .sample_count = 1,
+	    .width = b->args.width,
+	    .height = b->args.height,
+	    .face_count = 1,
+	    .array_size = 1,
+	    .mip_count = 1,
+	};
+
+	struct xrt_swapchain_create_properties xsccp = {
+	    .image_count = SWAPCHAIN_IMAGE_COUNT,
+	};
+
+	xrt_result_t xret = comp_swapchain_create(&b->vk, &b->cscs, &info, &xsccp, out_xsc);
+	if (xret != XRT_SUCCESS) {
+		PE("comp_swapchain_create: %i\n", xret);
+		return false;
+	}
+
+	return true;
+}
+
+static void
+fill_layer_common(struct bench *b, struct comp_layer *layer, enum xrt_layer_type type)
+{
+	U_ZERO(layer);
+
+	layer->data.type = type;
+	layer->data.name = XRT_INPUT_GENERIC_HEAD_POSE;
+	layer->data.view_count = b->args.view_count;
+	layer->data.color_scale = (struct xrt_colour_rgba_f32){1.0f, 1.0f, 1.0f, 1.0f};
+
+	// Anything but the bottom layer has to be blended.
+	if (b->layer_count > 0) {
+		layer->data.flags = XRT_LAYER_COMPOSITION_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
+	}
+}
+
+static void
+fill_sub_image(struct bench *b, struct xrt_sub_image *sub)
+{
+	sub->rect.extent.w = (int)b->args.width;
+	sub->rect.extent.h = (int)b->args.height;
+	sub->norm_rect = (struct xrt_normalized_rect){.x = 0.0f, .y = 0.0f, .w = 1.0f, .h = 1.0f};
+}
+
+static bool
+init_layers(struct bench *b)
+{
+	struct xrt_vec3 default_eye_relation = {0.063f, 0.0f, 0.0f};
+	struct xrt_space_relation head_relation = XRT_SPACE_RELATION_ZERO;
+
+	xrt_device_get_view_poses( //
+	    b->xdev,               // xdev
+	    &default_eye_relation, // default_eye_relation
+	    os_monotonic_get_ns(), // at_timestamp_ns
+	    b->args.view_count,    // view_count
+	    &head_relation,        // out_head_relation
+	    b->fovs,               // out_fovs
+	    b->eye_poses);         // out_poses
+
+	if (b->args.projection_count > 0) {
+		for (uint32_t i = 0; i < b->args.view_count; i++) {
+			if (!create_swapchain(b, &b->proj_xscs[i])) {
+				return false;
+			}
+		}
+	}
+
+	if (b->args.quad_count > 0 && !create_swapchain(b, &b->quad_xsc)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < b->args.projection_count; i++) {
+		struct comp_layer *layer = &b->layers[b->layer_count];
+		fill_layer_common(b, layer, XRT_LAYER_PROJECTION);
+
+		for (uint32_t k = 0; k < b->args.view_count; k++) {
+			layer->sc_array[k] = comp_swapchain(b->proj_xscs[k]);
+			layer->data.proj.v[k].fov = b->fovs[k];
+			layer->data.proj.v[k].pose = b->eye_poses[k];
+			fill_sub_image(b, &layer->data.proj.v[k].sub);
+		}
+
+		b->layer_count++;
+	}
+
+	for (uint32_t i = 0; i < b->args.quad_count; i++) {
+		struct comp_layer *layer = &b->layers[b->layer_count];
+		fill_layer_common(b, layer, XRT_LAYER_QUAD);
+
+		// Spread them out a bit so they don't all cover the same pixels.
+		float x = ((float)i - (float)(b->args.quad_count - 1) / 2.0f) * 0.25f;
+
+		layer->sc_array[0] = comp_swapchain(b->quad_xsc);
+		layer->data.quad.visibility = XRT_LAYER_EYE_VISIBILITY_BOTH;
+		layer->data.quad.pose = (struct xrt_pose){XRT_QUAT_IDENTITY, {x, 0.0f, -1.5f}};
+		layer->data.quad.size = (struct xrt_vec2){0.5f, 0.5f};
+		fill_sub_image(b, &layer->data.quad.sub);
+
+		b->layer_count++;
+	}
+
+	return true;
+}
+
+
+/*
+ *
+ * Rendering.
+ *
+ */
+
+static void
+calc_view_data(struct bench *b,
+               struct render_viewport_data target_viewport_datas[XRT_MAX_VIEWS],
+               struct render_viewport_data *out_layer_viewport_data,
+               struct xrt_normalized_rect *out_layer_norm_rect)
+{
+	for (uint32_t i = 0; i < b->args.view_count; i++) {
+		target_viewport_datas[i] = (struct render_viewport_data){
+		    .x = i * b->args.width,
+		    .y = 0,
+		    .w = b->args.width,
+		    .h = b->args.height,
+		};
+	}
+
+	// Scratch images covers the whole image.
+	*out_layer_viewport_data = (struct render_viewport_data){
+	    .x = 0,
+	    .y = 0,
+	    .w = b->args.width,
+	    .h = b->args.height,
+	};
+	*out_layer_norm_rect = (struct xrt_normalized_rect){.x = 0.0f, .y = 0.0f, .w = 1.0f, .h = 1.0f};
+}
+
+static bool
+is_fast_path(struct bench *b)
+{
+	return b->layer_count == 1 && b->layers[0].data.type == XRT_LAYER_PROJECTION;
+}
+
+static void
+record_gfx(struct bench *b, struct render_gfx *rr)
+{
+	struct render_viewport_data target_viewport_datas[XRT_MAX_VIEWS];
+	struct render_viewport_data layer_viewport_data;
+	struct xrt_normalized_rect layer_norm_rect;
+	calc_view_data(b, target_viewport_datas, &layer_viewport_data, &layer_norm_rect);
+
+	struct comp_render_dispatch_data data;
+	comp_render_gfx_initial_init( //
+	    &data,                    // data
+	    &b->target.rtr,           // rtr
+	    is_fast_path(b),          // fast_path
+	    b->args.timewarp);        // do_timewarp
+
+	for (uint32_t i = 0; i < b->args.view_count; i++) {
+		comp_render_gfx_add_view(           //
+		    &data,                          // data
+		    &b->eye_poses[i],               // world_pose
+		    &b->eye_poses[i],               // eye_pose
+		    &b->fovs[i],                    // fov
+		    &b->scratch_rtrs[i],            // rtr
+		    &layer_viewport_data,           // layer_viewport_data
+		    &layer_norm_rect,               // layer_norm_rect
+		    b->scratch.color[i].image,      // image
+		    b->scratch.color[i].srgb_view,  // srgb_view
+		    &b->xdev->hmd->views[i].rot,    // vertex_rot
+		    &target_viewport_datas[i]);     // target_viewport_data
+	}
+
+	render_gfx_begin(rr);
+
+	comp_render_gfx_dispatch( //
+	    rr,                   // rr
+	    b->layers,            // layers
+	    b->layer_count,       // layer_count
+	    &data);               // d
+
+	render_gfx_end(rr);
+}
+
+static void
+record_compute(struct bench *b, struct render_compute *crc)
+{
+	struct render_viewport_data target_viewport_datas[XRT_MAX_VIEWS];
+	struct render_viewport_data layer_viewport_data;
+	struct xrt_normalized_rect layer_norm_rect;
+	calc_view_data(b, target_viewport_datas, &layer_viewport_data, &layer_norm_rect);
+
+	struct comp_render_dispatch_data data;
+	comp_render_cs_initial_init( //
+	    &data,                   // data
+	    b->target.image,         // target_image
+	    b->target.view,          // target_unorm_view
+	    is_fast_path(b),         // fast_path
+	    b->args.timewarp);       // do_timewarp
+
+	for (uint32_t i = 0; i < b->args.view_count; i++) {
+		comp_render_cs_add_view(            //
+		    &data,                          // data
+		    &b->eye_poses[i],               // world_pose
+		    &b->eye_poses[i],               // eye_pose
+		    &b->fovs[i],                    // fov
+		    &layer_viewport_data,           // layer_viewport_data
+		    &layer_norm_rect,               // layer_norm_rect
+		    b->scratch.color[i].image,      // image
+		    b->scratch.color[i].srgb_view,  // srgb_view
+		    b->scratch.color[i].unorm_view, // unorm_view
+		    &target_viewport_datas[i]);     // target_viewport_data
+	}
+
+	render_compute_begin(crc);
+
+	comp_render_cs_dispatch( //
+	    crc,                 // crc
+	    b->layers,           // layers
+	    b->layer_count,      // layer_count
+	    &data);              // d
+
+	render_compute_end(crc);
+}
+
+static bool
+submit_and_wait(struct bench *b)
+{
+	struct vk_bundle *vk = &b->vk;
+	VkResult ret;
+
+	VkSubmitInfo submit_info = {
+	    .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+	    .commandBufferCount = 1,
+	    .pCommandBuffers = &b->r.cmd,
+	};
+
+	// Only this thread uses the pool.
+	ret = vk_cmd_submit_locked(vk, 1, &submit_info, b->fence);
+	if (ret != VK_SUCCESS) {
+		PE("vk_cmd_submit_locked: %s\n", vk_result_string(ret));
+		return false;
+	}
+
+	ret = vk->vkWaitForFences(vk->device, 1, &b->fence, VK_TRUE, UINT64_MAX);
+	if (ret != VK_SUCCESS) {
+		PE("vkWaitForFences: %s\n", vk_result_string(ret));
+		return false;
+	}
+
+	ret = vk->vkResetFences(vk->device, 1, &b->fence);
+	if (ret != VK_SUCCESS) {
+		PE("vkResetFences: %s\n", vk_result_string(ret));
+		return false;
+	}
+
+	return true;
+}
+
+/*!
+ * CPU time covers recording and submitting, not waiting for the GPU.
+ */
+static bool
+run_frame(struct bench *b, uint64_t *out_cpu_ns)
+{
+	uint64_t start_ns = os_monotonic_get_ns();
+
+	struct render_compute crc;
+	struct render_gfx rr;
+	if (b->args.compute) {
+		render_compute_init(&crc, &b->r);
+		record_compute(b, &crc);
+	} else {
+		render_gfx_init(&rr, &b->r);
+		record_gfx(b, &rr);
+	}
+
+	bool bret = submit_and_wait(b);
+	*out_cpu_ns = os_monotonic_get_ns() - start_ns;
+
+	// The descriptors must outlive the GPU work.
+	if (b->args.compute) {
+		render_compute_close(&crc);
+	} else {
+		render_gfx_close(&rr);
+	}
+
+	return bret;
+}
+
+static bool
+run(struct bench *b)
+{
+	for (uint32_t i = 0; i < b->args.warmup + b->args.frames; i++) {
+		uint64_t cpu_ns = 0;
+		if (!run_frame(b, &cpu_ns)) {
+			return false;
+		}
+
+		// Pipelines and caches are created on the first frames.
+		if (i < b->args.warmup) {
+			continue;
+		}
+
+		u_hist_ns_add(b->cpu_hist, cpu_ns);
+
+		uint64_t gpu_ns = 0;
+		if (render_resources_get_duration(&b->r, &gpu_ns)) {
+			u_hist_ns_add(b->gpu_hist, gpu_ns);
+		} else {
+			b->gpu_missing++;
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ *
+ * Reporting.
+ *
+ */
+
+static void
+print_stats_row(const char *name, struct u_hist_ns *hist)
+{
+	struct u_hist_ns_snapshot snapshot;
+	u_hist_ns_get_snapshot(hist, &snapshot);
+
+	struct u_hist_ns_stats stats;
+	u_hist_ns_snapshot_get_stats(&snapshot, &stats);
+
+	double us = (double)U_TIME_1MS_IN_NS / 1000.0;
+	P("%-8s %10" PRIu64 " %12.2f %12.2f %12.2f %12.2f %12.2f\n", name, stats.count, (double)stats.mean / us,
+	  (double)stats.p50 / us, (double)stats.p90 / us, (double)stats.p99 / us, (double)stats.worst / us);
+}
+
+static void
+print_report(struct bench *b)
+{
+	const struct bench_args *args = &b->args;
+
+	P("%s path, %u view(s) of %ux%u, %u projection and %u quad layer(s), %s distortion, timewarp %s%s\n",
+	  args->compute ? "Compute" : "Graphics", args->view_count, args->width, args->height, args->projection_count,
+	  args->quad_count, args->distortion == BENCH_DISTORTION_NONE ? "no" : "panotools",
+	  args->timewarp ? "on" : "off", is_fast_path(b) ? ", fast path" : "");
+
+	P("%-8s %10s %12s %12s %12s %12s %12s\n", "Time", "Frames", "Mean (us)", "p50 (us)", "p90 (us)", "p99 (us)",
+	  "Max (us)");
+	print_stats_row("CPU", b->cpu_hist);
+	print_stats_row("GPU", b->gpu_hist);
+
+	if (b->gpu_missing > 0) {
+		P("\nNo GPU timestamps for %u frame(s).\n", b->gpu_missing);
+	}
+}
+
+
+/*
+ *
+ * Teardown.
+ *
+ */
+
+static void
+bench_fini(struct bench *b)
+{
+	struct vk_bundle *vk = &b->vk;
+
+	if (vk->device != VK_NULL_HANDLE) {
+		vk->vkDeviceWaitIdle(vk->device);
+
+		for (uint32_t i = 0; i < XRT_MAX_VIEWS; i++) {
+			xrt_swapchain_reference(&b->proj_xscs[i], NULL);
+		}
+		xrt_swapchain_reference(&b->quad_xsc, NULL);
+
+		// Only close what got initialised, setup may have failed half way.
+		if (b->target.rtr.r != NULL) {
+			render_gfx_target_resources_close(&b->target.rtr);
+		}
+		if (b->target.rgrp.r != NULL) {
+			render_gfx_render_pass_close(&b->target.rgrp);
+		}
+		for (uint32_t i = 0; i < b->args.view_count; i++) {
+			if (b->scratch_rtrs[i].r != NULL) {
+				render_gfx_target_resources_close(&b->scratch_rtrs[i]);
+			}
+		}
+		if (b->scratch_rgrp.r != NULL) {
+			render_gfx_render_pass_close(&b->scratch_rgrp);
+		}
+		if (b->r.vk != NULL) {
+			render_scratch_images_close(&b->r, &b->scratch);
+			render_resources_close(&b->r);
+		}
+		render_shaders_close(&b->shaders, vk);
+
+		D(ImageView, b->target.view);
+		D(Image, b->target.image);
+		DF(Memory, b->target.mem);
+		D(Fence, b->fence);
+
+		comp_swapchain_shared_garbage_collect(&b->cscs);
+		comp_swapchain_shared_destroy(&b->cscs, vk);
+
+		vk->vkDestroyDevice(vk->device, NULL);
+		vk->device = VK_NULL_HANDLE;
+	}
+
+	vk_deinit_mutex(vk);
+
+	if (vk->instance != VK_NULL_HANDLE) {
+		vk->vkDestroyInstance(vk->instance, NULL);
+		vk->instance = VK_NULL_HANDLE;
+	}
+
+	xrt_device_destroy(&b->xdev);
+
+	u_hist_ns_destroy(&b->cpu_hist);
+	u_hist_ns_destroy(&b->gpu_hist);
+}
+
+
+/*
+ *
+ * Main.
+ *
+ */
+
+static void
+print_usage(void)
+{
+	PE("Usage: monado-comp-bench [options]\n");
+	PE("    -n <count>: Number of frames to measure (default 1000)\n");
+	PE("    -w <count>: Number of frames to render before measuring (default 50)\n");
+	PE("    -v <count>: Number of views, 1 or 2 (default 2)\n");
+	PE("    -s <w>x<h>: Size of each view and of the layer images (default 1920x1920)\n");
+	PE("    -p <count>: Number of projection layers (default 1)\n");
+	PE("    -q <count>: Number of quad layers (default 0)\n");
+	PE("    -d <mode>:  Distortion, 'none' or 'panotools' (default panotools)\n");
+	PE("    -c:         Use the compute path instead of the graphics path\n");
+	PE("    -t:         Disable timewarp\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct bench_args args = {
+	    .frames = 1000,
+	    .warmup = 50,
+	    .view_count = 2,
+	    .width = 1920,
+	    .height = 1920,
+	    .projection_count = 1,
+	    .quad_count = 0,
+	    .distortion = BENCH_DISTORTION_PANOTOOLS,
+	    .compute = false,
+	    .timewarp = true,
+	};
+
+	int c;
+	while ((c = getopt(argc, argv, "n:w:v:s:p:q:d:cth")) != -1) {
+		switch (c) {
+		case 'n': args.frames = (uint32_t)atoi(optarg); break;
+		case 'w': args.warmup = (uint32_t)atoi(optarg); break;
+		case 'v': args.view_count = (uint32_t)atoi(optarg); break;
+		case 'p': args.projection_count = (uint32_t)atoi(optarg); break;
+		case 'q': args.quad_count = (uint32_t)atoi(optarg); break;
+		case 'c': args.compute = true; break;
+		case 't': args.timewarp = false; break;
+		case 's':
+			if (sscanf(optarg, "%ux%u", &args.width, &args.height) != 2) {
+				print_usage();
+				return 1;
+			}
+			break;
+		case 'd':
+			if (strcmp(optarg, "none") == 0) {
+				args.distortion = BENCH_DISTORTION_NONE;
+			} else if (strcmp(optarg, "panotools") == 0) {
+				args.distortion = BENCH_DISTORTION_PANOTOOLS;
+			} else {
+				print_usage();
+				return 1;
+			}
+			break;
+		case 'h': print_usage(); return 0;
+		default: print_usage(); return 1;
+		}
+	}
+
+	// The device helpers only know how to setup one or two views.
+	if (optind != argc || args.frames == 0 || args.view_count < 1 || args.view_count > 2 || args.width == 0 ||
+	    args.height == 0 || args.projection_count + args.quad_count > MAX_LAYERS) {
+		print_usage();
+		return 1;
+	}
+
+	struct bench *b = U_TYPED_CALLOC(struct bench);
+	b->args = args;
+	b->cpu_hist = u_hist_ns_create();
+	b->gpu_hist = u_hist_ns_create();
+
+	int ret = 1;
+	b->xdev = bench_device_create(&args);
+	if (b->xdev != NULL &&  //
+	    init_vulkan(b) &&   //
+	    init_render(b) &&   //
+	    init_target(b) &&   //
+	    init_layers(b) &&   //
+	    run(b)) {
+		print_report(b);
+		ret = 0;
+	}
+
+	bench_fini(b);
+	free(b);
+
+	return ret;
+}
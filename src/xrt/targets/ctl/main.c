@@ -7,7 +7,10 @@
  * @ingroup ipc
  */
 
+#include "os/os_time.h"
+
 #include "util/u_file.h"
+#include "util/u_time.h"
 
 #include "client/ipc_client.h"
 #include "client/ipc_client_connection.h"
@@ -15,6 +18,8 @@
 #include "ipc_client_generated.h"
 
 #include <ctype.h>
+#include <string.h>
+#include <inttypes.h>
 
 
 #define P(...) fprintf(stdout, __VA_ARGS__)
@@ -27,32 +32,37 @@ typedef enum op_mode
 	MODE_SET_FOCUSED,
 	MODE_TOGGLE_IO,
 	MODE_RECENTER,
+	MODE_STATS,
+	MODE_DUMP_TRACE,
+	MODE_STARTUP_TIMELINE,
+	MODE_TOP,
 } op_mode_t;
 
+//! How often the top view is refreshed.
+#define TOP_INTERVAL_NS (U_TIME_1S_IN_NS)
+
+//! Number of IPC commands shown in the top view, busiest first.
+#define TOP_COMMAND_COUNT (10)
+
 
 int
 get_mode(struct ipc_connection *ipc_c)
 {
-	struct ipc_client_list clients;
+	struct ipc_app_states states;
 
 	xrt_result_t r;
 
-	r = ipc_call_system_get_clients(ipc_c, &clients);
+	r = ipc_call_system_get_client_states(ipc_c, &states);
 	if (r != XRT_SUCCESS) {
 		PE("Failed to get client list.\n");
 		exit(1);
 	}
 
 	P("Clients:\n");
-	for (uint32_t i = 0; i < clients.id_count; i++) {
-		uint32_t id = clients.ids[i];
-
-		struct ipc_app_state cs;
-		r = ipc_call_system_get_client_info(ipc_c, id, &cs);
-		if (r != XRT_SUCCESS) {
-			PE("Failed to get client info for client %d.\n", id);
-			return 1;
-		}
+	for (uint32_t i = 0; i < states.count; i++) {
+		const struct ipc_app_state cs = states.states[i];
+		double gpu_ms = (double)cs.stats.client_gpu_avg_ns / (double)U_TIME_1MS_IN_NS;
+		double comp_ms = (double)cs.stats.compositor_gpu_avg_ns / (double)U_TIME_1MS_IN_NS;
 
 		P("\tid: %d"
 		  "\tact: %d"
@@ -62,15 +72,22 @@ get_mode(struct ipc_connection *ipc_c)
 		  "\tovly: %d"
 		  "\tz: %d"
 		  "\tpid: %d"
+		  "\tgpu: %.2fms"
+		  "\tcomp: %.2fms"
+		  "\tover: %" PRIu64 "/%" PRIu64
 		  "\t%s\n",
-		  clients.ids[i],     //
-		  cs.session_active,  //
-		  cs.session_visible, //
-		  cs.session_focused, //
-		  cs.io_active,       //
-		  cs.session_overlay, //
-		  cs.z_order,         //
-		  cs.pid,             //
+		  cs.id,                          //
+		  cs.session_active,              //
+		  cs.session_visible,             //
+		  cs.session_focused,             //
+		  cs.io_active,                   //
+		  cs.session_overlay,             //
+		  cs.z_order,                     //
+		  cs.pid,                         //
+		  gpu_ms,                         //
+		  comp_ms,                        //
+		  cs.stats.over_budget_count, //
+		  cs.stats.frame_count,       //
 		  cs.info.application_name);
 	}
 
@@ -143,6 +160,322 @@ recenter_local_spaces(struct ipc_connection *ipc_c)
 
 	return 0;
 }
+
+static void
+print_histogram(const char *kind, const struct ipc_latency_histogram *h)
+{
+	if (h->count == 0) {
+		return;
+	}
+
+	P("\t\t%s: count: %" PRIu64 " avg: %.1fus max: %.1fus\n\t\t\t", //
+	  kind,                                                        //
+	  h->count,                                                    //
+	  (double)h->total_ns / (double)h->count / 1000.0,             //
+	  (double)h->max_ns / 1000.0);                                 //
+
+	// Bucket N is everything below 2^N microseconds.
+	for (uint32_t i = 0; i < IPC_LATENCY_BUCKET_COUNT; i++) {
+		if (h->buckets[i] == 0) {
+			continue;
+		}
+		if (i == IPC_LATENCY_BUCKET_COUNT - 1) {
+			P(" >=%uus: %u", 1u << (i - 1), h->buckets[i]);
+		} else {
+			P(" <%uus: %u", 1u << i, h->buckets[i]);
+		}
+	}
+	P("\n");
+}
+
+int
+print_stats(struct ipc_connection *ipc_c)
+{
+	xrt_result_t r;
+
+	P("IPC commands:\n");
+	for (uint32_t i = 1; i < IPC_MAX_COMMANDS; i++) {
+		struct ipc_command_stats stats;
+
+		r = ipc_call_system_get_ipc_stats(ipc_c, i, &stats);
+		if (r != XRT_SUCCESS) {
+			PE("Failed to get stats for command %u.\n", i);
+			return 1;
+		}
+
+		if (stats.server.count == 0 && stats.client.count == 0) {
+			continue;
+		}
+
+		P("\t%s\n", ipc_cmd_to_str((ipc_command_t)i));
+		print_histogram("service", &stats.server);
+		print_histogram("end-to-end", &stats.client);
+	}
+
+	return 0;
+}
+
+int
+dump_trace(struct ipc_connection *ipc_c)
+{
+	struct ipc_trace_dump_info info;
+	xrt_result_t r;
+
+	r = ipc_call_system_dump_trace(ipc_c, &info);
+	if (r != XRT_SUCCESS) {
+		PE("Failed to dump trace.\n");
+		return 1;
+	}
+
+	if (info.path[0] == '\0') {
+		PE("Service is not recording traces, needs XRT_FEATURE_TRACING without Percetto or Tracy.\n");
+		return 1;
+	}
+
+	P("Wrote %u events to '%s'\n", info.event_count, info.path);
+
+	return 0;
+}
+
+int
+print_startup_timeline(struct ipc_connection *ipc_c)
+{
+	struct ipc_startup_phase phase;
+	uint64_t start_ns = 0;
+	xrt_result_t r;
+
+	P("Startup timeline:\n");
+	P("\t%10s %10s  %s\n", "start", "duration", "phase");
+
+	for (uint32_t i = 0;; i++) {
+		r = ipc_call_system_get_startup_phase(ipc_c, i, &phase);
+		if (r != XRT_SUCCESS) {
+			PE("Failed to get startup phase %u.\n", i);
+			return 1;
+		}
+
+		if (i >= phase.count) {
+			break;
+		}
+
+		if (i == 0) {
+			start_ns = phase.begin_ns;
+		}
+
+		P("\t%8.1fms ", (double)(phase.begin_ns - start_ns) / 1000000.0);
+		if (phase.end_ns == 0) {
+			P("%10s", "running");
+		} else {
+			P("%8.1fms", (double)(phase.end_ns - phase.begin_ns) / 1000000.0);
+		}
+		P("  %*s%s\n", (int)phase.depth * 2, "", phase.name);
+	}
+
+	return 0;
+}
+
+static double
+ns_to_ms(uint64_t ns)
+{
+	return (double)ns / (double)U_TIME_1MS_IN_NS;
+}
+
+static double
+per_second(uint64_t now, uint64_t then, double dt_s)
+{
+	return now >= then ? (double)(now - then) / dt_s : 0.0;
+}
+
+/*!
+ * Everything the top view shows, two of these are compared to get rates.
+ */
+struct top_snapshot
+{
+	uint64_t when_ns;
+
+	bool have_comp;
+	struct xrt_multi_compositor_stats comp;
+
+	struct ipc_app_states states;
+
+	uint64_t command_counts[IPC_MAX_COMMANDS];
+	uint64_t command_total_ns[IPC_MAX_COMMANDS];
+};
+
+static xrt_result_t
+top_sample(struct ipc_connection *ipc_c, struct top_snapshot *snap)
+{
+	xrt_result_t r;
+
+	snap->when_ns = os_monotonic_get_ns();
+
+	// Not all system compositors keep stats.
+	snap->have_comp = ipc_call_system_compositor_get_stats(ipc_c, &snap->comp) == XRT_SUCCESS;
+
+	r = ipc_call_system_get_client_states(ipc_c, &snap->states);
+	if (r != XRT_SUCCESS) {
+		PE("Failed to get client list.\n");
+		return r;
+	}
+
+	for (uint32_t i = 1; i < IPC_MAX_COMMANDS; i++) {
+		struct ipc_command_stats stats;
+
+		r = ipc_call_system_get_ipc_stats(ipc_c, i, &stats);
+		if (r != XRT_SUCCESS) {
+			PE("Failed to get stats for command %u.\n", i);
+			return r;
+		}
+
+		snap->command_counts[i] = stats.server.count;
+		snap->command_total_ns[i] = stats.server.total_ns;
+	}
+
+	return XRT_SUCCESS;
+}
+
+static const struct ipc_app_state *
+top_find_client(const struct top_snapshot *snap, uint32_t id)
+{
+	for (uint32_t i = 0; i < snap->states.count; i++) {
+		if (snap->states.states[i].id == id) {
+			return &snap->states.states[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void
+top_print_compositor(const struct top_snapshot *now, const struct top_snapshot *then, double dt_s)
+{
+	if (!now->have_comp) {
+		P("Compositor: no stats\n\n");
+		return;
+	}
+
+	const struct xrt_multi_compositor_stats *c = &now->comp;
+
+	P("Compositor: %.1f fps  period: %.2fms (display %.2fms)  gpu: %.2fms  late: %" PRIu64 "\n\n",
+	  per_second(c->frame_count, then->comp.frame_count, dt_s), //
+	  ns_to_ms(c->frame_period_avg_ns),                         //
+	  ns_to_ms(c->display_period_ns),                           //
+	  ns_to_ms(c->compositor_gpu_avg_ns),                       //
+	  c->late_count);                                           //
+}
+
+static void
+top_print_clients(const struct top_snapshot *now, const struct top_snapshot *then, double dt_s)
+{
+	P("%4s %6s %7s %7s %8s %8s %8s %6s %6s %7s  %s\n", "id", "pid", "fps", "drop/s", "cpu", "gpu", "comp",
+	  "layers", "over", "vram", "application");
+
+	for (uint32_t i = 0; i < now->states.count; i++) {
+		const struct ipc_app_state *cs = &now->states.states[i];
+		const struct xrt_multi_compositor_client_stats *st = &cs->stats;
+
+		// New clients have nothing to compare against.
+		struct xrt_multi_compositor_client_stats prev = *st;
+		const struct ipc_app_state *old = top_find_client(then, cs->id);
+		if (old != NULL) {
+			prev = old->stats;
+		}
+
+		P("%4u %6d %7.1f %7.1f %6.2fms %6.2fms %6.2fms %6u %6" PRIu64 " %4" PRIu64 "MiB  %s%s\n",
+		  cs->id,                                                      //
+		  (int)cs->pid,                                                //
+		  per_second(st->delivered_count, prev.delivered_count, dt_s), //
+		  per_second(st->dropped_count, prev.dropped_count, dt_s),     //
+		  ns_to_ms(st->app_cpu_avg_ns),                                //
+		  ns_to_ms(st->client_gpu_avg_ns),                             //
+		  ns_to_ms(st->compositor_gpu_avg_ns),                         //
+		  st->layer_count,                                             //
+		  st->over_budget_count,                                       //
+		  st->swapchain_bytes / (1024 * 1024),                         //
+		  cs->info.application_name,                                   //
+		  cs->session_visible ? "" : " (hidden)");                     //
+	}
+
+	P("\n");
+}
+
+static void
+top_print_commands(const struct top_snapshot *now, const struct top_snapshot *then, double dt_s)
+{
+	uint32_t order[IPC_MAX_COMMANDS];
+	uint32_t count = 0;
+
+	for (uint32_t i = 1; i < IPC_MAX_COMMANDS; i++) {
+		if (now->command_counts[i] > then->command_counts[i]) {
+			order[count++] = i;
+		}
+	}
+
+	// Few commands, a simple insertion sort on calls since last time is plenty.
+	for (uint32_t i = 1; i < count; i++) {
+		uint32_t cmd = order[i];
+		uint64_t calls = now->command_counts[cmd] - then->command_counts[cmd];
+		uint32_t k = i;
+
+		while (k > 0 && now->command_counts[order[k - 1]] - then->command_counts[order[k - 1]] < calls) {
+			order[k] = order[k - 1];
+			k--;
+		}
+		order[k] = cmd;
+	}
+
+	P("%-40s %9s %9s\n", "IPC command", "calls/s", "avg");
+
+	for (uint32_t i = 0; i < count && i < TOP_COMMAND_COUNT; i++) {
+		uint32_t cmd = order[i];
+		uint64_t calls = now->command_counts[cmd] - then->command_counts[cmd];
+		uint64_t total_ns = now->command_total_ns[cmd] - then->command_total_ns[cmd];
+
+		P("%-40s %9.1f %7.1fus\n",                   //
+		  ipc_cmd_to_str((ipc_command_t)cmd),         //
+		  (double)calls / dt_s,                       //
+		  (double)total_ns / (double)calls / 1000.0); //
+	}
+}
+
+int
+top(struct ipc_connection *ipc_c)
+{
+	// Large, keep them off the stack.
+	static struct top_snapshot snaps[2];
+	uint32_t current = 0;
+
+	if (top_sample(ipc_c, &snaps[current]) != XRT_SUCCESS) {
+		return 1;
+	}
+
+	while (true) {
+		os_nanosleep(TOP_INTERVAL_NS);
+
+		struct top_snapshot *then = &snaps[current];
+		struct top_snapshot *now = &snaps[current ^ 1];
+
+		if (top_sample(ipc_c, now) != XRT_SUCCESS) {
+			return 1;
+		}
+
+		double dt_s = (double)(now->when_ns - then->when_ns) / (double)U_TIME_1S_IN_NS;
+
+		// Clear the screen and move to the top left corner.
+		P("\033[H\033[2J");
+
+		top_print_compositor(now, then, dt_s);
+		top_print_clients(now, then, dt_s);
+		top_print_commands(now, then, dt_s);
+
+		fflush(stdout);
+
+		current ^= 1;
+	}
+
+	return 0;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -153,7 +486,7 @@ main(int argc, char *argv[])
 	int s_val = 0;
 
 	opterr = 0;
-	while ((c = getopt(argc, argv, "p:f:i:c")) != -1) {
+	while ((c = getopt(argc, argv, "p:f:i:clstT")) != -1) {
 		switch (c) {
 		case 'p':
 			s_val = atoi(optarg);
@@ -168,6 +501,10 @@ main(int argc, char *argv[])
 			op_mode = MODE_TOGGLE_IO;
 			break;
 		case 'c': op_mode = MODE_RECENTER; break;
+		case 'l': op_mode = MODE_STARTUP_TIMELINE; break;
+		case 's': op_mode = MODE_STATS; break;
+		case 't': op_mode = MODE_DUMP_TRACE; break;
+		case 'T': op_mode = MODE_TOP; break;
 		case '?':
 			if (optopt == 's') {
 				PE("Option -s requires an id to set.\n");
@@ -177,6 +514,10 @@ main(int argc, char *argv[])
 				PE("    -f <id>: Set focused client\n");
 				PE("    -p <id>: Set primary client\n");
 				PE("    -i <id>: Toggle whether client receives input\n");
+				PE("    -l: Print how long the phases of starting the service took\n");
+				PE("    -s: Print per command IPC latency statistics\n");
+				PE("    -t: Dump the trace recorder of the service to a file\n");
+				PE("    -T, top: Show a refreshing view of compositor, client and IPC performance\n");
 			} else {
 				PE("Option `\\x%x' unknown.\n", optopt);
 			}
@@ -185,6 +526,10 @@ main(int argc, char *argv[])
 		}
 	}
 
+	if (optind < argc && strcmp(argv[optind], "top") == 0) {
+		op_mode = MODE_TOP;
+	}
+
 	// Connection struct on the stack, super simple.
 	struct ipc_connection ipc_c = {0};
 
@@ -204,6 +549,10 @@ main(int argc, char *argv[])
 	case MODE_SET_FOCUSED: exit(set_focused(&ipc_c, s_val)); break;
 	case MODE_TOGGLE_IO: exit(toggle_io(&ipc_c, s_val)); break;
 	case MODE_RECENTER: exit(recenter_local_spaces(&ipc_c)); break;
+	case MODE_STATS: exit(print_stats(&ipc_c)); break;
+	case MODE_DUMP_TRACE: exit(dump_trace(&ipc_c)); break;
+	case MODE_STARTUP_TIMELINE: exit(print_startup_timeline(&ipc_c)); break;
+	case MODE_TOP: exit(top(&ipc_c)); break;
 	default: P("Unrecognised operation mode.\n"); exit(1);
 	}
 
@@ -0,0 +1,431 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief  Replays captured IPC call streams against a running service.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ * @ingroup ipc
+ */
+
+#include "os/os_time.h"
+#include "os/os_threading.h"
+
+#include "util/u_misc.h"
+#include "util/u_git_tag.h"
+
+#include "shared/ipc_stats.h"
+#include "shared/ipc_capture.h"
+#include "client/ipc_client.h"
+#include "client/ipc_client_connection.h"
+
+#include "ipc_client_generated.h"
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#define P(...) fprintf(stdout, __VA_ARGS__)
+#define PE(...) fprintf(stderr, __VA_ARGS__)
+
+#define MAX_CLIENTS IPC_MAX_CLIENTS
+
+
+/*
+ *
+ * Structs
+ *
+ */
+
+/*!
+ * A single call loaded from a capture file.
+ */
+struct bench_call
+{
+	uint64_t timestamp_ns;
+	uint32_t msg_size;
+	uint32_t reply_size;
+	const uint8_t *msg;
+};
+
+/*!
+ * A whole capture file loaded into memory.
+ */
+struct bench_capture
+{
+	const char *path;
+	uint8_t *data;
+	struct bench_call *calls;
+	uint32_t call_count;
+	uint32_t max_reply_size;
+};
+
+/*!
+ * One fake client replaying a capture.
+ */
+struct bench_client
+{
+	struct os_thread thread;
+
+	const struct bench_capture *capture;
+	double speed;
+	uint32_t loops;
+
+	struct ipc_connection ipc_c;
+
+	struct ipc_latency_histogram stats[IPC_MAX_COMMANDS];
+	uint64_t frame_count;
+	uint64_t error_count;
+	uint64_t duration_ns;
+	xrt_result_t result;
+};
+
+
+/*
+ *
+ * Capture loading.
+ *
+ */
+
+static bool
+load_capture(struct bench_capture *cap, const char *path)
+{
+	cap->path = path;
+
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		PE("Could not open '%s'.\n", path);
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	if (size < (long)sizeof(struct ipc_capture_header)) {
+		PE("'%s' is too small to be a capture.\n", path);
+		fclose(file);
+		return false;
+	}
+
+	cap->data = U_TYPED_ARRAY_CALLOC(uint8_t, size);
+	size_t read = fread(cap->data, 1, size, file);
+	fclose(file);
+
+	if (read != (size_t)size) {
+		PE("Failed to read '%s'.\n", path);
+		return false;
+	}
+
+	struct ipc_capture_header header;
+	memcpy(&header, cap->data, sizeof(header));
+	if (header.magic != IPC_CAPTURE_MAGIC || header.version != IPC_CAPTURE_VERSION) {
+		PE("'%s' is not a capture or has the wrong version.\n", path);
+		return false;
+	}
+
+	// Command ids are only stable within one build.
+	if (strncmp(header.u_git_tag, u_git_tag, IPC_VERSION_NAME_LEN) != 0) {
+		PE("'%s' was captured with %s but this is %s, command ids might not match.\n", path, header.u_git_tag,
+		   u_git_tag);
+	}
+
+	// Count the calls first.
+	size_t offset = sizeof(header);
+	uint32_t count = 0;
+	while (offset + sizeof(struct ipc_capture_record) <= (size_t)size) {
+		struct ipc_capture_record record;
+		memcpy(&record, cap->data + offset, sizeof(record));
+		offset += sizeof(record);
+
+		if (record.msg_size < sizeof(ipc_command_t) || record.msg_size > IPC_BUF_SIZE ||
+		    record.msg_size > (size_t)size - offset) {
+			PE("'%s' has a broken record at %zu, ignoring the rest.\n", path, offset);
+			break;
+		}
+
+		offset += record.msg_size;
+		count++;
+	}
+
+	cap->calls = U_TYPED_ARRAY_CALLOC(struct bench_call, count);
+	cap->call_count = count;
+
+	offset = sizeof(header);
+	for (uint32_t i = 0; i < count; i++) {
+		struct ipc_capture_record record;
+		memcpy(&record, cap->data + offset, sizeof(record));
+		offset += sizeof(record);
+
+		struct bench_call *call = &cap->calls[i];
+		call->timestamp_ns = record.timestamp_ns;
+		call->msg_size = record.msg_size;
+		call->reply_size = record.reply_size;
+		call->msg = cap->data + offset;
+		offset += record.msg_size;
+
+		if (call->reply_size != IPC_CAPTURE_NO_REPLY && call->reply_size > cap->max_reply_size) {
+			cap->max_reply_size = call->reply_size;
+		}
+	}
+
+	P("Loaded %u calls from '%s'.\n", count, path);
+
+	return count > 0;
+}
+
+static void
+free_capture(struct bench_capture *cap)
+{
+	free(cap->calls);
+	free(cap->data);
+	U_ZERO(cap);
+}
+
+
+/*
+ *
+ * Replaying.
+ *
+ */
+
+static ipc_command_t
+get_command(const struct bench_call *call)
+{
+	ipc_command_t cmd = IPC_ERR;
+	memcpy(&cmd, call->msg, sizeof(cmd));
+	return cmd;
+}
+
+static xrt_result_t
+replay_call(struct bench_client *bc, const struct bench_call *call, uint8_t *reply_buf)
+{
+	struct ipc_connection *ipc_c = &bc->ipc_c;
+	xrt_result_t xret;
+
+	const uint64_t start_ns = os_monotonic_get_ns();
+
+	ipc_client_connection_lock(ipc_c);
+	if (call->reply_size == IPC_CAPTURE_NO_REPLY) {
+		xret = ipc_client_post_locked(ipc_c, call->msg, call->msg_size);
+	} else {
+		xret = ipc_client_transact_locked(ipc_c, call->msg, call->msg_size, reply_buf, call->reply_size);
+	}
+	ipc_client_connection_unlock(ipc_c);
+
+	const uint64_t duration_ns = os_monotonic_get_ns() - start_ns;
+
+	if (xret != XRT_SUCCESS) {
+		return xret;
+	}
+
+	ipc_command_t cmd = get_command(call);
+	if (cmd < IPC_MAX_COMMANDS) {
+		ipc_latency_histogram_add(&bc->stats[cmd], duration_ns);
+	}
+
+	if (cmd == IPC_COMPOSITOR_BEGIN_FRAME) {
+		bc->frame_count++;
+	}
+
+	// All replies start with the result, the stream may depend on state we do not have.
+	if (call->reply_size >= sizeof(xrt_result_t)) {
+		xrt_result_t reply_result;
+		memcpy(&reply_result, reply_buf, sizeof(reply_result));
+		if (reply_result != XRT_SUCCESS) {
+			bc->error_count++;
+		}
+	}
+
+	return XRT_SUCCESS;
+}
+
+static void *
+run_client(void *ptr)
+{
+	struct bench_client *bc = (struct bench_client *)ptr;
+	const struct bench_capture *cap = bc->capture;
+
+	uint8_t *reply_buf = U_TYPED_ARRAY_CALLOC(uint8_t, cap->max_reply_size + 1);
+	const uint64_t start_ns = os_monotonic_get_ns();
+
+	for (uint32_t loop = 0; loop < bc->loops; loop++) {
+		const uint64_t loop_start_ns = os_monotonic_get_ns();
+
+		for (uint32_t i = 0; i < cap->call_count; i++) {
+			const struct bench_call *call = &cap->calls[i];
+
+			// A speed of zero means as fast as possible.
+			if (bc->speed > 0.0) {
+				uint64_t target_ns = loop_start_ns + (uint64_t)((double)call->timestamp_ns / bc->speed);
+				int64_t wait_ns = (int64_t)(target_ns - os_monotonic_get_ns());
+				if (wait_ns > 0) {
+					os_nanosleep(wait_ns);
+				}
+			}
+
+			bc->result = replay_call(bc, call, reply_buf);
+			if (bc->result != XRT_SUCCESS) {
+				goto out;
+			}
+		}
+	}
+
+out:
+	bc->duration_ns = os_monotonic_get_ns() - start_ns;
+	free(reply_buf);
+
+	return NULL;
+}
+
+
+/*
+ *
+ * Reporting.
+ *
+ */
+
+static void
+print_report(struct bench_client *clients, uint32_t client_count)
+{
+	struct ipc_latency_histogram total[IPC_MAX_COMMANDS] = {0};
+	uint64_t frames = 0;
+	uint64_t errors = 0;
+	uint64_t max_duration_ns = 0;
+
+	for (uint32_t i = 0; i < client_count; i++) {
+		struct bench_client *bc = &clients[i];
+
+		for (uint32_t k = 0; k < IPC_MAX_COMMANDS; k++) {
+			ipc_latency_histogram_merge(&total[k], &bc->stats[k]);
+		}
+
+		frames += bc->frame_count;
+		errors += bc->error_count;
+		if (bc->duration_ns > max_duration_ns) {
+			max_duration_ns = bc->duration_ns;
+		}
+
+		if (bc->result != XRT_SUCCESS) {
+			PE("Client %u stopped early with error %i.\n", i, bc->result);
+		}
+	}
+
+	P("%-48s %10s %12s %12s\n", "Command", "Count", "Mean (us)", "Max (us)");
+	for (uint32_t k = 1; k < IPC_MAX_COMMANDS; k++) {
+		const struct ipc_latency_histogram *h = &total[k];
+		if (h->count == 0) {
+			continue;
+		}
+
+		double mean_us = (double)h->total_ns / (double)h->count / 1000.0;
+		double max_us = (double)h->max_ns / 1000.0;
+		P("%-48s %10" PRIu64 " %12.2f %12.2f\n", ipc_cmd_to_str((ipc_command_t)k), h->count, mean_us, max_us);
+	}
+
+	double seconds = (double)max_duration_ns / (double)U_TIME_1S_IN_NS;
+	P("\n%u client(s), %" PRIu64 " frames in %.3fs, %.1f frames/s", client_count, frames, seconds,
+	  seconds > 0.0 ? (double)frames / seconds : 0.0);
+	P(", %" PRIu64 " calls returned errors.\n", errors);
+}
+
+
+/*
+ *
+ * Main.
+ *
+ */
+
+static void
+print_usage(void)
+{
+	PE("Usage: monado-ipc-bench [-x speed] [-c clients] [-n loops] capture...\n");
+	PE("    -x <speed>: Replay at this many times the captured speed, 0 for as fast as possible (default 1)\n");
+	PE("    -c <count>: Number of concurrent fake clients (default 1)\n");
+	PE("    -n <count>: Number of times each client replays its capture (default 1)\n");
+	PE("\nRecord captures by running an application with IPC_CAPTURE=<file>.\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+	double speed = 1.0;
+	uint32_t client_count = 1;
+	uint32_t loops = 1;
+
+	int c;
+	while ((c = getopt(argc, argv, "x:c:n:h")) != -1) {
+		switch (c) {
+		case 'x': speed = atof(optarg); break;
+		case 'c': client_count = (uint32_t)atoi(optarg); break;
+		case 'n': loops = (uint32_t)atoi(optarg); break;
+		case 'h': print_usage(); return 0;
+		default: print_usage(); return 1;
+		}
+	}
+
+	uint32_t capture_count = (uint32_t)(argc - optind);
+	if (capture_count == 0 || client_count == 0 || client_count > MAX_CLIENTS || speed < 0.0) {
+		print_usage();
+		return 1;
+	}
+
+	struct bench_capture *captures = U_TYPED_ARRAY_CALLOC(struct bench_capture, capture_count);
+	for (uint32_t i = 0; i < capture_count; i++) {
+		if (!load_capture(&captures[i], argv[optind + i])) {
+			return 1;
+		}
+	}
+
+	struct bench_client *clients = U_TYPED_ARRAY_CALLOC(struct bench_client, client_count);
+	uint32_t started = 0;
+	int ret = 0;
+
+	for (uint32_t i = 0; i < client_count; i++) {
+		struct bench_client *bc = &clients[i];
+		bc->capture = &captures[i % capture_count];
+		bc->speed = speed;
+		bc->loops = loops;
+
+		struct xrt_instance_info info = {0};
+		snprintf(info.application_name, sizeof(info.application_name), "monado-ipc-bench #%u", i);
+
+		xrt_result_t xret = ipc_client_connection_init(&bc->ipc_c, U_LOGGING_WARN, &info);
+		if (xret != XRT_SUCCESS) {
+			PE("Failed to connect client %u: %i\n", i, xret);
+			ret = 1;
+			break;
+		}
+
+		os_thread_init(&bc->thread);
+		started++;
+	}
+
+	// Start them all at once so they overlap.
+	for (uint32_t i = 0; i < started; i++) {
+		os_thread_start(&clients[i].thread, run_client, &clients[i]);
+	}
+
+	for (uint32_t i = 0; i < started; i++) {
+		os_thread_join(&clients[i].thread);
+		os_thread_destroy(&clients[i].thread);
+	}
+
+	if (started == client_count) {
+		print_report(clients, client_count);
+	}
+
+	for (uint32_t i = 0; i < started; i++) {
+		ipc_client_connection_fini(&clients[i].ipc_c);
+	}
+
+	for (uint32_t i = 0; i < capture_count; i++) {
+		free_capture(&captures[i]);
+	}
+	free(captures);
+	free(clients);
+
+	return ret;
+}
@@ -34,6 +34,9 @@ struct mnd_root
 	//! List of clients.
 	struct ipc_client_list clients;
 
+	//! State of all clients, fetched together with the list of clients.
+	struct ipc_app_states app_states;
+
 	/// State of most recent app asked about
 	struct ipc_app_state app_state;
 };
@@ -88,6 +91,14 @@ get_client_info(mnd_root_t *root, uint32_t client_id)
 {
 	assert(root != NULL);
 
+	// Fetched in bulk when the client list was updated.
+	for (uint32_t i = 0; i < root->app_states.count; i++) {
+		if (root->app_states.states[i].id == client_id) {
+			root->app_state = root->app_states.states[i];
+			return MND_SUCCESS;
+		}
+	}
+
 	xrt_result_t r = ipc_call_system_get_client_info(&root->ipc_c, client_id, &root->app_state);
 	if (r != XRT_SUCCESS) {
 		PE("Failed to get client info for client id: %u.\n", client_id);
@@ -166,12 +177,19 @@ mnd_root_update_client_list(mnd_root_t *root)
 {
 	CHECK_NOT_NULL(root);
 
-	xrt_result_t r = ipc_call_system_get_clients(&root->ipc_c, &root->clients);
+	// One call for all clients, instead of one per client and query.
+	xrt_result_t r = ipc_call_system_get_client_states(&root->ipc_c, &root->app_states);
 	if (r != XRT_SUCCESS) {
 		PE("Failed to get client list.\n");
+		root->app_states.count = 0;
 		return MND_ERROR_OPERATION_FAILED;
 	}
 
+	for (uint32_t i = 0; i < root->app_states.count; i++) {
+		root->clients.ids[i] = root->app_states.states[i].id;
+	}
+	root->clients.id_count = root->app_states.count;
+
 	return MND_SUCCESS;
 }
 
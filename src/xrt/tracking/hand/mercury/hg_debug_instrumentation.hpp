@@ -34,10 +34,14 @@ struct hg_tuneable_values
 	struct u_var_draggable_f32 opt_smooth_factor;
 	struct u_var_draggable_f32 max_hand_dist;
 	struct u_var_draggable_f32 min_detection_confidence;
+	struct u_var_draggable_f32 adaptive_detection_min_confidence;
+	struct u_var_draggable_f32 adaptive_detection_min_iou;
 	bool scribble_predictions_into_next_frame = false;
 	bool scribble_keypoint_model_outputs = false;
 	bool scribble_optimizer_outputs = true;
 	bool always_run_detection_model = false;
+	bool adaptive_detection = true;
+	int adaptive_detection_max_interval = 6;
 	bool optimize_hand_size = true;
 	int max_num_outside_view = 6;
 	size_t num_frames_before_display = 10;
@@ -20,6 +20,7 @@
 #include "xrt/xrt_defines.h"
 #include "math/m_space.h"
 #include <filesystem>
+#include <memory>
 #include <fstream>
 #include "os/os_time.h"
 #include "util/u_logging.h"
@@ -35,8 +36,16 @@
 
 namespace xrt::tracking::hand::mercury {
 
+DEBUG_GET_ONCE_BOOL_OPTION(mercury_exact_distort, "MERCURY_EXACT_DISTORT", false)
+
 constexpr int wsize = 128;
 
+//! Spacing of the points that are projected exactly, the map between them is interpolated.
+constexpr int kTileSize = 8;
+constexpr int kTileShift = 3;
+constexpr int kGridSize = wsize / kTileSize + 1;
+static_assert((1 << kTileShift) == kTileSize);
+
 template <typename T> using OutputSizedArray = Eigen::Array<T, wsize, wsize, Eigen::RowMajor>;
 using OutputSizedFloatArray = OutputSizedArray<float>;
 
@@ -63,6 +72,15 @@ struct ArrayStack
 	}
 };
 
+//! The big buffers of @ref projection_state, kept for each thread that projects images.
+struct projection_scratch
+{
+	ArrayStack stack = {};
+
+	OutputSizedArray<int16_t> image_x = {};
+	OutputSizedArray<int16_t> image_y = {};
+};
+
 struct projection_state
 {
 	cv::Mat &input;
@@ -71,15 +89,35 @@ struct projection_state
 
 	const projection_instructions &instructions;
 
-	ArrayStack stack = {};
+	ArrayStack &stack;
 
-	OutputSizedArray<int16_t> image_x = {};
-	OutputSizedArray<int16_t> image_y = {};
+	OutputSizedArray<int16_t> &image_x;
+	OutputSizedArray<int16_t> &image_y;
 
-	projection_state(const projection_instructions &instructions, cv::Mat &input, cv::Mat &output)
-	    : input(input), distorted_image_eigen(output.data, 128, 128), instructions(instructions){};
+	projection_state(const projection_instructions &instructions,
+	                 cv::Mat &input,
+	                 cv::Mat &output,
+	                 projection_scratch &scratch)
+	    : input(input), distorted_image_eigen(output.data, 128, 128), instructions(instructions),
+	      stack(scratch.stack), image_x(scratch.image_x), image_y(scratch.image_y)
+	{
+		stack.dropAll();
+	};
 };
 
+//! Too big for the stack, so allocated the first time each thread needs it.
+static projection_scratch &
+get_projection_scratch()
+{
+	static thread_local std::unique_ptr<projection_scratch> t_scratch;
+
+	if (!t_scratch) {
+		t_scratch = std::make_unique<projection_scratch>();
+	}
+
+	return *t_scratch;
+}
+
 
 // A private, purpose-optimized version of the Kannalla-Brandt projection function.
 static void
@@ -183,11 +221,120 @@ naive_remap(OutputSizedArray<int16_t> &image_x,
 
 
 
+//! Projects one corner of the tile grid, same math as @ref StereographicDistort.
+static void
+project_grid_point(projection_state &mi, int x, int y, float &out_x, float &out_y)
+{
+	float r = mi.instructions.stereographic_radius;
+
+	float sg_x = map_ranges<float>((float)x, 0.0f, (float)wsize, -r, r);
+	float sg_y = map_ranges<float>((float)y, 0.0f, (float)wsize, r, -r);
+
+	if (mi.instructions.flip) {
+		sg_x = -sg_x;
+	}
+
+	Eigen::Vector3f dir = mi.instructions.rot_quat * stereographic_unprojection(sg_x, sg_y);
+
+	dir.y() *= -1;
+	dir.z() *= -1;
+
+	t_camera_models_project(&mi.dist, dir.x(), dir.y(), dir.z(), &out_x, &out_y);
+}
+
+//! Camera pixel coordinate in 16.16 fixed point, clamped so that tile differences fit.
+static inline int32_t
+to_fixed(float v)
+{
+	constexpr float limit = 8192.0f;
+
+	if (!std::isfinite(v)) {
+		v = -limit;
+	}
+	v = std::min(std::max(v, -limit), limit);
+
+	return (int32_t)(v * 65536.0f);
+}
+
+/*!
+ * Only projects the corners of 8x8 pixel tiles and interpolates the camera
+ * coordinates in fixed point between them. The map is smooth over a tile so
+ * this is within a fraction of a pixel of the exact map, at about 1/50th of
+ * the projections. Samples the nearest pixel, like @ref naive_remap.
+ */
+static void
+tiled_remap(projection_state &mi)
+{
+	XRT_TRACE_MARKER();
+
+	int32_t grid_x[kGridSize][kGridSize];
+	int32_t grid_y[kGridSize][kGridSize];
+
+	{
+		XRT_TRACE_IDENT(camera_projection);
+
+		for (int gy = 0; gy < kGridSize; gy++) {
+			for (int gx = 0; gx < kGridSize; gx++) {
+				float x = 0;
+				float y = 0;
+				project_grid_point(mi, gx * kTileSize, gy * kTileSize, x, y);
+				grid_x[gy][gx] = to_fixed(x);
+				grid_y[gy][gx] = to_fixed(y);
+			}
+		}
+	}
+
+	const uint8_t *src = mi.input.data;
+	const size_t src_stride = mi.input.step;
+	const uint32_t cols = mi.input.cols;
+	const uint32_t rows = mi.input.rows;
+	uint8_t *dst = mi.distorted_image_eigen.data();
+
+	for (int y = 0; y < wsize; y++) {
+		int ty = y >> kTileShift;
+		int64_t j = y & (kTileSize - 1);
+		uint8_t *dst_row = dst + (y * wsize);
+
+		for (int tx = 0; tx < wsize / kTileSize; tx++) {
+			// Interpolate down the left and right edges of the tile, then across.
+			int64_t lx = grid_x[ty][tx] + (((grid_x[ty + 1][tx] - (int64_t)grid_x[ty][tx]) * j) >> kTileShift);
+			int64_t ly = grid_y[ty][tx] + (((grid_y[ty + 1][tx] - (int64_t)grid_y[ty][tx]) * j) >> kTileShift);
+			int64_t rx = grid_x[ty][tx + 1] +
+			             (((grid_x[ty + 1][tx + 1] - (int64_t)grid_x[ty][tx + 1]) * j) >> kTileShift);
+			int64_t ry = grid_y[ty][tx + 1] +
+			             (((grid_y[ty + 1][tx + 1] - (int64_t)grid_y[ty][tx + 1]) * j) >> kTileShift);
+
+			int32_t fx = (int32_t)lx;
+			int32_t fy = (int32_t)ly;
+			int32_t dx = (int32_t)((rx - lx) >> kTileShift);
+			int32_t dy = (int32_t)((ry - ly) >> kTileShift);
+
+			uint8_t *out = dst_row + (tx * kTileSize);
+
+			for (int i = 0; i < kTileSize; i++) {
+				// Negative values wrap around and fail the bounds check too.
+				uint32_t ix = (uint32_t)(fx >> 16);
+				uint32_t iy = (uint32_t)(fy >> 16);
+
+				out[i] = (ix < cols && iy < rows) ? src[(iy * src_stride) + ix] : 0;
+
+				fx += dx;
+				fy += dy;
+			}
+		}
+	}
+}
+
 void
 StereographicDistort(projection_state &mi)
 {
 	XRT_TRACE_MARKER();
 
+	if (!debug_get_bool_option_mercury_exact_distort()) {
+		tiled_remap(mi);
+		return;
+	}
+
 	OutputSizedFloatArray &sg_x = mi.stack.get();
 	OutputSizedFloatArray &sg_y = mi.stack.get();
 
@@ -607,9 +754,9 @@ stereographic_project_image(const t_camera_model_params &dist,
                             cv::Mat &out)
 
 {
-	out = cv::Mat(cv::Size(wsize, wsize), CV_8U);
-	projection_state *mi_ptr = new projection_state(instructions, input_image, out);
-	projection_state &mi = *mi_ptr;
+	// Reuses the data if out is from an earlier call.
+	out.create(cv::Size(wsize, wsize), CV_8U);
+	projection_state mi(instructions, input_image, out, get_projection_scratch());
 
 	mi.dist = dist;
 
@@ -618,6 +765,5 @@ stereographic_project_image(const t_camera_model_params &dist,
 	if (debug_image) {
 		draw_boundary(mi, boundary_color, *debug_image);
 	}
-	delete mi_ptr;
 }
 } // namespace xrt::tracking::hand::mercury
@@ -26,6 +26,38 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
                                     struct t_hand_tracking_create_info create_info,
                                     const char *models_folder);
 
+/*!
+ * How long the stages of the last frame Mercury processed took, for
+ * benchmarking. The stages don't add up to the total, it also has the
+ * bookkeeping between them.
+ *
+ * @ingroup aux_tracking
+ */
+struct t_hand_tracking_mercury_timings
+{
+	//! Setting up the views and debug images.
+	uint64_t convert_ns;
+	//! Hand detection, or taking the results of the pipelined one.
+	uint64_t detect_ns;
+	//! Stereographic projection and normalization of the keypoint model inputs, summed over the parallel jobs.
+	uint64_t warp_ns;
+	//! Keypoint estimation for all views and hands, including the warps.
+	uint64_t keypoint_ns;
+	//! The kinematic optimizer for both hands.
+	uint64_t kine_lm_ns;
+	uint64_t total_ns;
+};
+
+/*!
+ * Get the stage timings of the last frame processed by @p ht_sync, which must
+ * have been made by @ref t_hand_tracking_sync_mercury_create.
+ *
+ * @ingroup aux_tracking
+ */
+void
+t_hand_tracking_sync_mercury_get_timings(struct t_hand_tracking_sync *ht_sync,
+                                         struct t_hand_tracking_mercury_timings *out_timings);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -13,10 +13,21 @@
 #include "hg_image_math.inl"
 #include "hg_numerics_checker.hpp"
 
+#include "os/os_time.h"
 
 #include <filesystem>
 #include <array>
 
+#if __has_include(<nnapi_provider_factory.h>)
+#include <nnapi_provider_factory.h>
+#define HG_HAVE_ORT_NNAPI
+#endif
+
+#if __has_include(<dml_provider_factory.h>)
+#include <dml_provider_factory.h>
+#define HG_HAVE_ORT_DML
+#endif
+
 namespace xrt::tracking::hand::mercury {
 
 #define ORT(expr)                                                                                                      \
@@ -107,14 +118,9 @@ blackbar(const cv::Mat &in, enum t_camera_orientation rot, cv::Mat &out, xrt_siz
 
 	cv::warpAffine(in, out, go, cv::Size(out_size.w, out_size.h));
 
-	// Return the inverse affine transform by passing
-	// through a 3x3 rotation matrix
-	cv::Mat e = cv::Mat::eye(3, 3, CV_32F);
-	cv::Mat tmp = e(cv::Rect(0, 0, 3, 2));
-	cv::Mat(go).copyTo(tmp);
-
-	e = e.inv();
-	cv::Matx23f ret = e(cv::Rect(0, 0, 3, 2));
+	// Return the inverse affine transform
+	cv::Matx23f ret;
+	cv::invertAffineTransform(go, ret);
 
 	return ret;
 }
@@ -245,37 +251,193 @@ normalizeGrayscaleImage(cv::Mat &data_in, cv::Mat &data_out)
 {
 	data_in.convertTo(data_out, CV_32FC1, 1 / 255.0);
 
-	cv::Mat mean;
-	cv::Mat stddev;
+	cv::Scalar mean;
+	cv::Scalar stddev;
 	cv::meanStdDev(data_out, mean, stddev);
 
-	if (stddev.at<double>(0, 0) == 0) {
+	if (stddev[0] == 0) {
 		U_LOG_W("Got image with zero standard deviation!");
 		return false;
 	}
 
-	data_out *= 0.25 / stddev.at<double>(0, 0);
+	data_out *= 0.25 / stddev[0];
 
 	// Calculate it again; mean has changed. Yes we don't need to but it's easy
 	//! @todo optimize
 	cv::meanStdDev(data_out, mean, stddev);
-	data_out += (0.5 - mean.at<double>(0, 0));
+	data_out += (0.5 - mean[0]);
 	return true;
 }
 
+//! Name that onnxruntime lists the provider under, nullptr for the CPU.
+static const char *
+get_ort_provider_name(const char *provider)
+{
+	struct
+	{
+		const char *option;
+		const char *name;
+	} names[] = {
+	    {"cpu", nullptr},                               //
+	    {"cuda", "CUDAExecutionProvider"},              //
+	    {"tensorrt", "TensorrtExecutionProvider"},      //
+	    {"openvino", "OpenVINOExecutionProvider"},      //
+	    {"xnnpack", "XnnpackExecutionProvider"},        //
+	    {"nnapi", "NnapiExecutionProvider"},            //
+	    {"dml", "DmlExecutionProvider"},                //
+	    {"qnn", "QNNExecutionProvider"},                //
+	    {"coreml", "CoreMLExecutionProvider"},          //
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(names); i++) {
+		if (strcmp(provider, names[i].option) == 0) {
+			return names[i].name;
+		}
+	}
+
+	// Let people use the full name of providers we don't know about.
+	return provider;
+}
+
+static bool
+is_ort_provider_available(HandTracking *hgt, onnx_wrap *wrap, const char *name)
+{
+	char **providers = nullptr;
+	int count = 0;
+	bool found = false;
+
+	ORT(GetAvailableProviders(&providers, &count));
+	for (int i = 0; i < count; i++) {
+		found = found || strcmp(providers[i], name) == 0;
+	}
+	ORT(ReleaseAvailableProviders(providers, count));
+
+	return found;
+}
+
+//! Logs and releases a failed status, used where failing isn't fatal.
+static bool
+check_ort_status(HandTracking *hgt, onnx_wrap *wrap, OrtStatus *status, const char *what)
+{
+	if (status == nullptr) {
+		return true;
+	}
+
+	HG_WARN(hgt, "%s: %s", what, wrap->api->GetErrorMessage(status));
+	wrap->api->ReleaseStatus(status);
+
+	return false;
+}
+
+static bool
+append_ort_provider(HandTracking *hgt, onnx_wrap *wrap, OrtSessionOptions *opts, const char *provider)
+{
+	const OrtApi *api = wrap->api;
+	OrtStatus *status = nullptr;
+
+	if (strcmp(provider, "cuda") == 0) {
+		OrtCUDAProviderOptionsV2 *cuda = nullptr;
+		status = api->CreateCUDAProviderOptions(&cuda);
+		if (status == nullptr) {
+			status = api->SessionOptionsAppendExecutionProvider_CUDA_V2(opts, cuda);
+			api->ReleaseCUDAProviderOptions(cuda);
+		}
+	} else if (strcmp(provider, "tensorrt") == 0) {
+		OrtTensorRTProviderOptionsV2 *trt = nullptr;
+		status = api->CreateTensorRTProviderOptions(&trt);
+		if (status == nullptr) {
+			status = api->SessionOptionsAppendExecutionProvider_TensorRT_V2(opts, trt);
+			api->ReleaseTensorRTProviderOptions(trt);
+		}
+	} else if (strcmp(provider, "openvino") == 0) {
+		OrtOpenVINOProviderOptions openvino = {};
+		status = api->SessionOptionsAppendExecutionProvider_OpenVINO(opts, &openvino);
+	} else if (strcmp(provider, "xnnpack") == 0) {
+		char threads[16];
+		snprintf(threads, ARRAY_SIZE(threads), "%d", hgt->ort_options.intra_op_threads);
+		const char *keys[] = {"intra_op_num_threads"};
+		const char *values[] = {threads};
+		status = api->SessionOptionsAppendExecutionProvider(opts, "XNNPACK", keys, values, ARRAY_SIZE(keys));
+	} else if (strcmp(provider, "nnapi") == 0) {
+#ifdef HG_HAVE_ORT_NNAPI
+		status = OrtSessionOptionsAppendExecutionProvider_Nnapi(opts, 0);
+#else
+		HG_WARN(hgt, "Built without the NNAPI provider header!");
+		return false;
+#endif
+	} else if (strcmp(provider, "dml") == 0) {
+#ifdef HG_HAVE_ORT_DML
+		const OrtDmlApi *dml = nullptr;
+		status = api->GetExecutionProviderApi("DML", ORT_API_VERSION, (const void **)&dml);
+		if (status == nullptr) {
+			// DirectML doesn't support these.
+			api->DisableMemPattern(opts);
+			api->SetSessionExecutionMode(opts, ORT_SEQUENTIAL);
+			status = dml->SessionOptionsAppendExecutionProvider_DML(opts, 0);
+		}
+#else
+		HG_WARN(hgt, "Built without the DirectML provider header!");
+		return false;
+#endif
+	} else {
+		// Generic path, takes names like "QNN" and "SNPE".
+		status = api->SessionOptionsAppendExecutionProvider(opts, provider, nullptr, nullptr, 0);
+	}
+
+	return check_ort_status(hgt, wrap, status, "Failed to add execution provider");
+}
+
+static void
+setup_ort_provider(HandTracking *hgt, onnx_wrap *wrap, OrtSessionOptions *opts)
+{
+	const char *provider = hgt->ort_options.provider;
+	const char *name = get_ort_provider_name(provider);
+
+	if (name == nullptr) {
+		return;
+	}
+
+	if (!is_ort_provider_available(hgt, wrap, name)) {
+		HG_WARN(hgt, "Execution provider '%s' not available, using the CPU!", provider);
+		return;
+	}
+
+	if (!append_ort_provider(hgt, wrap, opts, provider)) {
+		HG_WARN(hgt, "Could not use execution provider '%s', using the CPU!", provider);
+		return;
+	}
+
+	HG_INFO(hgt, "Using execution provider '%s'", provider);
+}
+
+/*!
+ * Creates the session for the model at @p path, @p thread_scale multiplies
+ * the intra-op thread count for sessions that do the work of several.
+ */
 void
-setup_ort_api(HandTracking *hgt, onnx_wrap *wrap, std::filesystem::path path)
+setup_ort_api(HandTracking *hgt, onnx_wrap *wrap, std::filesystem::path path, int thread_scale = 1)
 {
 	wrap->api = OrtGetApiBase()->GetApi(ORT_API_VERSION);
 	OrtSessionOptions *opts = nullptr;
 
+	const hg_ort_options &options = hgt->ort_options;
+
 	ORT(CreateSessionOptions(&opts));
 
-	ORT(SetSessionGraphOptimizationLevel(opts, ORT_ENABLE_ALL));
-	ORT(SetIntraOpNumThreads(opts, 1));
+	ORT(SetSessionGraphOptimizationLevel(opts, options.optimization_level));
+	ORT(SetIntraOpNumThreads(opts, options.intra_op_threads * thread_scale));
+
+	if (options.inter_op_threads > 0) {
+		ORT(SetInterOpNumThreads(opts, options.inter_op_threads));
+	}
+	if (options.inter_op_threads > 1) {
+		ORT(SetSessionExecutionMode(opts, ORT_PARALLEL));
+	}
 
 	ORT(CreateEnv(ORT_LOGGING_LEVEL_FATAL, "monado_ht", &wrap->env));
 
+	setup_ort_provider(hgt, wrap, opts);
+
 	ORT(CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &wrap->meminfo));
 
 	ORT(CreateSession(wrap->env, path.c_str(), opts, &wrap->session));
@@ -283,6 +445,291 @@ setup_ort_api(HandTracking *hgt, onnx_wrap *wrap, std::filesystem::path path)
 	wrap->api->ReleaseSessionOptions(opts);
 }
 
+static bool
+is_float_tensor(HandTracking *hgt, onnx_wrap *wrap, OrtTypeInfo *type_info)
+{
+	const OrtTensorTypeAndShapeInfo *tensor_info = nullptr;
+	ONNXTensorElementDataType type = ONNX_TENSOR_ELEMENT_DATA_TYPE_UNDEFINED;
+
+	ORT(CastTypeInfoToTensorInfo(type_info, &tensor_info));
+	ORT(GetTensorElementType(tensor_info, &type));
+	wrap->api->ReleaseTypeInfo(type_info);
+
+	return type == ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT;
+}
+
+/*!
+ * The pre and post-processing works on floats, so quantized models need to be
+ * in the QDQ format that keeps float inputs and outputs.
+ */
+static bool
+has_float_io(HandTracking *hgt, onnx_wrap *wrap)
+{
+	size_t num_inputs = 0;
+	size_t num_outputs = 0;
+	bool all_float = true;
+
+	ORT(SessionGetInputCount(wrap->session, &num_inputs));
+	ORT(SessionGetOutputCount(wrap->session, &num_outputs));
+
+	for (size_t i = 0; i < num_inputs; i++) {
+		OrtTypeInfo *type_info = nullptr;
+		ORT(SessionGetInputTypeInfo(wrap->session, i, &type_info));
+		all_float = is_float_tensor(hgt, wrap, type_info) && all_float;
+	}
+
+	for (size_t i = 0; i < num_outputs; i++) {
+		OrtTypeInfo *type_info = nullptr;
+		ORT(SessionGetOutputTypeInfo(wrap->session, i, &type_info));
+		all_float = is_float_tensor(hgt, wrap, type_info) && all_float;
+	}
+
+	return all_float;
+}
+
+/*!
+ * Sets up the session for the model @p name. If a model variant (like "int8")
+ * has been selected and is shipped as `<name>_<variant>.onnx` it is used,
+ * otherwise the float model. Returns true if the variant was loaded.
+ */
+static bool
+setup_model_session(HandTracking *hgt, onnx_wrap *wrap, const char *name, int thread_scale = 1)
+{
+	std::filesystem::path folder = hgt->models_folder;
+	const char *variant = hgt->model_variant;
+
+	if (variant != nullptr && variant[0] != '\0') {
+		std::filesystem::path path = folder / (std::string(name) + "_" + variant + ".onnx");
+
+		if (std::filesystem::exists(path)) {
+			setup_ort_api(hgt, wrap, path, thread_scale);
+
+			if (has_float_io(hgt, wrap)) {
+				HG_INFO(hgt, "Using '%s' variant of model '%s'", variant, name);
+				return true;
+			}
+
+			HG_WARN(hgt, "Model '%s' needs float inputs and outputs (QDQ format), using the float one!",
+			        path.c_str());
+			release_onnx_wrap(wrap);
+			*wrap = {};
+		} else {
+			HG_WARN(hgt, "No '%s' variant of model '%s', using the float one!", variant, name);
+		}
+	}
+
+	setup_ort_api(hgt, wrap, folder / (std::string(name) + ".onnx"), thread_scale);
+
+	return false;
+}
+
+//! Does the first input of the model have a dynamic first (batch) dimension.
+static bool
+has_dynamic_batch(HandTracking *hgt, onnx_wrap *wrap)
+{
+	OrtTypeInfo *type_info = nullptr;
+	const OrtTensorTypeAndShapeInfo *tensor_info = nullptr;
+	size_t num_dims = 0;
+	int64_t dims[4] = {};
+
+	ORT(SessionGetInputTypeInfo(wrap->session, 0, &type_info));
+	ORT(CastTypeInfoToTensorInfo(type_info, &tensor_info));
+	ORT(GetDimensionsCount(tensor_info, &num_dims));
+	num_dims = std::min(num_dims, ARRAY_SIZE(dims));
+	ORT(GetDimensions(tensor_info, dims, num_dims));
+	wrap->api->ReleaseTypeInfo(type_info);
+
+	return num_dims > 0 && dims[0] < 0;
+}
+
+//! Tensor over the first @p batch items of a batched input or output.
+static OrtValue *
+create_batch_tensor(HandTracking *hgt, onnx_wrap *wrap, const model_input_wrap &input, int64_t batch)
+{
+	int64_t dims[4] = {};
+	size_t count = 1;
+	for (size_t i = 0; i < input.num_dimensions; i++) {
+		dims[i] = i == 0 ? batch : input.dimensions[i];
+		count *= dims[i];
+	}
+
+	OrtValue *tensor = nullptr;
+	ORT(CreateTensorWithDataAsOrtValue(wrap->meminfo,                       //
+	                                   input.data,                          //
+	                                   count * sizeof(float),               //
+	                                   dims,                                //
+	                                   input.num_dimensions,                //
+	                                   ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, //
+	                                   &tensor));
+
+	return tensor;
+}
+
+//! The tensor of @p input for a run of @p batch items, @p batch is zero for sessions that don't batch.
+static OrtValue *
+get_run_tensor(const model_input_wrap &input, int batch)
+{
+	return batch == 0 ? input.tensor : input.batch_tensors[batch - 1];
+}
+
+/*!
+ * Allocates the data for an input of @p batch items of @p dims each, with
+ * tensors for runs of any number of items up to that.
+ */
+static void
+setup_batched_input(HandTracking *hgt,
+                    onnx_wrap *wrap,
+                    const char *name,
+                    int64_t batch,
+                    std::initializer_list<int64_t> dims)
+{
+	model_input_wrap input = {};
+	input.name = name;
+	input.dimensions[0] = batch;
+	input.num_dimensions = 1;
+
+	size_t count = batch;
+	for (int64_t dim : dims) {
+		input.dimensions[input.num_dimensions++] = dim;
+		count *= dim;
+	}
+
+	input.data = (float *)calloc(count, sizeof(float));
+
+	for (int64_t i = 0; i < batch; i++) {
+		input.batch_tensors[i] = create_batch_tensor(hgt, wrap, input, i + 1);
+	}
+
+	wrap->wraps.push_back(input);
+}
+
+//! Gets the shape of the output @p name, returns false if the model doesn't have it.
+static bool
+get_output_shape(HandTracking *hgt, onnx_wrap *wrap, const char *name, model_input_wrap &out)
+{
+	OrtAllocator *allocator = nullptr;
+	size_t num_outputs = 0;
+
+	ORT(GetAllocatorWithDefaultOptions(&allocator));
+	ORT(SessionGetOutputCount(wrap->session, &num_outputs));
+
+	for (size_t i = 0; i < num_outputs; i++) {
+		char *output_name = nullptr;
+		ORT(SessionGetOutputName(wrap->session, i, allocator, &output_name));
+		bool match = strcmp(output_name, name) == 0;
+		ORT(AllocatorFree(allocator, output_name));
+
+		if (!match) {
+			continue;
+		}
+
+		OrtTypeInfo *type_info = nullptr;
+		const OrtTensorTypeAndShapeInfo *tensor_info = nullptr;
+
+		ORT(SessionGetOutputTypeInfo(wrap->session, i, &type_info));
+		ORT(CastTypeInfoToTensorInfo(type_info, &tensor_info));
+		ORT(GetDimensionsCount(tensor_info, &out.num_dimensions));
+		out.num_dimensions = std::min(out.num_dimensions, ARRAY_SIZE(out.dimensions));
+		ORT(GetDimensions(tensor_info, out.dimensions, out.num_dimensions));
+		wrap->api->ReleaseTypeInfo(type_info);
+
+		return true;
+	}
+
+	return false;
+}
+
+/*!
+ * Allocates the outputs @p names, so ORT writes into them instead of
+ * allocating new ones every run. For batched sessions @p batch is the most
+ * items a run has and the first dimension must be dynamic, zero otherwise.
+ * Outputs with other dynamic dimensions are left to ORT.
+ */
+static void
+setup_model_outputs(HandTracking *hgt, onnx_wrap *wrap, const char *const *names, size_t num_names, int64_t batch)
+{
+	for (size_t i = 0; i < num_names; i++) {
+		model_input_wrap output = {};
+		output.name = names[i];
+
+		bool known = get_output_shape(hgt, wrap, output.name, output) && output.num_dimensions > 0;
+
+		if (known && batch > 0) {
+			known = output.dimensions[0] < 0;
+			output.dimensions[0] = batch;
+		}
+
+		size_t count = 1;
+		for (size_t dim_idx = 0; known && dim_idx < output.num_dimensions; dim_idx++) {
+			known = output.dimensions[dim_idx] > 0;
+			count *= output.dimensions[dim_idx];
+		}
+
+		if (!known) {
+			HG_DEBUG(hgt, "Output '%s' has an unknown size, ORT allocates it for every run", output.name);
+			wrap->outputs.push_back(output);
+			continue;
+		}
+
+		output.data = (float *)calloc(count, sizeof(float));
+
+		if (batch > 0) {
+			for (int64_t item = 0; item < batch; item++) {
+				output.batch_tensors[item] = create_batch_tensor(hgt, wrap, output, item + 1);
+			}
+		} else {
+			output.tensor = create_batch_tensor(hgt, wrap, output, output.dimensions[0]);
+		}
+
+		wrap->outputs.push_back(output);
+	}
+}
+
+//! Output tensors to give to a run of @p batch items, null for the ones ORT needs to allocate.
+static void
+get_output_tensors(onnx_wrap *wrap, int batch, OrtValue **out_tensors, size_t count)
+{
+	assert(count == wrap->outputs.size());
+
+	for (size_t i = 0; i < count; i++) {
+		out_tensors[i] = get_run_tensor(wrap->outputs[i], batch);
+	}
+}
+
+//! Releases the output tensors that ORT allocated in a run.
+static void
+release_ort_outputs(onnx_wrap *wrap, int batch, OrtValue **tensors, size_t count)
+{
+	for (size_t i = 0; i < count; i++) {
+		if (tensors[i] != get_run_tensor(wrap->outputs[i], batch)) {
+			wrap->api->ReleaseValue(tensors[i]);
+		}
+	}
+}
+
+//! Number of floats for each of the @p batch items in output @p index of a run.
+static size_t
+get_batch_stride(HandTracking *hgt, onnx_wrap *wrap, size_t index, OrtValue *tensor, int64_t batch)
+{
+	const model_input_wrap &output = wrap->outputs[index];
+	if (output.data != nullptr) {
+		size_t stride = 1;
+		for (size_t i = 1; i < output.num_dimensions; i++) {
+			stride *= output.dimensions[i];
+		}
+		return stride;
+	}
+
+	OrtTensorTypeAndShapeInfo *info = nullptr;
+	size_t count = 0;
+
+	ORT(GetTensorTypeAndShape(tensor, &info));
+	ORT(GetTensorShapeElementCount(info, &count));
+	wrap->api->ReleaseTensorTypeAndShapeInfo(info);
+
+	return count / batch;
+}
+
 void
 setup_model_image_input(HandTracking *hgt, onnx_wrap *wrap, const char *name, int64_t w, int64_t h)
 {
@@ -312,73 +759,57 @@ setup_model_image_input(HandTracking *hgt, onnx_wrap *wrap, const char *name, in
 	wrap->wraps.push_back(inputimg);
 }
 
+static const char *const kDetectionOutputNames[] = {"hand_exists", "cx", "cy", "size"};
+static const char *const kKeypointOutputNames[] = {"heatmap_xy", "heatmap_depth", "scalar_extras", "curls"};
+
 void
 init_hand_detection(HandTracking *hgt, onnx_wrap *wrap)
 {
-	std::filesystem::path path = hgt->models_folder;
-
-	path /= "grayscale_detection_160x160.onnx";
-
 	wrap->wraps.clear();
+	wrap->outputs.clear();
 
-	setup_ort_api(hgt, wrap, path);
+	setup_model_session(hgt, wrap, "grayscale_detection_160x160");
 
 	setup_model_image_input(hgt, wrap, "inputImg", kDetectionInputSize, kDetectionInputSize);
+	setup_model_outputs(hgt, wrap, kDetectionOutputNames, ARRAY_SIZE(kDetectionOutputNames), 0);
 }
 
 
-void
-run_hand_detection(void *ptr)
+//! Fills @p input for the view, returns the transform from the model input back to the camera image.
+static cv::Matx23f
+hand_detection_prepare(hand_detection_run_info *info, float *input, cv::Mat &out_binned_uint8)
 {
-	XRT_TRACE_MARKER();
-
-	hand_detection_run_info *info = (hand_detection_run_info *)ptr;
 	ht_view *view = info->view;
-	HandTracking *hgt = view->hgt;
-	onnx_wrap *wrap = &view->detection;
-
-	cv::Mat &orig_data = view->run_model_on_this;
-
-	cv::Mat binned_uint8;
+	cv::Mat &orig_data = info->image;
 
 	xrt_size desired_bin_size;
 	desired_bin_size.h = kDetectionInputSize;
 	desired_bin_size.w = kDetectionInputSize;
 
-	cv::Matx23f go_back = blackbar(orig_data, view->camera_info.camera_orientation, binned_uint8, desired_bin_size);
+	cv::Matx23f go_back =
+	    blackbar(orig_data, view->camera_info.camera_orientation, out_binned_uint8, desired_bin_size);
 
 	cv::Mat binned_float_wrapper_mat(cv::Size(kDetectionInputSize, kDetectionInputSize),
-	                                 CV_32FC1,            //
-	                                 wrap->wraps[0].data, //
+	                                 CV_32FC1, //
+	                                 input,    //
 	                                 kDetectionInputSize * sizeof(float));
 
-	normalizeGrayscaleImage(binned_uint8, binned_float_wrapper_mat);
-
-	const OrtValue *inputs[] = {wrap->wraps[0].tensor};
-	const char *input_names[] = {wrap->wraps[0].name};
-
-	OrtValue *output_tensors[] = {nullptr, nullptr, nullptr, nullptr};
-	const char *output_names[] = {"hand_exists", "cx", "cy", "size"};
-
-	{
-		XRT_TRACE_IDENT(model);
-		static_assert(ARRAY_SIZE(input_names) == ARRAY_SIZE(inputs));
-		static_assert(ARRAY_SIZE(output_names) == ARRAY_SIZE(output_tensors));
-		ORT(Run(wrap->session, nullptr, input_names, inputs, ARRAY_SIZE(input_names), output_names,
-		        ARRAY_SIZE(output_names), output_tensors));
-	}
-
-	float *hand_exists = nullptr;
-	float *cx = nullptr;
-	float *cy = nullptr;
-	float *sizee = nullptr;
-
-	ORT(GetTensorMutableData(output_tensors[0], (void **)&hand_exists));
-	ORT(GetTensorMutableData(output_tensors[1], (void **)&cx));
-	ORT(GetTensorMutableData(output_tensors[2], (void **)&cy));
-	ORT(GetTensorMutableData(output_tensors[3], (void **)&sizee));
+	normalizeGrayscaleImage(out_binned_uint8, binned_float_wrapper_mat);
 
+	return go_back;
+}
 
+static void
+hand_detection_interpret(hand_detection_run_info *info,
+                         const cv::Matx23f &go_back,
+                         const cv::Mat &binned_uint8,
+                         const float *hand_exists,
+                         const float *cx,
+                         const float *cy,
+                         const float *sizee)
+{
+	ht_view *view = info->view;
+	HandTracking *hgt = view->hgt;
 
 	for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
 		hand_region_of_interest &output = info->outputs[hand_idx];
@@ -408,12 +839,12 @@ run_hand_detection(void *ptr)
 			output.center_px = _pt;
 			output.size_px = size;
 
-			if (hgt->debug_scribble) {
+			if (info->scribble) {
 				handSquare(debug_frame, output.center_px, output.size_px, PINK);
 			}
 		}
 
-		if (hgt->debug_scribble) {
+		if (info->scribble) {
 			// note: this will multiply the model outputs by 255, don't do anything with them after this.
 			int top_of_rect_y = kVisSpacerSize; // 8 + 128 + 8 + 128 + 8;
 			int left_of_rect_x = kVisSpacerSize + ((kKeypointInputSize + kVisSpacerSize) * 4);
@@ -423,41 +854,105 @@ run_hand_detection(void *ptr)
 			binned_uint8.copyTo(hgt->visualizers.mat(p));
 		}
 	}
+}
 
-	for (size_t i = 0; i < ARRAY_SIZE(output_tensors); i++) {
-		wrap->api->ReleaseValue(output_tensors[i]);
+void
+run_hand_detection(void *ptr)
+{
+	XRT_TRACE_MARKER();
+
+	hand_detection_run_info *info = (hand_detection_run_info *)ptr;
+	ht_view *view = info->view;
+	HandTracking *hgt = view->hgt;
+	onnx_wrap *wrap = &view->detection;
+
+	cv::Mat &binned_uint8 = wrap->images_uint8[0];
+
+	cv::Matx23f go_back = hand_detection_prepare(info, wrap->wraps[0].data, binned_uint8);
+
+	const OrtValue *inputs[] = {wrap->wraps[0].tensor};
+	const char *input_names[] = {wrap->wraps[0].name};
+
+	OrtValue *output_tensors[ARRAY_SIZE(kDetectionOutputNames)] = {};
+	get_output_tensors(wrap, 0, output_tensors, ARRAY_SIZE(output_tensors));
+
+	{
+		XRT_TRACE_IDENT(model);
+		static_assert(ARRAY_SIZE(input_names) == ARRAY_SIZE(inputs));
+		ORT(Run(wrap->session, nullptr, input_names, inputs, ARRAY_SIZE(input_names), kDetectionOutputNames,
+		        ARRAY_SIZE(kDetectionOutputNames), output_tensors));
 	}
+
+	float *hand_exists = nullptr;
+	float *cx = nullptr;
+	float *cy = nullptr;
+	float *sizee = nullptr;
+
+	ORT(GetTensorMutableData(output_tensors[0], (void **)&hand_exists));
+	ORT(GetTensorMutableData(output_tensors[1], (void **)&cx));
+	ORT(GetTensorMutableData(output_tensors[2], (void **)&cy));
+	ORT(GetTensorMutableData(output_tensors[3], (void **)&sizee));
+
+	hand_detection_interpret(info, go_back, binned_uint8, hand_exists, cx, cy, sizee);
+
+	release_ort_outputs(wrap, 0, output_tensors, ARRAY_SIZE(output_tensors));
 }
 
 void
-init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap)
+run_hand_detection_batched(HandTracking *hgt, hand_detection_run_info *infos, int count)
 {
+	XRT_TRACE_MARKER();
 
-	std::filesystem::path path = hgt->models_folder;
+	assert(count > 0 && count <= 2);
 
-	path /= "grayscale_keypoint_jan18.onnx";
+	onnx_wrap *wrap = &hgt->batched.detection;
+	constexpr size_t image_size = kDetectionInputSize * kDetectionInputSize;
 
-	wrap->wraps.clear();
+	cv::Mat *binned_uint8 = wrap->images_uint8;
+	cv::Matx23f go_back[2];
 
+	for (int i = 0; i < count; i++) {
+		go_back[i] = hand_detection_prepare(&infos[i], wrap->wraps[0].data + i * image_size, binned_uint8[i]);
+	}
 
-	wrap->api = OrtGetApiBase()->GetApi(ORT_API_VERSION);
+	const OrtValue *input_tensors[] = {get_run_tensor(wrap->wraps[0], count)};
+	const char *input_names[] = {wrap->wraps[0].name};
 
+	OrtValue *output_tensors[ARRAY_SIZE(kDetectionOutputNames)] = {};
+	get_output_tensors(wrap, count, output_tensors, ARRAY_SIZE(output_tensors));
 
-	OrtSessionOptions *opts = nullptr;
-	ORT(CreateSessionOptions(&opts));
+	{
+		XRT_TRACE_IDENT(model);
+		static_assert(ARRAY_SIZE(input_names) == ARRAY_SIZE(input_tensors));
+		ORT(Run(wrap->session, nullptr, input_names, input_tensors, ARRAY_SIZE(input_names),
+		        kDetectionOutputNames, ARRAY_SIZE(kDetectionOutputNames), output_tensors));
+	}
 
-	// TODO review options, config for threads?
-	ORT(SetSessionGraphOptimizationLevel(opts, ORT_ENABLE_ALL));
-	ORT(SetIntraOpNumThreads(opts, 1));
+	float *outputs[ARRAY_SIZE(output_tensors)] = {};
+	size_t strides[ARRAY_SIZE(output_tensors)] = {};
+	for (size_t i = 0; i < ARRAY_SIZE(output_tensors); i++) {
+		ORT(GetTensorMutableData(output_tensors[i], (void **)&outputs[i]));
+		strides[i] = get_batch_stride(hgt, wrap, i, output_tensors[i], count);
+	}
 
+	for (int i = 0; i < count; i++) {
+		hand_detection_interpret(&infos[i], go_back[i], binned_uint8[i], //
+		                         outputs[0] + i * strides[0],           //
+		                         outputs[1] + i * strides[1],           //
+		                         outputs[2] + i * strides[2],           //
+		                         outputs[3] + i * strides[3]);          //
+	}
 
-	ORT(CreateEnv(ORT_LOGGING_LEVEL_FATAL, "monado_ht", &wrap->env));
+	release_ort_outputs(wrap, count, output_tensors, ARRAY_SIZE(output_tensors));
+}
 
-	ORT(CreateCpuMemoryInfo(OrtArenaAllocator, OrtMemTypeDefault, &wrap->meminfo));
+void
+init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap)
+{
+	wrap->wraps.clear();
+	wrap->outputs.clear();
 
-	// HG_DEBUG(this->device, "Loading hand detection model from file '%s'", path.c_str());
-	ORT(CreateSession(wrap->env, path.c_str(), opts, &wrap->session));
-	assert(wrap->session != NULL);
+	hgt->quantized_keypoint_model = setup_model_session(hgt, wrap, "grayscale_keypoint_jan18");
 
 	// size_t input_size = wrap->input_shape[0] * wrap->input_shape[1] * wrap->input_shape[2] *
 	// wrap->input_shape[3];
@@ -543,8 +1038,7 @@ init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap)
 		wrap->wraps.push_back(inputimg);
 	}
 
-
-	wrap->api->ReleaseSessionOptions(opts);
+	setup_model_outputs(hgt, wrap, kKeypointOutputNames, ARRAY_SIZE(kKeypointOutputNames), 0);
 }
 
 enum xrt_hand_joint joints_ml_to_xr[21]{
@@ -633,25 +1127,26 @@ set_predicted_zero(float *data)
 	}
 }
 
-void
-run_keypoint_estimation(void *ptr)
+/*!
+ * Projects the hand's region of interest and fills the three model inputs,
+ * returns false if the image is already known to not contain a hand.
+ */
+static bool
+keypoint_estimation_prepare(const keypoint_estimation_run_info &info,
+                            float *image,
+                            float *last_keypoints,
+                            float *use_last_keypoints,
+                            cv::Mat &data_128x128_uint8)
 {
-	XRT_TRACE_MARKER();
-	keypoint_estimation_run_info info = *(keypoint_estimation_run_info *)ptr;
-
-	onnx_wrap *wrap = &info.view->keypoint[info.hand_idx];
 	struct HandTracking *hgt = info.view->hgt;
+	uint64_t start_ns = os_monotonic_get_ns();
 
 	int view_idx = info.view->view;
 	int hand_idx = info.hand_idx;
 	one_frame_one_view &this_output = hgt->keypoint_outputs[hand_idx].views[view_idx];
-	MLOutput2D &px_coord = this_output.keypoints_in_scaled_stereographic;
-	// Factor out starting here
 
 	hand_region_of_interest &output = info.view->regions_of_interest_this_frame[hand_idx];
 
-	cv::Mat data_128x128_uint8;
-
 	projection_instructions instr(info.view->hgdist);
 	instr.rot_quat = Eigen::Quaternionf::Identity();
 	instr.stereographic_radius = 0.4;
@@ -709,8 +1204,8 @@ run_keypoint_estimation(void *ptr)
 		make_projection_instructions_angular(center, hand_idx, angle,
 		                                     hgt->tuneable_values.after_detection_fac.val, twist, instr);
 
-		wrap->wraps[2].data[0] = 0.0f;
-		set_predicted_zero(wrap->wraps[1].data);
+		*use_last_keypoints = 0.0f;
+		set_predicted_zero(last_keypoints);
 	} else {
 		Eigen::Array<float, 3, 21> keypoints_in_camera;
 
@@ -736,17 +1231,17 @@ run_keypoint_estimation(void *ptr)
 
 		if (hgt->tuneable_values.enable_pose_predicted_input) {
 			for (int ml_joint_idx = 0; ml_joint_idx < 21; ml_joint_idx++) {
-				float *data = wrap->wraps[1].data;
+				float *data = last_keypoints;
 				data[(ml_joint_idx * 2) + 0] = bleh[ml_joint_idx].pos_2d.x;
 				data[(ml_joint_idx * 2) + 1] = bleh[ml_joint_idx].pos_2d.y;
 				// data[(ml_joint_idx * 2) + 2] = bleh[ml_joint_idx].depth_relative_to_midpxm;
 			}
 
 
-			wrap->wraps[2].data[0] = 1.0f;
+			*use_last_keypoints = 1.0f;
 		} else {
-			wrap->wraps[2].data[0] = 0.0f;
-			set_predicted_zero(wrap->wraps[1].data);
+			*use_last_keypoints = 0.0f;
+			set_predicted_zero(last_keypoints);
 		}
 	}
 
@@ -763,39 +1258,31 @@ run_keypoint_estimation(void *ptr)
 	{
 		XRT_TRACE_IDENT(convert_format);
 
-		// here!
-		cv::Mat data_128x128_float(cv::Size(128, 128), CV_32FC1, wrap->wraps[0].data, 128 * sizeof(float));
+		cv::Mat data_128x128_float(cv::Size(128, 128), CV_32FC1, image, 128 * sizeof(float));
 
 		is_hand = is_hand && normalizeGrayscaleImage(data_128x128_uint8, data_128x128_float);
 	}
 
+	hgt->keypoint_warp_ns += os_monotonic_get_ns() - start_ns;
 
-	// Ending here
-
-
-	const OrtValue *inputs[] = {wrap->wraps[0].tensor, wrap->wraps[1].tensor, wrap->wraps[2].tensor};
-	const char *input_names[] = {wrap->wraps[0].name, wrap->wraps[1].name, wrap->wraps[2].name};
-
-	OrtValue *output_tensors[] = {nullptr, nullptr, nullptr, nullptr};
-	const char *output_names[] = {"heatmap_xy", "heatmap_depth", "scalar_extras", "curls"};
-
-	{
-		XRT_TRACE_IDENT(model);
-		assert(ARRAY_SIZE(input_names) == ARRAY_SIZE(inputs));
-		assert(ARRAY_SIZE(output_names) == ARRAY_SIZE(output_tensors));
-		ORT(Run(wrap->session, nullptr, input_names, inputs, ARRAY_SIZE(input_names), output_names,
-		        ARRAY_SIZE(output_names), output_tensors));
-	}
-
-	// To here
-
-	// Interpret model outputs!
-
-
-	float *out_data = nullptr;
+	return is_hand;
+}
 
+static void
+keypoint_estimation_interpret(const keypoint_estimation_run_info &info,
+                              bool is_hand,
+                              const cv::Mat &data_128x128_uint8,
+                              float *out_data,
+                              float *out_data_depth,
+                              float *out_data_extras,
+                              float *out_data_curls)
+{
+	struct HandTracking *hgt = info.view->hgt;
 
-	ORT(GetTensorMutableData(output_tensors[0], (void **)&out_data));
+	int view_idx = info.view->view;
+	int hand_idx = info.hand_idx;
+	one_frame_one_view &this_output = hgt->keypoint_outputs[hand_idx].views[view_idx];
+	MLOutput2D &px_coord = this_output.keypoints_in_scaled_stereographic;
 
 	// I don't know why this was added
 	// float *confidences = info.view->keypoint_outputs.views[hand_idx].confidences;
@@ -814,6 +1301,13 @@ run_keypoint_estimation(void *ptr)
 			CHECK_NOT_NAN(data[i]);
 		}
 
+		// Dequantized heatmaps have a noise floor around zero, it throws off the refinement below.
+		if (hgt->quantized_keypoint_model) {
+			for (size_t x = 0; x < plane_size; x++) {
+				data[x] = fmaxf(data[x], 0.0f);
+			}
+		}
+
 
 		int out_idx = argmax(data, 22 * 22);
 		int row = out_idx / 22;
@@ -839,9 +1333,6 @@ run_keypoint_estimation(void *ptr)
 	}
 
 
-	float *out_data_depth = nullptr;
-	ORT(GetTensorMutableData(output_tensors[1], (void **)&out_data_depth));
-
 	for (int joint_idx = 0; joint_idx < 21; joint_idx++) {
 		float *p_ptr = &out_data_depth[(joint_idx * 22)];
 
@@ -860,9 +1351,6 @@ run_keypoint_estimation(void *ptr)
 		}
 	}
 
-	float *out_data_extras = nullptr;
-	ORT(GetTensorMutableData(output_tensors[2], (void **)&out_data_extras));
-
 	float is_hand_explicit = out_data_extras[0];
 
 	is_hand_explicit = (1.0) / (1.0 + powf(2.71828182845904523536, -is_hand_explicit));
@@ -878,9 +1366,6 @@ run_keypoint_estimation(void *ptr)
 	this_output.active = is_hand;
 
 
-	float *out_data_curls = nullptr;
-	ORT(GetTensorMutableData(output_tensors[3], (void **)&out_data_curls));
-
 	for (int i = 0; i < 5; i++) {
 		float curl = out_data_curls[i];
 		float variance = out_data_curls[5 + i];
@@ -965,20 +1450,179 @@ run_keypoint_estimation(void *ptr)
 			cv::line(hgt->visualizers.mat, center, pt2, {0}, 1);
 		}
 	}
+}
+
+void
+run_keypoint_estimation(void *ptr)
+{
+	XRT_TRACE_MARKER();
+	keypoint_estimation_run_info info = *(keypoint_estimation_run_info *)ptr;
+
+	onnx_wrap *wrap = &info.view->keypoint[info.hand_idx];
+	struct HandTracking *hgt = info.view->hgt;
+
+	cv::Mat &data_128x128_uint8 = wrap->images_uint8[0];
+
+	bool is_hand = keypoint_estimation_prepare(info, wrap->wraps[0].data, wrap->wraps[1].data,
+	                                           wrap->wraps[2].data, data_128x128_uint8);
+
+	const OrtValue *inputs[] = {wrap->wraps[0].tensor, wrap->wraps[1].tensor, wrap->wraps[2].tensor};
+	const char *input_names[] = {wrap->wraps[0].name, wrap->wraps[1].name, wrap->wraps[2].name};
+
+	OrtValue *output_tensors[ARRAY_SIZE(kKeypointOutputNames)] = {};
+	get_output_tensors(wrap, 0, output_tensors, ARRAY_SIZE(output_tensors));
+
+	{
+		XRT_TRACE_IDENT(model);
+		assert(ARRAY_SIZE(input_names) == ARRAY_SIZE(inputs));
+		ORT(Run(wrap->session, nullptr, input_names, inputs, ARRAY_SIZE(input_names), kKeypointOutputNames,
+		        ARRAY_SIZE(kKeypointOutputNames), output_tensors));
+	}
 
+	float *outputs[ARRAY_SIZE(output_tensors)] = {};
 	for (size_t i = 0; i < ARRAY_SIZE(output_tensors); i++) {
-		wrap->api->ReleaseValue(output_tensors[i]);
+		ORT(GetTensorMutableData(output_tensors[i], (void **)&outputs[i]));
 	}
+
+	keypoint_estimation_interpret(info, is_hand, data_128x128_uint8, outputs[0], outputs[1], outputs[2],
+	                              outputs[3]);
+
+	release_ort_outputs(wrap, 0, output_tensors, ARRAY_SIZE(output_tensors));
+}
+
+//! One item of a batched keypoint estimation run, prepared on the worker group.
+struct keypoint_batch_item
+{
+	keypoint_estimation_run_info info;
+	onnx_wrap *wrap;
+	int index;
+
+	bool is_hand;
+};
+
+static void
+keypoint_batch_item_prepare(void *ptr)
+{
+	XRT_TRACE_MARKER();
+
+	keypoint_batch_item *item = (keypoint_batch_item *)ptr;
+	std::vector<model_input_wrap> &w = item->wrap->wraps;
+	constexpr size_t image_size = kKeypointInputSize * kKeypointInputSize;
+
+	item->is_hand = keypoint_estimation_prepare(item->info,                        //
+	                                            w[0].data + item->index * image_size, //
+	                                            w[1].data + item->index * 42,      //
+	                                            w[2].data + item->index,           //
+	                                            item->wrap->images_uint8[item->index]);
+}
+
+void
+run_keypoint_estimation_batched(HandTracking *hgt, keypoint_estimation_run_info *infos, int count)
+{
+	XRT_TRACE_MARKER();
+
+	assert(count > 0 && count <= 4);
+
+	onnx_wrap *wrap = &hgt->batched.keypoint;
+	keypoint_batch_item items[4];
+
+	for (int i = 0; i < count; i++) {
+		items[i].info = infos[i];
+		items[i].wrap = wrap;
+		items[i].index = i;
+		u_worker_group_push(hgt->group, keypoint_batch_item_prepare, &items[i]);
+	}
+	u_worker_group_wait_all(hgt->group);
+
+	const OrtValue *input_tensors[] = {
+	    get_run_tensor(wrap->wraps[0], count),
+	    get_run_tensor(wrap->wraps[1], count),
+	    get_run_tensor(wrap->wraps[2], count),
+	};
+	const char *input_names[] = {wrap->wraps[0].name, wrap->wraps[1].name, wrap->wraps[2].name};
+
+	OrtValue *output_tensors[ARRAY_SIZE(kKeypointOutputNames)] = {};
+	get_output_tensors(wrap, count, output_tensors, ARRAY_SIZE(output_tensors));
+
+	{
+		XRT_TRACE_IDENT(model);
+		static_assert(ARRAY_SIZE(input_names) == ARRAY_SIZE(input_tensors));
+		ORT(Run(wrap->session, nullptr, input_names, input_tensors, ARRAY_SIZE(input_names),
+		        kKeypointOutputNames, ARRAY_SIZE(kKeypointOutputNames), output_tensors));
+	}
+
+	float *outputs[ARRAY_SIZE(output_tensors)] = {};
+	size_t strides[ARRAY_SIZE(output_tensors)] = {};
+	for (size_t i = 0; i < ARRAY_SIZE(output_tensors); i++) {
+		ORT(GetTensorMutableData(output_tensors[i], (void **)&outputs[i]));
+		strides[i] = get_batch_stride(hgt, wrap, i, output_tensors[i], count);
+	}
+
+	for (int i = 0; i < count; i++) {
+		keypoint_estimation_interpret(items[i].info, items[i].is_hand, wrap->images_uint8[i],      //
+		                              outputs[0] + i * strides[0],                                 //
+		                              outputs[1] + i * strides[1],                                 //
+		                              outputs[2] + i * strides[2],                                 //
+		                              outputs[3] + i * strides[3]);                                //
+	}
+
+	release_ort_outputs(wrap, count, output_tensors, ARRAY_SIZE(output_tensors));
+}
+
+bool
+init_batched_inference(HandTracking *hgt)
+{
+	// One session now does the work of several, let it use more threads.
+	constexpr int thread_scale = 2;
+
+	onnx_wrap *wrap = &hgt->batched.detection;
+	wrap->wraps.clear();
+	wrap->outputs.clear();
+	setup_model_session(hgt, wrap, "grayscale_detection_160x160", thread_scale);
+	bool dynamic = has_dynamic_batch(hgt, wrap);
+	setup_batched_input(hgt, wrap, "inputImg", 2, {1, kDetectionInputSize, kDetectionInputSize});
+	setup_model_outputs(hgt, wrap, kDetectionOutputNames, ARRAY_SIZE(kDetectionOutputNames), 2);
+
+	wrap = &hgt->batched.keypoint;
+	wrap->wraps.clear();
+	wrap->outputs.clear();
+	setup_model_session(hgt, wrap, "grayscale_keypoint_jan18", thread_scale);
+	dynamic = dynamic && has_dynamic_batch(hgt, wrap);
+	setup_batched_input(hgt, wrap, "inputImg", 4, {1, kKeypointInputSize, kKeypointInputSize});
+	setup_batched_input(hgt, wrap, "lastKeypoints", 4, {42});
+	setup_batched_input(hgt, wrap, "useLastKeypoints", 4, {});
+	setup_model_outputs(hgt, wrap, kKeypointOutputNames, ARRAY_SIZE(kKeypointOutputNames), 4);
+
+	if (!dynamic) {
+		HG_WARN(hgt, "Models do not have a dynamic batch dimension, not batching inference!");
+		release_onnx_wrap(&hgt->batched.detection);
+		release_onnx_wrap(&hgt->batched.keypoint);
+		hgt->batched.detection = {};
+		hgt->batched.keypoint = {};
+		return false;
+	}
+
+	return true;
 }
 
 void
 release_onnx_wrap(onnx_wrap *wrap)
 {
+	// Not all wraps are always set up, like the batched ones.
+	if (wrap->api == nullptr) {
+		return;
+	}
+
 	wrap->api->ReleaseMemoryInfo(wrap->meminfo);
 	wrap->api->ReleaseSession(wrap->session);
-	for (model_input_wrap &a : wrap->wraps) {
-		wrap->api->ReleaseValue(a.tensor);
-		free(a.data);
+	for (std::vector<model_input_wrap> *list : {&wrap->wraps, &wrap->outputs}) {
+		for (model_input_wrap &a : *list) {
+			wrap->api->ReleaseValue(a.tensor);
+			for (OrtValue *tensor : a.batch_tensors) {
+				wrap->api->ReleaseValue(tensor);
+			}
+			free(a.data);
+		}
 	}
 	wrap->api->ReleaseEnv(wrap->env);
 }
@@ -15,6 +15,7 @@
 #include "util/u_box_iou.hpp"
 #include "util/u_hand_tracking.h"
 #include "math/m_vec2.h"
+#include "os/os_time.h"
 #include "util/u_misc.h"
 #include "xrt/xrt_defines.h"
 #include "xrt/xrt_frame.h"
@@ -30,6 +31,16 @@ namespace xrt::tracking::hand::mercury {
 DEBUG_GET_ONCE_LOG_OPTION(mercury_log, "MERCURY_LOG", U_LOGGING_WARN)
 DEBUG_GET_ONCE_BOOL_OPTION(mercury_optimize_hand_size, "MERCURY_optimize_hand_size", true)
 DEBUG_GET_ONCE_FLOAT_OPTION(mercury_min_detection_confidence, "MERCURY_MIN_DETECTION_CONFIDENCE", 0.3)
+DEBUG_GET_ONCE_BOOL_OPTION(mercury_adaptive_detection, "MERCURY_ADAPTIVE_DETECTION", true)
+DEBUG_GET_ONCE_NUM_OPTION(mercury_threads, "MERCURY_THREADS", 4)
+DEBUG_GET_ONCE_BOOL_OPTION(mercury_shared_pool, "MERCURY_SHARED_POOL", false)
+DEBUG_GET_ONCE_BOOL_OPTION(mercury_batched_inference, "MERCURY_BATCHED_INFERENCE", false)
+DEBUG_GET_ONCE_OPTION(mercury_ort_provider, "MERCURY_ORT_PROVIDER", "cpu")
+DEBUG_GET_ONCE_NUM_OPTION(mercury_ort_intra_op_threads, "MERCURY_ORT_INTRA_OP_THREADS", 1)
+DEBUG_GET_ONCE_NUM_OPTION(mercury_ort_inter_op_threads, "MERCURY_ORT_INTER_OP_THREADS", 0)
+DEBUG_GET_ONCE_NUM_OPTION(mercury_ort_optimization_level, "MERCURY_ORT_OPTIMIZATION_LEVEL", 99)
+DEBUG_GET_ONCE_OPTION(mercury_model_variant, "MERCURY_MODEL_VARIANT", "")
+DEBUG_GET_ONCE_BOOL_OPTION(mercury_lazy_models, "MERCURY_LAZY_MODELS", true)
 
 // Flags to tell state tracker that these are indeed valid joints
 static const enum xrt_space_relation_flags valid_flags_ht = (enum xrt_space_relation_flags)(
@@ -375,53 +386,148 @@ hand_bounding_boxes_iou(const hand_region_of_interest &one, const hand_region_of
 	return boxIOU(this_box, other_box);
 }
 
-void
-dispatch_and_process_hand_detections(struct HandTracking *hgt)
+//! Sets up @p infos to run detection on @p images, with nothing found yet.
+static void
+setup_hand_detection_run_infos(struct HandTracking *hgt,
+                               hand_detection_run_info infos[2],
+                               const cv::Mat images[2],
+                               bool scribble)
 {
-	if (hgt->tuneable_values.always_run_detection_model) {
-		// Pretend like nothing was detected last frame.
+	for (int view_idx = 0; view_idx < 2; view_idx++) {
+		infos[view_idx].view = &hgt->views[view_idx];
+		infos[view_idx].image = images[view_idx];
+		infos[view_idx].scribble = scribble;
+
+		// Mega paranoia, should get optimized out.
 		for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
-			hgt->this_frame_hand_detected[hand_idx] = false;
+			infos[view_idx].outputs[hand_idx].found = false;
+			infos[view_idx].outputs[hand_idx].hand_detection_confidence = 0;
+			infos[view_idx].outputs[hand_idx].provenance = ROIProvenance::HAND_DETECTION;
+		}
+	}
+}
 
-			hgt->history_hands[hand_idx].clear();
+//! Runs detection in both views or alternating between them, returns how many views it ran in.
+static int
+run_hand_detections(struct HandTracking *hgt, hand_detection_run_info infos[2], bool both_views, u_worker_group *group)
+{
+	size_t active_camera = hgt->detection_counter++ % 2;
+
+	if (!both_views) {
+		run_hand_detection(&infos[active_camera]);
+		return 1;
+	}
+
+	if (hgt->batched.enabled) {
+		run_hand_detection_batched(hgt, infos, 2);
+	} else {
+		u_worker_group_push(group, run_hand_detection, &infos[0]);
+		u_worker_group_push(group, run_hand_detection, &infos[1]);
+		u_worker_group_wait_all(group);
+	}
+	return 2;
+}
+
+//! Picks up what @ref HandTracking::cCallbackProcessBegin found for this frame, returns the number of views.
+static int
+take_lookahead_hand_detections(struct HandTracking *hgt, hand_detection_run_info infos[2])
+{
+	std::scoped_lock lock(hgt->lookahead.mutex);
+
+	for (hand_detection_lookahead &slot : hgt->lookahead.slots) {
+		if (slot.timestamp != hgt->current_frame_timestamp || slot.num_views == 0) {
+			continue;
 		}
+
+		infos[0] = slot.infos[0];
+		infos[1] = slot.infos[1];
+		return slot.num_views;
 	}
 
-	hand_detection_run_info infos[2] = {};
+	return 0;
+}
+
+/*!
+ * Fills @p infos with what the @ref t_hand_detection_source found for the frames with @p timestamp, returns the number
+ * of views or zero if it has nothing for them.
+ */
+static int
+take_source_hand_detections(struct HandTracking *hgt,
+                            uint64_t timestamp,
+                            hand_detection_run_info infos[2],
+                            bool scribble)
+{
+	if (hgt->detection_source == nullptr) {
+		return 0;
+	}
+
+	struct t_hand_detections detections = {};
+	if (!t_hand_detection_source_get(hgt->detection_source, timestamp, &detections)) {
+		return 0;
+	}
 
-	// Mega paranoia, should get optimized out.
 	for (int view_idx = 0; view_idx < 2; view_idx++) {
+		infos[view_idx].view = &hgt->views[view_idx];
+		infos[view_idx].scribble = scribble;
+
 		for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
-			infos[view_idx].outputs[hand_idx].found = false;
-			infos[view_idx].outputs[hand_idx].hand_detection_confidence = 0;
-			infos[view_idx].outputs[hand_idx].provenance = ROIProvenance::HAND_DETECTION;
+			const struct t_hand_detection &in = detections.views[view_idx][hand_idx];
+			hand_region_of_interest &output = infos[view_idx].outputs[hand_idx];
+
+			output.provenance = ROIProvenance::HAND_DETECTION;
+			output.found = in.found && in.confidence > hgt->tuneable_values.min_detection_confidence.val;
+			output.hand_detection_confidence = output.found ? in.confidence : 0;
+			output.center_px = in.center_px;
+			output.size_px = in.size_px;
+
+			if (scribble && output.found) {
+				cv::Mat &debug_frame = hgt->views[view_idx].debug_out_to_this;
+				handSquare(debug_frame, output.center_px, output.size_px, PINK);
+			}
 		}
 	}
 
+	return 2;
+}
 
+void
+dispatch_and_process_hand_detections(struct HandTracking *hgt)
+{
+	if (hgt->tuneable_values.always_run_detection_model) {
+		// Pretend like nothing was detected last frame.
+		for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
+			hgt->this_frame_hand_detected[hand_idx] = false;
 
-	infos[0].view = &hgt->views[0];
-	infos[1].view = &hgt->views[1];
-
+			hgt->history_hands[hand_idx].clear();
+		}
+	}
 
+	hand_detection_run_info infos[2] = {};
 
 	bool no_hands_detected_last_frame = !(hgt->this_frame_hand_detected[0] || hgt->this_frame_hand_detected[1]);
 
-	size_t active_camera = hgt->detection_counter++ % 2;
-
-	int num_views = 0;
+	// Found before the frames got to us, then there is nothing to run.
+	int num_views = take_source_hand_detections(hgt, hgt->current_frame_timestamp, infos, hgt->debug_scribble);
 
-	if (hgt->tuneable_values.always_run_detection_model || hgt->refinement.optimizing ||
-	    hgt->tuneable_values.detection_model_in_both_views) {
-		u_worker_group_push(hgt->group, run_hand_detection, &infos[0]);
-		u_worker_group_push(hgt->group, run_hand_detection, &infos[1]);
-		num_views = 2;
-		u_worker_group_wait_all(hgt->group);
+	if (num_views != 0) {
+		// Nothing to do.
+	} else if (hgt->lookahead.enabled) {
+		// Might find nothing, if the begin call thought detection wasn't needed. It will run next frame.
+		num_views = take_lookahead_hand_detections(hgt, infos);
+		if (num_views == 0) {
+			return;
+		}
 	} else {
-		run_hand_detection(&infos[active_camera]);
-		num_views = 1;
+		const cv::Mat images[2] = {hgt->views[0].run_model_on_this, hgt->views[1].run_model_on_this};
+		setup_hand_detection_run_infos(hgt, infos, images, hgt->debug_scribble);
+
+		bool both_views = hgt->tuneable_values.always_run_detection_model || hgt->refinement.optimizing ||
+		                  hgt->tuneable_values.detection_model_in_both_views;
+		num_views = run_hand_detections(hgt, infos, both_views, hgt->group);
 	}
 
+	hgt->detection_cadence.frames_since_detection = 0;
+
 
 	for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
 		float confidence_sum = (infos[0].outputs[hand_idx].hand_detection_confidence +
@@ -491,6 +597,43 @@ dispatch_and_process_hand_detections(struct HandTracking *hgt)
 	}
 }
 
+/*!
+ * Whether the next frame should run the detection model. With both hands tracked it can't find anything we use, and
+ * with neither it's the only way to get going. With one hand tracked it would otherwise run every frame looking for
+ * the other one, so back off to every @ref hg_tuneable_values::adaptive_detection_max_interval frames while the
+ * tracked hand is confident and its region of interest isn't moving much.
+ */
+static bool
+want_hand_detection(struct HandTracking *hgt)
+{
+	const bool *tracked = hgt->last_frame_hand_detected;
+	const hg_tuneable_values &tv = hgt->tuneable_values;
+
+	if (tracked[0] && tracked[1]) {
+		return false;
+	}
+
+	if (!tv.adaptive_detection || tv.always_run_detection_model || !(tracked[0] || tracked[1])) {
+		return true;
+	}
+
+	if (hgt->detection_cadence.frames_since_detection >= tv.adaptive_detection_max_interval) {
+		return true;
+	}
+
+	for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
+		if (!tracked[hand_idx]) {
+			continue;
+		}
+		if (hgt->detection_cadence.confidence[hand_idx] < tv.adaptive_detection_min_confidence.val ||
+		    hgt->detection_cadence.roi_iou[hand_idx] < tv.adaptive_detection_min_iou.val) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 void
 hand_joint_set_to_eigen_21(const xrt_hand_joint_set &set, Eigen::Array<float, 3, 21> &out)
 {
@@ -665,11 +808,38 @@ scribble_image_boundary(struct HandTracking *hgt)
 HandTracking::HandTracking()
 {
 	this->base.process = &HandTracking::cCallbackProcess;
+	this->base.process_begin = &HandTracking::cCallbackProcessBegin;
 	this->base.destroy = &HandTracking::cCallbackDestroy;
 	u_sink_debug_init(&this->debug_sink_ann);
 	u_sink_debug_init(&this->debug_sink_model);
 }
 
+/*!
+ * Load the models, which takes a good while. Done on the first frames by
+ * default so creating the tracker, and so the system, stays fast and a tracker
+ * that never gets any frames never pays for it.
+ */
+static void
+load_models(HandTracking *hgt)
+{
+	std::call_once(hgt->models_loaded, [hgt] {
+		XRT_TRACE_IDENT(load_models);
+
+		init_hand_detection(hgt, &hgt->views[0].detection);
+		init_hand_detection(hgt, &hgt->views[1].detection);
+
+		init_keypoint_estimation(hgt, &hgt->views[0].keypoint[0]);
+		init_keypoint_estimation(hgt, &hgt->views[0].keypoint[1]);
+
+		init_keypoint_estimation(hgt, &hgt->views[1].keypoint[0]);
+		init_keypoint_estimation(hgt, &hgt->views[1].keypoint[1]);
+
+		if (debug_get_bool_option_mercury_batched_inference()) {
+			hgt->batched.enabled = init_batched_inference(hgt);
+		}
+	});
+}
+
 HandTracking::~HandTracking()
 {
 	u_sink_debug_destroy(&this->debug_sink_ann);
@@ -686,7 +856,17 @@ HandTracking::~HandTracking()
 	release_onnx_wrap(&this->views[1].keypoint[1]);
 	release_onnx_wrap(&this->views[1].detection);
 
+	release_onnx_wrap(&this->batched.detection);
+	release_onnx_wrap(&this->batched.keypoint);
+
 	u_worker_group_reference(&this->group, NULL);
+	u_worker_group_reference(&this->lookahead.group, NULL);
+
+	if (this->pool_is_shared) {
+		u_worker_thread_pool_put_tracking(&this->pool);
+	} else {
+		u_worker_thread_pool_reference(&this->pool, NULL);
+	}
 
 	t_stereo_camera_calibration_reference(&this->calib, NULL);
 
@@ -709,6 +889,11 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 
 	HandTracking *hgt = (struct HandTracking *)ht_sync;
 
+	load_models(hgt);
+
+	uint64_t start_ns = os_monotonic_get_ns();
+	struct t_hand_tracking_mercury_timings timings = {};
+
 	hgt->current_frame_timestamp = left_frame->timestamp;
 
 	struct xrt_hand_joint_set *out_xrt_hands[2] = {out_left_hand, out_right_hand};
@@ -800,14 +985,17 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 
 	check_new_user_event(hgt);
 
-
+	uint64_t detect_start_ns = os_monotonic_get_ns();
+	timings.convert_ns = detect_start_ns - start_ns;
 
 	// Every now and then if we're not already tracking both hands, try to detect new hands.
-	bool saw_both_hands_last_frame = hgt->last_frame_hand_detected[0] && hgt->last_frame_hand_detected[1];
-	if (!saw_both_hands_last_frame) {
+	if (want_hand_detection(hgt)) {
 		dispatch_and_process_hand_detections(hgt);
 	}
 
+	uint64_t keypoint_start_ns = os_monotonic_get_ns();
+	timings.detect_ns = keypoint_start_ns - detect_start_ns;
+
 	stop_everything_if_hands_are_overlapping(hgt);
 
 	//!@todo does this go here?
@@ -822,6 +1010,11 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 
 
 	// Dispatch keypoint estimator neural nets
+	struct keypoint_estimation_run_info batch[4];
+	int batch_count = 0;
+
+	hgt->keypoint_warp_ns = 0;
+
 	for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
 		for (int view_idx = 0; view_idx < 2; view_idx++) {
 			if (!hgt->views[view_idx].regions_of_interest_this_frame[hand_idx].found) {
@@ -831,11 +1024,25 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 			struct keypoint_estimation_run_info &inf = hgt->views[view_idx].run_info[hand_idx];
 			inf.view = &hgt->views[view_idx];
 			inf.hand_idx = hand_idx;
+
+			if (hgt->batched.enabled) {
+				batch[batch_count++] = inf;
+				continue;
+			}
+
 			u_worker_group_push(hgt->group, hgt->keypoint_estimation_run_func,
 			                    &hgt->views[view_idx].run_info[hand_idx]);
 		}
 	}
-	u_worker_group_wait_all(hgt->group);
+
+	if (batch_count > 0) {
+		run_keypoint_estimation_batched(hgt, batch, batch_count);
+	} else {
+		u_worker_group_wait_all(hgt->group);
+	}
+
+	timings.keypoint_ns = os_monotonic_get_ns() - keypoint_start_ns;
+	timings.warp_ns = hgt->keypoint_warp_ns;
 
 	// Spaghetti logic for optimizing hand size
 	bool any_hands_are_only_visible_in_one_view = false;
@@ -945,6 +1152,7 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 
 		//!@todo optimize: We can have one of these on each thread
 		float reprojection_error;
+		uint64_t optimizer_start_ns = os_monotonic_get_ns();
 		lm::optimizer_run(hand,                                     //
 		                  hgt->keypoint_outputs[hand_idx],          //
 		                  !hgt->last_frame_hand_detected[hand_idx], //
@@ -956,8 +1164,10 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 		                  *put_in_set,   //
 		                  out_hand_size, //
 		                  reprojection_error);
+		timings.kine_lm_ns += os_monotonic_get_ns() - optimizer_start_ns;
 
-
+		hgt->detection_cadence.confidence[hand_idx] =
+		    hand_confidence_value(reprojection_error, hgt->keypoint_outputs[hand_idx]);
 
 		if (reprojection_error > reprojection_error_threshold) {
 			HG_DEBUG(hgt, "Reprojection error above threshold!");
@@ -1028,11 +1238,41 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 		}
 	}
 
+	hgt->detection_cadence.frames_since_detection++;
+
+	// Same decisions as at the start of this function, for the begin call that is probably already running.
+	// Made before predicting the regions of interest, so the begin call doesn't wait for that.
+	hgt->lookahead.detection_wanted = want_hand_detection(hgt);
+	hgt->lookahead.both_views = hgt->refinement.optimizing || hgt->tuneable_values.detection_model_in_both_views;
+
 	// estimators next frame. Also, if next frame's hand will be outside of the camera's field of view, mark it as
 	// inactive this frame. This stops issues where our hand detector detects hands that are slightly too close to
 	// the edge, causing flickery hands.
 	if (!hgt->tuneable_values.always_run_detection_model) {
+		hand_region_of_interest old_rois[2][2];
+		for (int view_idx = 0; view_idx < 2; view_idx++) {
+			const hand_region_of_interest *rois = hgt->views[view_idx].regions_of_interest_this_frame;
+			old_rois[view_idx][0] = rois[0];
+			old_rois[view_idx][1] = rois[1];
+		}
+
 		predict_new_regions_of_interest(hgt);
+
+		// How much the hands move in the image, a lost region of interest counts as no overlap.
+		for (int hand_idx = 0; hand_idx < 2; hand_idx++) {
+			float lowest_iou = 1.0f;
+			for (int view_idx = 0; view_idx < 2; view_idx++) {
+				const hand_region_of_interest &old_roi = old_rois[view_idx][hand_idx];
+				const hand_region_of_interest &new_roi =
+				    hgt->views[view_idx].regions_of_interest_this_frame[hand_idx];
+				if (old_roi.found) {
+					float iou = std::max(hand_bounding_boxes_iou(old_roi, new_roi), 0.0f);
+					lowest_iou = std::min(lowest_iou, iou);
+				}
+			}
+			hgt->detection_cadence.roi_iou[hand_idx] = lowest_iou;
+		}
+
 		bool still_found[2] = {hgt->last_frame_hand_detected[0], hgt->last_frame_hand_detected[1]};
 		still_found[0] = hgt->views[0].regions_of_interest_this_frame[0].found ||
 		                 hgt->views[1].regions_of_interest_this_frame[0].found;
@@ -1054,6 +1294,9 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 	// If the debug UI is active, push to the frame-timing widget
 	u_frame_times_widget_push_sample(&hgt->ft_widget, hgt->current_frame_timestamp);
 
+	timings.total_ns = os_monotonic_get_ns() - start_ns;
+	hgt->timings = timings;
+
 	// If the debug UI is active, push our debug frame
 	if (hgt->debug_scribble) {
 		u_sink_debug_push_frame(&hgt->debug_sink_ann, debug_frame);
@@ -1069,6 +1312,52 @@ HandTracking::cCallbackProcess(struct t_hand_tracking_sync *ht_sync,
 	// done!
 }
 
+void
+HandTracking::cCallbackProcessBegin(struct t_hand_tracking_sync *ht_sync,
+                                    struct xrt_frame *left_frame,
+                                    struct xrt_frame *right_frame)
+{
+	XRT_TRACE_MARKER();
+
+	HandTracking *hgt = (struct HandTracking *)ht_sync;
+
+	load_models(hgt);
+
+	hgt->lookahead.enabled = true;
+
+	// The previous frame is still being finished, so these are from the one before it.
+	bool always_run = hgt->tuneable_values.always_run_detection_model;
+	bool needed = always_run || hgt->lookahead.detection_wanted;
+	bool both_views = always_run || hgt->lookahead.both_views;
+
+	hand_detection_lookahead result = {};
+	result.timestamp = left_frame->timestamp;
+
+	// Process will pick them up from the source instead.
+	if (needed && hgt->detection_source != nullptr) {
+		struct t_hand_detections unused = {};
+		needed = !t_hand_detection_source_get(hgt->detection_source, left_frame->timestamp, &unused);
+	}
+
+	if (needed) {
+		const cv::Mat images[2] = {
+		    cv::Mat(cv::Size(left_frame->width, left_frame->height), CV_8UC1, left_frame->data,
+		            left_frame->stride),
+		    cv::Mat(cv::Size(right_frame->width, right_frame->height), CV_8UC1, right_frame->data,
+		            right_frame->stride),
+		};
+
+		// The debug images belong to the frame being finished, don't draw on them.
+		setup_hand_detection_run_infos(hgt, result.infos, images, false);
+		result.num_views = run_hand_detections(hgt, result.infos, both_views, hgt->lookahead.group);
+	}
+
+	// The other slot is for the frame being finished right now.
+	std::scoped_lock lock(hgt->lookahead.mutex);
+	hgt->lookahead.slots[hgt->lookahead.next_slot] = result;
+	hgt->lookahead.next_slot = (hgt->lookahead.next_slot + 1) % 2;
+}
+
 void
 HandTracking::cCallbackDestroy(t_hand_tracking_sync *ht_sync)
 {
@@ -1111,32 +1400,62 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
 	getCalibration(hgt, *calib);
 	strncpy(hgt->models_folder, models_folder, ARRAY_SIZE(hgt->models_folder) - 1);
 
+	hgt->ort_options.provider = xrt::tracking::hand::mercury::debug_get_option_mercury_ort_provider();
+	hgt->ort_options.intra_op_threads =
+	    std::max(1, (int)xrt::tracking::hand::mercury::debug_get_num_option_mercury_ort_intra_op_threads());
+	hgt->ort_options.inter_op_threads =
+	    std::max(0, (int)xrt::tracking::hand::mercury::debug_get_num_option_mercury_ort_inter_op_threads());
+
+	hgt->model_variant = xrt::tracking::hand::mercury::debug_get_option_mercury_model_variant();
+
+	// Same numbers as GraphOptimizationLevel, 0, 1, 2 and 99.
+	long optimization_level = xrt::tracking::hand::mercury::debug_get_num_option_mercury_ort_optimization_level();
+	if (optimization_level <= 0) {
+		hgt->ort_options.optimization_level = ORT_DISABLE_ALL;
+	} else if (optimization_level == 1) {
+		hgt->ort_options.optimization_level = ORT_ENABLE_BASIC;
+	} else if (optimization_level == 2) {
+		hgt->ort_options.optimization_level = ORT_ENABLE_EXTENDED;
+	} else {
+		hgt->ort_options.optimization_level = ORT_ENABLE_ALL;
+	}
+
 
 	hgt->views[0].hgt = hgt;
 	hgt->views[1].hgt = hgt; // :)
 
 	hgt->hand_masks_sink = create_info.masks_sink;
+	hgt->detection_source = create_info.detections;
 
 	struct t_camera_extra_info &extra_camera_info = create_info.cams_info;
 	hgt->views[0].camera_info = extra_camera_info.views[0];
 	hgt->views[1].camera_info = extra_camera_info.views[1];
 
-	init_hand_detection(hgt, &hgt->views[0].detection);
-	init_hand_detection(hgt, &hgt->views[1].detection);
-
-	init_keypoint_estimation(hgt, &hgt->views[0].keypoint[0]);
-	init_keypoint_estimation(hgt, &hgt->views[0].keypoint[1]);
-
-	init_keypoint_estimation(hgt, &hgt->views[1].keypoint[0]);
-	init_keypoint_estimation(hgt, &hgt->views[1].keypoint[1]);
 	hgt->keypoint_estimation_run_func = xrt::tracking::hand::mercury::run_keypoint_estimation;
 
+	if (!xrt::tracking::hand::mercury::debug_get_bool_option_mercury_lazy_models()) {
+		load_models(hgt);
+	}
+
 	hgt->views[0].view = 0;
 	hgt->views[1].view = 1;
 
-	int num_threads = 4;
-	hgt->pool = u_worker_thread_pool_create(num_threads - 1, num_threads, "Hand Tracking");
+	hgt->pool = NULL;
+	if (create_info.pool != NULL) {
+		u_worker_thread_pool_reference(&hgt->pool, create_info.pool);
+	} else if (debug_get_bool_option_mercury_shared_pool()) {
+		hgt->pool = u_worker_thread_pool_get_tracking();
+		hgt->pool_is_shared = hgt->pool != NULL;
+	}
+
+	if (hgt->pool == NULL) {
+		int num_threads = (int)debug_get_num_option_mercury_threads();
+		num_threads = CLAMP(num_threads, 1, 16);
+		hgt->pool = u_worker_thread_pool_create_with_role(num_threads - 1, num_threads, "Hand Tracking",
+		                                                 U_THREAD_ROLE_TRACKING);
+	}
 	hgt->group = u_worker_group_create(hgt->pool);
+	hgt->lookahead.group = u_worker_group_create(hgt->pool);
 
 	lm::optimizer_create(hgt->left_in_right, false, hgt->log_level, &hgt->kinematic_hands[0]);
 	lm::optimizer_create(hgt->left_in_right, true, hgt->log_level, &hgt->kinematic_hands[1]);
@@ -1221,6 +1540,19 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
 	hgt->tuneable_values.min_detection_confidence.step = 0.01f;
 	hgt->tuneable_values.min_detection_confidence.val = debug_get_float_option_mercury_min_detection_confidence();
 
+	// On the scale of hand_confidence_value, tuned by looking at it.
+	hgt->tuneable_values.adaptive_detection_min_confidence.max = 1.0f;
+	hgt->tuneable_values.adaptive_detection_min_confidence.min = 0.0f;
+	hgt->tuneable_values.adaptive_detection_min_confidence.step = 0.01f;
+	hgt->tuneable_values.adaptive_detection_min_confidence.val = 0.25f;
+
+	hgt->tuneable_values.adaptive_detection_min_iou.max = 1.0f;
+	hgt->tuneable_values.adaptive_detection_min_iou.min = 0.0f;
+	hgt->tuneable_values.adaptive_detection_min_iou.step = 0.01f;
+	hgt->tuneable_values.adaptive_detection_min_iou.val = 0.6f;
+
+	hgt->tuneable_values.adaptive_detection = debug_get_bool_option_mercury_adaptive_detection();
+
 	u_var_add_draggable_f32(hgt, &hgt->tuneable_values.amt_use_depth, "Amount to use depth prediction");
 
 
@@ -1237,11 +1569,18 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
 	u_var_add_draggable_f32(hgt, &hgt->tuneable_values.opt_smooth_factor, "Optimizer smoothing factor");
 	u_var_add_draggable_f32(hgt, &hgt->tuneable_values.max_hand_dist, "Max hand distance");
 	u_var_add_draggable_f32(hgt, &hgt->tuneable_values.min_detection_confidence, "Min detection confidence");
+	u_var_add_draggable_f32(hgt, &hgt->tuneable_values.adaptive_detection_min_confidence,
+	                        "Adaptive detection: min tracking confidence");
+	u_var_add_draggable_f32(hgt, &hgt->tuneable_values.adaptive_detection_min_iou,
+	                        "Adaptive detection: min region of interest IOU");
 
 	u_var_add_i32(hgt, &hgt->tuneable_values.max_num_outside_view,
 	              "max allowed number of hand joints outside view");
 	u_var_add_u64(hgt, &hgt->tuneable_values.num_frames_before_display,
 	              "Number of frames before we show hands to OpenXR");
+	u_var_add_i32(hgt, &hgt->tuneable_values.adaptive_detection_max_interval,
+	              "Adaptive detection: max frames between detections");
+	u_var_add_ro_i32(hgt, &hgt->detection_cadence.frames_since_detection, "Frames since detection");
 
 
 	u_var_add_bool(hgt, &hgt->tuneable_values.scribble_predictions_into_next_frame,
@@ -1250,6 +1589,8 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
 	u_var_add_bool(hgt, &hgt->tuneable_values.scribble_optimizer_outputs, "Scribble kinematic optimizer output");
 	u_var_add_bool(hgt, &hgt->tuneable_values.always_run_detection_model,
 	               "Use detection model instead of pose-predicting into next frame");
+	u_var_add_bool(hgt, &hgt->tuneable_values.adaptive_detection,
+	               "Skip detection while a single tracked hand is confident");
 	u_var_add_bool(hgt, &hgt->tuneable_values.optimize_hand_size, "Optimize hand size");
 	u_var_add_bool(hgt, &hgt->tuneable_values.enable_pose_predicted_input,
 	               "Enable pose-predicted input to keypoint model");
@@ -1266,3 +1607,12 @@ t_hand_tracking_sync_mercury_create(struct t_stereo_camera_calibration *calib,
 
 	return &hgt->base;
 }
+
+extern "C" void
+t_hand_tracking_sync_mercury_get_timings(struct t_hand_tracking_sync *ht_sync,
+                                         struct t_hand_tracking_mercury_timings *out_timings)
+{
+	HandTracking *hgt = (struct HandTracking *)ht_sync;
+
+	*out_timings = hgt->timings;
+}
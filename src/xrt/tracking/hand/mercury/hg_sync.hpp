@@ -42,6 +42,9 @@
 #include <string.h>
 #include <stdint.h>
 
+#include <atomic>
+#include <mutex>
+
 #include <opencv2/opencv.hpp>
 #include <onnxruntime_c_api.h>
 
@@ -63,6 +66,9 @@ using namespace xrt::auxiliary::math;
 static constexpr uint16_t kDetectionInputSize = 160;
 static constexpr uint16_t kKeypointInputSize = 128;
 
+//! Both views for detection, and both hands in both views for keypoint estimation.
+static constexpr int kMaxBatchSize = 4;
+
 static constexpr uint16_t kKeypointOutputHeatmapSize = 22;
 static constexpr uint16_t kVisSpacerSize = 8;
 
@@ -142,6 +148,7 @@ struct projection_instructions
 	projection_instructions(const t_camera_model_params &dist) : dist(dist) {}
 };
 
+//! A model input or output, with data we own so runs don't allocate.
 struct model_input_wrap
 {
 	float *data = nullptr;
@@ -149,6 +156,8 @@ struct model_input_wrap
 	size_t num_dimensions = 0;
 
 	OrtValue *tensor = nullptr;
+	//! For batched sessions, over the first N + 1 items of @ref data.
+	OrtValue *batch_tensors[kMaxBatchSize] = {};
 	const char *name;
 };
 
@@ -161,6 +170,12 @@ struct onnx_wrap
 	OrtSession *session = nullptr;
 
 	std::vector<model_input_wrap> wraps = {};
+
+	//! Outputs ORT writes into, the ones without a tensor are allocated by ORT for each run.
+	std::vector<model_input_wrap> outputs = {};
+
+	//! Model input images before normalization, for each batch item.
+	cv::Mat images_uint8[kMaxBatchSize] = {};
 };
 
 // Multipurpose.
@@ -181,15 +196,49 @@ struct hand_region_of_interest
 
 
 
+/*!
+ * How the ONNX Runtime sessions are set up, filled in from the
+ * MERCURY_ORT_* options.
+ */
+struct hg_ort_options
+{
+	/*!
+	 * Execution provider to run the models with: "cpu", "cuda", "tensorrt",
+	 * "openvino", "xnnpack", "nnapi", "dml" or any other name that the
+	 * onnxruntime build accepts. Falls back to the CPU if not available.
+	 */
+	const char *provider = "cpu";
+
+	int intra_op_threads = 1;
+
+	//! Zero leaves it to onnxruntime, more than one runs the graph in parallel.
+	int inter_op_threads = 0;
+
+	GraphOptimizationLevel optimization_level = ORT_ENABLE_ALL;
+};
+
 struct hand_detection_run_info
 {
 	ht_view *view;
+	// The image to run on, usually the view's run_model_on_this but not when running ahead of time.
+	cv::Mat image;
+	// Whether to draw into the debug images.
+	bool scribble;
 	// These are not duplicates of ht_view's regions_of_interest_this_frame!
 	// If some hands are already tracked, we have logic that only copies new ROIs to this frame's regions of
 	// interest.
 	hand_region_of_interest outputs[2];
 };
 
+//! Hand detection that @ref HandTracking::cCallbackProcessBegin ran ahead of time for one frame.
+struct hand_detection_lookahead
+{
+	uint64_t timestamp = 0;
+	// Zero if detection wasn't needed.
+	int num_views = 0;
+	hand_detection_run_info infos[2] = {};
+};
+
 
 struct keypoint_estimation_run_info
 {
@@ -256,6 +305,9 @@ public:
 	struct u_sink_debug debug_sink_model = {};
 	struct xrt_hand_masks_sink *hand_masks_sink;
 
+	//! Optional, detections made before the frames got to us, used instead of running the detection model.
+	struct t_hand_detection_source *detection_source = nullptr;
+
 	float multiply_px_coord_for_undistort;
 
 
@@ -272,8 +324,43 @@ public:
 
 	u_worker_thread_pool *pool;
 
+	//! The pool is from @ref u_worker_thread_pool_get_tracking and must be put back.
+	bool pool_is_shared = false;
+
 	u_worker_group *group;
 
+	/*!
+	 * Detection run by @ref cCallbackProcessBegin while the previous frame is
+	 * still being finished. Once that has been called, detection only ever
+	 * runs there.
+	 */
+	struct
+	{
+		std::atomic_bool enabled = false;
+
+		//! For the frame being finished and the one being started.
+		hand_detection_lookahead slots[2] = {};
+		int next_slot = 0;
+		std::mutex mutex;
+
+		//! Written at the end of each frame, to decide if the next begin needs to run detection and where.
+		std::atomic_bool detection_wanted = true;
+		std::atomic_bool both_views = false;
+
+		u_worker_group *group = nullptr;
+	} lookahead;
+
+	//! Sessions that run all views and hands in one go, see @ref init_batched_inference.
+	struct
+	{
+		bool enabled = false;
+		onnx_wrap detection = {};
+		onnx_wrap keypoint = {};
+	} batched;
+
+	//! The models are loaded on the first frames, see load_models.
+	std::once_flag models_loaded;
+
 
 	float baseline = {};
 	xrt_pose hand_pose_camera_offset = {};
@@ -284,6 +371,14 @@ public:
 
 	char models_folder[1024];
 
+	struct hg_ort_options ort_options = {};
+
+	//! Model file variant to prefer, like "int8", empty for the float models.
+	const char *model_variant = "";
+
+	//! The keypoint model is a quantized variant, its heatmaps need cleaning up.
+	bool quantized_keypoint_model = false;
+
 	enum u_logging_level log_level = U_LOGGING_INFO;
 
 	lm::KinematicHandLM *kinematic_hands[2];
@@ -321,6 +416,22 @@ public:
 
 	int detection_counter = 0;
 
+	//! Of the last frame, see @ref t_hand_tracking_sync_mercury_get_timings.
+	struct t_hand_tracking_mercury_timings timings = {};
+
+	//! Warp time of the keypoint jobs of this frame, added to from the worker threads.
+	std::atomic_uint64_t keypoint_warp_ns = 0;
+
+	//! Inputs to @ref want_hand_detection, the per hand ones are only kept up to date while tracked.
+	struct
+	{
+		int32_t frames_since_detection = 0;
+		//! From @ref hand_confidence_value.
+		float confidence[2] = {};
+		//! Of the last and the predicted region of interest, lowest over the views.
+		float roi_iou[2] = {};
+	} detection_cadence;
+
 	struct hand_size_refinement refinement = {};
 	float target_hand_size = STANDARD_HAND_SIZE;
 
@@ -357,6 +468,11 @@ public:
 	                 struct xrt_hand_joint_set *out_right_hand,
 	                 uint64_t *out_timestamp_ns);
 
+	static void
+	cCallbackProcessBegin(struct t_hand_tracking_sync *ht_sync,
+	                      struct xrt_frame *left_frame,
+	                      struct xrt_frame *right_frame);
+
 	static void
 	cCallbackDestroy(t_hand_tracking_sync *ht_sync);
 };
@@ -374,6 +490,21 @@ init_keypoint_estimation(HandTracking *hgt, onnx_wrap *wrap);
 void
 run_keypoint_estimation(void *ptr);
 
+/*!
+ * Sets up the batched sessions, returns false if the models can't take more
+ * than one image per run.
+ */
+bool
+init_batched_inference(HandTracking *hgt);
+
+//! Runs detection for @p count views (at most two) with one model run.
+void
+run_hand_detection_batched(HandTracking *hgt, hand_detection_run_info *infos, int count);
+
+//! Runs keypoint estimation for @p count regions (at most four) with one model run.
+void
+run_keypoint_estimation_batched(HandTracking *hgt, keypoint_estimation_run_info *infos, int count);
+
 void
 release_onnx_wrap(onnx_wrap *wrap);
 
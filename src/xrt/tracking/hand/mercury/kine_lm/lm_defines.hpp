@@ -53,6 +53,17 @@ static constexpr size_t kNumOrientationsInFinger = 4;
 
 #undef RESIDUALS_HACKING
 
+// Use the hand-derived Jacobian in lm_main.cpp instead of autodiff. Undefine this to go back to autodiff, for example
+// when hacking on the residuals; the tests check the two against each other. It only knows about the default set of
+// residuals, so it is turned off if any of the terms above are changed.
+#define USE_ANALYTIC_JACOBIAN
+
+#if !defined(USE_HAND_SIZE) || !defined(USE_HAND_TRANSLATION) || !defined(USE_HAND_ORIENTATION) ||                    \
+    !defined(USE_EVERYTHING_ELSE) || defined(USE_HAND_PLAUSIBILITY) || defined(USE_HAND_CURLS) ||                      \
+    defined(RESIDUALS_HACKING)
+#undef USE_ANALYTIC_JACOBIAN
+#endif
+
 static constexpr size_t kMetacarpalBoneDim = 3;
 static constexpr size_t kProximalBoneDim = 2;
 static constexpr size_t kFingerDim = kProximalBoneDim + 2;
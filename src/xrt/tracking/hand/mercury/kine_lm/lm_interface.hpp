@@ -57,6 +57,24 @@ optimizer_run(KinematicHandLM *hand,
               float &out_hand_size,
               float &out_reprojection_error);
 
+/*!
+ * For testing: evaluates the Jacobian of the optimizer's residuals both with autodiff and analytically, at the hand's
+ * current parameters with each one moved by a random amount up to @p perturbation, and returns the largest difference
+ * relative to the autodiff value plus one. Returns 0 if the analytic Jacobian is compiled out.
+ *
+ * Takes the same arguments as @ref optimizer_run and doesn't change the hand's pose.
+ */
+float
+optimizer_compare_jacobians(KinematicHandLM *hand,
+                            one_frame_input &observation,
+                            float smoothing_factor,
+                            bool optimize_hand_size,
+                            float target_hand_size,
+                            float hand_size_err_mul,
+                            float amt_use_depth,
+                            float perturbation,
+                            uint32_t seed);
+
 // Destructor
 void
 optimizer_destroy(KinematicHandLM **hand);
@@ -723,6 +723,466 @@ CostFunctor<optimize_hand_size>::operator()(const T *const x, T *residual) const
 	return true;
 }
 
+#ifdef USE_ANALYTIC_JACOBIAN
+
+/*
+ * Analytic Jacobian.
+ *
+ * Autodiff carries a derivative for each of the ~28 inputs through every operation of the cost functor, which is
+ * most of the time spent in the optimizer. The residuals are simple functions of the joint positions though, so
+ * instead we work out how each joint moves with each input and push that through the projection by hand.
+ *
+ * This has to be kept in sync with CostFunctor by hand, the LevenbergMarquardt tests compare the two.
+ */
+
+static constexpr size_t kInputTranslationIdx = 0;
+static constexpr size_t kInputOrientationIdx = kInputTranslationIdx + kHandTranslationDim;
+static constexpr size_t kInputThumbIdx = kInputOrientationIdx + kHandOrientationDim;
+static constexpr size_t kInputFingersIdx = kInputThumbIdx + kThumbDim;
+static constexpr size_t kInputHandSizeIdx = kInputFingersIdx + (kFingerDim * 4);
+
+//! Derivative of each joint position, in the same order as @ref cjrc, with respect to each input.
+template <bool optimize_hand_size> struct JointDerivatives
+{
+	Vec3<HandScalar> d[kNumNNJoints][calc_input_size(optimize_hand_size)];
+};
+
+static inline Vec3<HandScalar>
+cross(const Vec3<HandScalar> &a, const Vec3<HandScalar> &b)
+{
+	return Vec3<HandScalar>(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+
+/*!
+ * Angular velocity, in tracking space, of a rotation per unit change of each of the N variables seeded in @p q.
+ * @p parent is the absolute orientation the rotation is applied on top of.
+ */
+template <int N>
+static inline void
+angular_derivatives(const Quat<ceres::Jet<HandScalar, N>> &q, const Quat<HandScalar> &parent, Vec3<HandScalar> out[N])
+{
+	const Quat<HandScalar> q_conj(-q.x.a, -q.y.a, -q.z.a, q.w.a);
+
+	for (int k = 0; k < N; k++) {
+		const Quat<HandScalar> dq(q.x.v[k], q.y.v[k], q.z.v[k], q.w.v[k]);
+		Quat<HandScalar> half_omega;
+		QuaternionProduct(dq, q_conj, half_omega);
+
+		const Vec3<HandScalar> omega(half_omega.x * 2, half_omega.y * 2, half_omega.z * 2);
+		UnitQuaternionRotatePoint(parent, omega, out[k]);
+	}
+}
+
+static inline int
+joint_index(int finger, int bone)
+{
+	return 1 + (finger * 4) + (bone - 1);
+}
+
+/*!
+ * Fills in the derivatives of the joints of @p finger from @p first_bone on, for a rotation around
+ * @p base with angular velocity @p omega. Right hands are mirrored after rotating, so undo that first.
+ */
+template <bool optimize_hand_size>
+static inline void
+add_rotation_derivative(const KinematicHandLM &state,
+                        const Translations55<HandScalar> &translations_absolute,
+                        const Vec3<HandScalar> &base,
+                        const Vec3<HandScalar> &omega,
+                        int finger,
+                        int first_bone,
+                        size_t input_idx,
+                        JointDerivatives<optimize_hand_size> &out)
+{
+	const HandScalar mirror = state.is_right ? -1 : 1;
+
+	for (int bone = first_bone; bone < (int)kNumJointsInFinger; bone++) {
+		const Vec3<HandScalar> &p = translations_absolute.t[finger][bone];
+		const Vec3<HandScalar> arm((p.x - base.x) * mirror, p.y - base.y, p.z - base.z);
+
+		Vec3<HandScalar> d = cross(omega, arm);
+		d.x *= mirror;
+
+		out.d[joint_index(finger, bone)][input_idx] = d;
+	}
+}
+
+template <bool optimize_hand_size>
+static void
+eval_joint_derivatives(const KinematicHandLM &state,
+                       const HandScalar *x,
+                       const OptimizerHand<HandScalar> &hand,
+                       const Translations55<HandScalar> &translations_absolute,
+                       const Orientations54<HandScalar> &orientations_absolute,
+                       JointDerivatives<optimize_hand_size> &out)
+{
+	using Jet1 = ceres::Jet<HandScalar, 1>;
+	using Jet2 = ceres::Jet<HandScalar, 2>;
+	using Jet3 = ceres::Jet<HandScalar, 3>;
+
+	for (size_t i = 0; i < kNumNNJoints; i++) {
+		for (size_t k = 0; k < calc_input_size(optimize_hand_size); k++) {
+			out.d[i][k] = Vec3<HandScalar>::Zero();
+		}
+	}
+
+	const Vec3<HandScalar> &wrist = hand.wrist_final_location;
+
+	// Translation moves everything, including the wrist.
+	for (size_t i = 0; i < kNumNNJoints; i++) {
+		out.d[i][kInputTranslationIdx + 0].x = 1;
+		out.d[i][kInputTranslationIdx + 1].y = 1;
+		out.d[i][kInputTranslationIdx + 2].z = 1;
+	}
+
+	// Hand size scales everything around the wrist.
+	if constexpr (optimize_hand_size) {
+		const HandScalar ds = LMToModelDerivative(x[kInputHandSizeIdx], the_limit.hand_size) / hand.hand_size;
+		for (int finger = 0; finger < 5; finger++) {
+			for (int bone = 1; bone < (int)kNumJointsInFinger; bone++) {
+				const Vec3<HandScalar> &p = translations_absolute.t[finger][bone];
+				out.d[joint_index(finger, bone)][kInputHandSizeIdx] =
+				    Vec3<HandScalar>((p.x - wrist.x) * ds, (p.y - wrist.y) * ds, (p.z - wrist.z) * ds);
+			}
+		}
+	}
+
+	// Wrist orientation.
+	{
+		const Vec3<Jet3> aax(Jet3(hand.wrist_post_orientation_aax.x, 0),
+		                     Jet3(hand.wrist_post_orientation_aax.y, 1),
+		                     Jet3(hand.wrist_post_orientation_aax.z, 2));
+		Quat<Jet3> q;
+		AngleAxisToQuaternion(aax, q);
+
+		Vec3<HandScalar> omega[3];
+		angular_derivatives<3>(q, state.this_frame_pre_rotation, omega);
+
+		for (int k = 0; k < 3; k++) {
+			for (int finger = 0; finger < 5; finger++) {
+				add_rotation_derivative(state, translations_absolute, wrist, omega[k], finger, 1,
+				                        kInputOrientationIdx + k, out);
+			}
+		}
+	}
+
+	// Thumb metacarpal, its swing-twist sits after the hidden orientation.
+	{
+		const OptimizerMetacarpalBone<HandScalar> &mcp = hand.thumb.metacarpal;
+
+		const Vec2<Jet3> swing(Jet3(mcp.swing.x, 0), Jet3(mcp.swing.y, 1));
+		Quat<Jet3> q;
+		SwingTwistToQuaternion(swing, Jet3(mcp.twist, 2), q);
+
+		Vec3<HandScalar> omega[3];
+		angular_derivatives<3>(q, orientations_absolute.q[0][0], omega);
+
+		const minmax *limits[3] = {&the_limit.thumb_mcp_swing_x, &the_limit.thumb_mcp_swing_y,
+		                           &the_limit.thumb_mcp_twist};
+
+		for (int k = 0; k < 3; k++) {
+			const size_t idx = kInputThumbIdx + k;
+			const HandScalar lm = LMToModelDerivative(x[idx], *limits[k]);
+			const Vec3<HandScalar> w(omega[k].x * lm, omega[k].y * lm, omega[k].z * lm);
+			add_rotation_derivative(state, translations_absolute, translations_absolute.t[0][1], w, 0, 2,
+			                        idx, out);
+		}
+	}
+
+	// Finger proximal swings.
+	for (int finger_idx = 0; finger_idx < 4; finger_idx++) {
+		const int finger = finger_idx + 1;
+		const Vec2<HandScalar> &pxm = hand.finger[finger_idx].proximal_swing;
+
+		const Vec2<Jet2> swing(Jet2(pxm.x, 0), Jet2(pxm.y, 1));
+		Quat<Jet2> q;
+		SwingToQuaternion(swing, q);
+
+		Vec3<HandScalar> omega[2];
+		angular_derivatives<2>(q, orientations_absolute.q[finger][0], omega);
+
+		const minmax *limits[2] = {&the_limit.fingers[finger_idx].pxm_swing_x,
+		                           &the_limit.fingers[finger_idx].pxm_swing_y};
+
+		for (int k = 0; k < 2; k++) {
+			const size_t idx = kInputFingersIdx + (finger_idx * kFingerDim) + k;
+			const HandScalar lm = LMToModelDerivative(x[idx], *limits[k]);
+			const Vec3<HandScalar> w(omega[k].x * lm, omega[k].y * lm, omega[k].z * lm);
+			add_rotation_derivative(state, translations_absolute, translations_absolute.t[finger][1], w,
+			                        finger, 2, idx, out);
+		}
+	}
+
+	// Curls, for the thumb and the fingers.
+	for (int finger = 0; finger < 5; finger++) {
+		for (int i = 0; i < 2; i++) {
+			HandScalar curl;
+			size_t idx;
+			const minmax *limit;
+			if (finger == 0) {
+				curl = hand.thumb.rots[i];
+				idx = kInputThumbIdx + kMetacarpalBoneDim + i;
+				limit = &the_limit.thumb_curls[i];
+			} else {
+				curl = hand.finger[finger - 1].rots[i];
+				idx = kInputFingersIdx + ((finger - 1) * kFingerDim) + kProximalBoneDim + i;
+				limit = &the_limit.fingers[finger - 1].curls[i];
+			}
+
+			Quat<Jet1> q;
+			CurlToQuaternion(Jet1(curl, 0), q);
+
+			Vec3<HandScalar> omega;
+			angular_derivatives<1>(q, orientations_absolute.q[finger][i + 1], &omega);
+
+			const HandScalar lm = LMToModelDerivative(x[idx], *limit);
+			const Vec3<HandScalar> w(omega.x * lm, omega.y * lm, omega.z * lm);
+			add_rotation_derivative(state, translations_absolute, translations_absolute.t[finger][i + 2], w,
+			                        finger, i + 3, idx, out);
+		}
+	}
+}
+
+//! Column-major Jacobian of the residuals from @ref CostFunctor, written to @p jacobian.
+template <bool optimize_hand_size>
+static void
+eval_analytic_jacobian(const KinematicHandLM &state,
+                       const HandScalar *x,
+                       size_t num_residuals,
+                       HandScalar *jacobian)
+{
+	XRT_TRACE_MARKER();
+
+	constexpr size_t input_size = calc_input_size(optimize_hand_size);
+
+	Eigen::Map<Eigen::Matrix<HandScalar, Eigen::Dynamic, input_size>> J(jacobian, num_residuals, input_size);
+	J.setZero();
+
+	OptimizerHand<HandScalar> hand = {};
+	Quat<HandScalar> tmp = state.this_frame_pre_rotation;
+	OptimizerHandInit<HandScalar>(hand, tmp);
+	OptimizerHandUnpackFromVector(x, state, hand);
+
+	Translations55<HandScalar> translations_absolute = {};
+	Orientations54<HandScalar> orientations_absolute = {};
+	eval_hand_with_orientation(state, hand, state.is_right, translations_absolute, orientations_absolute);
+
+	JointDerivatives<optimize_hand_size> joint_derivatives;
+	eval_joint_derivatives(state, x, hand, translations_absolute, orientations_absolute, joint_derivatives);
+
+	const HandScalar ds = optimize_hand_size ? LMToModelDerivative(x[kInputHandSizeIdx], the_limit.hand_size) : 0;
+
+	size_t row = 0;
+
+	// Matches CostFunctor_PositionsPart.
+	for (int view = 0; view < 2; view++) {
+		const one_frame_one_view &inp = state.observation->views[view];
+		if (!inp.active) {
+			continue;
+		}
+
+		Vec3<HandScalar> model_joints_rel_camera[kNumNNJoints] = {};
+		cjrc(state, hand, translations_absolute, view, model_joints_rel_camera);
+
+		// The rotation cjrc applies, the translation doesn't matter for the derivatives.
+		Quat<HandScalar> move_orientation = Quat<HandScalar>::Identity();
+		if (view != 0) {
+			move_orientation = state.left_in_right_orientation;
+		}
+		xrt_quat extra_rot = inp.look_dir;
+		math_quat_invert(&extra_rot, &extra_rot);
+		const Quat<HandScalar> after_orientation(extra_rot.x, extra_rot.y, extra_rot.z, extra_rot.w);
+
+		Quat<HandScalar> camera_orientation;
+		QuaternionProduct(after_orientation, move_orientation, camera_orientation);
+
+		// Derivatives of each joint's position and distance, relative to the camera.
+		Vec3<HandScalar> dc[kNumNNJoints][input_size];
+		HandScalar len[kNumNNJoints];
+		HandScalar dlen[kNumNNJoints][input_size];
+
+		for (size_t i = 0; i < kNumNNJoints; i++) {
+			const Vec3<HandScalar> &c = model_joints_rel_camera[i];
+			len[i] = c.norm();
+
+			for (size_t k = 0; k < input_size; k++) {
+				UnitQuaternionRotatePoint(camera_orientation, joint_derivatives.d[i][k], dc[i][k]);
+				const Vec3<HandScalar> &d = dc[i][k];
+				dlen[i][k] = len[i] > FLT_EPSILON ? (c.x * d.x + c.y * d.y + c.z * d.z) / len[i] : 0;
+			}
+		}
+
+		const size_t m = Joint21::INDX_PXM;
+
+		for (size_t i = 0; i < kNumNNJoints; i++) {
+			const HandScalar confidence_xy = inp.keypoints_in_scaled_stereographic[i].confidence_xy;
+			const Vec3<HandScalar> &c = model_joints_rel_camera[i];
+
+			// diff_stereographic
+			if (len[i] <= FLT_EPSILON) {
+				// normalize_vector_inplace leaves x and y alone and sets z to -1.
+				for (size_t k = 0; k < input_size; k++) {
+					J(row + 0, k) = dc[i][k].x * HandScalar(0.5) * confidence_xy;
+					J(row + 1, k) = dc[i][k].y * HandScalar(0.5) * confidence_xy;
+				}
+			} else {
+				const Vec3<HandScalar> n(c.x / len[i], c.y / len[i], c.z / len[i]);
+				const HandScalar denom = 1 - n.z;
+
+				for (size_t k = 0; k < input_size; k++) {
+					const Vec3<HandScalar> &d = dc[i][k];
+					const HandScalar dot = n.x * d.x + n.y * d.y + n.z * d.z;
+					const Vec3<HandScalar> dn((d.x - n.x * dot) / len[i], (d.y - n.y * dot) / len[i],
+					                          (d.z - n.z * dot) / len[i]);
+
+					J(row + 0, k) = (dn.x / denom + n.x * dn.z / (denom * denom)) * confidence_xy;
+					J(row + 1, k) = (dn.y / denom + n.y * dn.z / (denom * denom)) * confidence_xy;
+				}
+			}
+			row += 2;
+
+			if (i == Joint21::MIDL_PXM) {
+				continue;
+			}
+
+			if (!state.first_frame && len[i] > FLT_EPSILON && len[m] > FLT_EPSILON) {
+				const HandScalar w =
+				    HandScalar(pow(inp.keypoints_in_scaled_stereographic[i].confidence_depth, 3)) *
+				    state.depth_err_mul;
+				const HandScalar s = hand.hand_size;
+				const HandScalar rel = (len[i] - len[m]) / (s * s);
+
+				for (size_t k = 0; k < input_size; k++) {
+					J(row, k) = ((dlen[i][k] - dlen[m][k]) / s) * w;
+				}
+				if constexpr (optimize_hand_size) {
+					J(row, kInputHandSizeIdx) -= rel * ds * w;
+				}
+			}
+			row++;
+		}
+	}
+
+	// Matches computeResidualStability.
+	HandStability stab(state.smoothing_factor);
+
+	if constexpr (optimize_hand_size) {
+		J(row++, kInputHandSizeIdx) = stab.stabilityHandSize * state.hand_size_err_mul * ds;
+	}
+
+	if (state.first_frame) {
+		assert(row == num_residuals);
+		return;
+	}
+
+	for (size_t k = 0; k < 3; k++) {
+		J(row++, kInputTranslationIdx + k) = stab.stabilityRootPosition;
+	}
+
+	{
+		const Vec3<HandScalar> &aax = hand.wrist_post_orientation_aax;
+		const HandScalar weights[3] = {stab.stabilityHandOrientationXY, stab.stabilityHandOrientationXY,
+		                               stab.stabilityHandOrientationZ};
+
+		const float epsilon = 0.001;
+		if (aax.x < epsilon && aax.y < epsilon && aax.z < epsilon) {
+			for (size_t k = 0; k < 3; k++) {
+				J(row + k, kInputOrientationIdx + k) = weights[k];
+			}
+		} else {
+			// d/da of 2 * sin(|a| / 2) * a / |a|
+			const HandScalar theta = aax.norm();
+			const HandScalar u[3] = {aax.x / theta, aax.y / theta, aax.z / theta};
+			const HandScalar sin_part = HandScalar(2) * sin(HandScalar(0.5) * theta) / theta;
+			const HandScalar cos_part = cos(HandScalar(0.5) * theta);
+
+			for (size_t r = 0; r < 3; r++) {
+				for (size_t k = 0; k < 3; k++) {
+					const HandScalar uu = u[r] * u[k];
+					const HandScalar identity = r == k ? 1 : 0;
+					J(row + r, kInputOrientationIdx + k) =
+					    (sin_part * (identity - uu) + cos_part * uu) * weights[r];
+				}
+			}
+		}
+		row += 3;
+	}
+
+	const HandScalar thumb_weights[kThumbDim] = {stab.stabilityThumbMCPSwing, stab.stabilityThumbMCPSwing,
+	                                             stab.stabilityThumbMCPTwist, stab.stabilityCurlRoot,
+	                                             stab.stabilityCurlRoot};
+	const minmax *thumb_limits[kThumbDim] = {&the_limit.thumb_mcp_swing_x, &the_limit.thumb_mcp_swing_y,
+	                                         &the_limit.thumb_mcp_twist, &the_limit.thumb_curls[0],
+	                                         &the_limit.thumb_curls[1]};
+	for (size_t k = 0; k < kThumbDim; k++) {
+		const size_t idx = kInputThumbIdx + k;
+		J(row++, idx) = thumb_weights[k] * LMToModelDerivative(x[idx], *thumb_limits[k]);
+	}
+
+	for (int finger_idx = 0; finger_idx < 4; finger_idx++) {
+		const FingerLimit &limit = the_limit.fingers[finger_idx];
+
+		HandScalar obs_curl = HandScalar(get_avg_curl_value(*state.observation, finger_idx + 1));
+		HandScalar curl_sub_mul = calc_stability_curl_multiplier(state.last_frame.finger[finger_idx], obs_curl);
+
+		const HandScalar weights[kFingerDim] = {stab.stabilityFingerPXMSwingX * curl_sub_mul,
+		                                        stab.stabilityFingerPXMSwingY,
+		                                        stab.stabilityCurlRoot * curl_sub_mul,
+		                                        stab.stabilityCurlRoot * curl_sub_mul};
+		const minmax *limits[kFingerDim] = {&limit.pxm_swing_x, &limit.pxm_swing_y, &limit.curls[0],
+		                                    &limit.curls[1]};
+
+		for (size_t k = 0; k < kFingerDim; k++) {
+			const size_t idx = kInputFingersIdx + (finger_idx * kFingerDim) + k;
+			J(row++, idx) = weights[k] * LMToModelDerivative(x[idx], *limits[k]);
+		}
+	}
+
+	assert(row == num_residuals);
+}
+
+/*!
+ * Drop-in for ceres::TinySolverAutoDiffFunction that gets the residuals from CostFunctor and the Jacobian from
+ * @ref eval_analytic_jacobian.
+ */
+template <bool optimize_hand_size> struct AnalyticCostFunction
+{
+	using Scalar = HandScalar;
+	enum
+	{
+		NUM_RESIDUALS = Eigen::Dynamic,
+		NUM_PARAMETERS = calc_input_size(optimize_hand_size),
+	};
+
+	const CostFunctor<optimize_hand_size> &cost_functor;
+
+	explicit AnalyticCostFunction(const CostFunctor<optimize_hand_size> &cost_functor)
+	    : cost_functor(cost_functor)
+	{}
+
+	int
+	NumResiduals() const
+	{
+		return (int)cost_functor.NumResiduals();
+	}
+
+	bool
+	operator()(const HandScalar *x, HandScalar *residuals, HandScalar *jacobian) const
+	{
+		if (!cost_functor(x, residuals)) {
+			return false;
+		}
+
+		if (jacobian != nullptr) {
+			eval_analytic_jacobian<optimize_hand_size>(cost_functor.parent, x, cost_functor.NumResiduals(),
+			                                           jacobian);
+		}
+		return true;
+	}
+};
+
+#endif
+
 // look at tests_quat_change_of_basis
 #if 0
 template <typename T>
@@ -853,12 +1313,16 @@ opt_run(KinematicHandLM &state, one_frame_input &observation, xrt_hand_joint_set
 
 	CostFunctor<optimize_hand_size> cf(state, residual_size);
 
-	using AutoDiffCostFunctor =
+#ifdef USE_ANALYTIC_JACOBIAN
+	using CostFunction = AnalyticCostFunction<optimize_hand_size>;
+#else
+	using CostFunction =
 	    ceres::TinySolverAutoDiffFunction<CostFunctor<optimize_hand_size>, Eigen::Dynamic, input_size, HandScalar>;
+#endif
 
-	AutoDiffCostFunctor f(cf);
+	CostFunction f(cf);
 
-	ceres::TinySolver<AutoDiffCostFunctor> solver = {};
+	ceres::TinySolver<CostFunction> solver = {};
 	solver.options.max_num_iterations = 30;
 
 	//!@todo We don't yet know what "good" termination conditions are.
@@ -1097,6 +1561,85 @@ optimizer_run(KinematicHandLM *hand,
 
 
 
+#ifdef USE_ANALYTIC_JACOBIAN
+template <bool optimize_hand_size>
+static float
+compare_jacobians(KinematicHandLM &state, float perturbation, uint32_t seed)
+{
+	constexpr size_t input_size = calc_input_size(optimize_hand_size);
+	size_t residual_size = calc_residual_size(state.use_stability, optimize_hand_size, state.num_observation_views);
+
+	CostFunctor<optimize_hand_size> cf(state, residual_size);
+
+	Eigen::Matrix<HandScalar, input_size, 1> x = state.TinyOptimizerInput.head<input_size>();
+
+	std::mt19937 mt(seed);
+	std::uniform_real_distribution<HandScalar> dist(-perturbation, perturbation);
+	for (size_t i = 0; i < input_size; i++) {
+		x(i) += dist(mt);
+	}
+
+	Eigen::Matrix<HandScalar, Eigen::Dynamic, 1> residuals(residual_size);
+	Eigen::Matrix<HandScalar, Eigen::Dynamic, input_size> autodiff_jacobian(residual_size, input_size);
+	Eigen::Matrix<HandScalar, Eigen::Dynamic, input_size> analytic_jacobian(residual_size, input_size);
+
+	ceres::TinySolverAutoDiffFunction<CostFunctor<optimize_hand_size>, Eigen::Dynamic, input_size, HandScalar>
+	    autodiff(cf);
+	autodiff(x.data(), residuals.data(), autodiff_jacobian.data());
+
+	AnalyticCostFunction<optimize_hand_size> analytic(cf);
+	analytic(x.data(), residuals.data(), analytic_jacobian.data());
+
+	auto difference = (analytic_jacobian - autodiff_jacobian).cwiseAbs().array();
+	auto scale = autodiff_jacobian.cwiseAbs().array() + HandScalar(1);
+
+	return (difference / scale).maxCoeff();
+}
+#endif
+
+float
+optimizer_compare_jacobians(KinematicHandLM *hand,
+                            one_frame_input &observation,
+                            float smoothing_factor,
+                            bool optimize_hand_size,
+                            float target_hand_size,
+                            float hand_size_err_mul,
+                            float amt_use_depth,
+                            float perturbation,
+                            uint32_t seed) // NOLINT(bugprone-easily-swappable-parameters)
+{
+#ifdef USE_ANALYTIC_JACOBIAN
+	KinematicHandLM &state = *hand;
+
+	// Same setup as optimizer_run, without touching the hand itself.
+	state.smoothing_factor = smoothing_factor;
+
+	state.num_observation_views = 0;
+	for (int i = 0; i < 2; i++) {
+		if (observation.views[i].active) {
+			state.num_observation_views++;
+		}
+	}
+
+	state.optimize_hand_size = optimize_hand_size;
+	state.target_hand_size = target_hand_size;
+	state.hand_size_err_mul = hand_size_err_mul;
+	state.depth_err_mul = amt_use_depth;
+
+	state.use_stability = !state.first_frame;
+
+	state.observation = &observation;
+
+	if (optimize_hand_size) {
+		return compare_jacobians<true>(state, perturbation, seed);
+	}
+	return compare_jacobians<false>(state, perturbation, seed);
+#else
+	// Autodiff is all there is, nothing to compare against.
+	return 0.0f;
+#endif
+}
+
 void
 optimizer_create(xrt_pose left_in_right, bool is_right, u_logging_level log_level, KinematicHandLM **out_kinematic_hand)
 {
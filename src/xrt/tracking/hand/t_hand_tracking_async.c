@@ -7,6 +7,7 @@
  * @ingroup drv_ht
  */
 
+#include "os/os_time.h"
 #include "os/os_threading.h"
 
 #include "math/m_space.h"
@@ -23,6 +24,8 @@
 
 DEBUG_GET_ONCE_BOOL_OPTION(hta_prediction_disable, "HTA_PREDICTION_DISABLE", false)
 DEBUG_GET_ONCE_FLOAT_OPTION(hta_prediction_offset_ms, "HTA_PREDICTION_OFFSET_MS", -40.0f)
+DEBUG_GET_ONCE_BOOL_OPTION(hta_pipelined, "HTA_PIPELINED", false)
+DEBUG_GET_ONCE_NUM_OPTION(hta_idle_timeout_ms, "HTA_IDLE_TIMEOUT_MS", 2000)
 
 
 /*!
@@ -53,8 +56,17 @@ struct ht_async_impl
 		struct xrt_hand_joint_set hands[2];
 		struct m_relation_history *relation_hist[2];
 		uint64_t timestamp;
+
+		//! When hands were last asked for, zero if never.
+		uint64_t last_query_ns;
+
+		//! Nobody has asked for hands in a while, frames are dropped.
+		bool idle;
 	} present;
 
+	//! How long after the last query to stop tracking, zero to always track.
+	uint64_t idle_timeout_ns;
+
 	// in here:
 	// mutex is so that the mainloop and two push_frames don't fight over referencing frames;
 	// cond is so that we can wake up the mainloop at certain times;
@@ -62,6 +74,23 @@ struct ht_async_impl
 	struct os_thread_helper mainloop;
 
 	volatile bool hand_tracking_work_active;
+
+	/*!
+	 * Only used if the provider has a process_begin function and pipelining
+	 * is enabled. The mainloop then only calls process_begin and hands the
+	 * frames over to this thread, which calls process and publishes the
+	 * result. So the next pair of frames can be started while the current
+	 * one is being finished.
+	 */
+	struct
+	{
+		bool enabled;
+
+		//! Protected by the thread helper's mutex, NULL when the thread is idle.
+		struct xrt_frame *frames[2];
+
+		struct os_thread_helper thread;
+	} pipeline;
 };
 
 
@@ -77,6 +106,145 @@ ht_async_impl(struct t_hand_tracking_async *base)
 	return (struct ht_async_impl *)base;
 }
 
+static void
+ht_async_publish(struct ht_async_impl *hta)
+{
+	os_mutex_lock(&hta->present.mutex);
+
+	hta->present.timestamp = hta->working.timestamp;
+
+	for (int i = 0; i < 2; i++) {
+		hta->present.hands[i] = hta->working.hands[i];
+	}
+
+	os_mutex_unlock(&hta->present.mutex);
+
+	for (int i = 0; i < 2; i++) {
+		struct xrt_space_relation wrist_rel =
+		    hta->working.hands[i].values.hand_joint_set_default[XRT_HAND_JOINT_WRIST].relation;
+
+		m_relation_history_estimate_motion( //
+		    hta->present.relation_hist[i],  //
+		    &wrist_rel,                     //
+		    hta->working.timestamp,         //
+		    &wrist_rel);                    //
+
+		m_relation_history_push(           //
+		    hta->present.relation_hist[i], //
+		    &wrist_rel,                    //
+		    hta->working.timestamp);       //
+	}
+}
+
+/*!
+ * Tracking is only started once someone asks for hands, and stopped again
+ * when nobody has for a while, so an idle service doesn't spend its CPU on
+ * tracking hands no app is looking at. Returns true if the frames should be
+ * dropped.
+ */
+static bool
+ht_async_check_idle(struct ht_async_impl *hta)
+{
+	if (hta->idle_timeout_ns == 0) {
+		return false;
+	}
+
+	uint64_t now_ns = os_monotonic_get_ns();
+
+	os_mutex_lock(&hta->present.mutex);
+
+	bool was_idle = hta->present.idle;
+	bool idle = hta->present.last_query_ns == 0 || now_ns - hta->present.last_query_ns > hta->idle_timeout_ns;
+
+	// Don't hand out hands that are frozen in place when tracking resumes.
+	if (idle && !was_idle) {
+		hta->present.hands[0].is_active = false;
+		hta->present.hands[1].is_active = false;
+	}
+	hta->present.idle = idle;
+
+	os_mutex_unlock(&hta->present.mutex);
+
+	if (idle != was_idle) {
+		U_LOG_D("Hand tracking %s", idle ? "idle, no longer tracking" : "requested, tracking");
+	}
+
+	return idle;
+}
+
+/*!
+ * Pipelined mode: wait for the finishing thread to be idle and give it the
+ * frames, returns false if we are shutting down.
+ */
+static bool
+ht_async_hand_over(struct ht_async_impl *hta)
+{
+	os_thread_helper_lock(&hta->pipeline.thread);
+
+	while (hta->pipeline.frames[0] != NULL && os_thread_helper_is_running_locked(&hta->pipeline.thread)) {
+		os_thread_helper_wait_locked(&hta->pipeline.thread);
+	}
+
+	if (!os_thread_helper_is_running_locked(&hta->pipeline.thread)) {
+		os_thread_helper_unlock(&hta->pipeline.thread);
+		return false;
+	}
+
+	// Move the references over.
+	hta->pipeline.frames[0] = hta->frames[0];
+	hta->pipeline.frames[1] = hta->frames[1];
+	hta->frames[0] = NULL;
+	hta->frames[1] = NULL;
+
+	os_thread_helper_signal_locked(&hta->pipeline.thread);
+	os_thread_helper_unlock(&hta->pipeline.thread);
+
+	return true;
+}
+
+static void *
+ht_async_finish_loop(void *ptr)
+{
+	U_TRACE_SET_THREAD_NAME("Hand Tracking: Async finish");
+
+	struct ht_async_impl *hta = (struct ht_async_impl *)ptr;
+
+	os_thread_helper_lock(&hta->pipeline.thread);
+
+	while (os_thread_helper_is_running_locked(&hta->pipeline.thread)) {
+
+		if (hta->pipeline.frames[0] == NULL) {
+			os_thread_helper_wait_locked(&hta->pipeline.thread);
+			continue;
+		}
+
+		// Only this thread clears the frames, fine to use them unlocked.
+		os_thread_helper_unlock(&hta->pipeline.thread);
+
+		t_ht_sync_process(            //
+		    hta->provider,            //
+		    hta->pipeline.frames[0],  //
+		    hta->pipeline.frames[1],  //
+		    &hta->working.hands[0],   //
+		    &hta->working.hands[1],   //
+		    &hta->working.timestamp); //
+
+		ht_async_publish(hta);
+
+		os_thread_helper_lock(&hta->pipeline.thread);
+
+		xrt_frame_reference(&hta->pipeline.frames[0], NULL);
+		xrt_frame_reference(&hta->pipeline.frames[1], NULL);
+
+		// Wake up the mainloop if it is waiting to hand over the next frames.
+		os_thread_helper_signal_locked(&hta->pipeline.thread);
+	}
+
+	os_thread_helper_unlock(&hta->pipeline.thread);
+
+	return NULL;
+}
+
 static void *
 ht_async_mainloop(void *ptr)
 {
@@ -107,46 +275,29 @@ ht_async_mainloop(void *ptr)
 		 * Do the hand-tracking now.
 		 */
 
-		t_ht_sync_process(            //
-		    hta->provider,            //
-		    hta->frames[0],           //
-		    hta->frames[1],           //
-		    &hta->working.hands[0],   //
-		    &hta->working.hands[1],   //
-		    &hta->working.timestamp); //
-
-		xrt_frame_reference(&hta->frames[0], NULL);
-		xrt_frame_reference(&hta->frames[1], NULL);
-
-
-		/*
-		 * Post process.
-		 */
-
-		os_mutex_lock(&hta->present.mutex);
-
-		hta->present.timestamp = hta->working.timestamp;
-
-		for (int i = 0; i < 2; i++) {
-			hta->present.hands[i] = hta->working.hands[i];
-		}
-
-		os_mutex_unlock(&hta->present.mutex);
-
-		for (int i = 0; i < 2; i++) {
-			struct xrt_space_relation wrist_rel =
-			    hta->working.hands[i].values.hand_joint_set_default[XRT_HAND_JOINT_WRIST].relation;
-
-			m_relation_history_estimate_motion( //
-			    hta->present.relation_hist[i],  //
-			    &wrist_rel,                     //
-			    hta->working.timestamp,         //
-			    &wrist_rel);                    //
-
-			m_relation_history_push(           //
-			    hta->present.relation_hist[i], //
-			    &wrist_rel,                    //
-			    hta->working.timestamp);       //
+		if (hta->pipeline.enabled) {
+			t_ht_sync_process_begin(hta->provider, hta->frames[0], hta->frames[1]);
+
+			if (!ht_async_hand_over(hta)) {
+				xrt_frame_reference(&hta->frames[0], NULL);
+				xrt_frame_reference(&hta->frames[1], NULL);
+				hta->hand_tracking_work_active = false;
+				os_thread_helper_lock(&hta->mainloop);
+				break;
+			}
+		} else {
+			t_ht_sync_process(            //
+			    hta->provider,            //
+			    hta->frames[0],           //
+			    hta->frames[1],           //
+			    &hta->working.hands[0],   //
+			    &hta->working.hands[1],   //
+			    &hta->working.timestamp); //
+
+			xrt_frame_reference(&hta->frames[0], NULL);
+			xrt_frame_reference(&hta->frames[1], NULL);
+
+			ht_async_publish(hta);
 		}
 
 		hta->hand_tracking_work_active = false;
@@ -178,6 +329,11 @@ ht_async_receive_left(struct xrt_frame_sink *sink, struct xrt_frame *frame)
 		return;
 	}
 
+	// Nobody wants hands, the right frame is dropped too as there is no left.
+	if (ht_async_check_idle(hta)) {
+		return;
+	}
+
 	// Ensure a strict left then right order of frames.
 	assert(hta->frames[0] == NULL);
 
@@ -228,6 +384,11 @@ ht_async_break_apart(struct xrt_frame_node *node)
 {
 	struct ht_async_impl *hta = ht_async_impl(container_of(node, struct t_hand_tracking_async, node));
 
+	// Stop the finishing thread first, the mainloop might be waiting on it.
+	if (hta->pipeline.enabled) {
+		os_thread_helper_stop_and_wait(&hta->pipeline.thread);
+	}
+
 	// Stop the thread, unsure nothing else is pushed into the tracker.
 	os_thread_helper_stop_and_wait(&hta->mainloop);
 }
@@ -238,8 +399,16 @@ ht_async_destroy(struct xrt_frame_node *node)
 	struct ht_async_impl *hta = ht_async_impl(container_of(node, struct t_hand_tracking_async, node));
 
 	os_thread_helper_destroy(&hta->mainloop);
+	if (hta->pipeline.enabled) {
+		os_thread_helper_destroy(&hta->pipeline.thread);
+	}
 	os_mutex_destroy(&hta->present.mutex);
 
+	for (int i = 0; i < 2; i++) {
+		xrt_frame_reference(&hta->frames[i], NULL);
+		xrt_frame_reference(&hta->pipeline.frames[i], NULL);
+	}
+
 	t_ht_sync_destroy(&hta->provider);
 
 	for (int i = 0; i < 2; i++) {
@@ -273,6 +442,8 @@ ht_async_get_hand(struct t_hand_tracking_async *ht_async,
 
 	os_mutex_lock(&hta->present.mutex);
 
+	hta->present.last_query_ns = os_monotonic_get_ns();
+
 	struct xrt_hand_joint_set latest_hand = hta->present.hands[idx];
 
 	if (!hta->use_prediction) {
@@ -357,8 +528,19 @@ t_hand_tracking_async_default_create(struct xrt_frame_context *xfctx, struct t_h
 	    .max = 1000000,
 	};
 
+	int64_t idle_timeout_ms = debug_get_num_option_hta_idle_timeout_ms();
+	hta->idle_timeout_ns = idle_timeout_ms > 0 ? (uint64_t)idle_timeout_ms * U_TIME_1MS_IN_NS : 0;
+	hta->present.idle = hta->idle_timeout_ns != 0;
+
+	// Overlaps the start of one frame with the end of the previous one, needs support from the provider.
+	hta->pipeline.enabled = debug_get_bool_option_hta_pipelined() && sync->process_begin != NULL;
+
 	// In reality never fails.
 	os_mutex_init(&hta->present.mutex);
+	if (hta->pipeline.enabled) {
+		os_thread_helper_init(&hta->pipeline.thread);
+		os_thread_helper_start(&hta->pipeline.thread, ht_async_finish_loop, hta);
+	}
 	os_thread_helper_init(&hta->mainloop);
 	os_thread_helper_start(&hta->mainloop, ht_async_mainloop, hta);
 
@@ -369,6 +551,7 @@ t_hand_tracking_async_default_create(struct xrt_frame_context *xfctx, struct t_h
 	u_var_add_root(hta, "Hand-tracking async shim!", 0);
 	u_var_add_bool(hta, &hta->use_prediction, "Predict wrist movement");
 	u_var_add_draggable_f32(hta, &hta->prediction_offset_ms, "Amount to time-travel (ms)");
+	u_var_add_bool(hta, &hta->present.idle, "Idle (nobody asking for hands)");
 
 	return &hta->base;
 }
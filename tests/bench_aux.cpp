@@ -0,0 +1,386 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Microbenchmarks for aux/math and aux/util.
+ *
+ * Uses Google Benchmark, run with `--benchmark_format=json` or
+ * `--benchmark_out=<file> --benchmark_out_format=json` to get results that
+ * can be compared between releases.
+ *
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include "xrt/xrt_space.h"
+
+#include "math/m_api.h"
+#include "math/m_space.h"
+#include "math/m_relation_history.h"
+
+#include "util/u_deque.h"
+#include "util/u_hashmap.h"
+#include "util/u_hashset.h"
+#include "util/u_space_overseer.h"
+#include "util/u_template_historybuf.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+
+using xrt::auxiliary::math::RelationHistory;
+using xrt::auxiliary::util::HistoryBuffer;
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+static xrt_space_relation
+make_relation(float x)
+{
+	xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+	rel.relation_flags = (enum xrt_space_relation_flags)(XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	                                                     XRT_SPACE_RELATION_ORIENTATION_VALID_BIT);
+	rel.pose.orientation.w = 1.0f;
+	rel.pose.position.x = x;
+	return rel;
+}
+
+static xrt_pose
+make_pose(uint32_t i)
+{
+	xrt_pose pose = XRT_POSE_IDENTITY;
+	xrt_vec3 axis = {0.0f, 1.0f, 0.0f};
+	math_quat_from_angle_vector(0.1f * (float)(i % 7), &axis, &pose.orientation);
+	pose.position.x = (float)(i % 3);
+	pose.position.z = 0.5f;
+	return pose;
+}
+
+
+/*
+ *
+ * m_relation_history
+ *
+ */
+
+static void
+BM_RelationHistoryPush(benchmark::State &state)
+{
+	RelationHistory rh;
+	uint64_t ts = 0;
+
+	for (auto _ : state) {
+		ts += 1000;
+		benchmark::DoNotOptimize(rh.push(make_relation((float)ts), ts));
+	}
+}
+BENCHMARK(BM_RelationHistoryPush);
+
+static void
+BM_RelationHistoryGet(benchmark::State &state)
+{
+	RelationHistory rh;
+	const uint64_t count = (uint64_t)state.range(0);
+	for (uint64_t i = 1; i <= count; i++) {
+		rh.push(make_relation((float)i), i * 1000);
+	}
+
+	xrt_space_relation out = {};
+	uint64_t i = 0;
+
+	for (auto _ : state) {
+		// In between two entries so it interpolates.
+		uint64_t ts = ((i++ % count) + 1) * 1000 + 500;
+		benchmark::DoNotOptimize(rh.get(ts, &out));
+	}
+}
+BENCHMARK(BM_RelationHistoryGet)->Arg(16)->Arg(256)->Arg(4096);
+
+
+/*
+ *
+ * m_relation_chain
+ *
+ */
+
+static void
+BM_RelationChainResolve(benchmark::State &state)
+{
+	const uint32_t depth = (uint32_t)state.range(0);
+
+	xrt_relation_chain xrc = {};
+	for (uint32_t i = 0; i < depth; i++) {
+		xrt_pose pose = make_pose(i);
+		m_relation_chain_push_pose(&xrc, &pose);
+	}
+
+	xrt_space_relation out = {};
+
+	for (auto _ : state) {
+		m_relation_chain_resolve(&xrc, &out);
+		benchmark::DoNotOptimize(out);
+	}
+}
+BENCHMARK(BM_RelationChainResolve)->Arg(2)->Arg(4)->Arg(XRT_RELATION_CHAIN_CAPACITY);
+
+
+/*
+ *
+ * math_quat_*
+ *
+ */
+
+static void
+BM_QuatRotate(benchmark::State &state)
+{
+	xrt_pose a = make_pose(1);
+	xrt_pose b = make_pose(2);
+	xrt_quat out = {};
+
+	for (auto _ : state) {
+		math_quat_rotate(&a.orientation, &b.orientation, &out);
+		benchmark::DoNotOptimize(out);
+	}
+}
+BENCHMARK(BM_QuatRotate);
+
+static void
+BM_QuatRotateVec3(benchmark::State &state)
+{
+	xrt_pose a = make_pose(3);
+	xrt_vec3 v = {1.0f, 2.0f, 3.0f};
+	xrt_vec3 out = {};
+
+	for (auto _ : state) {
+		math_quat_rotate_vec3(&a.orientation, &v, &out);
+		benchmark::DoNotOptimize(out);
+	}
+}
+BENCHMARK(BM_QuatRotateVec3);
+
+static void
+BM_QuatNormalize(benchmark::State &state)
+{
+	xrt_quat q = {0.1f, 0.2f, 0.3f, 0.9f};
+
+	for (auto _ : state) {
+		xrt_quat tmp = q;
+		math_quat_normalize(&tmp);
+		benchmark::DoNotOptimize(tmp);
+	}
+}
+BENCHMARK(BM_QuatNormalize);
+
+static void
+BM_QuatFromAngleVector(benchmark::State &state)
+{
+	xrt_vec3 axis = {0.0f, 0.0f, 1.0f};
+	xrt_quat out = {};
+	float angle = 0.0f;
+
+	for (auto _ : state) {
+		angle += 0.001f;
+		math_quat_from_angle_vector(angle, &axis, &out);
+		benchmark::DoNotOptimize(out);
+	}
+}
+BENCHMARK(BM_QuatFromAngleVector);
+
+
+/*
+ *
+ * u_space_overseer
+ *
+ */
+
+static void
+BM_SpaceOverseerLocateDeep(benchmark::State &state)
+{
+	const uint32_t depth = (uint32_t)state.range(0);
+
+	struct u_space_overseer *uso = u_space_overseer_create(NULL);
+	struct xrt_space_overseer *xso = (struct xrt_space_overseer *)uso;
+
+	// A single long line of offset spaces hanging off the root.
+	std::vector<xrt_space *> spaces;
+	xrt_space *parent = xso->semantic.root;
+	for (uint32_t i = 0; i < depth; i++) {
+		xrt_space *space = NULL;
+		xrt_pose pose = make_pose(i);
+		xrt_space_overseer_create_offset_space(xso, parent, &pose, &space);
+		spaces.push_back(space);
+		parent = space;
+	}
+
+	xrt_pose identity = XRT_POSE_IDENTITY;
+	xrt_space_relation out = {};
+	uint64_t ts = 0;
+
+	for (auto _ : state) {
+		ts += 1000;
+		xrt_space_overseer_locate_space(xso, xso->semantic.root, &identity, ts, parent, &identity, &out);
+		benchmark::DoNotOptimize(out);
+	}
+
+	for (xrt_space *&space : spaces) {
+		xrt_space_reference(&space, NULL);
+	}
+	xrt_space_overseer_destroy(&xso);
+}
+BENCHMARK(BM_SpaceOverseerLocateDeep)->Arg(1)->Arg(4)->Arg(12);
+
+
+/*
+ *
+ * u_hashmap_int
+ *
+ */
+
+static void
+BM_HashmapIntInsertErase(benchmark::State &state)
+{
+	struct u_hashmap_int *hmi = NULL;
+	u_hashmap_int_create(&hmi);
+	uint64_t key = 0;
+
+	for (auto _ : state) {
+		u_hashmap_int_insert(hmi, key, &key);
+		u_hashmap_int_erase(hmi, key);
+		key++;
+	}
+
+	u_hashmap_int_destroy(&hmi);
+}
+BENCHMARK(BM_HashmapIntInsertErase);
+
+static void
+BM_HashmapIntFind(benchmark::State &state)
+{
+	const uint64_t count = (uint64_t)state.range(0);
+
+	struct u_hashmap_int *hmi = NULL;
+	u_hashmap_int_create(&hmi);
+	for (uint64_t i = 0; i < count; i++) {
+		u_hashmap_int_insert(hmi, i, hmi);
+	}
+
+	void *item = NULL;
+	uint64_t i = 0;
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(u_hashmap_int_find(hmi, i++ % count, &item));
+	}
+
+	u_hashmap_int_destroy(&hmi);
+}
+BENCHMARK(BM_HashmapIntFind)->Arg(16)->Arg(1024);
+
+
+/*
+ *
+ * u_hashset
+ *
+ */
+
+static void
+free_item(struct u_hashset_item *item, void *priv)
+{
+	free(item);
+}
+
+static void
+BM_HashsetFind(benchmark::State &state)
+{
+	const uint32_t count = (uint32_t)state.range(0);
+
+	struct u_hashset *hs = NULL;
+	u_hashset_create(&hs);
+
+	std::vector<std::string> strings;
+	for (uint32_t i = 0; i < count; i++) {
+		strings.push_back("/user/hand/left/input/trigger/value/" + std::to_string(i));
+		struct u_hashset_item *item = NULL;
+		u_hashset_create_and_insert_str_c(hs, strings.back().c_str(), &item);
+	}
+
+	struct u_hashset_item *item = NULL;
+	uint32_t i = 0;
+
+	for (auto _ : state) {
+		const std::string &str = strings[i++ % count];
+		benchmark::DoNotOptimize(u_hashset_find_str(hs, str.c_str(), str.size(), &item));
+	}
+
+	u_hashset_clear_and_call_for_each(hs, free_item, NULL);
+	u_hashset_destroy(&hs);
+}
+BENCHMARK(BM_HashsetFind)->Arg(16)->Arg(1024);
+
+
+/*
+ *
+ * u_deque
+ *
+ */
+
+static void
+BM_DequePushPop(benchmark::State &state)
+{
+	struct u_deque_timepoint_ns dt = u_deque_timepoint_ns_create();
+	timepoint_ns value = 0;
+
+	for (auto _ : state) {
+		u_deque_timepoint_ns_push_back(dt, value++);
+		benchmark::DoNotOptimize(u_deque_timepoint_ns_pop_front(dt, &value));
+	}
+
+	u_deque_timepoint_ns_destroy(&dt);
+}
+BENCHMARK(BM_DequePushPop);
+
+
+/*
+ *
+ * u_template_historybuf
+ *
+ */
+
+static void
+BM_HistoryBufPush(benchmark::State &state)
+{
+	HistoryBuffer<uint64_t, 1024> buf;
+	uint64_t value = 0;
+
+	for (auto _ : state) {
+		buf.push_back(value++);
+	}
+
+	benchmark::DoNotOptimize(buf.size());
+}
+BENCHMARK(BM_HistoryBufPush);
+
+static void
+BM_HistoryBufIterate(benchmark::State &state)
+{
+	HistoryBuffer<uint64_t, 1024> buf;
+	for (uint64_t i = 0; i < 1024; i++) {
+		buf.push_back(i);
+	}
+
+	for (auto _ : state) {
+		uint64_t sum = 0;
+		for (uint64_t value : buf) {
+			sum += value;
+		}
+		benchmark::DoNotOptimize(sum);
+	}
+}
+BENCHMARK(BM_HistoryBufIterate);
+
+
+BENCHMARK_MAIN();
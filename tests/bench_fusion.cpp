@@ -0,0 +1,572 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Benchmarks for the IMU fusion and tracking filters.
+ *
+ * Feeds IMU streams at the rates real devices deliver them (1 and 2 kHz) to
+ * each filter, both one sample at a time and in the batches that USB and
+ * Bluetooth devices hand over per packet. A synthetic stream is used by
+ * default, set `BENCH_FUSION_IMU_CSV` to an EuRoC style `imu0/data.csv` to
+ * replay a recording instead.
+ *
+ * Items per second is samples per second, compare it against the rate to see
+ * how much of a core one device costs.
+ *
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include "xrt/xrt_tracking.h"
+
+#include "math/m_api.h"
+#include "math/m_imu_3dof.h"
+#include "math/m_filter_one_euro.h"
+#include "math/m_lowpass_float_vector.hpp"
+#include "math/m_lowpass_integer.hpp"
+
+#include "util/u_time.h"
+
+#include "tracking/t_imu_fusion.hpp"
+
+#ifdef XRT_HAVE_OPENCV
+#include "tracking/t_tracker_psmv_fusion.hpp"
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+using xrt::auxiliary::math::IntegerLowPassIIRFilter;
+using xrt::auxiliary::math::LowPassIIRVectorFilter;
+using xrt::auxiliary::math::Rational;
+using xrt::auxiliary::tracking::SimpleIMUFusion;
+
+
+/*
+ *
+ * IMU stream.
+ *
+ */
+
+struct imu_sample
+{
+	uint64_t timestamp_ns;
+	xrt_vec3 accel; //!< m/s^2
+	xrt_vec3 gyro;  //!< rad/s
+};
+
+//! Number of seconds of samples in the synthetic stream, looped over.
+#define SYNTH_SECONDS (4)
+
+//! Number of devices in the multi device scenario, a full body setup.
+#define MULTI_DEVICE_COUNT (12)
+
+/*!
+ * A slow wobble around all three axes with some deterministic noise on top,
+ * enough to keep the gravity correction and bias estimation busy.
+ */
+static std::vector<imu_sample>
+make_synthetic_stream(uint32_t rate_hz, uint32_t seed)
+{
+	std::vector<imu_sample> samples(rate_hz * SYNTH_SECONDS);
+	uint64_t period_ns = U_TIME_1S_IN_NS / rate_hz;
+	uint32_t state = seed * 2654435761u + 1;
+
+	for (size_t i = 0; i < samples.size(); i++) {
+		double t = (double)i / (double)rate_hz;
+
+		// xorshift32, cheap and repeatable.
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		float noise = ((float)(state & 0xffff) / 65535.0f - 0.5f) * 0.02f;
+
+		imu_sample &s = samples[i];
+		s.timestamp_ns = (uint64_t)(i + 1) * period_ns;
+		s.gyro.x = (float)(0.8 * sin(t * 1.3)) + noise;
+		s.gyro.y = (float)(0.5 * sin(t * 0.7 + 1.0)) - noise;
+		s.gyro.z = (float)(0.3 * cos(t * 2.1)) + noise;
+		s.accel.x = (float)(0.4 * sin(t * 1.3)) + noise;
+		s.accel.y = 9.81f + noise;
+		s.accel.z = (float)(0.2 * cos(t * 0.7)) - noise;
+	}
+
+	return samples;
+}
+
+/*!
+ * Reads `timestamp [ns], w_x, w_y, w_z, a_x, a_y, a_z` lines, the format of
+ * the EuRoC datasets, returns an empty vector if it can't.
+ */
+static std::vector<imu_sample>
+load_csv_stream(const char *path)
+{
+	std::vector<imu_sample> samples;
+
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		fprintf(stderr, "Could not open '%s', using synthetic data.\n", path);
+		return samples;
+	}
+
+	char line[256];
+	while (fgets(line, sizeof(line), file) != NULL) {
+		unsigned long long ts = 0;
+		imu_sample s = {};
+		int ret = sscanf(line, "%llu,%f,%f,%f,%f,%f,%f", &ts, &s.gyro.x, &s.gyro.y, &s.gyro.z, &s.accel.x,
+		                 &s.accel.y, &s.accel.z);
+		if (ret != 7) {
+			continue; // Header or comment.
+		}
+		s.timestamp_ns = ts;
+		samples.push_back(s);
+	}
+
+	fclose(file);
+
+	return samples;
+}
+
+/*!
+ * The stream for the given rate and device, the recording if one was given
+ * (its own rate is used then, but timestamps are offset per device).
+ */
+static std::vector<imu_sample>
+get_stream(uint32_t rate_hz, uint32_t device)
+{
+	const char *path = getenv("BENCH_FUSION_IMU_CSV");
+	if (path != NULL) {
+		std::vector<imu_sample> samples = load_csv_stream(path);
+		if (!samples.empty()) {
+			for (imu_sample &s : samples) {
+				s.timestamp_ns += device * 97 * U_TIME_1MS_IN_NS / 100;
+			}
+			return samples;
+		}
+	}
+
+	return make_synthetic_stream(rate_hz, device);
+}
+
+/*!
+ * Loops over a stream, shifting timestamps forward every lap so filters
+ * always see time moving forward.
+ */
+struct stream_cursor
+{
+	const std::vector<imu_sample> *samples = nullptr;
+	size_t index = 0;
+	uint64_t offset_ns = 0;
+
+	imu_sample
+	next()
+	{
+		if (index >= samples->size()) {
+			// Recordings start at arbitrary times, continue one period after the end.
+			uint64_t first_ns = samples->front().timestamp_ns;
+			uint64_t last_ns = samples->back().timestamp_ns;
+			uint64_t period_ns = (last_ns - first_ns) / std::max<size_t>(samples->size() - 1, 1);
+			index = 0;
+			offset_ns += last_ns - first_ns + period_ns;
+		}
+
+		imu_sample s = (*samples)[index++];
+		s.timestamp_ns += offset_ns;
+		return s;
+	}
+};
+
+static Eigen::Vector3d
+to_eigen(const xrt_vec3 &v)
+{
+	return Eigen::Vector3d(v.x, v.y, v.z);
+}
+
+static void
+rate_args(benchmark::internal::Benchmark *b)
+{
+	b->ArgName("hz")->Arg(1000)->Arg(2000);
+}
+
+static void
+rate_batch_args(benchmark::internal::Benchmark *b)
+{
+	b->ArgNames({"hz", "batch"});
+	for (int64_t hz : {1000, 2000}) {
+		for (int64_t batch : {1, 8, 16}) {
+			b->Args({hz, batch});
+		}
+	}
+}
+
+
+/*
+ *
+ * m_imu_3dof
+ *
+ */
+
+static void
+BM_Imu3dofPerSample(benchmark::State &state)
+{
+	std::vector<imu_sample> samples = get_stream((uint32_t)state.range(0), 0);
+	stream_cursor cursor = {&samples};
+
+	m_imu_3dof f;
+	m_imu_3dof_init(&f, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+
+	for (auto _ : state) {
+		imu_sample s = cursor.next();
+		m_imu_3dof_update(&f, s.timestamp_ns, &s.accel, &s.gyro);
+		benchmark::DoNotOptimize(f.rot);
+	}
+
+	m_imu_3dof_close(&f);
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Imu3dofPerSample)->Apply(rate_args);
+
+/*!
+ * One iteration is one wake of a device thread, a packet worth of samples is
+ * integrated and the pose read out once, like a driver does.
+ */
+static void
+BM_Imu3dofBatch(benchmark::State &state)
+{
+	std::vector<imu_sample> samples = get_stream((uint32_t)state.range(0), 0);
+	stream_cursor cursor = {&samples};
+	uint32_t batch = (uint32_t)state.range(1);
+
+	std::vector<uint64_t> timestamps(batch);
+	std::vector<xrt_vec3> accels(batch);
+	std::vector<xrt_vec3> gyros(batch);
+
+	m_imu_3dof f;
+	m_imu_3dof_init(&f, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+
+	for (auto _ : state) {
+		for (uint32_t i = 0; i < batch; i++) {
+			imu_sample s = cursor.next();
+			timestamps[i] = s.timestamp_ns;
+			accels[i] = s.accel;
+			gyros[i] = s.gyro;
+		}
+
+		m_imu_3dof_update_batch(&f, timestamps.data(), accels.data(), gyros.data(), batch);
+		benchmark::DoNotOptimize(f.rot);
+	}
+
+	m_imu_3dof_close(&f);
+	state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_Imu3dofBatch)->Apply(rate_batch_args);
+
+
+/*
+ *
+ * SimpleIMUFusion
+ *
+ */
+
+static void
+BM_SimpleImuFusion(benchmark::State &state)
+{
+	std::vector<imu_sample> samples = get_stream((uint32_t)state.range(0), 0);
+	stream_cursor cursor = {&samples};
+	uint32_t batch = (uint32_t)state.range(1);
+
+	SimpleIMUFusion fusion;
+
+	for (auto _ : state) {
+		uint64_t last_ns = 0;
+		for (uint32_t i = 0; i < batch; i++) {
+			imu_sample s = cursor.next();
+			fusion.handleGyro(to_eigen(s.gyro), s.timestamp_ns);
+			fusion.handleAccel(to_eigen(s.accel), s.timestamp_ns);
+			last_ns = s.timestamp_ns;
+		}
+
+		// Predict a frame ahead, as the device's get_tracked_pose would.
+		Eigen::Quaterniond quat = fusion.getPredictedQuat(last_ns + 11 * U_TIME_1MS_IN_NS);
+		benchmark::DoNotOptimize(quat);
+	}
+
+	state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_SimpleImuFusion)->Apply(rate_batch_args);
+
+
+/*
+ *
+ * One euro and low-pass filters.
+ *
+ */
+
+static void
+BM_OneEuroVec3(benchmark::State &state)
+{
+	std::vector<imu_sample> samples = get_stream((uint32_t)state.range(0), 0);
+	stream_cursor cursor = {&samples};
+
+	m_filter_euro_vec3 f;
+	m_filter_euro_vec3_init(&f, 1.0, 1.0, 0.05);
+
+	for (auto _ : state) {
+		imu_sample s = cursor.next();
+		xrt_vec3 out;
+		m_filter_euro_vec3_run(&f, s.timestamp_ns, &s.accel, &out);
+		benchmark::DoNotOptimize(out);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OneEuroVec3)->Apply(rate_args);
+
+static void
+BM_OneEuroQuat(benchmark::State &state)
+{
+	std::vector<imu_sample> samples = get_stream((uint32_t)state.range(0), 0);
+	stream_cursor cursor = {&samples};
+
+	m_filter_euro_quat f;
+	m_filter_euro_quat_init(&f, 1.0, 1.0, 0.05);
+
+	for (auto _ : state) {
+		imu_sample s = cursor.next();
+
+		// A rotation that follows the gyro, so the filter sees motion.
+		xrt_quat in;
+		math_quat_from_angle_vector(0.1f, &s.gyro, &in);
+
+		xrt_quat out;
+		m_filter_euro_quat_run(&f, s.timestamp_ns, &in, &out);
+		benchmark::DoNotOptimize(out);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OneEuroQuat)->Apply(rate_args);
+
+static void
+BM_LowPassVector(benchmark::State &state)
+{
+	std::vector<imu_sample> samples = get_stream((uint32_t)state.range(0), 0);
+	stream_cursor cursor = {&samples};
+
+	LowPassIIRVectorFilter<3, double> filter(200.0);
+
+	for (auto _ : state) {
+		imu_sample s = cursor.next();
+		filter.addSample(to_eigen(s.accel), s.timestamp_ns);
+		benchmark::DoNotOptimize(filter.getState());
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LowPassVector)->Apply(rate_args);
+
+static void
+BM_LowPassInteger(benchmark::State &state)
+{
+	std::vector<imu_sample> samples = get_stream((uint32_t)state.range(0), 0);
+	stream_cursor cursor = {&samples};
+
+	IntegerLowPassIIRFilter<int64_t> filter(Rational<int64_t>{1, 16});
+
+	for (auto _ : state) {
+		imu_sample s = cursor.next();
+		// Raw counts like a driver has before scaling, 16 LSB per mg.
+		filter.addSample((int64_t)(s.accel.y * 1632.0f));
+		benchmark::DoNotOptimize(filter.getState());
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LowPassInteger)->Apply(rate_args);
+
+
+/*
+ *
+ * PSMV fusion, the Kalman filter in t_kalman.cpp.
+ *
+ */
+
+#ifdef XRT_HAVE_OPENCV
+using xrt::auxiliary::tracking::PSMVFusionInterface;
+
+/*!
+ * IMU samples at the given rate with a vision update at 60Hz, the way the
+ * PSMV tracker feeds it.
+ */
+static void
+BM_PsmvFusion(benchmark::State &state)
+{
+	uint32_t rate_hz = (uint32_t)state.range(0);
+	std::vector<imu_sample> samples = get_stream(rate_hz, 0);
+	stream_cursor cursor = {&samples};
+	uint64_t vision_period_ns = U_TIME_1S_IN_NS / 60;
+	uint64_t next_vision_ns = 0;
+
+	std::unique_ptr<PSMVFusionInterface> fusion = PSMVFusionInterface::create();
+
+	for (auto _ : state) {
+		imu_sample s = cursor.next();
+
+		xrt_tracking_sample sample = {};
+		sample.accel_m_s2 = s.accel;
+		sample.gyro_rad_secs = s.gyro;
+		fusion->process_imu_data(s.timestamp_ns, &sample, NULL);
+
+		if (s.timestamp_ns >= next_vision_ns) {
+			xrt_vec3 pos = {0.1f * s.accel.x, 1.5f, -0.5f};
+			fusion->process_3d_vision_data(s.timestamp_ns, &pos, NULL, NULL, 1.5f);
+			next_vision_ns = s.timestamp_ns + vision_period_ns;
+		}
+	}
+
+	xrt_space_relation rel;
+	fusion->get_prediction(next_vision_ns, &rel);
+	benchmark::DoNotOptimize(rel);
+
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PsmvFusion)->Apply(rate_args);
+#endif
+
+
+/*
+ *
+ * Multi device and waking.
+ *
+ */
+
+/*!
+ * Twelve devices each with their own 3dof filter, streams and phase, one
+ * iteration is one packet from every device. Shows how the cost scales once
+ * the state of all filters no longer stays in the caches of one core.
+ */
+static void
+BM_MultiDevice3dof(benchmark::State &state)
+{
+	uint32_t rate_hz = (uint32_t)state.range(0);
+	uint32_t batch = (uint32_t)state.range(1);
+
+	std::vector<std::vector<imu_sample>> streams(MULTI_DEVICE_COUNT);
+	std::vector<stream_cursor> cursors(MULTI_DEVICE_COUNT);
+	std::vector<m_imu_3dof> filters(MULTI_DEVICE_COUNT);
+
+	for (uint32_t d = 0; d < MULTI_DEVICE_COUNT; d++) {
+		streams[d] = get_stream(rate_hz, d);
+		cursors[d].samples = &streams[d];
+		m_imu_3dof_init(&filters[d], M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+	}
+
+	std::vector<uint64_t> timestamps(batch);
+	std::vector<xrt_vec3> accels(batch);
+	std::vector<xrt_vec3> gyros(batch);
+
+	for (auto _ : state) {
+		for (uint32_t d = 0; d < MULTI_DEVICE_COUNT; d++) {
+			for (uint32_t i = 0; i < batch; i++) {
+				imu_sample s = cursors[d].next();
+				timestamps[i] = s.timestamp_ns;
+				accels[i] = s.accel;
+				gyros[i] = s.gyro;
+			}
+
+			m_imu_3dof_update_batch(&filters[d], timestamps.data(), accels.data(), gyros.data(), batch);
+			benchmark::DoNotOptimize(filters[d].rot);
+		}
+	}
+
+	for (m_imu_3dof &f : filters) {
+		m_imu_3dof_close(&f);
+	}
+
+	state.SetItemsProcessed(state.iterations() * batch * MULTI_DEVICE_COUNT);
+}
+BENCHMARK(BM_MultiDevice3dof)->Apply(rate_batch_args);
+
+/*!
+ * The cost of waking a fusion thread, a producer hands packets of samples to
+ * a consumer thread through a condition variable like a driver's USB thread
+ * does. Compare against @ref BM_Imu3dofBatch to see how much of the per
+ * sample cost is the wake rather than the filter.
+ */
+static void
+BM_ThreadWake3dof(benchmark::State &state)
+{
+	std::vector<imu_sample> samples = get_stream((uint32_t)state.range(0), 0);
+	stream_cursor cursor = {&samples};
+	uint32_t batch = (uint32_t)state.range(1);
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::vector<imu_sample> pending;
+	uint64_t produced = 0;
+	uint64_t consumed = 0;
+	bool running = true;
+
+	std::thread consumer([&] {
+		m_imu_3dof f;
+		m_imu_3dof_init(&f, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+
+		std::vector<imu_sample> work;
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			cond.wait(lock, [&] { return !pending.empty() || !running; });
+			if (pending.empty()) {
+				break;
+			}
+
+			work.swap(pending);
+			lock.unlock();
+
+			for (const imu_sample &s : work) {
+				m_imu_3dof_update(&f, s.timestamp_ns, &s.accel, &s.gyro);
+			}
+			benchmark::DoNotOptimize(f.rot);
+
+			lock.lock();
+			consumed += work.size();
+			work.clear();
+			cond.notify_all();
+		}
+
+		m_imu_3dof_close(&f);
+	});
+
+	for (auto _ : state) {
+		std::unique_lock<std::mutex> lock(mutex);
+		for (uint32_t i = 0; i < batch; i++) {
+			pending.push_back(cursor.next());
+		}
+		produced += batch;
+		cond.notify_all();
+
+		// Wait for the packet to be processed, so each iteration is one wake.
+		cond.wait(lock, [&] { return consumed == produced; });
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		running = false;
+		cond.notify_all();
+	}
+	consumer.join();
+
+	state.SetItemsProcessed(state.iterations() * batch);
+}
+BENCHMARK(BM_ThreadWake3dof)->Apply(rate_batch_args)->UseRealTime();
+
+
+BENCHMARK_MAIN();
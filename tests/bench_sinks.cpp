@@ -0,0 +1,529 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Throughput benchmarks for the frame sink pipeline.
+ *
+ * Pushes synthetic camera frames through the u_sink converters, queue,
+ * splitters and combiner, and the HSV filter when built with OpenCV. Besides
+ * the time per frame every benchmark reports `frames_per_second`,
+ * `latency_us`, the time from pushing a frame to the last sink getting it,
+ * and `allocs_per_frame`, heap allocations made while pushing one frame.
+ * The allocation counter only works with glibc and without sanitizers,
+ * otherwise it reads zero.
+ *
+ * Uses Google Benchmark, run with `--benchmark_format=json` or
+ * `--benchmark_out=<file> --benchmark_out_format=json` to get results that
+ * can be compared between changes.
+ *
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include "xrt/xrt_frame.h"
+#include "xrt/xrt_config_have.h"
+
+#include "os/os_time.h"
+
+#include "util/u_sink.h"
+#include "util/u_frame.h"
+#include "util/u_format.h"
+
+#ifdef XRT_HAVE_OPENCV
+#include "tracking/t_tracking.h"
+#endif
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef XRT_HAVE_JPEG
+#include <jpeglib.h>
+#endif
+
+
+/*
+ *
+ * Allocation counting.
+ *
+ */
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define BENCH_COUNT_ALLOCS
+#endif
+
+static std::atomic<uint64_t> g_alloc_count{0};
+
+#ifdef BENCH_COUNT_ALLOCS
+extern "C" {
+
+void *
+__libc_malloc(size_t size);
+void *
+__libc_calloc(size_t count, size_t size);
+void *
+__libc_realloc(void *ptr, size_t size);
+
+// Replaces the ones from glibc for the whole process, free is left as is.
+void *
+malloc(size_t size)
+{
+	g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t count, size_t size)
+{
+	g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+	return __libc_calloc(count, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+	g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+	return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+#endif
+
+
+/*
+ *
+ * Helpers.
+ *
+ */
+
+namespace {
+
+/*!
+ * End of a chain, counts frames and how long they took to get here.
+ */
+struct counting_sink
+{
+	struct xrt_frame_sink base = {};
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	uint64_t frame_count = 0;
+	uint64_t latency_total_ns = 0;
+
+	counting_sink()
+	{
+		base.push_frame = push;
+	}
+
+	static void
+	push(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+	{
+		counting_sink *s = reinterpret_cast<counting_sink *>(xfs);
+		uint64_t now_ns = os_monotonic_get_ns();
+
+		std::unique_lock<std::mutex> lock(s->mutex);
+		s->frame_count++;
+		s->latency_total_ns += now_ns - (uint64_t)xf->timestamp;
+		s->cond.notify_all();
+	}
+
+	//! For chains with a thread in them.
+	void
+	wait_for(uint64_t count)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [this, count] { return frame_count >= count; });
+	}
+};
+
+/*!
+ * Runs one chain, @p push is called once per iteration with a fresh timestamp
+ * and @p sinks are where all frames end up, each gets one frame per push.
+ */
+template <typename F>
+void
+run_chain(benchmark::State &state, std::vector<counting_sink *> sinks, F push)
+{
+	uint64_t allocs_before = g_alloc_count.load();
+	uint64_t start_ns = os_monotonic_get_ns();
+	uint64_t pushes = 0;
+
+	for (auto _ : state) {
+		push((int64_t)os_monotonic_get_ns());
+		pushes++;
+
+		for (counting_sink *s : sinks) {
+			s->wait_for(pushes);
+		}
+	}
+
+	// Wall clock, some of the sinks do their work on other threads.
+	double elapsed_s = (double)(os_monotonic_get_ns() - start_ns) / 1e9;
+	uint64_t allocs = g_alloc_count.load() - allocs_before;
+
+	uint64_t frames = 0;
+	uint64_t latency_ns = 0;
+	for (counting_sink *s : sinks) {
+		frames += s->frame_count;
+		latency_ns += s->latency_total_ns;
+	}
+
+	state.counters["frames_per_second"] = elapsed_s > 0.0 ? (double)pushes / elapsed_s : 0.0;
+	state.counters["latency_us"] = frames > 0 ? (double)latency_ns / (double)frames / 1000.0 : 0.0;
+	state.counters["allocs_per_frame"] = pushes > 0 ? (double)allocs / (double)pushes : 0.0;
+}
+
+/*!
+ * A frame with a repeating pattern, so converters have something that is not
+ * all zeros to chew on.
+ */
+struct xrt_frame *
+make_frame(enum xrt_format format, uint32_t width, uint32_t height, enum xrt_stereo_format stereo)
+{
+	struct xrt_frame *xf = NULL;
+	u_frame_create_one_off(format, width, height, &xf);
+
+	for (uint32_t y = 0; y < xf->height; y++) {
+		uint8_t *row = xf->data + y * xf->stride;
+		for (size_t x = 0; x < xf->stride; x++) {
+			row[x] = (uint8_t)((x * 7 + y * 13) & 0xff);
+		}
+	}
+
+	xf->stereo_format = stereo;
+
+	return xf;
+}
+
+#ifdef XRT_HAVE_JPEG
+/*!
+ * Encodes a smooth gradient, noisy patterns make unrealistically large files.
+ */
+struct xrt_frame *
+make_mjpeg_frame(uint32_t width, uint32_t height)
+{
+	std::vector<uint8_t> rgb((size_t)width * height * 3);
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			uint8_t *p = &rgb[((size_t)y * width + x) * 3];
+			p[0] = (uint8_t)(x * 255 / width);
+			p[1] = (uint8_t)(y * 255 / height);
+			p[2] = (uint8_t)((x + y) & 0xff);
+		}
+	}
+
+	struct jpeg_compress_struct cinfo = {};
+	struct jpeg_error_mgr jerr = {};
+	unsigned char *out = NULL;
+	unsigned long out_size = 0;
+
+	cinfo.err = jpeg_std_error(&jerr);
+	jpeg_create_compress(&cinfo);
+	jpeg_mem_dest(&cinfo, &out, &out_size);
+
+	cinfo.image_width = width;
+	cinfo.image_height = height;
+	cinfo.input_components = 3;
+	cinfo.in_color_space = JCS_RGB;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, 85, TRUE);
+	jpeg_start_compress(&cinfo, TRUE);
+
+	while (cinfo.next_scanline < cinfo.image_height) {
+		JSAMPROW row = &rgb[(size_t)cinfo.next_scanline * width * 3];
+		jpeg_write_scanlines(&cinfo, &row, 1);
+	}
+
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+
+	// Like the v4l2 driver the frame holds the compressed data as is.
+	struct xrt_frame *xf = NULL;
+	u_frame_create_one_off(XRT_FORMAT_L8, (uint32_t)out_size, 1, &xf);
+	memcpy(xf->data, out, out_size);
+	free(out);
+
+	xf->format = XRT_FORMAT_MJPEG;
+	xf->width = width;
+	xf->height = height;
+	xf->stride = 0;
+	xf->size = out_size;
+
+	return xf;
+}
+#endif
+
+void
+push_frame(struct xrt_frame_sink *xfs, struct xrt_frame *xf, int64_t timestamp)
+{
+	xf->timestamp = timestamp;
+	xrt_sink_push_frame(xfs, xf);
+}
+
+} // namespace
+
+
+/*
+ *
+ * u_sink_converter
+ *
+ */
+
+static void
+bench_converter(benchmark::State &state, struct xrt_frame *xf, enum xrt_format to)
+{
+	struct xrt_frame_context xfctx = {};
+	counting_sink sink;
+	struct xrt_frame_sink *xfs = NULL;
+
+	u_sink_create_format_converter(&xfctx, to, &sink.base, &xfs);
+
+	run_chain(state, {&sink}, [&](int64_t ts) { push_frame(xfs, xf, ts); });
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+	xrt_frame_reference(&xf, NULL);
+}
+
+static void
+BM_ConverterYuyvToR8G8B8(benchmark::State &state)
+{
+	struct xrt_frame *xf = make_frame(XRT_FORMAT_YUYV422, 1280, 720, XRT_STEREO_FORMAT_NONE);
+	bench_converter(state, xf, XRT_FORMAT_R8G8B8);
+}
+BENCHMARK(BM_ConverterYuyvToR8G8B8);
+
+static void
+BM_ConverterYuyvToL8(benchmark::State &state)
+{
+	struct xrt_frame *xf = make_frame(XRT_FORMAT_YUYV422, 1280, 720, XRT_STEREO_FORMAT_NONE);
+	bench_converter(state, xf, XRT_FORMAT_L8);
+}
+BENCHMARK(BM_ConverterYuyvToL8);
+
+static void
+BM_ConverterBayerToR8G8B8(benchmark::State &state)
+{
+	struct xrt_frame *xf = make_frame(XRT_FORMAT_BAYER_GR8, 1280, 800, XRT_STEREO_FORMAT_NONE);
+	bench_converter(state, xf, XRT_FORMAT_R8G8B8);
+}
+BENCHMARK(BM_ConverterBayerToR8G8B8);
+
+#ifdef XRT_HAVE_JPEG
+static void
+BM_ConverterMjpegToR8G8B8(benchmark::State &state)
+{
+	struct xrt_frame *xf = make_mjpeg_frame(1280, 720);
+	bench_converter(state, xf, XRT_FORMAT_R8G8B8);
+}
+BENCHMARK(BM_ConverterMjpegToR8G8B8);
+
+static void
+BM_ConverterMjpegToL8(benchmark::State &state)
+{
+	struct xrt_frame *xf = make_mjpeg_frame(1280, 720);
+	bench_converter(state, xf, XRT_FORMAT_L8);
+}
+BENCHMARK(BM_ConverterMjpegToL8);
+#endif
+
+
+/*
+ *
+ * Stereo sinks, the frames are 640x480 per view.
+ *
+ */
+
+static void
+BM_DeinterleaverStereoL8(benchmark::State &state)
+{
+	struct xrt_frame_context xfctx = {};
+	counting_sink sink;
+	struct xrt_frame_sink *xfs = NULL;
+
+	// Interleaved frames have both views in each pixel, so half the width.
+	struct xrt_frame *xf = make_frame(XRT_FORMAT_L8, 1280, 480, XRT_STEREO_FORMAT_INTERLEAVED);
+
+	u_sink_deinterleaver_create(&xfctx, &sink.base, &xfs);
+
+	run_chain(state, {&sink}, [&](int64_t ts) { push_frame(xfs, xf, ts); });
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+	xrt_frame_reference(&xf, NULL);
+}
+BENCHMARK(BM_DeinterleaverStereoL8);
+
+static void
+BM_SplitSbsStereoL8(benchmark::State &state)
+{
+	struct xrt_frame_context xfctx = {};
+	counting_sink left;
+	counting_sink right;
+	struct xrt_frame_sink *xfs = NULL;
+
+	struct xrt_frame *xf = make_frame(XRT_FORMAT_L8, 1280, 480, XRT_STEREO_FORMAT_SBS);
+
+	u_sink_stereo_sbs_to_slam_sbs_create(&xfctx, &left.base, &right.base, &xfs);
+
+	run_chain(state, {&left, &right}, [&](int64_t ts) { push_frame(xfs, xf, ts); });
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+	xrt_frame_reference(&xf, NULL);
+}
+BENCHMARK(BM_SplitSbsStereoL8);
+
+static void
+BM_SplitFanOutStereoL8(benchmark::State &state)
+{
+	struct xrt_frame_context xfctx = {};
+	counting_sink left;
+	counting_sink right;
+	struct xrt_frame_sink *xfs = NULL;
+
+	struct xrt_frame *xf = make_frame(XRT_FORMAT_L8, 1280, 480, XRT_STEREO_FORMAT_SBS);
+
+	u_sink_split_create(&xfctx, &left.base, &right.base, &xfs);
+
+	run_chain(state, {&left, &right}, [&](int64_t ts) { push_frame(xfs, xf, ts); });
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+	xrt_frame_reference(&xf, NULL);
+}
+BENCHMARK(BM_SplitFanOutStereoL8);
+
+static void
+BM_CombinerStereoL8(benchmark::State &state)
+{
+	struct xrt_frame_context xfctx = {};
+	counting_sink sink;
+	struct xrt_frame_sink *left = NULL;
+	struct xrt_frame_sink *right = NULL;
+
+	struct xrt_frame *l = make_frame(XRT_FORMAT_L8, 640, 480, XRT_STEREO_FORMAT_NONE);
+	struct xrt_frame *r = make_frame(XRT_FORMAT_L8, 640, 480, XRT_STEREO_FORMAT_NONE);
+
+	u_sink_combiner_create(&xfctx, &sink.base, &left, &right);
+
+	run_chain(state, {&sink}, [&](int64_t ts) {
+		push_frame(left, l, ts);
+		push_frame(right, r, ts);
+	});
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+	xrt_frame_reference(&l, NULL);
+	xrt_frame_reference(&r, NULL);
+}
+BENCHMARK(BM_CombinerStereoL8);
+
+
+/*
+ *
+ * u_sink_queue, measures the hand off to the queue thread.
+ *
+ */
+
+static void
+BM_QueueHandoffStereoL8(benchmark::State &state)
+{
+	struct xrt_frame_context xfctx = {};
+	counting_sink sink;
+	struct xrt_frame_sink *xfs = NULL;
+
+	struct xrt_frame *xf = make_frame(XRT_FORMAT_L8, 1280, 480, XRT_STEREO_FORMAT_SBS);
+
+	u_sink_simple_queue_create(&xfctx, &sink.base, &xfs);
+
+	run_chain(state, {&sink}, [&](int64_t ts) { push_frame(xfs, xf, ts); });
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+	xrt_frame_reference(&xf, NULL);
+}
+BENCHMARK(BM_QueueHandoffStereoL8)->UseRealTime();
+
+static void
+BM_QueueDeinterleaveSplitStereoL8(benchmark::State &state)
+{
+	struct xrt_frame_context xfctx = {};
+	counting_sink left;
+	counting_sink right;
+	struct xrt_frame_sink *split = NULL;
+	struct xrt_frame_sink *deinterleaver = NULL;
+	struct xrt_frame_sink *queue = NULL;
+
+	struct xrt_frame *xf = make_frame(XRT_FORMAT_L8, 1280, 480, XRT_STEREO_FORMAT_INTERLEAVED);
+
+	// Like a stereo camera feeding a SLAM tracker.
+	u_sink_stereo_sbs_to_slam_sbs_create(&xfctx, &left.base, &right.base, &split);
+	u_sink_deinterleaver_create(&xfctx, split, &deinterleaver);
+	u_sink_simple_queue_create(&xfctx, deinterleaver, &queue);
+
+	run_chain(state, {&left, &right}, [&](int64_t ts) { push_frame(queue, xf, ts); });
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+	xrt_frame_reference(&xf, NULL);
+}
+BENCHMARK(BM_QueueDeinterleaveSplitStereoL8)->UseRealTime();
+
+
+/*
+ *
+ * t_hsv_filter
+ *
+ */
+
+#ifdef XRT_HAVE_OPENCV
+static void
+bench_hsv(benchmark::State &state, enum xrt_format from, bool convert)
+{
+	struct xrt_frame_context xfctx = {};
+	counting_sink sinks[4];
+	struct xrt_frame_sink *sink_ptrs[4] = {&sinks[0].base, &sinks[1].base, &sinks[2].base, &sinks[3].base};
+	struct xrt_frame_sink *hsv = NULL;
+	struct xrt_frame_sink *xfs = NULL;
+
+	struct xrt_frame *xf = make_frame(from, 640, 480, XRT_STEREO_FORMAT_NONE);
+
+	struct t_hsv_filter_params params = T_HSV_DEFAULT_PARAMS();
+	t_hsv_filter_create(&xfctx, &params, sink_ptrs, &hsv);
+
+	// Like the PS Eye pipeline of the PSMV tracker.
+	xfs = hsv;
+	if (convert) {
+		u_sink_create_to_yuv_or_yuyv(&xfctx, hsv, &xfs);
+	}
+
+	run_chain(state, {&sinks[0], &sinks[1], &sinks[2], &sinks[3]}, [&](int64_t ts) { push_frame(xfs, xf, ts); });
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+	xrt_frame_reference(&xf, NULL);
+}
+
+static void
+BM_HsvFilterYuyv(benchmark::State &state)
+{
+	bench_hsv(state, XRT_FORMAT_YUYV422, false);
+}
+BENCHMARK(BM_HsvFilterYuyv);
+
+static void
+BM_HsvFilterYuv888(benchmark::State &state)
+{
+	bench_hsv(state, XRT_FORMAT_YUV888, false);
+}
+BENCHMARK(BM_HsvFilterYuv888);
+
+static void
+BM_ConverterHsvFilterYuyv(benchmark::State &state)
+{
+	bench_hsv(state, XRT_FORMAT_YUYV422, true);
+}
+BENCHMARK(BM_ConverterHsvFilterYuyv);
+#endif
+
+
+BENCHMARK_MAIN();
@@ -0,0 +1,155 @@
+#!/usr/bin/env python3
+# Copyright 2024, Collabora, Ltd.
+# SPDX-License-Identifier: BSL-1.0
+"""
+Run a benchmark and compare its results against a stored baseline.
+
+Used by the tests labelled "perf", every result is turned into a time where
+lower is better and compared against the same entry in the baseline file. The
+test fails if any result is more than the threshold slower than the baseline.
+
+Set XRT_PERF_UPDATE_BASELINE=1 to write the results to the baseline instead,
+entries for other benchmarks already in the file are kept.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+# ctest treats this as skipped, see SKIP_RETURN_CODE in tests/CMakeLists.txt.
+SKIP = 77
+
+
+def run(cmd):
+    """Run cmd, returning the exit code and output."""
+    print("Running:", " ".join(cmd), flush=True)
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+    sys.stderr.write(proc.stderr)
+    return proc.returncode, proc.stdout, proc.stderr
+
+
+def results_gbench(exe, extra):
+    """Google Benchmark, the median of the repetitions of each benchmark."""
+    with tempfile.TemporaryDirectory() as tmp:
+        out = Path(tmp) / "out.json"
+        code, _, _ = run([exe,
+                          "--benchmark_repetitions=5",
+                          "--benchmark_report_aggregates_only=true",
+                          "--benchmark_out_format=json",
+                          "--benchmark_out=" + str(out)] + extra)
+        if code != 0:
+            sys.exit("Benchmark failed with {}".format(code))
+        data = json.loads(out.read_text())
+
+    scale = {"ns": 1, "us": 1e3, "ms": 1e6, "s": 1e9}
+    results = {}
+    for b in data["benchmarks"]:
+        if b.get("aggregate_name") != "median":
+            continue
+        results[b["run_name"]] = b["real_time"] * scale[b["time_unit"]]
+    return results
+
+
+def results_comp(exe, extra):
+    """monado-comp-bench, the mean and p99 CPU and GPU frame times."""
+    code, stdout, _ = run([exe] + extra)
+    if code != 0 or "Mean (us)" not in stdout:
+        print("Compositor benchmark did not run, no usable Vulkan device?")
+        sys.exit(SKIP)
+
+    results = {}
+    for line in stdout.splitlines():
+        # Time, frames, mean, p50, p90, p99 and max.
+        m = re.match(r"^(CPU|GPU)\s+\d+\s+([\d.]+)\s+[\d.]+\s+[\d.]+\s+([\d.]+)\s+[\d.]+", line)
+        if m:
+            results[m.group(1) + "/mean"] = float(m.group(2)) * 1e3
+            results[m.group(1) + "/p99"] = float(m.group(3)) * 1e3
+    return results
+
+
+def results_ipc(exe, extra):
+    """monado-ipc-bench, the time per frame and the mean of every call."""
+    code, stdout, stderr = run([exe] + extra)
+    if "Failed to connect" in stderr:
+        print("Could not connect to the service, is monado-service running?")
+        sys.exit(SKIP)
+    if code != 0:
+        sys.exit("IPC benchmark failed with {}".format(code))
+
+    results = {}
+    for line in stdout.splitlines():
+        m = re.match(r"^(\w+)\s+\d+\s+([\d.]+)\s+[\d.]+$", line)
+        if m:
+            results[m.group(1)] = float(m.group(2)) * 1e3
+        m = re.search(r"([\d.]+) frames/s", line)
+        if m and float(m.group(1)) > 0:
+            results["frame"] = 1e9 / float(m.group(1))
+    return results
+
+
+KINDS = {
+    "gbench": results_gbench,
+    "comp": results_comp,
+    "ipc": results_ipc,
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--kind", choices=KINDS.keys(), required=True)
+    parser.add_argument("--name", required=True, help="Name of the benchmark in the baseline")
+    parser.add_argument("--baseline", required=True, type=Path)
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="Percent slower than the baseline that is still a pass")
+    parser.add_argument("exe")
+    parser.add_argument("args", nargs=argparse.REMAINDER)
+    args = parser.parse_args()
+
+    results = KINDS[args.kind](args.exe, args.args)
+    if not results:
+        sys.exit("No results from the benchmark")
+
+    baseline = {}
+    if args.baseline.exists():
+        baseline = json.loads(args.baseline.read_text())
+
+    if os.environ.get("XRT_PERF_UPDATE_BASELINE"):
+        baseline[args.name] = results
+        args.baseline.parent.mkdir(parents=True, exist_ok=True)
+        args.baseline.write_text(json.dumps(baseline, indent=2, sort_keys=True) + "\n")
+        print("Wrote {} results to {}".format(len(results), args.baseline))
+        return 0
+
+    if args.name not in baseline:
+        print("No baseline for {} in {}, run with XRT_PERF_UPDATE_BASELINE=1 to record one."
+              .format(args.name, args.baseline))
+        return SKIP
+
+    failed = 0
+    for key, value in sorted(results.items()):
+        base = baseline[args.name].get(key)
+        if base is None or base <= 0:
+            print("{:<64} {:>12.1f}ns (new)".format(key, value))
+            continue
+
+        change = (value - base) * 100.0 / base
+        status = "ok"
+        if change > args.threshold:
+            status = "SLOWER"
+            failed += 1
+        print("{:<64} {:>12.1f}ns {:>+7.1f}% {}".format(key, value, change, status))
+
+    if failed:
+        print("{} result(s) more than {}% slower than the baseline".format(failed, args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
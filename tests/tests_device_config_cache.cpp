@@ -0,0 +1,97 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Device config cache tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include <util/u_device_config_cache.h>
+
+#include "catch/catch.hpp"
+
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#ifdef XRT_OS_LINUX
+
+TEST_CASE("u_device_config_cache")
+{
+	char dir[] = "/tmp/monado-device-config-cache-XXXXXX";
+	REQUIRE(mkdtemp(dir) != nullptr);
+	setenv("XDG_CACHE_HOME", dir, 1);
+
+	REQUIRE(u_device_config_cache_enabled());
+
+	const char blob[] = "{\"calibration\": [1, 2, 3]}";
+	const size_t blob_size = sizeof(blob) - 1;
+
+	uint64_t checksum = u_device_config_cache_hash_bytes(U_DEVICE_CONFIG_CACHE_HASH_INIT, "meta", 4);
+	REQUIRE(checksum != U_DEVICE_CONFIG_CACHE_HASH_INIT);
+
+	uint8_t *out = nullptr;
+	size_t out_size = 0;
+
+	SECTION("missing entry")
+	{
+		CHECK_FALSE(u_device_config_cache_load("test", "ABC123", checksum, &out, &out_size));
+	}
+
+	SECTION("round trip")
+	{
+		REQUIRE(u_device_config_cache_store("test", "ABC123", checksum, blob, blob_size));
+		REQUIRE(u_device_config_cache_load("test", "ABC123", checksum, &out, &out_size));
+		REQUIRE(out_size == blob_size);
+		CHECK(memcmp(out, blob, blob_size) == 0);
+		CHECK(out[out_size] == '\0');
+		free(out);
+	}
+
+	SECTION("no serial")
+	{
+		REQUIRE(u_device_config_cache_store("test", nullptr, checksum, blob, blob_size));
+		REQUIRE(u_device_config_cache_load("test", nullptr, checksum, &out, &out_size));
+		CHECK(out_size == blob_size);
+		free(out);
+	}
+
+	SECTION("mismatch")
+	{
+		REQUIRE(u_device_config_cache_store("test", "ABC123", checksum, blob, blob_size));
+
+		// Stale checksum.
+		CHECK_FALSE(u_device_config_cache_load("test", "ABC123", checksum + 1, &out, &out_size));
+
+		// Other device, other entry.
+		CHECK_FALSE(u_device_config_cache_load("test", "XYZ789", checksum, &out, &out_size));
+
+		// A new checksum replaces the old entry.
+		REQUIRE(u_device_config_cache_store("test", "ABC123", checksum + 1, blob, blob_size));
+		CHECK_FALSE(u_device_config_cache_load("test", "ABC123", checksum, &out, &out_size));
+	}
+
+	SECTION("corrupt data")
+	{
+		REQUIRE(u_device_config_cache_store("test", "ABC123", checksum, blob, blob_size));
+
+		std::string path = std::string(dir) + "/monado/device-config-test-ABC123";
+		FILE *file = fopen(path.c_str(), "r+b");
+		REQUIRE(file != nullptr);
+		REQUIRE(fseek(file, -1, SEEK_END) == 0);
+		REQUIRE(fputc('x', file) != EOF);
+		REQUIRE(fclose(file) == 0);
+
+		CHECK_FALSE(u_device_config_cache_load("test", "ABC123", checksum, &out, &out_size));
+	}
+
+	std::string cmd = std::string("rm -rf ") + dir;
+	CHECK(system(cmd.c_str()) == 0);
+}
+
+#endif
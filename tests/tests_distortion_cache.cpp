@@ -0,0 +1,71 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Distortion cache tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include "xrt/xrt_config_os.h"
+
+#include <util/u_distortion_cache.h>
+
+#include "catch/catch.hpp"
+
+#include <array>
+#include <string>
+#include <stdlib.h>
+#include <unistd.h>
+
+
+#ifdef XRT_OS_LINUX
+
+TEST_CASE("u_distortion_cache")
+{
+	char dir[] = "/tmp/monado-distortion-cache-XXXXXX";
+	REQUIRE(mkdtemp(dir) != nullptr);
+	setenv("XDG_CACHE_HOME", dir, 1);
+
+	REQUIRE(u_distortion_cache_enabled());
+
+	std::array<float, 64> data{};
+	for (size_t i = 0; i < data.size(); i++) {
+		data[i] = (float)i * 0.5f;
+	}
+
+	uint64_t key = u_distortion_cache_hash_bytes(U_DISTORTION_CACHE_HASH_INIT, "test", 4);
+	REQUIRE(key != U_DISTORTION_CACHE_HASH_INIT);
+
+	SECTION("missing entry")
+	{
+		std::array<float, 64> out{};
+		CHECK_FALSE(u_distortion_cache_load("test", key, out.data(), sizeof(out)));
+	}
+
+	SECTION("round trip")
+	{
+		REQUIRE(u_distortion_cache_store("test", key, data.data(), sizeof(data)));
+
+		std::array<float, 64> out{};
+		REQUIRE(u_distortion_cache_load("test", key, out.data(), sizeof(out)));
+		CHECK(out == data);
+	}
+
+	SECTION("mismatch")
+	{
+		REQUIRE(u_distortion_cache_store("test", key, data.data(), sizeof(data)));
+
+		// Different key, different file.
+		std::array<float, 64> out{};
+		CHECK_FALSE(u_distortion_cache_load("test", key + 1, out.data(), sizeof(out)));
+
+		// Same key but the size doesn't match.
+		std::array<float, 32> small{};
+		CHECK_FALSE(u_distortion_cache_load("test", key, small.data(), sizeof(small)));
+	}
+
+	std::string cmd = std::string("rm -rf ") + dir;
+	CHECK(system(cmd.c_str()) == 0);
+}
+
+#endif
@@ -0,0 +1,101 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Filter fifo tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <math/m_filter_fifo.h>
+
+#include "catch/catch.hpp"
+
+#include <vector>
+
+
+//! Straight loop over all samples, what the filter used to do.
+static size_t
+reference_filter(FilterFifo3F &ff, size_t num, uint64_t start_ns, uint64_t stop_ns, xrt_vec3 *out_average)
+{
+	double x = 0, y = 0, z = 0;
+	size_t count = 0;
+
+	for (size_t i = 0; i < num; i++) {
+		xrt_vec3 sample = {};
+		uint64_t ts = 0;
+		REQUIRE(ff.get(i, &sample, &ts));
+		if (ts < start_ns || ts > stop_ns) {
+			continue;
+		}
+		x += sample.x;
+		y += sample.y;
+		z += sample.z;
+		count++;
+	}
+
+	*out_average = {};
+	if (count > 0) {
+		out_average->x = (float)(x / count);
+		out_average->y = (float)(y / count);
+		out_average->z = (float)(z / count);
+	}
+
+	return count;
+}
+
+
+TEST_CASE("m_filter_fifo")
+{
+	constexpr size_t num = 100;
+	FilterFifo3F ff(num);
+	xrt_vec3 avg = {};
+
+	SECTION("filled with zeros")
+	{
+		xrt_vec3 sample = {1, 1, 1};
+		uint64_t ts = 1;
+		CHECK(ff.get(num - 1, &sample, &ts));
+		CHECK(sample.x == 0.0f);
+		CHECK(ts == 0);
+		CHECK_FALSE(ff.get(num, &sample, &ts));
+
+		CHECK(ff.filter(0, 0, &avg) == num);
+		CHECK(ff.filter(1, 1000, &avg) == 0);
+		CHECK(avg.x == 0.0f);
+	}
+
+	SECTION("matches reference")
+	{
+		// Wrap around the ring a few times, with some duplicate timestamps.
+		std::vector<xrt_vec3> samples;
+		std::vector<uint64_t> timestamps;
+		for (uint64_t i = 1; i <= 1000; i++) {
+			samples.push_back({(float)i, (float)(i % 7), -(float)i});
+			timestamps.push_back(i * 10 - (i % 3 == 0 ? 10 : 0));
+		}
+
+		ff.push_many(samples.data(), timestamps.data(), 500);
+		for (size_t i = 500; i < samples.size(); i++) {
+			ff.push(samples[i], timestamps[i]);
+		}
+
+		xrt_vec3 sample = {};
+		uint64_t ts = 0;
+		CHECK(ff.get(0, &sample, &ts));
+		CHECK(sample.x == 1000.0f);
+		CHECK(ts == timestamps.back());
+
+		const uint64_t windows[][2] = {
+		    {0, UINT64_MAX}, {9000, 9500}, {9005, 9005}, {9990, 9990}, {0, 9000}, {20000, 30000}, {9500, 9000},
+		};
+
+		for (const auto &w : windows) {
+			xrt_vec3 ref = {};
+			size_t ref_count = reference_filter(ff, num, w[0], w[1], &ref);
+			CHECK(ff.filter(w[0], w[1], &avg) == ref_count);
+			CHECK(avg.x == Approx(ref.x));
+			CHECK(avg.y == Approx(ref.y));
+			CHECK(avg.z == Approx(ref.z));
+		}
+	}
+}
@@ -0,0 +1,138 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Pixel format row conversion tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_format_rows.h>
+
+#include "catch/catch.hpp"
+
+#include <random>
+#include <vector>
+
+
+static void
+check_same(u_format_row_func_t func, u_format_row_func_t ref, size_t src_bpp, size_t dst_bpp)
+{
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int> dist(0, 255);
+
+	// Cover widths with and without a tail for the SIMD code.
+	for (uint32_t width = 2; width <= 100; width += 2) {
+		std::vector<uint8_t> src(width * src_bpp);
+		for (uint8_t &v : src) {
+			v = (uint8_t)dist(rng);
+		}
+
+		// One extra byte to catch writes past the end.
+		std::vector<uint8_t> dst(width * dst_bpp + 1, 0xab);
+		std::vector<uint8_t> expected(width * dst_bpp + 1, 0xab);
+
+		func(dst.data(), src.data(), width);
+		ref(expected.data(), src.data(), width);
+
+		INFO("width " << width);
+		CHECK(dst == expected);
+	}
+}
+
+static void
+check_same_bayer(u_format_bayer_row_func_t func, u_format_bayer_row_func_t ref, size_t dst_bpp)
+{
+	std::mt19937 rng(4321);
+	std::uniform_int_distribution<int> dist(0, 255);
+
+	for (uint32_t width = 1; width <= 50; width++) {
+		std::vector<uint8_t> src0(width * 2);
+		std::vector<uint8_t> src1(width * 2);
+		for (uint8_t &v : src0) {
+			v = (uint8_t)dist(rng);
+		}
+		for (uint8_t &v : src1) {
+			v = (uint8_t)dist(rng);
+		}
+
+		std::vector<uint8_t> dst(width * dst_bpp + 1, 0xab);
+		std::vector<uint8_t> expected(width * dst_bpp + 1, 0xab);
+
+		func(dst.data(), src0.data(), src1.data(), width);
+		ref(expected.data(), src0.data(), src1.data(), width);
+
+		INFO("width " << width);
+		CHECK(dst == expected);
+	}
+}
+
+TEST_CASE("u_format_rows")
+{
+	const struct u_format_row_funcs *funcs = u_format_row_funcs_get();
+	const struct u_format_row_funcs *scalar = u_format_row_funcs_get_scalar();
+	INFO("Using " << funcs->name);
+
+	SECTION("known values")
+	{
+		// Black, white and mid grey, with no chroma.
+		const uint8_t src[] = {16, 128, 235, 128, 126, 128, 126, 128};
+		uint8_t dst[4 * 3] = {};
+
+		scalar->YUYV422_to_R8G8B8(dst, src, 4);
+		CHECK(dst[0] == 0);
+		CHECK(dst[3] == 255);
+		CHECK(dst[4] == 255);
+		CHECK(dst[5] == 255);
+		CHECK(dst[6] == 128);
+		CHECK(dst[7] == 128);
+		CHECK(dst[8] == 128);
+	}
+
+	SECTION("bayer known values")
+	{
+		// G R G R
+		// B G B G
+		const uint8_t src0[] = {100, 255, 255, 255};
+		const uint8_t src1[] = {0, 50, 255, 255};
+		uint8_t rgb[2 * 3] = {};
+		uint8_t l8[2] = {};
+
+		scalar->BAYER_GR8_to_R8G8B8(rgb, src0, src1, 2);
+		CHECK(rgb[0] == 255);
+		CHECK(rgb[1] == 75);
+		CHECK(rgb[2] == 0);
+		CHECK(rgb[3] == 255);
+		CHECK(rgb[4] == 255);
+		CHECK(rgb[5] == 255);
+
+		scalar->BAYER_GR8_to_L8(l8, src0, src1, 2);
+		CHECK(l8[0] == 121);
+		CHECK(l8[1] == 255);
+	}
+
+	SECTION("interleaved known values")
+	{
+		const uint8_t src[] = {1, 2, 3, 4, 5, 6};
+		uint8_t dst[6] = {};
+
+		scalar->L8_INTERLEAVED_to_L8_SBS(dst, src, 6);
+		CHECK(dst[0] == 1);
+		CHECK(dst[1] == 3);
+		CHECK(dst[2] == 5);
+		CHECK(dst[3] == 2);
+		CHECK(dst[4] == 4);
+		CHECK(dst[5] == 6);
+	}
+
+	SECTION("same as scalar")
+	{
+		check_same(funcs->L8_to_R8G8B8, scalar->L8_to_R8G8B8, 1, 3);
+		check_same(funcs->YUYV422_to_L8, scalar->YUYV422_to_L8, 2, 1);
+		check_same(funcs->YUYV422_to_R8G8B8, scalar->YUYV422_to_R8G8B8, 2, 3);
+		check_same(funcs->UYVY422_to_R8G8B8, scalar->UYVY422_to_R8G8B8, 2, 3);
+		check_same(funcs->YUV888_to_R8G8B8, scalar->YUV888_to_R8G8B8, 3, 3);
+		check_same(funcs->L8_INTERLEAVED_to_L8_SBS, scalar->L8_INTERLEAVED_to_L8_SBS, 1, 1);
+		check_same_bayer(funcs->BAYER_GR8_to_R8G8B8, scalar->BAYER_GR8_to_R8G8B8, 3);
+		check_same_bayer(funcs->BAYER_GR8_to_L8, scalar->BAYER_GR8_to_L8, 1);
+	}
+}
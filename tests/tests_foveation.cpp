@@ -0,0 +1,87 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Foveation helper tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_foveation.h>
+
+#include "catch/catch.hpp"
+
+#include <vector>
+
+
+TEST_CASE("u_foveation_density")
+{
+	struct xrt_foveation_params params;
+	u_foveation_params_from_level(U_FOVEATION_LEVEL_HIGH, &params);
+
+	SECTION("full density at the center")
+	{
+		CHECK(u_foveation_density(&params, 0, 1.0f, 0.5f, 0.5f) == 1.0f);
+	}
+
+	SECTION("outer density in the corner")
+	{
+		CHECK(u_foveation_density(&params, 0, 1.0f, 0.0f, 0.0f) == params.outer_density);
+	}
+
+	SECTION("falls off between the radii")
+	{
+		float mid = 0.5f + (params.inner_radius + params.outer_radius) / 2.0f;
+		float density = u_foveation_density(&params, 0, 1.0f, 0.5f, mid);
+		CHECK(density < 1.0f);
+		CHECK(density > params.outer_density);
+	}
+
+	SECTION("follows the center of the view")
+	{
+		params.centers[1].x = 0.05f;
+		params.centers[1].y = 0.95f;
+		CHECK(u_foveation_density(&params, 1, 1.0f, 0.05f, 0.95f) == 1.0f);
+		CHECK(u_foveation_density(&params, 0, 1.0f, 0.05f, 0.95f) == params.outer_density);
+	}
+
+	SECTION("aspect stretches the horizontal distance")
+	{
+		float u = 0.5f + params.inner_radius * 0.75f;
+		CHECK(u_foveation_density(&params, 0, 1.0f, u, 0.5f) == 1.0f);
+		CHECK(u_foveation_density(&params, 0, 2.0f, u, 0.5f) < 1.0f);
+	}
+}
+
+TEST_CASE("u_foveation_levels")
+{
+	struct xrt_foveation_params none, low, high;
+	u_foveation_params_from_level(U_FOVEATION_LEVEL_NONE, &none);
+	u_foveation_params_from_level(U_FOVEATION_LEVEL_LOW, &low);
+	u_foveation_params_from_level(U_FOVEATION_LEVEL_HIGH, &high);
+
+	CHECK(u_foveation_density(&none, 0, 1.0f, 0.0f, 0.0f) == 1.0f);
+	CHECK(low.inner_radius > high.inner_radius);
+	CHECK(low.outer_density >= high.outer_density);
+}
+
+TEST_CASE("u_foveation_fill_r8g8")
+{
+	struct xrt_foveation_params params;
+	u_foveation_params_from_level(U_FOVEATION_LEVEL_HIGH, &params);
+
+	const uint32_t width = 8;
+	const uint32_t height = 4;
+	std::vector<uint8_t> texels(width * height * 2, 0);
+	u_foveation_fill_r8g8(&params, 0, width, height, texels.data());
+
+	auto at = [&](uint32_t x, uint32_t y, uint32_t c) { return texels[(y * width + x) * 2 + c]; };
+
+	// Center is at full density on both axes.
+	CHECK(at(4, 2, 0) == 255);
+	CHECK(at(4, 2, 1) == 255);
+
+	// Corners are at the outer density.
+	uint8_t outer = (uint8_t)(params.outer_density * 255.0f + 0.5f);
+	CHECK(at(0, 0, 0) == outer);
+	CHECK(at(width - 1, height - 1, 1) == outer);
+}
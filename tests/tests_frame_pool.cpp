@@ -0,0 +1,132 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Frame pool tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_frame.h>
+
+#include "catch/catch.hpp"
+
+
+TEST_CASE("u_frame_pool")
+{
+	struct u_frame_pool *ufp = u_frame_pool_create(2);
+	REQUIRE(ufp != NULL);
+
+	struct xrt_frame *xf = NULL;
+
+	SECTION("released frames are reused")
+	{
+		u_frame_pool_create_frame(ufp, XRT_FORMAT_L8, 64, 32, &xf);
+		REQUIRE(xf != NULL);
+		CHECK(xf->reference.count == 1);
+		CHECK(xf->stride == 64);
+		CHECK(xf->size == 64 * 32);
+
+		struct xrt_frame *first = xf;
+		uint8_t *data = xf->data;
+		xf->timestamp = 1234;
+		xrt_frame_reference(&xf, NULL);
+
+		u_frame_pool_create_frame(ufp, XRT_FORMAT_L8, 64, 32, &xf);
+		CHECK(xf == first);
+		CHECK(xf->data == data);
+		CHECK(xf->timestamp == 0);
+		xrt_frame_reference(&xf, NULL);
+	}
+
+	SECTION("different size gets a new frame")
+	{
+		struct xrt_frame *other = NULL;
+		u_frame_pool_create_frame(ufp, XRT_FORMAT_L8, 64, 32, &xf);
+		u_frame_pool_create_frame(ufp, XRT_FORMAT_R8G8B8, 64, 32, &other);
+		CHECK(other != xf);
+		CHECK(other->format == XRT_FORMAT_R8G8B8);
+		CHECK(other->size == 64 * 32 * 3);
+
+		xrt_frame_reference(&xf, NULL);
+		xrt_frame_reference(&other, NULL);
+
+		// Pool is full of these two, a third size evicts one.
+		u_frame_pool_create_frame(ufp, XRT_FORMAT_L8, 16, 16, &xf);
+		CHECK(xf->width == 16);
+		xrt_frame_reference(&xf, NULL);
+	}
+
+	SECTION("frames outlive the pool")
+	{
+		u_frame_pool_create_frame(ufp, XRT_FORMAT_L8, 64, 32, &xf);
+		u_frame_pool_destroy(&ufp);
+		CHECK(ufp == NULL);
+
+		xf->data[0] = 42;
+		xrt_frame_reference(&xf, NULL);
+	}
+
+	SECTION("no pool")
+	{
+		u_frame_pool_create_frame(NULL, XRT_FORMAT_L8, 64, 32, &xf);
+		REQUIRE(xf != NULL);
+		xrt_frame_reference(&xf, NULL);
+	}
+
+	u_frame_pool_destroy(&ufp);
+}
+
+TEST_CASE("u_frame_pool_flags")
+{
+	struct xrt_frame *xf = NULL;
+
+	SECTION("buffers are aligned")
+	{
+		struct u_frame_pool *ufp = u_frame_pool_create(2);
+		u_frame_pool_create_frame(ufp, XRT_FORMAT_L8, 30, 7, &xf);
+		REQUIRE(xf != NULL);
+		CHECK(xf->stride == 30);
+		CHECK(((uintptr_t)xf->data % U_FRAME_POOL_ALIGNMENT) == 0);
+
+		xrt_frame_reference(&xf, NULL);
+		u_frame_pool_destroy(&ufp);
+	}
+
+	SECTION("aligned rows")
+	{
+		struct u_frame_pool *ufp = u_frame_pool_create_with_flags(2, U_FRAME_POOL_ALIGN_ROWS);
+		u_frame_pool_create_frame(ufp, XRT_FORMAT_R8G8B8, 30, 7, &xf);
+		REQUIRE(xf != NULL);
+		CHECK(xf->stride == 128);
+		CHECK(xf->size == 128 * 7);
+		CHECK(((uintptr_t)xf->data % U_FRAME_POOL_ALIGNMENT) == 0);
+
+		// Every byte is ours.
+		xf->data[xf->size - 1] = 42;
+
+		xrt_frame_reference(&xf, NULL);
+		u_frame_pool_destroy(&ufp);
+	}
+
+	SECTION("huge pages and locked fall back")
+	{
+		enum u_frame_pool_flags flags = (enum u_frame_pool_flags)(U_FRAME_POOL_HUGE_PAGES | U_FRAME_POOL_LOCKED);
+		struct u_frame_pool *ufp = u_frame_pool_create_with_flags(2, flags);
+		u_frame_pool_create_frame(ufp, XRT_FORMAT_L8, 640, 480, &xf);
+		REQUIRE(xf != NULL);
+		REQUIRE(xf->data != NULL);
+		CHECK(((uintptr_t)xf->data % U_FRAME_POOL_ALIGNMENT) == 0);
+
+		xf->data[0] = 1;
+		xf->data[xf->size - 1] = 2;
+
+		// Reused frames keep their buffer.
+		uint8_t *data = xf->data;
+		xrt_frame_reference(&xf, NULL);
+		u_frame_pool_create_frame(ufp, XRT_FORMAT_L8, 640, 480, &xf);
+		CHECK(xf->data == data);
+
+		xrt_frame_reference(&xf, NULL);
+		u_frame_pool_destroy(&ufp);
+	}
+}
@@ -0,0 +1,92 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Test the sequential Kalman correction against the batch one.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include "catch/catch.hpp"
+
+#include "tracking/t_fusion_sequential.hpp"
+
+#include "flexkalman/AbsoluteOrientationMeasurement.h"
+#include "flexkalman/AbsolutePositionMeasurement.h"
+#include "flexkalman/FlexibleKalmanCorrect.h"
+#include "flexkalman/FlexibleKalmanFilter.h"
+#include "flexkalman/PoseSeparatelyDampedConstantVelocity.h"
+#include "flexkalman/PoseState.h"
+
+#include <limits>
+
+using xrt::auxiliary::tracking::correctSequential;
+
+using State = flexkalman::pose_externalized_rotation::State;
+using ProcessModel = flexkalman::PoseSeparatelyDampedConstantVelocityProcessModel<State>;
+
+//! A state that has been predicted forward a bit so it has a non-trivial covariance.
+static State
+make_state()
+{
+	State state;
+	ProcessModel process_model;
+
+	flexkalman::types::Vector<12> x;
+	x << 0.1, -0.2, 0.3, 0.01, 0.02, -0.03, 0.5, -0.4, 0.3, 0.2, -0.1, 0.05;
+	state.setStateVector(x);
+
+	for (int i = 0; i < 5; i++) {
+		flexkalman::predict(state, process_model, 0.01);
+	}
+
+	return state;
+}
+
+template <typename Measurement>
+static void
+check_same_as_extended(Measurement meas)
+{
+	State extended = make_state();
+	State sequential = make_state();
+	ProcessModel process_model;
+
+	Measurement meas_copy = meas;
+	REQUIRE(flexkalman::correctExtended(extended, process_model, meas));
+	REQUIRE(correctSequential(sequential, meas_copy));
+
+	CHECK(sequential.stateVector().isApprox(extended.stateVector(), 1e-9));
+	CHECK(sequential.errorCovariance().isApprox(extended.errorCovariance(), 1e-9));
+	CHECK(sequential.getQuaternion().isApprox(extended.getQuaternion(), 1e-9));
+}
+
+TEST_CASE("correctSequential")
+{
+	SECTION("Position measurement")
+	{
+		Eigen::Vector3d position(0.2, -0.1, 0.4);
+		Eigen::Vector3d variance(1.e-4, 2.e-4, 4.e-4);
+		flexkalman::AbsolutePositionEKFMeasurement<State> meas{position, variance};
+		check_same_as_extended(meas);
+	}
+
+	SECTION("Orientation measurement")
+	{
+		Eigen::Quaterniond quat(Eigen::AngleAxisd(0.3, Eigen::Vector3d(1, 2, 3).normalized()));
+		flexkalman::AbsoluteOrientationEKFMeasurement<State> meas{quat, Eigen::Vector3d::Constant(0.01)};
+		check_same_as_extended(meas);
+	}
+
+	SECTION("Non-finite measurement leaves the state untouched")
+	{
+		State state = make_state();
+		State before = state;
+
+		double nan = std::numeric_limits<double>::quiet_NaN();
+		Eigen::Vector3d position(nan, 0.0, 0.0);
+		flexkalman::AbsolutePositionEKFMeasurement<State> meas{position, Eigen::Vector3d::Constant(1.e-4)};
+
+		CHECK_FALSE(correctSequential(state, meas));
+		CHECK(state.stateVector() == before.stateVector());
+		CHECK(state.errorCovariance() == before.errorCovariance());
+	}
+}
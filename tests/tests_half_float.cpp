@@ -0,0 +1,103 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Half float conversion tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <math/m_half.h>
+#include <util/u_distortion_mesh.h>
+
+#include "catch/catch.hpp"
+
+#include <cmath>
+#include <limits>
+
+
+static float
+round_trip(float f)
+{
+	return m_half_to_float(m_float_to_half(f));
+}
+
+TEST_CASE("m_half")
+{
+	SECTION("exact values")
+	{
+		CHECK(round_trip(0.0f) == 0.0f);
+		CHECK(round_trip(1.0f) == 1.0f);
+		CHECK(round_trip(-2.0f) == -2.0f);
+		CHECK(round_trip(0.5f) == 0.5f);
+		CHECK(round_trip(65504.0f) == 65504.0f);
+
+		// Smallest subnormal.
+		CHECK(round_trip(std::ldexp(1.0f, -24)) == std::ldexp(1.0f, -24));
+	}
+
+	SECTION("rounding")
+	{
+		// Halfway between 1 and the next half, ties to even.
+		CHECK(round_trip(1.0f + std::ldexp(1.0f, -11)) == 1.0f);
+		CHECK(round_trip(1.0f + 3.0f * std::ldexp(1.0f, -11)) == 1.0f + std::ldexp(1.0f, -9));
+
+		// Rounds up into the next exponent.
+		CHECK(round_trip(2.0f - std::ldexp(1.0f, -12)) == 2.0f);
+	}
+
+	SECTION("special values")
+	{
+		CHECK(std::isinf(round_trip(std::numeric_limits<float>::infinity())));
+		CHECK(std::isinf(round_trip(100000.0f)));
+		CHECK(std::isnan(round_trip(std::numeric_limits<float>::quiet_NaN())));
+		CHECK(round_trip(std::ldexp(1.0f, -30)) == 0.0f);
+	}
+}
+
+TEST_CASE("m_half_distortion")
+{
+	// Roughly a first generation headset, large chromatic aberration.
+	struct u_panotools_values values = {};
+	values.distortion_k[0] = 1.0f;
+	values.distortion_k[1] = 0.22f;
+	values.distortion_k[2] = 0.24f;
+	values.aberration_k[0] = 0.985f;
+	values.aberration_k[1] = 1.0f;
+	values.aberration_k[2] = 1.015f;
+	values.scale = 0.04f;
+	values.viewport_size = {0.0635f, 0.0705f};
+	values.lens_center = {0.0635f / 2.0f, 0.0705f / 2.0f};
+
+	// Same size as the compositor distortion images.
+	const int dim = 128;
+	float max_error = 0.0f;
+	int in_range = 0;
+
+	for (int row = 0; row < dim; row++) {
+		for (int col = 0; col < dim; col++) {
+			float u = col / float(dim - 1);
+			float v = row / float(dim - 1);
+
+			struct xrt_uv_triplet result;
+			u_compute_distortion_panotools(&values, u, v, &result);
+
+			const struct xrt_vec2 uvs[3] = {result.r, result.g, result.b};
+			for (const struct xrt_vec2 &uv : uvs) {
+				// Outside of the image samples the border, can't be seen.
+				if (uv.x < 0.0f || uv.x > 1.0f || uv.y < 0.0f || uv.y > 1.0f) {
+					continue;
+				}
+
+				in_range++;
+				max_error = std::fmax(max_error, std::fabs(round_trip(uv.x) - uv.x));
+				max_error = std::fmax(max_error, std::fabs(round_trip(uv.y) - uv.y));
+			}
+		}
+	}
+
+	REQUIRE(in_range > dim * dim);
+	CHECK(max_error <= std::ldexp(1.0f, -12));
+
+	// Sampling is linear, so at most half a pixel off on a 2048 wide view.
+	CHECK(max_error * 2048.0f <= 0.5f);
+}
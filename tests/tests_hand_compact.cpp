@@ -0,0 +1,130 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Compact hand joint set encoding tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <math/m_api.h>
+#include <math/m_hand_compact.h>
+
+#include "catch/catch.hpp"
+
+#include <cmath>
+
+
+static constexpr enum xrt_space_relation_flags kFlags = (enum xrt_space_relation_flags)(
+    XRT_SPACE_RELATION_ORIENTATION_VALID_BIT | XRT_SPACE_RELATION_POSITION_VALID_BIT |
+    XRT_SPACE_RELATION_ORIENTATION_TRACKED_BIT | XRT_SPACE_RELATION_POSITION_TRACKED_BIT);
+
+static void
+make_hand(struct xrt_hand_joint_set *set)
+{
+	*set = {};
+	set->is_active = true;
+	set->hand_pose.relation_flags = kFlags;
+	set->hand_pose.pose.orientation.w = 1.0f;
+
+	for (uint32_t i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+		struct xrt_hand_joint_value *v = &set->values.hand_joint_set_default[i];
+
+		// Somewhere in front of the user, joints spread out around the wrist.
+		v->relation.relation_flags = kFlags;
+		v->relation.pose.position = {0.2f + 0.004f * i, 1.3f - 0.003f * i, -0.4f + 0.005f * i};
+		v->relation.pose.orientation = {0.1f * i, -0.05f * i, 0.3f, 1.0f - 0.02f * i};
+		math_quat_normalize(&v->relation.pose.orientation);
+		v->radius = 0.005f + 0.0005f * i;
+	}
+}
+
+static float
+quat_angle(const struct xrt_quat &a, const struct xrt_quat &b)
+{
+	float dot = std::fabs(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+	return 2.0f * std::acos(std::fmin(dot, 1.0f));
+}
+
+TEST_CASE("m_hand_compact")
+{
+	struct xrt_hand_joint_set set;
+	make_hand(&set);
+
+	struct m_hand_joint_set_compact compact;
+
+	SECTION("smaller")
+	{
+		CHECK(sizeof(compact) * 3 < sizeof(set));
+	}
+
+	SECTION("round trip")
+	{
+		REQUIRE(m_hand_joint_set_compact_encode(&set, &compact));
+
+		struct xrt_hand_joint_set out;
+		m_hand_joint_set_compact_decode(&compact, &out);
+
+		CHECK(out.is_active);
+		CHECK(out.hand_pose.relation_flags == set.hand_pose.relation_flags);
+
+		const struct xrt_hand_joint_value *in_values = set.values.hand_joint_set_default;
+		const struct xrt_hand_joint_value *out_values = out.values.hand_joint_set_default;
+
+		for (uint32_t i = 0; i < XRT_HAND_JOINT_COUNT; i++) {
+			const struct xrt_pose &a = in_values[i].relation.pose;
+			const struct xrt_pose &b = out_values[i].relation.pose;
+
+			CHECK(out_values[i].relation.relation_flags == kFlags);
+			CHECK(b.position.x == Approx(a.position.x).margin(0.0002));
+			CHECK(b.position.y == Approx(a.position.y).margin(0.0002));
+			CHECK(b.position.z == Approx(a.position.z).margin(0.0002));
+			CHECK(out_values[i].radius == Approx(in_values[i].radius).margin(0.00001));
+
+			// Well below what anybody could see on a hand.
+			CHECK(quat_angle(a.orientation, b.orientation) < 0.001f);
+		}
+
+		// The wrist is exact.
+		const struct xrt_pose &wa = in_values[XRT_HAND_JOINT_WRIST].relation.pose;
+		const struct xrt_pose &wb = out_values[XRT_HAND_JOINT_WRIST].relation.pose;
+		CHECK(wb.position.x == wa.position.x);
+		CHECK(wb.orientation.w == wa.orientation.w);
+	}
+
+	SECTION("negative largest component")
+	{
+		struct xrt_quat &q = set.values.hand_joint_set_default[3].relation.pose.orientation;
+		q = {0.1f, 0.2f, -0.9f, 0.1f};
+		math_quat_normalize(&q);
+
+		REQUIRE(m_hand_joint_set_compact_encode(&set, &compact));
+
+		struct xrt_hand_joint_set out;
+		m_hand_joint_set_compact_decode(&compact, &out);
+
+		CHECK(quat_angle(q, out.values.hand_joint_set_default[3].relation.pose.orientation) < 0.001f);
+	}
+
+	SECTION("not active")
+	{
+		set.is_active = false;
+		REQUIRE(m_hand_joint_set_compact_encode(&set, &compact));
+
+		struct xrt_hand_joint_set out;
+		m_hand_joint_set_compact_decode(&compact, &out);
+		CHECK_FALSE(out.is_active);
+	}
+
+	SECTION("velocities can't be encoded")
+	{
+		set.values.hand_joint_set_default[5].relation.relation_flags = (enum xrt_space_relation_flags)(
+		    kFlags | XRT_SPACE_RELATION_LINEAR_VELOCITY_VALID_BIT);
+		CHECK_FALSE(m_hand_joint_set_compact_encode(&set, &compact));
+	}
+
+	SECTION("different flags can't be encoded")
+	{
+		set.values.hand_joint_set_default[7].relation.relation_flags = XRT_SPACE_RELATION_ORIENTATION_VALID_BIT;
+		CHECK_FALSE(m_hand_joint_set_compact_encode(&set, &compact));
+	}
+}
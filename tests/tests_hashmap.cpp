@@ -0,0 +1,160 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Hashmap and hashset tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_hashmap.h>
+#include <util/u_hashset.h>
+
+#include "catch/catch.hpp"
+
+#include <map>
+#include <random>
+#include <string>
+
+
+static void
+count_cb(uint64_t key, const void *value, void *priv)
+{
+	(*(uint32_t *)priv)++;
+}
+
+static void
+free_item(struct u_hashset_item *item, void *priv)
+{
+	(*(uint32_t *)priv)++;
+	free(item);
+}
+
+TEST_CASE("u_hashmap_int")
+{
+	struct u_hashmap_int *hmi = NULL;
+	REQUIRE(u_hashmap_int_create(&hmi) == 0);
+
+	void *item = NULL;
+	CHECK(u_hashmap_int_empty(hmi));
+	CHECK(u_hashmap_int_find(hmi, 0, &item) == -1);
+	CHECK(u_hashmap_int_erase(hmi, 0) == 0);
+
+	SECTION("insert replaces")
+	{
+		int a = 0, b = 0;
+		u_hashmap_int_insert(hmi, 42, &a);
+		u_hashmap_int_insert(hmi, 42, &b);
+		CHECK(u_hashmap_int_find(hmi, 42, &item) == 0);
+		CHECK(item == &b);
+
+		u_hashmap_int_erase(hmi, 42);
+		CHECK(u_hashmap_int_empty(hmi));
+	}
+
+	SECTION("matches std::map")
+	{
+		// Few keys so there are lots of collisions, erases and reinserts.
+		std::mt19937_64 rng(1234);
+		std::map<uint64_t, void *> reference;
+
+		for (uint32_t i = 0; i < 100000; i++) {
+			uint64_t key = rng() % 512;
+			void *value = (void *)(uintptr_t)(i + 1);
+
+			if (rng() % 3 == 0) {
+				u_hashmap_int_erase(hmi, key);
+				reference.erase(key);
+			} else {
+				u_hashmap_int_insert(hmi, key, value);
+				reference[key] = value;
+			}
+		}
+
+		uint32_t bad = 0;
+		for (uint64_t key = 0; key < 512; key++) {
+			auto search = reference.find(key);
+			int ret = u_hashmap_int_find(hmi, key, &item);
+			if (search == reference.end() ? ret != -1 : (ret != 0 || item != search->second)) {
+				bad++;
+			}
+		}
+		CHECK(bad == 0);
+
+		uint32_t count = 0;
+		u_hashmap_int_for_each(hmi, count_cb, &count);
+		CHECK(count == reference.size());
+	}
+
+	u_hashmap_int_destroy(&hmi);
+	CHECK(hmi == NULL);
+}
+
+TEST_CASE("u_hashset")
+{
+	struct u_hashset *hs = NULL;
+	REQUIRE(u_hashset_create(&hs) == 0);
+
+	struct u_hashset_item *item = NULL;
+	CHECK(u_hashset_find_c_str(hs, "/user/hand/left", &item) == -1);
+
+	SECTION("basics")
+	{
+		struct u_hashset_item *left = NULL;
+		CHECK(u_hashset_create_and_insert_str_c(hs, "/user/hand/left", &left) == 0);
+		CHECK(u_hashset_create_and_insert_str_c(hs, "/user/hand/left", &item) == -1);
+
+		// Not null terminated lookups.
+		const char str[] = "/user/hand/left/input";
+		CHECK(u_hashset_find_str(hs, str, 15, &item) == 0);
+		CHECK(item == left);
+		CHECK(u_hashset_find_str(hs, str, 14, &item) == -1);
+
+		// Erasing by a different item with the same string.
+		struct u_hashset_item *other = NULL;
+		u_hashset_create_and_insert_str_c(hs, "/user/hand/right", &other);
+		u_hashset_erase_c_str(hs, "/user/hand/left");
+		CHECK(u_hashset_find_c_str(hs, "/user/hand/left", &item) == -1);
+		CHECK(u_hashset_find_c_str(hs, "/user/hand/right", &item) == 0);
+		free(left);
+	}
+
+	SECTION("matches std::map")
+	{
+		std::mt19937 rng(4321);
+		std::map<std::string, struct u_hashset_item *> reference;
+
+		for (uint32_t i = 0; i < 20000; i++) {
+			std::string str = "/user/hand/left/input/" + std::to_string(rng() % 300);
+
+			if (rng() % 3 == 0) {
+				auto search = reference.find(str);
+				if (search != reference.end()) {
+					u_hashset_erase_item(hs, search->second);
+					free(search->second);
+					reference.erase(search);
+				}
+			} else if (reference.count(str) == 0) {
+				CHECK(u_hashset_create_and_insert_str(hs, str.c_str(), str.size(), &item) == 0);
+				reference[str] = item;
+			}
+		}
+
+		uint32_t bad = 0;
+		for (uint32_t i = 0; i < 300; i++) {
+			std::string str = "/user/hand/left/input/" + std::to_string(i);
+			auto search = reference.find(str);
+			int ret = u_hashset_find_str(hs, str.c_str(), str.size(), &item);
+			if (search == reference.end() ? ret != -1 : (ret != 0 || item != search->second)) {
+				bad++;
+			}
+		}
+		CHECK(bad == 0);
+	}
+
+	uint32_t count = 0;
+	u_hashset_clear_and_call_for_each(hs, free_item, &count);
+	CHECK(u_hashset_find_c_str(hs, "/user/hand/right", &item) == -1);
+
+	u_hashset_destroy(&hs);
+	CHECK(hs == NULL);
+}
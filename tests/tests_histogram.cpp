@@ -0,0 +1,136 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Streaming histogram tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_histogram.h>
+
+#include "catch/catch.hpp"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+
+static bool
+within(uint64_t value, uint64_t expected)
+{
+	// Relative error of the buckets, plus one for rounding.
+	uint64_t error = expected / (1u << U_HIST_NS_SUB_BUCKET_BITS) + 1;
+	return value + error >= expected && value <= expected + error;
+}
+
+TEST_CASE("u_histogram")
+{
+	struct u_hist_ns *uhn = u_hist_ns_create();
+	std::unique_ptr<u_hist_ns_snapshot> snapshot(new u_hist_ns_snapshot());
+	struct u_hist_ns_stats stats = {};
+
+	SECTION("empty")
+	{
+		u_hist_ns_get_snapshot(uhn, snapshot.get());
+		u_hist_ns_snapshot_get_stats(snapshot.get(), &stats);
+		CHECK(stats.count == 0);
+		CHECK(stats.p50 == 0);
+		CHECK(stats.worst == 0);
+	}
+
+	SECTION("small values are exact")
+	{
+		for (uint64_t i = 100; i > 0; i--) {
+			u_hist_ns_add(uhn, i);
+		}
+
+		u_hist_ns_get_snapshot(uhn, snapshot.get());
+		u_hist_ns_snapshot_get_stats(snapshot.get(), &stats);
+		CHECK(stats.count == 100);
+		CHECK(stats.mean == 50);
+		CHECK(stats.p50 == 50);
+		CHECK(stats.p90 == 90);
+		CHECK(stats.p99 == 99);
+		CHECK(stats.worst == 100);
+		CHECK(u_hist_ns_snapshot_get_percentile(snapshot.get(), 0.0) == 1);
+	}
+
+	SECTION("big values are within the error")
+	{
+		// 1us to 100ms.
+		for (uint64_t i = 1; i <= 100000; i++) {
+			u_hist_ns_add(uhn, i * 1000);
+		}
+
+		u_hist_ns_get_snapshot(uhn, snapshot.get());
+		u_hist_ns_snapshot_get_stats(snapshot.get(), &stats);
+		CHECK(stats.count == 100000);
+		CHECK(within(stats.p50, 50000 * 1000));
+		CHECK(within(stats.p90, 90000 * 1000));
+		CHECK(within(stats.p99, 99000 * 1000));
+		CHECK(within(stats.p99_9, 99900 * 1000));
+		CHECK(stats.worst == 100000 * 1000);
+	}
+
+	SECTION("huge values are clamped")
+	{
+		u_hist_ns_add(uhn, UINT64_MAX);
+		u_hist_ns_get_snapshot(uhn, snapshot.get());
+		CHECK(u_hist_ns_snapshot_get_percentile(snapshot.get(), 50.0) > (1ull << U_HIST_NS_MAX_BIT));
+	}
+
+	SECTION("merge and subtract")
+	{
+		std::unique_ptr<u_hist_ns_snapshot> old(new u_hist_ns_snapshot());
+
+		for (uint64_t i = 0; i < 1000; i++) {
+			u_hist_ns_add(uhn, 1000000);
+		}
+		u_hist_ns_get_snapshot(uhn, old.get());
+
+		for (uint64_t i = 0; i < 1000; i++) {
+			u_hist_ns_add(uhn, 5000000);
+		}
+		u_hist_ns_get_snapshot(uhn, snapshot.get());
+
+		// Only the values added after the old snapshot.
+		u_hist_ns_snapshot_subtract(snapshot.get(), old.get());
+		u_hist_ns_snapshot_get_stats(snapshot.get(), &stats);
+		CHECK(stats.count == 1000);
+		CHECK(stats.mean == 5000000);
+		CHECK(within(stats.p50, 5000000));
+
+		// And back again.
+		u_hist_ns_snapshot_merge(snapshot.get(), old.get());
+		u_hist_ns_snapshot_get_stats(snapshot.get(), &stats);
+		CHECK(stats.count == 2000);
+		CHECK(stats.mean == 3000000);
+		CHECK(within(stats.p50, 1000000));
+		CHECK(within(stats.p99, 5000000));
+	}
+
+	SECTION("snapshot while adding")
+	{
+		std::atomic<bool> done{false};
+		std::thread producer([&] {
+			for (uint64_t i = 0; i < 200000; i++) {
+				u_hist_ns_add(uhn, i % 1000);
+			}
+			done = true;
+		});
+
+		uint64_t last_count = 0;
+		while (!done) {
+			u_hist_ns_get_snapshot(uhn, snapshot.get());
+			CHECK(snapshot->count >= last_count);
+			last_count = snapshot->count;
+		}
+		producer.join();
+
+		u_hist_ns_get_snapshot(uhn, snapshot.get());
+		CHECK(snapshot->count == 200000);
+	}
+
+	u_hist_ns_destroy(&uhn);
+	CHECK(uhn == NULL);
+}
@@ -0,0 +1,104 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief 3dof IMU fusion prediction tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <math/m_api.h>
+#include <math/m_imu_3dof.h>
+#include <math/m_vec3.h>
+#include <util/u_time.h>
+
+#include "catch/catch.hpp"
+
+#include <cmath>
+
+
+static constexpr float kEpsilon = 0.0001f;
+
+// Looking to the left, spinning around the body x axis (pitching up).
+static void
+setup_pitching(struct m_imu_3dof &f)
+{
+	m_imu_3dof_init(&f, M_IMU_3DOF_USE_GRAVITY_DUR_20MS);
+	f.state = M_IMU_3DOF_STATE_RUNNING;
+
+	struct xrt_vec3 up = {0, 1, 0};
+	math_quat_from_angle_vector((float)M_PI_2, &up, &f.rot);
+	f.last.gyro = {1, 0, 0};
+}
+
+TEST_CASE("m_imu_3dof_predict")
+{
+	struct m_imu_3dof f = {};
+	setup_pitching(f);
+
+	SECTION("angular velocity is in the world frame")
+	{
+		struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+		m_imu_3dof_predict(&f, 0, &rel);
+
+		// Body x points along world -z when looking to the left.
+		CHECK(rel.angular_velocity.x == Approx(0).margin(kEpsilon));
+		CHECK(rel.angular_velocity.y == Approx(0).margin(kEpsilon));
+		CHECK(rel.angular_velocity.z == Approx(-1).margin(kEpsilon));
+		CHECK((rel.relation_flags & XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT) != 0);
+	}
+
+	SECTION("matches integrating in the body frame")
+	{
+		struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+		m_imu_3dof_predict(&f, 50 * U_TIME_1MS_IN_NS, &rel);
+
+		struct xrt_quat delta;
+		struct xrt_vec3 axis = {1, 0, 0};
+		math_quat_from_angle_vector(0.05f, &axis, &delta);
+		struct xrt_quat expected;
+		math_quat_rotate(&f.rot, &delta, &expected);
+
+		CHECK(fabsf(rel.pose.orientation.x - expected.x) < kEpsilon);
+		CHECK(fabsf(rel.pose.orientation.y - expected.y) < kEpsilon);
+		CHECK(fabsf(rel.pose.orientation.z - expected.z) < kEpsilon);
+		CHECK(fabsf(rel.pose.orientation.w - expected.w) < kEpsilon);
+	}
+
+	SECTION("gyro bias is removed")
+	{
+		f.gyro_bias.value = f.last.gyro;
+
+		struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+		m_imu_3dof_predict(&f, 50 * U_TIME_1MS_IN_NS, &rel);
+
+		CHECK(m_vec3_len(rel.angular_velocity) < kEpsilon);
+		CHECK(fabsf(rel.pose.orientation.y - f.rot.y) < kEpsilon);
+		CHECK(fabsf(rel.pose.orientation.w - f.rot.w) < kEpsilon);
+	}
+
+	SECTION("negative deltas do not predict")
+	{
+		struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+		m_imu_3dof_predict(&f, -50 * (int64_t)U_TIME_1MS_IN_NS, &rel);
+
+		CHECK(rel.pose.orientation.x == f.rot.x);
+		CHECK(rel.pose.orientation.y == f.rot.y);
+		CHECK(rel.pose.orientation.z == f.rot.z);
+		CHECK(rel.pose.orientation.w == f.rot.w);
+	}
+
+	SECTION("long predictions are clamped")
+	{
+		struct xrt_space_relation clamped = XRT_SPACE_RELATION_ZERO;
+		struct xrt_space_relation longest = XRT_SPACE_RELATION_ZERO;
+		m_imu_3dof_predict(&f, 10 * M_IMU_3DOF_MAX_PREDICTION_NS, &clamped);
+		m_imu_3dof_predict(&f, M_IMU_3DOF_MAX_PREDICTION_NS, &longest);
+
+		CHECK(clamped.pose.orientation.x == longest.pose.orientation.x);
+		CHECK(clamped.pose.orientation.y == longest.pose.orientation.y);
+		CHECK(clamped.pose.orientation.z == longest.pose.orientation.z);
+		CHECK(clamped.pose.orientation.w == longest.pose.orientation.w);
+	}
+
+	m_imu_3dof_close(&f);
+}
@@ -0,0 +1,85 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief I/O thread stats tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_time.h>
+#include <util/u_io_stats.h>
+
+#include "catch/catch.hpp"
+
+
+static void
+packet(struct u_io_stats *uis, uint64_t arrival_ns, uint64_t process_ns)
+{
+	u_io_stats_packet_begin(uis, arrival_ns);
+	u_io_stats_packet_end(uis, arrival_ns + process_ns);
+}
+
+TEST_CASE("u_io_stats")
+{
+	struct u_io_stats uis;
+	u_io_stats_init(&uis, "test");
+
+	SECTION("sequence")
+	{
+		u_io_stats_sequence(&uis, 250, 0xff);
+		u_io_stats_sequence(&uis, 251, 0xff);
+		CHECK(uis.missed_count == 0);
+
+		// Wraps around, 252 to 255 and 0 missed.
+		u_io_stats_sequence(&uis, 1, 0xff);
+		CHECK(uis.missed_count == 5);
+
+		u_io_stats_sequence(&uis, 1, 0xff);
+		CHECK(uis.duplicate_count == 1);
+
+		// Backwards is a resync, not counted.
+		u_io_stats_sequence(&uis, 200, 0xff);
+		u_io_stats_sequence(&uis, 201, 0xff);
+		CHECK(uis.missed_count == 5);
+		CHECK(uis.duplicate_count == 1);
+	}
+
+	SECTION("period")
+	{
+		uint64_t ns = U_TIME_1S_IN_NS;
+
+		// 1kHz packets, the thread keeps up.
+		for (uint32_t i = 0; i < 1000; i++) {
+			packet(&uis, ns, 20 * U_TIME_1US_IN_NS);
+			ns += U_TIME_1MS_IN_NS;
+		}
+
+		// Published after a full period.
+		packet(&uis, ns, 50 * U_TIME_1US_IN_NS);
+
+		CHECK(uis.packet_count == 1001);
+		CHECK(uis.interval_ms == Approx(1.0f));
+		CHECK(uis.interval_max_ms == Approx(1.0f));
+		CHECK(uis.process_max_us == Approx(50.0f));
+		CHECK(uis.backlog_max == 0);
+	}
+
+	SECTION("backlog")
+	{
+		uint64_t ns = U_TIME_1S_IN_NS;
+
+		// Stalled, then three packets that were waiting are read at once.
+		packet(&uis, ns, 10 * U_TIME_1US_IN_NS);
+		ns += 20 * U_TIME_1MS_IN_NS;
+		for (uint32_t i = 0; i < 4; i++) {
+			packet(&uis, ns, 10 * U_TIME_1US_IN_NS);
+			ns += 15 * U_TIME_1US_IN_NS;
+		}
+
+		// End the period.
+		packet(&uis, ns + U_TIME_1S_IN_NS, 10 * U_TIME_1US_IN_NS);
+
+		CHECK(uis.backlog_max == 3);
+		CHECK(uis.interval_max_ms == Approx(1000.0f).epsilon(0.01));
+	}
+}
@@ -9,6 +9,7 @@
 #include "util/u_logging.h"
 #include "xrt/xrt_defines.h"
 #include <util/u_worker.hpp>
+#include <math/m_api.h>
 #include <math/m_mathinclude.h>
 #include <math/m_space.h>
 #include <math/m_vec3.h>
@@ -25,17 +26,9 @@
 
 using namespace xrt::tracking::hand::mercury;
 
-TEST_CASE("LevenbergMarquardt")
+static void
+make_test_input(one_frame_input &input)
 {
-	// This does very little at the moment:
-	// * It will explode if any floating point exceptions are generated
-	// * You should run it with `valgrind --track-origins=yes` (and compile without optimizations so that origin
-	// tracking works well) to see if we are using any uninitialized values.
-
-	fetestexcept(FE_ALL_EXCEPT);
-
-	struct one_frame_input input = {};
-
 	for (int view = 0; view < 2; view++) {
 		input.views[view].active = true;
 		input.views[view].stereographic_radius = 0.5;
@@ -57,6 +50,19 @@ TEST_CASE("LevenbergMarquardt")
 			input.views[view].keypoints_in_scaled_stereographic[i].confidence_xy = 1.0f;
 		}
 	}
+}
+
+TEST_CASE("LevenbergMarquardt")
+{
+	// This does very little at the moment:
+	// * It will explode if any floating point exceptions are generated
+	// * You should run it with `valgrind --track-origins=yes` (and compile without optimizations so that origin
+	// tracking works well) to see if we are using any uninitialized values.
+
+	fetestexcept(FE_ALL_EXCEPT);
+
+	struct one_frame_input input = {};
+	make_test_input(input);
 
 	lm::KinematicHandLM *hand;
 
@@ -84,3 +90,50 @@ TEST_CASE("LevenbergMarquardt")
 	CHECK(std::isfinite(out_reprojection_error));
 	CHECK(std::isfinite(out_hand_size));
 }
+
+TEST_CASE("LevenbergMarquardtJacobian")
+{
+	// The optimizer uses a hand-written Jacobian, check it against autodiff.
+
+	for (bool is_right : {false, true}) {
+		for (bool optimize_hand_size : {false, true}) {
+			CAPTURE(is_right);
+			CAPTURE(optimize_hand_size);
+
+			struct one_frame_input input = {};
+			make_test_input(input);
+
+			// Look a bit away from straight ahead so all of the rotations matter.
+			input.views[1].look_dir = {0.1f, -0.05f, 0.02f, 0.99f};
+			math_quat_normalize(&input.views[1].look_dir);
+
+			lm::KinematicHandLM *hand;
+
+			xrt_pose left_in_right = XRT_POSE_IDENTITY;
+			left_in_right.position.x = 0.1;
+
+			lm::optimizer_create(left_in_right, is_right, U_LOGGING_WARN, &hand);
+
+			// Run twice so that we have a previous frame and the stability terms are used.
+			for (int i = 0; i < 2; i++) {
+				struct one_frame_input copy = input;
+				xrt_hand_joint_set out = {};
+				float out_hand_size = 0.0f;
+				float out_reprojection_error = 0.0f;
+				lm::optimizer_run(hand, copy, i == 0, 2.0f, optimize_hand_size, 0.09, 0.5, 0.5f, out,
+				                  out_hand_size, out_reprojection_error);
+			}
+
+			for (uint32_t seed = 0; seed < 8; seed++) {
+				CAPTURE(seed);
+				// No perturbation is the starting point of the next frame, where the wrist's angle-axis
+				// is still zero.
+				float perturbation = seed == 0 ? 0.0f : 0.3f;
+				CHECK(lm::optimizer_compare_jacobians(hand, input, 2.0f, optimize_hand_size, 0.09, 0.5,
+				                                      0.5f, perturbation, seed) < 1e-3f);
+			}
+
+			lm::optimizer_destroy(&hand);
+		}
+	}
+}
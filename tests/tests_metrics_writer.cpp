@@ -0,0 +1,97 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Metrics writer tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_metrics_writer.h>
+
+#include "catch/catch.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+TEST_CASE("u_metrics_writer")
+{
+	FILE *file = tmpfile();
+	REQUIRE(file != nullptr);
+
+	SECTION("needs an output")
+	{
+		CHECK(u_metrics_writer_create(nullptr, nullptr, false) == nullptr);
+	}
+
+	SECTION("many producers")
+	{
+		struct u_metrics_writer *umw = u_metrics_writer_create(file, nullptr, false);
+		REQUIRE(umw != nullptr);
+
+		constexpr uint32_t thread_count = 4;
+		constexpr uint32_t record_count = 20000;
+		std::atomic<uint32_t> pushed{0};
+
+		// Each record is the thread index and a counter, so they can be checked.
+		std::vector<std::thread> threads;
+		for (uint32_t t = 0; t < thread_count; t++) {
+			threads.emplace_back([&, t]() {
+				for (uint32_t i = 0; i < record_count; i++) {
+					uint32_t record[2] = {t, i};
+					if (u_metrics_writer_push(umw, record, sizeof(record))) {
+						pushed++;
+					} else {
+						std::this_thread::yield();
+					}
+				}
+			});
+		}
+
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+
+		u_metrics_writer_destroy(&umw);
+		CHECK(umw == nullptr);
+
+		// Everything pushed is written, in order per thread.
+		rewind(file);
+		uint32_t last[thread_count] = {};
+		bool first[thread_count] = {true, true, true, true};
+		uint32_t read = 0;
+		uint32_t bad = 0;
+		uint32_t record[2];
+		while (fread(record, sizeof(record), 1, file) == 1) {
+			uint32_t t = record[0];
+			if (t >= thread_count || (!first[t] && record[1] <= last[t])) {
+				bad++;
+				continue;
+			}
+			first[t] = false;
+			last[t] = record[1];
+			read++;
+		}
+
+		CHECK(bad == 0);
+		CHECK(read == pushed.load());
+		CHECK(read > 0);
+	}
+
+	SECTION("too big")
+	{
+		struct u_metrics_writer *umw = u_metrics_writer_create(file, nullptr, false);
+		REQUIRE(umw != nullptr);
+
+		uint8_t big[U_METRICS_WRITER_MAX_RECORD_SIZE + 1] = {};
+		CHECK_FALSE(u_metrics_writer_push(umw, big, sizeof(big)));
+		CHECK(u_metrics_writer_push(umw, big, U_METRICS_WRITER_MAX_RECORD_SIZE));
+
+		u_metrics_writer_destroy(&umw);
+
+		CHECK(ftell(file) == U_METRICS_WRITER_MAX_RECORD_SIZE);
+	}
+
+	fclose(file);
+}
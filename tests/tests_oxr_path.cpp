@@ -0,0 +1,95 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Path store tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <oxr/oxr_objects.h>
+#include <oxr/oxr_logger.h>
+
+#include "catch/catch.hpp"
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+
+TEST_CASE("oxr_path")
+{
+	struct oxr_logger log;
+	oxr_log_init(&log, "test");
+
+	// Too big for the stack and needs to be zeroed.
+	struct oxr_instance *inst = (struct oxr_instance *)calloc(1, sizeof(struct oxr_instance));
+	REQUIRE(oxr_path_init(&log, inst) == XR_SUCCESS);
+
+	SECTION("null path is invalid")
+	{
+		const char *str = NULL;
+		size_t length = 0;
+
+		CHECK_FALSE(oxr_path_is_valid(&log, inst, XR_NULL_PATH));
+		CHECK(oxr_path_get_string(&log, inst, XR_NULL_PATH, &str, &length) == XR_ERROR_PATH_INVALID);
+		CHECK(oxr_path_get_string(&log, inst, 1000, &str, &length) == XR_ERROR_PATH_INVALID);
+	}
+
+	SECTION("get or create is interned")
+	{
+		std::string s = "/user/hand/left/input/select/click";
+		XrPath a = XR_NULL_PATH;
+		XrPath b = XR_NULL_PATH;
+		XrPath only = XR_NULL_PATH;
+
+		CHECK(oxr_path_only_get(&log, inst, s.c_str(), s.length(), &only) == XR_SUCCESS);
+		CHECK(only == XR_NULL_PATH);
+
+		CHECK(oxr_path_get_or_create(&log, inst, s.c_str(), s.length(), &a) == XR_SUCCESS);
+		CHECK(oxr_path_get_or_create(&log, inst, s.c_str(), s.length(), &b) == XR_SUCCESS);
+		CHECK(oxr_path_only_get(&log, inst, s.c_str(), s.length(), &only) == XR_SUCCESS);
+		CHECK(a != XR_NULL_PATH);
+		CHECK(a == b);
+		CHECK(a == only);
+		CHECK(oxr_path_is_valid(&log, inst, a));
+
+		// A prefix is a different path.
+		XrPath prefix = XR_NULL_PATH;
+		CHECK(oxr_path_get_or_create(&log, inst, s.c_str(), s.length() - 6, &prefix) == XR_SUCCESS);
+		CHECK(prefix != a);
+	}
+
+	SECTION("many paths keep their strings")
+	{
+		// Enough to grow the table, path array and string chunks several times.
+		std::vector<std::string> strs;
+		std::vector<XrPath> ids;
+		for (int i = 0; i < 5000; i++) {
+			strs.push_back("/interaction_profiles/test/path_" + std::to_string(i));
+		}
+		// One string longer than a chunk.
+		strs.push_back("/" + std::string(20000, 'a'));
+
+		for (const std::string &s : strs) {
+			XrPath id = XR_NULL_PATH;
+			REQUIRE(oxr_path_get_or_create(&log, inst, s.c_str(), s.length(), &id) == XR_SUCCESS);
+			ids.push_back(id);
+		}
+
+		for (size_t i = 0; i < strs.size(); i++) {
+			const char *str = NULL;
+			size_t length = 0;
+			XrPath id = XR_NULL_PATH;
+
+			REQUIRE(oxr_path_get_string(&log, inst, ids[i], &str, &length) == XR_SUCCESS);
+			CHECK(std::string(str, length) == strs[i]);
+			CHECK(str[length] == '\0');
+
+			CHECK(oxr_path_only_get(&log, inst, strs[i].c_str(), strs[i].length(), &id) == XR_SUCCESS);
+			CHECK(id == ids[i]);
+		}
+	}
+
+	oxr_path_destroy(&log, inst);
+	free(inst);
+}
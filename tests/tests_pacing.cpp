@@ -12,6 +12,7 @@
 
 #include "time_utils.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <chrono>
 #include <sstream>
@@ -402,3 +403,106 @@ TEST_CASE("u_pacing_compositor_fake")
 	}
 	u_pc_destroy(&upc);
 }
+
+TEST_CASE("u_pacing_compositor_fake_vblank_clock")
+{
+	MockClock clock;
+	u_pacing_compositor *upc = nullptr;
+	REQUIRE(XRT_SUCCESS == u_pc_fake_create(frame_interval_ns.count(), clock.now(), &upc));
+	REQUIRE(upc != nullptr);
+
+	// The real display is a bit slower than the nominal period.
+	const uint64_t period_ns = frame_interval_ns.count() + unanoseconds(100us).count();
+	uint64_t vblank_ns = clock.now() + unanoseconds(5ms).count();
+
+	// Samples are late by the wake up latency of the thread, sometimes skipping vblanks.
+	for (int i = 0; i < 200; i++) {
+		uint64_t latency_ns = unanoseconds(50us).count() + (uint64_t)((i * 7919) % 13) * 100'000;
+		u_pc_update_vblank_from_display_control(upc, vblank_ns + latency_ns);
+		vblank_ns += period_ns * (i % 5 == 0 ? 2 : 1);
+	}
+	clock.advance_to(vblank_ns - period_ns / 2);
+
+	CompositorPredictions predictions;
+	u_pc_predict(upc, clock.now(), &predictions.frame_id, &predictions.wake_up_time_ns,
+	             &predictions.desired_present_time_ns, &predictions.present_slop_ns,
+	             &predictions.predicted_display_time_ns, &predictions.predicted_display_period_ns,
+	             &predictions.min_display_period_ns);
+	basicPredictionConsistencyChecks(clock.now(), predictions);
+
+	// The period is measured, not the nominal one.
+	CHECK(predictions.predicted_display_period_ns > period_ns - unanoseconds(10us).count());
+	CHECK(predictions.predicted_display_period_ns < period_ns + unanoseconds(10us).count());
+
+	// Lines up with a real vblank, closer than the up to 1.25ms of latency.
+	int64_t diff_ns = (int64_t)predictions.desired_present_time_ns - (int64_t)vblank_ns;
+	int64_t offset_ns = ((diff_ns % (int64_t)period_ns) + (int64_t)period_ns) % (int64_t)period_ns;
+	int64_t error_ns = std::min<int64_t>(offset_ns, (int64_t)period_ns - offset_ns);
+	CHECK(error_ns < (int64_t)unanoseconds(500us).count());
+
+	u_pc_destroy(&upc);
+}
+
+TEST_CASE("u_pacing_app_gpu_slice")
+{
+	MockClock clock;
+	clock.advance(1ms);
+
+	u_pacing_app_factory *upaf = nullptr;
+	REQUIRE(XRT_SUCCESS == u_pa_factory_create(&upaf));
+
+	u_pacing_app *first = nullptr;
+	u_pacing_app *second = nullptr;
+	u_paf_create(upaf, &first);
+	u_paf_create(upaf, &second);
+	REQUIRE(first != nullptr);
+	REQUIRE(second != nullptr);
+
+	uint64_t display_ns = clock.now() + unanoseconds(50ms).count();
+	u_pa_info(first, display_ns, frame_interval_ns.count(), unanoseconds(2ms).count());
+	u_pa_info(second, display_ns, frame_interval_ns.count(), unanoseconds(2ms).count());
+
+	int64_t frame_id = -1;
+	uint64_t first_wake_ns = 0;
+	uint64_t first_display_ns = 0;
+	uint64_t second_wake_ns = 0;
+	uint64_t second_display_ns = 0;
+	uint64_t period_ns = 0;
+
+	SECTION("slice moves the wake up earlier")
+	{
+		u_pa_set_gpu_slice(second, unanoseconds(4ms).count());
+
+		u_pa_predict(first, clock.now(), &frame_id, &first_wake_ns, &first_display_ns, &period_ns);
+		u_pa_predict(second, clock.now(), &frame_id, &second_wake_ns, &second_display_ns, &period_ns);
+
+		CHECK(first_display_ns == display_ns);
+		CHECK(second_display_ns == display_ns);
+		CHECK(first_wake_ns - second_wake_ns == (uint64_t)unanoseconds(4ms).count());
+	}
+
+	SECTION("slice that doesn't fit goes to a later display")
+	{
+		u_pa_set_gpu_slice(second, unanoseconds(48ms).count());
+
+		u_pa_predict(second, clock.now(), &frame_id, &second_wake_ns, &second_display_ns, &period_ns);
+
+		CHECK(second_display_ns > display_ns);
+		CHECK(second_wake_ns > clock.now());
+	}
+
+	SECTION("cleared slice")
+	{
+		u_pa_set_gpu_slice(second, unanoseconds(4ms).count());
+		u_pa_set_gpu_slice(second, 0);
+
+		u_pa_predict(first, clock.now(), &frame_id, &first_wake_ns, &first_display_ns, &period_ns);
+		u_pa_predict(second, clock.now(), &frame_id, &second_wake_ns, &second_display_ns, &period_ns);
+
+		CHECK(first_wake_ns == second_wake_ns);
+	}
+
+	u_pa_destroy(&first);
+	u_pa_destroy(&second);
+	u_paf_destroy(&upaf);
+}
@@ -0,0 +1,91 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Dynamic resolution controller tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_pacing_resolution.h>
+
+#include "catch/catch.hpp"
+
+
+static constexpr uint64_t kPeriodNs = 11'111'111;
+
+// Feed frames whose GPU time follows the pixel count of the current scale.
+static bool
+run_frames(struct u_pacing_resolution &upr, uint64_t full_gpu_ns, int count)
+{
+	bool changed = false;
+	for (int i = 0; i < count; i++) {
+		uint64_t gpu_ns = (uint64_t)((double)full_gpu_ns * upr.scale * upr.scale);
+		changed = u_pr_update(&upr, gpu_ns, kPeriodNs, gpu_ns > kPeriodNs) || changed;
+	}
+	return changed;
+}
+
+TEST_CASE("u_pacing_resolution")
+{
+	struct u_pacing_resolution upr;
+	u_pr_init(&upr, 0.5f);
+
+	SECTION("starts at full resolution")
+	{
+		CHECK(upr.scale == 1.0f);
+	}
+
+	SECTION("light load stays at full resolution")
+	{
+		CHECK_FALSE(run_frames(upr, kPeriodNs / 2, 200));
+		CHECK(upr.scale == 1.0f);
+	}
+
+	SECTION("heavy load settles below the period")
+	{
+		CHECK(run_frames(upr, kPeriodNs * 3 / 2, 300));
+		CHECK(upr.scale < 1.0f);
+		CHECK(upr.scale >= 0.5f);
+
+		// Once settled the frames fit.
+		double load = 1.5 * upr.scale * upr.scale;
+		CHECK(load < 0.95);
+		CHECK(load > 0.5);
+	}
+
+	SECTION("never below the minimum")
+	{
+		run_frames(upr, kPeriodNs * 10, 300);
+		CHECK(upr.scale == 0.5f);
+	}
+
+	SECTION("grows back when the load goes away")
+	{
+		run_frames(upr, kPeriodNs * 2, 100);
+		REQUIRE(upr.scale < 1.0f);
+
+		run_frames(upr, kPeriodNs / 4, 45 * 32);
+		CHECK(upr.scale == 1.0f);
+	}
+
+	SECTION("a missed frame always backs off")
+	{
+		CHECK(u_pr_update(&upr, kPeriodNs / 2, kPeriodNs, true));
+		CHECK(upr.scale == 1.0f - U_PACING_RESOLUTION_STEP);
+	}
+
+	SECTION("no period no change")
+	{
+		CHECK_FALSE(u_pr_update(&upr, kPeriodNs * 2, 0, true));
+		CHECK(upr.scale == 1.0f);
+	}
+}
+
+TEST_CASE("u_pacing_resolution_disabled")
+{
+	struct u_pacing_resolution upr;
+	u_pr_init(&upr, 1.0f);
+
+	CHECK_FALSE(u_pr_update(&upr, kPeriodNs * 2, kPeriodNs, true));
+	CHECK(upr.scale == 1.0f);
+}
@@ -0,0 +1,831 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Discrete event simulation of app and compositor frame pacing.
+ *
+ * Drives a @ref u_pacing_app and a @ref u_pacing_compositor against a
+ * simulated display with jittery vsync, and apps and compositors whose CPU and
+ * GPU times come from synthetic distributions or a recorded trace. Everything
+ * runs on a virtual clock with a fixed seed, so a run gives the same numbers
+ * every time and pacing changes can be compared on them.
+ *
+ * Set `PACING_SIM_TRACE` to a file with one "cpu_ms gpu_ms" pair of app frame
+ * times per line to also replay a recorded trace against all configurations.
+ *
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_time.h>
+#include <util/u_pacing.h>
+
+#include "catch/catch.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <vector>
+
+
+namespace {
+
+constexpr uint64_t kMs = U_TIME_1MS_IN_NS;
+constexpr uint64_t kUs = U_TIME_1MS_IN_NS / 1000;
+
+//! 90Hz, like most headsets.
+constexpr uint64_t kPeriodNs = U_TIME_1S_IN_NS / 90;
+
+//! How long after present the display timing information shows up.
+constexpr uint64_t kInfoDelayNs = 1 * kMs;
+
+//! Compositor frames to run for, and at the start to leave out of the stats.
+constexpr uint32_t kFrameCount = 2000;
+constexpr uint32_t kWarmupFrames = 100;
+
+
+/*
+ *
+ * Random numbers.
+ *
+ */
+
+/*!
+ * SplitMix64, the standard library distributions are implementation defined
+ * so would give different numbers on different platforms.
+ */
+struct Rng
+{
+	uint64_t state;
+
+	uint64_t
+	next()
+	{
+		uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		return z ^ (z >> 31);
+	}
+
+	//! Uniform in [0, 1).
+	double
+	unit()
+	{
+		return (double)(next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	//! Uniform in [-range, range].
+	int64_t
+	jitter(uint64_t range_ns)
+	{
+		return (int64_t)((unit() * 2.0 - 1.0) * (double)range_ns);
+	}
+
+	bool
+	chance(double probability)
+	{
+		return unit() < probability;
+	}
+};
+
+
+/*
+ *
+ * Workload description.
+ *
+ */
+
+//! CPU and GPU time of one frame.
+struct FrameTimes
+{
+	uint64_t cpu_ns;
+	uint64_t gpu_ns;
+};
+
+/*!
+ * Synthetic frame times, a base plus uniform jitter and an occasional spike.
+ */
+struct Workload
+{
+	uint64_t cpu_ns;
+	uint64_t cpu_jitter_ns;
+	uint64_t gpu_ns;
+	uint64_t gpu_jitter_ns;
+	uint64_t gpu_spike_ns;
+	double gpu_spike_chance;
+
+	//! If not empty the frame times are taken from here in a loop instead.
+	std::vector<FrameTimes> trace;
+
+	FrameTimes
+	sample(Rng &rng, uint64_t index) const
+	{
+		if (!trace.empty()) {
+			return trace[index % trace.size()];
+		}
+
+		FrameTimes ft;
+		ft.cpu_ns = (uint64_t)((int64_t)cpu_ns + rng.jitter(cpu_jitter_ns));
+		ft.gpu_ns = (uint64_t)((int64_t)gpu_ns + rng.jitter(gpu_jitter_ns));
+		if (rng.chance(gpu_spike_chance)) {
+			ft.gpu_ns += gpu_spike_ns;
+		}
+		return ft;
+	}
+};
+
+struct Scenario
+{
+	const char *name;
+	uint64_t vsync_jitter_ns;
+	Workload app;
+	Workload comp;
+};
+
+struct PacingConfig
+{
+	const char *name;
+	std::function<u_pacing_compositor *(uint64_t now_ns)> create;
+};
+
+//! Numbers for one run of a scenario with a pacing config.
+struct SimResult
+{
+	uint64_t comp_frames = 0;
+	uint64_t comp_missed = 0;
+
+	uint64_t app_frames = 0;
+	uint64_t app_late = 0;
+	uint64_t app_dropped = 0;
+
+	//! Display time minus the time the app began the frame, for displayed frames.
+	uint64_t latency_sum_ns = 0;
+	uint64_t latency_count = 0;
+
+	//! Time between the compositor GPU work finishing and its present.
+	uint64_t comp_waste_sum_ns = 0;
+
+	//! Time between the app GPU work finishing and the compositor picking it up.
+	uint64_t app_waste_sum_ns = 0;
+	uint64_t app_waste_count = 0;
+
+	double
+	compMissRate() const
+	{
+		return comp_frames > 0 ? (double)comp_missed / (double)comp_frames : 0.0;
+	}
+
+	double
+	appMissRate() const
+	{
+		return app_frames > 0 ? (double)(app_late + app_dropped) / (double)app_frames : 0.0;
+	}
+
+	double
+	latencyMs() const
+	{
+		return latency_count > 0 ? (double)latency_sum_ns / (double)latency_count / (double)kMs : 0.0;
+	}
+
+	double
+	compWasteMs() const
+	{
+		return comp_frames > 0 ? (double)comp_waste_sum_ns / (double)comp_frames / (double)kMs : 0.0;
+	}
+
+	double
+	appWasteMs() const
+	{
+		return app_waste_count > 0 ? (double)app_waste_sum_ns / (double)app_waste_count / (double)kMs : 0.0;
+	}
+};
+
+
+/*
+ *
+ * Simulation.
+ *
+ */
+
+//! Vsyncs are at a fixed period plus a per vsync jitter, seeded by the index.
+struct Display
+{
+	uint64_t start_ns;
+	uint64_t jitter_ns;
+
+	uint64_t
+	vsync(uint64_t index) const
+	{
+		Rng rng{index * 0x2545f4914f6cdd1dULL};
+		return start_ns + index * kPeriodNs + (uint64_t)((int64_t)jitter_ns + rng.jitter(jitter_ns));
+	}
+
+	//! First vsync at or after @p when_ns, jitter is less than half a period.
+	uint64_t
+	vsyncAtOrAfter(uint64_t when_ns) const
+	{
+		uint64_t index = when_ns > start_ns ? (when_ns - start_ns) / kPeriodNs : 0;
+		index = index > 0 ? index - 1 : 0;
+		while (vsync(index) < when_ns) {
+			index++;
+		}
+		return vsync(index);
+	}
+};
+
+//! An app frame from being delivered until it has been displayed or dropped.
+struct AppFrame
+{
+	int64_t frame_id;
+	uint64_t begin_ns;
+	uint64_t predicted_display_ns;
+	uint64_t gpu_done_ns;
+	bool counted;
+};
+
+struct InfoEvent
+{
+	uint64_t when_ns;
+	int64_t frame_id;
+	uint64_t desired_present_ns;
+	uint64_t actual_present_ns;
+	uint64_t earliest_present_ns;
+	uint64_t margin_ns;
+	uint64_t gpu_start_ns;
+	uint64_t gpu_end_ns;
+
+	bool
+	operator>(const InfoEvent &other) const
+	{
+		return when_ns > other.when_ns;
+	}
+};
+
+class Simulation
+{
+public:
+	Simulation(const Scenario &scenario, const PacingConfig &config)
+	    : scenario_(scenario), display_{kPeriodNs * 10, scenario.vsync_jitter_ns}
+	{
+		upc_ = config.create(now_ns_);
+		REQUIRE(upc_ != nullptr);
+
+		REQUIRE(u_pa_factory_create(&upaf_) == XRT_SUCCESS);
+		u_paf_create(upaf_, &upa_);
+		REQUIRE(upa_ != nullptr);
+	}
+
+	~Simulation()
+	{
+		u_pa_destroy(&upa_);
+		u_paf_destroy(&upaf_);
+		u_pc_destroy(&upc_);
+	}
+
+	SimResult
+	run()
+	{
+		while (result_frame_ < kFrameCount) {
+			step();
+		}
+		return result_;
+	}
+
+private:
+	enum class CompState
+	{
+		Predict,
+		Wake,
+		Submit,
+	};
+
+	enum class AppState
+	{
+		Predict,
+		Wake,
+		Deliver,
+	};
+
+	static constexpr uint64_t kNever = UINT64_MAX;
+
+	const Scenario &scenario_;
+	Display display_;
+
+	Rng app_rng_{1};
+	Rng comp_rng_{2};
+
+	u_pacing_compositor *upc_ = nullptr;
+	u_pacing_app_factory *upaf_ = nullptr;
+	u_pacing_app *upa_ = nullptr;
+
+	uint64_t now_ns_ = kPeriodNs;
+
+	// Compositor.
+	CompState comp_state_ = CompState::Predict;
+	uint64_t comp_next_ns_ = kPeriodNs;
+	int64_t comp_frame_id_ = 0;
+	uint64_t comp_desired_present_ns_ = 0;
+	uint64_t comp_present_slop_ns_ = 0;
+	uint64_t comp_predicted_display_ns_ = 0;
+	uint64_t comp_period_ns_ = 0;
+	uint64_t comp_frames_done_ = 0;
+	FrameTimes comp_times_{};
+
+	// App, waits for the first timing info from the compositor.
+	AppState app_state_ = AppState::Predict;
+	uint64_t app_next_ns_ = kNever;
+	int64_t app_frame_id_ = 0;
+	uint64_t app_predicted_display_ns_ = 0;
+	uint64_t app_begin_ns_ = 0;
+	uint64_t app_last_gpu_done_ns_ = 0;
+	uint64_t app_frames_done_ = 0;
+	FrameTimes app_times_{};
+
+	//! Delivered but not yet GPU done or not yet picked up, oldest first.
+	std::vector<AppFrame> app_frames_;
+
+	//! The app frame the compositor is showing, -1 if none.
+	int64_t latched_frame_id_ = -1;
+
+	//! Latched this compositor frame, stats are filled in once the present is known.
+	AppFrame pending_latch_{};
+	bool has_pending_latch_ = false;
+
+	std::priority_queue<InfoEvent, std::vector<InfoEvent>, std::greater<InfoEvent>> info_queue_;
+
+	SimResult result_;
+	uint32_t result_frame_ = 0;
+
+	bool
+	counting() const
+	{
+		return result_frame_ >= kWarmupFrames;
+	}
+
+	void
+	step()
+	{
+		uint64_t info_ns = info_queue_.empty() ? kNever : info_queue_.top().when_ns;
+		uint64_t gpu_ns = kNever;
+		for (const AppFrame &f : app_frames_) {
+			if (!f.counted && f.gpu_done_ns < gpu_ns) {
+				gpu_ns = f.gpu_done_ns;
+			}
+		}
+
+		// Ties are resolved in the order the real code would see them.
+		uint64_t next_ns = std::min({info_ns, gpu_ns, comp_next_ns_, app_next_ns_});
+		now_ns_ = next_ns;
+
+		if (next_ns == info_ns) {
+			doInfo();
+		} else if (next_ns == gpu_ns) {
+			doAppGpuDone();
+		} else if (next_ns == comp_next_ns_) {
+			doComp();
+		} else {
+			doApp();
+		}
+	}
+
+	void
+	doInfo()
+	{
+		InfoEvent e = info_queue_.top();
+		info_queue_.pop();
+
+		u_pc_info(upc_, e.frame_id, e.desired_present_ns, e.actual_present_ns, e.earliest_present_ns,
+		          e.margin_ns, e.when_ns);
+		u_pc_info_gpu(upc_, e.frame_id, e.gpu_start_ns, e.gpu_end_ns, e.when_ns);
+	}
+
+	void
+	doAppGpuDone()
+	{
+		for (AppFrame &f : app_frames_) {
+			if (!f.counted && f.gpu_done_ns == now_ns_) {
+				u_pa_mark_gpu_done(upa_, f.frame_id, now_ns_);
+				f.counted = true;
+				return;
+			}
+		}
+	}
+
+	//! Pick the newest finished app frame that is not meant for a later display.
+	void
+	latchAppFrame()
+	{
+		int64_t newest = -1;
+		for (const AppFrame &f : app_frames_) {
+			bool ready = f.counted && f.gpu_done_ns <= now_ns_;
+			bool too_early = f.predicted_display_ns > comp_predicted_display_ns_ + comp_period_ns_ / 2;
+			if (ready && !too_early) {
+				newest = f.frame_id;
+			}
+		}
+
+		if (newest < 0) {
+			return;
+		}
+
+		for (auto it = app_frames_.begin(); it != app_frames_.end();) {
+			if (it->frame_id > newest) {
+				++it;
+				continue;
+			}
+
+			if (it->frame_id == newest) {
+				u_pa_latched(upa_, it->frame_id, now_ns_, comp_frame_id_);
+				if (latched_frame_id_ >= 0) {
+					u_pa_retired(upa_, latched_frame_id_, now_ns_);
+				}
+				latched_frame_id_ = it->frame_id;
+
+				pending_latch_ = *it;
+				has_pending_latch_ = true;
+			} else if (counting()) {
+				// Superseded before the compositor ever got to it.
+				result_.app_dropped++;
+				result_.app_frames++;
+			}
+
+			it = app_frames_.erase(it);
+		}
+	}
+
+	void
+	doComp()
+	{
+		switch (comp_state_) {
+		case CompState::Predict: {
+			uint64_t wake_up_ns = 0;
+			uint64_t min_period_ns = 0;
+			u_pc_predict(upc_, now_ns_, &comp_frame_id_, &wake_up_ns, &comp_desired_present_ns_,
+			             &comp_present_slop_ns_, &comp_predicted_display_ns_, &comp_period_ns_,
+			             &min_period_ns);
+
+			comp_state_ = CompState::Wake;
+			comp_next_ns_ = std::max(now_ns_, wake_up_ns);
+			break;
+		}
+		case CompState::Wake: {
+			u_pc_mark_point(upc_, U_TIMING_POINT_WAKE_UP, comp_frame_id_, now_ns_);
+
+			// Same as the multi compositor, the diff is the time left.
+			uint64_t diff_ns = comp_predicted_display_ns_ - now_ns_;
+			u_pa_info(upa_, comp_predicted_display_ns_, comp_period_ns_, diff_ns);
+			if (app_next_ns_ == kNever) {
+				app_next_ns_ = now_ns_;
+			}
+
+			latchAppFrame();
+
+			u_pc_mark_point(upc_, U_TIMING_POINT_BEGIN, comp_frame_id_, now_ns_);
+
+			comp_times_ = scenario_.comp.sample(comp_rng_, comp_frames_done_);
+			comp_state_ = CompState::Submit;
+			comp_next_ns_ = now_ns_ + comp_times_.cpu_ns;
+			break;
+		}
+		case CompState::Submit: {
+			u_pc_mark_point(upc_, U_TIMING_POINT_SUBMIT_BEGIN, comp_frame_id_, now_ns_);
+			u_pc_mark_point(upc_, U_TIMING_POINT_SUBMIT_END, comp_frame_id_, now_ns_);
+
+			uint64_t gpu_start_ns = now_ns_;
+			uint64_t gpu_end_ns = gpu_start_ns + comp_times_.gpu_ns;
+
+			// FIFO present, never before the requested time.
+			uint64_t not_before_ns = comp_desired_present_ns_ - comp_present_slop_ns_;
+			uint64_t actual_ns = display_.vsyncAtOrAfter(std::max(gpu_end_ns, not_before_ns));
+			uint64_t earliest_ns = display_.vsyncAtOrAfter(gpu_end_ns);
+
+			// The vsync the pacer was aiming for, the frame missed if it is later.
+			uint64_t target_ns = display_.vsyncAtOrAfter(not_before_ns);
+
+			InfoEvent e;
+			e.when_ns = actual_ns + kInfoDelayNs;
+			e.frame_id = comp_frame_id_;
+			e.desired_present_ns = comp_desired_present_ns_;
+			e.actual_present_ns = actual_ns;
+			e.earliest_present_ns = earliest_ns;
+			e.margin_ns = earliest_ns - gpu_end_ns;
+			e.gpu_start_ns = gpu_start_ns;
+			e.gpu_end_ns = gpu_end_ns;
+			info_queue_.push(e);
+
+			recordCompFrame(actual_ns, target_ns, gpu_end_ns);
+
+			comp_frames_done_++;
+			result_frame_++;
+			comp_state_ = CompState::Predict;
+			comp_next_ns_ = now_ns_;
+			break;
+		}
+		}
+	}
+
+	void
+	recordCompFrame(uint64_t actual_present_ns, uint64_t target_present_ns, uint64_t gpu_end_ns)
+	{
+		// Same offset from present to display as the pacer predicted.
+		uint64_t display_ns = actual_present_ns + (comp_predicted_display_ns_ - comp_desired_present_ns_);
+		bool missed = actual_present_ns > target_present_ns;
+
+		if (counting()) {
+			result_.comp_frames++;
+			result_.comp_waste_sum_ns += actual_present_ns - gpu_end_ns;
+			if (missed) {
+				result_.comp_missed++;
+			}
+		}
+
+		if (!has_pending_latch_) {
+			return;
+		}
+		has_pending_latch_ = false;
+
+		if (!counting()) {
+			return;
+		}
+
+		const AppFrame &f = pending_latch_;
+		result_.app_frames++;
+		result_.latency_sum_ns += display_ns - f.begin_ns;
+		result_.latency_count++;
+		result_.app_waste_sum_ns += now_ns_ - f.gpu_done_ns - comp_times_.cpu_ns;
+		result_.app_waste_count++;
+
+		// Picked up for a later compositor frame than it was meant for, or that frame missed.
+		if (missed || comp_predicted_display_ns_ > f.predicted_display_ns + kPeriodNs / 2) {
+			result_.app_late++;
+		}
+	}
+
+	void
+	doApp()
+	{
+		switch (app_state_) {
+		case AppState::Predict: {
+			uint64_t wake_up_ns = 0;
+			uint64_t period_ns = 0;
+			u_pa_predict(upa_, now_ns_, &app_frame_id_, &wake_up_ns, &app_predicted_display_ns_,
+			             &period_ns);
+
+			app_state_ = AppState::Wake;
+			app_next_ns_ = std::max(now_ns_, wake_up_ns);
+			break;
+		}
+		case AppState::Wake: {
+			u_pa_mark_point(upa_, app_frame_id_, U_TIMING_POINT_WAKE_UP, now_ns_);
+			u_pa_mark_point(upa_, app_frame_id_, U_TIMING_POINT_BEGIN, now_ns_);
+			app_begin_ns_ = now_ns_;
+
+			app_times_ = scenario_.app.sample(app_rng_, app_frames_done_);
+			app_state_ = AppState::Deliver;
+			app_next_ns_ = now_ns_ + app_times_.cpu_ns;
+			break;
+		}
+		case AppState::Deliver: {
+			u_pa_mark_delivered(upa_, app_frame_id_, now_ns_, app_predicted_display_ns_);
+
+			// The GPU does one frame at a time.
+			uint64_t gpu_done_ns = std::max(now_ns_, app_last_gpu_done_ns_) + app_times_.gpu_ns;
+			app_last_gpu_done_ns_ = gpu_done_ns;
+
+			AppFrame f;
+			f.frame_id = app_frame_id_;
+			f.begin_ns = app_begin_ns_;
+			f.predicted_display_ns = app_predicted_display_ns_;
+			f.gpu_done_ns = gpu_done_ns;
+			f.counted = false;
+			app_frames_.push_back(f);
+
+			app_frames_done_++;
+			app_state_ = AppState::Predict;
+			app_next_ns_ = now_ns_;
+			break;
+		}
+		}
+	}
+};
+
+
+/*
+ *
+ * Scenarios and configs.
+ *
+ */
+
+Workload
+lightComp()
+{
+	Workload w{};
+	w.cpu_ns = 300 * kUs;
+	w.cpu_jitter_ns = 50 * kUs;
+	w.gpu_ns = 1 * kMs;
+	w.gpu_jitter_ns = 100 * kUs;
+	return w;
+}
+
+Workload
+app(uint64_t cpu_ns, uint64_t gpu_ns, uint64_t jitter_ns)
+{
+	Workload w{};
+	w.cpu_ns = cpu_ns;
+	w.cpu_jitter_ns = jitter_ns;
+	w.gpu_ns = gpu_ns;
+	w.gpu_jitter_ns = jitter_ns;
+	return w;
+}
+
+std::vector<Scenario>
+makeScenarios()
+{
+	std::vector<Scenario> scenarios;
+
+	scenarios.push_back({"light app", 0, app(2 * kMs, 3 * kMs, 200 * kUs), lightComp()});
+
+	scenarios.push_back({"jittery vsync", 500 * kUs, app(2 * kMs, 3 * kMs, 1 * kMs), lightComp()});
+
+	Scenario spikes{"gpu spikes", 200 * kUs, app(2 * kMs, 4 * kMs, 300 * kUs), lightComp()};
+	spikes.app.gpu_spike_ns = 8 * kMs;
+	spikes.app.gpu_spike_chance = 0.01;
+	spikes.comp.gpu_spike_ns = 4 * kMs;
+	spikes.comp.gpu_spike_chance = 0.02;
+	scenarios.push_back(spikes);
+
+	scenarios.push_back({"heavy app", 200 * kUs, app(4 * kMs, 7 * kMs, 500 * kUs), lightComp()});
+
+	// A burst of slow frames, like an app loading something in the background.
+	Scenario bursty{"bursty trace", 200 * kUs, {}, lightComp()};
+	for (uint32_t i = 0; i < 60; i++) {
+		bool slow = i >= 40 && i < 46;
+		bursty.app.trace.push_back({(slow ? 9 : 2) * kMs, (slow ? 6 : 3) * kMs});
+	}
+	scenarios.push_back(bursty);
+
+	return scenarios;
+}
+
+std::vector<PacingConfig>
+makeConfigs()
+{
+	std::vector<PacingConfig> configs;
+
+	configs.push_back({"fake", [](uint64_t now_ns) {
+		                   u_pacing_compositor *upc = nullptr;
+		                   u_pc_fake_create(kPeriodNs, now_ns, &upc);
+		                   return upc;
+	                   }});
+
+	configs.push_back({"display timing", [](uint64_t now_ns) {
+		                   u_pacing_compositor *upc = nullptr;
+		                   u_pc_display_timing_create(kPeriodNs, &U_PC_DISPLAY_TIMING_CONFIG_DEFAULT, &upc);
+		                   return upc;
+	                   }});
+
+	configs.push_back({"display timing, tight margin", [](uint64_t now_ns) {
+		                   u_pc_display_timing_config config = U_PC_DISPLAY_TIMING_CONFIG_DEFAULT;
+		                   config.margin_ns = 250 * kUs;
+		                   config.comp_time_fraction = 5;
+
+		                   u_pacing_compositor *upc = nullptr;
+		                   u_pc_display_timing_create(kPeriodNs, &config, &upc);
+		                   return upc;
+	                   }});
+
+	return configs;
+}
+
+SimResult
+simulate(const Scenario &scenario, const PacingConfig &config)
+{
+	Simulation sim(scenario, config);
+	return sim.run();
+}
+
+void
+printHeader()
+{
+	std::cout << std::left << std::setw(16) << "scenario" << std::setw(30) << "pacing" << std::right
+	          << std::setw(10) << "comp miss" << std::setw(10) << "app miss" << std::setw(14) << "latency(ms)"
+	          << std::setw(16) << "comp waste(ms)" << std::setw(15) << "app waste(ms)" << std::endl;
+}
+
+void
+printResult(const Scenario &scenario, const PacingConfig &config, const SimResult &r)
+{
+	std::cout << std::left << std::setw(16) << scenario.name << std::setw(30) << config.name << std::right
+	          << std::fixed << std::setprecision(2) << std::setw(9) << r.compMissRate() * 100.0 << "%"
+	          << std::setw(9) << r.appMissRate() * 100.0 << "%" << std::setw(14) << r.latencyMs()
+	          << std::setw(16) << r.compWasteMs() << std::setw(15) << r.appWasteMs() << std::endl;
+}
+
+bool
+loadTrace(const char *path, std::vector<FrameTimes> &out_trace)
+{
+	std::ifstream file(path);
+	double cpu_ms = 0.0;
+	double gpu_ms = 0.0;
+	while (file >> cpu_ms >> gpu_ms) {
+		out_trace.push_back({(uint64_t)(cpu_ms * (double)kMs), (uint64_t)(gpu_ms * (double)kMs)});
+	}
+	return !out_trace.empty();
+}
+
+} // namespace
+
+
+TEST_CASE("pacing_sim_deterministic")
+{
+	std::vector<Scenario> scenarios = makeScenarios();
+	std::vector<PacingConfig> configs = makeConfigs();
+
+	SimResult a = simulate(scenarios[2], configs[1]);
+	SimResult b = simulate(scenarios[2], configs[1]);
+
+	CHECK(a.comp_missed == b.comp_missed);
+	CHECK(a.app_late == b.app_late);
+	CHECK(a.app_dropped == b.app_dropped);
+	CHECK(a.latency_sum_ns == b.latency_sum_ns);
+	CHECK(a.comp_waste_sum_ns == b.comp_waste_sum_ns);
+}
+
+TEST_CASE("pacing_sim_report")
+{
+	std::vector<Scenario> scenarios = makeScenarios();
+	std::vector<PacingConfig> configs = makeConfigs();
+
+	printHeader();
+	for (const Scenario &scenario : scenarios) {
+		for (const PacingConfig &config : configs) {
+			SimResult r = simulate(scenario, config);
+			printResult(scenario, config, r);
+
+			INFO(scenario.name << " with " << config.name);
+			CHECK(r.comp_frames == kFrameCount - kWarmupFrames);
+			CHECK(r.app_frames > 0);
+
+			// Latency can never be below the time the app itself takes.
+			CHECK(r.latencyMs() > 0.0);
+		}
+	}
+}
+
+TEST_CASE("pacing_sim_regressions")
+{
+	std::vector<Scenario> scenarios = makeScenarios();
+	std::vector<PacingConfig> configs = makeConfigs();
+
+	const PacingConfig &display_timing = configs[1];
+
+	SECTION("light app never misses")
+	{
+		SimResult r = simulate(scenarios[0], display_timing);
+		CHECK(r.comp_missed == 0);
+		CHECK(r.app_late + r.app_dropped == 0);
+	}
+
+	SECTION("jittery vsync rarely misses")
+	{
+		SimResult r = simulate(scenarios[1], display_timing);
+		CHECK(r.compMissRate() < 0.01);
+		CHECK(r.appMissRate() < 0.05);
+	}
+
+	SECTION("gpu spikes are absorbed")
+	{
+		SimResult r = simulate(scenarios[2], display_timing);
+		CHECK(r.compMissRate() < 0.05);
+		CHECK(r.appMissRate() < 0.05);
+	}
+
+	SECTION("heavy app keeps latency under two periods")
+	{
+		SimResult r = simulate(scenarios[3], display_timing);
+		CHECK(r.appMissRate() < 0.02);
+		CHECK(r.latencyMs() < 2.0 * (double)kPeriodNs / (double)kMs);
+	}
+}
+
+TEST_CASE("pacing_sim_recorded_trace")
+{
+	const char *path = getenv("PACING_SIM_TRACE");
+	if (path == nullptr) {
+		return;
+	}
+
+	std::vector<FrameTimes> trace;
+	REQUIRE(loadTrace(path, trace));
+
+	Scenario scenario{"recorded", 200 * kUs, {}, lightComp()};
+	scenario.app.trace = trace;
+
+	printHeader();
+	for (const PacingConfig &config : makeConfigs()) {
+		printResult(scenario, config, simulate(scenario, config));
+	}
+}
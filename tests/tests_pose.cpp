@@ -66,3 +66,140 @@ TEST_CASE("Pose interpolation works")
 	CHECK(res.orientation.y == Approx(0).margin(e));
 	CHECK(res.orientation.w == Approx(1).margin(e));
 }
+
+
+/*
+ *
+ * Plain scalar reference implementations to check the library against.
+ *
+ */
+
+static xrt_vec3
+reference_cross(const xrt_vec3 &a, const xrt_vec3 &b)
+{
+	return xrt_vec3{a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+static xrt_vec3
+reference_rotate(const xrt_quat &q, const xrt_vec3 &v)
+{
+	// v + 2 * w * (q x v) + 2 * q x (q x v)
+	xrt_vec3 u = {q.x, q.y, q.z};
+	xrt_vec3 t = reference_cross(u, v) * 2.0f;
+	return v + t * q.w + reference_cross(u, t);
+}
+
+static xrt_quat
+reference_quat_mul(const xrt_quat &a, const xrt_quat &b)
+{
+	return xrt_quat{
+	    a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+	    a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+	    a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+	    a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+	};
+}
+
+static xrt_pose
+reference_transform(const xrt_pose &transform, const xrt_pose &pose)
+{
+	xrt_pose ret;
+	ret.orientation = reference_quat_mul(transform.orientation, pose.orientation);
+	ret.position = reference_rotate(transform.orientation, pose.position) + transform.position;
+	return ret;
+}
+
+static xrt_pose
+make_pose(uint32_t i)
+{
+	xrt_pose pose = {
+	    {(float)i, 1.0f, -2.0f, 0.5f + (float)(i % 3)},
+	    {(float)i * 0.1f, -1.0f, (float)i * -0.3f},
+	};
+	math_quat_normalize(&pose.orientation);
+	return pose;
+}
+
+static void
+check_vec3(const xrt_vec3 &a, const xrt_vec3 &b)
+{
+	CHECK(a.x == Approx(b.x).margin(0.0001f));
+	CHECK(a.y == Approx(b.y).margin(0.0001f));
+	CHECK(a.z == Approx(b.z).margin(0.0001f));
+}
+
+static void
+check_pose(const xrt_pose &a, const xrt_pose &b)
+{
+	check_vec3(a.position, b.position);
+	CHECK(a.orientation.x == Approx(b.orientation.x).margin(0.0001f));
+	CHECK(a.orientation.y == Approx(b.orientation.y).margin(0.0001f));
+	CHECK(a.orientation.z == Approx(b.orientation.z).margin(0.0001f));
+	CHECK(a.orientation.w == Approx(b.orientation.w).margin(0.0001f));
+}
+
+TEST_CASE("Pose transform matches reference")
+{
+	constexpr uint32_t count = 26; // Same as hand joints.
+	const xrt_pose transform = make_pose(7);
+
+	xrt_pose poses[count];
+	xrt_vec3 points[count];
+	for (uint32_t i = 0; i < count; i++) {
+		poses[i] = make_pose(i);
+		points[i] = poses[i].position;
+	}
+
+	SECTION("Single")
+	{
+		for (uint32_t i = 0; i < count; i++) {
+			xrt_pose pose;
+			math_pose_transform(&transform, &poses[i], &pose);
+			check_pose(pose, reference_transform(transform, poses[i]));
+
+			xrt_vec3 point;
+			math_pose_transform_point(&transform, &points[i], &point);
+			check_vec3(point, reference_rotate(transform.orientation, points[i]) + transform.position);
+
+			xrt_vec3 rotated;
+			math_quat_rotate_vec3(&transform.orientation, &points[i], &rotated);
+			check_vec3(rotated, reference_rotate(transform.orientation, points[i]));
+		}
+	}
+
+	SECTION("Batch")
+	{
+		xrt_pose out_poses[count];
+		xrt_vec3 out_points[count];
+		math_pose_transform_many(&transform, poses, count, out_poses);
+		math_pose_transform_points(&transform, points, count, out_points);
+
+		for (uint32_t i = 0; i < count; i++) {
+			xrt_vec3 expected = reference_rotate(transform.orientation, points[i]) + transform.position;
+			check_pose(out_poses[i], reference_transform(transform, poses[i]));
+			check_vec3(out_points[i], expected);
+		}
+	}
+
+	SECTION("Batch in place")
+	{
+		xrt_pose expected_poses[count];
+		xrt_vec3 expected_points[count];
+		for (uint32_t i = 0; i < count; i++) {
+			expected_poses[i] = reference_transform(transform, poses[i]);
+			expected_points[i] = reference_rotate(transform.orientation, points[i]) + transform.position;
+		}
+
+		math_pose_transform_many(&transform, poses, count, poses);
+		math_pose_transform_points(&transform, points, count, points);
+
+		for (uint32_t i = 0; i < count; i++) {
+			check_pose(poses[i], expected_poses[i]);
+			check_vec3(points[i], expected_points[i]);
+		}
+
+		// Nothing to do is fine.
+		math_pose_transform_many(&transform, NULL, 0, NULL);
+		math_pose_transform_points(&transform, NULL, 0, NULL);
+	}
+}
@@ -0,0 +1,236 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Relation history tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <math/m_relation_history.h>
+#include <xrt/xrt_compiler.h>
+#include <util/u_time.h>
+
+#include "catch/catch.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+
+using xrt::auxiliary::math::RelationHistory;
+
+static xrt_space_relation
+make_relation(float x)
+{
+	xrt_space_relation rel = {};
+	rel.relation_flags = (enum xrt_space_relation_flags)(XRT_SPACE_RELATION_POSITION_VALID_BIT |
+	                                                     XRT_SPACE_RELATION_ORIENTATION_VALID_BIT);
+	rel.pose.orientation.w = 1.0f;
+	rel.pose.position.x = x;
+	return rel;
+}
+
+
+TEST_CASE("m_relation_history")
+{
+	RelationHistory rh;
+	xrt_space_relation out = {};
+
+	SECTION("empty")
+	{
+		CHECK(rh.size() == 0);
+		CHECK(rh.get(1000, &out) == M_RELATION_HISTORY_RESULT_INVALID);
+
+		uint64_t ts = 0;
+		CHECK_FALSE(rh.get_latest(&ts, &out));
+	}
+
+	SECTION("lookups")
+	{
+		CHECK(rh.push(make_relation(1.0f), 1000));
+		CHECK(rh.push(make_relation(2.0f), 2000));
+		CHECK(rh.push(make_relation(3.0f), 3000));
+
+		// Not monotonic.
+		CHECK_FALSE(rh.push(make_relation(4.0f), 3000));
+		CHECK_FALSE(rh.push(make_relation(4.0f), 500));
+		CHECK(rh.size() == 3);
+
+		CHECK(rh.get(0, &out) == M_RELATION_HISTORY_RESULT_INVALID);
+
+		CHECK(rh.get(2000, &out) == M_RELATION_HISTORY_RESULT_EXACT);
+		CHECK(out.pose.position.x == 2.0f);
+
+		CHECK(rh.get(2500, &out) == M_RELATION_HISTORY_RESULT_INTERPOLATED);
+		CHECK(out.pose.position.x == Approx(2.5f));
+
+		CHECK(rh.get(4000, &out) == M_RELATION_HISTORY_RESULT_PREDICTED);
+		CHECK(out.pose.position.x == Approx(3.0f));
+
+		CHECK(rh.get(100, &out) == M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED);
+		CHECK(out.pose.position.x == Approx(1.0f));
+
+		uint64_t ts = 0;
+		CHECK(rh.get_latest(&ts, &out));
+		CHECK(ts == 3000);
+		CHECK(out.pose.position.x == 3.0f);
+
+		rh.clear();
+		CHECK(rh.size() == 0);
+		CHECK(rh.get(2000, &out) == M_RELATION_HISTORY_RESULT_INVALID);
+
+		// Older timestamps are fine after a clear.
+		CHECK(rh.push(make_relation(5.0f), 10));
+		CHECK(rh.get(10, &out) == M_RELATION_HISTORY_RESULT_EXACT);
+		CHECK(out.pose.position.x == 5.0f);
+	}
+
+	SECTION("get many")
+	{
+		for (uint64_t i = 1; i <= 100; i++) {
+			rh.push(make_relation((float)i), i * 10);
+		}
+
+		// Increasing, decreasing, invalid, out of the range and more than one chunk worth.
+		uint64_t timestamps[40] = {5, 10, 15, 500, 1000, 2000, 995, 20, 0, 30};
+		for (uint32_t i = 10; i < ARRAY_SIZE(timestamps); i++) {
+			timestamps[i] = 1000 - i * 7;
+		}
+
+		xrt_space_relation many[ARRAY_SIZE(timestamps)] = {};
+		m_relation_history_result results[ARRAY_SIZE(timestamps)] = {};
+		rh.get_many(timestamps, ARRAY_SIZE(timestamps), many, results);
+
+		for (uint32_t i = 0; i < ARRAY_SIZE(timestamps); i++) {
+			xrt_space_relation single = {};
+			CHECK(results[i] == rh.get(timestamps[i], &single));
+			CHECK(many[i].relation_flags == single.relation_flags);
+			CHECK(many[i].pose.position.x == Approx(single.pose.position.x));
+		}
+
+		CHECK(results[0] == M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED);
+		CHECK(results[1] == M_RELATION_HISTORY_RESULT_EXACT);
+		CHECK(results[2] == M_RELATION_HISTORY_RESULT_INTERPOLATED);
+		CHECK(results[5] == M_RELATION_HISTORY_RESULT_PREDICTED);
+		CHECK(results[8] == M_RELATION_HISTORY_RESULT_INVALID);
+
+		// The results are optional.
+		rh.get_many(timestamps, 3, many);
+		CHECK(many[2].pose.position.x == Approx(1.5f));
+	}
+
+	SECTION("angular acceleration prediction")
+	{
+		// Spinning up around Y, 10 rad/s^2.
+		for (uint64_t i = 0; i <= 10; i++) {
+			xrt_space_relation rel = make_relation(0.0f);
+			int flags = rel.relation_flags | XRT_SPACE_RELATION_ANGULAR_VELOCITY_VALID_BIT;
+			rel.relation_flags = (enum xrt_space_relation_flags)flags;
+			rel.angular_velocity.y = 0.01f * (float)i;
+			rh.push(rel, (i + 1) * U_TIME_1MS_IN_NS);
+		}
+
+		const uint64_t at_ns = 61 * U_TIME_1MS_IN_NS;
+		xrt_space_relation constant = {};
+		CHECK(rh.get(at_ns, &constant) == M_RELATION_HISTORY_RESULT_PREDICTED);
+		CHECK(constant.angular_velocity.y == Approx(0.1f));
+
+		m_relation_history_prediction pred = {};
+		pred.angular_acceleration = true;
+		pred.damping = 0.0f;
+		pred.window_ms = 5.0f;
+		rh.set_prediction(pred);
+
+		xrt_space_relation accel = {};
+		CHECK(rh.get(at_ns, &accel) == M_RELATION_HISTORY_RESULT_PREDICTED);
+		CHECK(accel.angular_velocity.y == Approx(0.1f + 10.0f * 0.05f));
+
+		// Damping keeps it speeding up less.
+		pred.damping = 20.0f;
+		rh.set_prediction(pred);
+
+		xrt_space_relation damped = {};
+		CHECK(rh.get(at_ns, &damped) == M_RELATION_HISTORY_RESULT_PREDICTED);
+		CHECK(damped.angular_velocity.y > constant.angular_velocity.y);
+		CHECK(damped.angular_velocity.y < accel.angular_velocity.y);
+		CHECK(damped.angular_velocity.y == Approx(0.1f + 10.0f * (1.0f - expf(-1.0f)) / 20.0f));
+
+		// Interpolation is not affected.
+		CHECK(rh.get(5500000, &out) == M_RELATION_HISTORY_RESULT_INTERPOLATED);
+		CHECK(out.angular_velocity.y == Approx(0.045f));
+	}
+
+	SECTION("push many")
+	{
+		CHECK(rh.push(make_relation(1.0f), 1000));
+
+		// The one at 1000 is already there and 2500 is out of order.
+		xrt_space_relation relations[] = {make_relation(1.0f), make_relation(2.0f), make_relation(3.0f),
+		                                  make_relation(2.5f), make_relation(4.0f)};
+		uint64_t timestamps[] = {1000, 2000, 3000, 2500, 4000};
+		static_assert(ARRAY_SIZE(relations) == ARRAY_SIZE(timestamps));
+
+		CHECK(rh.push_many(relations, timestamps, ARRAY_SIZE(timestamps)) == 3);
+		CHECK(rh.size() == 4);
+
+		CHECK(rh.get(3000, &out) == M_RELATION_HISTORY_RESULT_EXACT);
+		CHECK(out.pose.position.x == 3.0f);
+		CHECK(rh.get(2500, &out) == M_RELATION_HISTORY_RESULT_INTERPOLATED);
+		CHECK(out.pose.position.x == Approx(2.5f));
+
+		uint64_t ts = 0;
+		CHECK(rh.get_latest(&ts, &out));
+		CHECK(ts == 4000);
+
+		CHECK(rh.push_many(relations, timestamps, 0) == 0);
+		CHECK(rh.size() == 4);
+	}
+
+	SECTION("wraps around")
+	{
+		constexpr uint64_t count = 10000;
+		for (uint64_t i = 1; i <= count; i++) {
+			rh.push(make_relation((float)i), i * 10);
+		}
+
+		size_t size = rh.size();
+		CHECK(size < count);
+
+		CHECK(rh.get(count * 10, &out) == M_RELATION_HISTORY_RESULT_EXACT);
+		CHECK(out.pose.position.x == (float)count);
+
+		// The oldest ones have been dropped.
+		CHECK(rh.get(10, &out) == M_RELATION_HISTORY_RESULT_REVERSE_PREDICTED);
+		CHECK(out.pose.position.x == (float)(count - size + 1));
+	}
+
+	SECTION("concurrent reader")
+	{
+		std::atomic<bool> done{false};
+		std::atomic<uint32_t> bad{0};
+
+		// The position always matches the timestamp, torn reads would break that.
+		std::thread reader([&]() {
+			while (!done.load()) {
+				xrt_space_relation rel = {};
+				uint64_t ts = 0;
+				if (rh.get_latest(&ts, &rel) && rel.pose.position.x != (float)ts) {
+					bad++;
+				}
+				m_relation_history_result res = rh.get(ts, &rel);
+				if (res == M_RELATION_HISTORY_RESULT_EXACT && rel.pose.position.x != (float)ts) {
+					bad++;
+				}
+			}
+		});
+
+		for (uint64_t i = 1; i <= 20000; i++) {
+			rh.push(make_relation((float)i), i);
+		}
+
+		done = true;
+		reader.join();
+
+		CHECK(bad.load() == 0);
+	}
+}
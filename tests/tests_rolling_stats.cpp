@@ -0,0 +1,59 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Rolling stats tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_rolling_stats.h>
+
+#include "catch/catch.hpp"
+
+
+TEST_CASE("u_rolling_stats")
+{
+	struct u_rolling_stats_ns urs = {};
+
+	SECTION("empty")
+	{
+		CHECK(u_rs_ns_get_percentile(&urs, 50.0f) == 0);
+		CHECK(u_rs_ns_get_percentile(&urs, 99.0f) == 0);
+	}
+
+	SECTION("percentiles")
+	{
+		// Add 100 to 1 in reverse so order doesn't help.
+		for (uint64_t i = 100; i > 0; i--) {
+			u_rs_ns_add(&urs, i);
+		}
+
+		CHECK(urs.value_count == 100);
+		CHECK(u_rs_ns_get_percentile(&urs, 0.0f) == 1);
+		CHECK(u_rs_ns_get_percentile(&urs, 50.0f) == 50);
+		CHECK(u_rs_ns_get_percentile(&urs, 99.0f) == 99);
+		CHECK(u_rs_ns_get_percentile(&urs, 100.0f) == 100);
+
+		// Out of range is clamped.
+		CHECK(u_rs_ns_get_percentile(&urs, -1.0f) == 1);
+		CHECK(u_rs_ns_get_percentile(&urs, 200.0f) == 100);
+	}
+
+	SECTION("spike falls out of the window")
+	{
+		u_rs_ns_add(&urs, 1000000);
+		for (uint32_t i = 0; i < U_ROLLING_STATS_VALUE_COUNT - 1; i++) {
+			u_rs_ns_add(&urs, 10);
+		}
+
+		CHECK(urs.value_count == U_ROLLING_STATS_VALUE_COUNT);
+		CHECK(u_rs_ns_get_percentile(&urs, 99.0f) == 10);
+		CHECK(u_rs_ns_get_percentile(&urs, 100.0f) == 1000000);
+
+		// Pushes out the spike.
+		u_rs_ns_add(&urs, 20);
+		CHECK(urs.value_count == U_ROLLING_STATS_VALUE_COUNT);
+		CHECK(u_rs_ns_get_percentile(&urs, 100.0f) == 20);
+		CHECK(u_rs_ns_get_percentile(&urs, 50.0f) == 10);
+	}
+}
@@ -0,0 +1,139 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Force genlock sink matching tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_sink.h>
+#include <util/u_time.h>
+#include <util/u_frame.h>
+
+#include "catch/catch.hpp"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+struct recording_sink
+{
+	struct xrt_frame_sink base = {};
+
+	std::mutex mutex;
+	std::vector<uint64_t> sources;
+
+	recording_sink()
+	{
+		base.push_frame = push;
+	}
+
+	static void
+	push(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+	{
+		recording_sink *s = reinterpret_cast<recording_sink *>(xfs);
+
+		std::unique_lock<std::mutex> lock(s->mutex);
+		s->sources.push_back(xf->source_sequence);
+	}
+
+	size_t
+	wait_count(size_t count)
+	{
+		for (int i = 0; i < 1000; i++) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				if (sources.size() >= count) {
+					return sources.size();
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		std::unique_lock<std::mutex> lock(mutex);
+		return sources.size();
+	}
+};
+
+void
+push_frame(struct xrt_frame_sink *xfs, int64_t timestamp_us, uint64_t sequence)
+{
+	struct xrt_frame *xf = NULL;
+	u_frame_create_one_off(XRT_FORMAT_L8, 4, 4, &xf);
+	REQUIRE(xf != NULL);
+	xf->timestamp = timestamp_us * U_TIME_1MS_IN_NS / 1000;
+	xf->source_sequence = sequence;
+	xfs->push_frame(xfs, xf);
+	xrt_frame_reference(&xf, NULL);
+}
+
+} // namespace
+
+
+TEST_CASE("u_sink_force_genlock")
+{
+	struct xrt_frame_context xfctx = {};
+	recording_sink left;
+	recording_sink right;
+	struct xrt_frame_sink *in_left = NULL;
+	struct xrt_frame_sink *in_right = NULL;
+
+	REQUIRE(u_sink_force_genlock_create(&xfctx, &left.base, &right.base, &in_left, &in_right));
+
+	SECTION("pairs in any order")
+	{
+		push_frame(in_left, 10000, 1);
+		push_frame(in_right, 10200, 2);
+		CHECK(left.wait_count(1) == 1);
+
+		push_frame(in_right, 20000, 4);
+		push_frame(in_left, 19500, 3);
+		CHECK(right.wait_count(2) == 2);
+
+		CHECK(left.sources == std::vector<uint64_t>{1, 3});
+		CHECK(right.sources == std::vector<uint64_t>{2, 4});
+	}
+
+	SECTION("nearest frame within the window is picked")
+	{
+		// Several left frames queue up while the right side is behind.
+		push_frame(in_left, 10000, 1);
+		push_frame(in_left, 20000, 2);
+		push_frame(in_left, 30000, 3);
+		push_frame(in_right, 20300, 10);
+		CHECK(right.wait_count(1) == 1);
+
+		CHECK(left.sources == std::vector<uint64_t>{2});
+		CHECK(right.sources == std::vector<uint64_t>{10});
+
+		// Left frame 3 is still waiting.
+		push_frame(in_right, 30900, 11);
+		CHECK(right.wait_count(2) == 2);
+		CHECK(left.sources == std::vector<uint64_t>{2, 3});
+	}
+
+	SECTION("no match outside the window and late frames are dropped")
+	{
+		push_frame(in_left, 10000, 1);
+		push_frame(in_right, 15000, 2);
+
+		push_frame(in_left, 20000, 3);
+		push_frame(in_right, 20500, 4);
+		CHECK(left.wait_count(1) == 1);
+
+		// Older than the matched pair, would otherwise match right 2.
+		push_frame(in_left, 15000, 5);
+
+		push_frame(in_left, 30000, 6);
+		push_frame(in_right, 30000, 7);
+		CHECK(left.wait_count(2) == 2);
+
+		CHECK(left.sources == std::vector<uint64_t>{3, 6});
+		CHECK(right.sources == std::vector<uint64_t>{4, 7});
+	}
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+}
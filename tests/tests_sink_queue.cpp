@@ -0,0 +1,172 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Sink queue drop policy tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_sink.h>
+#include <util/u_frame.h>
+
+#include "catch/catch.hpp"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+/*!
+ * Blocks in the first push until released, so the test can fill the queue
+ * while the consumer is busy.
+ */
+struct blocking_sink
+{
+	struct xrt_frame_sink base = {};
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool busy = false;
+	bool released = false;
+	std::vector<int64_t> timestamps;
+
+	blocking_sink()
+	{
+		base.push_frame = push;
+	}
+
+	static void
+	push(struct xrt_frame_sink *xfs, struct xrt_frame *xf)
+	{
+		blocking_sink *s = reinterpret_cast<blocking_sink *>(xfs);
+
+		std::unique_lock<std::mutex> lock(s->mutex);
+		s->timestamps.push_back(xf->timestamp);
+		s->busy = true;
+		s->cond.notify_all();
+		s->cond.wait(lock, [s] { return s->released; });
+	}
+
+	void
+	wait_busy()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait(lock, [this] { return busy; });
+	}
+
+	void
+	release()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		released = true;
+		cond.notify_all();
+	}
+
+	size_t
+	wait_count(size_t count)
+	{
+		// The queue thread keeps going after the release, poll for it.
+		for (int i = 0; i < 1000; i++) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				if (timestamps.size() >= count) {
+					return timestamps.size();
+				}
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		std::unique_lock<std::mutex> lock(mutex);
+		return timestamps.size();
+	}
+};
+
+void
+push_frame(struct xrt_frame_sink *xfs, int64_t timestamp)
+{
+	struct xrt_frame *xf = NULL;
+	u_frame_create_one_off(XRT_FORMAT_L8, 4, 4, &xf);
+	REQUIRE(xf != NULL);
+	xf->timestamp = timestamp;
+	xfs->push_frame(xfs, xf);
+	xrt_frame_reference(&xf, NULL);
+}
+
+std::vector<int64_t>
+run_queue(enum u_sink_queue_drop_policy policy, bool use_shared_pool)
+{
+	struct xrt_frame_context xfctx = {};
+	blocking_sink sink;
+	struct xrt_frame_sink *queue = NULL;
+
+	struct u_sink_queue_params params = {};
+	params.max_size = 2;
+	params.drop_policy = policy;
+	params.name = "Test Queue";
+	params.use_shared_pool = use_shared_pool;
+	REQUIRE(u_sink_queue_create_with_params(&xfctx, &params, &sink.base, &queue));
+
+	// The consumer holds on to the first frame, so the rest are queued.
+	push_frame(queue, 1);
+	sink.wait_busy();
+	for (int64_t i = 2; i <= 5; i++) {
+		push_frame(queue, i);
+	}
+
+	sink.release();
+	CHECK(sink.wait_count(3) == 3);
+
+	xrt_frame_context_destroy_nodes(&xfctx);
+
+	return sink.timestamps;
+}
+
+} // namespace
+
+
+TEST_CASE("u_sink_queue")
+{
+	bool use_shared_pool = GENERATE(false, true);
+	INFO("Shared pool " << use_shared_pool);
+
+	SECTION("drop newest keeps the first queued frames")
+	{
+		std::vector<int64_t> expected = {1, 2, 3};
+		CHECK(run_queue(U_SINK_QUEUE_DROP_NEWEST, use_shared_pool) == expected);
+	}
+
+	SECTION("drop oldest keeps the last queued frames")
+	{
+		std::vector<int64_t> expected = {1, 4, 5};
+		CHECK(run_queue(U_SINK_QUEUE_DROP_OLDEST, use_shared_pool) == expected);
+	}
+
+	SECTION("unbounded queues keep the order")
+	{
+		struct xrt_frame_context xfctx = {};
+		blocking_sink sink;
+		sink.released = true;
+
+		struct u_sink_queue_params params = {};
+		params.use_shared_pool = use_shared_pool;
+
+		// Several queues so that the tasks of the shared pool interleave.
+		std::vector<struct xrt_frame_sink *> queues(4);
+		for (struct xrt_frame_sink *&queue : queues) {
+			REQUIRE(u_sink_queue_create_with_params(&xfctx, &params, &sink.base, &queue));
+		}
+
+		std::vector<int64_t> expected;
+		for (int64_t i = 0; i < 100; i++) {
+			push_frame(queues[0], i);
+			expected.push_back(i);
+		}
+
+		CHECK(sink.wait_count(100) == 100);
+		xrt_frame_context_destroy_nodes(&xfctx);
+
+		CHECK(sink.timestamps == expected);
+	}
+}
@@ -0,0 +1,169 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Test u_arena and the small vector and deque.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include "catch/catch.hpp"
+#include "util/u_arena.h"
+#include "util/u_small_containers.h"
+
+#include <stdint.h>
+
+
+U_SMALL_VECTOR_DECLARATION(int, int, 4)
+U_SMALL_DEQUE_DECLARATION(int, int, 4)
+
+
+TEST_CASE("u_arena")
+{
+	struct u_arena arena;
+	u_arena_init(&arena, 256);
+
+	SECTION("Allocations are aligned and distinct")
+	{
+		uint8_t *a = (uint8_t *)u_arena_alloc(&arena, 3);
+		uint8_t *b = (uint8_t *)u_arena_alloc(&arena, 17);
+		REQUIRE(a != NULL);
+		REQUIRE(b != NULL);
+		CHECK((uintptr_t)a % U_ARENA_ALIGNMENT == 0);
+		CHECK((uintptr_t)b % U_ARENA_ALIGNMENT == 0);
+		CHECK(b >= a + 3);
+	}
+
+	SECTION("Reset reuses the memory")
+	{
+		void *first = u_arena_alloc(&arena, 64);
+		u_arena_reset(&arena);
+		CHECK(u_arena_alloc(&arena, 64) == first);
+	}
+
+	SECTION("Larger than block size and coalescing")
+	{
+		int *big = U_ARENA_ALLOC_ARRAY(&arena, int, 1000);
+		REQUIRE(big != NULL);
+		big[999] = 42;
+		CHECK(U_ARENA_ALLOC_ARRAY(&arena, int, 1000) != NULL);
+
+		// After a reset everything fits in one block.
+		u_arena_reset(&arena);
+		uint8_t *a = (uint8_t *)U_ARENA_ALLOC_ARRAY(&arena, int, 1000);
+		uint8_t *b = (uint8_t *)U_ARENA_ALLOC_ARRAY(&arena, int, 1000);
+		CHECK(b == a + sizeof(int) * 1000);
+	}
+
+	u_arena_fini(&arena);
+}
+
+TEST_CASE("u_small_vector")
+{
+	struct u_arena arena;
+	u_arena_init(&arena, 256);
+
+	struct u_small_vector_int v;
+	bool use_arena = GENERATE(false, true);
+	u_small_vector_int_init(&v, use_arena ? &arena : NULL);
+
+	SECTION("Inline storage")
+	{
+		for (int i = 0; i < 4; i++) {
+			CHECK(u_small_vector_int_push_back(&v, i));
+		}
+		CHECK(v.heap == NULL);
+		CHECK(u_small_vector_int_data(&v) == v.storage);
+		CHECK(u_small_vector_int_size(&v) == 4);
+		CHECK(u_small_vector_int_at(&v, 3) == 3);
+	}
+
+	SECTION("Grow past inline storage")
+	{
+		for (int i = 0; i < 100; i++) {
+			CHECK(u_small_vector_int_push_back(&v, i));
+		}
+		CHECK(v.heap != NULL);
+		CHECK(u_small_vector_int_size(&v) == 100);
+		for (int i = 0; i < 100; i++) {
+			CHECK(u_small_vector_int_at(&v, i) == i);
+		}
+	}
+
+	SECTION("Batch push and clear keeps the memory")
+	{
+		int values[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+		CHECK(u_small_vector_int_push_back_n(&v, values, 10));
+		CHECK(u_small_vector_int_push_back_n(&v, values, 10));
+		CHECK(u_small_vector_int_size(&v) == 20);
+		CHECK(u_small_vector_int_at(&v, 19) == 9);
+
+		int *data = u_small_vector_int_data(&v);
+		size_t capacity = v.capacity;
+
+		u_small_vector_int_clear(&v);
+		CHECK(u_small_vector_int_size(&v) == 0);
+		CHECK(u_small_vector_int_push_back_n(&v, values, 10));
+		CHECK(u_small_vector_int_data(&v) == data);
+		CHECK(v.capacity == capacity);
+	}
+
+	u_small_vector_int_fini(&v);
+	CHECK(v.heap == NULL);
+	CHECK(u_small_vector_int_size(&v) == 0);
+
+	u_arena_fini(&arena);
+}
+
+TEST_CASE("u_small_deque")
+{
+	struct u_arena arena;
+	u_arena_init(&arena, 256);
+
+	struct u_small_deque_int d;
+	bool use_arena = GENERATE(false, true);
+	u_small_deque_int_init(&d, use_arena ? &arena : NULL);
+
+	int elem = -1;
+	CHECK(!u_small_deque_int_pop_front(&d, &elem));
+	CHECK(elem == -1);
+
+	SECTION("Wraps around in inline storage")
+	{
+		for (int i = 0; i < 20; i++) {
+			CHECK(u_small_deque_int_push_back(&d, i));
+			CHECK(u_small_deque_int_push_back(&d, i + 100));
+			CHECK(u_small_deque_int_pop_front(&d, &elem));
+			CHECK(elem == i);
+			CHECK(u_small_deque_int_at(&d, 0) == i + 100);
+			CHECK(u_small_deque_int_pop_front(&d, &elem));
+			CHECK(elem == i + 100);
+		}
+		CHECK(d.heap == NULL);
+		CHECK(u_small_deque_int_size(&d) == 0);
+	}
+
+	SECTION("Grow while wrapped keeps order")
+	{
+		int values[3] = {1, 2, 3};
+		CHECK(u_small_deque_int_push_back_n(&d, values, 3));
+		CHECK(u_small_deque_int_pop_front(&d, &elem));
+		CHECK(u_small_deque_int_pop_front(&d, &elem));
+
+		// Head is now at 2, this wraps and then grows.
+		for (int i = 4; i < 50; i++) {
+			CHECK(u_small_deque_int_push_back(&d, i));
+		}
+		CHECK(d.heap != NULL);
+		CHECK(u_small_deque_int_size(&d) == 47);
+		for (size_t i = 0; i < 47; i++) {
+			CHECK(u_small_deque_int_at(&d, i) == (int)i + 3);
+		}
+
+		u_small_deque_int_clear(&d);
+		CHECK(u_small_deque_int_size(&d) == 0);
+		CHECK(!u_small_deque_int_pop_front(&d, &elem));
+	}
+
+	u_small_deque_int_fini(&d);
+	u_arena_fini(&arena);
+}
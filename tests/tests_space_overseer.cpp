@@ -0,0 +1,235 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Test u_space_overseer locate functions.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include "xrt/xrt_space.h"
+
+#include "math/m_api.h"
+#include "math/m_space.h"
+
+#include "util/u_space_overseer.h"
+
+#include "catch/catch.hpp"
+
+
+/*
+ *
+ * Constants
+ *
+ */
+
+constexpr xrt_pose kPoseIdentity = XRT_POSE_IDENTITY;
+
+constexpr xrt_pose kPoseOneY = {
+    XRT_QUAT_IDENTITY,
+    {0.0f, 1.0f, 0.0f},
+};
+
+constexpr xrt_pose kPoseTwoX = {
+    XRT_QUAT_IDENTITY,
+    {2.0f, 0.0f, 0.0f},
+};
+
+constexpr xrt_pose kPoseTurnedThreeZ = {
+    {0.0f, 0.70710678f, 0.0f, 0.70710678f},
+    {0.0f, 0.0f, 3.0f},
+};
+
+constexpr uint64_t kTimestamp = 1000;
+
+
+/*
+ *
+ * Helpers
+ *
+ */
+
+static void
+check_relations_equal(const xrt_space_relation &a, const xrt_space_relation &b)
+{
+	CHECK(a.relation_flags == b.relation_flags);
+	CHECK(a.pose.position.x == Approx(b.pose.position.x));
+	CHECK(a.pose.position.y == Approx(b.pose.position.y));
+	CHECK(a.pose.position.z == Approx(b.pose.position.z));
+	CHECK(a.pose.orientation.x == Approx(b.pose.orientation.x));
+	CHECK(a.pose.orientation.y == Approx(b.pose.orientation.y));
+	CHECK(a.pose.orientation.z == Approx(b.pose.orientation.z));
+	CHECK(a.pose.orientation.w == Approx(b.pose.orientation.w));
+}
+
+
+/*
+ *
+ * Tests
+ *
+ */
+
+TEST_CASE("SpaceOverseerLocateSpaces")
+{
+	struct u_space_overseer *uso = u_space_overseer_create(NULL);
+	struct xrt_space_overseer *xso = (struct xrt_space_overseer *)uso;
+	REQUIRE(xso->semantic.root != NULL);
+
+	struct xrt_space *one_y = NULL;
+	struct xrt_space *two_x = NULL;
+	struct xrt_space *turned = NULL;
+	REQUIRE(xrt_space_overseer_create_offset_space(xso, xso->semantic.root, &kPoseOneY, &one_y) == XRT_SUCCESS);
+	REQUIRE(xrt_space_overseer_create_offset_space(xso, xso->semantic.root, &kPoseTwoX, &two_x) == XRT_SUCCESS);
+	REQUIRE(xrt_space_overseer_create_offset_space(xso, one_y, &kPoseTurnedThreeZ, &turned) == XRT_SUCCESS);
+
+	struct xrt_space *spaces[] = {one_y, two_x, turned, one_y};
+	const struct xrt_pose offsets[] = {kPoseIdentity, kPoseOneY, kPoseTwoX, kPoseTurnedThreeZ};
+	constexpr uint32_t count = ARRAY_SIZE(spaces);
+
+	SECTION("Matches locate_space")
+	{
+		struct xrt_space *bases[] = {xso->semantic.root, one_y, turned};
+
+		for (struct xrt_space *base : bases) {
+			struct xrt_space_relation batched[count] = {};
+			xrt_result_t xret = xrt_space_overseer_locate_spaces( //
+			    xso,                                              //
+			    base,                                             //
+			    &kPoseOneY,                                       //
+			    kTimestamp,                                       //
+			    spaces,                                           //
+			    count,                                            //
+			    offsets,                                          //
+			    batched);                                         //
+			REQUIRE(xret == XRT_SUCCESS);
+
+			for (uint32_t i = 0; i < count; i++) {
+				struct xrt_space_relation single = XRT_SPACE_RELATION_ZERO;
+				xret = xrt_space_overseer_locate_space( //
+				    xso,                                //
+				    base,                               //
+				    &kPoseOneY,                         //
+				    kTimestamp,                         //
+				    spaces[i],                          //
+				    &offsets[i],                        //
+				    &single);                           //
+				REQUIRE(xret == XRT_SUCCESS);
+
+				check_relations_equal(batched[i], single);
+			}
+		}
+	}
+
+	SECTION("Known values")
+	{
+		struct xrt_space_relation batched[count] = {};
+		xrt_result_t xret = xrt_space_overseer_locate_spaces( //
+		    xso,                                              //
+		    two_x,                                            //
+		    &kPoseIdentity,                                   //
+		    kTimestamp,                                       //
+		    spaces,                                           //
+		    count,                                            //
+		    offsets,                                          //
+		    batched);                                         //
+		REQUIRE(xret == XRT_SUCCESS);
+
+		// one_y in two_x.
+		CHECK(batched[0].pose.position.x == Approx(-2.0f));
+		CHECK(batched[0].pose.position.y == Approx(1.0f));
+		CHECK(batched[0].pose.position.z == Approx(0.0f));
+
+		// Locating two_x in itself only applies the offset.
+		CHECK(batched[1].pose.position.x == Approx(0.0f));
+		CHECK(batched[1].pose.position.y == Approx(1.0f));
+		CHECK(batched[1].pose.position.z == Approx(0.0f));
+	}
+
+	SECTION("Fallback without function")
+	{
+		struct xrt_space_relation batched[count] = {};
+		struct xrt_space_relation fallback[count] = {};
+
+		xrt_result_t xret = xrt_space_overseer_locate_spaces( //
+		    xso,                                              //
+		    turned,                                           //
+		    &kPoseTwoX,                                       //
+		    kTimestamp,                                       //
+		    spaces,                                           //
+		    count,                                            //
+		    offsets,                                          //
+		    batched);                                         //
+		REQUIRE(xret == XRT_SUCCESS);
+
+		// The helper loops over locate_space when the function is missing.
+		xso->locate_spaces = NULL;
+		xret = xrt_space_overseer_locate_spaces( //
+		    xso,                                 //
+		    turned,                              //
+		    &kPoseTwoX,                          //
+		    kTimestamp,                          //
+		    spaces,                              //
+		    count,                               //
+		    offsets,                             //
+		    fallback);                           //
+		REQUIRE(xret == XRT_SUCCESS);
+
+		for (uint32_t i = 0; i < count; i++) {
+			check_relations_equal(batched[i], fallback[i]);
+		}
+	}
+
+	xrt_space_reference(&turned, NULL);
+	xrt_space_reference(&two_x, NULL);
+	xrt_space_reference(&one_y, NULL);
+	xrt_space_overseer_destroy(&xso);
+}
+
+TEST_CASE("SpaceOverseerChainCache")
+{
+	struct u_space_overseer *uso = u_space_overseer_create(NULL);
+	struct xrt_space_overseer *xso = (struct xrt_space_overseer *)uso;
+	REQUIRE(xso->semantic.root != NULL);
+
+	struct xrt_space *one_y = NULL;
+	REQUIRE(xrt_space_overseer_create_offset_space(xso, xso->semantic.root, &kPoseOneY, &one_y) == XRT_SUCCESS);
+
+	struct xrt_space *space = NULL;
+	REQUIRE(xrt_space_overseer_create_offset_space(xso, one_y, &kPoseTwoX, &space) == XRT_SUCCESS);
+
+	// Locate twice, the second one comes from the cache.
+	for (uint32_t i = 0; i < 2; i++) {
+		struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+		REQUIRE(xrt_space_overseer_locate_space(xso, xso->semantic.root, &kPoseIdentity, kTimestamp, space,
+		                                        &kPoseIdentity, &rel) == XRT_SUCCESS);
+		CHECK(rel.pose.position.x == Approx(2.0f));
+		CHECK(rel.pose.position.y == Approx(1.0f));
+		CHECK(rel.pose.position.z == Approx(0.0f));
+	}
+
+	// A new space may get the same address, must not hit the old entry.
+	xrt_space_reference(&space, NULL);
+	REQUIRE(xrt_space_overseer_create_offset_space(xso, one_y, &kPoseTurnedThreeZ, &space) == XRT_SUCCESS);
+
+	struct xrt_space_relation rel = XRT_SPACE_RELATION_ZERO;
+	REQUIRE(xrt_space_overseer_locate_space(xso, xso->semantic.root, &kPoseIdentity, kTimestamp, space,
+	                                        &kPoseIdentity, &rel) == XRT_SUCCESS);
+	CHECK(rel.pose.position.x == Approx(0.0f));
+	CHECK(rel.pose.position.y == Approx(1.0f));
+	CHECK(rel.pose.position.z == Approx(3.0f));
+	CHECK(rel.pose.orientation.y == Approx(kPoseTurnedThreeZ.orientation.y));
+
+	// The inverse goes through the same offsets.
+	REQUIRE(xrt_space_overseer_locate_space(xso, space, &kPoseIdentity, kTimestamp, xso->semantic.root,
+	                                        &kPoseIdentity, &rel) == XRT_SUCCESS);
+	struct xrt_pose expected;
+	struct xrt_pose combined;
+	math_pose_transform(&kPoseOneY, &kPoseTurnedThreeZ, &combined);
+	math_pose_invert(&combined, &expected);
+	CHECK(rel.pose.position.x == Approx(expected.position.x).margin(0.0001));
+	CHECK(rel.pose.position.y == Approx(expected.position.y).margin(0.0001));
+	CHECK(rel.pose.position.z == Approx(expected.position.z).margin(0.0001));
+
+	xrt_space_reference(&space, NULL);
+	xrt_space_reference(&one_y, NULL);
+	xrt_space_overseer_destroy(&xso);
+}
@@ -0,0 +1,126 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief SpscHistoryBuffer collection tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <util/u_template_spsc_historybuf.hpp>
+
+#include "catch/catch.hpp"
+
+#include <thread>
+#include <vector>
+
+
+using xrt::auxiliary::util::SpscHistoryBuffer;
+using xrt::auxiliary::util::detail::SpscIndex;
+
+static_assert(SpscIndex<8>::is_power_of_two, "8 is a power of two");
+static_assert(!SpscIndex<5>::is_power_of_two, "5 is not a power of two");
+static_assert(SpscIndex<8>::wrap(13) == 5, "masked");
+static_assert(SpscIndex<5>::wrap(13) == 3, "modulo");
+
+
+TEMPLATE_TEST_CASE_SIG("SpscHistoryBuffer", "", ((size_t N), N), 4, 5)
+{
+	SpscHistoryBuffer<int, N> buffer;
+	int value = 0;
+
+	SECTION("starts empty")
+	{
+		CHECK(buffer.empty());
+		CHECK(buffer.size() == 0);
+		CHECK(buffer.peek_front() == nullptr);
+		CHECK_FALSE(buffer.try_pop_front(value));
+	}
+
+	SECTION("first in first out")
+	{
+		REQUIRE(buffer.try_push_back(1));
+		REQUIRE(buffer.try_push_back(2));
+		CHECK(buffer.size() == 2);
+
+		REQUIRE(buffer.peek_front() != nullptr);
+		CHECK(*buffer.peek_front() == 1);
+
+		REQUIRE(buffer.try_pop_front(value));
+		CHECK(value == 1);
+		REQUIRE(buffer.try_pop_front(value));
+		CHECK(value == 2);
+		CHECK(buffer.empty());
+	}
+
+	SECTION("full does not overwrite")
+	{
+		for (size_t i = 0; i < N; i++) {
+			REQUIRE(buffer.try_push_back((int)i));
+		}
+
+		CHECK(buffer.size() == N);
+		CHECK_FALSE(buffer.try_push_back(100));
+
+		REQUIRE(buffer.try_pop_front(value));
+		CHECK(value == 0);
+		CHECK(buffer.try_push_back(100));
+	}
+
+	SECTION("bulk wraps around")
+	{
+		const int in[3] = {1, 2, 3};
+		int out[8] = {};
+
+		// Move the indices so the next bulk wraps.
+		for (int round = 0; round < 3; round++) {
+			CHECK(buffer.push_back_bulk(in, 3) == 3);
+			CHECK(buffer.pop_front_bulk(out, 8) == 3);
+			CHECK(out[0] == 1);
+			CHECK(out[2] == 3);
+		}
+
+		// Only pushes what fits.
+		CHECK(buffer.push_back_bulk(in, 3) == 3);
+		CHECK(buffer.push_back_bulk(in, 3) == N - 3);
+		CHECK(buffer.size() == N);
+		CHECK(buffer.pop_front_bulk(out, 8) == N);
+		CHECK(out[3] == 1);
+	}
+}
+
+TEST_CASE("SpscHistoryBuffer threaded")
+{
+	constexpr int count = 100000;
+
+	SpscHistoryBuffer<int, 64> buffer;
+	std::vector<int> received;
+	received.reserve(count);
+
+	std::thread producer([&] {
+		int next = 0;
+		while (next < count) {
+			int batch[7];
+			int n = 0;
+			for (; n < 7 && next + n < count; n++) {
+				batch[n] = next + n;
+			}
+			next += (int)buffer.push_back_bulk(batch, (size_t)n);
+		}
+	});
+
+	while ((int)received.size() < count) {
+		int out[5];
+		size_t n = buffer.pop_front_bulk(out, 5);
+		received.insert(received.end(), out, out + n);
+	}
+
+	producer.join();
+
+	bool in_order = true;
+	for (int i = 0; i < count; i++) {
+		in_order = in_order && received[i] == i;
+	}
+
+	CHECK(in_order);
+	CHECK(buffer.empty());
+}
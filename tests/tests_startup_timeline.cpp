@@ -0,0 +1,62 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Startup timeline tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include "catch/catch.hpp"
+
+#include "util/u_startup_timeline.h"
+
+#include <string>
+
+
+// The table is global and never cleared, so no sections, they rerun the test.
+TEST_CASE("u_startup_timeline")
+{
+	struct u_startup_phase phase = {};
+
+	REQUIRE(u_startup_timeline_get(0, &phase) == 0);
+
+	int32_t outer = u_startup_timeline_begin("outer %d", 1);
+	int32_t inner = u_startup_timeline_begin("inner");
+	REQUIRE(outer == 0);
+	REQUIRE(inner == 1);
+
+	// Running phase has no end.
+	REQUIRE(u_startup_timeline_get(1, &phase) == 2);
+	CHECK(phase.end_ns == 0);
+	CHECK(phase.depth == 1);
+
+	u_startup_timeline_end(inner);
+	u_startup_timeline_end(inner); // Ending twice is ignored.
+	u_startup_timeline_end(U_STARTUP_TIMELINE_INVALID_ID);
+	u_startup_timeline_end(outer);
+	u_startup_timeline_mark("mark");
+
+	REQUIRE(u_startup_timeline_get(0, &phase) == 3);
+	CHECK(std::string(phase.name) == "outer 1");
+	CHECK(phase.depth == 0);
+	uint64_t outer_begin_ns = phase.begin_ns;
+	uint64_t outer_end_ns = phase.end_ns;
+
+	REQUIRE(u_startup_timeline_get(1, &phase) == 3);
+	CHECK(std::string(phase.name) == "inner");
+	CHECK(phase.begin_ns >= outer_begin_ns);
+	CHECK(phase.end_ns >= phase.begin_ns);
+	CHECK(phase.end_ns <= outer_end_ns);
+
+	REQUIRE(u_startup_timeline_get(2, &phase) == 3);
+	CHECK(std::string(phase.name) == "mark");
+	CHECK(phase.depth == 0);
+	CHECK(phase.begin_ns == phase.end_ns);
+
+	// Phases past the limit are dropped.
+	for (uint32_t i = 3; i < U_STARTUP_TIMELINE_MAX_PHASES; i++) {
+		u_startup_timeline_end(u_startup_timeline_begin("filler %u", i));
+	}
+	CHECK(u_startup_timeline_begin("dropped") == U_STARTUP_TIMELINE_INVALID_ID);
+	CHECK(u_startup_timeline_get(0, &phase) == U_STARTUP_TIMELINE_MAX_PHASES);
+}
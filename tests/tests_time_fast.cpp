@@ -0,0 +1,53 @@
+// Copyright 2024, Collabora, Ltd.
+// SPDX-License-Identifier: BSL-1.0
+/*!
+ * @file
+ * @brief Fast monotonic clock tests.
+ * @author Jakob Bornecrantz <jakob@collabora.com>
+ */
+
+#include <os/os_time.h>
+
+#include "catch/catch.hpp"
+
+
+// Calibration promises to stay within this of CLOCK_MONOTONIC.
+static constexpr int64_t kMaxErrorNs = 100 * U_TIME_1US_IN_NS;
+
+TEST_CASE("os_monotonic_get_ns_fast")
+{
+	// Calibrates, whatever the answer the fast clock must behave.
+	bool enabled = os_monotonic_fast_is_enabled();
+	INFO("fast clock enabled: " << enabled);
+
+	SECTION("follows the monotonic clock")
+	{
+		for (int i = 0; i < 100; i++) {
+			uint64_t before = os_monotonic_get_ns();
+			uint64_t fast = os_monotonic_get_ns_fast();
+			uint64_t after = os_monotonic_get_ns();
+
+			CHECK((int64_t)(fast - before) > -kMaxErrorNs);
+			CHECK((int64_t)(after - fast) > -kMaxErrorNs);
+		}
+	}
+
+	SECTION("never goes backwards")
+	{
+		uint64_t last = os_monotonic_get_ns_fast();
+		for (int i = 0; i < 100000; i++) {
+			uint64_t now = os_monotonic_get_ns_fast();
+			REQUIRE(now >= last);
+			last = now;
+		}
+	}
+
+	SECTION("advances with sleeps")
+	{
+		uint64_t start = os_monotonic_get_ns_fast();
+		os_nanosleep(5 * U_TIME_1MS_IN_NS);
+		uint64_t end = os_monotonic_get_ns_fast();
+
+		CHECK((int64_t)(end - start) >= 5 * U_TIME_1MS_IN_NS - kMaxErrorNs);
+	}
+}
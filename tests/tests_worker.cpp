@@ -6,10 +6,12 @@
  * @author Rylie Pavlik <rylie.pavlik@collabora.com>
  */
 
+#include <util/u_worker.h>
 #include <util/u_worker.hpp>
 
 #include "catch/catch.hpp"
 
+#include <atomic>
 #include <thread>
 #include <chrono>
 
@@ -130,3 +132,183 @@ TEST_CASE("TaskCollection")
 		CHECK(calledA[2]);
 	}
 }
+
+struct stress_inner
+{
+	struct u_worker_group *group;
+	std::atomic<uint32_t> *counter;
+};
+
+static void
+stress_leaf(void *ptr)
+{
+	std::atomic<uint32_t> *counter = (std::atomic<uint32_t> *)ptr;
+	(*counter)++;
+}
+
+static void
+stress_nested(void *ptr)
+{
+	struct stress_inner *inner = (struct stress_inner *)ptr;
+
+	// Pushed from a worker, so these go on its own deque and can be stolen.
+	for (uint32_t i = 0; i < 8; i++) {
+		u_worker_group_push(inner->group, stress_leaf, inner->counter);
+	}
+	u_worker_group_wait_all(inner->group);
+
+	(*inner->counter)++;
+}
+
+TEST_CASE("WorkerStress")
+{
+	struct u_worker_thread_pool *uwtp = u_worker_thread_pool_create(3, 4, "Stress");
+	REQUIRE(uwtp != nullptr);
+
+	SECTION("Many tasks, many groups")
+	{
+		constexpr uint32_t group_count = 4;
+		constexpr uint32_t task_count = 2000; // More than fits in the queues.
+
+		struct u_worker_group *groups[group_count] = {};
+		std::atomic<uint32_t> counters[group_count] = {};
+
+		for (uint32_t g = 0; g < group_count; g++) {
+			groups[g] = u_worker_group_create(uwtp);
+		}
+
+		for (uint32_t i = 0; i < task_count; i++) {
+			for (uint32_t g = 0; g < group_count; g++) {
+				u_worker_group_push(groups[g], stress_leaf, &counters[g]);
+			}
+		}
+
+		for (uint32_t g = 0; g < group_count; g++) {
+			u_worker_group_wait_all(groups[g]);
+			CHECK(counters[g].load() == task_count);
+			u_worker_group_reference(&groups[g], nullptr);
+		}
+	}
+
+	SECTION("Nested push and wait")
+	{
+		constexpr uint32_t outer_count = 64;
+
+		struct u_worker_group *outer = u_worker_group_create(uwtp);
+		struct stress_inner inners[outer_count] = {};
+		std::atomic<uint32_t> counter{0};
+
+		for (uint32_t i = 0; i < outer_count; i++) {
+			inners[i].group = u_worker_group_create(uwtp);
+			inners[i].counter = &counter;
+			u_worker_group_push(outer, stress_nested, &inners[i]);
+		}
+
+		u_worker_group_wait_all(outer);
+		CHECK(counter.load() == outer_count * 9);
+
+		for (uint32_t i = 0; i < outer_count; i++) {
+			u_worker_group_reference(&inners[i].group, nullptr);
+		}
+		u_worker_group_reference(&outer, nullptr);
+	}
+
+	u_worker_thread_pool_reference(&uwtp, nullptr);
+}
+
+TEST_CASE("ParallelFor")
+{
+	SharedThreadPool pool{2, 3, "Test"};
+	SharedThreadGroup group{pool};
+
+	std::vector<std::atomic<uint32_t>> hits(1000);
+
+	SECTION("Uneven chunks")
+	{
+		// Catch isn't thread safe, so only check from the main thread.
+		std::atomic<uint32_t> too_big{0};
+		parallelFor(group, 3, hits.size(), 64, [&](size_t begin, size_t end) {
+			if (end - begin > 64) {
+				too_big++;
+			}
+			for (size_t i = begin; i < end; i++) {
+				hits[i]++;
+			}
+		});
+
+		CHECK(too_big.load() == 0);
+		for (size_t i = 0; i < hits.size(); i++) {
+			CHECK(hits[i].load() == (i < 3 ? 0 : 1));
+		}
+	}
+
+	SECTION("Empty range")
+	{
+		bool called = false;
+		parallelFor(group, 10, 10, 4, [&](size_t, size_t) { called = true; });
+		CHECK(!called);
+	}
+}
+
+TEST_CASE("TaskGraph")
+{
+	SharedThreadPool pool{2, 3, "Test"};
+	SharedThreadGroup group{pool};
+	TaskGraph graph{group};
+
+	std::atomic<uint32_t> step{0};
+	uint32_t a1 = 0;
+	uint32_t a2 = 0;
+	uint32_t b = 0;
+	uint32_t c = 0;
+
+	TaskGraph::Id idA1 = graph.add([&] {
+		std::this_thread::sleep_for(50ms);
+		a1 = ++step;
+	});
+	TaskGraph::Id idA2 = graph.add([&] { a2 = ++step; });
+	TaskGraph::Id idB = graph.add([&] { b = ++step; }, {idA1, idA2});
+	graph.add([&] { c = ++step; }, {idB});
+
+	graph.run();
+	CHECK(step.load() == 4);
+	CHECK(b > a1);
+	CHECK(b > a2);
+	CHECK(c == 4);
+
+	// Can be run again.
+	graph.run();
+	CHECK(step.load() == 8);
+	CHECK(b > a1);
+	CHECK(b > a2);
+	CHECK(c == 8);
+}
+
+TEST_CASE("SharedTrackingPool")
+{
+	struct u_worker_thread_pool *a = u_worker_thread_pool_get_tracking();
+	struct u_worker_thread_pool *b = u_worker_thread_pool_get_tracking();
+	REQUIRE(a != nullptr);
+	CHECK(a == b);
+
+	std::atomic<uint32_t> count{0};
+	struct u_worker_group *group = u_worker_group_create(b);
+	for (int i = 0; i < 16; i++) {
+		u_worker_group_push(
+		    group, [](void *ptr) { (*static_cast<std::atomic<uint32_t> *>(ptr))++; }, &count);
+	}
+	u_worker_group_wait_all(group);
+	CHECK(count.load() == 16);
+
+	// The group keeps the pool alive after the users put it back.
+	u_worker_thread_pool_put_tracking(&a);
+	u_worker_thread_pool_put_tracking(&b);
+	CHECK(a == nullptr);
+	CHECK(b == nullptr);
+	u_worker_group_reference(&group, NULL);
+
+	// A new pool is made once all users are gone.
+	struct u_worker_thread_pool *c = u_worker_thread_pool_get_tracking();
+	REQUIRE(c != nullptr);
+	u_worker_thread_pool_put_tracking(&c);
+}